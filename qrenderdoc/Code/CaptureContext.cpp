@@ -212,7 +212,12 @@ void CaptureContext::LoadLogfileThreaded(const QString &logFile, const QString &
 
     m_Drawcalls = r->GetDrawcalls();
 
-    AddFakeProfileMarkers();
+    // the flat list is owned by the replay and stays valid until the log is closed, but it won't
+    // contain any fake markers we add.
+    m_FlatDrawcalls = &r->GetFlatDrawcalls();
+
+    if(AddFakeProfileMarkers())
+      m_FlatDrawcalls = NULL;
 
     m_PostloadProgress = 0.4f;
 
@@ -377,15 +382,15 @@ bool CaptureContext::ContainsMarker(const rdctype::array<DrawcallDescription> &d
   return ret;
 }
 
-void CaptureContext::AddFakeProfileMarkers()
+bool CaptureContext::AddFakeProfileMarkers()
 {
   rdctype::array<DrawcallDescription> &draws = m_Drawcalls;
 
   if(!Config().EventBrowser_AddFake)
-    return;
+    return false;
 
   if(ContainsMarker(draws))
-    return;
+    return false;
 
   QList<DrawcallDescription> ret;
 
@@ -501,6 +506,8 @@ void CaptureContext::AddFakeProfileMarkers()
   m_Drawcalls.create(ret.count());
   for(int i = 0; i < ret.count(); i++)
     m_Drawcalls[i] = ret[i];
+
+  return true;
 }
 
 void CaptureContext::CloseLogfile()
@@ -512,6 +519,8 @@ void CaptureContext::CloseLogfile()
 
   m_Renderer.CloseThread();
 
+  m_FlatDrawcalls = NULL;
+
   memset(&m_APIProps, 0, sizeof(m_APIProps));
   memset(&m_FrameInfo, 0, sizeof(m_FrameInfo));
   m_Buffers.clear();
@@ -525,6 +534,12 @@ void CaptureContext::CloseLogfile()
   m_CurVulkanPipelineState = VKPipe::State();
   m_CurPipelineState.SetStates(m_APIProps, NULL, NULL, NULL, NULL);
 
+  {
+    QMutexLocker autolock(&m_PrefetchLock);
+    m_Prefetched.clear();
+  }
+  m_PrefetchGeneration.fetchAndAddRelaxed(1);
+
   m_DebugMessages.clear();
   m_UnreadMessageCount = 0;
 
@@ -547,15 +562,56 @@ void CaptureContext::SetEventID(const QVector<ILogViewer *> &exclude, uint32_t s
   uint32_t prevEventID = m_EventID;
   m_EventID = eventID;
 
-  m_Renderer.BlockInvoke([this, eventID, force](IReplayController *r) {
-    r->SetFrameEvent(eventID, force);
-    m_CurD3D11PipelineState = r->GetD3D11PipelineState();
-    m_CurD3D12PipelineState = r->GetD3D12PipelineState();
-    m_CurGLPipelineState = r->GetGLPipelineState();
-    m_CurVulkanPipelineState = r->GetVulkanPipelineState();
+  m_PrefetchGeneration.fetchAndAddRelaxed(1);
+
+  bool prefetched = false;
+
+  {
+    QMutexLocker autolock(&m_PrefetchLock);
+
+    // a forced refresh means the replay has changed underneath us (e.g. an edited shader), so
+    // anything prefetched is out of date.
+    if(force)
+      m_Prefetched.clear();
+
+    auto it = m_Prefetched.find(eventID);
+    if(it != m_Prefetched.end())
+    {
+      m_CurD3D11PipelineState = it->d3d11;
+      m_CurD3D12PipelineState = it->d3d12;
+      m_CurGLPipelineState = it->gl;
+      m_CurVulkanPipelineState = it->vulkan;
+      prefetched = true;
+    }
+  }
+
+  if(prefetched)
+  {
     m_CurPipelineState.SetStates(m_APIProps, &m_CurD3D11PipelineState, &m_CurD3D12PipelineState,
                                  &m_CurGLPipelineState, &m_CurVulkanPipelineState);
-  });
+
+    // the replay still needs to move to the event, but nothing here has to wait for it. It runs
+    // ahead of anything the viewers queue up in response to the change, and replaces a move that
+    // hasn't happened yet.
+    m_Renderer.AsyncInvoke(lit("SetFrameEvent"), InvokePriority::Interactive,
+                           [this, eventID](IReplayController *r) {
+                             r->SetFrameEvent(eventID, false);
+                             m_ReplayEventID = eventID;
+                           });
+  }
+  else
+  {
+    m_Renderer.BlockInvoke([this, eventID, force](IReplayController *r) {
+      r->SetFrameEvent(eventID, force);
+      m_ReplayEventID = eventID;
+      m_CurD3D11PipelineState = r->GetD3D11PipelineState();
+      m_CurD3D12PipelineState = r->GetD3D12PipelineState();
+      m_CurGLPipelineState = r->GetGLPipelineState();
+      m_CurVulkanPipelineState = r->GetVulkanPipelineState();
+      m_CurPipelineState.SetStates(m_APIProps, &m_CurD3D11PipelineState, &m_CurD3D12PipelineState,
+                                   &m_CurGLPipelineState, &m_CurVulkanPipelineState);
+    });
+  }
 
   for(ILogViewer *logviewer : m_LogViewers)
   {
@@ -567,6 +623,96 @@ void CaptureContext::SetEventID(const QVector<ILogViewer *> &exclude, uint32_t s
     if(force || prevEventID != eventID)
       logviewer->OnEventChanged(eventID);
   }
+
+  if(m_Config.EventBrowser_PrefetchDrawcalls > 0)
+  {
+    int generation = m_PrefetchGeneration.load();
+
+    QTimer::singleShot(PrefetchDelay, m_MainWindow, [this, eventID, generation]() {
+      if(m_LogLoaded && m_PrefetchGeneration.load() == generation)
+        StartPrefetch(eventID);
+    });
+  }
+}
+
+void CaptureContext::StartPrefetch(uint32_t eventID)
+{
+  const int count = m_Config.EventBrowser_PrefetchDrawcalls;
+
+  // step outwards from the current drawcall, nearest first, alternating forwards and backwards
+  // since either direction is as likely.
+  QVector<uint32_t> eventIDs;
+
+  const DrawcallDescription *next = GetDrawcall(eventID);
+  const DrawcallDescription *prev = next;
+
+  for(int i = 0; i < count && (next || prev); i++)
+  {
+    if(next)
+    {
+      next = next->next > 0 ? GetDrawcall((uint32_t)next->next) : NULL;
+      if(next)
+        eventIDs.push_back(next->eventID);
+    }
+
+    if(prev)
+    {
+      prev = prev->previous > 0 ? GetDrawcall((uint32_t)prev->previous) : NULL;
+      if(prev)
+        eventIDs.push_back(prev->eventID);
+    }
+  }
+
+  {
+    QMutexLocker autolock(&m_PrefetchLock);
+
+    // only keep what's still within reach of the new event
+    for(auto it = m_Prefetched.begin(); it != m_Prefetched.end();)
+    {
+      if(it.key() == eventID || eventIDs.contains(it.key()))
+        ++it;
+      else
+        it = m_Prefetched.erase(it);
+    }
+
+    for(int i = 0; i < eventIDs.count();)
+    {
+      if(m_Prefetched.contains(eventIDs[i]))
+        eventIDs.removeAt(i);
+      else
+        i++;
+    }
+  }
+
+  int generation = m_PrefetchGeneration.load();
+
+  // each event is a separate background invoke, so that any other work can run in between and
+  // stepping to another event only ever waits for one prefetch to finish.
+  for(uint32_t eid : eventIDs)
+  {
+    m_Renderer.AsyncInvoke(
+        lit("Prefetch%1").arg(eid), InvokePriority::Background,
+        [this, eid, generation](IReplayController *r) {
+          if(m_PrefetchGeneration.load() != generation)
+            return;
+
+          PrefetchedState state;
+
+          r->SetFrameEvent(eid, false);
+          state.d3d11 = r->GetD3D11PipelineState();
+          state.d3d12 = r->GetD3D12PipelineState();
+          state.gl = r->GetGLPipelineState();
+          state.vulkan = r->GetVulkanPipelineState();
+
+          // put the replay back where the UI expects it to be
+          r->SetFrameEvent(m_ReplayEventID, false);
+
+          // don't store anything if the cache was pruned or cleared since this was queued
+          QMutexLocker autolock(&m_PrefetchLock);
+          if(m_PrefetchGeneration.load() == generation)
+            m_Prefetched[eid] = state;
+        });
+  }
 }
 
 void CaptureContext::AddMessages(const rdctype::array<DebugMessage> &msgs)
@@ -28,6 +28,7 @@
 #include <QList>
 #include <QMap>
 #include <QMessageBox>
+#include <QMutex>
 #include <QString>
 #include <QtWidgets/QWidget>
 #include "Interface/QRDInterface.h"
@@ -105,6 +106,7 @@ public:
   }
   const DrawcallDescription *CurDrawcall() override { return GetDrawcall(CurEvent()); }
   const rdctype::array<DrawcallDescription> &CurDrawcalls() override { return m_Drawcalls; }
+  const FlatDrawcallList *CurFlatDrawcalls() override { return m_FlatDrawcalls; }
   TextureDescription *GetTexture(ResourceId id) override { return m_Textures[id]; }
   const rdctype::array<TextureDescription> &GetTextures() override { return m_TextureList; }
   BufferDescription *GetBuffer(ResourceId id) override { return m_Buffers[id]; }
@@ -207,7 +209,7 @@ private:
 
   bool PassEquivalent(const DrawcallDescription &a, const DrawcallDescription &b);
   bool ContainsMarker(const rdctype::array<DrawcallDescription> &m_Drawcalls);
-  void AddFakeProfileMarkers();
+  bool AddFakeProfileMarkers();
 
   float m_LoadProgress = 0.0f;
   float m_PostloadProgress = 0.0f;
@@ -219,6 +221,29 @@ private:
   uint32_t m_SelectedEventID;
   uint32_t m_EventID;
 
+  // speculative prefetching of the pipeline state at drawcalls either side of the current event,
+  // see PersistantConfig::EventBrowser_PrefetchDrawcalls
+  struct PrefetchedState
+  {
+    D3D11Pipe::State d3d11;
+    D3D12Pipe::State d3d12;
+    GLPipe::State gl;
+    VKPipe::State vulkan;
+  };
+
+  // how long the selection must stay on one event before prefetching starts
+  static const int PrefetchDelay = 250;
+
+  // filled in on the render thread, read on the UI thread
+  QMutex m_PrefetchLock;
+  QMap<uint32_t, PrefetchedState> m_Prefetched;
+  // incremented on every event change, so that prefetches for an old event are abandoned
+  QAtomicInt m_PrefetchGeneration;
+  // the event the replay was last moved to for the UI. Only accessed on the render thread.
+  uint32_t m_ReplayEventID = 0;
+
+  void StartPrefetch(uint32_t eventID);
+
   const DrawcallDescription *GetDrawcall(const rdctype::array<DrawcallDescription> &draws,
                                          uint32_t eventID)
   {
@@ -241,6 +266,7 @@ private:
   void setupDockWindow(QWidget *shad);
 
   rdctype::array<DrawcallDescription> m_Drawcalls;
+  const FlatDrawcallList *m_FlatDrawcalls = NULL;
 
   APIProperties m_APIProps;
   FrameDescription m_FrameInfo;
@@ -95,6 +95,10 @@ DECLARE_REFLECTION_STRUCT(SPIRVDisassembler);
                                                                                            \
   CONFIG_SETTING_VAL(public, bool, bool, EventBrowser_ColorEventRow, true)                 \
                                                                                            \
+  CONFIG_SETTING_VAL(public, int, int, EventBrowser_TimingIterations, 1)                   \
+                                                                                           \
+  CONFIG_SETTING_VAL(public, int, int, EventBrowser_PrefetchDrawcalls, 0)                  \
+                                                                                           \
   CONFIG_SETTING_VAL(public, int, int, Formatter_MinFigures, 2)                            \
                                                                                            \
   CONFIG_SETTING_VAL(public, int, int, Formatter_MaxFigures, 5)                            \
@@ -301,6 +305,22 @@ For more information about some of these settings that are user-facing see
 
   Defaults to ``True``.
 
+.. data:: EventBrowser_TimingIterations
+
+  The number of times the capture is replayed when timing drawcalls in the :class:`EventBrowser`.
+  Values above ``1`` perform an extra warm-up replay and then display the median duration of each
+  event, with the minimum and standard deviation available as a tooltip.
+
+  Defaults to ``1``.
+
+.. data:: EventBrowser_PrefetchDrawcalls
+
+  The number of drawcalls either side of the current one that are replayed speculatively in the
+  background while the UI is idle, so that their pipeline state is ready when stepping to them.
+  ``0`` disables prefetching.
+
+  Defaults to ``0``.
+
 .. data:: Formatter_MinFigures
 
   The minimum number of significant figures to show in formatted floating point values.
@@ -81,6 +81,19 @@ CaptureSettings::operator QVariant() const
   opts[lit("SaveAllInitials")] = Options.SaveAllInitials;
   opts[lit("CaptureAllCmdLists")] = Options.CaptureAllCmdLists;
   opts[lit("DebugOutputMute")] = Options.DebugOutputMute;
+  opts[lit("CompressionLevel")] = Options.CompressionLevel;
+  opts[lit("DeduplicateInitialContents")] = Options.DeduplicateInitialContents;
+  opts[lit("WriteCapturesAsync")] = Options.WriteCapturesAsync;
+  opts[lit("FramesPerCapture")] = Options.FramesPerCapture;
+  opts[lit("TrackCoherentMapWrites")] = Options.TrackCoherentMapWrites;
+  opts[lit("ProfileAPICalls")] = Options.ProfileAPICalls;
+  opts[lit("ReduceIdleOverhead")] = Options.ReduceIdleOverhead;
+  opts[lit("PrepareAheadBudget")] = Options.PrepareAheadBudget;
+  opts[lit("CompressInitialContentsOnGPU")] = Options.CompressInitialContentsOnGPU;
+  opts[lit("InitialContentsBudget")] = Options.InitialContentsBudget;
+  opts[lit("FrameTimeTriggerMS")] = Options.FrameTimeTriggerMS;
+  opts[lit("FrameTimeTriggerMultiple")] = Options.FrameTimeTriggerMultiple;
+  opts[lit("AppendCapturesToSession")] = Options.AppendCapturesToSession;
   ret[lit("Options")] = opts;
 
   return ret;
@@ -117,6 +130,19 @@ CaptureSettings::CaptureSettings(const QVariant &v)
   Options.SaveAllInitials = opts[lit("SaveAllInitials")].toBool();
   Options.CaptureAllCmdLists = opts[lit("CaptureAllCmdLists")].toBool();
   Options.DebugOutputMute = opts[lit("DebugOutputMute")].toBool();
+  Options.CompressionLevel = opts[lit("CompressionLevel")].toUInt();
+  Options.DeduplicateInitialContents = opts[lit("DeduplicateInitialContents")].toBool();
+  Options.WriteCapturesAsync = opts[lit("WriteCapturesAsync")].toBool();
+  Options.FramesPerCapture = qMax(1U, opts[lit("FramesPerCapture")].toUInt());
+  Options.TrackCoherentMapWrites = opts[lit("TrackCoherentMapWrites")].toBool();
+  Options.ProfileAPICalls = opts[lit("ProfileAPICalls")].toBool();
+  Options.ReduceIdleOverhead = opts[lit("ReduceIdleOverhead")].toBool();
+  Options.PrepareAheadBudget = opts[lit("PrepareAheadBudget")].toUInt();
+  Options.CompressInitialContentsOnGPU = opts[lit("CompressInitialContentsOnGPU")].toBool();
+  Options.InitialContentsBudget = opts[lit("InitialContentsBudget")].toUInt();
+  Options.FrameTimeTriggerMS = opts[lit("FrameTimeTriggerMS")].toUInt();
+  Options.FrameTimeTriggerMultiple = opts[lit("FrameTimeTriggerMultiple")].toFloat();
+  Options.AppendCapturesToSession = opts[lit("AppendCapturesToSession")].toBool();
 }
 
 QString ConfigFilePath(const QString &filename)
@@ -494,6 +494,30 @@ protected:
 
 DECLARE_REFLECTION_STRUCT(ILogViewer);
 
+DOCUMENT(R"(Specifies how urgently an invoke onto the replay thread should run, relative to others that
+are waiting. Invokes of the same priority always run in the order they were made.
+
+.. data:: Background
+
+  Long-running analysis that doesn't depend on the current event, such as fetching counters for the
+  whole frame. Only runs once nothing else is waiting.
+
+.. data:: Normal
+
+  The default for invokes that don't specify a priority.
+
+.. data:: Interactive
+
+  Short requests that give immediate feedback to the user, such as picking a pixel or vertex under
+  the cursor. These run before any other waiting invokes.
+)");
+enum class InvokePriority : int
+{
+  Background,
+  Normal,
+  Interactive,
+};
+
 DOCUMENT(R"(A manager for accessing the underlying replay information that isn't already abstracted
 in UI side structures. This manager controls and serialises access to the underlying
 :class:`~renderdoc.ReplayController`, as well as handling remote server connections.
@@ -624,13 +648,26 @@ other work is taking a while or because we're sending requests faster than they
 processed.
 
 The manager processes only the request on the top of the queue, so when a new tagged invoke
-comes in, we remove any other requests in the queue before it that have the same tag.
+comes in, we remove any other requests in the queue before it that have the same tag. If a request
+with the same tag is already running, it is asked to cancel via
+:meth:`~renderdoc.ReplayController.RequestCancel` so that long-running replay work returns early.
 
 :param str tag: The tag to identify this callback.
 :param InvokeCallback method: The function to callback on the replay thread.
 )");
   virtual void AsyncInvoke(const QString &tag, InvokeCallback method) = 0;
 
+  DOCUMENT(R"(Make a tagged non-blocking invoke call onto the replay thread with a given priority.
+
+This behaves as the tagged :meth:`AsyncInvoke`, but the callback runs ahead of any waiting invokes
+with a lower priority.
+
+:param str tag: The tag to identify this callback.
+:param InvokePriority priority: How urgently this callback should run.
+:param InvokeCallback method: The function to callback on the replay thread.
+)");
+  virtual void AsyncInvoke(const QString &tag, InvokePriority priority, InvokeCallback method) = 0;
+
   DOCUMENT(R"(Make a non-blocking invoke call onto the replay thread.
 
 :param InvokeCallback method: The function to callback on the replay thread.
@@ -887,6 +924,16 @@ more information for how this differs.
 )");
   virtual const rdctype::array<DrawcallDescription> &CurDrawcalls() = 0;
 
+  DOCUMENT(R"(Retrieve the flat list of drawcalls in the current capture, owned by the replay.
+
+This isn't available when fake profile markers have been added to :meth:`CurDrawcalls`, since it
+only contains the drawcalls in the capture itself.
+
+:return: The flat drawcall list, or ``None`` if it isn't available.
+:rtype: ~renderdoc.FlatDrawcallList
+)");
+  virtual const FlatDrawcallList *CurFlatDrawcalls() = 0;
+
   DOCUMENT(R"(Retrieve the information about a particular texture.
 
 :param ~renderdoc.ResourceId id: The ID of the texture to query about.
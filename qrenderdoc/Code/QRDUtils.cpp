@@ -630,6 +630,21 @@ public:
     }
   }
 
+  void enableCancel(ProgressCancelMethod cancel)
+  {
+    setCancelButtonText(tr("Cancel"));
+
+    // don't let the dialog close itself when cancelled - the work still has to wind down, and we
+    // close once the finished callback says it has.
+    setAutoClose(false);
+    setAutoReset(false);
+
+    QObject::connect(this, &QProgressDialog::canceled, [this, cancel]() {
+      m_Label.setText(tr("Cancelling..."));
+      cancel();
+    });
+  }
+
   void closeAndReset()
   {
     setValue(maxProgress);
@@ -883,13 +898,16 @@ QStringList ParseArgsList(const QString &args)
 }
 
 void ShowProgressDialog(QWidget *window, const QString &labelText, ProgressFinishedMethod finished,
-                        ProgressUpdateMethod update)
+                        ProgressUpdateMethod update, ProgressCancelMethod cancel)
 {
   RDProgressDialog dialog(labelText, window);
 
   // if we don't have an update function, set the progress display to be 'infinite spinner'
   dialog.setInfinite(!update);
 
+  if(cancel)
+    dialog.enableCancel(cancel);
+
   QSemaphore tickerSemaphore(1);
 
   // start a lambda thread to tick our functions and close the progress dialog when we're done.
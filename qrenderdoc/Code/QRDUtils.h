@@ -508,6 +508,33 @@ struct ToStr
     return "Unknown";
   }
 
+  static std::string Get(const Bottleneck &el)
+  {
+    switch(el)
+    {
+      case Bottleneck::Overhead: return "Overhead";
+      case Bottleneck::Vertex: return "Vertex";
+      case Bottleneck::Fragment: return "Fragment";
+      case Bottleneck::Fill: return "Fill";
+      case Bottleneck::Bandwidth: return "Bandwidth";
+      case Bottleneck::Compute: return "Compute";
+      default: break;
+    }
+    return "Unknown";
+  }
+
+  static std::string Get(const QueueType &el)
+  {
+    switch(el)
+    {
+      case QueueType::Graphics: return "Graphics";
+      case QueueType::Compute: return "Compute";
+      case QueueType::Copy: return "Copy";
+      default: break;
+    }
+    return "Unknown";
+  }
+
   static std::string Get(const MessageCategory &el)
   {
     switch(el)
@@ -853,13 +880,15 @@ class QProgressDialog;
 
 typedef std::function<float()> ProgressUpdateMethod;
 typedef std::function<bool()> ProgressFinishedMethod;
+typedef std::function<void()> ProgressCancelMethod;
 
 QStringList ParseArgsList(const QString &args);
 bool RunProcessAsAdmin(const QString &fullExecutablePath, const QStringList &params,
                        std::function<void()> finishedCallback = std::function<void()>());
 
 void ShowProgressDialog(QWidget *window, const QString &labelText, ProgressFinishedMethod finished,
-                        ProgressUpdateMethod update = ProgressUpdateMethod());
+                        ProgressUpdateMethod update = ProgressUpdateMethod(),
+                        ProgressCancelMethod cancel = ProgressCancelMethod());
 
 QString GetSystemUsername();
 
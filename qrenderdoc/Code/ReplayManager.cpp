@@ -231,25 +231,39 @@ bool ReplayManager::IsRunning()
 }
 
 void ReplayManager::AsyncInvoke(const QString &tag, ReplayManager::InvokeCallback m)
+{
+  AsyncInvoke(tag, InvokePriority::Normal, m);
+}
+
+void ReplayManager::AsyncInvoke(const QString &tag, InvokePriority priority,
+                                ReplayManager::InvokeCallback m)
 {
   {
     QMutexLocker autolock(&m_RenderLock);
-    for(int i = 0; i < m_RenderQueue.count();)
+    for(QQueue<InvokeHandle *> &queue : m_RenderQueue)
     {
-      if(m_RenderQueue[i]->tag == tag)
-      {
-        InvokeHandle *cmd = m_RenderQueue.takeAt(i);
-        if(cmd->selfdelete)
-          delete cmd;
-      }
-      else
+      for(int i = 0; i < queue.count();)
       {
-        i++;
+        if(queue[i]->tag == tag)
+        {
+          InvokeHandle *cmd = queue.takeAt(i);
+          if(cmd->selfdelete)
+            delete cmd;
+        }
+        else
+        {
+          i++;
+        }
       }
     }
+
+    // the running command is being replaced, so there's no point waiting for it to finish. The
+    // flag is cleared by the render thread once the command returns.
+    if(m_CurrentInvoke && m_Renderer && !tag.isEmpty() && m_CurrentInvoke->tag == tag)
+      m_Renderer->RequestCancel();
   }
 
-  InvokeHandle *cmd = new InvokeHandle(m, tag);
+  InvokeHandle *cmd = new InvokeHandle(m, tag, priority);
   cmd->selfdelete = true;
 
   PushInvoke(cmd);
@@ -387,10 +401,19 @@ void ReplayManager::PushInvoke(ReplayManager::InvokeHandle *cmd)
   }
 
   QMutexLocker autolock(&m_RenderLock);
-  m_RenderQueue.enqueue(cmd);
+  m_RenderQueue[int(cmd->priority)].enqueue(cmd);
   m_RenderCondition.wakeAll();
 }
 
+ReplayManager::InvokeHandle *ReplayManager::PopInvoke()
+{
+  for(int p = NumInvokePriorities - 1; p >= 0; p--)
+    if(!m_RenderQueue[p].isEmpty())
+      return m_RenderQueue[p].dequeue();
+
+  return NULL;
+}
+
 void ReplayManager::run()
 {
   IReplayController *renderer = NULL;
@@ -417,6 +440,11 @@ void ReplayManager::run()
 
   qInfo() << "QRenderDoc - renderer created for" << m_Logfile;
 
+  {
+    QMutexLocker autolock(&m_RenderLock);
+    m_Renderer = renderer;
+  }
+
   m_Running = true;
 
   // main render command loop
@@ -424,15 +452,19 @@ void ReplayManager::run()
   {
     InvokeHandle *cmd = NULL;
 
-    // wait for the condition to be woken, grab top of current queue,
+    // wait for the condition to be woken, grab top of the highest priority queue,
     // unlock again.
     {
       QMutexLocker autolock(&m_RenderLock);
-      if(m_RenderQueue.isEmpty())
+      cmd = PopInvoke();
+
+      if(cmd == NULL)
+      {
         m_RenderCondition.wait(&m_RenderLock, 10);
+        cmd = PopInvoke();
+      }
 
-      if(!m_RenderQueue.isEmpty())
-        cmd = m_RenderQueue.dequeue();
+      m_CurrentInvoke = cmd;
     }
 
     if(cmd == NULL)
@@ -441,6 +473,13 @@ void ReplayManager::run()
     if(cmd->method != NULL)
       cmd->method(renderer);
 
+    // any cancel request was for this command, so don't let it leak into the next one
+    {
+      QMutexLocker autolock(&m_RenderLock);
+      m_CurrentInvoke = NULL;
+      renderer->ClearCancelRequest();
+    }
+
     // if it's a throwaway command, delete it
     if(cmd->selfdelete)
       delete cmd;
@@ -450,22 +489,27 @@ void ReplayManager::run()
 
   // clean up anything left in the queue
   {
-    QQueue<InvokeHandle *> queue;
+    QQueue<InvokeHandle *> queue[NumInvokePriorities];
 
     {
       QMutexLocker autolock(&m_RenderLock);
-      m_RenderQueue.swap(queue);
+      for(int p = 0; p < NumInvokePriorities; p++)
+        m_RenderQueue[p].swap(queue[p]);
+      m_Renderer = NULL;
     }
 
-    for(InvokeHandle *cmd : queue)
+    for(int p = 0; p < NumInvokePriorities; p++)
     {
-      if(cmd == NULL)
-        continue;
+      for(InvokeHandle *cmd : queue[p])
+      {
+        if(cmd == NULL)
+          continue;
 
-      if(cmd->selfdelete)
-        delete cmd;
-      else
-        cmd->processed.release();
+        if(cmd->selfdelete)
+          delete cmd;
+        else
+          cmd->processed.release();
+      }
     }
   }
 
@@ -62,8 +62,10 @@ public:
   // other work is taking a while or because we're sending requests faster than they can be
   // processed.
   // the manager processes only the request on the top of the queue, so when a new tagged invoke
-  // comes in, we remove any other requests in the queue before it that have the same tag
+  // comes in, we remove any other requests in the queue before it that have the same tag. If one
+  // with the same tag is currently running we ask the replay to cancel it, so it returns early.
   void AsyncInvoke(const QString &tag, InvokeCallback m);
+  void AsyncInvoke(const QString &tag, InvokePriority priority, InvokeCallback m);
   void AsyncInvoke(InvokeCallback m);
   void BlockInvoke(InvokeCallback m);
 
@@ -88,26 +90,38 @@ public:
 private:
   struct InvokeHandle
   {
-    InvokeHandle(InvokeCallback m, const QString &t = QString())
+    InvokeHandle(InvokeCallback m, const QString &t = QString(),
+                 InvokePriority p = InvokePriority::Normal)
     {
       tag = t;
       method = m;
+      priority = p;
       selfdelete = false;
     }
 
     QString tag;
     InvokeCallback method;
+    InvokePriority priority;
     QSemaphore processed;
     bool selfdelete;
   };
 
   void run();
 
+  static const int NumInvokePriorities = int(InvokePriority::Interactive) + 1;
+
+  // one FIFO queue per priority, the highest non-empty queue is always served first
   QMutex m_RenderLock;
-  QQueue<InvokeHandle *> m_RenderQueue;
+  QQueue<InvokeHandle *> m_RenderQueue[NumInvokePriorities];
   QWaitCondition m_RenderCondition;
 
+  // the command currently executing on the render thread and the controller it's running against,
+  // both protected by m_RenderLock so that other threads can cancel it.
+  InvokeHandle *m_CurrentInvoke = NULL;
+  IReplayController *m_Renderer = NULL;
+
   void PushInvoke(InvokeHandle *cmd);
+  InvokeHandle *PopInvoke();
 
   int m_ProxyRenderer;
   QString m_ReplayHost;
@@ -67,6 +67,28 @@ struct TypeConversion
     T *pyCopy = new T(in);
     return SWIG_NewPointerObj((void *)pyCopy, type_info, SWIG_BUILTIN_INIT);
   }
+
+  // relocates the object into python instead of copying it. The source is always consumed, even on
+  // failure, and must be freed as raw memory without being destructed. The replay types only hold
+  // arrays and plain data, so a bitwise move is safe and avoids deep-copying the drawcall tree.
+  static PyObject *ConvertToPyMove(PyObject *self, T &in)
+  {
+    swig_type_info *type_info = GetTypeInfo();
+    if(type_info == NULL)
+    {
+      in.~T();
+      return NULL;
+    }
+
+    T *pyObj = (T *)::operator new(sizeof(T));
+    memcpy((void *)pyObj, (void *)&in, sizeof(T));
+    PyObject *ret = SWIG_NewPointerObj((void *)pyObj, type_info, SWIG_BUILTIN_INIT);
+
+    if(!ret)
+      delete pyObj;
+
+    return ret;
+  }
 };
 
 // specialisations for pointer types (opaque handles to be moved not copied)
@@ -305,6 +327,55 @@ struct TypeConversion<rdctype::pair<A, B>, false>
   }
 };
 
+// python object that takes ownership of the storage of an rdctype::array<byte> and exposes it
+// through the buffer protocol, so that a memoryview or numpy array can wrap it without a copy.
+struct ByteArrayStorage
+{
+  PyObject_HEAD
+
+  byte *elems;
+  Py_ssize_t count;
+};
+
+static void ByteArrayStorage_dealloc(PyObject *self)
+{
+  ByteArrayStorage *storage = (ByteArrayStorage *)self;
+  rdctype::array<byte>::deallocate(storage->elems);
+  PyObject_Del(self);
+}
+
+static int ByteArrayStorage_getbuffer(PyObject *self, Py_buffer *view, int flags)
+{
+  ByteArrayStorage *storage = (ByteArrayStorage *)self;
+  return PyBuffer_FillInfo(view, self, storage->elems, storage->count, 0, flags);
+}
+
+static PyTypeObject *ByteArrayStorage_Type()
+{
+  static PyBufferProcs buffer_procs = {};
+  static PyTypeObject type = {PyVarObject_HEAD_INIT(NULL, 0)};
+
+  if(type.tp_name == NULL)
+  {
+    buffer_procs.bf_getbuffer = &ByteArrayStorage_getbuffer;
+
+    type.tp_name = "renderdoc.ByteArrayStorage";
+    type.tp_basicsize = sizeof(ByteArrayStorage);
+    type.tp_flags = Py_TPFLAGS_DEFAULT;
+    type.tp_doc = "Storage backing a memoryview of bytes returned from the replay.";
+    type.tp_dealloc = &ByteArrayStorage_dealloc;
+    type.tp_as_buffer = &buffer_procs;
+
+    if(PyType_Ready(&type) < 0)
+    {
+      type.tp_name = NULL;
+      return NULL;
+    }
+  }
+
+  return &type;
+}
+
 // specialisation for array<byte>
 template <>
 struct TypeConversion<rdctype::array<byte>, false>
@@ -345,6 +416,30 @@ struct TypeConversion<rdctype::array<byte>, false>
   {
     return ConvertToPy(self, in, NULL);
   }
+
+  // hands the array's storage to python and returns a memoryview over it. The array is left empty.
+  static PyObject *ConvertToPyMove(PyObject *self, rdctype::array<byte> &in, int *failIdx)
+  {
+    PyTypeObject *type = ByteArrayStorage_Type();
+    if(!type)
+      return NULL;
+
+    ByteArrayStorage *storage = PyObject_New(ByteArrayStorage, type);
+    if(!storage)
+      return NULL;
+
+    storage->elems = in.elems;
+    storage->count = (Py_ssize_t)in.count;
+
+    in.elems = NULL;
+    in.count = 0;
+
+    // the memoryview holds its own reference to the storage
+    PyObject *ret = PyMemoryView_FromObject((PyObject *)storage);
+    Py_DECREF(storage);
+
+    return ret;
+  }
 };
 
 // specialisation for array
@@ -420,6 +515,42 @@ struct TypeConversion<rdctype::array<U>, false>
   {
     return ConvertToPy(self, in, NULL);
   }
+
+  // moves each element into python rather than copying it. The array is left empty.
+  static PyObject *ConvertToPyMove(PyObject *self, rdctype::array<U> &in, int *failIdx)
+  {
+    PyObject *list = PyList_New(0);
+
+    int i = 0;
+    for(; list && i < in.count; i++)
+    {
+      PyObject *elem = TypeConversion<U>::ConvertToPyMove(self, in.elems[i]);
+
+      if(elem)
+      {
+        PyList_Append(list, elem);
+        Py_DECREF(elem);
+      }
+      else
+      {
+        if(failIdx)
+          *failIdx = i;
+
+        Py_XDECREF(list);
+        list = NULL;
+      }
+    }
+
+    // elements up to i were consumed, anything after a failure still needs to be destructed
+    for(; i < in.count; i++)
+      in.elems[i].~U();
+
+    rdctype::array<U>::deallocate(in.elems);
+    in.elems = NULL;
+    in.count = 0;
+
+    return list;
+  }
 };
 
 // specialisation for string
@@ -92,4 +92,20 @@ CONTAINER_TYPEMAPS_VARIANT(ContainerType)
 CONTAINER_TYPEMAPS_VARIANT(ContainerType *)
 CONTAINER_TYPEMAPS_VARIANT(ContainerType &)
 
+%enddef
+
+// arrays returned by value aren't referenced by anything else, so their contents can be moved into
+// python instead of copied. Used for large results like buffer contents or the drawcall tree.
+%define MOVE_CONTAINER_TYPEMAPS(ContainerType)
+
+%typemap(out, fragment="pyconvert") ContainerType {
+  int failIdx = 0;
+  $result = TypeConversion<$1_basetype>::ConvertToPyMove(self, $1, &failIdx);
+  if(!$result)
+  {
+    snprintf(convert_error, sizeof(convert_error)-1, "in method '$symname' returning type '$1_basetype', encoding element %d", failIdx);
+    SWIG_exception_fail(SWIG_ValueError, convert_error);
+  }
+}
+
 %enddef
\ No newline at end of file
@@ -51,6 +51,11 @@ SIMPLE_TYPEMAPS(rdctype::str)
 
 CONTAINER_TYPEMAPS(rdctype::array)
 
+// byte arrays come back as a memoryview over the returned storage, and drawcalls are moved rather
+// than deep-copied
+MOVE_CONTAINER_TYPEMAPS(rdctype::array<byte>)
+MOVE_CONTAINER_TYPEMAPS(rdctype::array<DrawcallDescription>)
+
 %typemap(in, fragment="pyconvert") std::function {
   PyObject *func = $input;
   failed$argnum = false;
@@ -77,6 +82,14 @@ static PyObject *resid_str(PyObject *resid)
 }
 %}
 
+// gathering data for many events can take a while, so let other python threads run meanwhile. The
+// arguments are converted before and the results after, so no python objects are touched inside.
+%exception IReplayController::GetEventData {
+  Py_BEGIN_ALLOW_THREADS
+  $action
+  Py_END_ALLOW_THREADS
+}
+
 %{
   #include "renderdoc_replay.h"
 %}
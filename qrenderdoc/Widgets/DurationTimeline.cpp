@@ -0,0 +1,261 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+
+#include "DurationTimeline.h"
+#include <QMouseEvent>
+#include <QPainter>
+#include <QToolTip>
+#include "Code/QRDUtils.h"
+
+DurationTimeline::DurationTimeline(QWidget *parent) : QWidget(parent)
+{
+  m_TimeUnit = TimeUnit::Microseconds;
+
+  setMouseTracking(true);
+  setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Fixed);
+}
+
+DurationTimeline::~DurationTimeline()
+{
+}
+
+void DurationTimeline::setRegions(const rdctype::array<TimelineRegion> &regions,
+                                  const FlatDrawcallList *flat)
+{
+  m_Regions = regions;
+  m_Flat = flat;
+
+  m_TotalDuration = 0.0;
+  m_MaxDepth = 0;
+  m_MaxDurations.clear();
+
+  for(const TimelineRegion &r : m_Regions)
+  {
+    if(r.depth == 0)
+      m_TotalDuration += r.duration;
+
+    m_MaxDepth = qMax(m_MaxDepth, r.depth);
+
+    if((int)r.depth >= m_MaxDurations.count())
+      m_MaxDurations.resize(r.depth + 1);
+
+    m_MaxDurations[r.depth] = qMax(m_MaxDurations[r.depth], r.duration);
+  }
+
+  updateGeometry();
+  update();
+}
+
+void DurationTimeline::clearRegions()
+{
+  setRegions(rdctype::array<TimelineRegion>(), NULL);
+}
+
+void DurationTimeline::setCurrentEvent(uint32_t eventID)
+{
+  m_EID = eventID;
+  update();
+}
+
+void DurationTimeline::setTimeUnit(TimeUnit unit)
+{
+  m_TimeUnit = unit;
+}
+
+int DurationTimeline::rowHeight() const
+{
+  return fontMetrics().height() + 4;
+}
+
+int DurationTimeline::numRows() const
+{
+  if(m_Regions.empty())
+    return 1;
+
+  int rows = (int)m_MaxDepth + 1;
+
+  return rows < m_MaxRows ? rows : m_MaxRows;
+}
+
+QSize DurationTimeline::sizeHint() const
+{
+  return QSize(200, numRows() * rowHeight() + m_Margin * 2);
+}
+
+QSize DurationTimeline::minimumSizeHint() const
+{
+  return QSize(50, sizeHint().height());
+}
+
+QRectF DurationTimeline::regionRect(const TimelineRegion &region) const
+{
+  if(m_TotalDuration <= 0.0)
+    return QRectF();
+
+  QRect r = rect().marginsRemoved(QMargins(m_Margin, m_Margin, m_Margin, m_Margin));
+
+  double scale = r.width() / m_TotalDuration;
+
+  // make sure every region has at least a sliver visible
+  return QRectF(r.left() + region.start * scale, r.top() + region.depth * rowHeight(),
+                qMax(1.0, region.duration * scale), rowHeight());
+}
+
+int DurationTimeline::regionAt(QPoint pos) const
+{
+  for(int32_t i = 0; i < m_Regions.count; i++)
+  {
+    if(m_Regions[i].depth >= (uint32_t)m_MaxRows)
+      continue;
+
+    if(regionRect(m_Regions[i]).contains(pos))
+      return i;
+  }
+
+  return -1;
+}
+
+QString DurationTimeline::regionName(const TimelineRegion &region) const
+{
+  if(region.drawIndex < 0)
+    return tr("%1 drawcalls").arg(region.numEvents);
+
+  if(m_Flat)
+    return QString::fromUtf8(m_Flat->Name(region.drawIndex));
+
+  return QFormatStr("EID %1").arg(region.eventID);
+}
+
+QColor DurationTimeline::heatColor(const TimelineRegion &region) const
+{
+  double maxDuration = m_MaxDurations[region.depth];
+
+  double heat = maxDuration > 0.0 ? region.duration / maxDuration : 0.0;
+
+  // from green for the cheapest regions in a row, to red for the most expensive
+  return QColor::fromHsvF((1.0 - qBound(0.0, heat, 1.0)) / 3.0, 0.75, 0.95);
+}
+
+void DurationTimeline::mousePressEvent(QMouseEvent *e)
+{
+  if(e->button() != Qt::LeftButton)
+    return;
+
+  int idx = regionAt(e->pos());
+
+  if(idx >= 0)
+    emit eventSelected(m_Regions[idx].lastEventID);
+}
+
+void DurationTimeline::mouseMoveEvent(QMouseEvent *e)
+{
+  int idx = regionAt(e->pos());
+
+  if(idx < 0)
+  {
+    QToolTip::hideText();
+    return;
+  }
+
+  const TimelineRegion &region = m_Regions[idx];
+
+  double scale = 1.0;
+
+  if(m_TimeUnit == TimeUnit::Milliseconds)
+    scale = 1000.0;
+  else if(m_TimeUnit == TimeUnit::Microseconds)
+    scale = 1000000.0;
+  else if(m_TimeUnit == TimeUnit::Nanoseconds)
+    scale = 1000000000.0;
+
+  QString eids = region.lastEventID > region.eventID
+                     ? QFormatStr("%1-%2").arg(region.eventID).arg(region.lastEventID)
+                     : QString::number(region.eventID);
+
+  QString text = tr("%1\nEID %2\n%3 %4 (%5% of the frame) over %6 drawcalls")
+                     .arg(regionName(region))
+                     .arg(eids)
+                     .arg(Formatter::Format(region.duration * scale))
+                     .arg(UnitSuffix(m_TimeUnit))
+                     .arg(Formatter::Format(100.0 * region.duration / m_TotalDuration))
+                     .arg(region.numEvents);
+
+  if(region.critical)
+    text += tr("\nOn the critical path");
+
+  QToolTip::showText(e->globalPos(), text, this);
+}
+
+void DurationTimeline::resizeEvent(QResizeEvent *e)
+{
+  QWidget::resizeEvent(e);
+
+  // the regions were merged for the previous width, so they need to be rebuilt
+  if(e->oldSize().width() != e->size().width())
+    emit resolutionChanged();
+}
+
+void DurationTimeline::paintEvent(QPaintEvent *e)
+{
+  QPainter p(this);
+
+  p.fillRect(rect(), palette().brush(QPalette::Window));
+
+  if(m_Regions.empty() || m_TotalDuration <= 0.0)
+    return;
+
+  const QPen regionPen(palette().color(QPalette::Mid), 1.0);
+  const QPen criticalPen(QColor(0, 0, 0), 2.0);
+  const QPen currentPen(palette().color(QPalette::Highlight), 2.0);
+
+  for(const TimelineRegion &region : m_Regions)
+  {
+    if(region.depth >= (uint32_t)m_MaxRows)
+      continue;
+
+    QRectF r = regionRect(region);
+
+    if(!r.intersects(e->rect()))
+      continue;
+
+    p.fillRect(r, heatColor(region));
+
+    bool current = region.eventID <= m_EID && m_EID <= region.lastEventID;
+
+    p.setPen(current ? currentPen : region.critical ? criticalPen : regionPen);
+    p.drawRect(r.adjusted(0.5, 0.5, -0.5, -0.5));
+
+    // only label regions wide enough to fit a few characters
+    if(r.width() > 30.0)
+    {
+      QRectF textRect = r.adjusted(3.0, 0.0, -3.0, 0.0);
+      QString name = p.fontMetrics().elidedText(regionName(region), Qt::ElideRight,
+                                                (int)textRect.width());
+
+      p.setPen(QColor(0, 0, 0));
+      p.drawText(textRect, Qt::AlignLeft | Qt::AlignVCenter, name);
+    }
+  }
+}
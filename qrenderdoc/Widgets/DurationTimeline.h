@@ -0,0 +1,83 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+
+#pragma once
+
+#include <QVector>
+#include <QWidget>
+#include "renderdoc_replay.h"
+
+enum class TimeUnit : int;
+
+// draws the GPU durations of the frame as a flame graph, one row per level of the marker
+// hierarchy, with each region coloured by how expensive it is compared to the rest of its row.
+class DurationTimeline : public QWidget
+{
+  Q_OBJECT
+
+public:
+  explicit DurationTimeline(QWidget *parent = 0);
+  ~DurationTimeline();
+
+  void setRegions(const rdctype::array<TimelineRegion> &regions, const FlatDrawcallList *flat);
+  void clearRegions();
+
+  void setCurrentEvent(uint32_t eventID);
+  void setTimeUnit(TimeUnit unit);
+
+  QSize sizeHint() const override;
+  QSize minimumSizeHint() const override;
+
+signals:
+  void eventSelected(uint32_t eventID);
+  void resolutionChanged();
+
+protected:
+  void mousePressEvent(QMouseEvent *e) override;
+  void mouseMoveEvent(QMouseEvent *e) override;
+  void resizeEvent(QResizeEvent *e) override;
+  void paintEvent(QPaintEvent *e) override;
+
+private:
+  static const int m_Margin = 2;
+  static const int m_MaxRows = 12;
+
+  int rowHeight() const;
+  int numRows() const;
+  QRectF regionRect(const TimelineRegion &region) const;
+  int regionAt(QPoint pos) const;
+  QString regionName(const TimelineRegion &region) const;
+  QColor heatColor(const TimelineRegion &region) const;
+
+  rdctype::array<TimelineRegion> m_Regions;
+  const FlatDrawcallList *m_Flat = NULL;
+
+  double m_TotalDuration = 0.0;
+  uint32_t m_MaxDepth = 0;
+  QVector<double> m_MaxDurations;
+
+  uint32_t m_EID = 0;
+  TimeUnit m_TimeUnit;
+};
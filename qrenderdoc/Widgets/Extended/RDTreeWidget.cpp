@@ -72,6 +72,12 @@ public:
   }
 
   void endAddChild(RDTreeWidgetItem *item) { endInsertRows(); }
+  void beginInsertChildren(RDTreeWidgetItem *parent, int first, int last)
+  {
+    beginInsertRows(indexForItem(parent, 0), first, last);
+  }
+
+  void endInsertChildren() { endInsertRows(); }
   void beginRemoveChildren(RDTreeWidgetItem *parent, int first, int last)
   {
     beginRemoveRows(indexForItem(parent, 0), first, last);
@@ -289,7 +295,7 @@ void RDTreeWidgetItem::setData(int column, int role, const QVariant &value)
 
       d.data = value;
 
-      if(different && role < Qt::UserRole)
+      if(different && role < Qt::UserRole && m_widget)
         m_widget->m_model->itemChanged(this, {role});
 
       return;
@@ -298,10 +304,62 @@ void RDTreeWidgetItem::setData(int column, int role, const QVariant &value)
 
   dataVec.push_back(RoleData(role, value));
 
-  if(role < Qt::UserRole)
+  if(role < Qt::UserRole && m_widget)
     m_widget->m_model->itemChanged(this, {role});
 }
 
+bool RDTreeWidgetItem::sameContents(const RDTreeWidgetItem &other) const
+{
+  if(m_text != other.m_text || m_icons.count() != other.m_icons.count() ||
+     m_customData != other.m_customData || m_tooltip != other.m_tooltip ||
+     m_bold != other.m_bold || m_italic != other.m_italic || m_treeCol != other.m_treeCol ||
+     m_treeColWidth != other.m_treeColWidth || m_back != other.m_back || m_fore != other.m_fore)
+    return false;
+
+  for(int i = 0; i < m_icons.count(); i++)
+    if(m_icons[i].cacheKey() != other.m_icons[i].cacheKey())
+      return false;
+
+  if((m_data == NULL) != (other.m_data == NULL))
+    return false;
+
+  if(m_data)
+  {
+    if(m_data->count() != other.m_data->count())
+      return false;
+
+    for(int c = 0; c < m_data->count(); c++)
+    {
+      const QVector<RoleData> &a = (*m_data)[c];
+      const QVector<RoleData> &b = (*other.m_data)[c];
+
+      if(a.count() != b.count())
+        return false;
+
+      for(int i = 0; i < a.count(); i++)
+        if(a[i].role != b[i].role || a[i].data != b[i].data)
+          return false;
+    }
+  }
+
+  return true;
+}
+
+void RDTreeWidgetItem::takeContents(RDTreeWidgetItem &other)
+{
+  m_text.swap(other.m_text);
+  m_icons.swap(other.m_icons);
+  qSwap(m_data, other.m_data);
+  m_customData = other.m_customData;
+  m_tooltip = other.m_tooltip;
+  m_bold = other.m_bold;
+  m_italic = other.m_italic;
+  m_treeCol = other.m_treeCol;
+  m_treeColWidth = other.m_treeColWidth;
+  m_back = other.m_back;
+  m_fore = other.m_fore;
+}
+
 void RDTreeWidgetItem::addChild(RDTreeWidgetItem *item)
 {
   int colCount = item->m_text.count();
@@ -420,6 +478,7 @@ RDTreeWidget::RDTreeWidget(QWidget *parent) : QTreeView(parent)
 
 RDTreeWidget::~RDTreeWidget()
 {
+  delete m_rebuildRoot;
   delete m_root;
   delete m_model;
 }
@@ -458,6 +517,99 @@ void RDTreeWidget::endUpdate()
   }
 }
 
+void RDTreeWidget::beginRebuild()
+{
+  m_rebuildMap.clear();
+
+  delete m_rebuildRoot;
+  m_rebuildRoot = new RDTreeWidgetItem;
+}
+
+void RDTreeWidget::endRebuild()
+{
+  if(!m_rebuildRoot)
+    return;
+
+  QVector<RDTreeWidgetItem *> items;
+  items.swap(m_rebuildRoot->m_children);
+
+  delete m_rebuildRoot;
+  m_rebuildRoot = NULL;
+
+  mergeChildren(m_root, items);
+}
+
+void RDTreeWidget::mergeChildren(RDTreeWidgetItem *parent, QVector<RDTreeWidgetItem *> &items)
+{
+  int existingCount = parent->childCount();
+  int common = qMin(existingCount, items.count());
+
+  for(int i = 0; i < common; i++)
+  {
+    RDTreeWidgetItem *existing = parent->m_children[i];
+    RDTreeWidgetItem *item = items[i];
+
+    // the tag isn't displayed, so it can always be updated silently
+    existing->m_tag = item->m_tag;
+
+    if(!existing->sameContents(*item))
+    {
+      existing->takeContents(*item);
+      m_model->itemChanged(existing, {});
+    }
+
+    QVector<RDTreeWidgetItem *> children;
+    children.swap(item->m_children);
+    for(RDTreeWidgetItem *child : children)
+      child->m_parent = NULL;
+
+    mergeChildren(existing, children);
+
+    m_rebuildMap[item] = existing;
+
+    item->m_parent = NULL;
+    delete item;
+  }
+
+  if(existingCount > common)
+  {
+    m_model->beginRemoveChildren(parent, common, existingCount - 1);
+
+    // the hovered item could be anywhere in the removed subtrees, it'll be found again on the next
+    // mouse move
+    m_currentHoverItem = NULL;
+
+    for(int i = common; i < existingCount; i++)
+    {
+      RDTreeWidgetItem *item = parent->m_children[i];
+
+      // detach the whole subtree so deleting it doesn't notify the model row by row
+      item->m_parent = NULL;
+      item->setWidget(NULL);
+      delete item;
+    }
+
+    parent->m_children.resize(common);
+
+    m_model->endRemoveChildren();
+  }
+
+  if(items.count() > common)
+  {
+    m_model->beginInsertChildren(parent, common, items.count() - 1);
+
+    for(int i = common; i < items.count(); i++)
+    {
+      RDTreeWidgetItem *item = items[i];
+      item->m_parent = parent;
+      item->setWidget(this);
+      parent->m_children.push_back(item);
+    }
+
+    m_model->endInsertChildren();
+  }
+}
+
 void RDTreeWidget::setColumns(const QStringList &columns)
 {
   m_headers = columns;
@@ -540,7 +692,7 @@ void RDTreeWidget::scrollToItem(RDTreeWidgetItem *node)
 
 void RDTreeWidget::clear()
 {
-  m_root->clear();
+  buildRoot()->clear();
 }
 
 void RDTreeWidget::mouseMoveEvent(QMouseEvent *e)
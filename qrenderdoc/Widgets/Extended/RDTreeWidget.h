@@ -24,6 +24,7 @@
 
 #pragma once
 
+#include <QHash>
 #include <QTreeView>
 
 class RDTreeWidget;
@@ -108,6 +109,10 @@ private:
   friend class RDTreeWidget;
   friend class RDTreeWidgetModel;
 
+  // compares and moves everything that's displayed, i.e. everything except the tag and children
+  bool sameContents(const RDTreeWidgetItem &other) const;
+  void takeContents(RDTreeWidgetItem &other);
+
   void setWidget(RDTreeWidget *widget);
   RDTreeWidget *m_widget = NULL;
 
@@ -162,15 +167,30 @@ public:
   void setHoverHandCursor(bool hand) { m_hoverHandCursor = hand; }
   void setHoverClickActivate(bool click) { m_activateOnClick = click; }
   void setClearSelectionOnFocusLoss(bool clear) { m_clearSelectionOnFocusLoss = clear; }
-  RDTreeWidgetItem *invisibleRootItem() { return m_root; }
-  void addTopLevelItem(RDTreeWidgetItem *item) { m_root->addChild(item); }
-  RDTreeWidgetItem *topLevelItem(int index) const { return m_root->child(index); }
-  int indexOfTopLevelItem(RDTreeWidgetItem *item) const { return m_root->indexOfChild(item); }
-  RDTreeWidgetItem *takeTopLevelItem(int index) { return m_root->takeChild(index); }
-  int topLevelItemCount() const { return m_root->childCount(); }
+  RDTreeWidgetItem *invisibleRootItem() { return buildRoot(); }
+  void addTopLevelItem(RDTreeWidgetItem *item) { buildRoot()->addChild(item); }
+  RDTreeWidgetItem *topLevelItem(int index) const { return buildRoot()->child(index); }
+  int indexOfTopLevelItem(RDTreeWidgetItem *item) const
+  {
+    return buildRoot()->indexOfChild(item);
+  }
+  RDTreeWidgetItem *takeTopLevelItem(int index) { return buildRoot()->takeChild(index); }
+  int topLevelItemCount() const { return buildRoot()->childCount(); }
   void beginUpdate();
   void endUpdate();
 
+  // between these calls clear() and adding items build up a new set of items off to the side,
+  // without touching the view. endRebuild() then compares them against the current items row by
+  // row, and only rows that differ are updated, inserted or removed - unchanged rows keep their
+  // expansion and selection. Any new item that matched an existing row is deleted, so pointers
+  // kept to new items must be passed through rebuiltItem() afterwards.
+  void beginRebuild();
+  void endRebuild();
+  RDTreeWidgetItem *rebuiltItem(RDTreeWidgetItem *item) const
+  {
+    return m_rebuildMap.value(item, item);
+  }
+
   void setColumns(const QStringList &columns);
   QString headerText(int column) const { return m_headers[column]; }
   void setHeaderText(int column, const QString &text);
@@ -216,12 +236,20 @@ private:
   void setModel(QAbstractItemModel *model) override {}
   void itemDataChanged(RDTreeWidgetItem *item, int role);
 
+  RDTreeWidgetItem *buildRoot() const { return m_rebuildRoot ? m_rebuildRoot : m_root; }
+  void mergeChildren(RDTreeWidgetItem *parent, QVector<RDTreeWidgetItem *> &items);
+
   friend class RDTreeWidgetModel;
   friend class RDTreeWidgetItem;
 
   // invisible root item, used to simplify recursion by even top-level items having a parent
   RDTreeWidgetItem *m_root;
 
+  // while rebuilding, new top-level items are added under this detached root instead
+  RDTreeWidgetItem *m_rebuildRoot = NULL;
+  // new items from the last rebuild -> the existing item they were merged into
+  QHash<RDTreeWidgetItem *, RDTreeWidgetItem *> m_rebuildMap;
+
   RDTreeWidgetModel *m_model;
 
   QStringList m_headers;
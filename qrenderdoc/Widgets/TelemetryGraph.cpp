@@ -0,0 +1,123 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+
+
+#include "TelemetryGraph.h"
+#include <QPainter>
+#include <QPainterPath>
+
+TelemetryGraph::TelemetryGraph(QWidget *parent) : QWidget(parent)
+{
+  setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Fixed);
+}
+
+TelemetryGraph::~TelemetryGraph()
+{
+}
+
+void TelemetryGraph::addSample(double frameAvg, double frameMax, double apiMilliseconds)
+{
+  if(m_Samples.count() >= m_MaxSamples)
+    m_Samples.removeFirst();
+
+  m_Samples.push_back({frameAvg, frameMax, apiMilliseconds});
+
+  update();
+}
+
+void TelemetryGraph::clearSamples()
+{
+  m_Samples.clear();
+  update();
+}
+
+QSize TelemetryGraph::sizeHint() const
+{
+  return QSize(200, 80);
+}
+
+QSize TelemetryGraph::minimumSizeHint() const
+{
+  return QSize(50, sizeHint().height());
+}
+
+void TelemetryGraph::paintEvent(QPaintEvent *e)
+{
+  QPainter p(this);
+
+  p.fillRect(rect(), palette().brush(QPalette::Base));
+
+  p.setPen(QPen(palette().color(QPalette::Mid), 1.0));
+  p.drawRect(QRectF(rect()).adjusted(0.5, 0.5, -0.5, -0.5));
+
+  if(m_Samples.isEmpty())
+    return;
+
+  // the vertical scale covers the longest frame in the history, with a floor so that an idle
+  // target doesn't magnify noise
+  double scaleMax = 1.0;
+  for(const Sample &s : m_Samples)
+    scaleMax = qMax(scaleMax, qMax(s.frameMax, s.apiMilliseconds));
+
+  QRectF r = QRectF(rect()).marginsRemoved(QMarginsF(m_Margin, m_Margin, m_Margin, m_Margin));
+
+  const double step = r.width() / double(m_MaxSamples - 1);
+  const double left = r.right() - step * (m_Samples.count() - 1);
+
+  auto point = [&](int i, double value) {
+    return QPointF(left + step * i, r.bottom() - r.height() * qBound(0.0, value / scaleMax, 1.0));
+  };
+
+  // API overhead is filled in under the frame time lines
+  QPainterPath api;
+  api.moveTo(left, r.bottom());
+  for(int i = 0; i < m_Samples.count(); i++)
+    api.lineTo(point(i, m_Samples[i].apiMilliseconds));
+  api.lineTo(r.right(), r.bottom());
+  api.closeSubpath();
+
+  p.setRenderHint(QPainter::Antialiasing);
+
+  p.fillPath(api, QColor(120, 200, 120, 160));
+
+  QPolygonF maxLine, avgLine;
+  for(int i = 0; i < m_Samples.count(); i++)
+  {
+    maxLine << point(i, m_Samples[i].frameMax);
+    avgLine << point(i, m_Samples[i].frameAvg);
+  }
+
+  p.setPen(QPen(QColor(220, 80, 60), 1.0));
+  p.drawPolyline(maxLine);
+
+  p.setPen(QPen(palette().color(QPalette::Highlight), 1.5));
+  p.drawPolyline(avgLine);
+
+  p.setRenderHint(QPainter::Antialiasing, false);
+
+  p.setPen(palette().color(QPalette::Text));
+  p.drawText(r.adjusted(3.0, 0.0, 0.0, 0.0), Qt::AlignLeft | Qt::AlignTop,
+             tr("%1 ms").arg(scaleMax, 0, 'f', 1));
+}
@@ -0,0 +1,64 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+
+
+#pragma once
+
+#include <QVector>
+#include <QWidget>
+
+// plots the recent history of a live target's frame times, along with the time spent in
+// RenderDoc's API wrappers, one sample per telemetry message. The newest sample is on the right.
+class TelemetryGraph : public QWidget
+{
+  Q_OBJECT
+
+public:
+  explicit TelemetryGraph(QWidget *parent = 0);
+  ~TelemetryGraph();
+
+  // all times are in milliseconds
+  void addSample(double frameAvg, double frameMax, double apiMilliseconds);
+  void clearSamples();
+
+  QSize sizeHint() const override;
+  QSize minimumSizeHint() const override;
+
+protected:
+  void paintEvent(QPaintEvent *e) override;
+
+private:
+  static const int m_Margin = 2;
+  static const int m_MaxSamples = 120;
+
+  struct Sample
+  {
+    double frameAvg;
+    double frameMax;
+    double apiMilliseconds;
+  };
+
+  QVector<Sample> m_Samples;
+};
@@ -33,7 +33,11 @@ APIInspector::APIInspector(ICaptureContext &ctx, QWidget *parent)
 {
   ui->setupUi(this);
 
-  ui->apiEvents->setColumns({lit("EID"), tr("Event")});
+  ui->apiEvents->setColumns({lit("EID"), tr("Event"), tr("CPU Time"), tr("Thread")});
+  ui->apiEvents->header()->setSectionResizeMode(1, QHeaderView::Stretch);
+  ui->apiEvents->header()->setSectionResizeMode(2, QHeaderView::ResizeToContents);
+  ui->apiEvents->header()->setSectionResizeMode(3, QHeaderView::ResizeToContents);
+  ui->apiEvents->header()->setStretchLastSection(false);
 
   ui->splitter->setCollapsible(1, true);
   ui->splitter->setSizes({1, 0});
@@ -121,37 +125,31 @@ void APIInspector::fillAPIView()
   ui->apiEvents->setUpdatesEnabled(false);
   ui->apiEvents->clear();
 
-  QRegularExpression rgxopen(lit("^\\s*{"));
-  QRegularExpression rgxclose(lit("^\\s*}"));
-
   const DrawcallDescription *draw = m_Ctx.CurSelectedDrawcall();
+  const rdctype::array<ThreadTimeline> &threads = m_Ctx.FrameInfo().threadTimelines;
 
   if(draw != NULL && draw->events.count > 0)
   {
+    QVector<uint32_t> eventIDs;
+
     for(const APIEvent &ev : draw->events)
     {
-      QStringList lines = ToQStr(ev.eventDesc).split(lit("\n"), QString::SkipEmptyParts);
-
-      RDTreeWidgetItem *root = new RDTreeWidgetItem({QString::number(ev.eventID), lines[0]});
-
-      int i = 1;
-
-      if(i < lines.count() && lines[i].trimmed() == lit("{"))
-        i++;
-
-      QList<RDTreeWidgetItem *> nodestack;
-      nodestack.push_back(root);
-
-      for(; i < lines.count(); i++)
+      // the CPU timeline is optional, show when the call was made relative to the frame start and
+      // which of the frame's threads made it
+      QString cpuTime, thread;
+      for(int t = 0; t < threads.count; t++)
       {
-        if(rgxopen.match(lines[i]).hasMatch())
-          nodestack.push_back(nodestack.back()->child(nodestack.back()->childCount() - 1));
-        else if(rgxclose.match(lines[i]).hasMatch())
-          nodestack.pop_back();
-        else if(!nodestack.empty())
-          nodestack.back()->addChild(new RDTreeWidgetItem({QString(), lines[i].trimmed()}));
+        if(threads[t].threadID == ev.threadID)
+        {
+          cpuTime = QFormatStr("%1 ms").arg(double(ev.cpuTimestamp) / 1000.0, 0, 'f', 3);
+          thread = QString::number(t);
+          break;
+        }
       }
 
+      RDTreeWidgetItem *root = new RDTreeWidgetItem(
+          {QString::number(ev.eventID), ToQStr(ev.eventDesc), cpuTime, thread});
+
       if(ev.eventID == draw->eventID)
         root->setBold(true);
 
@@ -160,7 +158,61 @@ void APIInspector::fillAPIView()
       ui->apiEvents->addTopLevelItem(root);
 
       ui->apiEvents->setSelectedItem(root);
+
+      eventIDs.push_back(ev.eventID);
     }
+
+    // the parameters aren't part of the drawcall list, fetch them for just these events
+    uint32_t drawEID = draw->eventID;
+
+    m_Ctx.Replay().AsyncInvoke([this, drawEID, eventIDs](IReplayController *r) {
+      QStringList parameters;
+      for(uint32_t eid : eventIDs)
+        parameters.push_back(ToQStr(r->GetEventParameters(eid)));
+
+      GUIInvoke::call([this, drawEID, parameters]() { addParameters(drawEID, parameters); });
+    });
   }
   ui->apiEvents->setUpdatesEnabled(true);
 }
+
+void APIInspector::addParameters(uint32_t drawEID, const QStringList &parameters)
+{
+  const DrawcallDescription *draw = m_Ctx.CurSelectedDrawcall();
+
+  // the selection moved on while the parameters were being fetched
+  if(draw == NULL || draw->eventID != drawEID ||
+     ui->apiEvents->topLevelItemCount() != parameters.count())
+    return;
+
+  QRegularExpression rgxopen(lit("^\\s*{"));
+  QRegularExpression rgxclose(lit("^\\s*}"));
+
+  ui->apiEvents->setUpdatesEnabled(false);
+
+  for(int p = 0; p < parameters.count(); p++)
+  {
+    QStringList lines = parameters[p].split(lit("\n"), QString::SkipEmptyParts);
+
+    int i = 0;
+
+    if(i < lines.count() && lines[i].trimmed() == lit("{"))
+      i++;
+
+    QList<RDTreeWidgetItem *> nodestack;
+    nodestack.push_back(ui->apiEvents->topLevelItem(p));
+
+    for(; i < lines.count(); i++)
+    {
+      if(rgxopen.match(lines[i]).hasMatch())
+        nodestack.push_back(nodestack.back()->child(nodestack.back()->childCount() - 1));
+      else if(rgxclose.match(lines[i]).hasMatch())
+        nodestack.pop_back();
+      else if(!nodestack.empty())
+        nodestack.back()->addChild(
+            new RDTreeWidgetItem({QString(), lines[i].trimmed(), QString(), QString()}));
+    }
+  }
+
+  ui->apiEvents->setUpdatesEnabled(true);
+}
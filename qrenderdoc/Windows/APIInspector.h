@@ -57,4 +57,5 @@ private:
 
   void addCallstack(rdctype::array<rdctype::str> calls);
   void fillAPIView();
+  void addParameters(uint32_t drawEID, const QStringList &parameters);
 };
@@ -29,6 +29,7 @@
 #include <QMenu>
 #include <QMouseEvent>
 #include <QScrollBar>
+#include <QSemaphore>
 #include <QTimer>
 #include <QtMath>
 #include "Code/Resources.h"
@@ -513,87 +514,135 @@ public:
 
           const FormatElement &el = elementForColumn(col);
 
-          uint32_t instIdx = 0;
-          if(el.instancerate > 0)
-            instIdx = curInstance / el.instancerate;
-
           if(el.buffer < buffers.size())
           {
-            const byte *data = buffers[el.buffer]->data;
-            const byte *end = buffers[el.buffer]->end;
+            if(windowed)
+            {
+              // rows outside the window are blank until the data for them arrives
+              if(idx < windowFirstRow || idx - windowFirstRow >= windowRowCount)
+              {
+                if(fetchWindow)
+                  fetchWindow(idx);
 
-            if(!el.perinstance)
-              data += buffers[el.buffer]->stride * idx;
-            else
-              data += buffers[el.buffer]->stride * instIdx;
+                return QVariant();
+              }
 
-            data += el.offset;
+              idx -= windowFirstRow;
+            }
 
-            // only slightly wasteful, we need to fetch all variants together
-            // since some formats are packed and can't be read individually
-            QVariantList list = el.GetVariants(data, end);
+            return formatComponent(col, buffers[el.buffer], idx);
+          }
+        }
+      }
+    }
 
-            int comp = componentForIndex(col);
+    return QVariant();
+  }
 
-            if(comp < list.count())
-            {
-              QVariant &v = list[comp];
+  // format one column from the given row of a buffer. The row is relative to the start of the
+  // buffer's data, which for a windowed buffer is windowFirstRow.
+  QVariant formatComponent(int col, const BufferData *buf, uint32_t row) const
+  {
+    const FormatElement &el = elementForColumn(col);
 
-              QString ret;
+    // only slightly wasteful, we need to fetch all variants together
+    // since some formats are packed and can't be read individually
+    QVariantList list = el.GetVariants(elementData(el, buf, row), buf->end);
 
-              QMetaType::Type vt = (QMetaType::Type)v.type();
+    int comp = componentForIndex(col);
 
-              if(vt == QMetaType::Double)
-              {
-                double d = v.toDouble();
-                // pad with space on left if sign is missing, to better align
-                if(d < 0.0)
-                  ret = Formatter::Format(d);
-                else if(d > 0.0)
-                  ret = lit(" ") + Formatter::Format(d);
-                else if(qIsNaN(d))
-                  ret = lit(" NaN");
-                else
-                  // force negative and positive 0 together
-                  ret = lit(" ") + Formatter::Format(0.0);
-              }
-              else if(vt == QMetaType::Float)
-              {
-                float f = v.toFloat();
-                // pad with space on left if sign is missing, to better align
-                if(f < 0.0)
-                  ret = Formatter::Format(f);
-                else if(f > 0.0)
-                  ret = lit(" ") + Formatter::Format(f);
-                else if(qIsNaN(f))
-                  ret = lit(" NaN");
-                else
-                  // force negative and positive 0 together
-                  ret = lit(" ") + Formatter::Format(0.0);
-              }
-              else if(vt == QMetaType::UInt || vt == QMetaType::UShort || vt == QMetaType::UChar)
-              {
-                ret = Formatter::Format(v.toUInt(), el.hex);
-              }
-              else if(vt == QMetaType::Int || vt == QMetaType::Short || vt == QMetaType::SChar)
-              {
-                int i = v.toInt();
-                if(i > 0)
-                  ret = lit(" ") + Formatter::Format(i);
-                else
-                  ret = Formatter::Format(i);
-              }
-              else
-                ret = v.toString();
+    if(comp < list.count())
+      return formatVariant(list[comp], el.hex);
 
-              return ret;
-            }
-          }
+    return QVariant();
+  }
+
+  // write rows [firstRow, firstRow + count) out as CSV, reading from bufs which start at
+  // bufFirstRow. This only reads the model so it's safe to call from several threads at once, as
+  // long as the model isn't reset in the meantime.
+  void formatCSV(QTextStream &s, uint32_t firstRow, uint32_t count, const QList<BufferData *> &bufs,
+                 uint32_t bufFirstRow) const
+  {
+    QVariantList list;
+
+    for(uint32_t row = firstRow; row < firstRow + count; row++)
+    {
+      s << row;
+
+      uint32_t idx = row;
+      bool restart = false, invalid = false;
+
+      if(indices && indices->data)
+      {
+        idx = CalcIndex(indices, row, baseVertex);
+        restart = primRestart && idx == primRestart;
+        invalid = !restart && idx == ~0U;
+      }
+
+      if(meshView)
+      {
+        s << ", ";
+
+        // if we have separate displayIndices, fetch that for display instead
+        if(restart)
+          s << "--";
+        else if(!invalid)
+          s << (displayIndices && displayIndices->data ? CalcIndex(displayIndices, row, baseVertex)
+                                                       : idx);
+      }
+
+      // each element covers several columns, but we only want to decode it once
+      int prevEl = -1;
+
+      for(int col = reservedColumnCount(); col < m_ColumnCount; col++)
+      {
+        s << ", ";
+
+        if(restart)
+        {
+          s << " Restart";
+          continue;
         }
+
+        int elIdx = columnLookup[col - reservedColumnCount()];
+        const FormatElement &el = columns[elIdx];
+
+        if(invalid || el.buffer >= bufs.size())
+          continue;
+
+        if(elIdx != prevEl)
+        {
+          const BufferData *buf = bufs[el.buffer];
+          list = el.GetVariants(elementData(el, buf, idx - bufFirstRow), buf->end);
+          prevEl = elIdx;
+        }
+
+        int comp = componentForIndex(col);
+
+        if(comp < list.count())
+          s << formatVariant(list[comp], el.hex);
       }
+
+      s << "\n";
     }
+  }
 
-    return QVariant();
+  // swap in a newly fetched window of rows, taking ownership of the data
+  void setWindow(BufferData *buf, uint32_t firstRow)
+  {
+    if(buffers.isEmpty())
+      buffers.push_back(buf);
+    else
+    {
+      buffers[0]->deref();
+      buffers[0] = buf;
+    }
+
+    windowFirstRow = firstRow;
+    windowRowCount = uint32_t((buf->end - buf->data) / qMax((size_t)1, buf->stride));
+
+    if(numRows > 0)
+      emit dataChanged(index(0, 0), index(rowCount() - 1, columnCount() - 1));
   }
 
   RDTableView *view = NULL;
@@ -614,6 +663,14 @@ public:
   QList<BufferData *> buffers;
   uint32_t primRestart = 0;
 
+  // raw buffers can be too large to fetch in one go, so only a window of rows is kept around what's
+  // been displayed. buffers[0] then starts at windowFirstRow, and rows outside it are requested
+  // through fetchWindow and drawn once setWindow() is called with their data.
+  bool windowed = false;
+  uint32_t windowFirstRow = 0;
+  uint32_t windowRowCount = 0;
+  std::function<void(uint32_t)> fetchWindow;
+
   void setPosColumn(int pos)
   {
     QVector<int> roles = {Qt::BackgroundRole, Qt::ForegroundRole};
@@ -699,6 +756,74 @@ private:
   bool secondaryElAlpha = false;
   bool secondaryEnabled = false;
 
+  const byte *elementData(const FormatElement &el, const BufferData *buf, uint32_t row) const
+  {
+    uint32_t instIdx = 0;
+    if(el.instancerate > 0)
+      instIdx = curInstance / el.instancerate;
+
+    const byte *data = buf->data;
+
+    if(!el.perinstance)
+      data += buf->stride * row;
+    else
+      data += buf->stride * instIdx;
+
+    return data + el.offset;
+  }
+
+  static QString formatVariant(const QVariant &v, bool hex)
+  {
+    QString ret;
+
+    QMetaType::Type vt = (QMetaType::Type)v.type();
+
+    if(vt == QMetaType::Double)
+    {
+      double d = v.toDouble();
+      // pad with space on left if sign is missing, to better align
+      if(d < 0.0)
+        ret = Formatter::Format(d);
+      else if(d > 0.0)
+        ret = lit(" ") + Formatter::Format(d);
+      else if(qIsNaN(d))
+        ret = lit(" NaN");
+      else
+        // force negative and positive 0 together
+        ret = lit(" ") + Formatter::Format(0.0);
+    }
+    else if(vt == QMetaType::Float)
+    {
+      float f = v.toFloat();
+      // pad with space on left if sign is missing, to better align
+      if(f < 0.0)
+        ret = Formatter::Format(f);
+      else if(f > 0.0)
+        ret = lit(" ") + Formatter::Format(f);
+      else if(qIsNaN(f))
+        ret = lit(" NaN");
+      else
+        // force negative and positive 0 together
+        ret = lit(" ") + Formatter::Format(0.0);
+    }
+    else if(vt == QMetaType::UInt || vt == QMetaType::UShort || vt == QMetaType::UChar)
+    {
+      ret = Formatter::Format(v.toUInt(), hex);
+    }
+    else if(vt == QMetaType::Int || vt == QMetaType::Short || vt == QMetaType::SChar)
+    {
+      int i = v.toInt();
+      if(i > 0)
+        ret = lit(" ") + Formatter::Format(i);
+      else
+        ret = Formatter::Format(i);
+    }
+    else
+      ret = v.toString();
+
+    return ret;
+  }
+
   int reservedColumnCount() const { return (meshView ? 2 : 1); }
   int componentForIndex(int col) const { return componentLookup[col - reservedColumnCount()]; }
   int firstColumnForElement(int el) const
@@ -822,12 +947,53 @@ void CacheDataForIteration(QVector<CachedElData> &cache, const QList<FormatEleme
   }
 }
 
+// go row by row, finding the start of the row and dumping out the elements using their offset
+// and sizes
+QByteArray ExportRawRows(const BufferItemModel *model, const QVector<CachedElData> &cache,
+                         uint32_t firstRow, uint32_t count)
+{
+  QByteArray ret;
+
+  for(uint32_t row = firstRow; row < firstRow + count; row++)
+  {
+    uint32_t idx = row;
+
+    if(model->indices && model->indices->data)
+      idx = CalcIndex(model->indices, row, model->baseVertex);
+
+    for(const CachedElData &d : cache)
+    {
+      const FormatElement *el = d.el;
+
+      if(d.data && idx != ~0U)
+      {
+        const char *bytes = (const char *)d.data;
+
+        if(!el->perinstance)
+          bytes += d.stride * idx;
+
+        if(bytes + d.byteSize <= (const char *)d.end)
+        {
+          ret.append(bytes, d.byteSize);
+          continue;
+        }
+      }
+
+      // if we didn't continue above, something was wrong, so write nulls
+      ret.append(d.nulls);
+    }
+  }
+
+  return ret;
+}
+
 BufferViewer::BufferViewer(ICaptureContext &ctx, bool meshview, QWidget *parent)
     : QFrame(parent), ui(new Ui::BufferViewer), m_Ctx(ctx)
 {
   ui->setupUi(this);
 
   m_ModelVSIn = new BufferItemModel(ui->vsinData, this);
+  m_ModelVSIn->fetchWindow = [this](uint32_t row) { fetchRawWindow(row); };
   m_ModelVSOut = new BufferItemModel(ui->vsoutData, this);
   m_ModelGSOut = new BufferItemModel(ui->gsoutData, this);
 
@@ -1271,6 +1437,10 @@ void BufferViewer::OnEventChanged(uint32_t eventID)
       guessSecondaryColumn(m_ModelGSOut);
   }
 
+  // any windows of raw data still being fetched are for the old data
+  m_WindowGeneration++;
+  m_WindowPending = false;
+
   m_Ctx.Replay().AsyncInvoke([this, vsinHoriz, vsoutHoriz, gsoutHoriz](IReplayController *r) {
 
     if(m_MeshView)
@@ -1279,36 +1449,60 @@ void BufferViewer::OnEventChanged(uint32_t eventID)
     }
     else
     {
-      BufferData *buf = new BufferData;
-      rdctype::array<byte> data;
-      if(m_IsBuffer)
+      for(auto vb : m_ModelVSIn->buffers)
+        vb->deref();
+      m_ModelVSIn->buffers.clear();
+
+      // calculate tight stride
+      size_t stride = 0;
+      for(const FormatElement &el : m_ModelVSIn->columns)
+        stride += el.byteSize();
+
+      stride = qMax((size_t)1, stride);
+
+      uint64_t rawLength = m_IsBuffer ? RawBufferLength() : 0;
+
+      m_ModelVSIn->windowed = rawLength > RawWindowThreshold;
+
+      if(m_ModelVSIn->windowed)
       {
-        uint64_t len = m_ByteSize;
-        if(len == UINT64_MAX)
-          len = 0;
+        // only fetch the first window now, the rest is fetched as it's scrolled into view
+        BufferData *buf = RT_FetchRawWindow(r, 0, stride);
 
-        data = r->GetBufferData(m_BufferID, m_ByteOffset, len);
+        m_ModelVSIn->numRows = uint32_t((rawLength + stride - 1) / stride);
+        m_ModelVSIn->windowFirstRow = 0;
+        m_ModelVSIn->windowRowCount = uint32_t((buf->end - buf->data) / stride);
+
+        // ownership passes to model
+        m_ModelVSIn->buffers.push_back(buf);
       }
       else
       {
-        data = r->GetTextureData(m_BufferID, m_TexArrayIdx, m_TexMip);
-      }
-
-      buf->data = new byte[data.count];
-      memcpy(buf->data, data.elems, data.count);
-      buf->end = buf->data + data.count;
+        BufferData *buf = new BufferData;
+        rdctype::array<byte> data;
+        if(m_IsBuffer)
+        {
+          uint64_t len = m_ByteSize;
+          if(len == UINT64_MAX)
+            len = 0;
 
-      // calculate tight stride
-      buf->stride = 0;
-      for(const FormatElement &el : m_ModelVSIn->columns)
-        buf->stride += el.byteSize();
+          data = r->GetBufferData(m_BufferID, m_ByteOffset, len);
+        }
+        else
+        {
+          data = r->GetTextureData(m_BufferID, m_TexArrayIdx, m_TexMip);
+        }
 
-      buf->stride = qMax((size_t)1, buf->stride);
+        buf->data = new byte[data.count];
+        memcpy(buf->data, data.elems, data.count);
+        buf->end = buf->data + data.count;
+        buf->stride = stride;
 
-      m_ModelVSIn->numRows = uint32_t((data.count + buf->stride - 1) / buf->stride);
+        m_ModelVSIn->numRows = uint32_t((data.count + buf->stride - 1) / buf->stride);
 
-      // ownership passes to model
-      m_ModelVSIn->buffers.push_back(buf);
+        // ownership passes to model
+        m_ModelVSIn->buffers.push_back(buf);
+      }
     }
 
     updatePreviewColumns();
@@ -1339,6 +1533,87 @@ void BufferViewer::OnEventChanged(uint32_t eventID)
   });
 }
 
+uint64_t BufferViewer::RawBufferLength()
+{
+  BufferDescription *buf = m_Ctx.GetBuffer(m_BufferID);
+
+  if(!buf || m_ByteOffset >= buf->length)
+    return 0;
+
+  return qMin(buf->length - m_ByteOffset, m_ByteSize);
+}
+
+uint32_t BufferViewer::RawWindowRows(size_t stride)
+{
+  return (uint32_t)qBound((size_t)256, RawWindowBytes / stride, (size_t)65536);
+}
+
+BufferData *BufferViewer::RT_FetchRawWindow(IReplayController *r, uint32_t firstRow, size_t stride)
+{
+  uint64_t length = RawBufferLength();
+  uint64_t offset = uint64_t(firstRow) * stride;
+
+  BufferData *buf = new BufferData;
+  buf->stride = stride;
+
+  if(offset < length)
+  {
+    uint64_t len = qMin(length - offset, uint64_t(RawWindowRows(stride)) * stride);
+
+    rdctype::array<byte> data = r->GetBufferData(m_BufferID, m_ByteOffset + offset, len);
+
+    buf->data = new byte[data.count];
+    memcpy(buf->data, data.elems, data.count);
+    buf->end = buf->data + data.count;
+  }
+
+  return buf;
+}
+
+void BufferViewer::fetchRawWindow(uint32_t row)
+{
+  if(m_ModelVSIn->buffers.isEmpty())
+    return;
+
+  size_t stride = m_ModelVSIn->buffers[0]->stride;
+  uint32_t windowRows = RawWindowRows(stride);
+
+  // a request already in flight will cover this row
+  if(m_WindowPending && row >= m_WindowPendingFirst && row - m_WindowPendingFirst < windowRows)
+    return;
+
+  // prefetch a quarter of the window above the row, and the rest below since that's the usual
+  // scrolling direction
+  uint32_t firstRow = row > windowRows / 4 ? row - windowRows / 4 : 0;
+
+  m_WindowPending = true;
+  m_WindowPendingFirst = firstRow;
+
+  uint32_t generation = m_WindowGeneration;
+
+  // tagged per viewer, so that scrolling quickly only fetches the most recent window
+  QString tag = QFormatStr("BufferWindow%1").arg((quintptr)this);
+
+  m_Ctx.Replay().AsyncInvoke(tag, InvokePriority::Interactive,
+                             [this, firstRow, stride, generation](IReplayController *r) {
+    BufferData *buf = RT_FetchRawWindow(r, firstRow, stride);
+
+    GUIInvoke::call([this, buf, firstRow, generation]() {
+      // the data was reset while this was being fetched
+      if(generation != m_WindowGeneration || !m_ModelVSIn->windowed)
+      {
+        buf->deref();
+        return;
+      }
+
+      if(firstRow == m_WindowPendingFirst)
+        m_WindowPending = false;
+
+      m_ModelVSIn->setWindow(buf, firstRow);
+    });
+  });
+}
+
 void BufferViewer::RT_FetchMeshData(IReplayController *r)
 {
   const DrawcallDescription *draw = m_Ctx.CurDrawcall();
@@ -2263,7 +2538,8 @@ void BufferViewer::render_clicked(QMouseEvent *e)
 
   if((e->buttons() & Qt::RightButton) && m_Output)
   {
-    m_Ctx.Replay().AsyncInvoke(lit("PickVertex"), [this, curpos](IReplayController *r) {
+    m_Ctx.Replay().AsyncInvoke(lit("PickVertex"), InvokePriority::Interactive,
+                               [this, curpos](IReplayController *r) {
       uint32_t instanceSelected = 0;
       uint32_t vertSelected = 0;
 
@@ -2360,7 +2636,14 @@ void BufferViewer::render_keyRelease(QKeyEvent *e)
 void BufferViewer::render_timer()
 {
   if(m_CurrentCamera && m_CurrentCamera->Update(ui->render->rect()))
+  {
+    m_SettledTicks = 0;
     INVOKE_MEMFN(RT_UpdateAndDisplay);
+  }
+  else if(m_MeshReduced && ++m_SettledTicks == MeshRefineDelayTicks)
+  {
+    INVOKE_MEMFN(RT_UpdateAndDisplay);
+  }
 }
 
 void BufferViewer::RT_UpdateAndDisplay(IReplayController *)
@@ -2370,6 +2653,7 @@ void BufferViewer::RT_UpdateAndDisplay(IReplayController *)
     m_Config.cam = m_CurrentCamera->camera();
     m_Output->SetMeshDisplay(m_Config);
     m_Output->Display();
+    m_MeshReduced = m_Output->IsMeshDisplayReduced();
   }
 }
 
@@ -2487,6 +2771,9 @@ void BufferViewer::ClearModels()
     m->columns.clear();
     m->numRows = 0;
 
+    m->windowed = false;
+    m->windowFirstRow = m->windowRowCount = 0;
+
     m->endReset();
   }
 }
@@ -2692,90 +2979,162 @@ void BufferViewer::exportData(const BufferExport &params)
 
   BufferItemModel *model = (BufferItemModel *)m_CurView->model();
 
-  LambdaThread *exportThread = new LambdaThread([this, params, model, f]() {
-    if(params.format == BufferExport::RawBytes)
+  QAtomicInteger<uint32_t> rowsDone(0);
+  QAtomicInt cancelled(0);
+
+  LambdaThread *exportThread = new LambdaThread([this, params, model, f, &rowsDone, &cancelled]() {
+    if(params.format == BufferExport::CSV)
     {
-      if(!m_MeshView)
+      QTextStream s(f);
+
+      for(int i = 0; i < model->columnCount(); i++)
       {
-        // this is the simplest possible case, we just dump the contents of the first buffer, as
-        // it's tightly packed
-        f->write((const char *)model->buffers[0]->data,
-                 int(model->buffers[0]->end - model->buffers[0]->data));
+        s << model->headerData(i, Qt::Horizontal, Qt::DisplayRole).toString();
+
+        if(i + 1 < model->columnCount())
+          s << ", ";
       }
-      else
-      {
-        // cache column data for the inner loop
-        QVector<CachedElData> cache;
 
+      s << "\n";
+    }
+
+    if(!model->windowed && params.format == BufferExport::RawBytes && !m_MeshView)
+    {
+      // this is the simplest possible case, we just dump the contents of the first buffer, as
+      // it's tightly packed
+      f->write((const char *)model->buffers[0]->data,
+               int(model->buffers[0]->end - model->buffers[0]->data));
+    }
+    else
+    {
+      // everything else is split into chunks of rows which are formatted in parallel and then
+      // written out in order. A windowed model only has part of the data, so there each chunk is
+      // one window that we fetch ourselves.
+      size_t stride = model->buffers.isEmpty() ? 1 : model->buffers[0]->stride;
+      uint32_t chunkRows = model->windowed ? RawWindowRows(stride) : ExportChunkRows;
+      uint32_t numChunks = (model->numRows + chunkRows - 1) / chunkRows;
+
+      int numWorkers = qMax(1, QThread::idealThreadCount());
+
+      // only keep a few chunks per worker in flight at once, so memory use is bounded
+      uint32_t batchSize = uint32_t(numWorkers) * (model->windowed ? 1 : 4);
+
+      QVector<CachedElData> cache;
+
+      if(params.format == BufferExport::RawBytes)
         CacheDataForIteration(cache, model->columns, model->buffers, model->curInstance);
 
-        // go row by row, finding the start of the row and dumping out the elements using their
-        // offset and sizes
-        for(int i = 0; i < model->rowCount(); i++)
+      for(uint32_t batchStart = 0; batchStart < numChunks && !cancelled.load(); batchStart += batchSize)
+      {
+        uint32_t batchCount = qMin(batchSize, numChunks - batchStart);
+
+        QVector<BufferData *> windows;
+
+        if(model->windowed)
         {
-          uint32_t idx = model->data(model->index(i, 1), Qt::DisplayRole).toUInt();
+          for(uint32_t i = 0; i < batchCount; i++)
+          {
+            uint32_t firstRow = (batchStart + i) * chunkRows;
+            BufferData *buf = NULL;
+
+            m_Ctx.Replay().BlockInvoke([this, &buf, firstRow, stride](IReplayController *r) {
+              buf = RT_FetchRawWindow(r, firstRow, stride);
+            });
+
+            if(!buf)
+              break;
+
+            windows.push_back(buf);
+          }
+
+          batchCount = (uint32_t)windows.count();
+
+          // stop after this batch if a fetch failed
+          if(windows.count() < (int)qMin(batchSize, numChunks - batchStart))
+            numChunks = batchStart + batchCount;
+        }
+
+        QVector<QByteArray> output(batchCount);
+        QAtomicInt nextChunk(0);
 
-          for(int col = 0; col < cache.count(); col++)
+        auto work = [&]() {
+          for(;;)
           {
-            const CachedElData &d = cache[col];
-            const FormatElement *el = d.el;
+            uint32_t i = (uint32_t)nextChunk.fetchAndAddRelaxed(1);
 
-            if(d.data)
-            {
-              const char *bytes = (const char *)d.data;
+            if(i >= batchCount || cancelled.load())
+              return;
 
-              if(!el->perinstance)
-                bytes += d.stride * idx;
+            uint32_t firstRow = (batchStart + i) * chunkRows;
+            uint32_t rows = qMin(chunkRows, model->numRows - firstRow);
 
-              if(bytes + d.byteSize <= (const char *)d.end)
-                f->write(bytes, d.byteSize);
+            if(model->windowed && params.format == BufferExport::RawBytes)
+            {
+              output[i] = QByteArray((const char *)windows[i]->data,
+                                     int(windows[i]->end - windows[i]->data));
             }
+            else if(params.format == BufferExport::RawBytes)
+            {
+              output[i] = ExportRawRows(model, cache, firstRow, rows);
+            }
+            else
+            {
+              QTextStream s(&output[i], QIODevice::WriteOnly);
 
-            // if we didn't continue above, something was wrong, so write nulls
-            f->write(d.nulls);
+              if(model->windowed)
+                model->formatCSV(s, firstRow, rows, {windows[i]}, firstRow);
+              else
+                model->formatCSV(s, firstRow, rows, model->buffers, 0);
+            }
+
+            rowsDone.fetchAndAddRelaxed(rows);
           }
-        }
-      }
-    }
-    else if(params.format == BufferExport::CSV)
-    {
-      // this works identically no matter whether we're mesh view or what, we just iterate the
-      // elements and call the model's data()
+        };
 
-      QTextStream s(f);
+        // the export thread works through the batch too, alongside the extra workers
+        int extraWorkers = qMin(numWorkers, (int)batchCount) - 1;
 
-      for(int i = 0; i < model->columnCount(); i++)
-      {
-        s << model->headerData(i, Qt::Horizontal, Qt::DisplayRole).toString();
+        QSemaphore workersDone(0);
 
-        if(i + 1 < model->columnCount())
-          s << ", ";
-      }
+        for(int w = 0; w < extraWorkers; w++)
+        {
+          LambdaThread *worker = new LambdaThread([&work, &workersDone]() {
+            work();
+            workersDone.release();
+          });
+          worker->selfDelete(true);
+          worker->start();
+        }
 
-      s << "\n";
+        work();
 
-      for(int row = 0; row < model->rowCount(); row++)
-      {
-        for(int col = 0; col < model->columnCount(); col++)
-        {
-          s << model->data(model->index(row, col), Qt::DisplayRole).toString();
+        workersDone.acquire(extraWorkers);
 
-          if(col + 1 < model->columnCount())
-            s << ", ";
-        }
+        for(BufferData *buf : windows)
+          buf->deref();
 
-        s << "\n";
+        for(const QByteArray &out : output)
+          f->write(out);
       }
     }
 
     f->close();
 
+    // don't leave a partial file behind
+    if(cancelled.load())
+      f->remove();
+
     delete f;
   });
   exportThread->start();
 
   ShowProgressDialog(this, tr("Exporting data"),
-                     [exportThread]() { return !exportThread->isRunning(); });
+                     [exportThread]() { return !exportThread->isRunning(); },
+                     [model, &rowsDone]() {
+                       return model->numRows > 0 ? float(rowsDone.load()) / float(model->numRows)
+                                                 : 0.0f;
+                     },
+                     [&cancelled]() { cancelled.store(1); });
 
   exportThread->deleteLater();
 }
@@ -2812,7 +3171,7 @@ void BufferViewer::debugVertex()
         r->DebugVertex(vertid, m_Config.curInstance, index, m_Ctx.CurDrawcall()->instanceOffset,
                        m_Ctx.CurDrawcall()->vertexOffset);
 
-    if(trace->states.count == 0)
+    if(trace->steps.count == 0)
     {
       r->FreeTrace(trace);
 
@@ -122,6 +122,12 @@ private:
 
   IReplayOutput *m_Output;
 
+  // set when the last display only drew part of the meshes while the camera was moving. Once the
+  // camera has been still for a few ticks of the render timer, the meshes are drawn in full.
+  bool m_MeshReduced = false;
+  int m_SettledTicks = 0;
+  static const int MeshRefineDelayTicks = 10;
+
   void RT_UpdateAndDisplay(IReplayController *);
   void RT_FetchMeshData(IReplayController *r);
 
@@ -180,6 +186,23 @@ private:
   uint64_t m_ByteSize = UINT64_MAX;
   ResourceId m_BufferID;
 
+  // raw buffers larger than this are fetched in windows of roughly RawWindowBytes as they're
+  // scrolled through, instead of all at once
+  static const uint64_t RawWindowThreshold = 16 * 1024 * 1024;
+  static const size_t RawWindowBytes = 1024 * 1024;
+
+  // rows per chunk when exporting, each chunk is formatted on its own worker
+  static const uint32_t ExportChunkRows = 4096;
+
+  uint32_t m_WindowGeneration = 0;
+  bool m_WindowPending = false;
+  uint32_t m_WindowPendingFirst = 0;
+
+  uint64_t RawBufferLength();
+  uint32_t RawWindowRows(size_t stride);
+  BufferData *RT_FetchRawWindow(IReplayController *r, uint32_t firstRow, size_t stride);
+  void fetchRawWindow(uint32_t row);
+
   CameraWrapper *m_CurrentCamera = NULL;
   ArcballWrapper *m_Arcball = NULL;
   FlycamWrapper *m_Flycam = NULL;
@@ -1063,6 +1063,30 @@ void LiveCapture::connectionThreadEntry()
         }
       }
     }
+
+    if(msg.Type == TargetControlMessageType::Telemetry)
+    {
+      TargetTelemetry t = msg.Telemetry;
+
+      GUIInvoke::call([this, t]() {
+        ui->telemetryGraph->addSample(t.frameTimeAvg, t.frameTimeMax, t.apiMilliseconds);
+
+        QString text = tr("Frame %1 / %2 / %3 ms (min/avg/max)")
+                           .arg(t.frameTimeMin, 0, 'f', 2)
+                           .arg(t.frameTimeAvg, 0, 'f', 2)
+                           .arg(t.frameTimeMax, 0, 'f', 2);
+
+        if(t.apiMilliseconds > 0.0)
+          text += tr(", %1 ms in API wrappers").arg(t.apiMilliseconds, 0, 'f', 2);
+
+        text += tr("\n%1 chunks in %2 MB, %3 MB of buffers")
+                    .arg(t.liveChunks)
+                    .arg(double(t.chunkBytes) / (1024.0 * 1024.0), 0, 'f', 1)
+                    .arg(double(t.bufferBytes) / (1024.0 * 1024.0), 0, 'f', 1);
+
+        ui->telemetryLabel->setText(text);
+      });
+    }
   }
 
   GUIInvoke::call([this]() {
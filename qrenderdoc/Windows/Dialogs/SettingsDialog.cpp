@@ -80,6 +80,8 @@ SettingsDialog::SettingsDialog(ICaptureContext &ctx, QWidget *parent)
   ui->EventBrowser_HideAPICalls->setChecked(m_Ctx.Config().EventBrowser_HideAPICalls);
   ui->EventBrowser_ApplyColors->setChecked(m_Ctx.Config().EventBrowser_ApplyColors);
   ui->EventBrowser_ColorEventRow->setChecked(m_Ctx.Config().EventBrowser_ColorEventRow);
+  ui->EventBrowser_TimingIterations->setValue(m_Ctx.Config().EventBrowser_TimingIterations);
+  ui->EventBrowser_PrefetchDrawcalls->setValue(m_Ctx.Config().EventBrowser_PrefetchDrawcalls);
 
   // disable sub-checkbox
   ui->EventBrowser_ColorEventRow->setEnabled(ui->EventBrowser_ApplyColors->isChecked());
@@ -328,6 +330,20 @@ void SettingsDialog::on_EventBrowser_ColorEventRow_toggled(bool checked)
   m_Ctx.Config().Save();
 }
 
+void SettingsDialog::on_EventBrowser_TimingIterations_valueChanged(int value)
+{
+  m_Ctx.Config().EventBrowser_TimingIterations = ui->EventBrowser_TimingIterations->value();
+
+  m_Ctx.Config().Save();
+}
+
+void SettingsDialog::on_EventBrowser_PrefetchDrawcalls_valueChanged(int value)
+{
+  m_Ctx.Config().EventBrowser_PrefetchDrawcalls = ui->EventBrowser_PrefetchDrawcalls->value();
+
+  m_Ctx.Config().Save();
+}
+
 // android
 void SettingsDialog::on_browseTempCaptureDirectory_clicked()
 {
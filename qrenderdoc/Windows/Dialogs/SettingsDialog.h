@@ -80,6 +80,8 @@ private slots:
   void on_EventBrowser_HideAPICalls_toggled(bool checked);
   void on_EventBrowser_ApplyColors_toggled(bool checked);
   void on_EventBrowser_ColorEventRow_toggled(bool checked);
+  void on_EventBrowser_TimingIterations_valueChanged(int value);
+  void on_EventBrowser_PrefetchDrawcalls_valueChanged(int value);
 
   // android
   void on_browseTempCaptureDirectory_clicked();
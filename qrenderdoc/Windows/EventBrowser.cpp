@@ -23,6 +23,8 @@
  ******************************************************************************/
 
 #include "EventBrowser.h"
+#include <algorithm>
+#include <QHash>
 #include <QKeyEvent>
 #include <QMenu>
 #include <QShortcut>
@@ -55,6 +57,87 @@ enum
   COL_DURATION = 2,
 };
 
+// an index over the node names for find-as-you-type, so a search doesn't have to walk the whole
+// tree. Nodes are numbered in the tree's pre-order, and each trigram of a (lower-cased) name maps to
+// the sorted list of nodes containing it. A query only needs to check the nodes that contain its
+// rarest trigram.
+//
+// The names are filled in on the UI thread, then build() and query() can run on any thread.
+class EventSearchIndex
+{
+public:
+  void addName(const QString &name) { m_Names.push_back(name.toLower()); }
+  void build()
+  {
+    for(int i = 0; i < m_Names.count(); i++)
+    {
+      const QString &name = m_Names[i];
+
+      for(int c = 0; c + 3 <= name.length(); c++)
+      {
+        QVector<int> &nodes = m_Trigrams[trigram(name.constData() + c)];
+
+        // names are visited in order, so this keeps each list sorted and unique
+        if(nodes.isEmpty() || nodes.back() != i)
+          nodes.push_back(i);
+      }
+    }
+
+    m_Built.storeRelease(1);
+  }
+
+  // returns the matching nodes in pre-order
+  QVector<int> query(const QString &filter) const
+  {
+    QString f = filter.toLower();
+
+    QVector<int> ret;
+
+    if(f.isEmpty())
+      return ret;
+
+    // short filters have no trigrams to look up, and until the index is built we check everything
+    if(f.length() < 3 || !m_Built.loadAcquire())
+    {
+      for(int i = 0; i < m_Names.count(); i++)
+        if(m_Names[i].contains(f))
+          ret.push_back(i);
+
+      return ret;
+    }
+
+    const QVector<int> *candidates = NULL;
+
+    for(int c = 0; c + 3 <= f.length(); c++)
+    {
+      auto it = m_Trigrams.find(trigram(f.constData() + c));
+
+      // if any trigram is missing nothing can match
+      if(it == m_Trigrams.end())
+        return ret;
+
+      if(candidates == NULL || it->count() < candidates->count())
+        candidates = &it.value();
+    }
+
+    for(int i : *candidates)
+      if(m_Names[i].contains(f))
+        ret.push_back(i);
+
+    return ret;
+  }
+
+private:
+  static quint64 trigram(const QChar *c)
+  {
+    return (quint64(c[0].unicode()) << 32) | (quint64(c[1].unicode()) << 16) | c[2].unicode();
+  }
+
+  QVector<QString> m_Names;
+  QHash<quint64, QVector<int>> m_Trigrams;
+  QAtomicInt m_Built;
+};
+
 EventBrowser::EventBrowser(ICaptureContext &ctx, QWidget *parent)
     : QFrame(parent), ui(new Ui::EventBrowser), m_Ctx(ctx)
 {
@@ -91,16 +174,21 @@ EventBrowser::EventBrowser(ICaptureContext &ctx, QWidget *parent)
   UpdateDurationColumn();
 
   m_FindHighlight = new QTimer(this);
-  m_FindHighlight->setInterval(400);
+  m_FindHighlight->setInterval(150);
   m_FindHighlight->setSingleShot(true);
   connect(m_FindHighlight, &QTimer::timeout, this, &EventBrowser::findHighlight_timeout);
 
   QObject::connect(ui->closeFind, &QToolButton::clicked, this, &EventBrowser::on_HideFindJump);
   QObject::connect(ui->closeJump, &QToolButton::clicked, this, &EventBrowser::on_HideFindJump);
   QObject::connect(ui->events, &RDTreeWidget::keyPress, this, &EventBrowser::events_keyPress);
+  QObject::connect(ui->timeline, &DurationTimeline::eventSelected, this,
+                   &EventBrowser::timeline_eventSelected);
+  QObject::connect(ui->timeline, &DurationTimeline::resolutionChanged, this,
+                   &EventBrowser::UpdateTimeline);
   ui->jumpStrip->hide();
   ui->findStrip->hide();
   ui->bookmarkStrip->hide();
+  ui->timeline->hide();
 
   m_BookmarkStripLayout = new FlowLayout(ui->bookmarkStrip, 0, 3, 3);
   m_BookmarkSpacer = new QSpacerItem(40, 20, QSizePolicy::Expanding, QSizePolicy::Minimum);
@@ -156,13 +244,32 @@ void EventBrowser::OnLogfileLoaded()
 
   frame->addChild(framestart);
 
-  uint lastEID = AddDrawcalls(frame, m_Ctx.CurDrawcalls());
+  const FlatDrawcallList *flat = m_Ctx.CurFlatDrawcalls();
+
+  uint lastEID = 0;
+
+  if(flat)
+    lastEID = AddFlatDrawcalls(frame, *flat, flat->Count() > 0 ? 0 : -1);
+  else
+    lastEID = AddDrawcalls(frame, m_Ctx.CurDrawcalls());
   frame->setTag(QVariant::fromValue(EventItemTag(0, lastEID)));
 
   ui->events->addTopLevelItem(frame);
 
   ui->events->expandItem(frame);
 
+  // the index is filled in here but built in the background, searches before it's ready still work
+  // but check every name.
+  QSharedPointer<EventSearchIndex> index(new EventSearchIndex);
+  m_SearchItems.clear();
+  m_SearchEIDs.clear();
+  AddSearchItems(*index, frame);
+  m_SearchIndex = index;
+
+  LambdaThread *thread = new LambdaThread([index]() { index->build(); });
+  thread->selfDelete(true);
+  thread->start();
+
   ui->find->setEnabled(true);
   ui->gotoEID->setEnabled(true);
   ui->timeDraws->setEnabled(true);
@@ -178,8 +285,19 @@ void EventBrowser::OnLogfileClosed()
 {
   clearBookmarks();
 
+  m_SearchIndex.reset();
+  m_SearchItems.clear();
+  m_SearchEIDs.clear();
+  m_FindResults.clear();
+  m_FindGeneration++;
+
   ui->events->clear();
 
+  m_Times.clear();
+  m_TimeStats.clear();
+  ui->timeline->clearRegions();
+  ui->timeline->hide();
+
   ui->find->setEnabled(false);
   ui->gotoEID->setEnabled(false);
   ui->timeDraws->setEnabled(false);
@@ -193,6 +311,7 @@ void EventBrowser::OnEventChanged(uint32_t eventID)
 {
   SelectEvent(eventID);
   highlightBookmarks();
+  ui->timeline->setCurrentEvent(eventID);
 }
 
 uint EventBrowser::AddDrawcalls(RDTreeWidgetItem *parent,
@@ -222,32 +341,71 @@ uint EventBrowser::AddDrawcalls(RDTreeWidgetItem *parent,
 
     child->setTag(QVariant::fromValue(EventItemTag(draws[i].eventID, lastEID)));
 
-    if(m_Ctx.Config().EventBrowser_ApplyColors)
-    {
-      // if alpha isn't 0, assume the colour is valid
-      if((d.flags & (DrawFlags::PushMarker | DrawFlags::SetMarker)) && d.markerColor[3] > 0.0f)
-      {
-        QColor col = QColor::fromRgb(
-            qRgb(d.markerColor[0] * 255.0f, d.markerColor[1] * 255.0f, d.markerColor[2] * 255.0f));
+    ApplyMarkerColor(child, d.flags, d.markerColor);
 
-        child->setTreeColor(col, 3.0f);
+    parent->addChild(child);
+  }
 
-        if(m_Ctx.Config().EventBrowser_ColorEventRow)
-        {
-          QColor textCol = ui->events->palette().color(QPalette::Text);
+  return lastEID;
+}
 
-          child->setBackgroundColor(col);
-          child->setForegroundColor(contrastingColor(col, textCol));
-        }
-      }
+uint EventBrowser::AddFlatDrawcalls(RDTreeWidgetItem *parent, const FlatDrawcallList &draws,
+                                    int32_t first)
+{
+  uint lastEID = 0;
+
+  // the EID range is already calculated in the flat list, so we only need to walk the siblings
+  for(int32_t i = first; i >= 0; i = draws.Get(i).nextSibling)
+  {
+    const FlatDrawcall &d = draws.Get(i);
+
+    RDTreeWidgetItem *child = new RDTreeWidgetItem(
+        {QString::fromUtf8(draws.Name(i)), QFormatStr("%1").arg(d.eventID), lit("0.0")});
+
+    if(d.firstChild >= 0)
+    {
+      AddFlatDrawcalls(child, draws, d.firstChild);
+
+      if(d.lastEventID > d.eventID)
+        child->setText(COL_EID, QFormatStr("%1-%2").arg(d.eventID).arg(d.lastEventID));
     }
 
+    lastEID = d.lastEventID;
+
+    child->setTag(QVariant::fromValue(EventItemTag(d.eventID, lastEID)));
+
+    ApplyMarkerColor(child, d.flags, d.markerColor);
+
     parent->addChild(child);
   }
 
   return lastEID;
 }
 
+void EventBrowser::ApplyMarkerColor(RDTreeWidgetItem *child, DrawFlags flags,
+                                    const float *markerColor)
+{
+  if(!m_Ctx.Config().EventBrowser_ApplyColors)
+    return;
+
+  // if alpha isn't 0, assume the colour is valid
+  if((flags & (DrawFlags::PushMarker | DrawFlags::SetMarker)) && markerColor[3] > 0.0f)
+  {
+    QColor col = QColor::fromRgb(
+        qRgb(markerColor[0] * 255.0f, markerColor[1] * 255.0f, markerColor[2] * 255.0f));
+
+    child->setTreeColor(col, 3.0f);
+
+    if(m_Ctx.Config().EventBrowser_ColorEventRow)
+    {
+      QColor textCol = ui->events->palette().color(QPalette::Text);
+
+      child->setBackgroundColor(col);
+      child->setForegroundColor(contrastingColor(col, textCol));
+    }
+  }
+}
+
 void EventBrowser::SetDrawcallTimes(RDTreeWidgetItem *node,
                                     const rdctype::array<CounterResult> &results)
 {
@@ -270,16 +428,33 @@ void EventBrowser::SetDrawcallTimes(RDTreeWidgetItem *node,
         duration = r.value.d;
     }
 
-    double secs = duration;
+    double scale = 1.0;
 
     if(m_TimeUnit == TimeUnit::Milliseconds)
-      secs *= 1000.0;
+      scale = 1000.0;
     else if(m_TimeUnit == TimeUnit::Microseconds)
-      secs *= 1000000.0;
+      scale = 1000000.0;
     else if(m_TimeUnit == TimeUnit::Nanoseconds)
-      secs *= 1000000000.0;
+      scale = 1000000000.0;
+
+    double secs = duration * scale;
 
     node->setText(COL_DURATION, duration < 0.0f ? QString() : QString::number(secs));
+
+    for(const CounterStatistics &st : m_TimeStats)
+    {
+      if(st.eventID == eid)
+      {
+        node->setToolTip(tr("Median %1 %4 over %2 replays\nMinimum %3 %4, standard deviation %5 %4")
+                             .arg(Formatter::Format(st.median * scale))
+                             .arg(st.samples)
+                             .arg(Formatter::Format(st.minimum * scale))
+                             .arg(UnitSuffix(m_TimeUnit))
+                             .arg(Formatter::Format(st.stddev * scale)));
+        break;
+      }
+    }
+
     EventItemTag tag = node->tag().value<EventItemTag>();
     tag.duration = duration;
     node->setTag(QVariant::fromValue(tag));
@@ -336,14 +511,68 @@ void EventBrowser::on_bookmark_clicked()
 
 void EventBrowser::on_timeDraws_clicked()
 {
-  m_Ctx.Replay().AsyncInvoke([this](IReplayController *r) {
+  // timings cover the whole frame so they can wait behind anything interactive. Timing again
+  // while a previous run is still going cancels that run.
+  m_Ctx.Replay().AsyncInvoke(lit("TimeDraws"), InvokePriority::Background,
+                             [this](IReplayController *r) {
+
+    uint32_t iterations = (uint32_t)qMax(1, m_Ctx.Config().EventBrowser_TimingIterations);
 
-    m_Times = r->FetchCounters({GPUCounter::EventGPUDuration});
+    if(iterations > 1)
+    {
+      // take the median over several replays so one-off spikes don't dominate the timings
+      m_TimeStats = r->FetchCounterStatistics({GPUCounter::EventGPUDuration}, iterations);
 
-    GUIInvoke::call([this]() { SetDrawcallTimes(ui->events->topLevelItem(0), m_Times); });
+      m_Times.create(m_TimeStats.count);
+      for(int32_t i = 0; i < m_TimeStats.count; i++)
+        m_Times[i] = CounterResult(m_TimeStats[i].eventID, m_TimeStats[i].counterID,
+                                   m_TimeStats[i].median);
+    }
+    else
+    {
+      m_TimeStats.clear();
+      m_Times = r->FetchCounters({GPUCounter::EventGPUDuration});
+    }
+
+    GUIInvoke::call([this]() {
+      SetDrawcallTimes(ui->events->topLevelItem(0), m_Times);
+      UpdateTimeline();
+    });
+  });
+}
+
+void EventBrowser::UpdateTimeline()
+{
+  if(m_Times.empty())
+    return;
+
+  double total = 0.0;
+  for(const CounterResult &r : m_Times)
+    total += r.value.d;
+
+  // anything narrower than a pixel is merged on the replay side, so the number of regions depends
+  // on the width of the timeline rather than the number of events
+  int width = ui->timeline->isVisible() ? ui->timeline->width() : ui->events->width();
+  double minDuration = total / qMax(1, width);
+
+  rdctype::array<CounterResult> times = m_Times;
+
+  m_Ctx.Replay().AsyncInvoke(lit("Timeline"), [this, times, minDuration](IReplayController *r) {
+    rdctype::array<TimelineRegion> regions = r->GetDurationTimeline(times, minDuration);
+
+    GUIInvoke::call([this, regions]() {
+      ui->timeline->setRegions(regions, m_Ctx.CurFlatDrawcalls());
+      ui->timeline->setCurrentEvent(m_Ctx.CurEvent());
+      ui->timeline->show();
+    });
   });
 }
 
+void EventBrowser::timeline_eventSelected(uint32_t eventID)
+{
+  SelectEvent(eventID);
+}
+
 void EventBrowser::on_events_currentItemChanged(RDTreeWidgetItem *current, RDTreeWidgetItem *previous)
 {
   if(previous)
@@ -392,12 +621,60 @@ void EventBrowser::findHighlight_timeout()
 {
   ClearFindIcons();
 
-  int results = SetFindIcons(ui->findEvent->text());
+  QString filter = ui->findEvent->text();
 
-  if(results > 0)
+  if(filter.isEmpty() || !m_SearchIndex)
+  {
     ui->findEvent->setStyleSheet(QString());
-  else
-    ui->findEvent->setStyleSheet(lit("QLineEdit{background-color:#ff0000;}"));
+    return;
+  }
+
+  uint32_t generation = ++m_FindGeneration;
+
+  ResourceId id;
+  if(ParseResourceQuery(filter, id))
+  {
+    // the events referencing a resource come from the index built on the replay side
+    m_Ctx.Replay().AsyncInvoke([this, id, generation](IReplayController *r) {
+      rdctype::array<uint32_t> eventIDs = r->FindEventsReferencing(id);
+
+      GUIInvoke::call([this, eventIDs, generation]() {
+        if(generation != m_FindGeneration)
+          return;
+
+        QVector<int> results = FindSearchItems(eventIDs);
+
+        SetFindIcons(results);
+
+        if(!results.isEmpty())
+          ui->findEvent->setStyleSheet(QString());
+        else
+          ui->findEvent->setStyleSheet(lit("QLineEdit{background-color:#ff0000;}"));
+      });
+    });
+    return;
+  }
+
+  QSharedPointer<EventSearchIndex> index = m_SearchIndex;
+
+  LambdaThread *thread = new LambdaThread([this, index, filter, generation]() {
+    QVector<int> results = index->query(filter);
+
+    GUIInvoke::call([this, results, generation]() {
+      // drop the results if the text changed or the capture was closed in the meantime
+      if(generation != m_FindGeneration)
+        return;
+
+      SetFindIcons(results);
+
+      if(!results.isEmpty())
+        ui->findEvent->setStyleSheet(QString());
+      else
+        ui->findEvent->setStyleSheet(lit("QLineEdit{background-color:#ff0000;}"));
+    });
+  });
+  thread->selfDelete(true);
+  thread->start();
 }
 
 void EventBrowser::on_findEvent_textEdited(const QString &arg1)
@@ -878,126 +1155,170 @@ bool EventBrowser::SelectEvent(uint32_t eventID)
   return false;
 }
 
-void EventBrowser::ClearFindIcons(RDTreeWidgetItem *parent)
+void EventBrowser::AddSearchItems(EventSearchIndex &index, RDTreeWidgetItem *parent)
 {
   for(int i = 0; i < parent->childCount(); i++)
   {
     RDTreeWidgetItem *n = parent->child(i);
 
-    EventItemTag tag = n->tag().value<EventItemTag>();
-    tag.find = false;
-    n->setTag(QVariant::fromValue(tag));
-    RefreshIcon(n, tag);
+    index.addName(n->text(COL_NAME));
+    m_SearchItems.push_back(n);
+    m_SearchEIDs.push_back(n->tag().value<EventItemTag>().EID);
 
     if(n->childCount() > 0)
-      ClearFindIcons(n);
+      AddSearchItems(index, n);
   }
 }
 
 void EventBrowser::ClearFindIcons()
 {
-  if(m_Ctx.LogLoaded())
-    ClearFindIcons(ui->events->topLevelItem(0));
+  // any search still in flight is now out of date
+  m_FindGeneration++;
+
+  for(int idx : m_FindResults)
+  {
+    RDTreeWidgetItem *n = m_SearchItems[idx];
+
+    EventItemTag tag = n->tag().value<EventItemTag>();
+    tag.find = false;
+    n->setTag(QVariant::fromValue(tag));
+    RefreshIcon(n, tag);
+  }
+
+  m_FindResults.clear();
 }
 
-int EventBrowser::SetFindIcons(RDTreeWidgetItem *parent, QString filter)
+void EventBrowser::SetFindIcons(const QVector<int> &results)
 {
-  int results = 0;
+  m_FindResults = results;
 
-  for(int i = 0; i < parent->childCount(); i++)
+  RDTreeWidgetItem *lastExpanded = NULL;
+
+  for(int idx : results)
   {
-    RDTreeWidgetItem *n = parent->child(i);
+    RDTreeWidgetItem *n = m_SearchItems[idx];
 
-    if(n->text(COL_NAME).contains(filter, Qt::CaseInsensitive))
-    {
-      EventItemTag tag = n->tag().value<EventItemTag>();
-      tag.find = true;
-      n->setTag(QVariant::fromValue(tag));
-      RefreshIcon(n, tag);
-      results++;
-    }
+    EventItemTag tag = n->tag().value<EventItemTag>();
+    tag.find = true;
+    n->setTag(QVariant::fromValue(tag));
+    RefreshIcon(n, tag);
 
-    if(n->childCount() > 0)
+    // expand the path down to each result. Results are in tree order so siblings share a parent
+    // with the previous result, which we've already expanded.
+    RDTreeWidgetItem *parent = n->parent();
+    if(parent != lastExpanded)
     {
-      results += SetFindIcons(n, filter);
+      for(RDTreeWidgetItem *p = parent; p != NULL; p = p->parent())
+        ui->events->expandItem(p);
+
+      lastExpanded = parent;
     }
   }
-
-  return results;
 }
 
-int EventBrowser::SetFindIcons(QString filter)
+// a search of the form "id:<resource>" finds every event that referenced the resource, instead of
+// matching names. The resource can be given by its ID number or by its name.
+bool EventBrowser::ParseResourceQuery(const QString &filter, ResourceId &id)
 {
-  if(filter.isEmpty())
-    return 0;
+  if(!filter.startsWith(lit("id:"), Qt::CaseInsensitive))
+    return false;
 
-  return SetFindIcons(ui->events->topLevelItem(0), filter);
-}
+  QString res = filter.mid(3).trimmed();
 
-RDTreeWidgetItem *EventBrowser::FindNode(RDTreeWidgetItem *parent, QString filter, uint32_t after)
-{
-  for(int i = 0; i < parent->childCount(); i++)
+  bool ok = false;
+  uint64_t num = res.toULongLong(&ok);
+  if(ok)
   {
-    RDTreeWidgetItem *n = parent->child(i);
-
-    uint eid = n->tag().value<EventItemTag>().lastEID;
-
-    if(eid > after && n->text(COL_NAME).contains(filter, Qt::CaseInsensitive))
-      return n;
+    memcpy(&id, &num, sizeof(num));
+    return true;
+  }
 
-    if(n->childCount() > 0)
+  for(const TextureDescription &tex : m_Ctx.GetTextures())
+  {
+    if(res.compare(ToQStr(tex.name), Qt::CaseInsensitive) == 0)
     {
-      RDTreeWidgetItem *found = FindNode(n, filter, after);
+      id = tex.ID;
+      return true;
+    }
+  }
 
-      if(found != NULL)
-        return found;
+  for(const BufferDescription &buf : m_Ctx.GetBuffers())
+  {
+    if(res.compare(ToQStr(buf.name), Qt::CaseInsensitive) == 0)
+    {
+      id = buf.ID;
+      return true;
     }
   }
 
-  return NULL;
+  // an unknown name matches nothing, rather than being searched for as text
+  id = ResourceId();
+  return true;
 }
 
-int EventBrowser::FindEvent(RDTreeWidgetItem *parent, QString filter, uint32_t after, bool forward)
+// maps sorted event IDs to the nodes that contain them. Each event belongs to the first node at or
+// after it, either the drawcall it leads up to or the marker it begins.
+QVector<int> EventBrowser::FindSearchItems(const rdctype::array<uint32_t> &eventIDs)
 {
-  if(parent == NULL)
-    return -1;
+  QVector<int> ret;
 
-  for(int i = forward ? 0 : parent->childCount() - 1; i >= 0 && i < parent->childCount();
-      i += forward ? 1 : -1)
+  for(uint32_t eid : eventIDs)
   {
-    auto n = parent->child(i);
+    int idx = int(std::lower_bound(m_SearchEIDs.begin(), m_SearchEIDs.end(), eid) -
+                  m_SearchEIDs.begin());
+
+    if(idx < m_SearchEIDs.count() && (ret.isEmpty() || ret.back() != idx))
+      ret.push_back(idx);
+  }
+
+  return ret;
+}
 
-    uint eid = n->tag().value<EventItemTag>().lastEID;
+int EventBrowser::FindEvent(QString filter, uint32_t after, bool forward)
+{
+  if(!m_Ctx.LogLoaded() || !m_SearchIndex)
+    return 0;
 
-    bool matchesAfter = (forward && eid > after) || (!forward && eid < after);
+  QVector<int> results;
 
-    if(matchesAfter)
+  ResourceId id;
+  if(ParseResourceQuery(filter, id))
+  {
+    rdctype::array<uint32_t> eventIDs;
+    m_Ctx.Replay().BlockInvoke(
+        [&eventIDs, id](IReplayController *r) { eventIDs = r->FindEventsReferencing(id); });
+
+    results = FindSearchItems(eventIDs);
+  }
+  else
+  {
+    results = m_SearchIndex->query(filter);
+  }
+
+  if(forward)
+  {
+    for(int i = 0; i < results.count(); i++)
     {
-      QString name = n->text(COL_NAME);
-      if(name.contains(filter, Qt::CaseInsensitive))
+      uint eid = m_SearchItems[results[i]]->tag().value<EventItemTag>().lastEID;
+
+      if(eid > after)
         return (int)eid;
     }
-
-    if(n->childCount() > 0)
+  }
+  else
+  {
+    for(int i = results.count() - 1; i >= 0; i--)
     {
-      int found = FindEvent(n, filter, after, forward);
+      uint eid = m_SearchItems[results[i]]->tag().value<EventItemTag>().lastEID;
 
-      if(found > 0)
-        return found;
+      if(eid < after)
+        return (int)eid;
     }
   }
 
   return -1;
 }
 
-int EventBrowser::FindEvent(QString filter, uint32_t after, bool forward)
-{
-  if(!m_Ctx.LogLoaded())
-    return 0;
-
-  return FindEvent(ui->events->topLevelItem(0), filter, after, forward);
-}
-
 void EventBrowser::Find(bool forward)
 {
   if(ui->findEvent->text().isEmpty())
@@ -1038,6 +1359,7 @@ void EventBrowser::UpdateDurationColumn()
   m_TimeUnit = m_Ctx.Config().EventBrowser_TimeUnit;
 
   ui->events->setHeaderText(COL_DURATION, tr("Duration (%1)").arg(UnitSuffix(m_TimeUnit)));
+  ui->timeline->setTimeUnit(m_TimeUnit);
 
   if(!m_Times.empty())
     SetDrawcallTimes(ui->events->topLevelItem(0), m_Times);
@@ -26,6 +26,7 @@
 
 #include <QFrame>
 #include <QIcon>
+#include <QSharedPointer>
 #include "Code/CaptureContext.h"
 
 namespace Ui
@@ -41,6 +42,7 @@ class QTextStream;
 class FlowLayout;
 class SizeDelegate;
 struct EventItemTag;
+class EventSearchIndex;
 
 class EventBrowser : public QFrame, public IEventBrowser, public ILogViewer
 {
@@ -82,6 +84,8 @@ private slots:
   void findHighlight_timeout();
   void events_keyPress(QKeyEvent *event);
   void events_contextMenu(const QPoint &pos);
+  void timeline_eventSelected(uint32_t eventID);
+  void UpdateTimeline();
 
 public slots:
   void clearBookmarks();
@@ -91,6 +95,8 @@ public slots:
 
 private:
   uint AddDrawcalls(RDTreeWidgetItem *parent, const rdctype::array<DrawcallDescription> &draws);
+  uint AddFlatDrawcalls(RDTreeWidgetItem *parent, const FlatDrawcallList &draws, int32_t first);
+  void ApplyMarkerColor(RDTreeWidgetItem *child, DrawFlags flags, const float *markerColor);
   void SetDrawcallTimes(RDTreeWidgetItem *node, const rdctype::array<CounterResult> &results);
 
   void ExpandNode(RDTreeWidgetItem *node);
@@ -98,17 +104,17 @@ private:
   bool FindEventNode(RDTreeWidgetItem *&found, RDTreeWidgetItem *parent, uint32_t eventID);
   bool SelectEvent(uint32_t eventID);
 
-  void ClearFindIcons(RDTreeWidgetItem *parent);
+  void AddSearchItems(EventSearchIndex &index, RDTreeWidgetItem *parent);
+
   void ClearFindIcons();
+  void SetFindIcons(const QVector<int> &results);
 
-  int SetFindIcons(RDTreeWidgetItem *parent, QString filter);
-  int SetFindIcons(QString filter);
+  bool ParseResourceQuery(const QString &filter, ResourceId &id);
+  QVector<int> FindSearchItems(const rdctype::array<uint32_t> &eventIDs);
 
   void highlightBookmarks();
   bool hasBookmark(RDTreeWidgetItem *node);
 
-  RDTreeWidgetItem *FindNode(RDTreeWidgetItem *parent, QString filter, uint32_t after);
-  int FindEvent(RDTreeWidgetItem *parent, QString filter, uint32_t after, bool forward);
   int FindEvent(QString filter, uint32_t after, bool forward);
   void Find(bool forward);
 
@@ -122,10 +128,21 @@ private:
   TimeUnit m_TimeUnit = TimeUnit::Count;
 
   rdctype::array<CounterResult> m_Times;
+  rdctype::array<CounterStatistics> m_TimeStats;
 
   SizeDelegate *m_SizeDelegate;
   QTimer *m_FindHighlight;
 
+  // built once per capture, numbering the nodes in the same order as m_SearchItems
+  QSharedPointer<EventSearchIndex> m_SearchIndex;
+  QVector<RDTreeWidgetItem *> m_SearchItems;
+  // the EID of each node in m_SearchItems, which is non-decreasing in tree order
+  QVector<uint32_t> m_SearchEIDs;
+  // the nodes currently marked as found
+  QVector<int> m_FindResults;
+  // bumped for each search, so that results from a stale search are dropped
+  uint32_t m_FindGeneration = 0;
+
   FlowLayout *m_BookmarkStripLayout;
   QSpacerItem *m_BookmarkSpacer;
   QList<int> m_Bookmarks;
@@ -870,7 +870,7 @@ void D3D11PipelineStateViewer::setShaderState(const D3D11Pipe::Shader &stage, QL
 
   vs = resources->verticalScrollBar()->value();
   resources->setUpdatesEnabled(false);
-  resources->clear();
+  resources->beginRebuild();
   for(int i = 0; i < stage.SRVs.count; i++)
   {
     const ShaderResource *shaderInput = NULL;
@@ -890,12 +890,13 @@ void D3D11PipelineStateViewer::setShaderState(const D3D11Pipe::Shader &stage, QL
     addResourceRow(ViewTag(ViewTag::SRV, i, stage.SRVs[i]), shaderInput, resources);
   }
   resources->clearSelection();
+  resources->endRebuild();
   resources->setUpdatesEnabled(true);
   resources->verticalScrollBar()->setValue(vs);
 
   vs = samplers->verticalScrollBar()->value();
   samplers->setUpdatesEnabled(false);
-  samplers->clear();
+  samplers->beginRebuild();
   for(int i = 0; i < stage.Samplers.count; i++)
   {
     const D3D11Pipe::Sampler &s = stage.Samplers[i];
@@ -992,12 +993,13 @@ void D3D11PipelineStateViewer::setShaderState(const D3D11Pipe::Shader &stage, QL
   }
 
   samplers->clearSelection();
+  samplers->endRebuild();
   samplers->setUpdatesEnabled(true);
   samplers->verticalScrollBar()->setValue(vs);
 
   vs = cbuffers->verticalScrollBar()->value();
   cbuffers->setUpdatesEnabled(false);
-  cbuffers->clear();
+  cbuffers->beginRebuild();
   for(int i = 0; i < stage.ConstantBuffers.count; i++)
   {
     const D3D11Pipe::CBuffer &b = stage.ConstantBuffers[i];
@@ -1076,12 +1078,13 @@ void D3D11PipelineStateViewer::setShaderState(const D3D11Pipe::Shader &stage, QL
     }
   }
   cbuffers->clearSelection();
+  cbuffers->endRebuild();
   cbuffers->setUpdatesEnabled(true);
   cbuffers->verticalScrollBar()->setValue(vs);
 
   vs = classes->verticalScrollBar()->value();
   classes->setUpdatesEnabled(false);
-  classes->clear();
+  classes->beginRebuild();
   for(int i = 0; i < stage.ClassInstances.count; i++)
   {
     QString interfaceName = lit("Interface %1").arg(i);
@@ -1093,6 +1096,7 @@ void D3D11PipelineStateViewer::setShaderState(const D3D11Pipe::Shader &stage, QL
         new RDTreeWidgetItem({i, interfaceName, ToQStr(stage.ClassInstances[i])}));
   }
   classes->clearSelection();
+  classes->endRebuild();
   classes->setUpdatesEnabled(true);
   classes->verticalScrollBar()->setValue(vs);
 
@@ -1218,7 +1222,7 @@ void D3D11PipelineStateViewer::setState()
 
   vs = ui->iaLayouts->verticalScrollBar()->value();
   ui->iaLayouts->setUpdatesEnabled(false);
-  ui->iaLayouts->clear();
+  ui->iaLayouts->beginRebuild();
   {
     int i = 0;
     for(const D3D11Pipe::Layout &l : state.m_IA.layouts)
@@ -1271,6 +1275,7 @@ void D3D11PipelineStateViewer::setState()
     }
   }
   ui->iaLayouts->clearSelection();
+  ui->iaLayouts->endRebuild();
   ui->iaLayouts->setUpdatesEnabled(true);
   ui->iaLayouts->verticalScrollBar()->setValue(vs);
 
@@ -1312,7 +1317,7 @@ void D3D11PipelineStateViewer::setState()
 
   vs = ui->iaBuffers->verticalScrollBar()->value();
   ui->iaBuffers->setUpdatesEnabled(false);
-  ui->iaBuffers->clear();
+  ui->iaBuffers->beginRebuild();
 
   if(state.m_IA.ibuffer.Buffer != ResourceId())
   {
@@ -1416,6 +1421,9 @@ void D3D11PipelineStateViewer::setState()
     }
   }
   ui->iaBuffers->clearSelection();
+  ui->iaBuffers->endRebuild();
+  for(RDTreeWidgetItem *&node : m_VBNodes)
+    node = ui->iaBuffers->rebuiltItem(node);
   ui->iaBuffers->setUpdatesEnabled(true);
   ui->iaBuffers->verticalScrollBar()->setValue(vs);
 
@@ -1434,7 +1442,7 @@ void D3D11PipelineStateViewer::setState()
 
   vs = ui->csUAVs->verticalScrollBar()->value();
   ui->csUAVs->setUpdatesEnabled(false);
-  ui->csUAVs->clear();
+  ui->csUAVs->beginRebuild();
   for(int i = 0; i < state.m_CS.UAVs.count; i++)
   {
     const ShaderResource *shaderInput = NULL;
@@ -1454,13 +1462,14 @@ void D3D11PipelineStateViewer::setState()
     addResourceRow(ViewTag(ViewTag::UAV, i, state.m_CS.UAVs[i]), shaderInput, ui->csUAVs);
   }
   ui->csUAVs->clearSelection();
+  ui->csUAVs->endRebuild();
   ui->csUAVs->setUpdatesEnabled(true);
   ui->csUAVs->verticalScrollBar()->setValue(vs);
 
   bool streamoutSet = false;
   vs = ui->gsStreamOut->verticalScrollBar()->value();
   ui->gsStreamOut->setUpdatesEnabled(false);
-  ui->gsStreamOut->clear();
+  ui->gsStreamOut->beginRebuild();
   for(int i = 0; i < state.m_SO.Outputs.count; i++)
   {
     const D3D11Pipe::SOBind &s = state.m_SO.Outputs[i];
@@ -1502,6 +1511,7 @@ void D3D11PipelineStateViewer::setState()
   }
   ui->gsStreamOut->verticalScrollBar()->setValue(vs);
   ui->gsStreamOut->clearSelection();
+  ui->gsStreamOut->endRebuild();
   ui->gsStreamOut->setUpdatesEnabled(true);
 
   ui->gsStreamOut->setVisible(streamoutSet);
@@ -1512,7 +1522,7 @@ void D3D11PipelineStateViewer::setState()
 
   vs = ui->viewports->verticalScrollBar()->value();
   ui->viewports->setUpdatesEnabled(false);
-  ui->viewports->clear();
+  ui->viewports->beginRebuild();
   for(int i = 0; i < state.m_RS.Viewports.count; i++)
   {
     const D3D11Pipe::Viewport &v = state.m_RS.Viewports[i];
@@ -1533,11 +1543,12 @@ void D3D11PipelineStateViewer::setState()
   }
   ui->viewports->verticalScrollBar()->setValue(vs);
   ui->viewports->clearSelection();
+  ui->viewports->endRebuild();
   ui->viewports->setUpdatesEnabled(true);
 
   vs = ui->scissors->verticalScrollBar()->value();
   ui->scissors->setUpdatesEnabled(false);
-  ui->scissors->clear();
+  ui->scissors->beginRebuild();
   for(int i = 0; i < state.m_RS.Scissors.count; i++)
   {
     const D3D11Pipe::Scissor &s = state.m_RS.Scissors[i];
@@ -1558,6 +1569,7 @@ void D3D11PipelineStateViewer::setState()
   }
   ui->scissors->clearSelection();
   ui->scissors->verticalScrollBar()->setValue(vs);
+  ui->scissors->endRebuild();
   ui->scissors->setUpdatesEnabled(true);
 
   ui->fillMode->setText(ToQStr(state.m_RS.m_State.fillMode));
@@ -1582,7 +1594,7 @@ void D3D11PipelineStateViewer::setState()
 
   vs = ui->targetOutputs->verticalScrollBar()->value();
   ui->targetOutputs->setUpdatesEnabled(false);
-  ui->targetOutputs->clear();
+  ui->targetOutputs->beginRebuild();
   {
     for(int i = 0; i < state.m_OM.RenderTargets.count; i++)
     {
@@ -1624,12 +1636,13 @@ void D3D11PipelineStateViewer::setState()
     addResourceRow(ViewTag(ViewTag::OMDepth, 0, state.m_OM.DepthTarget), NULL, ui->targetOutputs);
   }
   ui->targetOutputs->clearSelection();
+  ui->targetOutputs->endRebuild();
   ui->targetOutputs->setUpdatesEnabled(true);
   ui->targetOutputs->verticalScrollBar()->setValue(vs);
 
   vs = ui->blends->verticalScrollBar()->value();
   ui->blends->setUpdatesEnabled(false);
-  ui->blends->clear();
+  ui->blends->beginRebuild();
   {
     int i = 0;
     for(const D3D11Pipe::Blend &blend : state.m_OM.m_BlendState.Blends)
@@ -1672,6 +1685,7 @@ void D3D11PipelineStateViewer::setState()
     }
   }
   ui->blends->clearSelection();
+  ui->blends->endRebuild();
   ui->blends->setUpdatesEnabled(true);
   ui->blends->verticalScrollBar()->setValue(vs);
 
@@ -1699,7 +1713,7 @@ void D3D11PipelineStateViewer::setState()
       QFormatStr("%1").arg(state.m_OM.m_State.StencilRef, 2, 16, QLatin1Char('0')).toUpper());
 
   ui->stencils->setUpdatesEnabled(false);
-  ui->stencils->clear();
+  ui->stencils->beginRebuild();
   ui->stencils->addTopLevelItem(
       new RDTreeWidgetItem({tr("Front"), ToQStr(state.m_OM.m_State.m_FrontFace.Func),
                             ToQStr(state.m_OM.m_State.m_FrontFace.FailOp),
@@ -1710,6 +1724,7 @@ void D3D11PipelineStateViewer::setState()
        ToQStr(state.m_OM.m_State.m_BackFace.FailOp), ToQStr(state.m_OM.m_State.m_BackFace.DepthFailOp),
        ToQStr(state.m_OM.m_State.m_BackFace.PassOp)}));
   ui->stencils->clearSelection();
+  ui->stencils->endRebuild();
   ui->stencils->setUpdatesEnabled(true);
 
   // set up thread debugging inputs
@@ -2350,7 +2365,7 @@ void D3D11PipelineStateViewer::on_debugThread_clicked()
   m_Ctx.Replay().AsyncInvoke([this, thread](IReplayController *r) {
     ShaderDebugTrace *trace = r->DebugThread(thread.g, thread.t);
 
-    if(trace->states.count == 0)
+    if(trace->steps.count == 0)
     {
       r->FreeTrace(trace);
 
@@ -960,7 +960,7 @@ void D3D12PipelineStateViewer::setShaderState(const D3D12Pipe::Shader &stage, QL
 
   vs = resources->verticalScrollBar()->value();
   resources->setUpdatesEnabled(false);
-  resources->clear();
+  resources->beginRebuild();
   for(int space = 0; space < stage.Spaces.count; space++)
   {
     for(int reg = 0; reg < stage.Spaces[space].SRVs.count; reg++)
@@ -970,12 +970,13 @@ void D3D12PipelineStateViewer::setShaderState(const D3D12Pipe::Shader &stage, QL
     }
   }
   resources->clearSelection();
+  resources->endRebuild();
   resources->setUpdatesEnabled(true);
   resources->verticalScrollBar()->setValue(vs);
 
   vs = uavs->verticalScrollBar()->value();
   uavs->setUpdatesEnabled(false);
-  uavs->clear();
+  uavs->beginRebuild();
   for(int space = 0; space < stage.Spaces.count; space++)
   {
     for(int reg = 0; reg < stage.Spaces[space].UAVs.count; reg++)
@@ -984,12 +985,13 @@ void D3D12PipelineStateViewer::setShaderState(const D3D12Pipe::Shader &stage, QL
     }
   }
   uavs->clearSelection();
+  uavs->endRebuild();
   uavs->setUpdatesEnabled(true);
   uavs->verticalScrollBar()->setValue(vs);
 
   vs = samplers->verticalScrollBar()->value();
   samplers->setUpdatesEnabled(false);
-  samplers->clear();
+  samplers->beginRebuild();
   for(int space = 0; space < stage.Spaces.count; space++)
   {
     for(int reg = 0; reg < stage.Spaces[space].Samplers.count; reg++)
@@ -1105,12 +1107,13 @@ void D3D12PipelineStateViewer::setShaderState(const D3D12Pipe::Shader &stage, QL
     }
   }
   samplers->clearSelection();
+  samplers->endRebuild();
   samplers->setUpdatesEnabled(true);
   samplers->verticalScrollBar()->setValue(vs);
 
   vs = cbuffers->verticalScrollBar()->value();
   cbuffers->setUpdatesEnabled(false);
-  cbuffers->clear();
+  cbuffers->beginRebuild();
   for(int space = 0; space < stage.Spaces.count; space++)
   {
     for(int reg = 0; reg < stage.Spaces[space].ConstantBuffers.count; reg++)
@@ -1219,6 +1222,7 @@ void D3D12PipelineStateViewer::setShaderState(const D3D12Pipe::Shader &stage, QL
     }
   }
   cbuffers->clearSelection();
+  cbuffers->endRebuild();
   cbuffers->setUpdatesEnabled(true);
   cbuffers->verticalScrollBar()->setValue(vs);
 }
@@ -1247,7 +1251,7 @@ void D3D12PipelineStateViewer::setState()
 
   vs = ui->iaLayouts->verticalScrollBar()->value();
   ui->iaLayouts->setUpdatesEnabled(false);
-  ui->iaLayouts->clear();
+  ui->iaLayouts->beginRebuild();
   {
     int i = 0;
     for(const D3D12Pipe::Layout &l : state.m_IA.layouts)
@@ -1300,6 +1304,7 @@ void D3D12PipelineStateViewer::setState()
     }
   }
   ui->iaLayouts->clearSelection();
+  ui->iaLayouts->endRebuild();
   ui->iaLayouts->setUpdatesEnabled(true);
   ui->iaLayouts->verticalScrollBar()->setValue(vs);
 
@@ -1341,7 +1346,7 @@ void D3D12PipelineStateViewer::setState()
 
   vs = ui->iaBuffers->verticalScrollBar()->value();
   ui->iaBuffers->setUpdatesEnabled(false);
-  ui->iaBuffers->clear();
+  ui->iaBuffers->beginRebuild();
 
   if(state.m_IA.ibuffer.Buffer != ResourceId())
   {
@@ -1445,6 +1450,9 @@ void D3D12PipelineStateViewer::setState()
     }
   }
   ui->iaBuffers->clearSelection();
+  ui->iaBuffers->endRebuild();
+  for(RDTreeWidgetItem *&node : m_VBNodes)
+    node = ui->iaBuffers->rebuiltItem(node);
   ui->iaBuffers->setUpdatesEnabled(true);
   ui->iaBuffers->verticalScrollBar()->setValue(vs);
 
@@ -1464,7 +1472,7 @@ void D3D12PipelineStateViewer::setState()
   bool streamoutSet = false;
   vs = ui->gsStreamOut->verticalScrollBar()->value();
   ui->gsStreamOut->setUpdatesEnabled(false);
-  ui->gsStreamOut->clear();
+  ui->gsStreamOut->beginRebuild();
   for(int i = 0; i < state.m_SO.Outputs.count; i++)
   {
     const D3D12Pipe::SOBind &s = state.m_SO.Outputs[i];
@@ -1507,6 +1515,7 @@ void D3D12PipelineStateViewer::setState()
   }
   ui->gsStreamOut->verticalScrollBar()->setValue(vs);
   ui->gsStreamOut->clearSelection();
+  ui->gsStreamOut->endRebuild();
   ui->gsStreamOut->setUpdatesEnabled(true);
 
   ui->gsStreamOut->setVisible(streamoutSet);
@@ -1517,7 +1526,7 @@ void D3D12PipelineStateViewer::setState()
 
   vs = ui->viewports->verticalScrollBar()->value();
   ui->viewports->setUpdatesEnabled(false);
-  ui->viewports->clear();
+  ui->viewports->beginRebuild();
   for(int i = 0; i < state.m_RS.Viewports.count; i++)
   {
     const D3D12Pipe::Viewport &v = state.m_RS.Viewports[i];
@@ -1532,11 +1541,12 @@ void D3D12PipelineStateViewer::setState()
   }
   ui->viewports->verticalScrollBar()->setValue(vs);
   ui->viewports->clearSelection();
+  ui->viewports->endRebuild();
   ui->viewports->setUpdatesEnabled(true);
 
   vs = ui->scissors->verticalScrollBar()->value();
   ui->scissors->setUpdatesEnabled(false);
-  ui->scissors->clear();
+  ui->scissors->beginRebuild();
   for(int i = 0; i < state.m_RS.Scissors.count; i++)
   {
     const D3D12Pipe::Scissor &s = state.m_RS.Scissors[i];
@@ -1551,6 +1561,7 @@ void D3D12PipelineStateViewer::setState()
   }
   ui->scissors->clearSelection();
   ui->scissors->verticalScrollBar()->setValue(vs);
+  ui->scissors->endRebuild();
   ui->scissors->setUpdatesEnabled(true);
 
   ui->fillMode->setText(ToQStr(state.m_RS.m_State.fillMode));
@@ -1574,7 +1585,7 @@ void D3D12PipelineStateViewer::setState()
 
   vs = ui->targetOutputs->verticalScrollBar()->value();
   ui->targetOutputs->setUpdatesEnabled(false);
-  ui->targetOutputs->clear();
+  ui->targetOutputs->beginRebuild();
   {
     for(int i = 0; i < state.m_OM.RenderTargets.count; i++)
     {
@@ -1588,12 +1599,13 @@ void D3D12PipelineStateViewer::setState()
     addResourceRow(ViewTag(ViewTag::OMDepth, 0, 0, state.m_OM.DepthTarget), NULL, ui->targetOutputs);
   }
   ui->targetOutputs->clearSelection();
+  ui->targetOutputs->endRebuild();
   ui->targetOutputs->setUpdatesEnabled(true);
   ui->targetOutputs->verticalScrollBar()->setValue(vs);
 
   vs = ui->blends->verticalScrollBar()->value();
   ui->blends->setUpdatesEnabled(false);
-  ui->blends->clear();
+  ui->blends->beginRebuild();
   {
     int i = 0;
     for(const D3D12Pipe::Blend &blend : state.m_OM.m_BlendState.Blends)
@@ -1636,6 +1648,7 @@ void D3D12PipelineStateViewer::setState()
     }
   }
   ui->blends->clearSelection();
+  ui->blends->endRebuild();
   ui->blends->setUpdatesEnabled(true);
   ui->blends->verticalScrollBar()->setValue(vs);
 
@@ -1661,7 +1674,7 @@ void D3D12PipelineStateViewer::setState()
       QFormatStr("%1").arg(state.m_OM.m_State.StencilRef, 2, 16, QLatin1Char('0')).toUpper());
 
   ui->stencils->setUpdatesEnabled(false);
-  ui->stencils->clear();
+  ui->stencils->beginRebuild();
   ui->stencils->addTopLevelItem(
       new RDTreeWidgetItem({tr("Front"), ToQStr(state.m_OM.m_State.m_FrontFace.Func),
                             ToQStr(state.m_OM.m_State.m_FrontFace.FailOp),
@@ -1672,6 +1685,7 @@ void D3D12PipelineStateViewer::setState()
        ToQStr(state.m_OM.m_State.m_BackFace.FailOp), ToQStr(state.m_OM.m_State.m_BackFace.DepthFailOp),
        ToQStr(state.m_OM.m_State.m_BackFace.PassOp)}));
   ui->stencils->clearSelection();
+  ui->stencils->endRebuild();
   ui->stencils->setUpdatesEnabled(true);
 
   // highlight the appropriate stages in the flowchart
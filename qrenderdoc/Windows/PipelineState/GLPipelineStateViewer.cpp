@@ -634,10 +634,10 @@ void GLPipelineStateViewer::setShaderState(const GLPipe::Shader &stage, QLabel *
   // simultaneous update of resources and samplers
   vs = textures->verticalScrollBar()->value();
   textures->setUpdatesEnabled(false);
-  textures->clear();
+  textures->beginRebuild();
   vs2 = samplers->verticalScrollBar()->value();
   samplers->setUpdatesEnabled(false);
-  samplers->clear();
+  samplers->beginRebuild();
 
   for(int i = 0; i < state.Textures.count; i++)
   {
@@ -807,15 +807,17 @@ void GLPipelineStateViewer::setShaderState(const GLPipe::Shader &stage, QLabel *
   }
 
   samplers->clearSelection();
+  samplers->endRebuild();
   samplers->setUpdatesEnabled(true);
   samplers->verticalScrollBar()->setValue(vs2);
   textures->clearSelection();
+  textures->endRebuild();
   textures->setUpdatesEnabled(true);
   textures->verticalScrollBar()->setValue(vs);
 
   vs = ubos->verticalScrollBar()->value();
   ubos->setUpdatesEnabled(false);
-  ubos->clear();
+  ubos->beginRebuild();
   for(int i = 0; shaderDetails && i < shaderDetails->ConstantBlocks.count; i++)
   {
     const ConstantBlock &shaderCBuf = shaderDetails->ConstantBlocks[i];
@@ -888,15 +890,17 @@ void GLPipelineStateViewer::setShaderState(const GLPipe::Shader &stage, QLabel *
     }
   }
   ubos->clearSelection();
+  ubos->endRebuild();
   ubos->setUpdatesEnabled(true);
   ubos->verticalScrollBar()->setValue(vs);
 
   vs = subs->verticalScrollBar()->value();
   subs->setUpdatesEnabled(false);
-  subs->clear();
+  subs->beginRebuild();
   for(int i = 0; i < stage.Subroutines.count; i++)
     subs->addTopLevelItem(new RDTreeWidgetItem({i, stage.Subroutines[i]}));
   subs->clearSelection();
+  subs->endRebuild();
   subs->setUpdatesEnabled(true);
   subs->verticalScrollBar()->setValue(vs);
 
@@ -904,7 +908,7 @@ void GLPipelineStateViewer::setShaderState(const GLPipe::Shader &stage, QLabel *
 
   vs = readwrites->verticalScrollBar()->value();
   readwrites->setUpdatesEnabled(false);
-  readwrites->clear();
+  readwrites->beginRebuild();
   for(int i = 0; shaderDetails && i < shaderDetails->ReadWriteResources.count; i++)
   {
     const ShaderResource &res = shaderDetails->ReadWriteResources[i];
@@ -1036,6 +1040,7 @@ void GLPipelineStateViewer::setShaderState(const GLPipe::Shader &stage, QLabel *
     }
   }
   readwrites->clearSelection();
+  readwrites->endRebuild();
   readwrites->setUpdatesEnabled(true);
   readwrites->verticalScrollBar()->setValue(vs);
 
@@ -1128,7 +1133,7 @@ void GLPipelineStateViewer::setState()
 
   vs = ui->viAttrs->verticalScrollBar()->value();
   ui->viAttrs->setUpdatesEnabled(false);
-  ui->viAttrs->clear();
+  ui->viAttrs->beginRebuild();
   {
     int i = 0;
     for(const GLPipe::VertexAttribute &a : state.m_VtxIn.attributes)
@@ -1177,6 +1182,7 @@ void GLPipelineStateViewer::setState()
     }
   }
   ui->viAttrs->clearSelection();
+  ui->viAttrs->endRebuild();
   ui->viAttrs->setUpdatesEnabled(true);
   ui->viAttrs->verticalScrollBar()->setValue(vs);
 
@@ -1232,7 +1238,7 @@ void GLPipelineStateViewer::setState()
 
   vs = ui->viBuffers->verticalScrollBar()->value();
   ui->viBuffers->setUpdatesEnabled(false);
-  ui->viBuffers->clear();
+  ui->viBuffers->beginRebuild();
 
   if(state.m_VtxIn.ibuffer != ResourceId())
   {
@@ -1330,6 +1336,9 @@ void GLPipelineStateViewer::setState()
     }
   }
   ui->viBuffers->clearSelection();
+  ui->viBuffers->endRebuild();
+  for(RDTreeWidgetItem *&node : m_VBNodes)
+    node = ui->viBuffers->rebuiltItem(node);
   ui->viBuffers->setUpdatesEnabled(true);
   ui->viBuffers->verticalScrollBar()->setValue(vs);
 
@@ -1348,7 +1357,7 @@ void GLPipelineStateViewer::setState()
 
   vs = ui->gsFeedback->verticalScrollBar()->value();
   ui->gsFeedback->setUpdatesEnabled(false);
-  ui->gsFeedback->clear();
+  ui->gsFeedback->beginRebuild();
   if(state.m_Feedback.Active)
   {
     ui->xfbPaused->setPixmap(state.m_Feedback.Paused ? tick : cross);
@@ -1393,6 +1402,7 @@ void GLPipelineStateViewer::setState()
   }
   ui->gsFeedback->verticalScrollBar()->setValue(vs);
   ui->gsFeedback->clearSelection();
+  ui->gsFeedback->endRebuild();
   ui->gsFeedback->setUpdatesEnabled(true);
 
   ui->gsFeedback->setVisible(state.m_Feedback.Active);
@@ -1403,7 +1413,7 @@ void GLPipelineStateViewer::setState()
 
   vs = ui->viewports->verticalScrollBar()->value();
   ui->viewports->setUpdatesEnabled(false);
-  ui->viewports->clear();
+  ui->viewports->beginRebuild();
 
   {
     // accumulate identical viewports to save on visual repetition
@@ -1468,13 +1478,14 @@ void GLPipelineStateViewer::setState()
   }
   ui->viewports->verticalScrollBar()->setValue(vs);
   ui->viewports->clearSelection();
+  ui->viewports->endRebuild();
   ui->viewports->setUpdatesEnabled(true);
 
   bool anyScissorEnable = false;
 
   vs = ui->scissors->verticalScrollBar()->value();
   ui->scissors->setUpdatesEnabled(false);
-  ui->scissors->clear();
+  ui->scissors->beginRebuild();
   {
     // accumulate identical scissors to save on visual repetition
     int prev = 0;
@@ -1544,6 +1555,7 @@ void GLPipelineStateViewer::setState()
   }
   ui->scissors->clearSelection();
   ui->scissors->verticalScrollBar()->setValue(vs);
+  ui->scissors->endRebuild();
   ui->scissors->setUpdatesEnabled(true);
 
   ui->fillMode->setText(ToQStr(state.m_Rasterizer.m_State.fillMode));
@@ -1651,7 +1663,7 @@ void GLPipelineStateViewer::setState()
 
   vs = ui->framebuffer->verticalScrollBar()->value();
   ui->framebuffer->setUpdatesEnabled(false);
-  ui->framebuffer->clear();
+  ui->framebuffer->beginRebuild();
   {
     int i = 0;
     for(int db : state.m_FB.m_DrawFBO.DrawBuffers)
@@ -1813,12 +1825,13 @@ void GLPipelineStateViewer::setState()
   }
 
   ui->framebuffer->clearSelection();
+  ui->framebuffer->endRebuild();
   ui->framebuffer->setUpdatesEnabled(true);
   ui->framebuffer->verticalScrollBar()->setValue(vs);
 
   vs = ui->blends->verticalScrollBar()->value();
   ui->blends->setUpdatesEnabled(false);
-  ui->blends->clear();
+  ui->blends->beginRebuild();
   {
     bool logic = state.m_FB.m_Blending.Blends[0].Logic != LogicOp::NoOp;
 
@@ -1881,6 +1894,7 @@ void GLPipelineStateViewer::setState()
     }
   }
   ui->blends->clearSelection();
+  ui->blends->endRebuild();
   ui->blends->setUpdatesEnabled(true);
   ui->blends->verticalScrollBar()->setValue(vs);
 
@@ -1907,7 +1921,7 @@ void GLPipelineStateViewer::setState()
   }
 
   ui->stencils->setUpdatesEnabled(false);
-  ui->stencils->clear();
+  ui->stencils->beginRebuild();
   if(state.m_StencilState.StencilEnable)
   {
     ui->stencils->addTopLevelItem(new RDTreeWidgetItem(
@@ -1936,6 +1950,7 @@ void GLPipelineStateViewer::setState()
         {tr("Back"), lit("-"), lit("-"), lit("-"), lit("-"), lit("-"), lit("-"), lit("-")}));
   }
   ui->stencils->clearSelection();
+  ui->stencils->endRebuild();
   ui->stencils->setUpdatesEnabled(true);
 
   // highlight the appropriate stages in the flowchart
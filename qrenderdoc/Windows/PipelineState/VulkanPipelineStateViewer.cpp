@@ -1260,7 +1260,7 @@ void VulkanPipelineStateViewer::setShaderState(const VKPipe::Shader &stage,
 
   vs = resources->verticalScrollBar()->value();
   resources->setUpdatesEnabled(false);
-  resources->clear();
+  resources->beginRebuild();
 
   QMap<ResourceId, SamplerData> samplers;
 
@@ -1337,12 +1337,20 @@ void VulkanPipelineStateViewer::setShaderState(const VKPipe::Shader &stage,
   }
 
   resources->clearSelection();
+  resources->endRebuild();
+
+  // the image and sampler nodes may have been merged into existing rows
+  QMap<RDTreeWidgetItem *, RDTreeWidgetItem *> combinedImageSamplers;
+  for(auto it = m_CombinedImageSamplers.begin(); it != m_CombinedImageSamplers.end(); ++it)
+    combinedImageSamplers[resources->rebuiltItem(it.key())] = resources->rebuiltItem(it.value());
+  m_CombinedImageSamplers.swap(combinedImageSamplers);
+
   resources->setUpdatesEnabled(true);
   resources->verticalScrollBar()->setValue(vs);
 
   vs = ubos->verticalScrollBar()->value();
   ubos->setUpdatesEnabled(false);
-  ubos->clear();
+  ubos->beginRebuild();
   for(int bindset = 0; bindset < pipe.DescSets.count; bindset++)
   {
     for(int bind = 0; bind < pipe.DescSets[bindset].bindings.count; bind++)
@@ -1411,6 +1419,7 @@ void VulkanPipelineStateViewer::setShaderState(const VKPipe::Shader &stage,
     }
   }
   ubos->clearSelection();
+  ubos->endRebuild();
   ubos->setUpdatesEnabled(true);
   ubos->verticalScrollBar()->setValue(vs);
 }
@@ -1443,7 +1452,7 @@ void VulkanPipelineStateViewer::setState()
 
   vs = ui->viAttrs->verticalScrollBar()->value();
   ui->viAttrs->setUpdatesEnabled(false);
-  ui->viAttrs->clear();
+  ui->viAttrs->beginRebuild();
   {
     int i = 0;
     for(const VKPipe::VertexAttribute &a : state.VI.attrs)
@@ -1483,6 +1492,7 @@ void VulkanPipelineStateViewer::setState()
     }
   }
   ui->viAttrs->clearSelection();
+  ui->viAttrs->endRebuild();
   ui->viAttrs->setUpdatesEnabled(true);
   ui->viAttrs->verticalScrollBar()->setValue(vs);
 
@@ -1526,7 +1536,7 @@ void VulkanPipelineStateViewer::setState()
 
   vs = ui->viBuffers->verticalScrollBar()->value();
   ui->viBuffers->setUpdatesEnabled(false);
-  ui->viBuffers->clear();
+  ui->viBuffers->beginRebuild();
 
   bool ibufferUsed = draw != NULL && (draw->flags & DrawFlags::UseIBuffer);
 
@@ -1676,6 +1686,9 @@ void VulkanPipelineStateViewer::setState()
     }
   }
   ui->viBuffers->clearSelection();
+  ui->viBuffers->endRebuild();
+  for(RDTreeWidgetItem *&node : m_VBNodes)
+    node = ui->viBuffers->rebuiltItem(node);
   ui->viBuffers->setUpdatesEnabled(true);
   ui->viBuffers->verticalScrollBar()->setValue(vs);
 
@@ -1691,11 +1704,11 @@ void VulkanPipelineStateViewer::setState()
 
   vs = ui->viewports->verticalScrollBar()->value();
   ui->viewports->setUpdatesEnabled(false);
-  ui->viewports->clear();
+  ui->viewports->beginRebuild();
 
   int vs2 = ui->scissors->verticalScrollBar()->value();
   ui->scissors->setUpdatesEnabled(false);
-  ui->scissors->clear();
+  ui->scissors->beginRebuild();
 
   if(state.Pass.renderpass.obj != ResourceId())
   {
@@ -1730,7 +1743,9 @@ void VulkanPipelineStateViewer::setState()
   ui->scissors->clearSelection();
   ui->scissors->verticalScrollBar()->setValue(vs2);
 
+  ui->viewports->endRebuild();
   ui->viewports->setUpdatesEnabled(true);
+  ui->scissors->endRebuild();
   ui->scissors->setUpdatesEnabled(true);
 
   ui->fillMode->setText(ToQStr(state.RS.fillMode));
@@ -1758,7 +1773,7 @@ void VulkanPipelineStateViewer::setState()
 
   vs = ui->framebuffer->verticalScrollBar()->value();
   ui->framebuffer->setUpdatesEnabled(false);
-  ui->framebuffer->clear();
+  ui->framebuffer->beginRebuild();
   {
     int i = 0;
     for(const VKPipe::Attachment &p : state.Pass.framebuffer.attachments)
@@ -1855,12 +1870,13 @@ void VulkanPipelineStateViewer::setState()
   }
 
   ui->framebuffer->clearSelection();
+  ui->framebuffer->endRebuild();
   ui->framebuffer->setUpdatesEnabled(true);
   ui->framebuffer->verticalScrollBar()->setValue(vs);
 
   vs = ui->blends->verticalScrollBar()->value();
   ui->blends->setUpdatesEnabled(false);
-  ui->blends->clear();
+  ui->blends->beginRebuild();
   {
     int i = 0;
     for(const VKPipe::Blend &blend : state.CB.attachments)
@@ -1898,6 +1914,7 @@ void VulkanPipelineStateViewer::setState()
     }
   }
   ui->blends->clearSelection();
+  ui->blends->endRebuild();
   ui->blends->setUpdatesEnabled(true);
   ui->blends->verticalScrollBar()->setValue(vs);
 
@@ -1926,7 +1943,7 @@ void VulkanPipelineStateViewer::setState()
   }
 
   ui->stencils->setUpdatesEnabled(false);
-  ui->stencils->clear();
+  ui->stencils->beginRebuild();
   if(state.DS.stencilTestEnable)
   {
     ui->stencils->addTopLevelItem(new RDTreeWidgetItem(
@@ -1950,6 +1967,7 @@ void VulkanPipelineStateViewer::setState()
         {tr("Back"), lit("-"), lit("-"), lit("-"), lit("-"), lit("-"), lit("-"), lit("-")}));
   }
   ui->stencils->clearSelection();
+  ui->stencils->endRebuild();
   ui->stencils->setUpdatesEnabled(true);
 
   // highlight the appropriate stages in the flowchart
@@ -646,7 +646,7 @@ void PixelHistoryView::startDebug(EventTag tag)
     trace = r->DebugPixel((uint32_t)m_Pixel.x(), (uint32_t)m_Pixel.y(), m_Display.sampleIdx, ~0U);
   });
 
-  if(trace->states.count == 0)
+  if(trace->steps.count == 0)
   {
     RDDialog::critical(this, tr("Debug Error"), tr("Error debugging pixel."));
     m_Ctx.Replay().AsyncInvoke([trace](IReplayController *r) { r->FreeTrace(trace); });
@@ -65,6 +65,7 @@ ShaderViewer::ShaderViewer(ICaptureContext &ctx, QWidget *parent)
   ui->watch->setFont(Formatter::PreferredFont());
   ui->inputSig->setFont(Formatter::PreferredFont());
   ui->outputSig->setFont(Formatter::PreferredFont());
+  ui->cost->setFont(Formatter::PreferredFont());
 
   // we create this up front so its state stays persistent as much as possible.
   m_FindReplace = new FindReplace(this);
@@ -279,7 +280,11 @@ void ShaderViewer::debugShader(const ShaderBindpointMapping *bind, const ShaderR
   {
     // read-only applies to us too!
     m_DisassemblyView->setReadOnly(false);
-    m_DisassemblyView->setText(shader->Disassembly.c_str());
+    // some traces step through their own listing rather than the shader's disassembly
+    if(m_Trace && !m_Trace->disassembly.empty())
+      m_DisassemblyView->setText(m_Trace->disassembly.c_str());
+    else
+      m_DisassemblyView->setText(shader->Disassembly.c_str());
     m_DisassemblyView->setReadOnly(true);
   }
 
@@ -338,9 +343,10 @@ void ShaderViewer::debugShader(const ShaderBindpointMapping *bind, const ShaderR
 
   if(trace)
   {
-    // hide signatures
+    // hide signatures and cost
     ui->inputSig->hide();
     ui->outputSig->hide();
+    ui->cost->hide();
 
     ui->variables->setColumns({tr("Name"), tr("Type"), tr("Value")});
     ui->variables->header()->setSectionResizeMode(0, QHeaderView::Stretch);
@@ -490,6 +496,40 @@ void ShaderViewer::debugShader(const ShaderBindpointMapping *bind, const ShaderR
                                                         ui->docking->areaOf(ui->inputSig), 0.5f));
     ui->docking->setToolWindowProperties(
         ui->outputSig, ToolWindowManager::HideCloseButton | ToolWindowManager::DisallowFloatWindow);
+
+    // show the static cost estimate. OpenGL doesn't provide one
+    if(shader && shader->Cost.instructions > 0)
+    {
+      const ShaderCost &cost = shader->Cost;
+
+      ui->cost->setColumns({tr("Property"), tr("Value")});
+      ui->cost->header()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
+      ui->cost->header()->setSectionResizeMode(1, QHeaderView::Stretch);
+
+      ui->cost->addTopLevelItem(new RDTreeWidgetItem({tr("Instructions"), cost.instructions}));
+      ui->cost->addTopLevelItem(new RDTreeWidgetItem({tr("ALU"), cost.aluInstructions}));
+      ui->cost->addTopLevelItem(
+          new RDTreeWidgetItem({tr("Transcendental"), cost.transcendentalInstructions}));
+      ui->cost->addTopLevelItem(
+          new RDTreeWidgetItem({tr("Texture samples"), cost.sampleInstructions}));
+      ui->cost->addTopLevelItem(new RDTreeWidgetItem({tr("Memory"), cost.memoryInstructions}));
+      ui->cost->addTopLevelItem(
+          new RDTreeWidgetItem({tr("Flow control"), cost.flowControlInstructions}));
+      ui->cost->addTopLevelItem(new RDTreeWidgetItem({tr("Temp registers"), cost.tempRegisters}));
+      ui->cost->addTopLevelItem(new RDTreeWidgetItem({tr("Loops"), cost.loops}));
+      ui->cost->addTopLevelItem(new RDTreeWidgetItem({tr("Max loop depth"), cost.maxLoopDepth}));
+
+      ui->cost->setWindowTitle(tr("Cost"));
+      ui->docking->addToolWindow(
+          ui->cost, ToolWindowManager::AreaReference(ToolWindowManager::RightOf,
+                                                     ui->docking->areaOf(ui->outputSig), 0.3f));
+      ui->docking->setToolWindowProperties(
+          ui->cost, ToolWindowManager::HideCloseButton | ToolWindowManager::DisallowFloatWindow);
+    }
+    else
+    {
+      ui->cost->hide();
+    }
   }
 }
 
@@ -689,7 +729,7 @@ bool ShaderViewer::stepNext()
   if(!m_Trace)
     return false;
 
-  if(CurrentStep() + 1 >= m_Trace->states.count)
+  if(CurrentStep() + 1 >= m_Trace->steps.count)
     return false;
 
   SetCurrentStep(CurrentStep() + 1);
@@ -766,20 +806,20 @@ void ShaderViewer::runTo(int runToInstruction, bool forward, ShaderEvents condit
 
   bool firstStep = true;
 
-  while(step < m_Trace->states.count)
+  while(step < m_Trace->steps.count)
   {
-    if(runToInstruction >= 0 && m_Trace->states[step].nextInstruction == (uint32_t)runToInstruction)
+    if(runToInstruction >= 0 && m_Trace->steps[step].nextInstruction == (uint32_t)runToInstruction)
       break;
 
-    if(!firstStep && (m_Trace->states[step + inc].flags & condition))
+    if(!firstStep && (m_Trace->steps[step + inc].flags & condition))
       break;
 
-    if(!firstStep && m_Breakpoints.contains((int)m_Trace->states[step].nextInstruction))
+    if(!firstStep && m_Breakpoints.contains((int)m_Trace->steps[step].nextInstruction))
       break;
 
     firstStep = false;
 
-    if(step + inc < 0 || step + inc >= m_Trace->states.count)
+    if(step + inc < 0 || step + inc >= m_Trace->steps.count)
       break;
 
     step += inc;
@@ -875,15 +915,20 @@ void ShaderViewer::addFileList()
 
 void ShaderViewer::updateDebugging()
 {
-  if(!m_Trace || m_CurrentStep < 0 || m_CurrentStep >= m_Trace->states.count)
+  if(!m_Trace || m_CurrentStep < 0 || m_CurrentStep >= m_Trace->steps.count)
     return;
 
-  const ShaderDebugState &state = m_Trace->states[m_CurrentStep];
+  // the trace only stores what changed at each step, so bring our copy of the state up to the
+  // current step. Stepping forwards only needs to apply the changes since the last step shown.
+  ShaderDebug_ReconstructState(m_Trace, m_CurrentStep, m_StateStep, &m_State);
+  m_StateStep = m_CurrentStep;
+
+  const ShaderDebugState &state = m_State;
 
   uint32_t nextInst = state.nextInstruction;
   bool done = false;
 
-  if(m_CurrentStep == m_Trace->states.count - 1)
+  if(m_CurrentStep == m_Trace->steps.count - 1)
   {
     nextInst--;
     done = true;
@@ -1097,8 +1142,8 @@ int ShaderViewer::CurrentStep()
 
 void ShaderViewer::SetCurrentStep(int step)
 {
-  if(m_Trace && !m_Trace->states.empty())
-    m_CurrentStep = qBound(0, step, m_Trace->states.count - 1);
+  if(m_Trace && !m_Trace->steps.empty())
+    m_CurrentStep = qBound(0, step, m_Trace->steps.count - 1);
   else
     m_CurrentStep = 0;
 
@@ -163,6 +163,9 @@ private:
 
   ShaderDebugTrace *m_Trace = NULL;
   int m_CurrentStep;
+  // the full state at m_StateStep, rebuilt on demand from the trace's per-step changes
+  ShaderDebugState m_State;
+  int m_StateStep = -1;
   QList<int> m_Breakpoints;
 
   static const int CURRENT_MARKER = 0;
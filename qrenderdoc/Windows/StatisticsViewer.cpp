@@ -29,10 +29,8 @@
 static const int HistogramWidth = 128;
 static const QString Stars = QString(HistogramWidth, QLatin1Char('*'));
 
-QString Pow2IndexAsReadable(int index)
+QString BytesAsReadable(uint64_t value)
 {
-  uint64_t value = 1ULL << index;
-
   if(value >= (1024 * 1024))
   {
     float slice = (float)value / (1024 * 1024);
@@ -49,6 +47,11 @@ QString Pow2IndexAsReadable(int index)
   }
 }
 
+QString Pow2IndexAsReadable(int index)
+{
+  return BytesAsReadable(1ULL << index);
+}
+
 int SliceForString(const QString &s, uint32_t value, uint32_t maximum)
 {
   if(value == 0 || maximum == 0)
@@ -815,6 +818,91 @@ StatisticsViewer::StatisticsViewer(ICaptureContext &ctx, QWidget *parent)
 
   ui->statistics->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
 
+  ui->wastedWork->setColumns({lit("EID"), tr("Source"), tr("Severity"), tr("Description")});
+  ui->wastedWork->header()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
+  ui->wastedWork->header()->setSectionResizeMode(1, QHeaderView::ResizeToContents);
+  ui->wastedWork->header()->setSectionResizeMode(2, QHeaderView::ResizeToContents);
+  ui->wastedWork->header()->setSectionResizeMode(3, QHeaderView::Stretch);
+  ui->wastedWork->setFont(Formatter::PreferredFont());
+
+  ui->shaderCost->setColumns({lit("EID"), tr("Drawcall"), tr("Instructions"), tr("ALU"),
+                              tr("Transcendental"), tr("Samples"), tr("Memory"),
+                              tr("Flow Control"), tr("Temps"), tr("Loops")});
+  ui->shaderCost->header()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
+  ui->shaderCost->header()->setSectionResizeMode(1, QHeaderView::Stretch);
+  for(int i = 2; i < ui->shaderCost->header()->count(); i++)
+    ui->shaderCost->header()->setSectionResizeMode(i, QHeaderView::ResizeToContents);
+  ui->shaderCost->setFont(Formatter::PreferredFont());
+
+  ui->bandwidth->setColumns({lit("EID"), tr("Event"), tr("Total Read"), tr("Total Written"),
+                             tr("Vertices"), tr("Resources"), tr("Target Read"),
+                             tr("Target Written")});
+  ui->bandwidth->header()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
+  ui->bandwidth->header()->setSectionResizeMode(1, QHeaderView::Stretch);
+  for(int i = 2; i < ui->bandwidth->header()->count(); i++)
+    ui->bandwidth->header()->setSectionResizeMode(i, QHeaderView::ResizeToContents);
+  ui->bandwidth->setFont(Formatter::PreferredFont());
+
+  ui->splitter->setCollapsible(1, true);
+  ui->splitter->setCollapsible(2, true);
+  ui->bottlenecks->setColumns({lit("EID"), tr("Pass / Event"), tr("Limiter"),
+                               tr("Duration (%1)").arg(UnitSuffix(TimeUnit::Microseconds)),
+                               tr("Vertices"), tr("Pixels"), tr("Bytes")});
+  ui->bottlenecks->header()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
+  ui->bottlenecks->header()->setSectionResizeMode(1, QHeaderView::Stretch);
+  for(int i = 2; i < ui->bottlenecks->header()->count(); i++)
+    ui->bottlenecks->header()->setSectionResizeMode(i, QHeaderView::ResizeToContents);
+  ui->bottlenecks->setFont(Formatter::PreferredFont());
+
+  QString unit = UnitSuffix(TimeUnit::Microseconds);
+  ui->queueTimeline->setColumns({lit("EID"), tr("Queue / Submission"), tr("Start (%1)").arg(unit),
+                                 tr("Duration (%1)").arg(unit), tr("Stall (%1)").arg(unit),
+                                 tr("Overlap (%1)").arg(unit), tr("Waits")});
+  ui->queueTimeline->header()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
+  ui->queueTimeline->header()->setSectionResizeMode(1, QHeaderView::Stretch);
+  for(int i = 2; i < ui->queueTimeline->header()->count(); i++)
+    ui->queueTimeline->header()->setSectionResizeMode(i, QHeaderView::ResizeToContents);
+  ui->queueTimeline->setFont(Formatter::PreferredFont());
+
+  ui->indexEfficiency->setColumns({lit("EID"), tr("Event"), tr("Triangles"), tr("Degenerate"),
+                                   tr("Unique Vertices"), tr("Referenced"), tr("FIFO ACMR"),
+                                   tr("LRU ACMR"), tr("LRU ATVR")});
+  ui->indexEfficiency->header()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
+  ui->indexEfficiency->header()->setSectionResizeMode(1, QHeaderView::Stretch);
+  for(int i = 2; i < ui->indexEfficiency->header()->count(); i++)
+    ui->indexEfficiency->header()->setSectionResizeMode(i, QHeaderView::ResizeToContents);
+  ui->indexEfficiency->setFont(Formatter::PreferredFont());
+
+  ui->splitter->setCollapsible(3, true);
+  ui->splitter->setCollapsible(4, true);
+  ui->splitter->setCollapsible(5, true);
+  ui->splitter->setCollapsible(6, true);
+  ui->splitter->setSizes({3, 1, 1, 1, 1, 1, 1});
+
+  RDSplitterHandle *handle = (RDSplitterHandle *)ui->splitter->handle(1);
+  handle->setTitle(tr("Wasted Work"));
+  handle->setIndex(1);
+
+  handle = (RDSplitterHandle *)ui->splitter->handle(2);
+  handle->setTitle(tr("Shader Cost (heaviest first)"));
+  handle->setIndex(2);
+
+  handle = (RDSplitterHandle *)ui->splitter->handle(3);
+  handle->setTitle(tr("Estimated Memory Bandwidth (heaviest first)"));
+  handle->setIndex(3);
+
+  handle = (RDSplitterHandle *)ui->splitter->handle(4);
+  handle->setTitle(tr("Bottlenecks (most expensive pass first)"));
+  handle->setIndex(4);
+
+  handle = (RDSplitterHandle *)ui->splitter->handle(5);
+  handle->setTitle(tr("Queue Timeline"));
+  handle->setIndex(5);
+
+  handle = (RDSplitterHandle *)ui->splitter->handle(6);
+  handle->setTitle(tr("Index Efficiency (most redundant vertex work first)"));
+  handle->setIndex(6);
+
   m_Ctx.AddLogViewer(this);
 }
 
@@ -829,10 +917,322 @@ StatisticsViewer::~StatisticsViewer()
 void StatisticsViewer::OnLogfileClosed()
 {
   ui->statistics->clear();
+  ui->wastedWork->clear();
+  ui->shaderCost->clear();
+  ui->bandwidth->clear();
+  ui->bottlenecks->clear();
+  ui->queueTimeline->clear();
+  ui->indexEfficiency->clear();
 }
 
 void StatisticsViewer::OnLogfileLoaded()
 {
   GenerateReport();
   ui->statistics->setText(m_Report);
-}
\ No newline at end of file
+
+  FetchWastedWork();
+  FetchShaderCosts();
+  FetchBandwidth();
+  FetchBottlenecks();
+  FetchQueueTimeline();
+  FetchIndexEfficiency();
+}
+
+void StatisticsViewer::FetchWastedWork()
+{
+  ui->wastedWork->clear();
+
+  m_Ctx.Replay().AsyncInvoke([this](IReplayController *r) {
+    rdctype::array<DebugMessage> msgs = r->AnalyseWastedWork();
+
+    GUIInvoke::call([this, msgs]() {
+      ui->wastedWork->beginUpdate();
+
+      for(const DebugMessage &msg : msgs)
+      {
+        RDTreeWidgetItem *item =
+            new RDTreeWidgetItem({QString::number(msg.eventID), ToQStr(msg.source),
+                                  ToQStr(msg.severity), ToQStr(msg.description)});
+        item->setTag(msg.eventID);
+        ui->wastedWork->addTopLevelItem(item);
+      }
+
+      ui->wastedWork->endUpdate();
+    });
+  });
+}
+
+void StatisticsViewer::on_wastedWork_itemActivated(RDTreeWidgetItem *item, int column)
+{
+  if(!m_Ctx.LogLoaded())
+    return;
+
+  uint32_t eid = item->tag().toUInt();
+  m_Ctx.SetEventID({}, eid, eid);
+}
+
+void StatisticsViewer::FetchShaderCosts()
+{
+  ui->shaderCost->clear();
+
+  m_Ctx.Replay().AsyncInvoke([this](IReplayController *r) {
+    rdctype::array<DrawcallShaderCost> costs = r->GetDrawcallShaderCosts();
+
+    GUIInvoke::call([this, costs]() {
+      QVector<const DrawcallShaderCost *> sorted;
+      for(const DrawcallShaderCost &c : costs)
+        sorted.push_back(&c);
+
+      std::stable_sort(sorted.begin(), sorted.end(),
+                       [](const DrawcallShaderCost *a, const DrawcallShaderCost *b) {
+                         return a->cost.instructions > b->cost.instructions;
+                       });
+
+      ui->shaderCost->beginUpdate();
+
+      for(const DrawcallShaderCost *c : sorted)
+      {
+        const DrawcallDescription *draw = m_Ctx.GetDrawcall(c->eventID);
+
+        RDTreeWidgetItem *item = new RDTreeWidgetItem(
+            {c->eventID, draw ? ToQStr(draw->name) : QString(), c->cost.instructions,
+             c->cost.aluInstructions, c->cost.transcendentalInstructions,
+             c->cost.sampleInstructions, c->cost.memoryInstructions,
+             c->cost.flowControlInstructions, c->cost.tempRegisters, c->cost.loops});
+        item->setTag(c->eventID);
+        ui->shaderCost->addTopLevelItem(item);
+      }
+
+      ui->shaderCost->endUpdate();
+    });
+  });
+}
+
+void StatisticsViewer::on_shaderCost_itemActivated(RDTreeWidgetItem *item, int column)
+{
+  if(!m_Ctx.LogLoaded())
+    return;
+
+  uint32_t eid = item->tag().toUInt();
+  m_Ctx.SetEventID({}, eid, eid);
+}
+
+void StatisticsViewer::FetchBandwidth()
+{
+  ui->bandwidth->clear();
+
+  m_Ctx.Replay().AsyncInvoke([this](IReplayController *r) {
+    rdctype::array<DrawcallBandwidth> bandwidth = r->GetDrawcallBandwidth();
+
+    GUIInvoke::call([this, bandwidth]() {
+      QVector<const DrawcallBandwidth *> sorted;
+      for(const DrawcallBandwidth &b : bandwidth)
+        sorted.push_back(&b);
+
+      std::stable_sort(sorted.begin(), sorted.end(),
+                       [](const DrawcallBandwidth *a, const DrawcallBandwidth *b) {
+                         return a->bytesRead + a->bytesWritten > b->bytesRead + b->bytesWritten;
+                       });
+
+      ui->bandwidth->beginUpdate();
+
+      for(const DrawcallBandwidth *b : sorted)
+      {
+        const DrawcallDescription *draw = m_Ctx.GetDrawcall(b->eventID);
+
+        RDTreeWidgetItem *item = new RDTreeWidgetItem(
+            {b->eventID, draw ? ToQStr(draw->name) : QString(), BytesAsReadable(b->bytesRead),
+             BytesAsReadable(b->bytesWritten), BytesAsReadable(b->vertexBytes),
+             BytesAsReadable(b->resourceReadBytes), BytesAsReadable(b->targetReadBytes),
+             BytesAsReadable(b->targetWriteBytes)});
+        item->setTag(b->eventID);
+        ui->bandwidth->addTopLevelItem(item);
+      }
+
+      ui->bandwidth->endUpdate();
+    });
+  });
+}
+
+void StatisticsViewer::on_bandwidth_itemActivated(RDTreeWidgetItem *item, int column)
+{
+  if(!m_Ctx.LogLoaded())
+    return;
+
+  uint32_t eid = item->tag().toUInt();
+  m_Ctx.SetEventID({}, eid, eid);
+}
+
+void StatisticsViewer::FetchBottlenecks()
+{
+  ui->bottlenecks->clear();
+
+  m_Ctx.Replay().AsyncInvoke([this](IReplayController *r) {
+    rdctype::array<PassBottleneck> passes = r->AnalyseBottlenecks();
+
+    GUIInvoke::call([this, passes]() {
+      ui->bottlenecks->beginUpdate();
+
+      for(const PassBottleneck &p : passes)
+      {
+        RDTreeWidgetItem *passItem = new RDTreeWidgetItem(
+            {p.eventID, ToQStr(p.name), ToQStr(p.limiter), p.duration * 1000000.0, QString(),
+             QString(), QString()});
+        passItem->setTag(p.eventID);
+
+        for(const DrawcallBottleneck &b : p.draws)
+        {
+          const DrawcallDescription *draw = m_Ctx.GetDrawcall(b.eventID);
+
+          // a dispatch's shader invocations go in the pixel column, as it has no vertices
+          uint64_t invocations = b.computeInvocations ? b.computeInvocations : b.pixelInvocations;
+
+          RDTreeWidgetItem *item = new RDTreeWidgetItem(
+              {b.eventID, draw ? ToQStr(draw->name) : QString(), ToQStr(b.limiter),
+               b.duration * 1000000.0, qulonglong(b.vertexInvocations), qulonglong(invocations),
+               BytesAsReadable(b.bytes)});
+          item->setTag(b.eventID);
+          passItem->addChild(item);
+        }
+
+        ui->bottlenecks->addTopLevelItem(passItem);
+      }
+
+      ui->bottlenecks->endUpdate();
+    });
+  });
+}
+
+void StatisticsViewer::on_bottlenecks_itemActivated(RDTreeWidgetItem *item, int column)
+{
+  if(!m_Ctx.LogLoaded())
+    return;
+
+  uint32_t eid = item->tag().toUInt();
+  m_Ctx.SetEventID({}, eid, eid);
+}
+
+void StatisticsViewer::FetchQueueTimeline()
+{
+  ui->queueTimeline->clear();
+
+  // single-queue APIs have nothing to lay out
+  if(m_Ctx.FrameInfo().queueSubmissions.count == 0)
+    return;
+
+  m_Ctx.Replay().AsyncInvoke([this](IReplayController *r) {
+    rdctype::array<SubmissionTiming> timings = r->GetQueueTimeline();
+
+    GUIInvoke::call([this, timings]() {
+      const rdctype::array<QueueSubmission> &submissions = m_Ctx.FrameInfo().queueSubmissions;
+
+      ui->queueTimeline->beginUpdate();
+
+      QMap<ResourceId, RDTreeWidgetItem *> queues;
+      QMap<ResourceId, SubmissionTiming> totals;
+
+      for(const SubmissionTiming &t : timings)
+      {
+        const QueueSubmission &sub = submissions[t.submission];
+
+        RDTreeWidgetItem *queueItem = queues[sub.queue];
+        if(queueItem == NULL)
+        {
+          QString name = QFormatStr("%1 (%2)").arg(ToQStr(sub.queue)).arg(ToQStr(sub.type));
+
+          queueItem = new RDTreeWidgetItem(
+              {sub.eventID, name, QString(), QString(), QString(), QString(), QString()});
+          queueItem->setTag(sub.eventID);
+          queues[sub.queue] = queueItem;
+          totals[sub.queue] = SubmissionTiming();
+          ui->queueTimeline->addTopLevelItem(queueItem);
+        }
+
+        SubmissionTiming &total = totals[sub.queue];
+        total.duration += t.duration;
+        total.stall += t.stall;
+        total.overlap += t.overlap;
+
+        const DrawcallDescription *draw = m_Ctx.GetDrawcall(sub.eventID);
+
+        RDTreeWidgetItem *item = new RDTreeWidgetItem(
+            {sub.eventID, draw ? ToQStr(draw->name) : QString(), t.start * 1000000.0,
+             t.duration * 1000000.0, t.stall * 1000000.0, t.overlap * 1000000.0, sub.waits});
+        item->setTag(sub.eventID);
+        queueItem->addChild(item);
+      }
+
+      // queues show their busy, idle and overlapped time over the whole frame
+      for(auto it = queues.begin(); it != queues.end(); ++it)
+      {
+        const SubmissionTiming &total = totals[it.key()];
+        it.value()->setText(3, total.duration * 1000000.0);
+        it.value()->setText(4, total.stall * 1000000.0);
+        it.value()->setText(5, total.overlap * 1000000.0);
+      }
+
+      ui->queueTimeline->endUpdate();
+    });
+  });
+}
+
+void StatisticsViewer::on_queueTimeline_itemActivated(RDTreeWidgetItem *item, int column)
+{
+  if(!m_Ctx.LogLoaded())
+    return;
+
+  uint32_t eid = item->tag().toUInt();
+  m_Ctx.SetEventID({}, eid, eid);
+}
+
+void StatisticsViewer::FetchIndexEfficiency()
+{
+  ui->indexEfficiency->clear();
+
+  m_Ctx.Replay().AsyncInvoke([this](IReplayController *r) {
+    rdctype::array<IndexEfficiency> efficiency = r->GetIndexEfficiency();
+
+    GUIInvoke::call([this, efficiency]() {
+      // rank by the vertices transformed more than once, which is what reordering could save
+      auto redundant = [](const IndexEfficiency *e) {
+        return (e->lruATVR - 1.0f) * e->uniqueVertices;
+      };
+
+      QVector<const IndexEfficiency *> sorted;
+      for(const IndexEfficiency &e : efficiency)
+        sorted.push_back(&e);
+
+      std::stable_sort(sorted.begin(), sorted.end(),
+                       [redundant](const IndexEfficiency *a, const IndexEfficiency *b) {
+                         return redundant(a) > redundant(b);
+                       });
+
+      ui->indexEfficiency->beginUpdate();
+
+      for(const IndexEfficiency *e : sorted)
+      {
+        const DrawcallDescription *draw = m_Ctx.GetDrawcall(e->eventID);
+
+        RDTreeWidgetItem *item = new RDTreeWidgetItem(
+            {e->eventID, draw ? ToQStr(draw->name) : QString(), e->triangles,
+             e->degenerateTriangles, e->uniqueVertices,
+             QFormatStr("%1%").arg(Formatter::Format(e->referencedFraction * 100.0f)),
+             Formatter::Format(e->fifoACMR), Formatter::Format(e->lruACMR),
+             Formatter::Format(e->lruATVR)});
+        item->setTag(e->eventID);
+        ui->indexEfficiency->addTopLevelItem(item);
+      }
+
+      ui->indexEfficiency->endUpdate();
+    });
+  });
+}
+
+void StatisticsViewer::on_indexEfficiency_itemActivated(RDTreeWidgetItem *item, int column)
+{
+  if(!m_Ctx.LogLoaded())
+    return;
+
+  uint32_t eid = item->tag().toUInt();
+  m_Ctx.SetEventID({}, eid, eid);
+}
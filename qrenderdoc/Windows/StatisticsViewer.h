@@ -27,6 +27,8 @@
 #include <QFrame>
 #include "Code/CaptureContext.h"
 
+class RDTreeWidgetItem;
+
 namespace Ui
 {
 class StatisticsViewer;
@@ -47,6 +49,15 @@ public:
   void OnLogfileClosed() override;
   void OnSelectedEventChanged(uint32_t eventID) override {}
   void OnEventChanged(uint32_t eventID) override {}
+private slots:
+  // automatic slots
+  void on_wastedWork_itemActivated(RDTreeWidgetItem *item, int column);
+  void on_shaderCost_itemActivated(RDTreeWidgetItem *item, int column);
+  void on_bandwidth_itemActivated(RDTreeWidgetItem *item, int column);
+  void on_bottlenecks_itemActivated(RDTreeWidgetItem *item, int column);
+  void on_queueTimeline_itemActivated(RDTreeWidgetItem *item, int column);
+  void on_indexEfficiency_itemActivated(RDTreeWidgetItem *item, int column);
+
 private:
   Ui::StatisticsViewer *ui;
   ICaptureContext &m_Ctx;
@@ -70,4 +81,10 @@ private:
                                uint32_t &dispatchCount, uint32_t &diagnosticCount);
   void AppendAPICallSummary();
   void GenerateReport();
+  void FetchWastedWork();
+  void FetchShaderCosts();
+  void FetchBandwidth();
+  void FetchBottlenecks();
+  void FetchQueueTimeline();
+  void FetchIndexEfficiency();
 };
@@ -693,16 +693,44 @@ void TextureViewer::RT_PickPixelsAndUpdate(IReplayController *)
 
 void TextureViewer::RT_PickHoverAndUpdate(IReplayController *)
 {
-  PixelValue pickValue, realValue;
+  TextureDescription *texptr = GetCurrentTexture();
+
+  if(texptr == NULL || m_Output == NULL)
+    return;
 
   uint32_t x = (uint32_t)m_CurHoverPixel.x();
   uint32_t y = (uint32_t)m_CurHoverPixel.y();
 
-  RT_FetchCurrentPixel(x, y, pickValue, realValue);
+  if(m_TexDisplay.FlipY)
+    y = (texptr->height - 1) - y;
 
-  m_CurHoverValue = pickValue;
+  // hover picks are made when the output is next displayed, so moving the mouse never waits on
+  // the GPU. The value shown may be from the previous position until then.
+  m_Output->RequestPickPixel(m_TexDisplay.texid, true, x, y, m_TexDisplay.sliceFace,
+                             m_TexDisplay.mip, m_TexDisplay.sampleIdx);
 
-  GUIInvoke::call([this]() { UI_UpdateStatusText(); });
+  PixelPick pick = m_Output->GetPickedPixel();
+
+  if(pick.valid)
+    m_CurHoverValue = pick.value;
+
+  bool stale = !pick.valid || pick.texID != m_TexDisplay.texid || pick.x != x || pick.y != y;
+
+  // only check back once, in case the output isn't being displayed
+  bool retry = stale && !m_HoverPickRetry;
+  m_HoverPickRetry = retry;
+
+  GUIInvoke::call([this, retry]() {
+    UI_UpdateStatusText();
+
+    if(retry)
+    {
+      // the display is queued by the repaint, so the check after it sees the latest pick
+      ui->render->repaint();
+      m_Ctx.Replay().AsyncInvoke(lit("PickPixelHover"),
+                                 [this](IReplayController *r) { RT_PickHoverAndUpdate(r); });
+    }
+  });
 }
 
 void TextureViewer::RT_UpdateAndDisplay(IReplayController *)
@@ -2185,12 +2213,12 @@ void TextureViewer::render_mouseMove(QMouseEvent *e)
         m_PickedPoint.setX(qBound(0, m_PickedPoint.x(), (int)texptr->width - 1));
         m_PickedPoint.setY(qBound(0, m_PickedPoint.y(), (int)texptr->height - 1));
 
-        m_Ctx.Replay().AsyncInvoke(lit("PickPixelClick"),
+        m_Ctx.Replay().AsyncInvoke(lit("PickPixelClick"), InvokePriority::Interactive,
                                    [this](IReplayController *r) { RT_PickPixelsAndUpdate(r); });
       }
       else if(e->buttons() == Qt::NoButton)
       {
-        m_Ctx.Replay().AsyncInvoke(lit("PickPixelHover"),
+        m_Ctx.Replay().AsyncInvoke(lit("PickPixelHover"), InvokePriority::Interactive,
                                    [this](IReplayController *r) { RT_PickHoverAndUpdate(r); });
       }
     }
@@ -3298,7 +3326,7 @@ void TextureViewer::on_debugPixelContext_clicked()
   m_Ctx.Replay().AsyncInvoke([this, x, y](IReplayController *r) {
     ShaderDebugTrace *trace = r->DebugPixel((uint32_t)x, (uint32_t)y, m_TexDisplay.sampleIdx, ~0U);
 
-    if(trace->states.count == 0)
+    if(trace->steps.count == 0)
     {
       r->FreeTrace(trace);
 
@@ -277,6 +277,8 @@ private:
   PixelValue m_CurRealValue;
   PixelValue m_CurPixelValue;
   PixelValue m_CurHoverValue;
+  // set while a hover pick is being re-checked after the display that makes it
+  bool m_HoverPickRetry = false;
 
   QColor darkBack;
   QColor lightBack;
@@ -177,6 +177,8 @@ SOURCES += Code/qrenderdoc.cpp \
     Widgets/ThumbnailStrip.cpp \
     Widgets/TextureGoto.cpp \
     Widgets/RangeHistogram.cpp \
+    Widgets/DurationTimeline.cpp \
+    Widgets/TelemetryGraph.cpp \
     Windows/Dialogs/TextureSaveDialog.cpp \
     Windows/Dialogs/CaptureDialog.cpp \
     Windows/Dialogs/LiveCapture.cpp \
@@ -235,6 +237,8 @@ HEADERS += Code/CaptureContext.h \
     Widgets/ThumbnailStrip.h \
     Widgets/TextureGoto.h \
     Widgets/RangeHistogram.h \
+    Widgets/DurationTimeline.h \
+    Widgets/TelemetryGraph.h \
     Windows/Dialogs/TextureSaveDialog.h \
     Windows/Dialogs/CaptureDialog.h \
     Windows/Dialogs/LiveCapture.h \
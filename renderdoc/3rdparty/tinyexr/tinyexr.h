@@ -584,7 +584,7 @@ namespace miniz {
 #define MINIZ_HAS_64BIT_REGISTERS 1
 #endif
 
-#ifdef __cplusplus
+#if 0 // RenderDoc: no C linkage, keeps this miniz internal and apart from 3rdparty/miniz
 extern "C" {
 #endif
 
@@ -1554,7 +1554,7 @@ mz_uint tdefl_create_comp_flags_from_zip_params(int level, int window_bits,
                                                 int strategy);
 #endif // #ifndef MINIZ_NO_ZLIB_APIS
 
-#ifdef __cplusplus
+#if 0
 }
 #endif
 
@@ -1610,7 +1610,7 @@ typedef unsigned char mz_validate_uint64[sizeof(mz_uint64) == 8 ? 1 : -1];
 #define MZ_FORCEINLINE inline
 #endif
 
-#ifdef __cplusplus
+#if 0 // RenderDoc: no C linkage, see above
 extern "C" {
 #endif
 
@@ -6727,7 +6727,7 @@ void *mz_zip_extract_archive_file_to_heap(const char *pZip_filename,
 
 #endif // #ifndef MINIZ_NO_ARCHIVE_APIS
 
-#ifdef __cplusplus
+#if 0
 }
 #endif
 
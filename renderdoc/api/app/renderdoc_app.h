@@ -191,6 +191,139 @@ typedef enum {
   // 0 - API debugging is displayed as normal
   eRENDERDOC_Option_DebugOutputMute = 11,
 
+  // How captures are compressed when written to disk
+  //
+  // Default - 0
+  //
+  // 0 - Use fast LZ4 compression
+  // 1 to 9 - Use deflate compression at this level. Higher levels give smaller captures but
+  //          take longer to write
+  eRENDERDOC_Option_CompressionLevel = 12,
+
+  // Store resources' initial contents only once when several resources have identical contents,
+  // e.g. cleared render targets or default textures.
+  //
+  // Default - disabled
+  //
+  // 1 - Identical initial contents are stored once and referenced after that
+  // 0 - Each resource's initial contents are stored separately
+  eRENDERDOC_Option_DeduplicateInitialContents = 13,
+
+  // Write captures to disk on a background thread, so that the application can carry on
+  // rendering while the file is compressed and written. The capture only appears in the list of
+  // captures once it has been fully written.
+  //
+  // Note that if the process exits while a capture is still being written, it may be lost.
+  //
+  // Default - disabled
+  //
+  // 1 - Captures are written on a background thread
+  // 0 - Captures are written before the frame capture ends
+  eRENDERDOC_Option_WriteCapturesAsync = 14,
+
+  // The number of consecutive frames recorded into each capture. The frames share a single set of
+  // initial contents and are separated by their presents when replayed. This doesn't affect
+  // captures started and ended through the API.
+  //
+  // Default - 1
+  eRENDERDOC_Option_FramesPerCapture = 15,
+
+  // Track writes to persistently mapped coherent memory page by page, so that only the pages
+  // written to are saved at each submit. Applies to Vulkan and to OpenGL coherent buffer storage,
+  // and can't see writes made by the OS into mapped memory such as reading a file directly into it.
+  //
+  // Default - disabled
+  //
+  // 1 - Writes to coherent maps are tracked per-page
+  // 0 - Coherent maps are compared against a copy at each submit or sync point
+  eRENDERDOC_Option_TrackCoherentMapWrites = 16,
+
+  // Count the calls made to each API entry point and the time spent inside RenderDoc's wrapper for
+  // it, and show the most expensive entry points in the overlay. The same figures are sent to any
+  // connected target control client.
+  //
+  // Default - disabled
+  //
+  // 1 - Per entry point call counts and timings are recorded
+  // 0 - No per-call statistics are recorded
+  eRENDERDOC_Option_ProfileAPICalls = 17,
+
+  // Reduce the overhead of running under RenderDoc while no capture is pending. Vulkan command
+  // buffers begun while idle only track what's needed to stay correct, and tracking resumes when a
+  // capture is triggered, with the capture starting a few frames later. Command buffers recorded
+  // before the trigger and submitted in the captured frame will be missing from the capture.
+  //
+  // Default - disabled
+  //
+  // 1 - Command buffer recording is only fully tracked while a capture is pending
+  // 0 - Everything is tracked all the time, so any frame can be captured immediately
+  eRENDERDOC_Option_ReduceIdleOverhead = 18,
+
+  // Prepare the initial contents of resources ahead of time while no capture is in progress, a few
+  // resources each frame, so that starting a capture only needs to prepare what has been modified
+  // since. The value is the maximum size in megabytes of the GPU copies kept around for this.
+  // Applies to Vulkan and D3D11.
+  //
+  // Default - 0
+  //
+  // 0 - Initial contents are only prepared when a capture starts
+  // >0 - Up to this many megabytes of initial contents are prepared ahead of a capture
+  eRENDERDOC_Option_PrepareAheadBudget = 19,
+
+  // Compress image initial contents on the GPU before they're read back, so that large uniform
+  // regions like cleared render targets don't have to cross the bus. The contents are expanded
+  // again before being written, so captures are unaffected. Applies to Vulkan.
+  //
+  // Default - disabled
+  //
+  // 1 - Image initial contents are compressed on the GPU before being read back
+  // 0 - Image initial contents are read back as-is
+  eRENDERDOC_Option_CompressInitialContentsOnGPU = 20,
+
+  // Limit the size of the initial contents stored in a capture, in megabytes. When the budget is
+  // exceeded, texture contents are kept in order of priority - those read in the frame first, then
+  // those written, then the rest - and the textures left out are replaced with a cleared
+  // placeholder on replay.
+  //
+  // Default - 0
+  //
+  // 0 - No limit, all initial contents are stored
+  // >0 - Texture initial contents are kept within this many megabytes
+  eRENDERDOC_Option_InitialContentsBudget = 21,
+
+  // Automatically capture the frame after one that took longer than this many milliseconds, to
+  // catch rare hitches without anyone at the keyboard. The first frames after startup and after
+  // each capture are ignored, so loading and capturing don't trigger it.
+  //
+  // Default - 0
+  //
+  // 0 - Frame times don't trigger captures
+  // >0 - A frame taking longer than this many milliseconds triggers a capture of the next frame
+  eRENDERDOC_Option_FrameTimeTriggerMS = 22,
+
+  // Like eRENDERDOC_Option_FrameTimeTriggerMS, but relative to a rolling average of recent frame
+  // times instead of a fixed threshold. Both can be set at once, and either triggers a capture.
+  // The multiple can be fractional when set with SetCaptureOptionF32.
+  //
+  // Default - 0
+  //
+  // 0 - Frame times don't trigger captures
+  // >0 - A frame taking longer than this multiple of the average triggers a capture of the next
+  //      frame
+  eRENDERDOC_Option_FrameTimeTriggerMultiple = 23,
+
+  // Append every capture to one session file instead of writing each to its own file. Chunks that
+  // are identical between captures, such as resource creation, are stored only once, so captures
+  // taken later in a long session are cheap to write and store. A capture is only written out as
+  // a standalone file when it's needed, e.g. when it's retrieved over target control or through
+  // this API's GetCapture. Captures with callstacks are always written to their own file.
+  //
+  // Default - disabled
+  //
+  // 1 - Captures are appended to <logfile>_session.rdcs
+  // 0 - Each capture is written to its own file
+  eRENDERDOC_Option_AppendCapturesToSession = 24,
+
 } RENDERDOC_CaptureOption;
 
 // Sets an option that controls how RenderDoc behaves on capture.
@@ -144,6 +144,28 @@ struct array
     *this = o;
   }
 
+  // moving just takes ownership of the elements, leaving the source empty
+  array(array &&o)
+  {
+    elems = o.elems;
+    count = o.count;
+    o.elems = 0;
+    o.count = 0;
+  }
+
+  array &operator=(array &&o)
+  {
+    if(this == &o)
+      return *this;
+
+    Delete();
+    elems = o.elems;
+    count = o.count;
+    o.elems = 0;
+    o.count = 0;
+    return *this;
+  }
+
   array &operator=(const array &o)
   {
     // do nothing if we're self-assigning
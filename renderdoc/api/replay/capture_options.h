@@ -178,4 +178,174 @@ Default - enabled
 ``False`` - API debugging is displayed as normal.
 )");
   bool32 DebugOutputMute;
+
+  DOCUMENT(R"(How captures are compressed when written to disk.
+
+Default - 0
+
+``0`` - Use fast LZ4 compression.
+
+``1`` to ``9`` - Use deflate compression at this level. Higher levels give smaller captures but take
+longer to write.
+)");
+  uint32_t CompressionLevel;
+
+  DOCUMENT(R"(Store resources' initial contents only once when several resources have identical
+contents, such as cleared render targets or default textures.
+
+Default - disabled
+
+``True`` - Identical initial contents are stored once and referenced after that.
+
+``False`` - Each resource's initial contents are stored separately.
+)");
+  bool32 DeduplicateInitialContents;
+
+  DOCUMENT(R"(Write captures to disk on a background thread, so that the application can carry on
+rendering while the file is compressed and written. The capture only appears in the list of captures
+once it has been fully written.
+
+Note that if the process exits while a capture is still being written, it may be lost.
+
+Default - disabled
+
+``True`` - Captures are written on a background thread.
+
+``False`` - Captures are written before the frame capture ends.
+)");
+  bool32 WriteCapturesAsync;
+
+  DOCUMENT(R"(The number of consecutive frames recorded into each capture. The frames share a single
+set of initial contents and are separated by their presents when replayed.
+
+This only applies to captures triggered by a keypress or from the UI. Captures started and ended
+through the in-application API cover exactly what was bracketed.
+
+Default - 1
+)");
+  uint32_t FramesPerCapture;
+
+  DOCUMENT(R"(Track writes to persistently mapped coherent memory page by page, by write-protecting it
+and catching the first write to each page. Only the pages written to are then saved at each submit,
+instead of comparing the whole mapping against a copy.
+
+This applies to Vulkan coherent maps, and OpenGL buffers created with ``GL_MAP_COHERENT_BIT``
+storage. It can't see writes made by the operating system into mapped memory,
+such as reading a file directly into it.
+
+Default - disabled
+
+``True`` - Writes to coherent maps are tracked per-page.
+
+``False`` - Coherent maps are compared against a copy at each submit or sync point.
+)");
+  bool32 TrackCoherentMapWrites;
+
+  DOCUMENT(R"(Count the calls made to each API entry point and the time spent inside RenderDoc's
+wrapper for it, including the call into the driver. The most expensive entry points are shown in the
+overlay, and sent to any connected target control client as
+:data:`TargetControlMessageType.APICallStats` messages.
+
+This has a small overhead of its own on every API call while it's enabled.
+
+Default - disabled
+
+``True`` - Per entry point call counts and timings are recorded.
+
+``False`` - No per-call statistics are recorded.
+)");
+  bool32 ProfileAPICalls;
+
+  DOCUMENT(R"(Reduce the overhead of running under RenderDoc while no capture is pending. Only the
+resource creation and state needed to stay correct is tracked while idle - Vulkan command buffers
+begun with no capture pending don't record their commands.
+
+When a capture is triggered tracking resumes, and the capture starts a few frames later to give the
+application time to re-record its per-frame command buffers. Command buffers recorded before the
+trigger and submitted in the captured frame will be missing from the capture, so applications that
+pre-record command buffers once and re-submit them should leave this disabled.
+
+Default - disabled
+
+``True`` - Command buffer recording is only fully tracked while a capture is pending.
+
+``False`` - Everything is tracked all the time, so any frame can be captured immediately.
+)");
+  bool32 ReduceIdleOverhead;
+
+  DOCUMENT(R"(Prepare the initial contents of resources ahead of time while no capture is in
+progress, a few resources each frame, so that starting a capture only needs to prepare the
+resources modified since. This shortens the hitch when a capture is triggered.
+
+The value is the maximum size in megabytes of the GPU copies kept around for this. Resources that
+are modified every frame, and mapped Vulkan memory, are still prepared when the capture starts.
+
+Applies to Vulkan and D3D11.
+
+Default - 0, initial contents are only prepared when a capture starts.
+)");
+  uint32_t PrepareAheadBudget;
+
+  DOCUMENT(R"(Compress image initial contents on the GPU before they're read back, so that large
+uniform regions such as cleared render targets don't have to be copied across the bus. This helps
+when reading back from the GPU is slow, e.g. with a remote GPU.
+
+The contents are expanded again before they're written, so the capture is the same either way.
+
+Applies to Vulkan.
+
+Default - disabled
+
+``True`` - Image initial contents are compressed on the GPU before being read back.
+
+``False`` - Image initial contents are read back as-is.
+)");
+  bool32 CompressInitialContentsOnGPU;
+
+  DOCUMENT(R"(Limit the size of texture initial contents stored in a capture, in megabytes. This
+keeps captures of applications with very large amounts of texture memory to a manageable size.
+
+When the budget is exceeded textures are kept in order of priority: first those read in the frame
+before being written, then those written, then those only read, then anything else. Textures that
+don't fit are replaced with a cleared placeholder on replay, and are marked with
+:data:`TextureDescription.placeholderInitialContents`.
+
+Applies to Vulkan and D3D11.
+
+Default - 0, all initial contents are stored.
+)");
+  uint32_t InitialContentsBudget;
+
+  DOCUMENT(R"(Automatically capture the frame after one that took longer than this many
+milliseconds. This catches rare hitches during long unattended runs such as soak tests.
+
+The first frames after the application starts and after each capture are ignored, so that loading
+and the time spent capturing aren't mistaken for hitches.
+
+Default - 0, frame times don't trigger captures.
+)");
+  uint32_t FrameTimeTriggerMS;
+
+  DOCUMENT(R"(Automatically capture the frame after one that took longer than this multiple of
+the rolling average frame time. This works like :data:`FrameTimeTriggerMS` but adapts to how fast
+the application normally runs, and can be fractional, e.g. 1.5. If both are set, either one
+triggers a capture.
+
+Default - 0, frame times don't trigger captures.
+)");
+  float FrameTimeTriggerMultiple;
+
+  DOCUMENT(R"(Append every capture to one session file instead of writing each to its own file.
+Chunks that are identical between captures, such as resource creation, are stored only once, so
+captures taken minutes apart in a long-running session stay cheap to write and store.
+
+A capture is written out as a standalone file only when something needs it, such as retrieving it
+over target control. Captures can also be extracted from the session file later with
+:func:`ExtractSessionCapture`.
+
+Captures with :data:`CaptureCallstacks` enabled are always written to their own file.
+
+Default - Disabled
+)");
+  bool32 AppendCapturesToSession;
 };
@@ -28,6 +28,12 @@
 #include "data_types.h"
 #include "replay_enums.h"
 
+// the pipeline state headers rely on the types above already being declared
+#include "d3d11_pipestate.h"
+#include "d3d12_pipestate.h"
+#include "gl_pipestate.h"
+#include "vk_pipestate.h"
+
 DOCUMENT(R"(
 Contains the details of a single element of data (such as position or texture
 co-ordinates) within a mesh.)");
@@ -280,6 +286,35 @@ the input texture in cases where it isn't easy to directly fetch the input textu
 
 DECLARE_REFLECTION_STRUCT(TextureDisplay);
 
+DOCUMENT(R"(A pixel pick requested with :meth:`ReplayOutput.RequestPickPixel`, and its result once
+it has been made.
+)");
+struct PixelPick
+{
+  DOCUMENT("``True`` if a pick has been made and :data:`value` is valid.");
+  bool32 valid;
+
+  DOCUMENT("The :class:`ResourceId` of the texture the pixel was picked from.");
+  ResourceId texID;
+  DOCUMENT("``True`` if the configured custom shader was applied.");
+  bool32 customShader;
+  DOCUMENT("The x co-ordinate the pixel was picked from.");
+  uint32_t x;
+  DOCUMENT("The y co-ordinate the pixel was picked from.");
+  uint32_t y;
+  DOCUMENT("The slice of an array or 3D texture, or face of a cubemap texture.");
+  uint32_t sliceFace;
+  DOCUMENT("The mip level the pixel was picked from.");
+  uint32_t mip;
+  DOCUMENT("The multisample sample the pixel was picked from.");
+  uint32_t sample;
+
+  DOCUMENT("The :class:`PixelValue` contents of the pixel.");
+  PixelValue value;
+};
+
+DECLARE_REFLECTION_STRUCT(PixelPick);
+
 // some dependent structs for TextureSave
 DOCUMENT("How to map components to normalised ``[0, 255]`` for saving to 8-bit file formats.");
 struct TextureComponentMapping
@@ -422,6 +457,127 @@ It is an :class:`AlphaMapping` that controls what behaviour to use. :data:`alpha
 
 DECLARE_REFLECTION_STRUCT(TextureSave);
 
+DOCUMENT(R"(The differences between two textures, as calculated by
+:meth:`ReplayController.CompareTextures`.
+
+Errors are the absolute difference in each channel once both textures have been converted to
+floating point, so normalised formats are compared in the ``0.0`` to ``1.0`` range.
+)");
+struct TextureDiff
+{
+  DOCUMENT(R"(The :class:`ResourceId` of a ``RGBA32`` floating point texture holding the absolute
+difference in each channel. It can be displayed with :class:`TextureDisplay` like any other texture,
+and is reused by later comparisons of the same size.
+)");
+  ResourceId diffTexture;
+
+  DOCUMENT("The number of pixels that were compared.");
+  uint64_t totalPixels;
+
+  DOCUMENT("The number of pixels where any channel differed by more than the threshold.");
+  uint64_t changedPixels;
+
+  DOCUMENT("A :class:`FloatVector` with the largest error in each channel.");
+  FloatVector maxError;
+
+  DOCUMENT("A :class:`FloatVector` with the mean error in each channel, over all pixels.");
+  FloatVector meanError;
+
+  DOCUMENT("The left edge of the rectangle bounding all changed pixels.");
+  uint32_t changedX;
+  DOCUMENT("The top edge of the rectangle bounding all changed pixels.");
+  uint32_t changedY;
+  DOCUMENT("The width of the rectangle bounding all changed pixels, or ``0`` if none changed.");
+  uint32_t changedWidth;
+  DOCUMENT("The height of the rectangle bounding all changed pixels, or ``0`` if none changed.");
+  uint32_t changedHeight;
+};
+
+DECLARE_REFLECTION_STRUCT(TextureDiff);
+
+DOCUMENT("A texture or buffer used by an event, as part of :class:`EventData`.");
+struct EventResourceUsage
+{
+  DOCUMENT("The :class:`ResourceId` of the texture or buffer.");
+  ResourceId resourceId;
+
+  DOCUMENT("The :class:`ResourceUsage` describing how the event uses it.");
+  ResourceUsage usage = ResourceUsage::Unused;
+};
+
+DECLARE_REFLECTION_STRUCT(EventResourceUsage);
+
+DOCUMENT("The contents of a constant block read by an event, as part of :class:`EventData`.");
+struct EventConstantBlock
+{
+  DOCUMENT("The :class:`ShaderStage` whose shader reads the constant block.");
+  ShaderStage stage = ShaderStage::Vertex;
+
+  DOCUMENT(R"(The index of the constant block in the shader's
+:data:`ShaderReflection.ConstantBlocks`.
+)");
+  uint32_t slot = 0;
+
+  DOCUMENT(R"(The :class:`ResourceId` of the buffer the contents are read from, or an empty ID if
+the block isn't backed by a buffer.
+)");
+  ResourceId buffer;
+
+  DOCUMENT("The byte offset of the bound range in :data:`buffer`.");
+  uint64_t byteOffset = 0;
+
+  DOCUMENT("The byte size of the bound range in :data:`buffer`.");
+  uint64_t byteSize = 0;
+
+  DOCUMENT(R"(The contents of the constant block, as returned by
+:meth:`ReplayController.GetCBufferVariableContents`.
+
+:type: ``list`` of :class:`ShaderVariable`
+)");
+  rdctype::array<ShaderVariable> variables;
+};
+
+DECLARE_REFLECTION_STRUCT(EventConstantBlock);
+
+DOCUMENT(R"(The data gathered for a single event by :meth:`ReplayController.GetEventData`. Only
+the members selected by the :class:`EventDataFlags` passed are filled in, the rest are empty.
+)");
+struct EventData
+{
+  DOCUMENT("The :data:`EID <APIEvent.eventID>` the data was gathered at.");
+  uint32_t eventID = 0;
+
+  DOCUMENT("The :class:`D3D11_State` at the event, if the capture is D3D11.");
+  D3D11Pipe::State d3d11;
+  DOCUMENT("The :class:`D3D12_State` at the event, if the capture is D3D12.");
+  D3D12Pipe::State d3d12;
+  DOCUMENT("The :class:`GL_State` at the event, if the capture is OpenGL.");
+  GLPipe::State gl;
+  DOCUMENT("The :class:`VK_State` at the event, if the capture is Vulkan.");
+  VKPipe::State vulkan;
+
+  DOCUMENT(R"(The textures and buffers used by the event.
+
+:type: ``list`` of :class:`EventResourceUsage`
+)");
+  rdctype::array<EventResourceUsage> resources;
+
+  DOCUMENT(R"(The contents of the constant blocks read by each bound shader.
+
+:type: ``list`` of :class:`EventConstantBlock`
+)");
+  rdctype::array<EventConstantBlock> constantBlocks;
+
+  DOCUMENT(R"(The results of the requested counters for the event. Counters that don't apply to
+the event have no result.
+
+:type: ``list`` of :class:`CounterResult`
+)");
+  rdctype::array<CounterResult> counters;
+};
+
+DECLARE_REFLECTION_STRUCT(EventData);
+
 // dependent structs for TargetControlMessage
 DOCUMENT("Information about the a new capture created by the target.");
 struct NewCaptureData
@@ -432,9 +588,13 @@ struct NewCaptureData
   uint64_t timestamp;
   DOCUMENT("The raw bytes that contain the capture thumbnail, as a JPG.");
   rdctype::array<byte> thumbnail;
-  DOCUMENT("The local path on the target system where the capture is saved.");
+  DOCUMENT(R"(The local path on the target system where the capture is saved, or the path of this
+system's copy if it was streamed while it was being written.
+)");
   rdctype::str path;
-  DOCUMENT("``True`` if the target is running on the local system.");
+  DOCUMENT(R"(``True`` if :data:`path` is on the local system, either because the target is running
+on the local system or because the capture was streamed to it.
+)");
   bool32 local;
 };
 
@@ -469,6 +629,50 @@ struct NewChildData
 
 DECLARE_REFLECTION_STRUCT(NewChildData);
 
+DOCUMENT("How often the target has called one API entry point, and how long those calls took.");
+struct APICallStat
+{
+  DOCUMENT("The name of the entry point.");
+  rdctype::str name;
+  DOCUMENT("The number of times the entry point has been called.");
+  uint64_t count;
+  DOCUMENT(R"(The total time spent inside RenderDoc's wrapper for the entry point, including the
+call into the driver, in milliseconds.
+)");
+  double milliseconds;
+};
+
+DECLARE_REFLECTION_STRUCT(APICallStat);
+
+DOCUMENT(R"(A periodic snapshot of how the target is running, and what capturing is costing it.
+
+The frame times are over the most recent full second of frames.
+)");
+struct TargetTelemetry
+{
+  DOCUMENT("The shortest frame time, in milliseconds.");
+  double frameTimeMin;
+  DOCUMENT("The average frame time, in milliseconds.");
+  double frameTimeAvg;
+  DOCUMENT("The longest frame time, in milliseconds.");
+  double frameTimeMax;
+  DOCUMENT(R"(The time spent inside RenderDoc's API wrappers since the previous snapshot, in
+milliseconds. This includes the calls into the driver, and is only measured while
+:data:`CaptureOptions.ProfileAPICalls` is enabled, otherwise it is ``0``.
+)");
+  double apiMilliseconds;
+  DOCUMENT("The number of recorded chunks currently in memory.");
+  uint64_t liveChunks;
+  DOCUMENT("The number of bytes held by recorded chunks currently in memory.");
+  uint64_t chunkBytes;
+  DOCUMENT(R"(The number of bytes in RenderDoc's aligned buffers. These back the chunk pages, the
+shadow copies of mapped memory and the initial contents of resources.
+)");
+  uint64_t bufferBytes;
+};
+
+DECLARE_REFLECTION_STRUCT(TargetTelemetry);
+
 DOCUMENT("A message from a target control connection.");
 struct TargetControlMessage
 {
@@ -484,6 +688,16 @@ struct TargetControlMessage
   BusyData Busy;
   DOCUMENT("The :class:`new child process data <NewChild>`.");
   NewChildData NewChild;
+  DOCUMENT(R"(The fraction of the capture being written in the background that is done, from ``0.0``
+to ``1.0``. A :data:`TargetControlMessageType.NewCapture` message follows when it's finished.
+)");
+  float CaptureProgress;
+  DOCUMENT(R"(The :class:`APICallStat` for the most expensive entry points the target has called so
+far, most expensive first.
+)");
+  rdctype::array<APICallStat> APICallStats;
+  DOCUMENT("The latest :class:`TargetTelemetry` sent by the target.");
+  TargetTelemetry Telemetry;
 };
 
 DECLARE_REFLECTION_STRUCT(TargetControlMessage);
@@ -148,6 +148,20 @@ based on the ID.
 
   DOCUMENT("The byte length of the buffer.");
   uint64_t length;
+
+  DOCUMENT(R"(The size in bytes of the memory allocation the replay driver needs for this buffer,
+including any padding the driver adds. If the API doesn't report allocation sizes this is an estimate
+based on the length.
+)");
+  uint64_t allocationSize;
+
+  DOCUMENT("The alignment in bytes that the allocation requires, or 0 if it's not known.");
+  uint64_t allocationAlignment;
+
+  DOCUMENT(R"(A human readable description of the heap or memory type that backs this buffer, or an
+empty string if it's not known.
+)");
+  rdctype::str memoryType;
 };
 
 DECLARE_REFLECTION_STRUCT(BufferDescription);
@@ -204,6 +218,26 @@ based on the ID.
 
   DOCUMENT("How many bytes would be used to store this texture and all its mips/slices.");
   uint64_t byteSize;
+
+  DOCUMENT(R"(``True`` if this texture's initial contents were left out of the capture to keep it
+within :data:`CaptureOptions.InitialContentsBudget`. The texture starts the frame cleared instead of
+with the contents it had when the capture was made.
+)");
+  bool32 placeholderInitialContents;
+
+  DOCUMENT(R"(The size in bytes of the memory allocation the replay driver needs for this texture,
+including any padding the driver adds. If the API doesn't report allocation sizes this is an estimate
+based on the :data:`byteSize`.
+)");
+  uint64_t allocationSize;
+
+  DOCUMENT("The alignment in bytes that the allocation requires, or 0 if it's not known.");
+  uint64_t allocationAlignment;
+
+  DOCUMENT(R"(A human readable description of the heap or memory type that backs this texture, or an
+empty string if it's not known.
+)");
+  rdctype::str memoryType;
 };
 
 DECLARE_REFLECTION_STRUCT(TextureDescription);
@@ -211,6 +245,7 @@ DECLARE_REFLECTION_STRUCT(TextureDescription);
 DOCUMENT("An individual API-level event, generally corresponds one-to-one with an API call.");
 struct APIEvent
 {
+  APIEvent() : eventID(0), fileOffset(0), cpuTimestamp(0), threadID(0) {}
   DOCUMENT(R"(The API event's Event ID (EID).
 
 This is a 1-based count of API events in the capture. The EID is used as a reference point in
@@ -230,7 +265,11 @@ results part way through the multi draw.
   DOCUMENT("A list of addresses in the CPU callstack where this function was called.");
   rdctype::array<uint64_t> callstack;
 
-  DOCUMENT("A raw debug string with the serialised form of the function call parameters.");
+  DOCUMENT(R"(The name of the function call.
+
+The serialised parameters are fetched separately with
+:meth:`ReplayController.GetEventParameters`.
+)");
   rdctype::str eventDesc;
 
   DOCUMENT(R"(A byte offset in the data stream where this event happens.
@@ -239,6 +278,26 @@ results part way through the multi draw.
   the start of the file on disk.
 )");
   uint64_t fileOffset;
+
+  DOCUMENT(R"(The time in microseconds when the application made this call while it was being captured,
+relative to the first event in the frame.
+
+.. note:: This is CPU time on the capturing machine and it is only available for captures that
+  recorded a CPU timeline, otherwise it is 0.
+)");
+  uint64_t cpuTimestamp;
+
+  DOCUMENT(R"(An opaque identifier of the application thread that made this call, or 0 if the capture
+didn't record it. It is only meaningful for comparing against other events' thread IDs.
+)");
+  uint64_t threadID;
+
+  DOCUMENT(R"(The resources this call referenced in its parameters, such as buffers, textures,
+views, shaders, pipelines or command buffers. Each resource is only listed once per call.
+
+:class:`ReplayController.FindEventsReferencing` can be used to look this up in reverse.
+)");
+  rdctype::array<ResourceId> referencedResources;
 };
 
 DECLARE_REFLECTION_STRUCT(APIEvent);
@@ -640,11 +699,58 @@ struct FrameStatistics
 
 DECLARE_REFLECTION_STRUCT(FrameStatistics);
 
+DOCUMENT(R"(Describes the span of CPU time that one application thread spent issuing the calls in a
+frame, while it was being captured.
+)");
+struct ThreadTimeline
+{
+  DOCUMENT("The :data:`APIEvent.threadID` of the thread.");
+  uint64_t threadID;
+
+  DOCUMENT("The :data:`APIEvent.cpuTimestamp` of the thread's first event in the frame.");
+  uint64_t begin;
+
+  DOCUMENT("The :data:`APIEvent.cpuTimestamp` of the thread's last event in the frame.");
+  uint64_t end;
+
+  DOCUMENT("The number of events the thread issued in the frame.");
+  uint32_t numEvents;
+};
+
+DECLARE_REFLECTION_STRUCT(ThreadTimeline);
+
+DOCUMENT(R"(Describes one submission of work to a queue in a frame, such as a ``vkQueueSubmit`` or
+``ExecuteCommandLists``. The drawcall tree lists every queue's work in the order it was submitted,
+these show which queue each part of it went to.
+)");
+struct QueueSubmission
+{
+  DOCUMENT("The :class:`ResourceId` of the queue the work was submitted to.");
+  ResourceId queue;
+
+  DOCUMENT("The :class:`QueueType` of the queue.");
+  QueueType type;
+
+  DOCUMENT("The :data:`EID <APIEvent.eventID>` of the submission.");
+  uint32_t eventID;
+
+  DOCUMENT("The last :data:`EID <APIEvent.eventID>` of the work in the submission.");
+  uint32_t lastEventID;
+
+  DOCUMENT(R"(The number of semaphores or fences the queue waited on before this submission could
+start.
+)");
+  uint32_t waits;
+};
+
+DECLARE_REFLECTION_STRUCT(QueueSubmission);
+
 DOCUMENT("Contains frame-level global information");
 struct FrameDescription
 {
   FrameDescription()
       : frameNumber(0),
+        frameCount(1),
         fileOffset(0),
         uncompressedFileSize(0),
         compressedFileSize(0),
@@ -662,6 +768,12 @@ this counts the frame number when the capture was made.
 )");
   uint32_t frameNumber;
 
+  DOCUMENT(R"(The number of consecutive frames recorded in the capture, starting at
+:data:`frameNumber`. Every frame ends with a drawcall flagged as :data:`DrawFlags.Present`, which
+marks the boundaries between them in the drawcall list.
+)");
+  uint32_t frameCount;
+
   DOCUMENT(R"(The offset into the file of the start of the frame.
 
 .. note:: Similarly to :data:`APIEvent.fileOffset` this should only be used as a relative measure,
@@ -689,6 +801,16 @@ this counts the frame number when the capture was made.
 
   DOCUMENT("A list of debug messages that are not associated with any particular event.");
   rdctype::array<DebugMessage> debugMessages;
+
+  DOCUMENT(R"(A list of :class:`ThreadTimeline` with the span of CPU time each application thread
+spent issuing calls in the frame. This is empty if the capture didn't record a CPU timeline.
+)");
+  rdctype::array<ThreadTimeline> threadTimelines;
+
+  DOCUMENT(R"(A list of :class:`QueueSubmission` in the order they were submitted, or empty if the
+API only has a single implicit queue.
+)");
+  rdctype::array<QueueSubmission> queueSubmissions;
 };
 
 DECLARE_REFLECTION_STRUCT(FrameDescription);
@@ -848,6 +970,81 @@ for very coarse bucketing of drawcalls into similar passes by their outputs.
 
 DECLARE_REFLECTION_STRUCT(DrawcallDescription);
 
+DOCUMENT(R"(A compact description of a drawcall, as stored in a :class:`FlatDrawcallList`.
+
+The tree structure is expressed with indices into the list instead of nested child lists.
+)");
+struct FlatDrawcall
+{
+  DOCUMENT("The :data:`EID <APIEvent.eventID>` that actually produced the drawcall.");
+  uint32_t eventID;
+  DOCUMENT(R"(The last :data:`EID <APIEvent.eventID>` covered by this drawcall. For drawcalls with
+children, this is the last EID of its children. For a set marker it's the EID of the next drawcall
+at the same level, if there is one. Otherwise it's the drawcall's own EID.
+)");
+  uint32_t lastEventID;
+  DOCUMENT("A 1-based index of this drawcall relative to other drawcalls.");
+  uint32_t drawcallID;
+  DOCUMENT("A set of :class:`DrawFlags` properties describing what kind of drawcall this is.");
+  DrawFlags flags;
+  DOCUMENT("A RGBA colour specified by a debug marker call.");
+  float markerColor[4];
+
+  DOCUMENT("The index of this drawcall's parent in the list, or ``-1`` for a root-level drawcall.");
+  int32_t parent;
+  DOCUMENT("The index of this drawcall's first child in the list, or ``-1`` if it has none.");
+  int32_t firstChild;
+  DOCUMENT("The index of the next drawcall with the same parent, or ``-1`` if this is the last.");
+  int32_t nextSibling;
+
+  DOCUMENT(R"(The offset of this drawcall's NULL-terminated name in :data:`FlatDrawcallList.names`.
+Drawcalls with the same name share the same offset.
+)");
+  uint32_t nameOffset;
+};
+
+DECLARE_REFLECTION_STRUCT(FlatDrawcall);
+
+DOCUMENT(R"(All of the drawcalls in a capture as one flat list, in the same order as a depth-first
+walk of the :class:`DrawcallDescription` tree. The names are stored once each in a shared pool.
+
+The list can be accessed by index without copying, using :meth:`Count`, :meth:`Get` and
+:meth:`Name`. It's owned by the :class:`ReplayController` and doesn't change until it's shut down.
+)");
+struct FlatDrawcallList
+{
+  DOCUMENT(R"(Get the number of drawcalls in the list.
+
+:return: The number of drawcalls.
+:rtype: int
+)");
+  int32_t Count() const { return draws.count; }
+  DOCUMENT(R"(Get a drawcall by its index in the list.
+
+:param int index: The index of the drawcall. The first root-level drawcall is at index ``0``.
+:return: The drawcall.
+:rtype: FlatDrawcall
+)");
+  const FlatDrawcall &Get(int32_t index) const { return draws[index]; }
+  DOCUMENT(R"(Get the name of a drawcall by its index in the list.
+
+:param int index: The index of the drawcall.
+:return: The name of the drawcall.
+:rtype: str
+)");
+  const char *Name(int32_t index) const { return names.elems + draws[index].nameOffset; }
+
+  DOCUMENT(R"(The list of :class:`FlatDrawcall` drawcalls.
+
+.. note:: Accessing this from python copies the whole list. Use :meth:`Get` instead.
+)");
+  rdctype::array<FlatDrawcall> draws;
+  DOCUMENT("The pool of all distinct drawcall names, separated by NULL characters.");
+  rdctype::str names;
+};
+
+DECLARE_REFLECTION_STRUCT(FlatDrawcallList);
+
 DOCUMENT("Gives some API-specific information about the capture.");
 struct APIProperties
 {
@@ -962,6 +1159,464 @@ struct CounterResult
 
 DECLARE_REFLECTION_STRUCT(CounterResult);
 
+DOCUMENT(R"(The spread of values from a counter at an event, gathered over several replays of the
+capture.
+)");
+struct CounterStatistics
+{
+  CounterStatistics()
+      : eventID(0),
+        counterID(GPUCounter::EventGPUDuration),
+        samples(0),
+        minimum(0.0),
+        median(0.0),
+        mean(0.0),
+        stddev(0.0)
+  {
+  }
+
+  DOCUMENT("Compares two ``CounterStatistics`` objects for less-than.");
+  bool operator<(const CounterStatistics &o) const
+  {
+    if(eventID != o.eventID)
+      return eventID < o.eventID;
+    return counterID < o.counterID;
+  }
+
+  DOCUMENT("The :data:`EID <APIEvent.eventID>` that produced these values.");
+  uint32_t eventID;
+
+  DOCUMENT("The :data:`counter <GPUCounter>` that produced these values.");
+  GPUCounter counterID;
+
+  DOCUMENT("The number of replays that produced a value for this counter at this event.");
+  uint32_t samples;
+
+  DOCUMENT("The smallest value seen in any replay.");
+  double minimum;
+
+  DOCUMENT("The median of the values seen across all replays.");
+  double median;
+
+  DOCUMENT("The arithmetic mean of the values seen across all replays.");
+  double mean;
+
+  DOCUMENT("The standard deviation of the values seen across all replays.");
+  double stddev;
+};
+
+DECLARE_REFLECTION_STRUCT(CounterStatistics);
+
+DOCUMENT(R"(An estimate of the memory traffic of a single event, as returned by
+:meth:`ReplayController.GetDrawcallBandwidth`.
+
+The estimate is built from the sizes and formats of the resources the event uses, the blend and
+depth state, and the vertex, pixel and compute invocation counts where the hardware reports them. It
+ignores caches and compression, so it's best used to compare events against each other rather than
+as an absolute measurement.
+)");
+struct DrawcallBandwidth
+{
+  DOCUMENT("The :data:`EID <APIEvent.eventID>` of the event.");
+  uint32_t eventID = 0;
+
+  DOCUMENT("The bytes of index and vertex data fetched.");
+  uint64_t vertexBytes = 0;
+
+  DOCUMENT(R"(The bytes read from textures, buffers and constants by shaders, or from the source
+of a copy or resolve.
+)");
+  uint64_t resourceReadBytes = 0;
+
+  DOCUMENT(R"(The bytes read back from the resources being written, for blending, depth testing and
+read-write resources.
+)");
+  uint64_t targetReadBytes = 0;
+
+  DOCUMENT(R"(The bytes written to render targets, the depth target, read-write resources, or the
+destination of a clear, copy or resolve.
+)");
+  uint64_t targetWriteBytes = 0;
+
+  DOCUMENT("The total estimated bytes read, from all of the sources above.");
+  uint64_t bytesRead = 0;
+
+  DOCUMENT("The total estimated bytes written.");
+  uint64_t bytesWritten = 0;
+};
+
+DECLARE_REFLECTION_STRUCT(DrawcallBandwidth);
+
+DOCUMENT(R"(The likely bottleneck of a single drawcall or dispatch, as part of a
+:class:`PassBottleneck`.
+
+Each kind of work is scored in instruction-equivalents, from the pipeline statistics where the
+driver has them, the :class:`DrawcallShaderCost` of the bound shaders and the
+:class:`DrawcallBandwidth` estimate. The :data:`limiter` is whichever scores highest, unless the event is small enough that
+it's dominated by fixed overhead.
+)");
+struct DrawcallBottleneck
+{
+  DOCUMENT("The :data:`EID <APIEvent.eventID>` of the drawcall or dispatch.");
+  uint32_t eventID = 0;
+
+  DOCUMENT("The :class:`Bottleneck` that most likely limits this event.");
+  Bottleneck limiter = Bottleneck::Overhead;
+
+  DOCUMENT(R"(The GPU duration of the event in seconds, or ``0.0`` if the driver doesn't support
+:data:`GPUCounter.EventGPUDuration`.
+)");
+  double duration = 0.0;
+
+  DOCUMENT("The vertex shader invocations.");
+  uint64_t vertexInvocations = 0;
+
+  DOCUMENT("The pixel shader invocations, or ``0`` if the driver can't count them.");
+  uint64_t pixelInvocations = 0;
+
+  DOCUMENT("The compute shader invocations, for a dispatch.");
+  uint64_t computeInvocations = 0;
+
+  DOCUMENT("The primitives rasterized, or ``0`` if the driver can't count them.");
+  uint64_t rasterizedPrimitives = 0;
+
+  DOCUMENT("The samples that passed the depth and stencil tests, or ``0`` if unknown.");
+  uint64_t samplesWritten = 0;
+
+  DOCUMENT("The estimated bytes read and written, see :class:`DrawcallBandwidth`.");
+  uint64_t bytes = 0;
+
+  DOCUMENT("The score for vertex work, see :data:`Bottleneck.Vertex`.");
+  double vertexWork = 0.0;
+
+  DOCUMENT("The score for fragment shading, see :data:`Bottleneck.Fragment`.");
+  double fragmentWork = 0.0;
+
+  DOCUMENT("The score for writing samples, see :data:`Bottleneck.Fill`.");
+  double fillWork = 0.0;
+
+  DOCUMENT("The score for memory traffic, see :data:`Bottleneck.Bandwidth`.");
+  double bandwidthWork = 0.0;
+
+  DOCUMENT("The score for compute shading, see :data:`Bottleneck.Compute`.");
+  double computeWork = 0.0;
+};
+
+DECLARE_REFLECTION_STRUCT(DrawcallBottleneck);
+
+DOCUMENT(R"(The drawcalls and dispatches of one pass through the frame and what limits them, as
+returned by :meth:`ReplayController.AnalyseBottlenecks`.
+
+A pass is the marker region or other parent node that contains the events. Events at the top level
+of the frame are grouped into runs that write to the same targets.
+)");
+struct PassBottleneck
+{
+  DOCUMENT("The first :data:`EID <APIEvent.eventID>` in the pass.");
+  uint32_t eventID = 0;
+
+  DOCUMENT("The last :data:`EID <APIEvent.eventID>` in the pass.");
+  uint32_t lastEventID = 0;
+
+  DOCUMENT("The name of the marker region, or a description of the events for unmarked passes.");
+  rdctype::str name;
+
+  DOCUMENT(R"(The :class:`Bottleneck` limiting the largest share of the pass's cost, weighted by
+duration where it's available.
+)");
+  Bottleneck limiter = Bottleneck::Overhead;
+
+  DOCUMENT(R"(The total GPU duration of the pass in seconds, or ``0.0`` if the driver doesn't
+support :data:`GPUCounter.EventGPUDuration`.
+)");
+  double duration = 0.0;
+
+  DOCUMENT("The total of the highest score of each event, used to rank passes without durations.");
+  double work = 0.0;
+
+  DOCUMENT("The list of :class:`DrawcallBottleneck` in the pass, most expensive first.");
+  rdctype::array<DrawcallBottleneck> draws;
+};
+
+DECLARE_REFLECTION_STRUCT(PassBottleneck);
+
+DOCUMENT(R"(How efficiently an indexed drawcall's indices use the post-transform vertex cache, as
+returned by :meth:`ReplayController.GetIndexEfficiency`.
+
+The cache is simulated twice - as a 16-entry FIFO, like most fixed-function hardware, and as a
+32-entry LRU. Real hardware varies, so the two models give a range to compare draws against rather
+than an exact count of vertex shader invocations.
+
+A well ordered triangle list has an ACMR of around ``0.6`` to ``0.7``, while ``3.0`` means no vertex
+is reused at all.
+)");
+struct IndexEfficiency
+{
+  DOCUMENT("The :data:`EID <APIEvent.eventID>` of the drawcall.");
+  uint32_t eventID = 0;
+
+  DOCUMENT("The :class:`ResourceId` of the index buffer.");
+  ResourceId indexBuffer;
+
+  DOCUMENT("The offset in bytes of the first index in the buffer.");
+  uint64_t byteOffset = 0;
+
+  DOCUMENT("The number of indices drawn.");
+  uint32_t numIndices = 0;
+
+  DOCUMENT(R"(The triangles drawn, not counting instancing. Strips are cut at an index with all bits
+set, for the index width.
+)");
+  uint32_t triangles = 0;
+
+  DOCUMENT("The triangles with two or more identical indices, which are never rasterized.");
+  uint32_t degenerateTriangles = 0;
+
+  DOCUMENT("The number of distinct vertices referenced.");
+  uint32_t uniqueVertices = 0;
+
+  DOCUMENT("The smallest index referenced.");
+  uint32_t minIndex = 0;
+
+  DOCUMENT("The largest index referenced.");
+  uint32_t maxIndex = 0;
+
+  DOCUMENT(R"(The fraction of the vertices between :data:`minIndex` and :data:`maxIndex` that are
+referenced. Vertices in that range are usually fetched or transformed whether they're used or not.
+)");
+  float referencedFraction = 0.0f;
+
+  DOCUMENT(R"(The Average Cache Miss Ratio of the FIFO cache - the vertices transformed per
+triangle.
+)");
+  float fifoACMR = 0.0f;
+
+  DOCUMENT("The Average Cache Miss Ratio of the LRU cache.");
+  float lruACMR = 0.0f;
+
+  DOCUMENT(R"(The Average Transform to Vertex Ratio of the LRU cache - how many times each vertex
+is transformed on average. ``1.0`` is optimal.
+)");
+  float lruATVR = 0.0f;
+};
+
+DECLARE_REFLECTION_STRUCT(IndexEfficiency);
+
+DOCUMENT(R"(The parts of one mip of a texture that were sampled, in a
+:class:`TextureSamplingFeedback`.
+
+The mip is divided into a grid of :data:`TextureSamplingFeedback.gridSize` by ``gridSize`` tiles in
+normalised texture coordinates, so the tiles of every mip cover the same region of the texture.
+Coordinates outside ``[0, 1]`` are wrapped into that range, whatever the sampler's address mode.
+)");
+struct SampledMip
+{
+  DOCUMENT("The mip level.");
+  uint32_t mip = 0;
+
+  DOCUMENT("The number of tiles in this mip that were sampled at least once.");
+  uint32_t numTilesSampled = 0;
+
+  DOCUMENT(R"(A bitmask of the sampled tiles, 32 tiles to each element. The tile at ``(x, y)`` is
+bit ``(y * gridSize + x) % 32`` of element ``(y * gridSize + x) / 32``.
+)");
+  rdctype::array<uint32_t> tiles;
+};
+
+DECLARE_REFLECTION_STRUCT(SampledMip);
+
+DOCUMENT(R"(Which mips and regions of a texture were sampled over a range of events, as returned by
+:meth:`ReplayController.GetTextureSampling`.
+
+The mip is the level the sampler selects for each sample, before any filtering between levels, so a
+trilinear sample also reads from the next mip. Only samples from fragment shaders of 2D and 2D array
+textures that are bound directly, or with a constant index into an array of bindings, are recorded.
+)");
+struct TextureSamplingFeedback
+{
+  DOCUMENT("The :class:`ResourceId` of the texture.");
+  ResourceId resourceId;
+
+  DOCUMENT("The number of tiles across and down each mip.");
+  uint32_t gridSize = 0;
+
+  DOCUMENT(R"(The sampled mips in ascending order, as a ``list`` of :class:`SampledMip`. Mips that
+were never sampled are left out.
+)");
+  rdctype::array<SampledMip> mips;
+};
+
+DECLARE_REFLECTION_STRUCT(TextureSamplingFeedback);
+
+DOCUMENT(R"(A region of the frame in a GPU duration timeline, as returned by
+:meth:`ReplayController.GetDurationTimeline`.
+
+Regions are laid out end to end at each depth, starting from the beginning of the frame. A marker
+region covers the same time as all of its children together.
+)");
+struct TimelineRegion
+{
+  DOCUMENT(R"(The index of the drawcall in the :class:`FlatDrawcallList` that this region covers, or
+``-1`` if the region is a run of several small drawcalls merged together.
+)");
+  int32_t drawIndex;
+
+  DOCUMENT("The first :data:`EID <APIEvent.eventID>` covered by this region.");
+  uint32_t eventID;
+
+  DOCUMENT("The last :data:`EID <APIEvent.eventID>` covered by this region.");
+  uint32_t lastEventID;
+
+  DOCUMENT("How deeply nested the region is in the marker hierarchy, ``0`` for root-level regions.");
+  uint32_t depth;
+
+  DOCUMENT("The number of drawcalls without children whose durations are included in this region.");
+  uint32_t numEvents;
+
+  DOCUMENT(R"(``True`` if this region lies on the critical path - the most expensive region among its
+siblings, inside a parent that is also on the critical path.
+)");
+  bool32 critical;
+
+  DOCUMENT("The time in seconds from the start of the frame to the start of this region.");
+  double start;
+
+  DOCUMENT("The total GPU duration of this region in seconds.");
+  double duration;
+};
+
+DECLARE_REFLECTION_STRUCT(TimelineRegion);
+
+DOCUMENT(R"(When one :class:`QueueSubmission` ran on the GPU, as returned by
+:meth:`ReplayController.GetQueueTimeline`.
+)");
+struct SubmissionTiming
+{
+  DOCUMENT("The index of the submission in :data:`FrameDescription.queueSubmissions`.");
+  uint32_t submission;
+
+  DOCUMENT("The time in seconds from the start of the frame to the start of the submission.");
+  double start;
+
+  DOCUMENT(R"(The time in seconds from the start of the submission's first event to the end of its
+last.
+)");
+  double duration;
+
+  DOCUMENT(R"(The time in seconds the queue sat idle between the end of its previous submission, or
+the start of the frame, and the start of this one.
+)");
+  double stall;
+
+  DOCUMENT("The time in seconds during this submission when at least one other queue was busy.");
+  double overlap;
+};
+
+DECLARE_REFLECTION_STRUCT(SubmissionTiming);
+
+DOCUMENT(R"(The memory used by one part of the replay, as returned by
+:meth:`ReplayController.GetMemoryUsage`.
+
+Sizes are estimates based on the data each part keeps, and don't include allocator or driver
+overhead.
+)");
+struct MemoryUsage
+{
+  DOCUMENT(R"(The name of what is using the memory, e.g. ``Post-VS data`` or
+``Shader reflection``.
+)");
+  rdctype::str category;
+
+  DOCUMENT("``True`` if this memory is allocated on the GPU, ``False`` if it's CPU memory.");
+  bool32 gpu;
+
+  DOCUMENT("The number of objects or allocations in this category.");
+  uint64_t count;
+
+  DOCUMENT("The estimated total size of this category, in bytes.");
+  uint64_t bytes;
+};
+
+DECLARE_REFLECTION_STRUCT(MemoryUsage);
+
+DOCUMENT(R"(The GPU memory used by a single texture or buffer in the capture, as returned by
+:meth:`ReplayController.GetResourceMemory`.
+)");
+struct ResourceMemory
+{
+  DOCUMENT("The :class:`ResourceId` of the texture or buffer.");
+  ResourceId ID;
+
+  DOCUMENT("The name of the resource.");
+  rdctype::str name;
+
+  DOCUMENT("``True`` if the resource is a texture, ``False`` if it's a buffer.");
+  bool32 texture;
+
+  DOCUMENT(R"(The heap or memory type backing the resource, the same as
+:data:`TextureDescription.memoryType` or :data:`BufferDescription.memoryType`.
+)");
+  rdctype::str memoryType;
+
+  DOCUMENT(R"(The size of the resource's allocation in bytes, the same as
+:data:`TextureDescription.allocationSize` or :data:`BufferDescription.allocationSize`.
+)");
+  uint64_t bytes;
+};
+
+DECLARE_REFLECTION_STRUCT(ResourceMemory);
+
+DOCUMENT(R"(A render target, depth target or read-write resource whose contents only live within the
+frame, as part of an :class:`AliasGroup`.
+)");
+struct TransientResource
+{
+  DOCUMENT("The :class:`ResourceId` of the texture or buffer.");
+  ResourceId ID;
+
+  DOCUMENT("The name of the resource.");
+  rdctype::str name;
+
+  DOCUMENT("``True`` if the resource is a texture, ``False`` if it's a buffer.");
+  bool32 texture = false;
+
+  DOCUMENT("The size of the resource's allocation in bytes.");
+  uint64_t bytes = 0;
+
+  DOCUMENT("The :data:`EID <APIEvent.eventID>` of the first write to the resource in the frame.");
+  uint32_t firstWrite = 0;
+
+  DOCUMENT("The :data:`EID <APIEvent.eventID>` of the last read from the resource in the frame.");
+  uint32_t lastRead = 0;
+};
+
+DECLARE_REFLECTION_STRUCT(TransientResource);
+
+DOCUMENT(R"(A set of transient resources whose lifetimes don't overlap, so they could all share one
+allocation, as returned by :meth:`ReplayController.GetTransientAliasing`.
+)");
+struct AliasGroup
+{
+  DOCUMENT(R"(The heap or memory type backing every resource in the group, the same as
+:data:`TextureDescription.memoryType` or :data:`BufferDescription.memoryType`.
+)");
+  rdctype::str memoryType;
+
+  DOCUMENT("The size in bytes of the shared allocation, i.e. the size of the largest resource.");
+  uint64_t bytes = 0;
+
+  DOCUMENT("The number of bytes saved by sharing the allocation instead of allocating separately.");
+  uint64_t savedBytes = 0;
+
+  DOCUMENT(R"(The resources in the group, in the order they are used in the frame.
+
+:type: ``list`` of :class:`TransientResource`
+)");
+  rdctype::array<TransientResource> resources;
+};
+
+DECLARE_REFLECTION_STRUCT(AliasGroup);
+
 DOCUMENT("The contents of an RGBA pixel.");
 union PixelValue
 {
@@ -1051,3 +1706,16 @@ pixel.
 };
 
 DECLARE_REFLECTION_STRUCT(PixelModification);
+
+DOCUMENT("The history of modifications to one pixel in a region of a texture.");
+struct PixelRegionHistory
+{
+  DOCUMENT("The x co-ordinate of the pixel.");
+  uint32_t x = 0;
+  DOCUMENT("The y co-ordinate of the pixel.");
+  uint32_t y = 0;
+  DOCUMENT("The list of :class:`PixelModification` events that modified this pixel.");
+  rdctype::array<PixelModification> modifications;
+};
+
+DECLARE_REFLECTION_STRUCT(PixelRegionHistory);
@@ -0,0 +1,141 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2017 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Counter provider interface. This is a plain C interface that vendor libraries can implement to
+// expose hardware counters (cache hit rates, occupancy, bandwidth...) through RenderDoc's normal
+// GPUCounter API.
+//
+// Libraries to load are listed, separated by ';', in the replay.counterProviders config setting.
+// Each library exports RENDERDOC_GetCounterProvider which fills out the function table below. The
+// counters a library exposes are numbered from its counterBase, which must be one of the
+// IHV-specific ranges in GPUCounter (FirstAMD, FirstIntel, FirstNvidia), below FirstEstimated.
+//
+
+#if !defined(RENDERDOC_NO_STDINT)
+#include <stdint.h>
+#endif
+
+#if defined(WIN32)
+#define RENDERDOC_CC __cdecl
+#elif defined(__linux__)
+#define RENDERDOC_CC
+#elif defined(__APPLE__)
+#define RENDERDOC_CC
+#else
+#error "Unknown platform"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RENDERDOC_COUNTER_PROVIDER_VERSION 1
+
+// The API being replayed, passed to Init so the library knows how to interpret the native handles.
+typedef enum {
+  eRENDERDOC_CounterAPI_D3D11 = 0,
+  eRENDERDOC_CounterAPI_D3D12 = 1,
+  eRENDERDOC_CounterAPI_OpenGL = 2,
+  eRENDERDOC_CounterAPI_Vulkan = 3,
+} RENDERDOC_CounterAPI;
+
+// The type of a counter's results. All results are returned in a 64-bit slot.
+typedef enum {
+  eRENDERDOC_CounterType_UInt64 = 0,
+  eRENDERDOC_CounterType_Double = 1,
+} RENDERDOC_CounterType;
+
+// The unit of a counter's results, matching the CounterUnit enum.
+typedef enum {
+  eRENDERDOC_CounterUnit_Absolute = 0,
+  eRENDERDOC_CounterUnit_Seconds = 1,
+  eRENDERDOC_CounterUnit_Percentage = 2,
+  eRENDERDOC_CounterUnit_Bytes = 3,
+} RENDERDOC_CounterUnit;
+
+typedef struct
+{
+  // human readable name and description. Must remain valid until Shutdown is called.
+  const char *name;
+  const char *description;
+
+  RENDERDOC_CounterType type;
+  RENDERDOC_CounterUnit unit;
+} RENDERDOC_CounterProviderDescription;
+
+typedef struct
+{
+  // must be set to RENDERDOC_COUNTER_PROVIDER_VERSION
+  uint32_t version;
+
+  // the GPUCounter value of this library's first counter
+  uint32_t counterBase;
+
+  // called once after the replay device is created.
+  // nativeDevice is the ID3D11Device *, ID3D12Device * or VkDevice. For OpenGL it is NULL, and the
+  // replay context is current.
+  // Returns non-zero if the library can provide counters for this device.
+  int(RENDERDOC_CC *Init)(RENDERDOC_CounterAPI api, void *nativeDevice);
+
+  // called once before the replay device is destroyed.
+  void(RENDERDOC_CC *Shutdown)();
+
+  // the number of counters available. Counter indices run from 0 to NumCounters()-1
+  uint32_t(RENDERDOC_CC *NumCounters)();
+  void(RENDERDOC_CC *DescribeCounter)(uint32_t index, RENDERDOC_CounterProviderDescription *desc);
+
+  // Begins a session sampling the given counters. Returns the number of passes that are needed to
+  // gather them all - the frame is replayed this many times, and the same events are sampled each
+  // time.
+  uint32_t(RENDERDOC_CC *BeginSession)(const uint32_t *indices, uint32_t numIndices);
+
+  void(RENDERDOC_CC *BeginPass)(uint32_t pass);
+
+  // brackets a single event. nativeCommand is the ID3D11DeviceContext *,
+  // ID3D12GraphicsCommandList * or VkCommandBuffer the event is recorded into, or NULL on OpenGL.
+  void(RENDERDOC_CC *BeginSample)(uint32_t sampleID, void *nativeCommand);
+  void(RENDERDOC_CC *EndSample)(uint32_t sampleID, void *nativeCommand);
+
+  void(RENDERDOC_CC *EndPass)(uint32_t pass);
+
+  // called once all passes have been replayed and the GPU is idle
+  void(RENDERDOC_CC *EndSession)();
+
+  // reads the result of a counter for a sample in the last session into the 64-bit value.
+  // Returns non-zero if a result is available.
+  int(RENDERDOC_CC *GetResult)(uint32_t sampleID, uint32_t index, void *value);
+} RENDERDOC_CounterProvider;
+
+// the entry point exported by a counter provider library. Returns non-zero if the provider was
+// filled out for the requested version.
+typedef int(RENDERDOC_CC *pRENDERDOC_GetCounterProvider)(uint32_t version,
+                                                         RENDERDOC_CounterProvider *provider);
+
+#ifdef __cplusplus
+}    // extern "C"
+#endif
@@ -140,7 +140,9 @@ DOCUMENT(R"(Specifies a windowing system to use for creating an output window.
 
 .. data:: Unknown
 
-  No windowing data is passed and no native window will be output to.
+  No windowing data is passed and no native window will be output to. An output created this way
+  is headless - nothing is rendered for it until it's read back, e.g. with
+  :meth:`ReplayOutput.PickPixel`.
 
 .. data:: Win32
 
@@ -279,6 +281,16 @@ This will also render any thumbnails and the pixel context, if enabled.
 )");
   virtual void Display() = 0;
 
+  DOCUMENT(R"(Check whether the last :meth:`Display` of a mesh output drew reduced meshes.
+
+While the camera is moving, very large meshes are only partly drawn so that the display stays
+responsive. Calling :meth:`Display` again once the camera has stopped draws them in full.
+
+:return: ``True`` if the meshes were reduced in the last display.
+:rtype: ``bool``
+)");
+  virtual bool IsMeshDisplayReduced() = 0;
+
   DOCUMENT(R"(Sets up a zoomed in pixel context view around a particular pixel selection.
 
 The texture rendering uses the configuration specified in :meth:`SetTextureDisplay` except with a
@@ -368,6 +380,28 @@ Should only be called for texture outputs.
   virtual PixelValue PickPixel(ResourceId texID, bool customShader, uint32_t x, uint32_t y,
                                uint32_t sliceFace, uint32_t mip, uint32_t sample) = 0;
 
+  DOCUMENT(R"(Request a pixel pick without waiting for the result. The pick is made the next time
+the output is displayed. Only the latest request is kept, so calling this on every mouse move costs
+at most one pick per displayed frame.
+
+Should only be called for texture outputs.
+
+The parameters are as for :meth:`PickPixel`. Use :meth:`GetPickedPixel` to retrieve the result.
+)");
+  virtual void RequestPickPixel(ResourceId texID, bool customShader, uint32_t x, uint32_t y,
+                                uint32_t sliceFace, uint32_t mip, uint32_t sample) = 0;
+
+  DOCUMENT(R"(Retrieve the most recent result of :meth:`RequestPickPixel`. This never waits on the
+GPU, so the result may be for an earlier request than the latest. Compare its co-ordinates to those
+requested to check.
+
+The result is invalidated when the current event changes.
+
+:return: The most recent completed pick.
+:rtype: PixelPick
+)");
+  virtual PixelPick GetPickedPixel() = 0;
+
   DOCUMENT(R"(Retrieves the vertex and instance that is under the cursor location, when viewed
 relative to the current window with the current mesh display configuration.
 
@@ -463,6 +497,22 @@ used to present a progress dialog and repeatedly queried to see when to allow th
 )");
   virtual void SetFrameEvent(uint32_t eventID, bool force) = 0;
 
+  DOCUMENT(R"(Ask any long-running replay work to stop as soon as possible.
+
+This can be called from any thread, while another thread is inside a call on this interface. Calls
+that replay many times, such as :meth:`PixelHistory`, :meth:`FetchCounters` or post-transform data
+for a large pass, check for this periodically and return early with partial or empty results.
+
+The request stays in effect for subsequent calls until :meth:`ClearCancelRequest` is called.
+)");
+  virtual void RequestCancel() = 0;
+
+  DOCUMENT(R"(Clear a previous :meth:`RequestCancel` so that subsequent calls run to completion.
+
+This should be called once the call that was cancelled has returned.
+)");
+  virtual void ClearCancelRequest() = 0;
+
   DOCUMENT(R"(Retrieve the current :class:`D3D11_State` pipeline state.
 
 This pipeline state will be filled with default values if the capture is not using the D3D11 API.
@@ -503,6 +553,40 @@ You should use :meth:`GetAPIProperties` to determine the API of the capture.
 )");
   virtual VKPipe::State GetVulkanPipelineState() = 0;
 
+  DOCUMENT(R"(Gather data for many events at once, instead of calling :meth:`SetFrameEvent` and
+then fetching the data for each event in turn.
+
+The events are visited in order in a single pass. Where the API allows it the replay moves forward
+from one event to the next instead of replaying from the start of the frame each time, and no
+outputs are updated or drawcalls replayed along the way. Counters are fetched in one go for all
+events.
+
+The current event is unchanged afterwards. If the call is cancelled with :meth:`RequestCancel` only
+the events visited so far are returned.
+
+:param list eventIDs: The :data:`EIDs <APIEvent.eventID>` to gather data for, in any order.
+:param EventDataFlags flags: The data to gather for each event.
+:param list counters: The :class:`GPUCounter` values to fetch if :data:`EventDataFlags.Counters`
+  is set.
+:return: The data for each event, in ascending event order with duplicates removed.
+:rtype: ``list`` of :class:`EventData`
+)");
+  virtual rdctype::array<EventData> GetEventData(const rdctype::array<uint32_t> &eventIDs,
+                                                 EventDataFlags flags,
+                                                 const rdctype::array<GPUCounter> &counters) = 0;
+
+  DOCUMENT(R"(Retrieve the contents of every constant block read by the shaders bound at the current
+event, for all stages at once. This is the same as calling :meth:`GetCBufferVariableContents` for
+each block in turn.
+
+Decoded contents are cached, so a block whose contents haven't changed since it was last decoded
+for the same shader is not parsed again.
+
+:return: The constant blocks and their contents.
+:rtype: ``list`` of :class:`EventConstantBlock`
+)");
+  virtual rdctype::array<EventConstantBlock> GetBoundConstantBlocks() = 0;
+
   DOCUMENT(R"(Builds a shader suitable for running on the local replay instance as a custom shader.
 
 The language used is native to the local renderer - HLSL for D3D based renderers, GLSL otherwise.
@@ -589,6 +673,14 @@ See :meth:`BuildTargetShader`.
 )");
   virtual rdctype::array<DrawcallDescription> GetDrawcalls() = 0;
 
+  DOCUMENT(R"(Retrieve all of the drawcalls in the capture as one flat list, which can be accessed by
+index without copying the drawcall tree.
+
+:return: The flat list of drawcalls.
+:rtype: FlatDrawcallList
+)");
+  virtual const FlatDrawcallList &GetFlatDrawcalls() = 0;
+
   DOCUMENT(R"(Retrieve the values of a specified set of counters.
 
 :param list counters: The list of :class:`GPUCounter` to fetch results for.
@@ -597,6 +689,74 @@ See :meth:`BuildTargetShader`.
 )");
   virtual rdctype::array<CounterResult> FetchCounters(const rdctype::array<GPUCounter> &counters) = 0;
 
+  DOCUMENT(R"(Retrieve statistically stable values of a specified set of counters, by replaying the
+capture several times and summarising the values seen for each event.
+
+One extra warm-up replay is performed first and its results discarded, so that caches and clocks
+are in a steady state before any values are recorded.
+
+:param list counters: The list of :class:`GPUCounter` to fetch results for.
+:param int iterations: The number of recorded replays to gather values over.
+:return: The list of counter statistics generated.
+:rtype: ``list`` of :class:`CounterStatistics`
+)");
+  virtual rdctype::array<CounterStatistics> FetchCounterStatistics(
+      const rdctype::array<GPUCounter> &counters, uint32_t iterations) = 0;
+
+  DOCUMENT(R"(Replay the whole frame repeatedly, as fast as possible, so that an external GPU
+profiler attached to this process sees a steady stream of identical frames.
+
+Each iteration replays from the start of the frame to the end, including applying the initial
+contents of resources. Nothing else is fetched between iterations. When the loop finishes, the
+replay returns to the current event.
+
+The loop stops early if :meth:`RequestCancel` is called from another thread.
+
+:param int iterations: The number of times to replay the frame.
+:param ReplayOutput output: An output to display after each iteration, so that tools that delimit
+  frames by presents see one frame per iteration. Can be ``None``.
+:param bool timeGPU: ``True`` to time each iteration on the GPU. This adds a timestamp query around
+  every event, so leave it off when an external profiler is doing the measuring.
+:return: The GPU duration of each completed iteration in seconds, if ``timeGPU`` is set and
+  :data:`GPUCounter.EventGPUDuration` is available. Otherwise an empty list.
+:rtype: ``list`` of ``float``
+)");
+  virtual rdctype::array<double> ReplayLoop(uint32_t iterations, IReplayOutput *output,
+                                            bool timeGPU) = 0;
+
+  DOCUMENT(R"(Aggregate per-event GPU durations into a timeline of marker regions, suitable for
+drawing as a flame graph over the frame.
+
+Every region's duration is the sum of the durations of the drawcalls it contains. Consecutive
+siblings shorter than ``minDuration`` are merged into a single region and their children aren't
+listed, so the size of the timeline is bounded by the resolution it's drawn at rather than the
+number of events in the capture.
+
+:param list durations: The :class:`CounterResult` list from fetching
+  :data:`GPUCounter.EventGPUDuration`.
+:param float minDuration: The shortest duration in seconds to list as its own region, or ``0`` to
+  list every drawcall.
+:return: The list of timeline regions, in depth-first order.
+:rtype: ``list`` of :class:`TimelineRegion`
+)");
+  virtual rdctype::array<TimelineRegion> GetDurationTimeline(
+      const rdctype::array<CounterResult> &durations, double minDuration) = 0;
+
+  DOCUMENT(R"(Replay the frame with GPU timestamps to find when each queue submission ran, so work
+on different queues can be laid out side by side along with the gaps where a queue sat idle.
+
+Where the driver supports :data:`GPUCounter.EventGPUStart` the times are measured, and show how
+much the queues really overlapped. Otherwise the submissions are laid end to end from their
+:data:`GPUCounter.EventGPUDuration` and no overlap is shown.
+
+Submissions are replayed on their own queues, but on Vulkan waits on semaphores from another
+queue aren't reproduced, so work can start earlier than it did in the application.
+
+:return: The timing of each of :data:`FrameDescription.queueSubmissions`, sorted by start time.
+:rtype: ``list`` of :class:`SubmissionTiming`
+)");
+  virtual rdctype::array<SubmissionTiming> GetQueueTimeline() = 0;
+
   DOCUMENT(R"(Retrieve a list of which counters are available in the current capture analysis
 implementation.
 
@@ -628,6 +788,30 @@ understanding as well as the type and unit of the resulting information.
 )");
   virtual rdctype::array<BufferDescription> GetBuffers() = 0;
 
+  DOCUMENT(R"(Retrieve the GPU memory used by each texture and buffer in the capture, sorted with the
+largest allocation first.
+
+:return: The list of resources and their allocation sizes.
+:rtype: ``list`` of :class:`ResourceMemory`
+)");
+  virtual rdctype::array<ResourceMemory> GetResourceMemory() = 0;
+
+  DOCUMENT(R"(Find the render targets, depth targets and read-write resources that are only used
+within the frame, and suggest how they could be packed into shared allocations.
+
+A resource is transient if its first use in the frame writes to it, and its lifetime runs from
+that write to the last read of it. Resources whose lifetimes don't overlap are packed into the
+same group, largest first, and only resources of the same memory type are grouped together.
+Resources that are never read are not included, see :meth:`AnalyseWastedWork`.
+
+This is based only on the resource usage in the capture, so API restrictions on aliasing such as
+heap tiers or alignment aren't taken into account.
+
+:return: The suggested groups, with the largest saving first.
+:rtype: ``list`` of :class:`AliasGroup`
+)");
+  virtual rdctype::array<AliasGroup> GetTransientAliasing() = 0;
+
   DOCUMENT(R"(Retrieve the list of buffers alive in the capture.
 
 Must only be called after :meth:`InitResolver` has returned ``True``.
@@ -638,6 +822,31 @@ Must only be called after :meth:`InitResolver` has returned ``True``.
 )");
   virtual rdctype::array<rdctype::str> GetResolve(const rdctype::array<uint64_t> &callstack) = 0;
 
+  DOCUMENT(R"(Retrieve the serialised parameters of an API call.
+
+The drawcall list only carries the name of each call in :data:`APIEvent.eventDesc`, the parameters
+are looked up on demand with this function.
+
+:param int eventID: The event ID of the call.
+:return: The parameters in the same raw debug string form as the call was serialised, or an empty
+  string if the call has none.
+:rtype: ``str``
+)");
+  virtual rdctype::str GetEventParameters(uint32_t eventID) = 0;
+
+  DOCUMENT(R"(Find every API call that referenced a resource in its parameters.
+
+This is looked up in an index built when the capture is loaded, from
+:data:`APIEvent.referencedResources`, so it's quick to call even on large captures. Unlike
+:meth:`GetUsage` it includes calls that only refer to the resource indirectly, such as creating a
+view of it or binding a pipeline, but not calls that used it through something else that was bound.
+
+:param ResourceId id: The id of the resource to look for.
+:return: The sorted list of event IDs of calls that referenced the resource.
+:rtype: ``list`` of ``int``
+)");
+  virtual rdctype::array<uint32_t> FindEventsReferencing(ResourceId id) = 0;
+
   DOCUMENT(R"(Retrieve a list of any newly generated diagnostic messages.
 
 Every time this function is called, any debug messages returned will not be returned again. Only
@@ -648,6 +857,109 @@ newly generated messages will be returned after that.
 )");
   virtual rdctype::array<DebugMessage> GetDebugMessages() = 0;
 
+  DOCUMENT(R"(Analyse the capture for work that is wasted, either on the CPU by making API calls that
+have no effect, or on the GPU by producing results that are never used.
+
+Each problem found is returned as a :class:`DebugMessage`, with a
+:data:`MessageSource.RedundantAPIUse` source for CPU-side waste and
+:data:`MessageSource.GeneralPerformance` for GPU-side waste. The ``messageID`` identifies the check:
+
+* ``1`` - A state-setting call repeats the previous call to the same function with identical
+  parameters, and no other state has been set in between.
+* ``2`` - A resource is cleared again without being used since it was last cleared.
+* ``3`` - A resource is written by copies or uploads, but never read in the frame.
+* ``4`` - A drawcall's output is cleared before anything reads it.
+
+These checks are heuristic, based on the serialised parameters of each call and on the
+:meth:`GetUsage` of each resource, so they can miss problems or flag calls where the application's
+behaviour depends on something outside the frame.
+
+:return: The list of problems found, sorted by EID.
+:rtype: ``list`` of :class:`DebugMessage`
+)");
+  virtual rdctype::array<DebugMessage> AnalyseWastedWork() = 0;
+
+  DOCUMENT(R"(Estimate how expensive the shaders are for every drawcall and dispatch in the frame,
+from the :data:`ShaderReflection.Cost` of the shaders bound at each.
+
+This replays the state for each drawcall in turn, so it can take a while on large captures. If it's
+cancelled with :meth:`RequestCancel` only the drawcalls processed so far are returned. The current
+event is restored afterwards.
+
+:return: The list of shader costs, sorted by EID.
+:rtype: ``list`` of :class:`DrawcallShaderCost`
+)");
+  virtual rdctype::array<DrawcallShaderCost> GetDrawcallShaderCosts() = 0;
+
+  DOCUMENT(R"(Estimate the memory traffic of every drawcall, dispatch, clear, copy and resolve in
+the frame. See :class:`DrawcallBandwidth` for what goes into the estimate. The same totals are
+available through :meth:`FetchCounters` as :data:`GPUCounter.EstimatedBytesRead` and
+:data:`GPUCounter.EstimatedBytesWritten`.
+
+This replays the frame once to gather pipeline statistics where the driver supports them, then
+replays the state for each drawcall and dispatch in turn, so it can take a while on large captures.
+If it's cancelled with :meth:`RequestCancel` only the events processed so far are returned. The
+current event is restored afterwards.
+
+:return: The list of bandwidth estimates, sorted by EID.
+:rtype: ``list`` of :class:`DrawcallBandwidth`
+)");
+  virtual rdctype::array<DrawcallBandwidth> GetDrawcallBandwidth() = 0;
+
+  DOCUMENT(R"(Classify what most likely limits each drawcall and dispatch in the frame, and rank the
+passes of the frame by their cost. See :class:`DrawcallBottleneck` for how events are classified.
+
+This fetches the duration and pipeline statistics counters the driver supports, and combines them
+with :meth:`GetDrawcallShaderCosts` and :meth:`GetDrawcallBandwidth`, so it replays the frame
+several times. If it's cancelled with :meth:`RequestCancel` an empty list is returned. The current
+event is restored afterwards.
+
+:return: The list of passes, most expensive first. Passes are ranked by duration if the driver
+  supports :data:`GPUCounter.EventGPUDuration`, or by :data:`PassBottleneck.work` if not.
+:rtype: ``list`` of :class:`PassBottleneck`
+)");
+  virtual rdctype::array<PassBottleneck> AnalyseBottlenecks() = 0;
+
+  DOCUMENT(R"(Analyse how well the index buffer of every indexed triangle list and strip drawcall in
+the frame uses the post-transform vertex cache. See :class:`IndexEfficiency` for what's measured.
+
+Draws that use the same indices are only analysed once, so repeated draws of a mesh are cheap. The
+state for each indexed drawcall is still replayed to find its index buffer, so this can take a while
+on large captures. If it's cancelled with :meth:`RequestCancel` only the drawcalls processed so far
+are returned. The current event is restored afterwards.
+
+:return: The list of index buffer analyses, sorted by EID.
+:rtype: ``list`` of :class:`IndexEfficiency`
+)");
+  virtual rdctype::array<IndexEfficiency> GetIndexEfficiency() = 0;
+
+  DOCUMENT(R"(Find which mips and which regions of each texture are sampled over a range of events.
+
+The events are replayed with each drawcall's fragment shader patched to record the mip and
+coordinates of every texture sample, so this is only as expensive as a replay of the range. Pass
+the same EID twice to analyse a single drawcall.
+
+Currently only supported on Vulkan. Other APIs return an empty list.
+
+:param int startEventID: The first :data:`EID <APIEvent.eventID>` to include.
+:param int endEventID: The last :data:`EID <APIEvent.eventID>` to include.
+:return: The sampled footprint of each texture that was sampled.
+:rtype: ``list`` of :class:`TextureSamplingFeedback`
+)");
+  virtual rdctype::array<TextureSamplingFeedback> GetTextureSampling(uint32_t startEventID,
+                                                                     uint32_t endEventID) = 0;
+
+  DOCUMENT(R"(Retrieve an estimate of the memory currently used by the replay, broken down by
+what is using it.
+
+This includes CPU memory such as the drawcall tree and shader reflection, and GPU memory such as
+initial contents, post-VS data and the resources used to render overlays and read back data.
+
+:return: The list of :class:`MemoryUsage` categories.
+:rtype: ``list`` of :class:`MemoryUsage`
+)");
+  virtual rdctype::array<MemoryUsage> GetMemoryUsage() = 0;
+
   DOCUMENT(R"(Retrieve the history of modifications to the selected pixel on the selected texture.
 
 :param ResourceId texture: The texture to search for modifications.
@@ -664,6 +976,29 @@ newly generated messages will be returned after that.
                                                          uint32_t slice, uint32_t mip,
                                                          uint32_t sampleIdx, CompType typeHint) = 0;
 
+  DOCUMENT(R"(Retrieve the history of modifications to every pixel in a rectangle of a texture.
+
+This is much faster than calling :meth:`PixelHistory` for each pixel, since the replays and
+readbacks are shared between all of the pixels in the region.
+
+:param ResourceId texture: The texture to search for modifications.
+:param int x: The x co-ordinate of the top-left of the region.
+:param int y: The y co-ordinate of the top-left of the region.
+:param int width: The width of the region. It is clamped to the texture's dimensions.
+:param int height: The height of the region. It is clamped to the texture's dimensions.
+:param int slice: The slice of an array or 3D texture, or face of a cubemap texture.
+:param int mip: The mip level to pick from.
+:param int sampleIdx: The multi-sampled sample. Ignored if non-multisampled texture.
+:param CompType typeHint: A hint on how to interpret textures that are typeless.
+:return: The pixel history for each pixel in the region, in row-major order.
+:rtype: ``list`` of :class:`PixelRegionHistory`
+)");
+  virtual rdctype::array<PixelRegionHistory> PixelHistoryRegion(ResourceId texture, uint32_t x,
+                                                                uint32_t y, uint32_t width,
+                                                                uint32_t height, uint32_t slice,
+                                                                uint32_t mip, uint32_t sampleIdx,
+                                                                CompType typeHint) = 0;
+
   DOCUMENT(R"(Retrieve a debugging trace from running a vertex shader.
 
 :param int vertid: The vertex ID as a 0-based index up to the number of vertices in the draw.
@@ -693,6 +1028,35 @@ newly generated messages will be returned after that.
   virtual ShaderDebugTrace *DebugPixel(uint32_t x, uint32_t y, uint32_t sample,
                                        uint32_t primitive) = 0;
 
+  DOCUMENT(R"(Retrieve debugging traces from running a vertex shader on many vertices.
+
+This is much faster than calling :meth:`DebugVertex` for each vertex, since the inputs for all
+vertices are fetched together and the shader simulation runs in parallel.
+
+:param inputs: The list of :class:`ShaderDebugVertexInput` vertices to debug.
+:param int instOffset: The value from :data:`DrawcallDescription.instanceOffset`.
+:param int vertOffset: The value from :data:`DrawcallDescription.vertexOffset`.
+:return: The resulting traces, one for each entry in ``inputs`` in the same order.
+:rtype: ``list`` of :class:`ShaderDebugTrace`
+)");
+  virtual rdctype::array<ShaderDebugTrace> DebugVertices(
+      const rdctype::array<ShaderDebugVertexInput> &inputs, uint32_t instOffset,
+      uint32_t vertOffset) = 0;
+
+  DOCUMENT(R"(Retrieve debugging traces from running a pixel shader on many pixels.
+
+This is much faster than calling :meth:`DebugPixel` for each pixel, since the inputs for all
+pixels are fetched with a single replay of the event and the shader simulation runs in parallel.
+
+A pixel that can't be debugged, for example because nothing was drawn there, gets an empty trace.
+
+:param inputs: The list of :class:`ShaderDebugPixelInput` pixels to debug.
+:return: The resulting traces, one for each entry in ``inputs`` in the same order.
+:rtype: ``list`` of :class:`ShaderDebugTrace`
+)");
+  virtual rdctype::array<ShaderDebugTrace> DebugPixels(
+      const rdctype::array<ShaderDebugPixelInput> &inputs) = 0;
+
   DOCUMENT(R"(Retrieve a debugging trace from running a compute thread.
 
 :param groupid: A list containing the 3D workgroup index.
@@ -745,6 +1109,19 @@ texture to something compatible with the target file format.
 )");
   virtual bool SaveTexture(const TextureSave &saveData, const char *path) = 0;
 
+  DOCUMENT(R"(Save a list of textures to files on disk, as with :meth:`SaveTexture`.
+
+This is much faster than saving each texture in turn, as textures are encoded to their file formats
+on other threads while the following textures are read back.
+
+:param list saveData: A list of :class:`TextureSave` with the configuration of each texture to save.
+:param list paths: A list of ``str`` with the path to save each texture to, matching ``saveData``.
+:return: ``True`` if every texture was saved successfully, ``False`` otherwise.
+:rtype: ``bool``
+)");
+  virtual bool SaveTextures(const rdctype::array<TextureSave> &saveData,
+                            const rdctype::array<rdctype::str> &paths) = 0;
+
   DOCUMENT(R"(Retrieve the generated data from one of the geometry processing shader stages.
 
 :param int instID: The index of the instance to retrieve data for.
@@ -754,17 +1131,19 @@ texture to something compatible with the target file format.
 )");
   virtual MeshFormat GetPostVSData(uint32_t instID, MeshDataStage stage) = 0;
 
-  DOCUMENT(R"(Retrieve the contents of a range of a buffer as a ``bytes``.
+  DOCUMENT(R"(Retrieve the contents of a range of a buffer as a ``memoryview``.
+
+The returned data is not copied, so it can be wrapped directly with e.g. ``numpy.frombuffer``.
 
 :param ResourceId buff: The id of the buffer to retrieve data from.
 :param int offset: The byte offset to the start of the range.
 :param int len: The length of the range, or 0 to retrieve the rest of the bytes in the buffer.
 :return: The requested buffer contents.
-:rtype: ``bytes``
+:rtype: ``memoryview``
 )");
   virtual rdctype::array<byte> GetBufferData(ResourceId buff, uint64_t offset, uint64_t len) = 0;
 
-  DOCUMENT(R"(Retrieve the contents of one subresource of a texture as a ``bytes``.
+  DOCUMENT(R"(Retrieve the contents of one subresource of a texture as a ``memoryview``.
 
 For multi-sampled images, they are treated as if they are an array that is Nx longer, with each
 array slice being expanded in-place so it would be slice 0: sample 0, slice 0: sample 1, slice 1:
@@ -774,10 +1153,55 @@ sample 0, etc.
 :param int arrayIdx: The slice of an array or 3D texture, or face of a cubemap texture.
 :param int mip: The mip level to pick from.
 :return: The requested texture contents.
-:rtype: ``bytes``
+:rtype: ``memoryview``
 )");
   virtual rdctype::array<byte> GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip) = 0;
 
+  DOCUMENT(R"(Retrieve the contents of a rectangle within one subresource of a texture as a
+``memoryview``.
+
+Where the driver supports it only the rectangle is read back from the GPU, so this is much cheaper
+than :meth:`GetTextureData` when only part of a large texture is needed. The rows of the rectangle
+are tightly packed, and for 3D textures every depth slice of the rectangle is returned in turn.
+
+Block-compressed formats and some packed depth-stencil formats aren't supported.
+
+:param ResourceId tex: The id of the texture to retrieve data from.
+:param int arrayIdx: The slice of an array or 3D texture, or face of a cubemap texture.
+:param int mip: The mip level to pick from.
+:param int x: The x co-ordinate of the rectangle, in texels of the selected mip.
+:param int y: The y co-ordinate of the rectangle, in texels of the selected mip.
+:param int width: The width of the rectangle. It is clamped to the edge of the mip.
+:param int height: The height of the rectangle. It is clamped to the edge of the mip.
+:return: The requested texture contents, or an empty result if the region couldn't be fetched.
+:rtype: ``memoryview``
+)");
+  virtual rdctype::array<byte> GetTextureDataRegion(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
+                                                    uint32_t x, uint32_t y, uint32_t width,
+                                                    uint32_t height) = 0;
+
+  DOCUMENT(R"(Compare one subresource of two textures, each as it is at a given event. The same
+texture may be compared between two events, or two textures at the same event.
+
+The replay is moved to each event in turn to fetch the contents, and returned to the current event
+afterwards. Both textures must have the same dimensions at the selected mip. Block-compressed and
+most packed formats aren't supported.
+
+:param ResourceId texA: The first texture to compare.
+:param int eventA: The event at which to fetch the contents of ``texA``.
+:param ResourceId texB: The second texture to compare.
+:param int eventB: The event at which to fetch the contents of ``texB``.
+:param int sliceFace: The slice of an array texture, or face of a cubemap texture.
+:param int mip: The mip level to compare.
+:param float threshold: The error in any channel above which a pixel is counted as changed.
+:return: The differences found. If the textures couldn't be compared
+  :data:`TextureDiff.totalPixels` is ``0``.
+:rtype: TextureDiff
+)");
+  virtual TextureDiff CompareTextures(ResourceId texA, uint32_t eventA, ResourceId texB,
+                                      uint32_t eventB, uint32_t sliceFace, uint32_t mip,
+                                      float threshold) = 0;
+
   static const uint32_t NoPreference = ~0U;
 
 protected:
@@ -1086,6 +1510,17 @@ This filename is exactly as specified without any modificaton to make it an abso
 )");
   virtual const char *RecordedMachineIdent() = 0;
 
+  DOCUMENT(R"(Selects which GPU a later call to :meth:`OpenCapture` replays on.
+
+By default the GPU that best matches the one the capture was made on is chosen. Pinning captures to
+different GPUs lets several be opened and replayed concurrently from different threads. APIs that
+don't support choosing a GPU ignore this.
+
+:param int gpu: The index of the GPU in the API's own enumeration order, or ``0xFFFFFFFF`` to choose
+  automatically.
+)");
+  virtual void SetReplayGPU(uint32_t gpu) = 0;
+
   DOCUMENT(R"(Opens a capture for replay locally and returns a handle to the capture.
 
 This function will block until the capture is fully loaded and ready.
@@ -1107,10 +1542,27 @@ by the :class:`ReplayController`.
 :param int maxsize: The largest width or height allowed. If the thumbnail is larger, it's resized.
 :return: The raw contents of the thumbnail, converted to the desired type at the desired max
   resolution.
-:rtype: ``bytes``.
+:rtype: ``memoryview``.
   )");
   virtual rdctype::array<byte> GetThumbnail(FileType type, uint32_t maxsize) = 0;
 
+  DOCUMENT(R"(Writes a copy of the capture to a new file, without needing to replay it.
+
+The frame data is recompressed and the copy always has an index of its chunks, so older or
+differently compressed captures can be brought up to date. The capture itself is not modified.
+
+:param str destfile: The path to write the copy to. This must not be the capture's own path.
+:param int compressLevel: ``0`` to compress with the fast LZ4 codec, or the deflate level from ``1``
+  to ``9`` for a smaller file.
+:param bool stripCallstacks: ``True`` to leave out any callstacks recorded with the capture, along
+  with the module information needed to resolve them.
+:param bool stripThumbnail: ``True`` to leave out the embedded thumbnail.
+:return: The status of writing the copy, whether success or failure.
+:rtype: ReplayStatus
+)");
+  virtual ReplayStatus Repack(const char *destfile, uint32_t compressLevel, bool stripCallstacks,
+                              bool stripThumbnail) = 0;
+
 protected:
   ICaptureFile() = default;
   ~ICaptureFile() = default;
@@ -1187,6 +1639,24 @@ case of strip topologies.
 extern "C" RENDERDOC_API uint32_t RENDERDOC_CC Topology_VertexOffset(Topology topology,
                                                                      uint32_t primitive);
 
+DOCUMENT(R"(A utility function that rebuilds the full state at one step of a shader debug trace.
+
+The trace only stores a full :class:`ShaderDebugState` every
+:data:`ShaderDebugTrace.keyframeInterval` steps, and the changed variables for the steps in between. The state is rebuilt by applying those
+changes from the nearest earlier keyframe.
+
+If ``state`` already holds the state for an earlier step after that keyframe, as given by
+``currentStep``, only the changes after it are applied. This keeps stepping forward through a trace
+cheap.
+
+:param ShaderDebugTrace trace: The trace to rebuild the state from.
+:param int step: The step to rebuild, as an index into :data:`ShaderDebugTrace.steps`.
+:param int currentStep: The step that ``state`` currently holds, or ``-1`` if it holds nothing.
+:param ShaderDebugState state: The state to fill out.
+)");
+extern "C" RENDERDOC_API void RENDERDOC_CC ShaderDebug_ReconstructState(
+    const ShaderDebugTrace *trace, int32_t step, int32_t currentStep, ShaderDebugState *state);
+
 //////////////////////////////////////////////////////////////////////////
 // Create a capture handle.
 //
@@ -1204,6 +1674,28 @@ If any errors happen this can be queried with :meth:`CaptureFile.Status`.
 )");
 extern "C" RENDERDOC_API ICaptureFile *RENDERDOC_CC RENDERDOC_OpenCaptureFile(const char *logfile);
 
+DOCUMENT(R"(Counts the captures in a session file, written with the
+:data:`CaptureOptions.AppendCapturesToSession` option.
+
+:param str sessionfile: The path to the session file.
+:return: The number of captures in the session, or ``0`` if the file isn't a session file.
+:rtype: ``int``
+)");
+extern "C" RENDERDOC_API uint32_t RENDERDOC_CC
+RENDERDOC_GetSessionCaptureCount(const char *sessionfile);
+
+DOCUMENT(R"(Writes one capture from a session file out as a standalone capture, which can then be
+opened like any other. The session file is not modified.
+
+:param str sessionfile: The path to the session file.
+:param int index: The index of the capture in the session, in the order they were taken.
+:param str destfile: The path to write the capture to.
+:return: The status of writing the capture, whether success or failure.
+:rtype: ReplayStatus
+)");
+extern "C" RENDERDOC_API ReplayStatus RENDERDOC_CC
+RENDERDOC_ExtractSessionCapture(const char *sessionfile, uint32_t index, const char *destfile);
+
 //////////////////////////////////////////////////////////////////////////
 // Target Control
 //////////////////////////////////////////////////////////////////////////
@@ -1410,6 +1902,20 @@ DOCUMENT("Internal function for setting a config setting.");
 extern "C" RENDERDOC_API void RENDERDOC_CC RENDERDOC_SetConfigSetting(const char *name,
                                                                       const char *value);
 
+DOCUMENT("Internal function for benchmarking the implementations of buffer difference tracking.");
+extern "C" RENDERDOC_API void RENDERDOC_CC RENDERDOC_BenchmarkDiffRange(uint32_t sizeMB,
+                                                                        rdctype::str *report);
+
+DOCUMENT(R"(Internal function for running the microbenchmarks of replay and capture hot paths.
+
+Only benchmarks whose name contains the filter are run, or all of them if it is empty.
+)");
+extern "C" RENDERDOC_API void RENDERDOC_CC RENDERDOC_RunBenchmarks(const char *filter,
+                                                                  rdctype::str *report);
+
+DOCUMENT("Internal function for retrieving the peak memory used by this process, in bytes.");
+extern "C" RENDERDOC_API uint64_t RENDERDOC_CC RENDERDOC_GetPeakMemoryUsage();
+
 DOCUMENT("Internal function for enumerating android devices.");
 extern "C" RENDERDOC_API void RENDERDOC_CC RENDERDOC_EnumerateAndroidDevices(rdctype::str *deviceList);
 
@@ -2861,6 +2861,37 @@ enumerated with IDs in the appropriate ranges.
 
   Number of times a :data:`compute shader <ShaderStage.Compute>` was invoked.
 
+.. data:: EventGPUStart
+
+  Time from the start of the earliest timed event in the frame to the start of this event on the
+  GPU, in seconds. Unlike :data:`EventGPUDuration` this is comparable between events submitted to
+  different queues, so it shows where their work overlapped.
+
+.. data:: CoveredPixels
+
+  Number of pixels a drawcall covered that passed depth and stencil testing, and so had the
+  :data:`pixel shader <ShaderStage.Pixel>` run for them.
+
+  This and the other quad counters come from replaying the drawcall with a replacement pixel shader,
+  so pixels the real shader would discard are still counted, and tests are always done before
+  shading.
+
+.. data:: ShadedQuadPixels
+
+  Number of pixel shader lanes run for a drawcall, counting all four pixels of every 2x2 quad that
+  had at least one :data:`covered <CoveredPixels>` pixel.
+
+.. data:: HelperPixelRatio
+
+  The fraction of :data:`ShadedQuadPixels` that were only run as helpers for derivatives, rather
+  than for a covered pixel. Drawcalls made of small or thin triangles have a high ratio, since most
+  of their quads are only partly covered.
+
+.. data:: DepthRejectedPixels
+
+  Number of pixels a drawcall covered that then failed depth or stencil testing, and so were never
+  shaded.
+
 .. data:: FirstAMD
 
   The AMD-specific counter IDs start from this value.
@@ -2872,6 +2903,19 @@ enumerated with IDs in the appropriate ranges.
 .. data:: FirstNvidia
 
   The nVidia-specific counter IDs start from this value.
+
+.. data:: FirstEstimated
+
+  Counters from this value on aren't read from the GPU but estimated by RenderDoc from the capture,
+  so they are available on every API and hardware.
+
+.. data:: EstimatedBytesRead
+
+  An estimate of the bytes of memory read by an event, see :class:`DrawcallBandwidth`.
+
+.. data:: EstimatedBytesWritten
+
+  An estimate of the bytes of memory written by an event, see :class:`DrawcallBandwidth`.
 )");
 enum class GPUCounter : uint32_t
 {
@@ -2892,6 +2936,11 @@ enum class GPUCounter : uint32_t
   PSInvocations,
   FSInvocations = PSInvocations,
   CSInvocations,
+  EventGPUStart,
+  CoveredPixels,
+  ShadedQuadPixels,
+  HelperPixelRatio,
+  DepthRejectedPixels,
   Count,
 
   // IHV specific counters can be set above this point
@@ -2901,6 +2950,11 @@ enum class GPUCounter : uint32_t
   FirstIntel = 2000000,
 
   FirstNvidia = 3000000,
+
+  // counters estimated on the CPU from the capture rather than read from the GPU
+  FirstEstimated = 4000000,
+  EstimatedBytesRead = FirstEstimated,
+  EstimatedBytesWritten,
 };
 
 ITERABLE_OPERATORS(GPUCounter);
@@ -2918,12 +2972,77 @@ DOCUMENT(R"(The unit that GPU counter data is returned in.
 .. data:: Percentage
 
   The value is a floating point percentage value between 0.0 and 1.0.
+
+.. data:: Bytes
+
+  The value is a quantity of memory in bytes.
 )");
 enum class CounterUnit : uint32_t
 {
   Absolute,
   Seconds,
   Percentage,
+  Bytes,
+};
+
+DOCUMENT(R"(The most likely limiter of a drawcall or dispatch's performance, as classified by
+:meth:`ReplayController.AnalyseBottlenecks`.
+
+.. data:: Overhead
+
+  The event does so little work that its cost is mostly the fixed cost of issuing it. Merging it
+  with other small events is the likely fix.
+
+.. data:: Vertex
+
+  Vertex processing - the vertex, tessellation and geometry shaders, and primitive setup.
+
+.. data:: Fragment
+
+  Pixel or fragment shading.
+
+.. data:: Fill
+
+  Writing samples to the render targets, rather than shading them. Typical of many cheap pixels,
+  such as overdraw from particles or full-screen passes.
+
+.. data:: Bandwidth
+
+  Reading and writing memory - vertex data, textures, render targets and read-write resources.
+
+.. data:: Compute
+
+  Compute shading in a dispatch.
+)");
+enum class Bottleneck : uint32_t
+{
+  Overhead,
+  Vertex,
+  Fragment,
+  Fill,
+  Bandwidth,
+  Compute,
+};
+
+DOCUMENT(R"(The kind of work a queue accepts, for a :class:`QueueSubmission`.
+
+.. data:: Graphics
+
+  A queue that accepts any work, including drawing.
+
+.. data:: Compute
+
+  A queue that accepts compute dispatches and copies, but not drawing.
+
+.. data:: Copy
+
+  A queue that only accepts copies.
+)");
+enum class QueueType : uint32_t
+{
+  Graphics,
+  Compute,
+  Copy,
 };
 
 DOCUMENT(R"(How supported a given API is on a particular replay instance.
@@ -3073,6 +3192,19 @@ DOCUMENT(R"(The type of message received from or sent to an application target c
 .. data:: NewChild
 
   The target has created a child process.
+
+.. data:: CaptureProgress
+
+  The target is writing a capture to disk in the background.
+
+.. data:: APICallStats
+
+  The target sent its latest per API call statistics, see
+  :data:`CaptureOptions.ProfileAPICalls`.
+
+.. data:: Telemetry
+
+  The target sent its periodic frame time and memory telemetry.
 )");
 enum class TargetControlMessageType : uint32_t
 {
@@ -3084,6 +3216,9 @@ enum class TargetControlMessageType : uint32_t
   CaptureCopied,
   RegisterAPI,
   NewChild,
+  CaptureProgress,
+  APICallStats,
+  Telemetry,
 };
 
 DOCUMENT(R"(How to modify an environment variable.
@@ -3217,4 +3352,39 @@ enum class VulkanLayerFlags : uint32_t
   Unfixable = 0x40,
 };
 
-BITMASK_OPERATORS(VulkanLayerFlags);
\ No newline at end of file
+BITMASK_OPERATORS(VulkanLayerFlags);
+
+DOCUMENT(R"(A set of flags selecting what to gather for each event in
+:meth:`ReplayController.GetEventData`.
+
+.. data:: NoFlags
+
+  Only the event IDs are returned.
+
+.. data:: PipelineState
+
+  The API pipeline state at the event, as returned by e.g.
+  :meth:`ReplayController.GetD3D11PipelineState`.
+
+.. data:: BoundResources
+
+  The textures and buffers used by the event, and how they're used.
+
+.. data:: ConstantBuffers
+
+  The contents of every constant block read by the shaders bound at the event.
+
+.. data:: Counters
+
+  The results of the requested GPU counters for the event.
+)");
+enum class EventDataFlags : uint32_t
+{
+  NoFlags = 0x0,
+  PipelineState = 0x1,
+  BoundResources = 0x2,
+  ConstantBuffers = 0x4,
+  Counters = 0x8,
+};
+
+BITMASK_OPERATORS(EventDataFlags);
\ No newline at end of file
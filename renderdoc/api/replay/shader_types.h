@@ -218,9 +218,58 @@ shader execution happened will have ``nextInstruction == 0``.)");
 
 DECLARE_REFLECTION_STRUCT(ShaderDebugState);
 
+DOCUMENT("Describes the new value of a single variable that changed in a debugging step.");
+struct ShaderRegisterChange
+{
+  DOCUMENT("The index of the variable that changed, in its list in :class:`ShaderDebugState`.");
+  uint32_t index;
+  DOCUMENT(R"(For indexable temporaries, the index of the array in
+:data:`ShaderDebugState.indexableTemps` that contains the variable. Otherwise this is 0.
+)");
+  uint32_t arrayIndex;
+  DOCUMENT("The new value of the variable.");
+  ShaderValue value;
+};
+
+DECLARE_REFLECTION_STRUCT(ShaderRegisterChange);
+
+DOCUMENT(R"(The changes made by one step of shader execution, relative to the state at the previous
+step.
+
+The full :class:`ShaderDebugState` for any step can be rebuilt from these with
+:func:`ShaderDebug_ReconstructState`.
+)");
+struct ShaderDebugStateDelta
+{
+  DOCUMENT(R"(The temporary variables that changed as a list of :class:`ShaderRegisterChange`, indexing
+into :data:`ShaderDebugState.registers`.
+)");
+  rdctype::array<ShaderRegisterChange> registers;
+  DOCUMENT(R"(The output variables that changed as a list of :class:`ShaderRegisterChange`, indexing
+into :data:`ShaderDebugState.outputs`.
+)");
+  rdctype::array<ShaderRegisterChange> outputs;
+  DOCUMENT(R"(The indexable temporary variables that changed as a list of
+:class:`ShaderRegisterChange`, indexing into :data:`ShaderDebugState.indexableTemps`.
+)");
+  rdctype::array<ShaderRegisterChange> indexableTemps;
+
+  DOCUMENT("The same as :data:`ShaderDebugState.nextInstruction` for this step.");
+  uint32_t nextInstruction;
+
+  DOCUMENT("The same as :data:`ShaderDebugState.flags` for this step.");
+  ShaderEvents flags;
+};
+
+DECLARE_REFLECTION_STRUCT(ShaderDebugStateDelta);
+
 DOCUMENT(R"(This stores the whole state of a shader's execution from start to finish, with each
 individual debugging step along the way, as well as the immutable global constant values that do not
 change with shader execution.
+
+Steps are stored compactly as the changes from the previous step, with a full state stored every
+:data:`keyframeInterval` steps. Use :func:`ShaderDebug_ReconstructState` to get the
+:class:`ShaderDebugState` at any step.
 )");
 struct ShaderDebugTrace
 {
@@ -233,14 +282,66 @@ Each entry in this list corresponds to a constant block with the same index in t
 )");
   rdctype::array<rdctype::array<ShaderVariable> > cbuffers;
 
-  DOCUMENT(R"(A list of :class:`ShaderDebugState` states representing the state after each
-instruction was executed
+  DOCUMENT(R"(A list of :class:`ShaderDebugStateDelta` representing the changes made by each
+instruction that was executed. The first entry is the initial state before any instructions.
+
+The number of entries is the number of steps in the trace, and is 0 if debugging failed.
+)");
+  rdctype::array<ShaderDebugStateDelta> steps;
+
+  DOCUMENT(R"(A list of :class:`ShaderDebugState` holding the full state at every
+:data:`keyframeInterval` step, so ``keyframes[i]`` is the state at step ``i * keyframeInterval``.
 )");
-  rdctype::array<ShaderDebugState> states;
+  rdctype::array<ShaderDebugState> keyframes;
+
+  DOCUMENT("The number of steps between each full state in :data:`keyframes`.");
+  uint32_t keyframeInterval = 1;
+
+  DOCUMENT(R"(A listing of the program that :data:`ShaderDebugState.nextInstruction` indexes into,
+for APIs where the shader's own disassembly doesn't map one line per instruction. Empty otherwise.
+)");
+  rdctype::str disassembly;
 };
 
 DECLARE_REFLECTION_STRUCT(ShaderDebugTrace);
 
+DOCUMENT(R"(Identifies one vertex to debug as part of a batch, see
+:meth:`ReplayController.DebugVertices`.
+)");
+struct ShaderDebugVertexInput
+{
+  DOCUMENT("The vertex ID as a 0-based index up to the number of vertices in the draw.");
+  uint32_t vertid = 0;
+  DOCUMENT("The instance ID as a 0-based index up to the number of instances in the draw.");
+  uint32_t instid = 0;
+  DOCUMENT(R"(The actual index used to look up vertex inputs, either from the vertex ID for non-
+indexed draws or drawn from the index buffer. This must have all drawcall offsets applied.
+)");
+  uint32_t idx = 0;
+};
+
+DECLARE_REFLECTION_STRUCT(ShaderDebugVertexInput);
+
+DOCUMENT(R"(Identifies one pixel to debug as part of a batch, see
+:meth:`ReplayController.DebugPixels`.
+)");
+struct ShaderDebugPixelInput
+{
+  DOCUMENT("The x co-ordinate.");
+  uint32_t x = 0;
+  DOCUMENT("The y co-ordinate.");
+  uint32_t y = 0;
+  DOCUMENT("The multi-sampled sample. Ignored if non-multisampled texture.");
+  uint32_t sample = ~0U;
+  DOCUMENT(R"(Debug the pixel from this primitive if there's ambiguity. If set to
+:data:`ReplayController.NoPreference` then a random fragment writing to the given co-ordinate is
+debugged.
+)");
+  uint32_t primitive = ~0U;
+};
+
+DECLARE_REFLECTION_STRUCT(ShaderDebugPixelInput);
+
 DOCUMENT(R"(The information describing an input or output signature element describing the interface
 between shader stages.
 
@@ -465,6 +566,70 @@ struct ShaderDebugChunk
 
 DECLARE_REFLECTION_STRUCT(ShaderDebugChunk);
 
+DOCUMENT(R"(A static estimate of how expensive a shader is, from counting the instructions in its
+bytecode by class.
+
+Each instruction is counted once regardless of how many times it might run, so loops and branches
+are only described by :data:`loops` and :data:`maxLoopDepth`. The counts are of API-level
+instructions, before the driver compiles the shader for the hardware, so they are best used to
+compare shaders against each other rather than as an absolute cost.
+
+This is not available for OpenGL shaders, where all the counts are ``0``.
+)");
+struct ShaderCost
+{
+  ShaderCost()
+      : instructions(0),
+        aluInstructions(0),
+        transcendentalInstructions(0),
+        sampleInstructions(0),
+        memoryInstructions(0),
+        flowControlInstructions(0),
+        tempRegisters(0),
+        loops(0),
+        maxLoopDepth(0)
+  {
+  }
+
+  DOCUMENT("The total number of instructions counted in all of the classes below.");
+  uint32_t instructions;
+
+  DOCUMENT("The number of arithmetic, logic, conversion and move instructions.");
+  uint32_t aluInstructions;
+
+  DOCUMENT(R"(The number of transcendental instructions such as divisions, reciprocals, square
+roots, exponents, logarithms and trigonometric functions.
+)");
+  uint32_t transcendentalInstructions;
+
+  DOCUMENT("The number of texture sample and gather instructions, which go through a sampler.");
+  uint32_t sampleInstructions;
+
+  DOCUMENT(R"(The number of other memory instructions - texture fetches and buffer or image loads,
+stores and atomics.
+)");
+  uint32_t memoryInstructions;
+
+  DOCUMENT(R"(The number of flow control instructions that depend on data - conditional branches,
+switches, function calls and discards.
+)");
+  uint32_t flowControlInstructions;
+
+  DOCUMENT(R"(An estimate of register pressure. For DXBC this is the number of declared temporary
+registers including indexable temps. SPIR-V is in SSA form so registers are allocated entirely by
+the driver, and this is the number of function-local variables instead.
+)");
+  uint32_t tempRegisters;
+
+  DOCUMENT("The number of loops in the shader.");
+  uint32_t loops;
+
+  DOCUMENT("How deeply the most deeply nested loop is nested, or ``0`` if there are no loops.");
+  uint32_t maxLoopDepth;
+};
+
+DECLARE_REFLECTION_STRUCT(ShaderCost);
+
 DOCUMENT(R"(The reflection and metadata fully describing a shader.
 
 The information in this structure is API agnostic, and is matched up against a
@@ -502,10 +667,40 @@ struct ShaderReflection
   // TODO expand this to encompass shader subroutines.
   DOCUMENT("A list of strings with the shader's interfaces. Largely an unused API feature.");
   rdctype::array<rdctype::str> Interfaces;
+
+  DOCUMENT("A :class:`ShaderCost` with a static estimate of how expensive this shader is.");
+  ShaderCost Cost;
 };
 
 DECLARE_REFLECTION_STRUCT(ShaderReflection);
 
+DOCUMENT(R"(The static shader cost of a single drawcall or dispatch, as returned by
+:meth:`ReplayController.GetDrawcallShaderCosts`.
+)");
+struct DrawcallShaderCost
+{
+  DOCUMENT("The :data:`EID <APIEvent.eventID>` of the drawcall or dispatch.");
+  uint32_t eventID;
+
+  DOCUMENT(R"(The :class:`ResourceId` of the shader bound at each stage, indexed by
+:class:`ShaderStage`. Stages with no shader bound have a null ID.
+)");
+  rdctype::array<ResourceId> shaders;
+
+  DOCUMENT(R"(The :class:`ShaderCost` of the shader bound at each stage, indexed by
+:class:`ShaderStage`. Stages with no shader bound have a zero cost.
+)");
+  rdctype::array<ShaderCost> stageCosts;
+
+  DOCUMENT(R"(The :class:`ShaderCost` of all the bound shaders combined. Instruction and loop counts
+are summed over the stages, while :data:`ShaderCost.tempRegisters` and
+:data:`ShaderCost.maxLoopDepth` are the largest of any stage.
+)");
+  ShaderCost cost;
+};
+
+DECLARE_REFLECTION_STRUCT(DrawcallShaderCost);
+
 DOCUMENT(R"(Declares the binding information for a single resource binding.
 
 See :class:`ShaderBindpointMapping` for how this mapping works in detail.
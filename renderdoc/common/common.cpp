@@ -25,6 +25,7 @@
 
 #include "common.h"
 #include <stdarg.h>
+#include <algorithm>
 #include <string.h>
 #include <string>
 #include "common/threading.h"
@@ -84,143 +85,362 @@ void rdcassert(const char *msg, const char *file, unsigned int line, const char
   rdclog_int(LogType::Error, RDCLOG_PROJECT, file, line, "Assertion failed: %s", msg);
 }
 
-#if 0
-static __m128 zero = {0};
+// FindDiffRange is the hot path for tracking writes to persistent/coherent maps, so it has SIMD
+// implementations selected at runtime based on the CPU. Each implementation provides a pair of
+// functions - one sweeping forwards for the first differing byte, one sweeping backwards for the
+// last. Neither requires any particular alignment.
+
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#define DIFF_RANGE_X86 OPTION_ON
+#else
+#define DIFF_RANGE_X86 OPTION_OFF
 #endif
 
-// assumes a and b both point to 16-byte aligned 16-byte chunks of memory.
-// Returns if they're equal or different
-bool Vec16NotEqual(void *a, void *b)
-{
-// disabled SSE version as it's acting dodgy
-#if 0
-	__m128 avec = _mm_load_ps(aflt);
-	__m128 bvec = _mm_load_ps(bflt);
-
-	__m128 diff = _mm_xor_ps(avec, bvec);
-
-	__m128 eq = _mm_cmpeq_ps(diff, zero);
-	int mask = _mm_movemask_ps(eq);
-	int signMask = _mm_movemask_ps(diff);
-
-	// first check ensures that diff is floatequal to zero (ie. avec bitwise equal to bvec).
-	// HOWEVER -0 is floatequal to 0, so we ensure no sign bits are set on diff
-	if((mask^0xf) || signMask != 0)
-	{
-		return true;
-	}
-	
-	return false;
-#elif ENABLED(RDOC_X64)
-  uint64_t *a64 = (uint64_t *)a;
-  uint64_t *b64 = (uint64_t *)b;
-
-  return a64[0] != b64[0] || a64[1] != b64[1];
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define DIFF_RANGE_NEON OPTION_ON
 #else
-  uint32_t *a32 = (uint32_t *)a;
-  uint32_t *b32 = (uint32_t *)b;
+#define DIFF_RANGE_NEON OPTION_OFF
+#endif
+
+#if ENABLED(DIFF_RANGE_X86)
+
+#include <emmintrin.h>
+#include <immintrin.h>
 
-  return a32[0] != b32[0] || a32[1] != b32[1] || a32[2] != b32[2] || a32[3] != b32[3];
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define DIFF_RANGE_AVX2_FUNC
+#else
+#include <cpuid.h>
+#define DIFF_RANGE_AVX2_FUNC __attribute__((target("avx2")))
 #endif
-}
 
-bool FindDiffRange(void *a, void *b, size_t bufSize, size_t &diffStart, size_t &diffEnd)
+#elif ENABLED(DIFF_RANGE_NEON)
+
+#include <arm_neon.h>
+
+#endif
+
+// returns the offset of the first byte that differs, or size if they're identical
+typedef size_t (*FirstDiffFunc)(const byte *a, const byte *b, size_t size);
+// returns one past the offset of the last byte that differs, or 0 if they're identical
+typedef size_t (*LastDiffFunc)(const byte *a, const byte *b, size_t size);
+
+static size_t FirstDiff_Scalar(const byte *a, const byte *b, size_t size)
 {
-  RDCASSERT(uintptr_t(a) % 16 == 0);
-  RDCASSERT(uintptr_t(b) % 16 == 0);
+  size_t i = 0;
+
+  for(; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+  {
+    uint64_t a64, b64;
+    memcpy(&a64, a + i, sizeof(uint64_t));
+    memcpy(&b64, b + i, sizeof(uint64_t));
 
-  diffStart = bufSize + 1;
-  diffEnd = 0;
+    if(a64 != b64)
+      break;
+  }
 
-  size_t alignedSize = bufSize & (~0xf);
-  size_t numVecs = alignedSize / 16;
+  for(; i < size; i++)
+    if(a[i] != b[i])
+      return i;
 
-  size_t offs = 0;
+  return size;
+}
 
-  float *aflt = (float *)a;
-  float *bflt = (float *)b;
+static size_t LastDiff_Scalar(const byte *a, const byte *b, size_t size)
+{
+  size_t i = size;
 
-  // sweep to find the start of differences
-  for(size_t v = 0; v < numVecs; v++)
+  for(; i >= sizeof(uint64_t); i -= sizeof(uint64_t))
   {
-    if(Vec16NotEqual(aflt, bflt))
-    {
-      diffStart = offs;
+    uint64_t a64, b64;
+    memcpy(&a64, a + i - sizeof(uint64_t), sizeof(uint64_t));
+    memcpy(&b64, b + i - sizeof(uint64_t), sizeof(uint64_t));
+
+    if(a64 != b64)
       break;
-    }
+  }
+
+  for(; i > 0; i--)
+    if(a[i - 1] != b[i - 1])
+      return i;
+
+  return 0;
+}
+
+#if ENABLED(DIFF_RANGE_X86)
+
+// the byte-wise comparison gives a bit per byte in the movemask, so the position of the first and
+// last differing byte within a vector comes straight from a bit scan.
+
+static size_t FirstDiff_SSE2(const byte *a, const byte *b, size_t size)
+{
+  size_t i = 0;
 
-    aflt += 4;
-    bflt += 4;
-    offs += 4 * sizeof(float);
+  for(; i + 16 <= size; i += 16)
+  {
+    __m128i avec = _mm_loadu_si128((const __m128i *)(a + i));
+    __m128i bvec = _mm_loadu_si128((const __m128i *)(b + i));
+
+    uint32_t mask = uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(avec, bvec))) ^ 0xffff;
+
+    if(mask)
+      return i + Bits::CountTrailingZeroes(mask);
   }
 
-  // make sure we're byte-accurate, to comply with WRITE_NO_OVERWRITE
-  while(diffStart < bufSize && *((byte *)a + diffStart) == *((byte *)b + diffStart))
-    diffStart++;
+  return i + FirstDiff_Scalar(a + i, b + i, size - i);
+}
 
-  // do we have some unaligned bytes at the end of the buffer?
-  if(bufSize > alignedSize)
+static size_t LastDiff_SSE2(const byte *a, const byte *b, size_t size)
+{
+  size_t i = size;
+
+  for(; i >= 16; i -= 16)
   {
-    size_t numBytes = bufSize - alignedSize;
+    __m128i avec = _mm_loadu_si128((const __m128i *)(a + i - 16));
+    __m128i bvec = _mm_loadu_si128((const __m128i *)(b + i - 16));
 
-    // if we haven't even found a start, check in these bytes
-    if(diffStart > bufSize)
-    {
-      offs = bufSize;
-
-      for(size_t by = 0; by < numBytes; by++)
-      {
-        if(*((byte *)a + alignedSize + by) != *((byte *)b + alignedSize + by))
-        {
-          diffStart = offs;
-          break;
-        }
-
-        offs++;
-      }
-    }
+    uint32_t mask = uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(avec, bvec))) ^ 0xffff;
 
-    // sweep from the last byte to find the end
-    for(size_t by = 0; by < numBytes; by++)
-    {
-      if(*((byte *)a + bufSize - 1 - by) != *((byte *)b + bufSize - 1 - by))
-      {
-        diffEnd = bufSize - by;
-        break;
-      }
-    }
+    if(mask)
+      return i - 16 + (32 - Bits::CountLeadingZeroes(mask));
   }
 
-  // if we haven't found a start, or we've found a start AND and end,
-  // then we're done.
-  if(diffStart > bufSize || diffEnd > 0)
-    return diffStart < bufSize;
+  return LastDiff_Scalar(a, b, i);
+}
+
+DIFF_RANGE_AVX2_FUNC static size_t FirstDiff_AVX2(const byte *a, const byte *b, size_t size)
+{
+  size_t i = 0;
+
+  for(; i + 32 <= size; i += 32)
+  {
+    __m256i avec = _mm256_loadu_si256((const __m256i *)(a + i));
+    __m256i bvec = _mm256_loadu_si256((const __m256i *)(b + i));
+
+    uint32_t mask = ~uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(avec, bvec)));
 
-  offs = alignedSize;
+    if(mask)
+      return i + Bits::CountTrailingZeroes(mask);
+  }
+
+  return i + FirstDiff_SSE2(a + i, b + i, size - i);
+}
 
-  // sweep from the last __m128
-  aflt = (float *)a + offs / sizeof(float) - 4;
-  bflt = (float *)b + offs / sizeof(float) - 4;
+DIFF_RANGE_AVX2_FUNC static size_t LastDiff_AVX2(const byte *a, const byte *b, size_t size)
+{
+  size_t i = size;
 
-  for(size_t v = 0; v < numVecs; v++)
+  for(; i >= 32; i -= 32)
   {
-    if(Vec16NotEqual(aflt, bflt))
-    {
-      diffEnd = offs;
+    __m256i avec = _mm256_loadu_si256((const __m256i *)(a + i - 32));
+    __m256i bvec = _mm256_loadu_si256((const __m256i *)(b + i - 32));
+
+    uint32_t mask = ~uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(avec, bvec)));
+
+    if(mask)
+      return i - 32 + (32 - Bits::CountLeadingZeroes(mask));
+  }
+
+  return LastDiff_SSE2(a, b, i);
+}
+
+static void CPUID(uint32_t leaf, uint32_t regs[4])
+{
+#if defined(_MSC_VER)
+  __cpuidex((int *)regs, (int)leaf, 0);
+#else
+  __cpuid_count(leaf, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+bool CPUSupportsSSE2()
+{
+  uint32_t regs[4] = {};
+  CPUID(0, regs);
+
+  if(regs[0] < 1)
+    return false;
+
+  CPUID(1, regs);
+
+  return (regs[3] & (1U << 26)) != 0;
+}
+
+static bool OSSupportsAVX()
+{
+  uint32_t regs[4] = {};
+  CPUID(0, regs);
+
+  if(regs[0] < 1)
+    return false;
+
+  CPUID(1, regs);
+
+  // the OS must have enabled AVX state saving via XSAVE, as well as the CPU supporting it
+  const uint32_t osxsave = (1U << 27), avx = (1U << 28);
+  if((regs[2] & (osxsave | avx)) != (osxsave | avx))
+    return false;
+
+#if defined(_MSC_VER)
+  uint64_t xcr0 = _xgetbv(0);
+#else
+  uint32_t xcr0lo = 0, xcr0hi = 0;
+  __asm__ __volatile__("xgetbv" : "=a"(xcr0lo), "=d"(xcr0hi) : "c"(0));
+  uint64_t xcr0 = (uint64_t(xcr0hi) << 32) | xcr0lo;
+#endif
+
+  // XMM and YMM state
+  return (xcr0 & 0x6) == 0x6;
+}
+
+bool CPUSupportsAVX2()
+{
+  uint32_t regs[4] = {};
+  CPUID(0, regs);
+
+  if(regs[0] < 7 || !OSSupportsAVX())
+    return false;
+
+  CPUID(7, regs);
+
+  return (regs[1] & (1U << 5)) != 0;
+}
+
+bool CPUSupportsF16C()
+{
+  // F16C instructions are VEX encoded, so need the same OS support as AVX
+  if(!OSSupportsAVX())
+    return false;
+
+  uint32_t regs[4] = {};
+  CPUID(1, regs);
+
+  return (regs[2] & (1U << 29)) != 0;
+}
+
+#else
+
+bool CPUSupportsSSE2()
+{
+  return false;
+}
+
+bool CPUSupportsAVX2()
+{
+  return false;
+}
+
+bool CPUSupportsF16C()
+{
+  return false;
+}
+
+#endif
+
+#if ENABLED(DIFF_RANGE_NEON)
+
+// NEON has no movemask, so find the vector containing a difference then locate the byte within it
+// with the scalar path.
+
+static bool NEONNotEqual(const byte *a, const byte *b)
+{
+  uint64x2_t eq = vreinterpretq_u64_u8(vceqq_u8(vld1q_u8(a), vld1q_u8(b)));
+
+  return (vgetq_lane_u64(eq, 0) & vgetq_lane_u64(eq, 1)) != ~0ULL;
+}
+
+static size_t FirstDiff_NEON(const byte *a, const byte *b, size_t size)
+{
+  size_t i = 0;
+
+  for(; i + 16 <= size; i += 16)
+    if(NEONNotEqual(a + i, b + i))
+      break;
+
+  return i + FirstDiff_Scalar(a + i, b + i, size - i);
+}
+
+static size_t LastDiff_NEON(const byte *a, const byte *b, size_t size)
+{
+  size_t i = size;
+
+  for(; i >= 16; i -= 16)
+    if(NEONNotEqual(a + i - 16, b + i - 16))
       break;
-    }
 
-    aflt -= 4;
-    bflt -= 4;
-    offs -= 16;
+  return LastDiff_Scalar(a, b, i);
+}
+
+#endif
+
+template <FirstDiffFunc firstDiff, LastDiffFunc lastDiff>
+static bool FindDiffRangeImpl(void *a, void *b, size_t bufSize, size_t &diffStart, size_t &diffEnd)
+{
+  const byte *abyte = (const byte *)a;
+  const byte *bbyte = (const byte *)b;
+
+  diffStart = firstDiff(abyte, bbyte, bufSize);
+
+  if(diffStart >= bufSize)
+  {
+    diffStart = bufSize + 1;
+    diffEnd = 0;
+    return false;
+  }
+
+  // there's at least one difference, so only the bytes after the start need to be searched for
+  // the end. The results are byte-accurate, to comply with WRITE_NO_OVERWRITE
+  diffEnd = diffStart + lastDiff(abyte + diffStart, bbyte + diffStart, bufSize - diffStart);
+
+  return true;
+}
+
+static const DiffRangeImplementation diffRangeImpls[] = {
+    {"Scalar", &FindDiffRangeImpl<&FirstDiff_Scalar, &LastDiff_Scalar>},
+#if ENABLED(DIFF_RANGE_X86)
+    {"SSE2", &FindDiffRangeImpl<&FirstDiff_SSE2, &LastDiff_SSE2>},
+    {"AVX2", &FindDiffRangeImpl<&FirstDiff_AVX2, &LastDiff_AVX2>},
+#elif ENABLED(DIFF_RANGE_NEON)
+    {"NEON", &FindDiffRangeImpl<&FirstDiff_NEON, &LastDiff_NEON>},
+#endif
+};
+
+static size_t CountSupportedDiffRangeImpls()
+{
+  size_t count = 1;
+
+#if ENABLED(DIFF_RANGE_X86)
+  if(CPUSupportsSSE2())
+  {
+    count++;
+
+    if(CPUSupportsAVX2())
+      count++;
   }
+#elif ENABLED(DIFF_RANGE_NEON)
+  count++;
+#endif
+
+  return count;
+}
+
+size_t GetDiffRangeImplementations(const DiffRangeImplementation **impls)
+{
+  static const size_t count = CountSupportedDiffRangeImpls();
 
-  // make sure we're byte-accurate, to comply with WRITE_NO_OVERWRITE
-  while(diffEnd > 0 && *((byte *)a + diffEnd - 1) == *((byte *)b + diffEnd - 1))
-    diffEnd--;
+  if(impls)
+    *impls = diffRangeImpls;
 
-  // if we found a start then we necessarily found an end
-  return diffStart < bufSize;
+  return count;
+}
+
+bool FindDiffRange(void *a, void *b, size_t bufSize, size_t &diffStart, size_t &diffEnd)
+{
+  static const DiffRangeImplementation &impl =
+      diffRangeImpls[GetDiffRangeImplementations(NULL) - 1];
+
+  return impl.func(a, b, bufSize, diffStart, diffEnd);
 }
 
 uint32_t CalcNumMips(int w, int h, int d)
@@ -255,6 +475,300 @@ uint64_t Log2Floor(uint64_t value)
 static string logfile;
 static void *logfileHandle = NULL;
 
+static bool log_output_enabled = false;
+
+// Once output is enabled, logging is asynchronous. Each thread formats its messages into its own
+// ring buffer and a background thread writes them out, so that logging from a hot path doesn't
+// stall on the log file or on other threads logging. Messages are numbered as they're logged so
+// they're still written in order across threads. A thread can take a number and not have published
+// its message yet, so anything after a gap in the numbering is held back until the gap is filled.
+//
+// rdclog_flush() writes everything pending immediately. It's called after errors, fatal errors
+// and asserts. On a crash everything is written out, gaps or not: the crash handler does this
+// before writing a minidump on windows, and a signal handler does it elsewhere.
+
+// must be a power of two
+static const uint32_t LogRingSize = 32 * 1024;
+
+// threads are never tidied up, so don't let a program that keeps creating new threads use up
+// unbounded memory. Any threads beyond this log synchronously
+static const int32_t MaxLogRings = 64;
+
+// any more than this many repeats of the same message from the same place in a second on one thread
+// are dropped, with a count of how many were dropped logged afterwards. Errors are never dropped.
+static const uint32_t LogRateLimit = 20;
+static const double LogRateWindowMS = 1000.0;
+static const uint32_t LogRateEntries = 16;
+
+const int rdclog_outBufSize = 4 * 1024;
+
+struct LogMessageHeader
+{
+  int64_t seq;
+  LogType type;
+  uint32_t length;
+  uint32_t prefixLength;
+  uint32_t padding;
+};
+
+struct LogRateEntry
+{
+  const char *file;
+  unsigned int line;
+  uint64_t msgHash;
+  uint32_t count;
+  uint32_t suppressed;
+  uint64_t windowStart;
+};
+
+struct LogThreadState
+{
+  // only written by the owning thread
+  volatile int64_t writePos;
+  // only written while holding the flush lock
+  volatile int64_t readPos;
+  byte ring[LogRingSize];
+
+  LogRateEntry rate[LogRateEntries];
+  // set while logging a message about rate limiting, so it isn't limited itself
+  bool rateLimitNotice;
+
+  // +2 for the trailing newline and NULL terminator
+  char format[rdclog_outBufSize + 2];
+};
+
+struct PendingLogMessage
+{
+  int64_t seq;
+  LogType type;
+  uint32_t prefixLength;
+  string msg;
+
+  bool operator<(const PendingLogMessage &o) const { return seq < o.seq; }
+};
+
+static volatile int32_t log_async = 0;
+static uint64_t logStateSlot = 0;
+static LogThreadState *logRings[MaxLogRings] = {};
+static volatile int32_t numLogRings = 0;
+static volatile int64_t logSequence = 0;
+
+// only accessed with the flush lock held. The last message written, and messages read from the
+// rings that are waiting for an earlier one to be published
+static int64_t logWrittenSeq = 0;
+static vector<PendingLogMessage> logHeldBack;
+
+static Threading::ThreadHandle logFlushThread = 0;
+static volatile int32_t logFlushThreadStop = 0;
+static volatile int32_t logFlushThreadRunning = 0;
+
+// serialises reading from the rings, and writing to or changing the log file
+static Threading::CriticalSection &LogFlushLock()
+{
+  // function-local so it's usable no matter when the first log happens during static init
+  static Threading::CriticalSection lock;
+  return lock;
+}
+
+static LogThreadState *GetLogThreadState()
+{
+  if(log_async == 0)
+    return NULL;
+
+  LogThreadState *state = (LogThreadState *)Threading::GetTLSValue(logStateSlot);
+
+  if(state || numLogRings >= MaxLogRings)
+    return state;
+
+  int32_t idx = Atomic::Inc32(&numLogRings) - 1;
+
+  if(idx >= MaxLogRings)
+    return NULL;
+
+  state = new LogThreadState;
+  RDCEraseMem(state, sizeof(LogThreadState));
+
+  logRings[idx] = state;
+  Threading::SetTLSValue(logStateSlot, state);
+
+  return state;
+}
+
+static void RingRead(LogThreadState *state, int64_t pos, void *dst, size_t size)
+{
+  size_t offs = size_t(pos & (LogRingSize - 1));
+  size_t first = RDCMIN(size, LogRingSize - offs);
+
+  memcpy(dst, state->ring + offs, first);
+  memcpy((byte *)dst + first, state->ring, size - first);
+}
+
+static void RingWrite(LogThreadState *state, int64_t pos, const void *src, size_t size)
+{
+  size_t offs = size_t(pos & (LogRingSize - 1));
+  size_t first = RDCMIN(size, LogRingSize - offs);
+
+  memcpy(state->ring + offs, src, first);
+  memcpy(state->ring, (const byte *)src + first, size - first);
+}
+
+// adds a message to this thread's ring, returns false if there isn't room for it
+static bool EnqueueLog(LogThreadState *state, LogType type, const char *msg, uint32_t length,
+                       uint32_t prefixLength)
+{
+  int64_t size = (int64_t)AlignUp((uint64_t)sizeof(LogMessageHeader) + length, (uint64_t)8);
+
+  int64_t writePos = state->writePos;
+  int64_t readPos = Atomic::ExchAdd64(&state->readPos, 0);
+
+  if(writePos - readPos + size > LogRingSize)
+    return false;
+
+  LogMessageHeader header = {};
+  header.seq = Atomic::Inc64(&logSequence);
+  header.type = type;
+  header.length = length;
+  header.prefixLength = prefixLength;
+
+  RingWrite(state, writePos, &header, sizeof(header));
+  RingWrite(state, writePos + sizeof(header), msg, length);
+
+  // publish the message only once it's completely written
+  Atomic::ExchAdd64(&state->writePos, size);
+
+  return true;
+}
+
+// must be called with the flush lock held. Unless all is set, messages after a gap in the sequence
+// are held back until the message filling it is published.
+static void FlushPendingLogs(bool all = false)
+{
+  // writing out can log errors itself, which flush again. Let the outer flush finish instead of
+  // reading the same messages twice
+  static bool flushing = false;
+  if(flushing)
+    return;
+  flushing = true;
+
+  vector<PendingLogMessage> pending;
+  pending.swap(logHeldBack);
+
+  int32_t numRings = RDCMIN(int32_t(numLogRings), MaxLogRings);
+
+  for(int32_t i = 0; i < numRings; i++)
+  {
+    LogThreadState *state = logRings[i];
+
+    // may not be set up yet, if the thread is in the middle of creating it
+    if(state == NULL)
+      continue;
+
+    int64_t writePos = Atomic::ExchAdd64(&state->writePos, 0);
+    int64_t readPos = state->readPos;
+
+    if(readPos == writePos)
+      continue;
+
+    for(int64_t pos = readPos; pos < writePos;)
+    {
+      LogMessageHeader header;
+      RingRead(state, pos, &header, sizeof(header));
+
+      PendingLogMessage msg;
+      msg.seq = header.seq;
+      msg.type = header.type;
+      msg.prefixLength = header.prefixLength;
+      msg.msg.resize(header.length);
+      RingRead(state, pos + sizeof(header), &msg.msg[0], header.length);
+
+      pending.push_back(msg);
+
+      pos += (int64_t)AlignUp((uint64_t)sizeof(LogMessageHeader) + header.length, (uint64_t)8);
+    }
+
+    // let the thread re-use the space
+    Atomic::ExchAdd64(&state->readPos, writePos - readPos);
+  }
+
+  std::sort(pending.begin(), pending.end());
+
+  size_t i = 0;
+  for(; i < pending.size(); i++)
+  {
+    if(!all && pending[i].seq > logWrittenSeq + 1)
+      break;
+
+    logWrittenSeq = RDCMAX(logWrittenSeq, pending[i].seq);
+
+    rdclogprint_int(pending[i].type, pending[i].msg.c_str(),
+                    pending[i].msg.c_str() + pending[i].prefixLength);
+  }
+
+  logHeldBack.insert(logHeldBack.end(), pending.begin() + i, pending.end());
+
+  flushing = false;
+}
+
+static void LogFlushThreadEntry(void *)
+{
+  while(logFlushThreadStop == 0)
+  {
+    Threading::Sleep(10);
+
+    rdclog_flush();
+  }
+
+  Atomic::Dec32(&logFlushThreadRunning);
+}
+
+static uint64_t HashLogMessage(const char *msg, const char *end)
+{
+  // FNV-1a
+  uint64_t hash = 14695981039346656037ULL;
+  for(; msg < end; msg++)
+    hash = (hash ^ (byte)*msg) * 1099511628211ULL;
+  return hash;
+}
+
+// returns true if this message should be dropped because it's been repeated from the same place
+// too often recently. If that's the first repeat dropped, startedDropping is set. When a different
+// message takes over the entry, any repeats dropped of the previous one are returned in expired so
+// the caller can log how many there were.
+static bool RateLimitLog(LogThreadState *state, LogType type, const char *file, unsigned int line,
+                         uint64_t msgHash, LogRateEntry &expired, bool &startedDropping)
+{
+  if(type >= LogType::Error || state->rateLimitNotice)
+    return false;
+
+  static const double windowTicks = Timing::GetTickFrequency() * LogRateWindowMS;
+
+  uint64_t now = Timing::GetTick();
+
+  LogRateEntry &entry = state->rate[(uintptr_t(file) ^ line) % LogRateEntries];
+
+  if(entry.file != file || entry.line != line || entry.msgHash != msgHash ||
+     double(now - entry.windowStart) > windowTicks)
+  {
+    expired = entry;
+
+    entry.file = file;
+    entry.line = line;
+    entry.msgHash = msgHash;
+    entry.count = 0;
+    entry.suppressed = 0;
+    entry.windowStart = now;
+  }
+
+  if(entry.count >= LogRateLimit)
+  {
+    startedDropping = (entry.suppressed++ == 0);
+    return true;
+  }
+
+  entry.count++;
+  return false;
+}
+
 const char *rdclog_getfilename()
 {
   return logfile.c_str();
@@ -262,6 +776,11 @@ const char *rdclog_getfilename()
 
 void rdclog_filename(const char *filename)
 {
+  SCOPED_LOCK(LogFlushLock());
+
+  // anything pending belongs in the previous file
+  FlushPendingLogs();
+
   string previous = logfile;
 
   logfile = "";
@@ -269,6 +788,7 @@ void rdclog_filename(const char *filename)
     logfile = filename;
 
   FileIO::logfile_close(logfileHandle);
+  logfileHandle = NULL;
 
   if(!logfile.empty())
   {
@@ -288,22 +808,74 @@ void rdclog_filename(const char *filename)
   }
 }
 
-static bool log_output_enabled = false;
-
 void rdclog_enableoutput()
 {
   log_output_enabled = true;
+
+  if(logFlushThread == 0)
+  {
+    logStateSlot = Threading::AllocateTLSSlot();
+
+    logFlushThreadStop = 0;
+    logFlushThreadRunning = 1;
+    logFlushThread = Threading::CreateThread(&LogFlushThreadEntry, NULL);
+
+    if(logFlushThread)
+    {
+      log_async = 1;
+      Process::InstallCrashLogFlush();
+    }
+    else
+    {
+      logFlushThreadRunning = 0;
+    }
+  }
 }
 
 void rdclog_closelog()
 {
   log_output_enabled = false;
+
+  if(logFlushThread)
+  {
+    // from now on every thread logs synchronously
+    log_async = 0;
+    logFlushThreadStop = 1;
+
+    // as with other threads we can't join this on windows while the module is unloading, so give
+    // it a moment to notice instead
+    for(int i = 0; i < 20 && logFlushThreadRunning > 0; i++)
+      Threading::Sleep(5);
+
+    Threading::CloseThread(logFlushThread);
+    logFlushThread = 0;
+  }
+
+  SCOPED_LOCK(LogFlushLock());
+
+  // nothing is logged asynchronously any more, so there's nothing left to wait for
+  FlushPendingLogs(true);
+
   if(logfileHandle)
     FileIO::logfile_close(logfileHandle);
+  logfileHandle = NULL;
 }
 
 void rdclog_flush()
 {
+  SCOPED_LOCK(LogFlushLock());
+
+  FlushPendingLogs();
+}
+
+void rdclog_crashflush()
+{
+  // the crashing thread could have been in the middle of flushing, so don't wait on the lock
+  Threading::TryScopedLock lock(LogFlushLock());
+
+  // a thread that crashed part way through queueing a message would leave a gap forever
+  if(lock.HasLock())
+    FlushPendingLogs(true);
 }
 
 void rdclogprint_int(LogType type, const char *fullMsg, const char *msg)
@@ -334,12 +906,11 @@ void rdclogprint_int(LogType type, const char *fullMsg, const char *msg)
 #endif
 }
 
-const int rdclog_outBufSize = 4 * 1024;
-static char rdclog_outputBuffer[rdclog_outBufSize + 1];
-
 void rdclog_int(LogType type, const char *project, const char *file, unsigned int line,
                 const char *fmt, ...)
 {
+  LogThreadState *state = GetLogThreadState();
+
   va_list args;
   va_start(args, fmt);
 
@@ -363,13 +934,22 @@ void rdclog_int(LogType type, const char *project, const char *file, unsigned in
       "Debug  ", "Log    ", "Warning", "Error  ", "Fatal  ",
   };
 
-  static Threading::CriticalSection lock;
-
-  SCOPED_LOCK(lock);
+  // threads without their own state are rare enough to just allocate a buffer
+  vector<char> localBuffer;
+  char *outputBuffer = NULL;
+  if(state)
+  {
+    outputBuffer = state->format;
+  }
+  else
+  {
+    localBuffer.resize(rdclog_outBufSize + 2);
+    outputBuffer = &localBuffer[0];
+  }
 
-  rdclog_outputBuffer[rdclog_outBufSize] = rdclog_outputBuffer[0] = 0;
+  outputBuffer[rdclog_outBufSize] = outputBuffer[0] = 0;
 
-  char *output = rdclog_outputBuffer;
+  char *output = outputBuffer;
   size_t available = rdclog_outBufSize;
 
   const char *base = output;
@@ -393,6 +973,8 @@ void rdclog_int(LogType type, const char *project, const char *file, unsigned in
 
   int totalWritten = numWritten;
 
+  const char *msgBody = output;
+
   numWritten = StringFormat::vsnprintf(output, available, fmt, args);
 
   totalWritten += numWritten;
@@ -407,8 +989,8 @@ void rdclog_int(LogType type, const char *project, const char *file, unsigned in
 
   output += numWritten;
 
-  // we overran the static buffer. This is a 4k buffer so we won't be hitting this case often - just
-  // do the simple thing of allocating a temporary, print again, and re-assigning.
+  // we overran the buffer. This is a 4k buffer so we won't be hitting this case often - just do the
+  // simple thing of allocating a temporary, print again, and re-assigning.
   char *oversizedBuffer = NULL;
   if(totalWritten > rdclog_outBufSize)
   {
@@ -425,6 +1007,8 @@ void rdclog_int(LogType type, const char *project, const char *file, unsigned in
 
     noPrefixOutput = (output - 3 - (sizeof(typestr[(uint32_t)type]) - 1));
 
+    msgBody = output;
+
     numWritten = StringFormat::vsnprintf(output, available, fmt, args2);
 
     output += numWritten;
@@ -435,7 +1019,65 @@ void rdclog_int(LogType type, const char *project, const char *file, unsigned in
   *output = '\n';
   *(output + 1) = 0;
 
-  rdclogprint_int(type, base, noPrefixOutput);
+  uint32_t length = uint32_t(output + 1 - base);
+  uint32_t prefixLength = uint32_t(noPrefixOutput - base);
+
+  // repeats are compared without the prefix, since it has the time in it
+  if(state && type < LogType::Error && !state->rateLimitNotice)
+  {
+    LogRateEntry expired = {};
+    bool startedDropping = false;
+    bool drop = RateLimitLog(state, type, file, line, HashLogMessage(msgBody, output), expired,
+                             startedDropping);
+
+    if(expired.suppressed > 0 || startedDropping)
+    {
+      // the notices are formatted in this thread's buffer too, so keep a copy of this message
+      string saved(base, length);
+
+      state->rateLimitNotice = true;
+      if(expired.suppressed > 0)
+        rdclog_int(LogType::Warning, project, expired.file, expired.line,
+                   "%u messages suppressed, repeats of the same message", expired.suppressed);
+      if(startedDropping)
+        rdclog_int(LogType::Warning, project, file, line,
+                   "Same message logged too often, suppressing repeats for up to a second");
+      state->rateLimitNotice = false;
+
+      delete[] oversizedBuffer;
+      oversizedBuffer = new char[length + 1];
+      memcpy(oversizedBuffer, saved.c_str(), length + 1);
+
+      base = oversizedBuffer;
+      noPrefixOutput = base + prefixLength;
+    }
+
+    if(drop)
+    {
+      delete[] oversizedBuffer;
+      return;
+    }
+  }
+
+  if(state == NULL)
+  {
+    rdclogprint_int(type, base, noPrefixOutput);
+  }
+  else if(!EnqueueLog(state, type, base, length, prefixLength))
+  {
+    // the ring is full, or this message is too big for it. Write everything out synchronously so
+    // this message doesn't jump ahead of the queued ones
+    SCOPED_LOCK(LogFlushLock());
+
+    FlushPendingLogs();
+
+    if(!EnqueueLog(state, type, base, length, prefixLength))
+      rdclogprint_int(type, base, noPrefixOutput);
+  }
+
+  // if logging was closed after we decided to queue this message, make sure it isn't stranded
+  if(state && log_async == 0)
+    rdclog_flush();
 
   delete[] oversizedBuffer;
 }
@@ -156,6 +156,22 @@ inline T AlignUpPtr(T x, A a)
   (((uint32_t)(d) << 24) | ((uint32_t)(c) << 16) | ((uint32_t)(b) << 8) | (uint32_t)(a))
 
 bool FindDiffRange(void *a, void *b, size_t bufSize, size_t &diffStart, size_t &diffEnd);
+
+// the implementations of FindDiffRange usable on this CPU, in increasing order of preference.
+// FindDiffRange always uses the last one, the list is only exposed for benchmarking.
+struct DiffRangeImplementation
+{
+  const char *name;
+  bool (*func)(void *a, void *b, size_t bufSize, size_t &diffStart, size_t &diffEnd);
+};
+size_t GetDiffRangeImplementations(const DiffRangeImplementation **impls);
+
+// runtime checks for the x86 instruction sets that SIMD paths are selected on. These always return
+// false on other architectures.
+bool CPUSupportsSSE2();
+bool CPUSupportsAVX2();
+bool CPUSupportsF16C();
+
 uint32_t CalcNumMips(int Width, int Height, int Depth);
 
 uint32_t Log2Floor(uint32_t value);
@@ -283,6 +299,8 @@ struct BucketForRecord<T, BucketRecordType::Pow2>
 #else
 // perform any operations necessary to flush the log
 void rdclog_flush();
+// flushes any pending log messages if it can do so without blocking, for use when crashing
+void rdclog_crashflush();
 
 // actual low-level print to log output streams defined (useful for if we need to print
 // fatal error messages from within the more complex log function).
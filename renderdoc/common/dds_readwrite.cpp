@@ -623,7 +623,7 @@ DXGI_FORMAT ResourceFormat2DXGIFormat(ResourceFormat format)
   return DXGI_FORMAT_UNKNOWN;
 }
 
-bool write_dds_to_file(FILE *f, const dds_data &data)
+static bool write_dds(FILE *f, const dds_data &data, const dds_fetch_subresource &fetch)
 {
   if(!f)
     return false;
@@ -813,10 +813,25 @@ bool write_dds_to_file(FILE *f, const dds_data &data)
     {
       for(int mip = 0; mip < RDCMAX(1, data.mips); mip++)
       {
+        // when streaming, fetch all depth slices of this mip at once
+        byte *mipdata = NULL;
+        if(fetch)
+        {
+          mipdata = fetch(slice, mip);
+
+          if(mipdata == NULL)
+          {
+            RDCERR("Couldn't fetch data for slice %d mip %d", slice, mip);
+            return false;
+          }
+        }
+
+        byte *depthdata = mipdata;
+
         int numdepths = RDCMAX(1, data.depth >> mip);
         for(int d = 0; d < numdepths; d++)
         {
-          byte *bytedata = data.subdata[i];
+          byte *bytedata = fetch ? depthdata : data.subdata[i];
 
           int rowlen = RDCMAX(1, data.width >> mip);
           int numRows = RDCMAX(1, data.height >> mip);
@@ -842,8 +857,12 @@ bool write_dds_to_file(FILE *f, const dds_data &data)
             bytedata += pitch;
           }
 
+          depthdata = bytedata;
+
           i++;
         }
+
+        delete[] mipdata;
       }
     }
   }
@@ -851,6 +870,16 @@ bool write_dds_to_file(FILE *f, const dds_data &data)
   return true;
 }
 
+bool write_dds_to_file(FILE *f, const dds_data &data)
+{
+  return write_dds(f, data, dds_fetch_subresource());
+}
+
+bool write_dds_to_file(FILE *f, const dds_data &data, dds_fetch_subresource fetch)
+{
+  return write_dds(f, data, fetch);
+}
+
 bool is_dds_file(FILE *f)
 {
   FileIO::fseek64(f, 0, SEEK_SET);
@@ -863,7 +892,7 @@ bool is_dds_file(FILE *f)
   return magic == dds_fourcc;
 }
 
-dds_data load_dds_from_file(FILE *f)
+dds_data load_dds_header_from_file(FILE *f)
 {
   dds_data ret = {};
   dds_data error = {};
@@ -1017,7 +1046,9 @@ dds_data load_dds_from_file(FILE *f)
   }
 
   ret.subsizes = new uint32_t[ret.slices * ret.mips];
-  ret.subdata = new byte *[ret.slices * ret.mips];
+  ret.suboffsets = new uint64_t[ret.slices * ret.mips];
+
+  uint64_t offset = FileIO::ftell64(f);
 
   int i = 0;
   for(int slice = 0; slice < ret.slices; slice++)
@@ -1043,18 +1074,9 @@ dds_data load_dds_from_file(FILE *f)
       }
 
       ret.subsizes[i] = numdepths * numRows * pitch;
+      ret.suboffsets[i] = offset;
 
-      byte *bytedata = ret.subdata[i] = new byte[ret.subsizes[i]];
-
-      for(int d = 0; d < numdepths; d++)
-      {
-        for(int row = 0; row < numRows; row++)
-        {
-          FileIO::fread(bytedata, 1, pitch, f);
-
-          bytedata += pitch;
-        }
-      }
+      offset += ret.subsizes[i];
 
       i++;
     }
@@ -1062,3 +1084,28 @@ dds_data load_dds_from_file(FILE *f)
 
   return ret;
 }
+
+byte *load_dds_subresource(FILE *f, const dds_data &data, int subresource)
+{
+  FileIO::fseek64(f, data.suboffsets[subresource], SEEK_SET);
+
+  byte *ret = new byte[data.subsizes[subresource]];
+  FileIO::fread(ret, 1, data.subsizes[subresource], f);
+
+  return ret;
+}
+
+dds_data load_dds_from_file(FILE *f)
+{
+  dds_data ret = load_dds_header_from_file(f);
+
+  if(ret.subsizes == NULL)
+    return ret;
+
+  ret.subdata = new byte *[ret.slices * ret.mips];
+
+  for(int i = 0; i < ret.slices * ret.mips; i++)
+    ret.subdata[i] = load_dds_subresource(f, ret, i);
+
+  return ret;
+}
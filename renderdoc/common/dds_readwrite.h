@@ -24,6 +24,7 @@
 
 #pragma once
 
+#include <functional>
 #include "api/replay/renderdoc_replay.h"
 
 struct dds_data
@@ -41,8 +42,22 @@ struct dds_data
 
   byte **subdata;
   uint32_t *subsizes;
+
+  // file offset of each subresource, only filled when loading
+  uint64_t *suboffsets;
 };
 
+// returns the data for one mip of one array slice, with all depth slices of that mip contiguous.
+// The data is allocated with new[] and is deleted once it has been written.
+typedef std::function<byte *(int slice, int mip)> dds_fetch_subresource;
+
 extern bool is_dds_file(FILE *f);
 extern dds_data load_dds_from_file(FILE *f);
 extern bool write_dds_to_file(FILE *f, const dds_data &data);
+
+// streaming variants for large arrays and volumes, so only one subresource is in memory at once.
+// load_dds_header_from_file fills out everything but subdata, and subsizes is NULL on failure. The
+// subsizes and suboffsets arrays must be deleted by the caller in either case.
+extern bool write_dds_to_file(FILE *f, const dds_data &data, dds_fetch_subresource fetch);
+extern dds_data load_dds_header_from_file(FILE *f);
+extern byte *load_dds_subresource(FILE *f, const dds_data &data, int subresource);
@@ -109,6 +109,14 @@
 #define RDOC_XCB OPTION_OFF
 #endif
 
+// 32-bit ARM frame records aren't laid out consistently between compilers and thumb/arm code, so
+// only walk frame pointers where the layout is fixed
+#if defined(RENDERDOC_FRAME_POINTERS) && !defined(__arm__)
+#define RDOC_FRAME_POINTER_UNWIND OPTION_ON
+#else
+#define RDOC_FRAME_POINTER_UNWIND OPTION_OFF
+#endif
+
 /////////////////////////////////////////////////
 // Global constants
 enum
@@ -135,6 +143,12 @@ enum
 // force debugbreaks regardless of debug/release mode
 #define FORCE_DEBUGBREAK OPTION_OFF
 
+// normally RDCPROFILE_SCOPE markers are only compiled into debug builds. This keeps them in release
+#define FORCE_PROFILE_SCOPES OPTION_OFF
+
+// allocate big serialiser buffers straight from the OS, backed by large pages where possible
+#define LARGE_PAGE_BUFFERS OPTION_ON
+
 /////////////////////////////////////////////////
 // Logging configuration
 
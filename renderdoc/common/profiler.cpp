@@ -0,0 +1,167 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2017 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "profiler.h"
+#include <vector>
+#include "common/threading.h"
+
+struct ProfileEvent
+{
+  const char *name;
+  uint64_t threadID;
+  uint64_t start;
+  uint64_t end;
+  int64_t arg;
+};
+
+// a long session can hit a lot of markers, stop recording rather than growing without bound
+static const size_t MaxProfileEvents = 1024 * 1024;
+
+static Threading::CriticalSection profileLock;
+static std::vector<ProfileEvent> profileEvents;
+static std::string profileFilename;
+static uint64_t profileStartTick = 0;
+static volatile bool profileTracing = false;
+static bool profileOverflowed = false;
+
+void Profiler::BeginTrace(const char *filename)
+{
+  SCOPED_LOCK(profileLock);
+
+  if(profileTracing)
+    return;
+
+  RDCLOG("Recording replay profile trace to '%s'", filename);
+
+  profileFilename = filename;
+  profileEvents.clear();
+  profileEvents.reserve(4096);
+  profileStartTick = Timing::GetTimestamp();
+  profileOverflowed = false;
+  profileTracing = true;
+}
+
+bool Profiler::IsTracing()
+{
+  return profileTracing;
+}
+
+void Profiler::AddEvent(const char *name, uint64_t startTick, uint64_t endTick, int64_t arg)
+{
+  uint64_t threadID = Threading::GetCurrentID();
+
+  SCOPED_LOCK(profileLock);
+
+  if(!profileTracing)
+    return;
+
+  if(profileEvents.size() >= MaxProfileEvents)
+  {
+    if(!profileOverflowed)
+      RDCWARN("Replay profile trace is full, further markers will be dropped");
+    profileOverflowed = true;
+    return;
+  }
+
+  ProfileEvent ev = {name, threadID, startTick, endTick, arg};
+  profileEvents.push_back(ev);
+}
+
+// writes str as a quoted JSON string, escaping quotes, backslashes and control characters
+static void WriteJSONString(FILE *f, const char *str)
+{
+  fputc('"', f);
+
+  for(const char *c = str ? str : ""; *c; c++)
+  {
+    switch(*c)
+    {
+      case '"': fputs("\\\"", f); break;
+      case '\\': fputs("\\\\", f); break;
+      case '\n': fputs("\\n", f); break;
+      case '\r': fputs("\\r", f); break;
+      case '\t': fputs("\\t", f); break;
+      default:
+        if((unsigned char)*c < 0x20)
+          fprintf(f, "\\u%04x", (unsigned int)(unsigned char)*c);
+        else
+          fputc(*c, f);
+        break;
+    }
+  }
+
+  fputc('"', f);
+}
+
+void Profiler::EndTrace()
+{
+  SCOPED_LOCK(profileLock);
+
+  if(!profileTracing)
+    return;
+
+  profileTracing = false;
+
+  FILE *f = FileIO::fopen(profileFilename.c_str(), "w");
+
+  if(f == NULL)
+  {
+    RDCERR("Couldn't open '%s' to write replay profile trace", profileFilename.c_str());
+    profileEvents.clear();
+    return;
+  }
+
+  // Chrome trace timestamps and durations are in microseconds
+  const double microsPerTick = 1000.0 / Timing::GetTimestampFrequency();
+  const uint32_t pid = Process::GetCurrentPID();
+
+  fprintf(f, "{\"traceEvents\":[\n");
+
+  for(size_t i = 0; i < profileEvents.size(); i++)
+  {
+    const ProfileEvent &ev = profileEvents[i];
+
+    double ts = double(ev.start - profileStartTick) * microsPerTick;
+    double dur = double(ev.end - ev.start) * microsPerTick;
+
+    fprintf(f, "{\"name\":");
+    WriteJSONString(f, ev.name);
+    fprintf(f, ",\"ph\":\"X\",\"pid\":%u,\"tid\":%llu,\"ts\":%.3f,\"dur\":%.3f", pid,
+            (unsigned long long)ev.threadID, ts, dur);
+
+    if(ev.arg >= 0)
+      fprintf(f, ",\"args\":{\"arg\":%lld}", (long long)ev.arg);
+
+    fprintf(f, "}%s\n", i + 1 < profileEvents.size() ? "," : "");
+  }
+
+  fprintf(f, "],\"displayTimeUnit\":\"ms\"}\n");
+
+  FileIO::fclose(f);
+
+  RDCLOG("Wrote %llu replay profile markers to '%s'", (uint64_t)profileEvents.size(),
+         profileFilename.c_str());
+
+  profileEvents.clear();
+}
@@ -0,0 +1,80 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2017 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include "common/common.h"
+#include "common/timing.h"
+#include "os/os_specific.h"
+
+// Internal profiling of replay operations. While a trace is being recorded every SCOPED_PROFILE
+// marker that's hit is stored, and when the trace ends they're written out in the Chrome trace
+// event JSON format, which can be loaded in chrome://tracing or the Perfetto UI. When no trace is
+// being recorded markers cost a single check.
+namespace Profiler
+{
+void BeginTrace(const char *filename);
+void EndTrace();
+
+bool IsTracing();
+
+// arg is an optional value shown alongside the marker, such as an event ID. Negative values are
+// omitted. Times are from Timing::GetTimestamp()
+void AddEvent(const char *name, uint64_t startTick, uint64_t endTick, int64_t arg);
+};
+
+class ScopedProfile
+{
+public:
+  // name must be a string literal, or otherwise live until the trace ends
+  ScopedProfile(const char *name, int64_t arg = -1)
+      : m_Name(Profiler::IsTracing() ? name : NULL), m_Arg(arg), m_Start(0)
+  {
+    if(m_Name)
+      m_Start = Timing::GetTimestamp();
+  }
+
+  ~ScopedProfile()
+  {
+    if(m_Name)
+      Profiler::AddEvent(m_Name, m_Start, Timing::GetTimestamp(), m_Arg);
+  }
+
+private:
+  const char *m_Name;
+  int64_t m_Arg;
+  uint64_t m_Start;
+};
+
+#define SCOPED_PROFILE(...) ScopedProfile CONCAT(profile, __LINE__)(__VA_ARGS__);
+
+// the same as SCOPED_PROFILE, for markers on hot paths like individual API calls while capturing.
+// Even the check for whether a trace is running adds up there, so these compile out of release
+// builds entirely.
+#if ENABLED(RDOC_DEVEL) || ENABLED(FORCE_PROFILE_SCOPES)
+#define RDCPROFILE_SCOPE(...) SCOPED_PROFILE(__VA_ARGS__)
+#else
+#define RDCPROFILE_SCOPE(...)
+#endif
@@ -24,151 +24,291 @@
 
 #pragma once
 
+#include <map>
+#include <vector>
 #include "os/os_specific.h"
 
-template <typename ResultType, typename ShaderCallbacks>
-bool LoadShaderCache(const char *filename, const uint32_t magicNumber, const uint32_t versionNumber,
-                     std::map<uint32_t, ResultType> &resultCache, const ShaderCallbacks &callbacks)
+// Compiled shaders cached on disk, keyed by a hash of their source.
+//
+// The file is a header followed by a log of [hash, length, data] records. On open it's memory
+// mapped and only the record headers are scanned to build an index, each shader is decoded the
+// first time it's looked up. New shaders are appended to the file when it's closed, and the file
+// is rewritten without stale or duplicate records once enough of it is wasted.
+template <typename ResultType>
+class ShaderCache
 {
-  string shadercache = FileIO::GetAppFolderFilename(filename);
+public:
+  ShaderCache() : m_Mapping(NULL), m_Data(NULL), m_Size(0), m_Magic(0), m_Version(0)
+  {
+    m_StaleBytes = 0;
+    m_NeedsRewrite = true;
+  }
 
-  FILE *f = FileIO::fopen(shadercache.c_str(), "rb");
+  // returns false if the cache couldn't be opened or is out of date, in which case it starts empty
+  bool Open(const char *filename, uint32_t magicNumber, uint32_t versionNumber)
+  {
+    m_Filename = FileIO::GetAppFolderFilename(filename);
+    m_Magic = magicNumber;
+    m_Version = versionNumber;
 
-  if(!f)
-    return false;
+    m_Mapping = FileIO::mmap_open(m_Filename.c_str(), &m_Data, &m_Size);
+
+    if(m_Mapping == NULL)
+    {
+      m_Data = NULL;
+      m_Size = 0;
+      return false;
+    }
 
-  FileIO::fseek64(f, 0, SEEK_END);
-  uint64_t cachelen = FileIO::ftell64(f);
-  FileIO::fseek64(f, 0, SEEK_SET);
+    // header: magic number, file version, format
+    if(m_Size < HeaderSize)
+    {
+      RDCERR("Invalid shader cache");
+      return false;
+    }
 
-  bool ret = true;
+    const uint32_t *header = (const uint32_t *)m_Data;
 
-  // header: magic number, file version, number of entries
-  if(cachelen < sizeof(uint32_t) * 3)
-  {
-    RDCERR("Invalid shader cache");
-    ret = false;
+    if(header[0] != m_Magic || header[1] != m_Version || header[2] != FormatVersion)
+    {
+      RDCDEBUG("Out of date or invalid shader cache magic: %d version: %d", header[0], header[1]);
+      return false;
+    }
+
+    uint64_t offs = HeaderSize;
+
+    while(offs < m_Size)
+    {
+      if(m_Size - offs < sizeof(uint32_t) * 2)
+      {
+        RDCERR("Invalid shader cache - truncated, not enough data for shader hash and length");
+        break;
+      }
+
+      uint32_t hash = *(const uint32_t *)(m_Data + offs);
+      uint32_t len = *(const uint32_t *)(m_Data + offs + sizeof(uint32_t));
+
+      if(m_Size - offs - sizeof(uint32_t) * 2 < len)
+      {
+        RDCERR("Invalid shader cache - truncated, not enough data for shader buffer");
+        break;
+      }
+
+      // a later record for the same hash replaces the earlier one
+      auto it = m_Index.find(hash);
+      if(it != m_Index.end())
+        m_StaleBytes += sizeof(uint32_t) * 2 + it->second.length;
+
+      Entry &entry = m_Index[hash];
+      entry.offset = offs + sizeof(uint32_t) * 2;
+      entry.length = len;
+
+      offs += sizeof(uint32_t) * 2 + len;
+    }
+
+    // anything left over is garbage that can't be appended after
+    m_StaleBytes += m_Size - offs;
+    m_NeedsRewrite = (offs != m_Size);
+
+    RDCDEBUG("Indexed %u shaders in shader cache", (uint32_t)m_Index.size());
+
+    return true;
   }
-  else
+
+  template <typename ShaderCallbacks>
+  bool Find(uint32_t hash, ResultType &result, const ShaderCallbacks &callbacks)
   {
-    byte *cache = new byte[(size_t)cachelen];
-    FileIO::fread(cache, 1, (size_t)cachelen, f);
+    auto res = m_Results.find(hash);
+
+    if(res != m_Results.end())
+    {
+      result = res->second;
+      return true;
+    }
 
-    uint32_t *header = (uint32_t *)cache;
+    auto it = m_Index.find(hash);
 
-    uint32_t fileMagic = header[0];
-    uint32_t fileVer = header[1];
+    if(it == m_Index.end())
+      return false;
 
-    if(fileMagic != magicNumber || fileVer != versionNumber)
+    if(!callbacks.Create(it->second.length, (byte *)m_Data + it->second.offset, &result))
     {
-      RDCDEBUG("Out of date or invalid shader cache magic: %d version: %d", fileMagic, fileVer);
-      ret = false;
+      RDCERR("Couldn't create blob of size %u from shadercache", it->second.length);
+      m_StaleBytes += sizeof(uint32_t) * 2 + it->second.length;
+      m_Index.erase(it);
+      return false;
     }
-    else
+
+    m_Results[hash] = result;
+
+    return true;
+  }
+
+  // the cache takes ownership of the result
+  void Insert(uint32_t hash, ResultType result)
+  {
+    m_Results[hash] = result;
+    m_New.push_back(hash);
+  }
+
+  // replace an entry that was found but turned out to be unusable
+  template <typename ShaderCallbacks>
+  void Replace(uint32_t hash, ResultType result, const ShaderCallbacks &callbacks)
+  {
+    auto res = m_Results.find(hash);
+    if(res != m_Results.end())
     {
-      uint32_t numentries = header[2];
+      callbacks.Destroy(res->second);
+      m_Results.erase(res);
+    }
+
+    auto it = m_Index.find(hash);
+    if(it != m_Index.end())
+    {
+      m_StaleBytes += sizeof(uint32_t) * 2 + it->second.length;
+      m_Index.erase(it);
+    }
 
-      byte *ptr = cache + sizeof(uint32_t) * 3;
+    if(IsNew(hash))
+      m_Results[hash] = result;
+    else
+      Insert(hash, result);
+  }
 
-      int64_t bufsize = (int64_t)cachelen - sizeof(uint32_t) * 3;
+  // write out any new shaders and destroy all results
+  template <typename ShaderCallbacks>
+  void Close(const ShaderCallbacks &callbacks)
+  {
+    bool rewrite = m_NeedsRewrite || m_StaleBytes > m_Size / 4;
+
+    if(rewrite && (m_Mapping || !m_New.empty()))
+    {
+      // copy the live records out, since the mapping must be closed before the file is rewritten
+      std::vector<byte> records;
 
-      for(uint32_t i = 0; i < numentries; i++)
+      for(auto it = m_Index.begin(); it != m_Index.end(); ++it)
       {
-        if((size_t)bufsize < sizeof(uint32_t))
-        {
-          RDCERR("Invalid shader cache - truncated, not enough data for shader hash");
-          ret = false;
-          break;
-        }
-
-        uint32_t hash = *(uint32_t *)ptr;
-        ptr += sizeof(uint32_t);
-        bufsize -= sizeof(uint32_t);
-
-        if((size_t)bufsize < sizeof(uint32_t))
-        {
-          RDCERR("Invalid shader cache - truncated, not enough data for shader length");
-          ret = false;
-          break;
-        }
-
-        uint32_t len = *(uint32_t *)ptr;
-        ptr += sizeof(uint32_t);
-        bufsize -= sizeof(uint32_t);
-
-        if(bufsize < len)
-        {
-          RDCERR("Invalid shader cache - truncated, not enough data for shader buffer");
-          ret = false;
-          break;
-        }
-
-        byte *data = ptr;
-        ptr += len;
-        bufsize -= len;
-
-        ResultType result;
-        bool created = callbacks.Create(len, data, &result);
-
-        if(!created)
-        {
-          RDCERR("Couldn't create blob of size %u from shadercache", len);
-          ret = false;
-          break;
-        }
-
-        resultCache[hash] = result;
+        if(IsNew(it->first))
+          continue;
+
+        uint32_t hash = it->first;
+        uint32_t len = it->second.length;
+
+        records.insert(records.end(), (const byte *)&hash, (const byte *)(&hash + 1));
+        records.insert(records.end(), (const byte *)&len, (const byte *)(&len + 1));
+        records.insert(records.end(), m_Data + it->second.offset,
+                       m_Data + it->second.offset + len);
       }
 
-      if(ret == true && bufsize != 0)
+      CloseMapping();
+
+      FILE *f = FileIO::fopen(m_Filename.c_str(), "wb");
+
+      if(f)
+      {
+        uint32_t header[] = {m_Magic, m_Version, FormatVersion};
+        FileIO::fwrite(header, 1, sizeof(header), f);
+
+        if(!records.empty())
+          FileIO::fwrite(&records[0], 1, records.size(), f);
+
+        WriteNew(f, callbacks);
+
+        FileIO::fclose(f);
+
+        RDCDEBUG("Rewrote shader cache with %u shaders", uint32_t(m_Index.size() + m_New.size()));
+      }
+      else
       {
-        RDCERR("Invalid shader cache - trailing data");
-        ret = false;
+        RDCERR("Error opening shader cache for write");
       }
+    }
+    else if(!m_New.empty())
+    {
+      CloseMapping();
+
+      FILE *f = FileIO::fopen(m_Filename.c_str(), "ab");
+
+      if(f)
+      {
+        WriteNew(f, callbacks);
 
-      RDCDEBUG("Successfully loaded %d shaders from shader cache", resultCache.size());
+        FileIO::fclose(f);
+
+        RDCDEBUG("Appended %u shaders to shader cache", (uint32_t)m_New.size());
+      }
+      else
+      {
+        RDCERR("Error opening shader cache for write");
+      }
     }
 
-    delete[] cache;
-  }
+    CloseMapping();
 
-  FileIO::fclose(f);
+    for(auto it = m_Results.begin(); it != m_Results.end(); ++it)
+      callbacks.Destroy(it->second);
 
-  return ret;
-}
+    m_Results.clear();
+    m_Index.clear();
+    m_New.clear();
+  }
 
-template <typename ResultType, typename ShaderCallbacks>
-void SaveShaderCache(const char *filename, uint32_t magicNumber, uint32_t versionNumber,
-                     const std::map<uint32_t, ResultType> &cache, const ShaderCallbacks &callbacks)
-{
-  string shadercache = FileIO::GetAppFolderFilename(filename);
+private:
+  static const uint32_t FormatVersion = 0x80000002;
+  static const uint64_t HeaderSize = sizeof(uint32_t) * 3;
 
-  FILE *f = FileIO::fopen(shadercache.c_str(), "wb");
+  struct Entry
+  {
+    uint64_t offset;
+    uint32_t length;
+  };
 
-  if(!f)
+  bool IsNew(uint32_t hash) const
   {
-    RDCERR("Error opening shader cache for write");
-    return;
+    for(size_t i = 0; i < m_New.size(); i++)
+      if(m_New[i] == hash)
+        return true;
+    return false;
   }
 
-  FileIO::fwrite(&magicNumber, 1, sizeof(magicNumber), f);
-  FileIO::fwrite(&versionNumber, 1, sizeof(versionNumber), f);
-  uint32_t numentries = (uint32_t)cache.size();
-  FileIO::fwrite(&numentries, 1, sizeof(numentries), f);
-
-  for(auto it = cache.begin(); it != cache.end(); ++it)
+  void CloseMapping()
   {
-    uint32_t hash = it->first;
-    uint32_t len = callbacks.GetSize(it->second);
-    byte *data = callbacks.GetData(it->second);
-    FileIO::fwrite(&hash, 1, sizeof(hash), f);
-    FileIO::fwrite(&len, 1, sizeof(len), f);
-    FileIO::fwrite(data, 1, len, f);
-
-    callbacks.Destroy(it->second);
+    if(m_Mapping)
+      FileIO::mmap_close(m_Mapping);
+
+    m_Mapping = NULL;
+    m_Data = NULL;
+    m_Size = 0;
   }
 
-  FileIO::fclose(f);
+  template <typename ShaderCallbacks>
+  void WriteNew(FILE *f, const ShaderCallbacks &callbacks)
+  {
+    for(size_t i = 0; i < m_New.size(); i++)
+    {
+      uint32_t hash = m_New[i];
+      ResultType result = m_Results[hash];
+      uint32_t len = callbacks.GetSize(result);
+      byte *data = callbacks.GetData(result);
+      FileIO::fwrite(&hash, 1, sizeof(hash), f);
+      FileIO::fwrite(&len, 1, sizeof(len), f);
+      FileIO::fwrite(data, 1, len, f);
+    }
+  }
 
-  RDCDEBUG("Successfully wrote %u shaders to shader cache", numentries);
-}
+  std::string m_Filename;
+  void *m_Mapping;
+  const byte *m_Data;
+  uint64_t m_Size;
+  uint32_t m_Magic, m_Version;
+
+  // bytes in the file taken up by records that are replaced, undecodable or truncated
+  uint64_t m_StaleBytes;
+  bool m_NeedsRewrite;
+
+  // records in the mapped file
+  std::map<uint32_t, Entry> m_Index;
+  // shaders that have been decoded from the file, or added since it was opened
+  std::map<uint32_t, ResultType> m_Results;
+  std::vector<uint32_t> m_New;
+};
@@ -0,0 +1,459 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "threading.h"
+#include <deque>
+#include "common/common.h"
+
+namespace Threading
+{
+namespace JobSystem
+{
+struct Job
+{
+  Task task;
+  TaskGroup *group;
+};
+
+struct WorkQueue
+{
+  CriticalSection lock;
+  std::deque<Job> jobs;
+};
+
+struct Scheduler
+{
+  uint32_t numWorkers;
+  std::vector<ThreadHandle> threads;
+
+  // queues[0] takes tasks queued from threads that aren't workers, queues[i] belongs to worker i
+  std::vector<WorkQueue *> queues;
+
+  // counts queued jobs, so idle workers sleep until there might be something to do
+  Semaphore wake;
+
+  // holds each thread's queue index, 0 for anything that isn't a worker
+  uint64_t queueSlot;
+
+  volatile int32_t nextWorker;
+  volatile int32_t running;
+  volatile int32_t shutdown;
+};
+
+static CriticalSection schedulerLock;
+static Scheduler *volatile scheduler = NULL;
+static uint32_t requestedWorkers = 0;
+
+static size_t CurrentQueue(Scheduler *s)
+{
+  return (size_t)(uintptr_t)GetTLSValue(s->queueSlot);
+}
+
+// finds the next job for the thread with the given queue. A worker takes the most recent job from
+// its own queue, since that's the one most likely to still be in cache, then the oldest job from
+// everyone else.
+static bool FindJob(Scheduler *s, size_t self, Job &job)
+{
+  if(self != 0)
+  {
+    WorkQueue *q = s->queues[self];
+    SCOPED_LOCK(q->lock);
+    if(!q->jobs.empty())
+    {
+      job = q->jobs.back();
+      q->jobs.pop_back();
+      return true;
+    }
+  }
+
+  for(size_t i = 0; i < s->queues.size(); i++)
+  {
+    // start with the shared queue, then try stealing from the workers after this one so they
+    // don't all pick on the same victim
+    size_t idx = i == 0 ? 0 : 1 + (self + i - 1) % s->numWorkers;
+
+    if(idx == self)
+      continue;
+
+    WorkQueue *q = s->queues[idx];
+    SCOPED_LOCK(q->lock);
+    if(!q->jobs.empty())
+    {
+      job = q->jobs.front();
+      q->jobs.pop_front();
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static void RunJob(Job &job)
+{
+  job.task();
+  job.group->TaskFinished();
+}
+
+static void WorkerThread(void *param)
+{
+  Scheduler *s = (Scheduler *)param;
+
+  size_t self = (size_t)Atomic::Inc32(&s->nextWorker);
+  SetTLSValue(s->queueSlot, (void *)(uintptr_t)self);
+
+  while(s->shutdown == 0)
+  {
+    Job job;
+    if(FindJob(s, self, job))
+      RunJob(job);
+    else
+      s->wake.Wait();
+  }
+
+  Atomic::Dec32(&s->running);
+}
+
+static Scheduler *GetScheduler()
+{
+  // the scheduler is only ever created once, so don't lock every time tasks are queued
+  Scheduler *s = scheduler;
+  if(s)
+    return s;
+
+  SCOPED_LOCK(schedulerLock);
+
+  if(scheduler)
+    return scheduler;
+
+  s = new Scheduler();
+
+  s->numWorkers = requestedWorkers;
+  if(s->numWorkers == 0)
+    s->numWorkers = GetCPUCount() - 1;
+
+  s->queueSlot = AllocateTLSSlot();
+  s->nextWorker = 0;
+  s->running = 0;
+  s->shutdown = 0;
+
+  s->queues.resize(s->numWorkers + 1);
+  for(size_t i = 0; i < s->queues.size(); i++)
+    s->queues[i] = new WorkQueue();
+
+  for(uint32_t i = 0; i < s->numWorkers; i++)
+  {
+    Atomic::Inc32(&s->running);
+    ThreadHandle t = CreateThread(&WorkerThread, s);
+    if(t)
+    {
+      s->threads.push_back(t);
+    }
+    else
+    {
+      Atomic::Dec32(&s->running);
+      RDCERR("Couldn't create job system worker %u", i);
+    }
+  }
+
+  // any queues without a worker will still have their jobs stolen by the others, but if there are
+  // no workers at all everything runs inline
+  if(s->threads.empty())
+  {
+    s->numWorkers = 0;
+    for(size_t i = 1; i < s->queues.size(); i++)
+      delete s->queues[i];
+    s->queues.resize(1);
+  }
+
+  RDCLOG("Started job system with %u workers", s->numWorkers);
+
+  scheduler = s;
+  return s;
+}
+
+void SetWorkerCount(uint32_t count)
+{
+  SCOPED_LOCK(schedulerLock);
+
+  if(scheduler && scheduler->numWorkers != count)
+    RDCWARN("Job system already started with %u workers, can't change to %u",
+            scheduler->numWorkers, count);
+
+  requestedWorkers = count;
+}
+
+uint32_t GetWorkerCount()
+{
+  return GetScheduler()->numWorkers;
+}
+
+static void Submit(const Job &job)
+{
+  Scheduler *s = GetScheduler();
+
+  WorkQueue *q = s->queues[CurrentQueue(s)];
+  {
+    SCOPED_LOCK(q->lock);
+    q->jobs.push_back(job);
+  }
+
+  s->wake.Signal(1);
+}
+
+// runs one queued job on the calling thread, if there is one
+static bool HelpOut()
+{
+  Scheduler *s = GetScheduler();
+
+  Job job;
+  if(!FindJob(s, CurrentQueue(s), job))
+    return false;
+
+  RunJob(job);
+  return true;
+}
+
+void Shutdown()
+{
+  SCOPED_LOCK(schedulerLock);
+
+  Scheduler *s = scheduler;
+  if(s == NULL)
+    return;
+
+  s->shutdown = 1;
+  s->wake.Signal(s->numWorkers);
+
+  // as with other threads, we can't join these when the module is being unloaded on windows, so
+  // give them a moment to notice the shutdown instead. They only finish the task they're on.
+  for(int i = 0; i < 100 && s->running > 0; i++)
+    Threading::Sleep(5);
+
+  for(size_t i = 0; i < s->threads.size(); i++)
+    CloseThread(s->threads[i]);
+
+  // if a worker is still stuck in a long task it keeps using the scheduler, so leak it
+  if(s->running > 0)
+  {
+    RDCWARN("%d job system workers didn't stop in time", s->running);
+    return;
+  }
+
+  scheduler = NULL;
+
+  for(size_t i = 0; i < s->queues.size(); i++)
+    delete s->queues[i];
+  delete s;
+}
+};
+
+namespace PoolCache
+{
+struct Table
+{
+  std::vector<void *> caches;
+};
+
+static volatile int32_t nextIndex = 0;
+static uint64_t tableSlot = AllocateTLSSlot();
+
+// every thread's table, so they can be freed at shutdown
+static CriticalSection tablesLock;
+static std::vector<Table *> tables;
+
+uint32_t AllocateIndex()
+{
+  // Inc32 returns the post-increment value
+  return (uint32_t)(Atomic::Inc32(&nextIndex) - 1);
+}
+
+void *Get(uint32_t index)
+{
+  Table *table = (Table *)GetTLSValue(tableSlot);
+  if(table == NULL || index >= table->caches.size())
+    return NULL;
+  return table->caches[index];
+}
+
+void Set(uint32_t index, void *cache)
+{
+  Table *table = (Table *)GetTLSValue(tableSlot);
+
+  if(table == NULL)
+  {
+    table = new Table;
+    SetTLSValue(tableSlot, (void *)table);
+
+    SCOPED_LOCK(tablesLock);
+    tables.push_back(table);
+  }
+
+  // size for every pool that exists so far, so this normally only grows once per thread
+  if(index >= table->caches.size())
+    table->caches.resize(RDCMAX((size_t)index + 1, (size_t)nextIndex), NULL);
+
+  table->caches[index] = cache;
+}
+
+void Shutdown()
+{
+  SCOPED_LOCK(tablesLock);
+
+  for(size_t i = 0; i < tables.size(); i++)
+    delete tables[i];
+  tables.clear();
+}
+};
+
+TaskGroup::TaskGroup() : m_Pending(0), m_Waiters(0)
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+  Wait();
+}
+
+void TaskGroup::Run(const Task &task)
+{
+  Atomic::Inc32(&m_Pending);
+
+  if(JobSystem::GetWorkerCount() == 0)
+  {
+    // with nobody else to run it, do it now so waiting can't block on a queued task
+    task();
+    TaskFinished();
+    return;
+  }
+
+  JobSystem::Job job = {task, this};
+  JobSystem::Submit(job);
+}
+
+void TaskGroup::Then(const Task &task)
+{
+  {
+    SCOPED_LOCK(m_Lock);
+    if(m_Pending > 0)
+    {
+      m_Continuations.push_back(task);
+      return;
+    }
+  }
+
+  Run(task);
+}
+
+void TaskGroup::TaskFinished()
+{
+  std::vector<Task> continuations;
+
+  SCOPED_LOCK(m_Lock);
+
+  if(Atomic::Dec32(&m_Pending) > 0)
+    return;
+
+  if(!m_Continuations.empty())
+  {
+    continuations.swap(m_Continuations);
+
+    // count them all before any can finish, so the group doesn't look idle in between
+    for(size_t i = 0; i < continuations.size(); i++)
+      Atomic::Inc32(&m_Pending);
+
+    for(size_t i = 0; i < continuations.size(); i++)
+    {
+      JobSystem::Job job = {continuations[i], this};
+      JobSystem::Submit(job);
+    }
+
+    return;
+  }
+
+  if(m_Waiters > 0)
+  {
+    m_Done.Signal(m_Waiters);
+    m_Waiters = 0;
+  }
+}
+
+void TaskGroup::Wait()
+{
+  while(m_Pending > 0)
+  {
+    if(JobSystem::HelpOut())
+      continue;
+
+    // nothing left in any queue, so the rest of this group's tasks are already running
+    {
+      SCOPED_LOCK(m_Lock);
+      if(m_Pending == 0)
+        break;
+      m_Waiters++;
+    }
+
+    m_Done.Wait();
+  }
+
+  // whichever thread finished the last task could still be holding the lock, make sure it's done
+  // with the group before we return and it's potentially destroyed
+  SCOPED_LOCK(m_Lock);
+}
+
+void ParallelFor(uint32_t begin, uint32_t end, const std::function<void(uint32_t)> &func,
+                 uint32_t grainSize)
+{
+  if(end <= begin)
+    return;
+
+  uint32_t count = end - begin;
+  uint32_t numThreads = JobSystem::GetWorkerCount() + 1;
+
+  // a few chunks per thread, so uneven work still balances out
+  uint32_t numChunks = numThreads * 4;
+  uint32_t chunkSize = RDCMAX(RDCMAX(grainSize, 1U), (count + numChunks - 1) / numChunks);
+
+  if(numThreads == 1 || chunkSize >= count)
+  {
+    for(uint32_t i = begin; i < end; i++)
+      func(i);
+    return;
+  }
+
+  TaskGroup group;
+
+  for(uint32_t offs = 0; offs < count; offs += RDCMIN(chunkSize, count - offs))
+  {
+    uint32_t chunkBegin = begin + offs;
+    uint32_t chunkEnd = chunkBegin + RDCMIN(chunkSize, count - offs);
+
+    group.Run([&func, chunkBegin, chunkEnd]() {
+      for(uint32_t i = chunkBegin; i < chunkEnd; i++)
+        func(i);
+    });
+  }
+
+  group.Wait();
+}
+};
@@ -25,6 +25,8 @@
 
 #pragma once
 
+#include <functional>
+#include <vector>
 #include "os/os_specific.h"
 
 namespace Threading
@@ -53,6 +55,97 @@ private:
   CriticalSection *m_CS;
   bool m_Owned;
 };
+
+class ScopedReadLock
+{
+public:
+  ScopedReadLock(RWLock &rw) : m_RW(&rw) { m_RW->ReadLock(); }
+  ~ScopedReadLock() { m_RW->ReadUnlock(); }
+private:
+  RWLock *m_RW;
+};
+
+class ScopedWriteLock
+{
+public:
+  ScopedWriteLock(RWLock &rw) : m_RW(&rw) { m_RW->WriteLock(); }
+  ~ScopedWriteLock() { m_RW->WriteUnlock(); }
+private:
+  RWLock *m_RW;
+};
+
+// A shared pool of worker threads for splitting up CPU-heavy work like decoding, compression and
+// encoding. Each worker has its own queue and steals from the others' when it runs dry, so tasks
+// spawned from a task usually stay on the same thread. Workers are started on first use.
+namespace JobSystem
+{
+// sets how many workers to start, 0 for one per CPU core besides the calling thread. Only takes
+// effect before the workers have started.
+void SetWorkerCount(uint32_t count);
+// the number of worker threads, starting them if needed. 0 means tasks run where they're queued
+uint32_t GetWorkerCount();
+// stops the workers. Anything still queued is abandoned, so this must only happen at shutdown
+void Shutdown();
+};
+
+// per-thread caches for WrappingPool. Every pool shares a single TLS slot, which points to a small
+// table on each thread holding one cache pointer per pool, so the number of pool types doesn't
+// cost a TLS slot each.
+namespace PoolCache
+{
+// returns the index a new pool uses to look up its cache in each thread's table
+uint32_t AllocateIndex();
+// the calling thread's cache for the given pool index, or NULL if it hasn't set one
+void *Get(uint32_t index);
+void Set(uint32_t index, void *cache);
+// frees each thread's table. The caches themselves belong to their pools
+void Shutdown();
+};
+
+typedef std::function<void()> Task;
+
+// a set of tasks that can be waited on together. Tasks may queue more tasks into any group,
+// including their own.
+class TaskGroup
+{
+public:
+  TaskGroup();
+  // waits for any tasks still running
+  ~TaskGroup();
+
+  // queues a task to run on any worker
+  void Run(const Task &task);
+
+  // queues a task to run once every other task in the group has finished. Continuations belong to
+  // the group, so Wait() doesn't return until they've run too.
+  void Then(const Task &task);
+
+  // blocks until every task in the group has finished. The calling thread runs queued tasks while
+  // it waits, so it's safe to wait on a group from inside a task.
+  void Wait();
+
+  bool Finished() const { return m_Pending == 0; }
+  // called by the job system when one of this group's tasks has run
+  void TaskFinished();
+
+private:
+  // no copying
+  TaskGroup &operator=(const TaskGroup &other);
+  TaskGroup(const TaskGroup &other);
+
+  volatile int32_t m_Pending;
+  CriticalSection m_Lock;
+  std::vector<Task> m_Continuations;
+  Semaphore m_Done;
+  uint32_t m_Waiters;
+};
+
+// calls func(i) for every i in [begin, end) across the workers, in chunks of at least grainSize
+// indices, and returns once they've all finished.
+void ParallelFor(uint32_t begin, uint32_t end, const std::function<void(uint32_t)> &func,
+                 uint32_t grainSize = 1);
 };
 
 #define SCOPED_LOCK(cs) Threading::ScopedLock CONCAT(scopedlock, __LINE__)(cs);
+#define SCOPED_READLOCK(rw) Threading::ScopedReadLock CONCAT(scopedreadlock, __LINE__)(rw);
+#define SCOPED_WRITELOCK(rw) Threading::ScopedWriteLock CONCAT(scopedwritelock, __LINE__)(rw);
@@ -0,0 +1,120 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2017 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "timing.h"
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <cpuid.h>
+#endif
+
+namespace Timing
+{
+static bool HasCycleCounter()
+{
+// the TSC is only usable as a clock if it's invariant, i.e. it ticks at a constant rate regardless
+// of frequency scaling and sleep states
+#if defined(_M_IX86) || defined(_M_X64)
+  int regs[4] = {};
+  __cpuid(regs, 0x80000000);
+  if(uint32_t(regs[0]) < 0x80000007)
+    return false;
+  __cpuid(regs, 0x80000007);
+  return (regs[3] & (1 << 8)) != 0;
+#elif defined(__i386__) || defined(__x86_64__)
+  unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+  if(__get_cpuid_max(0x80000000, NULL) < 0x80000007)
+    return false;
+  __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+  return (edx & (1 << 8)) != 0;
+#elif defined(__aarch64__)
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool UseCycleCounter = HasCycleCounter();
+
+struct CalibrationPoint
+{
+  uint64_t timestamp;
+  uint64_t tick;
+};
+
+static CalibrationPoint GetCalibrationPoint()
+{
+  // take the tick in between two timestamps, so the pair is as close to simultaneous as we can get
+  uint64_t before = GetTimestamp();
+  uint64_t tick = GetTick();
+  uint64_t after = GetTimestamp();
+
+  CalibrationPoint ret = {before + (after - before) / 2, tick};
+  return ret;
+}
+
+// taken when the library is loaded, so by the time the frequency is needed there's usually been
+// long enough to calibrate against without having to wait
+static CalibrationPoint calibrationStart = GetCalibrationPoint();
+
+static double CalibrateFrequency()
+{
+  if(!UseCycleCounter)
+    return GetTickFrequency();
+
+#if defined(__aarch64__)
+  // the counter reports its own frequency, in Hz
+  uint64_t counterFrequency = 0;
+  __asm__ volatile("mrs %0, cntfrq_el0" : "=r"(counterFrequency));
+  if(counterFrequency > 0)
+    return double(counterFrequency) / 1000.0;
+#endif
+
+  const double tickFrequency = GetTickFrequency();
+
+  CalibrationPoint start = calibrationStart;
+  if(start.tick == 0)
+    start = GetCalibrationPoint();
+
+  // the error in each reading is well under a microsecond, so 10ms between them is plenty
+  CalibrationPoint end = GetCalibrationPoint();
+  while(double(end.tick - start.tick) / tickFrequency < 10.0)
+  {
+    Threading::Sleep(1);
+    end = GetCalibrationPoint();
+  }
+
+  double ret =
+      double(end.timestamp - start.timestamp) / (double(end.tick - start.tick) / tickFrequency);
+
+  RDCLOG("Calibrated cycle counter at %.3lf MHz", ret / 1000.0);
+
+  return ret;
+}
+
+double GetTimestampFrequency()
+{
+  static double frequency = CalibrateFrequency();
+  return frequency;
+}
+};
@@ -48,45 +48,55 @@ public:
   typedef C Type;
 };
 
-// allocate each class in its own pool so we can identify the type by the pointer
+// allocate each class in its own pool so we can identify the type by the pointer.
+//
+// PoolCount is the number of objects in the pool allocated up front, and can be raised per type
+// for types that are expected to be numerous (keeping under MaxPoolByteSize, which is checked at
+// compile time). If it's exceeded, progressively larger additional pools are allocated.
+//
+// Each thread keeps a small cache of free slots in front of the shared pools, so that creating and
+// destroying objects doesn't need to take the lock except to refill or spill that cache in batches.
+// Slots left in a thread's cache when it exits stay reserved, so at most ThreadCacheSize slots are
+// lost per thread that ever used the pool.
 template <typename WrapType, int PoolCount = 8192, int MaxPoolByteSize = 1024 * 1024, bool DebugClear = true>
 class WrappingPool
 {
 public:
   void *Allocate()
   {
-    SCOPED_LOCK(m_Lock);
+    ThreadCache *cache = GetThreadCache();
 
-    // try and allocate from immediate pool
-    void *ret = m_ImmediatePool.Allocate();
-    if(ret != NULL)
-      return ret;
-
-    // fall back to additional pools, if there are any
-    for(size_t i = 0; i < m_AdditionalPools.size(); i++)
+    if(cache->count > 0)
     {
-      ret = m_AdditionalPools[i]->Allocate();
-      if(ret != NULL)
-        return ret;
-    }
+      cache->hits++;
 
-// warn when we need to allocate an additional pool
-#if ENABLED(INCLUDE_TYPE_NAMES)
-    RDCWARN("Ran out of free slots in %s pool!", GetTypeName<WrapType>::Name());
-#else
-    RDCWARN("Ran out of free slots in pool 0x%p!", &m_ImmediatePool.items[0]);
+      void *ret = cache->items[--cache->count];
+
+#if ENABLED(RDOC_DEVEL)
+      memset(ret, 0xb0, AllocByteSize);
 #endif
 
-    // allocate a new additional pool and use that to allocate from
-    m_AdditionalPools.push_back(new ItemPool());
+      return ret;
+    }
 
-#if ENABLED(INCLUDE_TYPE_NAMES)
-    RDCDEBUG("WrappingPool[%d]<%s>: %p -> %p", (uint32_t)m_AdditionalPools.size() - 1,
-             GetTypeName<WrapType>::Name(), &m_AdditionalPools.back()->items[0],
-             &m_AdditionalPools.back()->items[AllocCount - 1]);
-#endif
+    SharedLock lock(*this, cache);
+
+    // refill half of the cache, so that a thread alternating between allocating and deallocating
+    // doesn't end up on the lock every time. Only take from pools we already have, additional
+    // pools should only be created when an allocation actually needs one.
+    while(cache->count < ThreadCacheSize / 2)
+    {
+      void *item = AllocateShared(false);
+      if(item == NULL)
+        break;
+      cache->items[cache->count++] = item;
+    }
 
-    return m_AdditionalPools.back()->Allocate();
+    // only make a new pool if there was nothing free at all
+    if(cache->count > 0)
+      return cache->items[--cache->count];
+
+    return AllocateShared(true);
   }
 
   bool IsAlloc(const void *p)
@@ -95,51 +105,52 @@ public:
     if(m_ImmediatePool.IsAlloc(p))
       return true;
 
-    // if we have additional pools, lock and check them.
-    // TODO: Check for additional pools in a lock-free manner,
-    // to prevent the cost of locking if there are no more pools.
-    {
-      SCOPED_LOCK(m_Lock);
+    // additional pools are only ever appended, and the count is incremented after the pool is in
+    // place, so they can be checked without locking too.
+    int32_t numPools = m_NumAdditionalPools;
 
-      for(size_t i = 0; i < m_AdditionalPools.size(); i++)
-        if(m_AdditionalPools[i]->IsAlloc(p))
-          return true;
-    }
+    for(int32_t i = 0; i < numPools; i++)
+      if(GetAdditionalPool(i)->IsAlloc(p))
+        return true;
 
     return false;
   }
 
   void Deallocate(void *p)
   {
-    SCOPED_LOCK(m_Lock);
-
-    // try immediate pool
-    if(m_ImmediatePool.IsAlloc(p))
+    if(!IsAlloc(p))
     {
-      m_ImmediatePool.Deallocate(p);
+// this is an error - deleting an object that we don't recognise
+#if ENABLED(INCLUDE_TYPE_NAMES)
+      RDCERR("Resource being deleted through wrong pool - 0x%p not a member of %s", p,
+             GetTypeName<WrapType>::Name());
+#else
+      RDCERR("Resource being deleted through wrong pool - 0x%p not a member of 0x%p", p,
+             &m_ImmediatePool.items[0]);
+#endif
       return;
     }
-    else if(!m_AdditionalPools.empty())
+
+#if ENABLED(RDOC_DEVEL)
+    memset(p, 0xfe, DebugClear ? AllocByteSize : 0);
+#endif
+
+    ThreadCache *cache = GetThreadCache();
+
+    if(cache->count < ThreadCacheSize)
     {
-      // fall back and try additional pools
-      for(size_t i = 0; i < m_AdditionalPools.size(); i++)
-      {
-        if(m_AdditionalPools[i]->IsAlloc(p))
-        {
-          m_AdditionalPools[i]->Deallocate(p);
-          return;
-        }
-      }
+      cache->hits++;
+      cache->items[cache->count++] = p;
+      return;
     }
 
-// this is an error - deleting an object that we don't recognise
-#if ENABLED(INCLUDE_TYPE_NAMES)
-    RDCERR("Resource being deleted through wrong pool - 0x%p not a member of %s", p,
-           GetTypeName<WrapType>::Name());
-#else
-    RDCERR("Resource being deleted through wrong pool - 0x%p not a member of 0x%p", p,
-           &m_ImmediatePool.items[0]);
-#endif
+    SharedLock lock(*this, cache);
+
+    // the cache is full, give half of it back to the shared pools along with this item
+    while(cache->count > ThreadCacheSize / 2)
+      DeallocateShared(cache->items[--cache->count]);
+
+    DeallocateShared(p);
   }
 
   static const size_t AllocCount = PoolCount;
@@ -147,8 +158,12 @@ public:
   static const size_t AllocByteSize;
 
 private:
-  WrappingPool()
+  WrappingPool() : m_ImmediatePool(PoolCount)
   {
+    m_NumAdditionalPools = 0;
+    RDCEraseEl(m_Stats);
+    m_ThreadCacheIndex = Threading::PoolCache::AllocateIndex();
+
 #if ENABLED(INCLUDE_TYPE_NAMES)
     // hack - print in kB because float printing relies on statics that might not be initialised
     // yet in loading order. Ugly :(
@@ -159,24 +174,197 @@ private:
   }
   ~WrappingPool()
   {
-    for(size_t i = 0; i < m_AdditionalPools.size(); i++)
-      delete m_AdditionalPools[i];
+    for(int32_t i = 0; i < m_NumAdditionalPools; i++)
+      delete GetAdditionalPool(i);
+
+    m_NumAdditionalPools = 0;
+
+    PoolBlock *block = m_AdditionalPools.next;
+    while(block)
+    {
+      PoolBlock *next = block->next;
+      delete block;
+      block = next;
+    }
+    m_AdditionalPools.next = NULL;
+
+    for(size_t i = 0; i < m_ThreadCaches.size(); i++)
+      delete m_ThreadCaches[i];
+
+    m_ThreadCaches.clear();
+  }
+
+  static const int32_t ThreadCacheSize = 32;
+  static const int32_t PoolsPerBlock = 64;
+  static const int32_t MaxPoolGrowthShift = 4;
+
+  struct ThreadCache
+  {
+    ThreadCache() : count(0), hits(0) {}
+    void *items[ThreadCacheSize];
+    int32_t count;
+
+    // allocations and deallocations served without the lock, added to the shared stats the next
+    // time this thread takes the lock
+    uint64_t hits;
+  };
+
+  ThreadCache *GetThreadCache()
+  {
+    ThreadCache *cache = (ThreadCache *)Threading::PoolCache::Get(m_ThreadCacheIndex);
+
+    if(cache == NULL)
+    {
+      cache = new ThreadCache();
+      Threading::PoolCache::Set(m_ThreadCacheIndex, (void *)cache);
 
-    m_AdditionalPools.clear();
+      SCOPED_LOCK(m_Lock);
+      m_ThreadCaches.push_back(cache);
+    }
+
+    return cache;
+  }
+
+  // takes the shared lock, keeping track of how often it was contended
+  struct SharedLock
+  {
+    SharedLock(WrappingPool &pool, ThreadCache *cache) : m_Pool(pool)
+    {
+      bool contended = !m_Pool.m_Lock.Trylock();
+      if(contended)
+        m_Pool.m_Lock.Lock();
+
+      m_Pool.UpdateStats(cache, contended);
+    }
+    ~SharedLock() { m_Pool.m_Lock.Unlock(); }
+    WrappingPool &m_Pool;
+  };
+
+  void UpdateStats(ThreadCache *cache, bool contended)
+  {
+    m_Stats.cacheHits += cache->hits;
+    cache->hits = 0;
+
+    m_Stats.locks++;
+    if(contended)
+      m_Stats.contendedLocks++;
+
+    if((m_Stats.locks % 4096) == 0)
+    {
+#if ENABLED(INCLUDE_TYPE_NAMES)
+      RDCDEBUG("WrappingPool<%s>: %llu of %llu shared locks contended, %llu thread cache hits",
+               GetTypeName<WrapType>::Name(), m_Stats.contendedLocks, m_Stats.locks,
+               m_Stats.cacheHits);
+#else
+      RDCDEBUG("WrappingPool 0x%p: %llu of %llu shared locks contended, %llu thread cache hits",
+               &m_ImmediatePool.items[0], m_Stats.contendedLocks, m_Stats.locks, m_Stats.cacheHits);
+#endif
+    }
+  }
+
+  // must be called with the lock held
+  void *AllocateShared(bool allowNewPool)
+  {
+    // try and allocate from immediate pool
+    void *ret = m_ImmediatePool.Allocate();
+    if(ret != NULL)
+      return ret;
+
+    // fall back to additional pools, if there are any
+    for(int32_t i = 0; i < m_NumAdditionalPools; i++)
+    {
+      ret = GetAdditionalPool(i)->Allocate();
+      if(ret != NULL)
+        return ret;
+    }
+
+    if(!allowNewPool)
+      return NULL;
+
+// warn when we need to allocate an additional pool
+#if ENABLED(INCLUDE_TYPE_NAMES)
+    RDCWARN("Ran out of free slots in %s pool!", GetTypeName<WrapType>::Name());
+#else
+    RDCWARN("Ran out of free slots in pool 0x%p!", &m_ImmediatePool.items[0]);
+#endif
+
+    // allocate a new additional pool and use that to allocate from. Each one is double the size of
+    // the last up to a limit, so a type that badly overflows its immediate pool doesn't end up with
+    // a long list of pools to search. It's only counted once it's in place, since IsAlloc() reads
+    // the pools without locking
+    int32_t growthShift = RDCMIN(m_NumAdditionalPools + 1, (int32_t)MaxPoolGrowthShift);
+    ItemPool *pool = new ItemPool(PoolCount << growthShift);
+
+    PoolBlock *block = &m_AdditionalPools;
+    for(int32_t i = m_NumAdditionalPools; i >= PoolsPerBlock; i -= PoolsPerBlock)
+    {
+      if(block->next == NULL)
+        block->next = new PoolBlock();
+      block = block->next;
+    }
+
+    block->pools[m_NumAdditionalPools % PoolsPerBlock] = pool;
+    Atomic::Inc32(&m_NumAdditionalPools);
+
+#if ENABLED(INCLUDE_TYPE_NAMES)
+    RDCDEBUG("WrappingPool[%d]<%s>: %p -> %p", m_NumAdditionalPools - 1,
+             GetTypeName<WrapType>::Name(), &pool->items[0], &pool->items[pool->count - 1]);
+#endif
+
+    return pool->Allocate();
+  }
+
+  // must be called with the lock held
+  void DeallocateShared(void *p)
+  {
+    // try immediate pool
+    if(m_ImmediatePool.IsAlloc(p))
+    {
+      m_ImmediatePool.Deallocate(p);
+      return;
+    }
+
+    // fall back and try additional pools
+    for(int32_t i = 0; i < m_NumAdditionalPools; i++)
+    {
+      ItemPool *pool = GetAdditionalPool(i);
+      if(pool->IsAlloc(p))
+      {
+        pool->Deallocate(p);
+        return;
+      }
+    }
   }
 
   Threading::CriticalSection m_Lock;
 
+  uint32_t m_ThreadCacheIndex;
+  std::vector<ThreadCache *> m_ThreadCaches;
+
+  struct
+  {
+    uint64_t locks;
+    uint64_t contendedLocks;
+    uint64_t cacheHits;
+  } m_Stats;
+
   struct ItemPool
   {
-    ItemPool()
+    ItemPool(int itemCount)
     {
+      count = itemCount;
       lastAllocIdx = 0;
-      RDCEraseEl(allocated);
 
-      items = (WrapType *)(new uint8_t[AllocCount * AllocByteSize]);
+      allocated = new bool[count];
+      memset(allocated, 0, count * sizeof(bool));
+
+      items = (WrapType *)(new uint8_t[count * AllocByteSize]);
+    }
+    ~ItemPool()
+    {
+      delete[](uint8_t *) items;
+      delete[] allocated;
     }
-    ~ItemPool() { delete[](uint8_t *) items; }
     void *Allocate()
     {
       int lastAlloc = lastAllocIdx;
@@ -187,7 +375,7 @@ private:
 
         do
         {
-          lastAlloc = (lastAlloc + 1) % PoolCount;
+          lastAlloc = (lastAlloc + 1) % count;
         } while(allocated[lastAlloc] && lastAlloc != end);
 
         if(allocated[lastAlloc])
@@ -229,12 +417,13 @@ private:
 #endif
     }
 
-    bool IsAlloc(const void *p) const { return p >= &items[0] && p < &items[PoolCount]; }
+    bool IsAlloc(const void *p) const { return p >= &items[0] && p < &items[count]; }
     WrapType *items;
+    int count;
 
     // could possibly make this uint32s and check via bitmasks, but
     // we'll see if it shows up in profiling
-    bool allocated[PoolCount];
+    bool *allocated;
 
     // store the last allocations index. Good place to start from and we
     // go through the pool in a ring. Good performance when the pool is empty
@@ -244,8 +433,26 @@ private:
     int lastAllocIdx;
   };
 
+  // additional pools are stored in blocks that are never moved or freed while the pool is alive,
+  // so the list can keep growing while other threads read it without locking
+  struct PoolBlock
+  {
+    PoolBlock() : next(NULL) { RDCEraseEl(pools); }
+    ItemPool *pools[PoolsPerBlock];
+    PoolBlock *next;
+  };
+
+  ItemPool *GetAdditionalPool(int32_t idx)
+  {
+    PoolBlock *block = &m_AdditionalPools;
+    for(; idx >= PoolsPerBlock; idx -= PoolsPerBlock)
+      block = block->next;
+    return block->pools[idx];
+  }
+
   ItemPool m_ImmediatePool;
-  std::vector<ItemPool *> m_AdditionalPools;
+  PoolBlock m_AdditionalPools;
+  volatile int32_t m_NumAdditionalPools;
 
   friend typename FriendMaker<WrapType>::Type;
 };
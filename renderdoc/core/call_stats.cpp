@@ -0,0 +1,127 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "call_stats.h"
+#include <algorithm>
+#include <map>
+#include <string>
+#include "common/threading.h"
+
+volatile bool APICallCounter::m_Enabled = false;
+APICallCounter *APICallCounter::m_First = NULL;
+
+// counters are constructed the first time their entry point is called, which could in theory be
+// before this file's globals are initialised, so the lock is a function-local static.
+static Threading::CriticalSection &CounterListLock()
+{
+  static Threading::CriticalSection lock;
+  return lock;
+}
+
+APICallCounter::APICallCounter(const char *name)
+    : m_Name(name), m_Count(0), m_Ticks(0), m_Next(NULL)
+{
+  SCOPED_LOCK(CounterListLock());
+
+  m_Next = m_First;
+  m_First = this;
+}
+
+void APICallCounter::SetEnabled(bool enabled)
+{
+  if(enabled == m_Enabled)
+    return;
+
+  if(enabled)
+  {
+    SCOPED_LOCK(CounterListLock());
+
+    for(APICallCounter *counter = m_First; counter; counter = counter->m_Next)
+    {
+      counter->m_Count = 0;
+      counter->m_Ticks = 0;
+    }
+  }
+
+  m_Enabled = enabled;
+}
+
+static bool MoreTimeSpent(const APICallStat &a, const APICallStat &b)
+{
+  return a.milliseconds > b.milliseconds;
+}
+
+std::vector<APICallStat> APICallCounter::GetStats(size_t maxCount)
+{
+  std::map<std::string, std::pair<uint64_t, uint64_t> > totals;
+
+  {
+    SCOPED_LOCK(CounterListLock());
+
+    for(APICallCounter *counter = m_First; counter; counter = counter->m_Next)
+    {
+      if(counter->m_Count == 0)
+        continue;
+
+      std::pair<uint64_t, uint64_t> &total = totals[counter->m_Name];
+      total.first += (uint64_t)counter->m_Count;
+      total.second += (uint64_t)counter->m_Ticks;
+    }
+  }
+
+  const double ticksPerMS = Timing::GetTickFrequency();
+
+  std::vector<APICallStat> ret;
+  ret.reserve(totals.size());
+
+  for(auto it = totals.begin(); it != totals.end(); ++it)
+  {
+    APICallStat stat;
+    stat.name = it->first;
+    stat.count = it->second.first;
+    stat.milliseconds = double(it->second.second) / ticksPerMS;
+    ret.push_back(stat);
+  }
+
+  std::sort(ret.begin(), ret.end(), MoreTimeSpent);
+
+  if(ret.size() > maxCount)
+    ret.resize(maxCount);
+
+  return ret;
+}
+
+double APICallCounter::GetTotalMilliseconds()
+{
+  uint64_t ticks = 0;
+
+  {
+    SCOPED_LOCK(CounterListLock());
+
+    for(APICallCounter *counter = m_First; counter; counter = counter->m_Next)
+      ticks += (uint64_t)counter->m_Ticks;
+  }
+
+  return double(ticks) / Timing::GetTickFrequency();
+}
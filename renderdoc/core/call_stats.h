@@ -0,0 +1,92 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "api/replay/renderdoc_replay.h"
+#include "os/os_specific.h"
+
+// Counts the calls made to one API entry point and the time spent in its wrapper. Each wrapped
+// entry point has a single static counter, declared with SCOPED_API_CALL_STATS, which registers
+// itself in a global list the first time the entry point is called. Nothing is recorded unless
+// the ProfileAPICalls capture option is enabled.
+class APICallCounter
+{
+public:
+  APICallCounter(const char *name);
+
+  void Record(uint64_t ticks)
+  {
+    Atomic::Inc64(&m_Count);
+    Atomic::ExchAdd64(&m_Ticks, (int64_t)ticks);
+  }
+
+  static bool Enabled() { return m_Enabled; }
+  // enabling the counters after they've been disabled starts counting again from zero
+  static void SetEnabled(bool enabled);
+
+  // returns up to maxCount entry points, the most time spent first. Entry points with more than
+  // one wrapper, such as GL functions that can be fetched by symbol or by GetProcAddress, are
+  // combined by name.
+  static std::vector<APICallStat> GetStats(size_t maxCount);
+
+  // returns the time spent in every wrapped entry point together, in milliseconds
+  static double GetTotalMilliseconds();
+
+private:
+  static volatile bool m_Enabled;
+  static APICallCounter *m_First;
+
+  const char *m_Name;
+  volatile int64_t m_Count;
+  volatile int64_t m_Ticks;
+  APICallCounter *m_Next;
+};
+
+class ScopedAPICallTimer
+{
+public:
+  ScopedAPICallTimer(APICallCounter &counter)
+      : m_Counter(APICallCounter::Enabled() ? &counter : NULL),
+        m_Start(m_Counter ? Timing::GetTick() : 0)
+  {
+  }
+
+  ~ScopedAPICallTimer()
+  {
+    if(m_Counter)
+      m_Counter->Record(Timing::GetTick() - m_Start);
+  }
+
+private:
+  APICallCounter *m_Counter;
+  uint64_t m_Start;
+};
+
+#define SCOPED_API_CALL_STATS(name)                              \
+  static APICallCounter CONCAT(apicallcounter, __LINE__)(name); \
+  ScopedAPICallTimer CONCAT(apicalltimer, __LINE__)(CONCAT(apicallcounter, __LINE__));
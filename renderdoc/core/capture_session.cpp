@@ -0,0 +1,473 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+
+#include "capture_session.h"
+#include "3rdparty/lz4/lz4.h"
+#include "core/core.h"
+#include "serialise/serialiser.h"
+
+/*
+
+ -----------------------------
+ Session file format:
+
+ SessionFileHeader header;
+
+ then records back to back until the end of the file:
+
+ SessionRecordHeader record;
+ byte contents[record.length];
+
+ A chunk record holds one chunk, the contents being:
+
+ SessionChunkHeader chunk;
+ byte data[];    // chunk.length bytes, or LZ4 compressed to fill the record if the record has
+                 // eSessionRecordFlag_LZ4
+
+ Chunks are numbered in the order their records appear. A capture record is serialised with a
+ Serialiser and holds:
+
+ the capture's metadata, in the same form as a capture file's metadata section
+ the hashes of deduplicated buffers the chunks refer back to, see Serialiser::AddReferencedBuffers
+ each chunk's number, and when and on which thread it was recorded, in capture order
+
+ A capture record always follows the records of the chunks it uses, so a session that's cut off
+ part way through a record still has every capture before it intact.
+
+*/
+
+static const uint32_t SessionMagic = MAKE_FOURCC('R', 'D', 'S', 'N');
+static const uint32_t SessionVersion = 1;
+
+// chunks smaller than this aren't worth compressing
+static const uint64_t SessionCompressThreshold = 64;
+
+struct SessionFileHeader
+{
+  uint32_t magic;
+  uint32_t version;
+  // Serialiser::SERIALISE_VERSION the chunks were recorded with
+  uint64_t serialiseVersion;
+};
+
+enum SessionRecordType
+{
+  eSessionRecord_Chunk = 1,
+  eSessionRecord_Capture = 2,
+};
+
+enum SessionRecordFlags
+{
+  eSessionRecordFlag_None = 0x0,
+  eSessionRecordFlag_LZ4 = 0x1,
+};
+
+struct SessionRecordHeader
+{
+  uint32_t type;
+  uint32_t flags;
+  uint64_t length;
+};
+
+struct SessionChunkHeader
+{
+  uint64_t length;
+  uint32_t chunkType;
+  uint32_t aligned;
+};
+
+static bool WriteRecord(FILE *f, SessionRecordType type, uint32_t flags, const void *prefix,
+                        size_t prefixLen, const void *data, size_t dataLen)
+{
+  SessionRecordHeader record = {(uint32_t)type, flags, uint64_t(prefixLen + dataLen)};
+
+  if(FileIO::fwrite(&record, 1, sizeof(record), f) != sizeof(record))
+    return false;
+
+  if(prefixLen > 0 && FileIO::fwrite(prefix, 1, prefixLen, f) != prefixLen)
+    return false;
+
+  return dataLen == 0 || FileIO::fwrite(data, 1, dataLen, f) == dataLen;
+}
+
+static bool WriteChunkRecord(FILE *f, Chunk *chunk, std::vector<byte> &compressed)
+{
+  SessionChunkHeader header = {chunk->GetLength(), chunk->GetChunkType(),
+                               chunk->IsAligned() ? 1U : 0U};
+
+  const byte *data = chunk->GetData();
+  size_t length = (size_t)header.length;
+
+  if(header.length >= SessionCompressThreshold && header.length <= LZ4_MAX_INPUT_SIZE)
+  {
+    compressed.resize(LZ4_COMPRESSBOUND(length));
+
+    int ret = LZ4_compress_default((const char *)data, (char *)&compressed[0], (int)length,
+                                   (int)compressed.size());
+
+    if(ret > 0 && (size_t)ret < length)
+      return WriteRecord(f, eSessionRecord_Chunk, eSessionRecordFlag_LZ4, &header, sizeof(header),
+                         &compressed[0], (size_t)ret);
+  }
+
+  return WriteRecord(f, eSessionRecord_Chunk, eSessionRecordFlag_None, &header, sizeof(header),
+                     data, length);
+}
+
+CaptureSessionWriter::CaptureSessionWriter(const std::string &filename)
+{
+  m_Filename = filename;
+  m_Created = false;
+  m_NumChunks = 0;
+  m_NumCaptures = 0;
+  m_Failed = false;
+}
+
+bool CaptureSessionWriter::Append(Serialiser *fileSerialiser, const CaptureMetadata &metadata,
+                                  uint32_t &index, volatile float *progress)
+{
+  SCOPED_LOCK(m_Lock);
+
+  if(m_Failed)
+    return false;
+
+  FILE *f = FileIO::fopen(m_Filename.c_str(), m_Created ? "ab" : "wb");
+
+  if(!f)
+  {
+    RDCERR("Can't open session file '%s' for write, errno %d", m_Filename.c_str(), errno);
+    return false;
+  }
+
+  bool success = true;
+
+  if(!m_Created)
+  {
+    SessionFileHeader header = {SessionMagic, SessionVersion, Serialiser::SERIALISE_VERSION};
+    success = FileIO::fwrite(&header, 1, sizeof(header), f) == sizeof(header);
+  }
+
+  const std::vector<Chunk *> &chunks = fileSerialiser->GetChunks();
+
+  std::vector<uint32_t> chunkIndices;
+  std::vector<uint64_t> timestamps, threadIDs;
+  chunkIndices.reserve(chunks.size());
+  timestamps.reserve(chunks.size());
+  threadIDs.reserve(chunks.size());
+
+  // chunks written for this capture are only added to m_WrittenChunks once it's complete, so
+  // that a failed write doesn't leave later captures referring to them
+  std::map<ChunkKey, uint32_t> newChunks;
+  uint32_t numChunks = m_NumChunks;
+
+  std::vector<byte> compressed;
+
+  for(size_t i = 0; success && i < chunks.size(); i++)
+  {
+    Chunk *chunk = chunks[i];
+
+    ChunkKey key = {Serialiser::HashBytes(chunk->GetData(), (size_t)chunk->GetLength()),
+                    chunk->GetLength(), chunk->IsAligned()};
+
+    auto it = m_WrittenChunks.find(key);
+
+    if(it == m_WrittenChunks.end())
+    {
+      it = newChunks.find(key);
+
+      if(it == newChunks.end())
+      {
+        it = newChunks.insert(std::make_pair(key, numChunks++)).first;
+        success = WriteChunkRecord(f, chunk, compressed);
+      }
+    }
+
+    chunkIndices.push_back(it->second);
+    timestamps.push_back(chunk->GetTimestamp());
+    threadIDs.push_back(chunk->GetThreadID());
+
+    if(progress)
+      *progress = float(i + 1) / float(chunks.size());
+  }
+
+  if(success)
+  {
+    std::vector<byte> metadataBytes;
+    RenderDoc::EncodeCaptureMetadata(metadata, metadataBytes);
+
+    const std::set<uint64_t> &refs = fileSerialiser->GetReferencedBuffers();
+    std::vector<uint64_t> referencedBuffers(refs.begin(), refs.end());
+
+    Serialiser ser(NULL, Serialiser::WRITING, false);
+
+    size_t len = metadataBytes.size();
+    byte *buf = metadataBytes.empty() ? NULL : &metadataBytes[0];
+    ser.SerialiseBuffer("Metadata", buf, len);
+    ser.Serialise("ReferencedBuffers", referencedBuffers);
+    ser.Serialise("ChunkIndices", chunkIndices);
+    ser.Serialise("Timestamps", timestamps);
+    ser.Serialise("ThreadIDs", threadIDs);
+
+    success = WriteRecord(f, eSessionRecord_Capture, eSessionRecordFlag_None, NULL, 0,
+                          ser.GetRawPtr(0), (size_t)ser.GetOffset());
+  }
+
+  success &= (FileIO::fclose(f) == 0);
+
+  if(!success)
+  {
+    RDCERR("Failed to append capture to session file '%s'", m_Filename.c_str());
+    m_Failed = true;
+    return false;
+  }
+
+  RDCLOG("Appended %u of %u chunks to session file '%s'", numChunks - m_NumChunks,
+         (uint32_t)chunks.size(), m_Filename.c_str());
+
+  m_WrittenChunks.insert(newChunks.begin(), newChunks.end());
+  m_NumChunks = numChunks;
+  m_Created = true;
+
+  index = m_NumCaptures++;
+
+  return true;
+}
+
+// reads through the records of a session file, noting where each chunk record is. Stops once the
+// contents of capture index have been read, or at the end of the file if index is ~0U.
+static ReplayStatus ScanSession(FILE *f, uint32_t index, std::vector<uint64_t> &chunkOffsets,
+                                std::vector<byte> &captureRecord, uint32_t &numCaptures)
+{
+  FileIO::fseek64(f, 0, SEEK_END);
+  uint64_t fileSize = FileIO::ftell64(f);
+  FileIO::fseek64(f, 0, SEEK_SET);
+
+  SessionFileHeader header = {};
+
+  if(FileIO::fread(&header, 1, sizeof(header), f) != sizeof(header) || header.magic != SessionMagic)
+    return ReplayStatus::FileCorrupted;
+
+  if(header.version != SessionVersion || header.serialiseVersion != Serialiser::SERIALISE_VERSION)
+    return ReplayStatus::FileIncompatibleVersion;
+
+  numCaptures = 0;
+
+  uint64_t offset = sizeof(header);
+
+  for(;;)
+  {
+    SessionRecordHeader record = {};
+
+    // a record that's cut off is one that was still being written
+    if(offset + sizeof(record) > fileSize ||
+       FileIO::fread(&record, 1, sizeof(record), f) != sizeof(record) ||
+       record.length > fileSize - offset - sizeof(record))
+      break;
+
+    if(record.type == eSessionRecord_Chunk)
+    {
+      chunkOffsets.push_back(offset);
+    }
+    else if(record.type == eSessionRecord_Capture)
+    {
+      if(numCaptures == index)
+      {
+        captureRecord.resize((size_t)record.length);
+
+        if(record.length > 0 &&
+           FileIO::fread(&captureRecord[0], 1, (size_t)record.length, f) != record.length)
+          return ReplayStatus::FileIOFailed;
+
+        numCaptures++;
+        break;
+      }
+
+      numCaptures++;
+    }
+
+    offset += sizeof(record) + record.length;
+    FileIO::fseek64(f, offset, SEEK_SET);
+  }
+
+  return ReplayStatus::Succeeded;
+}
+
+static Chunk *ReadSessionChunk(FILE *f, uint64_t offset, uint64_t timestamp, uint64_t threadID)
+{
+  FileIO::fseek64(f, offset, SEEK_SET);
+
+  SessionRecordHeader record = {};
+  SessionChunkHeader header = {};
+
+  if(FileIO::fread(&record, 1, sizeof(record), f) != sizeof(record) ||
+     FileIO::fread(&header, 1, sizeof(header), f) != sizeof(header) ||
+     record.length < sizeof(header))
+    return NULL;
+
+  uint64_t storedLength = record.length - sizeof(header);
+
+  // LZ4 can't expand data by more than this, so anything larger is corrupt
+  if(header.length > storedLength * 256 + SessionCompressThreshold)
+    return NULL;
+
+  Chunk *chunk = Chunk::AllocRaw(header.chunkType, header.length, header.aligned != 0, timestamp,
+                                 threadID);
+
+  bool success = false;
+
+  if(record.flags & eSessionRecordFlag_LZ4)
+  {
+    std::vector<byte> compressed((size_t)storedLength);
+
+    success = FileIO::fread(&compressed[0], 1, compressed.size(), f) == compressed.size() &&
+              LZ4_decompress_safe((const char *)&compressed[0], (char *)chunk->GetData(),
+                                  (int)storedLength, (int)header.length) == (int)header.length;
+  }
+  else
+  {
+    success = storedLength == header.length &&
+              FileIO::fread(chunk->GetData(), 1, (size_t)storedLength, f) == storedLength;
+  }
+
+  if(!success)
+    SAFE_DELETE(chunk);
+
+  return chunk;
+}
+
+uint32_t GetSessionCaptureCount(const char *sessionfile)
+{
+  FILE *f = FileIO::fopen(sessionfile, "rb");
+
+  if(!f)
+    return 0;
+
+  std::vector<uint64_t> chunkOffsets;
+  std::vector<byte> captureRecord;
+  uint32_t numCaptures = 0;
+
+  ReplayStatus status = ScanSession(f, ~0U, chunkOffsets, captureRecord, numCaptures);
+
+  FileIO::fclose(f);
+
+  return status == ReplayStatus::Succeeded ? numCaptures : 0;
+}
+
+ReplayStatus ExtractSessionCapture(const char *sessionfile, uint32_t index, const char *destfile)
+{
+  FILE *f = FileIO::fopen(sessionfile, "rb");
+
+  if(!f)
+  {
+    RDCERR("Couldn't open session file '%s'", sessionfile);
+    return ReplayStatus::FileIOFailed;
+  }
+
+  std::vector<uint64_t> chunkOffsets;
+  std::vector<byte> captureRecord;
+  uint32_t numCaptures = 0;
+
+  ReplayStatus status = ScanSession(f, index, chunkOffsets, captureRecord, numCaptures);
+
+  if(status == ReplayStatus::Succeeded && numCaptures <= index)
+  {
+    RDCERR("Session file '%s' has no capture %u", sessionfile, index);
+    status = ReplayStatus::FileNotFound;
+  }
+
+  if(status != ReplayStatus::Succeeded || captureRecord.empty())
+  {
+    FileIO::fclose(f);
+    return status == ReplayStatus::Succeeded ? ReplayStatus::FileCorrupted : status;
+  }
+
+  Serialiser ser(captureRecord.size(), &captureRecord[0], false);
+
+  byte *metadataBytes = NULL;
+  size_t metadataLen = 0;
+  std::vector<uint64_t> referencedBuffers;
+  std::vector<uint32_t> chunkIndices;
+  std::vector<uint64_t> timestamps, threadIDs;
+
+  ser.SerialiseBuffer("Metadata", metadataBytes, metadataLen);
+  ser.Serialise("ReferencedBuffers", referencedBuffers);
+  ser.Serialise("ChunkIndices", chunkIndices);
+  ser.Serialise("Timestamps", timestamps);
+  ser.Serialise("ThreadIDs", threadIDs);
+
+  CaptureMetadata metadata;
+
+  if(ser.HasError() || timestamps.size() != chunkIndices.size() ||
+     threadIDs.size() != chunkIndices.size() ||
+     !RenderDoc::DecodeCaptureMetadata(metadataBytes, metadataLen, metadata))
+  {
+    delete[] metadataBytes;
+    FileIO::fclose(f);
+    return ReplayStatus::FileCorrupted;
+  }
+
+  Serialiser writer(destfile, Serialiser::WRITING, false);
+
+  writer.SetMetadata(metadataBytes, metadataLen);
+  delete[] metadataBytes;
+
+  writer.AddReferencedBuffers(
+      std::set<uint64_t>(referencedBuffers.begin(), referencedBuffers.end()));
+
+  // otherwise the machine ID would be that of wherever the capture is extracted
+  Serialiser::RawSection machineID;
+  machineID.type = Serialiser::eSectionType_MachineID;
+  machineID.name = "renderdoc/internal/machineid";
+  machineID.data.assign((const byte *)&metadata.machineIdent,
+                        (const byte *)&metadata.machineIdent + sizeof(metadata.machineIdent));
+  writer.AddRawSection(machineID);
+
+  for(size_t i = 0; i < chunkIndices.size(); i++)
+  {
+    Chunk *chunk = NULL;
+
+    if(chunkIndices[i] < chunkOffsets.size())
+      chunk = ReadSessionChunk(f, chunkOffsets[chunkIndices[i]], timestamps[i], threadIDs[i]);
+
+    if(chunk == NULL)
+    {
+      RDCERR("Chunk %u of capture %u in session file '%s' is corrupt", (uint32_t)i, index,
+             sessionfile);
+      FileIO::fclose(f);
+      return ReplayStatus::FileCorrupted;
+    }
+
+    writer.Insert(chunk);
+  }
+
+  FileIO::fclose(f);
+
+  writer.FlushToDisk();
+
+  if(writer.HasError())
+    return ReplayStatus::FileIOFailed;
+
+  return ReplayStatus::Succeeded;
+}
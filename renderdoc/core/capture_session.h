@@ -0,0 +1,92 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+
+#pragma once
+
+#include <map>
+#include <string>
+#include "api/replay/renderdoc_replay.h"
+#include "os/os_specific.h"
+
+class Serialiser;
+struct CaptureMetadata;
+
+// Writes every capture taken in a session into one file. Each distinct chunk is stored the first
+// time a capture contains it, and each capture is then a record listing its chunks in order, so
+// the creation chunks shared by all captures are only written once. Later captures in a long
+// session only add the chunks that changed, such as initial contents and the frame itself.
+//
+// Records are only ever appended, so the file is valid after each capture and can be read while
+// later ones are being written. Captures are written back out as standalone files with
+// ExtractSessionCapture, see RenderDoc::EnsureCaptureFile.
+class CaptureSessionWriter
+{
+public:
+  CaptureSessionWriter(const std::string &filename);
+
+  // appends the capture in fileSerialiser, which must have been fully inserted including its
+  // thumbnail. The serialiser still owns its chunks afterwards. On success index is the capture's
+  // position in the session.
+  bool Append(Serialiser *fileSerialiser, const CaptureMetadata &metadata, uint32_t &index,
+              volatile float *progress);
+
+  const std::string &GetFilename() const { return m_Filename; }
+  uint32_t GetNumCaptures() const { return m_NumCaptures; }
+private:
+  Threading::CriticalSection m_Lock;
+
+  std::string m_Filename;
+  // the file is created, replacing anything already there, with the first capture
+  bool m_Created;
+
+  struct ChunkKey
+  {
+    uint64_t hash;
+    uint64_t length;
+    bool aligned;
+    bool operator<(const ChunkKey &o) const
+    {
+      if(hash != o.hash)
+        return hash < o.hash;
+      if(length != o.length)
+        return length < o.length;
+      return aligned < o.aligned;
+    }
+  };
+
+  // the index of every chunk already in the file
+  std::map<ChunkKey, uint32_t> m_WrittenChunks;
+  uint32_t m_NumChunks;
+  uint32_t m_NumCaptures;
+
+  // set once a write fails, since the file can't be appended to after a partial record
+  bool m_Failed;
+};
+
+// the number of captures in a session file, 0 if it isn't one
+uint32_t GetSessionCaptureCount(const char *sessionfile);
+
+// writes capture index of a session file to destfile as a standalone capture
+ReplayStatus ExtractSessionCapture(const char *sessionfile, uint32_t index, const char *destfile);
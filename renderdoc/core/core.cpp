@@ -33,8 +33,11 @@
 #include "replay/replay_driver.h"
 #include "serialise/serialiser.h"
 #include "serialise/string_utils.h"
+#include "jpeg-compressor/jpge.h"
 #include "stb/stb_image.h"
+#include "capture_session.h"
 #include "crash_handler.h"
+#include "socket_helpers.h"
 
 // from image_viewer.cpp
 ReplayStatus IMG_CreateReplayDevice(const char *logfile, IReplayDriver **driver);
@@ -217,12 +220,37 @@ RenderDoc::RenderDoc()
 
   m_CapturesActive = 0;
 
+  m_NumQueuedCaptures = 0;
+
   m_RemoteIdent = 0;
   m_RemoteThread = 0;
 
+  m_CaptureWrite.fileSerialiser = NULL;
+  m_CaptureWrite.frameNumber = 0;
+  m_CaptureWrite.thumbnail.pixels = NULL;
+  m_CaptureWrite.thumbnail.width = m_CaptureWrite.thumbnail.height = 0;
+  m_CaptureWriteThread = 0;
+  m_CaptureWriteProgress = -1.0f;
+  m_CaptureSession = NULL;
+  m_SingleClientStreamCaptures = false;
+  m_SingleClientCodecs = 0;
+
+  m_ReplayCancelSlot = 0;
+  m_ProgressSlot = 0;
+  m_ReplayGPUSlot = 0;
+  m_CapturePrecompressThread = 0;
+  m_CapturePrecompressRunning = false;
+  m_CapturePrecompressCancel = false;
+
   m_Replay = false;
 
   m_Cap = 0;
+  m_CaptureFramesLeft = 0;
+  m_IdleCatchUpFrames = 0;
+
+  m_CapturesStarted = m_SpikeCapturesSeen = 0;
+  m_SpikeWarmupFrames = 0;
+  m_SpikeAvgFrameTime = 0.0;
 
   m_FocusKeys.clear();
   m_FocusKeys.push_back(eRENDERDOC_Key_F11);
@@ -231,7 +259,6 @@ RenderDoc::RenderDoc()
   m_CaptureKeys.push_back(eRENDERDOC_Key_F12);
   m_CaptureKeys.push_back(eRENDERDOC_Key_PrtScrn);
 
-  m_ProgressPtr = NULL;
 
   m_ExHandler = NULL;
 
@@ -252,6 +279,10 @@ void RenderDoc::Initialise()
 
   Threading::Init();
 
+  m_ReplayCancelSlot = Threading::AllocateTLSSlot();
+  m_ProgressSlot = Threading::AllocateTLSSlot();
+  m_ReplayGPUSlot = Threading::AllocateTLSSlot();
+
   m_RemoteIdent = 0;
   m_RemoteThread = 0;
 
@@ -343,6 +374,11 @@ void RenderDoc::Initialise()
 
 RenderDoc::~RenderDoc()
 {
+  // the writer thread holds a reference on the module, so we only get here once it's finished or
+  // the process is exiting and it's already been terminated.
+  WaitForCaptureWrite();
+  StopCapturePrecompress();
+
   if(m_ExHandler)
   {
     UnloadCrashHandler();
@@ -357,13 +393,21 @@ RenderDoc::~RenderDoc()
     {
       RDCLOG("Removing remotely retrieved capture %s", m_Captures[i].path.c_str());
       FileIO::Delete(m_Captures[i].path.c_str());
+      DeletePrecompressedChunks(m_Captures[i].path.c_str());
     }
-    else
+    else if(m_Captures[i].sessionIndex == ~0U || m_Captures[i].extracted)
     {
       RDCLOG("'Leaking' unretrieved capture %s", m_Captures[i].path.c_str());
     }
   }
 
+  if(m_CaptureSession)
+  {
+    RDCLOG("'Leaking' session file %s with %u captures", m_CaptureSession->GetFilename().c_str(),
+           m_CaptureSession->GetNumCaptures());
+    SAFE_DELETE(m_CaptureSession);
+  }
+
   RDCSTOPLOGGING();
 
   FileIO::Delete(m_LoggingFilename.c_str());
@@ -382,6 +426,10 @@ RenderDoc::~RenderDoc()
 
   Network::Shutdown();
 
+  Threading::JobSystem::Shutdown();
+
+  Threading::PoolCache::Shutdown();
+
   Threading::Shutdown();
 
   FileIO::Delete(m_LoggingFilename.c_str());
@@ -389,6 +437,9 @@ RenderDoc::~RenderDoc()
 
 void RenderDoc::Shutdown()
 {
+  WaitForCaptureWrite();
+  StopCapturePrecompress();
+
   if(m_ExHandler)
   {
     UnloadCrashHandler();
@@ -479,9 +530,21 @@ void RenderDoc::StartFrameCapture(void *dev, void *wnd)
   {
     frameCap->StartFrameCapture(dev, wnd);
     m_CapturesActive++;
+    m_CapturesStarted++;
+
+    m_CaptureFramesLeft = RDCMAX(m_Options.FramesPerCapture, 1U) - 1;
   }
 }
 
+bool RenderDoc::ShouldContinueFrameCapture()
+{
+  if(m_CaptureFramesLeft == 0)
+    return false;
+
+  m_CaptureFramesLeft--;
+  return true;
+}
+
 void RenderDoc::SetActiveWindow(void *dev, void *wnd)
 {
   DeviceWnd dw(dev, wnd);
@@ -502,7 +565,14 @@ bool RenderDoc::EndFrameCapture(void *dev, void *wnd)
   if(frameCap)
   {
     m_CapturesActive--;
-    return frameCap->EndFrameCapture(dev, wnd);
+    bool ret = frameCap->EndFrameCapture(dev, wnd);
+
+    // the frame's chunks have been written or discarded by now, so release the pages held for
+    // allocating more of them
+    if(m_CapturesActive == 0)
+      Chunk::ReleaseThreadPages();
+
+    return ret;
   }
   return false;
 }
@@ -534,6 +604,9 @@ void RenderDoc::Tick()
 
   m_FrameTimer.UpdateTimers();
 
+  if(CheckFrameTimeSpike() && m_Cap == 0)
+    TriggerCapture(1);
+
   if(!prev_focus && cur_focus)
   {
     m_Cap = 0;
@@ -619,6 +692,23 @@ string RenderDoc::GetOverlayText(RDCDriver driver, uint32_t frameNumber, int fla
 
     overlayText += "\n";
 
+    if(APICallCounter::Enabled())
+    {
+      if(m_OverlayCallStats.empty() || m_OverlayCallStatsTimer.GetMilliseconds() > 1000.0)
+      {
+        m_OverlayCallStats = APICallCounter::GetStats(5);
+        m_OverlayCallStatsTimer.Restart();
+      }
+
+      for(size_t i = 0; i < m_OverlayCallStats.size(); i++)
+      {
+        const APICallStat &stat = m_OverlayCallStats[i];
+        overlayText += StringFormat::Fmt("%s: %llu calls, %.2f ms (%.2f us per call)\n",
+                                         stat.name.c_str(), stat.count, stat.milliseconds,
+                                         stat.milliseconds * 1000.0 / double(stat.count));
+      }
+    }
+
     if((overlay & eRENDERDOC_Overlay_CaptureList) && capturesEnabled)
     {
       overlayText += StringFormat::Fmt("%d Captures saved.\n", (uint32_t)m_Captures.size());
@@ -663,13 +753,95 @@ string RenderDoc::GetOverlayText(RDCDriver driver, uint32_t frameNumber, int fla
   return overlayText;
 }
 
+// how many frames to wait after startup or a capture before the frame-time trigger can fire, so
+// that loading and the capture itself aren't seen as spikes. The rolling average is built up
+// meanwhile.
+static const uint32_t SpikeWarmupFrameCount = 60;
+
+// the weight of each new frame in the rolling average frame time
+static const double SpikeAverageWeight = 1.0 / 32.0;
+
+bool RenderDoc::CheckFrameTimeSpike()
+{
+  if(m_Options.FrameTimeTriggerMS == 0 && m_Options.FrameTimeTriggerMultiple <= 0.0f)
+    return false;
+
+  double frameTime = m_FrameTimer.GetLastFrameTime();
+
+  // frame times are meaningless while a capture is pending or in progress, and the first frame
+  // after one includes the time taken to capture. Warm up again once it's done.
+  if(m_Cap > 0 || m_NumQueuedCaptures > 0 || m_CapturesActive > 0 ||
+     m_SpikeCapturesSeen != m_CapturesStarted)
+  {
+    m_SpikeCapturesSeen = m_CapturesStarted;
+    m_SpikeWarmupFrames = 0;
+    return false;
+  }
+
+  double avg = m_SpikeAvgFrameTime;
+
+  if(m_SpikeWarmupFrames < SpikeWarmupFrameCount)
+  {
+    m_SpikeWarmupFrames++;
+    m_SpikeAvgFrameTime = avg == 0.0 ? frameTime : RDCLERP(avg, frameTime, SpikeAverageWeight);
+    return false;
+  }
+
+  if((m_Options.FrameTimeTriggerMS > 0 && frameTime > double(m_Options.FrameTimeTriggerMS)) ||
+     (m_Options.FrameTimeTriggerMultiple > 0.0f &&
+      frameTime > avg * double(m_Options.FrameTimeTriggerMultiple)))
+  {
+    RDCLOG("Frame took %.2lf ms against an average of %.2lf ms, capturing the next frame",
+           frameTime, avg);
+    return true;
+  }
+
+  // spikes are left out so they don't raise the average that later frames are compared against
+  m_SpikeAvgFrameTime = RDCLERP(avg, frameTime, SpikeAverageWeight);
+  return false;
+}
+
+// how many frames to wait after idle tracking resumes before a capture starts. This covers the
+// usual number of frames in flight, so that per-frame command buffers have been re-recorded.
+static const uint32_t IdleCatchUpFrameCount = 3;
+
 bool RenderDoc::ShouldTriggerCapture(uint32_t frameNumber)
 {
+  if(m_Options.ReduceIdleOverhead)
+  {
+    if(IsIdleTrackingSuspended())
+    {
+      m_IdleCatchUpFrames = 0;
+      return false;
+    }
+
+    // tracking has only just resumed, so wait for the application to re-record its per-frame
+    // command buffers before capturing. Queued frames falling inside this window are pushed back
+    // rather than dropped.
+    if(m_IdleCatchUpFrames < IdleCatchUpFrameCount && !IsFrameCapturing())
+    {
+      m_IdleCatchUpFrames++;
+
+      SCOPED_LOCK(m_QueuedCapturesLock);
+
+      set<uint32_t> frames;
+      frames.swap(m_QueuedFrameCaptures);
+      for(auto it = frames.begin(); it != frames.end(); ++it)
+        m_QueuedFrameCaptures.insert(RDCMAX(*it, frameNumber + 2));
+
+      m_NumQueuedCaptures = (int32_t)m_QueuedFrameCaptures.size();
+
+      return false;
+    }
+  }
+
   bool ret = m_Cap > 0;
 
   if(m_Cap > 0)
     m_Cap--;
 
+  SCOPED_LOCK(m_QueuedCapturesLock);
+
   set<uint32_t> frames;
   frames.swap(m_QueuedFrameCaptures);
   for(auto it = frames.begin(); it != frames.end(); ++it)
@@ -690,11 +862,13 @@ bool RenderDoc::ShouldTriggerCapture(uint32_t frameNumber)
     }
   }
 
+  m_NumQueuedCaptures = (int32_t)m_QueuedFrameCaptures.size();
+
   return ret;
 }
 
-Serialiser *RenderDoc::OpenWriteSerialiser(uint32_t frameNum, RDCInitParams *params, void *thpixels,
-                                           size_t thlen, uint32_t thwidth, uint32_t thheight)
+Serialiser *RenderDoc::OpenWriteSerialiser(uint32_t frameNum, RDCInitParams *params, byte *thpixels,
+                                           uint32_t thwidth, uint32_t thheight)
 {
   RDCASSERT(m_CurrentDriver != RDC_Unknown);
 
@@ -711,21 +885,12 @@ Serialiser *RenderDoc::OpenWriteSerialiser(uint32_t frameNum, RDCInitParams *par
 
   Serialiser *chunkSerialiser = new Serialiser(NULL, Serialiser::WRITING, debugSerialiser);
 
+  // the thumbnail chunk is inserted ahead of everything else once it's encoded
   {
-    ScopedContext scope(chunkSerialiser, "Thumbnail", THUMBNAIL_DATA, false);
-
-    bool HasThumbnail = (thpixels != NULL && thwidth > 0 && thheight > 0);
-    chunkSerialiser->Serialise("HasThumbnail", HasThumbnail);
+    CaptureThumbnail thumbnail = {thpixels, thwidth, thheight};
 
-    if(HasThumbnail)
-    {
-      byte *buf = (byte *)thpixels;
-      chunkSerialiser->Serialise("ThumbWidth", thwidth);
-      chunkSerialiser->Serialise("ThumbHeight", thheight);
-      chunkSerialiser->SerialiseBuffer("ThumbnailPixels", buf, thlen);
-    }
-
-    fileSerialiser->Insert(scope.Get(true));
+    SCOPED_LOCK(m_ThumbnailLock);
+    m_PendingThumbnails[fileSerialiser] = thumbnail;
   }
 
   {
@@ -979,6 +1144,8 @@ void RenderDoc::SetCaptureOptions(const CaptureOptions &opts)
 {
   m_Options = opts;
 
+  APICallCounter::SetEnabled(m_Options.ProfileAPICalls != 0);
+
   LibraryHooks::GetInstance().OptionsUpdated();
 }
 
@@ -995,9 +1162,22 @@ void RenderDoc::SetLogFile(const char *logFile)
   FileIO::CreateParentDirectory(m_LogFile);
 }
 
+void RenderDoc::SetProgressPtr(float *progress)
+{
+  if(m_ProgressSlot == 0)
+    return;
+
+  if(progress == NULL && Threading::GetTLSValue(m_ProgressSlot) == NULL)
+    return;
+
+  Threading::SetTLSValue(m_ProgressSlot, (void *)progress);
+}
+
 void RenderDoc::SetProgress(LoadProgressSection section, float delta)
 {
-  if(m_ProgressPtr == NULL || section < 0 || section >= NumSections)
+  float *progressPtr = m_ProgressSlot ? (float *)Threading::GetTLSValue(m_ProgressSlot) : NULL;
+
+  if(progressPtr == NULL || section < 0 || section >= NumSections)
     return;
 
   float weights[NumSections];
@@ -1015,18 +1195,556 @@ void RenderDoc::SetProgress(LoadProgressSection section, float delta)
 
   progress += weights[section] * delta;
 
-  *m_ProgressPtr = progress;
+  *progressPtr = progress;
+}
+
+void RenderDoc::SetReplayGPU(uint32_t gpu)
+{
+  if(m_ReplayGPUSlot == 0)
+    return;
+
+  // stored off by one so that threads that never set a GPU read back as automatic
+  uintptr_t val = gpu == ~0U ? 0 : uintptr_t(gpu) + 1;
+
+  if(val == 0 && Threading::GetTLSValue(m_ReplayGPUSlot) == NULL)
+    return;
+
+  Threading::SetTLSValue(m_ReplayGPUSlot, (void *)val);
 }
 
-void RenderDoc::SuccessfullyWrittenLog(uint32_t frameNumber)
+uint32_t RenderDoc::GetReplayGPU()
 {
-  RDCLOG("Written to disk: %s", m_CurrentLogFile.c_str());
+  uintptr_t val = m_ReplayGPUSlot ? (uintptr_t)Threading::GetTLSValue(m_ReplayGPUSlot) : 0;
 
-  CaptureData cap(m_CurrentLogFile, Timing::GetUnixTimestamp(), frameNumber);
+  return val == 0 ? ~0U : uint32_t(val - 1);
+}
+
+void RenderDoc::SetReplayCancelFlag(volatile bool *flag)
+{
+  if(m_ReplayCancelSlot == 0)
+    return;
+
+  // avoid allocating TLS data for threads that never had a flag set
+  if(flag == NULL && GetReplayCancelFlag() == NULL)
+    return;
+
+  Threading::SetTLSValue(m_ReplayCancelSlot, (void *)flag);
+}
+
+volatile bool *RenderDoc::GetReplayCancelFlag()
+{
+  if(m_ReplayCancelSlot == 0)
+    return NULL;
+
+  return (volatile bool *)Threading::GetTLSValue(m_ReplayCancelSlot);
+}
+
+bool RenderDoc::IsReplayCancelled()
+{
+  volatile bool *flag = GetReplayCancelFlag();
+  return flag && *flag;
+}
+
+RenderDoc::CaptureThumbnail RenderDoc::TakePendingThumbnail(Serialiser *fileSerialiser)
+{
+  CaptureThumbnail ret = {NULL, 0, 0};
+
+  SCOPED_LOCK(m_ThumbnailLock);
+
+  auto it = m_PendingThumbnails.find(fileSerialiser);
+  if(it != m_PendingThumbnails.end())
+  {
+    ret = it->second;
+    m_PendingThumbnails.erase(it);
+  }
+
+  return ret;
+}
+
+// bump when the contents of the metadata section change, older metadata is then ignored
+#define CAPTURE_METADATA_VERSION 1
+
+static void SerialiseCaptureMetadata(Serialiser &ser, CaptureMetadata &metadata)
+{
+  ser.Serialise("DriverType", metadata.driverType);
+  ser.SerialiseString("DriverName", metadata.driverName);
+  ser.Serialise("MachineIdent", metadata.machineIdent);
+  ser.Serialise("FrameNumber", metadata.frameNumber);
+
+  bool HasThumbnail = !metadata.thumbnail.empty();
+  ser.Serialise("HasThumbnail", HasThumbnail);
+
+  if(HasThumbnail)
+  {
+    ser.Serialise("ThumbWidth", metadata.thumbWidth);
+    ser.Serialise("ThumbHeight", metadata.thumbHeight);
+
+    size_t len = metadata.thumbnail.size();
+    byte *buf = len > 0 ? &metadata.thumbnail[0] : NULL;
+    ser.SerialiseBuffer("ThumbnailPixels", buf, len);
+
+    if(ser.IsReading())
+    {
+      metadata.thumbnail.assign(buf, buf + len);
+      delete[] buf;
+    }
+  }
+}
+
+bool RenderDoc::ReadCaptureMetadata(const char *logfile, CaptureMetadata &metadata)
+{
+  vector<byte> data;
+  if(!Serialiser::ReadFileMetadata(logfile, data))
+    return false;
+
+  return DecodeCaptureMetadata(data.empty() ? NULL : &data[0], data.size(), metadata);
+}
+
+void RenderDoc::EncodeCaptureMetadata(const CaptureMetadata &metadata, vector<byte> &data)
+{
+  Serialiser ser(NULL, Serialiser::WRITING, false);
+
+  uint32_t version = CAPTURE_METADATA_VERSION;
+  ser.Serialise("Version", version);
+
+  CaptureMetadata copy = metadata;
+  SerialiseCaptureMetadata(ser, copy);
+
+  data.assign(ser.GetRawPtr(0), ser.GetRawPtr(0) + (size_t)ser.GetOffset());
+}
+
+bool RenderDoc::DecodeCaptureMetadata(const byte *data, size_t len, CaptureMetadata &metadata)
+{
+  if(data == NULL || len < sizeof(uint32_t))
+    return false;
+
+  Serialiser ser(len, data, false);
+
+  uint32_t version = 0;
+  ser.Serialise("Version", version);
+
+  if(version != CAPTURE_METADATA_VERSION)
+    return false;
+
+  SerialiseCaptureMetadata(ser, metadata);
+
+  return !ser.HasError();
+}
+
+void RenderDoc::InsertThumbnail(Serialiser *fileSerialiser, CaptureThumbnail &thumbnail,
+                                CaptureMetadata &metadata)
+{
+  byte *jpgbuf = NULL;
+  int len = 0;
+
+  if(thumbnail.pixels && thumbnail.width > 0 && thumbnail.height > 0)
+  {
+    // jpge::compress_image_to_jpeg_file_in_memory requires at least 1024 bytes
+    len = RDCMAX(int(thumbnail.width * thumbnail.height), 1024);
+
+    jpgbuf = new byte[len];
+
+    jpge::params p;
+    p.m_quality = 80;
+
+    if(!jpge::compress_image_to_jpeg_file_in_memory(jpgbuf, len, thumbnail.width, thumbnail.height,
+                                                    3, thumbnail.pixels, p))
+    {
+      RDCERR("Failed to compress to jpg");
+      SAFE_DELETE_ARRAY(jpgbuf);
+    }
+  }
+
+  SAFE_DELETE_ARRAY(thumbnail.pixels);
+
+#if ENABLED(RDOC_RELEASE)
+  const bool debugSerialiser = false;
+#else
+  const bool debugSerialiser = true;
+#endif
+
+  Serialiser chunkSerialiser(NULL, Serialiser::WRITING, debugSerialiser);
+
+  {
+    ScopedContext scope(&chunkSerialiser, "Thumbnail", THUMBNAIL_DATA, false);
+
+    bool HasThumbnail = (jpgbuf != NULL);
+    chunkSerialiser.Serialise("HasThumbnail", HasThumbnail);
+
+    if(HasThumbnail)
+    {
+      chunkSerialiser.Serialise("ThumbWidth", thumbnail.width);
+      chunkSerialiser.Serialise("ThumbHeight", thumbnail.height);
+      size_t jpglen = (size_t)len;
+      chunkSerialiser.SerialiseBuffer("ThumbnailPixels", jpgbuf, jpglen);
+    }
+
+    fileSerialiser->InsertFirst(scope.Get(true));
+  }
+
+  if(jpgbuf)
+  {
+    metadata.thumbWidth = thumbnail.width;
+    metadata.thumbHeight = thumbnail.height;
+    metadata.thumbnail.assign(jpgbuf, jpgbuf + len);
+  }
+
+  SAFE_DELETE_ARRAY(jpgbuf);
+
+  WriteCaptureMetadata(fileSerialiser, metadata);
+}
+
+void RenderDoc::WriteCaptureMetadata(Serialiser *fileSerialiser, CaptureMetadata &metadata)
+{
+  vector<byte> data;
+  EncodeCaptureMetadata(metadata, data);
+
+  fileSerialiser->SetMetadata(&data[0], data.size());
+}
+
+ReplayStatus RenderDoc::RepackCapture(const char *logfile, const char *destfile,
+                                      uint32_t compressLevel, bool stripCallstacks,
+                                      bool stripThumbnail)
+{
+  // the source is read while the copy is written
+  if(!strcmp(logfile, destfile))
+  {
+    RDCERR("Can't repack '%s' onto itself", logfile);
+    return ReplayStatus::FileIOFailed;
+  }
+
+  Serialiser reader(logfile, Serialiser::READING, false);
+
+  if(reader.HasError())
+  {
+    RDCERR("Couldn't open '%s'", logfile);
+
+    switch(reader.ErrorCode())
+    {
+      case Serialiser::eSerError_FileIO: return ReplayStatus::FileIOFailed;
+      case Serialiser::eSerError_Corrupt: return ReplayStatus::FileCorrupted;
+      case Serialiser::eSerError_UnsupportedVersion: return ReplayStatus::FileIncompatibleVersion;
+      default: break;
+    }
+
+    return ReplayStatus::InternalError;
+  }
+
+  vector<Serialiser::RawSection> sections;
+  if(!reader.ReadRawSections(sections))
+    return ReplayStatus::FileCorrupted;
+
+  Serialiser writer(destfile, Serialiser::WRITING, false);
+
+  writer.SetCompressionLevel(compressLevel);
+
+  // the chunks are copied byte for byte, so any buffer deduplication in them stays as it was
+  writer.AddReferencedBuffers(reader.GetReferencedBuffers());
+
+  // the chunk headers still refer to their callstacks, but without the table or the resolve DB
+  // they're ignored on replay
+  for(size_t i = 0; i < sections.size(); i++)
+  {
+    if(stripCallstacks && (sections[i].type == Serialiser::eSectionType_CallstackTable ||
+                           sections[i].type == Serialiser::eSectionType_ResolveDatabase))
+      continue;
+
+    writer.AddRawSection(sections[i]);
+  }
+
+  CaptureMetadata metadata;
+  bool hasMetadata = ReadCaptureMetadata(logfile, metadata);
+
+  if(stripThumbnail)
+  {
+    metadata.thumbWidth = metadata.thumbHeight = 0;
+    metadata.thumbnail.clear();
+  }
+
+  if(hasMetadata)
+    WriteCaptureMetadata(&writer, metadata);
+
+  for(uint32_t i = 0;; i++)
+  {
+    Chunk *chunk = reader.ReadRawChunk();
+
+    if(chunk == NULL)
+      break;
+
+    // the thumbnail is always the first chunk, replace it with an empty one
+    if(i == 0 && stripThumbnail && chunk->GetChunkType() == THUMBNAIL_DATA)
+    {
+      SAFE_DELETE(chunk);
+
+      Serialiser chunkSerialiser(NULL, Serialiser::WRITING, false);
+
+      {
+        ScopedContext scope(&chunkSerialiser, "Thumbnail", THUMBNAIL_DATA, false);
+
+        bool HasThumbnail = false;
+        chunkSerialiser.Serialise("HasThumbnail", HasThumbnail);
+
+        chunk = scope.Get(true);
+      }
+    }
+
+    writer.Insert(chunk);
+  }
+
+  if(reader.HasError())
+    return ReplayStatus::FileCorrupted;
+
+  writer.FlushToDisk();
+
+  if(writer.HasError())
+    return ReplayStatus::FileIOFailed;
+
+  return ReplayStatus::Succeeded;
+}
+
+void RenderDoc::FinishWriteSerialiser(Serialiser *fileSerialiser, uint32_t frameNumber)
+{
+  CaptureThumbnail thumbnail = TakePendingThumbnail(fileSerialiser);
+
+  CaptureMetadata metadata;
+  metadata.driverType = m_CurrentDriver;
+  metadata.driverName = m_CurrentDriverName;
+  metadata.machineIdent = OSUtility::GetMachineIdent();
+  metadata.frameNumber = frameNumber;
+
+  // chunk headers refer to callstacks by their index in this process's table, which the session
+  // file doesn't store, so captures with callstacks are always written to their own file
+  bool appendToSession = m_Options.AppendCapturesToSession && !m_Options.CaptureCallstacks;
+
+  if(!m_Options.WriteCapturesAsync)
+  {
+    InsertThumbnail(fileSerialiser, thumbnail, metadata);
+
+    WriteCapture(fileSerialiser, frameNumber, metadata, appendToSession);
+    return;
+  }
+
+  WaitForCaptureWrite();
+
+  // records and other chunks will be modified or freed as soon as we return, so we need our own
+  // copies of anything the serialiser doesn't already own.
+  fileSerialiser->TakeChunkOwnership();
+
+  m_CaptureWriteProgress = 0.0f;
+  fileSerialiser->SetWriteProgress(&m_CaptureWriteProgress);
+
+  m_CaptureWrite.fileSerialiser = fileSerialiser;
+  m_CaptureWrite.frameNumber = frameNumber;
+  m_CaptureWrite.thumbnail = thumbnail;
+  m_CaptureWrite.metadata = metadata;
+  m_CaptureWrite.appendToSession = appendToSession;
+
+  m_CaptureWriteThread = Threading::CreateThread(CaptureWriteThread, &m_CaptureWrite);
+}
+
+void RenderDoc::WriteCapture(Serialiser *fileSerialiser, uint32_t frameNumber,
+                             const CaptureMetadata &metadata, bool appendToSession)
+{
+  if(appendToSession)
+  {
+    if(m_CaptureSession == NULL)
+      m_CaptureSession =
+          new CaptureSessionWriter(StringFormat::Fmt("%s_session.rdcs", m_LogFile.c_str()));
+
+    uint32_t index = 0;
+
+    volatile float *progress = m_Options.WriteCapturesAsync ? &m_CaptureWriteProgress : NULL;
+
+    if(m_CaptureSession->Append(fileSerialiser, metadata, index, progress))
+    {
+      SuccessfullyWrittenLog(fileSerialiser->GetFilename(), frameNumber, index);
+
+      SAFE_DELETE(fileSerialiser);
+      return;
+    }
+
+    RDCWARN("Writing capture to its own file instead");
+  }
+
+  BeginCaptureWriteStream(fileSerialiser);
+
+  fileSerialiser->FlushToDisk();
+
+  SuccessfullyWrittenLog(fileSerialiser->GetFilename(), frameNumber);
+
+  SAFE_DELETE(fileSerialiser);
+}
+
+void RenderDoc::BeginCaptureWriteStream(Serialiser *fileSerialiser)
+{
+  {
+    SCOPED_LOCK(m_CaptureWriteStream.lock);
+    m_CaptureWriteStream.filename = fileSerialiser->GetFilename();
+    m_CaptureWriteStream.stableStart = m_CaptureWriteStream.stableEnd = 0;
+    m_CaptureWriteStream.complete = m_CaptureWriteStream.failed = false;
+  }
+
+  fileSerialiser->SetWriteStream(&m_CaptureWriteStream);
+}
+
+void RenderDoc::CaptureWriteThread(void *s)
+{
+  Threading::KeepModuleAlive();
+
+  CaptureWrite *write = (CaptureWrite *)s;
+
+  InsertThumbnail(write->fileSerialiser, write->thumbnail, write->metadata);
+
+  RenderDoc::Inst().WriteCapture(write->fileSerialiser, write->frameNumber, write->metadata,
+                                 write->appendToSession);
+
+  write->fileSerialiser = NULL;
+
+  RenderDoc::Inst().m_CaptureWriteProgress = -1.0f;
+
+  Threading::ReleaseModuleExitThread();
+}
+
+void RenderDoc::WaitForCaptureWrite()
+{
+  if(m_CaptureWriteThread)
+  {
+    Threading::JoinThread(m_CaptureWriteThread);
+    Threading::CloseThread(m_CaptureWriteThread);
+    m_CaptureWriteThread = 0;
+  }
+}
+
+void RenderDoc::SuccessfullyWrittenLog(const string &logFile, uint32_t frameNumber,
+                                       uint32_t sessionIndex)
+{
+  if(sessionIndex != ~0U)
+    RDCLOG("Appended to session file as capture %u: %s", sessionIndex, logFile.c_str());
+  else
+    RDCLOG("Written to disk: %s", logFile.c_str());
+
+  CaptureData cap(logFile, Timing::GetUnixTimestamp(), frameNumber);
+  cap.sessionIndex = sessionIndex;
   {
     SCOPED_LOCK(m_CaptureLock);
     m_Captures.push_back(cap);
   }
+
+#if ENABLED(RDOC_ANDROID)
+  if(sessionIndex == ~0U)
+    QueueCapturePrecompress(logFile);
+#endif
+}
+
+bool RenderDoc::EnsureCaptureFile(uint32_t idx)
+{
+  SCOPED_LOCK(m_CaptureExtractLock);
+
+  string path;
+  uint32_t sessionIndex = ~0U;
+
+  {
+    SCOPED_LOCK(m_CaptureLock);
+
+    if(idx >= m_Captures.size())
+      return false;
+
+    if(m_Captures[idx].sessionIndex == ~0U || m_Captures[idx].extracted)
+      return true;
+
+    path = m_Captures[idx].path;
+    sessionIndex = m_Captures[idx].sessionIndex;
+  }
+
+  ReplayStatus status =
+      ExtractSessionCapture(m_CaptureSession->GetFilename().c_str(), sessionIndex, path.c_str());
+
+  if(status != ReplayStatus::Succeeded)
+  {
+    RDCERR("Couldn't extract capture %u from session file to %s: %s", sessionIndex, path.c_str(),
+           ToStr::Get(status).c_str());
+    return false;
+  }
+
+  RDCLOG("Extracted capture %u from session file to %s", sessionIndex, path.c_str());
+
+  {
+    SCOPED_LOCK(m_CaptureLock);
+    m_Captures[idx].extracted = true;
+  }
+
+#if ENABLED(RDOC_ANDROID)
+  QueueCapturePrecompress(path);
+#endif
+
+  return true;
+}
+
+void RenderDoc::QueueCapturePrecompress(const string &logFile)
+{
+  SCOPED_LOCK(m_CapturePrecompressLock);
+
+  m_CapturePrecompressQueue.push_back(logFile);
+
+  if(!m_CapturePrecompressRunning)
+  {
+    // the previous thread has finished with the queue, so this won't wait for long
+    if(m_CapturePrecompressThread)
+    {
+      Threading::JoinThread(m_CapturePrecompressThread);
+      Threading::CloseThread(m_CapturePrecompressThread);
+    }
+
+    m_CapturePrecompressRunning = true;
+    m_CapturePrecompressThread = Threading::CreateThread(CapturePrecompressThread, NULL);
+  }
+}
+
+void RenderDoc::StopCapturePrecompress()
+{
+  {
+    SCOPED_LOCK(m_CapturePrecompressLock);
+    m_CapturePrecompressQueue.clear();
+    m_CapturePrecompressCancel = true;
+  }
+
+  if(m_CapturePrecompressThread)
+  {
+    Threading::JoinThread(m_CapturePrecompressThread);
+    Threading::CloseThread(m_CapturePrecompressThread);
+    m_CapturePrecompressThread = 0;
+  }
+}
+
+void RenderDoc::CapturePrecompressThread(void *s)
+{
+  Threading::KeepModuleAlive();
+
+  Threading::SetCurrentThreadLowPriority();
+
+  RenderDoc &rdoc = RenderDoc::Inst();
+
+  for(;;)
+  {
+    string logFile;
+
+    {
+      SCOPED_LOCK(rdoc.m_CapturePrecompressLock);
+
+      if(rdoc.m_CapturePrecompressQueue.empty() || rdoc.m_CapturePrecompressCancel)
+      {
+        rdoc.m_CapturePrecompressRunning = false;
+        break;
+      }
+
+      logFile = rdoc.m_CapturePrecompressQueue.front();
+      rdoc.m_CapturePrecompressQueue.erase(rdoc.m_CapturePrecompressQueue.begin());
+    }
+
+    WritePrecompressedChunks(logFile.c_str(), &rdoc.m_CapturePrecompressCancel);
+  }
+
+  Threading::ReleaseModuleExitThread();
 }
 
 void RenderDoc::AddDeviceFrameCapturer(void *dev, IFrameCapturer *cap)
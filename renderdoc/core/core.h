@@ -35,6 +35,7 @@
 #include "api/replay/renderdoc_replay.h"
 #include "common/threading.h"
 #include "common/timing.h"
+#include "core/call_stats.h"
 #include "os/os_specific.h"
 
 using std::string;
@@ -154,16 +155,49 @@ struct RDCInitParams
   Serialiser *GetSerialiser() { return m_pSerialiser; }
 };
 
+// lets another thread follow a capture file while FlushToDisk writes it, to send it on before it's
+// finished. Bytes from stableStart to stableEnd are flushed to disk and won't change again, while
+// the header before stableStart is only final once the file is complete.
+struct CaptureWriteStream
+{
+  CaptureWriteStream() : stableStart(0), stableEnd(0), complete(false), failed(false) {}
+  Threading::CriticalSection lock;
+  string filename;
+  uint64_t stableStart, stableEnd;
+  bool complete, failed;
+};
+
 struct CaptureData
 {
   CaptureData(string p, uint64_t t, uint32_t f)
-      : path(p), timestamp(t), frameNumber(f), retrieved(false)
+      : path(p), timestamp(t), frameNumber(f), retrieved(false), sessionIndex(~0U), extracted(false)
   {
   }
   string path;
   uint64_t timestamp;
   uint32_t frameNumber;
   bool retrieved;
+  // captures appended to the session file have their index there, and are only written to path
+  // once something needs the file. See RenderDoc::EnsureCaptureFile
+  uint32_t sessionIndex;
+  bool extracted;
+};
+
+// summary of a capture, stored at the start of the file so it can be read without opening the
+// whole capture, e.g. to list a directory of captures. See RenderDoc::ReadCaptureMetadata.
+struct CaptureMetadata
+{
+  CaptureMetadata()
+      : driverType(RDC_Unknown), machineIdent(0), frameNumber(0), thumbWidth(0), thumbHeight(0)
+  {
+  }
+  RDCDriver driverType;
+  string driverName;
+  uint64_t machineIdent;
+  uint32_t frameNumber;
+  // JPG encoded, empty if the capture has no thumbnail
+  uint32_t thumbWidth, thumbHeight;
+  vector<byte> thumbnail;
 };
 
 enum LoadProgressSection
@@ -176,6 +210,7 @@ enum LoadProgressSection
 
 class IRemoteDriver;
 class IReplayDriver;
+class CaptureSessionWriter;
 
 typedef ReplayStatus (*RemoteDriverProvider)(const char *logfile, IRemoteDriver **driver);
 typedef ReplayStatus (*ReplayDriverProvider)(const char *logfile, IReplayDriver **driver);
@@ -195,9 +230,21 @@ class RenderDoc
 public:
   static RenderDoc &Inst();
 
-  void SetProgressPtr(float *progress) { m_ProgressPtr = progress; }
+  // the load progress and GPU choice are per-thread, like the cancel flag below, so that several
+  // captures can be opened concurrently from different threads without clobbering each other.
+  void SetProgressPtr(float *progress);
   void SetProgress(LoadProgressSection section, float delta);
 
+  // ~0U lets the driver pick the GPU that best matches the capture
+  void SetReplayGPU(uint32_t gpu);
+  uint32_t GetReplayGPU();
+
+  // the cancel flag for replay work on the calling thread. Long-running replay loops poll
+  // IsReplayCancelled() and stop early, leaving partial results, once it's been set.
+  void SetReplayCancelFlag(volatile bool *flag);
+  volatile bool *GetReplayCancelFlag();
+  bool IsReplayCancelled();
+
   // set from outside of the device creation interface
   void SetLogFile(const char *logFile);
   const char *GetLogFile() const { return m_LogFile.c_str(); }
@@ -217,9 +264,22 @@ public:
   void RecreateCrashHandler();
   void UnloadCrashHandler();
   ICrashHandler *GetCrashHandler() const { return m_ExHandler; }
-  Serialiser *OpenWriteSerialiser(uint32_t frameNum, RDCInitParams *params, void *thpixels,
-                                  size_t thlen, uint32_t thwidth, uint32_t thheight);
-  void SuccessfullyWrittenLog(uint32_t frameNumber);
+  // thpixels is an optional tightly packed RGB8 thumbnail allocated with new[], which is owned by
+  // the serialiser from then on. It's only encoded when the capture is written, so with the
+  // WriteCapturesAsync option the encode happens on the background thread.
+  Serialiser *OpenWriteSerialiser(uint32_t frameNum, RDCInitParams *params, byte *thpixels,
+                                  uint32_t thwidth, uint32_t thheight);
+  // writes the capture in a serialiser from OpenWriteSerialiser to disk and deletes it. With the
+  // WriteCapturesAsync option the write happens on a background thread, and the caller is free to
+  // modify or delete any chunks it inserted as soon as this returns.
+  void FinishWriteSerialiser(Serialiser *fileSerialiser, uint32_t frameNumber);
+  // the fraction of the current background capture write that's done, or -1 if none is happening
+  float GetCaptureWriteProgress() const { return m_CaptureWriteProgress; }
+  void SuccessfullyWrittenLog(const string &logFile, uint32_t frameNumber,
+                              uint32_t sessionIndex = ~0U);
+  // writes out a capture that was appended to the session file as a standalone capture at its
+  // path, if it hasn't been already. Returns false if that fails.
+  bool EnsureCaptureFile(uint32_t idx);
 
   void AddChildProcess(uint32_t pid, uint32_t ident)
   {
@@ -249,6 +309,17 @@ public:
 
   ReplayStatus FillInitParams(const char *logfile, RDCDriver &driverType, string &driverName,
                               uint64_t &fileMachineIdent, RDCInitParams *params);
+  // reads only the metadata at the start of a capture. Returns false for anything that isn't a
+  // capture, and for captures written before the metadata was added.
+  static bool ReadCaptureMetadata(const char *logfile, CaptureMetadata &metadata);
+  // the metadata in the form it's stored in a capture's metadata section
+  static void EncodeCaptureMetadata(const CaptureMetadata &metadata, vector<byte> &data);
+  static bool DecodeCaptureMetadata(const byte *data, size_t len, CaptureMetadata &metadata);
+  // copies a capture to destfile without replaying it, recompressing the frame data and
+  // regenerating the chunk index. Optionally drops the callstacks and the thumbnail.
+  static ReplayStatus RepackCapture(const char *logfile, const char *destfile,
+                                    uint32_t compressLevel, bool stripCallstacks,
+                                    bool stripThumbnail);
 
   void RegisterReplayProvider(RDCDriver driver, const char *name, ReplayDriverProvider provider);
   void RegisterRemoteProvider(RDCDriver driver, const char *name, RemoteDriverProvider provider);
@@ -298,6 +369,9 @@ public:
 
   void StartFrameCapture(void *dev, void *wnd);
   bool IsFrameCapturing() { return m_CapturesActive > 0; }
+  // called by drivers at each present during a capture they triggered themselves. Returns true if
+  // the capture should carry on recording the next frame instead of ending here.
+  bool ShouldContinueFrameCapture();
   void SetActiveWindow(void *dev, void *wnd);
   bool EndFrameCapture(void *dev, void *wnd);
 
@@ -311,7 +385,12 @@ public:
   void TriggerCapture(uint32_t numFrames) { m_Cap = numFrames; }
   uint32_t GetOverlayBits() { return m_Overlay; }
   void MaskOverlayBits(uint32_t And, uint32_t Or) { m_Overlay = (m_Overlay & And) | Or; }
-  void QueueCapture(uint32_t frameNumber) { m_QueuedFrameCaptures.insert(frameNumber); }
+  void QueueCapture(uint32_t frameNumber)
+  {
+    SCOPED_LOCK(m_QueuedCapturesLock);
+    m_QueuedFrameCaptures.insert(frameNumber);
+    m_NumQueuedCaptures = (int32_t)m_QueuedFrameCaptures.size();
+  }
   void SetFocusKeys(RENDERDOC_InputButton *keys, int num)
   {
     m_FocusKeys.resize(num);
@@ -329,6 +408,14 @@ public:
   const vector<RENDERDOC_InputButton> &GetCaptureKeys() { return m_CaptureKeys; }
   bool ShouldTriggerCapture(uint32_t frameNumber);
 
+  // true while CaptureOptions::ReduceIdleOverhead is enabled and no capture is pending or in
+  // progress, so drivers can skip bookkeeping that only matters for a capture.
+  bool IsIdleTrackingSuspended()
+  {
+    return m_Options.ReduceIdleOverhead && m_Cap == 0 && m_NumQueuedCaptures == 0 &&
+           m_CapturesActive == 0;
+  }
+
   enum
   {
     eOverlay_ActiveWindow = 0x1,
@@ -346,12 +433,28 @@ private:
   bool m_Replay;
 
   uint32_t m_Cap;
+  uint32_t m_CaptureFramesLeft;
+
+  // frames seen since idle tracking resumed for a pending capture
+  uint32_t m_IdleCatchUpFrames;
+
+  // state for the frame-time capture trigger, see CheckFrameTimeSpike. Frames are only compared
+  // once m_SpikeWarmupFrames has built up since startup or the last capture.
+  bool CheckFrameTimeSpike();
+  uint32_t m_CapturesStarted;
+  uint32_t m_SpikeCapturesSeen;
+  uint32_t m_SpikeWarmupFrames;
+  double m_SpikeAvgFrameTime;
 
   vector<RENDERDOC_InputButton> m_FocusKeys;
   vector<RENDERDOC_InputButton> m_CaptureKeys;
 
   FrameTimer m_FrameTimer;
 
+  // the API call stats shown in the overlay, refreshed once a second
+  PerformanceTimer m_OverlayCallStatsTimer;
+  vector<APICallStat> m_OverlayCallStats;
+
   string m_LoggingFilename;
 
   string m_Target;
@@ -360,7 +463,11 @@ private:
   CaptureOptions m_Options;
   uint32_t m_Overlay;
 
+  // frames queued over target control. The set is only touched with the lock held, and its size
+  // is mirrored in m_NumQueuedCaptures for checks made from other threads without the lock
+  Threading::CriticalSection m_QueuedCapturesLock;
   set<uint32_t> m_QueuedFrameCaptures;
+  volatile int32_t m_NumQueuedCaptures;
 
   uint32_t m_RemoteIdent;
   Threading::ThreadHandle m_RemoteThread;
@@ -369,7 +476,69 @@ private:
   RDCDriver m_CurrentDriver;
   string m_CurrentDriverName;
 
-  float *m_ProgressPtr;
+
+  struct CaptureThumbnail
+  {
+    byte *pixels;
+    uint32_t width, height;
+  };
+
+  struct CaptureWrite
+  {
+    Serialiser *fileSerialiser;
+    uint32_t frameNumber;
+    CaptureThumbnail thumbnail;
+    CaptureMetadata metadata;
+    bool appendToSession;
+  };
+
+  // thumbnails for serialisers between OpenWriteSerialiser and FinishWriteSerialiser, waiting to be
+  // encoded and inserted as the first chunk
+  Threading::CriticalSection m_ThumbnailLock;
+  map<Serialiser *, CaptureThumbnail> m_PendingThumbnails;
+
+  CaptureThumbnail TakePendingThumbnail(Serialiser *fileSerialiser);
+  // encodes the thumbnail and inserts it as the first chunk, then sets the file's metadata with it
+  static void InsertThumbnail(Serialiser *fileSerialiser, CaptureThumbnail &thumbnail,
+                              CaptureMetadata &metadata);
+  static void WriteCaptureMetadata(Serialiser *fileSerialiser, CaptureMetadata &metadata);
+
+  // only one capture is written in the background at once, so they're registered in order and at
+  // most one frame's extra copy of chunk data is alive at a time.
+  CaptureWrite m_CaptureWrite;
+  Threading::ThreadHandle m_CaptureWriteThread;
+  volatile float m_CaptureWriteProgress;
+
+  // the capture file being written, or the last one written, for target control to stream to its
+  // client while it's still being written
+  CaptureWriteStream m_CaptureWriteStream;
+
+  void WaitForCaptureWrite();
+  void BeginCaptureWriteStream(Serialiser *fileSerialiser);
+  static void CaptureWriteThread(void *s);
+
+  // with the AppendCapturesToSession option, captures are appended here instead of written to
+  // their own file. Created with the first capture appended.
+  CaptureSessionWriter *m_CaptureSession;
+  // held while a capture is extracted from the session, so it's only done once
+  Threading::CriticalSection m_CaptureExtractLock;
+
+  // appends the capture to the session file, or writes it to its own file if that's not enabled
+  // or fails, then deletes the serialiser
+  void WriteCapture(Serialiser *fileSerialiser, uint32_t frameNumber,
+                    const CaptureMetadata &metadata, bool appendToSession);
+
+  // on devices where captures are pulled over a slow link, they're compressed at low priority once
+  // written so the transfer doesn't have to. Captures are queued and compressed one at a time.
+  Threading::CriticalSection m_CapturePrecompressLock;
+  vector<string> m_CapturePrecompressQueue;
+  Threading::ThreadHandle m_CapturePrecompressThread;
+  bool m_CapturePrecompressRunning;
+  volatile bool m_CapturePrecompressCancel;
+
+  void QueueCapturePrecompress(const string &logFile);
+  void StopCapturePrecompress();
+  static void CapturePrecompressThread(void *s);
 
   Threading::CriticalSection m_CaptureLock;
   vector<CaptureData> m_Captures;
@@ -434,6 +603,12 @@ private:
   volatile bool m_ControlClientThreadShutdown;
   Threading::CriticalSection m_SingleClientLock;
   string m_SingleClientName;
+  bool m_SingleClientStreamCaptures;
+  uint32_t m_SingleClientCodecs;
+
+  uint64_t m_ReplayCancelSlot;
+  uint64_t m_ProgressSlot;
+  uint64_t m_ReplayGPUSlot;
 
   static void TargetControlServerThread(void *s);
   static void TargetControlClientThread(void *s);
@@ -441,6 +616,20 @@ private:
   ICrashHandler *m_ExHandler;
 };
 
+// sets the calling thread's replay cancel flag for the current scope, restoring the previous one
+// after so that nested calls don't clear an outer flag.
+struct ScopedReplayCancel
+{
+  ScopedReplayCancel(volatile bool *flag)
+  {
+    m_Prev = RenderDoc::Inst().GetReplayCancelFlag();
+    RenderDoc::Inst().SetReplayCancelFlag(flag);
+  }
+  ~ScopedReplayCancel() { RenderDoc::Inst().SetReplayCancelFlag(m_Prev); }
+private:
+  volatile bool *m_Prev;
+};
+
 struct DriverRegistration
 {
   DriverRegistration(RDCDriver driver, const char *name, ReplayDriverProvider provider)
@@ -120,8 +120,9 @@ public:
 
     _CrtSetReportMode(_CRT_ASSERT, 0);
     m_ExHandler = new google_breakpad::ExceptionHandler(
-        dumpFolder.c_str(), NULL, NULL, NULL, google_breakpad::ExceptionHandler::HANDLER_ALL,
-        dumpType, L"\\\\.\\pipe\\RenderDocBreakpadServer", &custom);
+        dumpFolder.c_str(), &FlushLogFilter, NULL, NULL,
+        google_breakpad::ExceptionHandler::HANDLER_ALL, dumpType,
+        L"\\\\.\\pipe\\RenderDocBreakpadServer", &custom);
 
     m_ExHandler->set_handle_debug_exceptions(true);
 
@@ -139,6 +140,16 @@ public:
   void RegisterMemoryRegion(void *mem, size_t size) { m_ExHandler->RegisterAppMemory(mem, size); }
   void UnregisterMemoryRegion(void *mem) { m_ExHandler->UnregisterAppMemory(mem); }
 private:
+  // logging is asynchronous, so make sure everything logged up to the crash is written out
+  static bool FlushLogFilter(void *context, EXCEPTION_POINTERS *exinfo,
+                             MDRawAssertionInfo *assertion)
+  {
+#if DISABLED(STRIP_LOG)
+    rdclog_crashflush();
+#endif
+    return true;
+  }
+
   google_breakpad::ExceptionHandler *m_ExHandler;
 };
 
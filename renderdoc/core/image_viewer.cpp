@@ -35,6 +35,8 @@ public:
   ImageViewer(IReplayDriver *proxy, const char *filename)
       : m_Proxy(proxy), m_Filename(filename), m_TextureID()
   {
+    RDCEraseEl(m_DDS);
+
     if(m_Proxy == NULL)
       RDCERR("Unexpectedly NULL proxy at creation of ImageViewer");
 
@@ -61,6 +63,9 @@ public:
 
   virtual ~ImageViewer()
   {
+    delete[] m_DDS.subsizes;
+    delete[] m_DDS.suboffsets;
+
     m_Proxy->Shutdown();
     m_Proxy = NULL;
   }
@@ -101,23 +106,27 @@ public:
   bool GetMinMax(ResourceId texid, uint32_t sliceFace, uint32_t mip, uint32_t sample,
                  CompType typeHint, float *minval, float *maxval)
   {
+    LoadSubresource(sliceFace, mip);
     return m_Proxy->GetMinMax(m_TextureID, sliceFace, mip, sample, typeHint, minval, maxval);
   }
   bool GetHistogram(ResourceId texid, uint32_t sliceFace, uint32_t mip, uint32_t sample,
                     CompType typeHint, float minval, float maxval, bool channels[4],
                     vector<uint32_t> &histogram)
   {
+    LoadSubresource(sliceFace, mip);
     return m_Proxy->GetHistogram(m_TextureID, sliceFace, mip, sample, typeHint, minval, maxval,
                                  channels, histogram);
   }
   bool RenderTexture(TextureDisplay cfg)
   {
     cfg.texid = m_TextureID;
+    LoadSubresource(cfg.sliceFace, cfg.mip);
     return m_Proxy->RenderTexture(cfg);
   }
   void PickPixel(ResourceId texture, uint32_t x, uint32_t y, uint32_t sliceFace, uint32_t mip,
                  uint32_t sample, CompType typeHint, float pixel[4])
   {
+    LoadSubresource(sliceFace, mip);
     m_Proxy->PickPixel(m_TextureID, x, y, sliceFace, mip, sample, typeHint, pixel);
   }
   uint32_t PickVertex(uint32_t eventID, const MeshDisplay &cfg, uint32_t x, uint32_t y)
@@ -133,6 +142,7 @@ public:
   ResourceId ApplyCustomShader(ResourceId shader, ResourceId texid, uint32_t mip, uint32_t arrayIdx,
                                uint32_t sampleIdx, CompType typeHint)
   {
+    LoadSubresource(arrayIdx, mip);
     return m_Proxy->ApplyCustomShader(shader, m_TextureID, mip, arrayIdx, sampleIdx, typeHint);
   }
   vector<ResourceId> GetTextures() { return m_Proxy->GetTextures(); }
@@ -140,8 +150,15 @@ public:
   byte *GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
                        const GetTextureDataParams &params, size_t &dataSize)
   {
+    LoadSubresource(arrayIdx, mip);
     return m_Proxy->GetTextureData(m_TextureID, arrayIdx, mip, params, dataSize);
   }
+  vector<TextureThumbnail> GetTextureThumbnails(const vector<TextureThumbnailRequest> &textures,
+                                                uint32_t size)
+  {
+    // there's only ever the one texture, which is cheap enough to display directly
+    return vector<TextureThumbnail>(textures.size());
+  }
 
   // handle a couple of operations ourselves to return a simple fake log
   APIProperties GetAPIProperties() { return m_Props; }
@@ -154,6 +171,7 @@ public:
   }
   vector<ResourceId> GetBuffers() { return vector<ResourceId>(); }
   vector<DebugMessage> GetDebugMessages() { return vector<DebugMessage>(); }
+  vector<MemoryUsage> GetMemoryUsage() { return m_Proxy->GetMemoryUsage(); }
   BufferDescription GetBuffer(ResourceId id)
   {
     BufferDescription ret;
@@ -165,6 +183,8 @@ public:
   GLPipe::State GetGLPipelineState() { return GLPipe::State(); }
   VKPipe::State GetVulkanPipelineState() { return VKPipe::State(); }
   void ReplayLog(uint32_t endEventID, ReplayLogType replayType) {}
+  bool AdvanceReplay(uint32_t fromEventID, uint32_t toEventID) { return false; }
+  void SetPrunedEvents(const vector<uint32_t> &eventIDs) {}
   vector<uint32_t> GetPassEvents(uint32_t eventID) { return vector<uint32_t>(); }
   vector<EventUsage> GetUsage(ResourceId id) { return vector<EventUsage>(); }
   bool IsRenderOutput(ResourceId id) { return false; }
@@ -179,6 +199,10 @@ public:
   {
     return vector<CounterResult>();
   }
+  vector<TextureSamplingFeedback> FetchTextureSampling(uint32_t startEventID, uint32_t endEventID)
+  {
+    return vector<TextureSamplingFeedback>();
+  }
   void FillCBufferVariables(ResourceId shader, string entryPoint, uint32_t cbufSlot,
                             vector<ShaderVariable> &outvars, const vector<byte> &data)
   {
@@ -208,6 +232,14 @@ public:
   {
     return vector<PixelModification>();
   }
+  vector<vector<PixelModification> > PixelHistoryRegion(vector<EventUsage> events,
+                                                        ResourceId target, uint32_t x, uint32_t y,
+                                                        uint32_t width, uint32_t height,
+                                                        uint32_t slice, uint32_t mip,
+                                                        uint32_t sampleIdx, CompType typeHint)
+  {
+    return vector<vector<PixelModification> >(width * height);
+  }
   ShaderDebugTrace DebugVertex(uint32_t eventID, uint32_t vertid, uint32_t instid, uint32_t idx,
                                uint32_t instOffset, uint32_t vertOffset)
   {
@@ -222,6 +254,15 @@ public:
     RDCEraseEl(ret);
     return ret;
   }
+  vector<ShaderDebugTrace> DebugVertices(uint32_t eventID, vector<ShaderDebugVertexInput> inputs,
+                                         uint32_t instOffset, uint32_t vertOffset)
+  {
+    return vector<ShaderDebugTrace>(inputs.size());
+  }
+  vector<ShaderDebugTrace> DebugPixels(uint32_t eventID, vector<ShaderDebugPixelInput> inputs)
+  {
+    return vector<ShaderDebugTrace>(inputs.size());
+  }
   ShaderDebugTrace DebugThread(uint32_t eventID, const uint32_t groupid[3],
                                const uint32_t threadid[3])
   {
@@ -262,6 +303,7 @@ public:
   void FileChanged() { RefreshFile(); }
 private:
   void RefreshFile();
+  void LoadSubresource(uint32_t arrayIdx, uint32_t mip);
 
   APIProperties m_Props;
   FrameRecord m_FrameRecord;
@@ -270,6 +312,12 @@ private:
   string m_Filename;
   ResourceId m_TextureID;
   TextureDescription m_TexDetails;
+
+  // DDS files are only read a subresource at a time as each one is first needed, so large arrays
+  // and volumes open quickly and only the slices and mips actually viewed are read. These are
+  // reset whenever the file changes.
+  dds_data m_DDS;
+  std::vector<bool> m_DDSLoaded;
 };
 
 ReplayStatus IMG_CreateReplayDevice(const char *logfile, IReplayDriver **driver)
@@ -330,20 +378,19 @@ ReplayStatus IMG_CreateReplayDevice(const char *logfile, IReplayDriver **driver)
   else if(is_dds_file(f))
   {
     FileIO::fseek64(f, 0, SEEK_SET);
-    dds_data read_data = load_dds_from_file(f);
+    dds_data read_data = load_dds_header_from_file(f);
+
+    bool valid = (read_data.subsizes != NULL);
+
+    delete[] read_data.subsizes;
+    delete[] read_data.suboffsets;
 
-    if(read_data.subdata == NULL)
+    if(!valid)
     {
       FileIO::fclose(f);
       RDCERR("DDS file recognised, but couldn't load");
       return ReplayStatus::ImageUnsupported;
     }
-
-    for(int i = 0; i < read_data.slices * read_data.mips; i++)
-      delete[] read_data.subdata[i];
-
-    delete[] read_data.subdata;
-    delete[] read_data.subsizes;
   }
   else
   {
@@ -424,6 +471,8 @@ void ImageViewer::RefreshFile()
   texDetails.name = m_Filename;
   texDetails.ID = m_TextureID;
   texDetails.byteSize = 0;
+  texDetails.allocationSize = 0;
+  texDetails.allocationAlignment = 0;
   texDetails.msQual = 0;
   texDetails.msSamp = 1;
   texDetails.format = rgba8_unorm;
@@ -569,12 +618,17 @@ void ImageViewer::RefreshFile()
 
   dds_data read_data = {0};
 
+  delete[] m_DDS.subsizes;
+  delete[] m_DDS.suboffsets;
+  RDCEraseEl(m_DDS);
+  m_DDSLoaded.clear();
+
   if(dds)
   {
     FileIO::fseek64(f, 0, SEEK_SET);
-    read_data = load_dds_from_file(f);
+    read_data = load_dds_header_from_file(f);
 
-    if(read_data.subdata == NULL)
+    if(read_data.subsizes == NULL)
     {
       FileIO::fclose(f);
       return;
@@ -620,6 +674,8 @@ void ImageViewer::RefreshFile()
   if(m_TextureID == ResourceId())
     m_TextureID = m_Proxy->CreateProxyTexture(texDetails);
 
+  m_TexDetails = texDetails;
+
   if(!dds)
   {
     m_Proxy->SetProxyTextureData(m_TextureID, 0, 0, data, datasize);
@@ -627,17 +683,46 @@ void ImageViewer::RefreshFile()
   }
   else
   {
-    for(uint32_t i = 0; i < texDetails.arraysize * texDetails.mips; i++)
-    {
-      m_Proxy->SetProxyTextureData(m_TextureID, i / texDetails.mips, i % texDetails.mips,
-                                   read_data.subdata[i], (size_t)read_data.subsizes[i]);
+    // subresources are loaded on first use. If the file changed but kept the same layout, the
+    // proxy texture is reused and only the subresources that get viewed again are re-read.
+    m_DDS = read_data;
+    m_DDSLoaded.resize(texDetails.arraysize * texDetails.mips, false);
+  }
 
-      delete[] read_data.subdata[i];
-    }
+  FileIO::fclose(f);
+}
 
-    delete[] read_data.subdata;
-    delete[] read_data.subsizes;
+void ImageViewer::LoadSubresource(uint32_t arrayIdx, uint32_t mip)
+{
+  if(m_DDSLoaded.empty())
+    return;
+
+  // each DDS subresource of a volume holds all its depth slices
+  uint32_t slice = m_TexDetails.depth > 1 ? 0 : arrayIdx;
+
+  if(slice >= m_TexDetails.arraysize || mip >= m_TexDetails.mips)
+    return;
+
+  uint32_t idx = slice * m_TexDetails.mips + mip;
+
+  if(m_DDSLoaded[idx])
+    return;
+
+  m_DDSLoaded[idx] = true;
+
+  FILE *f = FileIO::fopen(m_Filename.c_str(), "rb");
+
+  if(!f)
+  {
+    RDCERR("Couldn't open %s to read slice %u mip %u", m_Filename.c_str(), slice, mip);
+    return;
   }
 
+  byte *subdata = load_dds_subresource(f, m_DDS, (int)idx);
+
+  m_Proxy->SetProxyTextureData(m_TextureID, slice, mip, subdata, (size_t)m_DDS.subsizes[idx]);
+
+  delete[] subdata;
+
   FileIO::fclose(f);
 }
@@ -82,7 +82,7 @@ void Serialiser::Serialise(const char *name, EnvironmentModification &el)
   Serialise("value", el.value);
 }
 
-static const uint32_t RemoteServerProtocolVersion = 1;
+static const uint32_t RemoteServerProtocolVersion = 8;
 
 enum RemoteServerPacket
 {
@@ -193,6 +193,10 @@ static void InactiveRemoteClientThread(void *data)
          Network::GetIPOctet(ip, 1), Network::GetIPOctet(ip, 2), Network::GetIPOctet(ip, 3));
 }
 
+// the progress of opening a log is reported through a single global pointer, so with several
+// sessions open at once only one can be loading a capture at a time
+static Threading::CriticalSection logOpenLock;
+
 static void ActiveRemoteClientThread(void *data)
 {
   ClientThread *threadData = (ClientThread *)data;
@@ -214,13 +218,12 @@ static void ActiveRemoteClientThread(void *data)
   uint32_t version = 0;
   handshakeSer->Serialise("version", version);
 
-  SAFE_DELETE(handshakeSer);
-
   if(version != RemoteServerProtocolVersion)
   {
     RDCLOG("Connection using protocol %u, but we are running %u", version,
            RemoteServerProtocolVersion);
     SendPacket(threadData->socket, eRemoteServer_VersionMismatch);
+    SAFE_DELETE(handshakeSer);
     SAFE_DELETE(client);
     return;
   }
@@ -230,6 +233,12 @@ static void ActiveRemoteClientThread(void *data)
     SendPacket(threadData->socket, eRemoteServer_Handshake);
   }
 
+  uint32_t packetCodecs = ePacketCodec_None;
+  handshakeSer->Serialise("codecs", packetCodecs);
+  packetCodecs &= ePacketCodec_All;
+
+  SAFE_DELETE(handshakeSer);
+
   vector<string> tempFiles;
   IRemoteDriver *driver = NULL;
   ReplayProxy *proxy = NULL;
@@ -303,9 +312,16 @@ static void ActiveRemoteClientThread(void *data)
       else if(type == eRemoteServer_CopyCaptureFromRemote)
       {
         string path;
+        uint64_t offset = 0;
+        uint32_t checksum = 0;
         recvser->Serialise("path", path);
+        recvser->Serialise("offset", offset);
+        recvser->Serialise("checksum", checksum);
 
-        if(!SendChunkedFile(client, eRemoteServer_CopyCaptureFromRemote, path.c_str(), sendSer, NULL))
+        offset = VerifyFileResume(path.c_str(), offset, checksum);
+
+        if(!SendChunkedFile(client, eRemoteServer_CopyCaptureFromRemote, path.c_str(), sendSer, NULL,
+                            offset, ~0ULL, packetCodecs))
         {
           RDCERR("Network error sending file");
           SAFE_DELETE(recvser);
@@ -381,6 +397,8 @@ static void ActiveRemoteClientThread(void *data)
         }
         else if(RenderDoc::Inst().HasRemoteDriver(driverType))
         {
+          SCOPED_LOCK(logOpenLock);
+
           ProgressLoopData progressData;
 
           progressData.sock = client;
@@ -408,7 +426,7 @@ static void ActiveRemoteClientThread(void *data)
             Threading::JoinThread(ticker);
             Threading::CloseThread(ticker);
 
-            proxy = new ReplayProxy(client, driver);
+            proxy = new ReplayProxy(client, driver, packetCodecs);
           }
         }
         else
@@ -418,8 +436,29 @@ static void ActiveRemoteClientThread(void *data)
           status = ReplayStatus::APIUnsupported;
         }
 
+        // identify the capture by its path, size and modification time, for clients to cache data
+        // from it that won't change
+        uint32_t captureHash = 0;
+        if(status == ReplayStatus::Succeeded)
+        {
+          FILE *f = FileIO::fopen(cap_file.c_str(), "rb");
+          uint64_t fileSize = 0;
+          if(f)
+          {
+            FileIO::fseek64(f, 0, SEEK_END);
+            fileSize = FileIO::ftell64(f);
+            FileIO::fclose(f);
+          }
+
+          uint64_t timestamp = FileIO::GetModifiedTimestamp(cap_file);
+          captureHash = strhash(cap_file.c_str());
+          captureHash =
+              strhash(StringFormat::Fmt("%llu_%llu", fileSize, timestamp).c_str(), captureHash);
+        }
+
         sendType = eRemoteServer_LogOpened;
         sendSer.Serialise("status", status);
+        sendSer.Serialise("captureHash", captureHash);
       }
       else if(type == eRemoteServer_CloseLog)
       {
@@ -492,8 +531,6 @@ static void ActiveRemoteClientThread(void *data)
   RDCLOG("Closing active connection from %u.%u.%u.%u.", Network::GetIPOctet(ip, 0),
          Network::GetIPOctet(ip, 1), Network::GetIPOctet(ip, 2), Network::GetIPOctet(ip, 3));
 
-  RDCLOG("Ready for new active connection...");
-
   SAFE_DELETE(client);
 }
 
@@ -506,6 +543,7 @@ void RenderDoc::BecomeRemoteServer(const char *listenhost, uint16_t port, volati
 
   std::vector<std::pair<uint32_t, uint32_t> > listenRanges;
   bool allowExecution = true;
+  uint32_t maxSessions = 1;
 
   FILE *f = FileIO::fopen(FileIO::GetAppFolderFilename("remoteserver.conf").c_str(), "r");
 
@@ -545,6 +583,18 @@ void RenderDoc::BecomeRemoteServer(const char *listenhost, uint16_t port, volati
 
       continue;
     }
+    else if(line.substr(0, sizeof("maxsessions") - 1) == "maxsessions")
+    {
+      // how many clients can have sessions at once, each with its own replay and capture
+      int num = atoi(line.c_str() + sizeof("maxsessions") - 1);
+
+      if(num > 0)
+        maxSessions = (uint32_t)num;
+      else
+        RDCLOG("Couldn't parse session count from: %s", line.c_str());
+
+      continue;
+    }
 
     RDCLOG("Malformed line '%s'. See documentation for file format.", line.c_str());
   }
@@ -581,9 +631,11 @@ void RenderDoc::BecomeRemoteServer(const char *listenhost, uint16_t port, volati
   else
     RDCLOG("Blocking execution commands");
 
+  RDCLOG("Allowing up to %u concurrent sessions", maxSessions);
+
   RDCLOG("Replay host ready for requests...");
 
-  ClientThread *activeClientData = NULL;
+  std::vector<ClientThread *> actives;
 
   std::vector<ClientThread *> inactives;
 
@@ -591,7 +643,11 @@ void RenderDoc::BecomeRemoteServer(const char *listenhost, uint16_t port, volati
   {
     Network::Socket *client = sock->AcceptClient(false);
 
-    if(activeClientData && activeClientData->killServer)
+    bool killServer = false;
+    for(size_t i = 0; i < actives.size(); i++)
+      killServer |= actives[i]->killServer;
+
+    if(killServer)
       break;
 
     // reap any dead inactive threads
@@ -607,14 +663,21 @@ void RenderDoc::BecomeRemoteServer(const char *listenhost, uint16_t port, volati
       }
     }
 
-    // reap our active connection possibly
-    if(activeClientData && activeClientData->socket == NULL)
+    // reap any finished active connections
+    for(size_t i = 0; i < actives.size(); i++)
     {
-      Threading::JoinThread(activeClientData->thread);
-      Threading::CloseThread(activeClientData->thread);
+      if(actives[i]->socket == NULL)
+      {
+        Threading::JoinThread(actives[i]->thread);
+        Threading::CloseThread(actives[i]->thread);
 
-      delete activeClientData;
-      activeClientData = NULL;
+        delete actives[i];
+        actives.erase(actives.begin() + i);
+
+        RDCLOG("Ready for new active connection, %u of %u sessions in use...",
+               (uint32_t)actives.size(), maxSessions);
+        break;
+      }
     }
 
     if(client == NULL)
@@ -658,15 +721,18 @@ void RenderDoc::BecomeRemoteServer(const char *listenhost, uint16_t port, volati
       continue;
     }
 
-    if(activeClientData == NULL)
+    if(actives.size() < maxSessions)
     {
-      activeClientData = new ClientThread();
-      activeClientData->socket = client;
-      activeClientData->allowExecution = allowExecution;
+      ClientThread *active = new ClientThread();
+      active->socket = client;
+      active->allowExecution = allowExecution;
+
+      active->thread = Threading::CreateThread(ActiveRemoteClientThread, active);
 
-      activeClientData->thread = Threading::CreateThread(ActiveRemoteClientThread, activeClientData);
+      actives.push_back(active);
 
-      RDCLOG("Making active connection");
+      RDCLOG("Making active connection, %u of %u sessions in use", (uint32_t)actives.size(),
+             maxSessions);
     }
     else
     {
@@ -682,14 +748,15 @@ void RenderDoc::BecomeRemoteServer(const char *listenhost, uint16_t port, volati
     }
   }
 
-  if(activeClientData && activeClientData->socket != NULL)
+  // shut down active sessions
+  for(size_t i = 0; i < actives.size(); i++)
   {
-    activeClientData->killThread = true;
+    actives[i]->killThread = true;
 
-    Threading::JoinThread(activeClientData->thread);
-    Threading::CloseThread(activeClientData->thread);
+    Threading::JoinThread(actives[i]->thread);
+    Threading::CloseThread(actives[i]->thread);
 
-    delete activeClientData;
+    delete actives[i];
   }
 
   // shut down client threads
@@ -927,8 +994,16 @@ public:
   void CopyCaptureFromRemote(const char *remotepath, const char *localpath, float *progress)
   {
     string path = remotepath;
+
+    // a previous copy that failed partway is resumed from where it stopped, if the remote file is
+    // still the same
+    uint32_t checksum = 0;
+    uint64_t offset = GetFileResumeOffset(localpath, checksum);
+
     Serialiser sendData("", Serialiser::WRITING, false);
     sendData.Serialise("path", path);
+    sendData.Serialise("offset", offset);
+    sendData.Serialise("checksum", checksum);
     Send(eRemoteServer_CopyCaptureFromRemote, sendData);
 
     float dummy = 0.0f;
@@ -1037,7 +1112,9 @@ public:
     }
 
     ReplayStatus status = ReplayStatus::Succeeded;
+    uint32_t captureHash = 0;
     progressSer->Serialise("status", status);
+    progressSer->Serialise("captureHash", captureHash);
 
     SAFE_DELETE(progressSer);
 
@@ -1065,6 +1142,11 @@ public:
     ReplayController *rend = new ReplayController();
 
     ReplayProxy *proxy = new ReplayProxy(m_Socket, proxyDriver);
+
+    // the same path may be a different capture on another host
+    if(captureHash != 0)
+      proxy->LoadPersistentCache(strhash(m_hostname.c_str(), captureHash));
+
     status = rend->SetDevice(proxy);
 
     if(status != ReplayStatus::Succeeded)
@@ -1242,7 +1324,9 @@ RENDERDOC_CreateRemoteServerConnection(const char *host, uint32_t port, IRemoteS
 
   Serialiser sendData("", Serialiser::WRITING, false);
   uint32_t version = RemoteServerProtocolVersion;
+  uint32_t codecs = GetAcceptedPacketCodecs();
   sendData.Serialise("version", version);
+  sendData.Serialise("codecs", codecs);
   SendPacket(sock, eRemoteServer_Handshake, sendData);
 
   RemoteServerPacket type = (RemoteServerPacket)RecvPacket(sock);
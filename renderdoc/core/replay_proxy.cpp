@@ -24,7 +24,11 @@
  ******************************************************************************/
 
 #include "replay_proxy.h"
-#include "lz4/lz4.h"
+#include "api/replay/version.h"
+#include "common/profiler.h"
+#include "jpeg-compressor/jpgd.h"
+#include "jpeg-compressor/jpge.h"
+#include "serialise/string_utils.h"
 
 // these functions do compile time asserts on the size of the structure, to
 // help prevent the structure changing without these functions being updated.
@@ -209,6 +213,22 @@ void Serialiser::Serialise(const char *name, ShaderResource &el)
   SIZE_CHECK(96);
 }
 
+template <>
+void Serialiser::Serialise(const char *name, ShaderCost &el)
+{
+  Serialise("", el.instructions);
+  Serialise("", el.aluInstructions);
+  Serialise("", el.transcendentalInstructions);
+  Serialise("", el.sampleInstructions);
+  Serialise("", el.memoryInstructions);
+  Serialise("", el.flowControlInstructions);
+  Serialise("", el.tempRegisters);
+  Serialise("", el.loops);
+  Serialise("", el.maxLoopDepth);
+
+  SIZE_CHECK(36);
+}
+
 template <>
 void Serialiser::Serialise(const char *name, ShaderReflection &el)
 {
@@ -232,7 +252,9 @@ void Serialiser::Serialise(const char *name, ShaderReflection &el)
 
   Serialise("", el.Interfaces);
 
-  SIZE_CHECK(192);
+  Serialise("", el.Cost);
+
+  SIZE_CHECK(232);
 }
 
 template <>
@@ -274,6 +296,18 @@ void Serialiser::Serialise(const char *name, ShaderDebugState &el)
   SIZE_CHECK(56);
 }
 
+template <>
+void Serialiser::Serialise(const char *name, ShaderDebugStateDelta &el)
+{
+  Serialise("", el.registers);
+  Serialise("", el.outputs);
+  Serialise("", el.indexableTemps);
+  Serialise("", el.nextInstruction);
+  Serialise("", el.flags);
+
+  SIZE_CHECK(56);
+}
+
 template <>
 void Serialiser::Serialise(const char *name, ShaderDebugTrace &el)
 {
@@ -288,9 +322,12 @@ void Serialiser::Serialise(const char *name, ShaderDebugTrace &el)
   for(int32_t i = 0; i < numcbuffers; i++)
     Serialise("", el.cbuffers[i]);
 
-  Serialise("", el.states);
+  Serialise("", el.steps);
+  Serialise("", el.keyframes);
+  Serialise("", el.keyframeInterval);
+  Serialise("", el.disassembly);
 
-  SIZE_CHECK(48);
+  SIZE_CHECK(88);
 }
 
 #pragma endregion General Shader / State
@@ -1262,8 +1299,12 @@ void Serialiser::Serialise(const char *name, TextureDescription &el)
   Serialise("", el.msQual);
   Serialise("", el.msSamp);
   Serialise("", el.byteSize);
+  Serialise("", el.placeholderInitialContents);
+  Serialise("", el.allocationSize);
+  Serialise("", el.allocationAlignment);
+  Serialise("", el.memoryType);
 
-  SIZE_CHECK(136);
+  SIZE_CHECK(176);
 }
 
 template <>
@@ -1274,8 +1315,11 @@ void Serialiser::Serialise(const char *name, BufferDescription &el)
   Serialise("", el.customName);
   Serialise("", el.creationFlags);
   Serialise("", el.length);
+  Serialise("", el.allocationSize);
+  Serialise("", el.allocationAlignment);
+  Serialise("", el.memoryType);
 
-  SIZE_CHECK(40);
+  SIZE_CHECK(72);
 }
 
 template <>
@@ -1302,57 +1346,147 @@ void Serialiser::Serialise(const char *name, DebugMessage &el)
 }
 
 template <>
-void Serialiser::Serialise(const char *name, APIEvent &el)
+void Serialiser::Serialise(const char *name, SampledMip &el)
 {
-  Serialise("", el.eventID);
-  Serialise("", el.callstack);
-  Serialise("", el.eventDesc);
-  Serialise("", el.fileOffset);
+  Serialise("", el.mip);
+  Serialise("", el.numTilesSampled);
+  Serialise("", el.tiles);
 
-  SIZE_CHECK(48);
+  SIZE_CHECK(24);
 }
 
 template <>
-void Serialiser::Serialise(const char *name, DrawcallDescription &el)
+void Serialiser::Serialise(const char *name, TextureSamplingFeedback &el)
 {
-  Serialise("", el.eventID);
-  Serialise("", el.drawcallID);
+  Serialise("", el.resourceId);
+  Serialise("", el.gridSize);
+  Serialise("", el.mips);
 
-  Serialise("", el.name);
+  SIZE_CHECK(32);
+}
 
-  Serialise("", el.flags);
+template <>
+void Serialiser::Serialise(const char *name, MemoryUsage &el)
+{
+  Serialise("", el.category);
+  Serialise("", el.gpu);
+  Serialise("", el.count);
+  Serialise("", el.bytes);
+
+  SIZE_CHECK(40);
+}
+
+// drawcall and event names repeat a lot, e.g. every call to the same function has the same event
+// name. A frame record's names are sent once each in a string pool, and then referred to by their
+// offset in it. Without a pool the names are serialised inline.
+static void SerialiseName(Serialiser &ser, rdctype::str &name, StringPool *pool)
+{
+  if(pool == NULL)
+  {
+    ser.Serialise("", name);
+    return;
+  }
 
-  SerialisePODArray<4>("", el.markerColor);
+  uint32_t offset = 0;
+  if(ser.IsWriting())
+    offset = pool->Intern(name.c_str(), name.count);
 
-  Serialise("", el.numIndices);
-  Serialise("", el.numInstances);
-  Serialise("", el.baseVertex);
-  Serialise("", el.indexOffset);
-  Serialise("", el.vertexOffset);
-  Serialise("", el.instanceOffset);
+  ser.Serialise("", offset);
+
+  if(ser.IsReading())
+    name = pool->Get(offset);
+}
+
+static void SerialiseAPIEvent(Serialiser &ser, APIEvent &el, StringPool *pool)
+{
+  ser.Serialise("", el.eventID);
+  ser.Serialise("", el.callstack);
+  SerialiseName(ser, el.eventDesc, pool);
+  ser.Serialise("", el.fileOffset);
+  ser.Serialise("", el.cpuTimestamp);
+  ser.Serialise("", el.threadID);
+  ser.Serialise("", el.referencedResources);
+
+  SIZE_CHECK(80);
+}
+
+static void SerialiseDrawcall(Serialiser &ser, DrawcallDescription &el, StringPool *pool)
+{
+  ser.Serialise("", el.eventID);
+  ser.Serialise("", el.drawcallID);
 
-  SerialisePODArray<3>("", el.dispatchDimension);
-  SerialisePODArray<3>("", el.dispatchThreadsDimension);
+  SerialiseName(ser, el.name, pool);
 
-  Serialise("", el.indexByteWidth);
-  Serialise("", el.topology);
+  ser.Serialise("", el.flags);
 
-  Serialise("", el.copySource);
-  Serialise("", el.copyDestination);
+  ser.SerialisePODArray<4>("", el.markerColor);
 
-  Serialise("", el.parent);
-  Serialise("", el.previous);
-  Serialise("", el.next);
+  ser.Serialise("", el.numIndices);
+  ser.Serialise("", el.numInstances);
+  ser.Serialise("", el.baseVertex);
+  ser.Serialise("", el.indexOffset);
+  ser.Serialise("", el.vertexOffset);
+  ser.Serialise("", el.instanceOffset);
 
-  SerialisePODArray<8>("", el.outputs);
-  Serialise("", el.depthOut);
+  ser.SerialisePODArray<3>("", el.dispatchDimension);
+  ser.SerialisePODArray<3>("", el.dispatchThreadsDimension);
 
-  Serialise("", el.events);
-  Serialise("", el.children);
+  ser.Serialise("", el.indexByteWidth);
+  ser.Serialise("", el.topology);
+
+  ser.Serialise("", el.copySource);
+  ser.Serialise("", el.copyDestination);
+
+  ser.Serialise("", el.parent);
+  ser.Serialise("", el.previous);
+  ser.Serialise("", el.next);
+
+  ser.SerialisePODArray<8>("", el.outputs);
+  ser.Serialise("", el.depthOut);
+
+  // the same layout as serialising the arrays directly, but passing the pool down
+  int32_t numEvents = el.events.count;
+  ser.Serialise("", numEvents);
+  if(ser.IsReading())
+    create_array_uninit(el.events, numEvents);
+  for(int32_t i = 0; i < numEvents; i++)
+    SerialiseAPIEvent(ser, el.events[i], pool);
+
+  int32_t numChildren = el.children.count;
+  ser.Serialise("", numChildren);
+  if(ser.IsReading())
+    create_array_uninit(el.children, numChildren);
+  for(int32_t i = 0; i < numChildren; i++)
+    SerialiseDrawcall(ser, el.children[i], pool);
 
   SIZE_CHECK(248);
 }
 
+static void InternNames(const rdctype::array<DrawcallDescription> &draws, StringPool &pool)
+{
+  for(const DrawcallDescription &d : draws)
+  {
+    pool.Intern(d.name.c_str(), d.name.count);
+
+    for(const APIEvent &ev : d.events)
+      pool.Intern(ev.eventDesc.c_str(), ev.eventDesc.count);
+
+    InternNames(d.children, pool);
+  }
+}
+
+template <>
+void Serialiser::Serialise(const char *name, APIEvent &el)
+{
+  SerialiseAPIEvent(*this, el, NULL);
+}
+
+template <>
+void Serialiser::Serialise(const char *name, DrawcallDescription &el)
+{
+  SerialiseDrawcall(*this, el, NULL);
+}
+
 template <>
 void Serialiser::Serialise(const char *name, ConstantBindStats &el)
 {
@@ -1538,10 +1672,34 @@ void Serialiser::Serialise(const char *name, FrameStatistics &el)
   SIZE_CHECK(1136);
 }
 
+template <>
+void Serialiser::Serialise(const char *name, ThreadTimeline &el)
+{
+  Serialise("", el.threadID);
+  Serialise("", el.begin);
+  Serialise("", el.end);
+  Serialise("", el.numEvents);
+
+  SIZE_CHECK(32);
+}
+
+template <>
+void Serialiser::Serialise(const char *name, QueueSubmission &el)
+{
+  Serialise("", el.queue);
+  Serialise("", el.type);
+  Serialise("", el.eventID);
+  Serialise("", el.lastEventID);
+  Serialise("", el.waits);
+
+  SIZE_CHECK(24);
+}
+
 template <>
 void Serialiser::Serialise(const char *name, FrameDescription &el)
 {
   Serialise("", el.frameNumber);
+  Serialise("", el.frameCount);
   Serialise("", el.fileOffset);
   Serialise("", el.uncompressedFileSize);
   Serialise("", el.compressedFileSize);
@@ -1550,17 +1708,40 @@ void Serialiser::Serialise(const char *name, FrameDescription &el)
   Serialise("", el.captureTime);
   Serialise("", el.stats);
   Serialise("", el.debugMessages);
+  Serialise("", el.threadTimelines);
+  Serialise("", el.queueSubmissions);
 
-  SIZE_CHECK(1208);
+  SIZE_CHECK(1240);
 }
 
 template <>
 void Serialiser::Serialise(const char *name, FrameRecord &el)
 {
   Serialise("", el.frameInfo);
-  Serialise("", el.drawcallList);
 
-  SIZE_CHECK(1224);
+  // the pool has to be complete before any drawcalls are read, so it's built up front
+  StringPool pool;
+  string names;
+
+  if(IsWriting())
+  {
+    InternNames(el.drawcallList, pool);
+    names = pool.GetData();
+  }
+
+  Serialise("", names);
+
+  if(IsReading())
+    pool.SetData(names);
+
+  int32_t numDraws = el.drawcallList.count;
+  Serialise("", numDraws);
+  if(IsReading())
+    create_array_uninit(el.drawcallList, numDraws);
+  for(int32_t i = 0; i < numDraws; i++)
+    SerialiseDrawcall(*this, el.drawcallList[i], &pool);
+
+  SIZE_CHECK(1256);
 }
 
 template <>
@@ -1721,6 +1902,11 @@ string ToStrHelper<false, CounterUnit>::Get(const CounterUnit &el)
   return "<...>";
 }
 template <>
+string ToStrHelper<false, QueueType>::Get(const QueueType &el)
+{
+  return "<...>";
+}
+template <>
 string ToStrHelper<false, Topology>::Get(const Topology &el)
 {
   return "<...>";
@@ -1956,11 +2142,29 @@ string ToStrHelper<false, TextureFilter>::Get(const TextureFilter &el)
 {
   return "<...>";
 }
+template <>
+string ToStrHelper<false, ShaderDebugVertexInput>::Get(const ShaderDebugVertexInput &el)
+{
+  return "<...>";
+}
+template <>
+string ToStrHelper<false, ShaderDebugPixelInput>::Get(const ShaderDebugPixelInput &el)
+{
+  return "<...>";
+}
+template <>
+string ToStrHelper<false, ShaderRegisterChange>::Get(const ShaderRegisterChange &el)
+{
+  return "<...>";
+}
 
 #pragma endregion Plain - old data structures
 
 ReplayProxy::~ReplayProxy()
 {
+  if(!m_RemoteServer)
+    SavePersistentCache();
+
   SAFE_DELETE(m_FromReplaySerialiser);
   m_ToReplaySerialiser = NULL;    // we don't own this
 
@@ -1972,24 +2176,263 @@ ReplayProxy::~ReplayProxy()
     delete it->second;
 }
 
+// bumped whenever the contents of the persistent cache change
+static const uint32_t PersistentCacheVersion = 2;
+
+bool ReplayProxy::SerialisePersistentCache(Serialiser &ser, PersistentCache &cache)
+{
+  // caches are only shared between identical builds, as any of the structures may have changed
+  uint32_t version = PersistentCacheVersion;
+  string build = GIT_COMMIT_HASH;
+
+  ser.Serialise("", version);
+  ser.Serialise("", build);
+
+  if(ser.HasError() || version != PersistentCacheVersion || build != GIT_COMMIT_HASH)
+    return false;
+
+  ser.Serialise("", cache.textures);
+  ser.Serialise("", cache.buffers);
+
+  uint32_t numTextures = (uint32_t)cache.textureDescs.size();
+  ser.Serialise("", numTextures);
+
+  if(ser.IsReading())
+  {
+    for(uint32_t i = 0; i < numTextures && !ser.HasError(); i++)
+    {
+      TextureDescription desc;
+      ser.Serialise("", desc);
+      cache.textureDescs[desc.ID] = desc;
+    }
+  }
+  else
+  {
+    for(auto it = cache.textureDescs.begin(); it != cache.textureDescs.end(); ++it)
+      ser.Serialise("", it->second);
+  }
+
+  uint32_t numBuffers = (uint32_t)cache.bufferDescs.size();
+  ser.Serialise("", numBuffers);
+
+  if(ser.IsReading())
+  {
+    for(uint32_t i = 0; i < numBuffers && !ser.HasError(); i++)
+    {
+      BufferDescription desc;
+      ser.Serialise("", desc);
+      cache.bufferDescs[desc.ID] = desc;
+    }
+  }
+  else
+  {
+    for(auto it = cache.bufferDescs.begin(); it != cache.bufferDescs.end(); ++it)
+      ser.Serialise("", it->second);
+  }
+
+  ser.Serialise("", cache.hasFrameRecord);
+  if(cache.hasFrameRecord)
+    ser.Serialise("", cache.frameRecord);
+
+  uint32_t numShaders = (uint32_t)cache.shaders.size();
+  ser.Serialise("", numShaders);
+
+  if(ser.IsReading())
+  {
+    for(uint32_t i = 0; i < numShaders && !ser.HasError(); i++)
+    {
+      ShaderReflKey key;
+      ser.Serialise("", key.id);
+      ser.Serialise("", key.entryPoint);
+      ser.Serialise("", cache.shaders[key]);
+    }
+  }
+  else
+  {
+    for(auto it = cache.shaders.begin(); it != cache.shaders.end(); ++it)
+    {
+      ShaderReflKey key = it->first;
+      ser.Serialise("", key.id);
+      ser.Serialise("", key.entryPoint);
+      ser.Serialise("", it->second);
+    }
+  }
+
+  return !ser.HasError();
+}
+
+void ReplayProxy::LoadPersistentCache(uint32_t captureHash)
+{
+  if(m_RemoteServer || RenderDoc::Inst().GetConfigSetting("remote.persistentCache") == "0")
+    return;
+
+  PersistentCache loaded;
+  bool success = false;
+
+  string filename =
+      FileIO::GetAppFolderFilename(StringFormat::Fmt("remotecache_%08x.bin", captureHash));
+
+  vector<byte> data;
+  if(FileIO::slurp(filename.c_str(), data) && !data.empty())
+  {
+    Serialiser ser(data.size(), &data[0], false);
+    success = SerialisePersistentCache(ser, loaded);
+  }
+
+  // these are always fetched, to check the saved IDs still refer to the same resources
+  vector<ResourceId> textures = GetTextures();
+  vector<ResourceId> buffers = GetBuffers();
+
+  if(!m_Socket->Connected())
+    return;
+
+  if(success && loaded.textures == textures && loaded.buffers == buffers)
+  {
+    RDCLOG("Using persistent cache for remote capture: %u textures, %u buffers, %u shaders",
+           (uint32_t)loaded.textureDescs.size(), (uint32_t)loaded.bufferDescs.size(),
+           (uint32_t)loaded.shaders.size());
+
+    m_PersistentCache = loaded;
+  }
+  else
+  {
+    m_PersistentCache = PersistentCache();
+    m_PersistentCache.textures = textures;
+    m_PersistentCache.buffers = buffers;
+    m_PersistentCache.dirty = true;
+  }
+
+  m_PersistentCache.filename = filename;
+  m_PersistentCache.valid = true;
+}
+
+void ReplayProxy::SavePersistentCache()
+{
+  if(!m_PersistentCache.valid || !m_PersistentCache.dirty)
+    return;
+
+  Serialiser ser(NULL, Serialiser::WRITING, false);
+
+  if(!SerialisePersistentCache(ser, m_PersistentCache))
+    return;
+
+  FileIO::CreateParentDirectory(m_PersistentCache.filename);
+
+  if(!FileIO::dump(m_PersistentCache.filename.c_str(), ser.GetRawPtr(0), (size_t)ser.GetOffset()))
+    RDCWARN("Couldn't write persistent cache to %s", m_PersistentCache.filename.c_str());
+}
+
+// commands with no results, which are sent without waiting for a reply
+static bool IsAsyncCommand(int type)
+{
+  switch(type)
+  {
+    case eReplayProxy_ReplayLog:
+    case eReplayProxy_InitPostVS:
+    case eReplayProxy_InitPostVSVec:
+    case eReplayProxy_FreeResource:
+    case eReplayProxy_ReplaceResource:
+    case eReplayProxy_RemoveReplacement: return true;
+    default: break;
+  }
+
+  return false;
+}
+
 bool ReplayProxy::SendReplayCommand(ReplayProxyPacket type)
 {
+  SCOPED_PROFILE("ReplayProxy::SendReplayCommand", type);
+
+  RDCASSERT(!IsAsyncCommand(type));
+
   if(!m_Socket->Connected())
     return false;
 
-  if(!SendPacket(m_Socket, type, *m_ToReplaySerialiser))
+  // any queued async commands go out in the same send as this one, ahead of it
+  uint32_t t = (uint32_t)type;
+  uint32_t payloadLength = m_ToReplaySerialiser->GetOffset() & 0xffffffff;
+
+  Network::SendBuffer bufs[] = {
+      {m_PendingCommands.empty() ? NULL : &m_PendingCommands[0], (uint32_t)m_PendingCommands.size()},
+      {&t, sizeof(t)},
+      {&payloadLength, sizeof(payloadLength)},
+      {m_ToReplaySerialiser->GetRawPtr(0), payloadLength},
+  };
+
+  m_PendingCommands.clear();
+
+  if(!m_Socket->SendDataBlocking(bufs, ARRAY_COUNT(bufs)))
     return false;
 
   m_ToReplaySerialiser->Rewind();
 
+  uint32_t expectedID = m_NextRequestID++;
+
   SAFE_DELETE(m_FromReplaySerialiser);
 
-  if(!RecvPacket(m_Socket, type, &m_FromReplaySerialiser))
+  ReplayProxyPacket replyType = type;
+  if(!RecvPacket(m_Socket, replyType, &m_FromReplaySerialiser))
+    return false;
+
+  uint32_t requestID = ~0U;
+  m_FromReplaySerialiser->Serialise("", requestID);
+
+  if(replyType != type || requestID != expectedID)
+  {
+    RDCERR("Expected reply to request %u (%d), but got %u (%d). Closing connection.", expectedID,
+           type, requestID, replyType);
+
+    // there's no way to get back in step, so make sure nothing else reads garbage
+    m_Socket->Shutdown();
+    return false;
+  }
+
+  return true;
+}
+
+bool ReplayProxy::SendReplayCommandAsync(ReplayProxyPacket type)
+{
+  SCOPED_PROFILE("ReplayProxy::SendReplayCommandAsync", type);
+
+  RDCASSERT(IsAsyncCommand(type));
+
+  if(!m_Socket->Connected())
     return false;
 
+  uint32_t t = (uint32_t)type;
+  uint32_t payloadLength = m_ToReplaySerialiser->GetOffset() & 0xffffffff;
+  const byte *payload = m_ToReplaySerialiser->GetRawPtr(0);
+
+  m_PendingCommands.insert(m_PendingCommands.end(), (const byte *)&t, (const byte *)(&t + 1));
+  m_PendingCommands.insert(m_PendingCommands.end(), (const byte *)&payloadLength,
+                           (const byte *)(&payloadLength + 1));
+  m_PendingCommands.insert(m_PendingCommands.end(), payload, payload + payloadLength);
+
+  m_ToReplaySerialiser->Rewind();
+  m_NextRequestID++;
+
+  // a replay is worth starting on straight away since it takes a while, and there's no point
+  // holding on to too much at once
+  static const size_t MaxPendingSize = 64 * 1024;
+
+  if(type == eReplayProxy_ReplayLog || m_PendingCommands.size() >= MaxPendingSize)
+    return FlushPendingCommands();
+
   return true;
 }
 
+bool ReplayProxy::FlushPendingCommands()
+{
+  if(m_PendingCommands.empty())
+    return true;
+
+  bool ret = m_Socket->SendDataBlocking(&m_PendingCommands[0], (uint32_t)m_PendingCommands.size());
+
+  m_PendingCommands.clear();
+
+  return ret;
+}
+
 template <>
 string ToStrHelper<false, RemapTextureEnum>::Get(const RemapTextureEnum &el)
 {
@@ -2089,13 +2532,20 @@ void ReplayProxy::EnsureTexCached(ResourceId texid, uint32_t arrayIdx, uint32_t
 
     const ProxyTextureProperties &proxy = m_ProxyTextures[texid];
 
-    size_t size;
-    byte *data = GetTextureData(texid, arrayIdx, mip, proxy.params, size);
+    // only the parts that changed since we last fetched this subresource come over the network,
+    // but the whole patched copy is uploaded as that's cheap locally.
+    TextureDataCopy &copy = m_TextureDataCopies[entry];
+    GetTextureDataDelta(texid, arrayIdx, mip, proxy.params, copy);
 
-    if(data)
-      m_Proxy->SetProxyTextureData(proxy.id, arrayIdx, mip, data, size);
-
-    delete[] data;
+    if(!copy.data.empty())
+    {
+      m_Proxy->SetProxyTextureData(proxy.id, arrayIdx, mip, &copy.data[0], copy.data.size());
+      m_ProxyTextureSizes[entry] = copy.data.size();
+    }
+    else
+    {
+      m_TextureDataCopies.erase(entry);
+    }
 
     m_TextureProxyCache.insert(entry);
   }
@@ -2120,7 +2570,10 @@ void ReplayProxy::EnsureBufCached(ResourceId bufid)
     GetBufferData(bufid, 0, 0, data);
 
     if(!data.empty())
+    {
       m_Proxy->SetProxyBufferData(proxyid, &data[0], data.size());
+      m_ProxyBufferSizes[bufid] = data.size();
+    }
 
     m_BufferProxyCache.insert(bufid);
   }
@@ -2138,6 +2591,9 @@ bool ReplayProxy::Tick(int type, Serialiser *incomingPacket)
 
   m_FromReplaySerialiser->Rewind();
 
+  uint32_t requestID = m_NextRequestID++;
+  m_FromReplaySerialiser->Serialise("", requestID);
+
   switch(type)
   {
     case eReplayProxy_ReplayLog: ReplayLog(0, (ReplayLogType)0); break;
@@ -2149,6 +2605,7 @@ bool ReplayProxy::Tick(int type, Serialiser *incomingPacket)
     case eReplayProxy_GetBuffer: GetBuffer(ResourceId()); break;
     case eReplayProxy_GetShader: GetShader(ResourceId(), ""); break;
     case eReplayProxy_GetDebugMessages: GetDebugMessages(); break;
+    case eReplayProxy_GetMemoryUsage: GetMemoryUsage(); break;
     case eReplayProxy_SavePipelineState: SavePipelineState(); break;
     case eReplayProxy_GetUsage: GetUsage(ResourceId()); break;
     case eReplayProxy_GetLiveID: GetLiveID(ResourceId()); break;
@@ -2166,6 +2623,8 @@ bool ReplayProxy::Tick(int type, Serialiser *incomingPacket)
       break;
     }
     case eReplayProxy_EnumerateCounters: EnumerateCounters(); break;
+    case eReplayProxy_FetchTextureSampling: FetchTextureSampling(0, 0); break;
+    case eReplayProxy_AdvanceReplay: AdvanceReplay(0, 0); break;
     case eReplayProxy_DescribeCounter:
     {
       CounterDescription desc;
@@ -2191,6 +2650,22 @@ bool ReplayProxy::Tick(int type, Serialiser *incomingPacket)
       GetTextureData(ResourceId(), 0, 0, GetTextureDataParams(), dummy);
       break;
     }
+    case eReplayProxy_GetTextureDataDelta:
+    {
+      TextureDataCopy dummy;
+      GetTextureDataDelta(ResourceId(), 0, 0, GetTextureDataParams(), dummy);
+      break;
+    }
+    case eReplayProxy_GetStreamedTexture:
+    {
+      uint32_t w, h;
+      vector<byte> dummy;
+      GetStreamedTexture(ResourceId(), 0, 0, GetTextureDataParams(), w, h, dummy);
+      break;
+    }
+    case eReplayProxy_GetTextureThumbnails:
+      GetTextureThumbnails(vector<TextureThumbnailRequest>(), 0);
+      break;
     case eReplayProxy_InitPostVS: InitPostVSBuffers(0); break;
     case eReplayProxy_InitPostVSVec:
     {
@@ -2210,8 +2685,16 @@ bool ReplayProxy::Tick(int type, Serialiser *incomingPacket)
     case eReplayProxy_PixelHistory:
       PixelHistory(vector<EventUsage>(), ResourceId(), 0, 0, 0, 0, 0, CompType::Typeless);
       break;
+    case eReplayProxy_PixelHistoryRegion:
+      PixelHistoryRegion(vector<EventUsage>(), ResourceId(), 0, 0, 0, 0, 0, 0, 0,
+                         CompType::Typeless);
+      break;
     case eReplayProxy_DebugVertex: DebugVertex(0, 0, 0, 0, 0, 0); break;
     case eReplayProxy_DebugPixel: DebugPixel(0, 0, 0, 0, 0); break;
+    case eReplayProxy_DebugVertices:
+      DebugVertices(0, vector<ShaderDebugVertexInput>(), 0, 0);
+      break;
+    case eReplayProxy_DebugPixels: DebugPixels(0, vector<ShaderDebugPixelInput>()); break;
     case eReplayProxy_DebugThread:
     {
       uint32_t dummy1[3] = {0};
@@ -2222,7 +2705,10 @@ bool ReplayProxy::Tick(int type, Serialiser *incomingPacket)
     default: RDCERR("Unexpected command"); return false;
   }
 
-  if(!SendPacket(m_Socket, type, *m_FromReplaySerialiser))
+  if(IsAsyncCommand(type))
+    return true;
+
+  if(!SendCompressedPacket(m_Socket, type, *m_FromReplaySerialiser, m_PacketCodecs))
     return false;
 
   return true;
@@ -2278,6 +2764,9 @@ vector<ResourceId> ReplayProxy::GetTextures()
 {
   vector<ResourceId> ret;
 
+  if(!m_RemoteServer && m_PersistentCache.valid)
+    return m_PersistentCache.textures;
+
   if(m_RemoteServer)
   {
     ret = m_Remote->GetTextures();
@@ -2312,11 +2801,70 @@ vector<DebugMessage> ReplayProxy::GetDebugMessages()
   return ret;
 }
 
-TextureDescription ReplayProxy::GetTexture(ResourceId id)
+vector<MemoryUsage> ReplayProxy::GetMemoryUsage()
 {
-  TextureDescription ret = {};
+  vector<MemoryUsage> ret;
 
-  m_ToReplaySerialiser->Serialise("", id);
+  if(m_RemoteServer)
+  {
+    ret = m_Remote->GetMemoryUsage();
+
+    uint64_t bytes = 0;
+    for(auto it = m_TextureDataCopies.begin(); it != m_TextureDataCopies.end(); ++it)
+      bytes += it->second.data.size();
+    ret.push_back(MakeMemoryUsage("Sent texture copies", false, m_TextureDataCopies.size(), bytes));
+  }
+  else
+  {
+    if(!SendReplayCommand(eReplayProxy_GetMemoryUsage))
+      return ret;
+  }
+
+  m_FromReplaySerialiser->Serialise("", ret);
+
+  if(!m_RemoteServer)
+  {
+    // the remote's categories are reported as-is, the ones below are held locally to proxy its
+    // resources and results.
+    uint64_t bytes = 0;
+    for(auto it = m_ProxyTextureSizes.begin(); it != m_ProxyTextureSizes.end(); ++it)
+      bytes += it->second;
+    ret.push_back(MakeMemoryUsage("Proxy textures", true, m_ProxyTextures.size(), bytes));
+
+    bytes = 0;
+    for(auto it = m_TextureDataCopies.begin(); it != m_TextureDataCopies.end(); ++it)
+      bytes += it->second.data.size();
+    ret.push_back(
+        MakeMemoryUsage("Proxy texture copies", false, m_TextureDataCopies.size(), bytes));
+
+    bytes = 0;
+    for(auto it = m_ProxyBufferSizes.begin(); it != m_ProxyBufferSizes.end(); ++it)
+      bytes += it->second;
+    ret.push_back(MakeMemoryUsage("Proxy buffers", true, m_ProxyBufferIds.size(), bytes));
+
+    bytes = 0;
+    for(auto it = m_ShaderReflectionCache.begin(); it != m_ShaderReflectionCache.end(); ++it)
+      if(it->second)
+        bytes += GetShaderReflectionSize(*it->second);
+    ret.push_back(MakeMemoryUsage("Proxy shader reflection", false,
+                                  m_ShaderReflectionCache.size(), bytes));
+  }
+
+  return ret;
+}
+
+TextureDescription ReplayProxy::GetTexture(ResourceId id)
+{
+  TextureDescription ret = {};
+
+  if(!m_RemoteServer && m_PersistentCache.valid)
+  {
+    auto it = m_PersistentCache.textureDescs.find(id);
+    if(it != m_PersistentCache.textureDescs.end())
+      return it->second;
+  }
+
+  m_ToReplaySerialiser->Serialise("", id);
 
   if(m_RemoteServer)
   {
@@ -2330,6 +2878,12 @@ TextureDescription ReplayProxy::GetTexture(ResourceId id)
 
   m_FromReplaySerialiser->Serialise("", ret);
 
+  if(!m_RemoteServer && m_PersistentCache.valid)
+  {
+    m_PersistentCache.textureDescs[id] = ret;
+    m_PersistentCache.dirty = true;
+  }
+
   return ret;
 }
 
@@ -2337,6 +2891,9 @@ vector<ResourceId> ReplayProxy::GetBuffers()
 {
   vector<ResourceId> ret;
 
+  if(!m_RemoteServer && m_PersistentCache.valid)
+    return m_PersistentCache.buffers;
+
   if(m_RemoteServer)
   {
     ret = m_Remote->GetBuffers();
@@ -2356,6 +2913,13 @@ BufferDescription ReplayProxy::GetBuffer(ResourceId id)
 {
   BufferDescription ret = {};
 
+  if(!m_RemoteServer && m_PersistentCache.valid)
+  {
+    auto it = m_PersistentCache.bufferDescs.find(id);
+    if(it != m_PersistentCache.bufferDescs.end())
+      return it->second;
+  }
+
   m_ToReplaySerialiser->Serialise("", id);
 
   if(m_RemoteServer)
@@ -2370,6 +2934,12 @@ BufferDescription ReplayProxy::GetBuffer(ResourceId id)
 
   m_FromReplaySerialiser->Serialise("", ret);
 
+  if(!m_RemoteServer && m_PersistentCache.valid)
+  {
+    m_PersistentCache.bufferDescs[id] = ret;
+    m_PersistentCache.dirty = true;
+  }
+
   return ret;
 }
 
@@ -2411,12 +2981,42 @@ void ReplayProxy::ReplayLog(uint32_t endEventID, ReplayLogType replayType)
   }
   else
   {
-    if(!SendReplayCommand(eReplayProxy_ReplayLog))
+    if(!SendReplayCommandAsync(eReplayProxy_ReplayLog))
       return;
 
     m_TextureProxyCache.clear();
     m_BufferProxyCache.clear();
+    m_StreamedTextureCache.clear();
+  }
+}
+
+bool ReplayProxy::AdvanceReplay(uint32_t fromEventID, uint32_t toEventID)
+{
+  bool ret = false;
+
+  m_ToReplaySerialiser->Serialise("", fromEventID);
+  m_ToReplaySerialiser->Serialise("", toEventID);
+
+  if(m_RemoteServer)
+  {
+    ret = m_Remote->AdvanceReplay(fromEventID, toEventID);
+  }
+  else
+  {
+    if(!SendReplayCommand(eReplayProxy_AdvanceReplay))
+      return ret;
+  }
+
+  m_FromReplaySerialiser->Serialise("", ret);
+
+  if(!m_RemoteServer && ret)
+  {
+    m_TextureProxyCache.clear();
+    m_BufferProxyCache.clear();
+    m_StreamedTextureCache.clear();
   }
+
+  return ret;
 }
 
 vector<uint32_t> ReplayProxy::GetPassEvents(uint32_t eventID)
@@ -2465,6 +3065,9 @@ FrameRecord ReplayProxy::GetFrameRecord()
 {
   FrameRecord ret;
 
+  if(!m_RemoteServer && m_PersistentCache.valid && m_PersistentCache.hasFrameRecord)
+    return m_PersistentCache.frameRecord;
+
   if(m_RemoteServer)
   {
     ret = m_Remote->GetFrameRecord();
@@ -2477,6 +3080,13 @@ FrameRecord ReplayProxy::GetFrameRecord()
 
   m_FromReplaySerialiser->Serialise("", ret);
 
+  if(!m_RemoteServer && m_PersistentCache.valid)
+  {
+    m_PersistentCache.frameRecord = ret;
+    m_PersistentCache.hasFrameRecord = true;
+    m_PersistentCache.dirty = true;
+  }
+
   return ret;
 }
 
@@ -2561,6 +3171,29 @@ vector<CounterResult> ReplayProxy::FetchCounters(const vector<GPUCounter> &count
   return ret;
 }
 
+vector<TextureSamplingFeedback> ReplayProxy::FetchTextureSampling(uint32_t startEventID,
+                                                                  uint32_t endEventID)
+{
+  vector<TextureSamplingFeedback> ret;
+
+  m_ToReplaySerialiser->Serialise("", startEventID);
+  m_ToReplaySerialiser->Serialise("", endEventID);
+
+  if(m_RemoteServer)
+  {
+    ret = m_Remote->FetchTextureSampling(startEventID, endEventID);
+  }
+  else
+  {
+    if(!SendReplayCommand(eReplayProxy_FetchTextureSampling))
+      return ret;
+  }
+
+  m_FromReplaySerialiser->Serialise("", ret);
+
+  return ret;
+}
+
 vector<GPUCounter> ReplayProxy::EnumerateCounters()
 {
   vector<GPUCounter> ret;
@@ -2663,23 +3296,23 @@ byte *ReplayProxy::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mi
   m_ToReplaySerialiser->Serialise("", params.remap);
   m_ToReplaySerialiser->Serialise("", params.blackPoint);
   m_ToReplaySerialiser->Serialise("", params.whitePoint);
+  m_ToReplaySerialiser->Serialise("", params.regionX);
+  m_ToReplaySerialiser->Serialise("", params.regionY);
+  m_ToReplaySerialiser->Serialise("", params.regionWidth);
+  m_ToReplaySerialiser->Serialise("", params.regionHeight);
 
   if(m_RemoteServer)
   {
     byte *data = m_Remote->GetTextureData(tex, arrayIdx, mip, params, dataSize);
 
-    byte *compressed = new byte[LZ4_COMPRESSBOUND(dataSize)];
-
-    uint32_t uncompressedSize = (uint32_t)dataSize;
-    uint32_t compressedSize =
-        (uint32_t)LZ4_compress((const char *)data, (char *)compressed, (int)uncompressedSize);
+    // the whole reply is compressed when it's sent, if the client accepts it
+    uint32_t size = data ? (uint32_t)dataSize : 0;
 
-    m_FromReplaySerialiser->Serialise("", uncompressedSize);
-    m_FromReplaySerialiser->Serialise("", compressedSize);
-    m_FromReplaySerialiser->RawWriteBytes(compressed, (size_t)compressedSize);
+    m_FromReplaySerialiser->Serialise("", size);
+    if(size > 0)
+      m_FromReplaySerialiser->RawWriteBytes(data, (size_t)size);
 
     delete[] data;
-    delete[] compressed;
   }
   else
   {
@@ -2689,25 +3322,21 @@ byte *ReplayProxy::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mi
       return NULL;
     }
 
-    uint32_t uncompressedSize = 0;
-    uint32_t compressedSize = 0;
+    uint32_t size = 0;
 
-    m_FromReplaySerialiser->Serialise("", uncompressedSize);
-    m_FromReplaySerialiser->Serialise("", compressedSize);
+    m_FromReplaySerialiser->Serialise("", size);
 
-    if(uncompressedSize == 0 || compressedSize == 0)
+    if(size == 0)
     {
       dataSize = 0;
       return NULL;
     }
 
-    dataSize = (size_t)uncompressedSize;
+    dataSize = (size_t)size;
 
     byte *ret = new byte[dataSize + 512];
 
-    byte *compressed = (byte *)m_FromReplaySerialiser->RawReadBytes((size_t)compressedSize);
-
-    LZ4_decompress_fast((const char *)compressed, (char *)ret, (int)dataSize);
+    memcpy(ret, m_FromReplaySerialiser->RawReadBytes(dataSize), dataSize);
 
     return ret;
   }
@@ -2715,6 +3344,463 @@ byte *ReplayProxy::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mi
   return NULL;
 }
 
+// the granularity that texture data is compared at when sending deltas
+static const size_t TextureDeltaBlockSize = 4 * 1024;
+
+void ReplayProxy::GetTextureDataDelta(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
+                                      const GetTextureDataParams &_params, TextureDataCopy &copy)
+{
+  GetTextureDataParams params = _params;    // Serialiser is non-const
+
+  m_ToReplaySerialiser->Serialise("", tex);
+  m_ToReplaySerialiser->Serialise("", arrayIdx);
+  m_ToReplaySerialiser->Serialise("", mip);
+  m_ToReplaySerialiser->Serialise("", params.forDiskSave);
+  m_ToReplaySerialiser->Serialise("", params.typeHint);
+  m_ToReplaySerialiser->Serialise("", params.resolve);
+  m_ToReplaySerialiser->Serialise("", params.remap);
+  m_ToReplaySerialiser->Serialise("", params.blackPoint);
+  m_ToReplaySerialiser->Serialise("", params.whitePoint);
+  m_ToReplaySerialiser->Serialise("", copy.generation);
+
+  if(m_RemoteServer)
+  {
+    TextureCacheEntry entry = {tex, arrayIdx, mip};
+    TextureDataCopy &last = m_TextureDataCopies[entry];
+
+    size_t dataSize = 0;
+    byte *data = m_Remote->GetTextureData(tex, arrayIdx, mip, params, dataSize);
+
+    uint32_t size = data ? (uint32_t)dataSize : 0;
+
+    // ranges of blocks that differ from what the client already has, as offset/length pairs
+    vector<uint32_t> ranges;
+    bool delta = false;
+
+    if(size > 0 && copy.generation != 0 && copy.generation == last.generation &&
+       last.data.size() == dataSize)
+    {
+      uint32_t changedBytes = 0;
+
+      for(size_t offs = 0; offs < dataSize; offs += TextureDeltaBlockSize)
+      {
+        size_t len = RDCMIN(TextureDeltaBlockSize, dataSize - offs);
+
+        if(memcmp(data + offs, &last.data[offs], len) == 0)
+          continue;
+
+        // extend the previous range if it ends where this block starts
+        if(!ranges.empty() && ranges[ranges.size() - 2] + ranges.back() == (uint32_t)offs)
+        {
+          ranges.back() += (uint32_t)len;
+        }
+        else
+        {
+          ranges.push_back((uint32_t)offs);
+          ranges.push_back((uint32_t)len);
+        }
+
+        changedBytes += (uint32_t)len;
+      }
+
+      // if most of the data changed it's simpler to send all of it
+      delta = changedBytes <= size / 2;
+    }
+
+    if(size > 0)
+    {
+      last.data.assign(data, data + dataSize);
+      last.generation = ++m_TextureDataGeneration;
+    }
+    else
+    {
+      m_TextureDataCopies.erase(entry);
+    }
+
+    uint32_t generation = size > 0 ? m_TextureDataGeneration : 0;
+    uint32_t numRanges = delta ? uint32_t(ranges.size() / 2) : 0;
+
+    m_FromReplaySerialiser->Serialise("", generation);
+    m_FromReplaySerialiser->Serialise("", size);
+    m_FromReplaySerialiser->Serialise("", delta);
+
+    if(delta)
+    {
+      m_FromReplaySerialiser->Serialise("", numRanges);
+
+      for(uint32_t i = 0; i < numRanges; i++)
+      {
+        uint32_t offs = ranges[i * 2 + 0];
+        uint32_t len = ranges[i * 2 + 1];
+
+        m_FromReplaySerialiser->Serialise("", offs);
+        m_FromReplaySerialiser->Serialise("", len);
+        m_FromReplaySerialiser->RawWriteBytes(data + offs, (size_t)len);
+      }
+    }
+    else if(size > 0)
+    {
+      m_FromReplaySerialiser->RawWriteBytes(data, (size_t)size);
+    }
+
+    delete[] data;
+  }
+  else
+  {
+    if(!SendReplayCommand(eReplayProxy_GetTextureDataDelta))
+    {
+      copy = TextureDataCopy();
+      return;
+    }
+
+    uint32_t generation = 0;
+    uint32_t size = 0;
+    bool delta = false;
+
+    m_FromReplaySerialiser->Serialise("", generation);
+    m_FromReplaySerialiser->Serialise("", size);
+    m_FromReplaySerialiser->Serialise("", delta);
+
+    if(delta)
+    {
+      if(copy.data.size() != (size_t)size)
+      {
+        RDCERR("Received texture delta of size %u for data of size %llu", size,
+               (uint64_t)copy.data.size());
+        copy = TextureDataCopy();
+        return;
+      }
+
+      uint32_t numRanges = 0;
+      m_FromReplaySerialiser->Serialise("", numRanges);
+
+      for(uint32_t i = 0; i < numRanges; i++)
+      {
+        uint32_t offs = 0, len = 0;
+
+        m_FromReplaySerialiser->Serialise("", offs);
+        m_FromReplaySerialiser->Serialise("", len);
+
+        byte *src = (byte *)m_FromReplaySerialiser->RawReadBytes((size_t)len);
+
+        if((uint64_t)offs + len <= (uint64_t)size)
+          memcpy(&copy.data[offs], src, len);
+      }
+    }
+    else if(size > 0)
+    {
+      byte *src = (byte *)m_FromReplaySerialiser->RawReadBytes((size_t)size);
+      copy.data.assign(src, src + size);
+    }
+    else
+    {
+      copy.data.clear();
+    }
+
+    copy.generation = generation;
+  }
+}
+
+// JPEG quality used for streamed texture display, from remote.textureStreamQuality
+static int GetTextureStreamQuality()
+{
+  int quality = atoi(RenderDoc::Inst().GetConfigSetting("remote.textureStreamQuality").c_str());
+  if(quality <= 0 || quality > 100)
+    quality = 90;
+  return quality;
+}
+
+void ReplayProxy::GetStreamedTexture(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
+                                     const GetTextureDataParams &_params, uint32_t &width,
+                                     uint32_t &height, vector<byte> &rgba)
+{
+  GetTextureDataParams params = _params;    // Serialiser is non-const
+
+  m_ToReplaySerialiser->Serialise("", tex);
+  m_ToReplaySerialiser->Serialise("", arrayIdx);
+  m_ToReplaySerialiser->Serialise("", mip);
+  m_ToReplaySerialiser->Serialise("", params.typeHint);
+  m_ToReplaySerialiser->Serialise("", params.blackPoint);
+  m_ToReplaySerialiser->Serialise("", params.whitePoint);
+
+  if(m_RemoteServer)
+  {
+    // the remote converts the subresource to displayable 8-bit colour with the right range, which is
+    // then small enough to compress lossily for display
+    params.remap = eRemap_RGBA8;
+
+    TextureDescription desc = m_Remote->GetTexture(tex);
+
+    width = RDCMAX(1U, desc.width >> mip);
+    height = RDCMAX(1U, desc.height >> mip);
+
+    size_t dataSize = 0;
+    byte *data = m_Remote->GetTextureData(tex, arrayIdx, mip, params, dataSize);
+
+    vector<byte> colour, alpha;
+
+    if(data && dataSize == size_t(width) * height * 4)
+    {
+      jpge::params p;
+      p.m_quality = GetTextureStreamQuality();
+
+      int len = RDCMAX((int)dataSize, 1024);
+      colour.resize(len);
+
+      // alpha is ignored when compressing 4 components
+      if(jpge::compress_image_to_jpeg_file_in_memory(&colour[0], len, (int)width, (int)height, 4,
+                                                     data, p))
+        colour.resize(len);
+      else
+        colour.clear();
+
+      // alpha is compressed separately as greyscale, only if it's used
+      bool opaque = true;
+      for(size_t i = 3; i < dataSize; i += 4)
+      {
+        if(data[i] != 255)
+        {
+          opaque = false;
+          break;
+        }
+      }
+
+      if(!colour.empty() && !opaque)
+      {
+        vector<byte> alphaPlane(size_t(width) * height);
+        for(size_t i = 0; i < alphaPlane.size(); i++)
+          alphaPlane[i] = data[i * 4 + 3];
+
+        p.m_subsampling = jpge::Y_ONLY;
+
+        len = RDCMAX((int)alphaPlane.size(), 1024);
+        alpha.resize(len);
+
+        if(jpge::compress_image_to_jpeg_file_in_memory(&alpha[0], len, (int)width, (int)height, 1,
+                                                       &alphaPlane[0], p))
+          alpha.resize(len);
+        else
+          colour.clear();
+      }
+    }
+
+    delete[] data;
+
+    if(colour.empty())
+    {
+      width = height = 0;
+      alpha.clear();
+    }
+
+    m_FromReplaySerialiser->Serialise("", width);
+    m_FromReplaySerialiser->Serialise("", height);
+
+    uint32_t colourSize = (uint32_t)colour.size();
+    uint32_t alphaSize = (uint32_t)alpha.size();
+
+    m_FromReplaySerialiser->Serialise("", colourSize);
+    if(colourSize > 0)
+      m_FromReplaySerialiser->RawWriteBytes(&colour[0], colourSize);
+
+    m_FromReplaySerialiser->Serialise("", alphaSize);
+    if(alphaSize > 0)
+      m_FromReplaySerialiser->RawWriteBytes(&alpha[0], alphaSize);
+  }
+  else
+  {
+    width = height = 0;
+    rgba.clear();
+
+    if(!SendReplayCommand(eReplayProxy_GetStreamedTexture))
+      return;
+
+    uint32_t colourSize = 0, alphaSize = 0;
+
+    m_FromReplaySerialiser->Serialise("", width);
+    m_FromReplaySerialiser->Serialise("", height);
+
+    m_FromReplaySerialiser->Serialise("", colourSize);
+    const byte *colour = colourSize > 0
+                             ? (const byte *)m_FromReplaySerialiser->RawReadBytes(colourSize)
+                             : NULL;
+
+    // the data is only valid until the next read, so decompress the colour first
+    int w = 0, h = 0, comps = 0;
+    byte *pixels =
+        colour ? jpgd::decompress_jpeg_image_from_memory(colour, (int)colourSize, &w, &h, &comps, 4)
+               : NULL;
+
+    if(pixels == NULL || (uint32_t)w != width || (uint32_t)h != height)
+    {
+      free(pixels);
+      width = height = 0;
+      return;
+    }
+
+    rgba.assign(pixels, pixels + size_t(width) * height * 4);
+    free(pixels);
+
+    m_FromReplaySerialiser->Serialise("", alphaSize);
+
+    if(alphaSize > 0)
+    {
+      const byte *alpha = (const byte *)m_FromReplaySerialiser->RawReadBytes(alphaSize);
+
+      pixels = jpgd::decompress_jpeg_image_from_memory(alpha, (int)alphaSize, &w, &h, &comps, 1);
+
+      if(pixels && (uint32_t)w == width && (uint32_t)h == height)
+      {
+        for(size_t i = 0; i < size_t(width) * height; i++)
+          rgba[i * 4 + 3] = pixels[i];
+      }
+
+      free(pixels);
+    }
+  }
+}
+
+vector<TextureThumbnail> ReplayProxy::GetTextureThumbnails(
+    const vector<TextureThumbnailRequest> &textures, uint32_t size)
+{
+  vector<TextureThumbnailRequest> reqs = textures;    // Serialiser is non-const
+
+  uint32_t count = (uint32_t)reqs.size();
+
+  m_ToReplaySerialiser->Serialise("", count);
+  m_ToReplaySerialiser->Serialise("", size);
+
+  reqs.resize(count);
+
+  for(uint32_t i = 0; i < count; i++)
+  {
+    m_ToReplaySerialiser->Serialise("", reqs[i].texid);
+    m_ToReplaySerialiser->Serialise("", reqs[i].typeHint);
+  }
+
+  vector<TextureThumbnail> ret;
+
+  if(m_RemoteServer)
+  {
+    // the thumbnails are made on the remote, so only their few pixels come over the network rather
+    // than each texture's full data
+    ret = m_Remote->GetTextureThumbnails(reqs, size);
+  }
+  else
+  {
+    if(!SendReplayCommand(eReplayProxy_GetTextureThumbnails))
+      return vector<TextureThumbnail>(textures.size());
+  }
+
+  ret.resize(count);
+
+  for(uint32_t i = 0; i < count; i++)
+  {
+    TextureThumbnail &thumb = ret[i];
+
+    m_FromReplaySerialiser->Serialise("", thumb.width);
+    m_FromReplaySerialiser->Serialise("", thumb.height);
+
+    uint32_t byteSize = (uint32_t)thumb.rgba.size();
+    m_FromReplaySerialiser->Serialise("", byteSize);
+
+    if(m_RemoteServer)
+    {
+      if(byteSize > 0)
+        m_FromReplaySerialiser->RawWriteBytes(&thumb.rgba[0], byteSize);
+    }
+    else
+    {
+      if(byteSize == size_t(thumb.width) * thumb.height * 4)
+      {
+        const byte *data = (const byte *)m_FromReplaySerialiser->RawReadBytes(byteSize);
+        thumb.rgba.assign(data, data + byteSize);
+      }
+      else
+      {
+        if(byteSize > 0)
+          m_FromReplaySerialiser->RawReadBytes(byteSize);
+        thumb = TextureThumbnail();
+      }
+    }
+  }
+
+  return ret;
+}
+
+bool ReplayProxy::EnsureTexStreamed(TextureDisplay &cfg)
+{
+  if(!m_Socket->Connected())
+    return false;
+
+  // raw output and custom shaders need the real data, and locally created textures have it
+  if(cfg.texid == ResourceId() || cfg.rawoutput || cfg.CustomShader != ResourceId() ||
+     m_LocalTextures.find(cfg.texid) != m_LocalTextures.end())
+    return false;
+
+  auto proxy = m_StreamedProxies.find(cfg.texid);
+  if(proxy == m_StreamedProxies.end())
+  {
+    TextureDescription tex = GetTexture(cfg.texid);
+
+    StreamedTextureProxy streamed;
+    streamed.mips = tex.mips;
+
+    // only single 2D images can be streamed as a picture
+    if(tex.msSamp <= 1 && tex.depth <= 1)
+    {
+      tex.format = ResourceFormat();
+      tex.format.special = false;
+      tex.format.compCount = 4;
+      tex.format.compByteWidth = 1;
+      tex.format.compType = CompType::UNorm;
+      tex.creationFlags = TextureCategory::ShaderRead;
+
+      streamed.id = m_Proxy->CreateProxyTexture(tex);
+    }
+
+    proxy = m_StreamedProxies.insert(std::make_pair(cfg.texid, streamed)).first;
+  }
+
+  if(proxy->second.id == ResourceId() || cfg.mip >= proxy->second.mips)
+    return false;
+
+  TextureCacheEntry entry = {cfg.texid, cfg.sliceFace, cfg.mip};
+
+  StreamedTextureState state;
+  state.rangemin = cfg.rangemin;
+  state.rangemax = cfg.rangemax;
+  state.typeHint = cfg.typeHint;
+
+  auto it = m_StreamedTextureCache.find(entry);
+  if(it == m_StreamedTextureCache.end() || !(it->second == state))
+  {
+    GetTextureDataParams params;
+    params.typeHint = cfg.typeHint;
+    params.blackPoint = cfg.rangemin;
+    params.whitePoint = cfg.rangemax;
+
+    uint32_t width = 0, height = 0;
+    vector<byte> rgba;
+    GetStreamedTexture(cfg.texid, cfg.sliceFace, cfg.mip, params, width, height, rgba);
+
+    if(rgba.empty())
+      return false;
+
+    m_Proxy->SetProxyTextureData(proxy->second.id, cfg.sliceFace, cfg.mip, &rgba[0], rgba.size());
+
+    m_StreamedTextureCache[entry] = state;
+  }
+
+  // the range has already been applied on the remote side
+  cfg.texid = proxy->second.id;
+  cfg.typeHint = CompType::Typeless;
+  cfg.rangemin = 0.0f;
+  cfg.rangemax = 1.0f;
+  cfg.HDRMul = -1.0f;
+
+  return true;
+}
+
 void ReplayProxy::InitPostVSBuffers(uint32_t eventID)
 {
   m_ToReplaySerialiser->Serialise("", eventID);
@@ -2725,7 +3811,7 @@ void ReplayProxy::InitPostVSBuffers(uint32_t eventID)
   }
   else
   {
-    if(!SendReplayCommand(eReplayProxy_InitPostVS))
+    if(!SendReplayCommandAsync(eReplayProxy_InitPostVS))
       return;
   }
 }
@@ -2740,7 +3826,7 @@ void ReplayProxy::InitPostVSBuffers(const vector<uint32_t> &events)
   }
   else
   {
-    if(!SendReplayCommand(eReplayProxy_InitPostVSVec))
+    if(!SendReplayCommandAsync(eReplayProxy_InitPostVSVec))
       return;
   }
 }
@@ -2816,6 +3902,15 @@ ShaderReflection *ReplayProxy::GetShader(ResourceId id, string entryPoint)
 
   ShaderReflKey key(id, entryPoint);
 
+  bool persistent = m_PersistentCache.valid && m_SessionShaders.find(id) == m_SessionShaders.end();
+
+  if(m_ShaderReflectionCache.find(key) == m_ShaderReflectionCache.end() && persistent)
+  {
+    auto it = m_PersistentCache.shaders.find(key);
+    if(it != m_PersistentCache.shaders.end())
+      m_ShaderReflectionCache[key] = new ShaderReflection(it->second);
+  }
+
   if(m_ShaderReflectionCache.find(key) == m_ShaderReflectionCache.end())
   {
     m_ToReplaySerialiser->Serialise("", id);
@@ -2832,6 +3927,12 @@ ShaderReflection *ReplayProxy::GetShader(ResourceId id, string entryPoint)
       m_ShaderReflectionCache[key] = new ShaderReflection();
 
       m_FromReplaySerialiser->Serialise("", *m_ShaderReflectionCache[key]);
+
+      if(persistent)
+      {
+        m_PersistentCache.shaders[key] = *m_ShaderReflectionCache[key];
+        m_PersistentCache.dirty = true;
+      }
     }
     else
     {
@@ -2852,7 +3953,7 @@ void ReplayProxy::FreeTargetResource(ResourceId id)
   }
   else
   {
-    if(!SendReplayCommand(eReplayProxy_FreeResource))
+    if(!SendReplayCommandAsync(eReplayProxy_FreeResource))
       return;
   }
 }
@@ -2954,6 +4055,8 @@ void ReplayProxy::BuildTargetShader(string source, string entry, const uint32_t
       *id = outId;
     if(errors)
       *errors = outErrs;
+
+    m_SessionShaders.insert(outId);
   }
 }
 
@@ -2968,7 +4071,7 @@ void ReplayProxy::ReplaceResource(ResourceId from, ResourceId to)
   }
   else
   {
-    if(!SendReplayCommand(eReplayProxy_ReplaceResource))
+    if(!SendReplayCommandAsync(eReplayProxy_ReplaceResource))
       return;
   }
 }
@@ -2983,7 +4086,7 @@ void ReplayProxy::RemoveReplacement(ResourceId id)
   }
   else
   {
-    if(!SendReplayCommand(eReplayProxy_RemoveReplacement))
+    if(!SendReplayCommandAsync(eReplayProxy_RemoveReplacement))
       return;
   }
 }
@@ -3019,6 +4122,44 @@ vector<PixelModification> ReplayProxy::PixelHistory(vector<EventUsage> events, R
   return ret;
 }
 
+vector<vector<PixelModification> > ReplayProxy::PixelHistoryRegion(
+    vector<EventUsage> events, ResourceId target, uint32_t x, uint32_t y, uint32_t width,
+    uint32_t height, uint32_t slice, uint32_t mip, uint32_t sampleIdx, CompType typeHint)
+{
+  vector<vector<PixelModification> > ret;
+
+  m_ToReplaySerialiser->Serialise("", events);
+  m_ToReplaySerialiser->Serialise("", target);
+  m_ToReplaySerialiser->Serialise("", x);
+  m_ToReplaySerialiser->Serialise("", y);
+  m_ToReplaySerialiser->Serialise("", width);
+  m_ToReplaySerialiser->Serialise("", height);
+  m_ToReplaySerialiser->Serialise("", slice);
+  m_ToReplaySerialiser->Serialise("", mip);
+  m_ToReplaySerialiser->Serialise("", sampleIdx);
+  m_ToReplaySerialiser->Serialise("", typeHint);
+
+  if(m_RemoteServer)
+  {
+    ret = m_Remote->PixelHistoryRegion(events, target, x, y, width, height, slice, mip, sampleIdx,
+                                       typeHint);
+  }
+  else
+  {
+    if(!SendReplayCommand(eReplayProxy_PixelHistoryRegion))
+      return ret;
+  }
+
+  uint32_t count = (uint32_t)ret.size();
+  m_FromReplaySerialiser->Serialise("", count);
+
+  ret.resize(count);
+  for(uint32_t i = 0; i < count; i++)
+    m_FromReplaySerialiser->Serialise("", ret[i]);
+
+  return ret;
+}
+
 ShaderDebugTrace ReplayProxy::DebugVertex(uint32_t eventID, uint32_t vertid, uint32_t instid,
                                           uint32_t idx, uint32_t instOffset, uint32_t vertOffset)
 {
@@ -3072,6 +4213,55 @@ ShaderDebugTrace ReplayProxy::DebugPixel(uint32_t eventID, uint32_t x, uint32_t
   return ret;
 }
 
+vector<ShaderDebugTrace> ReplayProxy::DebugVertices(uint32_t eventID,
+                                                    vector<ShaderDebugVertexInput> inputs,
+                                                    uint32_t instOffset, uint32_t vertOffset)
+{
+  vector<ShaderDebugTrace> ret;
+
+  m_ToReplaySerialiser->Serialise("", eventID);
+  m_ToReplaySerialiser->Serialise("", inputs);
+  m_ToReplaySerialiser->Serialise("", instOffset);
+  m_ToReplaySerialiser->Serialise("", vertOffset);
+
+  if(m_RemoteServer)
+  {
+    ret = m_Remote->DebugVertices(eventID, inputs, instOffset, vertOffset);
+  }
+  else
+  {
+    if(!SendReplayCommand(eReplayProxy_DebugVertices))
+      return ret;
+  }
+
+  m_FromReplaySerialiser->Serialise("", ret);
+
+  return ret;
+}
+
+vector<ShaderDebugTrace> ReplayProxy::DebugPixels(uint32_t eventID,
+                                                  vector<ShaderDebugPixelInput> inputs)
+{
+  vector<ShaderDebugTrace> ret;
+
+  m_ToReplaySerialiser->Serialise("", eventID);
+  m_ToReplaySerialiser->Serialise("", inputs);
+
+  if(m_RemoteServer)
+  {
+    ret = m_Remote->DebugPixels(eventID, inputs);
+  }
+  else
+  {
+    if(!SendReplayCommand(eReplayProxy_DebugPixels))
+      return ret;
+  }
+
+  m_FromReplaySerialiser->Serialise("", ret);
+
+  return ret;
+}
+
 ShaderDebugTrace ReplayProxy::DebugThread(uint32_t eventID, const uint32_t groupid[3],
                                           const uint32_t threadid[3])
 {
@@ -25,6 +25,7 @@
 
 #pragma once
 
+#include "core/resource_id_map.h"
 #include "os/os_specific.h"
 #include "replay/replay_driver.h"
 #include "serialise/serialiser.h"
@@ -85,6 +86,20 @@ enum ReplayProxyPacket
   eReplayProxy_GetAPIProperties,
 
   eReplayProxy_PixelHistory,
+  eReplayProxy_PixelHistoryRegion,
+
+  eReplayProxy_DebugVertices,
+  eReplayProxy_DebugPixels,
+
+  eReplayProxy_GetMemoryUsage,
+
+  eReplayProxy_GetTextureDataDelta,
+  eReplayProxy_GetStreamedTexture,
+  eReplayProxy_GetTextureThumbnails,
+
+  eReplayProxy_FetchTextureSampling,
+
+  eReplayProxy_AdvanceReplay,
 };
 
 // This class implements IReplayDriver and StackResolver. On the local machine where the UI
@@ -97,27 +112,48 @@ class ReplayProxy : public IReplayDriver, Callstack::StackResolver
 {
 public:
   ReplayProxy(Network::Socket *sock, IReplayDriver *proxy)
-      : m_Socket(sock), m_Proxy(proxy), m_Remote(NULL), m_RemoteServer(false)
+      : m_Socket(sock),
+        m_Proxy(proxy),
+        m_Remote(NULL),
+        m_RemoteServer(false),
+        m_PacketCodecs(ePacketCodec_None)
   {
     m_FromReplaySerialiser = NULL;
     m_ToReplaySerialiser = new Serialiser(NULL, Serialiser::WRITING, false);
     m_RemoteHasResolver = false;
+    m_TextureDataGeneration = 0;
+    m_NextRequestID = 0;
+    m_StreamTextureDisplay =
+        RenderDoc::Inst().GetConfigSetting("remote.streamTextureDisplay") == "1";
 
     GetAPIProperties();
   }
 
-  ReplayProxy(Network::Socket *sock, IRemoteDriver *remote)
-      : m_Socket(sock), m_Proxy(NULL), m_Remote(remote), m_RemoteServer(true)
+  // packetCodecs is the mask of PacketCodec that the client accepted in the handshake, which
+  // replies are compressed with
+  ReplayProxy(Network::Socket *sock, IRemoteDriver *remote, uint32_t packetCodecs)
+      : m_Socket(sock),
+        m_Proxy(NULL),
+        m_Remote(remote),
+        m_RemoteServer(true),
+        m_PacketCodecs(packetCodecs)
   {
     m_ToReplaySerialiser = NULL;
     m_FromReplaySerialiser = new Serialiser(NULL, Serialiser::WRITING, false);
     m_RemoteHasResolver = false;
+    m_TextureDataGeneration = 0;
+    m_NextRequestID = 0;
+    m_StreamTextureDisplay = false;
 
     RDCEraseEl(m_APIProps);
   }
 
   virtual ~ReplayProxy();
 
+  // on the client, loads what was saved from previous sessions with the same capture, identified by
+  // captureHash, and saves what's fetched this session when the proxy is destroyed.
+  void LoadPersistentCache(uint32_t captureHash);
+
   bool IsRemoteProxy() { return !m_RemoteServer; }
   void Shutdown() { delete this; }
   void ReadLogInitialisation() {}
@@ -223,10 +259,15 @@ public:
   {
     if(m_Proxy)
     {
-      EnsureTexCached(cfg.texid, cfg.sliceFace, cfg.mip);
-      if(cfg.texid == ResourceId() || m_ProxyTextures[cfg.texid] == ResourceId())
-        return false;
-      cfg.texid = m_ProxyTextures[cfg.texid];
+      // when streaming, only a compressed picture of the texture comes over the network to display.
+      // Picking and anything else that needs the real data still fetches it below.
+      if(!m_StreamTextureDisplay || !EnsureTexStreamed(cfg))
+      {
+        EnsureTexCached(cfg.texid, cfg.sliceFace, cfg.mip);
+        if(cfg.texid == ResourceId() || m_ProxyTextures[cfg.texid] == ResourceId())
+          return false;
+        cfg.texid = m_ProxyTextures[cfg.texid];
+      }
 
       // due to OpenGL having origin bottom-left compared to the rest of the world,
       // we need to flip going in or out of GL.
@@ -395,6 +436,7 @@ public:
   APIProperties GetAPIProperties();
 
   vector<DebugMessage> GetDebugMessages();
+  vector<MemoryUsage> GetMemoryUsage();
 
   void SavePipelineState();
   D3D11Pipe::State GetD3D11PipelineState() { return m_D3D11PipelineState; }
@@ -402,6 +444,9 @@ public:
   GLPipe::State GetGLPipelineState() { return m_GLPipelineState; }
   VKPipe::State GetVulkanPipelineState() { return m_VulkanPipelineState; }
   void ReplayLog(uint32_t endEventID, ReplayLogType replayType);
+  bool AdvanceReplay(uint32_t fromEventID, uint32_t toEventID);
+  // remote replays always run every event
+  void SetPrunedEvents(const vector<uint32_t> &eventIDs) {}
 
   vector<uint32_t> GetPassEvents(uint32_t eventID);
 
@@ -415,6 +460,7 @@ public:
   vector<GPUCounter> EnumerateCounters();
   void DescribeCounter(GPUCounter counterID, CounterDescription &desc);
   vector<CounterResult> FetchCounters(const vector<GPUCounter> &counterID);
+  vector<TextureSamplingFeedback> FetchTextureSampling(uint32_t startEventID, uint32_t endEventID);
 
   void FillCBufferVariables(ResourceId shader, string entryPoint, uint32_t cbufSlot,
                             vector<ShaderVariable> &outvars, const vector<byte> &data);
@@ -422,6 +468,8 @@ public:
   void GetBufferData(ResourceId buff, uint64_t offset, uint64_t len, vector<byte> &retData);
   byte *GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
                        const GetTextureDataParams &params, size_t &dataSize);
+  vector<TextureThumbnail> GetTextureThumbnails(const vector<TextureThumbnailRequest> &textures,
+                                                uint32_t size);
 
   void InitPostVSBuffers(uint32_t eventID);
   void InitPostVSBuffers(const vector<uint32_t> &passEvents);
@@ -443,10 +491,18 @@ public:
   vector<PixelModification> PixelHistory(vector<EventUsage> events, ResourceId target, uint32_t x,
                                          uint32_t y, uint32_t slice, uint32_t mip,
                                          uint32_t sampleIdx, CompType typeHint);
+  vector<vector<PixelModification> > PixelHistoryRegion(vector<EventUsage> events,
+                                                        ResourceId target, uint32_t x, uint32_t y,
+                                                        uint32_t width, uint32_t height,
+                                                        uint32_t slice, uint32_t mip,
+                                                        uint32_t sampleIdx, CompType typeHint);
   ShaderDebugTrace DebugVertex(uint32_t eventID, uint32_t vertid, uint32_t instid, uint32_t idx,
                                uint32_t instOffset, uint32_t vertOffset);
   ShaderDebugTrace DebugPixel(uint32_t eventID, uint32_t x, uint32_t y, uint32_t sample,
                               uint32_t primitive);
+  vector<ShaderDebugTrace> DebugVertices(uint32_t eventID, vector<ShaderDebugVertexInput> inputs,
+                                         uint32_t instOffset, uint32_t vertOffset);
+  vector<ShaderDebugTrace> DebugPixels(uint32_t eventID, vector<ShaderDebugPixelInput> inputs);
   ShaderDebugTrace DebugThread(uint32_t eventID, const uint32_t groupid[3],
                                const uint32_t threadid[3]);
 
@@ -456,9 +512,18 @@ public:
   void RemoveReplacement(ResourceId id);
 
   void FileChanged() {}
-  // will never be used
+  // proxy textures are only created locally, to display data that's already here such as texture
+  // thumbnails. They're never seen by the remote.
   ResourceId CreateProxyTexture(const TextureDescription &templateTex)
   {
+    if(m_Proxy)
+    {
+      ResourceId id = m_Proxy->CreateProxyTexture(templateTex);
+      m_LocalTextures.insert(id);
+      m_ProxyTextures[id] = id;
+      return id;
+    }
+
     RDCERR("Calling proxy-render functions on a proxy serialiser");
     return ResourceId();
   }
@@ -466,6 +531,12 @@ public:
   void SetProxyTextureData(ResourceId texid, uint32_t arrayIdx, uint32_t mip, byte *data,
                            size_t dataSize)
   {
+    if(m_Proxy && m_LocalTextures.find(texid) != m_LocalTextures.end())
+    {
+      m_Proxy->SetProxyTextureData(texid, arrayIdx, mip, data, dataSize);
+      return;
+    }
+
     RDCERR("Calling proxy-render functions on a proxy serialiser");
   }
 
@@ -483,6 +554,13 @@ public:
 
 private:
   bool SendReplayCommand(ReplayProxyPacket type);
+  // sends a command that has no results without waiting for the round-trip. The remote doesn't
+  // reply to these, and processes them in order before the next command that does wait, so any
+  // number of them can be in flight together.
+  bool SendReplayCommandAsync(ReplayProxyPacket type);
+  // async commands other than ReplayLog are small and often come in runs (e.g. freeing a batch of
+  // resources), so they're queued up here and go out together with the next command sent.
+  bool FlushPendingCommands();
 
   void EnsureTexCached(ResourceId texid, uint32_t arrayIdx, uint32_t mip);
   void RemapProxyTextureIfNeeded(ResourceFormat &format, GetTextureDataParams &params);
@@ -506,6 +584,50 @@ private:
   set<TextureCacheEntry> m_TextureProxyCache;
   set<ResourceId> m_LocalTextures;
 
+  // a copy of a subresource's data as last sent over the network. The remote side keeps these so
+  // that it only needs to send the blocks that changed, and the local side patches its copy with
+  // them before uploading it to the proxy texture. The generation identifies which send the copy
+  // came from, so both sides can tell if they're in sync.
+  struct TextureDataCopy
+  {
+    TextureDataCopy() : generation(0) {}
+    uint32_t generation;
+    vector<byte> data;
+  };
+  map<TextureCacheEntry, TextureDataCopy> m_TextureDataCopies;
+  uint32_t m_TextureDataGeneration;
+
+  void GetTextureDataDelta(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
+                           const GetTextureDataParams &params, TextureDataCopy &copy);
+
+  // with remote.streamTextureDisplay enabled, textures are displayed from an 8-bit JPEG compressed
+  // picture rendered on the remote side, in a separate proxy texture. The picture is fetched again
+  // whenever the event or the display range changes.
+  struct StreamedTextureProxy
+  {
+    StreamedTextureProxy() : mips(0) {}
+    ResourceId id;
+    uint32_t mips;
+  };
+  struct StreamedTextureState
+  {
+    float rangemin, rangemax;
+    CompType typeHint;
+
+    bool operator==(const StreamedTextureState &o) const
+    {
+      return rangemin == o.rangemin && rangemax == o.rangemax && typeHint == o.typeHint;
+    }
+  };
+  bool m_StreamTextureDisplay;
+  map<ResourceId, StreamedTextureProxy> m_StreamedProxies;
+  map<TextureCacheEntry, StreamedTextureState> m_StreamedTextureCache;
+
+  bool EnsureTexStreamed(TextureDisplay &cfg);
+  void GetStreamedTexture(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
+                          const GetTextureDataParams &params, uint32_t &width, uint32_t &height,
+                          vector<byte> &rgba);
+
   struct ProxyTextureProperties
   {
     ResourceId id;
@@ -518,11 +640,14 @@ private:
     bool operator==(const ResourceId &other) const { return id == other; }
   };
   map<ResourceId, ProxyTextureProperties> m_ProxyTextures;
+  // the size of the data uploaded to each cached subresource, for memory usage reporting
+  map<TextureCacheEntry, size_t> m_ProxyTextureSizes;
 
   set<ResourceId> m_BufferProxyCache;
   map<ResourceId, ResourceId> m_ProxyBufferIds;
+  map<ResourceId, size_t> m_ProxyBufferSizes;
 
-  map<ResourceId, ResourceId> m_LiveIDs;
+  ResourceIdMap<ResourceId> m_LiveIDs;
 
   struct ShaderReflKey
   {
@@ -541,12 +666,43 @@ private:
 
   map<ShaderReflKey, ShaderReflection *> m_ShaderReflectionCache;
 
+  // data from the capture that can't change between sessions, saved on disk on the client so that
+  // reopening the same capture doesn't fetch it all again. A saved cache is only used if the
+  // remote's resource lists match it, since otherwise the same IDs may be different resources.
+  struct PersistentCache
+  {
+    PersistentCache() : valid(false), dirty(false), hasFrameRecord(false) {}
+    string filename;
+    bool valid, dirty;
+    vector<ResourceId> textures, buffers;
+    map<ResourceId, TextureDescription> textureDescs;
+    map<ResourceId, BufferDescription> bufferDescs;
+    bool hasFrameRecord;
+    FrameRecord frameRecord;
+    map<ShaderReflKey, ShaderReflection> shaders;
+  };
+  PersistentCache m_PersistentCache;
+
+  // shaders built this session, whose IDs may be reused for something else next time
+  set<ResourceId> m_SessionShaders;
+
+  bool SerialisePersistentCache(Serialiser &ser, PersistentCache &cache);
+  void SavePersistentCache();
+
   Network::Socket *m_Socket;
   Serialiser *m_FromReplaySerialiser;
   Serialiser *m_ToReplaySerialiser;
   IReplayDriver *m_Proxy;
   IRemoteDriver *m_Remote;
   bool m_RemoteServer;
+  uint32_t m_PacketCodecs;
+
+  // every command is numbered in the order it's sent, and the remote echoes the number at the start
+  // of each reply so we can check they're still in step.
+  uint32_t m_NextRequestID;
+
+  // fully formed packets from SendReplayCommandAsync that haven't been sent yet
+  vector<byte> m_PendingCommands;
 
   bool m_RemoteHasResolver;
 
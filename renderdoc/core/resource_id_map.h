@@ -0,0 +1,281 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <utility>
+#include <vector>
+#include "api/replay/renderdoc_replay.h"
+
+// A flat open-addressing hash map keyed on ResourceId, for the maps that are looked up on every
+// API call and replayed event. Elements live in one array with linear probing, so a lookup is
+// usually a single cache miss instead of walking a tree.
+//
+// It's a drop-in for the subset of std::map used on these maps, with two differences:
+// - iteration is in no particular order. Anything that depends on ID order (e.g. the order things
+//   are serialised) must keep using std::map or sort afterwards.
+// - inserting can move every element, invalidating iterators and references. Erasing doesn't move
+//   anything, so erasing while iterating works as with std::map.
+template <typename V>
+class ResourceIdMap
+{
+public:
+  typedef ResourceId key_type;
+  typedef V mapped_type;
+  typedef std::pair<ResourceId, V> value_type;
+
+  template <typename MapType, typename ValueType>
+  class iterator_base
+  {
+  public:
+    iterator_base() : m_Map(NULL), m_Idx(0) {}
+    iterator_base(MapType *m, size_t idx) : m_Map(m), m_Idx(idx) {}
+    // allow iterator -> const_iterator
+    template <typename M, typename T>
+    iterator_base(const iterator_base<M, T> &o) : m_Map(o.m_Map), m_Idx(o.m_Idx)
+    {
+    }
+
+    ValueType &operator*() const { return m_Map->m_Slots[m_Idx]; }
+    ValueType *operator->() const { return &m_Map->m_Slots[m_Idx]; }
+    iterator_base &operator++()
+    {
+      m_Idx = m_Map->NextFull(m_Idx + 1);
+      return *this;
+    }
+    iterator_base operator++(int)
+    {
+      iterator_base ret = *this;
+      ++*this;
+      return ret;
+    }
+
+    template <typename M, typename T>
+    bool operator==(const iterator_base<M, T> &o) const
+    {
+      return m_Idx == o.m_Idx;
+    }
+    template <typename M, typename T>
+    bool operator!=(const iterator_base<M, T> &o) const
+    {
+      return m_Idx != o.m_Idx;
+    }
+
+  private:
+    template <typename M, typename T>
+    friend class iterator_base;
+    friend class ResourceIdMap;
+
+    MapType *m_Map;
+    size_t m_Idx;
+  };
+
+  typedef iterator_base<ResourceIdMap, value_type> iterator;
+  typedef iterator_base<const ResourceIdMap, const value_type> const_iterator;
+
+  ResourceIdMap() : m_Size(0), m_Used(0) {}
+  size_t size() const { return m_Size; }
+  bool empty() const { return m_Size == 0; }
+  iterator begin() { return iterator(this, NextFull(0)); }
+  iterator end() { return iterator(this, m_Slots.size()); }
+  const_iterator begin() const { return const_iterator(this, NextFull(0)); }
+  const_iterator end() const { return const_iterator(this, m_Slots.size()); }
+  iterator find(ResourceId id) { return iterator(this, FindSlot(id)); }
+  const_iterator find(ResourceId id) const { return const_iterator(this, FindSlot(id)); }
+  size_t count(ResourceId id) const { return FindSlot(id) != m_Slots.size() ? 1 : 0; }
+  V &operator[](ResourceId id) { return m_Slots[InsertSlot(id)].second; }
+  std::pair<iterator, bool> insert(const value_type &val)
+  {
+    size_t before = m_Size;
+    size_t idx = InsertSlot(val.first);
+    bool inserted = m_Size != before;
+    if(inserted)
+      m_Slots[idx].second = val.second;
+    return std::make_pair(iterator(this, idx), inserted);
+  }
+
+  size_t erase(ResourceId id)
+  {
+    size_t idx = FindSlot(id);
+    if(idx == m_Slots.size())
+      return 0;
+    EraseSlot(idx);
+    return 1;
+  }
+
+  iterator erase(iterator it)
+  {
+    EraseSlot(it.m_Idx);
+    return iterator(this, NextFull(it.m_Idx + 1));
+  }
+
+  void clear()
+  {
+    m_Slots.clear();
+    m_State.clear();
+    m_Size = m_Used = 0;
+  }
+
+  void swap(ResourceIdMap &o)
+  {
+    m_Slots.swap(o.m_Slots);
+    m_State.swap(o.m_State);
+    std::swap(m_Size, o.m_Size);
+    std::swap(m_Used, o.m_Used);
+  }
+
+  // make room for count elements without growing again
+  void reserve(size_t count)
+  {
+    size_t cap = size_t(MinCapacity);
+    while(cap * MaxLoadNum < count * MaxLoadDenom)
+      cap *= 2;
+    if(cap > m_Slots.size())
+      Rehash(cap);
+  }
+
+private:
+  enum SlotState : uint8_t
+  {
+    Empty,
+    Full,
+    Erased,
+  };
+
+  // power of two so the hash can be masked. Erased slots still count against the load, since they
+  // lengthen probes just as much as full ones
+  enum
+  {
+    MinCapacity = 16,
+    MaxLoadNum = 3,
+    MaxLoadDenom = 4,
+  };
+
+  static size_t Hash(ResourceId id)
+  {
+    // IDs are allocated sequentially, so multiply by the golden ratio to spread consecutive IDs
+    // out, then fold the high bits down since they're the best mixed and we mask off the low ones
+    uint64_t val;
+    memcpy(&val, &id, sizeof(val));
+    val *= 0x9E3779B97F4A7C15ULL;
+    return size_t(val ^ (val >> 32));
+  }
+
+  size_t NextFull(size_t idx) const
+  {
+    while(idx < m_State.size() && m_State[idx] != Full)
+      idx++;
+    return idx;
+  }
+
+  // returns the slot holding id, or m_Slots.size() if it's not present
+  size_t FindSlot(ResourceId id) const
+  {
+    if(m_Size == 0)
+      return m_Slots.size();
+
+    size_t mask = m_Slots.size() - 1;
+    for(size_t idx = Hash(id) & mask;; idx = (idx + 1) & mask)
+    {
+      if(m_State[idx] == Empty)
+        return m_Slots.size();
+      if(m_State[idx] == Full && m_Slots[idx].first == id)
+        return idx;
+    }
+  }
+
+  // returns the slot holding id, adding a default-constructed value if it's not present
+  size_t InsertSlot(ResourceId id)
+  {
+    size_t idx = FindSlot(id);
+    if(idx != m_Slots.size())
+      return idx;
+
+    if((m_Used + 1) * MaxLoadDenom > m_Slots.size() * MaxLoadNum)
+    {
+      // only grow if it's mostly live elements, otherwise rehashing in place clears out enough
+      // erased slots
+      size_t cap = m_Slots.empty() ? size_t(MinCapacity) : m_Slots.size();
+      if((m_Size + 1) * 2 * MaxLoadDenom > cap * MaxLoadNum)
+        cap *= 2;
+      Rehash(cap);
+    }
+
+    size_t mask = m_Slots.size() - 1;
+    idx = Hash(id) & mask;
+    while(m_State[idx] == Full)
+      idx = (idx + 1) & mask;
+
+    if(m_State[idx] == Empty)
+      m_Used++;
+
+    m_State[idx] = Full;
+    m_Slots[idx].first = id;
+    m_Slots[idx].second = V();
+    m_Size++;
+
+    return idx;
+  }
+
+  void EraseSlot(size_t idx)
+  {
+    m_State[idx] = Erased;
+    // release whatever the value holds now rather than whenever the slot is reused
+    m_Slots[idx].second = V();
+    m_Size--;
+  }
+
+  void Rehash(size_t cap)
+  {
+    std::vector<value_type> slots(cap);
+    std::vector<uint8_t> state(cap, Empty);
+
+    slots.swap(m_Slots);
+    state.swap(m_State);
+
+    size_t mask = cap - 1;
+    for(size_t i = 0; i < state.size(); i++)
+    {
+      if(state[i] != Full)
+        continue;
+
+      size_t idx = Hash(slots[i].first) & mask;
+      while(m_State[idx] == Full)
+        idx = (idx + 1) & mask;
+
+      m_State[idx] = Full;
+      m_Slots[idx] = slots[i];
+    }
+
+    m_Used = m_Size;
+  }
+
+  std::vector<value_type> m_Slots;
+  std::vector<uint8_t> m_State;
+
+  // number of full slots, and number of full or erased slots
+  size_t m_Size, m_Used;
+};
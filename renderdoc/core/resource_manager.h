@@ -25,11 +25,14 @@
 
 #pragma once
 
+#include <algorithm>
 #include <map>
 #include <set>
+#include <vector>
 #include "api/replay/renderdoc_replay.h"
 #include "common/threading.h"
 #include "core/core.h"
+#include "core/resource_id_map.h"
 #include "os/os_specific.h"
 #include "serialise/serialiser.h"
 
@@ -65,6 +68,34 @@ void SetReplayResourceIDs();
 
 struct ResourceRecord;
 
+// chunks paired with the ID they were recorded with, which orders them in the capture. Each record
+// keeps its own chunks sorted by ID, and gathering them from several records with Insert() just
+// appends, so the result should be passed to SortChunkList before it's used.
+typedef std::vector<std::pair<int32_t, Chunk *> > ChunkList;
+
+struct ChunkIDLess
+{
+  bool operator()(const std::pair<int32_t, Chunk *> &a, const std::pair<int32_t, Chunk *> &b) const
+  {
+    return a.first < b.first;
+  }
+};
+
+struct ChunkIDEqual
+{
+  bool operator()(const std::pair<int32_t, Chunk *> &a, const std::pair<int32_t, Chunk *> &b) const
+  {
+    return a.first == b.first;
+  }
+};
+
+inline void SortChunkList(ChunkList &list)
+{
+  // stable so that if a chunk ID somehow appears twice, the first one inserted is kept
+  std::stable_sort(list.begin(), list.end(), ChunkIDLess());
+  list.erase(std::unique(list.begin(), list.end(), ChunkIDEqual()), list.end());
+}
+
 class ResourceRecordHandler
 {
 public:
@@ -97,6 +128,7 @@ struct ResourceRecord
         SpecialResource(false)
   {
     m_ChunkLock = NULL;
+    m_DeferChunkIDs = false;
 
     if(lock)
       m_ChunkLock = new Threading::CriticalSection();
@@ -133,7 +165,7 @@ struct ResourceRecord
   }
 
   void MarkDataUnwritten() { DataWritten = false; }
-  void Insert(map<int32_t, Chunk *> &recordlist)
+  void Insert(ChunkList &recordlist)
   {
     bool dataWritten = DataWritten;
 
@@ -148,7 +180,20 @@ struct ResourceRecord
     }
 
     if(!dataWritten)
-      recordlist.insert(m_Chunks.begin(), m_Chunks.end());
+    {
+      if(m_DeferChunkIDs)
+      {
+        // chunks still waiting for an ID are from an unfinished record, so they have no place in
+        // the order yet
+        for(size_t i = 0; i < m_Chunks.size(); i++)
+          if(m_Chunks[i].first != 0)
+            recordlist.push_back(m_Chunks[i]);
+      }
+      else
+      {
+        recordlist.insert(recordlist.end(), m_Chunks.begin(), m_Chunks.end());
+      }
+    }
   }
 
   void AddRef() { Atomic::Inc32(&RefCount); }
@@ -172,13 +217,60 @@ struct ResourceRecord
 
   void AddChunk(Chunk *chunk, int32_t ID = 0)
   {
+    if(m_DeferChunkIDs && ID == 0)
+    {
+      m_Chunks.push_back(std::make_pair(0, chunk));
+      return;
+    }
+
     LockChunks();
     if(ID == 0)
       ID = GetID();
-    m_Chunks[ID] = chunk;
+
+    // IDs are almost always allocated in order, so this is normally an append
+    if(m_Chunks.empty() || ID > m_Chunks.back().first)
+    {
+      m_Chunks.push_back(std::make_pair(ID, chunk));
+    }
+    else
+    {
+      std::pair<int32_t, Chunk *> entry(ID, chunk);
+      ChunkList::iterator it =
+          std::lower_bound(m_Chunks.begin(), m_Chunks.end(), entry, ChunkIDLess());
+      if(it != m_Chunks.end() && it->first == ID)
+        it->second = chunk;
+      else
+        m_Chunks.insert(it, entry);
+    }
     UnlockChunks();
   }
 
+  // for records that are only ever written by one thread at a time, and whose chunks only need to
+  // be ordered relative to each other until the record is finished (e.g. a command buffer being
+  // recorded). Chunks are then appended without locking or touching the global ID counter, and are
+  // given a contiguous block of IDs by AssignDeferredChunkIDs() once the record is finished.
+  void SetDeferChunkIDs(bool defer) { m_DeferChunkIDs = defer; }
+  void AssignDeferredChunkIDs()
+  {
+    int32_t numDeferred = 0;
+    for(size_t i = 0; i < m_Chunks.size(); i++)
+      if(m_Chunks[i].first == 0)
+        numDeferred++;
+
+    if(numDeferred == 0)
+      return;
+
+    int32_t ID = ReserveIDs(numDeferred);
+    for(size_t i = 0; i < m_Chunks.size(); i++)
+      if(m_Chunks[i].first == 0)
+        m_Chunks[i].first = ID++;
+
+    // the block of IDs is newer than any chunk already here, so this is only needed if a chunk
+    // with an explicit ID was added in the meantime
+    if(!std::is_sorted(m_Chunks.begin(), m_Chunks.end(), ChunkIDLess()))
+      std::stable_sort(m_Chunks.begin(), m_Chunks.end(), ChunkIDLess());
+  }
+
   void LockChunks()
   {
     if(m_ChunkLock)
@@ -207,8 +299,12 @@ struct ResourceRecord
     LockChunks();
     other->LockChunks();
 
+    // the other record keeps its chunks (e.g. a command list can be executed many times), so
+    // share their contents rather than copying them for every execution. They can share one block
+    // of IDs too
+    int32_t ID = ReserveIDs((int32_t)other->m_Chunks.size());
     for(auto it = other->m_Chunks.begin(); it != other->m_Chunks.end(); ++it)
-      AddChunk(it->second->Duplicate());
+      AddChunk(it->second->Share(), ID++);
 
     for(auto it = other->Parents.begin(); it != other->Parents.end(); ++it)
       AddParent(*it);
@@ -229,16 +325,16 @@ struct ResourceRecord
   Chunk *GetLastChunk() const
   {
     RDCASSERT(HasChunks());
-    return m_Chunks.rbegin()->second;
+    return m_Chunks.back().second;
   }
 
   int32_t GetLastChunkID() const
   {
     RDCASSERT(HasChunks());
-    return m_Chunks.rbegin()->first;
+    return m_Chunks.back().first;
   }
 
-  void PopChunk() { m_Chunks.erase(m_Chunks.rbegin()->first); }
+  void PopChunk() { m_Chunks.pop_back(); }
   byte *GetDataPtr() { return DataPtr + DataOffset; }
   bool HasDataPtr() { return DataPtr != NULL; }
   void SetDataOffset(uint64_t offs) { DataOffset = offs; }
@@ -251,6 +347,19 @@ struct ResourceRecord
       ids.insert(it->first);
   }
 
+  // reserves count consecutive chunk IDs, returning the first. A chunk that's serialised later
+  // can be added with a reserved ID to order it as if it had been added at the time
+  static int32_t ReserveIDs(int32_t count)
+  {
+    volatile int32_t &counter = GlobalIDCounter();
+
+    int32_t prev = counter;
+    while(Atomic::CmpExch32(&counter, prev, prev + count) != prev)
+      prev = counter;
+
+    return prev + 1;
+  }
+
   uint64_t Length;
 
   int UpdateCount;
@@ -268,17 +377,19 @@ protected:
 
   std::set<ResourceRecord *> Parents;
 
-  int32_t GetID()
+  static volatile int32_t &GlobalIDCounter()
   {
     static volatile int32_t globalIDCounter = 10;
-
-    return Atomic::Inc32(&globalIDCounter);
+    return globalIDCounter;
   }
 
-  std::map<int32_t, Chunk *> m_Chunks;
+  int32_t GetID() { return Atomic::Inc32(&GlobalIDCounter()); }
+
+  ChunkList m_Chunks;
   Threading::CriticalSection *m_ChunkLock;
+  bool m_DeferChunkIDs;
 
-  map<ResourceId, FrameRefType> m_FrameRefs;
+  ResourceIdMap<FrameRefType> m_FrameRefs;
 };
 
 // the resource manager is a utility class that's not required but is likely wanted by any API
@@ -333,6 +444,7 @@ public:
 
   void MarkInFrame(bool inFrame) { m_InFrame = inFrame; }
   void ReleaseInFrameResources();
+  bool HasInFrameResources() { return !m_InframeResourceMap.empty(); }
 
   // insert the chunks for the resources referenced in the frame
   void InsertReferencedChunks(Serialiser *fileSer);
@@ -363,8 +475,20 @@ public:
   // call callbacks to prepare initial contents for dirty resources
   void PrepareInitialContents();
 
+  // while idle, prepare the initial contents of a few dirty resources that haven't been modified
+  // recently, keeping at most budgetBytes of them around. Resources that are dirtied again lose
+  // their prepared contents, and PrepareInitialContents then only needs to prepare the rest.
+  void PrepareInitialContentsAhead(uint64_t budgetBytes);
+
   InitialContentData GetInitialContents(ResourceId id);
+  size_t NumInitialContents()
+  {
+    SCOPED_LOCK(m_Lock);
+    return m_InitialContents.size();
+  }
   void SetInitialContents(ResourceId id, InitialContentData contents);
+  // free a resource's initial contents, e.g. so a replay can evict them and re-load them later.
+  void ReleaseInitialContents(ResourceId id) { ReleasePreparedAhead(id); }
   void SetInitialChunk(ResourceId id, Chunk *chunk);
 
   // generate chunks for initial contents and insert.
@@ -375,14 +499,35 @@ public:
   // cleared on frame init).
   void Serialise_InitialContentsNeeded();
 
+  // Serialise which resources had their initial contents left out of the capture to fit within
+  // the initial contents budget, so they can be shown as placeholders on replay. This must come
+  // before CreateInitialContents when reading.
+  void Serialise_InitialContentsPlaceholders();
+
   // handle marking a resource referenced for read or write and storing RAW access etc.
-  static bool MarkReferenced(map<ResourceId, FrameRefType> &refs, ResourceId id,
+  static bool MarkReferenced(ResourceIdMap<FrameRefType> &refs, ResourceId id,
                              FrameRefType refType);
 
+  // the reference state after a resource that was already referenced as prev is referenced again
+  static FrameRefType CombineReference(FrameRefType prev, FrameRefType refType);
+
   // mark resource referenced somewhere in the main frame-affecting calls.
   // That means this resource should be included in the final serialise out
   inline void MarkResourceFrameReferenced(ResourceId id, FrameRefType refType);
 
+  // mark only one subresource of a resource as referenced. The resource is still included in the
+  // frame as with MarkResourceFrameReferenced, but if it is only ever referenced by subresource
+  // then the initial contents only need to contain the subresources that were touched. Any
+  // reference to the whole resource overrides this.
+  void MarkSubresourceFrameReferenced(ResourceId id, uint32_t subresource, FrameRefType refType);
+
+  // check if this subresource was referenced in the frame, either directly or because the whole
+  // resource was referenced.
+  bool IsSubresourceFrameReferenced(ResourceId id, uint32_t subresource);
+
+  // check if this resource was referenced at all in the frame
+  bool IsResourceFrameReferenced(ResourceId id);
+
   // check if this resource was read before being written to - can be used to detect if
   // initial states are necessary
   bool ReadBeforeWrite(ResourceId id);
@@ -408,6 +553,9 @@ public:
   // Serialise in which resources need initial contents and set them up.
   void CreateInitialContents();
 
+  // check if this resource's initial contents were left out of the capture for the budget
+  bool IsInitialContentsPlaceholder(ResourceId origid);
+
   // Free any initial contents that are prepared (for after capture is complete)
   void FreeInitialContents();
 
@@ -431,6 +579,12 @@ protected:
   virtual bool AllowDeletedResource_InitialState() { return false; }
   virtual bool Need_InitialStateChunk(WrappedResourceType res) = 0;
   virtual bool Prepare_InitialState(WrappedResourceType res) = 0;
+  // estimated size of the initial contents Prepare_InitialState would keep for res, or 0 if it
+  // can't be prepared ahead of a capture and should be left until the capture starts
+  virtual uint64_t PrepareAheadSize_InitialState(WrappedResourceType res) { return 0; }
+  // estimated size of the serialised initial contents for res, used to fit them within the
+  // initial contents budget. Resources returning 0 are always serialised
+  virtual uint64_t GetSize_InitialState(WrappedResourceType res) { return 0; }
   virtual bool Serialise_InitialState(ResourceId id, WrappedResourceType res) = 0;
   virtual void Create_InitialState(ResourceId id, WrappedResourceType live, bool hasData) = 0;
   virtual void Apply_InitialState(WrappedResourceType live, InitialContentData initial) = 0;
@@ -441,52 +595,80 @@ protected:
   Serialiser *GetSerialiser() { return m_pSerialiser; }
   bool m_InFrame;
 
-  // very coarse lock, protects EVERYTHING. This could certainly be improved and it may be a
-  // bottleneck
-  // for performance. Given that the main use cases are write-rarely read-often the lock should be
-  // optimised
-  // for that as we only want to make sure we're not modifying the objects together, by far the most
-  // common
-  // operation is looking up data.
+  // coarse lock, protects everything. The hottest lookups are additionally covered by the
+  // reader-writer locks below so that they don't need to take it.
   Threading::CriticalSection m_Lock;
 
-  // easy optimisation win - don't use maps everywhere. It's convenient but not optimal, and
-  // profiling will
-  // likely prove that some or all of these could be a problem
+  // finer-grained locks for the lookups made from every application thread while capturing.
+  // Anything modifying these maps also holds m_Lock, so code iterating over them under m_Lock is
+  // unaffected, but lookups only need a shared lock and don't contend with each other. They aren't
+  // recursive, so nothing else may be locked while holding one of them.
+  Threading::RWLock m_RecordLock;      // m_ResourceRecords
+  Threading::RWLock m_CurrentLock;     // m_CurrentResourceMap and m_Replacements
+  Threading::RWLock m_FrameRefLock;    // m_FrameReferencedResources and subresources
+
+  // maps that are only looked up by ID use ResourceIdMap, which is much cheaper per lookup. The
+  // remaining std::maps are iterated somewhere that relies on ID order, e.g. to serialise or apply
+  // initial contents in the order resources were created.
 
   // used during capture - map from real resource to its wrapper (other way can be done just with an
   // Unwrap)
   map<RealResourceType, WrappedResourceType> m_WrapperMap;
 
   // used during capture - holds resources referenced in current frame (and how they're referenced)
-  map<ResourceId, FrameRefType> m_FrameReferencedResources;
+  ResourceIdMap<FrameRefType> m_FrameReferencedResources;
+
+  // used during capture - for resources in m_FrameReferencedResources that have only been
+  // referenced by subresource, which subresources. Resources referenced whole are not present.
+  map<ResourceId, set<uint32_t> > m_FrameReferencedSubresources;
 
   // used during capture - holds resources marked as dirty, needing initial contents
   set<ResourceId> m_DirtyResources;
   set<ResourceId> m_PendingDirtyResources;
 
-  // used during capture or replay - holds initial contents
+  // used during capture - dirty resources with initial contents prepared ahead of the capture that
+  // are still up to date, and their estimated sizes. Prepared contents that went stale are kept
+  // separately until they can be released, and resources dirtied since the last step are recorded
+  // so that only resources which stay unmodified for a while are prepared ahead.
+  bool m_PrepareAheadActive;
+  uint64_t m_PreparedAheadBytes;
+  map<ResourceId, uint64_t> m_PreparedAhead;
+  set<ResourceId> m_StalePreparedAhead;
+  set<ResourceId> m_RecentlyDirtied;
+  void MarkPreparedAheadStale(ResourceId res);
+  void ReleasePreparedAhead(ResourceId res);
+  void ClearPreparedAhead();
+
+  // used during capture or replay - resources whose initial contents were left out of the capture
+  // because they didn't fit in the initial contents budget
+  set<ResourceId> m_InitialContentsPlaceholders;
+  void ChooseInitialContentsPlaceholders(uint64_t budgetBytes);
+
+  // used during capture or replay - holds initial contents. Applied in ID order on replay
   map<ResourceId, InitialContentData> m_InitialContents;
   // on capture, if a chunk was prepared in Prepare_InitialContents and added, don't re-serialise.
   // Some initial contents may not need the delayed readback.
-  map<ResourceId, Chunk *> m_InitialChunks;
+  ResourceIdMap<Chunk *> m_InitialChunks;
 
   // used during capture or replay - map of resources currently alive with their real IDs, used in
   // capture and replay.
   map<ResourceId, WrappedResourceType> m_CurrentResourceMap;
 
   // used during replay - maps back and forth from original id to live id and vice-versa
-  map<ResourceId, ResourceId> m_OriginalIDs, m_LiveIDs;
+  ResourceIdMap<ResourceId> m_OriginalIDs, m_LiveIDs;
 
   // used during replay - holds resources allocated and the original id that they represent
   // for a) in-frame creations and b) pre-frame creations respectively.
-  map<ResourceId, WrappedResourceType> m_InframeResourceMap, m_LiveResourceMap;
+  ResourceIdMap<WrappedResourceType> m_InframeResourceMap, m_LiveResourceMap;
+  // releases and removes everything in one of the maps above in ID order, the order they were
+  // created, so resources that depend on earlier ones are released the same way on every run
+  void ReleaseInIdOrder(ResourceIdMap<WrappedResourceType> &resources);
 
   // used during capture - holds resource records by id.
   map<ResourceId, RecordType *> m_ResourceRecords;
 
   // used during replay - holds current resource replacements
-  map<ResourceId, ResourceId> m_Replacements;
+  ResourceIdMap<ResourceId> m_Replacements;
 };
 
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
@@ -500,36 +682,50 @@ ResourceManager<WrappedResourceType, RealResourceType, RecordType>::ResourceMana
   m_pSerialiser = ser;
 
   m_InFrame = false;
+
+  m_PrepareAheadActive = false;
+  m_PreparedAheadBytes = 0;
 }
 
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
 void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::Shutdown()
 {
-  while(!m_LiveResourceMap.empty())
-  {
-    auto it = m_LiveResourceMap.begin();
-    ResourceId id = it->first;
-    ResourceTypeRelease(it->second);
+  ReleaseInIdOrder(m_LiveResourceMap);
+  ReleaseInIdOrder(m_InframeResourceMap);
 
-    auto removeit = m_LiveResourceMap.find(id);
-    if(removeit != m_LiveResourceMap.end())
-      m_LiveResourceMap.erase(removeit);
-  }
+  FreeInitialContents();
 
-  while(!m_InframeResourceMap.empty())
+  RDCASSERT(m_ResourceRecords.empty());
+}
+
+template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
+void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::ReleaseInIdOrder(
+    ResourceIdMap<WrappedResourceType> &resources)
+{
+  // releasing a resource can remove others from the map, or add new ones, so look each one up
+  // again and repeat until the map is empty
+  while(!resources.empty())
   {
-    auto it = m_InframeResourceMap.begin();
-    ResourceId id = it->first;
-    ResourceTypeRelease(it->second);
+    vector<ResourceId> ids;
+    ids.reserve(resources.size());
+    for(auto it = resources.begin(); it != resources.end(); ++it)
+      ids.push_back(it->first);
 
-    auto removeit = m_InframeResourceMap.find(id);
-    if(removeit != m_InframeResourceMap.end())
-      m_InframeResourceMap.erase(removeit);
-  }
+    std::sort(ids.begin(), ids.end());
 
-  FreeInitialContents();
+    for(size_t i = 0; i < ids.size(); i++)
+    {
+      auto it = resources.find(ids[i]);
+      if(it == resources.end())
+        continue;
 
-  RDCASSERT(m_ResourceRecords.empty());
+      ResourceTypeRelease(it->second);
+
+      auto removeit = resources.find(ids[i]);
+      if(removeit != resources.end())
+        resources.erase(removeit);
+    }
+  }
 }
 
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
@@ -546,9 +742,11 @@ ResourceManager<WrappedResourceType, RealResourceType, RecordType>::~ResourceMan
 
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
 bool ResourceManager<WrappedResourceType, RealResourceType, RecordType>::MarkReferenced(
-    map<ResourceId, FrameRefType> &refs, ResourceId id, FrameRefType refType)
+    ResourceIdMap<FrameRefType> &refs, ResourceId id, FrameRefType refType)
 {
-  if(refs.find(id) == refs.end())
+  auto it = refs.find(id);
+
+  if(it == refs.end())
   {
     if(refType == eFrameRef_Read)
       refs[id] = eFrameRef_ReadOnly;
@@ -559,44 +757,115 @@ bool ResourceManager<WrappedResourceType, RealResourceType, RecordType>::MarkRef
 
     return true;
   }
-  else
+
+  it->second = CombineReference(it->second, refType);
+
+  return false;
+}
+
+template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
+FrameRefType ResourceManager<WrappedResourceType, RealResourceType, RecordType>::CombineReference(
+    FrameRefType prev, FrameRefType refType)
+{
+  if(refType == eFrameRef_Unknown)
   {
-    if(refType == eFrameRef_Unknown)
-    {
-      // nothing
-    }
-    else if(refType == eFrameRef_ReadBeforeWrite)
-    {
-      // special case, explicitly set to ReadBeforeWrite for when
-      // we know that this use will likely be a partial-write
-      refs[id] = eFrameRef_ReadBeforeWrite;
-    }
-    else if(refs[id] == eFrameRef_Unknown)
-    {
-      if(refType == eFrameRef_Read || refType == eFrameRef_ReadOnly)
-        refs[id] = eFrameRef_ReadOnly;
-      else
-        refs[id] = eFrameRef_ReadAndWrite;
-    }
-    else if(refs[id] == eFrameRef_ReadOnly && refType == eFrameRef_Write)
-    {
-      refs[id] = eFrameRef_ReadBeforeWrite;
-    }
+    // nothing
+    return prev;
+  }
+  else if(refType == eFrameRef_ReadBeforeWrite)
+  {
+    // special case, explicitly set to ReadBeforeWrite for when
+    // we know that this use will likely be a partial-write
+    return eFrameRef_ReadBeforeWrite;
+  }
+  else if(prev == eFrameRef_Unknown)
+  {
+    if(refType == eFrameRef_Read || refType == eFrameRef_ReadOnly)
+      return eFrameRef_ReadOnly;
+    else
+      return eFrameRef_ReadAndWrite;
+  }
+  else if(prev == eFrameRef_ReadOnly && refType == eFrameRef_Write)
+  {
+    return eFrameRef_ReadBeforeWrite;
   }
 
-  return false;
+  return prev;
 }
 
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
 void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::MarkResourceFrameReferenced(
     ResourceId id, FrameRefType refType)
+{
+  if(id == ResourceId())
+    return;
+
+  // by far the most common case is a resource that's already referenced, where this reference
+  // doesn't change anything. That only needs to read, so threads don't serialise on it.
+  {
+    SCOPED_READLOCK(m_FrameRefLock);
+
+    auto it = m_FrameReferencedResources.find(id);
+
+    if(it != m_FrameReferencedResources.end() &&
+       m_FrameReferencedSubresources.find(id) == m_FrameReferencedSubresources.end() &&
+       CombineReference(it->second, refType) == it->second)
+      return;
+  }
+
+  SCOPED_LOCK(m_Lock);
+
+  bool newRef = false;
+
+  {
+    SCOPED_WRITELOCK(m_FrameRefLock);
+
+    newRef = MarkReferenced(m_FrameReferencedResources, id, refType);
+
+    // a whole-resource reference supersedes any subresource references
+    if(!m_FrameReferencedSubresources.empty())
+      m_FrameReferencedSubresources.erase(id);
+  }
+
+  if(newRef)
+  {
+    RecordType *record = GetResourceRecord(id);
+
+    if(record)
+      record->AddRef();
+  }
+}
+
+template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
+void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::MarkSubresourceFrameReferenced(
+    ResourceId id, uint32_t subresource, FrameRefType refType)
 {
   SCOPED_LOCK(m_Lock);
 
   if(id == ResourceId())
     return;
 
-  bool newRef = MarkReferenced(m_FrameReferencedResources, id, refType);
+  bool newRef = false;
+
+  {
+    SCOPED_WRITELOCK(m_FrameRefLock);
+
+    auto partial = m_FrameReferencedSubresources.find(id);
+
+    // if the resource is already referenced but not by subresource, it's referenced whole
+    bool whole = partial == m_FrameReferencedSubresources.end() &&
+                 m_FrameReferencedResources.find(id) != m_FrameReferencedResources.end();
+
+    newRef = MarkReferenced(m_FrameReferencedResources, id, refType);
+
+    if(!whole)
+    {
+      if(partial == m_FrameReferencedSubresources.end())
+        m_FrameReferencedSubresources[id].insert(subresource);
+      else
+        partial->second.insert(subresource);
+    }
+  }
 
   if(newRef)
   {
@@ -607,12 +876,39 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::MarkRes
   }
 }
 
+template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
+bool ResourceManager<WrappedResourceType, RealResourceType, RecordType>::IsSubresourceFrameReferenced(
+    ResourceId id, uint32_t subresource)
+{
+  SCOPED_READLOCK(m_FrameRefLock);
+
+  auto partial = m_FrameReferencedSubresources.find(id);
+
+  if(partial != m_FrameReferencedSubresources.end())
+    return partial->second.find(subresource) != partial->second.end();
+
+  // referenced whole, or not at all (in which case we don't know better than to keep it all)
+  return true;
+}
+
+template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
+bool ResourceManager<WrappedResourceType, RealResourceType, RecordType>::IsResourceFrameReferenced(
+    ResourceId id)
+{
+  SCOPED_READLOCK(m_FrameRefLock);
+
+  return m_FrameReferencedResources.find(id) != m_FrameReferencedResources.end();
+}
+
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
 bool ResourceManager<WrappedResourceType, RealResourceType, RecordType>::ReadBeforeWrite(ResourceId id)
 {
-  if(m_FrameReferencedResources.find(id) != m_FrameReferencedResources.end())
-    return m_FrameReferencedResources[id] == eFrameRef_ReadBeforeWrite ||
-           m_FrameReferencedResources[id] == eFrameRef_ReadOnly;
+  SCOPED_READLOCK(m_FrameRefLock);
+
+  auto it = m_FrameReferencedResources.find(id);
+
+  if(it != m_FrameReferencedResources.end())
+    return it->second == eFrameRef_ReadBeforeWrite || it->second == eFrameRef_ReadOnly;
 
   return false;
 }
@@ -626,6 +922,9 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::MarkDir
     return;
 
   m_DirtyResources.insert(res);
+
+  if(m_PrepareAheadActive)
+    MarkPreparedAheadStale(res);
 }
 
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
@@ -637,6 +936,48 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::MarkPen
     return;
 
   m_PendingDirtyResources.insert(res);
+
+  if(m_PrepareAheadActive)
+    MarkPreparedAheadStale(res);
+}
+
+template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
+void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::MarkPreparedAheadStale(
+    ResourceId res)
+{
+  m_RecentlyDirtied.insert(res);
+
+  auto it = m_PreparedAhead.find(res);
+  if(it != m_PreparedAhead.end())
+  {
+    m_PreparedAheadBytes -= it->second;
+    m_PreparedAhead.erase(it);
+    m_StalePreparedAhead.insert(res);
+  }
+}
+
+template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
+void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::ReleasePreparedAhead(
+    ResourceId res)
+{
+  auto it = m_InitialContents.find(res);
+
+  if(it != m_InitialContents.end())
+  {
+    ResourceTypeRelease(it->second.resource);
+    Serialiser::FreeAlignedBuffer(it->second.blob);
+    m_InitialContents.erase(it);
+  }
+}
+
+template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
+void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::ClearPreparedAhead()
+{
+  m_PrepareAheadActive = false;
+  m_PreparedAheadBytes = 0;
+  m_PreparedAhead.clear();
+  m_StalePreparedAhead.clear();
+  m_RecentlyDirtied.clear();
 }
 
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
@@ -671,6 +1012,9 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::MarkCle
   {
     m_DirtyResources.erase(res);
   }
+
+  if(m_PrepareAheadActive)
+    MarkPreparedAheadStale(res);
 }
 
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
@@ -769,6 +1113,10 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::Seriali
     }
   }
 
+  // m_FrameReferencedResources is unordered, so sort to serialise the list in a stable order
+  std::sort(written.begin(), written.end(),
+            [](const WrittenRecord &a, const WrittenRecord &b) { return a.id < b.id; });
+
   uint32_t numWritten = (uint32_t)written.size();
   m_pSerialiser->Serialise("NumWrittenResources", numWritten);
 
@@ -779,9 +1127,55 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::Seriali
   }
 }
 
+template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
+void ResourceManager<WrappedResourceType, RealResourceType,
+                     RecordType>::Serialise_InitialContentsPlaceholders()
+{
+  SCOPED_LOCK(m_Lock);
+
+  uint32_t numPlaceholders = (uint32_t)m_InitialContentsPlaceholders.size();
+  m_pSerialiser->Serialise("NumPlaceholders", numPlaceholders);
+
+  if(m_State >= WRITING)
+  {
+    for(auto it = m_InitialContentsPlaceholders.begin(); it != m_InitialContentsPlaceholders.end();
+        ++it)
+    {
+      ResourceId id = *it;
+      m_pSerialiser->Serialise("id", id);
+    }
+  }
+  else
+  {
+    m_InitialContentsPlaceholders.clear();
+
+    for(uint32_t i = 0; i < numPlaceholders; i++)
+    {
+      ResourceId id;
+      m_pSerialiser->Serialise("id", id);
+      m_InitialContentsPlaceholders.insert(id);
+    }
+
+    if(numPlaceholders > 0)
+      RDCLOG("%u resources have placeholder initial contents to fit the capture's budget",
+             numPlaceholders);
+  }
+}
+
+template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
+bool ResourceManager<WrappedResourceType, RealResourceType, RecordType>::IsInitialContentsPlaceholder(
+    ResourceId origid)
+{
+  SCOPED_LOCK(m_Lock);
+
+  return m_InitialContentsPlaceholders.find(origid) != m_InitialContentsPlaceholders.end();
+}
+
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
 void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::FreeInitialContents()
 {
+  ClearPreparedAhead();
+
   while(!m_InitialContents.empty())
   {
     auto it = m_InitialContents.begin();
@@ -810,6 +1204,10 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::CreateI
 
     neededInitials.insert(id);
 
+    // placeholders have no data to restore, so create them as if they'd never been written
+    if(IsInitialContentsPlaceholder(id))
+      WrittenData = false;
+
     if(HasLiveResource(id) && m_InitialContents.find(id) == m_InitialContents.end())
       Create_InitialState(id, GetLiveResource(id), WrittenData);
   }
@@ -868,7 +1266,7 @@ template <typename WrappedResourceType, typename RealResourceType, typename Reco
 void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::InsertReferencedChunks(
     Serialiser *fileSer)
 {
-  map<int32_t, Chunk *> sortedChunks;
+  ChunkList sortedChunks;
 
   SCOPED_LOCK(m_Lock);
 
@@ -894,6 +1292,8 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::InsertR
     }
   }
 
+  SortChunkList(sortedChunks);
+
   RDCDEBUG("%u frame resource chunks", (uint32_t)sortedChunks.size());
 
   for(auto it = sortedChunks.begin(); it != sortedChunks.end(); it++)
@@ -910,7 +1310,16 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::Prepare
   SCOPED_LOCK(m_Lock);
 
   RDCDEBUG("Preparing up to %u potentially dirty resources", (uint32_t)m_DirtyResources.size());
-  uint32_t prepared = 0;
+  uint32_t prepared = 0, preparedAhead = 0;
+
+  // anything prepared ahead that's gone stale, or whose resource has since been deleted, is no
+  // longer needed. Dirty resources that are still alive are prepared again below.
+  for(auto it = m_StalePreparedAhead.begin(); it != m_StalePreparedAhead.end(); ++it)
+    ReleasePreparedAhead(*it);
+
+  for(auto it = m_PreparedAhead.begin(); it != m_PreparedAhead.end(); ++it)
+    if(!HasCurrentResource(it->first))
+      ReleasePreparedAhead(it->first);
 
   for(auto it = m_DirtyResources.begin(); it != m_DirtyResources.end(); ++it)
   {
@@ -919,6 +1328,12 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::Prepare
     if(!HasCurrentResource(id))
       continue;
 
+    if(m_PreparedAhead.find(id) != m_PreparedAhead.end())
+    {
+      preparedAhead++;
+      continue;
+    }
+
     RecordType *record = GetResourceRecord(id);
     WrappedResourceType res = GetCurrentResource(id);
 
@@ -934,7 +1349,10 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::Prepare
     Prepare_InitialState(res);
   }
 
-  RDCDEBUG("Prepared %u dirty resources", prepared);
+  RDCDEBUG("Prepared %u dirty resources, %u were prepared ahead", prepared, preparedAhead);
+
+  // the initial contents now belong to this capture, and are freed with the rest after it
+  ClearPreparedAhead();
 
   prepared = 0;
 
@@ -953,6 +1371,171 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::Prepare
   RDCDEBUG("Force-prepared %u dirty resources", prepared);
 }
 
+template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
+void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::PrepareInitialContentsAhead(
+    uint64_t budgetBytes)
+{
+  // spread filling the budget over this many frames, to keep the added cost per frame low
+  const uint64_t PrepareAheadFrames = 8;
+
+  SCOPED_LOCK(m_Lock);
+
+  // start tracking modifications first, so that resources dirtied every frame are never prepared
+  if(!m_PrepareAheadActive)
+  {
+    m_PrepareAheadActive = true;
+    m_RecentlyDirtied.clear();
+    return;
+  }
+
+  for(auto it = m_StalePreparedAhead.begin(); it != m_StalePreparedAhead.end(); ++it)
+    ReleasePreparedAhead(*it);
+
+  m_StalePreparedAhead.clear();
+
+  for(auto it = m_PreparedAhead.begin(); it != m_PreparedAhead.end();)
+  {
+    if(HasCurrentResource(it->first))
+    {
+      ++it;
+      continue;
+    }
+
+    ReleasePreparedAhead(it->first);
+    m_PreparedAheadBytes -= it->second;
+    m_PreparedAhead.erase(it++);
+  }
+
+  uint64_t frameBytes = RDCMAX(budgetBytes / PrepareAheadFrames, (uint64_t)1);
+  uint64_t preparedBytes = 0;
+
+  for(auto it = m_DirtyResources.begin(); it != m_DirtyResources.end(); ++it)
+  {
+    if(preparedBytes >= frameBytes || m_PreparedAheadBytes >= budgetBytes)
+      break;
+
+    ResourceId id = *it;
+
+    if(m_PreparedAhead.find(id) != m_PreparedAhead.end() ||
+       m_RecentlyDirtied.find(id) != m_RecentlyDirtied.end() || !HasCurrentResource(id))
+      continue;
+
+    RecordType *record = GetResourceRecord(id);
+    WrappedResourceType res = GetCurrentResource(id);
+
+    if(record == NULL || record->SpecialResource || Force_InitialState(res, true))
+      continue;
+
+    uint64_t size = PrepareAheadSize_InitialState(res);
+
+    if(size == 0 || m_PreparedAheadBytes + size > budgetBytes)
+      continue;
+
+    Prepare_InitialState(res);
+
+    m_PreparedAhead[id] = size;
+    m_PreparedAheadBytes += size;
+    preparedBytes += size;
+  }
+
+  m_RecentlyDirtied.clear();
+}
+
+template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
+void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::ChooseInitialContentsPlaceholders(
+    uint64_t budgetBytes)
+{
+  // the order in which initial contents are kept when they don't all fit. Contents read before
+  // being written matter the most since the frame depends on them and then changes them, next are
+  // resources written in the frame, then those only read. Anything else isn't used in the frame.
+  enum
+  {
+    ePriority_ReadBeforeWrite,
+    ePriority_Written,
+    ePriority_ReadOnly,
+    ePriority_Other,
+    ePriority_Count,
+  };
+
+  struct Candidate
+  {
+    ResourceId id;
+    uint64_t size;
+  };
+
+  vector<Candidate> candidates[ePriority_Count];
+
+  uint64_t total = 0;
+
+  for(auto it = m_DirtyResources.begin(); it != m_DirtyResources.end(); ++it)
+  {
+    ResourceId id = *it;
+
+    if(!HasCurrentResource(id))
+      continue;
+
+    RecordType *record = GetResourceRecord(id);
+
+    if(record == NULL || record->SpecialResource)
+      continue;
+
+    auto ref = m_FrameReferencedResources.find(id);
+
+    if(ref == m_FrameReferencedResources.end() &&
+       !RenderDoc::Inst().GetCaptureOptions().RefAllResources)
+      continue;
+
+    uint64_t size = GetSize_InitialState(GetCurrentResource(id));
+
+    // resources without a size are always serialised
+    if(size == 0)
+      continue;
+
+    int priority = ePriority_Other;
+
+    if(ref != m_FrameReferencedResources.end())
+    {
+      switch(ref->second)
+      {
+        case eFrameRef_ReadBeforeWrite: priority = ePriority_ReadBeforeWrite; break;
+        case eFrameRef_Write:
+        case eFrameRef_ReadAndWrite: priority = ePriority_Written; break;
+        case eFrameRef_Read:
+        case eFrameRef_ReadOnly: priority = ePriority_ReadOnly; break;
+        default: break;
+      }
+    }
+
+    Candidate c = {id, size};
+    candidates[priority].push_back(c);
+
+    total += size;
+  }
+
+  if(total <= budgetBytes)
+    return;
+
+  uint64_t used = 0;
+
+  // keep as many as fit in priority order. A resource that doesn't fit doesn't stop smaller ones
+  // after it from being kept.
+  for(int p = 0; p < ePriority_Count; p++)
+  {
+    for(size_t i = 0; i < candidates[p].size(); i++)
+    {
+      const Candidate &c = candidates[p][i];
+
+      if(used + c.size <= budgetBytes)
+        used += c.size;
+      else
+        m_InitialContentsPlaceholders.insert(c.id);
+    }
+  }
+
+  RDCLOG("Initial contents need %llu bytes, over the budget of %llu. %u left as placeholders", total,
+         budgetBytes, (uint32_t)m_InitialContentsPlaceholders.size());
+}
+
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
 void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::InsertInitialContentsChunks(
     Serialiser *fileSerialiser)
@@ -961,6 +1544,21 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::InsertI
 
   uint32_t dirty = 0;
   uint32_t skipped = 0;
+  uint32_t placeholders = 0;
+
+  m_InitialContentsPlaceholders.clear();
+
+  uint64_t budget = uint64_t(RenderDoc::Inst().GetCaptureOptions().InitialContentsBudget) << 20;
+
+  if(budget > 0)
+    ChooseInitialContentsPlaceholders(budget);
+
+  // chunks serialised here go straight into the file in order, so identical contents can be stored
+  // once and referenced after that. Prepared chunks were serialised earlier and might not be used,
+  // so they always keep their own copy.
+  bool dedup = RenderDoc::Inst().GetCaptureOptions().DeduplicateInitialContents != 0;
+
+  m_pSerialiser->ResetBufferDeduplication();
 
   RDCDEBUG("Checking %u possibly dirty resources", (uint32_t)m_DirtyResources.size());
 
@@ -1010,6 +1608,15 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::InsertI
       continue;
     }
 
+    if(m_InitialContentsPlaceholders.find(id) != m_InitialContentsPlaceholders.end())
+    {
+#if ENABLED(VERBOSE_DIRTY_RESOURCES)
+      RDCDEBUG("Resource %llu doesn't fit in the initial contents budget - skipping", id);
+#endif
+      placeholders++;
+      continue;
+    }
+
 #if ENABLED(VERBOSE_DIRTY_RESOURCES)
     RDCDEBUG("Serialising dirty Resource %llu", id);
 #endif
@@ -1034,13 +1641,16 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::InsertI
       ScopedContext scope(m_pSerialiser, "Initial Contents", "Initial Contents", INITIAL_CONTENTS,
                           false);
 
+      m_pSerialiser->SetBufferDeduplication(dedup);
       Serialise_InitialState(id, res);
+      m_pSerialiser->SetBufferDeduplication(false);
 
       fileSerialiser->Insert(scope.Get(true));
     }
   }
 
-  RDCDEBUG("Serialised %u dirty resources, skipped %u unreferenced", dirty, skipped);
+  RDCDEBUG("Serialised %u dirty resources, skipped %u unreferenced and %u over budget", dirty,
+           skipped, placeholders);
 
   dirty = 0;
 
@@ -1064,7 +1674,9 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::InsertI
         ScopedContext scope(m_pSerialiser, "Initial Contents", "Initial Contents", INITIAL_CONTENTS,
                             false);
 
+        m_pSerialiser->SetBufferDeduplication(dedup);
         Serialise_InitialState(it->first, it->second);
+        m_pSerialiser->SetBufferDeduplication(false);
 
         fileSerialiser->Insert(scope.Get(true));
       }
@@ -1073,6 +1685,15 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::InsertI
 
   RDCDEBUG("Force-serialised %u dirty resources", dirty);
 
+  if(dedup)
+  {
+    RDCDEBUG("%u deduplicated initial contents are referenced",
+             (uint32_t)m_pSerialiser->GetReferencedBuffers().size());
+
+    fileSerialiser->AddReferencedBuffers(m_pSerialiser->GetReferencedBuffers());
+    m_pSerialiser->ResetBufferDeduplication();
+  }
+
   // delete/cleanup any chunks that weren't used (maybe the resource was not
   // referenced).
   for(auto it = m_InitialChunks.begin(); it != m_InitialChunks.end(); ++it)
@@ -1109,7 +1730,10 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::ClearRe
       record->Delete(this);
   }
 
+  SCOPED_WRITELOCK(m_FrameRefLock);
+
   m_FrameReferencedResources.clear();
+  m_FrameReferencedSubresources.clear();
 }
 
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
@@ -1119,7 +1743,10 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::Replace
   SCOPED_LOCK(m_Lock);
 
   if(HasLiveResource(to))
+  {
+    SCOPED_WRITELOCK(m_CurrentLock);
     m_Replacements[from] = to;
+  }
 }
 
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
@@ -1140,6 +1767,7 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::RemoveR
   if(it == m_Replacements.end())
     return;
 
+  SCOPED_WRITELOCK(m_CurrentLock);
   m_Replacements.erase(it);
 }
 
@@ -1147,7 +1775,7 @@ template <typename WrappedResourceType, typename RealResourceType, typename Reco
 RecordType *ResourceManager<WrappedResourceType, RealResourceType, RecordType>::GetResourceRecord(
     ResourceId id)
 {
-  SCOPED_LOCK(m_Lock);
+  SCOPED_READLOCK(m_RecordLock);
 
   auto it = m_ResourceRecords.find(id);
 
@@ -1160,7 +1788,7 @@ RecordType *ResourceManager<WrappedResourceType, RealResourceType, RecordType>::
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
 bool ResourceManager<WrappedResourceType, RealResourceType, RecordType>::HasResourceRecord(ResourceId id)
 {
-  SCOPED_LOCK(m_Lock);
+  SCOPED_READLOCK(m_RecordLock);
 
   auto it = m_ResourceRecords.find(id);
 
@@ -1175,6 +1803,7 @@ RecordType *ResourceManager<WrappedResourceType, RealResourceType, RecordType>::
     ResourceId id)
 {
   SCOPED_LOCK(m_Lock);
+  SCOPED_WRITELOCK(m_RecordLock);
 
   RDCASSERT(m_ResourceRecords.find(id) == m_ResourceRecords.end(), id);
 
@@ -1186,6 +1815,7 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::RemoveR
     ResourceId id)
 {
   SCOPED_LOCK(m_Lock);
+  SCOPED_WRITELOCK(m_RecordLock);
 
   RDCASSERT(m_ResourceRecords.find(id) != m_ResourceRecords.end(), id);
 
@@ -1362,6 +1992,7 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::AddCurr
     ResourceId id, WrappedResourceType res)
 {
   SCOPED_LOCK(m_Lock);
+  SCOPED_WRITELOCK(m_CurrentLock);
 
   RDCASSERT(m_CurrentResourceMap.find(id) == m_CurrentResourceMap.end(), id);
   m_CurrentResourceMap[id] = res;
@@ -1370,7 +2001,7 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::AddCurr
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
 bool ResourceManager<WrappedResourceType, RealResourceType, RecordType>::HasCurrentResource(ResourceId id)
 {
-  SCOPED_LOCK(m_Lock);
+  SCOPED_READLOCK(m_CurrentLock);
 
   return m_CurrentResourceMap.find(id) != m_CurrentResourceMap.end();
 }
@@ -1379,13 +2010,18 @@ template <typename WrappedResourceType, typename RealResourceType, typename Reco
 WrappedResourceType ResourceManager<WrappedResourceType, RealResourceType,
                                     RecordType>::GetCurrentResource(ResourceId id)
 {
-  SCOPED_LOCK(m_Lock);
+  SCOPED_READLOCK(m_CurrentLock);
 
-  if(m_Replacements.find(id) != m_Replacements.end())
-    return GetCurrentResource(m_Replacements[id]);
+  for(auto r = m_Replacements.find(id); r != m_Replacements.end(); r = m_Replacements.find(id))
+    id = r->second;
 
-  RDCASSERT(m_CurrentResourceMap.find(id) != m_CurrentResourceMap.end(), id);
-  return m_CurrentResourceMap[id];
+  auto it = m_CurrentResourceMap.find(id);
+
+  RDCASSERT(it != m_CurrentResourceMap.end(), id);
+  if(it == m_CurrentResourceMap.end())
+    return (WrappedResourceType)RecordType::NullResource;
+
+  return it->second;
 }
 
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
@@ -1393,6 +2029,7 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::Release
     ResourceId id)
 {
   SCOPED_LOCK(m_Lock);
+  SCOPED_WRITELOCK(m_CurrentLock);
 
   RDCASSERT(m_CurrentResourceMap.find(id) != m_CurrentResourceMap.end(), id);
   m_CurrentResourceMap.erase(id);
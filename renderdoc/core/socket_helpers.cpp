@@ -0,0 +1,477 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2017 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "core/core.h"
+#include "os/os_specific.h"
+#include "serialise/serialiser.h"
+#include "serialise/string_utils.h"
+#include "3rdparty/lz4/lz4.h"
+#include "3rdparty/miniz/miniz.h"
+#include "socket_helpers.h"
+
+// LZ4 has to save at least this fraction of a payload for compressing to be worthwhile, otherwise
+// the data is assumed to be incompressible (e.g. already compressed textures) and sent raw.
+static const uint32_t MinimumSavingDivisor = 8;
+
+// payloads at least this large that LZ4 shows are compressible go on to try deflate, which is
+// slower but gives a better ratio. Below this, the time spent compressing outweighs the saving.
+static const uint32_t DeflateThreshold = 1024 * 1024;
+
+struct PacketCompressionHeader
+{
+  uint32_t codec;
+  uint32_t uncompressedLength;
+};
+
+uint32_t GetAcceptedPacketCodecs()
+{
+  string setting = strlower(RenderDoc::Inst().GetConfigSetting("remote.compression"));
+
+  if(setting == "none")
+    return ePacketCodec_None;
+  if(setting == "lz4")
+    return ePacketCodec_LZ4;
+  if(setting == "deflate")
+    return ePacketCodec_Deflate;
+
+  return ePacketCodec_All;
+}
+
+PacketCodec CompressPacketPayload(const byte *data, uint32_t length, uint32_t acceptedCodecs,
+                                  vector<byte> &compressed, bool strongest)
+{
+  if(length < PacketCompressionThreshold || (acceptedCodecs & ePacketCodec_All) == 0)
+    return ePacketCodec_None;
+
+  const size_t headerSize = sizeof(PacketCompressionHeader);
+  uint32_t maxSize = length - length / MinimumSavingDivisor;
+
+  PacketCodec codec = ePacketCodec_None;
+  uint32_t compressedLength = 0;
+
+  if(acceptedCodecs & ePacketCodec_LZ4)
+  {
+    compressed.resize(headerSize + LZ4_COMPRESSBOUND(length));
+
+    int ret = LZ4_compress_default((const char *)data, (char *)&compressed[headerSize], (int)length,
+                                   LZ4_COMPRESSBOUND(length));
+
+    // if LZ4 can't compress it, deflate won't do much better
+    if(ret <= 0 || (uint32_t)ret > maxSize)
+      return ePacketCodec_None;
+
+    codec = ePacketCodec_LZ4;
+    compressedLength = (uint32_t)ret;
+  }
+
+  if((acceptedCodecs & ePacketCodec_Deflate) &&
+     (codec == ePacketCodec_None || length >= DeflateThreshold || strongest))
+  {
+    vector<byte> deflated(headerSize + mz_compressBound((mz_ulong)length));
+    mz_ulong deflatedLength = (mz_ulong)(deflated.size() - headerSize);
+
+    int ret = mz_compress2(&deflated[headerSize], &deflatedLength, data, (mz_ulong)length,
+                           strongest ? MZ_BEST_COMPRESSION : 1);
+
+    if(ret == MZ_OK && deflatedLength <= maxSize &&
+       (codec == ePacketCodec_None || deflatedLength < compressedLength))
+    {
+      codec = ePacketCodec_Deflate;
+      compressedLength = (uint32_t)deflatedLength;
+      compressed.swap(deflated);
+    }
+  }
+
+  if(codec == ePacketCodec_None)
+    return ePacketCodec_None;
+
+  PacketCompressionHeader header = {(uint32_t)codec, length};
+  memcpy(&compressed[0], &header, headerSize);
+  compressed.resize(headerSize + compressedLength);
+
+  return codec;
+}
+
+bool DecompressPacketPayload(vector<byte> &payload)
+{
+  PacketCompressionHeader header;
+
+  if(payload.size() < sizeof(header))
+  {
+    RDCERR("Compressed packet is too small for its header");
+    return false;
+  }
+
+  memcpy(&header, &payload[0], sizeof(header));
+
+  if(header.uncompressedLength == 0)
+  {
+    RDCERR("Compressed packet has no contents");
+    return false;
+  }
+
+  const byte *src = &payload[sizeof(header)];
+  uint32_t srcLength = uint32_t(payload.size() - sizeof(header));
+
+  vector<byte> decompressed(header.uncompressedLength);
+
+  bool success = false;
+
+  if(header.codec == ePacketCodec_LZ4)
+  {
+    int ret = LZ4_decompress_safe((const char *)src, (char *)&decompressed[0], (int)srcLength,
+                                  (int)header.uncompressedLength);
+    success = (ret == (int)header.uncompressedLength);
+  }
+  else if(header.codec == ePacketCodec_Deflate)
+  {
+    mz_ulong destLen = (mz_ulong)header.uncompressedLength;
+    int ret = mz_uncompress(&decompressed[0], &destLen, src, (mz_ulong)srcLength);
+    success = (ret == MZ_OK && destLen == (mz_ulong)header.uncompressedLength);
+  }
+
+  if(!success)
+  {
+    RDCERR("Failed to decompress packet with codec %u (%u -> %u bytes)", header.codec, srcLength,
+           header.uncompressedLength);
+    return false;
+  }
+
+  payload.swap(decompressed);
+
+  return true;
+}
+
+uint32_t FileChunkChecksum(const byte *data, uint32_t length, uint32_t crc)
+{
+  return (uint32_t)mz_crc32((mz_ulong)crc, data, length);
+}
+
+// the start and end of the data are checksummed to check a partial file is from the same source,
+// without reading all of a multi-GB file on each side
+static uint32_t FileResumeChecksum(FILE *f, uint64_t offset)
+{
+  uint32_t headLength = (uint32_t)RDCMIN((uint64_t)FileChunkSize, offset);
+  uint32_t tailLength = (uint32_t)RDCMIN((uint64_t)FileChunkSize, offset - headLength);
+
+  vector<byte> buf(FileChunkSize);
+
+  FileIO::fseek64(f, 0, SEEK_SET);
+  if(FileIO::fread(&buf[0], 1, headLength, f) != headLength)
+    return 0;
+
+  uint32_t crc = FileChunkChecksum(&buf[0], headLength);
+
+  if(tailLength > 0)
+  {
+    FileIO::fseek64(f, offset - tailLength, SEEK_SET);
+    if(FileIO::fread(&buf[0], 1, tailLength, f) != tailLength)
+      return 0;
+
+    crc = FileChunkChecksum(&buf[0], tailLength, crc);
+  }
+
+  return crc;
+}
+
+uint64_t GetFileResumeOffset(const char *filename, uint32_t &checksum)
+{
+  checksum = 0;
+
+  FILE *f = FileIO::fopen(filename, "rb");
+
+  if(f == NULL)
+    return 0;
+
+  FileIO::fseek64(f, 0, SEEK_END);
+  uint64_t offset = FileIO::ftell64(f);
+
+  if(offset > 0)
+    checksum = FileResumeChecksum(f, offset);
+
+  FileIO::fclose(f);
+
+  return offset;
+}
+
+uint64_t VerifyFileResume(const char *filename, uint64_t offset, uint32_t checksum)
+{
+  if(offset == 0)
+    return 0;
+
+  FILE *f = FileIO::fopen(filename, "rb");
+
+  if(f == NULL)
+    return 0;
+
+  FileIO::fseek64(f, 0, SEEK_END);
+  uint64_t fileLen = FileIO::ftell64(f);
+
+  if(offset > fileLen || FileResumeChecksum(f, offset) != checksum)
+  {
+    RDCLOG("Partial copy of '%s' doesn't match, sending from the start", filename);
+    offset = 0;
+  }
+
+  FileIO::fclose(f);
+
+  return offset;
+}
+
+void GetFileTransferRange(uint64_t fileLen, uint64_t offset, uint32_t idx, uint32_t count,
+                          uint64_t &rangeOffset, uint64_t &rangeLength)
+{
+  offset = RDCMIN(offset, fileLen);
+  count = RDCMAX(count, 1U);
+
+  uint64_t numChunks = (fileLen - offset + FileChunkSize - 1) / FileChunkSize;
+
+  uint64_t firstChunk = numChunks * idx / count;
+  uint64_t lastChunk = numChunks * (idx + 1) / count;
+
+  rangeOffset = RDCMIN(fileLen, offset + firstChunk * FileChunkSize);
+  rangeLength = RDCMIN(fileLen, offset + lastChunk * FileChunkSize) - rangeOffset;
+}
+
+// precompressed chunks are stored in a file next to the capture, starting with this header and
+// followed by a table of numChunks+1 offsets to each chunk's payload. The magic is only written
+// once every chunk is, so a partially written file is never used.
+static const uint32_t PrecompressedChunksMagic = MAKE_FOURCC('R', 'D', 'P', 'C');
+
+struct PrecompressedChunksHeader
+{
+  uint32_t magic;
+  uint32_t chunkSize;
+  uint64_t fileLength;
+  uint64_t fileTimestamp;
+  uint32_t numChunks;
+  uint32_t padding;
+};
+
+// each chunk's payload is preceded by whether it's compressed, as incompressible chunks are stored
+// as-is
+struct PrecompressedChunkHeader
+{
+  uint32_t compressed;
+};
+
+static string GetPrecompressedChunksFilename(const char *logfile)
+{
+  return string(logfile) + ".chunks";
+}
+
+bool WritePrecompressedChunks(const char *logfile, const volatile bool *cancel)
+{
+  FILE *src = FileIO::fopen(logfile, "rb");
+
+  if(src == NULL)
+    return false;
+
+  FileIO::fseek64(src, 0, SEEK_END);
+  uint64_t fileLen = FileIO::ftell64(src);
+  FileIO::fseek64(src, 0, SEEK_SET);
+
+  string chunksFile = GetPrecompressedChunksFilename(logfile);
+
+  FILE *dst = FileIO::fopen(chunksFile.c_str(), "wb");
+
+  if(dst == NULL)
+  {
+    FileIO::fclose(src);
+    return false;
+  }
+
+  PrecompressedChunksHeader header = {};
+  header.chunkSize = FileChunkSize;
+  header.fileLength = fileLen;
+  header.fileTimestamp = FileIO::GetModifiedTimestamp(logfile);
+  header.numChunks = uint32_t((fileLen + FileChunkSize - 1) / FileChunkSize);
+
+  vector<uint64_t> offsets(header.numChunks + 1);
+
+  // placeholders for the header and table, filled in at the end
+  FileIO::fwrite(&header, 1, sizeof(header), dst);
+  FileIO::fwrite(&offsets[0], sizeof(uint64_t), offsets.size(), dst);
+
+  uint64_t pos = sizeof(header) + sizeof(uint64_t) * offsets.size();
+
+  vector<byte> payload(FileChunkSize + sizeof(uint32_t));
+  vector<byte> compressed;
+
+  uint64_t compressedSize = 0;
+  bool success = true;
+
+  for(uint32_t i = 0; i < header.numChunks; i++)
+  {
+    if(cancel && *cancel)
+    {
+      success = false;
+      break;
+    }
+
+    uint32_t chunkLength =
+        (uint32_t)RDCMIN((uint64_t)FileChunkSize, fileLen - uint64_t(i) * FileChunkSize);
+
+    if(FileIO::fread(&payload[0], 1, chunkLength, src) != chunkLength)
+    {
+      success = false;
+      break;
+    }
+
+    // the same payload SendChunkedFile would send, with the checksum of the uncompressed data
+    uint32_t checksum = FileChunkChecksum(&payload[0], chunkLength);
+    memcpy(&payload[chunkLength], &checksum, sizeof(checksum));
+
+    uint32_t payloadLength = chunkLength + sizeof(checksum);
+
+    PrecompressedChunkHeader chunkHeader = {0};
+    const byte *data = &payload[0];
+
+    if(CompressPacketPayload(&payload[0], payloadLength, ePacketCodec_Deflate, compressed, true) !=
+       ePacketCodec_None)
+    {
+      chunkHeader.compressed = 1;
+      data = &compressed[0];
+      payloadLength = (uint32_t)compressed.size();
+    }
+
+    offsets[i] = pos;
+
+    FileIO::fwrite(&chunkHeader, 1, sizeof(chunkHeader), dst);
+    FileIO::fwrite(data, 1, payloadLength, dst);
+
+    pos += sizeof(chunkHeader) + payloadLength;
+    compressedSize += payloadLength;
+  }
+
+  offsets[header.numChunks] = pos;
+
+  FileIO::fclose(src);
+
+  if(success)
+  {
+    header.magic = PrecompressedChunksMagic;
+
+    FileIO::fseek64(dst, 0, SEEK_SET);
+    FileIO::fwrite(&header, 1, sizeof(header), dst);
+    FileIO::fwrite(&offsets[0], sizeof(uint64_t), offsets.size(), dst);
+  }
+
+  FileIO::fclose(dst);
+
+  if(!success)
+  {
+    FileIO::Delete(chunksFile.c_str());
+    return false;
+  }
+
+  RDCLOG("Precompressed '%s' from %llu to %llu bytes", logfile, fileLen, compressedSize);
+
+  return true;
+}
+
+void DeletePrecompressedChunks(const char *logfile)
+{
+  string chunksFile = GetPrecompressedChunksFilename(logfile);
+
+  if(FileIO::exists(chunksFile.c_str()))
+    FileIO::Delete(chunksFile.c_str());
+}
+
+PrecompressedChunkReader::PrecompressedChunkReader(const char *logfile, uint64_t fileLen)
+    : m_File(NULL), m_FileLength(fileLen)
+{
+  string chunksFile = GetPrecompressedChunksFilename(logfile);
+
+  FILE *f = FileIO::fopen(chunksFile.c_str(), "rb");
+
+  if(f == NULL)
+    return;
+
+  PrecompressedChunksHeader header = {};
+
+  bool valid = FileIO::fread(&header, 1, sizeof(header), f) == sizeof(header) &&
+               header.magic == PrecompressedChunksMagic && header.chunkSize == FileChunkSize &&
+               header.fileLength == fileLen &&
+               header.fileTimestamp == FileIO::GetModifiedTimestamp(logfile) &&
+               header.numChunks == uint32_t((fileLen + FileChunkSize - 1) / FileChunkSize);
+
+  if(valid)
+  {
+    m_ChunkOffsets.resize(header.numChunks + 1);
+    valid = FileIO::fread(&m_ChunkOffsets[0], sizeof(uint64_t), m_ChunkOffsets.size(), f) ==
+            m_ChunkOffsets.size();
+  }
+
+  if(!valid)
+  {
+    RDCLOG("Precompressed chunks for '%s' are out of date, ignoring", logfile);
+    m_ChunkOffsets.clear();
+    FileIO::fclose(f);
+    return;
+  }
+
+  m_File = f;
+}
+
+PrecompressedChunkReader::~PrecompressedChunkReader()
+{
+  if(m_File)
+    FileIO::fclose(m_File);
+}
+
+bool PrecompressedChunkReader::ReadChunk(uint64_t offset, uint32_t length, vector<byte> &payload,
+                                         bool &compressed)
+{
+  if(m_File == NULL || (offset % FileChunkSize) != 0)
+    return false;
+
+  uint64_t idx = offset / FileChunkSize;
+
+  // only whole chunks match what was stored
+  if(idx + 1 >= m_ChunkOffsets.size() ||
+     length != (uint32_t)RDCMIN((uint64_t)FileChunkSize, m_FileLength - offset))
+    return false;
+
+  uint64_t storedLength = m_ChunkOffsets[idx + 1] - m_ChunkOffsets[idx];
+
+  PrecompressedChunkHeader chunkHeader = {0};
+
+  if(storedLength <= sizeof(chunkHeader))
+    return false;
+
+  FileIO::fseek64(m_File, m_ChunkOffsets[idx], SEEK_SET);
+
+  if(FileIO::fread(&chunkHeader, 1, sizeof(chunkHeader), m_File) != sizeof(chunkHeader))
+    return false;
+
+  payload.resize(size_t(storedLength - sizeof(chunkHeader)));
+
+  if(FileIO::fread(&payload[0], 1, payload.size(), m_File) != payload.size())
+    return false;
+
+  compressed = (chunkHeader.compressed != 0);
+
+  return true;
+}
@@ -25,6 +25,84 @@
 
 #pragma once
 
+#include "common/timing.h"
+
+// codecs that a packet's payload can be compressed with. Peers exchange a mask of the codecs they
+// accept in the handshake, and packets are only compressed with one of those.
+enum PacketCodec
+{
+  ePacketCodec_None = 0x0,
+  ePacketCodec_LZ4 = 0x1,
+  ePacketCodec_Deflate = 0x2,
+  ePacketCodec_All = ePacketCodec_LZ4 | ePacketCodec_Deflate,
+};
+
+// set on the packet type when the payload is compressed
+static const uint32_t PacketCompressedFlag = 0x80000000U;
+
+// payloads smaller than this go uncompressed, as they aren't worth the time to compress
+static const uint32_t PacketCompressionThreshold = 4 * 1024;
+
+// which codecs a client will accept compressed data in, from the remote.compression config
+// setting: "none" to disable compression, "lz4" or "deflate" to only use that codec, otherwise any.
+uint32_t GetAcceptedPacketCodecs();
+
+// compresses a payload with whichever accepted codec gives the best trade-off for its size, and
+// returns the codec used. If it returns ePacketCodec_None the payload should be sent as-is. With
+// strongest set the best ratio is preferred regardless of time, for compressing ahead of sending.
+PacketCodec CompressPacketPayload(const byte *data, uint32_t length, uint32_t acceptedCodecs,
+                                  vector<byte> &compressed, bool strongest = false);
+
+// decompresses a payload in place that was compressed with CompressPacketPayload
+bool DecompressPacketPayload(vector<byte> &payload);
+
+// files are sent in chunks of this size, each followed by a CRC-32 of its contents. A transfer that
+// fails partway leaves every verified chunk written, so it can be resumed from there.
+static const uint32_t FileChunkSize = 1024 * 1024;
+
+uint32_t FileChunkChecksum(const byte *data, uint32_t length, uint32_t crc = 0);
+
+// checks whether a partially received file can be resumed. Returns the offset to resume from, or
+// 0 if there's nothing to resume, with a checksum of the data that's already been received that
+// the sender can verify against its copy with VerifyFileResume.
+uint64_t GetFileResumeOffset(const char *filename, uint32_t &checksum);
+
+// returns offset if the first offset bytes of filename match the checksum, or 0 if it has to be
+// sent from the start
+uint64_t VerifyFileResume(const char *filename, uint64_t offset, uint32_t checksum);
+
+// a file can be pulled over several connections at once, each sending its own range of chunks
+static const uint32_t MaxFileTransferStreams = 8;
+
+// splits the data after offset into count ranges of whole chunks, and returns range idx. Ranges at
+// the end can be empty if there are fewer chunks than ranges.
+void GetFileTransferRange(uint64_t fileLen, uint64_t offset, uint32_t idx, uint32_t count,
+                          uint64_t &rangeOffset, uint64_t &rangeLength);
+
+// compresses every chunk of a finished capture with the strongest codec into a file alongside it,
+// so that SendChunkedFile can send them without compressing on the fly. This is worth doing on
+// devices with slow links, where idle CPU time after capturing is cheaper than the transfer.
+// Stops early and leaves nothing behind if cancel is set.
+bool WritePrecompressedChunks(const char *logfile, const volatile bool *cancel);
+void DeletePrecompressedChunks(const char *logfile);
+
+// reads back chunks written by WritePrecompressedChunks, if they're present and up to date
+class PrecompressedChunkReader
+{
+public:
+  PrecompressedChunkReader(const char *logfile, uint64_t fileLen);
+  ~PrecompressedChunkReader();
+
+  // returns the payload for the chunk at offset with its checksum, compressed with a codec if
+  // compressed is set. Returns false if the chunk isn't available and has to be read directly.
+  bool ReadChunk(uint64_t offset, uint32_t length, vector<byte> &payload, bool &compressed);
+
+private:
+  FILE *m_File;
+  uint64_t m_FileLength;
+  vector<uint64_t> m_ChunkOffsets;
+};
+
 inline uint32_t RecvPacket(Network::Socket *sock)
 {
   if(sock == NULL)
@@ -59,6 +137,14 @@ bool RecvPacket(Network::Socket *sock, PacketTypeEnum &type, vector<byte> &paylo
       return false;
   }
 
+  if(t & PacketCompressedFlag)
+  {
+    t &= ~PacketCompressedFlag;
+
+    if(!DecompressPacketPayload(payload))
+      return false;
+  }
+
   type = (PacketTypeEnum)t;
 
   return true;
@@ -103,17 +189,40 @@ bool SendPacket(Network::Socket *sock, PacketTypeEnum type, const Serialiser &se
     return false;
 
   uint32_t t = (uint32_t)type;
-  if(!sock->SendDataBlocking(&t, sizeof(t)))
+  uint32_t payloadLength = ser.GetOffset() & 0xffffffff;
+
+  // send the header and payload together so small packets go out in one segment
+  Network::SendBuffer bufs[] = {
+      {&t, sizeof(t)}, {&payloadLength, sizeof(payloadLength)}, {ser.GetRawPtr(0), payloadLength},
+  };
+
+  return sock->SendDataBlocking(bufs, ARRAY_COUNT(bufs));
+}
+
+// sends the serialiser's contents compressed with one of the accepted codecs from the handshake,
+// if it's large enough and compressible. RecvPacket decompresses it transparently.
+template <typename PacketTypeEnum>
+bool SendCompressedPacket(Network::Socket *sock, PacketTypeEnum type, const Serialiser &ser,
+                          uint32_t acceptedCodecs)
+{
+  if(sock == NULL)
     return false;
 
   uint32_t payloadLength = ser.GetOffset() & 0xffffffff;
-  if(!sock->SendDataBlocking(&payloadLength, sizeof(payloadLength)))
-    return false;
 
-  if(!sock->SendDataBlocking(ser.GetRawPtr(0), payloadLength))
-    return false;
+  vector<byte> compressed;
+  if(CompressPacketPayload(ser.GetRawPtr(0), payloadLength, acceptedCodecs, compressed) ==
+     ePacketCodec_None)
+    return SendPacket(sock, type, ser);
 
-  return true;
+  uint32_t t = (uint32_t)type | PacketCompressedFlag;
+  payloadLength = (uint32_t)compressed.size();
+
+  Network::SendBuffer bufs[] = {
+      {&t, sizeof(t)}, {&payloadLength, sizeof(payloadLength)}, {&compressed[0], payloadLength},
+  };
+
+  return sock->SendDataBlocking(bufs, ARRAY_COUNT(bufs));
 }
 
 template <typename PacketTypeEnum>
@@ -135,27 +244,36 @@ bool RecvChunkedFile(Network::Socket *sock, PacketTypeEnum packetType, const cha
   ser = new Serialiser(payload.size(), &payload[0], false);
 
   uint64_t fileLength;
+  uint64_t offset;
   uint32_t bufLength;
   uint32_t numBuffers;
 
   uint64_t sz = ser->GetSize();
-  ser->SetOffset(sz - sizeof(uint64_t) - sizeof(uint32_t) * 2);
+  ser->SetOffset(sz - sizeof(uint64_t) * 2 - sizeof(uint32_t) * 2);
 
   ser->Serialise("", fileLength);
+  ser->Serialise("", offset);
   ser->Serialise("", bufLength);
   ser->Serialise("", numBuffers);
 
   ser->SetOffset(0);
 
-  FILE *f = FileIO::fopen(logfile, "wb");
+  // when resuming, the data up to offset is already in the file
+  FILE *f = FileIO::fopen(logfile, offset > 0 ? "ab" : "wb");
 
   if(f == NULL)
   {
     return false;
   }
 
+  if(offset > 0)
+    RDCLOG("Resuming transfer of '%s' at %llu of %llu bytes", logfile, offset, fileLength);
+
   if(progress)
-    *progress = 0.0001f;
+    *progress = RDCMAX(0.0001f, float(double(offset) / double(RDCMAX(fileLength, (uint64_t)1))));
+
+  PerformanceTimer timer;
+  uint64_t received = 0;
 
   for(uint32_t i = 0; i < numBuffers; i++)
   {
@@ -165,26 +283,49 @@ bool RecvChunkedFile(Network::Socket *sock, PacketTypeEnum packetType, const cha
       return false;
     }
 
-    if(type != packetType)
+    if(type != packetType || payload.size() < sizeof(uint32_t))
     {
       FileIO::fclose(f);
       return false;
     }
 
-    FileIO::fwrite(&payload[0], 1, payload.size(), f);
+    uint32_t chunkLength = uint32_t(payload.size() - sizeof(uint32_t));
+
+    uint32_t checksum = 0;
+    memcpy(&checksum, &payload[chunkLength], sizeof(checksum));
+
+    // stop before writing a corrupt chunk, so the file can be resumed from the last good one
+    if(checksum != FileChunkChecksum(&payload[0], chunkLength))
+    {
+      RDCERR("Checksum mismatch in chunk %u of '%s'", i, logfile);
+      FileIO::fclose(f);
+      return false;
+    }
+
+    FileIO::fwrite(&payload[0], 1, chunkLength, f);
+
+    received += chunkLength;
 
     if(progress)
-      *progress = float(i + 1) / float(numBuffers);
+      *progress = float(double(offset + received) / double(fileLength));
   }
 
   FileIO::fclose(f);
 
+  double seconds = timer.GetMilliseconds() / 1000.0;
+  if(seconds > 0.0)
+    RDCLOG("Received %.2f MB in %.2fs (%.2f MB/s)", double(received) / (1024.0 * 1024.0), seconds,
+           double(received) / (1024.0 * 1024.0) / seconds);
+
   return true;
 }
 
+// sends up to length bytes of the file starting at offset. Chunks are compressed with one of the
+// accepted codecs if there are any, using precompressed chunks where they've been prepared.
 template <typename PacketTypeEnum>
 bool SendChunkedFile(Network::Socket *sock, PacketTypeEnum type, const char *logfile,
-                     Serialiser &ser, float *progress)
+                     Serialiser &ser, float *progress, uint64_t offset = 0,
+                     uint64_t length = ~0ULL, uint32_t acceptedCodecs = ePacketCodec_None)
 {
   if(sock == NULL)
     return false;
@@ -198,15 +339,21 @@ bool SendChunkedFile(Network::Socket *sock, PacketTypeEnum type, const char *log
 
   FileIO::fseek64(f, 0, SEEK_END);
   uint64_t fileLen = FileIO::ftell64(f);
-  FileIO::fseek64(f, 0, SEEK_SET);
 
-  uint32_t bufLen = (uint32_t)RDCMIN((uint64_t)4 * 1024 * 1024, fileLen);
-  uint64_t n = fileLen / (uint64_t)bufLen;
+  offset = RDCMIN(offset, fileLen);
+  FileIO::fseek64(f, offset, SEEK_SET);
+
+  uint64_t remaining = RDCMIN(fileLen - offset, length);
+  uint64_t end = offset + remaining;
+
+  uint32_t bufLen = (uint32_t)RDCMAX((uint64_t)1, RDCMIN((uint64_t)FileChunkSize, remaining));
+  uint64_t n = remaining / (uint64_t)bufLen;
   uint32_t numBufs = (uint32_t)n;
-  if(fileLen % (uint64_t)bufLen > 0)
+  if(remaining % (uint64_t)bufLen > 0)
     numBufs++;    // last remaining buffer
 
   ser.Serialise("", fileLen);
+  ser.Serialise("", offset);
   ser.Serialise("", bufLen);
   ser.Serialise("", numBufs);
 
@@ -220,32 +367,68 @@ bool SendChunkedFile(Network::Socket *sock, PacketTypeEnum type, const char *log
 
   uint32_t t = (uint32_t)type;
 
+  PrecompressedChunkReader *precompressed = NULL;
+  if(acceptedCodecs & ePacketCodec_Deflate)
+    precompressed = new PrecompressedChunkReader(logfile, fileLen);
+
+  vector<byte> payload, compressed;
+
   if(progress)
-    *progress = 0.0001f;
+    *progress = RDCMAX(0.0001f, float(double(offset) / double(RDCMAX(fileLen, (uint64_t)1))));
 
   for(uint32_t i = 0; i < numBufs; i++)
   {
-    uint32_t payloadLength = RDCMIN(bufLen, (uint32_t)(fileLen & 0xffffffff));
+    uint32_t chunkLength = (uint32_t)RDCMIN((uint64_t)bufLen, remaining);
+    uint64_t chunkOffset = end - remaining;
 
-    FileIO::fread(buf, 1, payloadLength, f);
+    bool isCompressed = false;
 
-    if(!sock->SendDataBlocking(&t, sizeof(t)) ||
-       !sock->SendDataBlocking(&payloadLength, sizeof(payloadLength)) ||
-       !sock->SendDataBlocking(buf, payloadLength))
+    if(precompressed && precompressed->ReadChunk(chunkOffset, chunkLength, payload, isCompressed))
     {
-      break;
+      FileIO::fseek64(f, chunkOffset + chunkLength, SEEK_SET);
+    }
+    else
+    {
+      FileIO::fread(buf, 1, chunkLength, f);
+
+      uint32_t checksum = FileChunkChecksum(buf, chunkLength);
+
+      payload.resize(chunkLength + sizeof(checksum));
+      memcpy(&payload[0], buf, chunkLength);
+      memcpy(&payload[chunkLength], &checksum, sizeof(checksum));
+
+      if(acceptedCodecs != ePacketCodec_None &&
+         CompressPacketPayload(&payload[0], (uint32_t)payload.size(), acceptedCodecs,
+                               compressed) != ePacketCodec_None)
+      {
+        payload.swap(compressed);
+        isCompressed = true;
+      }
     }
 
-    fileLen -= payloadLength;
+    uint32_t chunkType = isCompressed ? (t | PacketCompressedFlag) : t;
+    uint32_t payloadLength = (uint32_t)payload.size();
+
+    Network::SendBuffer bufs[] = {
+        {&chunkType, sizeof(chunkType)},
+        {&payloadLength, sizeof(payloadLength)},
+        {&payload[0], payloadLength},
+    };
+
+    if(!sock->SendDataBlocking(bufs, ARRAY_COUNT(bufs)))
+      break;
+
+    remaining -= chunkLength;
     if(progress)
-      *progress = float(i + 1) / float(numBufs);
+      *progress = float(double(end - remaining) / double(fileLen));
   }
 
   delete[] buf;
+  delete precompressed;
 
   FileIO::fclose(f);
 
-  if(fileLen != 0)
+  if(remaining != 0)
   {
     return false;
   }
@@ -42,14 +42,149 @@ enum PacketType
   ePacket_DeleteCapture,
   ePacket_QueueCapture,
   ePacket_NewChild,
+  ePacket_CaptureProgress,
+  ePacket_APICallStats,
+  ePacket_CaptureStreamData,
+  ePacket_CaptureStreamEnd,
+  ePacket_Telemetry,
 };
 
+// at most this much of a capture being written is streamed to the client per tick, so that other
+// packets aren't held up behind a large capture
+static const uint64_t MaxStreamPerTick = 8 * 1024 * 1024;
+
+// sends the next part of the capture file being written to the client. streamSent is how far
+// through the file has been sent so far. Returns false if the connection was lost.
+static bool StreamCaptureData(Network::Socket *client, const string &path, uint64_t start,
+                              uint64_t end, bool complete, uint64_t &streamSent)
+{
+  if(streamSent >= end && !complete)
+    return true;
+
+  FILE *f = FileIO::fopen(path.c_str(), "rb");
+
+  if(f == NULL)
+    return true;
+
+  string fullpath = FileIO::GetFullPathname(path);
+
+  vector<byte> buf;
+
+  uint64_t limit = RDCMIN(end, streamSent + MaxStreamPerTick);
+
+  bool ret = true;
+
+  while(streamSent < limit)
+  {
+    size_t len = (size_t)RDCMIN(limit - streamSent, (uint64_t)FileChunkSize);
+    buf.resize(len);
+
+    FileIO::fseek64(f, streamSent, SEEK_SET);
+    if(FileIO::fread(&buf[0], 1, len, f) != len)
+      break;
+
+    Serialiser ser("", Serialiser::WRITING, false);
+
+    ser.Serialise("", fullpath);
+    ser.Serialise("", streamSent);
+
+    byte *data = &buf[0];
+    ser.SerialiseBuffer("", data, len);
+
+    if(!SendPacket(client, ePacket_CaptureStreamData, ser))
+    {
+      ret = false;
+      break;
+    }
+
+    streamSent += len;
+  }
+
+  // once the file is complete, the header that was fixed up at the end is sent last
+  if(ret && complete && streamSent == end && start > 0)
+  {
+    buf.resize((size_t)start);
+
+    FileIO::fseek64(f, 0, SEEK_SET);
+    if(FileIO::fread(&buf[0], 1, buf.size(), f) == buf.size())
+    {
+      Serialiser ser("", Serialiser::WRITING, false);
+
+      uint64_t offs = 0;
+      ser.Serialise("", fullpath);
+      ser.Serialise("", offs);
+
+      byte *data = &buf[0];
+      size_t len = buf.size();
+      ser.SerialiseBuffer("", data, len);
+
+      ret = SendPacket(client, ePacket_CaptureStreamData, ser);
+    }
+  }
+
+  FileIO::fclose(f);
+
+  return ret;
+}
+
+// a connection opened by the client only to pull one range of a capture, in parallel with the rest
+// being sent over the main connection
+struct CaptureTransfer
+{
+  Network::Socket *sock;
+  string path;
+  uint32_t range, streams, codecs;
+  Threading::ThreadHandle thread;
+  volatile bool done;
+};
+
+static void CaptureTransferThread(void *s)
+{
+  Threading::KeepModuleAlive();
+
+  CaptureTransfer *transfer = (CaptureTransfer *)s;
+
+  FILE *f = FileIO::fopen(transfer->path.c_str(), "rb");
+
+  uint64_t fileLen = 0;
+
+  if(f)
+  {
+    FileIO::fseek64(f, 0, SEEK_END);
+    fileLen = FileIO::ftell64(f);
+    FileIO::fclose(f);
+  }
+
+  uint64_t offset = 0, length = 0;
+  GetFileTransferRange(fileLen, 0, transfer->range, transfer->streams, offset, length);
+
+  Serialiser ser("", Serialiser::WRITING, false);
+
+  if(!SendChunkedFile(transfer->sock, ePacket_CopyCapture, transfer->path.c_str(), ser, NULL,
+                      offset, length, transfer->codecs))
+    RDCERR("Failed to send range %u of '%s'", transfer->range, transfer->path.c_str());
+
+  SAFE_DELETE(transfer->sock);
+
+  transfer->done = true;
+
+  Threading::ReleaseModuleExitThread();
+}
+
 void RenderDoc::TargetControlClientThread(void *s)
 {
   Threading::KeepModuleAlive();
 
   Network::Socket *client = (Network::Socket *)s;
 
+  bool streamCaptures = false;
+  uint32_t codecs = ePacketCodec_None;
+  {
+    SCOPED_LOCK(RenderDoc::Inst().m_SingleClientLock);
+    streamCaptures = RenderDoc::Inst().m_SingleClientStreamCaptures;
+    codecs = RenderDoc::Inst().m_SingleClientCodecs;
+  }
+
   Serialiser ser("", Serialiser::WRITING, false);
 
   string api = "";
@@ -79,10 +214,26 @@ void RenderDoc::TargetControlClientThread(void *s)
 
   const int pingtime = 1000;    // ping every 1000ms
   const int ticktime = 10;      // tick every 10ms
+  const size_t maxCallStats = 32;
   int curtime = 0;
 
   vector<CaptureData> captures;
   vector<pair<uint32_t, uint32_t> > children;
+  float sentProgress = -1.0f;
+
+  // API call stats follow straight after each telemetry packet, when they're being recorded
+  bool callStatsPending = false;
+  double sentAPIMilliseconds = 0.0;
+
+  // captures are only streamed if they start being written after this client connected
+  string streamPath, streamedPath;
+  uint64_t streamSent = 0;
+  bool streamDone = true;
+
+  {
+    SCOPED_LOCK(RenderDoc::Inst().m_CaptureWriteStream.lock);
+    streamPath = RenderDoc::Inst().m_CaptureWriteStream.filename;
+  }
 
   while(client)
   {
@@ -104,6 +255,77 @@ void RenderDoc::TargetControlClientThread(void *s)
 
     vector<CaptureData> caps = RenderDoc::Inst().GetCaptures();
     vector<pair<uint32_t, uint32_t> > childprocs = RenderDoc::Inst().GetChildProcesses();
+    float writeProgress = RenderDoc::Inst().GetCaptureWriteProgress();
+
+    if(streamCaptures)
+    {
+      CaptureWriteStream &stream = RenderDoc::Inst().m_CaptureWriteStream;
+
+      string path;
+      uint64_t start = 0, end = 0;
+      bool complete = false, failed = false;
+
+      {
+        SCOPED_LOCK(stream.lock);
+        path = stream.filename;
+        start = stream.stableStart;
+        end = stream.stableEnd;
+        complete = stream.complete;
+        failed = stream.failed;
+      }
+
+      if(path != streamPath)
+      {
+        streamPath = path;
+        streamSent = 0;
+        streamDone = false;
+      }
+
+      if(!streamDone && start > 0)
+      {
+        // start sending after the header, which is written last
+        streamSent = RDCMAX(streamSent, start);
+
+        if(!failed && !StreamCaptureData(client, streamPath, start, end, complete, streamSent))
+        {
+          SAFE_DELETE(client);
+          continue;
+        }
+
+        if(complete && (failed || streamSent == end))
+        {
+          ser.Rewind();
+
+          string fullpath = FileIO::GetFullPathname(streamPath);
+          bool32 success = failed ? 0 : 1;
+          ser.Serialise("", fullpath);
+          ser.Serialise("", end);
+          ser.Serialise("", success);
+
+          if(!SendPacket(client, ePacket_CaptureStreamEnd, ser))
+          {
+            SAFE_DELETE(client);
+            continue;
+          }
+
+          ser.Rewind();
+
+          if(!failed)
+            streamedPath = streamPath;
+
+          streamDone = true;
+        }
+      }
+      else if(!streamDone && complete)
+      {
+        // failed before anything was written
+        streamDone = true;
+      }
+    }
+
+    // start again for the next capture written
+    if(writeProgress < 0.0f)
+      sentProgress = -1.0f;
 
     if(curapi != api)
     {
@@ -113,7 +335,7 @@ void RenderDoc::TargetControlClientThread(void *s)
 
       packetType = ePacket_RegisterAPI;
     }
-    else if(caps.size() != captures.size())
+    else if(caps.size() != captures.size() && (streamDone || !streamCaptures))
     {
       uint32_t idx = (uint32_t)captures.size();
 
@@ -121,8 +343,15 @@ void RenderDoc::TargetControlClientThread(void *s)
 
       packetType = ePacket_NewCapture;
 
+      // the client is given the path and may open it directly, so it has to exist
+      RenderDoc::Inst().EnsureCaptureFile(idx);
+
       std::string path = FileIO::GetFullPathname(captures.back().path);
 
+      // the client has its own copy, so this one can be cleaned up as if it had been copied
+      if(captures.back().path == streamedPath)
+        RenderDoc::Inst().MarkCaptureRetrieved(idx);
+
       ser.Serialise("", idx);
       ser.Serialise("", captures.back().timestamp);
       ser.Serialise("", path);
@@ -151,6 +380,71 @@ void RenderDoc::TargetControlClientThread(void *s)
       ser.Serialise("", children.back().first);
       ser.Serialise("", children.back().second);
     }
+    else if(writeProgress >= 0.0f && writeProgress >= sentProgress + 0.01f)
+    {
+      sentProgress = writeProgress;
+
+      packetType = ePacket_CaptureProgress;
+
+      ser.Serialise("", writeProgress);
+    }
+    else if(callStatsPending)
+    {
+      callStatsPending = false;
+
+      packetType = ePacket_APICallStats;
+
+      vector<APICallStat> stats = APICallCounter::GetStats(maxCallStats);
+
+      uint32_t numStats = (uint32_t)stats.size();
+      ser.Serialise("", numStats);
+
+      for(uint32_t i = 0; i < numStats; i++)
+      {
+        string name = stats[i].name.c_str();
+        ser.Serialise("", name);
+        ser.Serialise("", stats[i].count);
+        ser.Serialise("", stats[i].milliseconds);
+      }
+    }
+    else if(curtime >= pingtime)
+    {
+      // send the latest telemetry in place of the regular ping
+      packetType = ePacket_Telemetry;
+
+      const FrameTimer &timer = RenderDoc::Inst().m_FrameTimer;
+
+      TargetTelemetry telemetry;
+      telemetry.frameTimeMin = timer.GetMinFrameTime();
+      telemetry.frameTimeAvg = timer.GetAvgFrameTime();
+      telemetry.frameTimeMax = timer.GetMaxFrameTime();
+      telemetry.apiMilliseconds = 0.0;
+      telemetry.liveChunks = Chunk::NumLiveChunks();
+      telemetry.chunkBytes = Chunk::TotalMem();
+      telemetry.bufferBytes = Serialiser::AlignedBufferBytes();
+
+      if(APICallCounter::Enabled())
+      {
+        // the counters start again from zero whenever they're re-enabled
+        double total = APICallCounter::GetTotalMilliseconds();
+        telemetry.apiMilliseconds = RDCMAX(0.0, total - sentAPIMilliseconds);
+        sentAPIMilliseconds = total;
+
+        callStatsPending = true;
+      }
+      else
+      {
+        sentAPIMilliseconds = 0.0;
+      }
+
+      ser.Serialise("", telemetry.frameTimeMin);
+      ser.Serialise("", telemetry.frameTimeAvg);
+      ser.Serialise("", telemetry.frameTimeMax);
+      ser.Serialise("", telemetry.apiMilliseconds);
+      ser.Serialise("", telemetry.liveChunks);
+      ser.Serialise("", telemetry.chunkBytes);
+      ser.Serialise("", telemetry.bufferBytes);
+    }
 
     if(curtime < pingtime && packetType == ePacket_Noop)
     {
@@ -194,11 +488,16 @@ void RenderDoc::TargetControlClientThread(void *s)
           caps = RenderDoc::Inst().GetCaptures();
 
           uint32_t id = 0;
+          uint32_t streams = 1;
           recvser->Serialise("", id);
+          recvser->Serialise("", streams);
+
+          streams = RDCCLAMP(streams, 1U, MaxFileTransferStreams);
 
           if(id < caps.size())
           {
             ser.Serialise("", id);
+            ser.Serialise("", streams);
 
             if(!SendPacket(client, ePacket_CopyCapture, ser))
             {
@@ -208,7 +507,25 @@ void RenderDoc::TargetControlClientThread(void *s)
 
             ser.Rewind();
 
-            if(!SendChunkedFile(client, ePacket_CopyCapture, caps[id].path.c_str(), ser, NULL))
+            // with several streams the client pulls the other ranges over their own connections,
+            // and only the first is sent here
+            uint64_t fileLen = 0, offset = 0, length = ~0ULL;
+
+            if(streams > 1)
+            {
+              FILE *f = FileIO::fopen(caps[id].path.c_str(), "rb");
+              if(f)
+              {
+                FileIO::fseek64(f, 0, SEEK_END);
+                fileLen = FileIO::ftell64(f);
+                FileIO::fclose(f);
+              }
+
+              GetFileTransferRange(fileLen, 0, 0, streams, offset, length);
+            }
+
+            if(!SendChunkedFile(client, ePacket_CopyCapture, caps[id].path.c_str(), ser, NULL,
+                                offset, length, codecs))
             {
               SAFE_DELETE(client);
               continue;
@@ -252,12 +569,27 @@ void RenderDoc::TargetControlServerThread(void *s)
 
   Threading::ThreadHandle clientThread = 0;
 
+  vector<CaptureTransfer *> transfers;
+
   RenderDoc::Inst().m_ControlClientThreadShutdown = false;
 
   while(!RenderDoc::Inst().m_TargetControlThreadShutdown)
   {
     Network::Socket *client = sock->AcceptClient(false);
 
+    // reap any finished transfers
+    for(size_t i = 0; i < transfers.size(); i++)
+    {
+      if(transfers[i]->done)
+      {
+        Threading::JoinThread(transfers[i]->thread);
+        Threading::CloseThread(transfers[i]->thread);
+        delete transfers[i];
+        transfers.erase(transfers.begin() + i);
+        break;
+      }
+    }
+
     if(client == NULL)
     {
       if(!sock->Connected())
@@ -277,6 +609,10 @@ void RenderDoc::TargetControlServerThread(void *s)
     string existingClient;
     string newClient;
     bool kick = false;
+    bool streamCaptures = false;
+    uint32_t codecs = ePacketCodec_None;
+    uint32_t transferCapture = ~0U;
+    uint32_t transferRange = 0, transferStreams = 1;
 
     // receive handshake from client and get its name
     {
@@ -298,6 +634,11 @@ void RenderDoc::TargetControlServerThread(void *s)
 
       ser->SerialiseString("", newClient);
       ser->Serialise("", kick);
+      ser->Serialise("", streamCaptures);
+      ser->Serialise("", codecs);
+      ser->Serialise("", transferCapture);
+      ser->Serialise("", transferRange);
+      ser->Serialise("", transferStreams);
 
       SAFE_DELETE(ser);
 
@@ -308,6 +649,32 @@ void RenderDoc::TargetControlServerThread(void *s)
       }
     }
 
+    // transfer connections don't claim client status, they just send their range and close
+    if(transferCapture != ~0U)
+    {
+      vector<CaptureData> caps = RenderDoc::Inst().GetCaptures();
+
+      if(transferCapture >= caps.size() || transferStreams > MaxFileTransferStreams ||
+         transferRange >= transferStreams)
+      {
+        SAFE_DELETE(client);
+        continue;
+      }
+
+      CaptureTransfer *transfer = new CaptureTransfer();
+      transfer->sock = client;
+      transfer->path = caps[transferCapture].path;
+      transfer->range = transferRange;
+      transfer->streams = transferStreams;
+      transfer->codecs = codecs & ePacketCodec_All;
+      transfer->done = false;
+      transfer->thread = Threading::CreateThread(CaptureTransferThread, transfer);
+
+      transfers.push_back(transfer);
+
+      continue;
+    }
+
     // see if we have a client
     {
       SCOPED_LOCK(RenderDoc::Inst().m_SingleClientLock);
@@ -329,6 +696,8 @@ void RenderDoc::TargetControlServerThread(void *s)
     {
       SCOPED_LOCK(RenderDoc::Inst().m_SingleClientLock);
       RenderDoc::Inst().m_SingleClientName = newClient;
+      RenderDoc::Inst().m_SingleClientStreamCaptures = streamCaptures;
+      RenderDoc::Inst().m_SingleClientCodecs = codecs & ePacketCodec_All;
     }
 
     // if we've claimed client status, spawn a thread to communicate
@@ -365,29 +734,133 @@ void RenderDoc::TargetControlServerThread(void *s)
   Threading::CloseThread(clientThread);
   clientThread = 0;
 
+  // likewise any transfers still running are left to finish on their own
+  for(size_t i = 0; i < transfers.size(); i++)
+    Threading::CloseThread(transfers[i]->thread);
+
   SAFE_DELETE(sock);
 
   Threading::ReleaseModuleExitThread();
 }
 
+static bool SendTargetControlHandshake(Network::Socket *sock, string clientName,
+                                       bool forceConnection, bool streamCaptures, uint32_t codecs,
+                                       uint32_t transferCapture, uint32_t transferRange,
+                                       uint32_t transferStreams)
+{
+  Serialiser ser("", Serialiser::WRITING, false);
+
+  ser.SerialiseString("", clientName);
+  ser.Serialise("", forceConnection);
+  ser.Serialise("", streamCaptures);
+  ser.Serialise("", codecs);
+  ser.Serialise("", transferCapture);
+  ser.Serialise("", transferRange);
+  ser.Serialise("", transferStreams);
+
+  return SendPacket(sock, ePacket_Handshake, ser);
+}
+
+// one range of a capture being copied, pulled over its own connection into a separate file that's
+// appended to the capture once every range has arrived
+struct CaptureRangeTransfer
+{
+  string host;
+  uint16_t port;
+  string clientName;
+  uint32_t codecs;
+  uint32_t id, range, streams;
+  string path;
+  bool success;
+  Threading::ThreadHandle thread;
+};
+
+static void CaptureRangeTransferThread(void *s)
+{
+  CaptureRangeTransfer *transfer = (CaptureRangeTransfer *)s;
+
+  transfer->success = false;
+
+  Network::Socket *sock = Network::CreateClientSocket(transfer->host.c_str(), transfer->port, 750);
+
+  if(sock == NULL)
+    return;
+
+  if(SendTargetControlHandshake(sock, transfer->clientName, false, false, transfer->codecs,
+                                transfer->id, transfer->range, transfer->streams))
+  {
+    Serialiser *ser = NULL;
+
+    transfer->success =
+        RecvChunkedFile(sock, ePacket_CopyCapture, transfer->path.c_str(), ser, NULL);
+
+    SAFE_DELETE(ser);
+  }
+
+  SAFE_DELETE(sock);
+}
+
+static bool AppendFileContents(const char *dst, const char *src)
+{
+  FILE *in = FileIO::fopen(src, "rb");
+  FILE *out = FileIO::fopen(dst, "ab");
+
+  bool success = (in != NULL && out != NULL);
+
+  vector<byte> buf(FileChunkSize);
+
+  while(success)
+  {
+    size_t read = FileIO::fread(&buf[0], 1, buf.size(), in);
+
+    if(read == 0)
+      break;
+
+    success = (FileIO::fwrite(&buf[0], 1, read, out) == read);
+  }
+
+  if(in)
+    FileIO::fclose(in);
+  if(out)
+    FileIO::fclose(out);
+
+  return success;
+}
+
 struct TargetControl : public ITargetControl
 {
 public:
-  TargetControl(Network::Socket *sock, string clientName, bool forceConnection, bool localhost)
-      : m_Socket(sock), m_Local(localhost)
+  TargetControl(Network::Socket *sock, const string &host, uint16_t port, string clientName,
+                bool forceConnection, bool localhost, bool android)
+      : m_Socket(sock), m_Local(localhost), m_Host(host), m_Port(port), m_ClientName(clientName)
   {
     PacketType type;
     vector<byte> payload;
 
     m_PID = 0;
+    m_StreamFile = NULL;
+    m_StreamCount = 0;
+
+    m_Codecs = localhost ? (uint32_t)ePacketCodec_None : GetAcceptedPacketCodecs();
 
+    // adb forwards each connection separately over a slow link, so captures on android devices are
+    // pulled over several connections at once
+    m_TransferStreams = 1;
+    if(android)
     {
-      Serialiser ser("", Serialiser::WRITING, false);
+      string setting = RenderDoc::Inst().GetConfigSetting("targetcontrol.transferStreams");
+      m_TransferStreams = setting.empty() ? 4 : (uint32_t)atoi(setting.c_str());
+      m_TransferStreams = RDCCLAMP(m_TransferStreams, 1U, MaxFileTransferStreams);
+    }
 
-      ser.SerialiseString("", clientName);
-      ser.Serialise("", forceConnection);
+    {
+      // local targets' captures can be opened in place, so there's no point streaming them
+      bool streamCaptures =
+          !localhost &&
+          RenderDoc::Inst().GetConfigSetting("targetcontrol.streamCaptures") != "0";
 
-      if(!SendPacket(m_Socket, ePacket_Handshake, ser))
+      if(!SendTargetControlHandshake(m_Socket, clientName, forceConnection, streamCaptures,
+                                     m_Codecs, ~0U, 0, 1))
       {
         SAFE_DELETE(m_Socket);
         return;
@@ -429,6 +902,7 @@ public:
   void Shutdown()
   {
     SAFE_DELETE(m_Socket);
+    CloseStream(false);
     delete this;
   }
 
@@ -467,6 +941,7 @@ public:
     Serialiser ser("", Serialiser::WRITING, false);
 
     ser.Serialise("", remoteID);
+    ser.Serialise("", m_TransferStreams);
 
     if(!SendPacket(m_Socket, ePacket_CopyCapture, ser))
     {
@@ -554,13 +1029,25 @@ public:
       {
         msg.Type = TargetControlMessageType::CaptureCopied;
 
+        uint32_t streams = 1;
+
         ser->Serialise("", msg.NewCapture.ID);
+        ser->Serialise("", streams);
 
         SAFE_DELETE(ser);
 
         msg.NewCapture.path = m_CaptureCopies[msg.NewCapture.ID];
 
-        if(!RecvChunkedFile(m_Socket, ePacket_CopyCapture, msg.NewCapture.path.elems, ser, NULL))
+        vector<CaptureRangeTransfer *> transfers =
+            StartRangeTransfers(msg.NewCapture.ID, streams, msg.NewCapture.path.elems);
+
+        bool success =
+            RecvChunkedFile(m_Socket, ePacket_CopyCapture, msg.NewCapture.path.elems, ser, NULL);
+
+        // always wait for the other ranges, even if this one failed, so their files are cleaned up
+        success = FinishRangeTransfers(transfers, msg.NewCapture.path.elems, success);
+
+        if(!success)
         {
           SAFE_DELETE(ser);
           SAFE_DELETE(m_Socket);
@@ -600,6 +1087,15 @@ public:
         msg.NewCapture.path = path;
         msg.NewCapture.local = m_Local;
 
+        // if it was streamed while being written, we already have our own copy
+        auto streamed = m_StreamedCaptures.find(path);
+        if(streamed != m_StreamedCaptures.end())
+        {
+          msg.NewCapture.path = streamed->second;
+          msg.NewCapture.local = true;
+          m_StreamedCaptures.erase(streamed);
+        }
+
         int32_t thumblen = 0;
         ser->Serialise("", thumblen);
 
@@ -616,6 +1112,130 @@ public:
 
         return msg;
       }
+      else if(type == ePacket_CaptureStreamData)
+      {
+        string path;
+        uint64_t offset = 0;
+        ser->Serialise("", path);
+        ser->Serialise("", offset);
+
+        if(path != m_StreamRemotePath)
+        {
+          CloseStream(false);
+
+          string dummy, dummy2;
+          FileIO::GetDefaultFiles("remotestream", m_StreamLocalPath, dummy, dummy2);
+
+          // the default name only has minutes resolution, so make it unique
+          m_StreamLocalPath = m_StreamLocalPath.substr(0, m_StreamLocalPath.length() - 4) +
+                              StringFormat::Fmt("_%u_%u.rdc", m_PID, m_StreamCount++);
+
+          FileIO::CreateParentDirectory(m_StreamLocalPath);
+
+          m_StreamRemotePath = path;
+          m_StreamFile = FileIO::fopen(m_StreamLocalPath.c_str(), "w+b");
+
+          if(m_StreamFile == NULL)
+            RDCERR("Couldn't open '%s' to stream capture to", m_StreamLocalPath.c_str());
+        }
+
+        size_t len = 0;
+        byte *data = NULL;
+        ser->SerialiseBuffer("", data, len);
+
+        if(m_StreamFile && len > 0)
+        {
+          FileIO::fseek64(m_StreamFile, offset, SEEK_SET);
+          FileIO::fwrite(data, 1, len, m_StreamFile);
+        }
+
+        SAFE_DELETE_ARRAY(data);
+        SAFE_DELETE(ser);
+
+        msg.Type = TargetControlMessageType::Noop;
+        return msg;
+      }
+      else if(type == ePacket_CaptureStreamEnd)
+      {
+        string path;
+        uint64_t length = 0;
+        bool32 success = 0;
+        ser->Serialise("", path);
+        ser->Serialise("", length);
+        ser->Serialise("", success);
+
+        SAFE_DELETE(ser);
+
+        if(path == m_StreamRemotePath)
+        {
+          bool ok = success && m_StreamFile;
+
+          if(ok)
+          {
+            FileIO::fseek64(m_StreamFile, 0, SEEK_END);
+            ok = (FileIO::ftell64(m_StreamFile) == length);
+          }
+
+          if(ok)
+          {
+            RDCLOG("Streamed capture '%s' to '%s'", path.c_str(), m_StreamLocalPath.c_str());
+            m_StreamedCaptures[path] = m_StreamLocalPath;
+          }
+
+          CloseStream(ok);
+        }
+
+        msg.Type = TargetControlMessageType::Noop;
+        return msg;
+      }
+      else if(type == ePacket_CaptureProgress)
+      {
+        msg.Type = TargetControlMessageType::CaptureProgress;
+
+        ser->Serialise("", msg.CaptureProgress);
+
+        SAFE_DELETE(ser);
+
+        return msg;
+      }
+      else if(type == ePacket_APICallStats)
+      {
+        msg.Type = TargetControlMessageType::APICallStats;
+
+        uint32_t numStats = 0;
+        ser->Serialise("", numStats);
+
+        create_array(msg.APICallStats, numStats);
+
+        for(uint32_t i = 0; i < numStats; i++)
+        {
+          string name;
+          ser->Serialise("", name);
+          msg.APICallStats[i].name = name;
+          ser->Serialise("", msg.APICallStats[i].count);
+          ser->Serialise("", msg.APICallStats[i].milliseconds);
+        }
+
+        SAFE_DELETE(ser);
+
+        return msg;
+      }
+      else if(type == ePacket_Telemetry)
+      {
+        msg.Type = TargetControlMessageType::Telemetry;
+
+        ser->Serialise("", msg.Telemetry.frameTimeMin);
+        ser->Serialise("", msg.Telemetry.frameTimeAvg);
+        ser->Serialise("", msg.Telemetry.frameTimeMax);
+        ser->Serialise("", msg.Telemetry.apiMilliseconds);
+        ser->Serialise("", msg.Telemetry.liveChunks);
+        ser->Serialise("", msg.Telemetry.chunkBytes);
+        ser->Serialise("", msg.Telemetry.bufferBytes);
+
+        SAFE_DELETE(ser);
+
+        return msg;
+      }
       else if(type == ePacket_RegisterAPI)
       {
         msg.Type = TargetControlMessageType::RegisterAPI;
@@ -643,8 +1263,90 @@ private:
   string m_Target, m_API, m_BusyClient;
   uint32_t m_PID;
 
+  // to open extra connections for pulling captures in parallel
+  string m_Host;
+  uint16_t m_Port;
+  string m_ClientName;
+  uint32_t m_Codecs;
+  uint32_t m_TransferStreams;
+
   map<uint32_t, string> m_CaptureCopies;
 
+  // the capture currently being streamed from the target, and the local copies of those that
+  // finished streaming by their path on the target, until they're announced
+  FILE *m_StreamFile;
+  string m_StreamRemotePath, m_StreamLocalPath;
+  uint32_t m_StreamCount;
+  map<string, string> m_StreamedCaptures;
+
+  void CloseStream(bool keep)
+  {
+    if(m_StreamFile)
+      FileIO::fclose(m_StreamFile);
+
+    if(!keep && !m_StreamLocalPath.empty())
+      FileIO::Delete(m_StreamLocalPath.c_str());
+
+    m_StreamFile = NULL;
+    m_StreamRemotePath = m_StreamLocalPath = "";
+  }
+
+  vector<CaptureRangeTransfer *> StartRangeTransfers(uint32_t id, uint32_t streams,
+                                                     const string &path)
+  {
+    vector<CaptureRangeTransfer *> transfers;
+
+    // the first range comes over the main connection
+    for(uint32_t i = 1; i < streams; i++)
+    {
+      CaptureRangeTransfer *transfer = new CaptureRangeTransfer();
+      transfer->host = m_Host;
+      transfer->port = m_Port;
+      transfer->clientName = m_ClientName;
+      transfer->codecs = m_Codecs;
+      transfer->id = id;
+      transfer->range = i;
+      transfer->streams = streams;
+      transfer->path = StringFormat::Fmt("%s.part%u", path.c_str(), i);
+      transfer->success = false;
+
+      // a range is received from its start, not appended to what's there
+      if(FileIO::exists(transfer->path.c_str()))
+        FileIO::Delete(transfer->path.c_str());
+
+      transfer->thread = Threading::CreateThread(CaptureRangeTransferThread, transfer);
+
+      transfers.push_back(transfer);
+    }
+
+    return transfers;
+  }
+
+  bool FinishRangeTransfers(vector<CaptureRangeTransfer *> &transfers, const string &path,
+                            bool success)
+  {
+    for(size_t i = 0; i < transfers.size(); i++)
+    {
+      Threading::JoinThread(transfers[i]->thread);
+      Threading::CloseThread(transfers[i]->thread);
+
+      if(success && !transfers[i]->success)
+        RDCERR("Failed to receive range %u of capture %u", transfers[i]->range, transfers[i]->id);
+
+      success = success && transfers[i]->success &&
+                AppendFileContents(path.c_str(), transfers[i]->path.c_str());
+
+      if(FileIO::exists(transfers[i]->path.c_str()))
+        FileIO::Delete(transfers[i]->path.c_str());
+
+      delete transfers[i];
+    }
+
+    transfers.clear();
+
+    return success;
+  }
+
   void GetPacket(PacketType &type, Serialiser *&ser)
   {
     if(!RecvPacket(m_Socket, type, &ser))
@@ -727,7 +1429,8 @@ extern "C" RENDERDOC_API ITargetControl *RENDERDOC_CC RENDERDOC_CreateTargetCont
 
   bool localhost = !android && (Network::GetIPOctet(sock->GetRemoteIP(), 0) == 127);
 
-  TargetControl *remote = new TargetControl(sock, clientName, forceConnection != 0, localhost);
+  TargetControl *remote = new TargetControl(sock, s, ident & 0xffff, clientName,
+                                            forceConnection != 0, localhost, android);
 
   if(remote->Connected())
     return remote;
@@ -0,0 +1,62 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2015-2017 Baldur Karlsson
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+// outer code will hoist this up to just after the #version
+
+//#extension_gles GL_OES_sample_variables : enable
+//#extension_nongles GL_ARB_derivative_control : enable
+//#extension_nongles GL_ARB_shader_image_load_store : require
+//#extension_nongles GL_ARB_shader_storage_buffer_object : require
+//#extension_nongles GL_ARB_gpu_shader5 : require
+
+// Counts the pixels a drawcall covers and the 2x2 quads the fragment shader ran for. Quad coverage
+// is found the same way as in quadwrite.frag, but summed over the whole drawcall instead of stored
+// per quad.
+//
+// Helper pixels don't write memory, so only covered pixels get here. Each adds 12 divided by the
+// number of covered pixels in its quad, so every quad adds exactly 12 whatever its coverage.
+
+layout(binding = 0, std430) buffer quadStats
+{
+	uint coveredPixels;
+	uint quadsTimes12;
+} stats;
+
+layout(early_fragment_tests) in;
+
+void main()
+{
+	float c0 = gl_SampleMaskIn[0] != 0 ? 1.0f : 0.0f;
+
+	vec2 p = vec2(uint(gl_FragCoord.x) & 1u, uint(gl_FragCoord.y) & 1u);
+	vec2 sign = vec2(p.x > 0.0f ? -1.0f : 1.0f, p.y > 0.0f ? -1.0f : 1.0f);
+	float c1 = c0 + sign.x*dFdxFine(c0);
+	float c2 = c0 + sign.y*dFdyFine(c0);
+	float c3 = c2 + sign.x*dFdxFine(c2);
+
+	uint live = max(uint(c0 + c1 + c2 + c3 + 0.5f), 1u);
+
+	atomicAdd(stats.coveredPixels, 1u);
+	atomicAdd(stats.quadsTimes12, 12u / live);
+}
@@ -479,3 +479,20 @@ float4 RENDERDOC_PrimitiveIDPS(uint prim : SV_PrimitiveID) : SV_Target0
 {
 	return asfloat(prim).xxxx;
 }
+
+cbuffer fragmentcaptureconsts : register(b0)
+{
+	uint2 capture_coord;
+	uint capture_eid;
+	uint capture_samplemask;
+};
+
+AppendStructuredBuffer<uint2> capturedFragments : register(u0);
+
+void RENDERDOC_PixelHistoryCapturePS(float4 pos : SV_Position, uint prim : SV_PrimitiveID,
+                                     uint coverage : SV_Coverage)
+{
+	if(uint(pos.x) == capture_coord.x && uint(pos.y) == capture_coord.y &&
+	   (coverage & capture_samplemask) != 0)
+		capturedFragments.Append(uint2(capture_eid, prim));
+}
@@ -207,11 +207,22 @@ void RENDERDOC_ResultMinMaxCS()
 
 RWBuffer<uint> HistogramDest : register(u0);
 
+// each group accumulates into its own copy of the buckets so that the contended atomics stay
+// in group shared memory, and only non-empty buckets are flushed to the destination at the end
+groupshared uint HistogramLocal[HGRAM_NUM_BUCKETS];
+
 [numthreads(HGRAM_TILES_PER_BLOCK, HGRAM_TILES_PER_BLOCK, 1)]
 void RENDERDOC_HistogramCS(uint3 tid : SV_GroupThreadID, uint3 gid : SV_GroupID)
 {
 	uint texType = SHADER_RESTYPE;
 
+	uint flatIdx = tid.y*HGRAM_TILES_PER_BLOCK + tid.x;
+
+	for(uint b=flatIdx; b < HGRAM_NUM_BUCKETS; b += HGRAM_TILES_PER_BLOCK*HGRAM_TILES_PER_BLOCK)
+		HistogramLocal[b] = 0;
+
+	GroupMemoryBarrierWithGroupSync();
+
 	uint3 texDim = uint3(HistogramTextureResolution);
 
 	uint blocksX = (int)ceil(float(texDim.x)/float(HGRAM_PIXELS_PER_TILE*HGRAM_PIXELS_PER_TILE));
@@ -349,8 +360,16 @@ void RENDERDOC_HistogramCS(uint3 tid : SV_GroupThreadID, uint3 gid : SV_GroupID)
 #endif
 
 			if(bucketIdx >= 0 && bucketIdx < HGRAM_NUM_BUCKETS)
-				InterlockedAdd(HistogramDest[bucketIdx], 1);
+				InterlockedAdd(HistogramLocal[bucketIdx], 1);
 		}
 	}
+
+	GroupMemoryBarrierWithGroupSync();
+
+	for(uint f=flatIdx; f < HGRAM_NUM_BUCKETS; f += HGRAM_TILES_PER_BLOCK*HGRAM_TILES_PER_BLOCK)
+	{
+		if(HistogramLocal[f] > 0)
+			InterlockedAdd(HistogramDest[f], HistogramLocal[f]);
+	}
 }
 
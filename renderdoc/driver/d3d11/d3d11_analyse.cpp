@@ -419,12 +419,13 @@ void D3D11DebugManager::FillCBufferVariables(const vector<DXBC::CBufferVariable>
 
 ShaderDebug::State D3D11DebugManager::CreateShaderDebugState(ShaderDebugTrace &trace, int quadIdx,
                                                              DXBC::DXBCFile *dxbc,
+                                                             const ShaderDebug::GlobalState &global,
                                                              vector<byte> *cbufData)
 {
   using namespace DXBC;
   using namespace ShaderDebug;
 
-  State initialState = State(quadIdx, &trace, dxbc, m_WrappedDevice);
+  State initialState = State(quadIdx, &trace, &global.program, dxbc, m_WrappedDevice);
 
   // use pixel shader here to get inputs
 
@@ -592,6 +593,8 @@ void D3D11DebugManager::CreateShaderGlobalState(ShaderDebug::GlobalState &global
                                                 ID3D11UnorderedAccessView **UAVs,
                                                 ID3D11ShaderResourceView **SRVs)
 {
+  global.program.Decode(dxbc);
+
   for(int i = 0; UAVs != NULL && i + UAVStartSlot < D3D11_1_UAV_SLOT_COUNT; i++)
   {
     int dsti = i + UAVStartSlot;
@@ -914,17 +917,196 @@ struct DebugHit
   uint32_t rawdata;    // arbitrary, depending on shader
 };
 
+// shared by every simulation in a batch, so that the user is only asked once whether to abort no
+// matter how many of the invocations run for a long time.
+struct DebugTimeout
+{
+  DebugTimeout() : prompted(false), abort(false) {}
+  bool Check(DXBC::ProgramType prog, uint32_t cycleCounter)
+  {
+    SCOPED_LOCK(lock);
+
+    if(!prompted)
+    {
+      prompted = true;
+      abort = PromptDebugTimeout(prog, cycleCounter);
+    }
+
+    return abort;
+  }
+
+private:
+  Threading::CriticalSection lock;
+  bool prompted;
+  bool abort;
+};
+
+struct VertexDebugBatch
+{
+  D3D11DebugManager *manager;
+  volatile int32_t nextJob;
+  int32_t numJobs;
+
+  const vector<ShaderDebugVertexInput> *inputs;
+  vector<ShaderDebugTrace> *traces;
+
+  DXBC::DXBCFile *dxbc;
+  const DrawcallDescription *draw;
+  vector<D3D11_INPUT_ELEMENT_DESC> inputlayout;
+  UINT strides[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+
+  // the vertices from minIdx to the highest index in the batch, and the instances from 0 to the
+  // highest instance, read once for each slot
+  uint32_t minIdx;
+  vector<byte> vertData[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+  vector<byte> instData[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+
+  vector<byte> cbufData[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+
+  // vertex shaders can't write to any resources, so every simulation shares the global state
+  ShaderDebug::GlobalState global;
+
+  DebugTimeout timeout;
+};
+
+struct PixelDebugBatch
+{
+  D3D11DebugManager *manager;
+  volatile int32_t nextJob;
+  int32_t numJobs;
+
+  const vector<ShaderDebugPixelInput> *inputs;
+  vector<ShaderDebugTrace> *traces;
+
+  // the input to simulate for each job, and the hits that were fetched for its pixel
+  vector<size_t> jobs;
+  vector<byte *> hits;
+
+  DXBC::DXBCFile *dxbc;
+  vector<DataOutput> initialValues;
+  uint32_t structStride;
+  uint32_t overdrawLevels;
+  D3D11_COMPARISON_FUNC depthFunc;
+
+  vector<byte> cbufData[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+
+  // if the pixel shader has UAVs bound, it can write to them and each simulation needs its own
+  // copy of the global state. Otherwise they can all share it.
+  ShaderDebug::GlobalState global;
+  bool copyGlobal;
+
+  DebugTimeout timeout;
+};
+
+// maximum number of distinct pixels fetched by one replay of the event, and the largest buffer of
+// hits we want to allocate for them.
+#define MAX_DEBUG_PIXELS_PER_REPLAY 1024
+#define MAX_DEBUG_PIXEL_HIT_BYTES (64 * 1024 * 1024)
+
+// finds the data for one element in a contiguous range of elements read from a vertex buffer, then
+// offsets it to a particular attribute. A stride of 0 means each element reads the start of the
+// range.
+static void GetVertexElementData(vector<byte> &range, UINT stride, uint32_t element,
+                                 UINT byteOffset, byte *&data, size_t &dataSize)
+{
+  data = NULL;
+  dataSize = 0;
+
+  size_t offset = size_t(stride) * element;
+
+  if(offset >= range.size())
+    return;
+
+  size_t elemSize = range.size() - offset;
+  if(stride > 0)
+    elemSize = RDCMIN(elemSize, (size_t)stride);
+
+  if(elemSize > byteOffset)
+  {
+    data = &range[offset + byteOffset];
+    dataSize = elemSize - byteOffset;
+  }
+}
+
+// runs each job in a batch across the available cores, with this thread doing its share too.
+static void RunShaderDebugBatch(Threading::ThreadEntry worker, void *batch, uint32_t numJobs)
+{
+  uint32_t numThreads = RDCMIN(Threading::GetCPUCount(), numJobs);
+
+  std::vector<Threading::ThreadHandle> threads;
+
+  for(uint32_t i = 1; i < numThreads; i++)
+  {
+    Threading::ThreadHandle t = Threading::CreateThread(worker, batch);
+    if(t)
+      threads.push_back(t);
+  }
+
+  worker(batch);
+
+  for(size_t i = 0; i < threads.size(); i++)
+  {
+    Threading::JoinThread(threads[i]);
+    Threading::CloseThread(threads[i]);
+  }
+}
+
+void D3D11DebugManager::DebugVertexWorker(void *param)
+{
+  VertexDebugBatch *batch = (VertexDebugBatch *)param;
+
+  for(;;)
+  {
+    int32_t idx = Atomic::Inc32(&batch->nextJob) - 1;
+
+    if(idx >= batch->numJobs)
+      break;
+
+    batch->manager->SimulateVertex(*batch, (size_t)idx);
+  }
+}
+
+void D3D11DebugManager::DebugPixelWorker(void *param)
+{
+  PixelDebugBatch *batch = (PixelDebugBatch *)param;
+
+  for(;;)
+  {
+    int32_t idx = Atomic::Inc32(&batch->nextJob) - 1;
+
+    if(idx >= batch->numJobs)
+      break;
+
+    batch->manager->SimulatePixel(*batch, (size_t)idx);
+  }
+}
+
 ShaderDebugTrace D3D11DebugManager::DebugVertex(uint32_t eventID, uint32_t vertid, uint32_t instid,
                                                 uint32_t idx, uint32_t instOffset,
                                                 uint32_t vertOffset)
+{
+  vector<ShaderDebugVertexInput> inputs(1);
+  inputs[0].vertid = vertid;
+  inputs[0].instid = instid;
+  inputs[0].idx = idx;
+
+  return DebugVertices(eventID, inputs, instOffset, vertOffset)[0];
+}
+
+vector<ShaderDebugTrace> D3D11DebugManager::DebugVertices(
+    uint32_t eventID, const vector<ShaderDebugVertexInput> &inputs, uint32_t instOffset,
+    uint32_t vertOffset)
 {
   using namespace DXBC;
   using namespace ShaderDebug;
 
-  D3D11MarkerRegion debugpixRegion(
-      StringFormat::Fmt("DebugVertex @ %u of (%u,%u,%u)", eventID, vertid, instid, idx));
+  D3D11MarkerRegion debugvertRegion(
+      StringFormat::Fmt("DebugVertices @ %u of %u vertices", eventID, (uint32_t)inputs.size()));
 
-  ShaderDebugTrace empty;
+  vector<ShaderDebugTrace> traces(inputs.size());
+
+  if(inputs.empty())
+    return traces;
 
   const DrawcallDescription *draw = m_WrappedDevice->GetDrawcall(eventID);
 
@@ -938,29 +1120,32 @@ ShaderDebugTrace D3D11DebugManager::DebugVertex(uint32_t eventID, uint32_t verti
   SAFE_RELEASE(stateVS);
 
   if(!vs)
-    return empty;
+    return traces;
 
   DXBCFile *dxbc = vs->GetDXBC();
 
   if(!dxbc)
-    return empty;
+    return traces;
 
   D3D11RenderState *rs = m_WrappedContext->GetCurrentPipelineState();
 
-  vector<D3D11_INPUT_ELEMENT_DESC> inputlayout = m_WrappedDevice->GetLayoutDesc(rs->IA.Layout);
+  VertexDebugBatch batch;
+  batch.manager = this;
+  batch.nextJob = 0;
+  batch.numJobs = (int32_t)inputs.size();
+  batch.inputs = &inputs;
+  batch.traces = &traces;
+  batch.dxbc = dxbc;
+  batch.draw = draw;
+  batch.inputlayout = m_WrappedDevice->GetLayoutDesc(rs->IA.Layout);
+
+  vector<D3D11_INPUT_ELEMENT_DESC> &inputlayout = batch.inputlayout;
 
   set<UINT> vertexbuffers;
   uint32_t trackingOffs[32] = {0};
 
-  UINT MaxStepRate = 1U;
-
-  // need special handling for other step rates
   for(size_t i = 0; i < inputlayout.size(); i++)
   {
-    if(inputlayout[i].InputSlotClass == D3D11_INPUT_PER_INSTANCE_DATA &&
-       inputlayout[i].InstanceDataStepRate < draw->numInstances)
-      MaxStepRate = RDCMAX(inputlayout[i].InstanceDataStepRate, MaxStepRate);
-
     UINT slot =
         RDCCLAMP(inputlayout[i].InputSlot, 0U, UINT(D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT - 1));
 
@@ -980,44 +1165,71 @@ ShaderDebugTrace D3D11DebugManager::DebugVertex(uint32_t eventID, uint32_t verti
     trackingOffs[slot] += fmt.compByteWidth * fmt.compCount;
   }
 
-  vector<byte> vertData[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
-  vector<byte> *instData = new vector<byte>[MaxStepRate * D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
-  vector<byte> staticData[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+  uint32_t minIdx = inputs[0].idx, maxIdx = inputs[0].idx, maxInst = inputs[0].instid;
+
+  for(size_t i = 1; i < inputs.size(); i++)
+  {
+    minIdx = RDCMIN(minIdx, inputs[i].idx);
+    maxIdx = RDCMAX(maxIdx, inputs[i].idx);
+    maxInst = RDCMAX(maxInst, inputs[i].instid);
+  }
+
+  batch.minIdx = minIdx;
+
+  // rather than reading back each vertex and instance separately, read the whole range that the
+  // batch touches in one go. Every instance step rate indexes into the same instance range.
+  for(UINT i = 0; i < D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT; i++)
+    batch.strides[i] = rs->IA.Strides[i];
 
   for(auto it = vertexbuffers.begin(); it != vertexbuffers.end(); ++it)
   {
     UINT i = *it;
     if(rs->IA.VBs[i])
     {
-      GetBufferData(rs->IA.VBs[i], rs->IA.Offsets[i] + rs->IA.Strides[i] * (vertOffset + idx),
-                    rs->IA.Strides[i], vertData[i], true);
+      UINT stride = rs->IA.Strides[i];
 
-      for(UINT isr = 1; isr <= MaxStepRate; isr++)
-      {
-        GetBufferData(rs->IA.VBs[i],
-                      rs->IA.Offsets[i] + rs->IA.Strides[i] * (instOffset + (instid / isr)),
-                      rs->IA.Strides[i], instData[i * MaxStepRate + isr - 1], true);
-      }
+      GetBufferData(rs->IA.VBs[i], rs->IA.Offsets[i] + stride * (vertOffset + minIdx),
+                    uint64_t(stride) * (maxIdx - minIdx + 1), batch.vertData[i], true);
 
-      GetBufferData(rs->IA.VBs[i], rs->IA.Offsets[i] + rs->IA.Strides[i] * instOffset,
-                    rs->IA.Strides[i], staticData[i], true);
+      GetBufferData(rs->IA.VBs[i], rs->IA.Offsets[i] + stride * instOffset,
+                    uint64_t(stride) * (maxInst + 1), batch.instData[i], true);
     }
   }
 
-  vector<byte> cbufData[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
-
   for(int i = 0; i < D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT; i++)
     if(rs->VS.ConstantBuffers[i])
-      GetBufferData(rs->VS.ConstantBuffers[i], rs->VS.CBOffsets[i] * sizeof(Vec4f), 0, cbufData[i],
-                    true);
+      GetBufferData(rs->VS.ConstantBuffers[i], rs->VS.CBOffsets[i] * sizeof(Vec4f), 0,
+                    batch.cbufData[i], true);
 
-  ShaderDebugTrace ret;
+  CreateShaderGlobalState(batch.global, dxbc, 0, NULL, rs->VS.SRVs);
 
-  GlobalState global;
-  CreateShaderGlobalState(global, dxbc, 0, NULL, rs->VS.SRVs);
-  State initialState = CreateShaderDebugState(ret, -1, dxbc, cbufData);
+  D3D11MarkerRegion simloop("Simulation Loop");
+
+  RunShaderDebugBatch(&D3D11DebugManager::DebugVertexWorker, &batch, (uint32_t)inputs.size());
+
+  return traces;
+}
 
-  for(int32_t i = 0; i < ret.inputs.count; i++)
+void D3D11DebugManager::SimulateVertex(VertexDebugBatch &batch, size_t job)
+{
+  using namespace DXBC;
+  using namespace ShaderDebug;
+
+  const ShaderDebugVertexInput &input = (*batch.inputs)[job];
+  ShaderDebugTrace &trace = (*batch.traces)[job];
+
+  uint32_t vertid = input.vertid;
+  uint32_t instid = input.instid;
+  uint32_t idx = input.idx;
+
+  DXBCFile *dxbc = batch.dxbc;
+  const DrawcallDescription *draw = batch.draw;
+  const vector<D3D11_INPUT_ELEMENT_DESC> &inputlayout = batch.inputlayout;
+  GlobalState &global = batch.global;
+
+  State initialState = CreateShaderDebugState(trace, -1, dxbc, global, batch.cbufData);
+
+  for(int32_t i = 0; i < trace.inputs.count; i++)
   {
     if(dxbc->m_InputSig[i].systemValue == ShaderBuiltin::Undefined ||
        dxbc->m_InputSig[i].systemValue ==
@@ -1055,28 +1267,18 @@ ShaderDebugTrace D3D11DebugManager::DebugVertex(uint32_t eventID, uint32_t verti
 
       if(el->InputSlotClass == D3D11_INPUT_PER_VERTEX_DATA)
       {
-        if(vertData[el->InputSlot].size() >= el->AlignedByteOffset)
-        {
-          srcData = &vertData[el->InputSlot][el->AlignedByteOffset];
-          dataSize = vertData[el->InputSlot].size() - el->AlignedByteOffset;
-        }
+        GetVertexElementData(batch.vertData[el->InputSlot], batch.strides[el->InputSlot],
+                             idx - batch.minIdx, el->AlignedByteOffset, srcData, dataSize);
       }
       else
       {
-        if(el->InstanceDataStepRate >= draw->numInstances)
-        {
-          srcData = &staticData[el->InputSlot][el->AlignedByteOffset];
-          dataSize = staticData[el->InputSlot].size() - el->AlignedByteOffset;
-        }
-        else
-        {
-          UINT isrIdx = el->InputSlot * MaxStepRate + (el->InstanceDataStepRate - 1);
-          if(instData[isrIdx].size() >= el->AlignedByteOffset)
-          {
-            srcData = &instData[isrIdx][el->AlignedByteOffset];
-            dataSize = instData[isrIdx].size() - el->AlignedByteOffset;
-          }
-        }
+        uint32_t inst = 0;
+
+        if(el->InstanceDataStepRate < draw->numInstances)
+          inst = instid / RDCMAX(1U, el->InstanceDataStepRate);
+
+        GetVertexElementData(batch.instData[el->InputSlot], batch.strides[el->InputSlot], inst,
+                             el->AlignedByteOffset, srcData, dataSize);
       }
 
       ResourceFormat fmt = MakeResourceFormat(el->Format);
@@ -1084,17 +1286,17 @@ ShaderDebugTrace D3D11DebugManager::DebugVertex(uint32_t eventID, uint32_t verti
       // more data needed than is provided
       if(dxbc->m_InputSig[i].compCount > fmt.compCount)
       {
-        ret.inputs[i].value.u.w = 1;
+        trace.inputs[i].value.u.w = 1;
 
         if(fmt.compType == CompType::Float)
-          ret.inputs[i].value.f.w = 1.0f;
+          trace.inputs[i].value.f.w = 1.0f;
       }
 
       // interpret special formats
       if(fmt.special)
       {
-        Vec3f *v3 = (Vec3f *)ret.inputs[i].value.fv;
-        Vec4f *v4 = (Vec4f *)ret.inputs[i].value.fv;
+        Vec3f *v3 = (Vec3f *)trace.inputs[i].value.fv;
+        Vec4f *v4 = (Vec4f *)trace.inputs[i].value.fv;
 
         // only pull in all or nothing from these,
         // if there's only e.g. 3 bytes remaining don't read and unpack some of
@@ -1106,8 +1308,8 @@ ShaderDebugTrace D3D11DebugManager::DebugVertex(uint32_t eventID, uint32_t verti
 
         if(srcData == NULL || packedsize > dataSize)
         {
-          ret.inputs[i].value.u.x = ret.inputs[i].value.u.y = ret.inputs[i].value.u.z =
-              ret.inputs[i].value.u.w = 0;
+          trace.inputs[i].value.u.x = trace.inputs[i].value.u.y = trace.inputs[i].value.u.z =
+              trace.inputs[i].value.u.w = 0;
         }
         else if(fmt.specialFormat == SpecialFormat::R5G5B5A1)
         {
@@ -1133,10 +1335,10 @@ ShaderDebugTrace D3D11DebugManager::DebugVertex(uint32_t eventID, uint32_t verti
 
           if(fmt.compType == CompType::UInt)
           {
-            ret.inputs[i].value.u.z = (packed >> 0) & 0x3ff;
-            ret.inputs[i].value.u.y = (packed >> 10) & 0x3ff;
-            ret.inputs[i].value.u.x = (packed >> 20) & 0x3ff;
-            ret.inputs[i].value.u.w = (packed >> 30) & 0x003;
+            trace.inputs[i].value.u.z = (packed >> 0) & 0x3ff;
+            trace.inputs[i].value.u.y = (packed >> 10) & 0x3ff;
+            trace.inputs[i].value.u.x = (packed >> 20) & 0x3ff;
+            trace.inputs[i].value.u.w = (packed >> 30) & 0x003;
           }
           else
           {
@@ -1155,7 +1357,7 @@ ShaderDebugTrace D3D11DebugManager::DebugVertex(uint32_t eventID, uint32_t verti
         {
           if(srcData == NULL || fmt.compByteWidth > dataSize)
           {
-            ret.inputs[i].value.uv[c] = 0;
+            trace.inputs[i].value.uv[c] = 0;
             continue;
           }
 
@@ -1166,20 +1368,20 @@ ShaderDebugTrace D3D11DebugManager::DebugVertex(uint32_t eventID, uint32_t verti
             byte *src = srcData + c * fmt.compByteWidth;
 
             if(fmt.compType == CompType::UInt)
-              ret.inputs[i].value.uv[c] = *src;
+              trace.inputs[i].value.uv[c] = *src;
             else if(fmt.compType == CompType::SInt)
-              ret.inputs[i].value.iv[c] = *((int8_t *)src);
+              trace.inputs[i].value.iv[c] = *((int8_t *)src);
             else if(fmt.compType == CompType::UNorm)
-              ret.inputs[i].value.fv[c] = float(*src) / 255.0f;
+              trace.inputs[i].value.fv[c] = float(*src) / 255.0f;
             else if(fmt.compType == CompType::SNorm)
             {
               signed char *schar = (signed char *)src;
 
               // -128 is mapped to -1, then -127 to -127 are mapped to -1 to 1
               if(*schar == -128)
-                ret.inputs[i].value.fv[c] = -1.0f;
+                trace.inputs[i].value.fv[c] = -1.0f;
               else
-                ret.inputs[i].value.fv[c] = float(*schar) / 127.0f;
+                trace.inputs[i].value.fv[c] = float(*schar) / 127.0f;
             }
             else
               RDCERR("Unexpected component type");
@@ -1189,22 +1391,22 @@ ShaderDebugTrace D3D11DebugManager::DebugVertex(uint32_t eventID, uint32_t verti
             uint16_t *src = (uint16_t *)(srcData + c * fmt.compByteWidth);
 
             if(fmt.compType == CompType::Float)
-              ret.inputs[i].value.fv[c] = ConvertFromHalf(*src);
+              trace.inputs[i].value.fv[c] = ConvertFromHalf(*src);
             else if(fmt.compType == CompType::UInt)
-              ret.inputs[i].value.uv[c] = *src;
+              trace.inputs[i].value.uv[c] = *src;
             else if(fmt.compType == CompType::SInt)
-              ret.inputs[i].value.iv[c] = *((int16_t *)src);
+              trace.inputs[i].value.iv[c] = *((int16_t *)src);
             else if(fmt.compType == CompType::UNorm)
-              ret.inputs[i].value.fv[c] = float(*src) / float(UINT16_MAX);
+              trace.inputs[i].value.fv[c] = float(*src) / float(UINT16_MAX);
             else if(fmt.compType == CompType::SNorm)
             {
               int16_t *sint = (int16_t *)src;
 
               // -32768 is mapped to -1, then -32767 to -32767 are mapped to -1 to 1
               if(*sint == -32768)
-                ret.inputs[i].value.fv[c] = -1.0f;
+                trace.inputs[i].value.fv[c] = -1.0f;
               else
-                ret.inputs[i].value.fv[c] = float(*sint) / 32767.0f;
+                trace.inputs[i].value.fv[c] = float(*sint) / 32767.0f;
             }
             else
               RDCERR("Unexpected component type");
@@ -1215,7 +1417,7 @@ ShaderDebugTrace D3D11DebugManager::DebugVertex(uint32_t eventID, uint32_t verti
 
             if(fmt.compType == CompType::Float || fmt.compType == CompType::UInt ||
                fmt.compType == CompType::SInt)
-              memcpy(&ret.inputs[i].value.uv[c], src, 4);
+              memcpy(&trace.inputs[i].value.uv[c], src, 4);
             else
               RDCERR("Unexpected component type");
           }
@@ -1224,7 +1426,7 @@ ShaderDebugTrace D3D11DebugManager::DebugVertex(uint32_t eventID, uint32_t verti
         if(fmt.bgraOrder)
         {
           RDCASSERT(fmt.compCount == 4);
-          std::swap(ret.inputs[i].value.fv[2], ret.inputs[i].value.fv[0]);
+          std::swap(trace.inputs[i].value.fv[2], trace.inputs[i].value.fv[0]);
         }
       }
     }
@@ -1236,20 +1438,20 @@ ShaderDebugTrace D3D11DebugManager::DebugVertex(uint32_t eventID, uint32_t verti
         sv_vertid = idx;
 
       if(dxbc->m_InputSig[i].compType == CompType::Float)
-        ret.inputs[i].value.f.x = ret.inputs[i].value.f.y = ret.inputs[i].value.f.z =
-            ret.inputs[i].value.f.w = (float)sv_vertid;
+        trace.inputs[i].value.f.x = trace.inputs[i].value.f.y = trace.inputs[i].value.f.z =
+            trace.inputs[i].value.f.w = (float)sv_vertid;
       else
-        ret.inputs[i].value.u.x = ret.inputs[i].value.u.y = ret.inputs[i].value.u.z =
-            ret.inputs[i].value.u.w = sv_vertid;
+        trace.inputs[i].value.u.x = trace.inputs[i].value.u.y = trace.inputs[i].value.u.z =
+            trace.inputs[i].value.u.w = sv_vertid;
     }
     else if(dxbc->m_InputSig[i].systemValue == ShaderBuiltin::InstanceIndex)
     {
       if(dxbc->m_InputSig[i].compType == CompType::Float)
-        ret.inputs[i].value.f.x = ret.inputs[i].value.f.y = ret.inputs[i].value.f.z =
-            ret.inputs[i].value.f.w = (float)instid;
+        trace.inputs[i].value.f.x = trace.inputs[i].value.f.y = trace.inputs[i].value.f.z =
+            trace.inputs[i].value.f.w = (float)instid;
       else
-        ret.inputs[i].value.u.x = ret.inputs[i].value.u.y = ret.inputs[i].value.u.z =
-            ret.inputs[i].value.u.w = instid;
+        trace.inputs[i].value.u.x = trace.inputs[i].value.u.y = trace.inputs[i].value.u.z =
+            trace.inputs[i].value.u.w = instid;
     }
     else
     {
@@ -1257,15 +1459,9 @@ ShaderDebugTrace D3D11DebugManager::DebugVertex(uint32_t eventID, uint32_t verti
     }
   }
 
-  delete[] instData;
-
-  State last;
+  ShaderDebugTraceBuilder states;
 
-  vector<ShaderDebugState> states;
-
-  states.push_back((State)initialState);
-
-  D3D11MarkerRegion simloop("Simulation Loop");
+  states.AddState(initialState);
 
   for(int cycleCounter = 0;; cycleCounter++)
   {
@@ -1274,30 +1470,43 @@ ShaderDebugTrace D3D11DebugManager::DebugVertex(uint32_t eventID, uint32_t verti
 
     initialState = initialState.GetNext(global, NULL);
 
-    states.push_back((State)initialState);
+    states.AddState(initialState);
 
     if(cycleCounter == SHADER_DEBUG_WARN_THRESHOLD)
     {
-      if(PromptDebugTimeout(DXBC::TYPE_VERTEX, cycleCounter))
+      if(batch.timeout.Check(DXBC::TYPE_VERTEX, cycleCounter))
         break;
     }
   }
 
-  ret.states = states;
-
-  return ret;
+  states.Finish(trace);
 }
 
 ShaderDebugTrace D3D11DebugManager::DebugPixel(uint32_t eventID, uint32_t x, uint32_t y,
                                                uint32_t sample, uint32_t primitive)
+{
+  vector<ShaderDebugPixelInput> inputs(1);
+  inputs[0].x = x;
+  inputs[0].y = y;
+  inputs[0].sample = sample;
+  inputs[0].primitive = primitive;
+
+  return DebugPixels(eventID, inputs)[0];
+}
+
+vector<ShaderDebugTrace> D3D11DebugManager::DebugPixels(uint32_t eventID,
+                                                        const vector<ShaderDebugPixelInput> &inputs)
 {
   using namespace DXBC;
   using namespace ShaderDebug;
 
   D3D11MarkerRegion debugpixRegion(
-      StringFormat::Fmt("DebugPixel @ %u of (%u,%u) %u / %u", eventID, x, y, sample, primitive));
+      StringFormat::Fmt("DebugPixels @ %u of %u pixels", eventID, (uint32_t)inputs.size()));
 
-  ShaderDebugTrace empty;
+  vector<ShaderDebugTrace> traces(inputs.size());
+
+  if(inputs.empty())
+    return traces;
 
   D3D11RenderStateTracker tracker(m_WrappedContext);
 
@@ -1331,14 +1540,14 @@ ShaderDebugTrace D3D11DebugManager::DebugPixel(uint32_t eventID, uint32_t x, uin
   SAFE_RELEASE(stateVS);
 
   if(!ps)
-    return empty;
+    return traces;
 
   D3D11RenderState *rs = m_WrappedContext->GetCurrentPipelineState();
 
   DXBCFile *dxbc = ps->GetDXBC();
 
   if(!dxbc)
-    return empty;
+    return traces;
 
   DXBCFile *prevdxbc = NULL;
 
@@ -1349,7 +1558,13 @@ ShaderDebugTrace D3D11DebugManager::DebugPixel(uint32_t eventID, uint32_t x, uin
   if(prevdxbc == NULL && vs != NULL)
     prevdxbc = vs->GetDXBC();
 
-  vector<DataOutput> initialValues;
+  PixelDebugBatch batch;
+  batch.manager = this;
+  batch.inputs = &inputs;
+  batch.traces = &traces;
+  batch.dxbc = dxbc;
+
+  vector<DataOutput> &initialValues = batch.initialValues;
 
   string extractHlsl = "struct PSInput\n{\n";
 
@@ -1623,6 +1838,26 @@ ShaderDebugTrace D3D11DebugManager::DebugPixel(uint32_t eventID, uint32_t x, uin
 
   uint32_t overdrawLevels = 100;    // maximum number of overdraw levels
 
+  // several inputs can share the same co-ordinate with a different sample or primitive, so they
+  // share the same hits too.
+  map<pair<uint32_t, uint32_t>, uint32_t> pixelSlots;
+  vector<pair<uint32_t, uint32_t> > pixels;
+  vector<uint32_t> inputSlots(inputs.size());
+
+  for(size_t i = 0; i < inputs.size(); i++)
+  {
+    pair<uint32_t, uint32_t> coord = std::make_pair(inputs[i].x, inputs[i].y);
+
+    auto it = pixelSlots.find(coord);
+    if(it == pixelSlots.end())
+    {
+      it = pixelSlots.insert(std::make_pair(coord, (uint32_t)pixels.size())).first;
+      pixels.push_back(coord);
+    }
+
+    inputSlots[i] = it->second;
+  }
+
   uint32_t uavslot = 0;
 
   ID3D11DepthStencilView *depthView = NULL;
@@ -1633,6 +1868,14 @@ ShaderDebugTrace D3D11DebugManager::DebugPixel(uint32_t eventID, uint32_t x, uin
   if(rtView != NULL)
     uavslot = 1;
 
+  // each pixel gets overdrawLevels hits, plus one slot past the end that takes any further
+  // overdraw. The count of hits is stored in the first hit.
+  extractHlsl += "cbuffer DebugPixelList : register(b0)\n{\n";
+  extractHlsl += "  uint4 debug_pixelBounds;\n";
+  extractHlsl += "  uint4 debug_pixelCount;\n";
+  extractHlsl +=
+      "  uint4 debug_pixels[" + ToStr::Get((uint32_t)MAX_DEBUG_PIXELS_PER_REPLAY) + "];\n";
+  extractHlsl += "};\n\n";
   extractHlsl +=
       "struct PSInitialData { uint hit; float3 pos; uint prim; uint fface; uint sample; uint "
       "covge; float derivValid; PSInput IN; PSInput INddx; PSInput INddy; PSInput INddxfine; "
@@ -1644,10 +1887,16 @@ ShaderDebugTrace D3D11DebugManager::DebugPixel(uint32_t eventID, uint32_t x, uin
       "SV_PrimitiveID, uint sample : SV_SampleIndex, uint covge : SV_Coverage, bool fface : "
       "SV_IsFrontFace)\n{\n";
   extractHlsl += "  uint idx = " + ToStr::Get(overdrawLevels) + ";\n";
-  extractHlsl += "  if(abs(debug_pixelPos.x - " + ToStr::Get(x) +
-                 ".5) < 0.5f && abs(debug_pixelPos.y - " + ToStr::Get(y) + ".5) < 0.5f)\n";
-  extractHlsl += "    InterlockedAdd(PSInitialBuffer[0].hit, 1, idx);\n\n";
-  extractHlsl += "  idx = min(idx, " + ToStr::Get(overdrawLevels) + ");\n\n";
+  extractHlsl += "  uint2 debug_pixelCoord = uint2(debug_pixelPos.xy);\n";
+  extractHlsl +=
+      "  if(all(debug_pixelCoord >= debug_pixelBounds.xy) && "
+      "all(debug_pixelCoord <= debug_pixelBounds.zw))\n  {\n";
+  extractHlsl += "    for(uint p = 0; p < debug_pixelCount.x; p++)\n    {\n";
+  extractHlsl += "      if(all(debug_pixelCoord == debug_pixels[p].xy))\n      {\n";
+  extractHlsl += "        uint debug_first = p * " + ToStr::Get(overdrawLevels + 1) + ";\n";
+  extractHlsl += "        InterlockedAdd(PSInitialBuffer[debug_first].hit, 1, idx);\n";
+  extractHlsl += "        idx = debug_first + min(idx, " + ToStr::Get(overdrawLevels) + ");\n";
+  extractHlsl += "        break;\n      }\n    }\n  }\n\n";
   extractHlsl += "  PSInitialBuffer[idx].pos = debug_pixelPos.xyz;\n";
   extractHlsl += "  PSInitialBuffer[idx].prim = prim;\n";
   extractHlsl += "  PSInitialBuffer[idx].fface = fface;\n";
@@ -1682,6 +1931,13 @@ ShaderDebugTrace D3D11DebugManager::DebugPixel(uint32_t eventID, uint32_t x, uin
                           +
                           structureStride * 5;    // PSInput IN, INddx, INddy, INddxfine, INddyfine;
 
+  uint32_t pixelStride = structStride * (overdrawLevels + 1);
+
+  uint32_t pixelsPerReplay = MAX_DEBUG_PIXEL_HIT_BYTES / pixelStride;
+  pixelsPerReplay = RDCMIN(pixelsPerReplay, (uint32_t)MAX_DEBUG_PIXELS_PER_REPLAY);
+  pixelsPerReplay = RDCMIN(pixelsPerReplay, (uint32_t)pixels.size());
+  pixelsPerReplay = RDCMAX(pixelsPerReplay, 1U);
+
   HRESULT hr = S_OK;
 
   D3D11_BUFFER_DESC bdesc;
@@ -1690,7 +1946,7 @@ ShaderDebugTrace D3D11DebugManager::DebugPixel(uint32_t eventID, uint32_t x, uin
   bdesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
   bdesc.Usage = D3D11_USAGE_DEFAULT;
   bdesc.StructureByteStride = structStride;
-  bdesc.ByteWidth = bdesc.StructureByteStride * (overdrawLevels + 1);
+  bdesc.ByteWidth = pixelStride * pixelsPerReplay;
 
   ID3D11Buffer *initialBuf = NULL;
   hr = m_pDevice->CreateBuffer(&bdesc, NULL, &initialBuf);
@@ -1698,7 +1954,7 @@ ShaderDebugTrace D3D11DebugManager::DebugPixel(uint32_t eventID, uint32_t x, uin
   if(FAILED(hr))
   {
     RDCERR("Failed to create buffer %08x", hr);
-    return empty;
+    return traces;
   }
 
   bdesc.BindFlags = 0;
@@ -1713,14 +1969,14 @@ ShaderDebugTrace D3D11DebugManager::DebugPixel(uint32_t eventID, uint32_t x, uin
   if(FAILED(hr))
   {
     RDCERR("Failed to create buffer %08x", hr);
-    return empty;
+    return traces;
   }
 
   D3D11_UNORDERED_ACCESS_VIEW_DESC uavdesc;
   uavdesc.Format = DXGI_FORMAT_UNKNOWN;
   uavdesc.Buffer.FirstElement = 0;
   uavdesc.Buffer.Flags = 0;
-  uavdesc.Buffer.NumElements = overdrawLevels + 1;
+  uavdesc.Buffer.NumElements = (overdrawLevels + 1) * pixelsPerReplay;
   uavdesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
 
   ID3D11UnorderedAccessView *initialUAV = NULL;
@@ -1729,57 +1985,157 @@ ShaderDebugTrace D3D11DebugManager::DebugPixel(uint32_t eventID, uint32_t x, uin
   if(FAILED(hr))
   {
     RDCERR("Failed to create buffer %08x", hr);
-    return empty;
+    return traces;
   }
 
-  UINT zero = 0;
-  m_pImmediateContext->ClearUnorderedAccessViewUint(initialUAV, &zero);
+  // bounds, count, then one co-ordinate per uint4
+  vector<uint32_t> pixelList((2 + MAX_DEBUG_PIXELS_PER_REPLAY) * 4);
 
-  UINT count = (UINT)-1;
-  m_pImmediateContext->OMSetRenderTargetsAndUnorderedAccessViews(uavslot, &rtView, depthView,
-                                                                 uavslot, 1, &initialUAV, &count);
-  m_pImmediateContext->PSSetShader(extract, NULL, 0);
+  ID3D11Buffer *pixelListBuf = MakeCBuffer(UINT(pixelList.size() * sizeof(uint32_t)));
 
-  SAFE_RELEASE(rtView);
-  SAFE_RELEASE(depthView);
+  for(int i = 0; i < D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT; i++)
+    if(rs->PS.ConstantBuffers[i])
+      GetBufferData(rs->PS.ConstantBuffers[i], rs->PS.CBOffsets[i] * sizeof(Vec4f), 0,
+                    batch.cbufData[i], true);
 
+  batch.depthFunc = D3D11_COMPARISON_LESS;
+
+  if(rs->OM.DepthStencilState)
   {
-    D3D11MarkerRegion initState("Replaying event for initial states");
+    D3D11_DEPTH_STENCIL_DESC desc;
+    rs->OM.DepthStencilState->GetDesc(&desc);
+    batch.depthFunc = desc.DepthFunc;
+  }
 
-    m_WrappedDevice->ReplayLog(0, eventID, eReplay_OnlyDraw);
+  batch.structStride = structStride;
+  batch.overdrawLevels = overdrawLevels;
 
-    m_pImmediateContext->CopyResource(stageBuf, initialBuf);
-  }
+  CreateShaderGlobalState(batch.global, dxbc, rs->OM.UAVStartSlot, rs->OM.UAVs, rs->PS.SRVs);
 
-  D3D11_MAPPED_SUBRESOURCE mapped;
-  hr = m_pImmediateContext->Map(stageBuf, 0, D3D11_MAP_READ, 0, &mapped);
+  batch.copyGlobal = false;
+  for(size_t i = 0; i < ARRAY_COUNT(batch.global.uavs); i++)
+    if(!batch.global.uavs[i].data.empty())
+      batch.copyGlobal = true;
 
-  if(FAILED(hr))
+  byte *initialData = new byte[bdesc.ByteWidth];
+
+  for(size_t firstPixel = 0; firstPixel < pixels.size(); firstPixel += pixelsPerReplay)
   {
-    RDCERR("Failed to map stage buff %08x", hr);
-    return empty;
+    uint32_t numPixels = (uint32_t)RDCMIN((size_t)pixelsPerReplay, pixels.size() - firstPixel);
+
+    uint32_t *bounds = &pixelList[0];
+    bounds[0] = bounds[1] = ~0U;
+    bounds[2] = bounds[3] = 0;
+    pixelList[4] = numPixels;
+
+    for(uint32_t p = 0; p < numPixels; p++)
+    {
+      const pair<uint32_t, uint32_t> &coord = pixels[firstPixel + p];
+
+      bounds[0] = RDCMIN(bounds[0], coord.first);
+      bounds[1] = RDCMIN(bounds[1], coord.second);
+      bounds[2] = RDCMAX(bounds[2], coord.first);
+      bounds[3] = RDCMAX(bounds[3], coord.second);
+
+      pixelList[(2 + p) * 4 + 0] = coord.first;
+      pixelList[(2 + p) * 4 + 1] = coord.second;
+    }
+
+    FillCBuffer(pixelListBuf, &pixelList[0], pixelList.size() * sizeof(uint32_t));
+
+    UINT zero = 0;
+    m_pImmediateContext->ClearUnorderedAccessViewUint(initialUAV, &zero);
+
+    UINT count = (UINT)-1;
+    m_pImmediateContext->OMSetRenderTargetsAndUnorderedAccessViews(uavslot, &rtView, depthView,
+                                                                   uavslot, 1, &initialUAV, &count);
+    m_pImmediateContext->PSSetShader(extract, NULL, 0);
+    m_pImmediateContext->PSSetConstantBuffers(0, 1, &pixelListBuf);
+
+    {
+      D3D11MarkerRegion initState("Replaying event for initial states");
+
+      m_WrappedDevice->ReplayLog(0, eventID, eReplay_OnlyDraw);
+
+      m_pImmediateContext->CopyResource(stageBuf, initialBuf);
+    }
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    hr = m_pImmediateContext->Map(stageBuf, 0, D3D11_MAP_READ, 0, &mapped);
+
+    if(FAILED(hr))
+    {
+      RDCERR("Failed to map stage buff %08x", hr);
+      break;
+    }
+
+    memcpy(initialData, mapped.pData, bdesc.ByteWidth);
+
+    m_pImmediateContext->Unmap(stageBuf, 0);
+
+    batch.jobs.clear();
+    batch.hits.clear();
+
+    for(size_t i = 0; i < inputs.size(); i++)
+    {
+      if(inputSlots[i] < firstPixel || inputSlots[i] >= firstPixel + numPixels)
+        continue;
+
+      batch.jobs.push_back(i);
+      batch.hits.push_back(initialData + (inputSlots[i] - firstPixel) * pixelStride);
+    }
+
+    batch.nextJob = 0;
+    batch.numJobs = (int32_t)batch.jobs.size();
+
+    D3D11MarkerRegion simloop("Simulation Loop");
+
+    RunShaderDebugBatch(&D3D11DebugManager::DebugPixelWorker, &batch, (uint32_t)batch.jobs.size());
   }
 
-  byte *initialData = new byte[bdesc.ByteWidth];
-  memcpy(initialData, mapped.pData, bdesc.ByteWidth);
+  SAFE_DELETE_ARRAY(initialData);
 
-  m_pImmediateContext->Unmap(stageBuf, 0);
+  SAFE_RELEASE(rtView);
+  SAFE_RELEASE(depthView);
 
+  SAFE_RELEASE(pixelListBuf);
   SAFE_RELEASE(initialUAV);
   SAFE_RELEASE(initialBuf);
   SAFE_RELEASE(stageBuf);
 
   SAFE_RELEASE(extract);
 
-  DebugHit *buf = (DebugHit *)initialData;
+  return traces;
+}
 
-  D3D11MarkerRegion::Set(StringFormat::Fmt("Got %u hits", buf[0].numHits));
+void D3D11DebugManager::SimulatePixel(PixelDebugBatch &batch, size_t job)
+{
+  using namespace DXBC;
+  using namespace ShaderDebug;
+
+  const ShaderDebugPixelInput &input = (*batch.inputs)[batch.jobs[job]];
+  ShaderDebugTrace &ret = (*batch.traces)[batch.jobs[job]];
+
+  uint32_t x = input.x;
+  uint32_t y = input.y;
+  uint32_t sample = input.sample;
+  uint32_t primitive = input.primitive;
+
+  DXBCFile *dxbc = batch.dxbc;
+  const vector<DataOutput> &initialValues = batch.initialValues;
+  vector<byte> *cbufData = batch.cbufData;
+  uint32_t structStride = batch.structStride;
+  uint32_t overdrawLevels = batch.overdrawLevels;
+  D3D11_COMPARISON_FUNC depthFunc = batch.depthFunc;
+
+  byte *initialData = batch.hits[job];
+
+  DebugHit *buf = (DebugHit *)initialData;
 
   if(buf[0].numHits == 0)
   {
     RDCLOG("No hit for this event");
-    SAFE_DELETE_ARRAY(initialData);
-    return empty;
+    return;
   }
 
   // if we encounter multiple hits at our destination pixel co-ord (or any other) we
@@ -1799,22 +2155,6 @@ ShaderDebugTrace D3D11DebugManager::DebugPixel(uint32_t eventID, uint32_t x, uin
   // get the index of our desired pixel
   int destIdx = (x - xTL) + 2 * (y - yTL);
 
-  vector<byte> cbufData[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
-
-  for(int i = 0; i < D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT; i++)
-    if(rs->PS.ConstantBuffers[i])
-      GetBufferData(rs->PS.ConstantBuffers[i], rs->PS.CBOffsets[i] * sizeof(Vec4f), 0, cbufData[i],
-                    true);
-
-  D3D11_COMPARISON_FUNC depthFunc = D3D11_COMPARISON_LESS;
-
-  if(rs->OM.DepthStencilState)
-  {
-    D3D11_DEPTH_STENCIL_DESC desc;
-    rs->OM.DepthStencilState->GetDesc(&desc);
-    depthFunc = desc.DepthFunc;
-  }
-
   DebugHit *winner = NULL;
 
   if(sample == ~0U)
@@ -1859,19 +2199,26 @@ ShaderDebugTrace D3D11DebugManager::DebugPixel(uint32_t eventID, uint32_t x, uin
   if(winner == NULL)
   {
     RDCLOG("Couldn't find any pixels that passed depth test at target co-ordinates");
-    SAFE_DELETE_ARRAY(initialData);
-    return empty;
+    return;
   }
 
   ShaderDebugTrace traces[4];
 
-  GlobalState global;
-  CreateShaderGlobalState(global, dxbc, rs->OM.UAVStartSlot, rs->OM.UAVs, rs->PS.SRVs);
+  GlobalState localGlobal;
+  GlobalState *globalState = &batch.global;
+
+  if(batch.copyGlobal)
+  {
+    localGlobal = batch.global;
+    globalState = &localGlobal;
+  }
+
+  GlobalState &global = *globalState;
 
   {
     DebugHit *hit = winner;
 
-    State initialState = CreateShaderDebugState(traces[destIdx], destIdx, dxbc, cbufData);
+    State initialState = CreateShaderDebugState(traces[destIdx], destIdx, dxbc, global, cbufData);
 
     rdctype::array<ShaderVariable> &ins = traces[destIdx].inputs;
     if(ins.count > 0 && !strcmp(ins[ins.count - 1].name.elems, "vCoverage"))
@@ -1889,8 +2236,7 @@ ShaderDebugTrace D3D11DebugManager::DebugPixel(uint32_t eventID, uint32_t x, uin
     if(*ddx != 1.0f)
     {
       RDCERR("Derivatives invalid");
-      SAFE_DELETE_ARRAY(initialData);
-      return empty;
+      return;
     }
 
     data++;
@@ -2106,11 +2452,9 @@ ShaderDebugTrace D3D11DebugManager::DebugPixel(uint32_t eventID, uint32_t x, uin
     }
   }
 
-  SAFE_DELETE_ARRAY(initialData);
-
-  vector<ShaderDebugState> states;
+  ShaderDebugTraceBuilder states;
 
-  states.push_back((State)quad[destIdx]);
+  states.AddState(quad[destIdx]);
 
   // ping pong between so that we can have 'current' quad to update into new one
   State quad2[4];
@@ -2123,8 +2467,6 @@ ShaderDebugTrace D3D11DebugManager::DebugPixel(uint32_t eventID, uint32_t x, uin
 
   int cycleCounter = 0;
 
-  D3D11MarkerRegion simloop("Simulation Loop");
-
   // simulate lockstep until all threads are finished
   bool finished = true;
   do
@@ -2143,7 +2485,7 @@ ShaderDebugTrace D3D11DebugManager::DebugPixel(uint32_t eventID, uint32_t x, uin
 
     // if our destination quad is paused don't record multiple identical states.
     if(activeMask[destIdx])
-      states.push_back((State)curquad[destIdx]);
+      states.AddState(curquad[destIdx]);
 
     // we need to make sure that control flow which converges stays in lockstep so that
     // derivatives are still valid. While diverged, we don't have to keep threads in lockstep
@@ -2228,14 +2570,14 @@ ShaderDebugTrace D3D11DebugManager::DebugPixel(uint32_t eventID, uint32_t x, uin
 
     if(cycleCounter == SHADER_DEBUG_WARN_THRESHOLD)
     {
-      if(PromptDebugTimeout(DXBC::TYPE_VERTEX, cycleCounter))
+      if(batch.timeout.Check(DXBC::TYPE_PIXEL, cycleCounter))
         break;
     }
   } while(!finished);
 
-  traces[destIdx].states = states;
+  states.Finish(traces[destIdx]);
 
-  return traces[destIdx];
+  ret = traces[destIdx];
 }
 
 ShaderDebugTrace D3D11DebugManager::DebugThread(uint32_t eventID, const uint32_t groupid[3],
@@ -2278,37 +2620,127 @@ ShaderDebugTrace D3D11DebugManager::DebugThread(uint32_t eventID, const uint32_t
 
   ShaderDebugTrace ret;
 
-  GlobalState global;
-  CreateShaderGlobalState(global, dxbc, 0, rs->CSUAVs, rs->CS.SRVs);
-  State initialState = CreateShaderDebugState(ret, -1, dxbc, cbufData);
+  GlobalState global;
+  CreateShaderGlobalState(global, dxbc, 0, rs->CSUAVs, rs->CS.SRVs);
+  State initialState = CreateShaderDebugState(ret, -1, dxbc, global, cbufData);
+
+  for(int i = 0; i < 3; i++)
+  {
+    initialState.semantics.GroupID[i] = groupid[i];
+    initialState.semantics.ThreadID[i] = threadid[i];
+  }
+
+  ShaderDebugTraceBuilder states;
+
+  states.AddState(initialState);
+
+  const uint32_t *numthreads = global.program.numthreads;
+  uint32_t groupSize = numthreads[0] * numthreads[1] * numthreads[2];
+
+  // threads can only see each other's results through groupshared memory, so without any there's
+  // no need to simulate anything but the thread being debugged.
+  if(global.groupshared.empty() || groupSize <= 1 || groupSize > 1024)
+  {
+    for(int cycleCounter = 0;; cycleCounter++)
+    {
+      if(initialState.Finished())
+        break;
+
+      initialState = initialState.GetNext(global, NULL);
+
+      states.AddState(initialState);
+
+      if(cycleCounter == SHADER_DEBUG_WARN_THRESHOLD)
+      {
+        if(PromptDebugTimeout(DXBC::TYPE_VERTEX, cycleCounter))
+          break;
+      }
+    }
+
+    states.Finish(ret);
+
+    return ret;
+  }
+
+  D3D11MarkerRegion grouploop(StringFormat::Fmt("Simulating %u threads", groupSize));
+
+  // simulate the whole group so that groupshared memory contains what the other threads wrote
+  // by the time the debugged thread reads it. Each thread runs until it finishes or reaches a
+  // barrier, and once every thread is waiting the barrier is released.
+  vector<State> threads(groupSize, initialState);
+  uint32_t destIdx = 0;
+
+  for(uint32_t z = 0; z < numthreads[2]; z++)
+  {
+    for(uint32_t y = 0; y < numthreads[1]; y++)
+    {
+      for(uint32_t x = 0; x < numthreads[0]; x++)
+      {
+        uint32_t idx = (z * numthreads[1] + y) * numthreads[0] + x;
+
+        threads[idx].semantics.ThreadID[0] = x;
+        threads[idx].semantics.ThreadID[1] = y;
+        threads[idx].semantics.ThreadID[2] = z;
+
+        if(x == threadid[0] && y == threadid[1] && z == threadid[2])
+          destIdx = idx;
+      }
+    }
+  }
+
+  int cycleCounter = 0;
+  bool abort = false;
 
-  for(int i = 0; i < 3; i++)
+  while(!abort)
   {
-    initialState.semantics.GroupID[i] = groupid[i];
-    initialState.semantics.ThreadID[i] = threadid[i];
-  }
+    // run every thread up to the next barrier. The debugged thread goes last so that it sees
+    // anything written before the barrier by the others.
+    for(uint32_t t = 0; t <= groupSize && !abort; t++)
+    {
+      uint32_t i = t == groupSize ? destIdx : t;
 
-  vector<ShaderDebugState> states;
+      if(t == destIdx)
+        continue;
 
-  states.push_back((State)initialState);
+      State &s = threads[i];
 
-  for(int cycleCounter = 0;; cycleCounter++)
-  {
-    if(initialState.Finished())
-      break;
+      while(!s.Finished() && !s.AtThreadBarrier())
+      {
+        s = s.GetNext(global, NULL);
 
-    initialState = initialState.GetNext(global, NULL);
+        if(i == destIdx)
+        {
+          states.AddState(s);
+
+          if(cycleCounter++ == SHADER_DEBUG_WARN_THRESHOLD)
+          {
+            if(PromptDebugTimeout(DXBC::TYPE_VERTEX, cycleCounter))
+            {
+              abort = true;
+              break;
+            }
+          }
+        }
+      }
+    }
 
-    states.push_back((State)initialState);
+    if(abort || threads[destIdx].Finished())
+      break;
 
-    if(cycleCounter == SHADER_DEBUG_WARN_THRESHOLD)
+    // every thread is now either finished or waiting, release the barrier
+    for(uint32_t i = 0; i < groupSize; i++)
     {
-      if(PromptDebugTimeout(DXBC::TYPE_VERTEX, cycleCounter))
-        break;
+      if(threads[i].AtThreadBarrier())
+      {
+        threads[i] = threads[i].GetNext(global, NULL);
+
+        if(i == destIdx)
+          states.AddState(threads[i]);
+      }
     }
   }
 
-  ret.states = states;
+  states.Finish(ret);
 
   return ret;
 }
@@ -2481,11 +2913,15 @@ uint32_t D3D11DebugManager::PickVertex(uint32_t eventID, const MeshDisplay &cfg,
 
   HRESULT hr = S_OK;
 
+  // if we're picking in the same mesh as last time, its unpacked data is still in the pick buffers
+  // and only the dispatch itself needs to run again
+  bool upload = !m_DebugRender.PickCache.Matches(eventID, cfg.position);
+
   // most IB/VBs will not be available as SRVs. So, we copy into our own buffers.
   // In the case of VB we also tightly pack and unpack the data. IB can just be
   // read as R16 or R32 via the SRV so it is just a straight copy
 
-  if(cfg.position.idxByteWidth)
+  if(upload && cfg.position.idxByteWidth)
   {
     // resize up on demand
     if(m_DebugRender.PickIBBuf == NULL ||
@@ -2548,8 +2984,8 @@ uint32_t D3D11DebugManager::PickVertex(uint32_t eventID, const MeshDisplay &cfg,
     m_pImmediateContext->CopySubresourceRegion(m_DebugRender.PickIBBuf, 0, 0, 0, 0, ib, 0, &box);
   }
 
-  if(m_DebugRender.PickVBBuf == NULL ||
-     m_DebugRender.PickVBSize < cfg.position.numVerts * sizeof(Vec4f))
+  if(upload && (m_DebugRender.PickVBBuf == NULL ||
+                 m_DebugRender.PickVBSize < cfg.position.numVerts * sizeof(Vec4f)))
   {
     SAFE_RELEASE(m_DebugRender.PickVBBuf);
     SAFE_RELEASE(m_DebugRender.PickVBSRV);
@@ -2589,6 +3025,7 @@ uint32_t D3D11DebugManager::PickVertex(uint32_t eventID, const MeshDisplay &cfg,
   }
 
   // unpack and linearise the data
+  if(upload)
   {
     FloatVector *vbData = new FloatVector[cfg.position.numVerts];
 
@@ -2623,6 +3060,8 @@ uint32_t D3D11DebugManager::PickVertex(uint32_t eventID, const MeshDisplay &cfg,
                                            sizeof(Vec4f));
 
     delete[] vbData;
+
+    m_DebugRender.PickCache.Set(eventID, cfg.position);
   }
 
   ID3D11ShaderResourceView *srvs[2] = {m_DebugRender.PickIBSRV, m_DebugRender.PickVBSRV};
@@ -2812,6 +3251,32 @@ void D3D11DebugManager::PickPixel(ResourceId texture, uint32_t x, uint32_t y, ui
   m_pImmediateContext->Unmap(m_DebugRender.PickPixelStageTex, 0);
 }
 
+HRESULT D3D11DebugManager::GetStagingTexture2D(const D3D11_TEXTURE2D_DESC &desc,
+                                               ID3D11Texture2D **tex)
+{
+  // repeated reads of the same texture, or of same-sized textures, are the common case so only
+  // recreate when the desc changes. The caller gets its own reference to release as normal
+  if(m_StagingTex2D == NULL || memcmp(&desc, &m_StagingTex2DDesc, sizeof(desc)) != 0)
+  {
+    SAFE_RELEASE(m_StagingTex2D);
+
+    HRESULT hr = m_WrappedDevice->CreateTexture2D(&desc, NULL, &m_StagingTex2D);
+
+    if(FAILED(hr))
+    {
+      m_StagingTex2D = NULL;
+      return hr;
+    }
+
+    m_StagingTex2DDesc = desc;
+  }
+
+  m_StagingTex2D->AddRef();
+  *tex = m_StagingTex2D;
+
+  return S_OK;
+}
+
 byte *D3D11DebugManager::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
                                         const GetTextureDataParams &params, size_t &dataSize)
 {
@@ -2997,7 +3462,7 @@ byte *D3D11DebugManager::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint3
 
     subresource = arrayIdx * mips + mip;
 
-    HRESULT hr = m_WrappedDevice->CreateTexture2D(&desc, NULL, &d);
+    HRESULT hr = GetStagingTexture2D(desc, &d);
 
     dummyTex = d;
 
@@ -4742,6 +5207,159 @@ void D3D11DebugManager::PixelHistoryCopyPixel(CopyPixelParams &p, uint32_t x, ui
     SAFE_RELEASE(curCSUAV[i]);
 }
 
+void D3D11DebugManager::PixelHistoryCapturePrimitives(const vector<PixelModification> &history,
+                                                      uint32_t x, uint32_t y, uint32_t sampleMask,
+                                                      ID3D11DepthStencilView *dsv,
+                                                      map<uint32_t, vector<uint32_t> > &primitives)
+{
+  // count how many fragments we expect from each event, so that anything the capture got wrong
+  // can be detected and left to the slower path
+  map<uint32_t, uint32_t> fragCounts;
+
+  for(size_t h = 0; h < history.size(); h++)
+  {
+    const DrawcallDescription *draw = m_WrappedDevice->GetDrawcall(history[h].eventID);
+
+    // primitive IDs restart with each instance, so fragments can't be ordered by them alone
+    if((draw->flags & DrawFlags::Clear) || !(draw->flags & DrawFlags::Drawcall) ||
+       draw->numInstances > 1 || history[h].directShaderWrite)
+      continue;
+
+    fragCounts[history[h].eventID]++;
+  }
+
+  if(fragCounts.empty())
+    return;
+
+  D3D11MarkerRegion capture("capturing fragment primitives");
+
+  uint32_t cbufData[4] = {x, y, 0, sampleMask};
+  ID3D11Buffer *cbuf = MakeCBuffer(sizeof(cbufData));
+
+  float xf = (float)x;
+  float yf = (float)y;
+
+  D3D11_VIEWPORT curViewports[16] = {0};
+  D3D11_RECT newScissors[16] = {0};
+
+  UINT initCount = 0;
+
+  for(auto it = fragCounts.begin(); it != fragCounts.end(); ++it)
+  {
+    m_WrappedDevice->ReplayLog(0, it->first, eReplay_WithoutDraw);
+
+    UINT curNumViews = 16;
+    m_pImmediateContext->RSGetViewports(&curNumViews, curViewports);
+
+    for(UINT v = 0; v < curNumViews; v++)
+    {
+      // if (x,y) pixel isn't in viewport, make empty rect)
+      if(xf < curViewports[v].TopLeftX || yf < curViewports[v].TopLeftY ||
+         xf >= curViewports[v].TopLeftX + curViewports[v].Width ||
+         yf >= curViewports[v].TopLeftY + curViewports[v].Height)
+      {
+        newScissors[v].left = newScissors[v].top = newScissors[v].bottom = newScissors[v].right = 0;
+      }
+      else
+      {
+        newScissors[v].left = LONG(x);
+        newScissors[v].top = LONG(y);
+        newScissors[v].right = newScissors[v].left + 1;
+        newScissors[v].bottom = newScissors[v].top + 1;
+      }
+    }
+
+    m_pImmediateContext->RSSetScissorRects(curNumViews, newScissors);
+
+    // same rasterization as the original draw, so we get the same set of fragments that the
+    // stencil counting saw.
+    D3D11_RASTERIZER_DESC rd = {
+        /*FillMode =*/D3D11_FILL_SOLID,
+        /*CullMode =*/D3D11_CULL_BACK,
+        /*FrontCounterClockwise =*/FALSE,
+        /*DepthBias =*/D3D11_DEFAULT_DEPTH_BIAS,
+        /*DepthBiasClamp =*/D3D11_DEFAULT_DEPTH_BIAS_CLAMP,
+        /*SlopeScaledDepthBias =*/D3D11_DEFAULT_SLOPE_SCALED_DEPTH_BIAS,
+        /*DepthClipEnable =*/TRUE,
+        /*ScissorEnable =*/FALSE,
+        /*MultisampleEnable =*/FALSE,
+        /*AntialiasedLineEnable =*/FALSE,
+    };
+
+    ID3D11RasterizerState *curRS = NULL;
+    m_pImmediateContext->RSGetState(&curRS);
+    if(curRS)
+      curRS->GetDesc(&rd);
+    SAFE_RELEASE(curRS);
+
+    rd.ScissorEnable = TRUE;
+
+    ID3D11RasterizerState *newRS = NULL;
+    m_pDevice->CreateRasterizerState(&rd, &newRS);
+    m_pImmediateContext->RSSetState(newRS);
+    SAFE_RELEASE(newRS);
+
+    cbufData[2] = it->first;
+    FillCBuffer(cbuf, cbufData, sizeof(cbufData));
+
+    m_pImmediateContext->PSSetShader(m_DebugRender.PixelHistoryCapturePS, NULL, 0);
+    m_pImmediateContext->PSSetConstantBuffers(0, 1, &cbuf);
+
+    m_pImmediateContext->OMSetDepthStencilState(m_DebugRender.NopDepthState, 0);
+
+    // the counter is only reset on the first event, the rest append after it
+    m_pImmediateContext->OMSetRenderTargetsAndUnorderedAccessViews(
+        0, NULL, dsv, 0, 1, &m_DebugRender.PixelHistoryCaptureUAV, &initCount);
+    initCount = ~0U;
+
+    m_WrappedDevice->ReplayLog(0, it->first, eReplay_OnlyDraw);
+  }
+
+  m_pImmediateContext->OMSetRenderTargets(0, NULL, NULL);
+
+  SAFE_RELEASE(cbuf);
+
+  m_pImmediateContext->CopyStructureCount(m_DebugRender.histogramBuff, 0,
+                                          m_DebugRender.PixelHistoryCaptureUAV);
+
+  vector<byte> results;
+  GetBufferData(m_DebugRender.histogramBuff, 0, 0, results, false);
+
+  uint32_t numResults = results.size() >= sizeof(uint32_t) ? *(uint32_t *)&results[0] : 0;
+
+  if(numResults == 0)
+    return;
+
+  if(numResults > DebugRenderData::maxCapturedFragments)
+  {
+    RDCWARN("Too many fragments captured (%u), falling back to per-fragment primitive IDs",
+            numResults);
+    return;
+  }
+
+  GetBufferData(m_DebugRender.PixelHistoryCaptureBuf, 0, numResults * sizeof(uint32_t) * 2,
+                results, false);
+
+  uint32_t *records = (uint32_t *)&results[0];
+
+  for(uint32_t i = 0; i < numResults; i++)
+    primitives[records[i * 2 + 0]].push_back(records[i * 2 + 1]);
+
+  // the appends from each draw are unordered, but fragments at the same pixel within a draw are
+  // rasterized in primitive order. Anything that doesn't match the count we expect is discarded.
+  for(auto it = primitives.begin(); it != primitives.end();)
+  {
+    if(it->second.size() != fragCounts[it->first])
+    {
+      it = primitives.erase(it);
+      continue;
+    }
+
+    std::sort(it->second.begin(), it->second.end());
+    ++it;
+  }
+}
+
 vector<PixelModification> D3D11DebugManager::PixelHistory(vector<EventUsage> events,
                                                           ResourceId target, uint32_t x, uint32_t y,
                                                           uint32_t slice, uint32_t mip,
@@ -5286,6 +5904,18 @@ vector<PixelModification> D3D11DebugManager::PixelHistory(vector<EventUsage> eve
 
   for(size_t ev = 0; ev < events.size(); ev++)
   {
+    // stop before replaying any more events. The queries for the rest were never issued, so
+    // release them here and only look at the events that were replayed.
+    if(RenderDoc::Inst().IsReplayCancelled())
+    {
+      for(size_t i = ev; i < occl.size(); i++)
+        SAFE_RELEASE(occl[i]);
+
+      occl.resize(ev);
+      events.resize(ev);
+      break;
+    }
+
     curNumInst = D3D11_SHADER_MAX_INTERFACES;
     curNumScissors = curNumViews = 16;
 
@@ -6476,6 +7106,16 @@ vector<PixelModification> D3D11DebugManager::PixelHistory(vector<EventUsage> eve
 
   uint32_t prev = 0;
 
+  /////////////////////////////////////////////////////////////////////////
+  // capture all of the primitive IDs for each event on the GPU, with one draw per event that
+  // appends a record for each fragment, instead of a separate draw and readback per fragment.
+  // Any events that can't be captured this way fall back to fetching them below.
+
+  map<uint32_t, vector<uint32_t> > capturedPrimitives;
+
+  if(m_DebugRender.PixelHistoryCapturePS && m_DebugRender.PixelHistoryCaptureUAV)
+    PixelHistoryCapturePrimitives(history, x, y, sampleMask, shaddepthOutputDSV, capturedPrimitives);
+
   /////////////////////////////////////////////////////////////////////////
   // loop for each fragment, for non-final fragments fetch the post-output
   // buffer value, and for each fetch the shader output value
@@ -6689,7 +7329,23 @@ vector<PixelModification> D3D11DebugManager::PixelHistory(vector<EventUsage> eve
       m_pImmediateContext->ClearDepthStencilView(
           shaddepthOutputDSV, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, cleardepth, 0);
 
-      // fetch primitive ID
+      // fetch primitive ID, unless it was already captured above. The slot is still reserved so
+      // the layout of the shader output store stays the same.
+      if(capturedPrimitives.find(history[h].eventID) != capturedPrimitives.end())
+      {
+        m_pImmediateContext->PSGetShader(&curPS, curInst, &curNumInst);
+
+        if(curPS == NULL)
+          history[h].unboundPS = true;
+
+        for(UINT i = 0; i < curNumInst; i++)
+          SAFE_RELEASE(curInst[i]);
+
+        SAFE_RELEASE(curPS);
+
+        shadColSlot++;
+      }
+      else
       {
         D3D11MarkerRegion primid("fetching prim ID");
 
@@ -6909,7 +7565,12 @@ vector<PixelModification> D3D11DebugManager::PixelHistory(vector<EventUsage> eve
 
       bool someFragsClipped = history[h].primitiveID != 0;
 
-      memcpy(&history[h].primitiveID, data, sizeof(uint32_t));
+      auto captured = capturedPrimitives.find(history[h].eventID);
+
+      if(captured != capturedPrimitives.end() && history[h].fragIndex < captured->second.size())
+        history[h].primitiveID = captured->second[history[h].fragIndex];
+      else
+        memcpy(&history[h].primitiveID, data, sizeof(uint32_t));
 
       shadColSlot++;
 
@@ -7177,3 +7838,189 @@ vector<PixelModification> D3D11DebugManager::PixelHistory(vector<EventUsage> eve
 
   return history;
 }
+
+vector<vector<PixelModification> > D3D11DebugManager::PixelHistoryRegion(
+    vector<EventUsage> events, ResourceId target, uint32_t x, uint32_t y, uint32_t width,
+    uint32_t height, uint32_t slice, uint32_t mip, uint32_t sampleIdx, CompType typeHint)
+{
+  vector<vector<PixelModification> > history(width * height);
+
+  if(events.empty() || width == 0 || height == 0)
+    return history;
+
+  if(width == 1 && height == 1)
+  {
+    history[0] = PixelHistory(events, target, x, y, slice, mip, sampleIdx, typeHint);
+    return history;
+  }
+
+  D3D11MarkerRegion historyMarker(StringFormat::Fmt(
+      "Doing PixelHistoryRegion on %llu, (%u,%u) %ux%u %u, %u, %u over %u events", target, x, y,
+      width, height, slice, mip, sampleIdx, (uint32_t)events.size()));
+
+  SCOPED_TIMER("D3D11DebugManager::PixelHistoryRegion");
+
+  // before the full history is fetched for each pixel, replay every event once with all tests
+  // disabled and a scissor around the whole region. A draw that doesn't rasterize anywhere in the
+  // region can't have modified any of its pixels, so it's removed for every pixel at once instead
+  // of being replayed and read back again for each one.
+  vector<ID3D11Query *> occl(events.size(), NULL);
+
+  const D3D11_QUERY_DESC occlDesc = {D3D11_QUERY_OCCLUSION_PREDICATE, 0};
+
+  D3D11_RECT regionScissors[16];
+  for(size_t i = 0; i < ARRAY_COUNT(regionScissors); i++)
+  {
+    regionScissors[i].left = LONG(x);
+    regionScissors[i].top = LONG(y);
+    regionScissors[i].right = LONG(x + width);
+    regionScissors[i].bottom = LONG(y + height);
+  }
+
+  m_WrappedDevice->ReplayLog(0, events[0].eventID, eReplay_WithoutDraw);
+
+  for(size_t ev = 0; ev < events.size(); ev++)
+  {
+    // queries are only created for events we get to, so the rest are simply left NULL
+    if(RenderDoc::Inst().IsReplayCancelled())
+      break;
+
+    const DrawcallDescription *draw = m_WrappedDevice->GetDrawcall(events[ev].eventID);
+
+    // only normal rasterized output can be culled this way. Clears, copies and shader writes are
+    // left for the per-pixel history to handle.
+    bool rasterized = draw && (draw->flags & DrawFlags::Drawcall) &&
+                      (events[ev].usage == ResourceUsage::ColorTarget ||
+                       events[ev].usage == ResourceUsage::DepthStencilTarget);
+
+    if(rasterized)
+      m_pDevice->CreateQuery(&occlDesc, &occl[ev]);
+
+    if(occl[ev])
+    {
+      ID3D11RasterizerState *curRS = NULL;
+      ID3D11RasterizerState *newRS = NULL;
+      ID3D11PixelShader *curPS = NULL;
+      ID3D11ClassInstance *curInst[D3D11_SHADER_MAX_INTERFACES] = {NULL};
+      UINT curNumInst = D3D11_SHADER_MAX_INTERFACES;
+      UINT curNumViews = 16;
+      UINT curNumScissors = 16;
+      D3D11_VIEWPORT curViewports[16] = {0};
+      D3D11_RECT curScissors[16] = {0};
+      ID3D11BlendState *curBS = NULL;
+      float blendFactor[4] = {0};
+      UINT curSample = 0;
+      ID3D11DepthStencilState *curDS = NULL;
+      UINT stencilRef = 0;
+
+      m_pImmediateContext->RSGetState(&curRS);
+      m_pImmediateContext->OMGetBlendState(&curBS, blendFactor, &curSample);
+      m_pImmediateContext->OMGetDepthStencilState(&curDS, &stencilRef);
+      m_pImmediateContext->PSGetShader(&curPS, curInst, &curNumInst);
+      m_pImmediateContext->RSGetViewports(&curNumViews, curViewports);
+      m_pImmediateContext->RSGetScissorRects(&curNumScissors, curScissors);
+
+      D3D11_RASTERIZER_DESC rd = {
+          /*FillMode =*/D3D11_FILL_SOLID,
+          /*CullMode =*/D3D11_CULL_NONE,
+          /*FrontCounterClockwise =*/FALSE,
+          /*DepthBias =*/D3D11_DEFAULT_DEPTH_BIAS,
+          /*DepthBiasClamp =*/D3D11_DEFAULT_DEPTH_BIAS_CLAMP,
+          /*SlopeScaledDepthBias =*/D3D11_DEFAULT_SLOPE_SCALED_DEPTH_BIAS,
+          /*DepthClipEnable =*/FALSE,
+          /*ScissorEnable =*/TRUE,
+          /*MultisampleEnable =*/FALSE,
+          /*AntialiasedLineEnable =*/FALSE,
+      };
+
+      if(curRS)
+      {
+        curRS->GetDesc(&rd);
+
+        rd.CullMode = D3D11_CULL_NONE;
+        rd.DepthClipEnable = FALSE;
+        rd.ScissorEnable = TRUE;
+      }
+
+      m_pDevice->CreateRasterizerState(&rd, &newRS);
+      m_pImmediateContext->RSSetState(newRS);
+      SAFE_RELEASE(newRS);
+
+      m_pImmediateContext->PSSetShader(m_DebugRender.OverlayPS, NULL, 0);
+
+      m_pImmediateContext->OMSetBlendState(m_DebugRender.NopBlendState, blendFactor, ~0U);
+      m_pImmediateContext->OMSetDepthStencilState(m_DebugRender.NopDepthState, stencilRef);
+
+      m_pImmediateContext->RSSetScissorRects(RDCMAX(1U, curNumViews), regionScissors);
+
+      m_pImmediateContext->Begin(occl[ev]);
+
+      m_WrappedDevice->ReplayLog(0, events[ev].eventID, eReplay_OnlyDraw);
+
+      m_pImmediateContext->End(occl[ev]);
+
+      m_pImmediateContext->RSSetState(curRS);
+      m_pImmediateContext->RSSetScissorRects(curNumScissors, curScissors);
+      m_pImmediateContext->PSSetShader(curPS, curInst, curNumInst);
+      m_pImmediateContext->OMSetBlendState(curBS, blendFactor, curSample);
+      m_pImmediateContext->OMSetDepthStencilState(curDS, stencilRef);
+
+      for(UINT i = 0; i < curNumInst; i++)
+        SAFE_RELEASE(curInst[i]);
+
+      SAFE_RELEASE(curPS);
+      SAFE_RELEASE(curRS);
+      SAFE_RELEASE(curBS);
+      SAFE_RELEASE(curDS);
+    }
+
+    // replay the event itself so later events see the right contents
+    m_WrappedDevice->ReplayLog(events[ev].eventID, events[ev].eventID, eReplay_OnlyDraw);
+
+    if(ev < events.size() - 1)
+      m_WrappedDevice->ReplayLog(events[ev].eventID + 1, events[ev + 1].eventID, eReplay_WithoutDraw);
+  }
+
+  vector<EventUsage> candidates;
+  candidates.reserve(events.size());
+
+  for(size_t ev = 0; ev < events.size(); ev++)
+  {
+    if(occl[ev])
+    {
+      BOOL occlData = FALSE;
+      HRESULT hr = S_OK;
+
+      do
+      {
+        hr = m_pImmediateContext->GetData(occl[ev], &occlData, sizeof(occlData), 0);
+      } while(hr == S_FALSE);
+
+      SAFE_RELEASE(occl[ev]);
+
+      // nothing rasterized in the region at all
+      if(hr == S_OK && !occlData)
+        continue;
+    }
+
+    candidates.push_back(events[ev]);
+  }
+
+  RDCDEBUG("PixelHistoryRegion on %llu, %u of %u events touch the %ux%u region", target,
+           (uint32_t)candidates.size(), (uint32_t)events.size(), width, height);
+
+  if(candidates.empty() || RenderDoc::Inst().IsReplayCancelled())
+    return history;
+
+  for(uint32_t py = 0; py < height; py++)
+  {
+    if(RenderDoc::Inst().IsReplayCancelled())
+      break;
+
+    for(uint32_t px = 0; px < width; px++)
+      history[py * width + px] =
+          PixelHistory(candidates, target, x + px, y + py, slice, mip, sampleIdx, typeHint);
+  }
+
+  return history;
+}
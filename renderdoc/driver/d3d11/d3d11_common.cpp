@@ -412,29 +412,6 @@ ShaderReflection *MakeShaderReflection(DXBC::DXBCFile *dxbc)
 
   ShaderReflection *ret = new ShaderReflection();
 
-  if(dxbc->m_DebugInfo)
-  {
-    ret->DebugInfo.entryFunc = dxbc->m_DebugInfo->GetEntryFunction();
-    ret->DebugInfo.compileFlags = dxbc->m_DebugInfo->GetShaderCompileFlags();
-
-    ret->DebugInfo.entryFile = -1;
-
-    create_array_uninit(ret->DebugInfo.files, dxbc->m_DebugInfo->Files.size());
-    for(size_t i = 0; i < dxbc->m_DebugInfo->Files.size(); i++)
-    {
-      ret->DebugInfo.files[i].first = dxbc->m_DebugInfo->Files[i].first;
-      ret->DebugInfo.files[i].second = dxbc->m_DebugInfo->Files[i].second;
-
-      if(ret->DebugInfo.entryFile == -1 &&
-         strstr(ret->DebugInfo.files[i].second.elems, ret->DebugInfo.entryFunc.elems))
-      {
-        ret->DebugInfo.entryFile = (int32_t)i;
-      }
-    }
-  }
-
-  ret->Disassembly = dxbc->GetDisassembly();
-
   if(dxbc->m_ShaderBlob.empty())
     create_array_uninit(ret->RawBytes, 0);
   else
@@ -447,6 +424,8 @@ ShaderReflection *MakeShaderReflection(DXBC::DXBCFile *dxbc)
   ret->InputSig = dxbc->m_InputSig;
   ret->OutputSig = dxbc->m_OutputSig;
 
+  DXBC::MakeShaderCost(dxbc, ret);
+
   create_array_uninit(ret->ConstantBlocks, dxbc->m_CBuffers.size());
   for(size_t i = 0; i < dxbc->m_CBuffers.size(); i++)
   {
@@ -372,6 +372,8 @@ enum D3D11ChunkType
 
   SWAP_DEVICE_STATE,
 
+  CONTEXT_FRAME_BOUNDARY,    // chunk between frames in a multi-frame capture
+
   NUM_D3D11_CHUNKS,
 };
 
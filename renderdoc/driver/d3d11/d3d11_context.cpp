@@ -148,6 +148,11 @@ WrappedID3D11DeviceContext::WrappedID3D11DeviceContext(WrappedID3D11Device *real
     m_ContextRecord->NumSubResources = 0;
     m_ContextRecord->SubResources = NULL;
     m_ContextRecord->ignoreSerialise = true;
+
+    // deferred contexts are only recorded from one thread at a time, and their chunks are only
+    // placed relative to others once they're executed, so they can be recorded without locking
+    if(context->GetType() == D3D11_DEVICE_CONTEXT_DEFERRED)
+      m_ContextRecord->SetDeferChunkIDs(true);
   }
 
   m_SuccessfulCapture = true;
@@ -383,6 +388,104 @@ void WrappedID3D11DeviceContext::MarkResourceReferenced(ResourceId id, FrameRefT
   }
 }
 
+void WrappedID3D11DeviceContext::MarkSubresourcesReferenced(ID3D11Resource *res, UINT minMip,
+                                                            UINT maxMip, UINT minSlice,
+                                                            UINT maxSlice, FrameRefType refType)
+{
+  ResourceId id = GetIDForResource(res);
+
+  // deferred contexts track whole resources, which are merged in when the command list is
+  // executed.
+  if(m_pRealContext->GetType() != D3D11_DEVICE_CONTEXT_IMMEDIATE || id == ResourceId())
+  {
+    MarkResourceReferenced(id, refType);
+    return;
+  }
+
+  UINT numMips = 0, numSlices = 1;
+
+  if(WrappedID3D11Texture1D::IsAlloc(res))
+  {
+    D3D11_TEXTURE1D_DESC desc;
+    ((ID3D11Texture1D *)res)->GetDesc(&desc);
+    numMips = desc.MipLevels;
+    numSlices = desc.ArraySize;
+  }
+  else if(WrappedID3D11Texture2D1::IsAlloc(res))
+  {
+    D3D11_TEXTURE2D_DESC desc;
+    ((ID3D11Texture2D *)res)->GetDesc(&desc);
+
+    // multisampled initial contents are stored per-sample, so keep them whole
+    if(desc.SampleDesc.Count <= 1)
+    {
+      numMips = desc.MipLevels;
+      numSlices = desc.ArraySize;
+    }
+  }
+  else if(WrappedID3D11Texture3D1::IsAlloc(res))
+  {
+    D3D11_TEXTURE3D_DESC desc;
+    ((ID3D11Texture3D *)res)->GetDesc(&desc);
+    numMips = desc.MipLevels;
+
+    // the view's slices are depth slices, which aren't separate subresources
+    minSlice = maxSlice = 0;
+  }
+
+  if(numMips == 0)
+  {
+    MarkResourceReferenced(id, refType);
+    return;
+  }
+
+  maxMip = RDCMIN(maxMip, numMips - 1);
+  maxSlice = RDCMIN(maxSlice, numSlices - 1);
+
+  if(minMip == 0 && minSlice == 0 && maxMip == numMips - 1 && maxSlice == numSlices - 1)
+  {
+    MarkResourceReferenced(id, refType);
+    return;
+  }
+
+  for(UINT slice = minSlice; slice <= maxSlice; slice++)
+    for(UINT mip = minMip; mip <= maxMip; mip++)
+      m_pDevice->GetResourceManager()->MarkSubresourceFrameReferenced(
+          id, D3D11CalcSubresource(mip, slice, numMips), refType);
+}
+
+void WrappedID3D11DeviceContext::MarkViewResourceReferenced(ID3D11ShaderResourceView *view,
+                                                            FrameRefType refType)
+{
+  D3D11RenderState::ResourceRange range(view);
+  MarkSubresourcesReferenced((ID3D11Resource *)range.resource, range.minMip, range.maxMip,
+                             range.minSlice, range.maxSlice, refType);
+}
+
+void WrappedID3D11DeviceContext::MarkViewResourceReferenced(ID3D11UnorderedAccessView *view,
+                                                            FrameRefType refType)
+{
+  D3D11RenderState::ResourceRange range(view);
+  MarkSubresourcesReferenced((ID3D11Resource *)range.resource, range.minMip, range.maxMip,
+                             range.minSlice, range.maxSlice, refType);
+}
+
+void WrappedID3D11DeviceContext::MarkViewResourceReferenced(ID3D11RenderTargetView *view,
+                                                            FrameRefType refType)
+{
+  D3D11RenderState::ResourceRange range(view);
+  MarkSubresourcesReferenced((ID3D11Resource *)range.resource, range.minMip, range.maxMip,
+                             range.minSlice, range.maxSlice, refType);
+}
+
+void WrappedID3D11DeviceContext::MarkViewResourceReferenced(ID3D11DepthStencilView *view,
+                                                            FrameRefType refType)
+{
+  D3D11RenderState::ResourceRange range(view);
+  MarkSubresourcesReferenced((ID3D11Resource *)range.resource, range.minMip, range.maxMip,
+                             range.minSlice, range.maxSlice, refType);
+}
+
 void WrappedID3D11DeviceContext::MarkDirtyResource(ResourceId id)
 {
   if(m_pRealContext->GetType() == D3D11_DEVICE_CONTEXT_IMMEDIATE)
@@ -425,6 +528,8 @@ void WrappedID3D11DeviceContext::AttemptCapture()
 {
   m_State = WRITING_CAPFRAME;
 
+  m_SyncedMapShadows.clear();
+
   m_FailureReason = CaptureSucceeded;
 
   // deferred contexts are initially NOT successful unless empty. That's because we don't have the
@@ -516,6 +621,14 @@ void WrappedID3D11DeviceContext::Present(UINT SyncInterval, UINT Flags)
   m_ContextRecord->AddChunk(scope.Get());
 }
 
+void WrappedID3D11DeviceContext::FrameBoundary()
+{
+  SCOPED_SERIALISE_CONTEXT(CONTEXT_FRAME_BOUNDARY);
+  m_pSerialiser->Serialise("context", m_ResourceID);
+
+  m_ContextRecord->AddChunk(scope.Get());
+}
+
 void WrappedID3D11DeviceContext::FreeCaptureData()
 {
   SCOPED_LOCK(m_pDevice->D3DLock());
@@ -543,6 +656,8 @@ void WrappedID3D11DeviceContext::FreeCaptureData()
 
     record->FreeShadowStorage();
   }
+
+  m_SyncedMapShadows.clear();
 }
 
 void WrappedID3D11DeviceContext::CleanupCapture()
@@ -815,6 +930,24 @@ void WrappedID3D11DeviceContext::ProcessChunk(uint64_t offset, D3D11ChunkType ch
       }
     }
     break;
+    case CONTEXT_FRAME_BOUNDARY:
+    {
+      // this always follows a present chunk, which provides the event. Unlike the footer the frame
+      // carries on afterwards
+      if(m_State == READING)
+      {
+        m_pDevice->GetFrameRecord().frameInfo.frameCount++;
+
+        DrawcallDescription draw;
+        draw.name = "Present()";
+        draw.flags |= DrawFlags::Present;
+
+        draw.copyDestination = m_pDevice->GetBackbufferResourceID();
+
+        AddDrawcall(draw, true);
+      }
+    }
+    break;
     default: RDCERR("Unrecognised Chunk type %d", chunk); break;
   }
 
@@ -1011,6 +1144,8 @@ void WrappedID3D11DeviceContext::AddEvent(string description)
   APIEvent apievent;
 
   apievent.fileOffset = m_CurChunkOffset;
+  m_pSerialiser->GetChunkTiming(m_CurChunkOffset, apievent.cpuTimestamp, apievent.threadID);
+  m_pSerialiser->GetChunkResourceRefs(apievent.referencedResources);
   apievent.eventID = m_CurEventID;
 
   apievent.eventDesc = description;
@@ -1464,6 +1599,9 @@ void WrappedID3D11DeviceContext::ReplayLog(LogState readType, uint32_t startEven
 
     uint64_t offset = m_pSerialiser->GetOffset();
 
+    if(m_State == EXECUTING && m_CurEventID > startEventID)
+      m_pDevice->CheckpointReplay(m_CurEventID, offset);
+
     D3D11ChunkType chunktype = (D3D11ChunkType)m_pSerialiser->PushContext(NULL, NULL, 1, false);
 
     ProcessChunk(offset, chunktype, false);
@@ -1568,6 +1706,20 @@ void WrappedID3D11DeviceContext::ReplayLog(LogState readType, uint32_t startEven
   m_DoStateVerify = false;
 }
 
+void WrappedID3D11DeviceContext::ApplyReplayState(const D3D11RenderState &savedState)
+{
+  D3D11RenderState state(savedState);
+
+  m_DoStateVerify = false;
+  {
+    *m_CurrentPipelineState = state;
+    m_CurrentPipelineState->SetDevice(m_pDevice);
+    state.ApplyState(this);
+  }
+  m_DoStateVerify = true;
+  VerifyState();
+}
+
 void WrappedID3D11DeviceContext::ClearMaps()
 {
   auto it = m_OpenMaps.begin();
@@ -45,6 +45,7 @@ struct MapIntercept
     MapType = D3D11_MAP_WRITE_DISCARD;
     MapFlags = 0;
     verifyWrite = false;
+    d3dContentsKept = false;
   }
 
   void SetAppMemory(void *appMemory);
@@ -66,6 +67,9 @@ struct MapIntercept
 
   bool verifyWrite;
 
+  // the real map preserved the previous contents, so only changed bytes need to be copied back
+  bool d3dContentsKept;
+
   void CopyFromD3D();
   void CopyToD3D(size_t RangeStart = 0, size_t RangeEnd = 0);
 };
@@ -150,6 +154,10 @@ private:
   set<ResourceId> m_HighTrafficResources;
   map<MappedResource, MapIntercept> m_OpenMaps;
 
+  // buffers whose real contents are known to match the shadow copy, since this context last wrote
+  // the whole thing back on unmap. No-overwrite maps on these can be passed through as-is.
+  set<ResourceId> m_SyncedMapShadows;
+
   struct StreamOutData
   {
     StreamOutData() : query(NULL), running(false), numPrims(0) {}
@@ -256,6 +264,9 @@ private:
                                ID3D11DepthStencilView *DSV, UINT UAVStartSlot, UINT NumUAVs,
                                ID3D11UnorderedAccessView *UAVs[]);
 
+  void MarkSubresourcesReferenced(ID3D11Resource *res, UINT minMip, UINT maxMip, UINT minSlice,
+                                  UINT maxSlice, FrameRefType refType);
+
   ////////////////////////////////////////////////////////////////
   // implement InterceptorSystem privately, since it is not thread safe (like all other context
   // functions)
@@ -286,6 +297,8 @@ public:
 
   // insert a fake chunk just to store these parameters
   void Present(UINT SyncInterval, UINT Flags);
+  // marks the end of a frame, after Present(), when a capture carries on into the next frame
+  void FrameBoundary();
 
   void CleanupCapture();
   void FreeCaptureData();
@@ -311,8 +324,18 @@ public:
 
   void MarkResourceReferenced(ResourceId id, FrameRefType refType);
 
+  // mark the resource a view points to as referenced, restricted to the subresources the view
+  // covers. The view itself must still be marked separately.
+  void MarkViewResourceReferenced(ID3D11ShaderResourceView *view, FrameRefType refType);
+  void MarkViewResourceReferenced(ID3D11UnorderedAccessView *view, FrameRefType refType);
+  void MarkViewResourceReferenced(ID3D11RenderTargetView *view, FrameRefType refType);
+  void MarkViewResourceReferenced(ID3D11DepthStencilView *view, FrameRefType refType);
+
   vector<EventUsage> GetUsage(ResourceId id) { return m_ResourceUses[id]; }
   void ClearMaps();
+  bool HasOpenMaps() { return !m_OpenMaps.empty(); }
+  // apply a saved pipeline state as if replay had reached it, e.g. from a replay checkpoint
+  void ApplyReplayState(const D3D11RenderState &state);
 
   uint32_t GetEventID() { return m_CurEventID; }
   APIEvent GetEvent(uint32_t eventID);
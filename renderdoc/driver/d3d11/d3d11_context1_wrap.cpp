@@ -313,6 +313,7 @@ void WrappedID3D11DeviceContext::UpdateSubresource1(ID3D11Resource *pDstResource
                                                     const void *pSrcData, UINT SrcRowPitch,
                                                     UINT SrcDepthPitch, UINT CopyFlags)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::UpdateSubresource1");
   if(m_pRealContext1 == NULL)
     return;
 
@@ -393,6 +394,7 @@ void WrappedID3D11DeviceContext::CopySubresourceRegion1(ID3D11Resource *pDstReso
                                                         UINT SrcSubresource,
                                                         const D3D11_BOX *pSrcBox, UINT CopyFlags)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::CopySubresourceRegion1");
   if(m_pRealContext1 == NULL)
     return;
 
@@ -491,6 +493,7 @@ bool WrappedID3D11DeviceContext::Serialise_ClearView(ID3D11View *pView, const FL
 void WrappedID3D11DeviceContext::ClearView(ID3D11View *pView, const FLOAT Color[4],
                                            const D3D11_RECT *pRect, UINT NumRects)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::ClearView");
   if(m_pRealContext1 == NULL)
     return;
 
@@ -629,6 +632,7 @@ void WrappedID3D11DeviceContext::VSSetConstantBuffers1(UINT StartSlot, UINT NumB
                                                        const UINT *pFirstConstant,
                                                        const UINT *pNumConstants)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::VSSetConstantBuffers1");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -778,6 +782,7 @@ void WrappedID3D11DeviceContext::HSSetConstantBuffers1(UINT StartSlot, UINT NumB
                                                        const UINT *pFirstConstant,
                                                        const UINT *pNumConstants)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::HSSetConstantBuffers1");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -927,6 +932,7 @@ void WrappedID3D11DeviceContext::DSSetConstantBuffers1(UINT StartSlot, UINT NumB
                                                        const UINT *pFirstConstant,
                                                        const UINT *pNumConstants)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::DSSetConstantBuffers1");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -1076,6 +1082,7 @@ void WrappedID3D11DeviceContext::GSSetConstantBuffers1(UINT StartSlot, UINT NumB
                                                        const UINT *pFirstConstant,
                                                        const UINT *pNumConstants)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::GSSetConstantBuffers1");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -1225,6 +1232,7 @@ void WrappedID3D11DeviceContext::PSSetConstantBuffers1(UINT StartSlot, UINT NumB
                                                        const UINT *pFirstConstant,
                                                        const UINT *pNumConstants)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::PSSetConstantBuffers1");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -1374,6 +1382,7 @@ void WrappedID3D11DeviceContext::CSSetConstantBuffers1(UINT StartSlot, UINT NumB
                                                        const UINT *pFirstConstant,
                                                        const UINT *pNumConstants)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::CSSetConstantBuffers1");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -1443,6 +1452,7 @@ void WrappedID3D11DeviceContext::VSGetConstantBuffers1(UINT StartSlot, UINT NumB
                                                        ID3D11Buffer **ppConstantBuffers,
                                                        UINT *pFirstConstant, UINT *pNumConstants)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::VSGetConstantBuffers1");
   if(m_pRealContext1 == NULL || !m_SetCBuffer1)
   {
     VSGetConstantBuffers(StartSlot, NumBuffers, ppConstantBuffers);
@@ -1484,6 +1494,7 @@ void WrappedID3D11DeviceContext::HSGetConstantBuffers1(UINT StartSlot, UINT NumB
                                                        ID3D11Buffer **ppConstantBuffers,
                                                        UINT *pFirstConstant, UINT *pNumConstants)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::HSGetConstantBuffers1");
   if(m_pRealContext1 == NULL || !m_SetCBuffer1)
   {
     HSGetConstantBuffers(StartSlot, NumBuffers, ppConstantBuffers);
@@ -1525,6 +1536,7 @@ void WrappedID3D11DeviceContext::DSGetConstantBuffers1(UINT StartSlot, UINT NumB
                                                        ID3D11Buffer **ppConstantBuffers,
                                                        UINT *pFirstConstant, UINT *pNumConstants)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::DSGetConstantBuffers1");
   if(m_pRealContext1 == NULL || !m_SetCBuffer1)
   {
     DSGetConstantBuffers(StartSlot, NumBuffers, ppConstantBuffers);
@@ -1566,6 +1578,7 @@ void WrappedID3D11DeviceContext::GSGetConstantBuffers1(UINT StartSlot, UINT NumB
                                                        ID3D11Buffer **ppConstantBuffers,
                                                        UINT *pFirstConstant, UINT *pNumConstants)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::GSGetConstantBuffers1");
   if(m_pRealContext1 == NULL || !m_SetCBuffer1)
   {
     GSGetConstantBuffers(StartSlot, NumBuffers, ppConstantBuffers);
@@ -1607,6 +1620,7 @@ void WrappedID3D11DeviceContext::PSGetConstantBuffers1(UINT StartSlot, UINT NumB
                                                        ID3D11Buffer **ppConstantBuffers,
                                                        UINT *pFirstConstant, UINT *pNumConstants)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::PSGetConstantBuffers1");
   if(m_pRealContext1 == NULL || !m_SetCBuffer1)
   {
     PSGetConstantBuffers(StartSlot, NumBuffers, ppConstantBuffers);
@@ -1648,6 +1662,7 @@ void WrappedID3D11DeviceContext::CSGetConstantBuffers1(UINT StartSlot, UINT NumB
                                                        ID3D11Buffer **ppConstantBuffers,
                                                        UINT *pFirstConstant, UINT *pNumConstants)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::CSGetConstantBuffers1");
   if(m_pRealContext1 == NULL || !m_SetCBuffer1)
   {
     CSGetConstantBuffers(StartSlot, NumBuffers, ppConstantBuffers);
@@ -1724,6 +1739,7 @@ bool WrappedID3D11DeviceContext::Serialise_DiscardResource(ID3D11Resource *pReso
 
 void WrappedID3D11DeviceContext::DiscardResource(ID3D11Resource *pResource)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::DiscardResource");
   if(m_pRealContext1 == NULL)
     return;
 
@@ -1834,6 +1850,7 @@ bool WrappedID3D11DeviceContext::Serialise_DiscardView(ID3D11View *pResourceView
 
 void WrappedID3D11DeviceContext::DiscardView(ID3D11View *pResourceView)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::DiscardView");
   if(m_pRealContext1 == NULL)
     return;
 
@@ -1950,6 +1967,7 @@ bool WrappedID3D11DeviceContext::Serialise_DiscardView1(ID3D11View *pResourceVie
 void WrappedID3D11DeviceContext::DiscardView1(ID3D11View *pResourceView, const D3D11_RECT *pRects,
                                               UINT NumRects)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::DiscardView1");
   if(m_pRealContext1 == NULL)
     return;
 
@@ -2039,6 +2057,7 @@ bool WrappedID3D11DeviceContext::Serialise_SwapDeviceContextState(
 void WrappedID3D11DeviceContext::SwapDeviceContextState(ID3DDeviceContextState *pState,
                                                         ID3DDeviceContextState **ppPreviousState)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::SwapDeviceContextState");
   if(m_pRealContext1 == NULL)
     return;
 
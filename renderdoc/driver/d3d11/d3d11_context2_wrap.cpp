@@ -34,6 +34,7 @@ HRESULT WrappedID3D11DeviceContext::UpdateTileMappings(
     UINT NumRanges, const UINT *pRangeFlags, const UINT *pTilePoolStartOffsets,
     const UINT *pRangeTileCounts, UINT Flags)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::UpdateTileMappings");
   RDCUNIMPLEMENTED(
       "Tiled resources are not yet supported. Please contact me if you have a working example!");
 
@@ -53,6 +54,7 @@ HRESULT WrappedID3D11DeviceContext::CopyTileMappings(
     const D3D11_TILED_RESOURCE_COORDINATE *pSourceRegionStartCoordinate,
     const D3D11_TILE_REGION_SIZE *pTileRegionSize, UINT Flags)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::CopyTileMappings");
   RDCUNIMPLEMENTED(
       "Tiled resources are not yet supported. Please contact me if you have a working example!");
 
@@ -69,6 +71,7 @@ void WrappedID3D11DeviceContext::CopyTiles(
     const D3D11_TILE_REGION_SIZE *pTileRegionSize, ID3D11Buffer *pBuffer,
     UINT64 BufferStartOffsetInBytes, UINT Flags)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::CopyTiles");
   RDCUNIMPLEMENTED(
       "Tiled resources are not yet supported. Please contact me if you have a working example!");
 
@@ -84,6 +87,7 @@ void WrappedID3D11DeviceContext::UpdateTiles(
     const D3D11_TILED_RESOURCE_COORDINATE *pDestTileRegionStartCoordinate,
     const D3D11_TILE_REGION_SIZE *pDestTileRegionSize, const void *pSourceTileData, UINT Flags)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::UpdateTiles");
   RDCUNIMPLEMENTED(
       "Tiled resources are not yet supported. Please contact me if you have a working example!");
 
@@ -96,6 +100,7 @@ void WrappedID3D11DeviceContext::UpdateTiles(
 
 HRESULT WrappedID3D11DeviceContext::ResizeTilePool(ID3D11Buffer *pTilePool, UINT64 NewSizeInBytes)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::ResizeTilePool");
   RDCUNIMPLEMENTED(
       "Tiled resources are not yet supported. Please contact me if you have a working example!");
 
@@ -109,6 +114,7 @@ void WrappedID3D11DeviceContext::TiledResourceBarrier(
     ID3D11DeviceChild *pTiledResourceOrViewAccessBeforeBarrier,
     ID3D11DeviceChild *pTiledResourceOrViewAccessAfterBarrier)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::TiledResourceBarrier");
   RDCUNIMPLEMENTED(
       "Tiled resources are not yet supported. Please contact me if you have a working example!");
 
@@ -121,20 +127,24 @@ void WrappedID3D11DeviceContext::TiledResourceBarrier(
 
 BOOL WrappedID3D11DeviceContext::IsAnnotationEnabled()
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::IsAnnotationEnabled");
   return TRUE;
 }
 
 void WrappedID3D11DeviceContext::SetMarkerInt(LPCWSTR pLabel, INT Data)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::SetMarkerInt");
   SetMarker(0, pLabel);
 }
 
 void WrappedID3D11DeviceContext::BeginEventInt(LPCWSTR pLabel, INT Data)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::BeginEventInt");
   PushEvent(0, pLabel);
 }
 
 void WrappedID3D11DeviceContext::EndEvent()
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::EndEvent");
   PopEvent();
 }
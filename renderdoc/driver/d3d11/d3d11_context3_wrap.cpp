@@ -29,6 +29,7 @@
 
 void WrappedID3D11DeviceContext::Flush1(D3D11_CONTEXT_TYPE ContextType, HANDLE hEvent)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::Flush1");
   if(m_pRealContext3 == NULL)
     return;
 
@@ -37,6 +38,7 @@ void WrappedID3D11DeviceContext::Flush1(D3D11_CONTEXT_TYPE ContextType, HANDLE h
 
 void WrappedID3D11DeviceContext::SetHardwareProtectionState(BOOL HwProtectionEnable)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::SetHardwareProtectionState");
   if(m_pRealContext3 == NULL)
     return;
 
@@ -45,6 +47,7 @@ void WrappedID3D11DeviceContext::SetHardwareProtectionState(BOOL HwProtectionEna
 
 void WrappedID3D11DeviceContext::GetHardwareProtectionState(BOOL *pHwProtectionEnable)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::GetHardwareProtectionState");
   if(m_pRealContext3 == NULL)
     return;
 
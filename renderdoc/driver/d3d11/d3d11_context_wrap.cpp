@@ -248,6 +248,7 @@ void WrappedID3D11DeviceContext::DrainAnnotationQueue()
 
 void WrappedID3D11DeviceContext::IAGetInputLayout(ID3D11InputLayout **ppInputLayout)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::IAGetInputLayout");
   if(ppInputLayout)
   {
     ID3D11InputLayout *real = NULL;
@@ -265,6 +266,7 @@ void WrappedID3D11DeviceContext::IAGetVertexBuffers(UINT StartSlot, UINT NumBuff
                                                     ID3D11Buffer **ppVertexBuffers, UINT *pStrides,
                                                     UINT *pOffsets)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::IAGetVertexBuffers");
   ID3D11Buffer *real[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT] = {0};
   m_pRealContext->IAGetVertexBuffers(StartSlot, NumBuffers, real, pStrides, pOffsets);
 
@@ -288,6 +290,7 @@ void WrappedID3D11DeviceContext::IAGetVertexBuffers(UINT StartSlot, UINT NumBuff
 void WrappedID3D11DeviceContext::IAGetIndexBuffer(ID3D11Buffer **pIndexBuffer, DXGI_FORMAT *Format,
                                                   UINT *Offset)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::IAGetIndexBuffer");
   if(pIndexBuffer)
   {
     ID3D11Buffer *real = NULL;
@@ -308,6 +311,7 @@ void WrappedID3D11DeviceContext::IAGetIndexBuffer(ID3D11Buffer **pIndexBuffer, D
 
 void WrappedID3D11DeviceContext::IAGetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY *pTopology)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::IAGetPrimitiveTopology");
   m_pRealContext->IAGetPrimitiveTopology(pTopology);
   if(pTopology)
     RDCASSERT(*pTopology == m_CurrentPipelineState->IA.Topo);
@@ -329,6 +333,7 @@ bool WrappedID3D11DeviceContext::Serialise_IASetPrimitiveTopology(D3D11_PRIMITIV
 
 void WrappedID3D11DeviceContext::IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY Topology)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::IASetPrimitiveTopology");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -371,6 +376,7 @@ bool WrappedID3D11DeviceContext::Serialise_IASetInputLayout(ID3D11InputLayout *p
 
 void WrappedID3D11DeviceContext::IASetInputLayout(ID3D11InputLayout *pInputLayout)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::IASetInputLayout");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -447,6 +453,7 @@ void WrappedID3D11DeviceContext::IASetVertexBuffers(UINT StartSlot, UINT NumBuff
                                                     ID3D11Buffer *const *ppVertexBuffers,
                                                     const UINT *pStrides, const UINT *pOffsets)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::IASetVertexBuffers");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -506,6 +513,7 @@ bool WrappedID3D11DeviceContext::Serialise_IASetIndexBuffer(ID3D11Buffer *pIndex
 void WrappedID3D11DeviceContext::IASetIndexBuffer(ID3D11Buffer *pIndexBuffer, DXGI_FORMAT Format,
                                                   UINT Offset)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::IASetIndexBuffer");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -536,6 +544,7 @@ void WrappedID3D11DeviceContext::IASetIndexBuffer(ID3D11Buffer *pIndexBuffer, DX
 void WrappedID3D11DeviceContext::VSGetConstantBuffers(UINT StartSlot, UINT NumBuffers,
                                                       ID3D11Buffer **ppConstantBuffers)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::VSGetConstantBuffers");
   if(ppConstantBuffers)
   {
     ID3D11Buffer *real[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT] = {0};
@@ -555,6 +564,7 @@ void WrappedID3D11DeviceContext::VSGetConstantBuffers(UINT StartSlot, UINT NumBu
 void WrappedID3D11DeviceContext::VSGetShaderResources(UINT StartSlot, UINT NumViews,
                                                       ID3D11ShaderResourceView **ppShaderResourceViews)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::VSGetShaderResources");
   if(ppShaderResourceViews)
   {
     ID3D11ShaderResourceView *real[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT] = {0};
@@ -575,6 +585,7 @@ void WrappedID3D11DeviceContext::VSGetShaderResources(UINT StartSlot, UINT NumVi
 void WrappedID3D11DeviceContext::VSGetSamplers(UINT StartSlot, UINT NumSamplers,
                                                ID3D11SamplerState **ppSamplers)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::VSGetSamplers");
   if(ppSamplers)
   {
     ID3D11SamplerState *real[D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT] = {0};
@@ -595,6 +606,7 @@ void WrappedID3D11DeviceContext::VSGetShader(ID3D11VertexShader **ppVertexShader
                                              ID3D11ClassInstance **ppClassInstances,
                                              UINT *pNumClassInstances)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::VSGetShader");
   if(ppVertexShader == NULL && ppClassInstances == NULL && pNumClassInstances == NULL)
     return;
 
@@ -676,6 +688,7 @@ bool WrappedID3D11DeviceContext::Serialise_VSSetConstantBuffers(UINT StartSlot_,
 void WrappedID3D11DeviceContext::VSSetConstantBuffers(UINT StartSlot, UINT NumBuffers,
                                                       ID3D11Buffer *const *ppConstantBuffers)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::VSSetConstantBuffers");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -750,6 +763,7 @@ bool WrappedID3D11DeviceContext::Serialise_VSSetShaderResources(
 void WrappedID3D11DeviceContext::VSSetShaderResources(
     UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView *const *ppShaderResourceViews)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::VSSetShaderResources");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -771,11 +785,8 @@ void WrappedID3D11DeviceContext::VSSetShaderResources(
   {
     if(ppShaderResourceViews[i] && m_State >= WRITING_CAPFRAME)
     {
-      ID3D11Resource *res = NULL;
-      ppShaderResourceViews[i]->GetResource(&res);
       MarkResourceReferenced(GetIDForResource(ppShaderResourceViews[i]), eFrameRef_Read);
-      MarkResourceReferenced(GetIDForResource(res), eFrameRef_Read);
-      SAFE_RELEASE(res);
+      MarkViewResourceReferenced(ppShaderResourceViews[i], eFrameRef_Read);
     }
 
     SRVs[i] = UNWRAP(WrappedID3D11ShaderResourceView1, ppShaderResourceViews[i]);
@@ -826,6 +837,7 @@ bool WrappedID3D11DeviceContext::Serialise_VSSetSamplers(UINT StartSlot_, UINT N
 void WrappedID3D11DeviceContext::VSSetSamplers(UINT StartSlot, UINT NumSamplers,
                                                ID3D11SamplerState *const *ppSamplers)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::VSSetSamplers");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -900,6 +912,7 @@ void WrappedID3D11DeviceContext::VSSetShader(ID3D11VertexShader *pVertexShader,
                                              ID3D11ClassInstance *const *ppClassInstances,
                                              UINT NumClassInstances)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::VSSetShader");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -938,6 +951,7 @@ void WrappedID3D11DeviceContext::VSSetShader(ID3D11VertexShader *pVertexShader,
 void WrappedID3D11DeviceContext::HSGetConstantBuffers(UINT StartSlot, UINT NumBuffers,
                                                       ID3D11Buffer **ppConstantBuffers)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::HSGetConstantBuffers");
   if(ppConstantBuffers)
   {
     ID3D11Buffer *real[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT] = {0};
@@ -957,6 +971,7 @@ void WrappedID3D11DeviceContext::HSGetConstantBuffers(UINT StartSlot, UINT NumBu
 void WrappedID3D11DeviceContext::HSGetShaderResources(UINT StartSlot, UINT NumViews,
                                                       ID3D11ShaderResourceView **ppShaderResourceViews)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::HSGetShaderResources");
   if(ppShaderResourceViews)
   {
     ID3D11ShaderResourceView *real[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT] = {0};
@@ -977,6 +992,7 @@ void WrappedID3D11DeviceContext::HSGetShaderResources(UINT StartSlot, UINT NumVi
 void WrappedID3D11DeviceContext::HSGetSamplers(UINT StartSlot, UINT NumSamplers,
                                                ID3D11SamplerState **ppSamplers)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::HSGetSamplers");
   if(ppSamplers)
   {
     ID3D11SamplerState *real[D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT] = {0};
@@ -997,6 +1013,7 @@ void WrappedID3D11DeviceContext::HSGetShader(ID3D11HullShader **ppHullShader,
                                              ID3D11ClassInstance **ppClassInstances,
                                              UINT *pNumClassInstances)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::HSGetShader");
   if(ppHullShader == NULL && ppClassInstances == NULL && pNumClassInstances == NULL)
     return;
 
@@ -1081,6 +1098,7 @@ bool WrappedID3D11DeviceContext::Serialise_HSSetConstantBuffers(UINT StartSlot_,
 void WrappedID3D11DeviceContext::HSSetConstantBuffers(UINT StartSlot, UINT NumBuffers,
                                                       ID3D11Buffer *const *ppConstantBuffers)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::HSSetConstantBuffers");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -1155,6 +1173,7 @@ bool WrappedID3D11DeviceContext::Serialise_HSSetShaderResources(
 void WrappedID3D11DeviceContext::HSSetShaderResources(
     UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView *const *ppShaderResourceViews)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::HSSetShaderResources");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -1176,11 +1195,8 @@ void WrappedID3D11DeviceContext::HSSetShaderResources(
   {
     if(ppShaderResourceViews[i] && m_State >= WRITING_CAPFRAME)
     {
-      ID3D11Resource *res = NULL;
-      ppShaderResourceViews[i]->GetResource(&res);
       MarkResourceReferenced(GetIDForResource(ppShaderResourceViews[i]), eFrameRef_Read);
-      MarkResourceReferenced(GetIDForResource(res), eFrameRef_Read);
-      SAFE_RELEASE(res);
+      MarkViewResourceReferenced(ppShaderResourceViews[i], eFrameRef_Read);
     }
 
     SRVs[i] = UNWRAP(WrappedID3D11ShaderResourceView1, ppShaderResourceViews[i]);
@@ -1231,6 +1247,7 @@ bool WrappedID3D11DeviceContext::Serialise_HSSetSamplers(UINT StartSlot_, UINT N
 void WrappedID3D11DeviceContext::HSSetSamplers(UINT StartSlot, UINT NumSamplers,
                                                ID3D11SamplerState *const *ppSamplers)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::HSSetSamplers");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -1305,6 +1322,7 @@ void WrappedID3D11DeviceContext::HSSetShader(ID3D11HullShader *pHullShader,
                                              ID3D11ClassInstance *const *ppClassInstances,
                                              UINT NumClassInstances)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::HSSetShader");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -1343,6 +1361,7 @@ void WrappedID3D11DeviceContext::HSSetShader(ID3D11HullShader *pHullShader,
 void WrappedID3D11DeviceContext::DSGetConstantBuffers(UINT StartSlot, UINT NumBuffers,
                                                       ID3D11Buffer **ppConstantBuffers)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::DSGetConstantBuffers");
   if(ppConstantBuffers)
   {
     ID3D11Buffer *real[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT] = {0};
@@ -1362,6 +1381,7 @@ void WrappedID3D11DeviceContext::DSGetConstantBuffers(UINT StartSlot, UINT NumBu
 void WrappedID3D11DeviceContext::DSGetShaderResources(UINT StartSlot, UINT NumViews,
                                                       ID3D11ShaderResourceView **ppShaderResourceViews)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::DSGetShaderResources");
   if(ppShaderResourceViews)
   {
     ID3D11ShaderResourceView *real[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT] = {0};
@@ -1382,6 +1402,7 @@ void WrappedID3D11DeviceContext::DSGetShaderResources(UINT StartSlot, UINT NumVi
 void WrappedID3D11DeviceContext::DSGetSamplers(UINT StartSlot, UINT NumSamplers,
                                                ID3D11SamplerState **ppSamplers)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::DSGetSamplers");
   if(ppSamplers)
   {
     ID3D11SamplerState *real[D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT] = {0};
@@ -1402,6 +1423,7 @@ void WrappedID3D11DeviceContext::DSGetShader(ID3D11DomainShader **ppDomainShader
                                              ID3D11ClassInstance **ppClassInstances,
                                              UINT *pNumClassInstances)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::DSGetShader");
   if(ppDomainShader == NULL && ppClassInstances == NULL && pNumClassInstances == NULL)
     return;
 
@@ -1485,6 +1507,7 @@ bool WrappedID3D11DeviceContext::Serialise_DSSetConstantBuffers(UINT StartSlot_,
 void WrappedID3D11DeviceContext::DSSetConstantBuffers(UINT StartSlot, UINT NumBuffers,
                                                       ID3D11Buffer *const *ppConstantBuffers)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::DSSetConstantBuffers");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -1559,6 +1582,7 @@ bool WrappedID3D11DeviceContext::Serialise_DSSetShaderResources(
 void WrappedID3D11DeviceContext::DSSetShaderResources(
     UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView *const *ppShaderResourceViews)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::DSSetShaderResources");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -1580,11 +1604,8 @@ void WrappedID3D11DeviceContext::DSSetShaderResources(
   {
     if(ppShaderResourceViews[i] && m_State >= WRITING_CAPFRAME)
     {
-      ID3D11Resource *res = NULL;
-      ppShaderResourceViews[i]->GetResource(&res);
       MarkResourceReferenced(GetIDForResource(ppShaderResourceViews[i]), eFrameRef_Read);
-      MarkResourceReferenced(GetIDForResource(res), eFrameRef_Read);
-      SAFE_RELEASE(res);
+      MarkViewResourceReferenced(ppShaderResourceViews[i], eFrameRef_Read);
     }
 
     SRVs[i] = UNWRAP(WrappedID3D11ShaderResourceView1, ppShaderResourceViews[i]);
@@ -1635,6 +1656,7 @@ bool WrappedID3D11DeviceContext::Serialise_DSSetSamplers(UINT StartSlot_, UINT N
 void WrappedID3D11DeviceContext::DSSetSamplers(UINT StartSlot, UINT NumSamplers,
                                                ID3D11SamplerState *const *ppSamplers)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::DSSetSamplers");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -1709,6 +1731,7 @@ void WrappedID3D11DeviceContext::DSSetShader(ID3D11DomainShader *pDomainShader,
                                              ID3D11ClassInstance *const *ppClassInstances,
                                              UINT NumClassInstances)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::DSSetShader");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -1747,6 +1770,7 @@ void WrappedID3D11DeviceContext::DSSetShader(ID3D11DomainShader *pDomainShader,
 void WrappedID3D11DeviceContext::GSGetConstantBuffers(UINT StartSlot, UINT NumBuffers,
                                                       ID3D11Buffer **ppConstantBuffers)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::GSGetConstantBuffers");
   if(ppConstantBuffers)
   {
     ID3D11Buffer *real[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT] = {0};
@@ -1766,6 +1790,7 @@ void WrappedID3D11DeviceContext::GSGetConstantBuffers(UINT StartSlot, UINT NumBu
 void WrappedID3D11DeviceContext::GSGetShaderResources(UINT StartSlot, UINT NumViews,
                                                       ID3D11ShaderResourceView **ppShaderResourceViews)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::GSGetShaderResources");
   if(ppShaderResourceViews)
   {
     ID3D11ShaderResourceView *real[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT] = {0};
@@ -1786,6 +1811,7 @@ void WrappedID3D11DeviceContext::GSGetShaderResources(UINT StartSlot, UINT NumVi
 void WrappedID3D11DeviceContext::GSGetSamplers(UINT StartSlot, UINT NumSamplers,
                                                ID3D11SamplerState **ppSamplers)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::GSGetSamplers");
   if(ppSamplers)
   {
     ID3D11SamplerState *real[D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT] = {0};
@@ -1806,6 +1832,7 @@ void WrappedID3D11DeviceContext::GSGetShader(ID3D11GeometryShader **ppGeometrySh
                                              ID3D11ClassInstance **ppClassInstances,
                                              UINT *pNumClassInstances)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::GSGetShader");
   if(ppGeometryShader == NULL && ppClassInstances == NULL && pNumClassInstances == NULL)
     return;
 
@@ -1890,6 +1917,7 @@ bool WrappedID3D11DeviceContext::Serialise_GSSetConstantBuffers(UINT StartSlot_,
 void WrappedID3D11DeviceContext::GSSetConstantBuffers(UINT StartSlot, UINT NumBuffers,
                                                       ID3D11Buffer *const *ppConstantBuffers)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::GSSetConstantBuffers");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -1964,6 +1992,7 @@ bool WrappedID3D11DeviceContext::Serialise_GSSetShaderResources(
 void WrappedID3D11DeviceContext::GSSetShaderResources(
     UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView *const *ppShaderResourceViews)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::GSSetShaderResources");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -1985,11 +2014,8 @@ void WrappedID3D11DeviceContext::GSSetShaderResources(
   {
     if(ppShaderResourceViews[i] && m_State >= WRITING_CAPFRAME)
     {
-      ID3D11Resource *res = NULL;
-      ppShaderResourceViews[i]->GetResource(&res);
       MarkResourceReferenced(GetIDForResource(ppShaderResourceViews[i]), eFrameRef_Read);
-      MarkResourceReferenced(GetIDForResource(res), eFrameRef_Read);
-      SAFE_RELEASE(res);
+      MarkViewResourceReferenced(ppShaderResourceViews[i], eFrameRef_Read);
     }
 
     SRVs[i] = UNWRAP(WrappedID3D11ShaderResourceView1, ppShaderResourceViews[i]);
@@ -2040,6 +2066,7 @@ bool WrappedID3D11DeviceContext::Serialise_GSSetSamplers(UINT StartSlot_, UINT N
 void WrappedID3D11DeviceContext::GSSetSamplers(UINT StartSlot, UINT NumSamplers,
                                                ID3D11SamplerState *const *ppSamplers)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::GSSetSamplers");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -2114,6 +2141,7 @@ void WrappedID3D11DeviceContext::GSSetShader(ID3D11GeometryShader *pShader,
                                              ID3D11ClassInstance *const *ppClassInstances,
                                              UINT NumClassInstances)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::GSSetShader");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -2151,6 +2179,7 @@ void WrappedID3D11DeviceContext::GSSetShader(ID3D11GeometryShader *pShader,
 
 void WrappedID3D11DeviceContext::SOGetTargets(UINT NumBuffers, ID3D11Buffer **ppSOTargets)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::SOGetTargets");
   if(ppSOTargets)
   {
     ID3D11Buffer *real[D3D11_SO_BUFFER_SLOT_COUNT] = {0};
@@ -2269,6 +2298,7 @@ bool WrappedID3D11DeviceContext::Serialise_SOSetTargets(UINT NumBuffers_,
 void WrappedID3D11DeviceContext::SOSetTargets(UINT NumBuffers, ID3D11Buffer *const *ppSOTargets,
                                               const UINT *pOffsets)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::SOSetTargets");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -2370,6 +2400,7 @@ void WrappedID3D11DeviceContext::SOSetTargets(UINT NumBuffers, ID3D11Buffer *con
 
 void WrappedID3D11DeviceContext::RSGetViewports(UINT *pNumViewports, D3D11_VIEWPORT *pViewports)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::RSGetViewports");
   m_pRealContext->RSGetViewports(pNumViewports, pViewports);
 
   if(pViewports)
@@ -2379,6 +2410,7 @@ void WrappedID3D11DeviceContext::RSGetViewports(UINT *pNumViewports, D3D11_VIEWP
 
 void WrappedID3D11DeviceContext::RSGetScissorRects(UINT *pNumRects, D3D11_RECT *pRects)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::RSGetScissorRects");
   m_pRealContext->RSGetScissorRects(pNumRects, pRects);
 
   if(pRects)
@@ -2388,6 +2420,7 @@ void WrappedID3D11DeviceContext::RSGetScissorRects(UINT *pNumRects, D3D11_RECT *
 
 void WrappedID3D11DeviceContext::RSGetState(ID3D11RasterizerState **ppRasterizerState)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::RSGetState");
   if(ppRasterizerState)
   {
     ID3D11RasterizerState *real = NULL;
@@ -2445,6 +2478,7 @@ bool WrappedID3D11DeviceContext::Serialise_RSSetViewports(UINT NumViewports_,
 
 void WrappedID3D11DeviceContext::RSSetViewports(UINT NumViewports, const D3D11_VIEWPORT *pViewports)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::RSSetViewports");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -2487,6 +2521,7 @@ bool WrappedID3D11DeviceContext::Serialise_RSSetScissorRects(UINT NumRects_, con
 
 void WrappedID3D11DeviceContext::RSSetScissorRects(UINT NumRects, const D3D11_RECT *pRects)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::RSSetScissorRects");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -2532,6 +2567,7 @@ bool WrappedID3D11DeviceContext::Serialise_RSSetState(ID3D11RasterizerState *pRa
 
 void WrappedID3D11DeviceContext::RSSetState(ID3D11RasterizerState *pRasterizerState)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::RSSetState");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -2559,6 +2595,7 @@ void WrappedID3D11DeviceContext::RSSetState(ID3D11RasterizerState *pRasterizerSt
 void WrappedID3D11DeviceContext::PSGetConstantBuffers(UINT StartSlot, UINT NumBuffers,
                                                       ID3D11Buffer **ppConstantBuffers)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::PSGetConstantBuffers");
   if(ppConstantBuffers)
   {
     ID3D11Buffer *real[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT] = {0};
@@ -2578,6 +2615,7 @@ void WrappedID3D11DeviceContext::PSGetConstantBuffers(UINT StartSlot, UINT NumBu
 void WrappedID3D11DeviceContext::PSGetShaderResources(UINT StartSlot, UINT NumViews,
                                                       ID3D11ShaderResourceView **ppShaderResourceViews)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::PSGetShaderResources");
   if(ppShaderResourceViews)
   {
     ID3D11ShaderResourceView *real[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT] = {0};
@@ -2598,6 +2636,7 @@ void WrappedID3D11DeviceContext::PSGetShaderResources(UINT StartSlot, UINT NumVi
 void WrappedID3D11DeviceContext::PSGetSamplers(UINT StartSlot, UINT NumSamplers,
                                                ID3D11SamplerState **ppSamplers)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::PSGetSamplers");
   if(ppSamplers)
   {
     ID3D11SamplerState *real[D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT] = {0};
@@ -2618,6 +2657,7 @@ void WrappedID3D11DeviceContext::PSGetShader(ID3D11PixelShader **ppPixelShader,
                                              ID3D11ClassInstance **ppClassInstances,
                                              UINT *pNumClassInstances)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::PSGetShader");
   if(ppPixelShader == NULL && ppClassInstances == NULL && pNumClassInstances == NULL)
     return;
 
@@ -2699,6 +2739,7 @@ bool WrappedID3D11DeviceContext::Serialise_PSSetConstantBuffers(UINT StartSlot_,
 void WrappedID3D11DeviceContext::PSSetConstantBuffers(UINT StartSlot, UINT NumBuffers,
                                                       ID3D11Buffer *const *ppConstantBuffers)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::PSSetConstantBuffers");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -2771,6 +2812,7 @@ bool WrappedID3D11DeviceContext::Serialise_PSSetShaderResources(
 void WrappedID3D11DeviceContext::PSSetShaderResources(
     UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView *const *ppShaderResourceViews)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::PSSetShaderResources");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -2792,11 +2834,8 @@ void WrappedID3D11DeviceContext::PSSetShaderResources(
   {
     if(ppShaderResourceViews[i] && m_State >= WRITING_CAPFRAME)
     {
-      ID3D11Resource *res = NULL;
-      ppShaderResourceViews[i]->GetResource(&res);
       MarkResourceReferenced(GetIDForResource(ppShaderResourceViews[i]), eFrameRef_Read);
-      MarkResourceReferenced(GetIDForResource(res), eFrameRef_Read);
-      SAFE_RELEASE(res);
+      MarkViewResourceReferenced(ppShaderResourceViews[i], eFrameRef_Read);
     }
 
     SRVs[i] = UNWRAP(WrappedID3D11ShaderResourceView1, ppShaderResourceViews[i]);
@@ -2845,6 +2884,7 @@ bool WrappedID3D11DeviceContext::Serialise_PSSetSamplers(UINT StartSlot_, UINT N
 void WrappedID3D11DeviceContext::PSSetSamplers(UINT StartSlot, UINT NumSamplers,
                                                ID3D11SamplerState *const *ppSamplers)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::PSSetSamplers");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -2919,6 +2959,7 @@ void WrappedID3D11DeviceContext::PSSetShader(ID3D11PixelShader *pPixelShader,
                                              ID3D11ClassInstance *const *ppClassInstances,
                                              UINT NumClassInstances)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::PSSetShader");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -2958,6 +2999,7 @@ void WrappedID3D11DeviceContext::OMGetRenderTargets(UINT NumViews,
                                                     ID3D11RenderTargetView **ppRenderTargetViews,
                                                     ID3D11DepthStencilView **ppDepthStencilView)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::OMGetRenderTargets");
   if(ppRenderTargetViews == NULL && ppDepthStencilView == NULL)
     return;
 
@@ -2996,6 +3038,7 @@ void WrappedID3D11DeviceContext::OMGetRenderTargetsAndUnorderedAccessViews(
     ID3D11DepthStencilView **ppDepthStencilView, UINT UAVStartSlot, UINT NumUAVs,
     ID3D11UnorderedAccessView **ppUnorderedAccessViews)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::OMGetRenderTargetsAndUnorderedAccessViews");
   if(ppRenderTargetViews == NULL && ppDepthStencilView == NULL && ppUnorderedAccessViews == NULL)
     return;
 
@@ -3049,6 +3092,7 @@ void WrappedID3D11DeviceContext::OMGetRenderTargetsAndUnorderedAccessViews(
 void WrappedID3D11DeviceContext::OMGetBlendState(ID3D11BlendState **ppBlendState,
                                                  FLOAT BlendFactor[4], UINT *pSampleMask)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::OMGetBlendState");
   ID3D11BlendState *real = NULL;
   m_pRealContext->OMGetBlendState(&real, BlendFactor, pSampleMask);
 
@@ -3078,6 +3122,7 @@ void WrappedID3D11DeviceContext::OMGetBlendState(ID3D11BlendState **ppBlendState
 void WrappedID3D11DeviceContext::OMGetDepthStencilState(ID3D11DepthStencilState **ppDepthStencilState,
                                                         UINT *pStencilRef)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::OMGetDepthStencilState");
   ID3D11DepthStencilState *real = NULL;
   m_pRealContext->OMGetDepthStencilState(&real, pStencilRef);
 
@@ -3165,6 +3210,7 @@ void WrappedID3D11DeviceContext::OMSetRenderTargets(UINT NumViews,
                                                     ID3D11RenderTargetView *const *ppRenderTargetViews,
                                                     ID3D11DepthStencilView *pDepthStencilView)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::OMSetRenderTargets");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -3199,21 +3245,15 @@ void WrappedID3D11DeviceContext::OMSetRenderTargets(UINT NumViews,
     {
       if(ppRenderTargetViews && ppRenderTargetViews[i])
       {
-        ID3D11Resource *res = NULL;
-        ppRenderTargetViews[i]->GetResource(&res);
         MarkResourceReferenced(GetIDForResource(ppRenderTargetViews[i]), eFrameRef_Read);
-        MarkResourceReferenced(GetIDForResource(res), eFrameRef_Read);
-        SAFE_RELEASE(res);
+        MarkViewResourceReferenced(ppRenderTargetViews[i], eFrameRef_Read);
       }
     }
 
     if(pDepthStencilView)
     {
-      ID3D11Resource *res = NULL;
-      pDepthStencilView->GetResource(&res);
       MarkResourceReferenced(GetIDForResource(pDepthStencilView), eFrameRef_Read);
-      MarkResourceReferenced(GetIDForResource(res), eFrameRef_Read);
-      SAFE_RELEASE(res);
+      MarkViewResourceReferenced(pDepthStencilView, eFrameRef_Read);
     }
   }
 
@@ -3386,6 +3426,7 @@ void WrappedID3D11DeviceContext::OMSetRenderTargetsAndUnorderedAccessViews(
     ID3D11DepthStencilView *pDepthStencilView, UINT UAVStartSlot, UINT NumUAVs,
     ID3D11UnorderedAccessView *const *ppUnorderedAccessViews, const UINT *pUAVInitialCounts)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::OMSetRenderTargetsAndUnorderedAccessViews");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -3437,21 +3478,15 @@ void WrappedID3D11DeviceContext::OMSetRenderTargetsAndUnorderedAccessViews(
       {
         if(ppRenderTargetViews && ppRenderTargetViews[i])
         {
-          ID3D11Resource *res = NULL;
-          ppRenderTargetViews[i]->GetResource(&res);
           MarkResourceReferenced(GetIDForResource(ppRenderTargetViews[i]), eFrameRef_Read);
-          MarkResourceReferenced(GetIDForResource(res), eFrameRef_Read);
-          SAFE_RELEASE(res);
+          MarkViewResourceReferenced(ppRenderTargetViews[i], eFrameRef_Read);
         }
       }
 
       if(pDepthStencilView)
       {
-        ID3D11Resource *res = NULL;
-        pDepthStencilView->GetResource(&res);
         MarkResourceReferenced(GetIDForResource(pDepthStencilView), eFrameRef_Read);
-        MarkResourceReferenced(GetIDForResource(res), eFrameRef_Read);
-        SAFE_RELEASE(res);
+        MarkViewResourceReferenced(pDepthStencilView, eFrameRef_Read);
       }
     }
   }
@@ -3586,6 +3621,7 @@ bool WrappedID3D11DeviceContext::Serialise_OMSetBlendState(ID3D11BlendState *pBl
 void WrappedID3D11DeviceContext::OMSetBlendState(ID3D11BlendState *pBlendState,
                                                  const FLOAT BlendFactor[4], UINT SampleMask)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::OMSetBlendState");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -3644,6 +3680,7 @@ bool WrappedID3D11DeviceContext::Serialise_OMSetDepthStencilState(
 void WrappedID3D11DeviceContext::OMSetDepthStencilState(ID3D11DepthStencilState *pDepthStencilState,
                                                         UINT StencilRef)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::OMSetDepthStencilState");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -3796,6 +3833,7 @@ void WrappedID3D11DeviceContext::DrawIndexedInstanced(UINT IndexCountPerInstance
                                                       UINT StartIndexLocation, INT BaseVertexLocation,
                                                       UINT StartInstanceLocation)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::DrawIndexedInstanced");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -3867,6 +3905,7 @@ bool WrappedID3D11DeviceContext::Serialise_DrawInstanced(UINT VertexCountPerInst
 void WrappedID3D11DeviceContext::DrawInstanced(UINT VertexCountPerInstance, UINT InstanceCount,
                                                UINT StartVertexLocation, UINT StartInstanceLocation)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::DrawInstanced");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -3932,6 +3971,7 @@ bool WrappedID3D11DeviceContext::Serialise_DrawIndexed(UINT IndexCount_, UINT St
 void WrappedID3D11DeviceContext::DrawIndexed(UINT IndexCount, UINT StartIndexLocation,
                                              INT BaseVertexLocation)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::DrawIndexed");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -3991,6 +4031,7 @@ bool WrappedID3D11DeviceContext::Serialise_Draw(UINT VertexCount_, UINT StartVer
 
 void WrappedID3D11DeviceContext::Draw(UINT VertexCount, UINT StartVertexLocation)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::Draw");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -4099,6 +4140,7 @@ bool WrappedID3D11DeviceContext::Serialise_DrawAuto()
 
 void WrappedID3D11DeviceContext::DrawAuto()
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::DrawAuto");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -4195,6 +4237,7 @@ bool WrappedID3D11DeviceContext::Serialise_DrawIndexedInstancedIndirect(ID3D11Bu
 void WrappedID3D11DeviceContext::DrawIndexedInstancedIndirect(ID3D11Buffer *pBufferForArgs,
                                                               UINT AlignedByteOffsetForArgs)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::DrawIndexedInstancedIndirect");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -4281,6 +4324,7 @@ bool WrappedID3D11DeviceContext::Serialise_DrawInstancedIndirect(ID3D11Buffer *p
 void WrappedID3D11DeviceContext::DrawInstancedIndirect(ID3D11Buffer *pBufferForArgs,
                                                        UINT AlignedByteOffsetForArgs)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::DrawInstancedIndirect");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -4314,6 +4358,7 @@ void WrappedID3D11DeviceContext::DrawInstancedIndirect(ID3D11Buffer *pBufferForA
 void WrappedID3D11DeviceContext::CSGetConstantBuffers(UINT StartSlot, UINT NumBuffers,
                                                       ID3D11Buffer **ppConstantBuffers)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::CSGetConstantBuffers");
   if(ppConstantBuffers)
   {
     ID3D11Buffer *real[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT] = {0};
@@ -4333,6 +4378,7 @@ void WrappedID3D11DeviceContext::CSGetConstantBuffers(UINT StartSlot, UINT NumBu
 void WrappedID3D11DeviceContext::CSGetShaderResources(UINT StartSlot, UINT NumViews,
                                                       ID3D11ShaderResourceView **ppShaderResourceViews)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::CSGetShaderResources");
   if(ppShaderResourceViews)
   {
     ID3D11ShaderResourceView *real[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT] = {0};
@@ -4353,6 +4399,7 @@ void WrappedID3D11DeviceContext::CSGetShaderResources(UINT StartSlot, UINT NumVi
 void WrappedID3D11DeviceContext::CSGetUnorderedAccessViews(
     UINT StartSlot, UINT NumUAVs, ID3D11UnorderedAccessView **ppUnorderedAccessViews)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::CSGetUnorderedAccessViews");
   if(ppUnorderedAccessViews)
   {
     ID3D11UnorderedAccessView *real[D3D11_1_UAV_SLOT_COUNT] = {0};
@@ -4373,6 +4420,7 @@ void WrappedID3D11DeviceContext::CSGetUnorderedAccessViews(
 void WrappedID3D11DeviceContext::CSGetSamplers(UINT StartSlot, UINT NumSamplers,
                                                ID3D11SamplerState **ppSamplers)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::CSGetSamplers");
   if(ppSamplers)
   {
     ID3D11SamplerState *real[D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT] = {0};
@@ -4393,6 +4441,7 @@ void WrappedID3D11DeviceContext::CSGetShader(ID3D11ComputeShader **ppComputeShad
                                              ID3D11ClassInstance **ppClassInstances,
                                              UINT *pNumClassInstances)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::CSGetShader");
   if(ppComputeShader == NULL && ppClassInstances == NULL && pNumClassInstances == NULL)
     return;
 
@@ -4476,6 +4525,7 @@ bool WrappedID3D11DeviceContext::Serialise_CSSetConstantBuffers(UINT StartSlot_,
 void WrappedID3D11DeviceContext::CSSetConstantBuffers(UINT StartSlot, UINT NumBuffers,
                                                       ID3D11Buffer *const *ppConstantBuffers)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::CSSetConstantBuffers");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -4550,6 +4600,7 @@ bool WrappedID3D11DeviceContext::Serialise_CSSetShaderResources(
 void WrappedID3D11DeviceContext::CSSetShaderResources(
     UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView *const *ppShaderResourceViews)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::CSSetShaderResources");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -4571,10 +4622,7 @@ void WrappedID3D11DeviceContext::CSSetShaderResources(
   {
     if(ppShaderResourceViews[i] && m_State >= WRITING_CAPFRAME)
     {
-      ID3D11Resource *res = NULL;
-      ppShaderResourceViews[i]->GetResource(&res);
-      MarkResourceReferenced(GetIDForResource(res), eFrameRef_Read);
-      SAFE_RELEASE(res);
+      MarkViewResourceReferenced(ppShaderResourceViews[i], eFrameRef_Read);
     }
 
     SRVs[i] = UNWRAP(WrappedID3D11ShaderResourceView1, ppShaderResourceViews[i]);
@@ -4631,6 +4679,7 @@ void WrappedID3D11DeviceContext::CSSetUnorderedAccessViews(
     UINT StartSlot, UINT NumUAVs, ID3D11UnorderedAccessView *const *ppUnorderedAccessViews,
     const UINT *pUAVInitialCounts)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::CSSetUnorderedAccessViews");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -4706,6 +4755,7 @@ bool WrappedID3D11DeviceContext::Serialise_CSSetSamplers(UINT StartSlot_, UINT N
 void WrappedID3D11DeviceContext::CSSetSamplers(UINT StartSlot, UINT NumSamplers,
                                                ID3D11SamplerState *const *ppSamplers)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::CSSetSamplers");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -4780,6 +4830,7 @@ void WrappedID3D11DeviceContext::CSSetShader(ID3D11ComputeShader *pComputeShader
                                              ID3D11ClassInstance *const *ppClassInstances,
                                              UINT NumClassInstances)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::CSSetShader");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -4848,6 +4899,7 @@ bool WrappedID3D11DeviceContext::Serialise_ExecuteCommandList(ID3D11CommandList
 void WrappedID3D11DeviceContext::ExecuteCommandList(ID3D11CommandList *pCommandList,
                                                     BOOL RestoreContextState)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::ExecuteCommandList");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -4892,6 +4944,9 @@ void WrappedID3D11DeviceContext::ExecuteCommandList(ID3D11CommandList *pCommandL
     // still update dirty resources for subsequent captures
     wrapped->MarkDirtyResources(m_MissingTracks);
 
+    // the command list may have mapped buffers with its own contents
+    m_SyncedMapShadows.clear();
+
     if(RestoreContextState)
     {
       // insert a chunk to let us know on replay that we finished the command list's
@@ -4976,6 +5031,7 @@ bool WrappedID3D11DeviceContext::Serialise_Dispatch(UINT ThreadGroupCountX_,
 void WrappedID3D11DeviceContext::Dispatch(UINT ThreadGroupCountX, UINT ThreadGroupCountY,
                                           UINT ThreadGroupCountZ)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::Dispatch");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -5058,6 +5114,7 @@ bool WrappedID3D11DeviceContext::Serialise_DispatchIndirect(ID3D11Buffer *pBuffe
 void WrappedID3D11DeviceContext::DispatchIndirect(ID3D11Buffer *pBufferForArgs,
                                                   UINT AlignedByteOffsetForArgs)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::DispatchIndirect");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -5112,6 +5169,7 @@ bool WrappedID3D11DeviceContext::Serialise_FinishCommandList(BOOL RestoreDeferre
 HRESULT WrappedID3D11DeviceContext::FinishCommandList(BOOL RestoreDeferredContextState,
                                                       ID3D11CommandList **ppCommandList)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::FinishCommandList");
   if(GetType() == D3D11_DEVICE_CONTEXT_IMMEDIATE)
   {
     m_pDevice->AddDebugMessage(MessageCategory::Execution, MessageSeverity::High,
@@ -5167,6 +5225,8 @@ HRESULT WrappedID3D11DeviceContext::FinishCommandList(BOOL RestoreDeferredContex
         m_pDevice->GetResourceManager()->GetResourceRecord(wrapped->GetResourceID());
     RDCASSERT(r);
 
+    // hand the chunks over to the command list in one go
+    m_ContextRecord->AssignDeferredChunkIDs();
     m_ContextRecord->SwapChunks(r);
     wrapped->SetReferences(m_DeferredReferences);
     wrapped->SetDirtyResources(m_DeferredDirty);
@@ -5240,6 +5300,7 @@ bool WrappedID3D11DeviceContext::Serialise_Flush()
 
 void WrappedID3D11DeviceContext::Flush()
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::Flush");
   m_EmptyCommandList = false;
 
   if(m_State == WRITING_CAPFRAME)
@@ -5348,6 +5409,7 @@ void WrappedID3D11DeviceContext::CopySubresourceRegion(ID3D11Resource *pDstResou
                                                        UINT DstZ, ID3D11Resource *pSrcResource,
                                                        UINT SrcSubresource, const D3D11_BOX *pSrcBox)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::CopySubresourceRegion");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -5495,6 +5557,7 @@ bool WrappedID3D11DeviceContext::Serialise_CopyResource(ID3D11Resource *pDstReso
 void WrappedID3D11DeviceContext::CopyResource(ID3D11Resource *pDstResource,
                                               ID3D11Resource *pSrcResource)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::CopyResource");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -5625,6 +5688,7 @@ void WrappedID3D11DeviceContext::UpdateSubresource(ID3D11Resource *pDstResource,
                                                    const D3D11_BOX *pDstBox, const void *pSrcData,
                                                    UINT SrcRowPitch, UINT SrcDepthPitch)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::UpdateSubresource");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -5913,6 +5977,7 @@ void WrappedID3D11DeviceContext::CopyStructureCount(ID3D11Buffer *pDstBuffer,
                                                     UINT DstAlignedByteOffset,
                                                     ID3D11UnorderedAccessView *pSrcView)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::CopyStructureCount");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -6036,6 +6101,7 @@ void WrappedID3D11DeviceContext::ResolveSubresource(ID3D11Resource *pDstResource
                                                     UINT DstSubresource, ID3D11Resource *pSrcResource,
                                                     UINT SrcSubresource, DXGI_FORMAT Format)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::ResolveSubresource");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -6171,6 +6237,7 @@ bool WrappedID3D11DeviceContext::Serialise_GenerateMips(ID3D11ShaderResourceView
 
 void WrappedID3D11DeviceContext::GenerateMips(ID3D11ShaderResourceView *pShaderResourceView)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::GenerateMips");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -6191,8 +6258,8 @@ void WrappedID3D11DeviceContext::GenerateMips(ID3D11ShaderResourceView *pShaderR
 
     m_MissingTracks.insert(GetIDForResource(res));
 
-    MarkResourceReferenced(GetIDForResource(res), eFrameRef_Read);
-    MarkResourceReferenced(GetIDForResource(res), eFrameRef_Write);
+    MarkViewResourceReferenced(pShaderResourceView, eFrameRef_Read);
+    MarkViewResourceReferenced(pShaderResourceView, eFrameRef_Write);
     MarkResourceReferenced(GetIDForResource(pShaderResourceView), eFrameRef_Read);
     SAFE_RELEASE(res);
   }
@@ -6226,6 +6293,7 @@ bool WrappedID3D11DeviceContext::Serialise_ClearState()
 
 void WrappedID3D11DeviceContext::ClearState()
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::ClearState");
   m_EmptyCommandList = false;
 
   if(m_State == WRITING_CAPFRAME)
@@ -6340,6 +6408,7 @@ bool WrappedID3D11DeviceContext::Serialise_ClearRenderTargetView(
 void WrappedID3D11DeviceContext::ClearRenderTargetView(ID3D11RenderTargetView *pRenderTargetView,
                                                        const FLOAT ColorRGBA[4])
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::ClearRenderTargetView");
   DrainAnnotationQueue();
 
   if(pRenderTargetView == NULL)
@@ -6413,7 +6482,7 @@ void WrappedID3D11DeviceContext::ClearRenderTargetView(ID3D11RenderTargetView *p
 
     if(m_State == WRITING_CAPFRAME)
     {
-      MarkResourceReferenced(GetIDForResource(res), eFrameRef_Write);
+      MarkViewResourceReferenced(pRenderTargetView, eFrameRef_Write);
       MarkResourceReferenced(GetIDForResource(pRenderTargetView), eFrameRef_Read);
     }
 
@@ -6522,6 +6591,7 @@ bool WrappedID3D11DeviceContext::Serialise_ClearUnorderedAccessViewUint(
 void WrappedID3D11DeviceContext::ClearUnorderedAccessViewUint(
     ID3D11UnorderedAccessView *pUnorderedAccessView, const UINT Values[4])
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::ClearUnorderedAccessViewUint");
   m_EmptyCommandList = false;
 
   if(m_State == WRITING_CAPFRAME)
@@ -6583,7 +6653,7 @@ void WrappedID3D11DeviceContext::ClearUnorderedAccessViewUint(
 
     if(m_State == WRITING_CAPFRAME)
     {
-      MarkResourceReferenced(GetIDForResource(res), eFrameRef_Write);
+      MarkViewResourceReferenced(pUnorderedAccessView, eFrameRef_Write);
       MarkResourceReferenced(GetIDForResource(pUnorderedAccessView), eFrameRef_Read);
     }
 
@@ -6694,6 +6764,7 @@ bool WrappedID3D11DeviceContext::Serialise_ClearUnorderedAccessViewFloat(
 void WrappedID3D11DeviceContext::ClearUnorderedAccessViewFloat(
     ID3D11UnorderedAccessView *pUnorderedAccessView, const FLOAT Values[4])
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::ClearUnorderedAccessViewFloat");
   m_EmptyCommandList = false;
 
   if(m_State == WRITING_CAPFRAME)
@@ -6755,7 +6826,7 @@ void WrappedID3D11DeviceContext::ClearUnorderedAccessViewFloat(
 
     if(m_State == WRITING_CAPFRAME)
     {
-      MarkResourceReferenced(GetIDForResource(res), eFrameRef_Write);
+      MarkViewResourceReferenced(pUnorderedAccessView, eFrameRef_Write);
       MarkResourceReferenced(GetIDForResource(pUnorderedAccessView), eFrameRef_Read);
     }
 
@@ -6852,6 +6923,7 @@ bool WrappedID3D11DeviceContext::Serialise_ClearDepthStencilView(
 void WrappedID3D11DeviceContext::ClearDepthStencilView(ID3D11DepthStencilView *pDepthStencilView,
                                                        UINT ClearFlags, FLOAT Depth, UINT8 Stencil)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::ClearDepthStencilView");
   DrainAnnotationQueue();
 
   if(pDepthStencilView == NULL)
@@ -6921,7 +6993,7 @@ void WrappedID3D11DeviceContext::ClearDepthStencilView(ID3D11DepthStencilView *p
 
     if(m_State == WRITING_CAPFRAME)
     {
-      MarkResourceReferenced(GetIDForResource(res), eFrameRef_Write);
+      MarkViewResourceReferenced(pDepthStencilView, eFrameRef_Write);
       MarkResourceReferenced(GetIDForResource(pDepthStencilView), eFrameRef_Read);
     }
 
@@ -6968,6 +7040,7 @@ bool WrappedID3D11DeviceContext::Serialise_Begin(ID3D11Asynchronous *pAsync)
 
 void WrappedID3D11DeviceContext::Begin(ID3D11Asynchronous *pAsync)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::Begin");
   ID3D11Asynchronous *unwrapped = NULL;
 
   if(WrappedID3D11Query1::IsAlloc(pAsync))
@@ -7024,6 +7097,7 @@ bool WrappedID3D11DeviceContext::Serialise_End(ID3D11Asynchronous *pAsync)
 
 void WrappedID3D11DeviceContext::End(ID3D11Asynchronous *pAsync)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::End");
   ID3D11Asynchronous *unwrapped = NULL;
 
   if(WrappedID3D11Query1::IsAlloc(pAsync))
@@ -7050,6 +7124,7 @@ void WrappedID3D11DeviceContext::End(ID3D11Asynchronous *pAsync)
 HRESULT WrappedID3D11DeviceContext::GetData(ID3D11Asynchronous *pAsync, void *pData, UINT DataSize,
                                             UINT GetDataFlags)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::GetData");
   ID3D11Asynchronous *unwrapped = NULL;
 
   if(WrappedID3D11Query1::IsAlloc(pAsync))
@@ -7084,6 +7159,7 @@ bool WrappedID3D11DeviceContext::Serialise_SetPredication(ID3D11Predicate *pPred
 
 void WrappedID3D11DeviceContext::SetPredication(ID3D11Predicate *pPredicate, BOOL PredicateValue)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::SetPredication");
   m_EmptyCommandList = false;
 
   if(m_State == WRITING_CAPFRAME)
@@ -7100,6 +7176,7 @@ void WrappedID3D11DeviceContext::SetPredication(ID3D11Predicate *pPredicate, BOO
 
 FLOAT WrappedID3D11DeviceContext::GetResourceMinLOD(ID3D11Resource *pResource)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::GetResourceMinLOD");
   return m_pRealContext->GetResourceMinLOD(m_pDevice->GetResourceManager()->UnwrapResource(pResource));
 }
 
@@ -7119,6 +7196,7 @@ bool WrappedID3D11DeviceContext::Serialise_SetResourceMinLOD(ID3D11Resource *pRe
 
 void WrappedID3D11DeviceContext::SetResourceMinLOD(ID3D11Resource *pResource, FLOAT MinLOD)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::SetResourceMinLOD");
   m_EmptyCommandList = false;
 
   if(m_State == WRITING_CAPFRAME)
@@ -7136,6 +7214,7 @@ void WrappedID3D11DeviceContext::SetResourceMinLOD(ID3D11Resource *pResource, FL
 
 void WrappedID3D11DeviceContext::GetPredication(ID3D11Predicate **ppPredicate, BOOL *pPredicateValue)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::GetPredication");
   ID3D11Predicate *real = NULL;
   m_pRealContext->GetPredication(&real, pPredicateValue);
   SAFE_RELEASE_NOCLEAR(real);
@@ -7422,15 +7501,19 @@ bool WrappedID3D11DeviceContext::Serialise_Map(ID3D11Resource *pResource, UINT S
 
     if(appMem == NULL)
     {
-      record->AllocShadowStorage(ctxMapID, mapLength);
+      // while capturing, track which pages of buffer shadows get written so unmap only needs to
+      // compare those - usually just the range appended with a no-overwrite map
+      bool writeWatch = m_State == WRITING_CAPFRAME && WrappedID3D11Buffer::IsAlloc(pResource);
+      record->AllocShadowStorage(ctxMapID, mapLength, writeWatch);
       appMem = record->GetShadowPtr(ctxMapID, 0);
 
       if(MapType != D3D11_MAP_WRITE_DISCARD)
       {
         if(m_pDevice->GetResourceManager()->IsResourceDirty(Resource))
         {
-          ID3D11DeviceChild *initial =
-              m_pDevice->GetResourceManager()->GetInitialContents(Resource).resource;
+          D3D11ResourceManager::InitialContentData initialData =
+              m_pDevice->GetResourceManager()->GetInitialContents(Resource);
+          ID3D11DeviceChild *initial = initialData.resource;
 
           if(WrappedID3D11Buffer::IsAlloc(pResource))
           {
@@ -7447,6 +7530,10 @@ bool WrappedID3D11DeviceContext::Serialise_Map(ID3D11Resource *pResource, UINT S
             }
             else
             {
+              // small buffers are packed into a shared staging buffer at an offset
+              if(record->Length <= WrappedID3D11Device::InitialStatePackMaxBuffer)
+                mapped.pData = (byte *)mapped.pData + initialData.num;
+
               intercept = MapIntercept();
               intercept.SetD3D(mapped);
               intercept.Init((ID3D11Buffer *)pResource, record->GetDataPtr());
@@ -7584,6 +7671,7 @@ HRESULT WrappedID3D11DeviceContext::Map(ID3D11Resource *pResource, UINT Subresou
                                         D3D11_MAP MapType, UINT MapFlags,
                                         D3D11_MAPPED_SUBRESOURCE *pMappedResource)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::Map");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
@@ -7613,11 +7701,16 @@ HRESULT WrappedID3D11DeviceContext::Map(ID3D11Resource *pResource, UINT Subresou
                                Subresource, MapType, MapFlags, pMappedResource);
   }
 
-  // can't promise no-overwrite as we're going to blat the whole buffer!
-  HRESULT ret = m_pRealContext->Map(
-      m_pDevice->GetResourceManager()->UnwrapResource(pResource), Subresource,
-      MapType == D3D11_MAP_WRITE_NO_OVERWRITE ? D3D11_MAP_WRITE_DISCARD : MapType, MapFlags,
-      pMappedResource);
+  // we copy the whole shadow back on unmap unless the real buffer already matches it, so we can't
+  // promise no-overwrite otherwise
+  D3D11_MAP realMapType = MapType;
+  if(MapType == D3D11_MAP_WRITE_NO_OVERWRITE &&
+     (m_State != WRITING_CAPFRAME || m_SyncedMapShadows.find(id) == m_SyncedMapShadows.end()))
+    realMapType = D3D11_MAP_WRITE_DISCARD;
+
+  HRESULT ret =
+      m_pRealContext->Map(m_pDevice->GetResourceManager()->UnwrapResource(pResource), Subresource,
+                          realMapType, MapFlags, pMappedResource);
 
   if(SUCCEEDED(ret))
   {
@@ -7636,6 +7729,9 @@ HRESULT WrappedID3D11DeviceContext::Map(ID3D11Resource *pResource, UINT Subresou
         m_MissingTracks.insert(GetIDForResource(pResource));
 
         Serialise_Map(pResource, Subresource, MapType, MapFlags, pMappedResource);
+
+        if(realMapType == D3D11_MAP_WRITE_NO_OVERWRITE)
+          m_OpenMaps[MappedResource(id, Subresource)].d3dContentsKept = true;
       }
     }
     else if(m_State >= WRITING)
@@ -7671,6 +7767,33 @@ HRESULT WrappedID3D11DeviceContext::Map(ID3D11Resource *pResource, UINT Subresou
   return ret;
 }
 
+// finds the range that differs between the shadow copies, only comparing the pages that have been
+// written since they were last compared
+static bool FindWrittenDiffRange(WriteWatch::Region watch, byte *app, byte *shadow,
+                                 size_t &diffStart, size_t &diffEnd)
+{
+  std::vector<std::pair<size_t, size_t> > written;
+  WriteWatch::GetDirtyRanges(watch, written);
+
+  bool found = false;
+
+  // ranges are returned in ascending order
+  for(size_t i = 0; i < written.size(); i++)
+  {
+    size_t start = 0, end = 0;
+    if(!FindDiffRange(app + written[i].first, shadow + written[i].first,
+                      written[i].second - written[i].first, start, end))
+      continue;
+
+    if(!found)
+      diffStart = written[i].first + start;
+    diffEnd = written[i].first + end;
+    found = true;
+  }
+
+  return found;
+}
+
 bool WrappedID3D11DeviceContext::Serialise_Unmap(ID3D11Resource *pResource, UINT Subresource_)
 {
   MappedResource mapIdx;
@@ -7748,10 +7871,14 @@ bool WrappedID3D11DeviceContext::Serialise_Unmap(ID3D11Resource *pResource, UINT
     size_t diffStart = 0;
     size_t diffEnd = len;
 
+    WriteWatch::Region watch = record ? record->GetShadowWriteWatch(ctxMapID) : NULL;
+
     if(m_State == WRITING_CAPFRAME && len > 512 && intercept.MapType != D3D11_MAP_WRITE_DISCARD)
     {
-      bool found =
-          FindDiffRange(appWritePtr, record->GetShadowPtr(ctxMapID, 1), len, diffStart, diffEnd);
+      byte *shadow = record->GetShadowPtr(ctxMapID, 1);
+
+      bool found = watch ? FindWrittenDiffRange(watch, appWritePtr, shadow, diffStart, diffEnd)
+                         : FindDiffRange(appWritePtr, shadow, len, diffStart, diffEnd);
       if(found)
       {
         static size_t saved = 0;
@@ -7771,6 +7898,11 @@ bool WrappedID3D11DeviceContext::Serialise_Unmap(ID3D11Resource *pResource, UINT
         len = 1;
       }
     }
+    else if(m_State == WRITING_CAPFRAME && watch)
+    {
+      // the whole range is copied to the second shadow below, so earlier writes don't matter
+      WriteWatch::Reset(watch);
+    }
 
     appWritePtr += diffStart;
     if(m_State == WRITING_CAPFRAME && record->GetShadowPtr(ctxMapID, 1))
@@ -7867,7 +7999,24 @@ bool WrappedID3D11DeviceContext::Serialise_Unmap(ID3D11Resource *pResource, UINT
     }
     else if(m_State == WRITING_CAPFRAME)
     {
-      intercept.CopyToD3D();
+      if(intercept.d3dContentsKept)
+      {
+        // the real buffer still holds everything outside the difference
+        if(diffStart < diffEnd)
+        {
+          intercept.app.pData = appWritePtr;
+          intercept.CopyToD3D(diffStart, diffEnd);
+        }
+      }
+      else
+      {
+        intercept.CopyToD3D();
+      }
+
+      // dynamic buffers can't be written by the GPU, so the real contents now match the shadow
+      // until a command list maps them elsewhere
+      if(GetType() == D3D11_DEVICE_CONTEXT_IMMEDIATE && WrappedID3D11Buffer::IsAlloc(pResource))
+        m_SyncedMapShadows.insert(mapIdx.resource);
     }
   }
   else if(m_State == WRITING_IDLE)
@@ -7915,6 +8064,7 @@ bool WrappedID3D11DeviceContext::Serialise_Unmap(ID3D11Resource *pResource, UINT
 
 void WrappedID3D11DeviceContext::Unmap(ID3D11Resource *pResource, UINT Subresource)
 {
+  SCOPED_API_CALL_STATS("ID3D11DeviceContext::Unmap");
   DrainAnnotationQueue();
 
   m_EmptyCommandList = false;
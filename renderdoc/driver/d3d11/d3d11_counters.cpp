@@ -22,6 +22,7 @@
  * THE SOFTWARE.
  ******************************************************************************/
 
+#include <algorithm>
 #include "common/common.h"
 #include "d3d11_context.h"
 #include "d3d11_debug.h"
@@ -33,10 +34,12 @@ void D3D11DebugManager::PreDeviceInitCounters()
 
 void D3D11DebugManager::PostDeviceInitCounters()
 {
+  m_CounterProviders.Init(eRENDERDOC_CounterAPI_D3D11, (void *)m_pDevice);
 }
 
 void D3D11DebugManager::PreDeviceShutdownCounters()
 {
+  m_CounterProviders.Shutdown();
 }
 
 void D3D11DebugManager::PostDeviceShutdownCounters()
@@ -61,11 +64,17 @@ vector<GPUCounter> D3D11DebugManager::EnumerateCounters()
   ret.push_back(GPUCounter::PSInvocations);
   ret.push_back(GPUCounter::CSInvocations);
 
+  vector<GPUCounter> providerCounters = m_CounterProviders.EnumerateCounters();
+  ret.insert(ret.end(), providerCounters.begin(), providerCounters.end());
+
   return ret;
 }
 
 void D3D11DebugManager::DescribeCounter(GPUCounter counterID, CounterDescription &desc)
 {
+  if(m_CounterProviders.DescribeCounter(counterID, desc))
+    return;
+
   desc.counterID = counterID;
 
   switch(counterID)
@@ -188,6 +197,11 @@ struct D3D11CounterContext
   uint32_t eventStart;
   vector<GPUTimer> timers;
   int reuseIdx;
+
+  // which queries the requested counters need around each event
+  bool timestamps;
+  bool stats;
+  bool occlusion;
 };
 
 void D3D11DebugManager::FillTimers(D3D11CounterContext &ctx, const DrawcallTreeNode &drawnode)
@@ -201,6 +215,10 @@ void D3D11DebugManager::FillTimers(D3D11CounterContext &ctx, const DrawcallTreeN
 
   for(size_t i = 0; i < drawnode.children.size(); i++)
   {
+    // timers created so far are read back as normal, the rest of the frame is skipped
+    if(RenderDoc::Inst().IsReplayCancelled())
+      return;
+
     const DrawcallDescription &d = drawnode.children[i].draw;
     FillTimers(ctx, drawnode.children[i]);
 
@@ -220,14 +238,23 @@ void D3D11DebugManager::FillTimers(D3D11CounterContext &ctx, const DrawcallTreeN
         timer->eventID = d.eventID;
         timer->before = timer->after = timer->stats = timer->occlusion = NULL;
 
-        hr = m_pDevice->CreateQuery(&qtimedesc, &timer->before);
-        RDCASSERTEQUAL(hr, S_OK);
-        hr = m_pDevice->CreateQuery(&qtimedesc, &timer->after);
-        RDCASSERTEQUAL(hr, S_OK);
-        hr = m_pDevice->CreateQuery(&qstatsdesc, &timer->stats);
-        RDCASSERTEQUAL(hr, S_OK);
-        hr = m_pDevice->CreateQuery(&qoccldesc, &timer->occlusion);
-        RDCASSERTEQUAL(hr, S_OK);
+        if(ctx.timestamps)
+        {
+          hr = m_pDevice->CreateQuery(&qtimedesc, &timer->before);
+          RDCASSERTEQUAL(hr, S_OK);
+          hr = m_pDevice->CreateQuery(&qtimedesc, &timer->after);
+          RDCASSERTEQUAL(hr, S_OK);
+        }
+        if(ctx.stats)
+        {
+          hr = m_pDevice->CreateQuery(&qstatsdesc, &timer->stats);
+          RDCASSERTEQUAL(hr, S_OK);
+        }
+        if(ctx.occlusion)
+        {
+          hr = m_pDevice->CreateQuery(&qoccldesc, &timer->occlusion);
+          RDCASSERTEQUAL(hr, S_OK);
+        }
       }
       else
       {
@@ -257,6 +284,48 @@ void D3D11DebugManager::FillTimers(D3D11CounterContext &ctx, const DrawcallTreeN
   }
 }
 
+void D3D11DebugManager::FillProviderSamples(uint32_t &eventStart, const DrawcallTreeNode &drawnode)
+{
+  if(drawnode.children.empty())
+    return;
+
+  for(size_t i = 0; i < drawnode.children.size(); i++)
+  {
+    const DrawcallDescription &d = drawnode.children[i].draw;
+    FillProviderSamples(eventStart, drawnode.children[i]);
+
+    if(d.events.count == 0)
+      continue;
+
+    m_WrappedDevice->ReplayLog(eventStart, d.eventID, eReplay_WithoutDraw);
+
+    m_pImmediateContext->Flush();
+
+    m_CounterProviders.BeginSample(d.eventID, (void *)m_pImmediateContext);
+    m_WrappedDevice->ReplayLog(eventStart, d.eventID, eReplay_OnlyDraw);
+    m_CounterProviders.EndSample(d.eventID, (void *)m_pImmediateContext);
+
+    eventStart = d.eventID + 1;
+  }
+}
+
+vector<CounterResult> D3D11DebugManager::FetchProviderCounters(const vector<GPUCounter> &counters)
+{
+  uint32_t numPasses = m_CounterProviders.BeginSession(counters);
+
+  for(uint32_t pass = 0; pass < numPasses; pass++)
+  {
+    uint32_t eventStart = 0;
+
+    m_CounterProviders.BeginPass(pass);
+    FillProviderSamples(eventStart, m_WrappedContext->GetRootDraw());
+    m_pImmediateContext->Flush();
+    m_CounterProviders.EndPass(pass);
+  }
+
+  return m_CounterProviders.EndSession();
+}
+
 vector<CounterResult> D3D11DebugManager::FetchCounters(const vector<GPUCounter> &counters)
 {
   vector<CounterResult> ret;
@@ -267,6 +336,20 @@ vector<CounterResult> D3D11DebugManager::FetchCounters(const vector<GPUCounter>
     return ret;
   }
 
+  vector<GPUCounter> apiCounters, providerCounters;
+  if(m_CounterProviders.SplitCounters(counters, apiCounters, providerCounters))
+  {
+    if(!apiCounters.empty())
+      ret = FetchCounters(apiCounters);
+
+    vector<CounterResult> providerResults = FetchProviderCounters(providerCounters);
+    ret.insert(ret.end(), providerResults.begin(), providerResults.end());
+
+    std::sort(ret.begin(), ret.end());
+
+    return ret;
+  }
+
   SCOPED_TIMER("Fetch Counters, counters to fetch %u", counters.size());
 
   D3D11_QUERY_DESC disjointdesc = {D3D11_QUERY_TIMESTAMP_DISJOINT, 0};
@@ -293,6 +376,20 @@ vector<CounterResult> D3D11DebugManager::FetchCounters(const vector<GPUCounter>
 
   D3D11CounterContext ctx;
 
+  // all of the query types can be active at once, so every requested counter is gathered in the
+  // same replay. Only the queries that are needed are issued though.
+  ctx.timestamps = ctx.stats = ctx.occlusion = false;
+
+  for(size_t c = 0; c < counters.size(); c++)
+  {
+    switch(counters[c])
+    {
+      case GPUCounter::EventGPUDuration: ctx.timestamps = true; break;
+      case GPUCounter::SamplesWritten: ctx.occlusion = true; break;
+      default: ctx.stats = true; break;
+    }
+  }
+
   for(int loop = 0; loop < 1; loop++)
   {
     {
@@ -326,28 +423,41 @@ vector<CounterResult> D3D11DebugManager::FetchCounters(const vector<GPUCounter>
 
       for(size_t i = 0; i < ctx.timers.size(); i++)
       {
-        if(ctx.timers[i].before && ctx.timers[i].after && ctx.timers[i].stats &&
-           ctx.timers[i].occlusion)
+        const GPUTimer &t = ctx.timers[i];
+
+        if(((t.before && t.after) || !ctx.timestamps) && (t.stats || !ctx.stats) &&
+           (t.occlusion || !ctx.occlusion))
         {
-          hr = m_pImmediateContext->GetData(ctx.timers[i].before, &a, sizeof(UINT64), 0);
-          RDCASSERTEQUAL(hr, S_OK);
+          double duration = 0.0;
 
-          UINT64 b = 0;
-          hr = m_pImmediateContext->GetData(ctx.timers[i].after, &b, sizeof(UINT64), 0);
-          RDCASSERTEQUAL(hr, S_OK);
+          if(ctx.timestamps)
+          {
+            hr = m_pImmediateContext->GetData(t.before, &a, sizeof(UINT64), 0);
+            RDCASSERTEQUAL(hr, S_OK);
 
-          double duration = (double(b - a) / ticksToSecs);
+            UINT64 b = 0;
+            hr = m_pImmediateContext->GetData(t.after, &b, sizeof(UINT64), 0);
+            RDCASSERTEQUAL(hr, S_OK);
 
-          a = b;
+            duration = (double(b - a) / ticksToSecs);
 
-          D3D11_QUERY_DATA_PIPELINE_STATISTICS pipelineStats;
-          hr = m_pImmediateContext->GetData(ctx.timers[i].stats, &pipelineStats,
-                                            sizeof(D3D11_QUERY_DATA_PIPELINE_STATISTICS), 0);
-          RDCASSERTEQUAL(hr, S_OK);
+            a = b;
+          }
+
+          D3D11_QUERY_DATA_PIPELINE_STATISTICS pipelineStats = {};
+          if(ctx.stats)
+          {
+            hr = m_pImmediateContext->GetData(t.stats, &pipelineStats,
+                                              sizeof(D3D11_QUERY_DATA_PIPELINE_STATISTICS), 0);
+            RDCASSERTEQUAL(hr, S_OK);
+          }
 
           UINT64 occlusion = 0;
-          hr = m_pImmediateContext->GetData(ctx.timers[i].occlusion, &occlusion, sizeof(UINT64), 0);
-          RDCASSERTEQUAL(hr, S_OK);
+          if(ctx.occlusion)
+          {
+            hr = m_pImmediateContext->GetData(t.occlusion, &occlusion, sizeof(UINT64), 0);
+            RDCASSERTEQUAL(hr, S_OK);
+          }
 
           for(size_t c = 0; c < counters.size(); c++)
           {
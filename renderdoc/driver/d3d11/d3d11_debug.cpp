@@ -24,7 +24,6 @@
  ******************************************************************************/
 
 #include "d3d11_debug.h"
-#include "common/shader_cache.h"
 #include "data/resource.h"
 #include "driver/d3d11/d3d11_resources.h"
 #include "driver/dx/official/d3dcompiler.h"
@@ -140,11 +139,7 @@ D3D11DebugManager::D3D11DebugManager(WrappedID3D11Device *wrapper)
     }
   }
 
-  bool success = LoadShaderCache("d3dshaders.cache", m_ShaderCacheMagic, m_ShaderCacheVersion,
-                                 m_ShaderCache, ShaderCacheCallbacks);
-
-  // if we failed to load from the cache
-  m_ShaderCacheDirty = !success;
+  m_ShaderCache.Open("d3dshaders.cache", m_ShaderCacheMagic, m_ShaderCacheVersion);
 
   m_CacheShaders = true;
 
@@ -163,16 +158,7 @@ D3D11DebugManager::~D3D11DebugManager()
 {
   PreDeviceShutdownCounters();
 
-  if(m_ShaderCacheDirty)
-  {
-    SaveShaderCache("d3dshaders.cache", m_ShaderCacheMagic, m_ShaderCacheVersion, m_ShaderCache,
-                    ShaderCacheCallbacks);
-  }
-  else
-  {
-    for(auto it = m_ShaderCache.begin(); it != m_ShaderCache.end(); ++it)
-      ShaderCacheCallbacks.Destroy(it->second);
-  }
+  m_ShaderCache.Close(ShaderCacheCallbacks);
 
   ShutdownFontRendering();
   ShutdownStreamOut();
@@ -185,6 +171,8 @@ D3D11DebugManager::~D3D11DebugManager()
   if(m_CustomShaderResourceId != ResourceId())
     SAFE_RELEASE(m_CustomShaderTex);
 
+  SAFE_RELEASE(m_StagingTex2D);
+
   SAFE_RELEASE(m_pFactory);
 
   while(!m_ShaderItemCache.empty())
@@ -224,9 +212,8 @@ string D3D11DebugManager::GetShaderBlob(const char *source, const char *entry,
   hash = strhash(profile, hash);
   hash ^= compileFlags;
 
-  if(m_ShaderCache.find(hash) != m_ShaderCache.end())
+  if(m_ShaderCache.Find(hash, *srcblob, ShaderCacheCallbacks))
   {
-    *srcblob = m_ShaderCache[hash];
     (*srcblob)->AddRef();
     return "";
   }
@@ -278,9 +265,8 @@ string D3D11DebugManager::GetShaderBlob(const char *source, const char *entry,
 
   if(m_CacheShaders)
   {
-    m_ShaderCache[hash] = byteBlob;
+    m_ShaderCache.Insert(hash, byteBlob);
     byteBlob->AddRef();
-    m_ShaderCacheDirty = true;
   }
 
   SAFE_RELEASE(errBlob);
@@ -449,9 +435,16 @@ void D3D11DebugManager::BuildShader(string source, string entry, const uint32_t
       return;
   }
 
+  // user shaders tend to be rebuilt with the same source every session, so they go through the
+  // on-disk cache too. The key covers the source, entry point, profile and flags.
+  bool cacheShaders = m_CacheShaders;
+  m_CacheShaders = true;
+
   ID3DBlob *blob = NULL;
   *errors = GetShaderBlob(source.c_str(), entry.c_str(), compileFlags, profile, &blob);
 
+  m_CacheShaders = cacheShaders;
+
   if(blob == NULL)
   {
     *id = ResourceId();
@@ -612,6 +605,9 @@ bool D3D11DebugManager::InitDebugRendering()
   m_CustomShaderRTV = NULL;
   m_CustomShaderResourceId = ResourceId();
 
+  m_StagingTex2D = NULL;
+  RDCEraseEl(m_StagingTex2DDesc);
+
   m_OverlayRenderTex = NULL;
   m_OverlayResourceId = ResourceId();
 
@@ -702,6 +698,8 @@ bool D3D11DebugManager::InitDebugRendering()
         MakeCShader(displayhlsl.c_str(), "RENDERDOC_PixelHistoryCopyPixel", "cs_5_0");
     m_DebugRender.PrimitiveIDPS =
         MakePShader(displayhlsl.c_str(), "RENDERDOC_PrimitiveIDPS", "ps_5_0");
+    m_DebugRender.PixelHistoryCapturePS =
+        MakePShader(displayhlsl.c_str(), "RENDERDOC_PixelHistoryCapturePS", "ps_5_0");
 
     m_DebugRender.MeshPickCS = MakeCShader(meshhlsl.c_str(), "RENDERDOC_MeshPickCS", "cs_5_0");
 
@@ -1137,6 +1135,22 @@ bool D3D11DebugManager::InitDebugRendering()
     if(FAILED(hr))
       RDCERR("Failed to create mesh pick result UAV %08x", hr);
 
+    bDesc.ByteWidth = sizeof(uint32_t) * 2 * DebugRenderData::maxCapturedFragments;
+    bDesc.StructureByteStride = sizeof(uint32_t) * 2;
+
+    hr = m_pDevice->CreateBuffer(&bDesc, NULL, &m_DebugRender.PixelHistoryCaptureBuf);
+
+    if(FAILED(hr))
+      RDCERR("Failed to create pixel history capture buff %08x", hr);
+
+    uavDesc.Buffer.NumElements = DebugRenderData::maxCapturedFragments;
+
+    hr = m_pDevice->CreateUnorderedAccessView(m_DebugRender.PixelHistoryCaptureBuf, &uavDesc,
+                                              &m_DebugRender.PixelHistoryCaptureUAV);
+
+    if(FAILED(hr))
+      RDCERR("Failed to create pixel history capture UAV %08x", hr);
+
     // created/sized on demand
     m_DebugRender.PickIBBuf = m_DebugRender.PickVBBuf = NULL;
     m_DebugRender.PickIBSRV = m_DebugRender.PickVBSRV = NULL;
@@ -1154,10 +1168,13 @@ bool D3D11DebugManager::InitDebugRendering()
     desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
     desc.Usage = D3D11_USAGE_STAGING;
 
-    hr = m_pDevice->CreateBuffer(&desc, NULL, &m_DebugRender.StageBuffer);
+    for(uint32_t i = 0; i < STAGE_BUFFER_COUNT; i++)
+    {
+      hr = m_pDevice->CreateBuffer(&desc, NULL, &m_DebugRender.StageBuffers[i]);
 
-    if(FAILED(hr))
-      RDCERR("Failed to create map staging buffer %08x", hr);
+      if(FAILED(hr))
+        RDCERR("Failed to create map staging buffer %08x", hr);
+    }
   }
 
   return true;
@@ -1740,11 +1757,12 @@ void D3D11DebugManager::FlipOutputWindow(uint64_t id)
 
 uint32_t D3D11DebugManager::GetStructCount(ID3D11UnorderedAccessView *uav)
 {
-  m_pImmediateContext->CopyStructureCount(m_DebugRender.StageBuffer, 0,
+  m_pImmediateContext->CopyStructureCount(m_DebugRender.StageBuffers[0], 0,
                                           UNWRAP(WrappedID3D11UnorderedAccessView1, uav));
 
   D3D11_MAPPED_SUBRESOURCE mapped;
-  HRESULT hr = m_pImmediateContext->Map(m_DebugRender.StageBuffer, 0, D3D11_MAP_READ, 0, &mapped);
+  HRESULT hr =
+      m_pImmediateContext->Map(m_DebugRender.StageBuffers[0], 0, D3D11_MAP_READ, 0, &mapped);
 
   if(FAILED(hr))
   {
@@ -1754,7 +1772,7 @@ uint32_t D3D11DebugManager::GetStructCount(ID3D11UnorderedAccessView *uav)
 
   uint32_t ret = *((uint32_t *)mapped.pData);
 
-  m_pImmediateContext->Unmap(m_DebugRender.StageBuffer, 0);
+  m_pImmediateContext->Unmap(m_DebugRender.StageBuffers[0], 0);
 
   return ret;
 }
@@ -2036,8 +2054,6 @@ void D3D11DebugManager::GetBufferData(ID3D11Buffer *buffer, uint64_t offset, uin
     len = RDCMIN(len, desc.ByteWidth - offs);
   }
 
-  uint32_t outOffs = 0;
-
   ret.resize(len);
 
   D3D11_BOX box;
@@ -2048,37 +2064,60 @@ void D3D11DebugManager::GetBufferData(ID3D11Buffer *buffer, uint64_t offset, uin
 
   ID3D11Buffer *src = unwrap ? UNWRAP(WrappedID3D11Buffer, buffer) : buffer;
 
-  while(len > 0)
+  // copies into the staging buffers are queued ahead of mapping, so that the GPU copies the next
+  // chunks while the CPU reads back the oldest one, rather than stalling on every chunk
+  uint32_t chunkOffs[STAGE_BUFFER_COUNT] = {};
+  uint32_t chunkSizes[STAGE_BUFFER_COUNT] = {};
+
+  uint32_t copyOffs = 0;
+  uint32_t numCopied = 0, numRead = 0;
+
+  for(;;)
   {
-    uint32_t chunkSize = RDCMIN(len, STAGE_BUFFER_BYTE_SIZE);
+    while(copyOffs < len && numCopied - numRead < STAGE_BUFFER_COUNT)
+    {
+      uint32_t chunkSize = RDCMIN(len - copyOffs, STAGE_BUFFER_BYTE_SIZE);
+
+      if(desc.StructureByteStride > 0)
+        chunkSize -= (chunkSize % desc.StructureByteStride);
+
+      if(chunkSize == 0)
+        break;
+
+      box.left = offs + copyOffs;
+      box.right = offs + copyOffs + chunkSize;
+
+      uint32_t slot = numCopied % STAGE_BUFFER_COUNT;
+
+      m_pImmediateContext->CopySubresourceRegion(m_DebugRender.StageBuffers[slot], 0, 0, 0, 0, src,
+                                                 0, &box);
 
-    if(desc.StructureByteStride > 0)
-      chunkSize -= (chunkSize % desc.StructureByteStride);
+      chunkOffs[slot] = copyOffs;
+      chunkSizes[slot] = chunkSize;
 
-    box.left = RDCMIN(offs + outOffs, desc.ByteWidth);
-    box.right = RDCMIN(offs + outOffs + chunkSize, desc.ByteWidth);
+      copyOffs += chunkSize;
+      numCopied++;
+    }
 
-    if(box.right - box.left == 0)
+    if(numRead == numCopied)
       break;
 
-    m_pImmediateContext->CopySubresourceRegion(m_DebugRender.StageBuffer, 0, 0, 0, 0, src, 0, &box);
+    uint32_t slot = numRead % STAGE_BUFFER_COUNT;
 
-    HRESULT hr = m_pImmediateContext->Map(m_DebugRender.StageBuffer, 0, D3D11_MAP_READ, 0, &mapped);
+    HRESULT hr =
+        m_pImmediateContext->Map(m_DebugRender.StageBuffers[slot], 0, D3D11_MAP_READ, 0, &mapped);
 
     if(FAILED(hr))
     {
       RDCERR("Failed to map bufferdata buffer %08x", hr);
       return;
     }
-    else
-    {
-      memcpy(&ret[outOffs], mapped.pData, RDCMIN(len, STAGE_BUFFER_BYTE_SIZE));
 
-      m_pImmediateContext->Unmap(m_DebugRender.StageBuffer, 0);
-    }
+    memcpy(&ret[chunkOffs[slot]], mapped.pData, chunkSizes[slot]);
+
+    m_pImmediateContext->Unmap(m_DebugRender.StageBuffers[slot], 0);
 
-    outOffs += chunkSize;
-    len -= chunkSize;
+    numRead++;
   }
 }
 
@@ -3693,7 +3732,126 @@ MeshFormat D3D11DebugManager::GetPostVSBuffers(uint32_t eventID, uint32_t instID
   return ret;
 }
 
+static uint64_t GetPostVSDataSize(const D3D11PostVSData &postvs)
+{
+  ID3D11Buffer *bufs[] = {postvs.vsout.buf, postvs.vsout.idxBuf, postvs.gsout.buf,
+                          postvs.gsout.idxBuf};
+
+  uint64_t ret = 0;
+
+  for(size_t i = 0; i < ARRAY_COUNT(bufs); i++)
+  {
+    if(bufs[i] == NULL)
+      continue;
+
+    D3D11_BUFFER_DESC desc;
+    bufs[i]->GetDesc(&desc);
+    ret += desc.ByteWidth;
+  }
+
+  return ret;
+}
+
 void D3D11DebugManager::InitPostVSBuffers(uint32_t eventID)
+{
+  if(m_PostVSCache.Lookup(eventID))
+    return;
+
+  CreatePostVSBuffers(eventID);
+
+  auto it = m_PostVSData.find(eventID);
+  if(it != m_PostVSData.end())
+    m_PostVSCache.Insert(eventID, GetPostVSDataSize(it->second));
+}
+
+void D3D11DebugManager::TrimPostVSCache(uint32_t eventID)
+{
+  std::vector<uint32_t> evicted = m_PostVSCache.Trim(eventID);
+
+  for(size_t i = 0; i < evicted.size(); i++)
+  {
+    D3D11PostVSData &postvs = m_PostVSData[evicted[i]];
+
+    SAFE_RELEASE(postvs.vsout.buf);
+    SAFE_RELEASE(postvs.vsout.idxBuf);
+    SAFE_RELEASE(postvs.gsout.buf);
+    SAFE_RELEASE(postvs.gsout.idxBuf);
+
+    m_PostVSData.erase(evicted[i]);
+  }
+}
+
+static uint64_t GetBuffersSize(ID3D11Buffer *const *bufs, size_t count, uint64_t &num)
+{
+  uint64_t ret = 0;
+
+  for(size_t i = 0; i < count; i++)
+  {
+    if(bufs[i] == NULL)
+      continue;
+
+    D3D11_BUFFER_DESC desc;
+    bufs[i]->GetDesc(&desc);
+    ret += desc.ByteWidth;
+    num++;
+  }
+
+  return ret;
+}
+
+static uint64_t GetTexturesSize(ID3D11Texture2D *const *texs, size_t count, uint64_t &num)
+{
+  uint64_t ret = 0;
+
+  for(size_t i = 0; i < count; i++)
+  {
+    if(texs[i] == NULL)
+      continue;
+
+    D3D11_TEXTURE2D_DESC desc;
+    texs[i]->GetDesc(&desc);
+
+    uint64_t size = 0;
+    for(UINT sub = 0; sub < desc.MipLevels * desc.ArraySize; sub++)
+      size += GetByteSize(texs[i], sub);
+
+    ret += size * RDCMAX(desc.SampleDesc.Count, 1U);
+    num++;
+  }
+
+  return ret;
+}
+
+void D3D11DebugManager::GetMemoryUsage(vector<MemoryUsage> &usage)
+{
+  usage.push_back(MakeMemoryUsage("Post-VS data", true, m_PostVSCache.NumEvents(),
+                                  m_PostVSCache.GetStats().bytes));
+
+  uint64_t count = 0;
+  ID3D11Texture2D *overlays[] = {m_OverlayRenderTex, m_CustomShaderTex};
+  uint64_t bytes = GetTexturesSize(overlays, ARRAY_COUNT(overlays), count);
+  usage.push_back(MakeMemoryUsage("Overlays", true, count, bytes));
+
+  count = 0;
+  ID3D11Buffer *readback[] = {m_DebugRender.StageBuffers[0], m_DebugRender.StageBuffers[1],
+                              m_DebugRender.StageBuffers[2], m_DebugRender.tileResultBuff,
+                              m_DebugRender.resultBuff,      m_DebugRender.resultStageBuff,
+                              m_DebugRender.histogramBuff,   m_DebugRender.histogramStageBuff,
+                              m_DebugRender.PickResultBuf,   m_DebugRender.PixelHistoryCaptureBuf};
+  RDCCOMPILE_ASSERT(STAGE_BUFFER_COUNT == 3, "readback list doesn't cover every staging buffer");
+  ID3D11Texture2D *readbackTex[] = {m_DebugRender.PickPixelStageTex, m_StagingTex2D};
+  bytes = GetBuffersSize(readback, ARRAY_COUNT(readback), count);
+  bytes += GetTexturesSize(readbackTex, ARRAY_COUNT(readbackTex), count);
+  usage.push_back(MakeMemoryUsage("Readback", true, count, bytes));
+
+  count = 0;
+  ID3D11Buffer *mesh[] = {m_SOBuffer, m_SOStagingBuffer, m_DebugRender.PickIBBuf,
+                          m_DebugRender.PickVBBuf};
+  bytes = GetBuffersSize(mesh, ARRAY_COUNT(mesh), count);
+  usage.push_back(MakeMemoryUsage("Mesh data", true, count, bytes));
+}
+
+void D3D11DebugManager::CreatePostVSBuffers(uint32_t eventID)
 {
   if(m_PostVSData.find(eventID) != m_PostVSData.end())
     return;
@@ -29,8 +29,10 @@
 #include <map>
 #include <utility>
 #include "api/replay/renderdoc_replay.h"
+#include "common/shader_cache.h"
 #include "driver/dx/official/d3d11_4.h"
 #include "driver/shaders/dxbc/dxbc_debug.h"
+#include "replay/counter_provider.h"
 #include "replay/replay_driver.h"
 #include "d3d11_renderstate.h"
 
@@ -101,6 +103,8 @@ struct D3D11PostVSData
 
 struct CopyPixelParams;
 struct GetTextureDataParams;
+struct VertexDebugBatch;
+struct PixelDebugBatch;
 
 class D3D11DebugManager
 {
@@ -127,6 +131,10 @@ public:
   int GetWidth() { return m_width; }
   int GetHeight() { return m_height; }
   void InitPostVSBuffers(uint32_t eventID);
+  // free the least recently used post-VS data if it's over budget, other than eventID's
+  void TrimPostVSCache(uint32_t eventID);
+  // estimated GPU memory used for post-VS data, overlays, readback and mesh display
+  void GetMemoryUsage(vector<MemoryUsage> &usage);
   MeshFormat GetPostVSBuffers(uint32_t eventID, uint32_t instID, MeshDataStage stage);
 
   uint32_t GetStructCount(ID3D11UnorderedAccessView *uav);
@@ -188,15 +196,26 @@ public:
   vector<PixelModification> PixelHistory(vector<EventUsage> events, ResourceId target, uint32_t x,
                                          uint32_t y, uint32_t slice, uint32_t mip,
                                          uint32_t sampleIdx, CompType typeHint);
+  vector<vector<PixelModification> > PixelHistoryRegion(vector<EventUsage> events,
+                                                        ResourceId target, uint32_t x, uint32_t y,
+                                                        uint32_t width, uint32_t height,
+                                                        uint32_t slice, uint32_t mip,
+                                                        uint32_t sampleIdx, CompType typeHint);
   ShaderDebugTrace DebugVertex(uint32_t eventID, uint32_t vertid, uint32_t instid, uint32_t idx,
                                uint32_t instOffset, uint32_t vertOffset);
   ShaderDebugTrace DebugPixel(uint32_t eventID, uint32_t x, uint32_t y, uint32_t sample,
                               uint32_t primitive);
+  vector<ShaderDebugTrace> DebugVertices(uint32_t eventID,
+                                         const vector<ShaderDebugVertexInput> &inputs,
+                                         uint32_t instOffset, uint32_t vertOffset);
+  vector<ShaderDebugTrace> DebugPixels(uint32_t eventID,
+                                       const vector<ShaderDebugPixelInput> &inputs);
   ShaderDebugTrace DebugThread(uint32_t eventID, const uint32_t groupid[3],
                                const uint32_t threadid[3]);
   void PickPixel(ResourceId texture, uint32_t x, uint32_t y, uint32_t sliceFace, uint32_t mip,
                  uint32_t sample, CompType typeHint, float pixel[4]);
   uint32_t PickVertex(uint32_t eventID, const MeshDisplay &cfg, uint32_t x, uint32_t y);
+  void InvalidatePickCache() { m_DebugRender.PickCache.Invalidate(); }
 
   ResourceId RenderOverlay(ResourceId texid, CompType typeHint, DebugOverlay overlay,
                            uint32_t eventID, const vector<uint32_t> &passEvents);
@@ -334,8 +353,8 @@ private:
   static const uint32_t m_ShaderCacheMagic = 0xf000baba;
   static const uint32_t m_ShaderCacheVersion = 3;
 
-  bool m_ShaderCacheDirty, m_CacheShaders;
-  map<uint32_t, ID3DBlob *> m_ShaderCache;
+  bool m_CacheShaders;
+  ShaderCache<ID3DBlob *> m_ShaderCache;
 
   uint32_t m_SOBufferSize = 32 * 1024 * 1024;
   ID3D11Buffer *m_SOBuffer = NULL;
@@ -343,6 +362,9 @@ private:
   std::vector<ID3D11Query *> m_SOStatsQueries;
   // event -> data
   map<uint32_t, D3D11PostVSData> m_PostVSData;
+  PostVSCacheTracker m_PostVSCache;
+
+  void CreatePostVSBuffers(uint32_t eventID);
 
   HighlightCache m_HighlightCache;
 
@@ -353,6 +375,11 @@ private:
   ID3D11RenderTargetView *m_CustomShaderRTV;
   ResourceId m_CustomShaderResourceId;
 
+  // the last staging texture GetTextureData used, kept for the next read with the same desc
+  ID3D11Texture2D *m_StagingTex2D;
+  D3D11_TEXTURE2D_DESC m_StagingTex2DDesc;
+  HRESULT GetStagingTexture2D(const D3D11_TEXTURE2D_DESC &desc, ID3D11Texture2D **tex);
+
   ID3D11BlendState *m_WireframeHelpersBS;
   ID3D11RasterizerState *m_WireframeHelpersRS, *m_WireframeHelpersCullCCWRS,
       *m_WireframeHelpersCullCWRS;
@@ -382,12 +409,17 @@ private:
   void CreateCustomShaderTex(uint32_t w, uint32_t h);
 
   void PixelHistoryCopyPixel(CopyPixelParams &params, uint32_t x, uint32_t y);
+  void PixelHistoryCapturePrimitives(const vector<PixelModification> &history, uint32_t x,
+                                     uint32_t y, uint32_t sampleMask, ID3D11DepthStencilView *dsv,
+                                     map<uint32_t, vector<uint32_t> > &primitives);
 
   static const int FONT_TEX_WIDTH = 256;
   static const int FONT_TEX_HEIGHT = 128;
   static const int FONT_MAX_CHARS = 256;
 
   static const uint32_t STAGE_BUFFER_BYTE_SIZE = 4 * 1024 * 1024;
+  // buffer readbacks queue copies into this many staging buffers before mapping the oldest
+  static const uint32_t STAGE_BUFFER_COUNT = 3;
 
   struct FontData
   {
@@ -418,7 +450,8 @@ private:
     DebugRenderData() { RDCEraseMem(this, sizeof(DebugRenderData)); }
     ~DebugRenderData()
     {
-      SAFE_RELEASE(StageBuffer);
+      for(int i = 0; i < ARRAY_COUNT(StageBuffers); i++)
+        SAFE_RELEASE(StageBuffers[i]);
 
       SAFE_RELEASE(RastState);
       SAFE_RELEASE(BlendState);
@@ -458,6 +491,9 @@ private:
       SAFE_RELEASE(PixelHistoryUnusedCS);
       SAFE_RELEASE(PixelHistoryCopyCS);
       SAFE_RELEASE(PrimitiveIDPS);
+      SAFE_RELEASE(PixelHistoryCapturePS);
+      SAFE_RELEASE(PixelHistoryCaptureBuf);
+      SAFE_RELEASE(PixelHistoryCaptureUAV);
 
       SAFE_RELEASE(MeshPickCS);
       SAFE_RELEASE(PickIBBuf);
@@ -509,7 +545,7 @@ private:
       }
     }
 
-    ID3D11Buffer *StageBuffer;
+    ID3D11Buffer *StageBuffers[STAGE_BUFFER_COUNT];
 
     ID3D11RasterizerState *RastState;
     ID3D11SamplerState *PointSampState, *LinearSampState;
@@ -533,11 +569,18 @@ private:
     ID3D11ComputeShader *PixelHistoryUnusedCS, *PixelHistoryCopyCS;
     ID3D11PixelShader *PrimitiveIDPS;
 
+    static const uint32_t maxCapturedFragments = 8192;
+
+    ID3D11PixelShader *PixelHistoryCapturePS;
+    ID3D11Buffer *PixelHistoryCaptureBuf;
+    ID3D11UnorderedAccessView *PixelHistoryCaptureUAV;
+
     static const uint32_t maxMeshPicks = 500;
 
     ID3D11ComputeShader *MeshPickCS;
     ID3D11Buffer *PickIBBuf, *PickVBBuf;
     uint32_t PickIBSize, PickVBSize;
+    MeshPickCache PickCache;
     ID3D11ShaderResourceView *PickIBSRV, *PickVBSRV;
     ID3D11Buffer *PickResultBuf;
     ID3D11UnorderedAccessView *PickResultUAV;
@@ -565,7 +608,9 @@ private:
   bool InitDebugRendering();
 
   ShaderDebug::State CreateShaderDebugState(ShaderDebugTrace &trace, int quadIdx,
-                                            DXBC::DXBCFile *dxbc, vector<byte> *cbufData);
+                                            DXBC::DXBCFile *dxbc,
+                                            const ShaderDebug::GlobalState &global,
+                                            vector<byte> *cbufData);
   void CreateShaderGlobalState(ShaderDebug::GlobalState &global, DXBC::DXBCFile *dxbc,
                                uint32_t UAVStartSlot, ID3D11UnorderedAccessView **UAVs,
                                ID3D11ShaderResourceView **SRVs);
@@ -574,6 +619,13 @@ private:
                             vector<ShaderVariable> &outvars, const vector<byte> &data);
   friend struct ShaderDebugState;
 
+  // batched debugging does the GPU work up front on the replay thread, then these run the CPU
+  // simulation of each invocation across worker threads.
+  static void DebugVertexWorker(void *batch);
+  static void DebugPixelWorker(void *batch);
+  void SimulateVertex(VertexDebugBatch &batch, size_t job);
+  void SimulatePixel(PixelDebugBatch &batch, size_t job);
+
   // called after the device is created, to init any counters
   void PostDeviceInitCounters();
 
@@ -582,5 +634,10 @@ private:
 
   void FillTimers(D3D11CounterContext &ctx, const DrawcallTreeNode &drawnode);
 
+  // vendor hardware counters
+  CounterProviders m_CounterProviders;
+  void FillProviderSamples(uint32_t &eventStart, const DrawcallTreeNode &drawnode);
+  vector<CounterResult> FetchProviderCounters(const vector<GPUCounter> &counters);
+
   void FillCBuffer(ID3D11Buffer *buf, const void *data, size_t size);
 };
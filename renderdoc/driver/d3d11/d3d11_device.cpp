@@ -29,7 +29,6 @@
 #include "driver/d3d11/d3d11_renderstate.h"
 #include "driver/d3d11/d3d11_resources.h"
 #include "driver/dxgi/dxgi_wrapped.h"
-#include "jpeg-compressor/jpge.h"
 #include "maths/formatpacking.h"
 #include "serialise/string_utils.h"
 
@@ -198,6 +197,8 @@ const char *D3D11ChunkNames[] = {
     "ID3D11DeviceContext::FinishCommandList",
 
     "ID3D11DeviceContext1::SwapDeviceContextState",
+
+    "FrameBoundary",
 };
 
 WRAPPED_POOL_INST(WrappedID3D11Device);
@@ -240,6 +241,9 @@ const uint32_t D3D11InitParams::D3D11_OLD_VERSIONS[D3D11InitParams::D3D11_NUM_SU
     0x000009,
     // from 0xA to 0xB, we added the SwapDeviceContextState from ID3D11DeviceContext1
     0x00000A,
+    // from 0xB to 0xC, we added the list of textures with placeholder initial contents to the
+    // capture scope
+    0x00000B,
 };
 
 ReplayStatus D3D11InitParams::Serialise()
@@ -349,6 +353,22 @@ WrappedID3D11Device::WrappedID3D11Device(ID3D11Device *realDevice, D3D11InitPara
   m_FailedReason = CaptureSucceeded;
   m_Failures = 0;
 
+  m_InitialStatePack = NULL;
+  m_InitialStatePackUsed = 0;
+  m_MappedInitialStatePack = NULL;
+  RDCEraseEl(m_MappedInitialStatePackData);
+
+  m_CheckpointInterval = 0;
+  m_CheckpointBudget = 0;
+  m_CheckpointBytes = 0;
+  m_NextCheckpoint = ~0U;
+
+  m_DeferInitialStates = false;
+  m_DeferringInitialStates = false;
+  m_InitialStateChunkOffset = 0;
+  m_InitialStateBudget = 0;
+  m_RecordingInitialStateLocations = false;
+
   m_ChunkAtomic = 0;
 
   m_AppControlledCapture = false;
@@ -369,6 +389,23 @@ WrappedID3D11Device::WrappedID3D11Device(ID3D11Device *realDevice, D3D11InitPara
     string shaderSearchPathString = RenderDoc::Inst().GetConfigSetting("shader.debug.searchPaths");
     split(shaderSearchPathString, m_ShaderSearchPaths, ';');
 
+    // replay checkpoints are taken every N events, within a budget in MB. Either being 0 disables
+    // them.
+    const string &interval = RenderDoc::Inst().GetConfigSetting("replay.checkpoints.interval");
+    const string &budget = RenderDoc::Inst().GetConfigSetting("replay.checkpoints.budget");
+
+    m_CheckpointInterval = interval.empty() ? 2048 : (uint32_t)RDCMAX(0, atoi(interval.c_str()));
+    m_CheckpointBudget = budget.empty() ? 256 : (uint64_t)RDCMAX(0, atoi(budget.c_str()));
+    m_CheckpointBudget *= 1024 * 1024;
+
+    m_DeferInitialStates =
+        atoi(RenderDoc::Inst().GetConfigSetting("replay.initialContents.deferred").c_str()) != 0;
+
+    // in MB, 0 for no limit
+    m_InitialStateBudget = (uint64_t)RDCMAX(
+        0, atoi(RenderDoc::Inst().GetConfigSetting("replay.initialContents.budget").c_str()));
+    m_InitialStateBudget *= 1024 * 1024;
+
     ResourceIDGen::SetReplayResourceIDs();
   }
   else
@@ -497,6 +534,9 @@ WrappedID3D11Device::~WrappedID3D11Device()
 
   SAFE_RELEASE(m_RealAnnotations);
 
+  // the checkpoints' pipeline states hold references that must be released before the context
+  FreeReplayCheckpoints();
+
   SAFE_RELEASE(m_pImmediateContext);
 
   for(auto it = m_SwapChains.begin(); it != m_SwapChains.end(); ++it)
@@ -1080,7 +1120,10 @@ void WrappedID3D11Device::ProcessChunk(uint64_t offset, D3D11ChunkType context)
     default:
       // ignore system chunks
       if(context == INITIAL_CONTENTS)
+      {
+        m_InitialStateChunkOffset = offset;
         Serialise_InitialState(ResourceId(), NULL);
+      }
       else if(context < FIRST_CHUNK_ID)
         m_pSerialiser->SkipCurrentChunk();
       else
@@ -1093,6 +1136,9 @@ void WrappedID3D11Device::Serialise_CaptureScope(uint64_t offset)
 {
   SERIALISE_ELEMENT(uint32_t, FrameNumber, m_FrameCounter);
 
+  if(m_State >= WRITING || GetLogVersion() >= 0x00000C)
+    GetResourceManager()->Serialise_InitialContentsPlaceholders();
+
   if(m_State >= WRITING)
   {
     GetResourceManager()->Serialise_InitialContentsNeeded();
@@ -1144,10 +1190,15 @@ void WrappedID3D11Device::ReadLogInitialisation()
 
   LazyInit();
 
-  m_pSerialiser->SetDebugText(true);
-
   m_pSerialiser->Rewind();
 
+  // buffers that refer back to identical earlier ones have to be read in order, so deferring can
+  // only be done without them
+  m_RecordingInitialStateLocations = (m_DeferInitialStates || m_InitialStateBudget > 0) &&
+                                     m_pSerialiser->CanReadRange() &&
+                                     !m_pSerialiser->HasDedupReferences();
+  m_DeferringInitialStates = m_DeferInitialStates && m_RecordingInitialStateLocations;
+
   int chunkIdx = 0;
 
   struct chunkinfo
@@ -1188,8 +1239,17 @@ void WrappedID3D11Device::ReadLogInitialisation()
     {
       frameOffset = offset;
 
+      if(m_DeferringInitialStates)
+        RDCLOG("Deferred %u texture initial contents", (uint32_t)m_DeferredInitialStates.size());
+
+      m_DeferringInitialStates = false;
+      m_RecordingInitialStateLocations = false;
+
       GetResourceManager()->ApplyInitialContents();
 
+      // debug text is only needed for the events in the frame, not the chunks before it
+      m_pSerialiser->SetDebugText(true);
+
       m_pImmediateContext->ReplayLog(READING, 0, 0, false);
     }
 
@@ -1233,6 +1293,78 @@ void WrappedID3D11Device::ReadLogInitialisation()
   m_pSerialiser->SetDebugText(false);
 }
 
+uint64_t WrappedID3D11Device::PrepareAheadSize_InitialState(ID3D11DeviceChild *res)
+{
+  ResourceType type = IdentifyTypeByPtr(res);
+
+  uint64_t size = 0;
+
+  if(type == Resource_Buffer)
+  {
+    D3D11ResourceRecord *record = m_ResourceManager->GetResourceRecord(GetIDForResource(res));
+
+    if(record)
+      size = record->Length;
+  }
+  else if(type == Resource_Texture1D)
+  {
+    WrappedID3D11Texture1D *tex = (WrappedID3D11Texture1D *)res;
+
+    D3D11_TEXTURE1D_DESC desc;
+    tex->GetDesc(&desc);
+
+    for(UINT sub = 0; sub < desc.MipLevels * desc.ArraySize; sub++)
+      size += GetByteSize(tex, sub);
+  }
+  else if(type == Resource_Texture2D)
+  {
+    WrappedID3D11Texture2D1 *tex = (WrappedID3D11Texture2D1 *)res;
+
+    D3D11_TEXTURE2D_DESC desc;
+    tex->GetDesc(&desc);
+
+    for(UINT sub = 0; sub < desc.MipLevels * desc.ArraySize; sub++)
+      size += GetByteSize(tex, sub);
+
+    size *= RDCMAX(desc.SampleDesc.Count, 1U);
+  }
+  else if(type == Resource_Texture3D)
+  {
+    WrappedID3D11Texture3D1 *tex = (WrappedID3D11Texture3D1 *)res;
+
+    D3D11_TEXTURE3D_DESC desc;
+    tex->GetDesc(&desc);
+
+    for(UINT mip = 0; mip < desc.MipLevels; mip++)
+      size += GetByteSize(tex, mip);
+  }
+
+  // UAV counters are copied with the capture's other UAVs, they're not worth preparing early
+  return size;
+}
+
+uint64_t WrappedID3D11Device::GetSize_InitialState(ID3D11DeviceChild *res)
+{
+  ResourceType type = IdentifyTypeByPtr(res);
+
+  // only texture contents are left out to fit the initial contents budget, buffers and UAV
+  // counters can't be substituted with anything sensible.
+  if(type == Resource_Texture1D || type == Resource_Texture2D || type == Resource_Texture3D)
+    return PrepareAheadSize_InitialState(res);
+
+  return 0;
+}
+
+void WrappedID3D11Device::PrepareInitialStateAhead()
+{
+  uint64_t budget = uint64_t(RenderDoc::Inst().GetCaptureOptions().PrepareAheadBudget) << 20;
+
+  if(budget == 0)
+    return;
+
+  GetResourceManager()->PrepareInitialContentsAhead(budget);
+}
+
 bool WrappedID3D11Device::Prepare_InitialState(ID3D11DeviceChild *res)
 {
   ResourceType type = IdentifyTypeByPtr(res);
@@ -1300,6 +1432,54 @@ bool WrappedID3D11Device::Prepare_InitialState(ID3D11DeviceChild *res)
     WrappedID3D11Buffer *buf = (WrappedID3D11Buffer *)res;
     D3D11ResourceRecord *record = m_ResourceManager->GetResourceRecord(Id);
 
+    // small buffers are packed together into shared staging buffers, so that there's one copy
+    // target and one map for many of them. The initial contents' num is the offset in the pack.
+    if(record->Length <= InitialStatePackMaxBuffer)
+    {
+      UINT length = (UINT)record->Length;
+
+      if(m_InitialStatePack == NULL || m_InitialStatePackUsed + length > InitialStatePackSize)
+      {
+        m_InitialStatePack = NULL;
+        m_InitialStatePackUsed = 0;
+
+        D3D11_BUFFER_DESC desc;
+        desc.BindFlags = 0;
+        desc.ByteWidth = InitialStatePackSize;
+        desc.MiscFlags = 0;
+        desc.StructureByteStride = 0;
+        desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+        desc.Usage = D3D11_USAGE_STAGING;
+        HRESULT hr = m_pDevice->CreateBuffer(&desc, NULL, &m_InitialStatePack);
+
+        if(FAILED(hr) || m_InitialStatePack == NULL)
+        {
+          RDCERR("Failed to create staging pack for buffer initial contents %08x", hr);
+          m_InitialStatePack = NULL;
+          return true;
+        }
+      }
+      else
+      {
+        // each buffer packed in holds its own reference, the first one took the creation reference
+        m_InitialStatePack->AddRef();
+      }
+
+      D3D11_BOX box = {0, 0, 0, length, 1, 1};
+
+      m_pImmediateContext->GetReal()->CopySubresourceRegion(
+          m_InitialStatePack, 0, m_InitialStatePackUsed, 0, 0, UNWRAP(WrappedID3D11Buffer, buf), 0,
+          &box);
+
+      m_ResourceManager->SetInitialContents(
+          Id, D3D11ResourceManager::InitialContentData(m_InitialStatePack, m_InitialStatePackUsed,
+                                                       NULL));
+
+      m_InitialStatePackUsed = AlignUp16(m_InitialStatePackUsed + length);
+
+      return true;
+    }
+
     ID3D11Buffer *stage = NULL;
 
     D3D11_BUFFER_DESC desc;
@@ -1462,6 +1642,35 @@ bool WrappedID3D11Device::Prepare_InitialState(ID3D11DeviceChild *res)
   return true;
 }
 
+HRESULT WrappedID3D11Device::MapInitialStatePack(ID3D11Buffer *pack,
+                                                 D3D11_MAPPED_SUBRESOURCE &mapped)
+{
+  if(pack != m_MappedInitialStatePack)
+  {
+    UnmapInitialStatePack();
+
+    HRESULT hr = m_pImmediateContext->GetReal()->Map(pack, 0, D3D11_MAP_READ, 0,
+                                                     &m_MappedInitialStatePackData);
+
+    if(FAILED(hr))
+      return hr;
+
+    m_MappedInitialStatePack = pack;
+  }
+
+  mapped = m_MappedInitialStatePackData;
+
+  return S_OK;
+}
+
+void WrappedID3D11Device::UnmapInitialStatePack()
+{
+  if(m_MappedInitialStatePack)
+    m_pImmediateContext->GetReal()->Unmap(m_MappedInitialStatePack, 0);
+
+  m_MappedInitialStatePack = NULL;
+}
+
 bool WrappedID3D11Device::Serialise_InitialState(ResourceId resid, ID3D11DeviceChild *res)
 {
   ResourceType type = Resource_Unknown;
@@ -1480,8 +1689,32 @@ bool WrappedID3D11Device::Serialise_InitialState(ResourceId resid, ID3D11DeviceC
   }
   else
   {
+    uint64_t contentsOffset = m_pSerialiser->GetOffset();
+
     m_pSerialiser->Serialise("type", type);
     m_pSerialiser->Serialise("Id", Id);
+
+    // textures hold almost all of the initial contents data, so note where the chunk is so it
+    // can be re-read later. With deferred initial contents, skip it for now.
+    if(m_RecordingInitialStateLocations && m_ResourceManager->HasLiveResource(Id) &&
+       (type == Resource_Texture1D || type == Resource_Texture2D || type == Resource_Texture3D))
+    {
+      uint64_t chunkEnd = contentsOffset + m_pSerialiser->GetCurrentChunkLength();
+
+      DeferredInitialState &location = m_InitialStateLocations[Id];
+      location.offset = m_InitialStateChunkOffset;
+      location.length = chunkEnd - m_InitialStateChunkOffset;
+      location.firstUse = ~0U;
+      location.firstUseKnown = false;
+
+      if(m_DeferringInitialStates)
+      {
+        m_DeferredInitialStates[Id] = location;
+
+        m_pSerialiser->SetOffset(chunkEnd);
+        return true;
+      }
+    }
   }
 
   {
@@ -1586,12 +1819,19 @@ bool WrappedID3D11Device::Serialise_InitialState(ResourceId resid, ID3D11DeviceC
       desc.MiscFlags = 0;
       desc.StructureByteStride = 0;
 
-      ID3D11Buffer *stage = (ID3D11Buffer *)m_ResourceManager->GetInitialContents(Id).resource;
+      D3D11ResourceManager::InitialContentData initial = m_ResourceManager->GetInitialContents(Id);
+      ID3D11Buffer *stage = (ID3D11Buffer *)initial.resource;
 
       D3D11_MAPPED_SUBRESOURCE mapped = {};
       HRESULT hr = E_INVALIDARG;
 
-      if(stage)
+      // buffers packed together stay mapped across consecutive initial states, see
+      // Prepare_InitialState
+      bool packed = (record->Length <= InitialStatePackMaxBuffer);
+
+      if(stage && packed)
+        hr = MapInitialStatePack(stage, mapped);
+      else if(stage)
         hr = m_pImmediateContext->GetReal()->Map(stage, 0, D3D11_MAP_READ, 0, &mapped);
       else
         RDCERR(
@@ -1607,12 +1847,16 @@ bool WrappedID3D11Device::Serialise_InitialState(ResourceId resid, ID3D11DeviceC
       {
         RDCASSERT(record->DataInSerialiser);
 
+        if(packed)
+          mapped.pData = (byte *)mapped.pData + initial.num;
+
         MapIntercept intercept;
         intercept.SetD3D(mapped);
         intercept.Init(buf, record->GetDataPtr());
         intercept.CopyFromD3D();
 
-        m_pImmediateContext->GetReal()->Unmap(stage, 0);
+        if(!packed)
+          m_pImmediateContext->GetReal()->Unmap(stage, 0);
       }
     }
   }
@@ -1661,6 +1905,15 @@ bool WrappedID3D11Device::Serialise_InitialState(ResourceId resid, ID3D11DeviceC
 
         if(m_State >= WRITING)
         {
+          // subresources the frame never references are written empty and left undefined on
+          // replay
+          if(!m_ResourceManager->IsSubresourceFrameReferenced(Id, sub))
+          {
+            size_t len = 0;
+            m_pSerialiser->SerialiseBuffer("", inmemBuffer, len);
+            continue;
+          }
+
           D3D11_MAPPED_SUBRESOURCE mapped = {};
           HRESULT hr = E_INVALIDARG;
 
@@ -1698,6 +1951,14 @@ bool WrappedID3D11Device::Serialise_InitialState(ResourceId resid, ID3D11DeviceC
           size_t len = 0;
           m_pSerialiser->SerialiseBuffer("", data, len);
 
+          if(tex1D && len == 0)
+          {
+            SAFE_DELETE_ARRAY(data);
+            len = GetByteSize(desc.Width, 1, 1, desc.Format, mip);
+            data = new byte[len];
+            memset(data, 0, len);
+          }
+
           if(tex1D)
           {
             subData[sub].pSysMem = data;
@@ -1814,6 +2075,15 @@ bool WrappedID3D11Device::Serialise_InitialState(ResourceId resid, ID3D11DeviceC
 
         if(m_State >= WRITING)
         {
+          // subresources the frame never references are written empty and left undefined on
+          // replay
+          if(!m_ResourceManager->IsSubresourceFrameReferenced(Id, sub))
+          {
+            size_t len = 0;
+            m_pSerialiser->SerialiseBuffer("", inmemBuffer, len);
+            continue;
+          }
+
           D3D11_MAPPED_SUBRESOURCE mapped = {};
           HRESULT hr = E_INVALIDARG;
 
@@ -1859,6 +2129,14 @@ bool WrappedID3D11Device::Serialise_InitialState(ResourceId resid, ID3D11DeviceC
           size_t len = 0;
           m_pSerialiser->SerialiseBuffer("", data, len);
 
+          if(tex2D && len == 0)
+          {
+            SAFE_DELETE_ARRAY(data);
+            len = GetByteSize(desc.Width, desc.Height, 1, desc.Format, mip);
+            data = new byte[len];
+            memset(data, 0, len);
+          }
+
           if(tex2D)
           {
             subData[sub].pSysMem = data;
@@ -1991,6 +2269,15 @@ bool WrappedID3D11Device::Serialise_InitialState(ResourceId resid, ID3D11DeviceC
 
         if(m_State >= WRITING)
         {
+          // subresources the frame never references are written empty and left undefined on
+          // replay
+          if(!m_ResourceManager->IsSubresourceFrameReferenced(Id, sub))
+          {
+            size_t len = 0;
+            m_pSerialiser->SerialiseBuffer("", inmemBuffer, len);
+            continue;
+          }
+
           D3D11_MAPPED_SUBRESOURCE mapped = {};
           HRESULT hr = E_INVALIDARG;
 
@@ -2047,6 +2334,14 @@ bool WrappedID3D11Device::Serialise_InitialState(ResourceId resid, ID3D11DeviceC
           size_t len = 0;
           m_pSerialiser->SerialiseBuffer("", data, len);
 
+          if(tex3D && len == 0)
+          {
+            SAFE_DELETE_ARRAY(data);
+            len = GetByteSize(desc.Width, desc.Height, desc.Depth, desc.Format, mip);
+            data = new byte[len];
+            memset(data, 0, len);
+          }
+
           if(tex3D)
           {
             subData[sub].pSysMem = data;
@@ -2461,11 +2756,40 @@ void WrappedID3D11Device::ReplayLog(uint32_t startEventID, uint32_t endEventID,
 
   m_pSerialiser->PopContext(header);
 
+  // a replay starting from the beginning of the frame can instead start from the latest checkpoint
+  // at or before the first event it doesn't replay.
   if(!partial)
   {
-    D3D11MarkerRegion apply("ApplyInitialContents");
-    GetResourceManager()->ApplyInitialContents();
-    GetResourceManager()->ReleaseInFrameResources();
+    // a draw-only replay of endEventID usually follows this, so load what it needs too
+    LoadDeferredInitialStates(endEventID);
+    EvictInitialStates(endEventID);
+
+    uint32_t firstUnreplayed = replayType == eReplay_Full ? endEventID + 1 : RDCMAX(1U, endEventID);
+
+    const ReplayCheckpoint *cp = NULL;
+
+    for(size_t i = 0; i < m_Checkpoints.size() && m_Checkpoints[i].eventID <= firstUnreplayed; i++)
+      cp = &m_Checkpoints[i];
+
+    if(cp)
+    {
+      D3D11MarkerRegion restore(StringFormat::Fmt("RestoreReplayCheckpoint %u", cp->eventID));
+      GetResourceManager()->ReleaseInFrameResources();
+      RestoreReplayCheckpoint(*cp);
+
+      startEventID = cp->eventID;
+      partial = true;
+    }
+    else
+    {
+      D3D11MarkerRegion apply("ApplyInitialContents");
+      GetResourceManager()->ApplyInitialContents();
+      GetResourceManager()->ReleaseInFrameResources();
+    }
+
+    // take checkpoints from here onwards, as we're replaying from a known state
+    if(m_CheckpointInterval > 0 && m_CheckpointBudget > 0)
+      m_NextCheckpoint = (startEventID / m_CheckpointInterval + 1) * m_CheckpointInterval;
   }
 
   m_State = EXECUTING;
@@ -2492,6 +2816,381 @@ void WrappedID3D11Device::ReplayLog(uint32_t startEventID, uint32_t endEventID,
   {
     RDCFATAL("Unexpected replay type");
   }
+
+  m_NextCheckpoint = ~0U;
+}
+
+void WrappedID3D11Device::CheckpointReplay(uint32_t eventID, uint64_t fileOffset)
+{
+  if(eventID < m_NextCheckpoint)
+    return;
+
+  m_NextCheckpoint = (eventID / m_CheckpointInterval + 1) * m_CheckpointInterval;
+
+  // only checkpoint at the start of an actual event, so that replay can be resumed from it.
+  APIEvent ev = m_pImmediateContext->GetEvent(eventID);
+  if(ev.eventID != eventID || ev.fileOffset != fileOffset)
+    return;
+
+  // resources created mid-frame are released at the start of each replay and only recreated by
+  // replaying their creation, and maps can't be resumed half-way through.
+  if(GetResourceManager()->HasInFrameResources() || m_pImmediateContext->HasOpenMaps())
+    return;
+
+  size_t insertIdx = 0;
+  for(; insertIdx < m_Checkpoints.size(); insertIdx++)
+  {
+    if(m_Checkpoints[insertIdx].eventID == eventID)
+      return;
+    if(m_Checkpoints[insertIdx].eventID > eventID)
+      break;
+  }
+
+  ReplayCheckpoint cp;
+  cp.eventID = eventID;
+  cp.state = NULL;
+  cp.byteSize = 0;
+
+  vector<ID3D11Resource *> resources;
+
+  for(auto it = WrappedID3D11Buffer::m_BufferList.begin();
+      it != WrappedID3D11Buffer::m_BufferList.end(); ++it)
+    resources.push_back(it->second.m_Buffer);
+  for(auto it = WrappedID3D11Texture1D::m_TextureList.begin();
+      it != WrappedID3D11Texture1D::m_TextureList.end(); ++it)
+    resources.push_back(it->second.m_Texture);
+  for(auto it = WrappedID3D11Texture2D1::m_TextureList.begin();
+      it != WrappedID3D11Texture2D1::m_TextureList.end(); ++it)
+    resources.push_back(it->second.m_Texture);
+  for(auto it = WrappedID3D11Texture3D1::m_TextureList.begin();
+      it != WrappedID3D11Texture3D1::m_TextureList.end(); ++it)
+    resources.push_back(it->second.m_Texture);
+
+  for(size_t i = 0; i < resources.size(); i++)
+  {
+    ID3D11Resource *live = resources[i];
+    ResourceId liveid = GetIDForResource(live);
+    ResourceId origid = GetResourceManager()->GetOriginalID(liveid);
+
+    // skip anything that isn't from the capture, like our own replay resources
+    if(origid == liveid || !GetResourceManager()->HasLiveResource(origid))
+      continue;
+
+    uint64_t size = 0;
+    ID3D11Resource *copy = CreateCheckpointCopy(live, size);
+
+    if(copy == NULL)
+      continue;
+
+    if(m_CheckpointBytes + cp.byteSize + size > m_CheckpointBudget)
+    {
+      SAFE_RELEASE(copy);
+
+      for(size_t c = 0; c < cp.copies.size(); c++)
+        SAFE_RELEASE(cp.copies[c].second);
+
+      RDCDEBUG("Replay checkpoint at %u doesn't fit in budget, no more will be taken", eventID);
+
+      m_NextCheckpoint = ~0U;
+      return;
+    }
+
+    m_pImmediateContext->GetReal()->CopyResource(copy, GetResourceManager()->UnwrapResource(live));
+
+    cp.copies.push_back(std::make_pair(live, copy));
+    cp.byteSize += size;
+  }
+
+  cp.state = new D3D11RenderState(*m_pImmediateContext->GetCurrentPipelineState());
+
+  m_CheckpointBytes += cp.byteSize;
+  m_Checkpoints.insert(m_Checkpoints.begin() + insertIdx, cp);
+
+  RDCDEBUG("Took replay checkpoint at %u of %llu bytes (%llu total)", eventID, cp.byteSize,
+           m_CheckpointBytes);
+}
+
+ID3D11Resource *WrappedID3D11Device::CreateCheckpointCopy(ID3D11Resource *live, uint64_t &byteSize)
+{
+  ResourceType type = IdentifyTypeByPtr(live);
+
+  HRESULT hr = S_OK;
+  ID3D11Resource *copy = NULL;
+
+  if(type == Resource_Buffer)
+  {
+    D3D11_BUFFER_DESC desc;
+    ((WrappedID3D11Buffer *)live)->GetDesc(&desc);
+
+    if(desc.Usage == D3D11_USAGE_IMMUTABLE)
+      return NULL;
+
+    desc.BindFlags = 0;
+    desc.CPUAccessFlags = 0;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.MiscFlags = 0;
+    desc.StructureByteStride = 0;
+
+    byteSize = desc.ByteWidth;
+
+    hr = m_pDevice->CreateBuffer(&desc, NULL, (ID3D11Buffer **)&copy);
+  }
+  else if(type == Resource_Texture1D)
+  {
+    D3D11_TEXTURE1D_DESC desc;
+    ((WrappedID3D11Texture1D *)live)->GetDesc(&desc);
+
+    if(desc.Usage == D3D11_USAGE_IMMUTABLE)
+      return NULL;
+
+    desc.CPUAccessFlags = 0;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = 0;
+    if(IsDepthFormat(desc.Format))
+      desc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
+    desc.MiscFlags &= ~D3D11_RESOURCE_MISC_GENERATE_MIPS;
+
+    byteSize = PrepareAheadSize_InitialState(live);
+
+    hr = m_pDevice->CreateTexture1D(&desc, NULL, (ID3D11Texture1D **)&copy);
+  }
+  else if(type == Resource_Texture2D)
+  {
+    D3D11_TEXTURE2D_DESC desc;
+    ((WrappedID3D11Texture2D1 *)live)->GetDesc(&desc);
+
+    if(desc.Usage == D3D11_USAGE_IMMUTABLE)
+      return NULL;
+
+    bool isMS = (desc.SampleDesc.Count > 1 || desc.SampleDesc.Quality > 0);
+
+    desc.CPUAccessFlags = 0;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = isMS ? D3D11_BIND_SHADER_RESOURCE : 0;
+    if(IsDepthFormat(desc.Format))
+      desc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
+    desc.MiscFlags &= ~D3D11_RESOURCE_MISC_GENERATE_MIPS;
+
+    byteSize = PrepareAheadSize_InitialState(live);
+
+    hr = m_pDevice->CreateTexture2D(&desc, NULL, (ID3D11Texture2D **)&copy);
+  }
+  else if(type == Resource_Texture3D)
+  {
+    D3D11_TEXTURE3D_DESC desc;
+    ((WrappedID3D11Texture3D1 *)live)->GetDesc(&desc);
+
+    if(desc.Usage == D3D11_USAGE_IMMUTABLE)
+      return NULL;
+
+    desc.CPUAccessFlags = 0;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = 0;
+    desc.MiscFlags &= ~D3D11_RESOURCE_MISC_GENERATE_MIPS;
+
+    byteSize = PrepareAheadSize_InitialState(live);
+
+    hr = m_pDevice->CreateTexture3D(&desc, NULL, (ID3D11Texture3D **)&copy);
+  }
+  else
+  {
+    return NULL;
+  }
+
+  if(FAILED(hr) || copy == NULL)
+  {
+    RDCERR("Failed to create replay checkpoint copy %08x", hr);
+    return NULL;
+  }
+
+  return copy;
+}
+
+void WrappedID3D11Device::RestoreReplayCheckpoint(const ReplayCheckpoint &cp)
+{
+  for(size_t i = 0; i < cp.copies.size(); i++)
+    m_pImmediateContext->GetReal()->CopyResource(
+        GetResourceManager()->UnwrapResource(cp.copies[i].first), cp.copies[i].second);
+
+  m_pImmediateContext->ApplyReplayState(*cp.state);
+}
+
+void WrappedID3D11Device::LoadDeferredInitialStates(uint32_t lastEventID)
+{
+  if(m_DeferredInitialStates.empty())
+    return;
+
+  vector<ResourceId> needed;
+
+  for(auto it = m_DeferredInitialStates.begin(); it != m_DeferredInitialStates.end(); ++it)
+    if(GetFirstUse(it->first, it->second) <= lastEventID)
+      needed.push_back(it->first);
+
+  if(needed.empty())
+    return;
+
+  D3D11MarkerRegion load(StringFormat::Fmt("LoadDeferredInitialStates %u", (uint32_t)needed.size()));
+
+  for(size_t i = 0; i < needed.size(); i++)
+    LoadDeferredInitialState(needed[i]);
+}
+
+uint32_t WrappedID3D11Device::GetFirstUse(ResourceId origid, DeferredInitialState &state)
+{
+  if(!state.firstUseKnown)
+  {
+    vector<EventUsage> usage =
+        m_pImmediateContext->GetUsage(GetIDForResource(GetResourceManager()->GetLiveResource(origid)));
+
+    for(size_t i = 0; i < usage.size(); i++)
+      state.firstUse = RDCMIN(state.firstUse, usage[i].eventID);
+
+    state.firstUseKnown = true;
+  }
+
+  return state.firstUse;
+}
+
+void WrappedID3D11Device::EvictInitialStates(uint32_t lastEventID)
+{
+  if(m_InitialStateBudget == 0 || m_InitialStateLocations.empty())
+    return;
+
+  uint64_t residentBytes = 0;
+
+  // resources that the replay up to lastEventID doesn't touch, sorted so the ones needed last are
+  // evicted first.
+  vector<pair<uint32_t, ResourceId> > candidates;
+
+  for(auto it = m_InitialStateLocations.begin(); it != m_InitialStateLocations.end(); ++it)
+  {
+    if(m_DeferredInitialStates.find(it->first) != m_DeferredInitialStates.end())
+      continue;
+
+    D3D11ResourceManager::InitialContentData initial =
+        GetResourceManager()->GetInitialContents(it->first);
+
+    if(initial.resource == NULL || initial.num != eInitialContents_Copy)
+      continue;
+
+    residentBytes += PrepareAheadSize_InitialState(GetResourceManager()->GetLiveResource(it->first));
+
+    uint32_t firstUse = GetFirstUse(it->first, it->second);
+
+    if(firstUse > lastEventID)
+      candidates.push_back(std::make_pair(firstUse, it->first));
+  }
+
+  if(residentBytes <= m_InitialStateBudget)
+    return;
+
+  std::sort(candidates.begin(), candidates.end());
+
+  uint64_t evictedBytes = 0;
+  uint32_t evicted = 0;
+
+  for(size_t i = candidates.size(); i > 0 && residentBytes > m_InitialStateBudget; i--)
+  {
+    ResourceId origid = candidates[i - 1].second;
+
+    uint64_t size = PrepareAheadSize_InitialState(GetResourceManager()->GetLiveResource(origid));
+
+    GetResourceManager()->ReleaseInitialContents(origid);
+    m_DeferredInitialStates[origid] = m_InitialStateLocations[origid];
+
+    residentBytes -= size;
+    evictedBytes += size;
+    evicted++;
+  }
+
+  RDCLOG("Evicted %u texture initial contents (%llu MB), %llu MB resident of %llu MB budget, %u "
+         "evicted in total",
+         evicted, evictedBytes / (1024 * 1024), residentBytes / (1024 * 1024),
+         m_InitialStateBudget / (1024 * 1024), (uint32_t)m_DeferredInitialStates.size());
+
+  if(residentBytes > m_InitialStateBudget)
+    RDCWARN("Initial contents needed up to event %u don't fit in the budget", lastEventID);
+}
+
+void WrappedID3D11Device::LoadDeferredInitialState(ResourceId origid)
+{
+  auto it = m_DeferredInitialStates.find(origid);
+
+  if(it == m_DeferredInitialStates.end())
+    return;
+
+  DeferredInitialState deferred = it->second;
+  m_DeferredInitialStates.erase(it);
+
+  if(!m_pSerialiser->BeginReadRange(deferred.offset, deferred.length))
+  {
+    RDCERR("Couldn't read deferred initial contents for %llu", origid);
+    return;
+  }
+
+  D3D11ChunkType context = (D3D11ChunkType)m_pSerialiser->PushContext(NULL, NULL, 1, false);
+
+  RDCASSERTEQUAL(context, INITIAL_CONTENTS);
+
+  if(context == INITIAL_CONTENTS)
+    Serialise_InitialState(ResourceId(), NULL);
+
+  m_pSerialiser->PopContext(context);
+
+  m_pSerialiser->EndReadRange();
+
+  // checkpoints up to the resource's first use should hold its initial contents. Later ones were
+  // taken by a replay that had it loaded, if it was evicted since then.
+  D3D11ResourceManager::InitialContentData initial = GetResourceManager()->GetInitialContents(origid);
+  ID3D11Resource *live = (ID3D11Resource *)GetResourceManager()->GetLiveResource(origid);
+
+  if(initial.resource && initial.num == eInitialContents_Copy)
+  {
+    for(size_t i = 0; i < m_Checkpoints.size(); i++)
+    {
+      if(m_Checkpoints[i].eventID > deferred.firstUse)
+        continue;
+
+      for(size_t c = 0; c < m_Checkpoints[i].copies.size(); c++)
+      {
+        if(m_Checkpoints[i].copies[c].first == live)
+          m_pImmediateContext->GetReal()->CopyResource(m_Checkpoints[i].copies[c].second,
+                                                       (ID3D11Resource *)initial.resource);
+      }
+    }
+  }
+}
+
+void WrappedID3D11Device::EnsureInitialState(ResourceId liveid)
+{
+  if(m_DeferredInitialStates.empty())
+    return;
+
+  ResourceId origid = GetResourceManager()->GetOriginalID(liveid);
+
+  if(m_DeferredInitialStates.find(origid) == m_DeferredInitialStates.end())
+    return;
+
+  LoadDeferredInitialState(origid);
+
+  D3D11ResourceManager::InitialContentData initial = GetResourceManager()->GetInitialContents(origid);
+
+  if(initial.resource || initial.num != 0)
+    Apply_InitialState(GetResourceManager()->GetLiveResource(origid), initial);
+}
+
+void WrappedID3D11Device::FreeReplayCheckpoints()
+{
+  for(size_t i = 0; i < m_Checkpoints.size(); i++)
+  {
+    for(size_t c = 0; c < m_Checkpoints[i].copies.size(); c++)
+      SAFE_RELEASE(m_Checkpoints[i].copies[c].second);
+
+    SAFE_DELETE(m_Checkpoints[i].state);
+  }
+
+  m_Checkpoints.clear();
+  m_CheckpointBytes = 0;
 }
 
 void WrappedID3D11Device::ReleaseSwapchainResources(WrappedIDXGISwapChain4 *swap, UINT QueueCount,
@@ -2752,6 +3451,9 @@ void WrappedID3D11Device::StartFrameCapture(void *dev, void *wnd)
 
   GetResourceManager()->PrepareInitialContents();
 
+  // the last pack is only filled by one capture's initial contents
+  m_InitialStatePack = NULL;
+
   if(m_pInfoQueue)
     m_pInfoQueue->ClearStoredMessages();
 
@@ -2988,33 +3690,9 @@ bool WrappedID3D11Device::EndFrameCapture(void *dev, void *wnd)
       }
     }
 
-    byte *jpgbuf = NULL;
-    int len = thwidth * thheight;
-
-    if(wnd)
-    {
-      jpgbuf = new byte[len];
-
-      jpge::params p;
-      p.m_quality = 80;
-
-      bool success = jpge::compress_image_to_jpeg_file_in_memory(jpgbuf, len, thwidth, thheight, 3,
-                                                                 thpixels, p);
-
-      if(!success)
-      {
-        RDCERR("Failed to compress to jpg");
-        SAFE_DELETE_ARRAY(jpgbuf);
-        thwidth = 0;
-        thheight = 0;
-      }
-    }
-
+    // the thumbnail is JPEG encoded when the capture is written, off this thread if possible
     Serialiser *m_pFileSerialiser = RenderDoc::Inst().OpenWriteSerialiser(
-        m_FrameCounter, &m_InitParams, jpgbuf, len, thwidth, thheight);
-
-    SAFE_DELETE_ARRAY(jpgbuf);
-    SAFE_DELETE(thpixels);
+        m_FrameCounter, &m_InitParams, thpixels, thwidth, thheight);
 
     {
       SCOPED_SERIALISE_CONTEXT(DEVICE_INIT);
@@ -3032,6 +3710,8 @@ bool WrappedID3D11Device::EndFrameCapture(void *dev, void *wnd)
 
     GetResourceManager()->InsertInitialContentsChunks(m_pFileSerialiser);
 
+    UnmapInitialStatePack();
+
     RDCDEBUG("Creating Capture Scope");
 
     {
@@ -3050,8 +3730,9 @@ bool WrappedID3D11Device::EndFrameCapture(void *dev, void *wnd)
 
       RDCDEBUG("Accumulating context resource list");
 
-      map<int32_t, Chunk *> recordlist;
+      ChunkList recordlist;
       record->Insert(recordlist);
+      SortChunkList(recordlist);
 
       RDCDEBUG("Flushing %u records to file serialiser", (uint32_t)recordlist.size());
 
@@ -3061,14 +3742,11 @@ bool WrappedID3D11Device::EndFrameCapture(void *dev, void *wnd)
       RDCDEBUG("Done");
     }
 
-    m_pFileSerialiser->FlushToDisk();
+    // record chunks are copied before this returns if the write happens in the background
+    RenderDoc::Inst().FinishWriteSerialiser(m_pFileSerialiser, m_FrameCounter);
 
     UnlockForChunkFlushing();
 
-    SAFE_DELETE(m_pFileSerialiser);
-
-    RenderDoc::Inst().SuccessfullyWrittenLog(m_FrameCounter);
-
     m_State = WRITING_IDLE;
 
     m_pImmediateContext->CleanupCapture();
@@ -3188,6 +3866,7 @@ bool WrappedID3D11Device::EndFrameCapture(void *dev, void *wnd)
     {
       GetResourceManager()->MarkResourceFrameReferenced(m_ResourceID, eFrameRef_Write);
       GetResourceManager()->PrepareInitialContents();
+      m_InitialStatePack = NULL;
 
       m_pImmediateContext->AttemptCapture();
       m_pImmediateContext->BeginCaptureFrame();
@@ -3326,6 +4005,9 @@ HRESULT WrappedID3D11Device::Present(WrappedIDXGISwapChain4 *swap, UINT SyncInte
 
   m_pImmediateContext->EndFrame();
 
+  if(m_State == WRITING_IDLE)
+    PrepareInitialStateAhead();
+
   m_FrameCounter++;    // first present becomes frame #1, this function is at the end of the frame
 
   m_pImmediateContext->BeginFrame();
@@ -3379,12 +4061,16 @@ HRESULT WrappedID3D11Device::Present(WrappedIDXGISwapChain4 *swap, UINT SyncInte
 
   RenderDoc::Inst().SetCurrentDriver(RDC_D3D11);
 
-  // kill any current capture that isn't application defined
+  // kill any current capture that isn't application defined, unless it's set to record more
+  // frames, in which case just mark where this one ended
   if(m_State == WRITING_CAPFRAME && !m_AppControlledCapture)
   {
     m_pImmediateContext->Present(SyncInterval, Flags);
 
-    RenderDoc::Inst().EndFrameCapture((ID3D11Device *)this, swapdesc.OutputWindow);
+    if(RenderDoc::Inst().ShouldContinueFrameCapture())
+      m_pImmediateContext->FrameBoundary();
+    else
+      RenderDoc::Inst().EndFrameCapture((ID3D11Device *)this, swapdesc.OutputWindow);
   }
 
   if(RenderDoc::Inst().ShouldTriggerCapture(m_FrameCounter) && m_State == WRITING_IDLE)
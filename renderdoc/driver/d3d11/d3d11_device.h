@@ -62,10 +62,10 @@ struct D3D11InitParams : public RDCInitParams
   UINT NumFeatureLevels;
   D3D_FEATURE_LEVEL FeatureLevels[16];
 
-  static const uint32_t D3D11_SERIALISE_VERSION = 0x000000B;
+  static const uint32_t D3D11_SERIALISE_VERSION = 0x000000C;
 
   // backwards compatibility for old logs described at the declaration of this array
-  static const uint32_t D3D11_NUM_SUPPORTED_OLD_VERSIONS = 7;
+  static const uint32_t D3D11_NUM_SUPPORTED_OLD_VERSIONS = 8;
   static const uint32_t D3D11_OLD_VERSIONS[D3D11_NUM_SUPPORTED_OLD_VERSIONS];
 
   // version number internal to d3d11 stream
@@ -74,6 +74,7 @@ struct D3D11InitParams : public RDCInitParams
 
 class WrappedID3D11Device;
 class WrappedShader;
+struct D3D11RenderState;
 
 // declare this here as we don't want to pull in the whole D3D10 headers
 MIDL_INTERFACE("9B7E4E00-342C-4106-A19F-4F2704F689F0")
@@ -365,6 +366,74 @@ private:
 
   set<ID3D11DeviceChild *> m_CachedStateObjects;
 
+  // the staging pack currently being filled by Prepare_InitialState
+  ID3D11Buffer *m_InitialStatePack;
+  UINT m_InitialStatePackUsed;
+
+  // while serialising initial contents, the last pack mapped is kept mapped so that consecutive
+  // buffers in it don't each map and unmap.
+  ID3D11Buffer *m_MappedInitialStatePack;
+  D3D11_MAPPED_SUBRESOURCE m_MappedInitialStatePackData;
+
+  // with the PrepareAheadBudget option, prepare some initial contents at each idle present
+  void PrepareInitialStateAhead();
+
+  HRESULT MapInitialStatePack(ID3D11Buffer *pack, D3D11_MAPPED_SUBRESOURCE &mapped);
+  void UnmapInitialStatePack();
+
+  // replay checkpoints. While replaying forward from a known state, every m_CheckpointInterval
+  // events the pipeline state and a copy of every mutable resource is saved. A later replay up to
+  // an event can then restore the closest earlier checkpoint and only replay forward from there,
+  // instead of applying initial contents and replaying from the start of the frame.
+  struct ReplayCheckpoint
+  {
+    // the checkpoint holds the state just before this event is replayed
+    uint32_t eventID;
+    D3D11RenderState *state;
+    // live resource, copy of its contents
+    vector<pair<ID3D11Resource *, ID3D11Resource *> > copies;
+    uint64_t byteSize;
+  };
+
+  vector<ReplayCheckpoint> m_Checkpoints;
+  uint32_t m_CheckpointInterval;
+  uint64_t m_CheckpointBudget;
+  uint64_t m_CheckpointBytes;
+  // the next event at which to take a checkpoint, or ~0U when checkpoints aren't being taken
+  uint32_t m_NextCheckpoint;
+
+  ID3D11Resource *CreateCheckpointCopy(ID3D11Resource *live, uint64_t &byteSize);
+  void RestoreReplayCheckpoint(const ReplayCheckpoint &cp);
+
+  // deferred initial contents. When enabled, texture initial contents chunks are skipped on load
+  // and only their location is remembered. Each texture's contents are read and uploaded the first
+  // time a replay reaches an event that uses it, or when it is displayed.
+  struct DeferredInitialState
+  {
+    uint64_t offset;
+    uint64_t length;
+    // first event using the resource, ~0U if it's never used. Only valid once firstUseKnown is set
+    uint32_t firstUse;
+    bool firstUseKnown;
+  };
+
+  bool m_DeferInitialStates;
+  bool m_DeferringInitialStates;
+  uint64_t m_InitialStateChunkOffset;
+  map<ResourceId, DeferredInitialState> m_DeferredInitialStates;
+
+  // with a budget set, the location of every texture's initial contents chunk is remembered so
+  // that textures not needed by the current replay can be evicted and later re-loaded from the
+  // capture file, instead of keeping a full copy of every texture alongside the live one.
+  uint64_t m_InitialStateBudget;
+  bool m_RecordingInitialStateLocations;
+  map<ResourceId, DeferredInitialState> m_InitialStateLocations;
+
+  void LoadDeferredInitialState(ResourceId origid);
+  void LoadDeferredInitialStates(uint32_t lastEventID);
+  uint32_t GetFirstUse(ResourceId origid, DeferredInitialState &state);
+  void EvictInitialStates(uint32_t lastEventID);
+
   // This function will check if m_CachedStateObjects is growing too large, and if so
   // go through m_CachedStateObjects and release any state objects that are purely
   // cached (refcount == 1). This prevents us from aggressively caching and running
@@ -488,7 +557,14 @@ public:
   ////////////////////////////////////////////////////////////////
   // log replaying
 
+  // buffers up to this size have their initial contents packed together into staging buffers of
+  // InitialStatePackSize bytes. The initial contents' num is then the offset into the pack.
+  static const UINT InitialStatePackMaxBuffer = 64 * 1024;
+  static const UINT InitialStatePackSize = 4 * 1024 * 1024;
+
   bool Prepare_InitialState(ID3D11DeviceChild *res);
+  uint64_t PrepareAheadSize_InitialState(ID3D11DeviceChild *res);
+  uint64_t GetSize_InitialState(ID3D11DeviceChild *res);
   bool Serialise_InitialState(ResourceId resid, ID3D11DeviceChild *res);
   void Create_InitialState(ResourceId id, ID3D11DeviceChild *live, bool hasData);
   void Apply_InitialState(ID3D11DeviceChild *live, D3D11ResourceManager::InitialContentData initial);
@@ -497,6 +573,17 @@ public:
   void ProcessChunk(uint64_t offset, D3D11ChunkType context);
   void ReplayLog(uint32_t startEventID, uint32_t endEventID, ReplayLogType replayType);
 
+  // called by the immediate context before each event it replays, to take a replay checkpoint if
+  // one is due.
+  void CheckpointReplay(uint32_t eventID, uint64_t fileOffset);
+  // must be called whenever something changes that would make replaying differ from what was saved
+  // in the checkpoints, e.g. resource replacements.
+  void FreeReplayCheckpoints();
+
+  // if the live resource's initial contents were deferred, load and apply them now. Only valid
+  // while the resource hasn't been used yet in the current replay, e.g. before displaying it.
+  void EnsureInitialState(ResourceId liveid);
+
   ////////////////////////////////////////////////////////////////
   // 'fake' interfaces
 
@@ -104,6 +104,16 @@ bool D3D11ResourceManager::Prepare_InitialState(ID3D11DeviceChild *res)
   return m_Device->Prepare_InitialState(res);
 }
 
+uint64_t D3D11ResourceManager::PrepareAheadSize_InitialState(ID3D11DeviceChild *res)
+{
+  return m_Device->PrepareAheadSize_InitialState(res);
+}
+
+uint64_t D3D11ResourceManager::GetSize_InitialState(ID3D11DeviceChild *res)
+{
+  return m_Device->GetSize_InitialState(res);
+}
+
 bool D3D11ResourceManager::Serialise_InitialState(ResourceId id, ID3D11DeviceChild *res)
 {
   return m_Device->Serialise_InitialState(id, res);
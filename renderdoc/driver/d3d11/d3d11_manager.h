@@ -45,6 +45,7 @@ struct D3D11ResourceRecord : public ResourceRecord
       : ResourceRecord(id, true), NumSubResources(0), SubResources(NULL)
   {
     RDCEraseEl(ShadowPtr);
+    RDCEraseEl(ShadowWatch);
     RDCEraseEl(contexts);
     ignoreSerialise = false;
   }
@@ -62,17 +63,29 @@ struct D3D11ResourceRecord : public ResourceRecord
     FreeShadowStorage();
   }
 
-  void AllocShadowStorage(int ctx, size_t size)
+  void AllocShadowStorage(int ctx, size_t size, bool writeWatch = false)
   {
     if(ShadowPtr[ctx][0] == NULL)
     {
-      ShadowPtr[ctx][0] = Serialiser::AllocAlignedBuffer(size + sizeof(markerValue));
+      if(writeWatch)
+      {
+        size_t pageSize = WriteWatch::GetPageSize();
+        ShadowPtr[ctx][0] =
+            Serialiser::AllocAlignedBuffer(AlignUp(size + sizeof(markerValue), pageSize), pageSize);
+      }
+      else
+      {
+        ShadowPtr[ctx][0] = Serialiser::AllocAlignedBuffer(size + sizeof(markerValue));
+      }
       ShadowPtr[ctx][1] = Serialiser::AllocAlignedBuffer(size + sizeof(markerValue));
 
       memcpy(ShadowPtr[ctx][0] + size, markerValue, sizeof(markerValue));
       memcpy(ShadowPtr[ctx][1] + size, markerValue, sizeof(markerValue));
 
       ShadowSize[ctx] = size;
+
+      if(writeWatch)
+        ShadowWatch[ctx] = WriteWatch::Begin(ShadowPtr[ctx][0], size);
     }
   }
 
@@ -93,6 +106,9 @@ struct D3D11ResourceRecord : public ResourceRecord
   {
     for(int i = 0; i < 32; i++)
     {
+      WriteWatch::End(ShadowWatch[i]);
+      ShadowWatch[i] = NULL;
+
       if(ShadowPtr[i][0] != NULL)
       {
         Serialiser::FreeAlignedBuffer(ShadowPtr[i][0]);
@@ -103,6 +119,8 @@ struct D3D11ResourceRecord : public ResourceRecord
   }
 
   byte *GetShadowPtr(int ctx, int p) { return ShadowPtr[ctx][p]; }
+  // NULL unless writes to the context's first shadow buffer are being tracked
+  WriteWatch::Region GetShadowWriteWatch(int ctx) { return ShadowWatch[ctx]; }
   int GetContextID()
   {
     // 0 is reserved for the immediate context
@@ -131,7 +149,7 @@ struct D3D11ResourceRecord : public ResourceRecord
       SubResources[i]->SetDataPtr(ptr);
   }
 
-  void Insert(map<int32_t, Chunk *> &recordlist)
+  void Insert(ChunkList &recordlist)
   {
     bool dataWritten = DataWritten;
 
@@ -147,7 +165,7 @@ struct D3D11ResourceRecord : public ResourceRecord
 
     if(!dataWritten)
     {
-      recordlist.insert(m_Chunks.begin(), m_Chunks.end());
+      recordlist.insert(recordlist.end(), m_Chunks.begin(), m_Chunks.end());
 
       for(int i = 0; i < NumSubResources; i++)
         SubResources[i]->Insert(recordlist);
@@ -162,6 +180,7 @@ struct D3D11ResourceRecord : public ResourceRecord
 private:
   byte *ShadowPtr[32][2];
   size_t ShadowSize[32];
+  WriteWatch::Region ShadowWatch[32];
 
   bool contexts[32];
 };
@@ -190,6 +209,8 @@ private:
   bool Force_InitialState(ID3D11DeviceChild *res, bool prepare);
   bool Need_InitialStateChunk(ID3D11DeviceChild *res);
   bool Prepare_InitialState(ID3D11DeviceChild *res);
+  uint64_t PrepareAheadSize_InitialState(ID3D11DeviceChild *res);
+  uint64_t GetSize_InitialState(ID3D11DeviceChild *res);
   bool Serialise_InitialState(ResourceId resid, ID3D11DeviceChild *res);
   void Create_InitialState(ResourceId id, ID3D11DeviceChild *live, bool hasData);
   void Apply_InitialState(ID3D11DeviceChild *live, InitialContentData data);
@@ -233,15 +233,11 @@ void D3D11RenderState::MarkReferenced(WrappedID3D11DeviceContext *ctx, bool init
 
     for(UINT i = 0; i < D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT; i++)
     {
-      ID3D11Resource *res = NULL;
       if(sh->SRVs[i])
       {
-        sh->SRVs[i]->GetResource(&res);
         ctx->MarkResourceReferenced(GetIDForResource(sh->SRVs[i]),
                                     initial ? eFrameRef_Unknown : eFrameRef_Read);
-        ctx->MarkResourceReferenced(GetIDForResource(res),
-                                    initial ? eFrameRef_Unknown : eFrameRef_Read);
-        SAFE_RELEASE(res);
+        ctx->MarkViewResourceReferenced(sh->SRVs[i], initial ? eFrameRef_Unknown : eFrameRef_Read);
       }
     }
 
@@ -260,10 +256,8 @@ void D3D11RenderState::MarkReferenced(WrappedID3D11DeviceContext *ctx, bool init
                                   initial ? eFrameRef_Unknown : eFrameRef_Read);
       ctx->MarkResourceReferenced(GetIDForResource(CSUAVs[i]),
                                   initial ? eFrameRef_Unknown : eFrameRef_Write);
-      ctx->MarkResourceReferenced(GetIDForResource(res),
-                                  initial ? eFrameRef_Unknown : eFrameRef_Read);
-      ctx->MarkResourceReferenced(GetIDForResource(res),
-                                  initial ? eFrameRef_Unknown : eFrameRef_Write);
+      ctx->MarkViewResourceReferenced(CSUAVs[i], initial ? eFrameRef_Unknown : eFrameRef_Read);
+      ctx->MarkViewResourceReferenced(CSUAVs[i], initial ? eFrameRef_Unknown : eFrameRef_Write);
       SAFE_RELEASE(res);
     }
   }
@@ -369,10 +363,10 @@ void D3D11RenderState::MarkReferenced(WrappedID3D11DeviceContext *ctx, bool init
       ctx->MarkResourceReferenced(GetIDForResource(OM.RenderTargets[i]),
                                   initial ? eFrameRef_Unknown : eFrameRef_Read);
       if(viewportScissorPartial)
-        ctx->MarkResourceReferenced(GetIDForResource(res),
-                                    initial ? eFrameRef_Unknown : eFrameRef_Read);
-      ctx->MarkResourceReferenced(GetIDForResource(res),
-                                  initial ? eFrameRef_Unknown : eFrameRef_Write);
+        ctx->MarkViewResourceReferenced(OM.RenderTargets[i],
+                                        initial ? eFrameRef_Unknown : eFrameRef_Read);
+      ctx->MarkViewResourceReferenced(OM.RenderTargets[i],
+                                      initial ? eFrameRef_Unknown : eFrameRef_Write);
       SAFE_RELEASE(res);
     }
   }
@@ -389,10 +383,8 @@ void D3D11RenderState::MarkReferenced(WrappedID3D11DeviceContext *ctx, bool init
                                   initial ? eFrameRef_Unknown : eFrameRef_Read);
       ctx->MarkResourceReferenced(GetIDForResource(OM.UAVs[i]),
                                   initial ? eFrameRef_Unknown : eFrameRef_Write);
-      ctx->MarkResourceReferenced(GetIDForResource(res),
-                                  initial ? eFrameRef_Unknown : eFrameRef_Read);
-      ctx->MarkResourceReferenced(GetIDForResource(res),
-                                  initial ? eFrameRef_Unknown : eFrameRef_Write);
+      ctx->MarkViewResourceReferenced(OM.UAVs[i], initial ? eFrameRef_Unknown : eFrameRef_Read);
+      ctx->MarkViewResourceReferenced(OM.UAVs[i], initial ? eFrameRef_Unknown : eFrameRef_Write);
       SAFE_RELEASE(res);
     }
   }
@@ -406,10 +398,8 @@ void D3D11RenderState::MarkReferenced(WrappedID3D11DeviceContext *ctx, bool init
       ctx->MarkResourceReferenced(GetIDForResource(OM.DepthView),
                                   initial ? eFrameRef_Unknown : eFrameRef_Read);
       if(viewportScissorPartial)
-        ctx->MarkResourceReferenced(GetIDForResource(res),
-                                    initial ? eFrameRef_Unknown : eFrameRef_Read);
-      ctx->MarkResourceReferenced(GetIDForResource(res),
-                                  initial ? eFrameRef_Unknown : eFrameRef_Write);
+        ctx->MarkViewResourceReferenced(OM.DepthView, initial ? eFrameRef_Unknown : eFrameRef_Read);
+      ctx->MarkViewResourceReferenced(OM.DepthView, initial ? eFrameRef_Unknown : eFrameRef_Write);
       SAFE_RELEASE(res);
     }
   }
@@ -120,6 +120,8 @@ struct D3D11RenderState
 
     bool IsNull() const { return resource == NULL; }
   private:
+    friend class WrappedID3D11DeviceContext;
+
     ResourceRange();
 
     void SetMaxes(UINT numMips, UINT numSlices)
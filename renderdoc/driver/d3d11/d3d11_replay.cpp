@@ -24,6 +24,7 @@
  ******************************************************************************/
 
 #include "d3d11_replay.h"
+#include "common/profiler.h"
 #include "driver/dx/official/d3dcompiler.h"
 #include "driver/shaders/dxbc/dxbc_debug.h"
 #include "serialise/string_utils.h"
@@ -55,6 +56,10 @@ TextureDescription D3D11Replay::GetTexture(ResourceId id)
 {
   TextureDescription tex;
   tex.ID = ResourceId();
+  tex.allocationSize = 0;
+  tex.allocationAlignment = 0;
+  tex.placeholderInitialContents = m_pDevice->GetResourceManager()->IsInitialContentsPlaceholder(
+      m_pDevice->GetResourceManager()->GetOriginalID(id));
 
   auto it1D = WrappedID3D11Texture1D::m_TextureList.find(id);
   if(it1D != WrappedID3D11Texture1D::m_TextureList.end())
@@ -121,6 +126,10 @@ TextureDescription D3D11Replay::GetTexture(ResourceId id)
     for(uint32_t s = 0; s < tex.mips * tex.arraysize; s++)
       tex.byteSize += GetByteSize(d3dtex, s);
 
+    // D3D11 doesn't expose the driver's allocation, so use the calculated size
+    tex.allocationSize = tex.byteSize;
+    tex.memoryType = ToStr::Get(desc.Usage);
+
     return tex;
   }
 
@@ -215,6 +224,9 @@ TextureDescription D3D11Replay::GetTexture(ResourceId id)
     for(uint32_t s = 0; s < tex.arraysize * tex.mips; s++)
       tex.byteSize += GetByteSize(d3dtex, s);
 
+    tex.allocationSize = tex.byteSize;
+    tex.memoryType = ToStr::Get(desc.Usage);
+
     return tex;
   }
 
@@ -280,6 +292,9 @@ TextureDescription D3D11Replay::GetTexture(ResourceId id)
     for(uint32_t s = 0; s < tex.arraysize * tex.mips; s++)
       tex.byteSize += GetByteSize(d3dtex, s);
 
+    tex.allocationSize = tex.byteSize;
+    tex.memoryType = ToStr::Get(desc.Usage);
+
     return tex;
   }
 
@@ -312,6 +327,13 @@ ShaderReflection *D3D11Replay::GetShader(ResourceId shader, string entryPoint)
   ShaderReflection *ret = it->second->GetDetails();
   RDCASSERT(ret);
 
+  // disassemble and parse debug info lazily on demand
+  if(ret && ret->Disassembly.count == 0)
+  {
+    ret->Disassembly = it->second->GetDXBC()->GetDisassembly();
+    DXBC::MakeShaderDebugInfo(it->second->GetDXBC(), ret);
+  }
+
   return ret;
 }
 
@@ -350,6 +372,27 @@ vector<DebugMessage> D3D11Replay::GetDebugMessages()
   return m_pDevice->GetDebugMessages();
 }
 
+vector<MemoryUsage> D3D11Replay::GetMemoryUsage()
+{
+  vector<MemoryUsage> ret;
+
+  ret.push_back(MakeMemoryUsage("Capture data", false, 1, m_pDevice->GetSerialiser()->GetSize()));
+
+  // textures and buffers are copied on the GPU, so the serialised size is a close estimate of what
+  // the copies take
+  ret.push_back(MakeMemoryUsage("Initial contents", true,
+                                m_pDevice->GetResourceManager()->NumInitialContents(),
+                                m_pDevice->GetFrameRecord().frameInfo.initDataSize));
+
+  uint64_t count = 0, bytes = 0;
+  WrappedShader::GetMemoryUsage(count, bytes);
+  ret.push_back(MakeMemoryUsage("Shader reflection", false, count, bytes));
+
+  m_pDevice->GetDebugManager()->GetMemoryUsage(ret);
+
+  return ret;
+}
+
 APIProperties D3D11Replay::GetAPIProperties()
 {
   APIProperties ret;
@@ -378,6 +421,8 @@ BufferDescription D3D11Replay::GetBuffer(ResourceId id)
 {
   BufferDescription ret;
   ret.ID = ResourceId();
+  ret.allocationSize = 0;
+  ret.allocationAlignment = 0;
 
   auto it = WrappedID3D11Buffer::m_BufferList.find(id);
 
@@ -402,6 +447,8 @@ BufferDescription D3D11Replay::GetBuffer(ResourceId id)
 
   ret.name = str;
   ret.length = desc.ByteWidth;
+  ret.allocationSize = desc.ByteWidth;
+  ret.memoryType = ToStr::Get(desc.Usage);
 
   ret.creationFlags = BufferCategory::NoFlags;
   if(desc.BindFlags & D3D11_BIND_VERTEX_BUFFER)
@@ -1294,14 +1341,28 @@ D3D11Pipe::State D3D11Replay::MakePipelineState()
 
 void D3D11Replay::ReadLogInitialisation()
 {
+  SCOPED_PROFILE("D3D11Replay::ReadLogInitialisation");
   m_pDevice->ReadLogInitialisation();
 }
 
 void D3D11Replay::ReplayLog(uint32_t endEventID, ReplayLogType replayType)
 {
+  SCOPED_PROFILE("D3D11Replay::ReplayLog", endEventID);
   m_pDevice->ReplayLog(0, endEventID, replayType);
 }
 
+bool D3D11Replay::AdvanceReplay(uint32_t fromEventID, uint32_t toEventID)
+{
+  SCOPED_PROFILE("D3D11Replay::AdvanceReplay", toEventID);
+
+  if(fromEventID == 0 || toEventID <= fromEventID)
+    return false;
+
+  // everything replays on the immediate context, so a partial replay carries on from its state
+  m_pDevice->ReplayLog(fromEventID, toEventID - 1, eReplay_Full);
+  return true;
+}
+
 vector<uint32_t> D3D11Replay::GetPassEvents(uint32_t eventID)
 {
   vector<uint32_t> passEvents;
@@ -1382,6 +1443,10 @@ void D3D11Replay::FlipOutputWindow(uint64_t id)
 
 void D3D11Replay::InitPostVSBuffers(uint32_t eventID)
 {
+  SCOPED_PROFILE("D3D11Replay::InitPostVSBuffers", eventID);
+  // outputs init the selected event before its pass, so trim here rather than part-way through
+  // fetching a pass, when events that are about to be displayed could be evicted.
+  m_pDevice->GetDebugManager()->TrimPostVSCache(eventID);
   m_pDevice->GetDebugManager()->InitPostVSBuffers(eventID);
 }
 
@@ -1393,6 +1458,10 @@ void D3D11Replay::InitPostVSBuffers(const vector<uint32_t> &passEvents)
   // doing partial replays and calling InitPostVSBuffers for each
   for(size_t i = 0; i < passEvents.size(); i++)
   {
+    // events cached so far are complete, the rest are computed on demand if needed later
+    if(RenderDoc::Inst().IsReplayCancelled())
+      break;
+
     if(prev != passEvents[i])
     {
       m_pDevice->ReplayLog(prev, passEvents[i], eReplay_WithoutDraw);
@@ -1415,6 +1484,8 @@ ResourceId D3D11Replay::GetLiveID(ResourceId id)
 bool D3D11Replay::GetMinMax(ResourceId texid, uint32_t sliceFace, uint32_t mip, uint32_t sample,
                             CompType typeHint, float *minval, float *maxval)
 {
+  m_pDevice->EnsureInitialState(texid);
+
   return m_pDevice->GetDebugManager()->GetMinMax(texid, sliceFace, mip, sample, typeHint, minval,
                                                  maxval);
 }
@@ -1423,6 +1494,8 @@ bool D3D11Replay::GetHistogram(ResourceId texid, uint32_t sliceFace, uint32_t mi
                                CompType typeHint, float minval, float maxval, bool channels[4],
                                vector<uint32_t> &histogram)
 {
+  m_pDevice->EnsureInitialState(texid);
+
   return m_pDevice->GetDebugManager()->GetHistogram(texid, sliceFace, mip, sample, typeHint, minval,
                                                     maxval, channels, histogram);
 }
@@ -1440,17 +1513,31 @@ void D3D11Replay::GetBufferData(ResourceId buff, uint64_t offset, uint64_t len,
 byte *D3D11Replay::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
                                   const GetTextureDataParams &params, size_t &dataSize)
 {
+  SCOPED_PROFILE("D3D11Replay::GetTextureData");
+  m_pDevice->EnsureInitialState(tex);
+
   return m_pDevice->GetDebugManager()->GetTextureData(tex, arrayIdx, mip, params, dataSize);
 }
 
+vector<TextureThumbnail> D3D11Replay::GetTextureThumbnails(
+    const vector<TextureThumbnailRequest> &textures, uint32_t size)
+{
+  SCOPED_PROFILE("D3D11Replay::GetTextureThumbnails");
+  return FetchTextureThumbnails(this, textures, size);
+}
+
 void D3D11Replay::ReplaceResource(ResourceId from, ResourceId to)
 {
   m_pDevice->GetResourceManager()->ReplaceResource(from, to);
+  m_pDevice->FreeReplayCheckpoints();
+  m_pDevice->GetDebugManager()->InvalidatePickCache();
 }
 
 void D3D11Replay::RemoveReplacement(ResourceId id)
 {
   m_pDevice->GetResourceManager()->RemoveReplacement(id);
+  m_pDevice->FreeReplayCheckpoints();
+  m_pDevice->GetDebugManager()->InvalidatePickCache();
 }
 
 vector<GPUCounter> D3D11Replay::EnumerateCounters()
@@ -1489,6 +1576,8 @@ void D3D11Replay::BuildCustomShader(string source, string entry, const uint32_t
 
 bool D3D11Replay::RenderTexture(TextureDisplay cfg)
 {
+  m_pDevice->EnsureInitialState(cfg.texid);
+
   return m_pDevice->GetDebugManager()->RenderTexture(cfg, true);
 }
 
@@ -1520,6 +1609,13 @@ void D3D11Replay::FillCBufferVariables(ResourceId shader, string entryPoint, uin
   return;
 }
 
+vector<TextureSamplingFeedback> D3D11Replay::FetchTextureSampling(uint32_t startEventID,
+                                                                  uint32_t endEventID)
+{
+  // would need DXBC patching to record each sample
+  return vector<TextureSamplingFeedback>();
+}
+
 vector<PixelModification> D3D11Replay::PixelHistory(vector<EventUsage> events, ResourceId target,
                                                     uint32_t x, uint32_t y, uint32_t slice,
                                                     uint32_t mip, uint32_t sampleIdx,
@@ -1529,6 +1625,14 @@ vector<PixelModification> D3D11Replay::PixelHistory(vector<EventUsage> events, R
                                                     typeHint);
 }
 
+vector<vector<PixelModification> > D3D11Replay::PixelHistoryRegion(
+    vector<EventUsage> events, ResourceId target, uint32_t x, uint32_t y, uint32_t width,
+    uint32_t height, uint32_t slice, uint32_t mip, uint32_t sampleIdx, CompType typeHint)
+{
+  return m_pDevice->GetDebugManager()->PixelHistoryRegion(events, target, x, y, width, height,
+                                                          slice, mip, sampleIdx, typeHint);
+}
+
 ShaderDebugTrace D3D11Replay::DebugVertex(uint32_t eventID, uint32_t vertid, uint32_t instid,
                                           uint32_t idx, uint32_t instOffset, uint32_t vertOffset)
 {
@@ -1542,6 +1646,19 @@ ShaderDebugTrace D3D11Replay::DebugPixel(uint32_t eventID, uint32_t x, uint32_t
   return m_pDevice->GetDebugManager()->DebugPixel(eventID, x, y, sample, primitive);
 }
 
+vector<ShaderDebugTrace> D3D11Replay::DebugVertices(uint32_t eventID,
+                                                    vector<ShaderDebugVertexInput> inputs,
+                                                    uint32_t instOffset, uint32_t vertOffset)
+{
+  return m_pDevice->GetDebugManager()->DebugVertices(eventID, inputs, instOffset, vertOffset);
+}
+
+vector<ShaderDebugTrace> D3D11Replay::DebugPixels(uint32_t eventID,
+                                                  vector<ShaderDebugPixelInput> inputs)
+{
+  return m_pDevice->GetDebugManager()->DebugPixels(eventID, inputs);
+}
+
 ShaderDebugTrace D3D11Replay::DebugThread(uint32_t eventID, const uint32_t groupid[3],
                                           const uint32_t threadid[3])
 {
@@ -1556,18 +1673,23 @@ uint32_t D3D11Replay::PickVertex(uint32_t eventID, const MeshDisplay &cfg, uint3
 void D3D11Replay::PickPixel(ResourceId texture, uint32_t x, uint32_t y, uint32_t sliceFace,
                             uint32_t mip, uint32_t sample, CompType typeHint, float pixel[4])
 {
+  m_pDevice->EnsureInitialState(texture);
+
   m_pDevice->GetDebugManager()->PickPixel(texture, x, y, sliceFace, mip, sample, typeHint, pixel);
 }
 
 ResourceId D3D11Replay::RenderOverlay(ResourceId texid, CompType typeHint, DebugOverlay overlay,
                                       uint32_t eventID, const vector<uint32_t> &passEvents)
 {
+  SCOPED_PROFILE("D3D11Replay::RenderOverlay", eventID);
   return m_pDevice->GetDebugManager()->RenderOverlay(texid, typeHint, overlay, eventID, passEvents);
 }
 
 ResourceId D3D11Replay::ApplyCustomShader(ResourceId shader, ResourceId texid, uint32_t mip,
                                           uint32_t arrayIdx, uint32_t sampleIdx, CompType typeHint)
 {
+  m_pDevice->EnsureInitialState(texid);
+
   return m_pDevice->GetDebugManager()->ApplyCustomShader(shader, texid, mip, arrayIdx, sampleIdx,
                                                          typeHint);
 }
@@ -55,6 +55,7 @@ public:
   TextureDescription GetTexture(ResourceId id);
 
   vector<DebugMessage> GetDebugMessages();
+  vector<MemoryUsage> GetMemoryUsage();
 
   ShaderReflection *GetShader(ResourceId shader, string entryPoint);
 
@@ -72,6 +73,8 @@ public:
 
   void ReadLogInitialisation();
   void ReplayLog(uint32_t endEventID, ReplayLogType replayType);
+  bool AdvanceReplay(uint32_t fromEventID, uint32_t toEventID);
+  void SetPrunedEvents(const vector<uint32_t> &eventIDs) {}
 
   vector<uint32_t> GetPassEvents(uint32_t eventID);
 
@@ -108,6 +111,8 @@ public:
   void GetBufferData(ResourceId buff, uint64_t offset, uint64_t len, vector<byte> &retData);
   byte *GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
                        const GetTextureDataParams &params, size_t &dataSize);
+  vector<TextureThumbnail> GetTextureThumbnails(const vector<TextureThumbnailRequest> &textures,
+                                                uint32_t size);
 
   void BuildTargetShader(string source, string entry, const uint32_t compileFlags, ShaderStage type,
                          ResourceId *id, string *errors);
@@ -118,6 +123,8 @@ public:
   void DescribeCounter(GPUCounter counterID, CounterDescription &desc);
   vector<CounterResult> FetchCounters(const vector<GPUCounter> &counters);
 
+  vector<TextureSamplingFeedback> FetchTextureSampling(uint32_t startEventID, uint32_t endEventID);
+
   ResourceId CreateProxyTexture(const TextureDescription &templateTex);
   void SetProxyTextureData(ResourceId texid, uint32_t arrayIdx, uint32_t mip, byte *data,
                            size_t dataSize);
@@ -140,10 +147,18 @@ public:
   vector<PixelModification> PixelHistory(vector<EventUsage> events, ResourceId target, uint32_t x,
                                          uint32_t y, uint32_t slice, uint32_t mip,
                                          uint32_t sampleIdx, CompType typeHint);
+  vector<vector<PixelModification> > PixelHistoryRegion(vector<EventUsage> events,
+                                                        ResourceId target, uint32_t x, uint32_t y,
+                                                        uint32_t width, uint32_t height,
+                                                        uint32_t slice, uint32_t mip,
+                                                        uint32_t sampleIdx, CompType typeHint);
   ShaderDebugTrace DebugVertex(uint32_t eventID, uint32_t vertid, uint32_t instid, uint32_t idx,
                                uint32_t instOffset, uint32_t vertOffset);
   ShaderDebugTrace DebugPixel(uint32_t eventID, uint32_t x, uint32_t y, uint32_t sample,
                               uint32_t primitive);
+  vector<ShaderDebugTrace> DebugVertices(uint32_t eventID, vector<ShaderDebugVertexInput> inputs,
+                                         uint32_t instOffset, uint32_t vertOffset);
+  vector<ShaderDebugTrace> DebugPixels(uint32_t eventID, vector<ShaderDebugPixelInput> inputs);
   ShaderDebugTrace DebugThread(uint32_t eventID, const uint32_t groupid[3],
                                const uint32_t threadid[3]);
   void PickPixel(ResourceId texture, uint32_t x, uint32_t y, uint32_t sliceFace, uint32_t mip,
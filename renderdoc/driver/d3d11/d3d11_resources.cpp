@@ -29,6 +29,7 @@
 #include "driver/d3d11/d3d11_context.h"
 #include "driver/d3d11/d3d11_renderstate.h"
 #include "driver/dxgi/dxgi_wrapped.h"
+#include "replay/replay_driver.h"
 
 WRAPPED_POOL_INST(WrappedID3D11Buffer);
 WRAPPED_POOL_INST(WrappedID3D11Texture1D);
@@ -64,12 +65,35 @@ map<ResourceId, WrappedID3D11Texture3D1::TextureEntry>
     WrappedTexture<ID3D11Texture3D, D3D11_TEXTURE3D_DESC, ID3D11Texture3D1>::m_TextureList;
 map<ResourceId, WrappedID3D11Buffer::BufferEntry> WrappedID3D11Buffer::m_BufferList;
 map<ResourceId, WrappedShader::ShaderEntry *> WrappedShader::m_ShaderList;
+map<WrappedShader::BytecodeKey, WrappedShader::ShaderEntry *> WrappedShader::m_ShaderEntries;
 Threading::CriticalSection WrappedShader::m_ShaderListLock;
 std::vector<WrappedID3DDeviceContextState *> WrappedID3DDeviceContextState::m_List;
 Threading::CriticalSection WrappedID3DDeviceContextState::m_Lock;
 
 const GUID RENDERDOC_ID3D11ShaderGUID_ShaderDebugMagicValue = RENDERDOC_ShaderDebugMagicValue_struct;
 
+uint64_t WrappedShader::ShaderEntry::GetMemoryUsage() const
+{
+  uint64_t ret = m_Bytecode.capacity();
+
+  if(m_Details)
+    ret += GetShaderReflectionSize(*m_Details);
+
+  return ret;
+}
+
+void WrappedShader::GetMemoryUsage(uint64_t &count, uint64_t &bytes)
+{
+  SCOPED_LOCK(m_ShaderListLock);
+
+  count = m_ShaderList.size();
+  bytes = 0;
+
+  // count shared entries once
+  for(auto it = m_ShaderEntries.begin(); it != m_ShaderEntries.end(); ++it)
+    bytes += it->second->GetMemoryUsage();
+}
+
 void WrappedShader::ShaderEntry::TryReplaceOriginalByteCode()
 {
   if(!DXBC::DXBCFile::CheckForDebugInfo((const void *)&m_Bytecode[0], m_Bytecode.size()))
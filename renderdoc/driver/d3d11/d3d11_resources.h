@@ -892,16 +892,42 @@ public:
 class WrappedShader
 {
 public:
+  struct BytecodeKey
+  {
+    BytecodeKey(const byte *code, size_t codeLen)
+    {
+      byteLen = (uint32_t)codeLen;
+      DXBC::DXBCFile::GetHash(hash, code, codeLen);
+    }
+
+    // assume that byte length + hash is enough to uniquely identify a shader bytecode
+    uint32_t byteLen;
+    uint32_t hash[4];
+
+    bool operator<(const BytecodeKey &o) const
+    {
+      if(byteLen != o.byteLen)
+        return byteLen < o.byteLen;
+
+      for(size_t i = 0; i < 4; i++)
+        if(hash[i] != o.hash[i])
+          return hash[i] < o.hash[i];
+
+      return false;
+    }
+  };
+
   class ShaderEntry
   {
   public:
-    ShaderEntry() : m_DebugInfoSearchPaths(NULL), m_DXBCFile(NULL), m_Details(NULL) {}
     ShaderEntry(WrappedID3D11Device *device, const byte *code, size_t codeLen)
+        : m_Key(code, codeLen)
     {
       m_Bytecode.assign(code, code + codeLen);
       m_DebugInfoSearchPaths = device->GetShaderDebugInfoSearchPaths();
       m_DXBCFile = NULL;
       m_Details = NULL;
+      m_RefCount = 1;
     }
     ~ShaderEntry()
     {
@@ -927,11 +953,20 @@ public:
       return m_Details;
     }
 
+    // estimated CPU memory held for the bytecode and, once it's built, the reflection
+    uint64_t GetMemoryUsage() const;
+
+    // shaders created from identical bytecode share one entry, see m_ShaderEntries
+    const BytecodeKey &GetKey() const { return m_Key; }
+    int32_t m_RefCount;
+
   private:
     ShaderEntry(const ShaderEntry &e);
     void TryReplaceOriginalByteCode();
     ShaderEntry &operator=(const ShaderEntry &e);
 
+    BytecodeKey m_Key;
+
     std::string m_DebugInfoPath;
     vector<std::string> *m_DebugInfoSearchPaths;
 
@@ -942,15 +977,28 @@ public:
   };
 
   static map<ResourceId, ShaderEntry *> m_ShaderList;
+  // per-material shader objects are often created many times from the same bytecode, so entries
+  // are interned and the DXBC parse and reflection are only done once for all of them
+  static map<BytecodeKey, ShaderEntry *> m_ShaderEntries;
   static Threading::CriticalSection m_ShaderListLock;
 
+  static void GetMemoryUsage(uint64_t &count, uint64_t &bytes);
+
   WrappedShader(WrappedID3D11Device *device, ResourceId id, const byte *code, size_t codeLen)
       : m_ID(id)
   {
     SCOPED_LOCK(m_ShaderListLock);
 
     RDCASSERT(m_ShaderList.find(m_ID) == m_ShaderList.end());
-    m_ShaderList[m_ID] = new ShaderEntry(device, code, codeLen);
+
+    ShaderEntry *&entry = m_ShaderEntries[BytecodeKey(code, codeLen)];
+
+    if(entry == NULL)
+      entry = new ShaderEntry(device, code, codeLen);
+    else
+      entry->m_RefCount++;
+
+    m_ShaderList[m_ID] = entry;
   }
   virtual ~WrappedShader()
   {
@@ -959,8 +1007,14 @@ public:
     auto it = m_ShaderList.find(m_ID);
     if(it != m_ShaderList.end())
     {
-      delete it->second;
+      ShaderEntry *entry = it->second;
       m_ShaderList.erase(it);
+
+      if(--entry->m_RefCount == 0)
+      {
+        m_ShaderEntries.erase(entry->GetKey());
+        delete entry;
+      }
     }
   }
 
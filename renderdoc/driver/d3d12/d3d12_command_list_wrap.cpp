@@ -112,6 +112,7 @@ bool WrappedID3D12GraphicsCommandList::Serialise_Close()
 
 HRESULT WrappedID3D12GraphicsCommandList::Close()
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::Close");
   if(m_State >= WRITING)
   {
     {
@@ -121,6 +122,10 @@ HRESULT WrappedID3D12GraphicsCommandList::Close()
       m_ListRecord->AddChunk(scope.Get());
     }
 
+    // the commands are ordered against other chunks (e.g. the execute) from the point they're
+    // closed
+    m_ListRecord->AssignDeferredChunkIDs();
+
     m_ListRecord->Bake();
   }
 
@@ -291,6 +296,7 @@ bool WrappedID3D12GraphicsCommandList::Serialise_Reset(ID3D12CommandAllocator *p
 HRESULT WrappedID3D12GraphicsCommandList::Reset(ID3D12CommandAllocator *pAllocator,
                                                 ID3D12PipelineState *pInitialState)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::Reset");
   if(m_State >= WRITING)
   {
     bool firstTime = false;
@@ -339,6 +345,7 @@ HRESULT WrappedID3D12GraphicsCommandList::Reset(ID3D12CommandAllocator *pAllocat
 
 void WrappedID3D12GraphicsCommandList::ClearState(ID3D12PipelineState *pPipelineState)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::ClearState");
   m_pReal->ClearState(Unwrap(pPipelineState));
 }
 
@@ -461,6 +468,7 @@ bool WrappedID3D12GraphicsCommandList::Serialise_ResourceBarrier(UINT NumBarrier
 void WrappedID3D12GraphicsCommandList::ResourceBarrier(UINT NumBarriers,
                                                        const D3D12_RESOURCE_BARRIER *pBarriers)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::ResourceBarrier");
   D3D12_RESOURCE_BARRIER *barriers = m_pDevice->GetTempArray<D3D12_RESOURCE_BARRIER>(NumBarriers);
 
   for(UINT i = 0; i < NumBarriers; i++)
@@ -529,6 +537,7 @@ bool WrappedID3D12GraphicsCommandList::Serialise_IASetPrimitiveTopology(
 
 void WrappedID3D12GraphicsCommandList::IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY PrimitiveTopology)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::IASetPrimitiveTopology");
   m_pReal->IASetPrimitiveTopology(PrimitiveTopology);
 
   if(m_State >= WRITING)
@@ -585,6 +594,7 @@ bool WrappedID3D12GraphicsCommandList::Serialise_RSSetViewports(UINT NumViewport
 void WrappedID3D12GraphicsCommandList::RSSetViewports(UINT NumViewports,
                                                       const D3D12_VIEWPORT *pViewports)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::RSSetViewports");
   m_pReal->RSSetViewports(NumViewports, pViewports);
 
   if(m_State >= WRITING)
@@ -640,6 +650,7 @@ bool WrappedID3D12GraphicsCommandList::Serialise_RSSetScissorRects(UINT NumRects
 
 void WrappedID3D12GraphicsCommandList::RSSetScissorRects(UINT NumRects, const D3D12_RECT *pRects)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::RSSetScissorRects");
   m_pReal->RSSetScissorRects(NumRects, pRects);
 
   if(m_State >= WRITING)
@@ -687,6 +698,7 @@ bool WrappedID3D12GraphicsCommandList::Serialise_OMSetBlendFactor(const FLOAT Bl
 
 void WrappedID3D12GraphicsCommandList::OMSetBlendFactor(const FLOAT BlendFactor[4])
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::OMSetBlendFactor");
   m_pReal->OMSetBlendFactor(BlendFactor);
 
   if(m_State >= WRITING)
@@ -728,6 +740,7 @@ bool WrappedID3D12GraphicsCommandList::Serialise_OMSetStencilRef(UINT StencilRef
 
 void WrappedID3D12GraphicsCommandList::OMSetStencilRef(UINT StencilRef)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::OMSetStencilRef");
   m_pReal->OMSetStencilRef(StencilRef);
 
   if(m_State >= WRITING)
@@ -797,6 +810,7 @@ bool WrappedID3D12GraphicsCommandList::Serialise_SetDescriptorHeaps(
 void WrappedID3D12GraphicsCommandList::SetDescriptorHeaps(UINT NumDescriptorHeaps,
                                                           ID3D12DescriptorHeap *const *ppDescriptorHeaps)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::SetDescriptorHeaps");
   ID3D12DescriptorHeap **heaps = m_pDevice->GetTempArray<ID3D12DescriptorHeap *>(NumDescriptorHeaps);
   for(UINT i = 0; i < NumDescriptorHeaps; i++)
     heaps[i] = Unwrap(ppDescriptorHeaps[i]);
@@ -880,6 +894,7 @@ bool WrappedID3D12GraphicsCommandList::Serialise_IASetIndexBuffer(const D3D12_IN
 
 void WrappedID3D12GraphicsCommandList::IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW *pView)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::IASetIndexBuffer");
   m_pReal->IASetIndexBuffer(pView);
 
   if(m_State >= WRITING)
@@ -953,6 +968,7 @@ bool WrappedID3D12GraphicsCommandList::Serialise_IASetVertexBuffers(
 void WrappedID3D12GraphicsCommandList::IASetVertexBuffers(UINT StartSlot, UINT NumViews,
                                                           const D3D12_VERTEX_BUFFER_VIEW *pViews)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::IASetVertexBuffers");
   m_pReal->IASetVertexBuffers(StartSlot, NumViews, pViews);
 
   if(m_State >= WRITING)
@@ -1031,6 +1047,7 @@ bool WrappedID3D12GraphicsCommandList::Serialise_SOSetTargets(
 void WrappedID3D12GraphicsCommandList::SOSetTargets(UINT StartSlot, UINT NumViews,
                                                     const D3D12_STREAM_OUTPUT_BUFFER_VIEW *pViews)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::SOSetTargets");
   m_pReal->SOSetTargets(StartSlot, NumViews, pViews);
 
   if(m_State >= WRITING)
@@ -1077,6 +1094,7 @@ bool WrappedID3D12GraphicsCommandList::Serialise_SetPipelineState(ID3D12Pipeline
 
 void WrappedID3D12GraphicsCommandList::SetPipelineState(ID3D12PipelineState *pPipelineState)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::SetPipelineState");
   m_pReal->SetPipelineState(Unwrap(pPipelineState));
 
   if(m_State >= WRITING)
@@ -1183,6 +1201,7 @@ void WrappedID3D12GraphicsCommandList::OMSetRenderTargets(
     UINT NumRenderTargetDescriptors, const D3D12_CPU_DESCRIPTOR_HANDLE *pRenderTargetDescriptors,
     BOOL RTsSingleHandleToDescriptorRange, const D3D12_CPU_DESCRIPTOR_HANDLE *pDepthStencilDescriptor)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::OMSetRenderTargets");
   UINT num = NumRenderTargetDescriptors;
   UINT numHandles = RTsSingleHandleToDescriptorRange ? RDCMIN(1U, num) : num;
   D3D12_CPU_DESCRIPTOR_HANDLE *unwrapped =
@@ -1270,6 +1289,7 @@ bool WrappedID3D12GraphicsCommandList::Serialise_SetComputeRootSignature(
 
 void WrappedID3D12GraphicsCommandList::SetComputeRootSignature(ID3D12RootSignature *pRootSignature)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::SetComputeRootSignature");
   m_pReal->SetComputeRootSignature(Unwrap(pRootSignature));
 
   if(m_State >= WRITING)
@@ -1340,6 +1360,7 @@ bool WrappedID3D12GraphicsCommandList::Serialise_SetComputeRootDescriptorTable(
 void WrappedID3D12GraphicsCommandList::SetComputeRootDescriptorTable(
     UINT RootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::SetComputeRootDescriptorTable");
   m_pReal->SetComputeRootDescriptorTable(RootParameterIndex, Unwrap(BaseDescriptor));
 
   if(m_State >= WRITING)
@@ -1430,6 +1451,7 @@ void WrappedID3D12GraphicsCommandList::SetComputeRoot32BitConstant(UINT RootPara
                                                                    UINT SrcData,
                                                                    UINT DestOffsetIn32BitValues)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::SetComputeRoot32BitConstant");
   m_pReal->SetComputeRoot32BitConstant(RootParameterIndex, SrcData, DestOffsetIn32BitValues);
 
   if(m_State >= WRITING)
@@ -1489,6 +1511,7 @@ void WrappedID3D12GraphicsCommandList::SetComputeRoot32BitConstants(UINT RootPar
                                                                     const void *pSrcData,
                                                                     UINT DestOffsetIn32BitValues)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::SetComputeRoot32BitConstants");
   m_pReal->SetComputeRoot32BitConstants(RootParameterIndex, Num32BitValuesToSet, pSrcData,
                                         DestOffsetIn32BitValues);
 
@@ -1563,6 +1586,7 @@ bool WrappedID3D12GraphicsCommandList::Serialise_SetComputeRootConstantBufferVie
 void WrappedID3D12GraphicsCommandList::SetComputeRootConstantBufferView(
     UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::SetComputeRootConstantBufferView");
   m_pReal->SetComputeRootConstantBufferView(RootParameterIndex, BufferLocation);
 
   if(m_State >= WRITING)
@@ -1640,6 +1664,7 @@ bool WrappedID3D12GraphicsCommandList::Serialise_SetComputeRootShaderResourceVie
 void WrappedID3D12GraphicsCommandList::SetComputeRootShaderResourceView(
     UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::SetComputeRootShaderResourceView");
   m_pReal->SetComputeRootShaderResourceView(RootParameterIndex, BufferLocation);
 
   if(m_State >= WRITING)
@@ -1718,6 +1743,7 @@ bool WrappedID3D12GraphicsCommandList::Serialise_SetComputeRootUnorderedAccessVi
 void WrappedID3D12GraphicsCommandList::SetComputeRootUnorderedAccessView(
     UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::SetComputeRootUnorderedAccessView");
   m_pReal->SetComputeRootUnorderedAccessView(RootParameterIndex, BufferLocation);
 
   if(m_State >= WRITING)
@@ -1785,6 +1811,7 @@ bool WrappedID3D12GraphicsCommandList::Serialise_SetGraphicsRootSignature(
 
 void WrappedID3D12GraphicsCommandList::SetGraphicsRootSignature(ID3D12RootSignature *pRootSignature)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::SetGraphicsRootSignature");
   m_pReal->SetGraphicsRootSignature(Unwrap(pRootSignature));
 
   if(m_State >= WRITING)
@@ -1855,6 +1882,7 @@ bool WrappedID3D12GraphicsCommandList::Serialise_SetGraphicsRootDescriptorTable(
 void WrappedID3D12GraphicsCommandList::SetGraphicsRootDescriptorTable(
     UINT RootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::SetGraphicsRootDescriptorTable");
   m_pReal->SetGraphicsRootDescriptorTable(RootParameterIndex, Unwrap(BaseDescriptor));
 
   if(m_State >= WRITING)
@@ -1945,6 +1973,7 @@ void WrappedID3D12GraphicsCommandList::SetGraphicsRoot32BitConstant(UINT RootPar
                                                                     UINT SrcData,
                                                                     UINT DestOffsetIn32BitValues)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::SetGraphicsRoot32BitConstant");
   m_pReal->SetGraphicsRoot32BitConstant(RootParameterIndex, SrcData, DestOffsetIn32BitValues);
 
   if(m_State >= WRITING)
@@ -2004,6 +2033,7 @@ void WrappedID3D12GraphicsCommandList::SetGraphicsRoot32BitConstants(UINT RootPa
                                                                      const void *pSrcData,
                                                                      UINT DestOffsetIn32BitValues)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::SetGraphicsRoot32BitConstants");
   m_pReal->SetGraphicsRoot32BitConstants(RootParameterIndex, Num32BitValuesToSet, pSrcData,
                                          DestOffsetIn32BitValues);
 
@@ -2079,6 +2109,7 @@ bool WrappedID3D12GraphicsCommandList::Serialise_SetGraphicsRootConstantBufferVi
 void WrappedID3D12GraphicsCommandList::SetGraphicsRootConstantBufferView(
     UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::SetGraphicsRootConstantBufferView");
   m_pReal->SetGraphicsRootConstantBufferView(RootParameterIndex, BufferLocation);
 
   if(m_State >= WRITING)
@@ -2157,6 +2188,7 @@ bool WrappedID3D12GraphicsCommandList::Serialise_SetGraphicsRootShaderResourceVi
 void WrappedID3D12GraphicsCommandList::SetGraphicsRootShaderResourceView(
     UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::SetGraphicsRootShaderResourceView");
   m_pReal->SetGraphicsRootShaderResourceView(RootParameterIndex, BufferLocation);
 
   if(m_State >= WRITING)
@@ -2235,6 +2267,7 @@ bool WrappedID3D12GraphicsCommandList::Serialise_SetGraphicsRootUnorderedAccessV
 void WrappedID3D12GraphicsCommandList::SetGraphicsRootUnorderedAccessView(
     UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::SetGraphicsRootUnorderedAccessView");
   m_pReal->SetGraphicsRootUnorderedAccessView(RootParameterIndex, BufferLocation);
 
   if(m_State >= WRITING)
@@ -2289,6 +2322,7 @@ bool WrappedID3D12GraphicsCommandList::Serialise_BeginQuery(ID3D12QueryHeap *pQu
 void WrappedID3D12GraphicsCommandList::BeginQuery(ID3D12QueryHeap *pQueryHeap,
                                                   D3D12_QUERY_TYPE Type, UINT Index)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::BeginQuery");
   m_pReal->BeginQuery(Unwrap(pQueryHeap), Type, Index);
 
   if(m_State >= WRITING)
@@ -2336,6 +2370,7 @@ bool WrappedID3D12GraphicsCommandList::Serialise_EndQuery(ID3D12QueryHeap *pQuer
 void WrappedID3D12GraphicsCommandList::EndQuery(ID3D12QueryHeap *pQueryHeap, D3D12_QUERY_TYPE Type,
                                                 UINT Index)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::EndQuery");
   m_pReal->EndQuery(Unwrap(pQueryHeap), Type, Index);
 
   if(m_State >= WRITING)
@@ -2397,6 +2432,7 @@ void WrappedID3D12GraphicsCommandList::ResolveQueryData(ID3D12QueryHeap *pQueryH
                                                         ID3D12Resource *pDestinationBuffer,
                                                         UINT64 AlignedDestinationBufferOffset)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::ResolveQueryData");
   m_pReal->ResolveQueryData(Unwrap(pQueryHeap), Type, StartIndex, NumQueries,
                             Unwrap(pDestinationBuffer), AlignedDestinationBufferOffset);
 
@@ -2434,6 +2470,7 @@ void WrappedID3D12GraphicsCommandList::SetPredication(ID3D12Resource *pBuffer,
                                                       UINT64 AlignedBufferOffset,
                                                       D3D12_PREDICATION_OP Operation)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::SetPredication");
   m_pReal->SetPredication(Unwrap(pBuffer), AlignedBufferOffset, Operation);
 
   if(m_State >= WRITING)
@@ -2661,6 +2698,7 @@ bool WrappedID3D12GraphicsCommandList::Serialise_SetMarker(UINT Metadata, const
 
 void WrappedID3D12GraphicsCommandList::SetMarker(UINT Metadata, const void *pData, UINT Size)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::SetMarker");
   m_pReal->SetMarker(Metadata, pData, Size);
 
   if(m_State >= WRITING)
@@ -2719,6 +2757,7 @@ bool WrappedID3D12GraphicsCommandList::Serialise_BeginEvent(UINT Metadata, const
 
 void WrappedID3D12GraphicsCommandList::BeginEvent(UINT Metadata, const void *pData, UINT Size)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::BeginEvent");
   m_pReal->BeginEvent(Metadata, pData, Size);
 
   if(m_State >= WRITING)
@@ -2762,6 +2801,7 @@ bool WrappedID3D12GraphicsCommandList::Serialise_EndEvent()
 
 void WrappedID3D12GraphicsCommandList::EndEvent()
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::EndEvent");
   m_pReal->EndEvent();
 
   if(m_State >= WRITING)
@@ -2838,6 +2878,7 @@ void WrappedID3D12GraphicsCommandList::DrawInstanced(UINT VertexCountPerInstance
                                                      UINT InstanceCount, UINT StartVertexLocation,
                                                      UINT StartInstanceLocation)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::DrawInstanced");
   m_pReal->DrawInstanced(VertexCountPerInstance, InstanceCount, StartVertexLocation,
                          StartInstanceLocation);
 
@@ -2917,6 +2958,7 @@ void WrappedID3D12GraphicsCommandList::DrawIndexedInstanced(UINT IndexCountPerIn
                                                             INT BaseVertexLocation,
                                                             UINT StartInstanceLocation)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::DrawIndexedInstanced");
   m_pReal->DrawIndexedInstanced(IndexCountPerInstance, InstanceCount, StartIndexLocation,
                                 BaseVertexLocation, StartInstanceLocation);
 
@@ -2986,6 +3028,7 @@ bool WrappedID3D12GraphicsCommandList::Serialise_Dispatch(UINT ThreadGroupCountX
 void WrappedID3D12GraphicsCommandList::Dispatch(UINT ThreadGroupCountX, UINT ThreadGroupCountY,
                                                 UINT ThreadGroupCountZ)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::Dispatch");
   m_pReal->Dispatch(ThreadGroupCountX, ThreadGroupCountY, ThreadGroupCountZ);
 
   if(m_State >= WRITING)
@@ -3062,6 +3105,7 @@ bool WrappedID3D12GraphicsCommandList::Serialise_ExecuteBundle(ID3D12GraphicsCom
 
 void WrappedID3D12GraphicsCommandList::ExecuteBundle(ID3D12GraphicsCommandList *pCommandList)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::ExecuteBundle");
   m_pReal->ExecuteBundle(Unwrap(pCommandList));
 
   if(m_State >= WRITING)
@@ -3087,8 +3131,10 @@ void WrappedID3D12GraphicsCommandList::ExecuteBundle(ID3D12GraphicsCommandList *
  * time we crack the list into two, and copy off the argument buffer in the first part and execute
  * with the copy destination in the second part.
  *
- * Then when we come to ExecuteCommandLists this list, we go step by step through the cracked lists,
- * executing the first, then syncing to the GPU and patching the argument buffer before continuing.
+ * The count buffer is copied alongside the arguments, since its contents could change later in the
+ * submission. That means when we come to ExecuteCommandLists this list, all of the cracked lists
+ * can be executed back to back, with one sync at the end of the submission before patching every
+ * ExecuteIndirect in it.
  *
  * At READING time we reserve a maxCount number of drawcalls and events, and later on when patching
  * the argument buffer we fill in the parameters/names and remove any excess draws that weren't
@@ -3165,13 +3211,19 @@ void WrappedID3D12GraphicsCommandList::PatchExecuteIndirect(BakedCmdListInfo &in
   WrappedID3D12CommandSignature *comSig =
       GetResourceManager()->GetLiveAs<WrappedID3D12CommandSignature>(exec.sig);
 
+  D3D12_RANGE range = {0, D3D12CommandData::m_IndirectSize};
+  byte *mapPtr = NULL;
+  exec.argBuf->Map(0, &range, (void **)&mapPtr);
+
   uint32_t count = exec.maxCount;
 
+  // the count was copied straight after the arguments
   if(exec.countBuf)
   {
-    vector<byte> data;
-    m_pDevice->GetDebugManager()->GetBufferData(exec.countBuf, exec.countOffs, 4, data);
-    count = RDCMIN(count, *(uint32_t *)&data[0]);
+    uint32_t countVal = 0;
+    memcpy(&countVal, mapPtr + exec.argOffs + comSig->sig.ByteStride * exec.maxCount,
+           sizeof(countVal));
+    count = RDCMIN(count, countVal);
   }
 
   exec.realCount = count;
@@ -3184,10 +3236,6 @@ void WrappedID3D12GraphicsCommandList::PatchExecuteIndirect(BakedCmdListInfo &in
   // + 1 is because baseEvent refers to the marker before the commands
   exec.lastEvent = exec.baseEvent + 1 + sigSize * count;
 
-  D3D12_RANGE range = {0, D3D12CommandData::m_IndirectSize};
-  byte *mapPtr = NULL;
-  exec.argBuf->Map(0, &range, (void **)&mapPtr);
-
   std::vector<D3D12DrawcallTreeNode> &draws = info.draw->children;
 
   size_t idx = 0;
@@ -4001,25 +4049,38 @@ bool WrappedID3D12GraphicsCommandList::Serialise_ExecuteIndirect(
     exec.countBuf = countBuf;
     exec.countOffs = countOffs;
 
-    // allocate space for patched indirect buffer
-    m_Cmd->GetIndirectBuffer(comSig->sig.ByteStride * maxCount, &exec.argBuf, &exec.argOffs);
+    const uint64_t argSize = comSig->sig.ByteStride * maxCount;
+
+    // allocate space for patched indirect buffer, and the count after it
+    m_Cmd->GetIndirectBuffer(size_t(argSize + (countBuf ? sizeof(uint32_t) : 0)), &exec.argBuf,
+                             &exec.argOffs);
 
-    // transition buffer to COPY_SOURCE/COPY_DEST, copy, and back to INDIRECT_ARG
-    D3D12_RESOURCE_BARRIER barriers[2] = {};
-    barriers[0].Transition.pResource = Unwrap(argBuf);
+    // transition buffers to COPY_SOURCE/COPY_DEST, copy, and back to INDIRECT_ARG
+    D3D12_RESOURCE_BARRIER barriers[3] = {};
+    UINT numBarriers = 2;
+    barriers[0].Transition.pResource = Unwrap(exec.argBuf);
     barriers[0].Transition.StateBefore = D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT;
-    barriers[0].Transition.StateAfter = D3D12_RESOURCE_STATE_COPY_SOURCE;
-    barriers[1].Transition.pResource = Unwrap(exec.argBuf);
+    barriers[0].Transition.StateAfter = D3D12_RESOURCE_STATE_COPY_DEST;
+    barriers[1].Transition.pResource = Unwrap(argBuf);
     barriers[1].Transition.StateBefore = D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT;
-    barriers[1].Transition.StateAfter = D3D12_RESOURCE_STATE_COPY_DEST;
-    cracked->ResourceBarrier(2, barriers);
+    barriers[1].Transition.StateAfter = D3D12_RESOURCE_STATE_COPY_SOURCE;
+    if(countBuf && countBuf != argBuf)
+    {
+      barriers[2] = barriers[1];
+      barriers[2].Transition.pResource = Unwrap(countBuf);
+      numBarriers++;
+    }
+    cracked->ResourceBarrier(numBarriers, barriers);
+
+    cracked->CopyBufferRegion(Unwrap(exec.argBuf), exec.argOffs, Unwrap(argBuf), argOffs, argSize);
 
-    cracked->CopyBufferRegion(Unwrap(exec.argBuf), exec.argOffs, Unwrap(argBuf), argOffs,
-                              comSig->sig.ByteStride * maxCount);
+    if(countBuf)
+      cracked->CopyBufferRegion(Unwrap(exec.argBuf), exec.argOffs + argSize, Unwrap(countBuf),
+                                countOffs, sizeof(uint32_t));
 
-    std::swap(barriers[0].Transition.StateBefore, barriers[0].Transition.StateAfter);
-    std::swap(barriers[1].Transition.StateBefore, barriers[1].Transition.StateAfter);
-    cracked->ResourceBarrier(2, barriers);
+    for(UINT b = 0; b < numBarriers; b++)
+      std::swap(barriers[b].Transition.StateBefore, barriers[b].Transition.StateAfter);
+    cracked->ResourceBarrier(numBarriers, barriers);
 
     cracked->Close();
 
@@ -4068,6 +4129,7 @@ void WrappedID3D12GraphicsCommandList::ExecuteIndirect(ID3D12CommandSignature *p
                                                        ID3D12Resource *pCountBuffer,
                                                        UINT64 CountBufferOffset)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::ExecuteIndirect");
   m_pReal->ExecuteIndirect(Unwrap(pCommandSignature), MaxCommandCount, Unwrap(pArgumentBuffer),
                            ArgumentBufferOffset, Unwrap(pCountBuffer), CountBufferOffset);
 
@@ -4155,6 +4217,7 @@ void WrappedID3D12GraphicsCommandList::ClearDepthStencilView(
     D3D12_CPU_DESCRIPTOR_HANDLE DepthStencilView, D3D12_CLEAR_FLAGS ClearFlags, FLOAT Depth,
     UINT8 Stencil, UINT NumRects, const D3D12_RECT *pRects)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::ClearDepthStencilView");
   m_pReal->ClearDepthStencilView(Unwrap(DepthStencilView), ClearFlags, Depth, Stencil, NumRects,
                                  pRects);
 
@@ -4242,6 +4305,7 @@ void WrappedID3D12GraphicsCommandList::ClearRenderTargetView(
     D3D12_CPU_DESCRIPTOR_HANDLE RenderTargetView, const FLOAT ColorRGBA[4], UINT NumRects,
     const D3D12_RECT *pRects)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::ClearRenderTargetView");
   m_pReal->ClearRenderTargetView(Unwrap(RenderTargetView), ColorRGBA, NumRects, pRects);
 
   if(m_State >= WRITING)
@@ -4337,6 +4401,7 @@ void WrappedID3D12GraphicsCommandList::ClearUnorderedAccessViewUint(
     D3D12_GPU_DESCRIPTOR_HANDLE ViewGPUHandleInCurrentHeap, D3D12_CPU_DESCRIPTOR_HANDLE ViewCPUHandle,
     ID3D12Resource *pResource, const UINT Values[4], UINT NumRects, const D3D12_RECT *pRects)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::ClearUnorderedAccessViewUint");
   m_pReal->ClearUnorderedAccessViewUint(Unwrap(ViewGPUHandleInCurrentHeap), Unwrap(ViewCPUHandle),
                                         Unwrap(pResource), Values, NumRects, pRects);
 
@@ -4440,6 +4505,7 @@ void WrappedID3D12GraphicsCommandList::ClearUnorderedAccessViewFloat(
     D3D12_GPU_DESCRIPTOR_HANDLE ViewGPUHandleInCurrentHeap, D3D12_CPU_DESCRIPTOR_HANDLE ViewCPUHandle,
     ID3D12Resource *pResource, const FLOAT Values[4], UINT NumRects, const D3D12_RECT *pRects)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::ClearUnorderedAccessViewFloat");
   m_pReal->ClearUnorderedAccessViewFloat(Unwrap(ViewGPUHandleInCurrentHeap), Unwrap(ViewCPUHandle),
                                          Unwrap(pResource), Values, NumRects, pRects);
 
@@ -4500,6 +4566,7 @@ bool WrappedID3D12GraphicsCommandList::Serialise_DiscardResource(ID3D12Resource
 void WrappedID3D12GraphicsCommandList::DiscardResource(ID3D12Resource *pResource,
                                                        const D3D12_DISCARD_REGION *pRegion)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::DiscardResource");
   m_pReal->DiscardResource(Unwrap(pResource), pRegion);
 
   if(m_State >= WRITING)
@@ -4590,6 +4657,7 @@ void WrappedID3D12GraphicsCommandList::CopyBufferRegion(ID3D12Resource *pDstBuff
                                                         UINT64 DstOffset, ID3D12Resource *pSrcBuffer,
                                                         UINT64 SrcOffset, UINT64 NumBytes)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::CopyBufferRegion");
   m_pReal->CopyBufferRegion(Unwrap(pDstBuffer), DstOffset, Unwrap(pSrcBuffer), SrcOffset, NumBytes);
 
   if(m_State >= WRITING)
@@ -4679,6 +4747,7 @@ void WrappedID3D12GraphicsCommandList::CopyTextureRegion(const D3D12_TEXTURE_COP
                                                          const D3D12_TEXTURE_COPY_LOCATION *pSrc,
                                                          const D3D12_BOX *pSrcBox)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::CopyTextureRegion");
   D3D12_TEXTURE_COPY_LOCATION dst = *pDst;
   dst.pResource = Unwrap(dst.pResource);
 
@@ -4766,6 +4835,7 @@ bool WrappedID3D12GraphicsCommandList::Serialise_CopyResource(ID3D12Resource *pD
 void WrappedID3D12GraphicsCommandList::CopyResource(ID3D12Resource *pDstResource,
                                                     ID3D12Resource *pSrcResource)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::CopyResource");
   m_pReal->CopyResource(Unwrap(pDstResource), Unwrap(pSrcResource));
 
   if(m_State >= WRITING)
@@ -4858,6 +4928,7 @@ void WrappedID3D12GraphicsCommandList::ResolveSubresource(ID3D12Resource *pDstRe
                                                           ID3D12Resource *pSrcResource,
                                                           UINT SrcSubresource, DXGI_FORMAT Format)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::ResolveSubresource");
   m_pReal->ResolveSubresource(Unwrap(pDstResource), DstSubresource, Unwrap(pSrcResource),
                               SrcSubresource, Format);
 
@@ -4886,6 +4957,7 @@ void WrappedID3D12GraphicsCommandList::CopyTiles(
     const D3D12_TILE_REGION_SIZE *pTileRegionSize, ID3D12Resource *pBuffer,
     UINT64 BufferStartOffsetInBytes, D3D12_TILE_COPY_FLAGS Flags)
 {
+  SCOPED_API_CALL_STATS("ID3D12GraphicsCommandList::CopyTiles");
   D3D12NOTIMP("Tiled Resources");
   m_pReal->CopyTiles(Unwrap(pTiledResource), pTileRegionStartCoordinate, pTileRegionSize,
                      Unwrap(pBuffer), BufferStartOffsetInBytes, Flags);
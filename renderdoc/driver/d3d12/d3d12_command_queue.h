@@ -98,6 +98,11 @@ class WrappedID3D12CommandQueue : public ID3D12CommandQueue,
 
   ResourceId m_BackbufferID;
 
+  // every ExecuteCommandLists in the frame and which queue it went to, gathered while reading since
+  // the drawcall tree merges all queues together
+  vector<QueueSubmission> m_QueueSubmissions;
+  uint32_t m_PendingWaits;
+
   void ProcessChunk(uint64_t offset, D3D12ChunkType context);
 
   const char *GetChunkName(uint32_t idx) { return m_pDevice->GetChunkName(idx); }
@@ -116,6 +121,7 @@ public:
   D3D12ResourceRecord *GetResourceRecord() { return m_QueueRecord; }
   WrappedID3D12Device *GetWrappedDevice() { return m_pDevice; }
   const vector<D3D12ResourceRecord *> &GetCmdLists() { return m_CmdListRecords; }
+  const vector<QueueSubmission> &GetQueueSubmissions() { return m_QueueSubmissions; }
   D3D12DrawcallTreeNode &GetParentDrawcall() { return m_Cmd.m_ParentDrawcall; }
   APIEvent GetEvent(uint32_t eventID);
   uint32_t GetMaxEID() { return m_Cmd.m_Events.back().eventID; }
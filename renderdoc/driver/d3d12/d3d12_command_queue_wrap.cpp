@@ -147,10 +147,16 @@ bool WrappedID3D12CommandQueue::Serialise_ExecuteCommandLists(UINT NumCommandLis
 
   if(m_State == READING)
   {
+    // lists executed cracked for the first time. Their argument and count copies all land in
+    // separate parts of the indirect buffers, so they're patched together after one sync at the end
+    // instead of syncing for each ExecuteIndirect
+    set<ResourceId> patchLists;
+
     for(uint32_t i = 0; i < numCmds; i++)
     {
       if(m_Cmd.m_BakedCmdListInfo[cmdIds[i]].executeEvents.empty() ||
-         m_Cmd.m_BakedCmdListInfo[cmdIds[i]].executeEvents[0].patched)
+         m_Cmd.m_BakedCmdListInfo[cmdIds[i]].executeEvents[0].patched ||
+         patchLists.find(cmdIds[i]) != patchLists.end())
       {
         ID3D12CommandList *list = Unwrap(cmds[i]);
         real->ExecuteCommandLists(1, &list);
@@ -162,21 +168,13 @@ bool WrappedID3D12CommandQueue::Serialise_ExecuteCommandLists(UINT NumCommandLis
       {
         BakedCmdListInfo &info = m_Cmd.m_BakedCmdListInfo[cmdIds[i]];
 
-        // execute the first half of the cracked list
-        ID3D12CommandList *list = Unwrap(info.crackedLists[0]);
-        real->ExecuteCommandLists(1, &list);
+        vector<ID3D12CommandList *> lists;
+        for(size_t c = 0; c < info.crackedLists.size(); c++)
+          lists.push_back(Unwrap(info.crackedLists[c]));
 
-        for(size_t c = 1; c < info.crackedLists.size(); c++)
-        {
-          m_pDevice->GPUSync();
+        real->ExecuteCommandLists((UINT)lists.size(), &lists[0]);
 
-          // readback the patch buffer and perform patching
-          m_ReplayList->PatchExecuteIndirect(info, uint32_t(c - 1));
-
-          // execute next list with this indirect.
-          list = Unwrap(info.crackedLists[c]);
-          real->ExecuteCommandLists(1, &list);
-        }
+        patchLists.insert(cmdIds[i]);
 
 #if ENABLED(SINGLE_FLUSH_VALIDATE)
         m_pDevice->GPUSync();
@@ -184,6 +182,19 @@ bool WrappedID3D12CommandQueue::Serialise_ExecuteCommandLists(UINT NumCommandLis
       }
     }
 
+    if(!patchLists.empty())
+    {
+      m_pDevice->GPUSync();
+
+      for(auto it = patchLists.begin(); it != patchLists.end(); ++it)
+      {
+        BakedCmdListInfo &info = m_Cmd.m_BakedCmdListInfo[*it];
+
+        for(size_t e = 0; e < info.executeEvents.size(); e++)
+          m_ReplayList->PatchExecuteIndirect(info, uint32_t(e));
+      }
+    }
+
     for(uint32_t i = 0; i < numCmds; i++)
     {
       ResourceId cmd = GetResourceManager()->GetLiveID(cmdIds[i]);
@@ -192,6 +203,19 @@ bool WrappedID3D12CommandQueue::Serialise_ExecuteCommandLists(UINT NumCommandLis
 
     m_Cmd.AddEvent(desc);
 
+    QueueSubmission submission;
+    submission.queue = queueId;
+    submission.eventID = m_Cmd.m_RootEventID;
+    submission.waits = m_PendingWaits;
+    m_PendingWaits = 0;
+
+    switch(real->GetDesc().Type)
+    {
+      case D3D12_COMMAND_LIST_TYPE_COMPUTE: submission.type = QueueType::Compute; break;
+      case D3D12_COMMAND_LIST_TYPE_COPY: submission.type = QueueType::Copy; break;
+      default: submission.type = QueueType::Graphics; break;
+    }
+
     // we're adding multiple events, need to increment ourselves
     m_Cmd.m_RootEventID++;
 
@@ -251,6 +275,9 @@ bool WrappedID3D12CommandQueue::Serialise_ExecuteCommandLists(UINT NumCommandLis
     // account for the outer loop thinking we've added one event and incrementing,
     // since we've done all the handling ourselves this will be off by one.
     m_Cmd.m_RootEventID--;
+
+    submission.lastEventID = m_Cmd.m_RootEventID;
+    m_QueueSubmissions.push_back(submission);
   }
   else if(m_State == EXECUTING)
   {
@@ -668,6 +695,10 @@ bool WrappedID3D12CommandQueue::Serialise_Wait(ID3D12Fence *pFence, UINT64 Value
     m_pDevice->GPUSync();
   }
 
+  // waits don't record which queue they were on, so count them against the next submission
+  if(m_State == READING)
+    m_PendingWaits++;
+
   return true;
 }
 
@@ -138,7 +138,7 @@ ULONG STDMETHODCALLTYPE WrappedID3D12DebugCommandList::Release()
 WrappedID3D12CommandQueue::WrappedID3D12CommandQueue(ID3D12CommandQueue *real,
                                                      WrappedID3D12Device *device,
                                                      Serialiser *serialiser, LogState &state)
-    : RefCounter12(real), m_pDevice(device), m_State(state)
+    : RefCounter12(real), m_pDevice(device), m_State(state), m_PendingWaits(0)
 {
   if(RenderDoc::Inst().GetCrashHandler())
     RenderDoc::Inst().GetCrashHandler()->RegisterMemoryRegion(this,
@@ -431,6 +431,27 @@ void WrappedID3D12CommandQueue::ProcessChunk(uint64_t offset, D3D12ChunkType chu
       }
       break;
     }
+    case CONTEXT_FRAME_BOUNDARY:
+    {
+      // a present in the middle of a multi-frame capture. Unlike the footer the frame carries on
+      SERIALISE_ELEMENT(ResourceId, bbid, ResourceId());
+
+      if(m_State == READING)
+      {
+        m_pDevice->GetFrameRecord().frameInfo.frameCount++;
+
+        m_Cmd.AddEvent("Present()");
+
+        DrawcallDescription draw;
+        draw.name = "Present()";
+        draw.flags |= DrawFlags::Present;
+
+        draw.copyDestination = bbid;
+
+        m_Cmd.AddDrawcall(draw, true);
+      }
+      break;
+    }
     default:
       // ignore system chunks
       if(chunk == INITIAL_CONTENTS)
@@ -636,6 +657,10 @@ WrappedID3D12GraphicsCommandList::WrappedID3D12GraphicsCommandList(ID3D12Graphic
 
     m_ListRecord->cmdInfo = new CmdListRecordingInfo();
 
+    // command lists are only recorded on one thread at a time, so chunks can be added without
+    // locking or allocating IDs from the shared counter until the list is closed.
+    m_ListRecord->SetDeferChunkIDs(true);
+
     // this is set up in the implicit Reset() right after creation
     m_ListRecord->bakedCommands = NULL;
   }
@@ -955,6 +980,8 @@ void D3D12CommandData::AddEvent(string description)
   APIEvent apievent;
 
   apievent.fileOffset = m_CurChunkOffset;
+  m_pSerialiser->GetChunkTiming(m_CurChunkOffset, apievent.cpuTimestamp, apievent.threadID);
+  m_pSerialiser->GetChunkResourceRefs(apievent.referencedResources);
   apievent.eventID = m_LastCmdListID != ResourceId() ? m_BakedCmdListInfo[m_LastCmdListID].curEventID
                                                      : m_RootEventID;
 
@@ -399,29 +399,6 @@ void MakeShaderReflection(DXBC::DXBCFile *dxbc, ShaderReflection *refl,
   if(dxbc == NULL || !RenderDoc::Inst().IsReplayApp())
     return;
 
-  if(dxbc->m_DebugInfo)
-  {
-    refl->DebugInfo.entryFunc = dxbc->m_DebugInfo->GetEntryFunction();
-    refl->DebugInfo.compileFlags = dxbc->m_DebugInfo->GetShaderCompileFlags();
-
-    refl->DebugInfo.entryFile = -1;
-
-    create_array_uninit(refl->DebugInfo.files, dxbc->m_DebugInfo->Files.size());
-    for(size_t i = 0; i < dxbc->m_DebugInfo->Files.size(); i++)
-    {
-      refl->DebugInfo.files[i].first = dxbc->m_DebugInfo->Files[i].first;
-      refl->DebugInfo.files[i].second = dxbc->m_DebugInfo->Files[i].second;
-
-      if(refl->DebugInfo.entryFile == -1 &&
-         strstr(refl->DebugInfo.files[i].second.elems, refl->DebugInfo.entryFunc.elems))
-      {
-        refl->DebugInfo.entryFile = (int32_t)i;
-      }
-    }
-  }
-
-  refl->Disassembly = dxbc->GetDisassembly();
-
   if(dxbc->m_ShaderBlob.empty())
     create_array_uninit(refl->RawBytes, 0);
   else
@@ -434,6 +411,8 @@ void MakeShaderReflection(DXBC::DXBCFile *dxbc, ShaderReflection *refl,
   refl->InputSig = dxbc->m_InputSig;
   refl->OutputSig = dxbc->m_OutputSig;
 
+  DXBC::MakeShaderCost(dxbc, refl);
+
   create_array_uninit(mapping->InputAttributes, D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT);
   for(int s = 0; s < D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT; s++)
     mapping->InputAttributes[s] = s;
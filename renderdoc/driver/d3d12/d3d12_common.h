@@ -468,6 +468,8 @@ void Serialiser::Serialise(const char *name, D3D12Descriptor &el);
   D3D12_CHUNK_MACRO(UPDATE_TILE_MAPPINGS, "ID3D12GraphicsCommandQueue::UpdateTileMappings")        \
   D3D12_CHUNK_MACRO(COPY_TILE_MAPPINGS, "ID3D12GraphicsCommandQueue::CopyTileMappings")            \
                                                                                                    \
+  D3D12_CHUNK_MACRO(CONTEXT_FRAME_BOUNDARY, "FrameBoundary")                                       \
+                                                                                                   \
   D3D12_CHUNK_MACRO(NUM_D3D12_CHUNKS, "")
 
 enum D3D12ChunkType
@@ -22,6 +22,7 @@
  * THE SOFTWARE.
  ******************************************************************************/
 
+#include "d3d12_command_list.h"
 #include "d3d12_command_queue.h"
 #include "d3d12_common.h"
 #include "d3d12_device.h"
@@ -32,10 +33,12 @@ void D3D12Replay::PreDeviceInitCounters()
 
 void D3D12Replay::PostDeviceInitCounters()
 {
+  m_CounterProviders.Init(eRENDERDOC_CounterAPI_D3D12, (void *)m_pDevice->GetReal());
 }
 
 void D3D12Replay::PreDeviceShutdownCounters()
 {
+  m_CounterProviders.Shutdown();
 }
 
 void D3D12Replay::PostDeviceShutdownCounters()
@@ -47,6 +50,7 @@ vector<GPUCounter> D3D12Replay::EnumerateCounters()
   vector<GPUCounter> ret;
 
   ret.push_back(GPUCounter::EventGPUDuration);
+  ret.push_back(GPUCounter::EventGPUStart);
   ret.push_back(GPUCounter::InputVerticesRead);
   ret.push_back(GPUCounter::IAPrimitives);
   ret.push_back(GPUCounter::GSPrimitives);
@@ -60,11 +64,17 @@ vector<GPUCounter> D3D12Replay::EnumerateCounters()
   ret.push_back(GPUCounter::PSInvocations);
   ret.push_back(GPUCounter::CSInvocations);
 
+  vector<GPUCounter> providerCounters = m_CounterProviders.EnumerateCounters();
+  ret.insert(ret.end(), providerCounters.begin(), providerCounters.end());
+
   return ret;
 }
 
 void D3D12Replay::DescribeCounter(GPUCounter counterID, CounterDescription &desc)
 {
+  if(m_CounterProviders.DescribeCounter(counterID, desc))
+    return;
+
   desc.counterID = counterID;
 
   switch(counterID)
@@ -77,6 +87,15 @@ void D3D12Replay::DescribeCounter(GPUCounter counterID, CounterDescription &desc
       desc.resultType = CompType::Double;
       desc.unit = CounterUnit::Seconds;
       break;
+    case GPUCounter::EventGPUStart:
+      desc.name = "GPU Start";
+      desc.description =
+          "Time from the start of the first timed event in the frame to the start of this event "
+          "on the GPU, comparable between queues.";
+      desc.resultByteWidth = 8;
+      desc.resultType = CompType::Double;
+      desc.unit = CounterUnit::Seconds;
+      break;
     case GPUCounter::InputVerticesRead:
       desc.name = "Input Vertices Read";
       desc.description = "Number of vertices read by input assembler.";
@@ -243,8 +262,106 @@ struct D3D12GPUTimerCallback : public D3D12DrawcallCallback
   vector<pair<uint32_t, uint32_t> > m_AliasEvents;
 };
 
+struct D3D12CounterProviderCallback : public D3D12DrawcallCallback
+{
+  D3D12CounterProviderCallback(WrappedID3D12Device *dev, CounterProviders &providers)
+      : m_pDevice(dev), m_Providers(providers)
+  {
+    m_pDevice->GetQueue()->GetCommandData()->m_DrawcallCallback = this;
+  }
+  ~D3D12CounterProviderCallback()
+  {
+    m_pDevice->GetQueue()->GetCommandData()->m_DrawcallCallback = NULL;
+  }
+  void PreDraw(uint32_t eid, ID3D12GraphicsCommandList *cmd)
+  {
+    m_Providers.BeginSample(eid, (void *)Unwrap(cmd));
+  }
+
+  bool PostDraw(uint32_t eid, ID3D12GraphicsCommandList *cmd)
+  {
+    m_Providers.EndSample(eid, (void *)Unwrap(cmd));
+    return false;
+  }
+
+  void PostRedraw(uint32_t eid, ID3D12GraphicsCommandList *cmd) {}
+  // we don't need to distinguish, call the Draw functions
+  void PreDispatch(uint32_t eid, ID3D12GraphicsCommandList *cmd) { PreDraw(eid, cmd); }
+  bool PostDispatch(uint32_t eid, ID3D12GraphicsCommandList *cmd) { return PostDraw(eid, cmd); }
+  void PostRedispatch(uint32_t eid, ID3D12GraphicsCommandList *cmd) { PostRedraw(eid, cmd); }
+  bool RecordAllCmds() { return true; }
+  void AliasEvent(uint32_t primary, uint32_t alias)
+  {
+    m_AliasEvents.push_back(std::make_pair(primary, alias));
+  }
+
+  WrappedID3D12Device *m_pDevice;
+  CounterProviders &m_Providers;
+  vector<pair<uint32_t, uint32_t> > m_AliasEvents;
+};
+
+vector<CounterResult> D3D12Replay::FetchProviderCounters(const vector<GPUCounter> &counters)
+{
+  uint32_t maxEID = m_pDevice->GetQueue()->GetMaxEID();
+
+  uint32_t numPasses = m_CounterProviders.BeginSession(counters);
+
+  vector<pair<uint32_t, uint32_t> > aliasEvents;
+
+  for(uint32_t pass = 0; pass < numPasses; pass++)
+  {
+    D3D12CounterProviderCallback cb(m_pDevice, m_CounterProviders);
+
+    m_CounterProviders.BeginPass(pass);
+    m_pDevice->ReplayLog(0, maxEID, eReplay_Full);
+    m_pDevice->ExecuteLists();
+    m_pDevice->FlushLists(true);
+    m_CounterProviders.EndPass(pass);
+
+    if(pass == 0)
+      aliasEvents = cb.m_AliasEvents;
+  }
+
+  vector<CounterResult> ret = m_CounterProviders.EndSession();
+
+  for(size_t i = 0; i < aliasEvents.size(); i++)
+  {
+    for(size_t c = 0; c < counters.size(); c++)
+    {
+      CounterResult search;
+      search.counterID = counters[c];
+      search.eventID = aliasEvents[i].first;
+
+      auto it = std::find(ret.begin(), ret.end(), search);
+      if(it == ret.end())
+        continue;
+
+      CounterResult aliased = *it;
+      aliased.eventID = aliasEvents[i].second;
+      ret.push_back(aliased);
+    }
+  }
+
+  return ret;
+}
+
 vector<CounterResult> D3D12Replay::FetchCounters(const vector<GPUCounter> &counters)
 {
+  vector<GPUCounter> apiCounters, providerCounters;
+  if(m_CounterProviders.SplitCounters(counters, apiCounters, providerCounters))
+  {
+    vector<CounterResult> ret;
+    if(!apiCounters.empty())
+      ret = FetchCounters(apiCounters);
+
+    vector<CounterResult> providerResults = FetchProviderCounters(providerCounters);
+    ret.insert(ret.end(), providerResults.begin(), providerResults.end());
+
+    std::sort(ret.begin(), ret.end());
+
+    return ret;
+  }
+
   uint32_t maxEID = m_pDevice->GetQueue()->GetMaxEID();
 
   vector<CounterResult> ret;
@@ -383,8 +500,73 @@ vector<CounterResult> D3D12Replay::FetchCounters(const vector<GPUCounter> &count
   data += cb.m_NumStatsQueries * sizeof(D3D12_QUERY_DATA_PIPELINE_STATISTICS);
   uint64_t *occlusion = (uint64_t *)data;
 
-  uint64_t freq;
-  m_pDevice->GetQueue()->GetTimestampFrequency(&freq);
+  // each queue's timestamps come from its own clock, so they're moved onto the CPU's clock with
+  // the queue's calibration to compare starts between queues
+  struct QueueClock
+  {
+    UINT64 frequency;
+    UINT64 gpuRef;
+    UINT64 cpuRef;
+  };
+
+  QueueClock mainClock;
+  m_pDevice->GetQueue()->GetTimestampFrequency(&mainClock.frequency);
+  m_pDevice->GetQueue()->GetClockCalibration(&mainClock.gpuRef, &mainClock.cpuRef);
+
+  const rdctype::array<QueueSubmission> &submissions =
+      m_pDevice->GetFrameRecord().frameInfo.queueSubmissions;
+
+  map<ResourceId, QueueClock> clocks;
+  for(int32_t s = 0; s < submissions.count; s++)
+  {
+    ResourceId id = submissions[s].queue;
+
+    if(clocks.find(id) != clocks.end() || !m_pDevice->GetResourceManager()->HasLiveResource(id))
+      continue;
+
+    ID3D12CommandQueue *queue = m_pDevice->GetResourceManager()->GetLiveAs<ID3D12CommandQueue>(id);
+
+    QueueClock &clock = clocks[id];
+    queue->GetTimestampFrequency(&clock.frequency);
+    queue->GetClockCalibration(&clock.gpuRef, &clock.cpuRef);
+  }
+
+  double cpuFreq = Timing::GetTickFrequency() * 1000.0;
+
+  vector<const QueueClock *> eventClocks(cb.m_Results.size(), &mainClock);
+  vector<double> starts(cb.m_Results.size(), 0.0);
+  double firstStart = 0.0;
+
+  for(size_t i = 0; i < cb.m_Results.size(); i++)
+  {
+    uint32_t eid = cb.m_Results[i].first;
+
+    // submissions are in EID order, find the last one starting at or before this event
+    int32_t lo = 0, hi = submissions.count;
+    while(lo < hi)
+    {
+      int32_t mid = (lo + hi) / 2;
+      if(submissions[mid].eventID <= eid)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+    if(lo > 0 && eid <= submissions[lo - 1].lastEventID)
+    {
+      auto it = clocks.find(submissions[lo - 1].queue);
+      if(it != clocks.end())
+        eventClocks[i] = &it->second;
+    }
+
+    const QueueClock &clock = *eventClocks[i];
+
+    int64_t gpuDelta = int64_t(timestamps[i * 2 + 0] - clock.gpuRef);
+    starts[i] = double(clock.cpuRef) / cpuFreq + double(gpuDelta) / double(clock.frequency);
+
+    if(i == 0 || starts[i] < firstStart)
+      firstStart = starts[i];
+  }
 
   for(size_t i = 0; i < cb.m_Results.size(); i++)
   {
@@ -415,9 +597,10 @@ vector<CounterResult> D3D12Replay::FetchCounters(const vector<GPUCounter> &count
         case GPUCounter::EventGPUDuration:
         {
           uint64_t delta = timestamps[i * 2 + 1] - timestamps[i * 2 + 0];
-          result.value.d = double(delta) / double(freq);
+          result.value.d = double(delta) / double(eventClocks[i]->frequency);
         }
         break;
+        case GPUCounter::EventGPUStart: result.value.d = starts[i] - firstStart; break;
         case GPUCounter::InputVerticesRead: result.value.u64 = pipeStats.IAVertices; break;
         case GPUCounter::IAPrimitives: result.value.u64 = pipeStats.IAPrimitives; break;
         case GPUCounter::GSPrimitives: result.value.u64 = pipeStats.GSPrimitives; break;
@@ -23,7 +23,6 @@
  ******************************************************************************/
 
 #include "d3d12_debug.h"
-#include "common/shader_cache.h"
 #include "data/resource.h"
 #include "driver/dx/official/d3dcompiler.h"
 #include "driver/dxgi/dxgi_common.h"
@@ -303,11 +302,7 @@ D3D12DebugManager::D3D12DebugManager(WrappedID3D12Device *wrapper)
 
   RenderDoc::Inst().SetProgress(DebugManagerInit, 0.4f);
 
-  bool success = LoadShaderCache("d3d12shaders.cache", m_ShaderCacheMagic, m_ShaderCacheVersion,
-                                 m_ShaderCache, ShaderCache12Callbacks);
-
-  // if we failed to load from the cache
-  m_ShaderCacheDirty = !success;
+  m_ShaderCache.Open("d3d12shaders.cache", m_ShaderCacheMagic, m_ShaderCacheVersion);
 
   m_CacheShaders = true;
 
@@ -1252,16 +1247,7 @@ D3D12DebugManager::D3D12DebugManager(WrappedID3D12Device *wrapper)
 
 D3D12DebugManager::~D3D12DebugManager()
 {
-  if(m_ShaderCacheDirty)
-  {
-    SaveShaderCache("d3d12shaders.cache", m_ShaderCacheMagic, m_ShaderCacheVersion, m_ShaderCache,
-                    ShaderCache12Callbacks);
-  }
-  else
-  {
-    for(auto it = m_ShaderCache.begin(); it != m_ShaderCache.end(); ++it)
-      ShaderCache12Callbacks.Destroy(it->second);
-  }
+  m_ShaderCache.Close(ShaderCache12Callbacks);
 
   for(auto it = m_CachedMeshPipelines.begin(); it != m_CachedMeshPipelines.end(); ++it)
     for(size_t p = 0; p < MeshDisplayPipelines::ePipe_Count; p++)
@@ -1451,9 +1437,8 @@ string D3D12DebugManager::GetShaderBlob(const char *source, const char *entry,
   hash = strhash(profile, hash);
   hash ^= compileFlags;
 
-  if(m_ShaderCache.find(hash) != m_ShaderCache.end())
+  if(m_ShaderCache.Find(hash, *srcblob, ShaderCache12Callbacks))
   {
-    *srcblob = m_ShaderCache[hash];
     (*srcblob)->AddRef();
     return "";
   }
@@ -1505,9 +1490,8 @@ string D3D12DebugManager::GetShaderBlob(const char *source, const char *entry,
 
   if(m_CacheShaders)
   {
-    m_ShaderCache[hash] = byteBlob;
+    m_ShaderCache.Insert(hash, byteBlob);
     byteBlob->AddRef();
-    m_ShaderCacheDirty = true;
   }
 
   SAFE_RELEASE(errBlob);
@@ -2581,6 +2565,10 @@ uint32_t D3D12DebugManager::PickVertex(uint32_t eventID, const MeshDisplay &cfg,
 
   HRESULT hr = S_OK;
 
+  // if we're picking in the same mesh as last time, its unpacked data is still in the pick buffer
+  // and only the dispatch itself needs to run again
+  bool upload = !m_PickCache.Matches(eventID, cfg.position);
+
   // most IB/VBs will not be available as SRVs. So, we copy into our own buffers.
   // In the case of VB we also tightly pack and unpack the data. IB can just be
   // read as R16 or R32 via the SRV so it is just a straight copy
@@ -2654,6 +2642,7 @@ uint32_t D3D12DebugManager::PickVertex(uint32_t eventID, const MeshDisplay &cfg,
   }
 
   // unpack and linearise the data
+  if(upload)
   {
     FloatVector *vbData = new FloatVector[cfg.position.numVerts];
 
@@ -2687,6 +2676,8 @@ uint32_t D3D12DebugManager::PickVertex(uint32_t eventID, const MeshDisplay &cfg,
     FillBuffer(m_PickVB, 0, vbData, sizeof(Vec4f) * cfg.position.numVerts);
 
     delete[] vbData;
+
+    m_PickCache.Set(eventID, cfg.position);
   }
 
   ID3D12GraphicsCommandList *list = m_WrappedDevice->GetNewList();
@@ -3171,9 +3162,16 @@ void D3D12DebugManager::BuildShader(string source, string entry, const uint32_t
       return;
   }
 
+  // user shaders tend to be rebuilt with the same source every session, so they go through the
+  // on-disk cache too. The key covers the source, entry point, profile and flags.
+  bool cacheShaders = m_CacheShaders;
+  m_CacheShaders = true;
+
   ID3DBlob *blob = NULL;
   *errors = GetShaderBlob(source.c_str(), entry.c_str(), compileFlags, profile, &blob);
 
+  m_CacheShaders = cacheShaders;
+
   if(blob == NULL)
   {
     *id = ResourceId();
@@ -3776,6 +3774,89 @@ void D3D12DebugManager::InitPostVSBuffers(uint32_t eventID)
   if(m_PostVSAlias.find(eventID) != m_PostVSAlias.end())
     eventID = m_PostVSAlias[eventID];
 
+  if(m_PostVSCache.Lookup(eventID))
+    return;
+
+  CreatePostVSBuffers(eventID);
+
+  auto it = m_PostVSData.find(eventID);
+  if(it == m_PostVSData.end())
+    return;
+
+  ID3D12Resource *bufs[] = {it->second.vsout.buf, it->second.vsout.idxBuf, it->second.gsout.buf,
+                            it->second.gsout.idxBuf};
+
+  uint64_t size = 0;
+
+  for(size_t i = 0; i < ARRAY_COUNT(bufs); i++)
+    if(bufs[i])
+      size += bufs[i]->GetDesc().Width;
+
+  m_PostVSCache.Insert(eventID, size);
+}
+
+void D3D12DebugManager::TrimPostVSCache(uint32_t eventID)
+{
+  if(m_PostVSAlias.find(eventID) != m_PostVSAlias.end())
+    eventID = m_PostVSAlias[eventID];
+
+  std::vector<uint32_t> evicted = m_PostVSCache.Trim(eventID);
+
+  for(size_t i = 0; i < evicted.size(); i++)
+  {
+    D3D12PostVSData &postvs = m_PostVSData[evicted[i]];
+
+    SAFE_RELEASE(postvs.vsout.buf);
+    SAFE_RELEASE(postvs.vsout.idxBuf);
+    SAFE_RELEASE(postvs.gsout.buf);
+    SAFE_RELEASE(postvs.gsout.idxBuf);
+
+    m_PostVSData.erase(evicted[i]);
+  }
+}
+
+uint64_t D3D12DebugManager::GetResourcesSize(ID3D12Resource *const *resources, size_t count,
+                                             uint64_t &num)
+{
+  uint64_t ret = 0;
+
+  for(size_t i = 0; i < count; i++)
+  {
+    if(resources[i] == NULL)
+      continue;
+
+    D3D12_RESOURCE_DESC desc = resources[i]->GetDesc();
+    ret += m_WrappedDevice->GetResourceAllocationInfo(0, 1, &desc).SizeInBytes;
+    num++;
+  }
+
+  return ret;
+}
+
+void D3D12DebugManager::GetMemoryUsage(vector<MemoryUsage> &usage)
+{
+  usage.push_back(MakeMemoryUsage("Post-VS data", true, m_PostVSCache.NumEvents(),
+                                  m_PostVSCache.GetStats().bytes));
+
+  uint64_t count = 0;
+  ID3D12Resource *overlays[] = {m_OverlayRenderTex, m_CustomShaderTex};
+  uint64_t bytes = GetResourcesSize(overlays, ARRAY_COUNT(overlays), count);
+  usage.push_back(MakeMemoryUsage("Overlays", true, count, bytes));
+
+  count = 0;
+  ID3D12Resource *readback[] = {m_ReadbackBuffer, m_PickPixelTex, m_MinMaxResultBuffer,
+                                m_MinMaxTileBuffer, m_PickResultBuf};
+  bytes = GetResourcesSize(readback, ARRAY_COUNT(readback), count);
+  usage.push_back(MakeMemoryUsage("Readback", true, count, bytes));
+
+  count = 0;
+  ID3D12Resource *mesh[] = {m_SOBuffer, m_SOStagingBuffer, m_SOPatchedIndexBuffer, m_PickVB};
+  bytes = GetResourcesSize(mesh, ARRAY_COUNT(mesh), count);
+  usage.push_back(MakeMemoryUsage("Mesh data", true, count, bytes));
+}
+
+void D3D12DebugManager::CreatePostVSBuffers(uint32_t eventID)
+{
   if(m_PostVSData.find(eventID) != m_PostVSData.end())
     return;
 
@@ -25,6 +25,7 @@
 #pragma once
 
 #include "api/replay/renderdoc_replay.h"
+#include "common/shader_cache.h"
 #include "core/core.h"
 #include "driver/shaders/dxbc/dxbc_debug.h"
 #include "replay/replay_driver.h"
@@ -90,12 +91,17 @@ public:
   void PickPixel(ResourceId texture, uint32_t x, uint32_t y, uint32_t sliceFace, uint32_t mip,
                  uint32_t sample, CompType typeHint, float pixel[4]);
   uint32_t PickVertex(uint32_t eventID, const MeshDisplay &cfg, uint32_t x, uint32_t y);
+  void InvalidatePickCache() { m_PickCache.Invalidate(); }
 
   void FillCBufferVariables(const vector<DXBC::CBufferVariable> &invars,
                             vector<ShaderVariable> &outvars, bool flattenVec4s,
                             const vector<byte> &data);
 
   void InitPostVSBuffers(uint32_t eventID);
+  // free the least recently used post-VS data if it's over budget, other than eventID's
+  void TrimPostVSCache(uint32_t eventID);
+  // estimated GPU memory used for post-VS data, overlays, readback and mesh display
+  void GetMemoryUsage(vector<MemoryUsage> &usage);
 
   // indicates that EID alias is the same as eventID
   void AliasPostVSBuffers(uint32_t eventID, uint32_t alias) { m_PostVSAlias[alias] = eventID; }
@@ -301,8 +307,8 @@ private:
   static const uint32_t m_ShaderCacheMagic = 0xbaafd1d1;
   static const uint32_t m_ShaderCacheVersion = 1;
 
-  bool m_ShaderCacheDirty, m_CacheShaders;
-  map<uint32_t, ID3DBlob *> m_ShaderCache;
+  bool m_CacheShaders;
+  ShaderCache<ID3DBlob *> m_ShaderCache;
 
   void FillCBufferVariables(const string &prefix, size_t &offset, bool flatten,
                             const vector<DXBC::CBufferVariable> &invars,
@@ -389,6 +395,7 @@ private:
   static const uint32_t m_MaxMeshPicks = 500;
   ID3D12Resource *m_PickVB;
   uint32_t m_PickSize;
+  MeshPickCache m_PickCache;
   ID3D12Resource *m_PickResultBuf;
 
   uint64_t m_SOBufferSize = 128;
@@ -399,6 +406,10 @@ private:
 
   map<uint32_t, D3D12PostVSData> m_PostVSData;
   map<uint32_t, uint32_t> m_PostVSAlias;
+  PostVSCacheTracker m_PostVSCache;
+
+  void CreatePostVSBuffers(uint32_t eventID);
+  uint64_t GetResourcesSize(ID3D12Resource *const *resources, size_t count, uint64_t &num);
 
   ID3D12Resource *m_CustomShaderTex;
   ResourceId m_CustomShaderResourceId;
@@ -26,7 +26,6 @@
 #include "core/core.h"
 #include "driver/dxgi/dxgi_common.h"
 #include "driver/dxgi/dxgi_wrapped.h"
-#include "jpeg-compressor/jpge.h"
 #include "maths/formatpacking.h"
 #include "serialise/string_utils.h"
 #include "d3d12_command_list.h"
@@ -175,6 +174,13 @@ WrappedID3D12Device::WrappedID3D12Device(ID3D12Device *realDevice, D3D12InitPara
   m_pDevice1 = NULL;
   m_pDevice->QueryInterface(__uuidof(ID3D12Device1), (void **)&m_pDevice1);
 
+  m_ReplayPipelineLibrary = NULL;
+  m_ReplayPipelineLibraryInit = false;
+  m_ReplayPipelineLibraryDirty = false;
+
+  m_DeferPipelineCreation = false;
+  m_NextPendingPipeline = 0;
+
   for(size_t i = 0; i < ARRAY_COUNT(m_DescriptorIncrements); i++)
     m_DescriptorIncrements[i] =
         realDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE(i));
@@ -212,6 +218,9 @@ WrappedID3D12Device::WrappedID3D12Device(ID3D12Device *realDevice, D3D12InitPara
   m_GPUSyncHandle = NULL;
   m_GPUSyncCounter = 0;
 
+  m_Adapter3 = NULL;
+  m_Adapter3Queried = false;
+
 #if ENABLED(RDOC_RELEASE)
   const bool debugSerialiser = false;
 #else
@@ -379,6 +388,7 @@ WrappedID3D12Device::~WrappedID3D12Device()
 
   SAFE_DELETE(m_ResourceManager);
 
+  SAFE_RELEASE(m_ReplayPipelineLibrary);
   SAFE_RELEASE(m_pDevice1);
 
   SAFE_RELEASE(m_pInfoQueue);
@@ -1178,9 +1188,16 @@ HRESULT WrappedID3D12Device::Present(WrappedIDXGISwapChain4 *swap, UINT SyncInte
 
   RenderDoc::Inst().SetCurrentDriver(RDC_D3D12);
 
-  // kill any current capture that isn't application defined
+  // kill any current capture that isn't application defined, unless it's set to record more
+  // frames, in which case just mark where this one ended
   if(m_State == WRITING_CAPFRAME && !m_AppControlledCapture)
-    RenderDoc::Inst().EndFrameCapture((ID3D12Device *)this, swapdesc.OutputWindow);
+  {
+    if(RenderDoc::Inst().ShouldContinueFrameCapture())
+      AddFrameBoundary(
+          (ID3D12Resource *)swap->GetBackbuffers()[m_SwapChains[swap].lastPresentedBuffer]);
+    else
+      RenderDoc::Inst().EndFrameCapture((ID3D12Device *)this, swapdesc.OutputWindow);
+  }
 
   if(RenderDoc::Inst().ShouldTriggerCapture(m_FrameCounter) && m_State == WRITING_IDLE)
   {
@@ -1272,6 +1289,25 @@ void WrappedID3D12Device::EndCaptureFrame(ID3D12Resource *presentImage)
   m_FrameCaptureRecord->AddChunk(scope.Get());
 }
 
+void WrappedID3D12Device::AddFrameBoundary(ID3D12Resource *presentImage)
+{
+  SCOPED_LOCK(m_CapTransitionLock);
+
+  if(m_State != WRITING_CAPFRAME)
+    return;
+
+  GetResourceManager()->MarkResourceFrameReferenced(GetResID(presentImage), eFrameRef_Read);
+
+  // must use main serialiser here to match resource manager
+  Serialiser *localSerialiser = GetMainSerialiser();
+
+  SCOPED_SERIALISE_CONTEXT(CONTEXT_FRAME_BOUNDARY);
+
+  SERIALISE_ELEMENT(ResourceId, bbid, GetResID(presentImage));
+
+  m_FrameCaptureRecord->AddChunk(scope.Get());
+}
+
 void WrappedID3D12Device::StartFrameCapture(void *dev, void *wnd)
 {
   if(m_State != WRITING_IDLE)
@@ -1305,13 +1341,14 @@ void WrappedID3D12Device::StartFrameCapture(void *dev, void *wnd)
     initStateCurBatch = 0;
     initStateCurList = NULL;
 
+    GetResourceManager()->BeginInitialStateReadback();
+
     GetResourceManager()->PrepareInitialContents();
 
-    // close the final list
-    initStateCurList->Close();
+    GetResourceManager()->EndInitialStateReadback();
 
-    initStateCurBatch = 0;
-    initStateCurList = NULL;
+    // close the final list
+    CloseInitialStateList();
 
     ExecuteLists();
     FlushLists();
@@ -1581,30 +1618,9 @@ bool WrappedID3D12Device::EndFrameCapture(void *dev, void *wnd)
       }
     }
 
-    byte *jpgbuf = NULL;
-    int len = thwidth * thheight;
-
-    if(wnd && thpixels)
-    {
-      jpgbuf = new byte[len];
-
-      jpge::params p;
-      p.m_quality = 80;
-
-      bool success = jpge::compress_image_to_jpeg_file_in_memory(jpgbuf, len, thwidth, thheight, 3,
-                                                                 thpixels, p);
-
-      if(!success)
-      {
-        RDCERR("Failed to compress to jpg");
-        SAFE_DELETE_ARRAY(jpgbuf);
-        thwidth = 0;
-        thheight = 0;
-      }
-    }
-
-    m_pFileSerialiser = RenderDoc::Inst().OpenWriteSerialiser(m_FrameCounter, &m_InitParams, jpgbuf,
-                                                              len, thwidth, thheight);
+    // the thumbnail is JPEG encoded when the capture is written, off this thread if possible
+    m_pFileSerialiser = RenderDoc::Inst().OpenWriteSerialiser(m_FrameCounter, &m_InitParams,
+                                                              thpixels, thwidth, thheight);
 
     queues = m_Queues;
 
@@ -1645,7 +1661,7 @@ bool WrappedID3D12Device::EndFrameCapture(void *dev, void *wnd)
   // in capframe (the transition is thread-protected) so nothing will be
   // pushed to the vector
 
-  map<int32_t, Chunk *> recordlist;
+  ChunkList recordlist;
 
   for(auto it = queues.begin(); it != queues.end(); ++it)
   {
@@ -1674,6 +1690,8 @@ bool WrappedID3D12Device::EndFrameCapture(void *dev, void *wnd)
   {
     m_FrameCaptureRecord->Insert(recordlist);
 
+    SortChunkList(recordlist);
+
     RDCDEBUG("Flushing %u chunks to file serialiser from context record",
              (uint32_t)recordlist.size());
 
@@ -1683,11 +1701,8 @@ bool WrappedID3D12Device::EndFrameCapture(void *dev, void *wnd)
     RDCDEBUG("Done");
   }
 
-  m_pFileSerialiser->FlushToDisk();
-
-  RenderDoc::Inst().SuccessfullyWrittenLog(m_FrameCounter);
+  RenderDoc::Inst().FinishWriteSerialiser(m_pFileSerialiser, m_FrameCounter);
 
-  SAFE_DELETE(m_pFileSerialiser);
   SAFE_DELETE(m_HeaderChunk);
 
   m_State = WRITING_IDLE;
@@ -2079,6 +2094,50 @@ void WrappedID3D12Device::DestroyInternalResources()
   SAFE_RELEASE(m_Alloc);
   SAFE_RELEASE(m_GPUSyncFence);
   CloseHandle(m_GPUSyncHandle);
+
+  SAFE_RELEASE(m_Adapter3);
+}
+
+bool WrappedID3D12Device::QueryVideoMemoryInfo(DXGI_MEMORY_SEGMENT_GROUP group,
+                                               DXGI_QUERY_VIDEO_MEMORY_INFO &info)
+{
+  if(!m_Adapter3Queried)
+  {
+    m_Adapter3Queried = true;
+
+    typedef HRESULT(WINAPI * PFN_CREATE_DXGI_FACTORY)(REFIID, void **);
+
+    HMODULE dxgi = GetModuleHandleA("dxgi.dll");
+    PFN_CREATE_DXGI_FACTORY createFunc =
+        dxgi ? (PFN_CREATE_DXGI_FACTORY)GetProcAddress(dxgi, "CreateDXGIFactory1") : NULL;
+
+    IDXGIFactory4 *factory = NULL;
+    HRESULT hr = E_NOINTERFACE;
+
+    if(createFunc)
+      hr = createFunc(__uuidof(IDXGIFactory4), (void **)&factory);
+
+    if(SUCCEEDED(hr) && factory)
+      hr = factory->EnumAdapterByLuid(m_pDevice->GetAdapterLuid(), __uuidof(IDXGIAdapter3),
+                                      (void **)&m_Adapter3);
+
+    SAFE_RELEASE(factory);
+
+    if(FAILED(hr) || m_Adapter3 == NULL)
+    {
+      RDCWARN("Couldn't get IDXGIAdapter3 to query memory budgets: 0x%08x", hr);
+      m_Adapter3 = NULL;
+    }
+  }
+
+  if(m_Adapter3 == NULL)
+    return false;
+
+  RDCEraseEl(info);
+
+  HRESULT hr = m_Adapter3->QueryVideoMemoryInfo(0, group, &info);
+
+  return SUCCEEDED(hr);
 }
 
 void WrappedID3D12Device::GPUSync(ID3D12CommandQueue *queue, ID3D12Fence *fence)
@@ -2147,6 +2206,9 @@ ID3D12GraphicsCommandList *WrappedID3D12Device::GetInitialStateList()
 
 void WrappedID3D12Device::CloseInitialStateList()
 {
+  if(initStateCurList == NULL)
+    return;
+
   initStateCurList->Close();
   initStateCurList = NULL;
   initStateCurBatch = 0;
@@ -2306,8 +2368,6 @@ void WrappedID3D12Device::ReadLogInitialisation()
 {
   uint64_t frameOffset = 0;
 
-  m_pSerialiser->SetDebugText(true);
-
   m_pSerialiser->Rewind();
 
   int chunkIdx = 0;
@@ -2324,6 +2384,9 @@ void WrappedID3D12Device::ReadLogInitialisation()
 
   SCOPED_TIMER("chunk initialisation");
 
+  m_DeferPipelineCreation = RenderDoc::Inst().GetConfigSetting("replay.parallelPipelines") != "0" &&
+                            Threading::GetCPUCount() > 1;
+
   for(;;)
   {
     PerformanceTimer timer;
@@ -2332,8 +2395,14 @@ void WrappedID3D12Device::ReadLogInitialisation()
 
     D3D12ChunkType context = (D3D12ChunkType)m_pSerialiser->PushContext(NULL, NULL, 1, false);
 
+    // names and releases refer to pipelines by ID, and the frame uses them
+    if(context == SET_RESOURCE_NAME || context == RELEASE_RESOURCE || context == CAPTURE_SCOPE)
+      FlushPendingPipelines();
+
     if(context == CAPTURE_SCOPE)
     {
+      m_DeferPipelineCreation = false;
+
       // immediately read rest of log into memory
       m_pSerialiser->SetPersistentBlock(offset);
     }
@@ -2352,6 +2421,9 @@ void WrappedID3D12Device::ReadLogInitialisation()
 
       ApplyInitialContents();
 
+      // only the chunks in the frame are shown as events, so start generating debug text here
+      m_pSerialiser->SetDebugText(true);
+
       m_Queue->ReplayLog(READING, 0, 0, false);
     }
 
@@ -2407,11 +2479,292 @@ void WrappedID3D12Device::ReadLogInitialisation()
   m_FrameRecord.frameInfo.compressedFileSize = m_pSerialiser->GetFileSize();
   m_FrameRecord.frameInfo.persistentSize = m_pSerialiser->GetSize() - frameOffset;
   m_FrameRecord.frameInfo.initDataSize = chunkInfos[(D3D12ChunkType)INITIAL_CONTENTS].totalsize;
+  m_FrameRecord.frameInfo.queueSubmissions = m_Queue->GetQueueSubmissions();
 
   RDCDEBUG("Allocating %llu persistant bytes of memory for the log.",
            m_pSerialiser->GetSize() - frameOffset);
 
+  FlushPendingPipelines();
+  m_DeferPipelineCreation = false;
+
   m_pSerialiser->SetDebugText(false);
+
+  SaveReplayPipelineLibrary();
+}
+
+void WrappedID3D12Device::CreatePendingPipeline(PendingPipeline &pending)
+{
+  pending.pipe = NULL;
+
+  if(pending.compute)
+    pending.hr = CreateReplayPipelineState(pending.id, pending.computeDesc, &pending.pipe);
+  else
+    pending.hr = CreateReplayPipelineState(pending.id, pending.graphicsDesc, &pending.pipe);
+}
+
+void WrappedID3D12Device::FinishPendingPipeline(PendingPipeline &pending)
+{
+  if(FAILED(pending.hr))
+  {
+    RDCERR("Failed on resource serialise-creation, HRESULT: 0x%08x", pending.hr);
+    return;
+  }
+
+  WrappedID3D12PipelineState *wrapped = new WrappedID3D12PipelineState(pending.pipe, this);
+
+  if(pending.compute)
+  {
+    wrapped->compute = new D3D12_COMPUTE_PIPELINE_STATE_DESC(pending.computeDesc);
+
+    wrapped->compute->pRootSignature =
+        (ID3D12RootSignature *)GetResourceManager()->GetWrapper(wrapped->compute->pRootSignature);
+
+    wrapped->compute->CS.pShaderBytecode =
+        WrappedID3D12Shader::AddShader(wrapped->compute->CS, this, wrapped);
+  }
+  else
+  {
+    wrapped->graphics = new D3D12_GRAPHICS_PIPELINE_STATE_DESC(pending.graphicsDesc);
+
+    wrapped->graphics->pRootSignature =
+        (ID3D12RootSignature *)GetResourceManager()->GetWrapper(wrapped->graphics->pRootSignature);
+
+    D3D12_SHADER_BYTECODE *shaders[] = {
+        &wrapped->graphics->VS, &wrapped->graphics->HS, &wrapped->graphics->DS,
+        &wrapped->graphics->GS, &wrapped->graphics->PS,
+    };
+
+    for(size_t i = 0; i < ARRAY_COUNT(shaders); i++)
+    {
+      if(shaders[i]->BytecodeLength == 0)
+        shaders[i]->pShaderBytecode = NULL;
+      else
+        shaders[i]->pShaderBytecode = WrappedID3D12Shader::AddShader(*shaders[i], this, wrapped);
+    }
+  }
+
+  GetResourceManager()->AddLiveResource(pending.id, (ID3D12PipelineState *)wrapped);
+}
+
+void WrappedID3D12Device::QueuePendingPipeline(const PendingPipeline &pending)
+{
+  // make sure the library is created on this thread before any workers use it
+  GetReplayPipelineLibrary();
+
+  if(!m_DeferPipelineCreation)
+  {
+    PendingPipeline immediate = pending;
+    CreatePendingPipeline(immediate);
+    FinishPendingPipeline(immediate);
+    return;
+  }
+
+  m_PendingPipelines.push_back(pending);
+
+  if(m_PendingPipelines.size() >= PendingPipelineBatchSize)
+    FlushPendingPipelines();
+}
+
+void WrappedID3D12Device::PendingPipelineWorker(void *ths)
+{
+  WrappedID3D12Device *device = (WrappedID3D12Device *)ths;
+
+  for(;;)
+  {
+    int32_t idx = Atomic::Inc32(&device->m_NextPendingPipeline) - 1;
+
+    if(idx >= (int32_t)device->m_PendingPipelines.size())
+      break;
+
+    device->CreatePendingPipeline(device->m_PendingPipelines[idx]);
+  }
+}
+
+void WrappedID3D12Device::FlushPendingPipelines()
+{
+  if(m_PendingPipelines.empty())
+    return;
+
+  m_NextPendingPipeline = 0;
+
+  uint32_t numThreads = RDCMIN(Threading::GetCPUCount(), (uint32_t)m_PendingPipelines.size());
+
+  std::vector<Threading::ThreadHandle> threads;
+
+  // this thread works too
+  for(uint32_t i = 1; i < numThreads; i++)
+  {
+    Threading::ThreadHandle t =
+        Threading::CreateThread(&WrappedID3D12Device::PendingPipelineWorker, this);
+    if(t)
+      threads.push_back(t);
+  }
+
+  PendingPipelineWorker(this);
+
+  for(size_t i = 0; i < threads.size(); i++)
+  {
+    Threading::JoinThread(threads[i]);
+    Threading::CloseThread(threads[i]);
+  }
+
+  for(size_t i = 0; i < m_PendingPipelines.size(); i++)
+    FinishPendingPipeline(m_PendingPipelines[i]);
+
+  m_PendingPipelines.clear();
+}
+
+string WrappedID3D12Device::GetReplayPipelineLibraryFilename()
+{
+  const string &filename = m_pSerialiser->GetFilename();
+
+  // identify the capture by its path, size and modification time
+  uint32_t captureHash = strhash(filename.c_str());
+  uint64_t fileSize = m_pSerialiser->GetFileSize();
+  uint64_t timestamp = FileIO::GetModifiedTimestamp(filename);
+  captureHash = strhash(StringFormat::Fmt("%llu_%llu", fileSize, timestamp).c_str(), captureHash);
+
+  return FileIO::GetAppFolderFilename(StringFormat::Fmt("d3d12pipelib_%08x.bin", captureHash));
+}
+
+ID3D12PipelineLibrary *WrappedID3D12Device::GetReplayPipelineLibrary()
+{
+  if(m_ReplayPipelineLibraryInit)
+    return m_ReplayPipelineLibrary;
+
+  m_ReplayPipelineLibraryInit = true;
+
+  if(m_pDevice1 == NULL || RenderDoc::Inst().GetConfigSetting("replay.pipelineCache") == "0" ||
+     m_pSerialiser->GetFilename().empty())
+    return NULL;
+
+  string filename = GetReplayPipelineLibraryFilename();
+
+  FILE *f = FileIO::fopen(filename.c_str(), "rb");
+
+  if(f)
+  {
+    FileIO::fseek64(f, 0, SEEK_END);
+    m_ReplayPipelineLibraryBlob.resize((size_t)FileIO::ftell64(f));
+    FileIO::fseek64(f, 0, SEEK_SET);
+
+    if(m_ReplayPipelineLibraryBlob.empty() ||
+       FileIO::fread(&m_ReplayPipelineLibraryBlob[0], 1, m_ReplayPipelineLibraryBlob.size(), f) !=
+           m_ReplayPipelineLibraryBlob.size())
+      m_ReplayPipelineLibraryBlob.clear();
+
+    FileIO::fclose(f);
+  }
+
+  HRESULT hr = E_FAIL;
+
+  if(!m_ReplayPipelineLibraryBlob.empty())
+  {
+    hr = m_pDevice1->CreatePipelineLibrary(&m_ReplayPipelineLibraryBlob[0],
+                                           m_ReplayPipelineLibraryBlob.size(),
+                                           __uuidof(ID3D12PipelineLibrary),
+                                           (void **)&m_ReplayPipelineLibrary);
+
+    if(FAILED(hr))
+    {
+      RDCLOG("Discarding stale replay pipeline library, HRESULT: 0x%08x", hr);
+      m_ReplayPipelineLibraryBlob.clear();
+    }
+  }
+
+  if(FAILED(hr))
+  {
+    hr = m_pDevice1->CreatePipelineLibrary(NULL, 0, __uuidof(ID3D12PipelineLibrary),
+                                           (void **)&m_ReplayPipelineLibrary);
+
+    if(FAILED(hr))
+    {
+      RDCWARN("Couldn't create replay pipeline library, HRESULT: 0x%08x", hr);
+      m_ReplayPipelineLibrary = NULL;
+    }
+  }
+
+  return m_ReplayPipelineLibrary;
+}
+
+void WrappedID3D12Device::SaveReplayPipelineLibrary()
+{
+  if(m_ReplayPipelineLibrary == NULL || !m_ReplayPipelineLibraryDirty)
+    return;
+
+  SIZE_T size = m_ReplayPipelineLibrary->GetSerializedSize();
+
+  if(size == 0)
+    return;
+
+  std::vector<byte> data(size);
+  HRESULT hr = m_ReplayPipelineLibrary->Serialize(&data[0], size);
+
+  if(FAILED(hr))
+  {
+    RDCWARN("Couldn't serialize replay pipeline library, HRESULT: 0x%08x", hr);
+    return;
+  }
+
+  string filename = GetReplayPipelineLibraryFilename();
+
+  FILE *f = FileIO::fopen(filename.c_str(), "wb");
+
+  if(!f)
+  {
+    RDCWARN("Couldn't open replay pipeline library '%s' for write", filename.c_str());
+    return;
+  }
+
+  FileIO::fwrite(&data[0], 1, size, f);
+  FileIO::fclose(f);
+
+  m_ReplayPipelineLibraryDirty = false;
+
+  RDCLOG("Saved %llu bytes of replay pipeline library", (uint64_t)size);
+}
+
+HRESULT WrappedID3D12Device::CreateReplayPipelineState(ResourceId id,
+                                                      const D3D12_GRAPHICS_PIPELINE_STATE_DESC &desc,
+                                                      ID3D12PipelineState **ret)
+{
+  ID3D12PipelineLibrary *lib = GetReplayPipelineLibrary();
+
+  // pipelines are named by their ID, which is stable for a given capture
+  string name = StringFormat::Fmt("pipe_%llu", id);
+  std::wstring wname(name.begin(), name.end());
+
+  if(lib && SUCCEEDED(lib->LoadGraphicsPipeline(wname.c_str(), &desc,
+                                                __uuidof(ID3D12PipelineState), (void **)ret)))
+    return S_OK;
+
+  HRESULT hr = m_pDevice->CreateGraphicsPipelineState(&desc, __uuidof(ID3D12PipelineState), (void **)ret);
+
+  if(SUCCEEDED(hr) && lib && SUCCEEDED(lib->StorePipeline(wname.c_str(), *ret)))
+    m_ReplayPipelineLibraryDirty = true;
+
+  return hr;
+}
+
+HRESULT WrappedID3D12Device::CreateReplayPipelineState(ResourceId id,
+                                                      const D3D12_COMPUTE_PIPELINE_STATE_DESC &desc,
+                                                      ID3D12PipelineState **ret)
+{
+  ID3D12PipelineLibrary *lib = GetReplayPipelineLibrary();
+
+  string name = StringFormat::Fmt("pipe_%llu", id);
+  std::wstring wname(name.begin(), name.end());
+
+  if(lib && SUCCEEDED(lib->LoadComputePipeline(wname.c_str(), &desc,
+                                               __uuidof(ID3D12PipelineState), (void **)ret)))
+    return S_OK;
+
+  HRESULT hr = m_pDevice->CreateComputePipelineState(&desc, __uuidof(ID3D12PipelineState), (void **)ret);
+
+  if(SUCCEEDED(hr) && lib && SUCCEEDED(lib->StorePipeline(wname.c_str(), *ret)))
+    m_ReplayPipelineLibraryDirty = true;
+
+  return hr;
 }
 
 void WrappedID3D12Device::ReplayLog(uint32_t startEventID, uint32_t endEventID,
@@ -225,6 +225,46 @@ private:
   ID3D12Device *m_pDevice;
   ID3D12Device1 *m_pDevice1;
 
+  // on replay, pipelines are stored in a pipeline library saved in the app folder, keyed by the
+  // capture, so re-opening the same capture is faster. The runtime rejects libraries from another
+  // driver or adapter, in which case it starts again empty. The blob must outlive the library.
+  ID3D12PipelineLibrary *m_ReplayPipelineLibrary;
+  bool m_ReplayPipelineLibraryInit;
+  bool m_ReplayPipelineLibraryDirty;
+  std::vector<byte> m_ReplayPipelineLibraryBlob;
+
+  string GetReplayPipelineLibraryFilename();
+  ID3D12PipelineLibrary *GetReplayPipelineLibrary();
+  void SaveReplayPipelineLibrary();
+  HRESULT CreateReplayPipelineState(ResourceId id, const D3D12_GRAPHICS_PIPELINE_STATE_DESC &desc,
+                                    ID3D12PipelineState **ret);
+  HRESULT CreateReplayPipelineState(ResourceId id, const D3D12_COMPUTE_PIPELINE_STATE_DESC &desc,
+                                    ID3D12PipelineState **ret);
+
+  // while loading, pipeline creation chunks are queued and the pipelines created in parallel on
+  // worker threads. The queue is flushed, in order, before any chunk that can refer to a pipeline.
+  struct PendingPipeline
+  {
+    ResourceId id;
+    bool compute;
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC graphicsDesc;
+    D3D12_COMPUTE_PIPELINE_STATE_DESC computeDesc;
+    ID3D12PipelineState *pipe;
+    HRESULT hr;
+  };
+
+  static const size_t PendingPipelineBatchSize = 512;
+
+  bool m_DeferPipelineCreation;
+  std::vector<PendingPipeline> m_PendingPipelines;
+  int32_t m_NextPendingPipeline;
+
+  static void PendingPipelineWorker(void *ths);
+  void CreatePendingPipeline(PendingPipeline &pending);
+  void FinishPendingPipeline(PendingPipeline &pending);
+  void QueuePendingPipeline(const PendingPipeline &pending);
+  void FlushPendingPipelines();
+
   // list of all queues being captured
   std::vector<WrappedID3D12CommandQueue *> m_Queues;
   std::vector<ID3D12Fence *> m_QueueFences;
@@ -238,6 +278,10 @@ private:
   HANDLE m_GPUSyncHandle;
   UINT64 m_GPUSyncCounter;
 
+  // the adapter this device was created on, fetched on first use to query memory budgets
+  IDXGIAdapter3 *m_Adapter3;
+  bool m_Adapter3Queried;
+
   void CreateInternalResources();
   void DestroyInternalResources();
 
@@ -338,6 +382,7 @@ private:
 
   void Serialise_CaptureScope(uint64_t offset);
   void EndCaptureFrame(ID3D12Resource *presentImage);
+  void AddFrameBoundary(ID3D12Resource *presentImage);
 
 public:
   static const int AllocPoolCount = 4;
@@ -382,6 +427,7 @@ public:
   D3D12Replay *GetReplay() { return &m_Replay; }
   WrappedID3D12CommandQueue *GetQueue() { return m_Queue; }
   ID3D12CommandAllocator *GetAlloc() { return m_Alloc; }
+  bool QueryVideoMemoryInfo(DXGI_MEMORY_SEGMENT_GROUP group, DXGI_QUERY_VIDEO_MEMORY_INFO &info);
   void ApplyBarriers(vector<D3D12_RESOURCE_BARRIER> &barriers);
 
   void GetDynamicDescriptorReferences(std::vector<D3D12Descriptor> &refs)
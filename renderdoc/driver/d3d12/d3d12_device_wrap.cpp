@@ -245,39 +245,12 @@ bool WrappedID3D12Device::Serialise_CreateGraphicsPipelineState(
 
   if(m_State == READING)
   {
-    ID3D12PipelineState *ret = NULL;
-    HRESULT hr = m_pDevice->CreateGraphicsPipelineState(&Descriptor, guid, (void **)&ret);
+    PendingPipeline pending;
+    pending.id = Pipe;
+    pending.compute = false;
+    pending.graphicsDesc = Descriptor;
 
-    if(FAILED(hr))
-    {
-      RDCERR("Failed on resource serialise-creation, HRESULT: 0x%08x", hr);
-    }
-    else
-    {
-      ret = new WrappedID3D12PipelineState(ret, this);
-
-      WrappedID3D12PipelineState *wrapped = (WrappedID3D12PipelineState *)ret;
-
-      wrapped->graphics = new D3D12_GRAPHICS_PIPELINE_STATE_DESC(Descriptor);
-
-      wrapped->graphics->pRootSignature =
-          (ID3D12RootSignature *)GetResourceManager()->GetWrapper(wrapped->graphics->pRootSignature);
-
-      D3D12_SHADER_BYTECODE *shaders[] = {
-          &wrapped->graphics->VS, &wrapped->graphics->HS, &wrapped->graphics->DS,
-          &wrapped->graphics->GS, &wrapped->graphics->PS,
-      };
-
-      for(size_t i = 0; i < ARRAY_COUNT(shaders); i++)
-      {
-        if(shaders[i]->BytecodeLength == 0)
-          shaders[i]->pShaderBytecode = NULL;
-        else
-          shaders[i]->pShaderBytecode = WrappedID3D12Shader::AddShader(*shaders[i], this, wrapped);
-      }
-
-      GetResourceManager()->AddLiveResource(Pipe, ret);
-    }
+    QueuePendingPipeline(pending);
   }
 
   return true;
@@ -355,28 +328,12 @@ bool WrappedID3D12Device::Serialise_CreateComputePipelineState(
 
   if(m_State == READING)
   {
-    ID3D12PipelineState *ret = NULL;
-    HRESULT hr = m_pDevice->CreateComputePipelineState(&Descriptor, guid, (void **)&ret);
-
-    if(FAILED(hr))
-    {
-      RDCERR("Failed on resource serialise-creation, HRESULT: 0x%08x", hr);
-    }
-    else
-    {
-      WrappedID3D12PipelineState *wrapped = new WrappedID3D12PipelineState(ret, this);
-      ret = wrapped;
-
-      wrapped->compute = new D3D12_COMPUTE_PIPELINE_STATE_DESC(Descriptor);
+    PendingPipeline pending;
+    pending.id = Pipe;
+    pending.compute = true;
+    pending.computeDesc = Descriptor;
 
-      wrapped->compute->pRootSignature =
-          (ID3D12RootSignature *)GetResourceManager()->GetWrapper(wrapped->compute->pRootSignature);
-
-      wrapped->compute->CS.pShaderBytecode =
-          WrappedID3D12Shader::AddShader(wrapped->compute->CS, this, wrapped);
-
-      GetResourceManager()->AddLiveResource(Pipe, ret);
-    }
+    QueuePendingPipeline(pending);
   }
 
   return true;
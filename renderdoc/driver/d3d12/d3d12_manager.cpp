@@ -35,6 +35,8 @@ void D3D12Descriptor::Init(const D3D12_SAMPLER_DESC *pDesc)
     samp.desc = *pDesc;
   else
     RDCEraseEl(samp.desc);
+
+  MarkWritten();
 }
 
 void D3D12Descriptor::Init(const D3D12_CONSTANT_BUFFER_VIEW_DESC *pDesc)
@@ -45,6 +47,8 @@ void D3D12Descriptor::Init(const D3D12_CONSTANT_BUFFER_VIEW_DESC *pDesc)
     nonsamp.cbv = *pDesc;
   else
     RDCEraseEl(nonsamp.cbv);
+
+  MarkWritten();
 }
 
 void D3D12Descriptor::Init(ID3D12Resource *pResource, const D3D12_SHADER_RESOURCE_VIEW_DESC *pDesc)
@@ -55,6 +59,8 @@ void D3D12Descriptor::Init(ID3D12Resource *pResource, const D3D12_SHADER_RESOURC
     nonsamp.srv = *pDesc;
   else
     RDCEraseEl(nonsamp.srv);
+
+  MarkWritten();
 }
 
 void D3D12Descriptor::Init(ID3D12Resource *pResource, ID3D12Resource *pCounterResource,
@@ -67,6 +73,8 @@ void D3D12Descriptor::Init(ID3D12Resource *pResource, ID3D12Resource *pCounterRe
     nonsamp.uav.desc.Init(*pDesc);
   else
     RDCEraseEl(nonsamp.uav.desc);
+
+  MarkWritten();
 }
 
 void D3D12Descriptor::Init(ID3D12Resource *pResource, const D3D12_RENDER_TARGET_VIEW_DESC *pDesc)
@@ -77,6 +85,8 @@ void D3D12Descriptor::Init(ID3D12Resource *pResource, const D3D12_RENDER_TARGET_
     nonsamp.rtv = *pDesc;
   else
     RDCEraseEl(nonsamp.rtv);
+
+  MarkWritten();
 }
 
 void D3D12Descriptor::Init(ID3D12Resource *pResource, const D3D12_DEPTH_STENCIL_VIEW_DESC *pDesc)
@@ -87,6 +97,8 @@ void D3D12Descriptor::Init(ID3D12Resource *pResource, const D3D12_DEPTH_STENCIL_
     nonsamp.dsv = *pDesc;
   else
     RDCEraseEl(nonsamp.dsv);
+
+  MarkWritten();
 }
 
 // these are used to create NULL descriptors where necessary
@@ -394,6 +406,15 @@ void D3D12Descriptor::CopyFrom(const D3D12Descriptor &src)
 
   samp.heap = heap;
   samp.idx = index;
+
+  MarkWritten();
+}
+
+void D3D12Descriptor::MarkWritten()
+{
+  // descriptors that are being built up on their own, e.g. for pending writes, have no heap
+  if(samp.heap)
+    samp.heap->MarkWritten(samp.idx);
 }
 
 void D3D12Descriptor::GetRefIDs(ResourceId &id, ResourceId &id2, FrameRefType &ref)
@@ -647,6 +668,209 @@ bool D3D12ResourceManager::Need_InitialStateChunk(ID3D12DeviceChild *res)
   return true;
 }
 
+// bounds on the size of each initial state readback buffer. The size is a fraction of the memory
+// budget left when the capture starts, along with a fallback for when the budget can't be queried.
+static const uint64_t InitialStateReadbackMinBatch = 4 * 1024 * 1024;
+static const uint64_t InitialStateReadbackMaxBatch = 128 * 1024 * 1024;
+static const uint64_t InitialStateReadbackDefaultBatch = 32 * 1024 * 1024;
+
+void D3D12ResourceManager::BeginInitialStateReadback()
+{
+  // readback heaps live in system memory on discrete adapters, but an adapter with unified memory
+  // only reports a local segment.
+  DXGI_QUERY_VIDEO_MEMORY_INFO info;
+  bool budgetKnown = m_Device->QueryVideoMemoryInfo(DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL, info);
+
+  if(!budgetKnown || info.Budget == 0)
+    budgetKnown = m_Device->QueryVideoMemoryInfo(DXGI_MEMORY_SEGMENT_GROUP_LOCAL, info);
+
+  if(budgetKnown)
+  {
+    uint64_t available = info.Budget > info.CurrentUsage ? info.Budget - info.CurrentUsage : 0;
+
+    // two buffers are used, and leave plenty of room for the application
+    m_ReadbackBatchSize = available / 8;
+  }
+  else
+  {
+    m_ReadbackBatchSize = InitialStateReadbackDefaultBatch;
+  }
+
+  m_ReadbackBatchSize = RDCCLAMP(m_ReadbackBatchSize, InitialStateReadbackMinBatch,
+                                 InitialStateReadbackMaxBatch);
+  m_ReadbackBatchSize =
+      AlignUp(m_ReadbackBatchSize, (uint64_t)D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+
+  if(m_ReadbackFence == NULL)
+  {
+    HRESULT hr = m_Device->GetReal()->CreateFence(0, D3D12_FENCE_FLAG_NONE, __uuidof(ID3D12Fence),
+                                                  (void **)&m_ReadbackFence);
+
+    if(FAILED(hr))
+    {
+      RDCERR("Couldn't create initial state readback fence: 0x%08x", hr);
+      m_ReadbackFence = NULL;
+    }
+  }
+
+  m_ReadbackActive = (m_ReadbackFence != NULL);
+  m_CurReadbackBatch = 0;
+
+  RDCDEBUG("Reading back initial states in batches of %llu bytes", m_ReadbackBatchSize);
+}
+
+void D3D12ResourceManager::EndInitialStateReadback()
+{
+  ReadbackBatch &cur = m_ReadbackBatches[m_CurReadbackBatch];
+  ReadbackBatch &prev = m_ReadbackBatches[1 - m_CurReadbackBatch];
+
+  SubmitReadbackBatch(cur);
+
+  // the previous batch was submitted first
+  RetireReadbackBatch(prev);
+  RetireReadbackBatch(cur);
+
+  for(size_t i = 0; i < ARRAY_COUNT(m_ReadbackBatches); i++)
+    SAFE_RELEASE(m_ReadbackBatches[i].buffer);
+
+  SAFE_RELEASE(m_ReadbackFence);
+  m_ReadbackFenceValue = 0;
+
+  m_ReadbackActive = false;
+}
+
+ID3D12Resource *D3D12ResourceManager::AllocReadback(ResourceId id, uint64_t size, uint64_t &offset)
+{
+  // resources bigger than a whole batch get their own readback resource
+  if(!m_ReadbackActive || size > m_ReadbackBatchSize)
+    return NULL;
+
+  ReadbackBatch *batch = &m_ReadbackBatches[m_CurReadbackBatch];
+
+  uint64_t start = AlignUp(batch->used, (uint64_t)D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+  if(start + size > m_ReadbackBatchSize)
+  {
+    // this batch is full, so kick off its copies and switch to the other buffer. Its contents are
+    // copied out to make room while the GPU works on the batch just submitted.
+    SubmitReadbackBatch(*batch);
+
+    m_CurReadbackBatch = 1 - m_CurReadbackBatch;
+    batch = &m_ReadbackBatches[m_CurReadbackBatch];
+
+    RetireReadbackBatch(*batch);
+
+    start = 0;
+  }
+
+  if(batch->buffer == NULL)
+  {
+    D3D12_HEAP_PROPERTIES heapProps;
+    heapProps.Type = D3D12_HEAP_TYPE_READBACK;
+    heapProps.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+    heapProps.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+    heapProps.CreationNodeMask = 1;
+    heapProps.VisibleNodeMask = 1;
+
+    D3D12_RESOURCE_DESC bufDesc;
+    bufDesc.Alignment = 0;
+    bufDesc.DepthOrArraySize = 1;
+    bufDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    bufDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+    bufDesc.Format = DXGI_FORMAT_UNKNOWN;
+    bufDesc.Height = 1;
+    bufDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    bufDesc.MipLevels = 1;
+    bufDesc.SampleDesc.Count = 1;
+    bufDesc.SampleDesc.Quality = 0;
+    bufDesc.Width = m_ReadbackBatchSize;
+
+    HRESULT hr = m_Device->GetReal()->CreateCommittedResource(
+        &heapProps, D3D12_HEAP_FLAG_NONE, &bufDesc, D3D12_RESOURCE_STATE_COPY_DEST, NULL,
+        __uuidof(ID3D12Resource), (void **)&batch->buffer);
+
+    if(FAILED(hr))
+    {
+      RDCERR("Couldn't create initial state readback buffer: 0x%08x", hr);
+      batch->buffer = NULL;
+
+      // fall back to a readback resource for each resource
+      m_ReadbackActive = false;
+      return NULL;
+    }
+  }
+
+  ReadbackBatch::Pending pending = {id, start, size};
+  batch->pending.push_back(pending);
+  batch->used = start + size;
+
+  offset = start;
+  return batch->buffer;
+}
+
+void D3D12ResourceManager::SubmitReadbackBatch(ReadbackBatch &batch)
+{
+  if(batch.pending.empty() || batch.fenceValue != 0)
+    return;
+
+  m_Device->CloseInitialStateList();
+  m_Device->ExecuteLists();
+
+  batch.fenceValue = ++m_ReadbackFenceValue;
+
+  HRESULT hr = m_Device->GetQueue()->GetReal()->Signal(m_ReadbackFence, batch.fenceValue);
+  RDCASSERTEQUAL(hr, S_OK);
+}
+
+void D3D12ResourceManager::RetireReadbackBatch(ReadbackBatch &batch)
+{
+  if(batch.pending.empty())
+    return;
+
+  RDCASSERT(batch.fenceValue != 0);
+
+  // a NULL event blocks until the fence is reached
+  if(m_ReadbackFence->GetCompletedValue() < batch.fenceValue)
+    m_ReadbackFence->SetEventOnCompletion(batch.fenceValue, NULL);
+
+  byte *mapped = NULL;
+  D3D12_RANGE range = {0, (SIZE_T)batch.used};
+  HRESULT hr = batch.buffer->Map(0, &range, (void **)&mapped);
+
+  if(FAILED(hr) || mapped == NULL)
+  {
+    RDCERR("Failed to map initial state readback buffer: 0x%08x", hr);
+    mapped = NULL;
+  }
+
+  for(size_t i = 0; i < batch.pending.size(); i++)
+  {
+    const ReadbackBatch::Pending &p = batch.pending[i];
+
+    byte *blob = NULL;
+
+    if(mapped)
+    {
+      blob = Serialiser::AllocAlignedBuffer((size_t)p.size);
+      memcpy(blob, mapped + p.offset, (size_t)p.size);
+    }
+
+    // the size always fits as batches are much smaller than 4GB
+    SetInitialContents(p.id, D3D12ResourceManager::InitialContentData(
+                                 NULL, blob ? (uint32_t)p.size : 0, blob));
+  }
+
+  if(mapped)
+  {
+    D3D12_RANGE written = {0, 0};
+    batch.buffer->Unmap(0, &written);
+  }
+
+  batch.pending.clear();
+  batch.used = 0;
+  batch.fenceValue = 0;
+}
+
 bool D3D12ResourceManager::Prepare_InitialState(ID3D12DeviceChild *res)
 {
   ResourceId id = GetResID(res);
@@ -656,12 +880,26 @@ bool D3D12ResourceManager::Prepare_InitialState(ID3D12DeviceChild *res)
   {
     WrappedID3D12DescriptorHeap *heap = (WrappedID3D12DescriptorHeap *)res;
 
-    UINT numElems = heap->GetDesc().NumDescriptors;
+    // only save the parts of the heap that have ever been written. Anything else is still
+    // undefined, and large bindless heaps are often mostly empty. Each descriptor serialises its
+    // own index so the ranges don't need to be stored separately.
+    std::vector<std::pair<UINT, UINT> > ranges;
+    heap->GetWrittenRanges(ranges);
+
+    UINT numElems = 0;
+    for(size_t i = 0; i < ranges.size(); i++)
+      numElems += ranges[i].second;
 
     D3D12Descriptor *descs =
         (D3D12Descriptor *)Serialiser::AllocAlignedBuffer(sizeof(D3D12Descriptor) * numElems);
 
-    memcpy(descs, heap->GetDescriptors(), sizeof(D3D12Descriptor) * numElems);
+    D3D12Descriptor *dst = descs;
+    for(size_t i = 0; i < ranges.size(); i++)
+    {
+      memcpy(dst, heap->GetDescriptors() + ranges[i].first,
+             sizeof(D3D12Descriptor) * ranges[i].second);
+      dst += ranges[i].second;
+    }
 
     SetInitialContents(heap->GetResourceID(),
                        D3D12ResourceManager::InitialContentData(NULL, numElems, (byte *)descs));
@@ -705,10 +943,16 @@ bool D3D12ResourceManager::Prepare_InitialState(ID3D12DeviceChild *res)
 
       desc.Flags = D3D12_RESOURCE_FLAG_NONE;
 
-      ID3D12Resource *copyDst = NULL;
-      HRESULT hr = m_Device->GetReal()->CreateCommittedResource(
-          &heapProps, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_COPY_DEST, NULL,
-          __uuidof(ID3D12Resource), (void **)&copyDst);
+      uint64_t batchOffset = 0;
+      ID3D12Resource *copyDst = AllocReadback(GetResID(r), desc.Width, batchOffset);
+      bool batched = (copyDst != NULL);
+
+      HRESULT hr = S_OK;
+
+      if(!batched)
+        hr = m_Device->GetReal()->CreateCommittedResource(
+            &heapProps, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_COPY_DEST, NULL,
+            __uuidof(ID3D12Resource), (void **)&copyDst);
 
       if(nonresident)
         m_Device->MakeResident(1, &pageable);
@@ -717,7 +961,10 @@ bool D3D12ResourceManager::Prepare_InitialState(ID3D12DeviceChild *res)
       {
         ID3D12GraphicsCommandList *list = Unwrap(m_Device->GetInitialStateList());
 
-        list->CopyResource(copyDst, r->GetReal());
+        if(batched)
+          list->CopyBufferRegion(copyDst, batchOffset, r->GetReal(), 0, desc.Width);
+        else
+          list->CopyResource(copyDst, r->GetReal());
       }
       else
       {
@@ -734,7 +981,9 @@ bool D3D12ResourceManager::Prepare_InitialState(ID3D12DeviceChild *res)
         m_Device->Evict(1, &pageable);
       }
 
-      SetInitialContents(GetResID(r), D3D12ResourceManager::InitialContentData(copyDst, 0, NULL));
+      // batched contents are filled in once the batch has been read back
+      SetInitialContents(GetResID(r), D3D12ResourceManager::InitialContentData(
+                                          batched ? NULL : copyDst, 0, NULL));
       return true;
     }
     else
@@ -770,10 +1019,24 @@ bool D3D12ResourceManager::Prepare_InitialState(ID3D12DeviceChild *res)
       m_Device->GetCopyableFootprints(&desc, 0, numSubresources, 0, layouts, NULL, NULL,
                                       &bufDesc.Width);
 
-      ID3D12Resource *copyDst = NULL;
-      HRESULT hr = m_Device->GetReal()->CreateCommittedResource(
-          &heapProps, D3D12_HEAP_FLAG_NONE, &bufDesc, D3D12_RESOURCE_STATE_COPY_DEST, NULL,
-          __uuidof(ID3D12Resource), (void **)&copyDst);
+      uint64_t batchOffset = 0;
+      ID3D12Resource *copyDst = AllocReadback(GetResID(r), bufDesc.Width, batchOffset);
+      bool batched = (copyDst != NULL);
+
+      HRESULT hr = S_OK;
+
+      // the layout is the same as in a dedicated buffer, just moved to where this batch entry is
+      if(batched)
+      {
+        for(UINT i = 0; i < numSubresources; i++)
+          layouts[i].Offset += batchOffset;
+      }
+      else
+      {
+        hr = m_Device->GetReal()->CreateCommittedResource(
+            &heapProps, D3D12_HEAP_FLAG_NONE, &bufDesc, D3D12_RESOURCE_STATE_COPY_DEST, NULL,
+            __uuidof(ID3D12Resource), (void **)&copyDst);
+      }
 
       if(nonresident)
         m_Device->MakeResident(1, &pageable);
@@ -847,7 +1110,8 @@ bool D3D12ResourceManager::Prepare_InitialState(ID3D12DeviceChild *res)
 
       SAFE_DELETE_ARRAY(layouts);
 
-      SetInitialContents(GetResID(r), D3D12ResourceManager::InitialContentData(copyDst, 0, NULL));
+      SetInitialContents(GetResID(r), D3D12ResourceManager::InitialContentData(
+                                          batched ? NULL : copyDst, 0, NULL));
       return true;
     }
   }
@@ -881,6 +1145,17 @@ bool D3D12ResourceManager::Serialise_InitialState(ResourceId resid, ID3D12Device
     }
     else if(type == Resource_Resource)
     {
+      if(initContents.blob)
+      {
+        // already read back in a batch when the capture started
+        uint64_t size = initContents.num;
+        m_pSerialiser->Serialise("NumBytes", size);
+        size_t sz = (size_t)size;
+        m_pSerialiser->SerialiseBuffer("BufferData", initContents.blob, sz);
+
+        return true;
+      }
+
       m_Device->ExecuteLists();
       m_Device->FlushLists();
 
@@ -970,16 +1245,45 @@ bool D3D12ResourceManager::Serialise_InitialState(ResourceId resid, ID3D12Device
 
       UINT increment = m_Device->GetDescriptorHandleIncrementSize(desc.Type);
 
+      // only written parts of the heap were saved, so note the ranges to copy when applying
+      std::vector<std::pair<UINT, UINT> > ranges;
+
       for(uint32_t i = 0; i < numElems; i++)
       {
-        descs[i].Create(desc.Type, m_Device, handle);
+        UINT idx = descs[i].samp.idx;
 
-        handle.ptr += increment;
+        if(idx >= desc.NumDescriptors)
+        {
+          RDCERR("Descriptor index %u out of bounds in heap of %u", idx, desc.NumDescriptors);
+          continue;
+        }
+
+        D3D12_CPU_DESCRIPTOR_HANDLE dst = handle;
+        dst.ptr += idx * increment;
+
+        descs[i].Create(desc.Type, m_Device, dst);
+
+        if(!ranges.empty() && ranges.back().first + ranges.back().second == idx)
+          ranges.back().second++;
+        else
+          ranges.push_back(std::make_pair(idx, 1U));
       }
 
       SAFE_DELETE_ARRAY(descs);
 
-      SetInitialContents(id, D3D12ResourceManager::InitialContentData(copyheap, 0, NULL));
+      UINT *rangeData = NULL;
+      if(!ranges.empty())
+      {
+        rangeData = (UINT *)Serialiser::AllocAlignedBuffer(sizeof(UINT) * 2 * ranges.size());
+        for(size_t i = 0; i < ranges.size(); i++)
+        {
+          rangeData[i * 2 + 0] = ranges[i].first;
+          rangeData[i * 2 + 1] = ranges[i].second;
+        }
+      }
+
+      SetInitialContents(id, D3D12ResourceManager::InitialContentData(
+                                 copyheap, (uint32_t)ranges.size(), (byte *)rangeData));
     }
     else if(type == Resource_Resource)
     {
@@ -1086,15 +1390,23 @@ void D3D12ResourceManager::Apply_InitialState(ID3D12DeviceChild *live, InitialCo
 
   if(type == Resource_DescriptorHeap)
   {
-    ID3D12DescriptorHeap *dstheap = (ID3D12DescriptorHeap *)live;
-    ID3D12DescriptorHeap *srcheap = (ID3D12DescriptorHeap *)data.resource;
+    WrappedID3D12DescriptorHeap *dstheap = (WrappedID3D12DescriptorHeap *)live;
+    WrappedID3D12DescriptorHeap *srcheap = (WrappedID3D12DescriptorHeap *)data.resource;
 
     if(srcheap)
     {
-      // copy the whole heap
-      m_Device->CopyDescriptorsSimple(
-          srcheap->GetDesc().NumDescriptors, dstheap->GetCPUDescriptorHandleForHeapStart(),
-          srcheap->GetCPUDescriptorHandleForHeapStart(), srcheap->GetDesc().Type);
+      // copy the ranges that were saved, the rest of the heap was never written
+      const UINT *rangeData = (const UINT *)data.blob;
+      D3D12_DESCRIPTOR_HEAP_TYPE type = srcheap->GetDesc().Type;
+
+      for(uint32_t i = 0; i < data.num; i++)
+      {
+        UINT first = rangeData[i * 2 + 0];
+        UINT count = rangeData[i * 2 + 1];
+
+        m_Device->CopyDescriptorsSimple(count, dstheap->GetDescriptors()[first],
+                                        srcheap->GetDescriptors()[first], type);
+      }
     }
   }
   else if(type == Resource_Resource)
@@ -169,6 +169,9 @@ struct D3D12Descriptor
   void CopyFrom(const D3D12Descriptor &src);
   void GetRefIDs(ResourceId &id, ResourceId &id2, FrameRefType &ref);
 
+  // flag this descriptor's block in its heap as written, if it lives in a heap
+  void MarkWritten();
+
   union
   {
     // keep the sampler outside as it's the largest descriptor
@@ -310,11 +313,13 @@ struct GPUAddressRangeTracker
   GPUAddressRangeTracker &operator=(const GPUAddressRangeTracker &);
 
   std::vector<GPUAddressRange> addresses;
-  Threading::CriticalSection addressLock;
+  // lookups happen on every command that takes a GPU address, from every recording thread, so
+  // they only need to share the lock with each other
+  Threading::RWLock addressLock;
 
   void AddTo(GPUAddressRange range)
   {
-    SCOPED_LOCK(addressLock);
+    SCOPED_WRITELOCK(addressLock);
     auto it = std::lower_bound(addresses.begin(), addresses.end(), range.start);
     RDCASSERT(it == addresses.begin() || it == addresses.end() || range.start < it->start ||
               range.start >= it->end);
@@ -324,7 +329,7 @@ struct GPUAddressRangeTracker
 
   void RemoveFrom(D3D12_GPU_VIRTUAL_ADDRESS baseAddr)
   {
-    SCOPED_LOCK(addressLock);
+    SCOPED_WRITELOCK(addressLock);
     auto it = std::lower_bound(addresses.begin(), addresses.end(), baseAddr);
     RDCASSERT(it != addresses.end() && baseAddr >= it->start && baseAddr < it->end);
 
@@ -341,9 +346,8 @@ struct GPUAddressRangeTracker
 
     GPUAddressRange range;
 
-    // this should really be a read-write lock
     {
-      SCOPED_LOCK(addressLock);
+      SCOPED_READLOCK(addressLock);
 
       auto it = std::lower_bound(addresses.begin(), addresses.end(), addr);
       if(it == addresses.end())
@@ -393,7 +397,7 @@ struct D3D12ResourceRecord : public ResourceRecord
     cmdInfo->bundles.swap(bakedCommands->cmdInfo->bundles);
   }
 
-  void Insert(map<int32_t, Chunk *> &recordlist)
+  void Insert(ChunkList &recordlist)
   {
     bool dataWritten = DataWritten;
 
@@ -408,7 +412,7 @@ struct D3D12ResourceRecord : public ResourceRecord
     }
 
     if(!dataWritten)
-      recordlist.insert(m_Chunks.begin(), m_Chunks.end());
+      recordlist.insert(recordlist.end(), m_Chunks.begin(), m_Chunks.end());
   }
 
   D3D12ResourceType type;
@@ -436,6 +440,18 @@ public:
   D3D12ResourceManager(LogState state, Serialiser *ser, WrappedID3D12Device *dev)
       : ResourceManager(state, ser), m_Device(dev)
   {
+    m_ReadbackActive = false;
+    m_ReadbackBatchSize = 0;
+    m_CurReadbackBatch = 0;
+    m_ReadbackFence = NULL;
+    m_ReadbackFenceValue = 0;
+
+    for(size_t i = 0; i < ARRAY_COUNT(m_ReadbackBatches); i++)
+    {
+      m_ReadbackBatches[i].buffer = NULL;
+      m_ReadbackBatches[i].used = 0;
+      m_ReadbackBatches[i].fenceValue = 0;
+    }
   }
 
   template <class T>
@@ -458,6 +474,13 @@ public:
 
   bool Serialise_InitialState(ResourceId resid, ID3D12DeviceChild *res);
 
+  // resource contents are read back for initial states in batches through a pair of readback
+  // buffers, sized from the adapter's memory budget and reused for every batch. While the GPU copies
+  // one batch the previous one is copied out to CPU memory, so the readback memory allocated stays
+  // bounded however many resources are prepared. Resources prepared between these calls use it.
+  void BeginInitialStateReadback();
+  void EndInitialStateReadback();
+
 private:
   bool SerialisableResource(ResourceId id, D3D12ResourceRecord *record);
   ResourceId GetID(ID3D12DeviceChild *res);
@@ -470,5 +493,31 @@ private:
   void Create_InitialState(ResourceId id, ID3D12DeviceChild *live, bool hasData);
   void Apply_InitialState(ID3D12DeviceChild *live, InitialContentData data);
 
+  struct ReadbackBatch
+  {
+    struct Pending
+    {
+      ResourceId id;
+      uint64_t offset;
+      uint64_t size;
+    };
+
+    ID3D12Resource *buffer;
+    uint64_t used;
+    UINT64 fenceValue;
+    vector<Pending> pending;
+  };
+
+  ID3D12Resource *AllocReadback(ResourceId id, uint64_t size, uint64_t &offset);
+  void SubmitReadbackBatch(ReadbackBatch &batch);
+  void RetireReadbackBatch(ReadbackBatch &batch);
+
+  bool m_ReadbackActive;
+  uint64_t m_ReadbackBatchSize;
+  ReadbackBatch m_ReadbackBatches[2];
+  int m_CurReadbackBatch;
+  ID3D12Fence *m_ReadbackFence;
+  UINT64 m_ReadbackFenceValue;
+
   WrappedID3D12Device *m_Device;
 };
@@ -23,6 +23,7 @@
  ******************************************************************************/
 
 #include "d3d12_replay.h"
+#include "common/profiler.h"
 #include "driver/dx/official/d3dcompiler.h"
 #include "driver/dxgi/dxgi_common.h"
 #include "d3d12_command_queue.h"
@@ -59,6 +60,7 @@ void D3D12Replay::Shutdown()
 
 void D3D12Replay::ReadLogInitialisation()
 {
+  SCOPED_PROFILE("D3D12Replay::ReadLogInitialisation");
   m_pDevice->ReadLogInitialisation();
 }
 
@@ -75,9 +77,16 @@ APIProperties D3D12Replay::GetAPIProperties()
 
 void D3D12Replay::ReplayLog(uint32_t endEventID, ReplayLogType replayType)
 {
+  SCOPED_PROFILE("D3D12Replay::ReplayLog", endEventID);
   m_pDevice->ReplayLog(0, endEventID, replayType);
 }
 
+bool D3D12Replay::AdvanceReplay(uint32_t fromEventID, uint32_t toEventID)
+{
+  // partial replays only work within a single command list
+  return false;
+}
+
 vector<ResourceId> D3D12Replay::GetBuffers()
 {
   vector<ResourceId> ret;
@@ -105,10 +114,29 @@ vector<ResourceId> D3D12Replay::GetTextures()
   return ret;
 }
 
+static void GetAllocationInfo(WrappedID3D12Device *device, ID3D12Resource *res, uint64_t &size,
+                              uint64_t &alignment, rdctype::str &memoryType)
+{
+  D3D12_RESOURCE_DESC desc = res->GetDesc();
+  D3D12_RESOURCE_ALLOCATION_INFO info = device->GetResourceAllocationInfo(0, 1, &desc);
+
+  size = info.SizeInBytes;
+  alignment = info.Alignment;
+
+  // reserved resources have no heap of their own
+  D3D12_HEAP_PROPERTIES heapProps = {};
+  if(SUCCEEDED(res->GetHeapProperties(&heapProps, NULL)))
+    memoryType = ToStr::Get(heapProps.Type);
+  else
+    memoryType = "Reserved";
+}
+
 BufferDescription D3D12Replay::GetBuffer(ResourceId id)
 {
   BufferDescription ret;
   ret.ID = m_pDevice->GetResourceManager()->GetOriginalID(id);
+  ret.allocationSize = 0;
+  ret.allocationAlignment = 0;
 
   auto it = WrappedID3D12Resource::GetList().find(id);
 
@@ -130,6 +158,9 @@ BufferDescription D3D12Replay::GetBuffer(ResourceId id)
 
   ret.length = desc.Width;
 
+  GetAllocationInfo(m_pDevice, it->second, ret.allocationSize, ret.allocationAlignment,
+                    ret.memoryType);
+
   ret.creationFlags = BufferCategory::NoFlags;
 
   const std::vector<EventUsage> &usage = m_pDevice->GetQueue()->GetUsage(id);
@@ -161,6 +192,9 @@ TextureDescription D3D12Replay::GetTexture(ResourceId id)
 {
   TextureDescription ret;
   ret.ID = m_pDevice->GetResourceManager()->GetOriginalID(id);
+  ret.placeholderInitialContents = false;
+  ret.allocationSize = 0;
+  ret.allocationAlignment = 0;
 
   auto it = WrappedID3D12Resource::GetList().find(id);
 
@@ -184,6 +218,9 @@ TextureDescription D3D12Replay::GetTexture(ResourceId id)
     ret.byteSize += GetByteSize(ret.width, ret.height, ret.depth, desc.Format, i);
   ret.byteSize *= ret.arraysize;
 
+  GetAllocationInfo(m_pDevice, it->second, ret.allocationSize, ret.allocationAlignment,
+                    ret.memoryType);
+
   switch(ret.dimension)
   {
     case 1:
@@ -250,7 +287,18 @@ ShaderReflection *D3D12Replay::GetShader(ResourceId shader, string entryPoint)
       m_pDevice->GetResourceManager()->GetCurrentAs<WrappedID3D12Shader>(shader);
 
   if(sh)
-    return &sh->GetDetails();
+  {
+    ShaderReflection &refl = sh->GetDetails();
+
+    // disassemble and parse debug info lazily on demand
+    if(refl.Disassembly.count == 0 && sh->GetDXBC())
+    {
+      refl.Disassembly = sh->GetDXBC()->GetDisassembly();
+      DXBC::MakeShaderDebugInfo(sh->GetDXBC(), &refl);
+    }
+
+    return &refl;
+  }
 
   return NULL;
 }
@@ -1206,6 +1254,7 @@ bool D3D12Replay::GetHistogram(ResourceId texid, uint32_t sliceFace, uint32_t mi
 ResourceId D3D12Replay::RenderOverlay(ResourceId texid, CompType typeHint, DebugOverlay overlay,
                                       uint32_t eventID, const vector<uint32_t> &passEvents)
 {
+  SCOPED_PROFILE("D3D12Replay::RenderOverlay", eventID);
   return m_pDevice->GetDebugManager()->RenderOverlay(texid, typeHint, overlay, eventID, passEvents);
 }
 
@@ -1415,6 +1464,9 @@ void D3D12Replay::FillCBufferVariables(ResourceId shader, string entryPoint, uin
 
 void D3D12Replay::InitPostVSBuffers(uint32_t eventID)
 {
+  SCOPED_PROFILE("D3D12Replay::InitPostVSBuffers", eventID);
+  // trim before the pass is fetched, so none of its events are evicted
+  m_pDevice->GetDebugManager()->TrimPostVSCache(eventID);
   m_pDevice->GetDebugManager()->InitPostVSBuffers(eventID);
 }
 
@@ -1428,6 +1480,10 @@ struct D3D12InitPostVSCallback : public D3D12DrawcallCallback
   ~D3D12InitPostVSCallback() { m_pDevice->GetQueue()->GetCommandData()->m_DrawcallCallback = NULL; }
   void PreDraw(uint32_t eid, ID3D12GraphicsCommandList *cmd)
   {
+    // once cancelled, the rest of the pass replays without caching anything more
+    if(RenderDoc::Inst().IsReplayCancelled())
+      return;
+
     if(std::find(m_Events.begin(), m_Events.end(), eid) != m_Events.end())
       m_pDevice->GetDebugManager()->InitPostVSBuffers(eid);
   }
@@ -1539,6 +1595,28 @@ vector<DebugMessage> D3D12Replay::GetDebugMessages()
   return m_pDevice->GetDebugMessages();
 }
 
+vector<MemoryUsage> D3D12Replay::GetMemoryUsage()
+{
+  vector<MemoryUsage> ret;
+
+  ret.push_back(
+      MakeMemoryUsage("Capture data", false, 1, m_pDevice->GetMainSerialiser()->GetSize()));
+
+  // resources are copied on the GPU, so the serialised size is a close estimate of what the copies
+  // take
+  ret.push_back(MakeMemoryUsage("Initial contents", true,
+                                m_pDevice->GetResourceManager()->NumInitialContents(),
+                                m_pDevice->GetFrameRecord().frameInfo.initDataSize));
+
+  uint64_t count = 0, bytes = 0;
+  WrappedID3D12Shader::GetMemoryUsage(count, bytes);
+  ret.push_back(MakeMemoryUsage("Shader reflection", false, count, bytes));
+
+  m_pDevice->GetDebugManager()->GetMemoryUsage(ret);
+
+  return ret;
+}
+
 void D3D12Replay::BuildTargetShader(string source, string entry, const uint32_t compileFlags,
                                     ShaderStage type, ResourceId *id, string *errors)
 {
@@ -1620,6 +1698,8 @@ void D3D12Replay::RemoveReplacement(ResourceId id)
 
   rm->RemoveReplacement(id);
 
+  m_pDevice->GetDebugManager()->InvalidatePickCache();
+
   if(rm->HasLiveResource(id))
   {
     ID3D12DeviceChild *resource = rm->GetLiveResource(id);
@@ -1643,9 +1723,17 @@ void D3D12Replay::RemoveReplacement(ResourceId id)
 byte *D3D12Replay::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
                                   const GetTextureDataParams &params, size_t &dataSize)
 {
+  SCOPED_PROFILE("D3D12Replay::GetTextureData");
   return m_pDevice->GetDebugManager()->GetTextureData(tex, arrayIdx, mip, params, dataSize);
 }
 
+vector<TextureThumbnail> D3D12Replay::GetTextureThumbnails(
+    const vector<TextureThumbnailRequest> &textures, uint32_t size)
+{
+  SCOPED_PROFILE("D3D12Replay::GetTextureThumbnails");
+  return FetchTextureThumbnails(this, textures, size);
+}
+
 void D3D12Replay::BuildCustomShader(string source, string entry, const uint32_t compileFlags,
                                     ShaderStage type, ResourceId *id, string *errors)
 {
@@ -1661,6 +1749,12 @@ ResourceId D3D12Replay::ApplyCustomShader(ResourceId shader, ResourceId texid, u
 
 #pragma region not yet implemented
 
+vector<TextureSamplingFeedback> D3D12Replay::FetchTextureSampling(uint32_t startEventID,
+                                                                  uint32_t endEventID)
+{
+  return vector<TextureSamplingFeedback>();
+}
+
 vector<PixelModification> D3D12Replay::PixelHistory(vector<EventUsage> events, ResourceId target,
                                                     uint32_t x, uint32_t y, uint32_t slice,
                                                     uint32_t mip, uint32_t sampleIdx,
@@ -1669,6 +1763,13 @@ vector<PixelModification> D3D12Replay::PixelHistory(vector<EventUsage> events, R
   return vector<PixelModification>();
 }
 
+vector<vector<PixelModification> > D3D12Replay::PixelHistoryRegion(
+    vector<EventUsage> events, ResourceId target, uint32_t x, uint32_t y, uint32_t width,
+    uint32_t height, uint32_t slice, uint32_t mip, uint32_t sampleIdx, CompType typeHint)
+{
+  return vector<vector<PixelModification> >(width * height);
+}
+
 ShaderDebugTrace D3D12Replay::DebugVertex(uint32_t eventID, uint32_t vertid, uint32_t instid,
                                           uint32_t idx, uint32_t instOffset, uint32_t vertOffset)
 {
@@ -1681,6 +1782,19 @@ ShaderDebugTrace D3D12Replay::DebugPixel(uint32_t eventID, uint32_t x, uint32_t
   return ShaderDebugTrace();
 }
 
+vector<ShaderDebugTrace> D3D12Replay::DebugVertices(uint32_t eventID,
+                                                    vector<ShaderDebugVertexInput> inputs,
+                                                    uint32_t instOffset, uint32_t vertOffset)
+{
+  return vector<ShaderDebugTrace>(inputs.size());
+}
+
+vector<ShaderDebugTrace> D3D12Replay::DebugPixels(uint32_t eventID,
+                                                  vector<ShaderDebugPixelInput> inputs)
+{
+  return vector<ShaderDebugTrace>(inputs.size());
+}
+
 ShaderDebugTrace D3D12Replay::DebugThread(uint32_t eventID, const uint32_t groupid[3],
                                           const uint32_t threadid[3])
 {
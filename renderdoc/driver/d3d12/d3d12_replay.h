@@ -26,6 +26,7 @@
 
 #include "api/replay/renderdoc_replay.h"
 #include "core/core.h"
+#include "replay/counter_provider.h"
 #include "replay/replay_driver.h"
 #include "d3d12_common.h"
 #include "d3d12_state.h"
@@ -53,6 +54,7 @@ public:
   TextureDescription GetTexture(ResourceId id);
 
   vector<DebugMessage> GetDebugMessages();
+  vector<MemoryUsage> GetMemoryUsage();
 
   ShaderReflection *GetShader(ResourceId shader, string entryPoint);
 
@@ -70,6 +72,8 @@ public:
 
   void ReadLogInitialisation();
   void ReplayLog(uint32_t endEventID, ReplayLogType replayType);
+  bool AdvanceReplay(uint32_t fromEventID, uint32_t toEventID);
+  void SetPrunedEvents(const vector<uint32_t> &eventIDs) {}
 
   vector<uint32_t> GetPassEvents(uint32_t eventID);
 
@@ -106,6 +110,8 @@ public:
   void GetBufferData(ResourceId buff, uint64_t offset, uint64_t len, vector<byte> &retData);
   byte *GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
                        const GetTextureDataParams &params, size_t &dataSize);
+  vector<TextureThumbnail> GetTextureThumbnails(const vector<TextureThumbnailRequest> &textures,
+                                                uint32_t size);
 
   void BuildTargetShader(string source, string entry, const uint32_t compileFlags, ShaderStage type,
                          ResourceId *id, string *errors);
@@ -116,6 +122,8 @@ public:
   void DescribeCounter(GPUCounter counterID, CounterDescription &desc);
   vector<CounterResult> FetchCounters(const vector<GPUCounter> &counters);
 
+  vector<TextureSamplingFeedback> FetchTextureSampling(uint32_t startEventID, uint32_t endEventID);
+
   ResourceId CreateProxyTexture(const TextureDescription &templateTex);
   void SetProxyTextureData(ResourceId texid, uint32_t arrayIdx, uint32_t mip, byte *data,
                            size_t dataSize);
@@ -138,10 +146,18 @@ public:
   vector<PixelModification> PixelHistory(vector<EventUsage> events, ResourceId target, uint32_t x,
                                          uint32_t y, uint32_t slice, uint32_t mip,
                                          uint32_t sampleIdx, CompType typeHint);
+  vector<vector<PixelModification> > PixelHistoryRegion(vector<EventUsage> events,
+                                                        ResourceId target, uint32_t x, uint32_t y,
+                                                        uint32_t width, uint32_t height,
+                                                        uint32_t slice, uint32_t mip,
+                                                        uint32_t sampleIdx, CompType typeHint);
   ShaderDebugTrace DebugVertex(uint32_t eventID, uint32_t vertid, uint32_t instid, uint32_t idx,
                                uint32_t instOffset, uint32_t vertOffset);
   ShaderDebugTrace DebugPixel(uint32_t eventID, uint32_t x, uint32_t y, uint32_t sample,
                               uint32_t primitive);
+  vector<ShaderDebugTrace> DebugVertices(uint32_t eventID, vector<ShaderDebugVertexInput> inputs,
+                                         uint32_t instOffset, uint32_t vertOffset);
+  vector<ShaderDebugTrace> DebugPixels(uint32_t eventID, vector<ShaderDebugPixelInput> inputs);
   ShaderDebugTrace DebugThread(uint32_t eventID, const uint32_t groupid[3],
                                const uint32_t threadid[3]);
   void PickPixel(ResourceId texture, uint32_t x, uint32_t y, uint32_t sliceFace, uint32_t mip,
@@ -181,6 +197,10 @@ private:
                           D3D12_SHADER_VISIBILITY visibility);
   void FillResourceView(D3D12Pipe::View &view, D3D12Descriptor *desc);
 
+  // vendor hardware counters, see d3d12_counters.cpp
+  CounterProviders m_CounterProviders;
+  vector<CounterResult> FetchProviderCounters(const vector<GPUCounter> &counters);
+
   bool m_Proxy;
 
   vector<ID3D12Resource *> m_ProxyResources;
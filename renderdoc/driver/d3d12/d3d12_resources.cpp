@@ -26,6 +26,7 @@
 #include "3rdparty/lz4/lz4.h"
 #include "d3d12_command_list.h"
 #include "d3d12_command_queue.h"
+#include "replay/replay_driver.h"
 
 GPUAddressRangeTracker WrappedID3D12Resource::m_Addresses;
 std::map<ResourceId, WrappedID3D12Resource *> *WrappedID3D12Resource::m_List = NULL;
@@ -33,6 +34,20 @@ std::map<WrappedID3D12PipelineState::DXBCKey, WrappedID3D12Shader *> WrappedID3D
 
 const GUID RENDERDOC_ID3D12ShaderGUID_ShaderDebugMagicValue = RENDERDOC_ShaderDebugMagicValue_struct;
 
+void WrappedID3D12Shader::GetMemoryUsage(uint64_t &count, uint64_t &bytes)
+{
+  count = m_Shaders.size();
+  bytes = 0;
+
+  for(auto it = m_Shaders.begin(); it != m_Shaders.end(); ++it)
+  {
+    bytes += it->second->m_Bytecode.capacity();
+
+    if(it->second->m_Built)
+      bytes += GetShaderReflectionSize(it->second->m_Details);
+  }
+}
+
 void WrappedID3D12Shader::TryReplaceOriginalByteCode()
 {
   if(!DXBC::DXBCFile::CheckForDebugInfo((const void *)&m_Bytecode[0], m_Bytecode.size()))
@@ -419,7 +434,7 @@ HRESULT STDMETHODCALLTYPE WrappedID3D12Resource::WriteToSubresource(UINT DstSubr
 void WrappedID3D12Resource::RefBuffers(D3D12ResourceManager *rm)
 {
   // only buffers go into m_Addresses
-  SCOPED_LOCK(m_Addresses.addressLock);
+  SCOPED_READLOCK(m_Addresses.addressLock);
   for(size_t i = 0; i < m_Addresses.addresses.size(); i++)
     rm->MarkResourceFrameReferenced(m_Addresses.addresses[i].id, eFrameRef_Read);
 }
@@ -451,10 +466,37 @@ WrappedID3D12DescriptorHeap::WrappedID3D12DescriptorHeap(ID3D12DescriptorHeap *r
     // less undefined for the application to use
     descriptors[i].nonsamp.type = D3D12Descriptor::TypeUndefined;
   }
+
+  UINT numBlocks = (numDescriptors + WrittenBlockSize - 1) / WrittenBlockSize;
+  writtenBlocks = new byte[numBlocks];
+  memset(writtenBlocks, 0, numBlocks);
 }
 
 WrappedID3D12DescriptorHeap::~WrappedID3D12DescriptorHeap()
 {
   Shutdown();
   SAFE_DELETE_ARRAY(descriptors);
+  SAFE_DELETE_ARRAY(writtenBlocks);
+}
+
+void WrappedID3D12DescriptorHeap::GetWrittenRanges(std::vector<std::pair<UINT, UINT> > &ranges)
+{
+  ranges.clear();
+
+  UINT numBlocks = (numDescriptors + WrittenBlockSize - 1) / WrittenBlockSize;
+
+  for(UINT b = 0; b < numBlocks; b++)
+  {
+    if(!writtenBlocks[b])
+      continue;
+
+    UINT first = b * WrittenBlockSize;
+    UINT count = RDCMIN((UINT)WrittenBlockSize, numDescriptors - first);
+
+    // extend the previous range if it's contiguous
+    if(!ranges.empty() && ranges.back().first + ranges.back().second == first)
+      ranges.back().second += count;
+    else
+      ranges.push_back(std::make_pair(first, count));
+  }
 }
@@ -369,6 +369,9 @@ class WrappedID3D12DescriptorHeap : public WrappedDeviceChild12<ID3D12Descriptor
 
   D3D12Descriptor *descriptors;
 
+  // one flag per block of descriptors, set once anything has been written into the block
+  byte *writtenBlocks;
+
 public:
   ALLOCATE_WITH_WRAPPED_POOL(WrappedID3D12DescriptorHeap);
 
@@ -377,12 +380,22 @@ public:
     TypeEnum = Resource_DescriptorHeap,
   };
 
+  // descriptors are tracked in blocks of this many to find which parts of the heap are in use.
+  // Large heaps are often only partly filled, so only the written blocks need to be saved
+  enum
+  {
+    WrittenBlockSize = 64,
+  };
+
   WrappedID3D12DescriptorHeap(ID3D12DescriptorHeap *real, WrappedID3D12Device *device,
                               const D3D12_DESCRIPTOR_HEAP_DESC &desc);
   virtual ~WrappedID3D12DescriptorHeap();
 
   D3D12Descriptor *GetDescriptors() { return descriptors; }
   UINT GetNumDescriptors() { return numDescriptors; }
+  void MarkWritten(UINT idx) { writtenBlocks[idx / WrittenBlockSize] = 1; }
+  // fills out the ranges of descriptors that have been written at some point, as first/count pairs
+  void GetWrittenRanges(std::vector<std::pair<UINT, UINT> > &ranges);
   bool Resident() { return resident != 0; }
   void SetResident(bool r) { resident = r ? 1 : 0; }
   //////////////////////////////
@@ -563,6 +576,9 @@ public:
       shader->Release();
     }
 
+    // estimated CPU memory held by all shaders' bytecode and the reflection that's been built
+    static void GetMemoryUsage(uint64_t &count, uint64_t &bytes);
+
     DXBCKey GetKey() { return m_Key; }
     void SetDebugInfoPath(vector<std::string> *searchPaths, const std::string &path)
     {
@@ -719,5 +719,7 @@ enum GLChunkType
   INTEROP_INIT,
   INTEROP_DATA,
 
+  CONTEXT_FRAME_BOUNDARY,
+
   NUM_OPENGL_CHUNKS,
 };
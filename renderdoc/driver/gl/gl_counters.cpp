@@ -22,20 +22,29 @@
  * THE SOFTWARE.
  ******************************************************************************/
 
+#include <algorithm>
 #include "gl_driver.h"
 #include "gl_replay.h"
 #include "gl_resources.h"
 
+static bool IsQuadCounter(GPUCounter c)
+{
+  return c >= GPUCounter::CoveredPixels && c <= GPUCounter::DepthRejectedPixels;
+}
+
 void GLReplay::PreContextInitCounters()
 {
 }
 
 void GLReplay::PostContextInitCounters()
 {
+  // the replay context is current here, there's no separate device object to pass
+  m_CounterProviders.Init(eRENDERDOC_CounterAPI_OpenGL, NULL);
 }
 
 void GLReplay::PreContextShutdownCounters()
 {
+  m_CounterProviders.Shutdown();
 }
 
 void GLReplay::PostContextShutdownCounters()
@@ -60,11 +69,25 @@ vector<GPUCounter> GLReplay::EnumerateCounters()
   ret.push_back(GPUCounter::PSInvocations);
   ret.push_back(GPUCounter::CSInvocations);
 
+  if(DebugData.quadstatsFSProg)
+  {
+    ret.push_back(GPUCounter::CoveredPixels);
+    ret.push_back(GPUCounter::ShadedQuadPixels);
+    ret.push_back(GPUCounter::HelperPixelRatio);
+    ret.push_back(GPUCounter::DepthRejectedPixels);
+  }
+
+  vector<GPUCounter> providerCounters = m_CounterProviders.EnumerateCounters();
+  ret.insert(ret.end(), providerCounters.begin(), providerCounters.end());
+
   return ret;
 }
 
 void GLReplay::DescribeCounter(GPUCounter counterID, CounterDescription &desc)
 {
+  if(m_CounterProviders.DescribeCounter(counterID, desc))
+    return;
+
   desc.counterID = counterID;
 
   switch(counterID)
@@ -161,6 +184,40 @@ void GLReplay::DescribeCounter(GPUCounter counterID, CounterDescription &desc)
       desc.resultType = CompType::UInt;
       desc.unit = CounterUnit::Absolute;
       break;
+    case GPUCounter::CoveredPixels:
+      desc.name = "Covered Pixels";
+      desc.description =
+          "Number of pixels covered by the drawcall that passed depth/stencil test. Measured with "
+          "a replacement fragment shader, so pixels the real shader discards are included.";
+      desc.resultByteWidth = 8;
+      desc.resultType = CompType::UInt;
+      desc.unit = CounterUnit::Absolute;
+      break;
+    case GPUCounter::ShadedQuadPixels:
+      desc.name = "Shaded Quad Pixels";
+      desc.description =
+          "Number of fragment shader lanes run, counting every pixel of each 2x2 quad with at "
+          "least one covered pixel.";
+      desc.resultByteWidth = 8;
+      desc.resultType = CompType::UInt;
+      desc.unit = CounterUnit::Absolute;
+      break;
+    case GPUCounter::HelperPixelRatio:
+      desc.name = "Helper Pixel Ratio";
+      desc.description =
+          "Fraction of the shaded quad pixels that were only run as helpers for derivatives.";
+      desc.resultByteWidth = 8;
+      desc.resultType = CompType::Double;
+      desc.unit = CounterUnit::Percentage;
+      break;
+    case GPUCounter::DepthRejectedPixels:
+      desc.name = "Depth Rejected Pixels";
+      desc.description =
+          "Number of pixels covered by the drawcall that failed depth/stencil test before shading.";
+      desc.resultByteWidth = 8;
+      desc.resultType = CompType::UInt;
+      desc.unit = CounterUnit::Absolute;
+      break;
     default:
       desc.name = "Unknown";
       desc.description = "Unknown counter ID";
@@ -209,6 +266,10 @@ void GLReplay::FillTimers(GLCounterContext &ctx, const DrawcallTreeNode &drawnod
 
   for(size_t i = 0; i < drawnode.children.size(); i++)
   {
+    // timers created so far are read back as normal, the rest of the frame is skipped
+    if(RenderDoc::Inst().IsReplayCancelled())
+      return;
+
     const DrawcallDescription &d = drawnode.children[i].draw;
     FillTimers(ctx, drawnode.children[i], counters);
 
@@ -264,6 +325,48 @@ void GLReplay::FillTimers(GLCounterContext &ctx, const DrawcallTreeNode &drawnod
   }
 }
 
+void GLReplay::FillProviderSamples(uint32_t &eventStart, const DrawcallTreeNode &drawnode)
+{
+  if(drawnode.children.empty())
+    return;
+
+  for(size_t i = 0; i < drawnode.children.size(); i++)
+  {
+    const DrawcallDescription &d = drawnode.children[i].draw;
+    FillProviderSamples(eventStart, drawnode.children[i]);
+
+    if(d.events.count == 0)
+      continue;
+
+    m_pDriver->ReplayLog(eventStart, d.eventID, eReplay_WithoutDraw);
+
+    m_CounterProviders.BeginSample(d.eventID, NULL);
+    m_pDriver->ReplayLog(eventStart, d.eventID, eReplay_OnlyDraw);
+    m_CounterProviders.EndSample(d.eventID, NULL);
+
+    eventStart = d.eventID + 1;
+  }
+}
+
+vector<CounterResult> GLReplay::FetchProviderCounters(const vector<GPUCounter> &counters)
+{
+  uint32_t numPasses = m_CounterProviders.BeginSession(counters);
+
+  for(uint32_t pass = 0; pass < numPasses; pass++)
+  {
+    uint32_t eventStart = 0;
+
+    m_CounterProviders.BeginPass(pass);
+    m_pDriver->SetFetchCounters(true);
+    FillProviderSamples(eventStart, m_pDriver->GetRootDraw());
+    m_pDriver->SetFetchCounters(false);
+    m_pDriver->glFinish();
+    m_CounterProviders.EndPass(pass);
+  }
+
+  return m_CounterProviders.EndSession();
+}
+
 vector<CounterResult> GLReplay::FetchCounters(const vector<GPUCounter> &counters)
 {
   vector<CounterResult> ret;
@@ -276,6 +379,42 @@ vector<CounterResult> GLReplay::FetchCounters(const vector<GPUCounter> &counters
 
   MakeCurrentReplayContext(&m_ReplayCtx);
 
+  vector<GPUCounter> queryCounters, quadCounters;
+  for(GPUCounter c : counters)
+  {
+    if(IsQuadCounter(c))
+      quadCounters.push_back(c);
+    else
+      queryCounters.push_back(c);
+  }
+
+  if(!quadCounters.empty())
+  {
+    if(!queryCounters.empty())
+      ret = FetchCounters(queryCounters);
+
+    vector<CounterResult> quadResults = FetchQuadCounters(quadCounters);
+    ret.insert(ret.end(), quadResults.begin(), quadResults.end());
+
+    std::sort(ret.begin(), ret.end());
+
+    return ret;
+  }
+
+  vector<GPUCounter> apiCounters, providerCounters;
+  if(m_CounterProviders.SplitCounters(counters, apiCounters, providerCounters))
+  {
+    if(!apiCounters.empty())
+      ret = FetchCounters(apiCounters);
+
+    vector<CounterResult> providerResults = FetchProviderCounters(providerCounters);
+    ret.insert(ret.end(), providerResults.begin(), providerResults.end());
+
+    std::sort(ret.begin(), ret.end());
+
+    return ret;
+  }
+
   GLCounterContext ctx;
 
   for(int loop = 0; loop < 1; loop++)
@@ -333,3 +472,138 @@ vector<CounterResult> GLReplay::FetchCounters(const vector<GPUCounter> &counters
 
   return ret;
 }
+
+// the counts quadstats.frag accumulates for one drawcall
+struct QuadStats
+{
+  uint32_t coveredPixels;
+  uint32_t quadsTimes12;
+};
+
+static void GetDrawcallEvents(const DrawcallTreeNode &drawnode, vector<uint32_t> &events)
+{
+  for(const DrawcallTreeNode &child : drawnode.children)
+  {
+    GetDrawcallEvents(child, events);
+
+    if(child.draw.flags & DrawFlags::Drawcall)
+      events.push_back(child.draw.eventID);
+  }
+}
+
+vector<CounterResult> GLReplay::FetchQuadCounters(const vector<GPUCounter> &counters)
+{
+  vector<CounterResult> ret;
+
+  if(DebugData.quadstatsFSProg == 0)
+    return ret;
+
+  WrappedOpenGL &gl = *m_pDriver;
+
+  void *ctx = m_ReplayCtx.ctx;
+
+  vector<uint32_t> events;
+  GetDrawcallEvents(m_pDriver->GetRootDraw(), events);
+
+  if(events.empty())
+    return ret;
+
+  // each drawcall is drawn twice, once as normal and once without depth/stencil testing, into its
+  // own pair of slots. Everything is read back at the end so the frame is only replayed once
+  GLint align = 1;
+  gl.glGetIntegerv(eGL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &align);
+  GLsizeiptr slotSize = AlignUp((GLsizeiptr)sizeof(QuadStats), (GLsizeiptr)RDCMAX(align, 1));
+
+  // bind to the last binding, the replaced fragment shader can't be using it but the other stages
+  // are less likely to use it than the first
+  GLint maxBindings = 1;
+  gl.glGetIntegerv(eGL_MAX_SHADER_STORAGE_BUFFER_BINDINGS, &maxBindings);
+  GLuint binding = (GLuint)RDCMAX(maxBindings - 1, 0);
+  gl.glShaderStorageBlockBinding(DebugData.quadstatsFSProg, 0, binding);
+
+  vector<byte> data(size_t(slotSize) * 2 * events.size(), 0);
+
+  GLuint statsBuf = 0;
+  gl.glGenBuffers(1, &statsBuf);
+  gl.glBindBuffer(eGL_SHADER_STORAGE_BUFFER, statsBuf);
+  gl.glNamedBufferDataEXT(statsBuf, (GLsizeiptr)data.size(), data.data(), eGL_DYNAMIC_READ);
+
+  uint32_t eventStart = 0;
+  size_t measured = 0;
+
+  for(; measured < events.size(); measured++)
+  {
+    // drawcalls measured so far are read back as normal, the rest of the frame is skipped
+    if(RenderDoc::Inst().IsReplayCancelled())
+      break;
+
+    uint32_t eventID = events[measured];
+
+    m_pDriver->ReplayLog(eventStart, eventID, eReplay_WithoutDraw);
+
+    GLRenderState rs(&gl.GetHookset(), NULL, READING);
+    rs.FetchState(ctx, &gl);
+
+    // swap in our fragment shader and mask off all other writes. Testing is left as it is, with
+    // early tests forced by the shader
+    SetupOverlayPipeline(rs.Program, rs.Pipeline, DebugData.quadstatsFSProg);
+    gl.glUseProgram(0);
+    gl.glBindProgramPipeline(DebugData.overlayPipe);
+
+    gl.glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    gl.glDepthMask(GL_FALSE);
+    gl.glStencilMask(0);
+
+    GLintptr offs = GLintptr(slotSize) * 2 * measured;
+
+    gl.glBindBufferRange(eGL_SHADER_STORAGE_BUFFER, binding, statsBuf, offs, sizeof(QuadStats));
+    m_pDriver->ReplayLog(0, eventID, eReplay_OnlyDraw);
+
+    // the extra pixels covered without testing are the ones it rejected
+    gl.glDisable(eGL_DEPTH_TEST);
+    gl.glDisable(eGL_STENCIL_TEST);
+
+    gl.glBindBufferRange(eGL_SHADER_STORAGE_BUFFER, binding, statsBuf, offs + slotSize,
+                         sizeof(QuadStats));
+    m_pDriver->ReplayLog(0, eventID, eReplay_OnlyDraw);
+
+    rs.ApplyState(ctx, &gl);
+
+    // and the real drawcall, for anything after it that depends on its results
+    m_pDriver->ReplayLog(eventStart, eventID, eReplay_OnlyDraw);
+
+    eventStart = eventID + 1;
+  }
+
+  gl.glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+  gl.glGetNamedBufferSubDataEXT(statsBuf, 0, (GLsizeiptr)data.size(), data.data());
+  gl.glDeleteBuffers(1, &statsBuf);
+
+  for(size_t i = 0; i < measured; i++)
+  {
+    const QuadStats &tested = *(const QuadStats *)&data[size_t(slotSize) * 2 * i];
+    const QuadStats &untested = *(const QuadStats *)&data[size_t(slotSize) * (2 * i + 1)];
+
+    uint64_t covered = tested.coveredPixels;
+    // rounded, as with coarse derivatives the quad coverage can be slightly off
+    uint64_t shaded = uint64_t(double(tested.quadsTimes12) / 3.0 + 0.5);
+    uint64_t rejected = untested.coveredPixels > tested.coveredPixels
+                            ? untested.coveredPixels - tested.coveredPixels
+                            : 0;
+
+    for(GPUCounter c : counters)
+    {
+      if(c == GPUCounter::CoveredPixels)
+        ret.push_back(CounterResult(events[i], c, covered));
+      else if(c == GPUCounter::ShadedQuadPixels)
+        ret.push_back(CounterResult(events[i], c, shaded));
+      else if(c == GPUCounter::HelperPixelRatio)
+        ret.push_back(CounterResult(
+            events[i], c, shaded > covered ? 1.0 - double(covered) / double(shaded) : 0.0));
+      else if(c == GPUCounter::DepthRejectedPixels)
+        ret.push_back(CounterResult(events[i], c, rejected));
+    }
+  }
+
+  return ret;
+}
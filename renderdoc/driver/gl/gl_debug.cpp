@@ -26,6 +26,7 @@
 #include <float.h>
 #include <algorithm>
 #include "common/common.h"
+#include "common/profiler.h"
 #include "data/glsl_shaders.h"
 #include "maths/camera.h"
 #include "maths/formatpacking.h"
@@ -328,6 +329,7 @@ void GLReplay::InitDebugData()
   }
 
   DebugData.glslVersion = glslVersion;
+  DebugData.glslCSVer = glslCSVer;
 
   RDCLOG("GLSL version %d", glslVersion);
 
@@ -358,6 +360,18 @@ void GLReplay::InitDebugData()
     GenerateGLSLShader(fs, shaderType, "", GetEmbeddedResource(glsl_quadresolve_frag), glslBaseVer);
 
     DebugData.quadoverdrawResolveProg = CreateShaderProgram(vs, fs);
+
+    if(HasExt[ARB_shader_storage_buffer_object])
+    {
+      GenerateGLSLShader(fs, shaderType, defines, GetEmbeddedResource(glsl_quadstats_frag),
+                         RDCMIN(450, glslVersion));
+
+      DebugData.quadstatsFSProg = CreateShaderProgram(empty, fs);
+    }
+    else
+    {
+      DebugData.quadstatsFSProg = 0;
+    }
   }
   else
   {
@@ -370,6 +384,7 @@ void GLReplay::InitDebugData()
                                "disabling quad overdraw feature.");
     DebugData.quadoverdrawFSProg = 0;
     DebugData.quadoverdrawResolveProg = 0;
+    DebugData.quadstatsFSProg = 0;
   }
 
   GenerateGLSLShader(fs, shaderType, "", GetEmbeddedResource(glsl_checkerboard_frag), glslBaseVer);
@@ -461,61 +476,6 @@ void GLReplay::InitDebugData()
         ARRAY_COUNT(DebugData.minmaxTileProgram) >= (TEXDISPLAY_SINT_TEX | TEXDISPLAY_TYPEMASK) + 1,
         "not enough programs");
 
-    string extensions =
-        "#extension GL_ARB_compute_shader : require\n"
-        "#extension GL_ARB_shader_storage_buffer_object : require\n";
-
-    for(int t = 1; glesShadersAreComplete && HasExt[ARB_compute_shader] && t <= RESTYPE_TEXTYPEMAX;
-        t++)
-    {
-      // float, uint, sint
-      for(int i = 0; i < 3; i++)
-      {
-        int idx = t;
-        if(i == 1)
-          idx |= TEXDISPLAY_UINT_TEX;
-        if(i == 2)
-          idx |= TEXDISPLAY_SINT_TEX;
-
-        {
-          string defines = extensions;
-          defines += string("#define SHADER_RESTYPE ") + ToStr::Get(t) + "\n";
-          defines += string("#define UINT_TEX ") + (i == 1 ? "1" : "0") + "\n";
-          defines += string("#define SINT_TEX ") + (i == 2 ? "1" : "0") + "\n";
-
-          GenerateGLSLShader(cs, shaderType, defines, GetEmbeddedResource(glsl_minmaxtile_comp),
-                             glslCSVer);
-
-          DebugData.minmaxTileProgram[idx] = CreateCShaderProgram(cs);
-        }
-
-        {
-          string defines = extensions;
-          defines += string("#define SHADER_RESTYPE ") + ToStr::Get(t) + "\n";
-          defines += string("#define UINT_TEX ") + (i == 1 ? "1" : "0") + "\n";
-          defines += string("#define SINT_TEX ") + (i == 2 ? "1" : "0") + "\n";
-
-          GenerateGLSLShader(cs, shaderType, defines, GetEmbeddedResource(glsl_histogram_comp),
-                             glslCSVer);
-
-          DebugData.histogramProgram[idx] = CreateCShaderProgram(cs);
-        }
-
-        if(t == 1)
-        {
-          string defines = extensions;
-          defines += string("#define SHADER_RESTYPE ") + ToStr::Get(t) + "\n";
-          defines += string("#define UINT_TEX ") + (i == 1 ? "1" : "0") + "\n";
-          defines += string("#define SINT_TEX ") + (i == 2 ? "1" : "0") + "\n";
-
-          GenerateGLSLShader(cs, shaderType, defines, GetEmbeddedResource(glsl_minmaxresult_comp),
-                             glslCSVer);
-
-          DebugData.minmaxResultProgram[i] = CreateCShaderProgram(cs);
-        }
-      }
-    }
-
     if(!HasExt[ARB_compute_shader])
     {
       RDCWARN("GL_ARB_compute_shader not supported, disabling min/max and histogram features.");
@@ -660,6 +620,10 @@ void GLReplay::InitDebugData()
 
   gl.glGenTransformFeedbacks(1, &DebugData.feedbackObj);
   gl.glGenBuffers(1, &DebugData.feedbackBuffer);
+
+  DebugData.readbackBuffer = 0;
+  DebugData.readbackBufferSize = 0;
+
   DebugData.feedbackQueries.push_back(0);
   gl.glGenQueries(1, &DebugData.feedbackQueries[0]);
 
@@ -701,6 +665,53 @@ void GLReplay::InitDebugData()
   }
 }
 
+void GLReplay::CreateHistogramPrograms(int texSlot, int intIdx)
+{
+  // only desktop GL has these shaders, GetMinMax and GetHistogram fail on GLES
+  if(IsGLES || !HasExt[ARB_compute_shader])
+    return;
+
+  int idx = texSlot;
+  if(intIdx == 1)
+    idx |= TEXDISPLAY_UINT_TEX;
+  if(intIdx == 2)
+    idx |= TEXDISPLAY_SINT_TEX;
+
+  if(DebugData.histogramProgram[idx] != 0)
+    return;
+
+  const ShaderType shaderType = eShaderGLSL;
+
+  vector<string> cs;
+
+  string defines =
+      "#extension GL_ARB_compute_shader : require\n"
+      "#extension GL_ARB_shader_storage_buffer_object : require\n";
+  defines += string("#define UINT_TEX ") + (intIdx == 1 ? "1" : "0") + "\n";
+  defines += string("#define SINT_TEX ") + (intIdx == 2 ? "1" : "0") + "\n";
+
+  string restype = string("#define SHADER_RESTYPE ") + ToStr::Get(texSlot) + "\n";
+
+  GenerateGLSLShader(cs, shaderType, defines + restype, GetEmbeddedResource(glsl_minmaxtile_comp),
+                     DebugData.glslCSVer);
+
+  DebugData.minmaxTileProgram[idx] = CreateCShaderProgram(cs);
+
+  GenerateGLSLShader(cs, shaderType, defines + restype, GetEmbeddedResource(glsl_histogram_comp),
+                     DebugData.glslCSVer);
+
+  DebugData.histogramProgram[idx] = CreateCShaderProgram(cs);
+
+  // the result pass doesn't read the texture, so it's shared by all texture types
+  if(DebugData.minmaxResultProgram[intIdx] == 0)
+  {
+    GenerateGLSLShader(cs, shaderType, defines + "#define SHADER_RESTYPE 1\n",
+                       GetEmbeddedResource(glsl_minmaxresult_comp), DebugData.glslCSVer);
+
+    DebugData.minmaxResultProgram[intIdx] = CreateCShaderProgram(cs);
+  }
+}
+
 void GLReplay::DeleteDebugData()
 {
   WrappedOpenGL &gl = *m_pDriver;
@@ -711,6 +722,9 @@ void GLReplay::DeleteDebugData()
 
   gl.glDeleteTransformFeedbacks(1, &DebugData.feedbackObj);
   gl.glDeleteBuffers(1, &DebugData.feedbackBuffer);
+
+  if(DebugData.readbackBuffer)
+    gl.glDeleteBuffers(1, &DebugData.readbackBuffer);
   gl.glDeleteQueries((GLsizei)DebugData.feedbackQueries.size(), DebugData.feedbackQueries.data());
 
   MakeCurrentReplayContext(m_DebugCtx);
@@ -730,6 +744,7 @@ void GLReplay::DeleteDebugData()
 
   gl.glDeleteProgram(DebugData.quadoverdrawFSProg);
   gl.glDeleteProgram(DebugData.quadoverdrawResolveProg);
+  gl.glDeleteProgram(DebugData.quadstatsFSProg);
 
   gl.glDeleteProgram(DebugData.texDisplayVSProg);
   for(int i = 0; i < 3; i++)
@@ -805,7 +820,7 @@ bool GLReplay::GetMinMax(ResourceId texid, uint32_t sliceFace, uint32_t mip, uin
   if(texid == ResourceId() || m_pDriver->m_Textures.find(texid) == m_pDriver->m_Textures.end())
     return false;
 
-  if(!HasExt[ARB_compute_shader])
+  if(IsGLES || !HasExt[ARB_compute_shader])
     return false;
 
   auto &texDetails = m_pDriver->m_Textures[texid];
@@ -904,6 +919,8 @@ bool GLReplay::GetMinMax(ResourceId texid, uint32_t sliceFace, uint32_t mip, uin
     intIdx = 2;
   }
 
+  CreateHistogramPrograms(texSlot, intIdx);
+
   int blocksX = (int)ceil(cdata->HistogramTextureResolution.x /
                           float(HGRAM_PIXELS_PER_TILE * HGRAM_TILES_PER_BLOCK));
   int blocksY = (int)ceil(cdata->HistogramTextureResolution.y /
@@ -979,7 +996,7 @@ bool GLReplay::GetHistogram(ResourceId texid, uint32_t sliceFace, uint32_t mip,
   if(m_pDriver->m_Textures.find(texid) == m_pDriver->m_Textures.end())
     return false;
 
-  if(!HasExt[ARB_compute_shader])
+  if(IsGLES || !HasExt[ARB_compute_shader])
     return false;
 
   auto &texDetails = m_pDriver->m_Textures[texid];
@@ -1092,6 +1109,8 @@ bool GLReplay::GetHistogram(ResourceId texid, uint32_t sliceFace, uint32_t mip,
     intIdx = 2;
   }
 
+  CreateHistogramPrograms(texSlot, intIdx);
+
   int blocksX = (int)ceil(cdata->HistogramTextureResolution.x /
                           float(HGRAM_PIXELS_PER_TILE * HGRAM_TILES_PER_BLOCK));
   int blocksY = (int)ceil(cdata->HistogramTextureResolution.y /
@@ -1303,10 +1322,14 @@ uint32_t GLReplay::PickVertex(uint32_t eventID, const MeshDisplay &cfg, uint32_t
   if(cfg.position.idxByteWidth && cfg.position.idxbuf != ResourceId())
     ib = m_pDriver->GetResourceManager()->GetCurrentResource(cfg.position.idxbuf).name;
 
+  // if we're picking in the same mesh as last time, its unpacked data is still in the pick buffers
+  // and only the dispatch itself needs to run again
+  bool upload = !DebugData.pickCache.Matches(eventID, cfg.position);
+
   // We copy into our own buffers to promote to the target type (uint32) that the
   // shader expects. Most IBs will be 16-bit indices, most VBs will not be float4.
 
-  if(ib)
+  if(ib && upload)
   {
     // resize up on demand
     if(DebugData.pickIBBuf == 0 || DebugData.pickIBSize < cfg.position.numVerts * sizeof(uint32_t))
@@ -1368,7 +1391,8 @@ uint32_t GLReplay::PickVertex(uint32_t eventID, const MeshDisplay &cfg, uint32_t
     SAFE_DELETE_ARRAY(outidxs);
   }
 
-  if(DebugData.pickVBBuf == 0 || DebugData.pickVBSize < cfg.position.numVerts * sizeof(Vec4f))
+  if(upload &&
+     (DebugData.pickVBBuf == 0 || DebugData.pickVBSize < cfg.position.numVerts * sizeof(Vec4f)))
   {
     gl.glDeleteBuffers(1, &DebugData.pickVBBuf);
 
@@ -1381,6 +1405,7 @@ uint32_t GLReplay::PickVertex(uint32_t eventID, const MeshDisplay &cfg, uint32_t
   }
 
   // unpack and linearise the data
+  if(upload)
   {
     FloatVector *vbData = new FloatVector[cfg.position.numVerts];
 
@@ -1415,6 +1440,8 @@ uint32_t GLReplay::PickVertex(uint32_t eventID, const MeshDisplay &cfg, uint32_t
     gl.glBufferSubData(eGL_SHADER_STORAGE_BUFFER, 0, cfg.position.numVerts * sizeof(Vec4f), vbData);
 
     delete[] vbData;
+
+    DebugData.pickCache.Set(eventID, cfg.position);
   }
 
   uint32_t reset[4] = {};
@@ -2135,7 +2162,7 @@ void GLReplay::SetupOverlayPipeline(GLuint Program, GLuint Pipeline, GLuint frag
         {
           GLuint progsrc =
               m_pDriver->GetResourceManager()->GetCurrentResource(pipeDetails.stagePrograms[i]).name;
-          GLuint progdst = m_pDriver->m_Shaders[pipeDetails.stageShaders[i]].prog;
+          GLuint progdst = m_pDriver->m_Shaders[pipeDetails.stageShaders[i]].GetProg(*m_pDriver);
 
           gl.glUseProgramStages(DebugData.overlayPipe, ShaderBit(i), progdst);
 
@@ -2161,7 +2188,7 @@ void GLReplay::SetupOverlayPipeline(GLuint Program, GLuint Pipeline, GLuint frag
     {
       if(progDetails.stageShaders[i] != ResourceId())
       {
-        GLuint progdst = m_pDriver->m_Shaders[progDetails.stageShaders[i]].prog;
+        GLuint progdst = m_pDriver->m_Shaders[progDetails.stageShaders[i]].GetProg(*m_pDriver);
 
         gl.glUseProgramStages(DebugData.overlayPipe, ShaderBit(i), progdst);
 
@@ -2186,6 +2213,7 @@ void GLReplay::SetupOverlayPipeline(GLuint Program, GLuint Pipeline, GLuint frag
 ResourceId GLReplay::RenderOverlay(ResourceId texid, CompType typeHint, DebugOverlay overlay,
                                    uint32_t eventID, const vector<uint32_t> &passEvents)
 {
+  SCOPED_PROFILE("GLReplay::RenderOverlay", eventID);
   WrappedOpenGL &gl = *m_pDriver;
 
   MakeCurrentReplayContext(&m_ReplayCtx);
@@ -3284,6 +3312,69 @@ ResourceId GLReplay::RenderOverlay(ResourceId texid, CompType typeHint, DebugOve
 }
 
 void GLReplay::InitPostVSBuffers(uint32_t eventID)
+{
+  SCOPED_PROFILE("GLReplay::InitPostVSBuffers", eventID);
+  // trim before the pass is fetched, so none of its events are evicted
+  TrimPostVSCache(eventID);
+  CachePostVSBuffers(eventID);
+}
+
+void GLReplay::CachePostVSBuffers(uint32_t eventID)
+{
+  if(m_PostVSCache.Lookup(eventID))
+    return;
+
+  CreatePostVSBuffers(eventID);
+
+  auto it = m_PostVSData.find(eventID);
+  if(it == m_PostVSData.end())
+    return;
+
+  WrappedOpenGL &gl = *m_pDriver;
+
+  GLuint bufs[] = {it->second.vsout.buf, it->second.vsout.idxBuf, it->second.gsout.buf,
+                   it->second.gsout.idxBuf};
+
+  uint64_t size = 0;
+
+  for(size_t i = 0; i < ARRAY_COUNT(bufs); i++)
+  {
+    if(bufs[i] == 0)
+      continue;
+
+    GLint bufsize = 0;
+    gl.glGetNamedBufferParameterivEXT(bufs[i], eGL_BUFFER_SIZE, &bufsize);
+    size += (uint64_t)bufsize;
+  }
+
+  m_PostVSCache.Insert(eventID, size);
+}
+
+void GLReplay::TrimPostVSCache(uint32_t eventID)
+{
+  std::vector<uint32_t> evicted = m_PostVSCache.Trim(eventID);
+
+  if(evicted.empty())
+    return;
+
+  MakeCurrentReplayContext(&m_ReplayCtx);
+
+  WrappedOpenGL &gl = *m_pDriver;
+
+  for(size_t i = 0; i < evicted.size(); i++)
+  {
+    GLPostVSData &postvs = m_PostVSData[evicted[i]];
+
+    gl.glDeleteBuffers(1, &postvs.vsout.buf);
+    gl.glDeleteBuffers(1, &postvs.vsout.idxBuf);
+    gl.glDeleteBuffers(1, &postvs.gsout.buf);
+    gl.glDeleteBuffers(1, &postvs.gsout.idxBuf);
+
+    m_PostVSData.erase(evicted[i]);
+  }
+}
+
+void GLReplay::CreatePostVSBuffers(uint32_t eventID)
 {
   if(m_PostVSData.find(eventID) != m_PostVSData.end())
     return;
@@ -3335,24 +3426,24 @@ void GLReplay::InitPostVSBuffers(uint32_t eventID)
       if(pipeDetails.stageShaders[0] != ResourceId())
       {
         vsRefl = GetShader(pipeDetails.stageShaders[0], "");
-        vsProg = m_pDriver->m_Shaders[pipeDetails.stageShaders[0]].prog;
+        vsProg = m_pDriver->m_Shaders[pipeDetails.stageShaders[0]].GetProg(*m_pDriver);
         vsProgSrc = rm->GetCurrentResource(pipeDetails.stagePrograms[0]).name;
       }
       if(pipeDetails.stageShaders[1] != ResourceId())
       {
-        tcsProg = m_pDriver->m_Shaders[pipeDetails.stageShaders[1]].prog;
+        tcsProg = m_pDriver->m_Shaders[pipeDetails.stageShaders[1]].GetProg(*m_pDriver);
         tcsProgSrc = rm->GetCurrentResource(pipeDetails.stagePrograms[1]).name;
       }
       if(pipeDetails.stageShaders[2] != ResourceId())
       {
         tesRefl = GetShader(pipeDetails.stageShaders[2], "");
-        tesProg = m_pDriver->m_Shaders[pipeDetails.stageShaders[2]].prog;
+        tesProg = m_pDriver->m_Shaders[pipeDetails.stageShaders[2]].GetProg(*m_pDriver);
         tesProgSrc = rm->GetCurrentResource(pipeDetails.stagePrograms[2]).name;
       }
       if(pipeDetails.stageShaders[3] != ResourceId())
       {
         gsRefl = GetShader(pipeDetails.stageShaders[3], "");
-        gsProg = m_pDriver->m_Shaders[pipeDetails.stageShaders[3]].prog;
+        gsProg = m_pDriver->m_Shaders[pipeDetails.stageShaders[3]].GetProg(*m_pDriver);
         gsProgSrc = rm->GetCurrentResource(pipeDetails.stagePrograms[3]).name;
       }
     }
@@ -3364,21 +3455,21 @@ void GLReplay::InitPostVSBuffers(uint32_t eventID)
     if(progDetails.stageShaders[0] != ResourceId())
     {
       vsRefl = GetShader(progDetails.stageShaders[0], "");
-      vsProg = m_pDriver->m_Shaders[progDetails.stageShaders[0]].prog;
+      vsProg = m_pDriver->m_Shaders[progDetails.stageShaders[0]].GetProg(*m_pDriver);
     }
     if(progDetails.stageShaders[1] != ResourceId())
     {
-      tcsProg = m_pDriver->m_Shaders[progDetails.stageShaders[1]].prog;
+      tcsProg = m_pDriver->m_Shaders[progDetails.stageShaders[1]].GetProg(*m_pDriver);
     }
     if(progDetails.stageShaders[2] != ResourceId())
     {
       tesRefl = GetShader(progDetails.stageShaders[2], "");
-      tesProg = m_pDriver->m_Shaders[progDetails.stageShaders[2]].prog;
+      tesProg = m_pDriver->m_Shaders[progDetails.stageShaders[2]].GetProg(*m_pDriver);
     }
     if(progDetails.stageShaders[3] != ResourceId())
     {
       gsRefl = GetShader(progDetails.stageShaders[3], "");
-      gsProg = m_pDriver->m_Shaders[progDetails.stageShaders[3]].prog;
+      gsProg = m_pDriver->m_Shaders[progDetails.stageShaders[3]].GetProg(*m_pDriver);
     }
 
     vsProgSrc = tcsProgSrc = tesProgSrc = gsProgSrc = rs.Program;
@@ -4629,6 +4720,10 @@ void GLReplay::InitPostVSBuffers(const vector<uint32_t> &passEvents)
   // doing partial replays and calling InitPostVSBuffers for each
   for(size_t i = 0; i < passEvents.size(); i++)
   {
+    // events cached so far are complete, the rest are computed on demand if needed later
+    if(RenderDoc::Inst().IsReplayCancelled())
+      break;
+
     if(prev != passEvents[i])
     {
       m_pDriver->ReplayLog(prev, passEvents[i], eReplay_WithoutDraw);
@@ -4639,7 +4734,7 @@ void GLReplay::InitPostVSBuffers(const vector<uint32_t> &passEvents)
     const DrawcallDescription *d = m_pDriver->GetDrawcall(passEvents[i]);
 
     if(d)
-      InitPostVSBuffers(passEvents[i]);
+      CachePostVSBuffers(passEvents[i]);
   }
 }
 
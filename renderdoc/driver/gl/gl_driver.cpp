@@ -28,7 +28,6 @@
 #include "common/common.h"
 #include "data/glsl_shaders.h"
 #include "driver/shaders/spirv/spirv_common.h"
-#include "jpeg-compressor/jpge.h"
 #include "maths/matrix.h"
 #include "maths/vec.h"
 #include "replay/type_helpers.h"
@@ -320,6 +319,8 @@ const char *GLChunkNames[] = {
 
     "wglDXRegisterObjectNV",
     "wglDXLockObjectsNV",
+
+    "FrameBoundary",
 };
 
 GLInitParams::GLInitParams()
@@ -800,8 +801,12 @@ WrappedOpenGL::WrappedOpenGL(const char *logfile, const GLHookSet &funcs, GLPlat
   m_SuccessfulCapture = true;
   m_FailureReason = CaptureSucceeded;
 
+  m_AsyncUploadCopy = false;
+
   m_AppControlledCapture = false;
 
+  m_ContextDataTLSSlot = Threading::AllocateTLSSlot();
+
   m_RealDebugFunc = NULL;
   m_RealDebugFuncParam = NULL;
   m_SuppressDebugMessages = false;
@@ -813,6 +818,8 @@ WrappedOpenGL::WrappedOpenGL(const char *logfile, const GLHookSet &funcs, GLPlat
   m_FirstEventID = 0;
   m_LastEventID = ~0U;
 
+  m_PruningUnsafe = false;
+
   m_FetchCounters = false;
 
   RDCEraseEl(m_ActiveQueries);
@@ -886,6 +893,12 @@ WrappedOpenGL::WrappedOpenGL(const char *logfile, const GLHookSet &funcs, GLPlat
     RenderDoc::Inst().RegisterShutdownFunction(&ShutdownSPIRVCompiler);
   }
 
+  m_ProgramBinaryCacheInit = false;
+  m_ProgramBinaryCacheEnabled = false;
+  m_ReflectionCacheInit = false;
+  m_ReflectionCacheEnabled = false;
+  m_ReplayDriverHash = 0;
+
   m_FakeBB_FBO = 0;
   m_FakeBB_Color = 0;
   m_FakeBB_DepthStencil = 0;
@@ -1106,14 +1119,49 @@ WrappedOpenGL::~WrappedOpenGL()
 
 void *WrappedOpenGL::GetCtx()
 {
+  ContextData **cur = (ContextData **)Threading::GetTLSValue(m_ContextDataTLSSlot);
+  if(cur && *cur)
+    return (*cur)->ctx;
+
   return (void *)m_ActiveContexts[Threading::GetCurrentID()].ctx;
 }
 
 WrappedOpenGL::ContextData &WrappedOpenGL::GetCtxData()
 {
+  ContextData **cur = (ContextData **)Threading::GetTLSValue(m_ContextDataTLSSlot);
+  if(cur && *cur)
+    return **cur;
+
   return m_ContextData[GetCtx()];
 }
 
+GLTextureBindingShadow *WrappedOpenGL::GetTextureBindingShadow()
+{
+  if(m_State < WRITING)
+    return NULL;
+
+  return &GetCtxData().m_TextureBindings;
+}
+
+void WrappedOpenGL::SetActiveContext(const GLWindowingData &winData)
+{
+  uint64_t thread = Threading::GetCurrentID();
+
+  m_ActiveContexts[thread] = winData;
+
+  ContextData *&cur = m_ThreadContextData[thread];
+  cur = NULL;
+
+  if(winData.ctx)
+  {
+    cur = &m_ContextData[winData.ctx];
+    cur->ctx = winData.ctx;
+  }
+
+  // map nodes are never moved, so the entry's address is stable for as long as the driver lives
+  Threading::SetTLSValue(m_ContextDataTLSSlot, &cur);
+}
+
 // defined in gl_<platform>_hooks.cpp
 Threading::CriticalSection &GetGLLock();
 
@@ -1153,6 +1201,12 @@ void WrappedOpenGL::DeleteContext(void *contextHandle)
     }
   }
 
+  // don't leave any thread pointing at the data we're about to erase. They fall back to looking up
+  // the context until it's next made current.
+  for(auto it = m_ThreadContextData.begin(); it != m_ThreadContextData.end(); ++it)
+    if(it->second == &ctxdata)
+      it->second = NULL;
+
   m_ContextData.erase(contextHandle);
 }
 
@@ -1394,7 +1448,7 @@ void WrappedOpenGL::RegisterContext(GLWindowingData winData, void *shareContext,
 
 void WrappedOpenGL::ActivateContext(GLWindowingData winData)
 {
-  m_ActiveContexts[Threading::GetCurrentID()] = winData;
+  SetActiveContext(winData);
   if(winData.ctx)
   {
     for(auto it = m_LastContexts.begin(); it != m_LastContexts.end(); ++it)
@@ -1852,7 +1906,7 @@ void WrappedOpenGL::RenderOverlayStr(float x, float y, const char *text)
 
   RDCASSERT(strlen(text) < (size_t)FONT_MAX_CHARS);
 
-  ContextData &ctxdata = m_ContextData[GetCtx()];
+  ContextData &ctxdata = GetCtxData();
 
   if(!ctxdata.built || !ctxdata.ready)
     return;
@@ -2472,9 +2526,15 @@ void WrappedOpenGL::SwapBuffers(void *windowHandle)
   if(ctxdata.Legacy())
     return;
 
-  // kill any current capture that isn't application defined
+  // kill any current capture that isn't application defined, unless it's set to record more
+  // frames, in which case just mark where this one ended
   if(m_State == WRITING_CAPFRAME && !m_AppControlledCapture)
-    RenderDoc::Inst().EndFrameCapture(ctxdata.ctx, windowHandle);
+  {
+    if(RenderDoc::Inst().ShouldContinueFrameCapture())
+      ContextFrameBoundary();
+    else
+      RenderDoc::Inst().EndFrameCapture(ctxdata.ctx, windowHandle);
+  }
 
   if(RenderDoc::Inst().ShouldTriggerCapture(m_FrameCounter) && m_State == WRITING_IDLE)
   {
@@ -2517,7 +2577,7 @@ void WrappedOpenGL::MakeValidContextCurrent(GLWindowingData &prevctx, void *favo
              Threading::GetCurrentID());
     }
 
-    m_ActiveContexts[Threading::GetCurrentID()] = prevctx;
+    SetActiveContext(prevctx);
     m_Platform.MakeContextCurrent(prevctx);
   }
 }
@@ -2574,7 +2634,7 @@ void WrappedOpenGL::StartFrameCapture(void *dev, void *wnd)
   if(switchctx.ctx != prevctx.ctx)
   {
     m_Platform.MakeContextCurrent(prevctx);
-    m_ActiveContexts[Threading::GetCurrentID()] = prevctx;
+    SetActiveContext(prevctx);
   }
 
   RDCLOG("Starting capture, frame %u", m_FrameCounter);
@@ -2624,8 +2684,10 @@ bool WrappedOpenGL::EndFrameCapture(void *dev, void *wnd)
     if(bbim == NULL)
       bbim = SaveBackbufferImage();
 
+    // the serialiser takes ownership of the thumbnail pixels
     Serialiser *m_pFileSerialiser = RenderDoc::Inst().OpenWriteSerialiser(
-        m_FrameCounter, &m_InitParams, bbim->jpgbuf, bbim->len, bbim->thwidth, bbim->thheight);
+        m_FrameCounter, &m_InitParams, bbim->thpixels, bbim->thwidth, bbim->thheight);
+    bbim->thpixels = NULL;
 
     SAFE_DELETE(bbim);
 
@@ -2646,8 +2708,12 @@ bool WrappedOpenGL::EndFrameCapture(void *dev, void *wnd)
 
     GetResourceManager()->InsertReferencedChunks(m_pFileSerialiser);
 
+    GetResourceManager()->ReadbackInitialContents();
+
     GetResourceManager()->InsertInitialContentsChunks(m_pFileSerialiser);
 
+    GetResourceManager()->FreeInitialContentsReadbacks();
+
     RDCDEBUG("Creating Capture Scope");
 
     {
@@ -2665,8 +2731,9 @@ bool WrappedOpenGL::EndFrameCapture(void *dev, void *wnd)
 
       RDCDEBUG("Accumulating context resource list");
 
-      map<int32_t, Chunk *> recordlist;
+      ChunkList recordlist;
       record->Insert(recordlist);
+      SortChunkList(recordlist);
 
       RDCDEBUG("Flushing %u records to file serialiser", (uint32_t)recordlist.size());
 
@@ -2676,11 +2743,7 @@ bool WrappedOpenGL::EndFrameCapture(void *dev, void *wnd)
       RDCDEBUG("Done");
     }
 
-    m_pFileSerialiser->FlushToDisk();
-
-    RenderDoc::Inst().SuccessfullyWrittenLog(m_FrameCounter);
-
-    SAFE_DELETE(m_pFileSerialiser);
+    RenderDoc::Inst().FinishWriteSerialiser(m_pFileSerialiser, m_FrameCounter);
 
     m_State = WRITING_IDLE;
 
@@ -2691,7 +2754,7 @@ bool WrappedOpenGL::EndFrameCapture(void *dev, void *wnd)
     if(switchctx.ctx != prevctx.ctx)
     {
       m_Platform.MakeContextCurrent(prevctx);
-      m_ActiveContexts[Threading::GetCurrentID()] = prevctx;
+      SetActiveContext(prevctx);
     }
 
     return true;
@@ -2765,7 +2828,7 @@ bool WrappedOpenGL::EndFrameCapture(void *dev, void *wnd)
     if(switchctx.ctx != prevctx.ctx)
     {
       m_Platform.MakeContextCurrent(prevctx);
-      m_ActiveContexts[Threading::GetCurrentID()] = prevctx;
+      SetActiveContext(prevctx);
     }
 
     return false;
@@ -2806,64 +2869,94 @@ WrappedOpenGL::BackbufferImage *WrappedOpenGL::SaveBackbufferImage()
     m_Real.glPixelStorei(eGL_PACK_SKIP_PIXELS, 0);
     m_Real.glPixelStorei(eGL_PACK_ALIGNMENT, 1);
 
-    thwidth = m_InitParams.width;
-    thheight = m_InitParams.height;
+    // clamp dimensions to a width of maxSize
+    float aspect = float(m_InitParams.width) / float(m_InitParams.height);
+
+    thwidth = RDCMIN(maxSize, m_InitParams.width);
+    thheight = thwidth == m_InitParams.width ? m_InitParams.height
+                                             : uint32_t(float(thwidth) / aspect);
 
     thpixels = new byte[thwidth * thheight * 3];
 
-    m_Real.glReadPixels(0, 0, thwidth, thheight, eGL_RGB, eGL_UNSIGNED_BYTE, thpixels);
+    // if we can, blit to a thumbnail-sized renderbuffer so the GPU does the scaling and the flip
+    // and only the thumbnail is read back. A multisampled backbuffer can't be scaled by a blit.
+    bool gpuDownscale = m_Real.glBlitFramebuffer && m_Real.glGenFramebuffers &&
+                        m_Real.glGenRenderbuffers && m_Real.glRenderbufferStorage &&
+                        m_Real.glFramebufferRenderbuffer && m_InitParams.multiSamples <= 1;
 
-    // flip the image in-place
-    for(uint32_t y = 0; y <= thheight / 2; y++)
+    if(gpuDownscale)
     {
-      uint32_t flipY = (thheight - 1 - y);
-
-      for(uint32_t x = 0; x < thwidth; x++)
-      {
-        byte save[3];
-        save[0] = thpixels[y * (thwidth * 3) + x * 3 + 0];
-        save[1] = thpixels[y * (thwidth * 3) + x * 3 + 1];
-        save[2] = thpixels[y * (thwidth * 3) + x * 3 + 2];
-
-        thpixels[y * (thwidth * 3) + x * 3 + 0] = thpixels[flipY * (thwidth * 3) + x * 3 + 0];
-        thpixels[y * (thwidth * 3) + x * 3 + 1] = thpixels[flipY * (thwidth * 3) + x * 3 + 1];
-        thpixels[y * (thwidth * 3) + x * 3 + 2] = thpixels[flipY * (thwidth * 3) + x * 3 + 2];
-
-        thpixels[flipY * (thwidth * 3) + x * 3 + 0] = save[0];
-        thpixels[flipY * (thwidth * 3) + x * 3 + 1] = save[1];
-        thpixels[flipY * (thwidth * 3) + x * 3 + 2] = save[2];
-      }
+      GLint prevDrawBuf = 0;
+      GLint prevRenderbuf = 0;
+      m_Real.glGetIntegerv(eGL_DRAW_FRAMEBUFFER_BINDING, &prevDrawBuf);
+      m_Real.glGetIntegerv(eGL_RENDERBUFFER_BINDING, &prevRenderbuf);
+      GLboolean scissor = m_Real.glIsEnabled(eGL_SCISSOR_TEST);
+
+      GLuint thumbRB = 0, thumbFB = 0;
+      m_Real.glGenRenderbuffers(1, &thumbRB);
+      m_Real.glBindRenderbuffer(eGL_RENDERBUFFER, thumbRB);
+      m_Real.glRenderbufferStorage(eGL_RENDERBUFFER, eGL_RGBA8, thwidth, thheight);
+
+      m_Real.glGenFramebuffers(1, &thumbFB);
+      m_Real.glBindFramebuffer(eGL_DRAW_FRAMEBUFFER, thumbFB);
+      m_Real.glFramebufferRenderbuffer(eGL_DRAW_FRAMEBUFFER, eGL_COLOR_ATTACHMENT0,
+                                       eGL_RENDERBUFFER, thumbRB);
+
+      if(scissor)
+        m_Real.glDisable(eGL_SCISSOR_TEST);
+
+      // flip on the way, as the thumbnail is stored top-down
+      m_Real.glBlitFramebuffer(0, 0, m_InitParams.width, m_InitParams.height, 0, thheight, thwidth,
+                               0, GL_COLOR_BUFFER_BIT, eGL_LINEAR);
+
+      if(scissor)
+        m_Real.glEnable(eGL_SCISSOR_TEST);
+
+      m_Real.glBindFramebuffer(eGL_READ_FRAMEBUFFER, thumbFB);
+      m_Real.glReadBuffer(eGL_COLOR_ATTACHMENT0);
+      m_Real.glReadPixels(0, 0, thwidth, thheight, eGL_RGB, eGL_UNSIGNED_BYTE, thpixels);
+
+      m_Real.glBindFramebuffer(eGL_DRAW_FRAMEBUFFER, prevDrawBuf);
+      m_Real.glBindRenderbuffer(eGL_RENDERBUFFER, prevRenderbuf);
+      m_Real.glDeleteFramebuffers(1, &thumbFB);
+      m_Real.glDeleteRenderbuffers(1, &thumbRB);
     }
-
-    m_Real.glBindBuffer(eGL_PIXEL_PACK_BUFFER, packBufBind);
-    m_Real.glBindFramebuffer(eGL_READ_FRAMEBUFFER, prevBuf);
-    m_Real.glReadBuffer(prevReadBuf);
-    m_Real.glPixelStorei(eGL_PACK_ROW_LENGTH, prevPackRowLen);
-    m_Real.glPixelStorei(eGL_PACK_SKIP_ROWS, prevPackSkipRows);
-    m_Real.glPixelStorei(eGL_PACK_SKIP_PIXELS, prevPackSkipPixels);
-    m_Real.glPixelStorei(eGL_PACK_ALIGNMENT, prevPackAlignment);
-
-    // scale down if necessary using simple point sampling
-    if(thwidth > maxSize)
+    else
     {
-      float widthf = float(thwidth);
-      float heightf = float(thheight);
+      byte *src = thpixels;
 
-      float aspect = widthf / heightf;
+      // read back the whole backbuffer then point sample down if necessary
+      if(thwidth != m_InitParams.width)
+        src = new byte[m_InitParams.width * m_InitParams.height * 3];
 
-      // clamp dimensions to a width of maxSize
-      thwidth = maxSize;
-      thheight = uint32_t(float(thwidth) / aspect);
+      m_Real.glReadPixels(0, 0, m_InitParams.width, m_InitParams.height, eGL_RGB,
+                          eGL_UNSIGNED_BYTE, src);
 
-      byte *src = thpixels;
-      byte *dst = thpixels = new byte[3 * thwidth * thheight];
+      float widthf = float(m_InitParams.width);
+      float heightf = float(m_InitParams.height);
+
+      byte *dst = thpixels;
 
+      // flip the image as we go. When not scaling this is in-place, so swap pairs of rows
       for(uint32_t y = 0; y < thheight; y++)
       {
+        uint32_t flipY = (thheight - 1 - y);
+
+        if(src == thpixels)
+        {
+          if(y >= flipY)
+            break;
+
+          for(uint32_t x = 0; x < thwidth * 3; x++)
+            std::swap(thpixels[y * (thwidth * 3) + x], thpixels[flipY * (thwidth * 3) + x]);
+
+          continue;
+        }
+
         for(uint32_t x = 0; x < thwidth; x++)
         {
           float xf = float(x) / float(thwidth);
-          float yf = float(y) / float(thheight);
+          float yf = float(flipY) / float(thheight);
 
           byte *pixelsrc =
               &src[3 * uint32_t(xf * widthf) + m_InitParams.width * 3 * uint32_t(yf * heightf)];
@@ -2875,40 +2968,22 @@ WrappedOpenGL::BackbufferImage *WrappedOpenGL::SaveBackbufferImage()
       }
 
       // src is the raw unscaled pixels, which is no longer needed
-      SAFE_DELETE_ARRAY(src);
+      if(src != thpixels)
+        SAFE_DELETE_ARRAY(src);
     }
-  }
 
-  byte *jpgbuf = NULL;
-  int len = thwidth * thheight;
-
-  if(len > 0)
-  {
-    // jpge::compress_image_to_jpeg_file_in_memory requires at least 1024 bytes
-    len = len >= 1024 ? len : 1024;
-
-    jpgbuf = new byte[len];
-
-    jpge::params p;
-    p.m_quality = 80;
-
-    bool success =
-        jpge::compress_image_to_jpeg_file_in_memory(jpgbuf, len, thwidth, thheight, 3, thpixels, p);
-
-    if(!success)
-    {
-      RDCERR("Failed to compress to jpg");
-      SAFE_DELETE_ARRAY(jpgbuf);
-      thwidth = 0;
-      thheight = 0;
-    }
+    m_Real.glBindBuffer(eGL_PIXEL_PACK_BUFFER, packBufBind);
+    m_Real.glBindFramebuffer(eGL_READ_FRAMEBUFFER, prevBuf);
+    m_Real.glReadBuffer(prevReadBuf);
+    m_Real.glPixelStorei(eGL_PACK_ROW_LENGTH, prevPackRowLen);
+    m_Real.glPixelStorei(eGL_PACK_SKIP_ROWS, prevPackSkipRows);
+    m_Real.glPixelStorei(eGL_PACK_SKIP_PIXELS, prevPackSkipPixels);
+    m_Real.glPixelStorei(eGL_PACK_ALIGNMENT, prevPackAlignment);
   }
 
-  SAFE_DELETE_ARRAY(thpixels);
-
+  // the raw pixels are kept and only JPEG encoded when the capture is written
   BackbufferImage *bbim = new BackbufferImage();
-  bbim->jpgbuf = jpgbuf;
-  bbim->len = len;
+  bbim->thpixels = thpixels;
   bbim->thwidth = thwidth;
   bbim->thheight = thheight;
 
@@ -2955,6 +3030,13 @@ void WrappedOpenGL::ContextEndFrame()
   m_ContextRecord->AddChunk(scope.Get());
 }
 
+void WrappedOpenGL::ContextFrameBoundary()
+{
+  SCOPED_SERIALISE_CONTEXT(CONTEXT_FRAME_BOUNDARY);
+
+  m_ContextRecord->AddChunk(scope.Get());
+}
+
 void WrappedOpenGL::CleanupCapture()
 {
   m_SuccessfulCapture = true;
@@ -3245,8 +3327,6 @@ void WrappedOpenGL::ReadLogInitialisation()
 {
   uint64_t frameOffset = 0;
 
-  m_pSerialiser->SetDebugText(true);
-
   m_pSerialiser->Rewind();
 
   int chunkIdx = 0;
@@ -3291,6 +3371,10 @@ void WrappedOpenGL::ReadLogInitialisation()
 
       GetResourceManager()->ApplyInitialContents();
 
+      // only the frame's chunks become events, so don't format debug text for every resource
+      // creation and initial contents chunk before it
+      m_pSerialiser->SetDebugText(true);
+
       ContextReplayLog(READING, 0, 0, false);
     }
 
@@ -3330,6 +3414,8 @@ void WrappedOpenGL::ReadLogInitialisation()
            m_pSerialiser->GetSize() - frameOffset);
 
   m_pSerialiser->SetDebugText(false);
+
+  CloseProgramBinaryCache();
 }
 
 void WrappedOpenGL::ProcessChunk(uint64_t offset, GLChunkType context)
@@ -3768,6 +3854,24 @@ void WrappedOpenGL::ProcessChunk(uint64_t offset, GLChunkType context)
       }
     }
     break;
+    case CONTEXT_FRAME_BOUNDARY:
+      // a swap in the middle of a multi-frame capture. Unlike the footer the frame carries on
+      if(m_State == READING)
+      {
+        m_FrameRecord.frameInfo.frameCount++;
+
+        AddEvent("SwapBuffers()");
+
+        DrawcallDescription draw;
+        draw.name = "SwapBuffers()";
+        draw.flags |= DrawFlags::Present;
+
+        draw.copyDestination = GetResourceManager()->GetOriginalID(
+            GetResourceManager()->GetID(TextureRes(GetCtx(), m_FakeBB_Color)));
+
+        AddDrawcall(draw, true);
+      }
+      break;
     case INTEROP_INIT:
       Serialise_wglDXRegisterObjectNV(GLResource(MakeNullResource), eGL_NONE, NULL);
       break;
@@ -3901,16 +4005,59 @@ void WrappedOpenGL::ContextReplayLog(LogState readType, uint32_t startEventID, u
   m_State = READING;
 }
 
+// chunks that only do work using the current state without changing any of it, so skipping them
+// can only affect the resources they write
+static bool IsWorkOnlyChunk(GLChunkType chunk)
+{
+  if(chunk >= DRAWARRAYS && chunk <= DRAWELEMENTS_INSTANCEDBASEVERTEXBASEINSTANCE)
+    return true;
+
+  switch(chunk)
+  {
+    case DISPATCH_COMPUTE:
+    case DISPATCH_COMPUTE_GROUP_SIZE:
+    case DISPATCH_COMPUTE_INDIRECT:
+    case CLEAR:
+    case CLEARBUFFERF:
+    case CLEARBUFFERI:
+    case CLEARBUFFERUI:
+    case CLEARBUFFERFI:
+    case CLEARBUFFERDATA:
+    case CLEARBUFFERSUBDATA:
+    case CLEARTEXIMAGE:
+    case CLEARTEXSUBIMAGE:
+    case BLIT_FRAMEBUFFER:
+    case COPY_SUBIMAGE:
+    case COPYBUFFERSUBDATA:
+    case GENERATE_MIPMAP: return true;
+    default: break;
+  }
+
+  return false;
+}
+
 void WrappedOpenGL::ContextProcessChunk(uint64_t offset, GLChunkType chunk)
 {
   m_CurChunkOffset = offset;
 
   m_AddedDrawcall = false;
 
-  ProcessChunk(offset, chunk);
+  // a pruned drawcall's chunk is skipped entirely. Only single drawcalls are pruned, which don't
+  // advance the event ID themselves, and only from chunks that don't change any state.
+  if(m_State == EXECUTING && !m_PrunedEvents.empty() && IsWorkOnlyChunk(chunk) &&
+     std::binary_search(m_PrunedEvents.begin(), m_PrunedEvents.end(), m_CurEventID))
+    m_pSerialiser->SkipCurrentChunk();
+  else
+    ProcessChunk(offset, chunk);
 
   m_pSerialiser->PopContext(chunk);
 
+  if(m_State == READING &&
+     (chunk == BEGIN_CONDITIONAL || chunk == BEGIN_QUERY || chunk == BEGIN_QUERY_INDEXED ||
+      chunk == DRAW_FEEDBACK || chunk == DRAW_FEEDBACK_INSTANCED ||
+      chunk == DRAW_FEEDBACK_STREAM || chunk == DRAW_FEEDBACK_STREAM_INSTANCED))
+    m_PruningUnsafe = true;
+
   if(m_State == READING && chunk == SET_MARKER)
   {
     // no push/pop necessary
@@ -4280,6 +4427,8 @@ void WrappedOpenGL::AddEvent(string description)
   APIEvent apievent;
 
   apievent.fileOffset = m_CurChunkOffset;
+  m_pSerialiser->GetChunkTiming(m_CurChunkOffset, apievent.cpuTimestamp, apievent.threadID);
+  m_pSerialiser->GetChunkResourceRefs(apievent.referencedResources);
   apievent.eventID = m_CurEventID;
 
   apievent.eventDesc = description;
@@ -4316,6 +4465,36 @@ const DrawcallDescription *WrappedOpenGL::GetDrawcall(uint32_t eventID)
   return m_Drawcalls[eventID];
 }
 
+void WrappedOpenGL::SetPrunedEvents(const vector<uint32_t> &eventIDs)
+{
+  m_PrunedEvents.clear();
+
+  if(m_PruningUnsafe)
+    return;
+
+  for(uint32_t eid : eventIDs)
+  {
+    const DrawcallDescription *draw = GetDrawcall(eid);
+
+    // multidraws add their sub-draws while executing, so leave those alone
+    if(draw == NULL || draw->eventID != eid || draw->children.count > 0)
+      continue;
+
+    m_PrunedEvents.push_back(eid);
+  }
+
+  // anything touching aliased storage might affect what's being inspected through the alias
+  for(ResourceId id : m_AliasedResources)
+  {
+    for(const EventUsage &u : m_ResourceUses[id])
+    {
+      auto it = std::lower_bound(m_PrunedEvents.begin(), m_PrunedEvents.end(), u.eventID);
+      if(it != m_PrunedEvents.end() && *it == u.eventID)
+        m_PrunedEvents.erase(it);
+    }
+  }
+}
+
 void WrappedOpenGL::ReplayLog(uint32_t startEventID, uint32_t endEventID, ReplayLogType replayType)
 {
   uint64_t offs = m_FrameRecord.frameInfo.fileOffset;
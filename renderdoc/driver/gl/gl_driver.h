@@ -27,6 +27,7 @@
 
 #include <list>
 #include "common/common.h"
+#include "common/shader_cache.h"
 #include "common/timing.h"
 #include "core/core.h"
 #include "driver/shaders/spirv/spirv_common.h"
@@ -192,6 +193,12 @@ private:
 
   set<ResourceId> m_HighTrafficResources;
 
+  // while capturing a frame, big texture uploads from client memory are copied into their chunk
+  // on a worker while the driver reads the same memory. Set while serialising an upload that
+  // should do this, and the copies are waited on before the upload call returns.
+  bool m_AsyncUploadCopy;
+  Threading::TaskGroup m_UploadCopies;
+
   // we store two separate sets of maps, since for an explicit glMemoryBarrier
   // we need to flush both types of maps, but for implicit sync points we only
   // want to consider coherent maps, and since that happens often we want it to
@@ -233,6 +240,15 @@ private:
 
   map<ResourceId, vector<EventUsage> > m_ResourceUses;
 
+  // live IDs of resources that share storage with another resource, i.e. texture views and buffer
+  // textures with their buffers. Their usage doesn't show every access to that storage.
+  set<ResourceId> m_AliasedResources;
+  // set if draws in the frame can depend on earlier draws other than through resources, e.g. with
+  // queries, conditional rendering or drawing transform feedback results
+  bool m_PruningUnsafe;
+  // sorted events whose chunks are skipped while executing, see SetPrunedEvents
+  vector<uint32_t> m_PrunedEvents;
+
   bool m_FetchCounters;
 
   // buffer used
@@ -285,20 +301,24 @@ private:
 
   struct ShaderData
   {
-    ShaderData() : type(eGL_NONE), prog(0) {}
+    ShaderData() : type(eGL_NONE), prog(0), progDeferred(false) {}
     GLenum type;
     vector<string> sources;
     vector<string> includepaths;
     SPVModule spirv;
     ShaderReflection reflection;
     GLuint prog;
+    // set when the reflection came from the cache, so the separable program hasn't been made yet
+    bool progDeferred;
 
     void Compile(WrappedOpenGL &gl);
+    // returns the separable program, making it first if it was deferred
+    GLuint GetProg(WrappedOpenGL &gl);
   };
 
   struct ProgramData
   {
-    ProgramData() : linked(false) { RDCEraseEl(stageShaders); }
+    ProgramData() : linked(false), linkStateHash(5381) { RDCEraseEl(stageShaders); }
     vector<ResourceId> shaders;
 
     map<GLint, GLint> locationTranslate;
@@ -312,6 +332,10 @@ private:
     bool shaderProgramUnlinkable = false;
     bool linked;
     ResourceId stageShaders[6];
+
+    // on replay, a hash of the state set on the program before linking, such as attribute and frag
+    // data bindings, which affects the linked program binary.
+    uint32_t linkStateHash;
   };
 
   struct PipelineData
@@ -335,6 +359,38 @@ private:
 
   map<ResourceId, ShaderData> m_Shaders;
   map<ResourceId, ProgramData> m_Programs;
+
+  // on replay, linked program binaries are cached on disk keyed by a hash of the attached shaders'
+  // sources, the pre-link state and the driver, so later loads can skip linking. The cache holds
+  // the binary format followed by the binary.
+  static const uint32_t m_ProgramBinaryCacheMagic = 0xf00d0b1e;
+  static const uint32_t m_ProgramBinaryCacheVersion = 1;
+
+  bool m_ProgramBinaryCacheInit;
+  bool m_ProgramBinaryCacheEnabled;
+  ShaderCache<vector<byte> *> m_ProgramBinaryCache;
+
+  // similarly shader reflection is cached keyed by the shader's type and sources and the driver,
+  // so later loads can skip making separable programs and querying them. The cache holds the
+  // serialised ShaderReflection.
+  static const uint32_t m_ReflectionCacheMagic = 0xf00d4ef1;
+  static const uint32_t m_ReflectionCacheVersion = 2;
+
+  bool m_ReflectionCacheInit;
+  bool m_ReflectionCacheEnabled;
+  ShaderCache<vector<byte> *> m_ReflectionCache;
+
+  // hash of the vendor, renderer and version strings
+  uint32_t m_ReplayDriverHash;
+  uint32_t GetReplayDriverHash();
+
+  void AddProgramLinkState(ResourceId liveProg, const string &state);
+  uint32_t GetProgramBinaryHash(const ProgramData &prog);
+  void ReplayLinkProgram(ResourceId liveProg, GLuint program);
+  void CloseProgramBinaryCache();
+
+  bool FetchCachedReflection(ShaderData &shad, uint32_t &hash);
+  void CacheReflection(uint32_t hash, ShaderReflection &refl);
   map<ResourceId, PipelineData> m_Pipelines;
   vector<pair<ResourceId, Replacement> > m_DependentReplacements;
 
@@ -366,6 +422,7 @@ private:
   void BeginCaptureFrame();
   void FinishCapture();
   void ContextEndFrame();
+  void ContextFrameBoundary();
 
   void CleanupCapture();
   void FreeCaptureData();
@@ -445,6 +502,8 @@ private:
     GLuint m_ProgramPipeline;
     GLuint m_Program;
 
+    GLTextureBindingShadow m_TextureBindings;
+
     GLResourceRecord *GetActiveTexRecord() { return m_TextureRecord[m_TextureUnit]; }
     // GLES allows drawing from client memory, in which case we will copy to
     // temporary VBOs so that input mesh data is recorded. See struct ClientMemoryData
@@ -466,13 +525,22 @@ private:
     GLuint prevArrayBufferBinding;
   };
   ClientMemoryData *CopyClientMemoryArrays(GLint first, GLsizei count);
+  void UpdateTextureUnitShadow(GLuint unit, GLuint texture);
   void RestoreClientMemoryArrays(ClientMemoryData *clientMemoryArrays);
 
   map<void *, ContextData> m_ContextData;
 
+  // the ContextData current on each thread, NULL if none. Each thread caches a pointer to its own
+  // entry in a TLS slot so that GetCtx()/GetCtxData() don't need any lookups on the hot path.
+  // Entries are cleared if their context is deleted, so a cached pointer never dangles.
+  map<uint64_t, ContextData *> m_ThreadContextData;
+  uint64_t m_ContextDataTLSSlot;
+
   ContextData &GetCtxData();
   GLuint GetUniformProgram();
 
+  // records winData as current on this thread, which must be done any time it changes
+  void SetActiveContext(const GLWindowingData &winData);
   void MakeValidContextCurrent(GLWindowingData &prevctx, void *favourWnd);
 
   void ReplaceResource(ResourceId from, ResourceId to);
@@ -500,10 +568,10 @@ private:
 
   struct BackbufferImage
   {
-    BackbufferImage() : jpgbuf(NULL), len(0), thwidth(0), thheight(0) {}
-    ~BackbufferImage() { SAFE_DELETE_ARRAY(jpgbuf); }
-    byte *jpgbuf;
-    size_t len;
+    BackbufferImage() : thpixels(NULL), thwidth(0), thheight(0) {}
+    ~BackbufferImage() { SAFE_DELETE_ARRAY(thpixels); }
+    // tightly packed RGB8, top-down
+    byte *thpixels;
     uint32_t thwidth;
     uint32_t thheight;
   };
@@ -535,6 +603,10 @@ public:
   RDCDriver GetDriverType() { return m_DriverType; }
   void *GetCtx();
 
+  // the current context's texture bindings, tracked while capturing. NULL on replay, where state
+  // is set through the real functions directly and isn't tracked
+  GLTextureBindingShadow *GetTextureBindingShadow();
+
   void SetFetchCounters(bool in) { m_FetchCounters = in; };
   const GLHookSet &GetHookset() { return m_Real; }
   void SetDebugMsgContext(const char *context) { m_DebugMsgContext = context; }
@@ -549,6 +621,7 @@ public:
   // replay interface
   void Initialise(GLInitParams &params);
   void ReplayLog(uint32_t startEventID, uint32_t endEventID, ReplayLogType replayType);
+  void SetPrunedEvents(const vector<uint32_t> &eventIDs);
   void ReadLogInitialisation();
 
   Serialiser *GetSerialiser() { return m_pSerialiser; }
@@ -1870,7 +1943,8 @@ public:
                                      const void *pixels);
   void Common_glTextureSubImage2DEXT(GLResourceRecord *record, GLenum target, GLint level,
                                      GLint xoffset, GLint yoffset, GLsizei width, GLsizei height,
-                                     GLenum format, GLenum type, const void *pixels);
+                                     GLenum format, GLenum type, const void *pixels,
+                                     const std::function<void()> &upload);
   void Common_glTextureSubImage3DEXT(GLResourceRecord *record, GLenum target, GLint level,
                                      GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width,
                                      GLsizei height, GLsizei depth, GLenum format, GLenum type,
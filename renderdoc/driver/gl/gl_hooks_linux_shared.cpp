@@ -140,11 +140,13 @@ Threading::CriticalSection &GetGLLock()
   typedef ret (*CONCAT(function, _hooktype))();                    \
   extern "C" __attribute__((visibility("default"))) ret function() \
   {                                                                \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                    \
     SCOPED_LOCK(glLock);                                           \
     return m_GLDriver->function();                                 \
   }                                                                \
   ret CONCAT(function, _renderdoc_hooked)()                        \
   {                                                                \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                    \
     SCOPED_LOCK(glLock);                                           \
     return m_GLDriver->function();                                 \
   }
@@ -152,11 +154,13 @@ Threading::CriticalSection &GetGLLock()
   typedef ret (*CONCAT(function, _hooktype))(t1);                       \
   extern "C" __attribute__((visibility("default"))) ret function(t1 p1) \
   {                                                                     \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                         \
     SCOPED_LOCK(glLock);                                                \
     return m_GLDriver->function(p1);                                    \
   }                                                                     \
   ret CONCAT(function, _renderdoc_hooked)(t1 p1)                        \
   {                                                                     \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                         \
     SCOPED_LOCK(glLock);                                                \
     return m_GLDriver->function(p1);                                    \
   }
@@ -164,11 +168,13 @@ Threading::CriticalSection &GetGLLock()
   typedef ret (*CONCAT(function, _hooktype))(t1, t2);                          \
   extern "C" __attribute__((visibility("default"))) ret function(t1 p1, t2 p2) \
   {                                                                            \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                \
     SCOPED_LOCK(glLock);                                                       \
     return m_GLDriver->function(p1, p2);                                       \
   }                                                                            \
   ret CONCAT(function, _renderdoc_hooked)(t1 p1, t2 p2)                        \
   {                                                                            \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                \
     SCOPED_LOCK(glLock);                                                       \
     return m_GLDriver->function(p1, p2);                                       \
   }
@@ -176,11 +182,13 @@ Threading::CriticalSection &GetGLLock()
   typedef ret (*CONCAT(function, _hooktype))(t1, t2, t3);                             \
   extern "C" __attribute__((visibility("default"))) ret function(t1 p1, t2 p2, t3 p3) \
   {                                                                                   \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                       \
     SCOPED_LOCK(glLock);                                                              \
     return m_GLDriver->function(p1, p2, p3);                                          \
   }                                                                                   \
   ret CONCAT(function, _renderdoc_hooked)(t1 p1, t2 p2, t3 p3)                        \
   {                                                                                   \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                       \
     SCOPED_LOCK(glLock);                                                              \
     return m_GLDriver->function(p1, p2, p3);                                          \
   }
@@ -188,11 +196,13 @@ Threading::CriticalSection &GetGLLock()
   typedef ret (*CONCAT(function, _hooktype))(t1, t2, t3, t4);                                \
   extern "C" __attribute__((visibility("default"))) ret function(t1 p1, t2 p2, t3 p3, t4 p4) \
   {                                                                                          \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                              \
     SCOPED_LOCK(glLock);                                                                     \
     return m_GLDriver->function(p1, p2, p3, p4);                                             \
   }                                                                                          \
   ret CONCAT(function, _renderdoc_hooked)(t1 p1, t2 p2, t3 p3, t4 p4)                        \
   {                                                                                          \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                              \
     SCOPED_LOCK(glLock);                                                                     \
     return m_GLDriver->function(p1, p2, p3, p4);                                             \
   }
@@ -200,11 +210,13 @@ Threading::CriticalSection &GetGLLock()
   typedef ret (*CONCAT(function, _hooktype))(t1, t2, t3, t4, t5);                                   \
   extern "C" __attribute__((visibility("default"))) ret function(t1 p1, t2 p2, t3 p3, t4 p4, t5 p5) \
   {                                                                                                 \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                                     \
     SCOPED_LOCK(glLock);                                                                            \
     return m_GLDriver->function(p1, p2, p3, p4, p5);                                                \
   }                                                                                                 \
   ret CONCAT(function, _renderdoc_hooked)(t1 p1, t2 p2, t3 p3, t4 p4, t5 p5)                        \
   {                                                                                                 \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                                     \
     SCOPED_LOCK(glLock);                                                                            \
     return m_GLDriver->function(p1, p2, p3, p4, p5);                                                \
   }
@@ -213,11 +225,13 @@ Threading::CriticalSection &GetGLLock()
   extern "C" __attribute__((visibility("default"))) ret function(t1 p1, t2 p2, t3 p3, t4 p4, \
                                                                  t5 p5, t6 p6)               \
   {                                                                                          \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                              \
     SCOPED_LOCK(glLock);                                                                     \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6);                                     \
   }                                                                                          \
   ret CONCAT(function, _renderdoc_hooked)(t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6)          \
   {                                                                                          \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                              \
     SCOPED_LOCK(glLock);                                                                     \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6);                                     \
   }
@@ -226,11 +240,13 @@ Threading::CriticalSection &GetGLLock()
   extern "C" __attribute__((visibility("default"))) ret function(t1 p1, t2 p2, t3 p3, t4 p4, \
                                                                  t5 p5, t6 p6, t7 p7)        \
   {                                                                                          \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                              \
     SCOPED_LOCK(glLock);                                                                     \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7);                                 \
   }                                                                                          \
   ret CONCAT(function, _renderdoc_hooked)(t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7)   \
   {                                                                                          \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                              \
     SCOPED_LOCK(glLock);                                                                     \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7);                                 \
   }
@@ -239,11 +255,13 @@ Threading::CriticalSection &GetGLLock()
   extern "C" __attribute__((visibility("default"))) ret function(t1 p1, t2 p2, t3 p3, t4 p4,        \
                                                                  t5 p5, t6 p6, t7 p7, t8 p8)        \
   {                                                                                                 \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                                     \
     SCOPED_LOCK(glLock);                                                                            \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8);                                    \
   }                                                                                                 \
   ret CONCAT(function, _renderdoc_hooked)(t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7, t8 p8)   \
   {                                                                                                 \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                                     \
     SCOPED_LOCK(glLock);                                                                            \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8);                                    \
   }
@@ -253,12 +271,14 @@ Threading::CriticalSection &GetGLLock()
   extern "C" __attribute__((visibility("default"))) ret function(                                 \
       t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7, t8 p8, t9 p9)                              \
   {                                                                                               \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                                   \
     SCOPED_LOCK(glLock);                                                                          \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8, p9);                              \
   }                                                                                               \
   ret CONCAT(function, _renderdoc_hooked)(t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7, t8 p8, \
                                           t9 p9)                                                  \
   {                                                                                               \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                                   \
     SCOPED_LOCK(glLock);                                                                          \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8, p9);                              \
   }
@@ -268,12 +288,14 @@ Threading::CriticalSection &GetGLLock()
   extern "C" __attribute__((visibility("default"))) ret function(                                 \
       t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7, t8 p8, t9 p9, t10 p10)                     \
   {                                                                                               \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                                   \
     SCOPED_LOCK(glLock);                                                                          \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10);                         \
   }                                                                                               \
   ret CONCAT(function, _renderdoc_hooked)(t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7, t8 p8, \
                                           t9 p9, t10 p10)                                         \
   {                                                                                               \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                                   \
     SCOPED_LOCK(glLock);                                                                          \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10);                         \
   }
@@ -283,12 +305,14 @@ Threading::CriticalSection &GetGLLock()
   extern "C" __attribute__((visibility("default"))) ret function(                                 \
       t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7, t8 p8, t9 p9, t10 p10, t11 p11)            \
   {                                                                                               \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                                   \
     SCOPED_LOCK(glLock);                                                                          \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11);                    \
   }                                                                                               \
   ret CONCAT(function, _renderdoc_hooked)(t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7, t8 p8, \
                                           t9 p9, t10 p10, t11 p11)                                \
   {                                                                                               \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                                   \
     SCOPED_LOCK(glLock);                                                                          \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11);                    \
   }
@@ -298,12 +322,14 @@ Threading::CriticalSection &GetGLLock()
   extern "C" __attribute__((visibility("default"))) ret function(                                 \
       t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7, t8 p8, t9 p9, t10 p10, t11 p11, t12 p12)   \
   {                                                                                               \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                                   \
     SCOPED_LOCK(glLock);                                                                          \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12);               \
   }                                                                                               \
   ret CONCAT(function, _renderdoc_hooked)(t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7, t8 p8, \
                                           t9 p9, t10 p10, t11 p11, t12 p12)                       \
   {                                                                                               \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                                   \
     SCOPED_LOCK(glLock);                                                                          \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12);               \
   }
@@ -315,12 +341,14 @@ Threading::CriticalSection &GetGLLock()
       t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7, t8 p8, t9 p9, t10 p10, t11 p11, t12 p12,   \
       t13 p13)                                                                                    \
   {                                                                                               \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                                   \
     SCOPED_LOCK(glLock);                                                                          \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13);          \
   }                                                                                               \
   ret CONCAT(function, _renderdoc_hooked)(t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7, t8 p8, \
                                           t9 p9, t10 p10, t11 p11, t12 p12, t13 p13)              \
   {                                                                                               \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                                   \
     SCOPED_LOCK(glLock);                                                                          \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13);          \
   }
@@ -332,12 +360,14 @@ Threading::CriticalSection &GetGLLock()
       t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7, t8 p8, t9 p9, t10 p10, t11 p11, t12 p12,   \
       t13 p13, t14 p14)                                                                           \
   {                                                                                               \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                                   \
     SCOPED_LOCK(glLock);                                                                          \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13, p14);     \
   }                                                                                               \
   ret CONCAT(function, _renderdoc_hooked)(t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7, t8 p8, \
                                           t9 p9, t10 p10, t11 p11, t12 p12, t13 p13, t14 p14)     \
   {                                                                                               \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                                   \
     SCOPED_LOCK(glLock);                                                                          \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13, p14);     \
   }
@@ -349,6 +379,7 @@ Threading::CriticalSection &GetGLLock()
       t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7, t8 p8, t9 p9, t10 p10, t11 p11, t12 p12,    \
       t13 p13, t14 p14, t15 p15)                                                                   \
   {                                                                                                \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                                    \
     SCOPED_LOCK(glLock);                                                                           \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13, p14, p15); \
   }                                                                                                \
@@ -356,6 +387,7 @@ Threading::CriticalSection &GetGLLock()
                                           t9 p9, t10 p10, t11 p11, t12 p12, t13 p13, t14 p14,      \
                                           t15 p15)                                                 \
   {                                                                                                \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                                    \
     SCOPED_LOCK(glLock);                                                                           \
     return m_GLDriver->function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13, p14, p15); \
   }
@@ -122,6 +122,7 @@
   typedef ret(WINAPI *CONCAT(function, _hooktype))(); \
   static ret WINAPI CONCAT(function, _hooked)()       \
   {                                                   \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));       \
     SCOPED_LOCK(glLock);                              \
     if(!glhooks.m_HaveContextCreation)                \
       return glhooks.GL.function();                   \
@@ -132,6 +133,7 @@
   typedef ret(WINAPI *CONCAT(function, _hooktype))(t1); \
   static ret WINAPI CONCAT(function, _hooked)(t1 p1)    \
   {                                                     \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));         \
     SCOPED_LOCK(glLock);                                \
     if(!glhooks.m_HaveContextCreation)                  \
       return glhooks.GL.function(p1);                   \
@@ -142,6 +144,7 @@
   typedef ret(WINAPI *CONCAT(function, _hooktype))(t1, t2); \
   static ret WINAPI CONCAT(function, _hooked)(t1 p1, t2 p2) \
   {                                                         \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));             \
     SCOPED_LOCK(glLock);                                    \
     if(!glhooks.m_HaveContextCreation)                      \
       return glhooks.GL.function(p1, p2);                   \
@@ -152,6 +155,7 @@
   typedef ret(WINAPI *CONCAT(function, _hooktype))(t1, t2, t3);    \
   static ret WINAPI CONCAT(function, _hooked)(t1 p1, t2 p2, t3 p3) \
   {                                                                \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                    \
     SCOPED_LOCK(glLock);                                           \
     if(!glhooks.m_HaveContextCreation)                             \
       return glhooks.GL.function(p1, p2, p3);                      \
@@ -162,6 +166,7 @@
   typedef ret(WINAPI *CONCAT(function, _hooktype))(t1, t2, t3, t4);       \
   static ret WINAPI CONCAT(function, _hooked)(t1 p1, t2 p2, t3 p3, t4 p4) \
   {                                                                       \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                           \
     SCOPED_LOCK(glLock);                                                  \
     if(!glhooks.m_HaveContextCreation)                                    \
       return glhooks.GL.function(p1, p2, p3, p4);                         \
@@ -172,6 +177,7 @@
   typedef ret(WINAPI *CONCAT(function, _hooktype))(t1, t2, t3, t4, t5);          \
   static ret WINAPI CONCAT(function, _hooked)(t1 p1, t2 p2, t3 p3, t4 p4, t5 p5) \
   {                                                                              \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                  \
     SCOPED_LOCK(glLock);                                                         \
     if(!glhooks.m_HaveContextCreation)                                           \
       return glhooks.GL.function(p1, p2, p3, p4, p5);                            \
@@ -182,6 +188,7 @@
   typedef ret(WINAPI *CONCAT(function, _hooktype))(t1, t2, t3, t4, t5, t6);             \
   static ret WINAPI CONCAT(function, _hooked)(t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6) \
   {                                                                                     \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                         \
     SCOPED_LOCK(glLock);                                                                \
     if(!glhooks.m_HaveContextCreation)                                                  \
       return glhooks.GL.function(p1, p2, p3, p4, p5, p6);                               \
@@ -192,6 +199,7 @@
   typedef ret(WINAPI *CONCAT(function, _hooktype))(t1, t2, t3, t4, t5, t6, t7);                \
   static ret WINAPI CONCAT(function, _hooked)(t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7) \
   {                                                                                            \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                                \
     SCOPED_LOCK(glLock);                                                                       \
     if(!glhooks.m_HaveContextCreation)                                                         \
       return glhooks.GL.function(p1, p2, p3, p4, p5, p6, p7);                                  \
@@ -202,6 +210,7 @@
   typedef ret(WINAPI *CONCAT(function, _hooktype))(t1, t2, t3, t4, t5, t6, t7, t8);                   \
   static ret WINAPI CONCAT(function, _hooked)(t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7, t8 p8) \
   {                                                                                                   \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                                       \
     SCOPED_LOCK(glLock);                                                                              \
     if(!glhooks.m_HaveContextCreation)                                                                \
       return glhooks.GL.function(p1, p2, p3, p4, p5, p6, p7, p8);                                     \
@@ -214,6 +223,7 @@
   static ret WINAPI CONCAT(function, _hooked)(t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7,  \
                                               t8 p8, t9 p9)                                     \
   {                                                                                             \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                                 \
     SCOPED_LOCK(glLock);                                                                        \
     if(!glhooks.m_HaveContextCreation)                                                          \
       return glhooks.GL.function(p1, p2, p3, p4, p5, p6, p7, p8, p9);                           \
@@ -226,6 +236,7 @@
   static ret WINAPI CONCAT(function, _hooked)(t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7,   \
                                               t8 p8, t9 p9, t10 p10)                             \
   {                                                                                              \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                                  \
     SCOPED_LOCK(glLock);                                                                         \
     if(!glhooks.m_HaveContextCreation)                                                           \
       return glhooks.GL.function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10);                       \
@@ -238,6 +249,7 @@
   static ret WINAPI CONCAT(function, _hooked)(t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7,    \
                                               t8 p8, t9 p9, t10 p10, t11 p11)                     \
   {                                                                                               \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                                   \
     SCOPED_LOCK(glLock);                                                                          \
     if(!glhooks.m_HaveContextCreation)                                                            \
       return glhooks.GL.function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11);                   \
@@ -251,6 +263,7 @@
   static ret WINAPI CONCAT(function, _hooked)(t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7,    \
                                               t8 p8, t9 p9, t10 p10, t11 p11, t12 p12)            \
   {                                                                                               \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                                   \
     SCOPED_LOCK(glLock);                                                                          \
     if(!glhooks.m_HaveContextCreation)                                                            \
       return glhooks.GL.function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12);              \
@@ -265,6 +278,7 @@
   static ret WINAPI CONCAT(function, _hooked)(t1 p1, t2 p2, t3 p3, t4 p4, t5 p5, t6 p6, t7 p7,    \
                                               t8 p8, t9 p9, t10 p10, t11 p11, t12 p12, t13 p13)   \
   {                                                                                               \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                                   \
     SCOPED_LOCK(glLock);                                                                          \
     if(!glhooks.m_HaveContextCreation)                                                            \
       return glhooks.GL.function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13);         \
@@ -280,6 +294,7 @@
                                               t8 p8, t9 p9, t10 p10, t11 p11, t12 p12, t13 p13,  \
                                               t14 p14)                                           \
   {                                                                                              \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                                  \
     SCOPED_LOCK(glLock);                                                                         \
     if(!glhooks.m_HaveContextCreation)                                                           \
       return glhooks.GL.function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13, p14);   \
@@ -296,6 +311,7 @@
                                               t8 p8, t9 p9, t10 p10, t11 p11, t12 p12, t13 p13,     \
                                               t14 p14, t15 p15)                                     \
   {                                                                                                 \
+    SCOPED_API_CALL_STATS(STRINGIZE(function));                                                     \
     SCOPED_LOCK(glLock);                                                                            \
     if(!glhooks.m_HaveContextCreation)                                                              \
       return glhooks.GL.function(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13, p14, p15); \
@@ -947,6 +947,154 @@ bool GLResourceManager::Force_InitialState(GLResource res, bool prepare)
   return false;
 }
 
+void GLResourceManager::ReadbackInitialContents()
+{
+  const GLHookSet &gl = m_GL->GetHookset();
+
+  GLuint ppb = 0;
+  gl.glGetIntegerv(eGL_PIXEL_PACK_BUFFER_BINDING, (GLint *)&ppb);
+
+  PixelPackState pack;
+  pack.Fetch(&gl, false);
+
+  ResetPixelPackState(gl, false, 1);
+
+  for(auto it = m_InitialContents.begin(); it != m_InitialContents.end(); ++it)
+  {
+    ResourceId Id = it->first;
+    GLuint tex = it->second.resource.name;
+
+    if(it->second.resource.Namespace != eResTexture || tex == 0)
+      continue;
+
+    // only textures that will actually be serialised, see InsertInitialContentsChunks and
+    // Force_InitialState
+    if(m_FrameReferencedResources.find(Id) == m_FrameReferencedResources.end() &&
+       !RenderDoc::Inst().GetCaptureOptions().RefAllResources)
+    {
+      GLResourceRecord *record = GetResourceRecord(Id);
+      if(record == NULL || record->viewTextures.empty())
+        continue;
+    }
+
+    WrappedOpenGL::TextureData &details = m_GL->m_Textures[Id];
+
+    if(details.internalFormat == eGL_NONE || details.curType == eGL_TEXTURE_BUFFER ||
+       details.view || details.samples > 1)
+      continue;
+
+    GLenum t = details.curType;
+
+    int mips = GetNumMips(gl, t, tex, details.width, details.height, details.depth);
+
+    bool isCompressed = IsCompressedFormat(details.internalFormat);
+
+    GLenum fmt = GetBaseFormat(details.internalFormat);
+    GLenum type = GetDataType(details.internalFormat);
+
+    GLenum targets[] = {
+        eGL_TEXTURE_CUBE_MAP_POSITIVE_X, eGL_TEXTURE_CUBE_MAP_NEGATIVE_X,
+        eGL_TEXTURE_CUBE_MAP_POSITIVE_Y, eGL_TEXTURE_CUBE_MAP_NEGATIVE_Y,
+        eGL_TEXTURE_CUBE_MAP_POSITIVE_Z, eGL_TEXTURE_CUBE_MAP_NEGATIVE_Z,
+    };
+
+    int count = ARRAY_COUNT(targets);
+
+    if(t != eGL_TEXTURE_CUBE_MAP)
+    {
+      targets[0] = t;
+      count = 1;
+    }
+
+    bool arrayed =
+        (t == eGL_TEXTURE_CUBE_MAP_ARRAY || t == eGL_TEXTURE_1D_ARRAY || t == eGL_TEXTURE_2D_ARRAY);
+
+    // the sizes of each image, in the same order as Serialise_InitialState
+    vector<size_t> sizes;
+
+    for(int i = 0; i < mips; i++)
+    {
+      GLint w = RDCMAX(details.width >> i, 1);
+      GLint h = RDCMAX(details.height >> i, 1);
+      GLint d = arrayed ? details.depth : RDCMAX(details.depth >> i, 1);
+
+      size_t size = isCompressed ? GetCompressedByteSize(w, h, d, details.internalFormat)
+                                 : GetByteSize(w, h, d, fmt, type);
+
+      for(int trg = 0; trg < count; trg++)
+        sizes.push_back(size);
+    }
+
+    size_t total = 0;
+    for(size_t i = 0; i < sizes.size(); i++)
+      total += sizes[i];
+
+    if(total == 0)
+      continue;
+
+    GLuint pbo = 0;
+    gl.glGenBuffers(1, &pbo);
+    gl.glBindBuffer(eGL_PIXEL_PACK_BUFFER, pbo);
+    gl.glNamedBufferDataEXT(pbo, (GLsizeiptr)total, NULL, eGL_STREAM_READ);
+
+    GLuint prevtex = 0;
+    if(!isCompressed)
+    {
+      gl.glGetIntegerv(TextureBinding(t), (GLint *)&prevtex);
+      gl.glBindTexture(t, tex);
+    }
+
+    size_t offs = 0;
+
+    for(int i = 0, s = 0; i < mips; i++)
+    {
+      for(int trg = 0; trg < count; trg++)
+      {
+        // with a pixel pack buffer bound the pointer is an offset into it
+        void *dst = (void *)(uintptr_t)offs;
+
+        if(isCompressed)
+          gl.glGetCompressedTextureImageEXT(tex, targets[trg], i, dst);
+        else
+          gl.glGetTexImage(targets[trg], i, fmt, type, dst);
+
+        offs += sizes[s++];
+      }
+    }
+
+    if(!isCompressed)
+      gl.glBindTexture(t, prevtex);
+
+    m_InitialReadbacks[Id] = pbo;
+  }
+
+  gl.glBindBuffer(eGL_PIXEL_PACK_BUFFER, ppb);
+
+  pack.Apply(&gl, false);
+
+  // the buffer copies made in Prepare_InitialState are covered by the same fence
+  GLsync sync = gl.glFenceSync(eGL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+  if(sync)
+  {
+    GLenum status = eGL_TIMEOUT_EXPIRED;
+    while(status == eGL_TIMEOUT_EXPIRED)
+      status = gl.glClientWaitSync(sync, eGL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ULL);
+
+    gl.glDeleteSync(sync);
+  }
+}
+
+void GLResourceManager::FreeInitialContentsReadbacks()
+{
+  const GLHookSet &gl = m_GL->GetHookset();
+
+  for(auto it = m_InitialReadbacks.begin(); it != m_InitialReadbacks.end(); ++it)
+    gl.glDeleteBuffers(1, &it->second);
+
+  m_InitialReadbacks.clear();
+}
+
 bool GLResourceManager::Serialise_InitialState(ResourceId resid, GLResource res)
 {
   SERIALISE_ELEMENT(ResourceId, Id, GetID(res));
@@ -1127,6 +1275,22 @@ bool GLResourceManager::Serialise_InitialState(ResourceId resid, GLResource res)
 
         SERIALISE_ELEMENT(bool, isCompressed, IsCompressedFormat(details.internalFormat));
 
+        // if ReadbackInitialContents already fetched the images, serialise straight from there
+        byte *readback = NULL;
+        GLuint readbackBuf = 0;
+
+        {
+          auto it = m_InitialReadbacks.find(Id);
+          if(it != m_InitialReadbacks.end())
+          {
+            readbackBuf = it->second;
+            readback = (byte *)gl.glMapNamedBufferEXT(readbackBuf, eGL_READ_ONLY);
+
+            if(readback == NULL)
+              RDCERR("Couldn't map initial contents readback for %llu, reading back directly", Id);
+          }
+        }
+
         if(details.curType == eGL_TEXTURE_BUFFER || details.view)
         {
           // no contents to copy for texture buffer (it's copied under the buffer)
@@ -1162,6 +1326,14 @@ bool GLResourceManager::Serialise_InitialState(ResourceId resid, GLResource res)
             {
               size_t size = GetCompressedByteSize(w, h, d, details.internalFormat);
 
+              if(readback)
+              {
+                byte *src = readback;
+                m_pSerialiser->SerialiseBuffer("image", src, size);
+                readback += size;
+                continue;
+              }
+
               byte *buf = new byte[size];
 
               gl.glGetCompressedTextureImageEXT(tex, targets[trg], i, buf);
@@ -1190,7 +1362,7 @@ bool GLResourceManager::Serialise_InitialState(ResourceId resid, GLResource res)
 
           size_t size = GetByteSize(details.width, details.height, details.depth, fmt, type);
 
-          byte *buf = new byte[size];
+          byte *buf = readback ? NULL : new byte[size];
 
           GLenum binding = TextureBinding(t);
 
@@ -1227,6 +1399,14 @@ bool GLResourceManager::Serialise_InitialState(ResourceId resid, GLResource res)
 
             for(int trg = 0; trg < count; trg++)
             {
+              if(readback)
+              {
+                byte *src = readback;
+                m_pSerialiser->SerialiseBuffer("image", src, size);
+                readback += size;
+                continue;
+              }
+
               // we avoid glGetTextureImageEXT as it seems buggy for cubemap faces
               gl.glGetTexImage(targets[trg], i, fmt, type, buf);
 
@@ -1239,6 +1419,15 @@ bool GLResourceManager::Serialise_InitialState(ResourceId resid, GLResource res)
           SAFE_DELETE_ARRAY(buf);
         }
 
+        if(readbackBuf)
+        {
+          if(readback)
+            gl.glUnmapNamedBufferEXT(readbackBuf);
+
+          gl.glDeleteBuffers(1, &readbackBuf);
+          m_InitialReadbacks.erase(Id);
+        }
+
         gl.glBindBuffer(eGL_PIXEL_PACK_BUFFER, ppb);
 
         pack.Apply(&gl, false);
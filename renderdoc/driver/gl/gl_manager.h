@@ -212,6 +212,12 @@ public:
   bool Prepare_InitialState(GLResource res, byte *blob);
   bool Serialise_InitialState(ResourceId resid, GLResource res);
 
+  // reads back the texture initial contents that are going to be serialised into pixel pack
+  // buffers all at once, then waits on a single fence. That way Serialise_InitialState only maps
+  // finished data instead of stalling the pipeline for every texture.
+  void ReadbackInitialContents();
+  void FreeInitialContentsReadbacks();
+
 private:
   bool SerialisableResource(ResourceId id, GLResourceRecord *record);
 
@@ -236,5 +242,9 @@ private:
   map<ResourceId, std::string> m_Names;
   volatile int64_t m_SyncName;
 
+  // pixel pack buffers filled by ReadbackInitialContents, with each texture's images laid out in
+  // the order Serialise_InitialState writes them
+  map<ResourceId, GLuint> m_InitialReadbacks;
+
   WrappedOpenGL *m_GL;
 };
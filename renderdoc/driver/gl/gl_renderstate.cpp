@@ -400,6 +400,94 @@ byte *PixelUnpackState::UnpackCompressed(byte *pixels, GLsizei width, GLsizei he
   return ret;
 }
 
+GLTextureBindingShadow::GLTextureBindingShadow()
+{
+  valid = false;
+  RDCEraseEl(Textures);
+  RDCEraseEl(Samplers);
+}
+
+static int TextureBindingIndex(GLenum target)
+{
+  switch(target)
+  {
+    case eGL_TEXTURE_1D:
+    case eGL_TEXTURE_BINDING_1D: return GLTextureBindingShadow::eTex1D;
+    case eGL_TEXTURE_2D:
+    case eGL_TEXTURE_BINDING_2D: return GLTextureBindingShadow::eTex2D;
+    case eGL_TEXTURE_3D:
+    case eGL_TEXTURE_BINDING_3D: return GLTextureBindingShadow::eTex3D;
+    case eGL_TEXTURE_1D_ARRAY:
+    case eGL_TEXTURE_BINDING_1D_ARRAY: return GLTextureBindingShadow::eTex1DArray;
+    case eGL_TEXTURE_2D_ARRAY:
+    case eGL_TEXTURE_BINDING_2D_ARRAY: return GLTextureBindingShadow::eTex2DArray;
+    case eGL_TEXTURE_CUBE_MAP_ARRAY:
+    case eGL_TEXTURE_BINDING_CUBE_MAP_ARRAY: return GLTextureBindingShadow::eTexCubeArray;
+    case eGL_TEXTURE_RECTANGLE:
+    case eGL_TEXTURE_BINDING_RECTANGLE: return GLTextureBindingShadow::eTexRect;
+    case eGL_TEXTURE_BUFFER:
+    case eGL_TEXTURE_BINDING_BUFFER: return GLTextureBindingShadow::eTexBuffer;
+    case eGL_TEXTURE_CUBE_MAP:
+    case eGL_TEXTURE_BINDING_CUBE_MAP: return GLTextureBindingShadow::eTexCube;
+    case eGL_TEXTURE_2D_MULTISAMPLE:
+    case eGL_TEXTURE_BINDING_2D_MULTISAMPLE: return GLTextureBindingShadow::eTex2DMS;
+    case eGL_TEXTURE_2D_MULTISAMPLE_ARRAY:
+    case eGL_TEXTURE_BINDING_2D_MULTISAMPLE_ARRAY: return GLTextureBindingShadow::eTex2DMSArray;
+    default: break;
+  }
+
+  return -1;
+}
+
+void GLTextureBindingShadow::BindTexture(uint32_t unit, GLenum target, GLuint texture)
+{
+  if(unit >= ARRAY_COUNT(Samplers))
+    return;
+
+  int idx = TextureBindingIndex(target);
+
+  // a target we don't track (e.g. external images), or a texture whose type we don't know. Fall
+  // back to querying next time
+  if(idx < 0)
+  {
+    valid = false;
+    return;
+  }
+
+  Textures[idx][unit] = texture;
+}
+
+void GLTextureBindingShadow::UnbindUnit(uint32_t unit)
+{
+  if(unit >= ARRAY_COUNT(Samplers))
+    return;
+
+  for(int t = 0; t < eTex_Count; t++)
+    Textures[t][unit] = 0;
+}
+
+void GLTextureBindingShadow::DeleteTexture(GLuint texture)
+{
+  // deleting a texture unbinds it everywhere it's bound in the current context
+  for(int t = 0; t < eTex_Count; t++)
+    for(size_t i = 0; i < ARRAY_COUNT(Samplers); i++)
+      if(Textures[t][i] == texture)
+        Textures[t][i] = 0;
+}
+
+void GLTextureBindingShadow::BindSampler(uint32_t unit, GLuint sampler)
+{
+  if(unit < ARRAY_COUNT(Samplers))
+    Samplers[unit] = sampler;
+}
+
+void GLTextureBindingShadow::DeleteSampler(GLuint sampler)
+{
+  for(size_t i = 0; i < ARRAY_COUNT(Samplers); i++)
+    if(Samplers[i] == sampler)
+      Samplers[i] = 0;
+}
+
 GLRenderState::GLRenderState(const GLHookSet *funcs, Serialiser *ser, LogState state)
     : m_Real(funcs), m_pSerialiser(ser), m_State(state)
 {
@@ -720,38 +808,63 @@ void GLRenderState::FetchState(void *ctx, WrappedOpenGL *gl)
           sizeof(Tex2DMSArray) == sizeof(Samplers),
       "All texture arrays should be identically sized");
 
-  for(GLuint i = 0; i < RDCMIN(maxTextures, (GLuint)ARRAY_COUNT(Tex2D)); i++)
+  GLTextureBindingShadow *shadow = gl ? gl->GetTextureBindingShadow() : NULL;
+
+  // in the same order as the shadow's arrays
+  uint32_t *texArrays[GLTextureBindingShadow::eTex_Count] = {
+      Tex1D,   Tex2D,     Tex3D,   Tex1DArray, Tex2DArray,   TexCubeArray,
+      TexRect, TexBuffer, TexCube, Tex2DMS,    Tex2DMSArray,
+  };
+
+  if(shadow && shadow->valid)
   {
-    m_Real->glActiveTexture(GLenum(eGL_TEXTURE0 + i));
-    if(!IsGLES)
-      m_Real->glGetIntegerv(eGL_TEXTURE_BINDING_1D, (GLint *)&Tex1D[i]);
-    else
-      Tex1D[i] = 0;
-    m_Real->glGetIntegerv(eGL_TEXTURE_BINDING_2D, (GLint *)&Tex2D[i]);
-    m_Real->glGetIntegerv(eGL_TEXTURE_BINDING_3D, (GLint *)&Tex3D[i]);
-    if(!IsGLES)
-      m_Real->glGetIntegerv(eGL_TEXTURE_BINDING_1D_ARRAY, (GLint *)&Tex1DArray[i]);
-    else
-      Tex1DArray[i] = 0;
-    m_Real->glGetIntegerv(eGL_TEXTURE_BINDING_2D_ARRAY, (GLint *)&Tex2DArray[i]);
-    m_Real->glGetIntegerv(eGL_TEXTURE_BINDING_CUBE_MAP, (GLint *)&TexCube[i]);
-    if(!IsGLES)
-      m_Real->glGetIntegerv(eGL_TEXTURE_BINDING_RECTANGLE, (GLint *)&TexRect[i]);
-    else
-      TexRect[i] = 0;
-    m_Real->glGetIntegerv(eGL_TEXTURE_BINDING_BUFFER, (GLint *)&TexBuffer[i]);
-    m_Real->glGetIntegerv(eGL_TEXTURE_BINDING_2D_MULTISAMPLE, (GLint *)&Tex2DMS[i]);
-    m_Real->glGetIntegerv(eGL_TEXTURE_BINDING_2D_MULTISAMPLE_ARRAY, (GLint *)&Tex2DMSArray[i]);
+    for(int t = 0; t < GLTextureBindingShadow::eTex_Count; t++)
+      memcpy(texArrays[t], shadow->Textures[t], sizeof(Tex2D));
+    memcpy(Samplers, shadow->Samplers, sizeof(Samplers));
+  }
+  else
+  {
+    for(GLuint i = 0; i < RDCMIN(maxTextures, (GLuint)ARRAY_COUNT(Tex2D)); i++)
+    {
+      m_Real->glActiveTexture(GLenum(eGL_TEXTURE0 + i));
+      if(!IsGLES)
+        m_Real->glGetIntegerv(eGL_TEXTURE_BINDING_1D, (GLint *)&Tex1D[i]);
+      else
+        Tex1D[i] = 0;
+      m_Real->glGetIntegerv(eGL_TEXTURE_BINDING_2D, (GLint *)&Tex2D[i]);
+      m_Real->glGetIntegerv(eGL_TEXTURE_BINDING_3D, (GLint *)&Tex3D[i]);
+      if(!IsGLES)
+        m_Real->glGetIntegerv(eGL_TEXTURE_BINDING_1D_ARRAY, (GLint *)&Tex1DArray[i]);
+      else
+        Tex1DArray[i] = 0;
+      m_Real->glGetIntegerv(eGL_TEXTURE_BINDING_2D_ARRAY, (GLint *)&Tex2DArray[i]);
+      m_Real->glGetIntegerv(eGL_TEXTURE_BINDING_CUBE_MAP, (GLint *)&TexCube[i]);
+      if(!IsGLES)
+        m_Real->glGetIntegerv(eGL_TEXTURE_BINDING_RECTANGLE, (GLint *)&TexRect[i]);
+      else
+        TexRect[i] = 0;
+      m_Real->glGetIntegerv(eGL_TEXTURE_BINDING_BUFFER, (GLint *)&TexBuffer[i]);
+      m_Real->glGetIntegerv(eGL_TEXTURE_BINDING_2D_MULTISAMPLE, (GLint *)&Tex2DMS[i]);
+      m_Real->glGetIntegerv(eGL_TEXTURE_BINDING_2D_MULTISAMPLE_ARRAY, (GLint *)&Tex2DMSArray[i]);
 
-    if(HasExt[ARB_texture_cube_map_array])
-      m_Real->glGetIntegerv(eGL_TEXTURE_BINDING_CUBE_MAP_ARRAY, (GLint *)&TexCubeArray[i]);
-    else
-      TexCubeArray[i] = 0;
+      if(HasExt[ARB_texture_cube_map_array])
+        m_Real->glGetIntegerv(eGL_TEXTURE_BINDING_CUBE_MAP_ARRAY, (GLint *)&TexCubeArray[i]);
+      else
+        TexCubeArray[i] = 0;
 
-    if(HasExt[ARB_sampler_objects])
-      m_Real->glGetIntegerv(eGL_SAMPLER_BINDING, (GLint *)&Samplers[i]);
-    else
-      Samplers[i] = 0;
+      if(HasExt[ARB_sampler_objects])
+        m_Real->glGetIntegerv(eGL_SAMPLER_BINDING, (GLint *)&Samplers[i]);
+      else
+        Samplers[i] = 0;
+    }
+
+    if(shadow)
+    {
+      for(int t = 0; t < GLTextureBindingShadow::eTex_Count; t++)
+        memcpy(shadow->Textures[t], texArrays[t], sizeof(Tex2D));
+      memcpy(shadow->Samplers, Samplers, sizeof(Samplers));
+      shadow->valid = true;
+    }
   }
 
   if(HasExt[ARB_shader_image_load_store])
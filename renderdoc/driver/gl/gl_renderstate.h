@@ -68,6 +68,43 @@ struct PixelUnpackState : public PixelStorageState
 void ResetPixelPackState(const GLHookSet &gl, bool compressed, GLint alignment);
 void ResetPixelUnpackState(const GLHookSet &gl, bool compressed, GLint alignment);
 
+// the texture and sampler bound to each unit, laid out as in GLRenderState. While capturing,
+// WrappedOpenGL keeps one of these per context up to date as binding calls pass through, so
+// FetchState can copy it instead of switching to every unit and querying each target.
+struct GLTextureBindingShadow
+{
+  GLTextureBindingShadow();
+
+  enum
+  {
+    eTex1D,
+    eTex2D,
+    eTex3D,
+    eTex1DArray,
+    eTex2DArray,
+    eTexCubeArray,
+    eTexRect,
+    eTexBuffer,
+    eTexCube,
+    eTex2DMS,
+    eTex2DMSArray,
+    eTex_Count,
+  };
+
+  // the bindings aren't known until they've been queried once
+  bool valid;
+
+  uint32_t Textures[eTex_Count][128];
+  uint32_t Samplers[128];
+
+  // target can be a texture target or a binding, as stored in a texture record's datatype
+  void BindTexture(uint32_t unit, GLenum target, GLuint texture);
+  void UnbindUnit(uint32_t unit);
+  void DeleteTexture(GLuint texture);
+  void BindSampler(uint32_t unit, GLuint sampler);
+  void DeleteSampler(GLuint sampler);
+};
+
 struct GLRenderState
 {
   GLRenderState(const GLHookSet *funcs, Serialiser *ser, LogState state);
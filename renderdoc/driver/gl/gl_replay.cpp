@@ -24,6 +24,7 @@
  ******************************************************************************/
 
 #include "gl_replay.h"
+#include "common/profiler.h"
 #include "maths/matrix.h"
 #include "serialise/string_utils.h"
 #include "gl_driver.h"
@@ -75,16 +76,36 @@ void GLReplay::Shutdown()
 
 void GLReplay::ReadLogInitialisation()
 {
+  SCOPED_PROFILE("GLReplay::ReadLogInitialisation");
   MakeCurrentReplayContext(&m_ReplayCtx);
   m_pDriver->ReadLogInitialisation();
 }
 
 void GLReplay::ReplayLog(uint32_t endEventID, ReplayLogType replayType)
 {
+  SCOPED_PROFILE("GLReplay::ReplayLog", endEventID);
   MakeCurrentReplayContext(&m_ReplayCtx);
   m_pDriver->ReplayLog(0, endEventID, replayType);
 }
 
+bool GLReplay::AdvanceReplay(uint32_t fromEventID, uint32_t toEventID)
+{
+  SCOPED_PROFILE("GLReplay::AdvanceReplay", toEventID);
+
+  if(fromEventID == 0 || toEventID <= fromEventID)
+    return false;
+
+  // a partial replay carries on from the context's current state
+  MakeCurrentReplayContext(&m_ReplayCtx);
+  m_pDriver->ReplayLog(fromEventID, toEventID - 1, eReplay_Full);
+  return true;
+}
+
+void GLReplay::SetPrunedEvents(const vector<uint32_t> &eventIDs)
+{
+  m_pDriver->SetPrunedEvents(eventIDs);
+}
+
 vector<uint32_t> GLReplay::GetPassEvents(uint32_t eventID)
 {
   vector<uint32_t> passEvents;
@@ -411,14 +432,72 @@ void GLReplay::GetBufferData(ResourceId buff, uint64_t offset, uint64_t len, vec
 
   WrappedOpenGL &gl = *m_pDriver;
 
-  GLuint oldbuf = 0;
-  gl.glGetIntegerv(eGL_COPY_READ_BUFFER_BINDING, (GLint *)&oldbuf);
+  // copy on the GPU into the readback buffer, then only wait for that copy rather than having
+  // glGetBufferSubData stall the whole pipeline
+  GLuint readback = GetReadbackBuffer((size_t)len);
+
+  gl.glNamedCopyBufferSubDataEXT(buf.resource.name, readback, (GLintptr)offset, 0,
+                                 (GLsizeiptr)len);
+
+  FinishReadback((size_t)len, &ret[0]);
+}
+
+GLuint GLReplay::GetReadbackBuffer(size_t size)
+{
+  WrappedOpenGL &gl = *m_pDriver;
+
+  if(DebugData.readbackBuffer == 0)
+    gl.glGenBuffers(1, &DebugData.readbackBuffer);
+
+  if(size > DebugData.readbackBufferSize)
+  {
+    // round up so a run of slightly bigger readbacks doesn't reallocate each time
+    DebugData.readbackBufferSize = AlignUp(size, (size_t)(1024 * 1024));
+
+    GLuint prevbuf = 0;
+    gl.glGetIntegerv(eGL_PIXEL_PACK_BUFFER_BINDING, (GLint *)&prevbuf);
+
+    gl.glBindBuffer(eGL_PIXEL_PACK_BUFFER, DebugData.readbackBuffer);
+    gl.glNamedBufferDataEXT(DebugData.readbackBuffer, (GLsizeiptr)DebugData.readbackBufferSize,
+                            NULL, eGL_STREAM_READ);
+
+    gl.glBindBuffer(eGL_PIXEL_PACK_BUFFER, prevbuf);
+  }
+
+  return DebugData.readbackBuffer;
+}
+
+void GLReplay::FinishReadback(size_t size, byte *dst)
+{
+  WrappedOpenGL &gl = *m_pDriver;
+
+  // the fence is internal, so create it directly rather than registering it as a resource
+  const GLHookSet &real = gl.GetHookset();
 
-  gl.glBindBuffer(eGL_COPY_READ_BUFFER, buf.resource.name);
+  GLsync sync = real.glFenceSync(eGL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 
-  gl.glGetBufferSubData(eGL_COPY_READ_BUFFER, (GLintptr)offset, (GLsizeiptr)len, &ret[0]);
+  if(sync)
+  {
+    GLenum status = eGL_TIMEOUT_EXPIRED;
+    while(status == eGL_TIMEOUT_EXPIRED)
+      status = real.glClientWaitSync(sync, eGL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ULL);
 
-  gl.glBindBuffer(eGL_COPY_READ_BUFFER, oldbuf);
+    real.glDeleteSync(sync);
+  }
+
+  byte *src = (byte *)gl.glMapNamedBufferRangeEXT(DebugData.readbackBuffer, 0, (GLsizeiptr)size,
+                                                  GL_MAP_READ_BIT);
+
+  if(src)
+  {
+    memcpy(dst, src, size);
+    gl.glUnmapNamedBufferEXT(DebugData.readbackBuffer);
+  }
+  else
+  {
+    RDCERR("Couldn't map readback buffer");
+    memset(dst, 0, size);
+  }
 }
 
 bool GLReplay::IsRenderOutput(ResourceId id)
@@ -451,6 +530,11 @@ TextureDescription GLReplay::GetTexture(ResourceId id)
 void GLReplay::CacheTexture(ResourceId id)
 {
   TextureDescription tex;
+  tex.placeholderInitialContents = false;
+  // GL doesn't expose allocation details, the size is estimated from the storage below. Texture
+  // buffers share their buffer's storage so they don't count any themselves
+  tex.allocationSize = 0;
+  tex.allocationAlignment = 0;
 
   MakeCurrentReplayContext(&m_ReplayCtx);
 
@@ -526,6 +610,7 @@ void GLReplay::CacheTexture(ResourceId id)
 
     tex.name = str;
 
+    tex.allocationSize = tex.byteSize;
     m_CachedTextures[id] = tex;
     return;
   }
@@ -738,6 +823,7 @@ void GLReplay::CacheTexture(ResourceId id)
     }
   }
 
+  tex.allocationSize = tex.byteSize;
   m_CachedTextures[id] = tex;
 }
 
@@ -806,6 +892,8 @@ BufferDescription GLReplay::GetBuffer(ResourceId id)
   }
 
   ret.length = size;
+  ret.allocationSize = ret.length;
+  ret.allocationAlignment = 0;
 
   if(res.size == 0)
   {
@@ -835,11 +923,118 @@ vector<DebugMessage> GLReplay::GetDebugMessages()
   return m_pDriver->GetDebugMessages();
 }
 
+static uint64_t GetBuffersSize(WrappedOpenGL &gl, const GLuint *bufs, size_t num, uint64_t &count)
+{
+  uint64_t ret = 0;
+
+  for(size_t i = 0; i < num; i++)
+  {
+    if(bufs[i] == 0)
+      continue;
+
+    GLint bufsize = 0;
+    gl.glGetNamedBufferParameterivEXT(bufs[i], eGL_BUFFER_SIZE, &bufsize);
+    ret += (uint64_t)bufsize;
+    count++;
+  }
+
+  return ret;
+}
+
+vector<MemoryUsage> GLReplay::GetMemoryUsage()
+{
+  vector<MemoryUsage> ret;
+
+  MakeCurrentReplayContext(&m_ReplayCtx);
+
+  WrappedOpenGL &gl = *m_pDriver;
+
+  ret.push_back(MakeMemoryUsage("Capture data", false, 1, m_pDriver->GetSerialiser()->GetSize()));
+
+  ret.push_back(MakeMemoryUsage("Initial contents", true,
+                                m_pDriver->GetResourceManager()->NumInitialContents(),
+                                m_pDriver->GetFrameRecord().frameInfo.initDataSize));
+
+  uint64_t count = 0, bytes = 0;
+  for(auto it = m_pDriver->m_Shaders.begin(); it != m_pDriver->m_Shaders.end(); ++it)
+  {
+    const WrappedOpenGL::ShaderData &shad = it->second;
+
+    count++;
+    bytes += GetShaderReflectionSize(shad.reflection);
+    bytes += shad.spirv.spirv.size() * sizeof(uint32_t);
+    for(size_t i = 0; i < shad.sources.size(); i++)
+      bytes += shad.sources[i].size();
+  }
+  ret.push_back(MakeMemoryUsage("Shader reflection", false, count, bytes));
+
+  ret.push_back(MakeMemoryUsage("Post-VS data", true, m_PostVSCache.NumEvents(),
+                                m_PostVSCache.GetStats().bytes));
+
+  // overlays are RGBA16 (or smaller on GLES), custom shader textures are RGBA16F with a full mip
+  // chain
+  count = 0;
+  bytes = 0;
+  if(DebugData.overlayTex)
+  {
+    count++;
+    bytes += uint64_t(DebugData.overlayTexWidth) * DebugData.overlayTexHeight *
+             RDCMAX(1, DebugData.overlayTexSamples) * 8;
+  }
+  if(DebugData.customTex)
+  {
+    GLint w = 0, h = 0, maxlevel = 0;
+    gl.glGetTextureLevelParameterivEXT(DebugData.customTex, eGL_TEXTURE_2D, 0, eGL_TEXTURE_WIDTH,
+                                       &w);
+    gl.glGetTextureLevelParameterivEXT(DebugData.customTex, eGL_TEXTURE_2D, 0, eGL_TEXTURE_HEIGHT,
+                                       &h);
+    gl.glGetTextureParameterivEXT(DebugData.customTex, eGL_TEXTURE_2D, eGL_TEXTURE_MAX_LEVEL,
+                                  &maxlevel);
+
+    count++;
+    for(GLint i = 0; i <= maxlevel; i++)
+      bytes += uint64_t(RDCMAX(1, w >> i)) * RDCMAX(1, h >> i) * 8;
+  }
+  ret.push_back(MakeMemoryUsage("Overlays", true, count, bytes));
+
+  count = 0;
+  GLuint readback[] = {DebugData.minmaxTileResult, DebugData.minmaxResult, DebugData.histogramBuf,
+                       DebugData.pickResultBuf};
+  bytes = GetBuffersSize(gl, readback, ARRAY_COUNT(readback), count);
+  if(DebugData.pickPixelTex)
+  {
+    count++;
+    bytes += sizeof(Vec4f);
+  }
+  ret.push_back(MakeMemoryUsage("Readback", true, count, bytes));
+
+  count = 0;
+  bytes = 0;
+  if(DebugData.feedbackBuffer)
+  {
+    count++;
+    bytes += DebugData.feedbackBufferSize;
+  }
+  if(DebugData.pickIBBuf)
+  {
+    count++;
+    bytes += DebugData.pickIBSize;
+  }
+  if(DebugData.pickVBBuf)
+  {
+    count++;
+    bytes += DebugData.pickVBSize;
+  }
+  ret.push_back(MakeMemoryUsage("Mesh data", true, count, bytes));
+
+  return ret;
+}
+
 ShaderReflection *GLReplay::GetShader(ResourceId shader, string entryPoint)
 {
   auto &shaderDetails = m_pDriver->m_Shaders[shader];
 
-  if(shaderDetails.prog == 0)
+  if(shaderDetails.prog == 0 && !shaderDetails.progDeferred)
   {
     RDCERR("Can't get shader details without separable program");
     return NULL;
@@ -2197,6 +2392,7 @@ void GLReplay::FillCBufferVariables(ResourceId shader, string entryPoint, uint32
 byte *GLReplay::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
                                const GetTextureDataParams &params, size_t &dataSize)
 {
+  SCOPED_PROFILE("GLReplay::GetTextureData");
   WrappedOpenGL &gl = *m_pDriver;
 
   auto &texDetails = m_pDriver->m_Textures[tex];
@@ -2473,6 +2669,10 @@ byte *GLReplay::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
     GLuint prevtex = 0;
     gl.glGetIntegerv(binding, (GLint *)&prevtex);
 
+    // readbacks go through a pixel pack buffer, so the pointers below are offsets into it
+    GLuint prevpack = 0;
+    gl.glGetIntegerv(eGL_PIXEL_PACK_BUFFER_BINDING, (GLint *)&prevpack);
+
     gl.glBindTexture(texType, texname);
 
     GLenum target = texType;
@@ -2525,7 +2725,9 @@ byte *GLReplay::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
         if(m_GetTexturePrevData[mip] == NULL)
         {
           m_GetTexturePrevData[mip] = new byte[dataSize * arraysize];
-          gl.glGetCompressedTexImage(target, mip, m_GetTexturePrevData[mip]);
+          gl.glBindBuffer(eGL_PIXEL_PACK_BUFFER, GetReadbackBuffer(dataSize * arraysize));
+          gl.glGetCompressedTexImage(target, mip, NULL);
+          FinishReadback(dataSize * arraysize, m_GetTexturePrevData[mip]);
         }
 
         // now copy the slice from the cache into ret
@@ -2537,7 +2739,9 @@ byte *GLReplay::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
       else
       {
         // for non-arrays we can just readback without caching
-        gl.glGetCompressedTexImage(target, mip, ret);
+        gl.glBindBuffer(eGL_PIXEL_PACK_BUFFER, GetReadbackBuffer(dataSize));
+        gl.glGetCompressedTexImage(target, mip, NULL);
+        FinishReadback(dataSize, ret);
       }
     }
     else
@@ -2569,7 +2773,9 @@ byte *GLReplay::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
         if(m_GetTexturePrevData[mip] == NULL)
         {
           m_GetTexturePrevData[mip] = new byte[dataSize * arraysize];
-          gl.glGetTexImage(target, (GLint)mip, fmt, type, m_GetTexturePrevData[mip]);
+          gl.glBindBuffer(eGL_PIXEL_PACK_BUFFER, GetReadbackBuffer(dataSize * arraysize));
+          gl.glGetTexImage(target, (GLint)mip, fmt, type, NULL);
+          FinishReadback(dataSize * arraysize, m_GetTexturePrevData[mip]);
         }
 
         // now copy the slice from the cache into ret
@@ -2580,7 +2786,9 @@ byte *GLReplay::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
       }
       else
       {
-        gl.glGetTexImage(target, (GLint)mip, fmt, type, ret);
+        gl.glBindBuffer(eGL_PIXEL_PACK_BUFFER, GetReadbackBuffer(dataSize));
+        gl.glGetTexImage(target, (GLint)mip, fmt, type, NULL);
+        FinishReadback(dataSize, ret);
       }
 
       // if we're saving to disk we make the decision to vertically flip any non-compressed
@@ -2624,6 +2832,8 @@ byte *GLReplay::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
 
     unpack.Apply(&gl.GetHookset(), true);
 
+    gl.glBindBuffer(eGL_PIXEL_PACK_BUFFER, prevpack);
+
     gl.glBindTexture(texType, prevtex);
   }
 
@@ -2633,6 +2843,13 @@ byte *GLReplay::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
   return ret;
 }
 
+vector<TextureThumbnail> GLReplay::GetTextureThumbnails(
+    const vector<TextureThumbnailRequest> &textures, uint32_t size)
+{
+  SCOPED_PROFILE("GLReplay::GetTextureThumbnails");
+  return FetchTextureThumbnails(this, textures, size);
+}
+
 void GLReplay::BuildCustomShader(string source, string entry, const uint32_t compileFlags,
                                  ShaderStage type, ResourceId *id, string *errors)
 {
@@ -2844,12 +3061,14 @@ void GLReplay::BuildTargetShader(string source, string entry, const uint32_t com
 void GLReplay::ReplaceResource(ResourceId from, ResourceId to)
 {
   MakeCurrentReplayContext(&m_ReplayCtx);
+  DebugData.pickCache.Invalidate();
   m_pDriver->ReplaceResource(from, to);
 }
 
 void GLReplay::RemoveReplacement(ResourceId id)
 {
   MakeCurrentReplayContext(&m_ReplayCtx);
+  DebugData.pickCache.Invalidate();
   m_pDriver->RemoveReplacement(id);
 }
 
@@ -3230,6 +3449,13 @@ vector<EventUsage> GLReplay::GetUsage(ResourceId id)
 
 #pragma endregion
 
+vector<TextureSamplingFeedback> GLReplay::FetchTextureSampling(uint32_t startEventID,
+                                                               uint32_t endEventID)
+{
+  GLNOTIMP("GLReplay::FetchTextureSampling");
+  return vector<TextureSamplingFeedback>();
+}
+
 vector<PixelModification> GLReplay::PixelHistory(vector<EventUsage> events, ResourceId target,
                                                  uint32_t x, uint32_t y, uint32_t slice,
                                                  uint32_t mip, uint32_t sampleIdx, CompType typeHint)
@@ -3238,6 +3464,14 @@ vector<PixelModification> GLReplay::PixelHistory(vector<EventUsage> events, Reso
   return vector<PixelModification>();
 }
 
+vector<vector<PixelModification> > GLReplay::PixelHistoryRegion(
+    vector<EventUsage> events, ResourceId target, uint32_t x, uint32_t y, uint32_t width,
+    uint32_t height, uint32_t slice, uint32_t mip, uint32_t sampleIdx, CompType typeHint)
+{
+  GLNOTIMP("GLReplay::PixelHistoryRegion");
+  return vector<vector<PixelModification> >(width * height);
+}
+
 ShaderDebugTrace GLReplay::DebugVertex(uint32_t eventID, uint32_t vertid, uint32_t instid,
                                        uint32_t idx, uint32_t instOffset, uint32_t vertOffset)
 {
@@ -3252,6 +3486,21 @@ ShaderDebugTrace GLReplay::DebugPixel(uint32_t eventID, uint32_t x, uint32_t y,
   return ShaderDebugTrace();
 }
 
+vector<ShaderDebugTrace> GLReplay::DebugVertices(uint32_t eventID,
+                                                 vector<ShaderDebugVertexInput> inputs,
+                                                 uint32_t instOffset, uint32_t vertOffset)
+{
+  GLNOTIMP("DebugVertices");
+  return vector<ShaderDebugTrace>(inputs.size());
+}
+
+vector<ShaderDebugTrace> GLReplay::DebugPixels(uint32_t eventID,
+                                               vector<ShaderDebugPixelInput> inputs)
+{
+  GLNOTIMP("DebugPixels");
+  return vector<ShaderDebugTrace>(inputs.size());
+}
+
 ShaderDebugTrace GLReplay::DebugThread(uint32_t eventID, const uint32_t groupid[3],
                                        const uint32_t threadid[3])
 {
@@ -27,6 +27,7 @@
 
 #include "api/replay/renderdoc_replay.h"
 #include "core/core.h"
+#include "replay/counter_provider.h"
 #include "replay/replay_driver.h"
 #include "gl_common.h"
 
@@ -102,6 +103,7 @@ public:
   ShaderReflection *GetShader(ResourceId shader, string entryPoint);
 
   vector<DebugMessage> GetDebugMessages();
+  vector<MemoryUsage> GetMemoryUsage();
 
   vector<EventUsage> GetUsage(ResourceId id);
 
@@ -116,6 +118,8 @@ public:
 
   void ReadLogInitialisation();
   void ReplayLog(uint32_t endEventID, ReplayLogType replayType);
+  bool AdvanceReplay(uint32_t fromEventID, uint32_t toEventID);
+  void SetPrunedEvents(const vector<uint32_t> &eventIDs);
 
   vector<uint32_t> GetPassEvents(uint32_t eventID);
 
@@ -157,6 +161,8 @@ public:
   void GetBufferData(ResourceId buff, uint64_t offset, uint64_t len, vector<byte> &ret);
   byte *GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
                        const GetTextureDataParams &params, size_t &dataSize);
+  vector<TextureThumbnail> GetTextureThumbnails(const vector<TextureThumbnailRequest> &textures,
+                                                uint32_t size);
 
   void ReplaceResource(ResourceId from, ResourceId to);
   void RemoveReplacement(ResourceId id);
@@ -165,6 +171,8 @@ public:
   void DescribeCounter(GPUCounter counterID, CounterDescription &desc);
   vector<CounterResult> FetchCounters(const vector<GPUCounter> &counters);
 
+  vector<TextureSamplingFeedback> FetchTextureSampling(uint32_t startEventID, uint32_t endEventID);
+
   void RenderMesh(uint32_t eventID, const vector<MeshFormat> &secondaryDraws, const MeshDisplay &cfg);
 
   void BuildTargetShader(string source, string entry, const uint32_t compileFlags, ShaderStage type,
@@ -192,10 +200,18 @@ public:
   vector<PixelModification> PixelHistory(vector<EventUsage> events, ResourceId target, uint32_t x,
                                          uint32_t y, uint32_t slice, uint32_t mip,
                                          uint32_t sampleIdx, CompType typeHint);
+  vector<vector<PixelModification> > PixelHistoryRegion(vector<EventUsage> events,
+                                                        ResourceId target, uint32_t x, uint32_t y,
+                                                        uint32_t width, uint32_t height,
+                                                        uint32_t slice, uint32_t mip,
+                                                        uint32_t sampleIdx, CompType typeHint);
   ShaderDebugTrace DebugVertex(uint32_t eventID, uint32_t vertid, uint32_t instid, uint32_t idx,
                                uint32_t instOffset, uint32_t vertOffset);
   ShaderDebugTrace DebugPixel(uint32_t eventID, uint32_t x, uint32_t y, uint32_t sample,
                               uint32_t primitive);
+  vector<ShaderDebugTrace> DebugVertices(uint32_t eventID, vector<ShaderDebugVertexInput> inputs,
+                                         uint32_t instOffset, uint32_t vertOffset);
+  vector<ShaderDebugTrace> DebugPixels(uint32_t eventID, vector<ShaderDebugPixelInput> inputs);
   ShaderDebugTrace DebugThread(uint32_t eventID, const uint32_t groupid[3],
                                const uint32_t threadid[3]);
   void PickPixel(ResourceId texture, uint32_t x, uint32_t y, uint32_t sliceFace, uint32_t mip,
@@ -286,6 +302,7 @@ private:
     float outWidth, outHeight;
 
     int glslVersion;
+    int glslCSVer;
 
     // min/max data
     GLuint minmaxTileResult;          // tile result buffer
@@ -312,6 +329,7 @@ private:
     GLuint meshPickProgram;
     GLuint pickIBBuf, pickVBBuf;
     uint32_t pickIBSize, pickVBSize;
+    MeshPickCache pickCache;
     GLuint pickResultBuf;
 
     GLuint MS2Array, Array2MS;
@@ -343,11 +361,18 @@ private:
     GLuint feedbackBuffer;
     uint32_t feedbackBufferSize = 32 * 1024 * 1024;
 
+    // pixel pack buffer that GetTextureData and GetBufferData read through. Created on first use
+    // and only ever grown, so repeated readbacks don't reallocate
+    GLuint readbackBuffer;
+    size_t readbackBufferSize;
+
     GLuint pickPixelTex;
     GLuint pickPixelFBO;
 
     GLuint quadoverdrawFSProg;
     GLuint quadoverdrawResolveProg;
+    // replacement fragment shader that sums a drawcall's quad coverage, for the quad counters
+    GLuint quadstatsFSProg;
 
     GLuint overlayTex;
     GLuint overlayFBO;
@@ -365,14 +390,25 @@ private:
 
   // eventID -> data
   map<uint32_t, GLPostVSData> m_PostVSData;
+  PostVSCacheTracker m_PostVSCache;
+
+  void CachePostVSBuffers(uint32_t eventID);
+  void CreatePostVSBuffers(uint32_t eventID);
+  void TrimPostVSCache(uint32_t eventID);
 
   // cache the previous data returned
   ResourceId m_GetTexturePrevID;
   byte *m_GetTexturePrevData[16];
 
+  GLuint GetReadbackBuffer(size_t size);
+  void FinishReadback(size_t size, byte *dst);
+
   void InitDebugData();
   void DeleteDebugData();
 
+  // the min/max and histogram programs are only compiled on first use, as there are many of them
+  void CreateHistogramPrograms(int texSlot, int intIdx);
+
   void CheckGLSLVersion(const char *sl, int &glslVersion);
 
   // called after the context is created, to init any counters
@@ -383,6 +419,14 @@ private:
   void FillTimers(GLCounterContext &ctx, const DrawcallTreeNode &drawnode,
                   const vector<GPUCounter> &counters);
 
+  // vendor hardware counters
+  CounterProviders m_CounterProviders;
+  void FillProviderSamples(uint32_t &eventStart, const DrawcallTreeNode &drawnode);
+  vector<CounterResult> FetchProviderCounters(const vector<GPUCounter> &counters);
+
+  // counters measured by replaying each drawcall with quadstatsFSProg
+  vector<CounterResult> FetchQuadCounters(const vector<GPUCounter> &counters);
+
   GLuint CreateShaderProgram(const vector<string> &vs, const vector<string> &fs,
                              const vector<string> &gs);
   GLuint CreateShaderProgram(const vector<string> &vs, const vector<string> &fs);
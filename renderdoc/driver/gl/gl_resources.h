@@ -206,6 +206,7 @@ struct GLResourceRecord : public ResourceRecord
   {
     RDCEraseEl(ShadowPtr);
     RDCEraseEl(Map);
+    ShadowWatch = NULL;
   }
 
   ~GLResourceRecord() { FreeShadowStorage(); }
@@ -235,17 +236,16 @@ struct GLResourceRecord : public ResourceRecord
   void FilterChunks(const ChunkFilter &filter)
   {
     LockChunks();
-    std::vector<std::map<int32_t, Chunk *>::iterator> deletions;
-    for(auto it = m_Chunks.begin(); it != m_Chunks.end(); ++it)
+    // compact the remaining chunks down in place, keeping them in order
+    size_t keep = 0;
+    for(size_t i = 0; i < m_Chunks.size(); i++)
     {
-      if(filter(it->second))
-        deletions.push_back(it);
-    }
-    for(size_t i = 0; i < deletions.size(); i++)
-    {
-      SAFE_DELETE(deletions[i]->second);
-      m_Chunks.erase(deletions[i]);
+      if(filter(m_Chunks[i].second))
+        SAFE_DELETE(m_Chunks[i].second);
+      else
+        m_Chunks[keep++] = m_Chunks[i];
     }
+    m_Chunks.resize(keep);
     UnlockChunks();
   }
 
@@ -274,17 +274,31 @@ struct GLResourceRecord : public ResourceRecord
 
   GLResource Resource;
 
-  void AllocShadowStorage(size_t size)
+  // if writeWatch is set, writes to the first shadow buffer are tracked per-page. It then gets
+  // whole pages to itself, so that protecting them can't affect any other allocation.
+  void AllocShadowStorage(size_t size, bool writeWatch = false)
   {
     if(ShadowPtr[0] == NULL)
     {
-      ShadowPtr[0] = Serialiser::AllocAlignedBuffer(size + sizeof(markerValue));
+      if(writeWatch)
+      {
+        size_t pageSize = WriteWatch::GetPageSize();
+        ShadowPtr[0] =
+            Serialiser::AllocAlignedBuffer(AlignUp(size + sizeof(markerValue), pageSize), pageSize);
+      }
+      else
+      {
+        ShadowPtr[0] = Serialiser::AllocAlignedBuffer(size + sizeof(markerValue));
+      }
       ShadowPtr[1] = Serialiser::AllocAlignedBuffer(size + sizeof(markerValue));
 
       memcpy(ShadowPtr[0] + size, markerValue, sizeof(markerValue));
       memcpy(ShadowPtr[1] + size, markerValue, sizeof(markerValue));
 
       ShadowSize = size;
+
+      if(writeWatch)
+        ShadowWatch = WriteWatch::Begin(ShadowPtr[0], size);
     }
   }
 
@@ -301,6 +315,9 @@ struct GLResourceRecord : public ResourceRecord
 
   void FreeShadowStorage()
   {
+    WriteWatch::End(ShadowWatch);
+    ShadowWatch = NULL;
+
     if(ShadowPtr[0] != NULL)
     {
       Serialiser::FreeAlignedBuffer(ShadowPtr[0]);
@@ -310,7 +327,10 @@ struct GLResourceRecord : public ResourceRecord
   }
 
   byte *GetShadowPtr(int p) { return ShadowPtr[p]; }
+  // NULL unless writes to the first shadow buffer are being tracked
+  WriteWatch::Region GetShadowWriteWatch() { return ShadowWatch; }
 private:
   byte *ShadowPtr[2];
   size_t ShadowSize;
+  WriteWatch::Region ShadowWatch;
 };
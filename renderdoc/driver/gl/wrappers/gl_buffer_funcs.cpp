@@ -393,8 +393,13 @@ void WrappedOpenGL::Common_glNamedBufferStorageEXT(ResourceId id, GLsizeiptr siz
           GL_MAP_WRITE_BIT | GL_MAP_FLUSH_EXPLICIT_BIT | GL_MAP_PERSISTENT_BIT);
       RDCASSERT(record->Map.persistentPtr);
 
+      // coherent maps are checked at every implicit sync point, so if enabled we track which
+      // pages of the shadow storage the application writes to and only diff those.
+      bool writeWatch = (flags & GL_MAP_COHERENT_BIT) &&
+                        RenderDoc::Inst().GetCaptureOptions().TrackCoherentMapWrites;
+
       // persistent maps always need both sets of shadow storage, so allocate up front.
-      record->AllocShadowStorage(size);
+      record->AllocShadowStorage(size, writeWatch);
 
       // ensure shadow pointers have up to date data for diffing
       memcpy(record->GetShadowPtr(0), data, size);
@@ -2491,12 +2496,43 @@ void WrappedOpenGL::PersistentMapMemoryBarrier(const set<GLResourceRecord *> &ma
   // this function iterates over all the maps, checking for any changes between
   // the shadow pointers, and propogates that to 'real' GL
 
+  vector<std::pair<size_t, size_t> > dirtyRanges;
+
   for(set<GLResourceRecord *>::const_iterator it = maps.begin(); it != maps.end(); ++it)
   {
     GLResourceRecord *record = *it;
 
     RDCASSERT(record && record->Map.persistentPtr);
 
+    // if writes are being tracked, only the pages written since the last check can differ
+    if(record->GetShadowWriteWatch())
+    {
+      WriteWatch::GetDirtyRanges(record->GetShadowWriteWatch(), dirtyRanges);
+
+      for(size_t i = 0; i < dirtyRanges.size(); i++)
+      {
+        size_t rangeStart = dirtyRanges[i].first;
+
+        size_t diffStart = 0, diffEnd = 0;
+        bool found = FindDiffRange(record->GetShadowPtr(0) + rangeStart,
+                                   record->GetShadowPtr(1) + rangeStart,
+                                   dirtyRanges[i].second - rangeStart, diffStart, diffEnd);
+        if(found)
+        {
+          diffStart += rangeStart;
+          diffEnd += rangeStart;
+
+          memcpy(record->GetShadowPtr(1) + diffStart, record->GetShadowPtr(0) + diffStart,
+                 diffEnd - diffStart);
+
+          glFlushMappedNamedBufferRangeEXT(record->Resource.name, GLintptr(diffStart),
+                                           GLsizeiptr(diffEnd - diffStart));
+        }
+      }
+
+      continue;
+    }
+
     size_t diffStart = 0, diffEnd = 0;
     bool found = FindDiffRange(record->GetShadowPtr(0), record->GetShadowPtr(1),
                                (size_t)record->Length, diffStart, diffEnd);
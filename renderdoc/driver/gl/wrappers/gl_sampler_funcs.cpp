@@ -156,6 +156,9 @@ void WrappedOpenGL::glBindSampler(GLuint unit, GLuint sampler)
 {
   m_Real.glBindSampler(unit, sampler);
 
+  if(m_State >= WRITING)
+    GetCtxData().m_TextureBindings.BindSampler(unit, sampler);
+
   if(m_State == WRITING_CAPFRAME)
   {
     SCOPED_SERIALISE_CONTEXT(BIND_SAMPLER);
@@ -205,6 +208,13 @@ void WrappedOpenGL::glBindSamplers(GLuint first, GLsizei count, const GLuint *sa
 {
   m_Real.glBindSamplers(first, count, samplers);
 
+  if(m_State >= WRITING)
+  {
+    GLTextureBindingShadow &shadow = GetCtxData().m_TextureBindings;
+    for(GLsizei i = 0; i < count; i++)
+      shadow.BindSampler(first + i, samplers ? samplers[i] : 0);
+  }
+
   if(m_State == WRITING_CAPFRAME)
   {
     SCOPED_SERIALISE_CONTEXT(BIND_SAMPLERS);
@@ -514,4 +524,11 @@ void WrappedOpenGL::glDeleteSamplers(GLsizei n, const GLuint *ids)
   }
 
   m_Real.glDeleteSamplers(n, ids);
+
+  if(m_State >= WRITING)
+  {
+    GLTextureBindingShadow &shadow = GetCtxData().m_TextureBindings;
+    for(GLsizei i = 0; i < n; i++)
+      shadow.DeleteSampler(ids[i]);
+  }
 }
@@ -29,8 +29,23 @@
 #include "driver/shaders/spirv/spirv_common.h"
 #include "serialise/string_utils.h"
 
+// defined in core/replay_proxy.cpp
+template <>
+void Serialiser::Serialise(const char *name, ShaderReflection &el);
+
 void WrappedOpenGL::ShaderData::Compile(WrappedOpenGL &gl)
 {
+  // shaders made with glCreateShaderProgram already have their program, otherwise if the
+  // reflection is cached the separable program is only made if something needs it
+  uint32_t reflHash = 0;
+  bool cacheable = (prog == 0 && gl.m_State < WRITING);
+
+  if(cacheable && gl.FetchCachedReflection(*this, reflHash))
+  {
+    progDeferred = true;
+    return;
+  }
+
   bool pointSizeUsed = false, clipDistanceUsed = false;
   if(type == eGL_VERTEX_SHADER)
     CheckVertexOutputUses(sources, pointSizeUsed, clipDistanceUsed);
@@ -86,9 +101,29 @@ void WrappedOpenGL::ShaderData::Compile(WrappedOpenGL &gl)
       reflection.DebugInfo.files[i].first = StringFormat::Fmt("source%u.glsl", (uint32_t)i);
       reflection.DebugInfo.files[i].second = sources[i];
     }
+
+    if(cacheable)
+      gl.CacheReflection(reflHash, reflection);
   }
 }
 
+GLuint WrappedOpenGL::ShaderData::GetProg(WrappedOpenGL &gl)
+{
+  if(prog == 0 && progDeferred)
+  {
+    progDeferred = false;
+
+    prog = MakeSeparableShaderProgram(gl, type, sources, NULL);
+
+    if(prog == 0)
+      RDCERR(
+          "Couldn't make separable program for shader via patching - functionality will be "
+          "broken.");
+  }
+
+  return prog;
+}
+
 #pragma region Shaders
 
 bool WrappedOpenGL::Serialise_glCreateShader(GLuint shader, GLenum type)
@@ -190,10 +225,11 @@ bool WrappedOpenGL::Serialise_glShaderSource(GLuint shader, GLsizei count,
     // Doing this means we support the case of recompiling a shader different ways
     // and relinking a program before use, which is still moderately crazy and
     // so people who do that should be moderately ashamed.
-    if(m_Shaders[liveId].prog)
+    if(m_Shaders[liveId].prog || m_Shaders[liveId].progDeferred)
     {
       m_Real.glDeleteProgram(m_Shaders[liveId].prog);
       m_Shaders[liveId].prog = 0;
+      m_Shaders[liveId].progDeferred = false;
       m_Shaders[liveId].spirv = SPVModule();
       m_Shaders[liveId].reflection = ShaderReflection();
     }
@@ -608,12 +644,226 @@ bool WrappedOpenGL::Serialise_glLinkProgram(GLuint program)
       }
     }
 
-    m_Real.glLinkProgram(GetResourceManager()->GetLiveResource(id).name);
+    ReplayLinkProgram(progid, GetResourceManager()->GetLiveResource(id).name);
   }
 
   return true;
 }
 
+struct ProgramBinaryCallbacks
+{
+  bool Create(uint32_t size, byte *data, vector<byte> **ret) const
+  {
+    RDCASSERT(ret);
+
+    *ret = new vector<byte>(data, data + size);
+
+    return true;
+  }
+
+  void Destroy(vector<byte> *blob) const { delete blob; }
+  uint32_t GetSize(vector<byte> *blob) const { return (uint32_t)blob->size(); }
+  byte *GetData(vector<byte> *blob) const { return blob->empty() ? NULL : &(*blob)[0]; }
+} ProgramBinaryCacheCallbacks;
+
+void WrappedOpenGL::AddProgramLinkState(ResourceId liveProg, const string &state)
+{
+  ProgramData &progDetails = m_Programs[liveProg];
+
+  progDetails.linkStateHash = strhash(state.c_str(), progDetails.linkStateHash);
+}
+
+uint32_t WrappedOpenGL::GetReplayDriverHash()
+{
+  if(m_ReplayDriverHash == 0)
+  {
+    const char *vendor = (const char *)m_Real.glGetString(eGL_VENDOR);
+    const char *renderer = (const char *)m_Real.glGetString(eGL_RENDERER);
+    const char *version = (const char *)m_Real.glGetString(eGL_VERSION);
+
+    m_ReplayDriverHash = strhash(vendor ? vendor : "");
+    m_ReplayDriverHash = strhash(renderer ? renderer : "", m_ReplayDriverHash);
+    m_ReplayDriverHash = strhash(version ? version : "", m_ReplayDriverHash);
+  }
+
+  return m_ReplayDriverHash;
+}
+
+uint32_t WrappedOpenGL::GetProgramBinaryHash(const ProgramData &prog)
+{
+  uint32_t hash = prog.linkStateHash ^ GetReplayDriverHash();
+
+  for(size_t i = 0; i < prog.shaders.size(); i++)
+  {
+    const ShaderData &shad = m_Shaders[prog.shaders[i]];
+
+    hash = strhash(StringFormat::Fmt("shader %u", shad.type).c_str(), hash);
+
+    for(size_t s = 0; s < shad.sources.size(); s++)
+      hash = strhash(shad.sources[s].c_str(), hash);
+
+    for(size_t s = 0; s < shad.includepaths.size(); s++)
+      hash = strhash(shad.includepaths[s].c_str(), hash);
+  }
+
+  return hash;
+}
+
+void WrappedOpenGL::ReplayLinkProgram(ResourceId liveProg, GLuint program)
+{
+  if(!m_ProgramBinaryCacheInit)
+  {
+    m_ProgramBinaryCacheInit = true;
+
+    GLint numFormats = 0;
+    if(m_Real.glGetProgramBinary && m_Real.glProgramBinary)
+      m_Real.glGetIntegerv(eGL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+
+    m_ProgramBinaryCacheEnabled =
+        numFormats > 0 && RenderDoc::Inst().GetConfigSetting("replay.programBinaryCache") != "0";
+
+    if(m_ProgramBinaryCacheEnabled)
+    {
+      m_ProgramBinaryCache.Open("glprograms.cache", m_ProgramBinaryCacheMagic,
+                                m_ProgramBinaryCacheVersion);
+    }
+  }
+
+  if(!m_ProgramBinaryCacheEnabled)
+  {
+    m_Real.glLinkProgram(program);
+    return;
+  }
+
+  uint32_t hash = GetProgramBinaryHash(m_Programs[liveProg]);
+
+  vector<byte> *cached = NULL;
+
+  if(m_ProgramBinaryCache.Find(hash, cached, ProgramBinaryCacheCallbacks) &&
+     cached->size() > sizeof(GLenum))
+  {
+    GLenum format = *(GLenum *)&(*cached)[0];
+
+    m_Real.glProgramBinary(program, format, &(*cached)[sizeof(GLenum)],
+                           GLsizei(cached->size() - sizeof(GLenum)));
+
+    GLint status = 0;
+    m_Real.glGetProgramiv(program, eGL_LINK_STATUS, &status);
+
+    if(status)
+      return;
+
+    // the driver rejected the binary, e.g. after an update that didn't change its version string.
+    // Link normally and replace it.
+    RDCDEBUG("Cached program binary rejected, linking program %u", program);
+  }
+
+  m_Real.glProgramParameteri(program, eGL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  m_Real.glLinkProgram(program);
+
+  GLint status = 0;
+  m_Real.glGetProgramiv(program, eGL_LINK_STATUS, &status);
+
+  if(!status)
+    return;
+
+  GLint length = 0;
+  m_Real.glGetProgramiv(program, eGL_PROGRAM_BINARY_LENGTH, &length);
+
+  if(length <= 0)
+    return;
+
+  vector<byte> *binary = new vector<byte>(sizeof(GLenum) + length);
+
+  GLenum format = eGL_NONE;
+  GLsizei written = 0;
+  m_Real.glGetProgramBinary(program, length, &written, &format, &(*binary)[sizeof(GLenum)]);
+
+  if(written <= 0)
+  {
+    delete binary;
+    return;
+  }
+
+  binary->resize(sizeof(GLenum) + written);
+  memcpy(&(*binary)[0], &format, sizeof(GLenum));
+
+  if(cached)
+    m_ProgramBinaryCache.Replace(hash, binary, ProgramBinaryCacheCallbacks);
+  else
+    m_ProgramBinaryCache.Insert(hash, binary);
+}
+
+bool WrappedOpenGL::FetchCachedReflection(ShaderData &shad, uint32_t &hash)
+{
+  if(!m_ReflectionCacheInit)
+  {
+    m_ReflectionCacheInit = true;
+
+    m_ReflectionCacheEnabled =
+        RenderDoc::Inst().GetConfigSetting("replay.shaderReflectionCache") != "0";
+
+    if(m_ReflectionCacheEnabled)
+      m_ReflectionCache.Open("glreflection.cache", m_ReflectionCacheMagic, m_ReflectionCacheVersion);
+  }
+
+  if(!m_ReflectionCacheEnabled)
+    return false;
+
+  hash = GetReplayDriverHash();
+  hash = strhash(StringFormat::Fmt("shader %u", shad.type).c_str(), hash);
+
+  for(size_t s = 0; s < shad.sources.size(); s++)
+    hash = strhash(shad.sources[s].c_str(), hash);
+  for(size_t i = 0; i < shad.includepaths.size(); i++)
+    hash = strhash(shad.includepaths[i].c_str(), hash);
+
+  vector<byte> *cached = NULL;
+
+  if(!m_ReflectionCache.Find(hash, cached, ProgramBinaryCacheCallbacks) || cached->empty())
+    return false;
+
+  Serialiser ser(cached->size(), &(*cached)[0], false);
+
+  ShaderReflection refl;
+  ser.Serialise("", refl);
+  ser.Serialise("", refl.DebugInfo.entryFile);
+
+  if(ser.HasError())
+    return false;
+
+  shad.reflection = refl;
+
+  return true;
+}
+
+void WrappedOpenGL::CacheReflection(uint32_t hash, ShaderReflection &refl)
+{
+  if(!m_ReflectionCacheEnabled)
+    return;
+
+  Serialiser ser(NULL, Serialiser::WRITING, false);
+
+  ser.Serialise("", refl);
+  ser.Serialise("", refl.DebugInfo.entryFile);
+
+  const byte *data = ser.GetRawPtr(0);
+  m_ReflectionCache.Insert(hash, new vector<byte>(data, data + (size_t)ser.GetOffset()));
+}
+
+void WrappedOpenGL::CloseProgramBinaryCache()
+{
+  if(m_ProgramBinaryCacheEnabled)
+    m_ProgramBinaryCache.Close(ProgramBinaryCacheCallbacks);
+
+  m_ProgramBinaryCacheEnabled = false;
+
+  if(m_ReflectionCacheEnabled)
+    m_ReflectionCache.Close(ProgramBinaryCacheCallbacks);
+
+  m_ReflectionCacheEnabled = false;
+}
+
 void WrappedOpenGL::glLinkProgram(GLuint program)
 {
   m_Real.glLinkProgram(program);
@@ -732,6 +982,9 @@ bool WrappedOpenGL::Serialise_glBindAttribLocation(GLuint program, GLuint index,
   if(m_State == READING)
   {
     m_Real.glBindAttribLocation(GetResourceManager()->GetLiveResource(id).name, idx, name.c_str());
+
+    AddProgramLinkState(GetResourceManager()->GetLiveID(id),
+                        StringFormat::Fmt("attrib %u %s", idx, name.c_str()));
   }
 
   return true;
@@ -767,6 +1020,9 @@ bool WrappedOpenGL::Serialise_glBindFragDataLocation(GLuint program, GLuint colo
   if(m_State == READING)
   {
     m_Real.glBindFragDataLocation(GetResourceManager()->GetLiveResource(id).name, col, name.c_str());
+
+    AddProgramLinkState(GetResourceManager()->GetLiveID(id),
+                        StringFormat::Fmt("frag %u %s", col, name.c_str()));
   }
 
   return true;
@@ -833,6 +1089,9 @@ bool WrappedOpenGL::Serialise_glBindFragDataLocationIndexed(GLuint program, GLui
   {
     m_Real.glBindFragDataLocationIndexed(GetResourceManager()->GetLiveResource(id).name, colNum,
                                          idx, name.c_str());
+
+    AddProgramLinkState(GetResourceManager()->GetLiveID(id),
+                        StringFormat::Fmt("frag %u %u %s", colNum, idx, name.c_str()));
   }
 
   return true;
@@ -884,6 +1143,12 @@ bool WrappedOpenGL::Serialise_glTransformFeedbackVaryings(GLuint program, GLsize
   {
     m_Real.glTransformFeedbackVaryings(GetResourceManager()->GetLiveResource(id).name, Count,
                                        varstrs, Mode);
+
+    string state = StringFormat::Fmt("xfb %u", Mode);
+    for(uint32_t c = 0; c < Count; c++)
+      state += " " + vars[c];
+
+    AddProgramLinkState(GetResourceManager()->GetLiveID(id), state);
   }
 
   SAFE_DELETE_ARRAY(vars);
@@ -921,6 +1186,9 @@ bool WrappedOpenGL::Serialise_glProgramParameteri(GLuint program, GLenum pname,
   if(m_State == READING)
   {
     m_Real.glProgramParameteri(GetResourceManager()->GetLiveResource(id).name, PName, Value);
+
+    AddProgramLinkState(GetResourceManager()->GetLiveID(id),
+                        StringFormat::Fmt("param %u %d", PName, Value));
   }
 
   return true;
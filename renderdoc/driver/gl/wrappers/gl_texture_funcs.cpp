@@ -182,6 +182,13 @@ void WrappedOpenGL::glDeleteTextures(GLsizei n, const GLuint *textures)
   }
 
   m_Real.glDeleteTextures(n, textures);
+
+  if(m_State >= WRITING)
+  {
+    GLTextureBindingShadow &shadow = GetCtxData().m_TextureBindings;
+    for(GLsizei i = 0; i < n; i++)
+      shadow.DeleteTexture(textures[i]);
+  }
 }
 
 bool WrappedOpenGL::Serialise_glBindTexture(GLenum target, GLuint texture)
@@ -226,6 +233,9 @@ void WrappedOpenGL::glBindTexture(GLenum target, GLuint texture)
 {
   m_Real.glBindTexture(target, texture);
 
+  if(m_State >= WRITING)
+    GetCtxData().m_TextureBindings.BindTexture(GetCtxData().m_TextureUnit, target, texture);
+
   if(texture != 0 && GetResourceManager()->GetID(TextureRes(GetCtx(), texture)) == ResourceId())
     return;
 
@@ -325,12 +335,38 @@ bool WrappedOpenGL::Serialise_glBindTextures(GLuint first, GLsizei count, const
   return true;
 }
 
+void WrappedOpenGL::UpdateTextureUnitShadow(GLuint unit, GLuint texture)
+{
+  GLTextureBindingShadow &shadow = GetCtxData().m_TextureBindings;
+
+  if(texture == 0)
+  {
+    shadow.UnbindUnit(unit);
+    return;
+  }
+
+  // there's no target given, so take it from the texture's type. If that's not known yet the
+  // shadow is invalidated
+  GLResource res = TextureRes(GetCtx(), texture);
+  GLenum target = eGL_NONE;
+  if(GetResourceManager()->HasResourceRecord(res))
+    target = GetResourceManager()->GetResourceRecord(res)->datatype;
+
+  shadow.BindTexture(unit, target, texture);
+}
+
 // glBindTextures doesn't provide a target, so can't be used to "init" a texture from glGenTextures
 // which makes our lives a bit easier
 void WrappedOpenGL::glBindTextures(GLuint first, GLsizei count, const GLuint *textures)
 {
   m_Real.glBindTextures(first, count, textures);
 
+  if(m_State >= WRITING)
+  {
+    for(GLsizei i = 0; i < count; i++)
+      UpdateTextureUnitShadow(first + i, textures ? textures[i] : 0);
+  }
+
   if(m_State == WRITING_CAPFRAME)
   {
     SCOPED_SERIALISE_CONTEXT(BIND_TEXTURES);
@@ -395,6 +431,9 @@ void WrappedOpenGL::glBindMultiTextureEXT(GLenum texunit, GLenum target, GLuint
 {
   m_Real.glBindMultiTextureEXT(texunit, target, texture);
 
+  if(m_State >= WRITING)
+    GetCtxData().m_TextureBindings.BindTexture(texunit - eGL_TEXTURE0, target, texture);
+
   if(texture != 0 && GetResourceManager()->GetID(TextureRes(GetCtx(), texture)) == ResourceId())
     return;
 
@@ -480,6 +519,9 @@ void WrappedOpenGL::glBindTextureUnit(GLuint unit, GLuint texture)
 {
   m_Real.glBindTextureUnit(unit, texture);
 
+  if(m_State >= WRITING)
+    UpdateTextureUnitShadow(unit, texture);
+
   if(texture != 0 && GetResourceManager()->GetID(TextureRes(GetCtx(), texture)) == ResourceId())
     return;
 
@@ -638,6 +680,9 @@ bool WrappedOpenGL::Serialise_glTextureView(GLuint texture, GLenum target, GLuin
     m_Textures[liveTexId].curType = TextureTarget(Target);
     m_Textures[liveTexId].internalFormat = InternalFormat;
     m_Textures[liveTexId].view = true;
+
+    m_AliasedResources.insert(liveTexId);
+    m_AliasedResources.insert(liveOrigId);
     m_Textures[liveTexId].width = m_Textures[liveOrigId].width;
     m_Textures[liveTexId].height = m_Textures[liveOrigId].height;
     m_Textures[liveTexId].depth = m_Textures[liveOrigId].depth;
@@ -4480,6 +4525,9 @@ void WrappedOpenGL::glMultiTexSubImage1DEXT(GLenum texunit, GLenum target, GLint
                                   level, xoffset, width, format, type, pixels);
 }
 
+// below this it's quicker to copy the pixels inline than to hand the copy to a worker
+static const size_t AsyncUploadCopyMinSize = 256 * 1024;
+
 bool WrappedOpenGL::Serialise_glTextureSubImage2DEXT(GLuint texture, GLenum target, GLint level,
                                                      GLint xoffset, GLint yoffset, GLsizei width,
                                                      GLsizei height, GLenum format, GLenum type,
@@ -4516,7 +4564,25 @@ bool WrappedOpenGL::Serialise_glTextureSubImage2DEXT(GLuint texture, GLenum targ
 
   size_t subimageSize = GetByteSize(Width, Height, 1, Format, Type);
 
-  SERIALISE_ELEMENT_BUF_OPT(byte *, buf, srcPixels, subimageSize, !UnpackBufBound);
+  byte *buf = NULL;
+  byte *asyncDst = NULL;
+
+  // straight from the application's memory, the copy can run alongside the real upload. The
+  // buffer is reserved with room for bufoffs after it, so it can't move until the chunk is done.
+  if(m_AsyncUploadCopy && srcPixels && !unpackedPixels)
+    asyncDst = m_pSerialiser->ReserveBuffer("buf", subimageSize, sizeof(uint64_t));
+
+  if(asyncDst)
+    m_UploadCopies.Run([asyncDst, srcPixels, subimageSize]() {
+      memcpy(asyncDst, srcPixels, subimageSize);
+    });
+  else if(!UnpackBufBound)
+  {
+    buf = srcPixels;
+    size_t bufLen = subimageSize;
+    m_pSerialiser->SerialiseBuffer("buf", buf, bufLen);
+  }
+
   SERIALISE_ELEMENT(uint64_t, bufoffs, (uint64_t)pixels);
 
   SAFE_DELETE_ARRAY(unpackedPixels);
@@ -4577,8 +4643,22 @@ bool WrappedOpenGL::Serialise_glTextureSubImage2DEXT(GLuint texture, GLenum targ
 void WrappedOpenGL::Common_glTextureSubImage2DEXT(GLResourceRecord *record, GLenum target,
                                                   GLint level, GLint xoffset, GLint yoffset,
                                                   GLsizei width, GLsizei height, GLenum format,
-                                                  GLenum type, const void *pixels)
+                                                  GLenum type, const void *pixels,
+                                                  const std::function<void()> &upload)
 {
+  GLint unpackbuf = 0;
+  m_Real.glGetIntegerv(eGL_PIXEL_UNPACK_BUFFER_BINDING, &unpackbuf);
+
+  // a big enough upload from client memory in the frame is made after serialising starts, so
+  // the copy into the chunk overlaps with the driver's own read of the pixels. Anything else is
+  // uploaded first as normal.
+  bool overlapUpload = m_State == WRITING_CAPFRAME && record && pixels && unpackbuf == 0 &&
+                       !IsProxyTarget(format) &&
+                       GetByteSize(width, height, 1, format, type) >= AsyncUploadCopyMinSize;
+
+  if(!overlapUpload)
+    upload();
+
   if(!record)
   {
     RDCERR(
@@ -4593,9 +4673,6 @@ void WrappedOpenGL::Common_glTextureSubImage2DEXT(GLResourceRecord *record, GLen
   if(IsProxyTarget(format))
     return;
 
-  GLint unpackbuf = 0;
-  m_Real.glGetIntegerv(eGL_PIXEL_UNPACK_BUFFER_BINDING, &unpackbuf);
-
   if(m_State == WRITING_IDLE && unpackbuf != 0)
   {
     GetResourceManager()->MarkDirtyResource(record->GetResourceID());
@@ -4607,8 +4684,19 @@ void WrappedOpenGL::Common_glTextureSubImage2DEXT(GLResourceRecord *record, GLen
       return;
 
     SCOPED_SERIALISE_CONTEXT(TEXSUBIMAGE2D);
+    m_AsyncUploadCopy = overlapUpload;
     Serialise_glTextureSubImage2DEXT(record->Resource.name, target, level, xoffset, yoffset, width,
                                      height, format, type, pixels);
+    m_AsyncUploadCopy = false;
+
+    if(overlapUpload)
+    {
+      upload();
+
+      // the application can reuse its memory as soon as we return, and the chunk can't be
+      // finished until its contents are there
+      m_UploadCopies.Wait();
+    }
 
     if(m_State == WRITING_CAPFRAME)
     {
@@ -4634,48 +4722,66 @@ void WrappedOpenGL::glTextureSubImage2DEXT(GLuint texture, GLenum target, GLint
                                            GLint yoffset, GLsizei width, GLsizei height,
                                            GLenum format, GLenum type, const void *pixels)
 {
-  m_Real.glTextureSubImage2DEXT(texture, target, level, xoffset, yoffset, width, height, format,
-                                type, pixels);
+  std::function<void()> upload = [&]() {
+    m_Real.glTextureSubImage2DEXT(texture, target, level, xoffset, yoffset, width, height, format,
+                                  type, pixels);
+  };
 
   if(m_State >= WRITING)
     Common_glTextureSubImage2DEXT(
         GetResourceManager()->GetResourceRecord(TextureRes(GetCtx(), texture)), target, level,
-        xoffset, yoffset, width, height, format, type, pixels);
+        xoffset, yoffset, width, height, format, type, pixels, upload);
+  else
+    upload();
 }
 
 void WrappedOpenGL::glTextureSubImage2D(GLuint texture, GLint level, GLint xoffset, GLint yoffset,
                                         GLsizei width, GLsizei height, GLenum format, GLenum type,
                                         const void *pixels)
 {
-  m_Real.glTextureSubImage2D(texture, level, xoffset, yoffset, width, height, format, type, pixels);
+  std::function<void()> upload = [&]() {
+    m_Real.glTextureSubImage2D(texture, level, xoffset, yoffset, width, height, format, type,
+                               pixels);
+  };
 
   if(m_State >= WRITING)
     Common_glTextureSubImage2DEXT(
         GetResourceManager()->GetResourceRecord(TextureRes(GetCtx(), texture)), eGL_NONE, level,
-        xoffset, yoffset, width, height, format, type, pixels);
+        xoffset, yoffset, width, height, format, type, pixels, upload);
+  else
+    upload();
 }
 
 void WrappedOpenGL::glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset,
                                     GLsizei width, GLsizei height, GLenum format, GLenum type,
                                     const void *pixels)
 {
-  m_Real.glTexSubImage2D(target, level, xoffset, yoffset, width, height, format, type, pixels);
+  std::function<void()> upload = [&]() {
+    m_Real.glTexSubImage2D(target, level, xoffset, yoffset, width, height, format, type, pixels);
+  };
 
   if(m_State >= WRITING)
     Common_glTextureSubImage2DEXT(GetCtxData().GetActiveTexRecord(), target, level, xoffset,
-                                  yoffset, width, height, format, type, pixels);
+                                  yoffset, width, height, format, type, pixels, upload);
+  else
+    upload();
 }
 
 void WrappedOpenGL::glMultiTexSubImage2DEXT(GLenum texunit, GLenum target, GLint level, GLint xoffset,
                                             GLint yoffset, GLsizei width, GLsizei height,
                                             GLenum format, GLenum type, const void *pixels)
 {
-  m_Real.glMultiTexSubImage2DEXT(texunit, target, level, xoffset, yoffset, width, height, format,
-                                 type, pixels);
+  std::function<void()> upload = [&]() {
+    m_Real.glMultiTexSubImage2DEXT(texunit, target, level, xoffset, yoffset, width, height, format,
+                                   type, pixels);
+  };
 
   if(m_State >= WRITING)
     Common_glTextureSubImage2DEXT(GetCtxData().m_TextureRecord[texunit - eGL_TEXTURE0], target,
-                                  level, xoffset, yoffset, width, height, format, type, pixels);
+                                  level, xoffset, yoffset, width, height, format, type, pixels,
+                                  upload);
+  else
+    upload();
 }
 
 bool WrappedOpenGL::Serialise_glTextureSubImage3DEXT(GLuint texture, GLenum target, GLint level,
@@ -5485,8 +5591,16 @@ bool WrappedOpenGL::Serialise_glTextureBufferRangeEXT(GLuint texture, GLenum tar
     GLuint buf = 0;
 
     if(GetResourceManager()->HasLiveResource(bufid))
+    {
       buf = GetResourceManager()->GetLiveResource(bufid).name;
 
+      if(m_State == READING)
+      {
+        m_AliasedResources.insert(GetResourceManager()->GetLiveID(texid));
+        m_AliasedResources.insert(GetResourceManager()->GetLiveID(bufid));
+      }
+    }
+
     if(Target != eGL_NONE)
       m_Real.glTextureBufferRangeEXT(GetResourceManager()->GetLiveResource(texid).name, Target, fmt,
                                      buf, (GLintptr)offs, (GLsizeiptr)Size);
@@ -5641,6 +5755,12 @@ bool WrappedOpenGL::Serialise_glTextureBufferEXT(GLuint texture, GLenum target,
   {
     buffer = GetResourceManager()->GetLiveResource(bufid).name;
 
+    if(m_State == READING)
+    {
+      m_AliasedResources.insert(GetResourceManager()->GetLiveID(texid));
+      m_AliasedResources.insert(GetResourceManager()->GetLiveID(bufid));
+    }
+
     if(m_State == READING && m_CurEventID == 0)
     {
       ResourceId liveId = GetResourceManager()->GetLiveID(texid);
@@ -37,6 +37,10 @@ using namespace DXBC;
 
 namespace ShaderDebug
 {
+// batched debugging simulates several invocations at once on different threads. Any instruction
+// that goes to the GPU, or adds a message to the device, takes this lock first.
+static Threading::CriticalSection deviceLock;
+
 static float round_ne(float x)
 {
   // if on 0.5 boundary
@@ -47,7 +51,7 @@ static float round_ne(float x)
   return x < 0 ? x + 0.5f : x;
 }
 
-VarType State::OperationType(const OpcodeType &op) const
+static VarType OperationType(const OpcodeType &op)
 {
   switch(op)
   {
@@ -220,6 +224,49 @@ VarType State::OperationType(const OpcodeType &op) const
   }
 }
 
+void DecodedProgram::Decode(DXBCFile *dxbc)
+{
+  ops.resize(dxbc->GetNumInstructions());
+
+  for(size_t i = 0; i < ops.size(); i++)
+  {
+    const ASMOperation &op = dxbc->GetInstruction(i);
+
+    ops[i].optype = OperationType(op.operation);
+    ops[i].numOperands = (uint32_t)dxbc->NumOperands(op.operation);
+    // bit 0 of the sync flags is the thread group sync
+    ops[i].threadSync = op.operation == OPCODE_SYNC && (op.syncFlags & 0x1) != 0;
+  }
+
+  cbufferIndex.clear();
+
+  for(size_t i = 0; i < dxbc->m_CBuffers.size(); i++)
+  {
+    uint32_t reg = dxbc->m_CBuffers[i].reg;
+
+    if(reg >= cbufferIndex.size())
+      cbufferIndex.resize(reg + 1, -1);
+
+    // the first cbuffer declared with a register is the one that's used
+    if(cbufferIndex[reg] == -1)
+      cbufferIndex[reg] = (int32_t)i;
+  }
+
+  numthreads[0] = numthreads[1] = numthreads[2] = 0;
+
+  for(size_t i = 0; i < dxbc->GetNumDeclarations(); i++)
+  {
+    const ASMDecl &decl = dxbc->GetDeclaration(i);
+
+    if(decl.declaration == OPCODE_DCL_THREAD_GROUP)
+    {
+      numthreads[0] = decl.groupSize[0];
+      numthreads[1] = decl.groupSize[1];
+      numthreads[2] = decl.groupSize[2];
+    }
+  }
+}
+
 void DoubleSet(ShaderVariable &var, const double in[2])
 {
   var.value.d.x = in[0];
@@ -586,6 +633,11 @@ bool State::Finished() const
   return dxbc && (done || nextInstruction >= (int)dxbc->GetNumInstructions());
 }
 
+bool State::AtThreadBarrier() const
+{
+  return program && !Finished() && program->ops[(size_t)nextInstruction].threadSync;
+}
+
 void State::AssignValue(ShaderVariable &dst, uint32_t dstIndex, const ShaderVariable &src,
                         uint32_t srcIndex)
 {
@@ -928,14 +980,8 @@ ShaderVariable State::GetSrc(const ASMOperand &oper, const ASMOperation &op) con
     {
       int cb = -1;
 
-      for(size_t i = 0; i < dxbc->m_CBuffers.size(); i++)
-      {
-        if(dxbc->m_CBuffers[i].reg == indices[0])
-        {
-          cb = (int)i;
-          break;
-        }
-      }
+      if(indices[0] < program->cbufferIndex.size())
+        cb = program->cbufferIndex[indices[0]];
 
       RDCASSERTMSG("Invalid cbuffer lookup", cb != -1 && cb < trace->cbuffers.count, cb,
                    trace->cbuffers.count);
@@ -986,19 +1032,7 @@ ShaderVariable State::GetSrc(const ASMOperand &oper, const ASMOperation &op) con
     }
     case TYPE_INPUT_THREAD_ID:
     {
-      uint32_t numthreads[3] = {0, 0, 0};
-
-      for(size_t i = 0; i < dxbc->GetNumDeclarations(); i++)
-      {
-        const ASMDecl &decl = dxbc->GetDeclaration(i);
-
-        if(decl.declaration == OPCODE_DCL_THREAD_GROUP)
-        {
-          numthreads[0] = decl.groupSize[0];
-          numthreads[1] = decl.groupSize[1];
-          numthreads[2] = decl.groupSize[2];
-        }
-      }
+      const uint32_t *numthreads = program->numthreads;
 
       RDCASSERT(numthreads[0] >= 1 && numthreads[0] <= 1024);
       RDCASSERT(numthreads[1] >= 1 && numthreads[1] <= 1024);
@@ -1021,19 +1055,7 @@ ShaderVariable State::GetSrc(const ASMOperand &oper, const ASMOperation &op) con
     }
     case TYPE_INPUT_THREAD_ID_IN_GROUP_FLATTENED:
     {
-      uint32_t numthreads[3] = {0, 0, 0};
-
-      for(size_t i = 0; i < dxbc->GetNumDeclarations(); i++)
-      {
-        const ASMDecl &decl = dxbc->GetDeclaration(i);
-
-        if(decl.declaration == OPCODE_DCL_THREAD_GROUP)
-        {
-          numthreads[0] = decl.groupSize[0];
-          numthreads[1] = decl.groupSize[1];
-          numthreads[2] = decl.groupSize[2];
-        }
-      }
+      const uint32_t *numthreads = program->numthreads;
 
       RDCASSERT(numthreads[0] >= 1 && numthreads[0] <= 1024);
       RDCASSERT(numthreads[1] >= 1 && numthreads[1] <= 1024);
@@ -1100,18 +1122,20 @@ State State::GetNext(GlobalState &global, State quad[4]) const
     return s;
 
   const ASMOperation &op = s.dxbc->GetInstruction((size_t)s.nextInstruction);
+  const DecodedProgram::Operation &decoded = program->ops[(size_t)s.nextInstruction];
 
   s.nextInstruction++;
   s.flags = ShaderEvents::NoEvent;
 
-  vector<ShaderVariable> srcOpers;
+  size_t numOperands = decoded.numOperands;
 
-  size_t numOperands = s.dxbc->NumOperands(op.operation);
-
-  VarType optype = OperationType(op.operation);
+  VarType optype = decoded.optype;
 
   RDCASSERT(op.operands.size() == numOperands);
 
+  vector<ShaderVariable> srcOpers;
+  srcOpers.reserve(numOperands);
+
   for(size_t i = 1; i < numOperands; i++)
     srcOpers.push_back(GetSrc(op.operands[i], op));
 
@@ -1701,6 +1725,8 @@ State State::GetNext(GlobalState &global, State quad[4]) const
     case OPCODE_LOG:
     case OPCODE_SINCOS:
     {
+      SCOPED_LOCK(deviceLock);
+
       string csProgram =
           "RWBuffer<float4> outval : register(u0);\n"
           "cbuffer srcOper : register(b0) { float4 inval; };\n"
@@ -2520,6 +2546,7 @@ State State::GetNext(GlobalState &global, State quad[4]) const
 
       if(load && !srv && !gsm && (fmt.numComps != 1 || fmt.byteWidth != 4))
       {
+        SCOPED_LOCK(deviceLock);
         device->AddDebugMessage(
             MessageCategory::Shaders, MessageSeverity::Medium, MessageSource::RuntimeWarning,
             StringFormat::Fmt(
@@ -2637,6 +2664,8 @@ State State::GetNext(GlobalState &global, State quad[4]) const
     case OPCODE_SAMPLE_INFO:
     case OPCODE_SAMPLE_POS:
     {
+      SCOPED_LOCK(deviceLock);
+
       ID3D11DeviceContext *context = NULL;
       device->GetReal()->GetImmediateContext(&context);
 
@@ -2886,6 +2915,8 @@ State State::GetNext(GlobalState &global, State quad[4]) const
 
     case OPCODE_BUFINFO:
     {
+      SCOPED_LOCK(deviceLock);
+
       ID3D11DeviceContext *context = NULL;
       device->GetReal()->GetImmediateContext(&context);
 
@@ -3028,6 +3059,8 @@ State State::GetNext(GlobalState &global, State quad[4]) const
 
     case OPCODE_RESINFO:
     {
+      SCOPED_LOCK(deviceLock);
+
       // spec says "srcMipLevel is read as an unsigned integer scalar"
       uint32_t mipLevel = srcOpers[0].value.u.x;
 
@@ -3464,6 +3497,8 @@ State State::GetNext(GlobalState &global, State quad[4]) const
     case OPCODE_GATHER4_PO_C:
     case OPCODE_LOD:
     {
+      SCOPED_LOCK(deviceLock);
+
       string sampler = "";
       string texture = "";
       string funcRet = "";
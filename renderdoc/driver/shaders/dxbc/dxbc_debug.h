@@ -39,6 +39,31 @@ class WrappedID3D11Device;
 
 namespace ShaderDebug
 {
+// information about the program that's the same for every step of every thread. It's decoded once
+// before simulating, so each step doesn't need to look it up from the disassembly again.
+struct DecodedProgram
+{
+  DecodedProgram() { numthreads[0] = numthreads[1] = numthreads[2] = 0; }
+  void Decode(DXBC::DXBCFile *dxbc);
+
+  struct Operation
+  {
+    VarType optype;
+    uint32_t numOperands;
+    // a sync that waits for all threads in the group
+    bool threadSync;
+  };
+
+  // one entry for each instruction
+  vector<Operation> ops;
+
+  // the index into the trace's cbuffers for each cbuffer register, or -1 if there isn't one
+  vector<int32_t> cbufferIndex;
+
+  // the declared thread group size, for compute shaders
+  uint32_t numthreads[3];
+};
+
 struct GlobalState
 {
 public:
@@ -112,6 +137,8 @@ public:
   };
 
   vector<groupsharedMem> groupshared;
+
+  DecodedProgram program;
 };
 
 class State : public ShaderDebugState
@@ -124,17 +151,20 @@ public:
     flags = ShaderEvents::NoEvent;
     done = false;
     trace = NULL;
+    program = NULL;
     dxbc = NULL;
     device = NULL;
     RDCEraseEl(semantics);
   }
-  State(int quadIdx, const ShaderDebugTrace *t, DXBC::DXBCFile *f, WrappedID3D11Device *d)
+  State(int quadIdx, const ShaderDebugTrace *t, const DecodedProgram *p, DXBC::DXBCFile *f,
+        WrappedID3D11Device *d)
   {
     quadIndex = quadIdx;
     nextInstruction = 0;
     flags = ShaderEvents::NoEvent;
     done = false;
     trace = t;
+    program = p;
     dxbc = f;
     device = d;
     RDCEraseEl(semantics);
@@ -158,6 +188,8 @@ public:
 
   void Init();
   bool Finished() const;
+  // true if the next instruction is a group barrier this thread must wait at
+  bool AtThreadBarrier() const;
 
   State GetNext(GlobalState &global, State quad[4]) const;
 
@@ -185,9 +217,8 @@ private:
   ShaderVariable DDY(bool fine, State quad[4], const DXBC::ASMOperand &oper,
                      const DXBC::ASMOperation &op) const;
 
-  VarType OperationType(const DXBC::OpcodeType &op) const;
-
   DXBC::DXBCFile *dxbc;
+  const DecodedProgram *program;
   const ShaderDebugTrace *trace;
   WrappedID3D11Device *device;
 };
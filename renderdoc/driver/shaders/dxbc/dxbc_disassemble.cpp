@@ -291,6 +291,40 @@ void DXBCFile::FetchTypeVersion()
   m_Type = VersionToken::ProgramType.Get(cur[0]);
   m_Version.Major = VersionToken::MajorVersion.Get(cur[0]);
   m_Version.Minor = VersionToken::MinorVersion.Get(cur[0]);
+
+  if(m_Type != D3D11_ShaderType_Compute || m_HexDump.size() < 2)
+    return;
+
+  // reflection needs the thread group size, so skip along the opcodes to find its declaration
+  // without decoding the whole stream
+  uint32_t *end = begin + m_HexDump.size();
+
+  cur += 2;
+
+  while(cur < end)
+  {
+    OpcodeType op = Opcode::Type.Get(cur[0]);
+
+    if(op == OPCODE_DCL_THREAD_GROUP && cur + 3 < end)
+    {
+      DispatchThreadsDimension[0] = cur[1];
+      DispatchThreadsDimension[1] = cur[2];
+      DispatchThreadsDimension[2] = cur[3];
+      return;
+    }
+
+    uint32_t len = 0;
+
+    if(op != OPCODE_CUSTOMDATA)
+      len = Opcode::Length.Get(cur[0]);
+    else if(cur + 1 < end)
+      len = cur[1];
+
+    if(len == 0)
+      return;
+
+    cur += len;
+  }
 }
 
 void DXBCFile::DisassembleHexDump()
@@ -389,6 +423,7 @@ void DXBCFile::DisassembleHexDump()
 void DXBCFile::MakeDisassemblyString()
 {
   DisassembleHexDump();
+  GetDebugInfo();
 
   uint32_t *hash =
       (uint32_t *)&m_ShaderBlob[4];    // hash is 4 uints, starting after the FOURCC of 'DXBC'
@@ -511,9 +511,13 @@ string DXBCFile::GetDebugBinaryPath(const void *ByteCode, size_t ByteCodeLength)
 DXBCFile::DXBCFile(const void *ByteCode, size_t ByteCodeLength)
 {
   m_DebugInfo = NULL;
+  m_DebugChunkOffset = 0;
+  m_DebugChunkFourCC = 0;
 
   m_Disassembled = false;
 
+  RDCEraseEl(DispatchThreadsDimension);
+
   RDCASSERT(ByteCodeLength < UINT32_MAX);
 
   RDCEraseEl(m_ShaderStats);
@@ -981,17 +985,197 @@ DXBCFile::DXBCFile(const void *ByteCode, size_t ByteCodeLength)
       char *c = (char *)fourcc;
       RDCWARN("Unknown chunk: %c%c%c%c", c[0], c[1], c[2], c[3]);
     }
-    else if(*fourcc == FOURCC_SDBG)
+    else if(*fourcc == FOURCC_SDBG || *fourcc == FOURCC_SPDB)
     {
-      m_DebugInfo = new SDBGChunk(fourcc);
+      m_DebugChunkFourCC = *fourcc;
+      m_DebugChunkOffset = chunkOffsets[chunkIdx];
     }
-    else if(*fourcc == FOURCC_SPDB)
+  }
+}
+
+DXBCDebugChunk *DXBCFile::GetDebugInfo()
+{
+  if(m_DebugInfo || m_DebugChunkFourCC == 0)
+    return m_DebugInfo;
+
+  void *chunk = &m_ShaderBlob[m_DebugChunkOffset];
+
+  if(m_DebugChunkFourCC == FOURCC_SDBG)
+    m_DebugInfo = new SDBGChunk(chunk);
+  else
+    m_DebugInfo = new SPDBChunk(chunk);
+
+  m_DebugChunkFourCC = 0;
+
+  return m_DebugInfo;
+}
+
+void MakeShaderDebugInfo(DXBCFile *dxbc, ShaderReflection *refl)
+{
+  DXBCDebugChunk *debugInfo = dxbc ? dxbc->GetDebugInfo() : NULL;
+
+  if(debugInfo == NULL)
+    return;
+
+  refl->DebugInfo.entryFunc = debugInfo->GetEntryFunction();
+  refl->DebugInfo.compileFlags = debugInfo->GetShaderCompileFlags();
+
+  refl->DebugInfo.entryFile = -1;
+
+  create_array_uninit(refl->DebugInfo.files, debugInfo->Files.size());
+  for(size_t i = 0; i < debugInfo->Files.size(); i++)
+  {
+    refl->DebugInfo.files[i].first = debugInfo->Files[i].first;
+    refl->DebugInfo.files[i].second = debugInfo->Files[i].second;
+
+    if(refl->DebugInfo.entryFile == -1 &&
+       strstr(refl->DebugInfo.files[i].second.elems, refl->DebugInfo.entryFunc.elems))
     {
-      m_DebugInfo = new SPDBChunk(fourcc);
+      refl->DebugInfo.entryFile = (int32_t)i;
     }
   }
 }
 
+void MakeShaderCost(DXBCFile *dxbc, ShaderReflection *refl)
+{
+  if(dxbc == NULL)
+    return;
+
+  ShaderCost &cost = refl->Cost;
+  cost = ShaderCost();
+
+  uint32_t indexableTemps = 0;
+
+  for(size_t d = 0; d < dxbc->GetNumDeclarations(); d++)
+  {
+    const ASMDecl &decl = dxbc->GetDeclaration(d);
+
+    // hull shader phases each declare their own temps, so take the largest
+    if(decl.declaration == OPCODE_DCL_TEMPS)
+      cost.tempRegisters = RDCMAX(cost.tempRegisters, decl.numTemps);
+    else if(decl.declaration == OPCODE_DCL_INDEXABLE_TEMP)
+      indexableTemps += decl.numTemps;
+  }
+
+  cost.tempRegisters += indexableTemps;
+
+  uint32_t loopDepth = 0;
+
+  for(size_t i = 0; i < dxbc->GetNumInstructions(); i++)
+  {
+    switch(dxbc->GetInstruction(i).operation)
+    {
+      // structural, or markers with no cost of their own
+      case OPCODE_NOP:
+      case OPCODE_CUSTOMDATA:
+      case OPCODE_HS_CONTROL_POINT_PHASE:
+      case OPCODE_HS_FORK_PHASE:
+      case OPCODE_HS_JOIN_PHASE:
+      case OPCODE_LABEL:
+      case OPCODE_ELSE:
+      case OPCODE_ENDIF:
+      case OPCODE_CASE:
+      case OPCODE_DEFAULT:
+      case OPCODE_ENDSWITCH:
+      case OPCODE_BREAK:
+      case OPCODE_CONTINUE:
+      case OPCODE_RET: continue;
+
+      case OPCODE_LOOP:
+        cost.loops++;
+        loopDepth++;
+        cost.maxLoopDepth = RDCMAX(cost.maxLoopDepth, loopDepth);
+        continue;
+      case OPCODE_ENDLOOP:
+        if(loopDepth > 0)
+          loopDepth--;
+        continue;
+
+      case OPCODE_IF:
+      case OPCODE_BREAKC:
+      case OPCODE_CONTINUEC:
+      case OPCODE_RETC:
+      case OPCODE_SWITCH:
+      case OPCODE_CALL:
+      case OPCODE_CALLC:
+      case OPCODE_INTERFACE_CALL:
+      case OPCODE_DISCARD: cost.flowControlInstructions++; break;
+
+      case OPCODE_EXP:
+      case OPCODE_LOG:
+      case OPCODE_RSQ:
+      case OPCODE_SQRT:
+      case OPCODE_SINCOS:
+      case OPCODE_RCP:
+      case OPCODE_DIV:
+      case OPCODE_UDIV:
+      case OPCODE_DDIV:
+      case OPCODE_DRCP: cost.transcendentalInstructions++; break;
+
+      case OPCODE_SAMPLE:
+      case OPCODE_SAMPLE_C:
+      case OPCODE_SAMPLE_C_LZ:
+      case OPCODE_SAMPLE_L:
+      case OPCODE_SAMPLE_D:
+      case OPCODE_SAMPLE_B:
+      case OPCODE_LOD:
+      case OPCODE_GATHER4:
+      case OPCODE_GATHER4_C:
+      case OPCODE_GATHER4_PO:
+      case OPCODE_GATHER4_PO_C:
+      case OPCODE_GATHER4_FEEDBACK:
+      case OPCODE_GATHER4_C_FEEDBACK:
+      case OPCODE_GATHER4_PO_FEEDBACK:
+      case OPCODE_GATHER4_PO_C_FEEDBACK:
+      case OPCODE_SAMPLE_L_FEEDBACK:
+      case OPCODE_SAMPLE_C_LZ_FEEDBACK:
+      case OPCODE_SAMPLE_CLAMP_FEEDBACK:
+      case OPCODE_SAMPLE_B_CLAMP_FEEDBACK:
+      case OPCODE_SAMPLE_D_CLAMP_FEEDBACK:
+      case OPCODE_SAMPLE_C_CLAMP_FEEDBACK: cost.sampleInstructions++; break;
+
+      case OPCODE_LD:
+      case OPCODE_LD_MS:
+      case OPCODE_LD_UAV_TYPED:
+      case OPCODE_STORE_UAV_TYPED:
+      case OPCODE_LD_RAW:
+      case OPCODE_STORE_RAW:
+      case OPCODE_LD_STRUCTURED:
+      case OPCODE_STORE_STRUCTURED:
+      case OPCODE_LD_FEEDBACK:
+      case OPCODE_LD_MS_FEEDBACK:
+      case OPCODE_LD_UAV_TYPED_FEEDBACK:
+      case OPCODE_LD_RAW_FEEDBACK:
+      case OPCODE_LD_STRUCTURED_FEEDBACK:
+      case OPCODE_ATOMIC_AND:
+      case OPCODE_ATOMIC_OR:
+      case OPCODE_ATOMIC_XOR:
+      case OPCODE_ATOMIC_CMP_STORE:
+      case OPCODE_ATOMIC_IADD:
+      case OPCODE_ATOMIC_IMAX:
+      case OPCODE_ATOMIC_IMIN:
+      case OPCODE_ATOMIC_UMAX:
+      case OPCODE_ATOMIC_UMIN:
+      case OPCODE_IMM_ATOMIC_ALLOC:
+      case OPCODE_IMM_ATOMIC_CONSUME:
+      case OPCODE_IMM_ATOMIC_IADD:
+      case OPCODE_IMM_ATOMIC_AND:
+      case OPCODE_IMM_ATOMIC_OR:
+      case OPCODE_IMM_ATOMIC_XOR:
+      case OPCODE_IMM_ATOMIC_EXCH:
+      case OPCODE_IMM_ATOMIC_CMP_EXCH:
+      case OPCODE_IMM_ATOMIC_IMAX:
+      case OPCODE_IMM_ATOMIC_IMIN:
+      case OPCODE_IMM_ATOMIC_UMAX:
+      case OPCODE_IMM_ATOMIC_UMIN: cost.memoryInstructions++; break;
+
+      default: cost.aluInstructions++; break;
+    }
+
+    cost.instructions++;
+  }
+}
+
 void DXBCFile::GuessResources()
 {
   char buf[64] = {0};
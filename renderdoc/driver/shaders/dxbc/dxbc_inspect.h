@@ -340,7 +340,10 @@ public:
   } m_Version;
 
   ShaderStatistics m_ShaderStats;
-  DXBCDebugChunk *m_DebugInfo;
+
+  // the SDBG/SPDB chunk is only parsed the first time this is called, since it's expensive and
+  // only needed to show or debug the shader
+  DXBCDebugChunk *GetDebugInfo();
 
   vector<uint32_t> m_Immediate;
 
@@ -369,10 +372,28 @@ public:
     return m_Disassembly;
   }
 
-  size_t GetNumDeclarations() { return m_Declarations.size(); }
-  const ASMDecl &GetDeclaration(size_t i) { return m_Declarations[i]; }
-  size_t GetNumInstructions() { return m_Instructions.size(); }
-  const ASMOperation &GetInstruction(size_t i) { return m_Instructions[i]; }
+  // the instruction stream is only decoded the first time it's needed here, reflection alone
+  // doesn't need it unless the RDEF chunk was stripped
+  size_t GetNumDeclarations()
+  {
+    DisassembleHexDump();
+    return m_Declarations.size();
+  }
+  const ASMDecl &GetDeclaration(size_t i)
+  {
+    DisassembleHexDump();
+    return m_Declarations[i];
+  }
+  size_t GetNumInstructions()
+  {
+    DisassembleHexDump();
+    return m_Instructions.size();
+  }
+  const ASMOperation &GetInstruction(size_t i)
+  {
+    DisassembleHexDump();
+    return m_Instructions[i];
+  }
   size_t NumOperands(OpcodeType op);
 
   static void GetHash(uint32_t hash[4], const void *ByteCode, size_t BytecodeLength);
@@ -403,6 +424,11 @@ private:
 
   bool m_Disassembled;
 
+  DXBCDebugChunk *m_DebugInfo;
+  // location of the debug chunk in m_ShaderBlob, until it's parsed
+  size_t m_DebugChunkOffset;
+  uint32_t m_DebugChunkFourCC;
+
   vector<ASMDecl>
       m_Declarations;    // declarations of inputs, outputs, constant buffers, temp registers etc.
   vector<ASMOperation> m_Instructions;
@@ -410,4 +436,12 @@ private:
   string m_Disassembly;
 };
 
+// fills out the DebugInfo part of a shader reflection. This is separate from the rest of the
+// reflection since it needs the debug chunk to be parsed, which is only worth doing once the
+// shader is actually being looked at
+void MakeShaderDebugInfo(DXBCFile *dxbc, ShaderReflection *refl);
+
+// fills out the Cost part of a shader reflection by counting the instructions by class
+void MakeShaderCost(DXBCFile *dxbc, ShaderReflection *refl);
+
 };    // namespace DXBC
@@ -84,6 +84,11 @@ struct SPVModule
   vector<SPVInstruction *> funcs;            // functions
   vector<SPVInstruction *> structs;          // struct types
 
+  // false if only the words have been stored by DeferParseSPIRV, the instructions are built on
+  // first use by Disassemble or MakeReflection
+  bool parsed;
+  void EnsureParsed();
+
   SPVInstruction *GetByID(uint32_t id);
   string Disassemble(const string &entryPoint);
 
@@ -93,4 +98,19 @@ struct SPVModule
 
 string CompileSPIRV(SPIRVShaderStage shadType, const vector<string> &sources,
                     vector<uint32_t> &spirv);
+
+struct SPIRVCompileJob
+{
+  SPIRVShaderStage stage;
+  vector<string> sources;
+
+  // filled out by CompileSPIRVBatch, the same as CompileSPIRV's outputs
+  vector<uint32_t> spirv;
+  string errors;
+};
+
+// compiles all the jobs across the available cores. glslang keeps its allocation pools per-thread
+// so independent compiles can run concurrently
+void CompileSPIRVBatch(vector<SPIRVCompileJob> &jobs);
 void ParseSPIRV(uint32_t *spirv, size_t spirvLength, SPVModule &module);
+void DeferParseSPIRV(const uint32_t *spirv, size_t spirvLength, SPVModule &module);
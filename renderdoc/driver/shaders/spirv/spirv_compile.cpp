@@ -28,6 +28,7 @@
 #undef min
 #undef max
 
+#include "3rdparty/glslang/OGLCompilersDLL/InitializeDll.h"
 #include "3rdparty/glslang/SPIRV/GlslangToSpv.h"
 #include "3rdparty/glslang/glslang/Public/ShaderLang.h"
 
@@ -202,3 +203,63 @@ string CompileSPIRV(SPIRVShaderStage shadType, const std::vector<std::string> &s
 
   return errors;
 }
+
+struct SPIRVCompileBatch
+{
+  vector<SPIRVCompileJob> *jobs;
+  volatile int32_t nextJob;
+};
+
+static void SPIRVCompileWorker(void *param)
+{
+  SPIRVCompileBatch *batch = (SPIRVCompileBatch *)param;
+
+  for(;;)
+  {
+    int32_t idx = Atomic::Inc32(&batch->nextJob) - 1;
+
+    if(idx >= (int32_t)batch->jobs->size())
+      break;
+
+    SPIRVCompileJob &job = (*batch->jobs)[idx];
+    job.errors = CompileSPIRV(job.stage, job.sources, job.spirv);
+  }
+}
+
+static void SPIRVCompileThread(void *param)
+{
+  SPIRVCompileWorker(param);
+
+  // free this thread's glslang pools, they're created on first use by each thread
+  glslang::DetachThread();
+}
+
+void CompileSPIRVBatch(vector<SPIRVCompileJob> &jobs)
+{
+  if(jobs.empty())
+    return;
+
+  SPIRVCompileBatch batch;
+  batch.jobs = &jobs;
+  batch.nextJob = 0;
+
+  uint32_t numThreads = RDCMIN(Threading::GetCPUCount(), (uint32_t)jobs.size());
+
+  std::vector<Threading::ThreadHandle> threads;
+
+  for(uint32_t i = 1; i < numThreads; i++)
+  {
+    Threading::ThreadHandle t = Threading::CreateThread(&SPIRVCompileThread, &batch);
+    if(t)
+      threads.push_back(t);
+  }
+
+  // this thread does its share too
+  SPIRVCompileWorker(&batch);
+
+  for(size_t i = 0; i < threads.size(); i++)
+  {
+    Threading::JoinThread(threads[i]);
+    Threading::CloseThread(threads[i]);
+  }
+}
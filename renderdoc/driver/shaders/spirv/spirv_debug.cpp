@@ -0,0 +1,3454 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2017 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "spirv_debug.h"
+#include <math.h>
+#include <algorithm>
+#include <cmath>
+#include "maths/half_convert.h"
+#include "serialise/serialiser.h"
+#include "3rdparty/glslang/SPIRV/GLSL.std.450.h"
+
+// defined in spirv_disassemble.cpp
+extern const char *GLSL_STD_450_friendly_names[];
+
+namespace SPVDebug
+{
+static uint32_t NumComps(const ShaderVariable &v)
+{
+  return v.rows * v.columns;
+}
+
+static double GetF(const ShaderVariable &v, uint32_t c)
+{
+  return v.type == VarType::Double ? v.value.dv[c] : (double)v.value.fv[c];
+}
+
+static void SetF(ShaderVariable &v, uint32_t c, double d)
+{
+  if(v.type == VarType::Double)
+    v.value.dv[c] = d;
+  else
+    v.value.fv[c] = (float)d;
+}
+
+static uint32_t CompSize(const ShaderVariable &v)
+{
+  return v.type == VarType::Double ? 8 : 4;
+}
+
+// copies the values of src into dst, keeping dst's names
+static void AssignValue(ShaderVariable &dst, const ShaderVariable &src)
+{
+  dst.value = src.value;
+
+  for(int32_t i = 0; i < dst.members.count && i < src.members.count; i++)
+    AssignValue(dst.members[i], src.members[i]);
+}
+
+// one level of indexing into a composite: an array element or struct member, a matrix column or a
+// vector component
+static ShaderVariable Extract(const ShaderVariable &v, uint32_t idx)
+{
+  if(v.members.count > 0)
+  {
+    if(idx < (uint32_t)v.members.count)
+      return v.members[idx];
+    return ShaderVariable();
+  }
+
+  ShaderVariable ret = v;
+  ret.members = rdctype::array<ShaderVariable>();
+  for(int i = 0; i < 16; i++)
+    ret.value.uv[i] = 0;
+
+  if(v.rows > 1)
+  {
+    // matrices are stored row-major, and a column is every row's element at that index
+    ret.rows = 1;
+    ret.columns = v.rows;
+
+    if(idx < v.columns)
+    {
+      for(uint32_t r = 0; r < v.rows; r++)
+      {
+        if(v.type == VarType::Double)
+          ret.value.dv[r] = v.value.dv[r * v.columns + idx];
+        else
+          ret.value.uv[r] = v.value.uv[r * v.columns + idx];
+      }
+    }
+  }
+  else
+  {
+    ret.rows = ret.columns = 1;
+
+    if(idx < v.columns)
+    {
+      if(v.type == VarType::Double)
+        ret.value.dv[0] = v.value.dv[idx];
+      else
+        ret.value.uv[0] = v.value.uv[idx];
+    }
+  }
+
+  return ret;
+}
+
+static void Insert(ShaderVariable &v, uint32_t idx, const ShaderVariable &elem)
+{
+  if(v.members.count > 0)
+  {
+    if(idx < (uint32_t)v.members.count)
+      AssignValue(v.members[idx], elem);
+    return;
+  }
+
+  if(v.rows > 1)
+  {
+    if(idx < v.columns)
+    {
+      for(uint32_t r = 0; r < v.rows; r++)
+      {
+        if(v.type == VarType::Double)
+          v.value.dv[r * v.columns + idx] = elem.value.dv[r];
+        else
+          v.value.uv[r * v.columns + idx] = elem.value.uv[r];
+      }
+    }
+  }
+  else if(idx < v.columns)
+  {
+    if(v.type == VarType::Double)
+      v.value.dv[idx] = elem.value.dv[0];
+    else
+      v.value.uv[idx] = elem.value.uv[0];
+  }
+}
+
+static ShaderVariable ReadChain(const ShaderVariable &v, const uint32_t *chain, size_t count)
+{
+  if(count == 0)
+    return v;
+
+  if(v.members.count > 0)
+  {
+    if(chain[0] < (uint32_t)v.members.count)
+      return ReadChain(v.members[chain[0]], chain + 1, count - 1);
+    return ShaderVariable();
+  }
+
+  return ReadChain(Extract(v, chain[0]), chain + 1, count - 1);
+}
+
+static void WriteChain(ShaderVariable &v, const uint32_t *chain, size_t count,
+                       const ShaderVariable &val)
+{
+  if(count == 0)
+  {
+    AssignValue(v, val);
+    return;
+  }
+
+  if(v.members.count > 0)
+  {
+    if(chain[0] < (uint32_t)v.members.count)
+      WriteChain(v.members[chain[0]], chain + 1, count - 1, val);
+    return;
+  }
+
+  ShaderVariable elem = Extract(v, chain[0]);
+  WriteChain(elem, chain + 1, count - 1, val);
+  Insert(v, chain[0], elem);
+}
+
+// appends the leaves of a composite in order, named by their path
+static void Flatten(const ShaderVariable &v, const string &name, vector<ShaderVariable> &out)
+{
+  if(v.members.count == 0)
+  {
+    out.push_back(v);
+    out.back().name = name;
+    return;
+  }
+
+  for(int32_t i = 0; i < v.members.count; i++)
+  {
+    const ShaderVariable &m = v.members[i];
+    Flatten(m, v.isStruct ? name + "." + m.name.elems : name + m.name.elems, out);
+  }
+}
+
+static void CopyLeaves(const ShaderVariable &v, ShaderVariable *dst, int32_t count, int32_t &idx)
+{
+  if(v.members.count == 0)
+  {
+    if(idx < count)
+      dst[idx].value = v.value;
+    idx++;
+    return;
+  }
+
+  for(int32_t i = 0; i < v.members.count; i++)
+    CopyLeaves(v.members[i], dst, count, idx);
+}
+
+static bool Steps(spv::Op op)
+{
+  switch(op)
+  {
+    case spv::OpFunction:
+    case spv::OpFunctionParameter:
+    case spv::OpFunctionEnd:
+    case spv::OpLabel:
+    case spv::OpSelectionMerge:
+    case spv::OpLoopMerge:
+    case spv::OpLine:
+    case spv::OpNoLine:
+    case spv::OpNop:
+    case spv::OpVariable:
+    case spv::OpPhi:
+    case spv::OpUndef: return false;
+    default: break;
+  }
+
+  return true;
+}
+
+// instructions inside functions that have no result type or ID
+static bool HasResult(spv::Op op, bool &hasType)
+{
+  hasType = true;
+
+  switch(op)
+  {
+    case spv::OpStore:
+    case spv::OpCopyMemory:
+    case spv::OpCopyMemorySized:
+    case spv::OpBranch:
+    case spv::OpBranchConditional:
+    case spv::OpSwitch:
+    case spv::OpReturn:
+    case spv::OpReturnValue:
+    case spv::OpKill:
+    case spv::OpUnreachable:
+    case spv::OpSelectionMerge:
+    case spv::OpLoopMerge:
+    case spv::OpLine:
+    case spv::OpNoLine:
+    case spv::OpNop:
+    case spv::OpEmitVertex:
+    case spv::OpEndPrimitive:
+    case spv::OpEmitStreamVertex:
+    case spv::OpEndStreamPrimitive:
+    case spv::OpControlBarrier:
+    case spv::OpMemoryBarrier:
+    case spv::OpImageWrite:
+    case spv::OpAtomicStore:
+    case spv::OpFunctionEnd:
+    case spv::OpLifetimeStart:
+    case spv::OpLifetimeStop: hasType = false; return false;
+    case spv::OpLabel: hasType = false; return true;
+    default: break;
+  }
+
+  return true;
+}
+
+// for the declarations that Decode reads, the fewest words the instruction can have and which
+// words are ids: a bit per word in idMask, plus every word from trailingIds onwards if it's set.
+// Every one of those ids indexes a per-id array, so they're checked against the id bound first
+static void DeclarationIds(spv::Op op, const uint32_t *w, uint32_t wordCount, uint32_t &minWords,
+                           uint32_t &idMask, uint32_t &trailingIds)
+{
+  minWords = 1;
+  idMask = 0;
+  trailingIds = 0;
+
+#define IDS(min, mask) \
+  minWords = min;      \
+  idMask = mask;
+
+  switch(op)
+  {
+    case spv::OpEntryPoint: IDS(4, 1 << 2); break;
+    case spv::OpExecutionMode:
+      IDS(3, 1 << 1);
+      if(wordCount >= 3 && spv::ExecutionMode(w[2]) == spv::ExecutionModeLocalSize)
+        minWords = 6;
+      break;
+    case spv::OpExtInstImport:
+    case spv::OpName:
+    case spv::OpDecorate: IDS(3, 1 << 1); break;
+    case spv::OpMemberName:
+    case spv::OpMemberDecorate: IDS(4, 1 << 1); break;
+    case spv::OpTypeVoid:
+    case spv::OpTypeBool:
+    case spv::OpTypeSampler:
+    case spv::OpTypeEvent:
+    case spv::OpTypeDeviceEvent:
+    case spv::OpTypeReserveId:
+    case spv::OpTypeQueue:
+    case spv::OpTypePipe:
+    case spv::OpTypeOpaque: IDS(2, 1 << 1); break;
+    case spv::OpTypeInt: IDS(4, 1 << 1); break;
+    case spv::OpTypeFloat: IDS(3, 1 << 1); break;
+    case spv::OpTypeVector:
+    case spv::OpTypeMatrix: IDS(4, (1 << 1) | (1 << 2)); break;
+    case spv::OpTypeArray: IDS(4, (1 << 1) | (1 << 2) | (1 << 3)); break;
+    case spv::OpTypeRuntimeArray:
+    case spv::OpTypeSampledImage: IDS(3, (1 << 1) | (1 << 2)); break;
+    case spv::OpTypeStruct:
+      IDS(2, 1 << 1);
+      trailingIds = 2;
+      break;
+    case spv::OpTypePointer: IDS(4, (1 << 1) | (1 << 3)); break;
+    case spv::OpTypeImage: IDS(9, (1 << 1) | (1 << 2)); break;
+    case spv::OpTypeFunction:
+      IDS(3, (1 << 1) | (1 << 2));
+      trailingIds = 3;
+      break;
+    case spv::OpConstantTrue:
+    case spv::OpConstantFalse:
+    case spv::OpSpecConstantTrue:
+    case spv::OpSpecConstantFalse:
+    case spv::OpConstantNull:
+    case spv::OpUndef: IDS(3, (1 << 1) | (1 << 2)); break;
+    case spv::OpConstant:
+    case spv::OpSpecConstant: IDS(4, (1 << 1) | (1 << 2)); break;
+    case spv::OpConstantSampler: IDS(6, (1 << 1) | (1 << 2)); break;
+    case spv::OpConstantComposite:
+    case spv::OpSpecConstantComposite:
+      IDS(3, (1 << 1) | (1 << 2));
+      trailingIds = 3;
+      break;
+    case spv::OpSpecConstantOp:
+      IDS(4, (1 << 1) | (1 << 2));
+      // the operation's operands are all ids, apart from the literal indices and components of
+      // these three
+      if(wordCount >= 4)
+      {
+        switch(spv::Op(w[3]))
+        {
+          case spv::OpCompositeExtract: IDS(6, (1 << 1) | (1 << 2) | (1 << 4)); break;
+          case spv::OpVectorShuffle:
+          case spv::OpCompositeInsert:
+            IDS(6, (1 << 1) | (1 << 2) | (1 << 4) | (1 << 5));
+            break;
+          default: trailingIds = 4; break;
+        }
+      }
+      break;
+    case spv::OpVariable:
+      IDS(4, (1 << 1) | (1 << 2));
+      trailingIds = 4;
+      break;
+    case spv::OpFunction: IDS(5, (1 << 1) | (1 << 2) | (1 << 4)); break;
+    default: break;
+  }
+
+#undef IDS
+}
+
+DecodedProgram::DecodedProgram()
+{
+  stage = ShaderStage::Vertex;
+  entryFunc = 0;
+  localSize[0] = localSize[1] = localSize[2] = 1;
+  glslStd450 = 0;
+}
+
+ShaderVariable DecodedProgram::MakeValue(uint32_t typeId, const string &name) const
+{
+  ShaderVariable ret;
+  ret.name = name;
+
+  if(typeId >= types.size())
+    return ret;
+
+  const Type &type = types[typeId];
+
+  switch(type.kind)
+  {
+    case Type::Bool:
+      ret.type = VarType::UInt;
+      ret.rows = ret.columns = 1;
+      break;
+    case Type::Scalar:
+      ret.type = type.scalar;
+      ret.rows = ret.columns = 1;
+      break;
+    case Type::Vector:
+      ret.type = type.scalar;
+      ret.rows = 1;
+      ret.columns = type.vecSize;
+      break;
+    case Type::Matrix:
+      ret.type = type.scalar;
+      ret.rows = type.vecSize;
+      ret.columns = type.columns;
+      break;
+    case Type::Array:
+    {
+      // runtime arrays only exist in buffers, so never have a value of their own
+      uint32_t len = type.length == ~0U ? 0 : type.length;
+      create_array_uninit(ret.members, len);
+      for(uint32_t i = 0; i < len; i++)
+        ret.members[i] = MakeValue(type.elem, StringFormat::Fmt("[%u]", i));
+      break;
+    }
+    case Type::Struct:
+    {
+      ret.isStruct = true;
+      create_array_uninit(ret.members, type.members.size());
+      for(size_t i = 0; i < type.members.size(); i++)
+        ret.members[i] = MakeValue(type.members[i].type, type.members[i].name);
+      break;
+    }
+    case Type::Image:
+    case Type::Sampler:
+    case Type::SampledImage:
+      // handles are the image variable and descriptor index, then the same for the sampler
+      ret.type = VarType::UInt;
+      ret.rows = 1;
+      ret.columns = 4;
+      break;
+    default: break;
+  }
+
+  return ret;
+}
+
+ShaderVariable DecodedProgram::ReadMemory(const byte *data, size_t size, uint32_t typeId,
+                                          uint32_t offset, uint32_t matrixStride, bool rowMajor,
+                                          uint32_t vecStride, const string &name) const
+{
+  ShaderVariable ret = MakeValue(typeId, name);
+
+  if(typeId >= types.size())
+    return ret;
+
+  const Type &type = types[typeId];
+
+  if(type.kind == Type::Array)
+  {
+    for(int32_t i = 0; i < ret.members.count; i++)
+      ret.members[i] = ReadMemory(data, size, type.elem, offset + i * type.arrayStride,
+                                  matrixStride, rowMajor, 0, ret.members[i].name.elems);
+    return ret;
+  }
+
+  if(type.kind == Type::Struct)
+  {
+    for(int32_t i = 0; i < ret.members.count; i++)
+    {
+      const Type::Member &m = type.members[i];
+      ret.members[i] = ReadMemory(data, size, m.type, offset + m.offset, m.matrixStride, m.rowMajor,
+                                  0, ret.members[i].name.elems);
+    }
+    return ret;
+  }
+
+  if(type.kind != Type::Bool && type.kind != Type::Scalar && type.kind != Type::Vector &&
+     type.kind != Type::Matrix)
+    return ret;
+
+  uint32_t compSize = CompSize(ret);
+  if(vecStride == 0)
+    vecStride = compSize;
+
+  for(uint32_t r = 0; r < ret.rows; r++)
+  {
+    for(uint32_t c = 0; c < ret.columns; c++)
+    {
+      uint32_t byteOffs = offset;
+
+      if(type.kind == Type::Matrix)
+        byteOffs += rowMajor ? r * matrixStride + c * compSize : c * matrixStride + r * compSize;
+      else
+        byteOffs += c * vecStride;
+
+      if(byteOffs + compSize <= size)
+        memcpy(compSize == 8 ? (void *)&ret.value.dv[r * ret.columns + c]
+                             : (void *)&ret.value.uv[r * ret.columns + c],
+               data + byteOffs, compSize);
+    }
+  }
+
+  // bools in memory are any non-zero value
+  if(type.kind == Type::Bool)
+    ret.value.uv[0] = ret.value.uv[0] ? 1 : 0;
+
+  return ret;
+}
+
+void DecodedProgram::WriteMemory(byte *data, size_t size, uint32_t typeId, uint32_t offset,
+                                 uint32_t matrixStride, bool rowMajor, uint32_t vecStride,
+                                 const ShaderVariable &val) const
+{
+  if(typeId >= types.size())
+    return;
+
+  const Type &type = types[typeId];
+
+  if(type.kind == Type::Array)
+  {
+    for(int32_t i = 0; i < val.members.count; i++)
+      WriteMemory(data, size, type.elem, offset + i * type.arrayStride, matrixStride, rowMajor, 0,
+                  val.members[i]);
+    return;
+  }
+
+  if(type.kind == Type::Struct)
+  {
+    for(int32_t i = 0; i < val.members.count && i < (int32_t)type.members.size(); i++)
+    {
+      const Type::Member &m = type.members[i];
+      WriteMemory(data, size, m.type, offset + m.offset, m.matrixStride, m.rowMajor, 0,
+                  val.members[i]);
+    }
+    return;
+  }
+
+  uint32_t compSize = CompSize(val);
+  if(vecStride == 0)
+    vecStride = compSize;
+
+  for(uint32_t r = 0; r < val.rows; r++)
+  {
+    for(uint32_t c = 0; c < val.columns; c++)
+    {
+      uint32_t byteOffs = offset;
+
+      if(type.kind == Type::Matrix)
+        byteOffs += rowMajor ? r * matrixStride + c * compSize : c * matrixStride + r * compSize;
+      else
+        byteOffs += c * vecStride;
+
+      if(byteOffs + compSize <= size)
+        memcpy(data + byteOffs, compSize == 8 ? (const void *)&val.value.dv[r * val.columns + c]
+                                              : (const void *)&val.value.uv[r * val.columns + c],
+               compSize);
+    }
+  }
+}
+
+bool DecodedProgram::Decode(const SPVModule &module, const string &entryPoint,
+                            ShaderStage shaderStage,
+                            const std::map<uint32_t, uint64_t> &specConstants)
+{
+  const vector<uint32_t> &spirv = module.spirv;
+
+  if(spirv.size() < 5 || spirv[0] != (uint32_t)spv::MagicNumber)
+  {
+    RDCERR("Invalid SPIR-V module to debug");
+    return false;
+  }
+
+  stage = shaderStage;
+
+  spv::ExecutionModel model = spv::ExecutionModelVertex;
+  switch(stage)
+  {
+    case ShaderStage::Vertex: model = spv::ExecutionModelVertex; break;
+    case ShaderStage::Pixel: model = spv::ExecutionModelFragment; break;
+    case ShaderStage::Compute: model = spv::ExecutionModelGLCompute; break;
+    default: RDCWARN("Only vertex, fragment and compute shaders can be debugged"); return false;
+  }
+
+  uint32_t idbound = spirv[3];
+
+  types.resize(idbound);
+  idType.assign(idbound, 0);
+  names.resize(idbound);
+  labels.assign(idbound, ~0U);
+  functions.assign(idbound, ~0U);
+  mergeBlock.assign(idbound, false);
+  isConstant.assign(idbound, false);
+  constants.resize(idbound);
+  globalIndex.assign(idbound, -1);
+
+  struct Decorations
+  {
+    Decorations() : builtin(-1), location(-1), set(0), binding(0), specId(-1), arrayStride(0)
+    {
+      flat = noperspective = bufferBlock = false;
+    }
+    int32_t builtin, location;
+    uint32_t set, binding;
+    int32_t specId;
+    uint32_t arrayStride;
+    bool flat, noperspective, bufferBlock;
+  };
+
+  // annotations all come before the types they decorate, so these are complete by the time each
+  // type is declared
+  vector<Decorations> decorations(idbound);
+  std::map<std::pair<uint32_t, uint32_t>, Type::Member> memberDecorations;
+
+  bool inFunction = false;
+
+  for(size_t it = 5; it < spirv.size();)
+  {
+    uint32_t wordCount = spirv[it] >> spv::WordCountShift;
+    spv::Op op = spv::Op(spirv[it] & spv::OpCodeMask);
+
+    if(wordCount == 0 || it + wordCount > spirv.size())
+    {
+      RDCERR("Malformed SPIR-V at word %u", (uint32_t)it);
+      return false;
+    }
+
+    const uint32_t *w = &spirv[it];
+    it += wordCount;
+
+    if(inFunction && op != spv::OpLine && op != spv::OpNoLine)
+    {
+      bool hasType = false;
+      bool hasResult = HasResult(op, hasType);
+
+      Instruction inst;
+      inst.op = op;
+
+      uint32_t first = 1;
+      bool merge = op == spv::OpSelectionMerge || op == spv::OpLoopMerge;
+
+      if(wordCount < (hasType ? 1U : 0U) + (hasResult || merge ? 2U : 1U))
+      {
+        RDCERR("Malformed SPIR-V %s at word %u", ToStr::Get(op).c_str(),
+               (uint32_t)(it - wordCount));
+        return false;
+      }
+
+      inst.type = hasType ? w[first++] : 0;
+      inst.result = hasResult ? w[first++] : 0;
+      inst.firstArg = (uint32_t)args.size();
+      inst.numArgs = wordCount - first;
+      inst.step = Steps(op);
+
+      if(inst.type >= idbound || inst.result >= idbound || (merge && w[1] >= idbound))
+      {
+        RDCERR("SPIR-V %s at word %u uses an ID outside the bound of %u", ToStr::Get(op).c_str(),
+               (uint32_t)(it - wordCount), idbound);
+        return false;
+      }
+
+      args.insert(args.end(), w + first, w + wordCount);
+
+      if(inst.result)
+        idType[inst.result] = inst.type;
+
+      if(op == spv::OpLabel)
+        labels[inst.result] = (uint32_t)instructions.size();
+      else if(op == spv::OpSelectionMerge || op == spv::OpLoopMerge)
+        mergeBlock[w[1]] = true;
+      else if(op == spv::OpFunctionEnd)
+        inFunction = false;
+
+      instructions.push_back(inst);
+      continue;
+    }
+
+    {
+      uint32_t minWords = 1, idMask = 0, trailingIds = 0;
+      DeclarationIds(op, w, wordCount, minWords, idMask, trailingIds);
+
+      if(wordCount < minWords)
+      {
+        RDCERR("Malformed SPIR-V %s at word %u", ToStr::Get(op).c_str(),
+               (uint32_t)(it - wordCount));
+        return false;
+      }
+
+      for(uint32_t i = 1; i < wordCount; i++)
+      {
+        bool isId = (i < 32 && (idMask & (1U << i))) || (trailingIds && i >= trailingIds);
+        if(isId && w[i] >= idbound)
+        {
+          RDCERR("SPIR-V %s at word %u uses ID %u outside the bound of %u", ToStr::Get(op).c_str(),
+                 (uint32_t)(it - wordCount), w[i], idbound);
+          return false;
+        }
+      }
+    }
+
+    switch(op)
+    {
+      case spv::OpEntryPoint:
+        if(spv::ExecutionModel(w[1]) == model && entryPoint == (const char *)&w[3])
+          entryFunc = w[2];
+        break;
+      case spv::OpExecutionMode:
+        if(w[1] == entryFunc && spv::ExecutionMode(w[2]) == spv::ExecutionModeLocalSize)
+        {
+          localSize[0] = w[3];
+          localSize[1] = w[4];
+          localSize[2] = w[5];
+        }
+        break;
+      case spv::OpExtInstImport:
+        if(!strcmp((const char *)&w[2], "GLSL.std.450"))
+          glslStd450 = w[1];
+        break;
+      case spv::OpName: names[w[1]] = (const char *)&w[2]; break;
+      case spv::OpMemberName:
+        memberDecorations[std::make_pair(w[1], w[2])].name = (const char *)&w[3];
+        break;
+      case spv::OpDecorate:
+      {
+        Decorations &d = decorations[w[1]];
+        uint32_t val = wordCount > 3 ? w[3] : 0;
+        switch(spv::Decoration(w[2]))
+        {
+          case spv::DecorationBuiltIn: d.builtin = (int32_t)val; break;
+          case spv::DecorationLocation: d.location = (int32_t)val; break;
+          case spv::DecorationDescriptorSet: d.set = val; break;
+          case spv::DecorationBinding: d.binding = val; break;
+          case spv::DecorationSpecId: d.specId = (int32_t)val; break;
+          case spv::DecorationArrayStride: d.arrayStride = val; break;
+          case spv::DecorationFlat: d.flat = true; break;
+          case spv::DecorationNoPerspective: d.noperspective = true; break;
+          case spv::DecorationBufferBlock: d.bufferBlock = true; break;
+          default: break;
+        }
+        break;
+      }
+      case spv::OpMemberDecorate:
+      {
+        Type::Member &m = memberDecorations[std::make_pair(w[1], w[2])];
+        uint32_t val = wordCount > 4 ? w[4] : 0;
+        switch(spv::Decoration(w[3]))
+        {
+          case spv::DecorationOffset: m.offset = val; break;
+          case spv::DecorationMatrixStride: m.matrixStride = val; break;
+          case spv::DecorationRowMajor: m.rowMajor = true; break;
+          case spv::DecorationColMajor: m.rowMajor = false; break;
+          case spv::DecorationBuiltIn: m.builtin = (int32_t)val; break;
+          default: break;
+        }
+        break;
+      }
+      case spv::OpTypeVoid: types[w[1]].kind = Type::Void; break;
+      case spv::OpTypeBool:
+        types[w[1]].kind = Type::Bool;
+        types[w[1]].scalar = VarType::UInt;
+        break;
+      case spv::OpTypeInt:
+      {
+        Type &t = types[w[1]];
+        t.kind = w[2] == 32 ? Type::Scalar : Type::Unsupported;
+        t.scalar = w[3] ? VarType::Int : VarType::UInt;
+        t.width = w[2];
+        break;
+      }
+      case spv::OpTypeFloat:
+      {
+        Type &t = types[w[1]];
+        t.kind = (w[2] == 32 || w[2] == 64) ? Type::Scalar : Type::Unsupported;
+        t.scalar = w[2] == 64 ? VarType::Double : VarType::Float;
+        t.width = w[2];
+        break;
+      }
+      case spv::OpTypeVector:
+      {
+        Type t = types[w[2]];
+        if(t.kind != Type::Unsupported)
+          t.kind = Type::Vector;
+        t.vecSize = w[3];
+        t.elem = w[2];
+        types[w[1]] = t;
+        break;
+      }
+      case spv::OpTypeMatrix:
+      {
+        Type t = types[w[2]];
+        if(t.kind != Type::Unsupported)
+          t.kind = Type::Matrix;
+        t.columns = w[3];
+        t.elem = w[2];
+        types[w[1]] = t;
+        break;
+      }
+      case spv::OpTypeArray:
+      case spv::OpTypeRuntimeArray:
+      {
+        Type &t = types[w[1]];
+        t.kind = types[w[2]].kind == Type::Unsupported ? Type::Unsupported : Type::Array;
+        t.elem = w[2];
+        t.length = op == spv::OpTypeArray ? constants[w[3]].value.uv[0] : ~0U;
+        t.arrayStride = decorations[w[1]].arrayStride;
+        break;
+      }
+      case spv::OpTypeStruct:
+      {
+        Type &t = types[w[1]];
+        t.kind = Type::Struct;
+        t.bufferBlock = decorations[w[1]].bufferBlock;
+        for(uint32_t i = 2; i < wordCount; i++)
+        {
+          Type::Member m = memberDecorations[std::make_pair(w[1], i - 2)];
+          m.type = w[i];
+          if(m.name.empty())
+            m.name = StringFormat::Fmt("_child%u", i - 2);
+          if(types[w[i]].kind == Type::Unsupported)
+            t.kind = Type::Unsupported;
+          t.members.push_back(m);
+        }
+        break;
+      }
+      case spv::OpTypePointer:
+      {
+        Type &t = types[w[1]];
+        t.kind = Type::Pointer;
+        t.storage = spv::StorageClass(w[2]);
+        t.elem = w[3];
+        break;
+      }
+      case spv::OpTypeImage:
+      {
+        Type &t = types[w[1]];
+        t.kind = Type::Image;
+        t.elem = w[2];
+        t.scalar = types[w[2]].scalar;
+        t.dim = spv::Dim(w[3]);
+        t.depth = w[4] == 1;
+        t.arrayed = w[5] != 0;
+        t.multisampled = w[6] != 0;
+        break;
+      }
+      case spv::OpTypeSampler: types[w[1]].kind = Type::Sampler; break;
+      case spv::OpTypeSampledImage:
+        types[w[1]] = types[w[2]];
+        types[w[1]].kind = Type::SampledImage;
+        types[w[1]].elem = w[2];
+        break;
+      case spv::OpTypeFunction:
+        types[w[1]].kind = Type::Function;
+        types[w[1]].elem = w[2];
+        break;
+      case spv::OpTypeEvent:
+      case spv::OpTypeDeviceEvent:
+      case spv::OpTypeReserveId:
+      case spv::OpTypeQueue:
+      case spv::OpTypePipe:
+      case spv::OpTypeOpaque:
+      case spv::OpTypeForwardPointer:
+        if(op != spv::OpTypeForwardPointer)
+          types[w[1]].kind = Type::Unsupported;
+        break;
+      case spv::OpConstantTrue:
+      case spv::OpConstantFalse:
+      case spv::OpSpecConstantTrue:
+      case spv::OpSpecConstantFalse:
+      {
+        ShaderVariable &c = constants[w[2]];
+        c = MakeValue(w[1], "");
+        c.value.uv[0] = (op == spv::OpConstantTrue || op == spv::OpSpecConstantTrue) ? 1 : 0;
+
+        auto spec = specConstants.find((uint32_t)decorations[w[2]].specId);
+        if(decorations[w[2]].specId >= 0 && spec != specConstants.end())
+          c.value.uv[0] = spec->second ? 1 : 0;
+
+        isConstant[w[2]] = true;
+        idType[w[2]] = w[1];
+        break;
+      }
+      case spv::OpConstant:
+      case spv::OpSpecConstant:
+      {
+        ShaderVariable &c = constants[w[2]];
+        c = MakeValue(w[1], "");
+        if(types[w[1]].width == 64 && wordCount > 4)
+          memcpy(&c.value.dv[0], &w[3], sizeof(double));
+        else
+          c.value.uv[0] = w[3];
+
+        auto spec = specConstants.find((uint32_t)decorations[w[2]].specId);
+        if(decorations[w[2]].specId >= 0 && spec != specConstants.end())
+        {
+          uint64_t val = spec->second;
+          memcpy(&c.value.uv[0], &val, types[w[1]].width == 64 ? 8 : 4);
+        }
+
+        isConstant[w[2]] = true;
+        idType[w[2]] = w[1];
+        break;
+      }
+      case spv::OpConstantComposite:
+      case spv::OpSpecConstantComposite:
+      {
+        ShaderVariable &c = constants[w[2]];
+        c = MakeValue(w[1], "");
+        for(uint32_t i = 3; i < wordCount; i++)
+          Insert(c, i - 3, constants[w[i]]);
+
+        isConstant[w[2]] = true;
+        idType[w[2]] = w[1];
+        break;
+      }
+      case spv::OpConstantNull:
+      case spv::OpConstantSampler:
+      case spv::OpUndef:
+        constants[w[2]] = MakeValue(w[1], "");
+        isConstant[w[2]] = true;
+        idType[w[2]] = w[1];
+        break;
+      case spv::OpSpecConstantOp:
+      {
+        // evaluate the operation once with the constants decoded so far, the same way it would
+        // execute in a function
+        Instruction inst;
+        inst.op = spv::Op(w[3]);
+        inst.type = w[1];
+        inst.result = w[2];
+        inst.firstArg = (uint32_t)args.size();
+        inst.numArgs = wordCount - 4;
+        inst.step = true;
+        args.insert(args.end(), w + 4, w + wordCount);
+
+        ShaderVariable &c = constants[w[2]];
+        c = MakeValue(w[1], "");
+
+        State evaluator(-1, this);
+        if(!evaluator.EvaluateOp(NULL, inst, NULL, c))
+          RDCWARN("Unsupported specialization constant operation %s",
+                  ToStr::Get(inst.op).c_str());
+
+        isConstant[w[2]] = true;
+        idType[w[2]] = w[1];
+        break;
+      }
+      case spv::OpVariable:
+      {
+        Variable v;
+        v.id = w[2];
+        v.type = types[w[1]].elem;
+        v.storage = spv::StorageClass(w[3]);
+        v.init = wordCount > 4 ? w[4] : 0;
+        v.name = names[w[2]];
+
+        const Decorations &d = decorations[w[2]];
+        v.builtin = d.builtin;
+        v.location = d.location;
+        v.set = d.set;
+        v.binding = d.binding;
+        v.flat = d.flat;
+        v.noperspective = d.noperspective;
+
+        if(v.name.empty())
+          v.name = StringFormat::Fmt("_%u_", v.id);
+
+        idType[w[2]] = w[1];
+        globalIndex[w[2]] = (int32_t)globals.size();
+        globals.push_back(v);
+        break;
+      }
+      case spv::OpFunction:
+      {
+        // re-process this instruction as the start of the function
+        inFunction = true;
+        it -= wordCount;
+        functions[w[2]] = (uint32_t)instructions.size();
+        break;
+      }
+      default: break;
+    }
+  }
+
+  if(entryFunc == 0 || entryFunc >= idbound || functions[entryFunc] == ~0U)
+  {
+    RDCERR("Couldn't find entry point '%s' to debug", entryPoint.c_str());
+    return false;
+  }
+
+  for(size_t i = 0; i < instructions.size(); i++)
+  {
+    const Instruction &inst = instructions[i];
+    if(inst.type && types[inst.type].kind == Type::Unsupported)
+    {
+      RDCWARN("Shader uses types that can't be debugged, such as 8/16/64-bit integers or halfs");
+      return false;
+    }
+  }
+
+  for(uint32_t id = 0; id < idbound; id++)
+    if(names[id].empty())
+      names[id] = StringFormat::Fmt("_%u_", id);
+
+  // assign where each value is shown. Anything that's a plain value gets a register of its own,
+  // while composites are flattened into an indexable temp each.
+  Slot none = {Slot::None, 0};
+  slots.assign(idbound, none);
+
+  for(size_t i = 0; i < instructions.size(); i++)
+  {
+    const Instruction &inst = instructions[i];
+
+    if(inst.result == 0 || inst.type == 0 || inst.op == spv::OpFunction || inst.op == spv::OpLabel)
+      continue;
+
+    uint32_t type = inst.op == spv::OpVariable ? types[inst.type].elem : inst.type;
+
+    switch(types[type].kind)
+    {
+      case Type::Bool:
+      case Type::Scalar:
+      case Type::Vector:
+      case Type::Matrix:
+        slots[inst.result].kind = Slot::Register;
+        slots[inst.result].index = (uint32_t)registerIDs.size();
+        registerIDs.push_back(inst.result);
+        break;
+      case Type::Array:
+      case Type::Struct:
+        slots[inst.result].kind = Slot::Indexable;
+        slots[inst.result].index = (uint32_t)indexableIDs.size();
+        indexableIDs.push_back(inst.result);
+        break;
+      default: break;
+    }
+  }
+
+  for(size_t i = 0; i < globals.size(); i++)
+  {
+    const Variable &v = globals[i];
+
+    if(v.storage == spv::StorageClassOutput)
+    {
+      slots[v.id].kind = Slot::Output;
+      slots[v.id].index = (uint32_t)outputIDs.size();
+      outputIDs.push_back(v.id);
+    }
+    else if(v.storage == spv::StorageClassPrivate)
+    {
+      Type::Kind kind = types[v.type].kind;
+      if(kind == Type::Array || kind == Type::Struct)
+      {
+        slots[v.id].kind = Slot::Indexable;
+        slots[v.id].index = (uint32_t)indexableIDs.size();
+        indexableIDs.push_back(v.id);
+      }
+      else if(kind == Type::Bool || kind == Type::Scalar || kind == Type::Vector ||
+              kind == Type::Matrix)
+      {
+        slots[v.id].kind = Slot::Register;
+        slots[v.id].index = (uint32_t)registerIDs.size();
+        registerIDs.push_back(v.id);
+      }
+    }
+  }
+
+  MakeListing();
+
+  return true;
+}
+
+string DecodedProgram::OperandName(uint32_t id) const
+{
+  if(id >= names.size())
+    return StringFormat::Fmt("<%u>", id);
+
+  // scalar constants are clearer shown by value
+  if(isConstant[id] && NumComps(constants[id]) == 1 && constants[id].members.count == 0)
+  {
+    const ShaderVariable &c = constants[id];
+    const Type &t = types[idType[id]];
+
+    if(t.kind == Type::Bool)
+      return c.value.uv[0] ? "true" : "false";
+    if(c.type == VarType::Float)
+      return StringFormat::Fmt("%@gf", c.value.fv[0]);
+    if(c.type == VarType::Double)
+      return StringFormat::Fmt("%@lgf", c.value.dv[0]);
+    if(c.type == VarType::Int)
+      return StringFormat::Fmt("%i", c.value.iv[0]);
+    return StringFormat::Fmt("%u", c.value.uv[0]);
+  }
+
+  return names[id];
+}
+
+void DecodedProgram::MakeListing()
+{
+  disassembly.clear();
+
+  // number width for aligning the listing
+  uint32_t digits = 1;
+  for(size_t n = instructions.size(); n >= 10; n /= 10)
+    digits++;
+
+  for(size_t i = 0; i < instructions.size(); i++)
+  {
+    const Instruction &inst = instructions[i];
+    const uint32_t *a = Args(inst);
+
+    string line;
+
+    if(inst.op == spv::OpFunction)
+    {
+      line = StringFormat::Fmt("\nfunction %s\n", Name(inst.result).c_str());
+      disassembly += line;
+      continue;
+    }
+    else if(inst.op == spv::OpFunctionEnd)
+    {
+      disassembly += "end\n";
+      continue;
+    }
+    else if(inst.op == spv::OpLabel)
+    {
+      disassembly += StringFormat::Fmt("%s:\n", Name(inst.result).c_str());
+      continue;
+    }
+
+    if(inst.step)
+      line = StringFormat::Fmt("%*u: ", digits, (uint32_t)i);
+    else
+      line = string(digits + 2, ' ');
+
+    line += "  ";
+
+    if(inst.result)
+      line += Name(inst.result) + " = ";
+
+    if(inst.op == spv::OpExtInst && inst.numArgs >= 2 && a[0] == glslStd450 &&
+       a[1] < GLSLstd450Count)
+    {
+      line += GLSL_STD_450_friendly_names[a[1]];
+      for(uint32_t o = 2; o < inst.numArgs; o++)
+        line += (o == 2 ? " " : ", ") + OperandName(a[o]);
+    }
+    else
+    {
+      line += ToStr::Get(inst.op);
+
+      // operands from this index on are literals rather than IDs
+      uint32_t literals = inst.numArgs;
+      switch(inst.op)
+      {
+        case spv::OpCompositeExtract:
+        case spv::OpArrayLength: literals = 1; break;
+        case spv::OpCompositeInsert:
+        case spv::OpVectorShuffle:
+        case spv::OpSelectionMerge:
+        case spv::OpStore:
+        case spv::OpVariable: literals = inst.op == spv::OpVariable ? 0 : 2; break;
+        case spv::OpLoad:
+        case spv::OpFunction: literals = 1; break;
+        case spv::OpLoopMerge: literals = 2; break;
+        case spv::OpBranchConditional: literals = 3; break;
+        default: break;
+      }
+
+      for(uint32_t o = 0; o < inst.numArgs; o++)
+      {
+        line += o == 0 ? " " : ", ";
+
+        // switch alternates literal cases and labels after the selector and default
+        bool literal = o >= literals || (inst.op == spv::OpSwitch && o >= 2 && (o % 2) == 0);
+
+        if(inst.op == spv::OpVariable && o == 0)
+          line += ToStr::Get(spv::StorageClass(a[o]));
+        else if(literal)
+          line += StringFormat::Fmt("%u", a[o]);
+        else
+          line += OperandName(a[o]);
+      }
+    }
+
+    disassembly += line + "\n";
+  }
+}
+
+vector<byte> &GlobalState::GetBuffer(const BindingSlot &slot)
+{
+  Buffer &buf = buffers[slot];
+
+  if(!buf.fetched)
+  {
+    buf.fetched = true;
+    if(api && !api->FetchBuffer(slot, buf.data))
+      RDCWARN("Couldn't fetch buffer at set %u binding %u[%u]", slot.set, slot.bind, slot.arrayIdx);
+  }
+
+  return buf.data;
+}
+
+// the type of the value an ID holds, which for variables and access chains is what they point to
+static uint32_t ValueType(const DecodedProgram *program, uint32_t id)
+{
+  uint32_t type = program->idType[id];
+  if(program->types[type].kind == DecodedProgram::Type::Pointer)
+    return program->types[type].elem;
+  return type;
+}
+
+// the descriptor an image or sampler handle refers to
+static BindingSlot HandleSlot(const DecodedProgram *program, uint32_t var, uint32_t arrayIdx)
+{
+  if(var >= program->globalIndex.size() || program->globalIndex[var] < 0)
+    return BindingSlot();
+
+  const DecodedProgram::Variable &v = program->globals[program->globalIndex[var]];
+  return BindingSlot(v.set, v.binding, arrayIdx);
+}
+
+State::State()
+{
+  quadIndex = 0;
+  done = killed = helper = false;
+  program = NULL;
+  curBlock = prevBlock = 0;
+  nextInstruction = 0;
+  flags = ShaderEvents::NoEvent;
+}
+
+State::State(int quadIdx, const DecodedProgram *p)
+{
+  quadIndex = quadIdx;
+  done = killed = helper = false;
+  program = p;
+  curBlock = prevBlock = 0;
+  nextInstruction = 0;
+  flags = ShaderEvents::NoEvent;
+
+  // constants are never written, so they're simply IDs that start out with their value
+  ids = p->constants;
+  pointers.resize(ids.size());
+
+  create_array_uninit(registers, p->registerIDs.size());
+  for(size_t i = 0; i < p->registerIDs.size(); i++)
+  {
+    uint32_t id = p->registerIDs[i];
+    registers[i] = p->MakeValue(ValueType(p, id), p->Name(id));
+  }
+
+  create_array_uninit(indexableTemps, p->indexableIDs.size());
+  for(size_t i = 0; i < p->indexableIDs.size(); i++)
+  {
+    uint32_t id = p->indexableIDs[i];
+    vector<ShaderVariable> leaves;
+    Flatten(p->MakeValue(ValueType(p, id), p->Name(id)), p->Name(id), leaves);
+    indexableTemps[i] = leaves;
+  }
+
+  vector<ShaderVariable> leaves;
+  for(size_t i = 0; i < p->outputIDs.size(); i++)
+  {
+    uint32_t id = p->outputIDs[i];
+    Flatten(p->MakeValue(ValueType(p, id), p->Name(id)), p->Name(id), leaves);
+  }
+  outputs = leaves;
+}
+
+void State::SetInput(uint32_t varId, const ShaderVariable &val)
+{
+  ids[varId] = program->MakeValue(ValueType(program, varId), program->Name(varId));
+  AssignValue(ids[varId], val);
+}
+
+void State::GetInputs(vector<ShaderVariable> &inputs) const
+{
+  for(size_t i = 0; i < program->globals.size(); i++)
+  {
+    const DecodedProgram::Variable &v = program->globals[i];
+    if(v.storage == spv::StorageClassInput)
+      Flatten(ids[v.id], v.name, inputs);
+  }
+}
+
+void State::Init(GlobalState &global)
+{
+  for(size_t i = 0; i < program->globals.size(); i++)
+  {
+    const DecodedProgram::Variable &v = program->globals[i];
+
+    pointers[v.id].base = v.id;
+    pointers[v.id].chain.clear();
+
+    switch(v.storage)
+    {
+      case spv::StorageClassInput:
+        // anything the API side didn't provide is zero
+        if(ids[v.id].rows == 0 && ids[v.id].members.count == 0)
+          ids[v.id] = program->MakeValue(v.type, v.name);
+        break;
+      case spv::StorageClassOutput:
+      case spv::StorageClassPrivate:
+        ids[v.id] = program->MakeValue(v.type, v.name);
+        if(v.init)
+          AssignValue(ids[v.id], ids[v.init]);
+        UpdateSlot(v.id);
+        break;
+      case spv::StorageClassWorkgroup:
+        if(global.workgroup.find(v.id) == global.workgroup.end())
+          global.workgroup[v.id] = program->MakeValue(v.type, v.name);
+        break;
+      default: break;
+    }
+  }
+
+  EnterFunction(program->entryFunc, ~0U, 0, NULL, 0);
+}
+
+bool State::AtThreadBarrier() const
+{
+  return !done && program->instructions[nextInstruction].op == spv::OpControlBarrier;
+}
+
+bool State::AtConvergencePoint() const
+{
+  if(done || curBlock == 0 || !program->mergeBlock[curBlock])
+    return false;
+
+  uint32_t idx = program->labels[curBlock] + 1;
+  while(idx < program->instructions.size() && !program->instructions[idx].step)
+    idx++;
+
+  return nextInstruction == idx;
+}
+
+void State::SetResult(uint32_t id, const ShaderVariable &val)
+{
+  ids[id] = val;
+  ids[id].name = program->Name(id);
+  UpdateSlot(id);
+}
+
+void State::UpdateSlot(uint32_t id)
+{
+  if(id >= program->slots.size())
+    return;
+
+  const DecodedProgram::Slot &slot = program->slots[id];
+  int32_t idx = 0;
+
+  switch(slot.kind)
+  {
+    case DecodedProgram::Slot::Register: registers[slot.index].value = ids[id].value; break;
+    case DecodedProgram::Slot::Indexable:
+      CopyLeaves(ids[id], indexableTemps[slot.index].elems, indexableTemps[slot.index].count, idx);
+      break;
+    case DecodedProgram::Slot::Output:
+      // outputs are flattened one after another, so refresh them all in order
+      for(size_t i = 0; i < program->outputIDs.size(); i++)
+        CopyLeaves(ids[program->outputIDs[i]], outputs.elems, outputs.count, idx);
+      break;
+    default: break;
+  }
+}
+
+void State::EnterFunction(uint32_t func, uint32_t returnInst, uint32_t result, const uint32_t *args,
+                          uint32_t numArgs)
+{
+  const vector<DecodedProgram::Instruction> &insts = program->instructions;
+
+  uint32_t idx = program->functions[func] + 1;
+
+  // parameters alias the arguments, whether they're values or pointers
+  for(uint32_t p = 0; idx < insts.size() && insts[idx].op == spv::OpFunctionParameter; idx++, p++)
+  {
+    if(p < numArgs)
+    {
+      ids[insts[idx].result] = ids[args[p]];
+      pointers[insts[idx].result] = pointers[args[p]];
+    }
+  }
+
+  Frame frame = {func, returnInst, result, curBlock, prevBlock};
+  callstack.push_back(frame);
+
+  if(idx < insts.size() && insts[idx].op == spv::OpLabel)
+  {
+    curBlock = insts[idx].result;
+    prevBlock = 0;
+    idx++;
+  }
+
+  // function variables are all declared at the start of the first block
+  for(; idx < insts.size() && (insts[idx].op == spv::OpVariable || insts[idx].op == spv::OpLine);
+      idx++)
+  {
+    const DecodedProgram::Instruction &var = insts[idx];
+    if(var.op != spv::OpVariable)
+      continue;
+
+    ids[var.result] = program->MakeValue(ValueType(program, var.result), program->Name(var.result));
+    if(var.numArgs > 1)
+      AssignValue(ids[var.result], ids[program->Args(var)[1]]);
+
+    pointers[var.result].base = var.result;
+    pointers[var.result].chain.clear();
+
+    UpdateSlot(var.result);
+  }
+
+  nextInstruction = idx;
+  SkipNonSteps();
+}
+
+void State::JumpToBlock(uint32_t label)
+{
+  const vector<DecodedProgram::Instruction> &insts = program->instructions;
+
+  prevBlock = curBlock;
+  curBlock = label;
+
+  uint32_t idx = program->labels[label] + 1;
+
+  // phis all read their values as of the branch, so evaluate them together before assigning
+  vector<std::pair<uint32_t, uint32_t> > phis;
+
+  for(; idx < insts.size() && (insts[idx].op == spv::OpPhi || insts[idx].op == spv::OpLine); idx++)
+  {
+    const DecodedProgram::Instruction &phi = insts[idx];
+    if(phi.op != spv::OpPhi)
+      continue;
+
+    const uint32_t *a = program->Args(phi);
+    for(uint32_t o = 0; o + 1 < phi.numArgs; o += 2)
+    {
+      if(a[o + 1] == prevBlock)
+      {
+        phis.push_back(std::make_pair(phi.result, a[o]));
+        break;
+      }
+    }
+  }
+
+  vector<ShaderVariable> vals(phis.size());
+  vector<Pointer> ptrs(phis.size());
+  for(size_t i = 0; i < phis.size(); i++)
+  {
+    vals[i] = ids[phis[i].second];
+    ptrs[i] = pointers[phis[i].second];
+  }
+
+  for(size_t i = 0; i < phis.size(); i++)
+  {
+    pointers[phis[i].first] = ptrs[i];
+    SetResult(phis[i].first, vals[i]);
+  }
+
+  nextInstruction = idx;
+  SkipNonSteps();
+}
+
+void State::SkipNonSteps()
+{
+  const vector<DecodedProgram::Instruction> &insts = program->instructions;
+
+  while(nextInstruction < insts.size() && !insts[nextInstruction].step)
+  {
+    const DecodedProgram::Instruction &inst = insts[nextInstruction];
+
+    if(inst.op == spv::OpFunctionEnd)
+    {
+      done = true;
+      return;
+    }
+
+    nextInstruction++;
+  }
+
+  if(nextInstruction >= insts.size())
+    done = true;
+}
+
+BindingSlot State::DescriptorSlot(const Pointer &ptr, size_t &chainStart) const
+{
+  const DecodedProgram::Variable &v = program->globals[program->globalIndex[ptr.base]];
+
+  chainStart = 0;
+
+  if(v.storage == spv::StorageClassPushConstant)
+    return BindingSlot(~0U, 0, 0);
+
+  // arrays of descriptors are indexed by the first step of the chain
+  uint32_t arrayIdx = 0;
+  if(program->types[v.type].kind == DecodedProgram::Type::Array)
+  {
+    arrayIdx = ptr.chain.empty() ? 0 : ptr.chain[0];
+    chainStart = 1;
+  }
+
+  return BindingSlot(v.set, v.binding, arrayIdx);
+}
+
+bool State::BufferPointer(GlobalState &global, const Pointer &ptr, vector<byte> *&data,
+                          uint32_t &type, uint32_t &offset, uint32_t &matrixStride,
+                          bool &rowMajor, uint32_t &vecStride)
+{
+  typedef DecodedProgram::Type Type;
+
+  size_t chainStart = 0;
+  BindingSlot slot = DescriptorSlot(ptr, chainStart);
+
+  data = &global.GetBuffer(slot);
+
+  type = program->globals[program->globalIndex[ptr.base]].type;
+  if(chainStart > 0)
+    type = program->types[type].elem;
+
+  offset = 0;
+  matrixStride = 16;
+  rowMajor = false;
+  vecStride = 0;
+
+  for(size_t i = chainStart; i < ptr.chain.size(); i++)
+  {
+    const Type &t = program->types[type];
+    uint32_t idx = ptr.chain[i];
+    uint32_t compSize = t.scalar == VarType::Double ? 8 : 4;
+
+    switch(t.kind)
+    {
+      case Type::Struct:
+      {
+        if(idx >= t.members.size())
+          return false;
+        const Type::Member &m = t.members[idx];
+        offset += m.offset;
+        matrixStride = m.matrixStride;
+        rowMajor = m.rowMajor;
+        type = m.type;
+        break;
+      }
+      case Type::Array:
+        offset += idx * t.arrayStride;
+        type = t.elem;
+        break;
+      case Type::Matrix:
+        // a column of a row-major matrix has its components a whole row apart
+        if(rowMajor)
+        {
+          offset += idx * compSize;
+          vecStride = matrixStride;
+        }
+        else
+        {
+          offset += idx * matrixStride;
+        }
+        type = t.elem;
+        break;
+      case Type::Vector:
+        offset += idx * (vecStride ? vecStride : compSize);
+        vecStride = 0;
+        type = t.elem;
+        break;
+      default: return false;
+    }
+  }
+
+  return true;
+}
+
+ShaderVariable State::Load(GlobalState &global, const Pointer &ptr)
+{
+  typedef DecodedProgram::Type Type;
+
+  if(ptr.base == 0)
+    return ShaderVariable();
+
+  int32_t g = program->globalIndex[ptr.base];
+  spv::StorageClass storage = g >= 0 ? program->globals[g].storage : spv::StorageClassFunction;
+
+  switch(storage)
+  {
+    case spv::StorageClassUniform:
+    case spv::StorageClassPushConstant:
+    {
+      vector<byte> *data = NULL;
+      uint32_t type = 0, offset = 0, matrixStride = 0, vecStride = 0;
+      bool rowMajor = false;
+
+      if(!BufferPointer(global, ptr, data, type, offset, matrixStride, rowMajor, vecStride))
+        return ShaderVariable();
+
+      return program->ReadMemory(data->data(), data->size(), type, offset, matrixStride, rowMajor,
+                                 vecStride, "");
+    }
+    case spv::StorageClassUniformConstant:
+    {
+      // images and samplers load as a handle to their descriptor
+      uint32_t type = program->globals[g].type;
+      uint32_t arrayIdx = 0;
+      if(program->types[type].kind == Type::Array)
+      {
+        type = program->types[type].elem;
+        arrayIdx = ptr.chain.empty() ? 0 : ptr.chain[0];
+      }
+
+      ShaderVariable handle = program->MakeValue(type, "");
+      Type::Kind kind = program->types[type].kind;
+
+      if(kind != Type::Sampler)
+      {
+        handle.value.uv[0] = ptr.base;
+        handle.value.uv[1] = arrayIdx;
+      }
+      if(kind != Type::Image)
+      {
+        handle.value.uv[2] = ptr.base;
+        handle.value.uv[3] = arrayIdx;
+      }
+
+      return handle;
+    }
+    case spv::StorageClassWorkgroup:
+    {
+      std::map<uint32_t, ShaderVariable>::iterator it = global.workgroup.find(ptr.base);
+      if(it == global.workgroup.end())
+        return ShaderVariable();
+      return ReadChain(it->second, ptr.chain.data(), ptr.chain.size());
+    }
+    default: break;
+  }
+
+  return ReadChain(ids[ptr.base], ptr.chain.data(), ptr.chain.size());
+}
+
+void State::Store(GlobalState &global, const Pointer &ptr, const ShaderVariable &val)
+{
+  if(ptr.base == 0)
+    return;
+
+  int32_t g = program->globalIndex[ptr.base];
+  spv::StorageClass storage = g >= 0 ? program->globals[g].storage : spv::StorageClassFunction;
+
+  if(helper && (storage == spv::StorageClassUniform || storage == spv::StorageClassWorkgroup))
+    return;
+
+  switch(storage)
+  {
+    case spv::StorageClassUniform:
+    {
+      vector<byte> *data = NULL;
+      uint32_t type = 0, offset = 0, matrixStride = 0, vecStride = 0;
+      bool rowMajor = false;
+
+      if(BufferPointer(global, ptr, data, type, offset, matrixStride, rowMajor, vecStride))
+        program->WriteMemory(data->data(), data->size(), type, offset, matrixStride, rowMajor,
+                             vecStride, val);
+      return;
+    }
+    case spv::StorageClassPushConstant:
+    case spv::StorageClassUniformConstant: return;
+    case spv::StorageClassWorkgroup:
+      WriteChain(global.workgroup[ptr.base], ptr.chain.data(), ptr.chain.size(), val);
+      return;
+    default: break;
+  }
+
+  WriteChain(ids[ptr.base], ptr.chain.data(), ptr.chain.size(), val);
+  UpdateSlot(ptr.base);
+}
+
+ShaderVariable State::Derivative(bool xdir, bool fine, State *quad, uint32_t id) const
+{
+  ShaderVariable ret = ids[id];
+
+  for(uint32_t c = 0; c < NumComps(ret); c++)
+    SetF(ret, c, 0.0);
+
+  if(quad == NULL)
+    return ret;
+
+  // quad lanes are top-left, top-right, bottom-left, bottom-right. Coarse derivatives always use
+  // the top-left lane as the reference, fine ones use this lane's row or column.
+  int a = 0, b = 0;
+  if(xdir)
+  {
+    a = fine ? (quadIndex & 2) : 0;
+    b = a + 1;
+  }
+  else
+  {
+    a = fine ? (quadIndex & 1) : 0;
+    b = a + 2;
+  }
+
+  const ShaderVariable &va = quad[a].ids[id];
+  const ShaderVariable &vb = quad[b].ids[id];
+
+  for(uint32_t c = 0; c < NumComps(ret); c++)
+    SetF(ret, c, GetF(vb, c) - GetF(va, c));
+
+  return ret;
+}
+
+void State::StepNext(GlobalState &global, State *quad)
+{
+  if(done)
+    return;
+
+  const DecodedProgram::Instruction &inst = program->instructions[nextInstruction];
+  const uint32_t *a = program->Args(inst);
+
+  flags = ShaderEvents::NoEvent;
+
+  switch(inst.op)
+  {
+    case spv::OpBranch: JumpToBlock(a[0]); return;
+    case spv::OpBranchConditional: JumpToBlock(ids[a[0]].value.uv[0] ? a[1] : a[2]); return;
+    case spv::OpSwitch:
+    {
+      uint32_t selector = ids[a[0]].value.uv[0];
+      uint32_t target = a[1];
+      for(uint32_t o = 2; o + 1 < inst.numArgs; o += 2)
+      {
+        if(a[o] == selector)
+        {
+          target = a[o + 1];
+          break;
+        }
+      }
+      JumpToBlock(target);
+      return;
+    }
+    case spv::OpReturn:
+    case spv::OpReturnValue:
+    {
+      Frame frame = callstack.back();
+      callstack.pop_back();
+
+      if(callstack.empty())
+      {
+        done = true;
+        return;
+      }
+
+      if(inst.op == spv::OpReturnValue && frame.result)
+        SetResult(frame.result, ids[a[0]]);
+
+      curBlock = frame.curBlock;
+      prevBlock = frame.prevBlock;
+      nextInstruction = frame.returnInst + 1;
+      SkipNonSteps();
+      return;
+    }
+    case spv::OpKill:
+      killed = true;
+      done = true;
+      return;
+    case spv::OpUnreachable: done = true; return;
+    case spv::OpFunctionCall:
+      EnterFunction(a[0], nextInstruction, inst.result, a + 1, inst.numArgs - 1);
+      return;
+    case spv::OpStore: Store(global, pointers[a[0]], ids[a[1]]); break;
+    case spv::OpCopyMemory: Store(global, pointers[a[0]], Load(global, pointers[a[1]])); break;
+    case spv::OpAccessChain:
+    case spv::OpInBoundsAccessChain:
+    {
+      Pointer ptr = pointers[a[0]];
+      for(uint32_t o = 1; o < inst.numArgs; o++)
+        ptr.chain.push_back(ids[a[o]].value.uv[0]);
+      pointers[inst.result] = ptr;
+      break;
+    }
+    case spv::OpLoad:
+    {
+      ShaderVariable result = program->MakeValue(inst.type, "");
+      AssignValue(result, Load(global, pointers[a[0]]));
+      SetResult(inst.result, result);
+      break;
+    }
+    case spv::OpAtomicStore:
+    case spv::OpImageWrite:
+    {
+      ShaderVariable unused;
+      bool ok = inst.op == spv::OpAtomicStore ? Atomic(global, inst, unused)
+                                              : ImageOp(global, inst, quad, unused);
+      if(!ok)
+        RDCWARN("Unsupported instruction %s while debugging", ToStr::Get(inst.op).c_str());
+      break;
+    }
+    case spv::OpControlBarrier:
+    case spv::OpMemoryBarrier:
+      // threads are kept in sync by whoever is stepping them, memory is always coherent
+      break;
+    default:
+    {
+      if(inst.result && program->types[inst.type].kind == DecodedProgram::Type::Pointer)
+      {
+        // pointers can only be copied or selected between
+        if(inst.op == spv::OpCopyObject)
+          pointers[inst.result] = pointers[a[0]];
+        else if(inst.op == spv::OpSelect)
+          pointers[inst.result] = pointers[ids[a[0]].value.uv[0] ? a[1] : a[2]];
+        else
+          RDCWARN("Unsupported pointer instruction %s", ToStr::Get(inst.op).c_str());
+        break;
+      }
+
+      ShaderVariable result = program->MakeValue(inst.type, "");
+      if(!EvaluateOp(&global, inst, quad, result))
+      {
+        RDCWARN("Unsupported instruction %s while debugging", ToStr::Get(inst.op).c_str());
+        break;
+      }
+
+      if(inst.result)
+      {
+        if(result.type == VarType::Float || result.type == VarType::Double)
+        {
+          for(uint32_t c = 0; c < NumComps(result); c++)
+          {
+            double d = GetF(result, c);
+            if(std::isnan(d) || std::isinf(d))
+              flags |= ShaderEvents::GeneratedNanOrInf;
+          }
+        }
+
+        SetResult(inst.result, result);
+      }
+      break;
+    }
+  }
+
+  nextInstruction++;
+  SkipNonSteps();
+}
+
+// component c of v, or its only component if it's a scalar being applied to a vector
+static double GetFC(const ShaderVariable &v, uint32_t c)
+{
+  return GetF(v, NumComps(v) == 1 ? 0 : c);
+}
+
+static uint32_t GetUC(const ShaderVariable &v, uint32_t c)
+{
+  return v.value.uv[NumComps(v) == 1 ? 0 : c];
+}
+
+static void CopyComp(ShaderVariable &dst, uint32_t dc, const ShaderVariable &src, uint32_t sc)
+{
+  if(src.type == VarType::Double)
+    dst.value.dv[dc] = src.value.dv[sc];
+  else
+    dst.value.uv[dc] = src.value.uv[sc];
+}
+
+static uint32_t BitReverse(uint32_t x)
+{
+  uint32_t ret = 0;
+  for(int i = 0; i < 32; i++)
+    if(x & (1U << i))
+      ret |= 1U << (31 - i);
+  return ret;
+}
+
+static uint32_t BitCount(uint32_t x)
+{
+  uint32_t ret = 0;
+  for(; x; x &= x - 1)
+    ret++;
+  return ret;
+}
+
+static uint32_t BitMask(uint32_t count)
+{
+  return count >= 32 ? ~0U : (1U << count) - 1;
+}
+
+bool State::EvaluateOp(GlobalState *global, const DecodedProgram::Instruction &inst, State *quad,
+                       ShaderVariable &result)
+{
+  const uint32_t *a = program->Args(inst);
+  const uint32_t N = NumComps(result);
+
+#define ARG(i) ids[a[i]]
+
+  switch(inst.op)
+  {
+    case spv::OpCopyObject: AssignValue(result, ARG(0)); return true;
+
+    //////////////////////////////////////////////////////////////////////////
+    // composites
+
+    case spv::OpCompositeConstruct:
+    {
+      if(result.members.count > 0)
+      {
+        for(uint32_t o = 0; o < inst.numArgs; o++)
+          Insert(result, o, ARG(o));
+      }
+      else if(result.rows > 1)
+      {
+        // matrices are constructed from columns
+        for(uint32_t o = 0; o < inst.numArgs; o++)
+          Insert(result, o, ARG(o));
+      }
+      else
+      {
+        uint32_t c = 0;
+        for(uint32_t o = 0; o < inst.numArgs; o++)
+          for(uint32_t s = 0; s < NumComps(ARG(o)) && c < N; s++)
+            CopyComp(result, c++, ARG(o), s);
+      }
+      return true;
+    }
+    case spv::OpCompositeExtract:
+      AssignValue(result, ReadChain(ARG(0), a + 1, inst.numArgs - 1));
+      return true;
+    case spv::OpCompositeInsert:
+      AssignValue(result, ARG(1));
+      WriteChain(result, a + 2, inst.numArgs - 2, ARG(0));
+      return true;
+    case spv::OpVectorShuffle:
+    {
+      const ShaderVariable &v1 = ARG(0), &v2 = ARG(1);
+      uint32_t n1 = NumComps(v1);
+      for(uint32_t c = 0; c < N && c + 2 < inst.numArgs; c++)
+      {
+        uint32_t idx = a[c + 2];
+        if(idx == ~0U)
+          continue;
+        if(idx < n1)
+          CopyComp(result, c, v1, idx);
+        else
+          CopyComp(result, c, v2, idx - n1);
+      }
+      return true;
+    }
+    case spv::OpVectorExtractDynamic:
+    {
+      uint32_t idx = ARG(1).value.uv[0];
+      if(idx < NumComps(ARG(0)))
+        CopyComp(result, 0, ARG(0), idx);
+      return true;
+    }
+    case spv::OpVectorInsertDynamic:
+    {
+      AssignValue(result, ARG(0));
+      uint32_t idx = ARG(2).value.uv[0];
+      if(idx < N)
+        CopyComp(result, idx, ARG(1), 0);
+      return true;
+    }
+    case spv::OpTranspose:
+    {
+      const ShaderVariable &m = ARG(0);
+      for(uint32_t r = 0; r < result.rows; r++)
+        for(uint32_t c = 0; c < result.columns; c++)
+          CopyComp(result, r * result.columns + c, m, c * m.columns + r);
+      return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    // conversions
+
+    case spv::OpConvertFToU:
+      for(uint32_t c = 0; c < N; c++)
+      {
+        double d = GetF(ARG(0), c);
+        result.value.uv[c] = d <= 0.0 ? 0U : d >= 4294967295.0 ? ~0U : (uint32_t)d;
+      }
+      return true;
+    case spv::OpConvertFToS:
+      for(uint32_t c = 0; c < N; c++)
+      {
+        double d = GetF(ARG(0), c);
+        result.value.iv[c] = d <= -2147483648.0 ? INT32_MIN
+                                                : d >= 2147483647.0 ? INT32_MAX : (int32_t)d;
+      }
+      return true;
+    case spv::OpConvertSToF:
+      for(uint32_t c = 0; c < N; c++)
+        SetF(result, c, (double)ARG(0).value.iv[c]);
+      return true;
+    case spv::OpConvertUToF:
+      for(uint32_t c = 0; c < N; c++)
+        SetF(result, c, (double)ARG(0).value.uv[c]);
+      return true;
+    case spv::OpUConvert:
+    case spv::OpSConvert:
+      // only 32-bit integers are supported, so these are copies
+      for(uint32_t c = 0; c < N; c++)
+        result.value.uv[c] = ARG(0).value.uv[c];
+      return true;
+    case spv::OpFConvert:
+      for(uint32_t c = 0; c < N; c++)
+        SetF(result, c, GetF(ARG(0), c));
+      return true;
+    case spv::OpBitcast: result.value = ARG(0).value; return true;
+    case spv::OpQuantizeToF16:
+      for(uint32_t c = 0; c < N; c++)
+        result.value.fv[c] = ConvertFromHalf(ConvertToHalf(ARG(0).value.fv[c]));
+      return true;
+
+    //////////////////////////////////////////////////////////////////////////
+    // arithmetic
+
+    case spv::OpSNegate:
+      for(uint32_t c = 0; c < N; c++)
+        result.value.uv[c] = 0U - ARG(0).value.uv[c];
+      return true;
+    case spv::OpFNegate:
+      for(uint32_t c = 0; c < N; c++)
+        SetF(result, c, -GetF(ARG(0), c));
+      return true;
+    case spv::OpIAdd:
+    case spv::OpISub:
+    case spv::OpIMul:
+      for(uint32_t c = 0; c < N; c++)
+      {
+        uint32_t x = ARG(0).value.uv[c], y = ARG(1).value.uv[c];
+        if(inst.op == spv::OpIAdd)
+          result.value.uv[c] = x + y;
+        else if(inst.op == spv::OpISub)
+          result.value.uv[c] = x - y;
+        else
+          result.value.uv[c] = x * y;
+      }
+      return true;
+    case spv::OpUDiv:
+    case spv::OpUMod:
+      for(uint32_t c = 0; c < N; c++)
+      {
+        uint32_t x = ARG(0).value.uv[c], y = ARG(1).value.uv[c];
+        if(y == 0)
+          result.value.uv[c] = ~0U;
+        else
+          result.value.uv[c] = inst.op == spv::OpUDiv ? x / y : x % y;
+      }
+      return true;
+    case spv::OpSDiv:
+    case spv::OpSRem:
+    case spv::OpSMod:
+      for(uint32_t c = 0; c < N; c++)
+      {
+        int32_t x = ARG(0).value.iv[c], y = ARG(1).value.iv[c];
+        if(y == 0)
+        {
+          result.value.iv[c] = -1;
+        }
+        else if(y == -1)
+        {
+          // avoid INT_MIN / -1 overflowing
+          result.value.iv[c] = inst.op == spv::OpSDiv ? (int32_t)(0U - (uint32_t)x) : 0;
+        }
+        else if(inst.op == spv::OpSDiv)
+        {
+          result.value.iv[c] = x / y;
+        }
+        else
+        {
+          int32_t r = x % y;
+          // SMod takes the sign of the divisor, SRem of the dividend like C
+          if(inst.op == spv::OpSMod && r != 0 && ((r < 0) != (y < 0)))
+            r += y;
+          result.value.iv[c] = r;
+        }
+      }
+      return true;
+    case spv::OpFAdd:
+    case spv::OpFSub:
+    case spv::OpFMul:
+    case spv::OpFDiv:
+    case spv::OpFRem:
+    case spv::OpFMod:
+      for(uint32_t c = 0; c < N; c++)
+      {
+        double x = GetF(ARG(0), c), y = GetF(ARG(1), c), r = 0.0;
+        switch(inst.op)
+        {
+          case spv::OpFAdd: r = x + y; break;
+          case spv::OpFSub: r = x - y; break;
+          case spv::OpFMul: r = x * y; break;
+          case spv::OpFDiv: r = x / y; break;
+          case spv::OpFRem: r = fmod(x, y); break;
+          default: r = x - y * floor(x / y); break;
+        }
+        // compute in the precision of the result
+        if(result.type == VarType::Float)
+        {
+          float fx = (float)x, fy = (float)y;
+          switch(inst.op)
+          {
+            case spv::OpFAdd: r = fx + fy; break;
+            case spv::OpFSub: r = fx - fy; break;
+            case spv::OpFMul: r = fx * fy; break;
+            case spv::OpFDiv: r = fx / fy; break;
+            default: break;
+          }
+        }
+        SetF(result, c, r);
+      }
+      return true;
+    case spv::OpVectorTimesScalar:
+    case spv::OpMatrixTimesScalar:
+      for(uint32_t c = 0; c < N; c++)
+        SetF(result, c, GetF(ARG(0), c) * GetF(ARG(1), 0));
+      return true;
+    case spv::OpMatrixTimesVector:
+    {
+      const ShaderVariable &m = ARG(0), &v = ARG(1);
+      for(uint32_t r = 0; r < m.rows; r++)
+      {
+        double sum = 0.0;
+        for(uint32_t c = 0; c < m.columns; c++)
+          sum += GetF(m, r * m.columns + c) * GetF(v, c);
+        SetF(result, r, sum);
+      }
+      return true;
+    }
+    case spv::OpVectorTimesMatrix:
+    {
+      const ShaderVariable &v = ARG(0), &m = ARG(1);
+      for(uint32_t c = 0; c < m.columns; c++)
+      {
+        double sum = 0.0;
+        for(uint32_t r = 0; r < m.rows; r++)
+          sum += GetF(v, r) * GetF(m, r * m.columns + c);
+        SetF(result, c, sum);
+      }
+      return true;
+    }
+    case spv::OpMatrixTimesMatrix:
+    {
+      const ShaderVariable &l = ARG(0), &r = ARG(1);
+      for(uint32_t row = 0; row < result.rows; row++)
+      {
+        for(uint32_t col = 0; col < result.columns; col++)
+        {
+          double sum = 0.0;
+          for(uint32_t k = 0; k < l.columns; k++)
+            sum += GetF(l, row * l.columns + k) * GetF(r, k * r.columns + col);
+          SetF(result, row * result.columns + col, sum);
+        }
+      }
+      return true;
+    }
+    case spv::OpOuterProduct:
+      for(uint32_t r = 0; r < result.rows; r++)
+        for(uint32_t c = 0; c < result.columns; c++)
+          SetF(result, r * result.columns + c, GetF(ARG(0), r) * GetF(ARG(1), c));
+      return true;
+    case spv::OpDot:
+    {
+      double sum = 0.0;
+      for(uint32_t c = 0; c < NumComps(ARG(0)); c++)
+        sum += GetF(ARG(0), c) * GetF(ARG(1), c);
+      SetF(result, 0, sum);
+      return true;
+    }
+    case spv::OpIAddCarry:
+    case spv::OpISubBorrow:
+    case spv::OpUMulExtended:
+    case spv::OpSMulExtended:
+    {
+      // the results are a struct of two vectors
+      if(result.members.count != 2)
+        return false;
+      ShaderVariable &lo = result.members[0], &hi = result.members[1];
+      for(uint32_t c = 0; c < NumComps(lo); c++)
+      {
+        uint32_t x = ARG(0).value.uv[c], y = ARG(1).value.uv[c];
+        switch(inst.op)
+        {
+          case spv::OpIAddCarry:
+            lo.value.uv[c] = x + y;
+            hi.value.uv[c] = lo.value.uv[c] < x ? 1 : 0;
+            break;
+          case spv::OpISubBorrow:
+            lo.value.uv[c] = x - y;
+            hi.value.uv[c] = y > x ? 1 : 0;
+            break;
+          case spv::OpUMulExtended:
+          {
+            uint64_t m = (uint64_t)x * (uint64_t)y;
+            lo.value.uv[c] = uint32_t(m & 0xffffffff);
+            hi.value.uv[c] = uint32_t(m >> 32);
+            break;
+          }
+          default:
+          {
+            int64_t m = (int64_t)(int32_t)x * (int64_t)(int32_t)y;
+            lo.value.uv[c] = uint32_t(uint64_t(m) & 0xffffffff);
+            hi.value.uv[c] = uint32_t(uint64_t(m) >> 32);
+            break;
+          }
+        }
+      }
+      return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    // bit operations
+
+    case spv::OpShiftRightLogical:
+    case spv::OpShiftRightArithmetic:
+    case spv::OpShiftLeftLogical:
+    case spv::OpBitwiseOr:
+    case spv::OpBitwiseXor:
+    case spv::OpBitwiseAnd:
+      for(uint32_t c = 0; c < N; c++)
+      {
+        uint32_t x = ARG(0).value.uv[c], y = GetUC(ARG(1), c);
+        switch(inst.op)
+        {
+          case spv::OpShiftRightLogical: result.value.uv[c] = x >> (y & 31); break;
+          case spv::OpShiftRightArithmetic:
+            result.value.iv[c] = ARG(0).value.iv[c] >> (y & 31);
+            break;
+          case spv::OpShiftLeftLogical: result.value.uv[c] = x << (y & 31); break;
+          case spv::OpBitwiseOr: result.value.uv[c] = x | y; break;
+          case spv::OpBitwiseXor: result.value.uv[c] = x ^ y; break;
+          default: result.value.uv[c] = x & y; break;
+        }
+      }
+      return true;
+    case spv::OpNot:
+      for(uint32_t c = 0; c < N; c++)
+        result.value.uv[c] = ~ARG(0).value.uv[c];
+      return true;
+    case spv::OpBitFieldInsert:
+    {
+      uint32_t offset = ARG(2).value.uv[0] & 31, count = ARG(3).value.uv[0];
+      uint32_t mask = BitMask(count) << offset;
+      for(uint32_t c = 0; c < N; c++)
+        result.value.uv[c] =
+            (ARG(0).value.uv[c] & ~mask) | ((ARG(1).value.uv[c] << offset) & mask);
+      return true;
+    }
+    case spv::OpBitFieldSExtract:
+    case spv::OpBitFieldUExtract:
+    {
+      uint32_t offset = ARG(1).value.uv[0] & 31, count = ARG(2).value.uv[0];
+      for(uint32_t c = 0; c < N; c++)
+      {
+        uint32_t x = (ARG(0).value.uv[c] >> offset) & BitMask(count);
+        // sign extend from the top bit extracted
+        if(inst.op == spv::OpBitFieldSExtract && count > 0 && count < 32 &&
+           (x & (1U << (count - 1))))
+          x |= ~BitMask(count);
+        result.value.uv[c] = count == 0 ? 0 : x;
+      }
+      return true;
+    }
+    case spv::OpBitReverse:
+      for(uint32_t c = 0; c < N; c++)
+        result.value.uv[c] = BitReverse(ARG(0).value.uv[c]);
+      return true;
+    case spv::OpBitCount:
+      for(uint32_t c = 0; c < N; c++)
+        result.value.uv[c] = BitCount(ARG(0).value.uv[c]);
+      return true;
+
+    //////////////////////////////////////////////////////////////////////////
+    // relational and logical
+
+    case spv::OpAny:
+    case spv::OpAll:
+    {
+      bool any = false, all = true;
+      for(uint32_t c = 0; c < NumComps(ARG(0)); c++)
+      {
+        any |= ARG(0).value.uv[c] != 0;
+        all &= ARG(0).value.uv[c] != 0;
+      }
+      result.value.uv[0] = (inst.op == spv::OpAny ? any : all) ? 1 : 0;
+      return true;
+    }
+    case spv::OpIsNan:
+    case spv::OpIsInf:
+      for(uint32_t c = 0; c < N; c++)
+      {
+        double d = GetF(ARG(0), c);
+        result.value.uv[c] = (inst.op == spv::OpIsNan ? std::isnan(d) : std::isinf(d)) ? 1 : 0;
+      }
+      return true;
+    case spv::OpLogicalEqual:
+    case spv::OpLogicalNotEqual:
+    case spv::OpLogicalOr:
+    case spv::OpLogicalAnd:
+      for(uint32_t c = 0; c < N; c++)
+      {
+        bool x = ARG(0).value.uv[c] != 0, y = ARG(1).value.uv[c] != 0;
+        bool r = inst.op == spv::OpLogicalEqual
+                     ? x == y
+                     : inst.op == spv::OpLogicalNotEqual ? x != y
+                                                         : inst.op == spv::OpLogicalOr ? x || y
+                                                                                       : x && y;
+        result.value.uv[c] = r ? 1 : 0;
+      }
+      return true;
+    case spv::OpLogicalNot:
+      for(uint32_t c = 0; c < N; c++)
+        result.value.uv[c] = ARG(0).value.uv[c] ? 0 : 1;
+      return true;
+    case spv::OpSelect:
+    {
+      const ShaderVariable &cond = ARG(0);
+      if(NumComps(cond) == 1 || result.members.count > 0)
+      {
+        AssignValue(result, cond.value.uv[0] ? ARG(1) : ARG(2));
+      }
+      else
+      {
+        for(uint32_t c = 0; c < N; c++)
+          CopyComp(result, c, cond.value.uv[c] ? ARG(1) : ARG(2), c);
+      }
+      return true;
+    }
+    case spv::OpIEqual:
+    case spv::OpINotEqual:
+    case spv::OpUGreaterThan:
+    case spv::OpSGreaterThan:
+    case spv::OpUGreaterThanEqual:
+    case spv::OpSGreaterThanEqual:
+    case spv::OpULessThan:
+    case spv::OpSLessThan:
+    case spv::OpULessThanEqual:
+    case spv::OpSLessThanEqual:
+      for(uint32_t c = 0; c < N; c++)
+      {
+        uint32_t ux = ARG(0).value.uv[c], uy = ARG(1).value.uv[c];
+        int32_t sx = ARG(0).value.iv[c], sy = ARG(1).value.iv[c];
+        bool r = false;
+        switch(inst.op)
+        {
+          case spv::OpIEqual: r = ux == uy; break;
+          case spv::OpINotEqual: r = ux != uy; break;
+          case spv::OpUGreaterThan: r = ux > uy; break;
+          case spv::OpSGreaterThan: r = sx > sy; break;
+          case spv::OpUGreaterThanEqual: r = ux >= uy; break;
+          case spv::OpSGreaterThanEqual: r = sx >= sy; break;
+          case spv::OpULessThan: r = ux < uy; break;
+          case spv::OpSLessThan: r = sx < sy; break;
+          case spv::OpULessThanEqual: r = ux <= uy; break;
+          default: r = sx <= sy; break;
+        }
+        result.value.uv[c] = r ? 1 : 0;
+      }
+      return true;
+    case spv::OpFOrdEqual:
+    case spv::OpFUnordEqual:
+    case spv::OpFOrdNotEqual:
+    case spv::OpFUnordNotEqual:
+    case spv::OpFOrdLessThan:
+    case spv::OpFUnordLessThan:
+    case spv::OpFOrdGreaterThan:
+    case spv::OpFUnordGreaterThan:
+    case spv::OpFOrdLessThanEqual:
+    case spv::OpFUnordLessThanEqual:
+    case spv::OpFOrdGreaterThanEqual:
+    case spv::OpFUnordGreaterThanEqual:
+      for(uint32_t c = 0; c < N; c++)
+      {
+        double x = GetF(ARG(0), c), y = GetF(ARG(1), c);
+        bool r = false;
+        if(std::isnan(x) || std::isnan(y))
+        {
+          // ordered comparisons are false with NaNs, unordered ones true
+          r = inst.op == spv::OpFUnordEqual || inst.op == spv::OpFUnordNotEqual ||
+              inst.op == spv::OpFUnordLessThan || inst.op == spv::OpFUnordGreaterThan ||
+              inst.op == spv::OpFUnordLessThanEqual || inst.op == spv::OpFUnordGreaterThanEqual;
+        }
+        else
+        {
+          switch(inst.op)
+          {
+            case spv::OpFOrdEqual:
+            case spv::OpFUnordEqual: r = x == y; break;
+            case spv::OpFOrdNotEqual:
+            case spv::OpFUnordNotEqual: r = x != y; break;
+            case spv::OpFOrdLessThan:
+            case spv::OpFUnordLessThan: r = x < y; break;
+            case spv::OpFOrdGreaterThan:
+            case spv::OpFUnordGreaterThan: r = x > y; break;
+            case spv::OpFOrdLessThanEqual:
+            case spv::OpFUnordLessThanEqual: r = x <= y; break;
+            default: r = x >= y; break;
+          }
+        }
+        result.value.uv[c] = r ? 1 : 0;
+      }
+      return true;
+
+    //////////////////////////////////////////////////////////////////////////
+    // derivatives
+
+    case spv::OpDPdx:
+    case spv::OpDPdxCoarse:
+    case spv::OpDPdxFine:
+    case spv::OpDPdy:
+    case spv::OpDPdyCoarse:
+    case spv::OpDPdyFine:
+    {
+      bool xdir = inst.op == spv::OpDPdx || inst.op == spv::OpDPdxCoarse ||
+                  inst.op == spv::OpDPdxFine;
+      bool fine = inst.op == spv::OpDPdxFine || inst.op == spv::OpDPdyFine;
+      AssignValue(result, Derivative(xdir, fine, quad, a[0]));
+      return true;
+    }
+    case spv::OpFwidth:
+    case spv::OpFwidthCoarse:
+    case spv::OpFwidthFine:
+    {
+      bool fine = inst.op == spv::OpFwidthFine;
+      ShaderVariable dx = Derivative(true, fine, quad, a[0]);
+      ShaderVariable dy = Derivative(false, fine, quad, a[0]);
+      for(uint32_t c = 0; c < N; c++)
+        SetF(result, c, fabs(GetF(dx, c)) + fabs(GetF(dy, c)));
+      return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    // everything else needs the global state
+
+    case spv::OpExtInst: return global && ExtInst(*global, inst, result);
+
+    case spv::OpAtomicLoad:
+    case spv::OpAtomicExchange:
+    case spv::OpAtomicCompareExchange:
+    case spv::OpAtomicIIncrement:
+    case spv::OpAtomicIDecrement:
+    case spv::OpAtomicIAdd:
+    case spv::OpAtomicISub:
+    case spv::OpAtomicSMin:
+    case spv::OpAtomicUMin:
+    case spv::OpAtomicSMax:
+    case spv::OpAtomicUMax:
+    case spv::OpAtomicAnd:
+    case spv::OpAtomicOr:
+    case spv::OpAtomicXor: return global && Atomic(*global, inst, result);
+
+    case spv::OpArrayLength:
+    {
+      if(!global)
+        return false;
+
+      // the length of the runtime array at the end of a storage buffer's block
+      Pointer ptr = pointers[a[0]];
+      size_t chainStart = 0;
+      BindingSlot slot = DescriptorSlot(ptr, chainStart);
+      const vector<byte> &data = global->GetBuffer(slot);
+
+      uint32_t type = program->globals[program->globalIndex[ptr.base]].type;
+      if(chainStart > 0)
+        type = program->types[type].elem;
+
+      const DecodedProgram::Type &block = program->types[type];
+      if(a[1] >= block.members.size())
+        return false;
+
+      const DecodedProgram::Type::Member &m = block.members[a[1]];
+      uint32_t stride = program->types[m.type].arrayStride;
+      result.value.uv[0] =
+          stride && data.size() > m.offset ? uint32_t((data.size() - m.offset) / stride) : 0;
+      return true;
+    }
+
+    case spv::OpSampledImage:
+    case spv::OpImage:
+    case spv::OpImageSampleImplicitLod:
+    case spv::OpImageSampleExplicitLod:
+    case spv::OpImageSampleDrefImplicitLod:
+    case spv::OpImageSampleDrefExplicitLod:
+    case spv::OpImageSampleProjImplicitLod:
+    case spv::OpImageSampleProjExplicitLod:
+    case spv::OpImageSampleProjDrefImplicitLod:
+    case spv::OpImageSampleProjDrefExplicitLod:
+    case spv::OpImageFetch:
+    case spv::OpImageGather:
+    case spv::OpImageDrefGather:
+    case spv::OpImageRead:
+    case spv::OpImageQuerySizeLod:
+    case spv::OpImageQuerySize:
+    case spv::OpImageQueryLod:
+    case spv::OpImageQueryLevels:
+    case spv::OpImageQuerySamples: return global && ImageOp(*global, inst, quad, result);
+
+    default: break;
+  }
+
+#undef ARG
+
+  return false;
+}
+
+// loads a square matrix into doubles, m[row][col]
+static void GetMatrix(const ShaderVariable &v, double m[4][4])
+{
+  for(uint32_t r = 0; r < v.rows && r < 4; r++)
+    for(uint32_t c = 0; c < v.columns && c < 4; c++)
+      m[r][c] = GetF(v, r * v.columns + c);
+}
+
+static double Determinant(double m[4][4], uint32_t n)
+{
+  if(n == 1)
+    return m[0][0];
+  if(n == 2)
+    return m[0][0] * m[1][1] - m[0][1] * m[1][0];
+
+  // cofactor expansion along the first row
+  double det = 0.0;
+  for(uint32_t col = 0; col < n; col++)
+  {
+    double sub[4][4];
+    for(uint32_t r = 1; r < n; r++)
+    {
+      uint32_t sc = 0;
+      for(uint32_t c = 0; c < n; c++)
+        if(c != col)
+          sub[r - 1][sc++] = m[r][c];
+    }
+    det += ((col & 1) ? -1.0 : 1.0) * m[0][col] * Determinant(sub, n - 1);
+  }
+  return det;
+}
+
+static uint32_t PackNorm(double v, bool snorm, uint32_t bits)
+{
+  double scale = double((1U << (snorm ? bits - 1 : bits)) - 1);
+  v = snorm ? std::max(-1.0, std::min(1.0, v)) : std::max(0.0, std::min(1.0, v));
+  int32_t i = (int32_t)floor(v * scale + 0.5);
+  return uint32_t(i) & BitMask(bits);
+}
+
+static float UnpackNorm(uint32_t v, bool snorm, uint32_t bits)
+{
+  v &= BitMask(bits);
+  if(snorm)
+  {
+    // sign extend
+    int32_t i = int32_t(v << (32 - bits)) >> (32 - bits);
+    return std::max(-1.0f, float(i) / float((1U << (bits - 1)) - 1));
+  }
+  return float(v) / float(BitMask(bits));
+}
+
+bool State::ExtInst(GlobalState &global, const DecodedProgram::Instruction &inst,
+                    ShaderVariable &result)
+{
+  const uint32_t *a = program->Args(inst);
+
+  if(inst.numArgs < 2 || a[0] != program->glslStd450)
+    return false;
+
+  GLSLstd450 op = GLSLstd450(a[1]);
+  const uint32_t N = NumComps(result);
+
+  // operands
+  a += 2;
+  uint32_t numOps = inst.numArgs - 2;
+  if(numOps == 0)
+    return false;
+
+#define ARG(i) ids[a[i]]
+
+  const ShaderVariable &x = ARG(0);
+
+  switch(op)
+  {
+    case GLSLstd450Round:
+    case GLSLstd450RoundEven:
+    case GLSLstd450Trunc:
+    case GLSLstd450FAbs:
+    case GLSLstd450FSign:
+    case GLSLstd450Floor:
+    case GLSLstd450Ceil:
+    case GLSLstd450Fract:
+    case GLSLstd450Radians:
+    case GLSLstd450Degrees:
+    case GLSLstd450Sin:
+    case GLSLstd450Cos:
+    case GLSLstd450Tan:
+    case GLSLstd450Asin:
+    case GLSLstd450Acos:
+    case GLSLstd450Atan:
+    case GLSLstd450Sinh:
+    case GLSLstd450Cosh:
+    case GLSLstd450Tanh:
+    case GLSLstd450Asinh:
+    case GLSLstd450Acosh:
+    case GLSLstd450Atanh:
+    case GLSLstd450Exp:
+    case GLSLstd450Log:
+    case GLSLstd450Exp2:
+    case GLSLstd450Log2:
+    case GLSLstd450Sqrt:
+    case GLSLstd450InverseSqrt:
+      for(uint32_t c = 0; c < N; c++)
+      {
+        double v = GetF(x, c), r = 0.0;
+        switch(op)
+        {
+          case GLSLstd450Round: r = v < 0.0 ? ceil(v - 0.5) : floor(v + 0.5); break;
+          case GLSLstd450RoundEven:
+          {
+            r = floor(v);
+            double diff = v - r;
+            if(diff > 0.5 || (diff == 0.5 && fmod(r, 2.0) != 0.0))
+              r += 1.0;
+            break;
+          }
+          case GLSLstd450Trunc: r = v < 0.0 ? ceil(v) : floor(v); break;
+          case GLSLstd450FAbs: r = fabs(v); break;
+          case GLSLstd450FSign: r = v > 0.0 ? 1.0 : v < 0.0 ? -1.0 : 0.0; break;
+          case GLSLstd450Floor: r = floor(v); break;
+          case GLSLstd450Ceil: r = ceil(v); break;
+          case GLSLstd450Fract: r = v - floor(v); break;
+          case GLSLstd450Radians: r = v * (3.14159265358979323846 / 180.0); break;
+          case GLSLstd450Degrees: r = v * (180.0 / 3.14159265358979323846); break;
+          case GLSLstd450Sin: r = sin(v); break;
+          case GLSLstd450Cos: r = cos(v); break;
+          case GLSLstd450Tan: r = tan(v); break;
+          case GLSLstd450Asin: r = asin(v); break;
+          case GLSLstd450Acos: r = acos(v); break;
+          case GLSLstd450Atan: r = atan(v); break;
+          case GLSLstd450Sinh: r = sinh(v); break;
+          case GLSLstd450Cosh: r = cosh(v); break;
+          case GLSLstd450Tanh: r = tanh(v); break;
+          case GLSLstd450Asinh: r = asinh(v); break;
+          case GLSLstd450Acosh: r = acosh(v); break;
+          case GLSLstd450Atanh: r = atanh(v); break;
+          case GLSLstd450Exp: r = exp(v); break;
+          case GLSLstd450Log: r = log(v); break;
+          case GLSLstd450Exp2: r = exp2(v); break;
+          case GLSLstd450Log2: r = log2(v); break;
+          case GLSLstd450Sqrt: r = sqrt(v); break;
+          default: r = 1.0 / sqrt(v); break;
+        }
+        SetF(result, c, r);
+      }
+      return true;
+    case GLSLstd450SAbs:
+      for(uint32_t c = 0; c < N; c++)
+        result.value.iv[c] = x.value.iv[c] < 0 ? (int32_t)(0U - x.value.uv[c]) : x.value.iv[c];
+      return true;
+    case GLSLstd450SSign:
+      for(uint32_t c = 0; c < N; c++)
+        result.value.iv[c] = x.value.iv[c] > 0 ? 1 : x.value.iv[c] < 0 ? -1 : 0;
+      return true;
+    case GLSLstd450Atan2:
+    case GLSLstd450Pow:
+    case GLSLstd450FMin:
+    case GLSLstd450FMax:
+    case GLSLstd450NMin:
+    case GLSLstd450NMax:
+    case GLSLstd450Step:
+      if(numOps < 2)
+        return false;
+      for(uint32_t c = 0; c < N; c++)
+      {
+        double v = GetFC(x, c), w = GetFC(ARG(1), c), r = 0.0;
+        switch(op)
+        {
+          case GLSLstd450Atan2: r = atan2(v, w); break;
+          case GLSLstd450Pow: r = pow(v, w); break;
+          case GLSLstd450FMin:
+          case GLSLstd450NMin: r = fmin(v, w); break;
+          case GLSLstd450FMax:
+          case GLSLstd450NMax: r = fmax(v, w); break;
+          default: r = w < v ? 0.0 : 1.0; break;
+        }
+        SetF(result, c, r);
+      }
+      return true;
+    case GLSLstd450UMin:
+    case GLSLstd450UMax:
+    case GLSLstd450SMin:
+    case GLSLstd450SMax:
+      if(numOps < 2)
+        return false;
+      for(uint32_t c = 0; c < N; c++)
+      {
+        uint32_t ux = GetUC(x, c), uy = GetUC(ARG(1), c);
+        int32_t sx = (int32_t)ux, sy = (int32_t)uy;
+        switch(op)
+        {
+          case GLSLstd450UMin: result.value.uv[c] = std::min(ux, uy); break;
+          case GLSLstd450UMax: result.value.uv[c] = std::max(ux, uy); break;
+          case GLSLstd450SMin: result.value.iv[c] = std::min(sx, sy); break;
+          default: result.value.iv[c] = std::max(sx, sy); break;
+        }
+      }
+      return true;
+    case GLSLstd450FClamp:
+    case GLSLstd450NClamp:
+    case GLSLstd450FMix:
+    case GLSLstd450SmoothStep:
+    case GLSLstd450Fma:
+      if(numOps < 3)
+        return false;
+      for(uint32_t c = 0; c < N; c++)
+      {
+        double p = GetFC(x, c), q = GetFC(ARG(1), c), s = GetFC(ARG(2), c), r = 0.0;
+        switch(op)
+        {
+          case GLSLstd450FClamp:
+          case GLSLstd450NClamp: r = fmin(fmax(p, q), s); break;
+          case GLSLstd450FMix: r = p * (1.0 - s) + q * s; break;
+          case GLSLstd450SmoothStep:
+          {
+            double t = std::max(0.0, std::min(1.0, (s - p) / (q - p)));
+            r = t * t * (3.0 - 2.0 * t);
+            break;
+          }
+          default: r = p * q + s; break;
+        }
+        SetF(result, c, r);
+      }
+      return true;
+    case GLSLstd450UClamp:
+    case GLSLstd450SClamp:
+      if(numOps < 3)
+        return false;
+      for(uint32_t c = 0; c < N; c++)
+      {
+        if(op == GLSLstd450UClamp)
+          result.value.uv[c] =
+              std::min(std::max(GetUC(x, c), GetUC(ARG(1), c)), GetUC(ARG(2), c));
+        else
+          result.value.iv[c] = std::min(std::max((int32_t)GetUC(x, c), (int32_t)GetUC(ARG(1), c)),
+                                        (int32_t)GetUC(ARG(2), c));
+      }
+      return true;
+    case GLSLstd450Determinant:
+    {
+      double m[4][4] = {};
+      GetMatrix(x, m);
+      SetF(result, 0, Determinant(m, x.rows));
+      return true;
+    }
+    case GLSLstd450MatrixInverse:
+    {
+      // adjugate divided by the determinant
+      double m[4][4] = {};
+      GetMatrix(x, m);
+      uint32_t n = x.rows;
+      double det = Determinant(m, n);
+
+      for(uint32_t r = 0; r < n; r++)
+      {
+        for(uint32_t c = 0; c < n; c++)
+        {
+          double sub[4][4];
+          uint32_t sr = 0;
+          for(uint32_t i = 0; i < n; i++)
+          {
+            if(i == c)
+              continue;
+            uint32_t sc = 0;
+            for(uint32_t j = 0; j < n; j++)
+              if(j != r)
+                sub[sr][sc++] = m[i][j];
+            sr++;
+          }
+          double cofactor = (((r + c) & 1) ? -1.0 : 1.0) * Determinant(sub, n - 1);
+          SetF(result, r * n + c, cofactor / det);
+        }
+      }
+      return true;
+    }
+    case GLSLstd450Modf:
+    case GLSLstd450ModfStruct:
+    case GLSLstd450Frexp:
+    case GLSLstd450FrexpStruct:
+    {
+      bool modf = op == GLSLstd450Modf || op == GLSLstd450ModfStruct;
+      bool isStruct = op == GLSLstd450ModfStruct || op == GLSLstd450FrexpStruct;
+
+      if((isStruct && result.members.count != 2) || (!isStruct && numOps < 2))
+        return false;
+
+      ShaderVariable &first = isStruct ? result.members[0] : result;
+      ShaderVariable second = isStruct ? result.members[1] : Load(global, pointers[a[1]]);
+
+      for(uint32_t c = 0; c < NumComps(first); c++)
+      {
+        double v = GetF(x, c);
+        if(modf)
+        {
+          double whole = 0.0;
+          SetF(first, c, ::modf(v, &whole));
+          SetF(second, c, whole);
+        }
+        else
+        {
+          int e = 0;
+          SetF(first, c, ::frexp(v, &e));
+          second.value.iv[c] = e;
+        }
+      }
+
+      if(isStruct)
+        result.members[1].value = second.value;
+      else
+        Store(global, pointers[a[1]], second);
+      return true;
+    }
+    case GLSLstd450Ldexp:
+      if(numOps < 2)
+        return false;
+      for(uint32_t c = 0; c < N; c++)
+        SetF(result, c, ldexp(GetF(x, c), (int)GetUC(ARG(1), c)));
+      return true;
+    case GLSLstd450PackSnorm4x8:
+    case GLSLstd450PackUnorm4x8:
+      result.value.uv[0] = 0;
+      for(uint32_t c = 0; c < 4; c++)
+        result.value.uv[0] |= PackNorm(GetF(x, c), op == GLSLstd450PackSnorm4x8, 8) << (c * 8);
+      return true;
+    case GLSLstd450PackSnorm2x16:
+    case GLSLstd450PackUnorm2x16:
+      result.value.uv[0] = 0;
+      for(uint32_t c = 0; c < 2; c++)
+        result.value.uv[0] |= PackNorm(GetF(x, c), op == GLSLstd450PackSnorm2x16, 16) << (c * 16);
+      return true;
+    case GLSLstd450PackHalf2x16:
+      result.value.uv[0] =
+          uint32_t(ConvertToHalf(x.value.fv[0])) | (uint32_t(ConvertToHalf(x.value.fv[1])) << 16);
+      return true;
+    case GLSLstd450PackDouble2x32:
+    case GLSLstd450UnpackDouble2x32: result.value = x.value; return true;
+    case GLSLstd450UnpackSnorm4x8:
+    case GLSLstd450UnpackUnorm4x8:
+      for(uint32_t c = 0; c < 4; c++)
+        result.value.fv[c] =
+            UnpackNorm(x.value.uv[0] >> (c * 8), op == GLSLstd450UnpackSnorm4x8, 8);
+      return true;
+    case GLSLstd450UnpackSnorm2x16:
+    case GLSLstd450UnpackUnorm2x16:
+      for(uint32_t c = 0; c < 2; c++)
+        result.value.fv[c] =
+            UnpackNorm(x.value.uv[0] >> (c * 16), op == GLSLstd450UnpackSnorm2x16, 16);
+      return true;
+    case GLSLstd450UnpackHalf2x16:
+      result.value.fv[0] = ConvertFromHalf(uint16_t(x.value.uv[0] & 0xffff));
+      result.value.fv[1] = ConvertFromHalf(uint16_t(x.value.uv[0] >> 16));
+      return true;
+    case GLSLstd450Length:
+    case GLSLstd450Distance:
+    {
+      double sum = 0.0;
+      for(uint32_t c = 0; c < NumComps(x); c++)
+      {
+        double d = GetF(x, c) - (op == GLSLstd450Distance ? GetF(ARG(1), c) : 0.0);
+        sum += d * d;
+      }
+      SetF(result, 0, sqrt(sum));
+      return true;
+    }
+    case GLSLstd450Cross:
+    {
+      const ShaderVariable &y = ARG(1);
+      SetF(result, 0, GetF(x, 1) * GetF(y, 2) - GetF(x, 2) * GetF(y, 1));
+      SetF(result, 1, GetF(x, 2) * GetF(y, 0) - GetF(x, 0) * GetF(y, 2));
+      SetF(result, 2, GetF(x, 0) * GetF(y, 1) - GetF(x, 1) * GetF(y, 0));
+      return true;
+    }
+    case GLSLstd450Normalize:
+    {
+      double sum = 0.0;
+      for(uint32_t c = 0; c < N; c++)
+        sum += GetF(x, c) * GetF(x, c);
+      double len = sqrt(sum);
+      for(uint32_t c = 0; c < N; c++)
+        SetF(result, c, GetF(x, c) / len);
+      return true;
+    }
+    case GLSLstd450FaceForward:
+    case GLSLstd450Reflect:
+    case GLSLstd450Refract:
+    {
+      const ShaderVariable &y = ARG(1);
+
+      double dot = 0.0;
+      if(op == GLSLstd450FaceForward)
+      {
+        for(uint32_t c = 0; c < N; c++)
+          dot += GetF(ARG(2), c) * GetF(y, c);
+      }
+      else
+      {
+        for(uint32_t c = 0; c < N; c++)
+          dot += GetF(y, c) * GetF(x, c);
+      }
+
+      if(op == GLSLstd450FaceForward)
+      {
+        for(uint32_t c = 0; c < N; c++)
+          SetF(result, c, dot < 0.0 ? GetF(x, c) : -GetF(x, c));
+      }
+      else if(op == GLSLstd450Reflect)
+      {
+        for(uint32_t c = 0; c < N; c++)
+          SetF(result, c, GetF(x, c) - 2.0 * dot * GetF(y, c));
+      }
+      else
+      {
+        double eta = GetF(ARG(2), 0);
+        double k = 1.0 - eta * eta * (1.0 - dot * dot);
+        for(uint32_t c = 0; c < N; c++)
+          SetF(result, c, k < 0.0 ? 0.0 : eta * GetF(x, c) - (eta * dot + sqrt(k)) * GetF(y, c));
+      }
+      return true;
+    }
+    case GLSLstd450FindILsb:
+    case GLSLstd450FindSMsb:
+    case GLSLstd450FindUMsb:
+      for(uint32_t c = 0; c < N; c++)
+      {
+        uint32_t v = x.value.uv[c];
+        int32_t r = -1;
+        if(op == GLSLstd450FindILsb)
+        {
+          for(int32_t i = 0; i < 32 && r < 0; i++)
+            if(v & (1U << i))
+              r = i;
+        }
+        else
+        {
+          // for negative numbers the most significant 0 bit is found
+          if(op == GLSLstd450FindSMsb && (v & 0x80000000U))
+            v = ~v;
+          for(int32_t i = 31; i >= 0 && r < 0; i--)
+            if(v & (1U << i))
+              r = i;
+        }
+        result.value.iv[c] = r;
+      }
+      return true;
+    case GLSLstd450InterpolateAtCentroid:
+    case GLSLstd450InterpolateAtSample:
+    case GLSLstd450InterpolateAtOffset:
+      // inputs are only known at the pixel, so these all give the value there
+      AssignValue(result, Load(global, pointers[a[0]]));
+      return true;
+    default: break;
+  }
+
+#undef ARG
+
+  return false;
+}
+
+bool State::Atomic(GlobalState &global, const DecodedProgram::Instruction &inst,
+                   ShaderVariable &result)
+{
+  const uint32_t *a = program->Args(inst);
+  const Pointer &ptr = pointers[a[0]];
+
+  if(ptr.base == 0)
+    return false;
+
+  ShaderVariable val = Load(global, ptr);
+
+  if(inst.op == spv::OpAtomicStore)
+  {
+    val.value.uv[0] = ids[a[3]].value.uv[0];
+    Store(global, ptr, val);
+    return true;
+  }
+
+  uint32_t old = val.value.uv[0];
+  uint32_t arg = inst.numArgs > 3 ? ids[a[3]].value.uv[0] : 0;
+  uint32_t res = old;
+
+  switch(inst.op)
+  {
+    case spv::OpAtomicLoad: break;
+    case spv::OpAtomicExchange: res = arg; break;
+    case spv::OpAtomicCompareExchange:
+      // operands are pointer, scope, equal semantics, unequal semantics, value, comparator
+      if(old == ids[a[5]].value.uv[0])
+        res = ids[a[4]].value.uv[0];
+      break;
+    case spv::OpAtomicIIncrement: res = old + 1; break;
+    case spv::OpAtomicIDecrement: res = old - 1; break;
+    case spv::OpAtomicIAdd: res = old + arg; break;
+    case spv::OpAtomicISub: res = old - arg; break;
+    case spv::OpAtomicSMin: res = (uint32_t)std::min((int32_t)old, (int32_t)arg); break;
+    case spv::OpAtomicUMin: res = std::min(old, arg); break;
+    case spv::OpAtomicSMax: res = (uint32_t)std::max((int32_t)old, (int32_t)arg); break;
+    case spv::OpAtomicUMax: res = std::max(old, arg); break;
+    case spv::OpAtomicAnd: res = old & arg; break;
+    case spv::OpAtomicOr: res = old | arg; break;
+    case spv::OpAtomicXor: res = old ^ arg; break;
+    default: return false;
+  }
+
+  if(res != old)
+  {
+    val.value.uv[0] = res;
+    Store(global, ptr, val);
+  }
+
+  result.value.uv[0] = old;
+  return true;
+}
+
+// applies an addressing mode to a texel coordinate. Returns false if the border colour is used
+static bool AddressTexel(int32_t &t, int32_t size, AddressMode mode)
+{
+  switch(mode)
+  {
+    case AddressMode::Wrap: t = ((t % size) + size) % size; return true;
+    case AddressMode::Mirror:
+    {
+      int32_t period = size * 2;
+      int32_t m = ((t % period) + period) % period;
+      t = m < size ? m : period - 1 - m;
+      return true;
+    }
+    case AddressMode::MirrorOnce:
+      if(t < 0)
+        t = -t - 1;
+      t = std::min(t, size - 1);
+      return true;
+    case AddressMode::ClampBorder: return t >= 0 && t < size;
+    default: t = std::max(0, std::min(t, size - 1)); return true;
+  }
+}
+
+static bool Compare(CompareFunc func, double ref, double val)
+{
+  switch(func)
+  {
+    case CompareFunc::Never: return false;
+    case CompareFunc::Less: return ref < val;
+    case CompareFunc::LessEqual: return ref <= val;
+    case CompareFunc::Greater: return ref > val;
+    case CompareFunc::GreaterEqual: return ref >= val;
+    case CompareFunc::Equal: return ref == val;
+    case CompareFunc::NotEqual: return ref != val;
+    default: return true;
+  }
+}
+
+// reads one texel, seeing any writes made during the simulation
+static bool ReadTexel(GlobalState &global, const BindingSlot &slot, uint32_t x, uint32_t y,
+                      uint32_t z, uint32_t mip, uint32_t sample, ShaderValue &texel)
+{
+  memset(&texel, 0, sizeof(texel));
+
+  if(mip == 0)
+  {
+    GlobalState::TexelKey key;
+    key.slot = slot;
+    key.coord[0] = x;
+    key.coord[1] = y;
+    key.coord[2] = z;
+    key.coord[3] = sample;
+
+    std::map<GlobalState::TexelKey, ShaderValue>::iterator it = global.writtenTexels.find(key);
+    if(it != global.writtenTexels.end())
+    {
+      texel = it->second;
+      return true;
+    }
+  }
+
+  return global.api && global.api->ReadTexel(slot, x, y, z, mip, sample, texel);
+}
+
+bool State::ImageOp(GlobalState &global, const DecodedProgram::Instruction &inst, State *quad,
+                    ShaderVariable &result)
+{
+  typedef DecodedProgram::Type Type;
+
+  const uint32_t *a = program->Args(inst);
+  spv::Op op = inst.op;
+
+  if(op == spv::OpSampledImage)
+  {
+    result.value.uv[0] = ids[a[0]].value.uv[0];
+    result.value.uv[1] = ids[a[0]].value.uv[1];
+    result.value.uv[2] = ids[a[1]].value.uv[2];
+    result.value.uv[3] = ids[a[1]].value.uv[3];
+    return true;
+  }
+  else if(op == spv::OpImage)
+  {
+    result.value.uv[0] = ids[a[0]].value.uv[0];
+    result.value.uv[1] = ids[a[0]].value.uv[1];
+    return true;
+  }
+
+  if(!global.api)
+    return false;
+
+  const ShaderVariable &handle = ids[a[0]];
+  const Type &imgType = program->types[program->idType[a[0]]];
+
+  BindingSlot imgSlot = HandleSlot(program, handle.value.uv[0], handle.value.uv[1]);
+
+  ImageInfo info;
+  if(!global.api->GetImageInfo(imgSlot, info))
+  {
+    RDCWARN("Couldn't get image at set %u binding %u[%u]", imgSlot.set, imgSlot.bind,
+            imgSlot.arrayIdx);
+    return false;
+  }
+
+  uint32_t dims = 2;
+  switch(imgType.dim)
+  {
+    case spv::Dim1D:
+    case spv::DimBuffer: dims = 1; break;
+    case spv::Dim3D:
+    case spv::DimCube: dims = 3; break;
+    default: dims = 2; break;
+  }
+
+  bool cube = imgType.dim == spv::DimCube;
+
+  // the size of the given mip, with layers for arrays
+  uint32_t size[3] = {info.width, info.height, info.depth};
+  uint32_t layers = cube ? std::max(1U, info.layers / 6) : info.layers;
+
+  if(op == spv::OpImageQuerySizeLod || op == spv::OpImageQuerySize)
+  {
+    uint32_t mip = op == spv::OpImageQuerySizeLod ? ids[a[1]].value.uv[0] : 0;
+    uint32_t sizeComps = cube ? 2 : dims;
+    for(uint32_t c = 0; c < sizeComps; c++)
+      result.value.uv[c] = std::max(1U, size[c] >> mip);
+    if(imgType.arrayed)
+      result.value.uv[sizeComps] = layers;
+    return true;
+  }
+  else if(op == spv::OpImageQueryLevels)
+  {
+    result.value.uv[0] = info.mips;
+    return true;
+  }
+  else if(op == spv::OpImageQuerySamples)
+  {
+    result.value.uv[0] = info.samples;
+    return true;
+  }
+
+  flags |= ShaderEvents::SampleLoadGather;
+
+  const ShaderVariable &coord = ids[a[1]];
+
+  // fixed operands, then the image operands mask and the operands it enables
+  uint32_t operandIdx = 2;
+  bool dref = op == spv::OpImageSampleDrefImplicitLod || op == spv::OpImageSampleDrefExplicitLod ||
+              op == spv::OpImageSampleProjDrefImplicitLod ||
+              op == spv::OpImageSampleProjDrefExplicitLod || op == spv::OpImageDrefGather;
+  bool gather = op == spv::OpImageGather || op == spv::OpImageDrefGather;
+  bool proj = op == spv::OpImageSampleProjImplicitLod || op == spv::OpImageSampleProjExplicitLod ||
+              op == spv::OpImageSampleProjDrefImplicitLod ||
+              op == spv::OpImageSampleProjDrefExplicitLod;
+
+  double drefValue = 0.0;
+  uint32_t gatherComp = 0;
+  ShaderValue writeValue = {};
+
+  if(dref)
+    drefValue = GetF(ids[a[operandIdx++]], 0);
+  else if(op == spv::OpImageGather)
+    gatherComp = ids[a[operandIdx++]].value.uv[0];
+  else if(op == spv::OpImageWrite)
+    writeValue = ids[a[operandIdx++]].value;
+
+  uint32_t mask = operandIdx < inst.numArgs ? a[operandIdx++] : 0;
+  uint32_t bias = 0, lod = 0, gradX = 0, gradY = 0, offset = 0, offsets = 0, sample = 0,
+           minLod = 0;
+
+  if(mask & spv::ImageOperandsBiasMask)
+    bias = a[operandIdx++];
+  if(mask & spv::ImageOperandsLodMask)
+    lod = a[operandIdx++];
+  if(mask & spv::ImageOperandsGradMask)
+  {
+    gradX = a[operandIdx++];
+    gradY = a[operandIdx++];
+  }
+  if(mask & spv::ImageOperandsConstOffsetMask)
+    offset = a[operandIdx++];
+  if(mask & spv::ImageOperandsOffsetMask)
+    offset = a[operandIdx++];
+  if(mask & spv::ImageOperandsConstOffsetsMask)
+    offsets = a[operandIdx++];
+  if(mask & spv::ImageOperandsSampleMask)
+    sample = a[operandIdx++];
+  if(mask & spv::ImageOperandsMinLodMask)
+    minLod = a[operandIdx++];
+
+  // integer-addressed accesses, without a sampler
+  if(op == spv::OpImageFetch || op == spv::OpImageRead || op == spv::OpImageWrite)
+  {
+    uint32_t mip = lod ? ids[lod].value.uv[0] : 0;
+    uint32_t samp = sample ? ids[sample].value.uv[0] : 0;
+
+    int32_t c[3] = {0, 0, 0};
+    for(uint32_t i = 0; i < dims + (imgType.arrayed ? 1 : 0) && i < 3; i++)
+      c[i] = coord.value.iv[i];
+    if(offset)
+      for(uint32_t i = 0; i < dims; i++)
+        c[i] += ids[offset].value.iv[i];
+
+    bool inBounds = mip < info.mips;
+    for(uint32_t i = 0; i < dims; i++)
+      inBounds &= c[i] >= 0 && (uint32_t)c[i] < std::max(1U, size[i] >> mip);
+    if(imgType.arrayed)
+      inBounds &= c[dims] >= 0 && (uint32_t)c[dims] < layers;
+
+    if(op == spv::OpImageWrite)
+    {
+      if(inBounds && !helper)
+      {
+        GlobalState::TexelKey key;
+        key.slot = imgSlot;
+        key.coord[0] = c[0];
+        key.coord[1] = c[1];
+        key.coord[2] = c[2];
+        key.coord[3] = samp;
+        global.writtenTexels[key] = writeValue;
+      }
+      return true;
+    }
+
+    ShaderValue texel = {};
+    if(inBounds)
+      ReadTexel(global, imgSlot, c[0], c[1], c[2], mip, samp, texel);
+
+    for(uint32_t i = 0; i < NumComps(result) && i < 4; i++)
+      result.value.uv[i] = texel.uv[i];
+    return true;
+  }
+
+  SamplerInfo sampler;
+  BindingSlot sampSlot = HandleSlot(program, handle.value.uv[2], handle.value.uv[3]);
+  global.api->GetSamplerInfo(sampSlot, sampler);
+
+  double uv[4] = {0.0, 0.0, 0.0, 0.0};
+  for(uint32_t i = 0; i < dims + (imgType.arrayed ? 1 : 0) && i < 4; i++)
+    uv[i] = GetF(coord, i);
+
+  if(proj)
+  {
+    double q = GetF(coord, dims);
+    for(uint32_t i = 0; i < dims; i++)
+      uv[i] /= q;
+    if(dref)
+      drefValue /= q;
+  }
+
+  uint32_t layer = 0;
+
+  if(cube)
+  {
+    // select the face by the major axis, and project onto it
+    double x = uv[0], y = uv[1], z = uv[2];
+    double ax = fabs(x), ay = fabs(y), az = fabs(z);
+    double sc = 0.0, tc = 0.0, ma = 1.0;
+
+    if(ax >= ay && ax >= az)
+    {
+      layer = x >= 0.0 ? 0 : 1;
+      sc = x >= 0.0 ? -z : z;
+      tc = -y;
+      ma = ax;
+    }
+    else if(ay >= az)
+    {
+      layer = y >= 0.0 ? 2 : 3;
+      sc = x;
+      tc = y >= 0.0 ? z : -z;
+      ma = ay;
+    }
+    else
+    {
+      layer = z >= 0.0 ? 4 : 5;
+      sc = z >= 0.0 ? x : -x;
+      tc = -y;
+      ma = az;
+    }
+
+    if(ma > 0.0)
+    {
+      uv[0] = (sc / ma + 1.0) * 0.5;
+      uv[1] = (tc / ma + 1.0) * 0.5;
+    }
+
+    if(imgType.arrayed)
+      layer += 6 * (uint32_t)std::max(0.0, std::min(double(layers - 1), floor(uv[3] + 0.5)));
+
+    dims = 2;
+  }
+  else if(imgType.arrayed)
+  {
+    layer = (uint32_t)std::max(0.0, std::min(double(layers - 1), floor(uv[dims] + 0.5)));
+  }
+
+  // pick the level of detail, from the explicit lod or the coordinate gradients
+  double lodValue = 0.0;
+
+  if(lod)
+  {
+    lodValue = GetF(ids[lod], 0);
+  }
+  else if(!gather)
+  {
+    ShaderVariable dx, dy;
+    bool haveGrad = true;
+
+    if(gradX)
+    {
+      dx = ids[gradX];
+      dy = ids[gradY];
+    }
+    else if(quad)
+    {
+      dx = Derivative(true, false, quad, a[1]);
+      dy = Derivative(false, false, quad, a[1]);
+    }
+    else
+    {
+      haveGrad = false;
+    }
+
+    if(haveGrad)
+    {
+      double lenX = 0.0, lenY = 0.0;
+      for(uint32_t i = 0; i < dims; i++)
+      {
+        double scale = sampler.unnormalized ? 1.0 : double(size[cube ? 0 : i]);
+        lenX += GetF(dx, i) * GetF(dx, i) * scale * scale;
+        lenY += GetF(dy, i) * GetF(dy, i) * scale * scale;
+      }
+
+      double rho = sqrt(std::max(lenX, lenY));
+      lodValue = rho > 0.0 ? log2(rho) : -1000.0;
+    }
+
+    if(bias)
+      lodValue += GetF(ids[bias], 0);
+    lodValue += sampler.mipBias;
+  }
+
+  double lodMin = sampler.minLod;
+  if(minLod)
+    lodMin = std::max(lodMin, GetF(ids[minLod], 0));
+  double clampedLod = std::max(lodMin, std::min(double(sampler.maxLod), lodValue));
+
+  if(op == spv::OpImageQueryLod)
+  {
+    SetF(result, 0, clampedLod);
+    SetF(result, 1, lodValue);
+    flags &= ~ShaderEvents::SampleLoadGather;
+    return true;
+  }
+
+  // nearest mip selection
+  uint32_t mip = clampedLod <= 0.0 ? 0 : (uint32_t)floor(clampedLod + 0.5);
+  mip = std::min(mip, info.mips - 1);
+
+  int32_t mipSize[3];
+  for(uint32_t i = 0; i < 3; i++)
+    mipSize[i] = (int32_t)std::max(1U, size[i] >> mip);
+
+  int32_t offs[3] = {0, 0, 0};
+  if(offset)
+    for(uint32_t i = 0; i < dims; i++)
+      offs[i] = ids[offset].value.iv[i];
+
+  ShaderValue texels[4] = {};
+  uint32_t numTexels = gather ? 4 : 1;
+
+  int32_t base[3] = {0, 0, 0};
+  for(uint32_t i = 0; i < dims; i++)
+  {
+    double scaled = sampler.unnormalized ? uv[i] : uv[i] * mipSize[i];
+    // gathers start from the top-left of the 2x2 footprint around the coordinate
+    base[i] = (int32_t)floor(gather ? scaled - 0.5 : scaled) + offs[i];
+  }
+
+  // gather returns (i0,j1), (i1,j1), (i1,j0), (i0,j0)
+  const int32_t gatherOffs[4][2] = {{0, 1}, {1, 1}, {1, 0}, {0, 0}};
+
+  for(uint32_t t = 0; t < numTexels; t++)
+  {
+    int32_t c[3] = {base[0], base[1], base[2]};
+
+    if(gather)
+    {
+      if(offsets)
+      {
+        // each texel has its own offset from the unoffset top-left
+        const ShaderVariable &arr = ids[offsets];
+        if((int32_t)t < arr.members.count)
+        {
+          c[0] = base[0] - offs[0] + arr.members[t].value.iv[0];
+          c[1] = base[1] - offs[1] + arr.members[t].value.iv[1];
+        }
+      }
+      else
+      {
+        c[0] += gatherOffs[t][0];
+        c[1] += gatherOffs[t][1];
+      }
+    }
+
+    bool border = false;
+    for(uint32_t i = 0; i < dims; i++)
+    {
+      AddressMode mode = cube ? AddressMode::ClampEdge : sampler.address[i];
+      if(!AddressTexel(c[i], mipSize[i], mode))
+        border = true;
+    }
+
+    uint32_t z = imgType.dim == spv::Dim3D ? (uint32_t)c[2] : layer;
+
+    if(border)
+      memcpy(texels[t].fv, sampler.border, sizeof(sampler.border));
+    else
+      ReadTexel(global, imgSlot, (uint32_t)c[0], dims > 1 ? (uint32_t)c[1] : 0, z, mip, 0,
+                texels[t]);
+  }
+
+  if(gather)
+  {
+    for(uint32_t t = 0; t < 4; t++)
+    {
+      if(dref)
+        result.value.fv[t] =
+            Compare(sampler.compare, drefValue, texels[t].fv[0]) ? 1.0f : 0.0f;
+      else
+        result.value.uv[t] = texels[t].uv[std::min(gatherComp, 3U)];
+    }
+  }
+  else if(dref)
+  {
+    // without a comparison sampler the comparison always passes
+    SetF(result, 0, Compare(sampler.compare, drefValue, texels[0].fv[0]) ? 1.0 : 0.0);
+  }
+  else
+  {
+    for(uint32_t i = 0; i < NumComps(result) && i < 4; i++)
+      result.value.uv[i] = texels[0].uv[i];
+  }
+
+  return true;
+}
+
+};    // namespace SPVDebug
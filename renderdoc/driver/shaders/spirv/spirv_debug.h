@@ -0,0 +1,386 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2017 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include <map>
+#include "api/replay/renderdoc_replay.h"
+#include "common/common.h"
+#include "spirv_common.h"
+
+namespace SPVDebug
+{
+// identifies one descriptor the shader reads from. set is ~0U for push constants
+struct BindingSlot
+{
+  BindingSlot() : set(0), bind(0), arrayIdx(0) {}
+  BindingSlot(uint32_t s, uint32_t b, uint32_t a) : set(s), bind(b), arrayIdx(a) {}
+  uint32_t set, bind, arrayIdx;
+
+  bool operator<(const BindingSlot &o) const
+  {
+    if(set != o.set)
+      return set < o.set;
+    if(bind != o.bind)
+      return bind < o.bind;
+    return arrayIdx < o.arrayIdx;
+  }
+};
+
+struct ImageInfo
+{
+  ImageInfo() : width(1), height(1), depth(1), layers(1), mips(1), samples(1) {}
+  // dimensions of the view's first mip. For texel buffers width is the number of elements
+  uint32_t width, height, depth;
+  uint32_t layers, mips, samples;
+};
+
+struct SamplerInfo
+{
+  SamplerInfo() : unnormalized(false), mipBias(0.0f), minLod(0.0f), maxLod(1000.0f)
+  {
+    address[0] = address[1] = address[2] = AddressMode::Wrap;
+    compare = CompareFunc::AlwaysTrue;
+    border[0] = border[1] = border[2] = border[3] = 0.0f;
+  }
+  AddressMode address[3];
+  bool unnormalized;
+  float mipBias, minLod, maxLod;
+  // AlwaysTrue if this isn't a comparison sampler
+  CompareFunc compare;
+  float border[4];
+};
+
+// the API-specific side of the debugger, which fetches the contents of whatever is bound for the
+// shader to read. Sampling is done by the simulation with nearest filtering on top of ReadTexel.
+class DebugAPIWrapper
+{
+public:
+  virtual ~DebugAPIWrapper() {}
+  // the bound range of a uniform or storage buffer, or the push constants
+  virtual bool FetchBuffer(const BindingSlot &slot, vector<byte> &data) = 0;
+  virtual bool GetImageInfo(const BindingSlot &slot, ImageInfo &info) = 0;
+  virtual bool GetSamplerInfo(const BindingSlot &slot, SamplerInfo &info) = 0;
+  // reads one texel of an image or texel buffer view. Float formats are returned as floats, integer
+  // formats as their integer bits. mip and layer are relative to the view.
+  virtual bool ReadTexel(const BindingSlot &slot, uint32_t x, uint32_t y, uint32_t z,
+                         uint32_t mip, uint32_t sample, ShaderValue &texel) = 0;
+};
+
+// the program decoded once up front into a flat instruction list with operands resolved, so
+// stepping doesn't need to go back to the SPIR-V words or the disassembler's tree. Values are kept
+// per result ID, which is SSA so every ID is effectively its own register.
+struct DecodedProgram
+{
+  DecodedProgram();
+
+  // decodes the given entry point. specConstants maps specialization IDs to their raw values.
+  // Returns false if the shader uses something that can't be simulated.
+  bool Decode(const SPVModule &module, const string &entryPoint, ShaderStage stage,
+              const std::map<uint32_t, uint64_t> &specConstants);
+
+  struct Type
+  {
+    enum Kind
+    {
+      Void,
+      Bool,
+      Scalar,
+      Vector,
+      Matrix,
+      Array,
+      Struct,
+      Pointer,
+      Image,
+      Sampler,
+      SampledImage,
+      Function,
+      Unsupported,
+    };
+
+    Type()
+        : kind(Void),
+          scalar(VarType::Float),
+          width(32),
+          vecSize(1),
+          columns(1),
+          elem(0),
+          length(1),
+          arrayStride(0),
+          storage(spv::StorageClassFunction),
+          dim(spv::Dim2D),
+          arrayed(false),
+          multisampled(false),
+          depth(false),
+          bufferBlock(false)
+    {
+    }
+
+    Kind kind;
+    // the component type of scalars, vectors and matrices. Bools are stored as UInt
+    VarType scalar;
+    uint32_t width;
+    // components, or rows for a matrix
+    uint32_t vecSize;
+    uint32_t columns;
+    // the element type of an array, matrix column, pointer, image or sampled image
+    uint32_t elem;
+    // ~0U for runtime arrays
+    uint32_t length;
+    uint32_t arrayStride;
+    spv::StorageClass storage;
+
+    struct Member
+    {
+      Member() : type(0), offset(0), matrixStride(16), rowMajor(false), builtin(-1) {}
+      uint32_t type;
+      uint32_t offset;
+      uint32_t matrixStride;
+      bool rowMajor;
+      int32_t builtin;
+      string name;
+    };
+    vector<Member> members;
+
+    spv::Dim dim;
+    bool arrayed, multisampled, depth;
+    bool bufferBlock;
+  };
+
+  struct Instruction
+  {
+    spv::Op op;
+    // 0 if the instruction doesn't have one
+    uint32_t result;
+    uint32_t type;
+    uint32_t firstArg, numArgs;
+    // false for instructions that don't do anything when stepped, like labels and merges
+    bool step;
+  };
+
+  struct Variable
+  {
+    Variable()
+        : id(0), type(0), init(0), storage(spv::StorageClassPrivate), builtin(-1), location(-1)
+    {
+      set = binding = 0;
+      flat = noperspective = false;
+    }
+    uint32_t id;
+    // the type pointed to
+    uint32_t type;
+    // the constant it's initialised to, or 0
+    uint32_t init;
+    spv::StorageClass storage;
+    string name;
+    int32_t builtin;
+    int32_t location;
+    uint32_t set, binding;
+    bool flat, noperspective;
+  };
+
+  // where an ID's value is shown in the debug state, if it is
+  struct Slot
+  {
+    enum Kind
+    {
+      None,
+      Register,
+      Indexable,
+      Output,
+    } kind;
+    uint32_t index;
+  };
+
+  ShaderStage stage;
+  uint32_t entryFunc;
+  uint32_t localSize[3];
+
+  vector<Type> types;
+  vector<Instruction> instructions;
+  vector<uint32_t> args;
+
+  // all indexed by ID
+  vector<uint32_t> idType;
+  vector<string> names;
+  vector<uint32_t> labels;       // instruction index of each OpLabel
+  vector<uint32_t> functions;    // instruction index of each OpFunction
+  vector<bool> mergeBlock;       // true for labels that are the merge block of a construct
+  vector<bool> isConstant;
+  vector<ShaderVariable> constants;
+  vector<Slot> slots;
+
+  // the variable for a global ID, or -1
+  vector<int32_t> globalIndex;
+  vector<Variable> globals;
+  uint32_t glslStd450;
+
+  // IDs of displayed registers and indexable temps, in order
+  vector<uint32_t> registerIDs;
+  vector<uint32_t> indexableIDs;
+  vector<uint32_t> outputIDs;
+
+  // the flat instruction listing that ShaderDebugState::nextInstruction indexes into, with each
+  // steppable instruction prefixed by its index.
+  string disassembly;
+
+  const uint32_t *Args(const Instruction &inst) const { return &args[inst.firstArg]; }
+  const string &Name(uint32_t id) const { return names[id]; }
+  // a zero-initialised value of the given type, named for display
+  ShaderVariable MakeValue(uint32_t typeId, const string &name) const;
+  // the value of the given type at offset in data, using std140/std430 decorations
+  ShaderVariable ReadMemory(const byte *data, size_t size, uint32_t typeId, uint32_t offset,
+                            uint32_t matrixStride, bool rowMajor, uint32_t vecStride,
+                            const string &name) const;
+  void WriteMemory(byte *data, size_t size, uint32_t typeId, uint32_t offset, uint32_t matrixStride,
+                   bool rowMajor, uint32_t vecStride, const ShaderVariable &val) const;
+
+private:
+  void MakeListing();
+  string OperandName(uint32_t id) const;
+};
+
+struct GlobalState
+{
+  GlobalState() : api(NULL) {}
+  DebugAPIWrapper *api;
+
+  // buffer contents are fetched on first use, and any writes the simulation makes stay here
+  struct Buffer
+  {
+    Buffer() : fetched(false) {}
+    bool fetched;
+    vector<byte> data;
+  };
+  std::map<BindingSlot, Buffer> buffers;
+
+  // texels written to storage images, read back before going to the API
+  struct TexelKey
+  {
+    BindingSlot slot;
+    uint32_t coord[4];
+    bool operator<(const TexelKey &o) const
+    {
+      if(slot < o.slot)
+        return true;
+      if(o.slot < slot)
+        return false;
+      return memcmp(coord, o.coord, sizeof(coord)) < 0;
+    }
+  };
+  std::map<TexelKey, ShaderValue> writtenTexels;
+
+  // workgroup variables, shared by every thread in the group
+  std::map<uint32_t, ShaderVariable> workgroup;
+
+  DecodedProgram program;
+
+  vector<byte> &GetBuffer(const BindingSlot &slot);
+};
+
+class State : public ShaderDebugState
+{
+public:
+  State();
+  State(int quadIdx, const DecodedProgram *p);
+
+  // helper lanes run for derivatives, but any writes they make outside of the thread are dropped
+  void SetHelper() { helper = true; }
+  void SetQuadIndex(int quadIdx) { quadIndex = quadIdx; }
+  // sets the value of an input variable, before Init
+  void SetInput(uint32_t varId, const ShaderVariable &val);
+  // the flattened input values, as shown in the trace
+  void GetInputs(vector<ShaderVariable> &inputs) const;
+  // sets up variables and enters the entry point
+  void Init(GlobalState &global);
+
+  bool Finished() const { return done; }
+  bool Killed() const { return killed; }
+  // true if the next instruction is a group barrier this thread must wait at
+  bool AtThreadBarrier() const;
+  // true if this thread has just entered the merge block of a selection or loop, where diverged
+  // threads in a quad converge again
+  bool AtConvergencePoint() const;
+
+  // executes one instruction in place. quad is the four lanes of a pixel quad, including this
+  // one, or NULL when there are no neighbours for derivatives. Since results are SSA the other
+  // lanes' operands are never overwritten by stepping them in turn.
+  void StepNext(GlobalState &global, State *quad);
+
+  // used to evaluate OpSpecConstantOp at decode time on the constants
+  bool EvaluateOp(GlobalState *global, const DecodedProgram::Instruction &inst, State *quad,
+                  ShaderVariable &result);
+
+  const ShaderVariable &GetValue(uint32_t id) const { return ids[id]; }
+private:
+  struct Pointer
+  {
+    Pointer() : base(0) {}
+    // the variable pointed into, 0 if this isn't a valid pointer
+    uint32_t base;
+    vector<uint32_t> chain;
+  };
+
+  struct Frame
+  {
+    uint32_t func;
+    uint32_t returnInst;
+    uint32_t result;
+    uint32_t curBlock, prevBlock;
+  };
+
+  // index in the pixel quad
+  int quadIndex;
+  bool done, killed, helper;
+
+  const DecodedProgram *program;
+
+  vector<ShaderVariable> ids;
+  vector<Pointer> pointers;
+  vector<Frame> callstack;
+  uint32_t curBlock, prevBlock;
+
+  void SetResult(uint32_t id, const ShaderVariable &val);
+  void UpdateSlot(uint32_t id);
+  void EnterFunction(uint32_t func, uint32_t returnInst, uint32_t result, const uint32_t *args,
+                     uint32_t numArgs);
+  void JumpToBlock(uint32_t label);
+  void SkipNonSteps();
+
+  ShaderVariable Load(GlobalState &global, const Pointer &ptr);
+  void Store(GlobalState &global, const Pointer &ptr, const ShaderVariable &val);
+  bool BufferPointer(GlobalState &global, const Pointer &ptr, vector<byte> *&data,
+                     uint32_t &type, uint32_t &offset, uint32_t &matrixStride, bool &rowMajor,
+                     uint32_t &vecStride);
+  BindingSlot DescriptorSlot(const Pointer &ptr, size_t &chainStart) const;
+
+  ShaderVariable Derivative(bool xdir, bool fine, State *quad, uint32_t id) const;
+  bool ImageOp(GlobalState &global, const DecodedProgram::Instruction &inst, State *quad,
+               ShaderVariable &result);
+  bool ExtInst(GlobalState &global, const DecodedProgram::Instruction &inst,
+               ShaderVariable &result);
+  bool Atomic(GlobalState &global, const DecodedProgram::Instruction &inst, ShaderVariable &result);
+};
+
+};    // namespace SPVDebug
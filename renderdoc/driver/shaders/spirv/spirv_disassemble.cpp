@@ -2102,6 +2102,7 @@ SPVModule::SPVModule()
   generator = 0;
   sourceVer = 0;
   sourceLang = spv::SourceLanguageUnknown;
+  parsed = true;
 }
 
 SPVModule::~SPVModule()
@@ -2111,6 +2112,21 @@ SPVModule::~SPVModule()
   operations.clear();
 }
 
+void SPVModule::EnsureParsed()
+{
+  if(parsed)
+    return;
+
+  parsed = true;
+
+  // ParseSPIRV copies the words back into the module
+  vector<uint32_t> words;
+  words.swap(spirv);
+
+  if(!words.empty())
+    ParseSPIRV(&words[0], words.size(), *this);
+}
+
 SPVInstruction *SPVModule::GetByID(uint32_t id)
 {
   if(ids[id])
@@ -2156,6 +2172,8 @@ void FindFirstInstructionUse(SPVInstruction *op, SPVInstruction *search, SPVInst
 
 string SPVModule::Disassemble(const string &entryPoint)
 {
+  EnsureParsed();
+
   string retDisasm = "";
 
   // TODO filter to only functions/resources used by entryPoint
@@ -3847,9 +3865,178 @@ void AddSignatureParameter(ShaderStage stage, uint32_t id, uint32_t childIdx, st
   }
 }
 
+static spv::StorageClass PointerStorage(SPVInstruction *ptr)
+{
+  // walk back through any access chains to the variable the pointer is into
+  while(ptr && ptr->op && !ptr->op->arguments.empty() &&
+        (ptr->opcode == spv::OpAccessChain || ptr->opcode == spv::OpInBoundsAccessChain ||
+         ptr->opcode == spv::OpPtrAccessChain || ptr->opcode == spv::OpInBoundsPtrAccessChain))
+    ptr = ptr->op->arguments[0];
+
+  if(ptr && ptr->var)
+    return ptr->var->storage;
+
+  return spv::StorageClassFunction;
+}
+
+static void AddFunctionCost(SPVModule &module, SPVInstruction *funcInst, uint32_t loopDepth,
+                            vector<uint32_t> &visited, ShaderCost &cost)
+{
+  if(funcInst == NULL || funcInst->func == NULL ||
+     std::find(visited.begin(), visited.end(), funcInst->id) != visited.end())
+    return;
+
+  visited.push_back(funcInst->id);
+
+  SPVFunction *func = funcInst->func;
+
+  cost.tempRegisters += (uint32_t)func->variables.size();
+
+  // blocks are in structured order, so a loop's body is between its header and merge block
+  vector<uint32_t> loopMerges;
+
+  for(size_t b = 0; b < func->blocks.size(); b++)
+  {
+    SPVInstruction *blockInst = func->blocks[b];
+    SPVBlock *block = blockInst->block;
+
+    while(!loopMerges.empty() && loopMerges.back() == blockInst->id)
+      loopMerges.pop_back();
+
+    if(block->mergeFlow && block->mergeFlow->opcode == spv::OpLoopMerge)
+    {
+      loopMerges.push_back(block->mergeFlow->flow->targets[0]);
+      cost.loops++;
+      cost.maxLoopDepth = RDCMAX(cost.maxLoopDepth, loopDepth + (uint32_t)loopMerges.size());
+    }
+
+    for(size_t i = 0; i < block->instructions.size(); i++)
+    {
+      SPVInstruction *inst = block->instructions[i];
+
+      switch(inst->opcode)
+      {
+        // pointer arithmetic, SSA plumbing and combining descriptors have no cost of their own
+        case spv::OpAccessChain:
+        case spv::OpInBoundsAccessChain:
+        case spv::OpPtrAccessChain:
+        case spv::OpInBoundsPtrAccessChain:
+        case spv::OpVariable:
+        case spv::OpUndef:
+        case spv::OpPhi:
+        case spv::OpCopyObject:
+        case spv::OpSampledImage:
+        case spv::OpImage: continue;
+
+        case spv::OpLoad:
+        case spv::OpStore:
+        case spv::OpCopyMemory:
+        {
+          spv::StorageClass storage = spv::StorageClassFunction;
+          if(inst->op && !inst->op->arguments.empty())
+            storage = PointerStorage(inst->op->arguments[0]);
+
+          // these are registers, or descriptors rather than the memory behind them
+          if(storage == spv::StorageClassFunction || storage == spv::StorageClassPrivate ||
+             storage == spv::StorageClassInput || storage == spv::StorageClassOutput ||
+             storage == spv::StorageClassUniformConstant ||
+             storage == spv::StorageClassPushConstant)
+            continue;
+
+          cost.memoryInstructions++;
+          break;
+        }
+
+        case spv::OpImageSampleImplicitLod:
+        case spv::OpImageSampleExplicitLod:
+        case spv::OpImageSampleDrefImplicitLod:
+        case spv::OpImageSampleDrefExplicitLod:
+        case spv::OpImageSampleProjImplicitLod:
+        case spv::OpImageSampleProjExplicitLod:
+        case spv::OpImageSampleProjDrefImplicitLod:
+        case spv::OpImageSampleProjDrefExplicitLod:
+        case spv::OpImageGather:
+        case spv::OpImageDrefGather:
+        case spv::OpImageQueryLod:
+        case spv::OpImageSparseSampleImplicitLod:
+        case spv::OpImageSparseSampleExplicitLod:
+        case spv::OpImageSparseSampleDrefImplicitLod:
+        case spv::OpImageSparseSampleDrefExplicitLod:
+        case spv::OpImageSparseSampleProjImplicitLod:
+        case spv::OpImageSparseSampleProjExplicitLod:
+        case spv::OpImageSparseSampleProjDrefImplicitLod:
+        case spv::OpImageSparseSampleProjDrefExplicitLod:
+        case spv::OpImageSparseGather:
+        case spv::OpImageSparseDrefGather: cost.sampleInstructions++; break;
+
+        case spv::OpImageFetch:
+        case spv::OpImageRead:
+        case spv::OpImageWrite:
+        case spv::OpImageSparseFetch:
+        case spv::OpImageSparseRead:
+        case spv::OpAtomicLoad:
+        case spv::OpAtomicStore:
+        case spv::OpAtomicExchange:
+        case spv::OpAtomicCompareExchange:
+        case spv::OpAtomicCompareExchangeWeak:
+        case spv::OpAtomicIIncrement:
+        case spv::OpAtomicIDecrement:
+        case spv::OpAtomicIAdd:
+        case spv::OpAtomicISub:
+        case spv::OpAtomicSMin:
+        case spv::OpAtomicUMin:
+        case spv::OpAtomicSMax:
+        case spv::OpAtomicUMax:
+        case spv::OpAtomicAnd:
+        case spv::OpAtomicOr:
+        case spv::OpAtomicXor: cost.memoryInstructions++; break;
+
+        case spv::OpFDiv:
+        case spv::OpUDiv:
+        case spv::OpSDiv: cost.transcendentalInstructions++; break;
+
+        case spv::OpExtInst:
+        {
+          SPVInstruction *set = inst->op->arguments[0];
+
+          uint32_t extOp = inst->op->literals[0];
+
+          // everything from Sin to InverseSqrt is trigonometric, exponential or a root
+          if(set->ext && set->ext->setname == "GLSL.std.450" && extOp >= GLSLstd450Sin &&
+             extOp <= GLSLstd450InverseSqrt)
+            cost.transcendentalInstructions++;
+          else
+            cost.aluInstructions++;
+          break;
+        }
+
+        case spv::OpFunctionCall:
+          cost.flowControlInstructions++;
+          AddFunctionCost(module, module.GetByID(inst->op->funcCall),
+                          loopDepth + (uint32_t)loopMerges.size(), visited, cost);
+          break;
+
+        default: cost.aluInstructions++; break;
+      }
+
+      cost.instructions++;
+    }
+
+    if(block->exitFlow && (block->exitFlow->opcode == spv::OpBranchConditional ||
+                           block->exitFlow->opcode == spv::OpSwitch ||
+                           block->exitFlow->opcode == spv::OpKill))
+    {
+      cost.flowControlInstructions++;
+      cost.instructions++;
+    }
+  }
+}
+
 void SPVModule::MakeReflection(ShaderStage stage, const string &entryPoint,
                                ShaderReflection *reflection, ShaderBindpointMapping *mapping)
 {
+  EnsureParsed();
+
   vector<SigParameter> inputs;
   vector<SigParameter> outputs;
   vector<cblockpair> cblocks;
@@ -4395,6 +4582,24 @@ void SPVModule::MakeReflection(ShaderStage stage, const string &entryPoint,
     reflection->ReadWriteResources[i] = rwresources[i].bindres;
     reflection->ReadWriteResources[i].bindPoint = (int32_t)i;
   }
+
+  reflection->Cost = ShaderCost();
+
+  for(size_t i = 0; i < entries.size(); i++)
+  {
+    if(entries[i]->entry->name == entryPoint)
+    {
+      vector<uint32_t> visited;
+      AddFunctionCost(*this, GetByID(entries[i]->entry->func), 0, visited, reflection->Cost);
+      break;
+    }
+  }
+}
+
+void DeferParseSPIRV(const uint32_t *spirv, size_t spirvLength, SPVModule &module)
+{
+  module.spirv.assign(spirv, spirv + spirvLength);
+  module.parsed = false;
 }
 
 void ParseSPIRV(uint32_t *spirv, size_t spirvLength, SPVModule &module)
@@ -1424,6 +1424,7 @@ string ToStrHelper<false, VkResourceType>::Get(const VkResourceType &el)
     TOSTR_CASE_STRINGIZE(eResSemaphore)
     TOSTR_CASE_STRINGIZE(eResSwapchain)
     TOSTR_CASE_STRINGIZE(eResSurface)
+    TOSTR_CASE_STRINGIZE(eResDescUpdateTemplate)
     default: break;
   }
 
@@ -1930,6 +1931,20 @@ string ToStrHelper<false, VkPipelineBindPoint>::Get(const VkPipelineBindPoint &e
   return StringFormat::Fmt("VkPipelineBindPoint<%d>", el);
 }
 
+template <>
+string ToStrHelper<false, VkDescriptorUpdateTemplateTypeKHR>::Get(
+    const VkDescriptorUpdateTemplateTypeKHR &el)
+{
+  switch(el)
+  {
+    TOSTR_CASE_STRINGIZE(VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET_KHR)
+    TOSTR_CASE_STRINGIZE(VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR)
+    default: break;
+  }
+
+  return StringFormat::Fmt("VkDescriptorUpdateTemplateTypeKHR<%d>", el);
+}
+
 template <>
 string ToStrHelper<false, VkIndexType>::Get(const VkIndexType &el)
 {
@@ -2559,6 +2574,7 @@ string ToStrHelper<false, VkStructureType>::Get(const VkStructureType &el)
     TOSTR_CASE_STRINGIZE(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2_KHR)
     TOSTR_CASE_STRINGIZE(VK_STRUCTURE_TYPE_SPARSE_IMAGE_FORMAT_PROPERTIES_2_KHR)
     TOSTR_CASE_STRINGIZE(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SPARSE_IMAGE_FORMAT_INFO_2_KHR)
+    TOSTR_CASE_STRINGIZE(VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO_KHR)
     TOSTR_CASE_STRINGIZE(VK_STRUCTURE_TYPE_VALIDATION_FLAGS_EXT)
     TOSTR_CASE_STRINGIZE(VK_STRUCTURE_TYPE_VI_SURFACE_CREATE_INFO_NN)
     TOSTR_CASE_STRINGIZE(VK_STRUCTURE_TYPE_OBJECT_TABLE_CREATE_INFO_NVX)
@@ -4836,6 +4852,57 @@ void Serialiser::Deserialise(const VkDescriptorSetLayoutCreateInfo *const el) co
   }
 }
 
+template <>
+void Serialiser::Serialise(const char *name, VkDescriptorUpdateTemplateEntryKHR &el)
+{
+  ScopedContext scope(this, name, "VkDescriptorUpdateTemplateEntryKHR", 0, true);
+
+  Serialise("dstBinding", el.dstBinding);
+  Serialise("dstArrayElement", el.dstArrayElement);
+  Serialise("descriptorCount", el.descriptorCount);
+  Serialise("descriptorType", el.descriptorType);
+
+  uint64_t offset = el.offset;
+  Serialise("offset", offset);
+  uint64_t stride = el.stride;
+  Serialise("stride", stride);
+  if(m_Mode == READING)
+  {
+    el.offset = (size_t)offset;
+    el.stride = (size_t)stride;
+  }
+}
+
+template <>
+void Serialiser::Serialise(const char *name, VkDescriptorUpdateTemplateCreateInfoKHR &el)
+{
+  ScopedContext scope(this, name, "VkDescriptorUpdateTemplateCreateInfoKHR", 0, true);
+
+  RDCASSERT(m_Mode < WRITING ||
+            el.sType == VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO_KHR);
+  SerialiseNext(this, el.sType, (const void *&)el.pNext);
+
+  Serialise("flags", (VkFlagWithNoBits &)el.flags);
+  SerialiseComplexArray("pDescriptorUpdateEntries",
+                        (VkDescriptorUpdateTemplateEntryKHR *&)el.pDescriptorUpdateEntries,
+                        el.descriptorUpdateEntryCount);
+  Serialise("templateType", el.templateType);
+  SerialiseObject(VkDescriptorSetLayout, "descriptorSetLayout", el.descriptorSetLayout);
+  Serialise("pipelineBindPoint", el.pipelineBindPoint);
+  SerialiseObject(VkPipelineLayout, "pipelineLayout", el.pipelineLayout);
+  Serialise("set", el.set);
+}
+
+template <>
+void Serialiser::Deserialise(const VkDescriptorUpdateTemplateCreateInfoKHR *const el) const
+{
+  if(m_Mode == READING)
+  {
+    RDCASSERT(el->pNext == NULL);    // otherwise delete
+    delete[] el->pDescriptorUpdateEntries;
+  }
+}
+
 template <>
 void Serialiser::Serialise(const char *name, VkComponentMapping &el)
 {
@@ -274,6 +274,10 @@ void Serialiser::Serialise(const char *name, VkDescriptorSetLayoutBinding &el);
 template <>
 void Serialiser::Serialise(const char *name, VkDescriptorSetLayoutCreateInfo &el);
 template <>
+void Serialiser::Serialise(const char *name, VkDescriptorUpdateTemplateEntryKHR &el);
+template <>
+void Serialiser::Serialise(const char *name, VkDescriptorUpdateTemplateCreateInfoKHR &el);
+template <>
 void Serialiser::Serialise(const char *name, VkDescriptorPoolCreateInfo &el);
 template <>
 void Serialiser::Serialise(const char *name, VkDescriptorSetAllocateInfo &el);
@@ -377,6 +381,8 @@ template <>
 void Serialiser::Deserialise(const VkWriteDescriptorSet *const el) const;
 template <>
 void Serialiser::Deserialise(const VkDescriptorSetLayoutCreateInfo *const el) const;
+template <>
+void Serialiser::Deserialise(const VkDescriptorUpdateTemplateCreateInfoKHR *const el) const;
 
 // the possible contents of a descriptor set slot,
 // taken from the VkWriteDescriptorSet
@@ -529,6 +535,10 @@ enum VulkanChunkType
   CAPTURE_SCOPE,
   CONTEXT_CAPTURE_HEADER,
   CONTEXT_CAPTURE_FOOTER,
+  CONTEXT_FRAME_BOUNDARY,
+
+  CREATE_DESCRIPTOR_UPDATE_TEMPLATE,
+  UPDATE_DESC_SET_WITH_TEMPLATE,
 
   NUM_VULKAN_CHUNKS,
 };
@@ -23,7 +23,6 @@
  ******************************************************************************/
 
 #include "vk_core.h"
-#include "jpeg-compressor/jpge.h"
 #include "maths/formatpacking.h"
 #include "serialise/string_utils.h"
 #include "vk_debug.h"
@@ -155,6 +154,10 @@ const char *VkChunkNames[] = {
     "Capture",
     "BeginCapture",
     "EndCapture",
+    "FrameBoundary",
+
+    "vkCreateDescriptorUpdateTemplateKHR",
+    "vkUpdateDescriptorSetWithTemplateKHR",
 };
 
 VkInitParams::VkInitParams()
@@ -170,6 +173,9 @@ VkInitParams::VkInitParams()
 // Here we list which non-current versions we support, and what changed
 const uint32_t VkInitParams::VK_OLD_VERSIONS[VkInitParams::VK_NUM_SUPPORTED_OLD_VERSIONS] = {
     0x0000005,    // from 0x5 to 0x6, we added serialisation of the original swapchain's imageUsage
+    0x0000006,    // from 0x6 to 0x7, memory initial contents are serialised as a list of ranges
+    0x0000007,    // from 0x7 to 0x8, we added the list of placeholder initial contents
+    0x0000008,    // from 0x8 to 0x9, sparse initial contents only save the bound ranges of memory
 };
 
 ReplayStatus VkInitParams::Serialise()
@@ -292,6 +298,10 @@ WrappedVulkan::WrappedVulkan(const char *logFilename) : m_RenderState(&m_Creatio
 
   m_AppControlledCapture = false;
 
+  m_InitStateBatch.cmd = VK_NULL_HANDLE;
+  m_InitStateBatch.numResources = 0;
+  m_InitStateBatch.tempBytes = 0;
+
   threadSerialiserTLSSlot = Threading::AllocateTLSSlot();
   tempMemoryTLSSlot = Threading::AllocateTLSSlot();
   debugMessageSinkTLSSlot = Threading::AllocateTLSSlot();
@@ -308,6 +318,15 @@ WrappedVulkan::WrappedVulkan(const char *logFilename) : m_RenderState(&m_Creatio
 
   m_LastCmdBufferID = ResourceId();
 
+  m_PartialCmdCacheTick = 0;
+
+  m_ReplayPipelineCache = VK_NULL_HANDLE;
+  m_ReplayPipelineCacheInit = false;
+  m_ReplayPipelineCacheLoadedSize = 0;
+
+  m_DeferPipelineCreation = false;
+  m_NextPendingPipeline = 0;
+
   m_DrawcallStack.push_back(&m_ParentDrawcall);
 
   m_SetDeviceLoaderData = NULL;
@@ -387,6 +406,9 @@ VkCommandBuffer WrappedVulkan::GetNextCmd()
 {
   VkCommandBuffer ret;
 
+  if(m_InternalCmds.freecmds.empty())
+    RecycleCompletedCmds();
+
   if(!m_InternalCmds.freecmds.empty())
   {
     ret = m_InternalCmds.freecmds.back();
@@ -419,42 +441,138 @@ VkCommandBuffer WrappedVulkan::GetNextCmd()
 void WrappedVulkan::SubmitCmds()
 {
   // nothing to do
-  if(m_InternalCmds.pendingcmds.empty())
+  if(m_InternalCmds.pendingcmds.empty() && m_InternalCmds.pendingwaitsems.empty())
     return;
 
   vector<VkCommandBuffer> cmds = m_InternalCmds.pendingcmds;
   for(size_t i = 0; i < cmds.size(); i++)
     cmds[i] = Unwrap(cmds[i]);
 
+  vector<VkPipelineStageFlags> waitStages(m_InternalCmds.pendingwaitsems.size(),
+                                          VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
   VkSubmitInfo submitInfo = {
       VK_STRUCTURE_TYPE_SUBMIT_INFO,
       NULL,
-      0,
-      NULL,
-      NULL,    // wait semaphores
+      (uint32_t)m_InternalCmds.pendingwaitsems.size(),
+      m_InternalCmds.pendingwaitsems.empty() ? NULL : &m_InternalCmds.pendingwaitsems[0],
+      waitStages.empty() ? NULL : &waitStages[0],    // wait semaphores
       (uint32_t)cmds.size(),
-      &cmds[0],    // command buffers
+      cmds.empty() ? NULL : &cmds[0],    // command buffers
       0,
       NULL,    // signal semaphores
   };
 
+  InternalCmdsBatch batch;
+  batch.fence = VK_NULL_HANDLE;
+  batch.numCmds = cmds.size();
+  batch.waitsems.swap(m_InternalCmds.pendingwaitsems);
+
   // we might have work to do (e.g. debug manager creation command buffer) but
   // no queue, if the device is destroyed immediately. In this case we can just
   // skip the submit
   if(m_Queue != VK_NULL_HANDLE)
   {
-    VkResult vkr = ObjDisp(m_Queue)->QueueSubmit(Unwrap(m_Queue), 1, &submitInfo, VK_NULL_HANDLE);
+    if(!m_InternalCmds.freefences.empty())
+    {
+      batch.fence = m_InternalCmds.freefences.back();
+      m_InternalCmds.freefences.pop_back();
+    }
+    else
+    {
+      VkFenceCreateInfo fenceInfo = {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+      VkResult vkr =
+          ObjDisp(m_Device)->CreateFence(Unwrap(m_Device), &fenceInfo, NULL, &batch.fence);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    }
+
+    VkResult vkr = ObjDisp(m_Queue)->QueueSubmit(Unwrap(m_Queue), 1, &submitInfo, batch.fence);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
   }
 
-#if ENABLED(SINGLE_FLUSH_VALIDATE)
-  FlushQ();
-#endif
+  m_InternalCmds.submittedbatches.push_back(batch);
 
   m_InternalCmds.submittedcmds.insert(m_InternalCmds.submittedcmds.end(),
                                       m_InternalCmds.pendingcmds.begin(),
                                       m_InternalCmds.pendingcmds.end());
   m_InternalCmds.pendingcmds.clear();
+
+#if ENABLED(SINGLE_FLUSH_VALIDATE)
+  FlushQ();
+#endif
+}
+
+void WrappedVulkan::RecycleCompletedCmds()
+{
+  size_t numBatches = 0, numCmds = 0;
+
+  for(; numBatches < m_InternalCmds.submittedbatches.size(); numBatches++)
+  {
+    InternalCmdsBatch &batch = m_InternalCmds.submittedbatches[numBatches];
+
+    if(batch.fence != VK_NULL_HANDLE)
+    {
+      if(ObjDisp(m_Device)->GetFenceStatus(Unwrap(m_Device), batch.fence) != VK_SUCCESS)
+        break;
+
+      ObjDisp(m_Device)->ResetFences(Unwrap(m_Device), 1, &batch.fence);
+      m_InternalCmds.freefences.push_back(batch.fence);
+    }
+
+    for(size_t i = 0; i < batch.waitsems.size(); i++)
+      ObjDisp(m_Device)->DestroySemaphore(Unwrap(m_Device), batch.waitsems[i], NULL);
+
+    numCmds += batch.numCmds;
+  }
+
+  if(numBatches == 0)
+    return;
+
+  m_InternalCmds.submittedbatches.erase(m_InternalCmds.submittedbatches.begin(),
+                                        m_InternalCmds.submittedbatches.begin() + numBatches);
+
+  m_InternalCmds.freecmds.insert(m_InternalCmds.freecmds.end(),
+                                 m_InternalCmds.submittedcmds.begin(),
+                                 m_InternalCmds.submittedcmds.begin() + numCmds);
+  m_InternalCmds.submittedcmds.erase(m_InternalCmds.submittedcmds.begin(),
+                                     m_InternalCmds.submittedcmds.begin() + numCmds);
+}
+
+void WrappedVulkan::WaitForSubmittedCmds()
+{
+  if(m_InternalCmds.submittedbatches.empty())
+    return;
+
+  VkFence fence = m_InternalCmds.submittedbatches.back().fence;
+
+  if(fence != VK_NULL_HANDLE)
+  {
+    VkResult vkr =
+        ObjDisp(m_Device)->WaitForFences(Unwrap(m_Device), 1, &fence, VK_TRUE, ~0ULL);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  }
+
+  RecycleCompletedCmds();
+}
+
+void WrappedVulkan::DestroyInternalFences()
+{
+  // anything still waiting on these batches is about to be destroyed too
+  for(size_t i = 0; i < m_InternalCmds.submittedbatches.size(); i++)
+  {
+    InternalCmdsBatch &batch = m_InternalCmds.submittedbatches[i];
+
+    if(batch.fence != VK_NULL_HANDLE)
+      m_InternalCmds.freefences.push_back(batch.fence);
+
+    for(size_t s = 0; s < batch.waitsems.size(); s++)
+      ObjDisp(m_Device)->DestroySemaphore(Unwrap(m_Device), batch.waitsems[s], NULL);
+  }
+  m_InternalCmds.submittedbatches.clear();
+
+  for(size_t i = 0; i < m_InternalCmds.freefences.size(); i++)
+    ObjDisp(m_Device)->DestroyFence(Unwrap(m_Device), m_InternalCmds.freefences[i], NULL);
+  m_InternalCmds.freefences.clear();
 }
 
 VkSemaphore WrappedVulkan::GetNextSemaphore()
@@ -518,6 +636,9 @@ void WrappedVulkan::FlushQ()
   }
 #endif
 
+  // every batch has completed now, so recycling doesn't wait on anything
+  RecycleCompletedCmds();
+
   if(!m_InternalCmds.submittedcmds.empty())
   {
     m_InternalCmds.freecmds.insert(m_InternalCmds.freecmds.end(),
@@ -766,6 +887,10 @@ static const VkExtensionProperties supportedExtensions[] = {
         VK_KHR_ANDROID_SURFACE_EXTENSION_NAME, VK_KHR_ANDROID_SURFACE_SPEC_VERSION,
     },
 #endif
+    {
+        VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME,
+        VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_SPEC_VERSION,
+    },
 #ifdef VK_KHR_display
     {
         VK_KHR_DISPLAY_EXTENSION_NAME, VK_KHR_DISPLAY_SPEC_VERSION,
@@ -986,6 +1111,9 @@ void WrappedVulkan::Serialise_CaptureScope(uint64_t offset)
   // must use main serialiser here to match resource manager below
   GetMainSerialiser()->Serialise("FrameNumber", FrameNumber);
 
+  if(m_State >= WRITING || GetLogVersion() >= 0x0000008)
+    GetResourceManager()->Serialise_InitialContentsPlaceholders();
+
   if(m_State >= WRITING)
   {
     GetResourceManager()->Serialise_InitialContentsNeeded();
@@ -1029,6 +1157,25 @@ void WrappedVulkan::EndCaptureFrame(VkImage presentImage)
   m_FrameCaptureRecord->AddChunk(scope.Get());
 }
 
+void WrappedVulkan::AddFrameBoundary(VkImage presentImage)
+{
+  SCOPED_LOCK(m_CapTransitionLock);
+
+  if(m_State != WRITING_CAPFRAME)
+    return;
+
+  GetResourceManager()->MarkResourceFrameReferenced(GetResID(presentImage), eFrameRef_Read);
+
+  // must use main serialiser here to match resource manager
+  Serialiser *localSerialiser = GetMainSerialiser();
+
+  SCOPED_SERIALISE_CONTEXT(CONTEXT_FRAME_BOUNDARY);
+
+  SERIALISE_ELEMENT(ResourceId, bbid, GetResID(presentImage));
+
+  m_FrameCaptureRecord->AddChunk(scope.Get());
+}
+
 void WrappedVulkan::FirstFrame(VkSwapchainKHR swap)
 {
   SwapchainInfo *swapdesc = GetRecord(swap)->swapInfo;
@@ -1136,8 +1283,30 @@ void WrappedVulkan::StartFrameCapture(void *dev, void *wnd)
   // and go into the frame record.
   {
     SCOPED_LOCK(m_CapTransitionLock);
+
+    // write-watched maps start tracking afresh just before their initial contents are taken, so
+    // only pages written after this point need to be saved during the frame
+    {
+      SCOPED_LOCK(m_CoherentMapsLock);
+      for(auto it = m_CoherentMaps.begin(); it != m_CoherentMaps.end(); ++it)
+      {
+        MemMapState &state = *(*it)->memMapState;
+
+        if(state.writeWatch)
+        {
+          WriteWatch::Reset(state.writeWatch);
+          state.writeWatchSynced = true;
+
+          GetResourceManager()->MarkDirtyResource((*it)->GetResourceID());
+        }
+      }
+    }
+
     GetResourceManager()->PrepareInitialContents();
 
+    // wait for all the initial contents readbacks in one go
+    FlushInitStateBatch();
+
     RDCDEBUG("Attempting capture");
     m_FrameCaptureRecord->DeleteChunks();
 
@@ -1265,6 +1434,27 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
 
     const SwapchainInfo &swapInfo = *swaprecord->swapInfo;
 
+    float aspect = float(swapInfo.extent.width) / float(swapInfo.extent.height);
+
+    thwidth = RDCMIN(maxSize, swapInfo.extent.width);
+    thwidth &= ~0x7;    // align down to multiple of 8
+    thheight = uint32_t(float(thwidth) / aspect);
+
+    // where the formats allow it, blit down to an RGBA8 thumbnail on the GPU so only the thumbnail
+    // is read back and there's no resampling or conversion to do on the CPU. sRGB and float
+    // backbuffers are encoded to sRGB by the blit.
+    VkFormat thumbFormat = VK_FORMAT_R8G8B8A8_UNORM;
+    if(IsSRGBFormat(swapInfo.format) ||
+       MakeResourceFormat(swapInfo.format).compType == CompType::Float)
+      thumbFormat = VK_FORMAT_R8G8B8A8_SRGB;
+
+    const VkFormatFeatureFlags bbFeatures =
+        GetFormatProperties(swapInfo.format).optimalTilingFeatures;
+
+    bool gpuDownscale = (bbFeatures & VK_FORMAT_FEATURE_BLIT_SRC_BIT) &&
+                        (GetFormatProperties(thumbFormat).linearTilingFeatures &
+                         VK_FORMAT_FEATURE_BLIT_DST_BIT);
+
     // since these objects are very short lived (only this scope), we
     // don't wrap them.
     VkImage readbackIm = VK_NULL_HANDLE;
@@ -1272,14 +1462,15 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
 
     VkResult vkr = VK_SUCCESS;
 
-    // create identical image
+    // create identical image, or one the size of the thumbnail to blit into
     VkImageCreateInfo imInfo = {
         VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
         NULL,
         0,
         VK_IMAGE_TYPE_2D,
-        swapInfo.format,
-        {swapInfo.extent.width, swapInfo.extent.height, 1},
+        gpuDownscale ? thumbFormat : swapInfo.format,
+        {gpuDownscale ? thwidth : swapInfo.extent.width,
+         gpuDownscale ? thheight : swapInfo.extent.height, 1},
         1,
         1,
         VK_SAMPLE_COUNT_1_BIT,
@@ -1350,8 +1541,31 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
     DoPipelineBarrier(cmd, 1, &bbBarrier);
     DoPipelineBarrier(cmd, 1, &readBarrier);
 
-    vt->CmdCopyImage(Unwrap(cmd), Unwrap(backbuffer), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                     readbackIm, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &cpy);
+    if(gpuDownscale)
+    {
+      VkImageBlit blit = {
+          {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+          {
+              {0, 0, 0}, {(int32_t)swapInfo.extent.width, (int32_t)swapInfo.extent.height, 1},
+          },
+          {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+          {
+              {0, 0, 0}, {(int32_t)thwidth, (int32_t)thheight, 1},
+          },
+      };
+
+      VkFilter filter = (bbFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)
+                            ? VK_FILTER_LINEAR
+                            : VK_FILTER_NEAREST;
+
+      vt->CmdBlitImage(Unwrap(cmd), Unwrap(backbuffer), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                       readbackIm, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, filter);
+    }
+    else
+    {
+      vt->CmdCopyImage(Unwrap(cmd), Unwrap(backbuffer), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                       readbackIm, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &cpy);
+    }
 
     // barrier to switch backbuffer back to present layout
     std::swap(bbBarrier.oldLayout, bbBarrier.newLayout);
@@ -1378,8 +1592,31 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
 
     RDCASSERT(pData != NULL);
 
-    // point sample info into raw buffer
+    if(gpuDownscale)
+    {
+      // the thumbnail is already the right size and format, just drop the alpha
+      thpixels = new byte[3 * thwidth * thheight];
+
+      byte *dst = thpixels;
+
+      for(uint32_t y = 0; y < thheight; y++)
+      {
+        byte *src = pData + layout.offset + layout.rowPitch * y;
+
+        for(uint32_t x = 0; x < thwidth; x++)
+        {
+          dst[0] = src[0];
+          dst[1] = src[1];
+          dst[2] = src[2];
+
+          src += 4;
+          dst += 3;
+        }
+      }
+    }
+    else
     {
+      // point sample info into raw buffer
       ResourceFormat fmt = MakeResourceFormat(imInfo.format);
 
       byte *data = (byte *)pData;
@@ -1389,12 +1626,6 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
       float widthf = float(imInfo.extent.width);
       float heightf = float(imInfo.extent.height);
 
-      float aspect = widthf / heightf;
-
-      thwidth = RDCMIN(maxSize, imInfo.extent.width);
-      thwidth &= ~0x7;    // align down to multiple of 8
-      thheight = uint32_t(float(thwidth) / aspect);
-
       thpixels = new byte[3 * thwidth * thheight];
 
       uint32_t stride = fmt.compByteWidth * fmt.compCount;
@@ -1507,30 +1738,9 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
     vt->FreeMemory(Unwrap(device), readbackMem, NULL);
   }
 
-  byte *jpgbuf = NULL;
-  int len = thwidth * thheight;
-
-  if(wnd)
-  {
-    jpgbuf = new byte[len];
-
-    jpge::params p;
-    p.m_quality = 80;
-
-    bool success =
-        jpge::compress_image_to_jpeg_file_in_memory(jpgbuf, len, thwidth, thheight, 3, thpixels, p);
-
-    if(!success)
-    {
-      RDCERR("Failed to compress to jpg");
-      SAFE_DELETE_ARRAY(jpgbuf);
-      thwidth = 0;
-      thheight = 0;
-    }
-  }
-
+  // the thumbnail is JPEG encoded when the capture is written, off this thread if possible
   Serialiser *m_pFileSerialiser = RenderDoc::Inst().OpenWriteSerialiser(
-      m_FrameCounter, &m_InitParams, jpgbuf, len, thwidth, thheight);
+      m_FrameCounter, &m_InitParams, thpixels, thwidth, thheight);
 
   {
     CACHE_THREAD_SERIALISER();
@@ -1542,6 +1752,8 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
 
   RDCDEBUG("Inserting Resource Serialisers");
 
+  SerialiseDeferredSamplers();
+
   GetResourceManager()->InsertReferencedChunks(m_pFileSerialiser);
 
   GetResourceManager()->InsertInitialContentsChunks(m_pFileSerialiser);
@@ -1568,7 +1780,7 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
     RDCDEBUG("Flushing %u command buffer records to file serialiser",
              (uint32_t)m_CmdBufferRecords.size());
 
-    map<int32_t, Chunk *> recordlist;
+    ChunkList recordlist;
 
     // ensure all command buffer records within the frame evne if recorded before, but
     // otherwise order must be preserved (vs. queue submits and desc set updates)
@@ -1582,6 +1794,8 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
 
     m_FrameCaptureRecord->Insert(recordlist);
 
+    SortChunkList(recordlist);
+
     RDCDEBUG("Flushing %u chunks to file serialiser from context record",
              (uint32_t)recordlist.size());
 
@@ -1591,11 +1805,8 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
     RDCDEBUG("Done");
   }
 
-  m_pFileSerialiser->FlushToDisk();
-
-  RenderDoc::Inst().SuccessfullyWrittenLog(m_FrameCounter);
+  RenderDoc::Inst().FinishWriteSerialiser(m_pFileSerialiser, m_FrameCounter);
 
-  SAFE_DELETE(m_pFileSerialiser);
   SAFE_DELETE(m_HeaderChunk);
 
   m_State = WRITING_IDLE;
@@ -1624,8 +1835,6 @@ void WrappedVulkan::ReadLogInitialisation()
 
   ValidateSupportedExtensionList();
 
-  m_pSerialiser->SetDebugText(true);
-
   m_pSerialiser->Rewind();
 
   while(!m_pSerialiser->AtEnd())
@@ -1662,6 +1871,9 @@ void WrappedVulkan::ReadLogInitialisation()
 
   SCOPED_TIMER("chunk initialisation");
 
+  m_DeferPipelineCreation = RenderDoc::Inst().GetConfigSetting("replay.parallelPipelines") != "0" &&
+                            Threading::GetCPUCount() > 1;
+
   for(;;)
   {
     PerformanceTimer timer;
@@ -1670,8 +1882,14 @@ void WrappedVulkan::ReadLogInitialisation()
 
     VulkanChunkType context = (VulkanChunkType)m_pSerialiser->PushContext(NULL, NULL, 1, false);
 
+    // object names refer to pipelines by ID, and the frame uses them
+    if(context == SET_NAME || context == CAPTURE_SCOPE)
+      FlushPendingPipelines();
+
     if(context == CAPTURE_SCOPE)
     {
+      m_DeferPipelineCreation = false;
+
       // immediately read rest of log into memory
       m_pSerialiser->SetPersistentBlock(offset);
     }
@@ -1686,7 +1904,12 @@ void WrappedVulkan::ReadLogInitialisation()
         FileInitialRead, float(m_pSerialiser->GetOffset()) / float(m_pSerialiser->GetSize()));
 
     if(context == CAPTURE_SCOPE)
+    {
+      // the chunks before the frame never become events, so don't pay for their debug text
+      m_pSerialiser->SetDebugText(true);
+
       ContextReplayLog(READING, 0, 0, false);
+    }
 
     uint64_t offset2 = m_pSerialiser->GetOffset();
 
@@ -1706,6 +1929,9 @@ void WrappedVulkan::ReadLogInitialisation()
     }
   }
 
+  FlushPendingPipelines();
+  m_DeferPipelineCreation = false;
+
 #if ENABLED(RDOC_DEVEL)
   for(auto it = chunkInfos.begin(); it != chunkInfos.end(); ++it)
   {
@@ -1724,12 +1950,15 @@ void WrappedVulkan::ReadLogInitialisation()
   m_FrameRecord.frameInfo.compressedFileSize = m_pSerialiser->GetFileSize();
   m_FrameRecord.frameInfo.persistentSize = m_pSerialiser->GetSize() - firstFrame;
   m_FrameRecord.frameInfo.initDataSize = chunkInfos[(VulkanChunkType)INITIAL_CONTENTS].totalsize;
+  m_FrameRecord.frameInfo.queueSubmissions = m_QueueSubmissions;
 
   RDCDEBUG("Allocating %llu persistant bytes of memory for the log.",
            m_pSerialiser->GetSize() - firstFrame);
 
   m_pSerialiser->SetDebugText(false);
 
+  SaveReplayPipelineCache();
+
   // ensure the capture at least created a device and fetched a queue.
   RDCASSERT(m_Device != VK_NULL_HANDLE && m_Queue != VK_NULL_HANDLE &&
             m_InternalCmds.cmdpool != VK_NULL_HANDLE);
@@ -1854,6 +2083,46 @@ void WrappedVulkan::ContextReplayLog(LogState readType, uint32_t startEventID, u
 
   ObjDisp(GetDev())->DeviceWaitIdle(Unwrap(GetDev()));
 
+  // keep a freshly re-recorded primary partial command buffer for next time, unless it depended on
+  // a drawcall callback or a partial secondary that we don't keep.
+  if(m_State == EXECUTING && m_Partial[Primary].resultPartialCmdBuffer != VK_NULL_HANDLE &&
+     !m_Partial[Primary].resultFromCache && m_Partial[Primary].partialBakeId != ResourceId() &&
+     m_Partial[Primary].outsideCmdBuffer == VK_NULL_HANDLE &&
+     m_Partial[Secondary].resultPartialCmdBuffer == VK_NULL_HANDLE && m_DrawcallCallback == NULL)
+  {
+    PartialCmdKey key;
+    key.bakeId = m_Partial[Primary].partialBakeId;
+    key.lastEvent = m_LastEventID;
+    key.partialType = Primary;
+
+    if(m_PartialCmdCache.find(key) == m_PartialCmdCache.end())
+    {
+      if(m_PartialCmdCache.size() >= PartialCmdCacheSize)
+      {
+        auto lru = m_PartialCmdCache.begin();
+        for(auto it = m_PartialCmdCache.begin(); it != m_PartialCmdCache.end(); ++it)
+          if(it->second.lastUse < lru->second.lastUse)
+            lru = it;
+
+        FreeCachedPartialCmd(lru->second);
+        m_PartialCmdCache.erase(lru);
+      }
+
+      CachedPartialCmd &cached = m_PartialCmdCache[key];
+      cached.device = m_Partial[Primary].partialDevice;
+      cached.pool = m_Partial[Primary].resultPartialCmdPool;
+      cached.cmd = m_Partial[Primary].resultPartialCmdBuffer;
+      cached.state = new VulkanRenderState(&m_CreationInfo);
+      *cached.state = m_RenderState;
+      cached.renderPassActive = m_Partial[Primary].renderPassActive;
+      // without a drawcall callback or a secondary, only this command buffer creates events
+      cached.events.swap(m_CleanupEvents);
+      cached.lastUse = ++m_PartialCmdCacheTick;
+
+      m_Partial[Primary].resultFromCache = true;
+    }
+  }
+
   // destroy any events we created for waiting on
   for(size_t i = 0; i < m_CleanupEvents.size(); i++)
     ObjDisp(GetDev())->DestroyEvent(Unwrap(GetDev()), m_CleanupEvents[i], NULL);
@@ -1862,6 +2131,13 @@ void WrappedVulkan::ContextReplayLog(LogState readType, uint32_t startEventID, u
 
   for(int p = 0; p < ePartialNum; p++)
   {
+    // cached command buffers are owned by m_PartialCmdCache
+    if(m_Partial[p].resultFromCache)
+    {
+      m_Partial[p].resultPartialCmdBuffer = VK_NULL_HANDLE;
+      m_Partial[p].resultFromCache = false;
+    }
+
     if(m_Partial[p].resultPartialCmdBuffer != VK_NULL_HANDLE)
     {
       // deliberately call our own function, so this is destroyed as a wrapped object
@@ -2078,6 +2354,14 @@ void WrappedVulkan::ProcessChunk(uint64_t offset, VulkanChunkType context)
     case UPDATE_DESC_SET:
       Serialise_vkUpdateDescriptorSets(GetMainSerialiser(), VK_NULL_HANDLE, 0, NULL, 0, NULL);
       break;
+    case CREATE_DESCRIPTOR_UPDATE_TEMPLATE:
+      Serialise_vkCreateDescriptorUpdateTemplateKHR(GetMainSerialiser(), VK_NULL_HANDLE, NULL, NULL,
+                                                    NULL);
+      break;
+    case UPDATE_DESC_SET_WITH_TEMPLATE:
+      Serialise_vkUpdateDescriptorSetWithTemplateKHR(GetMainSerialiser(), VK_NULL_HANDLE,
+                                                     VK_NULL_HANDLE, VK_NULL_HANDLE, NULL);
+      break;
 
     case BEGIN_CMD_BUFFER:
       Serialise_vkBeginCommandBuffer(GetMainSerialiser(), VK_NULL_HANDLE, NULL);
@@ -2308,6 +2592,29 @@ void WrappedVulkan::ProcessChunk(uint64_t offset, VulkanChunkType context)
       }
       break;
     }
+    case CONTEXT_FRAME_BOUNDARY:
+    {
+      Serialiser *localSerialiser = GetMainSerialiser();
+
+      // a present in the middle of a multi-frame capture. Unlike the footer the frame carries on
+      SERIALISE_ELEMENT(ResourceId, bbid, ResourceId());
+
+      if(m_State == READING)
+      {
+        m_FrameRecord.frameInfo.frameCount++;
+
+        AddEvent("vkQueuePresentKHR()");
+
+        DrawcallDescription draw;
+        draw.name = "vkQueuePresentKHR()";
+        draw.flags |= DrawFlags::Present;
+
+        draw.copyDestination = bbid;
+
+        AddDrawcall(draw, true);
+      }
+      break;
+    }
     default:
     {
       // ignore system chunks
@@ -2676,6 +2983,296 @@ VkBool32 WrappedVulkan::DebugCallback(VkDebugReportFlagsEXT flags,
   return false;
 }
 
+void WrappedVulkan::FreeCachedPartialCmd(CachedPartialCmd &cached)
+{
+  // deliberately call our own function, so this is destroyed as a wrapped object
+  vkFreeCommandBuffers(cached.device, cached.pool, 1, &cached.cmd);
+
+  for(size_t i = 0; i < cached.events.size(); i++)
+    ObjDisp(GetDev())->DestroyEvent(Unwrap(GetDev()), cached.events[i], NULL);
+
+  SAFE_DELETE(cached.state);
+}
+
+void WrappedVulkan::FreePartialCmdCache()
+{
+  for(auto it = m_PartialCmdCache.begin(); it != m_PartialCmdCache.end(); ++it)
+    FreeCachedPartialCmd(it->second);
+
+  m_PartialCmdCache.clear();
+}
+
+void WrappedVulkan::FreePartialCmdCache(const vector<ResourceId> &pipelines)
+{
+  for(auto it = m_PartialCmdCache.begin(); it != m_PartialCmdCache.end();)
+  {
+    const set<ResourceId> &bound = m_BakedCmdBufferInfo[it->first.bakeId].boundPipelines;
+
+    bool refdPipe = false;
+    for(size_t i = 0; i < pipelines.size(); i++)
+    {
+      if(bound.find(pipelines[i]) != bound.end())
+      {
+        refdPipe = true;
+        break;
+      }
+    }
+
+    if(refdPipe)
+    {
+      FreeCachedPartialCmd(it->second);
+      it = m_PartialCmdCache.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+}
+
+string WrappedVulkan::GetReplayPipelineCacheFilename()
+{
+  const VkPhysicalDeviceProperties &props = m_PhysicalDeviceData.props;
+
+  const string &filename = m_pSerialiser->GetFilename();
+
+  // identify the capture by its path, size and modification time
+  uint32_t captureHash = strhash(filename.c_str());
+  uint64_t fileSize = m_pSerialiser->GetFileSize();
+  uint64_t timestamp = FileIO::GetModifiedTimestamp(filename);
+  captureHash = strhash(StringFormat::Fmt("%llu_%llu", fileSize, timestamp).c_str(), captureHash);
+
+  return FileIO::GetAppFolderFilename(
+      StringFormat::Fmt("vkpipecache_%08x_%04x_%04x_%08x.bin", captureHash, props.vendorID,
+                        props.deviceID, props.driverVersion));
+}
+
+VkPipelineCache WrappedVulkan::GetReplayPipelineCache()
+{
+  if(m_ReplayPipelineCacheInit)
+    return m_ReplayPipelineCache;
+
+  m_ReplayPipelineCacheInit = true;
+
+  if(RenderDoc::Inst().GetConfigSetting("replay.pipelineCache") == "0" ||
+     m_pSerialiser->GetFilename().empty())
+    return VK_NULL_HANDLE;
+
+  vector<byte> data;
+
+  string filename = GetReplayPipelineCacheFilename();
+
+  FILE *f = FileIO::fopen(filename.c_str(), "rb");
+
+  if(f)
+  {
+    FileIO::fseek64(f, 0, SEEK_END);
+    data.resize((size_t)FileIO::ftell64(f));
+    FileIO::fseek64(f, 0, SEEK_SET);
+
+    if(data.empty() || FileIO::fread(&data[0], 1, data.size(), f) != data.size())
+      data.clear();
+
+    FileIO::fclose(f);
+  }
+
+  // the driver validates the header and ignores data that doesn't match it
+  VkPipelineCacheCreateInfo info = {
+      VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO, NULL, 0, data.size(),
+      data.empty() ? NULL : &data[0],
+  };
+
+  VkResult ret =
+      ObjDisp(m_Device)->CreatePipelineCache(Unwrap(m_Device), &info, NULL, &m_ReplayPipelineCache);
+
+  if(ret != VK_SUCCESS)
+  {
+    RDCWARN("Couldn't create replay pipeline cache, VkResult: 0x%08x", ret);
+    m_ReplayPipelineCache = VK_NULL_HANDLE;
+    return VK_NULL_HANDLE;
+  }
+
+  m_ReplayPipelineCacheLoadedSize = data.size();
+
+  RDCLOG("Loaded %llu bytes of replay pipeline cache", (uint64_t)data.size());
+
+  return m_ReplayPipelineCache;
+}
+
+void WrappedVulkan::SaveReplayPipelineCache()
+{
+  if(m_ReplayPipelineCache == VK_NULL_HANDLE)
+    return;
+
+  size_t size = 0;
+  VkResult ret =
+      ObjDisp(m_Device)->GetPipelineCacheData(Unwrap(m_Device), m_ReplayPipelineCache, &size, NULL);
+
+  // nothing new was added since it was loaded
+  if(ret != VK_SUCCESS || size == 0 || size == m_ReplayPipelineCacheLoadedSize)
+    return;
+
+  vector<byte> data(size);
+  ret = ObjDisp(m_Device)->GetPipelineCacheData(Unwrap(m_Device), m_ReplayPipelineCache, &size,
+                                                &data[0]);
+
+  if(ret != VK_SUCCESS)
+    return;
+
+  string filename = GetReplayPipelineCacheFilename();
+
+  FILE *f = FileIO::fopen(filename.c_str(), "wb");
+
+  if(!f)
+  {
+    RDCWARN("Couldn't open replay pipeline cache '%s' for write", filename.c_str());
+    return;
+  }
+
+  FileIO::fwrite(&data[0], 1, size, f);
+  FileIO::fclose(f);
+
+  m_ReplayPipelineCacheLoadedSize = size;
+
+  RDCLOG("Saved %llu bytes of replay pipeline cache", (uint64_t)size);
+}
+
+void WrappedVulkan::DestroyReplayPipelineCache()
+{
+  if(m_ReplayPipelineCache != VK_NULL_HANDLE)
+    ObjDisp(m_Device)->DestroyPipelineCache(Unwrap(m_Device), m_ReplayPipelineCache, NULL);
+
+  m_ReplayPipelineCache = VK_NULL_HANDLE;
+}
+
+void WrappedVulkan::CreatePendingPipeline(PendingPipeline &pending)
+{
+  pending.pipe = VK_NULL_HANDLE;
+
+  if(pending.compute)
+    pending.ret = ObjDisp(pending.device)
+                      ->CreateComputePipelines(Unwrap(pending.device), pending.cache, 1,
+                                               &pending.computeInfo, NULL, &pending.pipe);
+  else
+    pending.ret = ObjDisp(pending.device)
+                      ->CreateGraphicsPipelines(Unwrap(pending.device), pending.cache, 1,
+                                                &pending.graphicsInfo, NULL, &pending.pipe);
+}
+
+void WrappedVulkan::FinishPendingPipeline(PendingPipeline &pending)
+{
+  VkDevice device = pending.device;
+  VkPipeline pipe = pending.pipe;
+
+  if(pending.ret != VK_SUCCESS)
+  {
+    RDCERR("Failed on resource serialise-creation, VkResult: 0x%08x", pending.ret);
+  }
+  else
+  {
+    ResourceId live;
+
+    if(GetResourceManager()->HasWrapper(ToTypedHandle(pipe)))
+    {
+      live = GetResourceManager()->GetNonDispWrapper(pipe)->id;
+
+      // destroy this instance of the duplicate, as we must have matching create/destroy
+      // calls and there won't be a wrapped resource hanging around to destroy this one.
+      ObjDisp(device)->DestroyPipeline(Unwrap(device), pipe, NULL);
+
+      // whenever the new ID is requested, return the old ID, via replacements.
+      GetResourceManager()->ReplaceResource(pending.id, GetResourceManager()->GetOriginalID(live));
+    }
+    else
+    {
+      live = GetResourceManager()->WrapResource(Unwrap(device), pipe);
+      GetResourceManager()->AddLiveResource(pending.id, pipe);
+
+      VulkanCreationInfo::Pipeline &pipeInfo = m_CreationInfo.m_Pipeline[live];
+
+      if(pending.compute)
+        pipeInfo.Init(GetResourceManager(), m_CreationInfo, &pending.computeInfo);
+      else
+        pipeInfo.Init(GetResourceManager(), m_CreationInfo, &pending.graphicsInfo);
+
+      for(size_t i = 0; i < ARRAY_COUNT(pipeInfo.shaders); i++)
+        if(pipeInfo.shaders[i].module != ResourceId())
+          m_CreationInfo.m_ShaderModulePipelines[pipeInfo.shaders[i].module].push_back(live);
+    }
+  }
+
+  // the create info was deserialised into allocations we now own
+  if(pending.compute)
+    m_pSerialiser->Deserialise(&pending.computeInfo);
+  else
+    m_pSerialiser->Deserialise(&pending.graphicsInfo);
+}
+
+void WrappedVulkan::QueuePendingPipeline(const PendingPipeline &pending)
+{
+  if(!m_DeferPipelineCreation)
+  {
+    PendingPipeline immediate = pending;
+    CreatePendingPipeline(immediate);
+    FinishPendingPipeline(immediate);
+    return;
+  }
+
+  m_PendingPipelines.push_back(pending);
+
+  if(m_PendingPipelines.size() >= PendingPipelineBatchSize)
+    FlushPendingPipelines();
+}
+
+void WrappedVulkan::PendingPipelineWorker(void *ths)
+{
+  WrappedVulkan *driver = (WrappedVulkan *)ths;
+
+  for(;;)
+  {
+    int32_t idx = Atomic::Inc32(&driver->m_NextPendingPipeline) - 1;
+
+    if(idx >= (int32_t)driver->m_PendingPipelines.size())
+      break;
+
+    driver->CreatePendingPipeline(driver->m_PendingPipelines[idx]);
+  }
+}
+
+void WrappedVulkan::FlushPendingPipelines()
+{
+  if(m_PendingPipelines.empty())
+    return;
+
+  m_NextPendingPipeline = 0;
+
+  uint32_t numThreads = RDCMIN(Threading::GetCPUCount(), (uint32_t)m_PendingPipelines.size());
+
+  vector<Threading::ThreadHandle> threads;
+
+  // this thread works too
+  for(uint32_t i = 1; i < numThreads; i++)
+  {
+    Threading::ThreadHandle t = Threading::CreateThread(&WrappedVulkan::PendingPipelineWorker, this);
+    if(t)
+      threads.push_back(t);
+  }
+
+  PendingPipelineWorker(this);
+
+  for(size_t i = 0; i < threads.size(); i++)
+  {
+    Threading::JoinThread(threads[i]);
+    Threading::CloseThread(threads[i]);
+  }
+
+  // wrap in chunk order, so duplicate handles are resolved the same as with serial creation
+  for(size_t i = 0; i < m_PendingPipelines.size(); i++)
+    FinishPendingPipeline(m_PendingPipelines[i]);
+
+  m_PendingPipelines.clear();
+}
+
 bool WrappedVulkan::ShouldRerecordCmd(ResourceId cmdid)
 {
   if(m_Partial[Primary].outsideCmdBuffer != VK_NULL_HANDLE)
@@ -3038,6 +3635,8 @@ void WrappedVulkan::AddEvent(string description)
   APIEvent apievent;
 
   apievent.fileOffset = m_CurChunkOffset;
+  m_pSerialiser->GetChunkTiming(m_CurChunkOffset, apievent.cpuTimestamp, apievent.threadID);
+  m_pSerialiser->GetChunkResourceRefs(apievent.referencedResources);
   apievent.eventID = m_LastCmdBufferID != ResourceId()
                          ? m_BakedCmdBufferInfo[m_LastCmdBufferID].curEventID
                          : m_RootEventID;
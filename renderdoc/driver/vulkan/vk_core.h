@@ -44,10 +44,10 @@ struct VkInitParams : public RDCInitParams
 
   void Set(const VkInstanceCreateInfo *pCreateInfo, ResourceId inst);
 
-  static const uint32_t VK_SERIALISE_VERSION = 0x0000006;
+  static const uint32_t VK_SERIALISE_VERSION = 0x0000009;
 
   // backwards compatibility for old logs described at the declaration of this array
-  static const uint32_t VK_NUM_SUPPORTED_OLD_VERSIONS = 1;
+  static const uint32_t VK_NUM_SUPPORTED_OLD_VERSIONS = 4;
   static const uint32_t VK_OLD_VERSIONS[VK_NUM_SUPPORTED_OLD_VERSIONS];
 
   // version number internal to vulkan stream
@@ -274,6 +274,10 @@ private:
   FrameRecord m_FrameRecord;
   vector<DrawcallDescription *> m_Drawcalls;
 
+  // every vkQueueSubmit in the frame and which queue it went to, gathered while reading since the
+  // drawcall tree merges all queues together
+  vector<QueueSubmission> m_QueueSubmissions;
+
   struct PhysicalDeviceData
   {
     PhysicalDeviceData() : readbackMemIndex(0), uploadMemIndex(0), GPULocalMemIndex(0)
@@ -344,6 +348,17 @@ private:
   void WrapAndProcessCreatedSwapchain(VkDevice device, const VkSwapchainCreateInfoKHR *pCreateInfo,
                                       VkSwapchainKHR *pSwapChain);
 
+  // each SubmitCmds() signals a fence, so its command buffers can be recycled as soon as it's
+  // complete without waiting for the queue to idle. Batches complete in order, and each covers
+  // the next numCmds of submittedcmds. Fences are only used internally, so aren't wrapped
+  struct InternalCmdsBatch
+  {
+    VkFence fence;
+    size_t numCmds;
+    // unwrapped semaphores the batch waited on, destroyed once it's complete
+    vector<VkSemaphore> waitsems;
+  };
+
   struct
   {
     void Reset()
@@ -356,6 +371,10 @@ private:
       freesems.clear();
       pendingsems.clear();
       submittedsems.clear();
+
+      freefences.clear();
+      submittedbatches.clear();
+      pendingwaitsems.clear();
     }
 
     VkCommandPool cmdpool;    // the command pool used for allocating our own command buffers
@@ -373,8 +392,19 @@ private:
     // -> SubmitSemaphores() ->
     vector<VkSemaphore> submittedsems;
     // -> FlushQ() ----back to freesems-------^
+
+    vector<VkFence> freefences;
+    vector<InternalCmdsBatch> submittedbatches;
+
+    // unwrapped semaphores that the next SubmitCmds() will wait on, then take ownership of
+    vector<VkSemaphore> pendingwaitsems;
   } m_InternalCmds;
 
+  // recycles the command buffers of any submitted batches that have completed, without waiting
+  void RecycleCompletedCmds();
+  // destroys all internal fences, when the device is being destroyed
+  void DestroyInternalFences();
+
   vector<VkDeviceMemory> m_CleanupMems;
   vector<VkEvent> m_CleanupEvents;
 
@@ -410,6 +440,9 @@ private:
 
     vector<pair<ResourceId, EventUsage> > resourceUsage;
 
+    // live IDs of every pipeline bound in this command buffer
+    set<ResourceId> boundPipelines;
+
     struct CmdBufferState
     {
       CmdBufferState() : idxWidth(0), subpass(0) {}
@@ -481,6 +514,8 @@ private:
       partialParent = ResourceId();
       baseEvent = 0;
       renderPassActive = false;
+      partialBakeId = ResourceId();
+      resultFromCache = false;
     }
 
     // if we're doing a partial replay, by definition only one command
@@ -532,9 +567,93 @@ private:
     // reach the vkEndCommandBuffer that we also need to end a render
     // pass.
     bool renderPassActive;
+
+    // the baked command buffer that is being partially replayed, and whether
+    // resultPartialCmdBuffer came from m_PartialCmdCache instead of being
+    // re-recorded this replay.
+    ResourceId partialBakeId;
+    bool resultFromCache;
   } m_Partial[ePartialNum];
 
-  map<ResourceId, VkCommandBuffer> m_RerecordCmds;
+  ResourceIdMap<VkCommandBuffer> m_RerecordCmds;
+
+  // Re-recorded partial command buffers are kept after a replay instead of
+  // being freed, so that replaying to the same event again can submit the
+  // same command buffer without re-recording it. Along with the command
+  // buffer we keep the render state it left behind, since the skipped vkCmd
+  // chunks would otherwise have tracked it.
+  struct PartialCmdKey
+  {
+    ResourceId bakeId;
+    uint32_t lastEvent;
+    int partialType;
+
+    bool operator<(const PartialCmdKey &o) const
+    {
+      if(bakeId != o.bakeId)
+        return bakeId < o.bakeId;
+      if(lastEvent != o.lastEvent)
+        return lastEvent < o.lastEvent;
+      return partialType < o.partialType;
+    }
+  };
+
+  struct CachedPartialCmd
+  {
+    VkDevice device;
+    VkCommandPool pool;
+    VkCommandBuffer cmd;
+    VulkanRenderState *state;
+    bool renderPassActive;
+    // events created while re-recording, which the command buffer waits on
+    vector<VkEvent> events;
+    uint64_t lastUse;
+  };
+
+  static const size_t PartialCmdCacheSize = 32;
+
+  map<PartialCmdKey, CachedPartialCmd> m_PartialCmdCache;
+  uint64_t m_PartialCmdCacheTick;
+
+  void FreeCachedPartialCmd(CachedPartialCmd &cached);
+
+  // on replay, pipelines are created through a pipeline cache that is saved in the app folder,
+  // keyed by the capture and the driver, so re-opening the same capture is faster. This is the
+  // unwrapped handle, and is created on first use.
+  VkPipelineCache m_ReplayPipelineCache;
+  bool m_ReplayPipelineCacheInit;
+  size_t m_ReplayPipelineCacheLoadedSize;
+
+  string GetReplayPipelineCacheFilename();
+  VkPipelineCache GetReplayPipelineCache();
+  void SaveReplayPipelineCache();
+  void DestroyReplayPipelineCache();
+
+  // while loading, pipeline creation chunks are queued and the pipelines created in parallel on
+  // worker threads. The queue is flushed, in order, before any chunk that can refer to a pipeline.
+  struct PendingPipeline
+  {
+    VkDevice device;
+    VkPipelineCache cache;
+    ResourceId id;
+    bool compute;
+    VkGraphicsPipelineCreateInfo graphicsInfo;
+    VkComputePipelineCreateInfo computeInfo;
+    VkPipeline pipe;
+    VkResult ret;
+  };
+
+  static const size_t PendingPipelineBatchSize = 512;
+
+  bool m_DeferPipelineCreation;
+  vector<PendingPipeline> m_PendingPipelines;
+  int32_t m_NextPendingPipeline;
+
+  static void PendingPipelineWorker(void *ths);
+  void CreatePendingPipeline(PendingPipeline &pending);
+  void FinishPendingPipeline(PendingPipeline &pending);
+  void QueuePendingPipeline(const PendingPipeline &pending);
+  void FlushPendingPipelines();
 
   // There is only a state while currently partially replaying, it's
   // undefined/empty otherwise.
@@ -567,11 +686,56 @@ private:
   vector<VkResourceRecord *> m_CoherentMaps;
   Threading::CriticalSection m_CoherentMapsLock;
 
+  // serialises the pages of a write-watched coherent map written since it was last flushed
+  void FlushWatchedMap(VkResourceRecord *record);
+
+  // the ranges bound into each memory object. Entries for destroyed resources are only pruned
+  // lazily, see AddMemoryBinding. Locked against concurrent use
+  map<ResourceId, vector<MemoryBinding> > m_MemoryBindings;
+  Threading::CriticalSection m_MemoryBindingsLock;
+
+  void AddMemoryBinding(ResourceId mem, ResourceId resource, VkDeviceSize offset,
+                        VkDeviceSize size);
+  bool FindMemoryBinding(ResourceId mem, ResourceId resource, MemoryBinding &binding);
+  vector<MemoryBinding> GetMemoryBindings(ResourceId mem);
+
   // used both on capture and replay side to track image layouts. Only locked
   // in capture
   map<ResourceId, ImageLayouts> m_ImageLayouts;
   Threading::CriticalSection m_ImageLayoutsLock;
 
+  // records image barriers into a command buffer being recorded, only locking the image layouts if
+  // they're needed to resolve a VK_REMAINING_* range
+  void RecordCmdImageBarriers(VkResourceRecord *cmdRecord, uint32_t numBarriers,
+                              const VkImageMemoryBarrier *barriers);
+
+  // updates one tracked descriptor in a set record and moves the set's bind frame refs from the
+  // old contents to the new. descriptor points to a VkDescriptorImageInfo, VkDescriptorBufferInfo
+  // or VkBufferView, depending on type
+  void UpdateTrackedDescriptor(VkResourceRecord *record, DescriptorSetSlot &bind,
+                               VkDescriptorType type, FrameRefType ref, const void *descriptor);
+
+  // applies one serialised descriptor write on replay and updates m_DescriptorSetState to match
+  void ReplayDescriptorSetWrite(VkDevice device, const VkWriteDescriptorSet &writeDesc);
+
+  // samplers are often created by the thousand while loading. While idle their creation chunk
+  // isn't serialised straight away - the create info is kept along with a chunk ID reserved at
+  // creation, so that if a frame is captured the chunk is serialised in the same place it would
+  // have been. Locked against concurrent use
+  struct DeferredSampler
+  {
+    VkDevice device;
+    VkSampler sampler;
+    VkSamplerCreateInfo info;
+    int32_t chunkID;
+  };
+  map<ResourceId, DeferredSampler> m_DeferredSamplers;
+  Threading::CriticalSection m_DeferredSamplersLock;
+
+  void SerialiseDeferredSampler(const DeferredSampler &deferred);
+  // serialises the creation chunks of every deferred sampler, before a capture is written
+  void SerialiseDeferredSamplers();
+
   // find swapchain for an image
   map<RENDERDOC_WindowHandle, VkSwapchainKHR> m_SwapLookup;
   Threading::CriticalSection m_SwapLookupLock;
@@ -598,9 +762,17 @@ private:
   Serialiser *GetThreadSerialiser();
   Serialiser *GetMainSerialiser() { return m_pSerialiser; }
   void Serialise_CaptureScope(uint64_t offset);
+
+  // must be called whenever anything changes that would make re-recording
+  // a command buffer give different results, e.g. resource replacements.
+  // The device must be idle.
+  void FreePartialCmdCache();
+  // only frees cached command buffers that bind one of the given (live) pipelines
+  void FreePartialCmdCache(const vector<ResourceId> &pipelines);
   bool HasSuccessfulCapture();
   bool Serialise_BeginCaptureFrame(bool applyInitialState);
   void EndCaptureFrame(VkImage presentImage);
+  void AddFrameBoundary(VkImage presentImage);
 
   void FirstFrame(VkSwapchainKHR swap);
 
@@ -617,6 +789,26 @@ private:
   bool Serialise_SetShaderDebugPath(Serialiser *localSerialiser, VkDevice device,
                                     VkDebugMarkerObjectTagInfoEXT *pTagInfo);
 
+  // the copies made to read back initial contents are recorded into shared command buffers and
+  // only waited on once all resources are prepared, instead of flushing the queue per resource.
+  // The temporary objects used by the copies are destroyed once the batch is flushed.
+  struct InitStateBatch
+  {
+    VkCommandBuffer cmd;
+    uint32_t numResources;
+    VkDeviceSize tempBytes;
+
+    vector<VkBuffer> buffers;
+    vector<VkImage> images;
+    vector<VkDeviceMemory> mems;
+  } m_InitStateBatch;
+
+  VkCommandBuffer GetInitStateCmd();
+  void CloseInitStateCmd();
+  void EndInitStateResource(VkDeviceSize tempBytes);
+  void FlushInitStateBatch();
+  void PrepareInitialStateAhead();
+
   // replay
 
   bool Prepare_SparseInitialState(WrappedVkBuffer *buf);
@@ -697,6 +889,8 @@ public:
   VulkanReplay *GetReplay() { return &m_Replay; }
   // replay interface
   bool Prepare_InitialState(WrappedVkRes *res);
+  uint64_t PrepareAheadSize_InitialState(WrappedVkRes *res);
+  uint64_t GetSize_InitialState(WrappedVkRes *res);
   bool Serialise_InitialState(ResourceId resid, WrappedVkRes *res);
   void Create_InitialState(ResourceId id, WrappedVkRes *live, bool hasData);
   void Apply_InitialState(WrappedVkRes *live, VulkanResourceManager::InitialContentData initial);
@@ -742,6 +936,14 @@ public:
   VkSemaphore GetNextSemaphore();
   void SubmitSemaphores();
   void FlushQ();
+  // waits on the fence of the last SubmitCmds(), which covers everything submitted before it. This
+  // is enough for synchronous readbacks and doesn't idle the queue like FlushQ()
+  void WaitForSubmittedCmds();
+  // the next SubmitCmds() waits on sem before any of its commands, and destroys it once complete
+  void WaitSemaphoreOnNextSubmit(VkSemaphore sem)
+  {
+    m_InternalCmds.pendingwaitsems.push_back(sem);
+  }
 
   VulkanRenderState &GetRenderState() { return m_RenderState; }
   void SetDrawcallCB(VulkanDrawcallCallback *cb) { m_DrawcallCallback = cb; }
@@ -1459,6 +1661,21 @@ public:
   void vkTrimCommandPoolKHR(VkDevice device, VkCommandPool commandPool,
                             VkCommandPoolTrimFlagsKHR flags);
 
+  // VK_KHR_descriptor_update_template
+  IMPLEMENT_FUNCTION_SERIALISED(VkResult, vkCreateDescriptorUpdateTemplateKHR, VkDevice device,
+                                const VkDescriptorUpdateTemplateCreateInfoKHR *pCreateInfo,
+                                const VkAllocationCallbacks *pAllocator,
+                                VkDescriptorUpdateTemplateKHR *pDescriptorUpdateTemplate);
+
+  IMPLEMENT_FUNCTION_SERIALISED(void, vkDestroyDescriptorUpdateTemplateKHR, VkDevice device,
+                                VkDescriptorUpdateTemplateKHR descriptorUpdateTemplate,
+                                const VkAllocationCallbacks *pAllocator);
+
+  IMPLEMENT_FUNCTION_SERIALISED(void, vkUpdateDescriptorSetWithTemplateKHR, VkDevice device,
+                                VkDescriptorSet descriptorSet,
+                                VkDescriptorUpdateTemplateKHR descriptorUpdateTemplate,
+                                const void *pData);
+
   // VK_KHR_get_physical_device_properties2
   void vkGetPhysicalDeviceFeatures2KHR(VkPhysicalDevice physicalDevice,
                                        VkPhysicalDeviceFeatures2KHR *pFeatures);
@@ -32,10 +32,12 @@ void VulkanReplay::PreDeviceInitCounters()
 
 void VulkanReplay::PostDeviceInitCounters()
 {
+  m_CounterProviders.Init(eRENDERDOC_CounterAPI_Vulkan, (void *)Unwrap(m_pDriver->GetDev()));
 }
 
 void VulkanReplay::PreDeviceShutdownCounters()
 {
+  m_CounterProviders.Shutdown();
 }
 
 void VulkanReplay::PostDeviceShutdownCounters()
@@ -49,6 +51,7 @@ vector<GPUCounter> VulkanReplay::EnumerateCounters()
   VkPhysicalDeviceFeatures availableFeatures = m_pDriver->GetDeviceFeatures();
 
   ret.push_back(GPUCounter::EventGPUDuration);
+  ret.push_back(GPUCounter::EventGPUStart);
   if(availableFeatures.pipelineStatisticsQuery)
   {
     ret.push_back(GPUCounter::InputVerticesRead);
@@ -71,11 +74,17 @@ vector<GPUCounter> VulkanReplay::EnumerateCounters()
     ret.push_back(GPUCounter::CSInvocations);
   }
 
+  vector<GPUCounter> providerCounters = m_CounterProviders.EnumerateCounters();
+  ret.insert(ret.end(), providerCounters.begin(), providerCounters.end());
+
   return ret;
 }
 
 void VulkanReplay::DescribeCounter(GPUCounter counterID, CounterDescription &desc)
 {
+  if(m_CounterProviders.DescribeCounter(counterID, desc))
+    return;
+
   desc.counterID = counterID;
 
   switch(counterID)
@@ -88,6 +97,15 @@ void VulkanReplay::DescribeCounter(GPUCounter counterID, CounterDescription &des
       desc.resultType = CompType::Double;
       desc.unit = CounterUnit::Seconds;
       break;
+    case GPUCounter::EventGPUStart:
+      desc.name = "GPU Start";
+      desc.description =
+          "Time from the start of the first timed event in the frame to the start of this event "
+          "on the GPU, comparable between queues.";
+      desc.resultByteWidth = 8;
+      desc.resultType = CompType::Double;
+      desc.unit = CounterUnit::Seconds;
+      break;
     case GPUCounter::InputVerticesRead:
       desc.name = "Input Vertices Read";
       desc.description = "Number of vertices read by input assembler.";
@@ -202,14 +220,16 @@ struct VulkanGPUTimerCallback : public VulkanDrawcallCallback
                                   VK_QUERY_CONTROL_PRECISE_BIT);
     if(m_PipeStatsQueryPool != VK_NULL_HANDLE)
       ObjDisp(cmd)->CmdBeginQuery(Unwrap(cmd), m_PipeStatsQueryPool, (uint32_t)m_Results.size(), 0);
-    ObjDisp(cmd)->CmdWriteTimestamp(Unwrap(cmd), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                                    m_TimeStampQueryPool, (uint32_t)(m_Results.size() * 2 + 0));
+    if(m_TimeStampQueryPool != VK_NULL_HANDLE)
+      ObjDisp(cmd)->CmdWriteTimestamp(Unwrap(cmd), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                                      m_TimeStampQueryPool, (uint32_t)(m_Results.size() * 2 + 0));
   }
 
   bool PostDraw(uint32_t eid, VkCommandBuffer cmd)
   {
-    ObjDisp(cmd)->CmdWriteTimestamp(Unwrap(cmd), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-                                    m_TimeStampQueryPool, (uint32_t)(m_Results.size() * 2 + 1));
+    if(m_TimeStampQueryPool != VK_NULL_HANDLE)
+      ObjDisp(cmd)->CmdWriteTimestamp(Unwrap(cmd), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                                      m_TimeStampQueryPool, (uint32_t)(m_Results.size() * 2 + 1));
     if(m_OcclusionQueryPool != VK_NULL_HANDLE)
       ObjDisp(cmd)->CmdEndQuery(Unwrap(cmd), m_OcclusionQueryPool, (uint32_t)m_Results.size());
     if(m_PipeStatsQueryPool != VK_NULL_HANDLE)
@@ -245,14 +265,139 @@ struct VulkanGPUTimerCallback : public VulkanDrawcallCallback
   vector<pair<uint32_t, uint32_t> > m_AliasEvents;
 };
 
+struct VulkanCounterProviderCallback : public VulkanDrawcallCallback
+{
+  VulkanCounterProviderCallback(WrappedVulkan *vk, CounterProviders &providers)
+      : m_pDriver(vk), m_Providers(providers)
+  {
+    m_pDriver->SetDrawcallCB(this);
+  }
+  ~VulkanCounterProviderCallback() { m_pDriver->SetDrawcallCB(NULL); }
+  void PreDraw(uint32_t eid, VkCommandBuffer cmd)
+  {
+    m_Providers.BeginSample(eid, (void *)Unwrap(cmd));
+  }
+
+  bool PostDraw(uint32_t eid, VkCommandBuffer cmd)
+  {
+    m_Providers.EndSample(eid, (void *)Unwrap(cmd));
+    return false;
+  }
+
+  void PostRedraw(uint32_t eid, VkCommandBuffer cmd) {}
+  // we don't need to distinguish, call the Draw functions
+  void PreDispatch(uint32_t eid, VkCommandBuffer cmd) { PreDraw(eid, cmd); }
+  bool PostDispatch(uint32_t eid, VkCommandBuffer cmd) { return PostDraw(eid, cmd); }
+  void PostRedispatch(uint32_t eid, VkCommandBuffer cmd) { PostRedraw(eid, cmd); }
+  void PreMisc(uint32_t eid, DrawFlags flags, VkCommandBuffer cmd) { PreDraw(eid, cmd); }
+  bool PostMisc(uint32_t eid, DrawFlags flags, VkCommandBuffer cmd) { return PostDraw(eid, cmd); }
+  void PostRemisc(uint32_t eid, DrawFlags flags, VkCommandBuffer cmd) { PostRedraw(eid, cmd); }
+  bool RecordAllCmds() { return true; }
+  void AliasEvent(uint32_t primary, uint32_t alias)
+  {
+    m_AliasEvents.push_back(std::make_pair(primary, alias));
+  }
+
+  WrappedVulkan *m_pDriver;
+  CounterProviders &m_Providers;
+  vector<pair<uint32_t, uint32_t> > m_AliasEvents;
+};
+
+vector<CounterResult> VulkanReplay::FetchProviderCounters(const vector<GPUCounter> &counters)
+{
+  uint32_t maxEID = m_pDriver->GetMaxEID();
+
+  uint32_t numPasses = m_CounterProviders.BeginSession(counters);
+
+  vector<pair<uint32_t, uint32_t> > aliasEvents;
+
+  for(uint32_t pass = 0; pass < numPasses; pass++)
+  {
+    VulkanCounterProviderCallback cb(m_pDriver, m_CounterProviders);
+
+    m_CounterProviders.BeginPass(pass);
+    m_pDriver->ReplayLog(0, maxEID, eReplay_Full);
+    m_pDriver->SubmitCmds();
+    m_pDriver->FlushQ();
+    m_CounterProviders.EndPass(pass);
+
+    if(pass == 0)
+      aliasEvents = cb.m_AliasEvents;
+  }
+
+  vector<CounterResult> ret = m_CounterProviders.EndSession();
+
+  for(size_t i = 0; i < aliasEvents.size(); i++)
+  {
+    for(size_t c = 0; c < counters.size(); c++)
+    {
+      CounterResult search;
+      search.counterID = counters[c];
+      search.eventID = aliasEvents[i].first;
+
+      auto it = std::find(ret.begin(), ret.end(), search);
+      if(it == ret.end())
+        continue;
+
+      CounterResult aliased = *it;
+      aliased.eventID = aliasEvents[i].second;
+      ret.push_back(aliased);
+    }
+  }
+
+  return ret;
+}
+
 vector<CounterResult> VulkanReplay::FetchCounters(const vector<GPUCounter> &counters)
 {
+  vector<GPUCounter> apiCounters, providerCounters;
+  if(m_CounterProviders.SplitCounters(counters, apiCounters, providerCounters))
+  {
+    vector<CounterResult> ret;
+    if(!apiCounters.empty())
+      ret = FetchCounters(apiCounters);
+
+    vector<CounterResult> providerResults = FetchProviderCounters(providerCounters);
+    ret.insert(ret.end(), providerResults.begin(), providerResults.end());
+
+    std::sort(ret.begin(), ret.end());
+
+    return ret;
+  }
+
   uint32_t maxEID = m_pDriver->GetMaxEID();
 
   VkPhysicalDeviceFeatures availableFeatures = m_pDriver->GetDeviceFeatures();
 
   VkDevice dev = m_pDriver->GetDev();
 
+  // all of the query types can be active at once, so every requested counter is gathered in a
+  // single replay. Only create the pools that the requested counters need though, as each query
+  // adds work around every event.
+  bool needTimestamps = false, needOcclusion = false, needPipeStats = false;
+
+  for(size_t c = 0; c < counters.size(); c++)
+  {
+    switch(counters[c])
+    {
+      case GPUCounter::EventGPUDuration:
+      case GPUCounter::EventGPUStart: needTimestamps = true; break;
+      case GPUCounter::SamplesWritten: needOcclusion = true; break;
+      case GPUCounter::InputVerticesRead:
+      case GPUCounter::IAPrimitives:
+      case GPUCounter::GSPrimitives:
+      case GPUCounter::RasterizerInvocations:
+      case GPUCounter::RasterizedPrimitives:
+      case GPUCounter::VSInvocations:
+      case GPUCounter::TCSInvocations:
+      case GPUCounter::TESInvocations:
+      case GPUCounter::GSInvocations:
+      case GPUCounter::PSInvocations:
+      case GPUCounter::CSInvocations: needPipeStats = true; break;
+      default: break;
+    }
+  }
+
   VkQueryPoolCreateInfo timeStampPoolCreateInfo = {
       VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO, NULL, 0, VK_QUERY_TYPE_TIMESTAMP, maxEID * 2, 0};
 
@@ -276,20 +421,24 @@ vector<CounterResult> VulkanReplay::FetchCounters(const vector<GPUCounter> &coun
       VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO, NULL,   0,
       VK_QUERY_TYPE_PIPELINE_STATISTICS,        maxEID, pipeStatsFlags};
 
-  VkQueryPool timeStampPool;
-  VkResult vkr =
-      ObjDisp(dev)->CreateQueryPool(Unwrap(dev), &timeStampPoolCreateInfo, NULL, &timeStampPool);
-  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  VkResult vkr = VK_SUCCESS;
+
+  VkQueryPool timeStampPool = VK_NULL_HANDLE;
+  if(needTimestamps)
+  {
+    vkr = ObjDisp(dev)->CreateQueryPool(Unwrap(dev), &timeStampPoolCreateInfo, NULL, &timeStampPool);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  }
 
   VkQueryPool occlusionPool = VK_NULL_HANDLE;
-  if(availableFeatures.occlusionQueryPrecise)
+  if(needOcclusion && availableFeatures.occlusionQueryPrecise)
   {
     vkr = ObjDisp(dev)->CreateQueryPool(Unwrap(dev), &occlusionPoolCreateInfo, NULL, &occlusionPool);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
   }
 
   VkQueryPool pipeStatsPool = VK_NULL_HANDLE;
-  if(availableFeatures.pipelineStatisticsQuery)
+  if(needPipeStats && availableFeatures.pipelineStatisticsQuery)
   {
     vkr = ObjDisp(dev)->CreateQueryPool(Unwrap(dev), &pipeStatsPoolCreateInfo, NULL, &pipeStatsPool);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
@@ -303,7 +452,8 @@ vector<CounterResult> VulkanReplay::FetchCounters(const vector<GPUCounter> &coun
   vkr = ObjDisp(dev)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-  ObjDisp(dev)->CmdResetQueryPool(Unwrap(cmd), timeStampPool, 0, maxEID * 2);
+  if(timeStampPool != VK_NULL_HANDLE)
+    ObjDisp(dev)->CmdResetQueryPool(Unwrap(cmd), timeStampPool, 0, maxEID * 2);
   if(occlusionPool != VK_NULL_HANDLE)
     ObjDisp(dev)->CmdResetQueryPool(Unwrap(cmd), occlusionPool, 0, maxEID);
   if(pipeStatsPool != VK_NULL_HANDLE)
@@ -323,14 +473,17 @@ vector<CounterResult> VulkanReplay::FetchCounters(const vector<GPUCounter> &coun
 
   vector<uint64_t> m_TimeStampData;
   m_TimeStampData.resize(cb.m_Results.size() * 2);
+  if(timeStampPool != VK_NULL_HANDLE && !m_TimeStampData.empty())
+  {
+    vkr = ObjDisp(dev)->GetQueryPoolResults(
+        Unwrap(dev), timeStampPool, 0, (uint32_t)m_TimeStampData.size(),
+        sizeof(uint64_t) * m_TimeStampData.size(), &m_TimeStampData[0], sizeof(uint64_t),
+        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  }
 
-  vkr = ObjDisp(dev)->GetQueryPoolResults(
-      Unwrap(dev), timeStampPool, 0, (uint32_t)m_TimeStampData.size(),
-      sizeof(uint64_t) * m_TimeStampData.size(), &m_TimeStampData[0], sizeof(uint64_t),
-      VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
-  RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-  ObjDisp(dev)->DestroyQueryPool(Unwrap(dev), timeStampPool, NULL);
+  if(timeStampPool != VK_NULL_HANDLE)
+    ObjDisp(dev)->DestroyQueryPool(Unwrap(dev), timeStampPool, NULL);
 
   vector<uint64_t> m_OcclusionData;
   m_OcclusionData.resize(cb.m_Results.size());
@@ -358,6 +511,15 @@ vector<CounterResult> VulkanReplay::FetchCounters(const vector<GPUCounter> &coun
     ObjDisp(dev)->DestroyQueryPool(Unwrap(dev), pipeStatsPool, NULL);
   }
 
+  // timestamps from every queue on the device come from the same clock, so starts are relative to
+  // the earliest one whichever queue it was on
+  uint64_t firstTimeStamp = 0;
+  for(size_t i = 0; timeStampPool != VK_NULL_HANDLE && i < cb.m_Results.size(); i++)
+  {
+    if(i == 0 || m_TimeStampData[i * 2 + 0] < firstTimeStamp)
+      firstTimeStamp = m_TimeStampData[i * 2 + 0];
+  }
+
   vector<CounterResult> ret;
 
   for(size_t i = 0; i < cb.m_Results.size(); i++)
@@ -379,6 +541,14 @@ vector<CounterResult> VulkanReplay::FetchCounters(const vector<GPUCounter> &coun
                            / (1000.0 * 1000.0 * 1000.0);    // to seconds
         }
         break;
+        case GPUCounter::EventGPUStart:
+        {
+          uint64_t delta = m_TimeStampData[i * 2 + 0] - firstTimeStamp;
+          result.value.d = (double(m_pDriver->GetDeviceProps().limits.timestampPeriod) *
+                            double(delta))                  // nanoseconds
+                           / (1000.0 * 1000.0 * 1000.0);    // to seconds
+        }
+        break;
         case GPUCounter::InputVerticesRead: result.value.u64 = m_PipeStatsData[i * 11 + 0]; break;
         case GPUCounter::IAPrimitives: result.value.u64 = m_PipeStatsData[i * 11 + 1]; break;
         case GPUCounter::GSPrimitives: result.value.u64 = m_PipeStatsData[i * 11 + 4]; break;
@@ -393,7 +563,7 @@ vector<CounterResult> VulkanReplay::FetchCounters(const vector<GPUCounter> &coun
         case GPUCounter::TCSInvocations: result.value.u64 = m_PipeStatsData[i * 11 + 8]; break;
         case GPUCounter::TESInvocations: result.value.u64 = m_PipeStatsData[i * 11 + 9]; break;
         case GPUCounter::GSInvocations: result.value.u64 = m_PipeStatsData[i * 11 + 3]; break;
-        case GPUCounter::PSInvocations: result.value.u64 = m_PipeStatsData[i * 11 + 9]; break;
+        case GPUCounter::PSInvocations: result.value.u64 = m_PipeStatsData[i * 11 + 7]; break;
         case GPUCounter::CSInvocations: result.value.u64 = m_PipeStatsData[i * 11 + 10]; break;
         default: break;
       }
@@ -26,7 +26,6 @@
 #include <float.h>
 #include "3rdparty/glslang/SPIRV/spirv.hpp"
 #include "3rdparty/stb/stb_truetype.h"
-#include "common/shader_cache.h"
 #include "data/glsl_shaders.h"
 #include "driver/shaders/spirv/spirv_common.h"
 #include "maths/camera.h"
@@ -40,6 +39,9 @@
 
 const VkDeviceSize STAGE_BUFFER_BYTE_SIZE = 16 * 1024 * 1024ULL;
 
+// how many initial state compressions can be recorded before the batch must be flushed
+const uint32_t InitStateCompressMaxSets = 64;
+
 void VulkanDebugManager::GPUBuffer::Create(WrappedVulkan *driver, VkDevice dev, VkDeviceSize size,
                                            uint32_t ringSize, uint32_t flags)
 {
@@ -170,12 +172,8 @@ struct VulkanBlobShaderCallbacks
   byte *GetData(vector<uint32_t> *blob) const { return (byte *)&(*blob)[0]; }
 } ShaderCacheCallbacks;
 
-string VulkanDebugManager::GetSPIRVBlob(SPIRVShaderStage shadType,
-                                        const std::vector<std::string> &sources,
-                                        vector<uint32_t> **outBlob)
+static uint32_t GetSPIRVHash(SPIRVShaderStage shadType, const std::vector<std::string> &sources)
 {
-  RDCASSERT(sources.size() > 0);
-
   uint32_t hash = strhash(sources[0].c_str());
   for(size_t i = 1; i < sources.size(); i++)
     hash = strhash(sources[i].c_str(), hash);
@@ -184,11 +182,51 @@ string VulkanDebugManager::GetSPIRVBlob(SPIRVShaderStage shadType,
   typestr[0] += (char)shadType;
   hash = strhash(typestr, hash);
 
-  if(m_ShaderCache.find(hash) != m_ShaderCache.end())
+  return hash;
+}
+
+void VulkanDebugManager::PrecompileSPIRVBlobs(vector<SPIRVCompileJob> &jobs)
+{
+  vector<SPIRVCompileJob> uncached;
+
+  for(size_t i = 0; i < jobs.size(); i++)
   {
-    *outBlob = m_ShaderCache[hash];
-    return "";
+    vector<uint32_t> *blob = NULL;
+    if(!m_ShaderCache.Find(GetSPIRVHash(jobs[i].stage, jobs[i].sources), blob,
+                           ShaderCacheCallbacks))
+      uncached.push_back(jobs[i]);
+  }
+
+  if(uncached.empty())
+    return;
+
+  RDCDEBUG("Compiling %u uncached shaders", (uint32_t)uncached.size());
+
+  CompileSPIRVBatch(uncached);
+
+  // any that failed are left out, GetSPIRVBlob will compile them again and report the errors
+  for(size_t i = 0; i < uncached.size(); i++)
+  {
+    if(!uncached[i].errors.empty() || uncached[i].spirv.empty())
+      continue;
+
+    vector<uint32_t> *spirv = new vector<uint32_t>();
+    spirv->swap(uncached[i].spirv);
+
+    m_ShaderCache.Insert(GetSPIRVHash(uncached[i].stage, uncached[i].sources), spirv);
   }
+}
+
+string VulkanDebugManager::GetSPIRVBlob(SPIRVShaderStage shadType,
+                                        const std::vector<std::string> &sources,
+                                        vector<uint32_t> **outBlob)
+{
+  RDCASSERT(sources.size() > 0);
+
+  uint32_t hash = GetSPIRVHash(shadType, sources);
+
+  if(m_ShaderCache.Find(hash, *outBlob, ShaderCacheCallbacks))
+    return "";
 
   vector<uint32_t> *spirv = new vector<uint32_t>();
   string errors = CompileSPIRV(shadType, sources, *spirv);
@@ -210,13 +248,28 @@ string VulkanDebugManager::GetSPIRVBlob(SPIRVShaderStage shadType,
 
   if(m_CacheShaders)
   {
-    m_ShaderCache[hash] = spirv;
-    m_ShaderCacheDirty = true;
+    m_ShaderCache.Insert(hash, spirv);
   }
 
   return errors;
 }
 
+string VulkanDebugManager::GetUserSPIRVBlob(SPIRVShaderStage shadType, const string &source,
+                                            vector<uint32_t> **outBlob)
+{
+  vector<string> sources;
+  sources.push_back(source);
+
+  bool cacheShaders = m_CacheShaders;
+  m_CacheShaders = true;
+
+  string errors = GetSPIRVBlob(shadType, sources, outBlob);
+
+  m_CacheShaders = cacheShaders;
+
+  return errors;
+}
+
 VulkanDebugManager::VulkanDebugManager(WrappedVulkan *driver, VkDevice dev)
 {
   m_pDriver = driver;
@@ -234,6 +287,8 @@ VulkanDebugManager::VulkanDebugManager(WrappedVulkan *driver, VkDevice dev)
   m_LinearSampler = VK_NULL_HANDLE;
   m_PointSampler = VK_NULL_HANDLE;
 
+  m_ReadbackWindowData = NULL;
+
   m_CheckerboardDescSetLayout = VK_NULL_HANDLE;
   m_CheckerboardPipeLayout = VK_NULL_HANDLE;
   m_CheckerboardDescSet = VK_NULL_HANDLE;
@@ -277,6 +332,12 @@ VulkanDebugManager::VulkanDebugManager(WrappedVulkan *driver, VkDevice dev)
   m_Array2MSPipe = VK_NULL_HANDLE;
   m_MS2ArrayPipe = VK_NULL_HANDLE;
 
+  m_InitStateCompressDescSetLayout = VK_NULL_HANDLE;
+  m_InitStateCompressPipeLayout = VK_NULL_HANDLE;
+  m_InitStateCompressDescPool = VK_NULL_HANDLE;
+  m_InitStateCompressDescSetsUsed = 0;
+  m_InitStateCompressPipe = VK_NULL_HANDLE;
+
   m_TextDescSetLayout = VK_NULL_HANDLE;
   m_TextPipeLayout = VK_NULL_HANDLE;
   m_TextDescSet = VK_NULL_HANDLE;
@@ -295,6 +356,7 @@ VulkanDebugManager::VulkanDebugManager(WrappedVulkan *driver, VkDevice dev)
   m_OverlayNoDepthRP = VK_NULL_HANDLE;
   RDCEraseEl(m_OverlayDim);
   m_OverlayMemSize = 0;
+  m_OverlayPipelineEpoch = 0;
 
   m_QuadDescSetLayout = VK_NULL_HANDLE;
   m_QuadResolvePipeLayout = VK_NULL_HANDLE;
@@ -328,6 +390,9 @@ VulkanDebugManager::VulkanDebugManager(WrappedVulkan *driver, VkDevice dev)
   m_MeshFetchDescSetLayout = VK_NULL_HANDLE;
   m_MeshFetchDescSet = VK_NULL_HANDLE;
 
+  m_PostVSBatching = false;
+  m_PostVSBatchSize = 0;
+
   m_MeshPickDescSetLayout = VK_NULL_HANDLE;
   m_MeshPickDescSet = VK_NULL_HANDLE;
   m_MeshPickLayout = VK_NULL_HANDLE;
@@ -338,17 +403,23 @@ VulkanDebugManager::VulkanDebugManager(WrappedVulkan *driver, VkDevice dev)
 
   m_FixedColSPIRV = NULL;
 
+  m_MeshPipelineTick = 0;
+  m_MeshPipelineWarmThread = 0;
+
+  m_InternalPipelineCache = VK_NULL_HANDLE;
+  m_TexelFetchBrokenDriver = false;
+
   m_Device = dev;
 
   //////////////////////////////////////////////////////////////////////////////////////////////////
   // Do some work that's needed both during capture and during replay
 
   // Load shader cache, if present
-  bool success = LoadShaderCache("vkshaders.cache", m_ShaderCacheMagic, m_ShaderCacheVersion,
-                                 m_ShaderCache, ShaderCacheCallbacks);
+  m_ShaderCache.Open("vkshaders.cache", m_ShaderCacheMagic, m_ShaderCacheVersion);
 
-  // if we failed to load from the cache
-  m_ShaderCacheDirty = !success;
+  // during capture only a handful of text pipelines are made, so it's not worth it there
+  if(m_State < WRITING)
+    LoadInternalPipelineCache();
 
   VkResult vkr = VK_SUCCESS;
 
@@ -405,6 +476,9 @@ VulkanDebugManager::VulkanDebugManager(WrappedVulkan *driver, VkDevice dev)
       {
           VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 32,
       },
+      {
+          VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1,
+      },
       {
           VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 32,
       },
@@ -731,6 +805,8 @@ VulkanDebugManager::VulkanDebugManager(WrappedVulkan *driver, VkDevice dev)
         "version");
   }
 
+  m_TexelFetchBrokenDriver = texelFetchBrokenDriver;
+
   // needed in both replay and capture, create depth MS->array pipelines
   {
     {
@@ -903,7 +979,7 @@ VulkanDebugManager::VulkanDebugManager(WrappedVulkan *driver, VkDevice dev)
 
       pipeInfo.renderPass = rp;
 
-      vkr = m_pDriver->vkCreateGraphicsPipelines(dev, VK_NULL_HANDLE, 1, &pipeInfo, NULL,
+      vkr = m_pDriver->vkCreateGraphicsPipelines(dev, m_InternalPipelineCache, 1, &pipeInfo, NULL,
                                                  &m_DepthMS2ArrayPipe[f]);
       RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
@@ -923,7 +999,7 @@ VulkanDebugManager::VulkanDebugManager(WrappedVulkan *driver, VkDevice dev)
 
         pipeInfo.renderPass = rp;
 
-        vkr = m_pDriver->vkCreateGraphicsPipelines(dev, VK_NULL_HANDLE, 1, &pipeInfo, NULL,
+        vkr = m_pDriver->vkCreateGraphicsPipelines(dev, m_InternalPipelineCache, 1, &pipeInfo, NULL,
                                                    &m_DepthArray2MSPipe[f][s]);
         RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
@@ -1060,41 +1136,129 @@ VulkanDebugManager::VulkanDebugManager(WrappedVulkan *driver, VkDevice dev)
       compPipeInfo.stage.module = ms2arrayModule;
       compPipeInfo.layout = m_ArrayMSPipeLayout;
 
-      vkr = m_pDriver->vkCreateComputePipelines(dev, VK_NULL_HANDLE, 1, &compPipeInfo, NULL,
-                                                &m_MS2ArrayPipe);
+      vkr = m_pDriver->vkCreateComputePipelines(dev, m_InternalPipelineCache, 1, &compPipeInfo,
+                                                NULL, &m_MS2ArrayPipe);
       RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
       compPipeInfo.stage.module = array2msModule;
       compPipeInfo.layout = m_ArrayMSPipeLayout;
 
-      vkr = m_pDriver->vkCreateComputePipelines(dev, VK_NULL_HANDLE, 1, &compPipeInfo, NULL,
-                                                &m_Array2MSPipe);
+      vkr = m_pDriver->vkCreateComputePipelines(dev, m_InternalPipelineCache, 1, &compPipeInfo,
+                                                NULL, &m_Array2MSPipe);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    }
+
+    if(RenderDoc::Inst().GetCaptureOptions().CompressInitialContentsOnGPU)
+    {
+      VkDescriptorSetLayoutBinding layoutBinding[] = {
+          {
+              0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_ALL, NULL,
+          },
+          {
+              1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_ALL, NULL,
+          },
+      };
+
+      VkDescriptorSetLayoutCreateInfo descsetLayoutInfo = {
+          VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+          NULL,
+          0,
+          ARRAY_COUNT(layoutBinding),
+          &layoutBinding[0],
+      };
+
+      vkr = m_pDriver->vkCreateDescriptorSetLayout(dev, &descsetLayoutInfo, NULL,
+                                                   &m_InitStateCompressDescSetLayout);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+      pipeLayoutInfo.pSetLayouts = &m_InitStateCompressDescSetLayout;
+
+      VkPushConstantRange push = {VK_SHADER_STAGE_ALL, 0, sizeof(Vec4u)};
+
+      pipeLayoutInfo.pushConstantRangeCount = 1;
+      pipeLayoutInfo.pPushConstantRanges = &push;
+
+      vkr = m_pDriver->vkCreatePipelineLayout(dev, &pipeLayoutInfo, NULL,
+                                              &m_InitStateCompressPipeLayout);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+      pipeLayoutInfo.pushConstantRangeCount = 0;
+      pipeLayoutInfo.pPushConstantRanges = NULL;
+
+      // the sets are allocated and reset without wrapping, once per initial state batch
+      VkDescriptorPoolSize compressPoolTypes[] = {
+          {
+              VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2 * InitStateCompressMaxSets,
+          },
+      };
+
+      VkDescriptorPoolCreateInfo compressPoolInfo = {
+          VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+          NULL,
+          0,
+          InitStateCompressMaxSets,
+          ARRAY_COUNT(compressPoolTypes),
+          &compressPoolTypes[0],
+      };
+
+      vkr = m_pDriver->vkCreateDescriptorPool(dev, &compressPoolInfo, NULL,
+                                              &m_InitStateCompressDescPool);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+      GenerateGLSLShader(sources, eShaderVulkan, "",
+                         GetEmbeddedResource(glsl_initstate_compress_comp), 430, false);
+
+      vector<uint32_t> *spirv;
+
+      string err = GetSPIRVBlob(eSPIRVCompute, sources, &spirv);
+      RDCASSERT(err.empty() && spirv);
+
+      VkShaderModule compressModule = VK_NULL_HANDLE;
+
+      VkShaderModuleCreateInfo modinfo = {
+          VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+          NULL,
+          0,
+          spirv->size() * sizeof(uint32_t),
+          &(*spirv)[0],
+      };
+
+      vkr = m_pDriver->vkCreateShaderModule(dev, &modinfo, NULL, &compressModule);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+      compPipeInfo.stage.module = compressModule;
+      compPipeInfo.layout = m_InitStateCompressPipeLayout;
+
+      vkr = m_pDriver->vkCreateComputePipelines(dev, m_InternalPipelineCache, 1, &compPipeInfo,
+                                                NULL, &m_InitStateCompressPipe);
       RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+      m_pDriver->vkDestroyShaderModule(dev, compressModule, NULL);
     }
 
     ia.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 
     pipeInfo.layout = m_TextPipeLayout;
 
-    vkr = m_pDriver->vkCreateGraphicsPipelines(dev, VK_NULL_HANDLE, 1, &pipeInfo, NULL,
+    vkr = m_pDriver->vkCreateGraphicsPipelines(dev, m_InternalPipelineCache, 1, &pipeInfo, NULL,
                                                &m_TextPipeline[0]);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
     pipeInfo.renderPass = RGBA8LinearRP;
 
-    vkr = m_pDriver->vkCreateGraphicsPipelines(dev, VK_NULL_HANDLE, 1, &pipeInfo, NULL,
+    vkr = m_pDriver->vkCreateGraphicsPipelines(dev, m_InternalPipelineCache, 1, &pipeInfo, NULL,
                                                &m_TextPipeline[1]);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
     pipeInfo.renderPass = BGRA8sRGBRP;
 
-    vkr = m_pDriver->vkCreateGraphicsPipelines(dev, VK_NULL_HANDLE, 1, &pipeInfo, NULL,
+    vkr = m_pDriver->vkCreateGraphicsPipelines(dev, m_InternalPipelineCache, 1, &pipeInfo, NULL,
                                                &m_TextPipeline[2]);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
     pipeInfo.renderPass = BGRA8LinearRP;
 
-    vkr = m_pDriver->vkCreateGraphicsPipelines(dev, VK_NULL_HANDLE, 1, &pipeInfo, NULL,
+    vkr = m_pDriver->vkCreateGraphicsPipelines(dev, m_InternalPipelineCache, 1, &pipeInfo, NULL,
                                                &m_TextPipeline[3]);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
@@ -1379,8 +1543,9 @@ VulkanDebugManager::VulkanDebugManager(WrappedVulkan *driver, VkDevice dev)
   }
 
   {
+    // dynamic so that a batch of draws can each write to their own range of one buffer
     VkDescriptorSetLayoutBinding layoutBinding[] = {{
-        0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_ALL, NULL,
+        0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1, VK_SHADER_STAGE_ALL, NULL,
     }};
 
     VkDescriptorSetLayoutCreateInfo descsetLayoutInfo = {
@@ -1697,6 +1862,9 @@ VulkanDebugManager::VulkanDebugManager(WrappedVulkan *driver, VkDevice dev)
 
   m_ReadbackWindow.Create(driver, dev, STAGE_BUFFER_BYTE_SIZE, 1, GPUBuffer::eGPUBufferReadback);
 
+  // kept mapped for the lifetime of the device, every readback waits for the GPU before reading it
+  m_ReadbackWindowData = (byte *)m_ReadbackWindow.Map();
+
   m_OutlineUBO.Create(driver, dev, 128, 10, 0);
   RDCCOMPILE_ASSERT(sizeof(OutlineUBOData) <= 128, "outline UBO size");
 
@@ -1753,14 +1921,19 @@ VulkanDebugManager::VulkanDebugManager(WrappedVulkan *driver, VkDevice dev)
 
   m_CacheShaders = true;
 
+  vector<SPIRVCompileJob> precompile;
+
   {
     GenerateGLSLShader(sources, eShaderVulkan, "", GetEmbeddedResource(glsl_fixedcol_frag), 430,
                        false);
 
-    string err = GetSPIRVBlob(eSPIRVFragment, sources, &m_FixedColSPIRV);
-    RDCASSERT(err.empty() && m_FixedColSPIRV);
+    precompile.push_back(SPIRVCompileJob());
+    precompile.back().stage = eSPIRVFragment;
+    precompile.back().sources = sources;
   }
 
+  vector<string> moduleSources[NUM_SHADERS];
+
   for(size_t i = 0; i < ARRAY_COUNT(module); i++)
   {
     // these modules will be compiled later
@@ -1771,9 +1944,29 @@ VulkanDebugManager::VulkanDebugManager(WrappedVulkan *driver, VkDevice dev)
     if(texelFetchBrokenDriver)
       defines += "#define NO_TEXEL_FETCH\n";
 
-    GenerateGLSLShader(sources, eShaderVulkan, defines, shaderSources[i], 430, i != QUADWRITEFS);
+    GenerateGLSLShader(moduleSources[i], eShaderVulkan, defines, shaderSources[i], 430,
+                       i != QUADWRITEFS);
+
+    precompile.push_back(SPIRVCompileJob());
+    precompile.back().stage = shaderStages[i];
+    precompile.back().sources = moduleSources[i];
+  }
+
+  // compile anything that isn't in the shader cache yet in parallel, so that the lookups below
+  // only hit the cache
+  PrecompileSPIRVBlobs(precompile);
+
+  {
+    string err = GetSPIRVBlob(eSPIRVFragment, precompile[0].sources, &m_FixedColSPIRV);
+    RDCASSERT(err.empty() && m_FixedColSPIRV);
+  }
+
+  for(size_t i = 0; i < ARRAY_COUNT(module); i++)
+  {
+    if(i == HISTOGRAMCS || i == MINMAXTILECS || i == MINMAXRESULTCS)
+      continue;
 
-    string err = GetSPIRVBlob(shaderStages[i], sources, &shaderSPIRV[i]);
+    string err = GetSPIRVBlob(shaderStages[i], moduleSources[i], &shaderSPIRV[i]);
     RDCASSERT(err.empty() && shaderSPIRV[i]);
 
     VkShaderModuleCreateInfo modinfo = {
@@ -1803,14 +1996,14 @@ VulkanDebugManager::VulkanDebugManager(WrappedVulkan *driver, VkDevice dev)
   stages[0].module = module[BLITVS];
   stages[1].module = module[CHECKERBOARDFS];
 
-  vkr = m_pDriver->vkCreateGraphicsPipelines(dev, VK_NULL_HANDLE, 1, &pipeInfo, NULL,
+  vkr = m_pDriver->vkCreateGraphicsPipelines(dev, m_InternalPipelineCache, 1, &pipeInfo, NULL,
                                              &m_CheckerboardPipeline);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
   msaa.rasterizationSamples = VULKAN_MESH_VIEW_SAMPLES;
   pipeInfo.renderPass = RGBA8MSRP;
 
-  vkr = m_pDriver->vkCreateGraphicsPipelines(dev, VK_NULL_HANDLE, 1, &pipeInfo, NULL,
+  vkr = m_pDriver->vkCreateGraphicsPipelines(dev, m_InternalPipelineCache, 1, &pipeInfo, NULL,
                                              &m_CheckerboardMSAAPipeline);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
@@ -1822,13 +2015,13 @@ VulkanDebugManager::VulkanDebugManager(WrappedVulkan *driver, VkDevice dev)
 
   pipeInfo.layout = m_TexDisplayPipeLayout;
 
-  vkr = m_pDriver->vkCreateGraphicsPipelines(dev, VK_NULL_HANDLE, 1, &pipeInfo, NULL,
+  vkr = m_pDriver->vkCreateGraphicsPipelines(dev, m_InternalPipelineCache, 1, &pipeInfo, NULL,
                                              &m_TexDisplayPipeline);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
   pipeInfo.renderPass = RGBA32RP;
 
-  vkr = m_pDriver->vkCreateGraphicsPipelines(dev, VK_NULL_HANDLE, 1, &pipeInfo, NULL,
+  vkr = m_pDriver->vkCreateGraphicsPipelines(dev, m_InternalPipelineCache, 1, &pipeInfo, NULL,
                                              &m_TexDisplayF32Pipeline);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
@@ -1838,7 +2031,7 @@ VulkanDebugManager::VulkanDebugManager(WrappedVulkan *driver, VkDevice dev)
   attState.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
   attState.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
 
-  vkr = m_pDriver->vkCreateGraphicsPipelines(dev, VK_NULL_HANDLE, 1, &pipeInfo, NULL,
+  vkr = m_pDriver->vkCreateGraphicsPipelines(dev, m_InternalPipelineCache, 1, &pipeInfo, NULL,
                                              &m_TexDisplayBlendPipeline);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
@@ -1860,7 +2053,7 @@ VulkanDebugManager::VulkanDebugManager(WrappedVulkan *driver, VkDevice dev)
 
     msaa.rasterizationSamples = VkSampleCountFlagBits(1 << i);
 
-    vkr = m_pDriver->vkCreateGraphicsPipelines(dev, VK_NULL_HANDLE, 1, &pipeInfo, NULL,
+    vkr = m_pDriver->vkCreateGraphicsPipelines(dev, m_InternalPipelineCache, 1, &pipeInfo, NULL,
                                                &m_OutlinePipeline[i]);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
   }
@@ -1881,104 +2074,18 @@ VulkanDebugManager::VulkanDebugManager(WrappedVulkan *driver, VkDevice dev)
 
     msaa.rasterizationSamples = VkSampleCountFlagBits(1 << i);
 
-    vkr = m_pDriver->vkCreateGraphicsPipelines(dev, VK_NULL_HANDLE, 1, &pipeInfo, NULL,
+    vkr = m_pDriver->vkCreateGraphicsPipelines(dev, m_InternalPipelineCache, 1, &pipeInfo, NULL,
                                                &m_QuadResolvePipeline[i]);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
   }
 
   msaa.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
 
-  compPipeInfo.layout = m_HistogramPipeLayout;
-
-  for(size_t t = eTexType_1D; t < eTexType_Max; t++)
-  {
-    for(size_t f = 0; f < 3; f++)
-    {
-      VkShaderModule minmaxtile = VK_NULL_HANDLE;
-      VkShaderModule minmaxresult = VK_NULL_HANDLE;
-      VkShaderModule histogram = VK_NULL_HANDLE;
-      string err;
-      vector<uint32_t> *blob = NULL;
-      VkShaderModuleCreateInfo modinfo = {
-          VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO, NULL, 0, 0, NULL,
-      };
-
-      string defines = "";
-      if(texelFetchBrokenDriver)
-        defines += "#define NO_TEXEL_FETCH\n";
-      defines += string("#define SHADER_RESTYPE ") + ToStr::Get(t) + "\n";
-      defines += string("#define UINT_TEX ") + (f == 1 ? "1" : "0") + "\n";
-      defines += string("#define SINT_TEX ") + (f == 2 ? "1" : "0") + "\n";
-
-      GenerateGLSLShader(sources, eShaderVulkan, defines, shaderSources[HISTOGRAMCS], 430);
-
-      err = GetSPIRVBlob(eSPIRVCompute, sources, &blob);
-      RDCASSERT(err.empty() && blob);
-
-      modinfo.codeSize = blob->size() * sizeof(uint32_t);
-      modinfo.pCode = &(*blob)[0];
-
-      vkr = m_pDriver->vkCreateShaderModule(dev, &modinfo, NULL, &histogram);
-      RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-      GenerateGLSLShader(sources, eShaderVulkan, defines, shaderSources[MINMAXTILECS], 430);
-
-      err = GetSPIRVBlob(eSPIRVCompute, sources, &blob);
-      RDCASSERT(err.empty() && blob);
-
-      modinfo.codeSize = blob->size() * sizeof(uint32_t);
-      modinfo.pCode = &(*blob)[0];
-
-      vkr = m_pDriver->vkCreateShaderModule(dev, &modinfo, NULL, &minmaxtile);
-      RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-      if(t == 1)
-      {
-        GenerateGLSLShader(sources, eShaderVulkan, defines, shaderSources[MINMAXRESULTCS], 430);
-
-        err = GetSPIRVBlob(eSPIRVCompute, sources, &blob);
-        RDCASSERT(err.empty() && blob);
-
-        modinfo.codeSize = blob->size() * sizeof(uint32_t);
-        modinfo.pCode = &(*blob)[0];
-
-        vkr = m_pDriver->vkCreateShaderModule(dev, &modinfo, NULL, &minmaxresult);
-        RDCASSERTEQUAL(vkr, VK_SUCCESS);
-      }
-
-      compPipeInfo.stage.module = minmaxtile;
-
-      vkr = m_pDriver->vkCreateComputePipelines(dev, VK_NULL_HANDLE, 1, &compPipeInfo, NULL,
-                                                &m_MinMaxTilePipe[t][f]);
-      RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-      compPipeInfo.stage.module = histogram;
-
-      vkr = m_pDriver->vkCreateComputePipelines(dev, VK_NULL_HANDLE, 1, &compPipeInfo, NULL,
-                                                &m_HistogramPipe[t][f]);
-      RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-      if(t == 1)
-      {
-        compPipeInfo.stage.module = minmaxresult;
-
-        vkr = m_pDriver->vkCreateComputePipelines(dev, VK_NULL_HANDLE, 1, &compPipeInfo, NULL,
-                                                  &m_MinMaxResultPipe[f]);
-        RDCASSERTEQUAL(vkr, VK_SUCCESS);
-      }
-
-      m_pDriver->vkDestroyShaderModule(dev, histogram, NULL);
-      m_pDriver->vkDestroyShaderModule(dev, minmaxtile, NULL);
-      if(t == 1)
-        m_pDriver->vkDestroyShaderModule(dev, minmaxresult, NULL);
-    }
-  }
-
   {
     compPipeInfo.stage.module = module[MESHCS];
     compPipeInfo.layout = m_MeshPickLayout;
 
-    vkr = m_pDriver->vkCreateComputePipelines(dev, VK_NULL_HANDLE, 1, &compPipeInfo, NULL,
+    vkr = m_pDriver->vkCreateComputePipelines(dev, m_InternalPipelineCache, 1, &compPipeInfo, NULL,
                                               &m_MeshPickPipeline);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
   }
@@ -1989,14 +2096,14 @@ VulkanDebugManager::VulkanDebugManager(WrappedVulkan *driver, VkDevice dev)
     compPipeInfo.stage.module = module[MS2ARRAYCS];
     compPipeInfo.layout = m_ArrayMSPipeLayout;
 
-    vkr = m_pDriver->vkCreateComputePipelines(dev, VK_NULL_HANDLE, 1, &compPipeInfo, NULL,
+    vkr = m_pDriver->vkCreateComputePipelines(dev, m_InternalPipelineCache, 1, &compPipeInfo, NULL,
                                               &m_MS2ArrayPipe);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
     compPipeInfo.stage.module = module[ARRAY2MSCS];
     compPipeInfo.layout = m_ArrayMSPipeLayout;
 
-    vkr = m_pDriver->vkCreateComputePipelines(dev, VK_NULL_HANDLE, 1, &compPipeInfo, NULL,
+    vkr = m_pDriver->vkCreateComputePipelines(dev, m_InternalPipelineCache, 1, &compPipeInfo, NULL,
                                               &m_Array2MSPipe);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
   }
@@ -2439,94 +2546,279 @@ VulkanDebugManager::VulkanDebugManager(WrappedVulkan *driver, VkDevice dev)
 
   ObjDisp(dev)->UpdateDescriptorSets(Unwrap(dev), ARRAY_COUNT(analysisSetWrites), analysisSetWrites,
                                      0, NULL);
+
+  m_MeshPipelineWarmThread =
+      Threading::CreateThread(&VulkanDebugManager::WarmMeshDisplayPipelines, this);
 }
 
-VulkanDebugManager::~VulkanDebugManager()
+static string GetInternalPipelineCacheFilename(const VkPhysicalDeviceProperties &props)
 {
-  VkDevice dev = m_Device;
+  return FileIO::GetAppFolderFilename(StringFormat::Fmt(
+      "vkinternalpipes_%04x_%04x_%08x.bin", props.vendorID, props.deviceID, props.driverVersion));
+}
 
-  if(m_ShaderCacheDirty)
-  {
-    SaveShaderCache("vkshaders.cache", m_ShaderCacheMagic, m_ShaderCacheVersion, m_ShaderCache,
-                    ShaderCacheCallbacks);
-  }
-  else
+void VulkanDebugManager::LoadInternalPipelineCache()
+{
+  if(RenderDoc::Inst().GetConfigSetting("replay.pipelineCache") == "0")
+    return;
+
+  string filename = GetInternalPipelineCacheFilename(m_pDriver->GetDeviceProps());
+
+  vector<byte> data;
+
+  FILE *f = FileIO::fopen(filename.c_str(), "rb");
+
+  if(f)
   {
-    for(auto it = m_ShaderCache.begin(); it != m_ShaderCache.end(); ++it)
-      ShaderCacheCallbacks.Destroy(it->second);
+    FileIO::fseek64(f, 0, SEEK_END);
+    data.resize((size_t)FileIO::ftell64(f));
+    FileIO::fseek64(f, 0, SEEK_SET);
+
+    if(data.empty() || FileIO::fread(&data[0], 1, data.size(), f) != data.size())
+      data.clear();
+
+    FileIO::fclose(f);
   }
 
-  for(auto it = m_PostVSData.begin(); it != m_PostVSData.end(); ++it)
+  // the driver validates the header and ignores data that doesn't match it. This is created
+  // directly and wrapped, since the wrapped create discards initial data from the application.
+  VkPipelineCacheCreateInfo info = {
+      VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO, NULL, 0, data.size(),
+      data.empty() ? NULL : &data[0],
+  };
+
+  VkResult vkr = ObjDisp(m_Device)->CreatePipelineCache(Unwrap(m_Device), &info, NULL,
+                                                        &m_InternalPipelineCache);
+
+  if(vkr != VK_SUCCESS)
   {
-    m_pDriver->vkDestroyBuffer(dev, it->second.vsout.buf, NULL);
-    m_pDriver->vkDestroyBuffer(dev, it->second.vsout.idxBuf, NULL);
-    m_pDriver->vkFreeMemory(dev, it->second.vsout.bufmem, NULL);
-    m_pDriver->vkFreeMemory(dev, it->second.vsout.idxBufMem, NULL);
+    RDCWARN("Couldn't create internal pipeline cache, VkResult: 0x%08x", vkr);
+    m_InternalPipelineCache = VK_NULL_HANDLE;
+    return;
   }
 
-  m_PostVSData.clear();
+  GetResourceManager()->WrapResource(Unwrap(m_Device), m_InternalPipelineCache);
 
-  // since we don't have properly registered resources, releasing our descriptor
-  // pool here won't remove the descriptor sets, so we need to free our own
-  // tracking data (not the API objects) for descriptor sets.
+  RDCDEBUG("Loaded %llu bytes of internal pipeline cache", (uint64_t)data.size());
+}
 
-  for(auto it = m_CachedMeshPipelines.begin(); it != m_CachedMeshPipelines.end(); ++it)
-    for(uint32_t i = 0; i < MeshDisplayPipelines::ePipe_Count; i++)
-      m_pDriver->vkDestroyPipeline(dev, it->second.pipes[i], NULL);
+void VulkanDebugManager::SaveInternalPipelineCache()
+{
+  if(m_InternalPipelineCache == VK_NULL_HANDLE)
+    return;
 
-  for(size_t i = 0; i < ARRAY_COUNT(m_MeshModules); i++)
-    m_pDriver->vkDestroyShaderModule(dev, m_MeshModules[i], NULL);
+  size_t size = 0;
+  VkResult vkr = ObjDisp(m_Device)->GetPipelineCacheData(
+      Unwrap(m_Device), Unwrap(m_InternalPipelineCache), &size, NULL);
 
-  m_pDriver->vkDestroyShaderModule(dev, m_TriSizeGSModule, NULL);
-  m_pDriver->vkDestroyShaderModule(dev, m_TriSizeFSModule, NULL);
+  if(vkr != VK_SUCCESS || size == 0)
+    return;
 
-  m_pDriver->vkDestroyDescriptorPool(dev, m_DescriptorPool, NULL);
+  vector<byte> data(size);
+  vkr = ObjDisp(m_Device)->GetPipelineCacheData(Unwrap(m_Device), Unwrap(m_InternalPipelineCache),
+                                                &size, &data[0]);
 
-  m_pDriver->vkDestroySampler(dev, m_LinearSampler, NULL);
-  m_pDriver->vkDestroySampler(dev, m_PointSampler, NULL);
+  if(vkr != VK_SUCCESS)
+    return;
 
-  m_pDriver->vkDestroyDescriptorSetLayout(dev, m_CheckerboardDescSetLayout, NULL);
-  m_pDriver->vkDestroyPipelineLayout(dev, m_CheckerboardPipeLayout, NULL);
-  m_pDriver->vkDestroyPipeline(dev, m_CheckerboardPipeline, NULL);
-  m_pDriver->vkDestroyPipeline(dev, m_CheckerboardMSAAPipeline, NULL);
+  string filename = GetInternalPipelineCacheFilename(m_pDriver->GetDeviceProps());
 
-  m_pDriver->vkDestroyDescriptorSetLayout(dev, m_TexDisplayDescSetLayout, NULL);
-  m_pDriver->vkDestroyPipelineLayout(dev, m_TexDisplayPipeLayout, NULL);
-  m_pDriver->vkDestroyPipeline(dev, m_TexDisplayPipeline, NULL);
-  m_pDriver->vkDestroyPipeline(dev, m_TexDisplayBlendPipeline, NULL);
-  m_pDriver->vkDestroyPipeline(dev, m_TexDisplayF32Pipeline, NULL);
+  FILE *f = FileIO::fopen(filename.c_str(), "wb");
 
-  for(size_t i = 0; i < ARRAY_COUNT(m_TexDisplayDummyImages); i++)
+  if(!f)
   {
-    m_pDriver->vkDestroyImageView(dev, m_TexDisplayDummyImageViews[i], NULL);
-    m_pDriver->vkDestroyImage(dev, m_TexDisplayDummyImages[i], NULL);
+    RDCWARN("Couldn't open internal pipeline cache '%s' for write", filename.c_str());
+    return;
   }
 
-  m_pDriver->vkFreeMemory(dev, m_TexDisplayDummyMemory, NULL);
+  FileIO::fwrite(&data[0], 1, size, f);
+  FileIO::fclose(f);
+}
 
-  m_pDriver->vkDestroyRenderPass(dev, m_CustomTexRP, NULL);
-  m_pDriver->vkDestroyFramebuffer(dev, m_CustomTexFB, NULL);
-  m_pDriver->vkDestroyImage(dev, m_CustomTexImg, NULL);
-  for(size_t i = 0; i < ARRAY_COUNT(m_CustomTexImgView); i++)
-    m_pDriver->vkDestroyImageView(dev, m_CustomTexImgView[i], NULL);
-  m_pDriver->vkFreeMemory(dev, m_CustomTexMem, NULL);
-  m_pDriver->vkDestroyPipeline(dev, m_CustomTexPipeline, NULL);
+void VulkanDebugManager::CreateHistogramPipelines(uint32_t textype, uint32_t intTypeIndex)
+{
+  if(textype < eTexType_1D || textype >= eTexType_Max || intTypeIndex >= 3)
+    return;
 
-  m_CheckerboardUBO.Destroy();
-  m_TexDisplayUBO.Destroy();
+  if(m_HistogramPipe[textype][intTypeIndex] != VK_NULL_HANDLE)
+    return;
 
-  m_PickPixelReadbackBuffer.Destroy();
+  VkDevice dev = m_Device;
+  VkResult vkr = VK_SUCCESS;
 
-  m_pDriver->vkDestroyFramebuffer(dev, m_PickPixelFB, NULL);
-  m_pDriver->vkDestroyRenderPass(dev, m_PickPixelRP, NULL);
-  m_pDriver->vkDestroyImageView(dev, m_PickPixelImageView, NULL);
-  m_pDriver->vkDestroyImage(dev, m_PickPixelImage, NULL);
-  m_pDriver->vkFreeMemory(dev, m_PickPixelImageMem, NULL);
+  VkComputePipelineCreateInfo compPipeInfo = {
+      VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+      NULL,
+      0,
+      {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO, NULL, 0, VK_SHADER_STAGE_COMPUTE_BIT,
+       VK_NULL_HANDLE, "main", NULL},
+      m_HistogramPipeLayout,
+      VK_NULL_HANDLE,
+      0,    // base pipeline VkPipeline
+  };
 
-  m_pDriver->vkDestroyDescriptorSetLayout(dev, m_ArrayMSDescSetLayout, NULL);
-  m_pDriver->vkDestroyPipelineLayout(dev, m_ArrayMSPipeLayout, NULL);
-  m_pDriver->vkDestroyPipeline(dev, m_Array2MSPipe, NULL);
-  m_pDriver->vkDestroyPipeline(dev, m_MS2ArrayPipe, NULL);
+  string shaderSources[] = {
+      GetEmbeddedResource(glsl_histogram_comp), GetEmbeddedResource(glsl_minmaxtile_comp),
+      GetEmbeddedResource(glsl_minmaxresult_comp),
+  };
+
+  VkPipeline *pipes[] = {
+      &m_HistogramPipe[textype][intTypeIndex], &m_MinMaxTilePipe[textype][intTypeIndex],
+      &m_MinMaxResultPipe[intTypeIndex],
+  };
+
+  // keep the shaders in the on-disk cache, so they're only compiled the first time
+  bool cacheShaders = m_CacheShaders;
+  m_CacheShaders = true;
+
+  for(size_t i = 0; i < ARRAY_COUNT(pipes); i++)
+  {
+    if(*pipes[i] != VK_NULL_HANDLE)
+      continue;
+
+    // the result pass doesn't read the texture, so it's shared by all texture types
+    uint32_t restype = (i == 2) ? (uint32_t)eTexType_1D : textype;
+
+    string defines = "";
+    if(m_TexelFetchBrokenDriver)
+      defines += "#define NO_TEXEL_FETCH\n";
+    defines += string("#define SHADER_RESTYPE ") + ToStr::Get(restype) + "\n";
+    defines += string("#define UINT_TEX ") + (intTypeIndex == 1 ? "1" : "0") + "\n";
+    defines += string("#define SINT_TEX ") + (intTypeIndex == 2 ? "1" : "0") + "\n";
+
+    vector<string> sources;
+    GenerateGLSLShader(sources, eShaderVulkan, defines, shaderSources[i], 430);
+
+    vector<uint32_t> *blob = NULL;
+    string err = GetSPIRVBlob(eSPIRVCompute, sources, &blob);
+    RDCASSERT(err.empty() && blob);
+
+    if(blob == NULL)
+      continue;
+
+    VkShaderModuleCreateInfo modinfo = {
+        VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO, NULL, 0, blob->size() * sizeof(uint32_t),
+        &(*blob)[0],
+    };
+
+    VkShaderModule module = VK_NULL_HANDLE;
+    vkr = m_pDriver->vkCreateShaderModule(dev, &modinfo, NULL, &module);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+    compPipeInfo.stage.module = module;
+
+    vkr = m_pDriver->vkCreateComputePipelines(dev, m_InternalPipelineCache, 1, &compPipeInfo, NULL,
+                                              pipes[i]);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+    m_pDriver->vkDestroyShaderModule(dev, module, NULL);
+  }
+
+  m_CacheShaders = cacheShaders;
+}
+
+VulkanDebugManager::~VulkanDebugManager()
+{
+  VkDevice dev = m_Device;
+
+  if(m_MeshPipelineWarmThread)
+  {
+    Threading::JoinThread(m_MeshPipelineWarmThread);
+    Threading::CloseThread(m_MeshPipelineWarmThread);
+    m_MeshPipelineWarmThread = 0;
+  }
+
+  SaveInternalPipelineCache();
+  m_pDriver->vkDestroyPipelineCache(dev, m_InternalPipelineCache, NULL);
+
+  m_ShaderCache.Close(ShaderCacheCallbacks);
+
+  for(auto it = m_PostVSData.begin(); it != m_PostVSData.end(); ++it)
+  {
+    // buffers shared by a batch are destroyed below
+    if(it->second.vsout.bufmem != VK_NULL_HANDLE)
+      m_pDriver->vkDestroyBuffer(dev, it->second.vsout.buf, NULL);
+    m_pDriver->vkDestroyBuffer(dev, it->second.vsout.idxBuf, NULL);
+    m_pDriver->vkFreeMemory(dev, it->second.vsout.bufmem, NULL);
+    m_pDriver->vkFreeMemory(dev, it->second.vsout.idxBufMem, NULL);
+  }
+
+  m_PostVSData.clear();
+
+  for(auto it = m_PostVSBatchBuffers.begin(); it != m_PostVSBatchBuffers.end(); ++it)
+  {
+    m_pDriver->vkDestroyBuffer(dev, it->first, NULL);
+    m_pDriver->vkFreeMemory(dev, it->second.first, NULL);
+  }
+
+  m_PostVSBatchBuffers.clear();
+
+  // since we don't have properly registered resources, releasing our descriptor
+  // pool here won't remove the descriptor sets, so we need to free our own
+  // tracking data (not the API objects) for descriptor sets.
+
+  for(auto it = m_CachedMeshPipelines.begin(); it != m_CachedMeshPipelines.end(); ++it)
+    for(uint32_t i = 0; i < MeshDisplayPipelines::ePipe_Count; i++)
+      m_pDriver->vkDestroyPipeline(dev, it->second.pipes[i], NULL);
+
+  for(size_t i = 0; i < ARRAY_COUNT(m_MeshModules); i++)
+    m_pDriver->vkDestroyShaderModule(dev, m_MeshModules[i], NULL);
+
+  m_pDriver->vkDestroyShaderModule(dev, m_TriSizeGSModule, NULL);
+  m_pDriver->vkDestroyShaderModule(dev, m_TriSizeFSModule, NULL);
+
+  m_pDriver->vkDestroyDescriptorPool(dev, m_DescriptorPool, NULL);
+
+  m_pDriver->vkDestroySampler(dev, m_LinearSampler, NULL);
+  m_pDriver->vkDestroySampler(dev, m_PointSampler, NULL);
+
+  m_pDriver->vkDestroyDescriptorSetLayout(dev, m_CheckerboardDescSetLayout, NULL);
+  m_pDriver->vkDestroyPipelineLayout(dev, m_CheckerboardPipeLayout, NULL);
+  m_pDriver->vkDestroyPipeline(dev, m_CheckerboardPipeline, NULL);
+  m_pDriver->vkDestroyPipeline(dev, m_CheckerboardMSAAPipeline, NULL);
+
+  m_pDriver->vkDestroyDescriptorSetLayout(dev, m_TexDisplayDescSetLayout, NULL);
+  m_pDriver->vkDestroyPipelineLayout(dev, m_TexDisplayPipeLayout, NULL);
+  m_pDriver->vkDestroyPipeline(dev, m_TexDisplayPipeline, NULL);
+  m_pDriver->vkDestroyPipeline(dev, m_TexDisplayBlendPipeline, NULL);
+  m_pDriver->vkDestroyPipeline(dev, m_TexDisplayF32Pipeline, NULL);
+
+  for(size_t i = 0; i < ARRAY_COUNT(m_TexDisplayDummyImages); i++)
+  {
+    m_pDriver->vkDestroyImageView(dev, m_TexDisplayDummyImageViews[i], NULL);
+    m_pDriver->vkDestroyImage(dev, m_TexDisplayDummyImages[i], NULL);
+  }
+
+  m_pDriver->vkFreeMemory(dev, m_TexDisplayDummyMemory, NULL);
+
+  m_pDriver->vkDestroyRenderPass(dev, m_CustomTexRP, NULL);
+  m_pDriver->vkDestroyFramebuffer(dev, m_CustomTexFB, NULL);
+  m_pDriver->vkDestroyImage(dev, m_CustomTexImg, NULL);
+  for(size_t i = 0; i < ARRAY_COUNT(m_CustomTexImgView); i++)
+    m_pDriver->vkDestroyImageView(dev, m_CustomTexImgView[i], NULL);
+  m_pDriver->vkFreeMemory(dev, m_CustomTexMem, NULL);
+  m_pDriver->vkDestroyPipeline(dev, m_CustomTexPipeline, NULL);
+
+  m_CheckerboardUBO.Destroy();
+  m_TexDisplayUBO.Destroy();
+
+  m_PickPixelReadbackBuffer.Destroy();
+
+  m_pDriver->vkDestroyFramebuffer(dev, m_PickPixelFB, NULL);
+  m_pDriver->vkDestroyRenderPass(dev, m_PickPixelRP, NULL);
+  m_pDriver->vkDestroyImageView(dev, m_PickPixelImageView, NULL);
+  m_pDriver->vkDestroyImage(dev, m_PickPixelImage, NULL);
+  m_pDriver->vkFreeMemory(dev, m_PickPixelImageMem, NULL);
+
+  m_pDriver->vkDestroyDescriptorSetLayout(dev, m_ArrayMSDescSetLayout, NULL);
+  m_pDriver->vkDestroyPipelineLayout(dev, m_ArrayMSPipeLayout, NULL);
+  m_pDriver->vkDestroyPipeline(dev, m_Array2MSPipe, NULL);
+  m_pDriver->vkDestroyPipeline(dev, m_MS2ArrayPipe, NULL);
+
+  m_pDriver->vkDestroyDescriptorSetLayout(dev, m_InitStateCompressDescSetLayout, NULL);
+  m_pDriver->vkDestroyPipelineLayout(dev, m_InitStateCompressPipeLayout, NULL);
+  m_pDriver->vkDestroyDescriptorPool(dev, m_InitStateCompressDescPool, NULL);
+  m_pDriver->vkDestroyPipeline(dev, m_InitStateCompressPipe, NULL);
 
   for(size_t i = 0; i < ARRAY_COUNT(m_DepthMS2ArrayPipe); i++)
     m_pDriver->vkDestroyPipeline(dev, m_DepthMS2ArrayPipe[i], NULL);
@@ -2577,6 +2869,8 @@ VulkanDebugManager::~VulkanDebugManager()
     }
   }
 
+  if(m_ReadbackWindowData)
+    m_ReadbackWindow.Unmap();
   m_ReadbackWindow.Destroy();
 
   m_MinMaxTileResult.Destroy();
@@ -2601,6 +2895,13 @@ VulkanDebugManager::~VulkanDebugManager()
   m_pDriver->vkDestroyPipeline(dev, m_MeshPickPipeline, NULL);
 
   m_pDriver->vkDestroyDescriptorSetLayout(dev, m_MeshFetchDescSetLayout, NULL);
+
+  FreeOverlayPipelineCache();
+
+  for(size_t i = 0; i < m_FixedColShaders.size(); i++)
+    m_pDriver->vkDestroyShaderModule(dev, m_FixedColShaders[i].module, NULL);
+  m_FixedColShaders.clear();
+
   m_pDriver->vkDestroyFramebuffer(dev, m_OverlayNoDepthFB, NULL);
   m_pDriver->vkDestroyRenderPass(dev, m_OverlayNoDepthRP, NULL);
   m_pDriver->vkDestroyImageView(dev, m_OverlayImageView, NULL);
@@ -2717,89 +3018,88 @@ void VulkanDebugManager::RenderTextInternal(const TextPrintState &textstate, flo
   ObjDisp(textstate.cmd)->CmdDraw(Unwrap(textstate.cmd), 6 * (uint32_t)strlen(text), 1, 0, 0);
 }
 
-void VulkanDebugManager::ReplaceResource(ResourceId from, ResourceId to)
+void VulkanDebugManager::ReplaceResource(ResourceId from, ResourceId to,
+                                         vector<ResourceId> &pipelines)
 {
   VkDevice dev = m_pDriver->GetDev();
 
+  m_MeshPickCache.Invalidate();
+
   // we're passed in the original ID but we want the live ID for comparison
   ResourceId liveid = GetResourceManager()->GetLiveID(from);
 
   VkShaderModule srcShaderModule = GetResourceManager()->GetCurrentHandle<VkShaderModule>(liveid);
   VkShaderModule dstShaderModule = GetResourceManager()->GetCurrentHandle<VkShaderModule>(to);
 
-  // remake and replace any pipelines that referenced this shader
-  for(auto it = m_pDriver->m_CreationInfo.m_Pipeline.begin();
-      it != m_pDriver->m_CreationInfo.m_Pipeline.end(); ++it)
+  pipelines = m_pDriver->m_CreationInfo.m_ShaderModulePipelines[liveid];
+
+  // remake and replace only the pipelines that referenced this shader
+  for(size_t p = 0; p < pipelines.size(); p++)
   {
-    bool refdShader = false;
-    for(size_t i = 0; i < ARRAY_COUNT(it->second.shaders); i++)
-    {
-      if(it->second.shaders[i].module == liveid)
-      {
-        refdShader = true;
-        break;
-      }
-    }
+    ResourceId pipeid = pipelines[p];
 
-    if(refdShader)
+    VkPipeline pipe = VK_NULL_HANDLE;
+    const VulkanCreationInfo::Pipeline &pipeInfo = m_pDriver->m_CreationInfo.m_Pipeline[pipeid];
+    if(pipeInfo.renderpass != ResourceId())    // check if this is a graphics or compute pipeline
     {
-      VkPipeline pipe = VK_NULL_HANDLE;
-      const VulkanCreationInfo::Pipeline &pipeInfo = m_pDriver->m_CreationInfo.m_Pipeline[it->first];
-      if(pipeInfo.renderpass != ResourceId())    // check if this is a graphics or compute pipeline
-      {
-        VkGraphicsPipelineCreateInfo pipeCreateInfo;
-        MakeGraphicsPipelineInfo(pipeCreateInfo, it->first);
-
-        // replace the relevant module
-        for(uint32_t i = 0; i < pipeCreateInfo.stageCount; i++)
-        {
-          VkPipelineShaderStageCreateInfo &sh =
-              (VkPipelineShaderStageCreateInfo &)pipeCreateInfo.pStages[i];
+      VkGraphicsPipelineCreateInfo pipeCreateInfo;
+      MakeGraphicsPipelineInfo(pipeCreateInfo, pipeid);
 
-          if(sh.module == srcShaderModule)
-            sh.module = dstShaderModule;
-        }
+      // replace the relevant module
+      for(uint32_t i = 0; i < pipeCreateInfo.stageCount; i++)
+      {
+        VkPipelineShaderStageCreateInfo &sh =
+            (VkPipelineShaderStageCreateInfo &)pipeCreateInfo.pStages[i];
 
-        // create the new graphics pipeline
-        VkResult vkr = m_pDriver->vkCreateGraphicsPipelines(dev, VK_NULL_HANDLE, 1, &pipeCreateInfo,
-                                                            NULL, &pipe);
-        RDCASSERTEQUAL(vkr, VK_SUCCESS);
+        if(sh.module == srcShaderModule)
+          sh.module = dstShaderModule;
       }
-      else
-      {
-        VkComputePipelineCreateInfo pipeCreateInfo;
-        MakeComputePipelineInfo(pipeCreateInfo, it->first);
 
-        // replace the relevant module
-        VkPipelineShaderStageCreateInfo &sh = pipeCreateInfo.stage;
-        RDCASSERT(sh.module == srcShaderModule);
-        sh.module = dstShaderModule;
+      // create the new graphics pipeline
+      VkResult vkr = m_pDriver->vkCreateGraphicsPipelines(dev, m_InternalPipelineCache, 1,
+                                                          &pipeCreateInfo, NULL, &pipe);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    }
+    else
+    {
+      VkComputePipelineCreateInfo pipeCreateInfo;
+      MakeComputePipelineInfo(pipeCreateInfo, pipeid);
 
-        // create the new compute pipeline
-        VkResult vkr = m_pDriver->vkCreateComputePipelines(dev, VK_NULL_HANDLE, 1, &pipeCreateInfo,
-                                                           NULL, &pipe);
-        RDCASSERTEQUAL(vkr, VK_SUCCESS);
-      }
+      // replace the relevant module
+      VkPipelineShaderStageCreateInfo &sh = pipeCreateInfo.stage;
+      RDCASSERT(sh.module == srcShaderModule);
+      sh.module = dstShaderModule;
 
-      // remove the replacements
-      GetResourceManager()->ReplaceResource(it->first, GetResID(pipe));
-      GetResourceManager()->ReplaceResource(GetResourceManager()->GetOriginalID(it->first),
-                                            GetResID(pipe));
+      // create the new compute pipeline
+      VkResult vkr = m_pDriver->vkCreateComputePipelines(dev, m_InternalPipelineCache, 1,
+                                                         &pipeCreateInfo, NULL, &pipe);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
     }
+
+    // remove the replacements
+    GetResourceManager()->ReplaceResource(pipeid, GetResID(pipe));
+    GetResourceManager()->ReplaceResource(GetResourceManager()->GetOriginalID(pipeid),
+                                          GetResID(pipe));
   }
 
   // make the actual shader module replacements
   GetResourceManager()->ReplaceResource(from, to);
   GetResourceManager()->ReplaceResource(liveid, to);
+
+  FreeOverlayPipelines(pipelines);
 }
 
-void VulkanDebugManager::RemoveReplacement(ResourceId id)
+void VulkanDebugManager::RemoveReplacement(ResourceId id, vector<ResourceId> &pipelines)
 {
   VkDevice dev = m_pDriver->GetDev();
 
+  m_MeshPickCache.Invalidate();
+
   // we're passed in the original ID but we want the live ID for comparison
   ResourceId liveid = GetResourceManager()->GetLiveID(id);
 
+  pipelines.clear();
+
   if(!GetResourceManager()->HasReplacement(id))
     return;
 
@@ -2807,32 +3107,24 @@ void VulkanDebugManager::RemoveReplacement(ResourceId id)
   GetResourceManager()->RemoveReplacement(id);
   GetResourceManager()->RemoveReplacement(liveid);
 
+  pipelines = m_pDriver->m_CreationInfo.m_ShaderModulePipelines[liveid];
+
   // remove any replacements on pipelines that referenced this shader
-  for(auto it = m_pDriver->m_CreationInfo.m_Pipeline.begin();
-      it != m_pDriver->m_CreationInfo.m_Pipeline.end(); ++it)
+  for(size_t p = 0; p < pipelines.size(); p++)
   {
-    bool refdShader = false;
-    for(size_t i = 0; i < ARRAY_COUNT(it->second.shaders); i++)
-    {
-      if(it->second.shaders[i].module == liveid)
-      {
-        refdShader = true;
-        break;
-      }
-    }
+    ResourceId pipeid = pipelines[p];
 
-    if(refdShader)
-    {
-      VkPipeline pipe = GetResourceManager()->GetCurrentHandle<VkPipeline>(it->first);
+    VkPipeline pipe = GetResourceManager()->GetCurrentHandle<VkPipeline>(pipeid);
 
-      // delete the replacement pipeline
-      m_pDriver->vkDestroyPipeline(dev, pipe, NULL);
+    // delete the replacement pipeline
+    m_pDriver->vkDestroyPipeline(dev, pipe, NULL);
 
-      // remove both live and original replacements, since we will have made these above
-      GetResourceManager()->RemoveReplacement(it->first);
-      GetResourceManager()->RemoveReplacement(GetResourceManager()->GetOriginalID(it->first));
-    }
+    // remove both live and original replacements, since we will have made these above
+    GetResourceManager()->RemoveReplacement(pipeid);
+    GetResourceManager()->RemoveReplacement(GetResourceManager()->GetOriginalID(pipeid));
   }
+
+  FreeOverlayPipelines(pipelines);
 }
 
 void VulkanDebugManager::CreateCustomShaderTex(uint32_t width, uint32_t height, uint32_t mip)
@@ -3174,8 +3466,8 @@ void VulkanDebugManager::CreateCustomShaderPipeline(ResourceId shader)
       -1,                // base pipeline index
   };
 
-  VkResult vkr = m_pDriver->vkCreateGraphicsPipelines(dev, VK_NULL_HANDLE, 1, &pipeInfo, NULL,
-                                                      &m_CustomTexPipeline);
+  VkResult vkr = m_pDriver->vkCreateGraphicsPipelines(dev, m_InternalPipelineCache, 1, &pipeInfo,
+                                                      NULL, &m_CustomTexPipeline);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 }
 
@@ -3296,6 +3588,74 @@ void VulkanDebugManager::CopyTex2DMSToArray(VkImage destArray, VkImage srcMS, Vk
   ObjDisp(dev)->DestroyImageView(Unwrap(dev), destView, NULL);
 }
 
+bool VulkanDebugManager::CanCompressInitState()
+{
+  return m_InitStateCompressPipe != VK_NULL_HANDLE &&
+         m_InitStateCompressDescSetsUsed < InitStateCompressMaxSets;
+}
+
+void VulkanDebugManager::CompressInitState(VkCommandBuffer cmd, VkBuffer src, VkBuffer dst,
+                                           uint32_t numDwords, uint32_t numBlocks,
+                                           uint32_t dataOffset)
+{
+  VkDevice dev = m_Device;
+
+  VkDescriptorSetAllocateInfo allocInfo = {
+      VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO, NULL, Unwrap(m_InitStateCompressDescPool), 1,
+      UnwrapPtr(m_InitStateCompressDescSetLayout),
+  };
+
+  VkDescriptorSet descSet = VK_NULL_HANDLE;
+
+  VkResult vkr = ObjDisp(dev)->AllocateDescriptorSets(Unwrap(dev), &allocInfo, &descSet);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  m_InitStateCompressDescSetsUsed++;
+
+  VkDescriptorBufferInfo bufdesc[] = {
+      {src, 0, VK_WHOLE_SIZE}, {dst, 0, VK_WHOLE_SIZE},
+  };
+
+  VkWriteDescriptorSet writeSet[] = {
+      {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, NULL, descSet, 0, 0, 1,
+       VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, NULL, &bufdesc[0], NULL},
+      {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, NULL, descSet, 1, 0, 1,
+       VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, NULL, &bufdesc[1], NULL},
+  };
+
+  ObjDisp(dev)->UpdateDescriptorSets(Unwrap(dev), ARRAY_COUNT(writeSet), writeSet, 0, NULL);
+
+  // one workgroup per block, wrapping into rows to stay within the dispatch limits
+  uint32_t groupsX =
+      RDCMIN(numBlocks, m_pDriver->GetDeviceProps().limits.maxComputeWorkGroupCount[0]);
+  uint32_t groupsY = (numBlocks + groupsX - 1) / groupsX;
+
+  ObjDisp(cmd)->CmdBindPipeline(Unwrap(cmd), VK_PIPELINE_BIND_POINT_COMPUTE,
+                                Unwrap(m_InitStateCompressPipe));
+  ObjDisp(cmd)->CmdBindDescriptorSets(Unwrap(cmd), VK_PIPELINE_BIND_POINT_COMPUTE,
+                                      Unwrap(m_InitStateCompressPipeLayout), 0, 1, &descSet, 0,
+                                      NULL);
+
+  Vec4u params = {numDwords, numBlocks, dataOffset, groupsX};
+
+  ObjDisp(cmd)->CmdPushConstants(Unwrap(cmd), Unwrap(m_InitStateCompressPipeLayout),
+                                 VK_SHADER_STAGE_ALL, 0, sizeof(Vec4u), &params);
+
+  ObjDisp(cmd)->CmdDispatch(Unwrap(cmd), groupsX, groupsY, 1);
+}
+
+void VulkanDebugManager::ResetInitStateCompression()
+{
+  if(m_InitStateCompressDescSetsUsed == 0)
+    return;
+
+  VkDevice dev = m_Device;
+
+  ObjDisp(dev)->ResetDescriptorPool(Unwrap(dev), Unwrap(m_InitStateCompressDescPool), 0);
+
+  m_InitStateCompressDescSetsUsed = 0;
+}
+
 void VulkanDebugManager::CopyDepthTex2DMSToArray(VkImage destArray, VkImage srcMS, VkExtent3D extent,
                                                  uint32_t layers, uint32_t samples, VkFormat fmt)
 {
@@ -4013,9 +4373,13 @@ uint32_t VulkanDebugManager::PickVertex(uint32_t eventID, const MeshDisplay &cfg
 
   m_MeshPickUBO.Unmap();
 
+  // if we're picking in the same mesh as last time, its unpacked data is still in the pick buffers
+  // and only the dispatch itself needs to run again
+  bool upload = !m_MeshPickCache.Matches(eventID, cfg.position);
+
   vector<byte> idxs;
 
-  if(cfg.position.idxByteWidth && cfg.position.idxbuf != ResourceId())
+  if(upload && cfg.position.idxByteWidth && cfg.position.idxbuf != ResourceId())
     GetBufferData(cfg.position.idxbuf, cfg.position.idxoffs, 0, idxs);
 
   // We copy into our own buffers to promote to the target type (uint32) that the
@@ -4065,7 +4429,7 @@ uint32_t VulkanDebugManager::PickVertex(uint32_t eventID, const MeshDisplay &cfg
     m_MeshPickIBUpload.Unmap();
   }
 
-  if(m_MeshPickVBSize < cfg.position.numVerts * sizeof(FloatVector))
+  if(upload && m_MeshPickVBSize < cfg.position.numVerts * sizeof(FloatVector))
   {
     if(m_MeshPickVBSize > 0)
     {
@@ -4081,6 +4445,7 @@ uint32_t VulkanDebugManager::PickVertex(uint32_t eventID, const MeshDisplay &cfg
   }
 
   // unpack and linearise the data
+  if(upload)
   {
     vector<byte> oldData;
     GetBufferData(cfg.position.buf, cfg.position.offset, 0, oldData);
@@ -4127,9 +4492,10 @@ uint32_t VulkanDebugManager::PickVertex(uint32_t eventID, const MeshDisplay &cfg
        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, NULL, &ibInfo, NULL},
   };
 
+  // when the data is cached the descriptors still point at the same buffers
   if(!idxs.empty())
     vt->UpdateDescriptorSets(Unwrap(m_Device), 2, writes, 0, NULL);
-  else
+  else if(upload)
     vt->UpdateDescriptorSets(Unwrap(m_Device), 1, writes, 0, NULL);
 
   VkCommandBuffer cmd = m_pDriver->GetNextCmd();
@@ -4180,22 +4546,27 @@ uint32_t VulkanDebugManager::PickVertex(uint32_t eventID, const MeshDisplay &cfg
     DoPipelineBarrier(cmd, 1, &bufBarrier);
   }
 
-  // wait for writes
-  bufBarrier.buffer = Unwrap(m_MeshPickVBUpload.buf);
-  bufBarrier.srcAccessMask = VK_ACCESS_HOST_WRITE_BIT;
-  bufBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-  DoPipelineBarrier(cmd, 1, &bufBarrier);
+  if(upload)
+  {
+    // wait for writes
+    bufBarrier.buffer = Unwrap(m_MeshPickVBUpload.buf);
+    bufBarrier.srcAccessMask = VK_ACCESS_HOST_WRITE_BIT;
+    bufBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    DoPipelineBarrier(cmd, 1, &bufBarrier);
+
+    // do copy
+    bufCopy.size = m_MeshPickVBSize;
+    vt->CmdCopyBuffer(Unwrap(cmd), Unwrap(m_MeshPickVBUpload.buf), Unwrap(m_MeshPickVB.buf), 1,
+                      &bufCopy);
 
-  // do copy
-  bufCopy.size = m_MeshPickVBSize;
-  vt->CmdCopyBuffer(Unwrap(cmd), Unwrap(m_MeshPickVBUpload.buf), Unwrap(m_MeshPickVB.buf), 1,
-                    &bufCopy);
+    // wait for copy
+    bufBarrier.buffer = Unwrap(m_MeshPickVB.buf);
+    bufBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    bufBarrier.dstAccessMask = VK_ACCESS_UNIFORM_READ_BIT;
+    DoPipelineBarrier(cmd, 1, &bufBarrier);
 
-  // wait for copy
-  bufBarrier.buffer = Unwrap(m_MeshPickVB.buf);
-  bufBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-  bufBarrier.dstAccessMask = VK_ACCESS_UNIFORM_READ_BIT;
-  DoPipelineBarrier(cmd, 1, &bufBarrier);
+    m_MeshPickCache.Set(eventID, cfg.position);
+  }
 
   vt->CmdBindPipeline(Unwrap(cmd), VK_PIPELINE_BIND_POINT_COMPUTE, Unwrap(m_MeshPickPipeline));
   vt->CmdBindDescriptorSets(Unwrap(cmd), VK_PIPELINE_BIND_POINT_COMPUTE, Unwrap(m_MeshPickLayout),
@@ -4384,6 +4755,9 @@ void VulkanDebugManager::GetBufferData(ResourceId buff, uint64_t offset, uint64_
   {
     VkDeviceSize chunkSize = RDCMIN(sizeRemaining, STAGE_BUFFER_BYTE_SIZE);
 
+    // the previous command buffer is recycled once its chunk has been read
+    cmd = m_pDriver->GetNextCmd();
+
     vkr = vt->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
@@ -4403,23 +4777,23 @@ void VulkanDebugManager::GetBufferData(ResourceId buff, uint64_t offset, uint64_
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
     m_pDriver->SubmitCmds();
-    m_pDriver->FlushQ();
+    m_pDriver->WaitForSubmittedCmds();
 
-    byte *pData = NULL;
-    vkr = vt->MapMemory(Unwrap(dev), Unwrap(m_ReadbackWindow.mem), 0, VK_WHOLE_SIZE, 0,
-                        (void **)&pData);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-    RDCASSERT(pData != NULL);
-    memcpy(&ret[dstoffset], pData, (size_t)chunkSize);
+    memcpy(&ret[dstoffset], m_ReadbackWindowData, (size_t)chunkSize);
 
+    srcoffset += chunkSize;
     dstoffset += (size_t)chunkSize;
     sizeRemaining -= chunkSize;
-
-    vt->UnmapMemory(Unwrap(dev), Unwrap(m_ReadbackWindow.mem));
   }
+}
 
-  vt->DeviceWaitIdle(Unwrap(dev));
+byte *VulkanDebugManager::GetReadbackWindow(VkDeviceSize size, VkBuffer &buf)
+{
+  if(m_ReadbackWindowData == NULL || size > m_ReadbackWindow.sz)
+    return NULL;
+
+  buf = Unwrap(m_ReadbackWindow.buf);
+  return m_ReadbackWindowData;
 }
 
 void VulkanDebugManager::MakeGraphicsPipelineInfo(VkGraphicsPipelineCreateInfo &pipeCreateInfo,
@@ -4724,8 +5098,12 @@ void VulkanDebugManager::MakeComputePipelineInfo(VkComputePipelineCreateInfo &pi
   pipeCreateInfo = ret;
 }
 
-void VulkanDebugManager::PatchFixedColShader(VkShaderModule &mod, float col[4])
+VkShaderModule VulkanDebugManager::GetFixedColShader(const float col[4])
 {
+  for(size_t i = 0; i < m_FixedColShaders.size(); i++)
+    if(!memcmp(m_FixedColShaders[i].col, col, sizeof(float) * 4))
+      return m_FixedColShaders[i].module;
+
   union
   {
     uint32_t *spirv;
@@ -4768,8 +5146,85 @@ void VulkanDebugManager::PatchFixedColShader(VkShaderModule &mod, float col[4])
       alias.spirv,
   };
 
+  VkShaderModule mod = VK_NULL_HANDLE;
+
   VkResult vkr = m_pDriver->vkCreateShaderModule(m_Device, &modinfo, NULL, &mod);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  FixedColShader fixedCol;
+  memcpy(fixedCol.col, col, sizeof(float) * 4);
+  fixedCol.module = mod;
+  m_FixedColShaders.push_back(fixedCol);
+
+  return mod;
+}
+
+VulkanDebugManager::OverlayPipeline *VulkanDebugManager::FindOverlayPipeline(
+    const OverlayPipelineKey &key)
+{
+  auto it = m_OverlayPipelineCache.find(key);
+
+  if(it == m_OverlayPipelineCache.end())
+    return NULL;
+
+  it->second.lastUse = m_OverlayPipelineEpoch;
+
+  return &it->second;
+}
+
+void VulkanDebugManager::AddOverlayPipeline(const OverlayPipelineKey &key, OverlayPipeline pipe)
+{
+  if(m_OverlayPipelineCache.size() >= OverlayPipelineCacheSize)
+  {
+    auto lru = m_OverlayPipelineCache.end();
+    for(auto it = m_OverlayPipelineCache.begin(); it != m_OverlayPipelineCache.end(); ++it)
+      if(lru == m_OverlayPipelineCache.end() || it->second.lastUse < lru->second.lastUse)
+        lru = it;
+
+    // anything used by this overlay render could still be pending, so let the cache grow instead
+    if(lru != m_OverlayPipelineCache.end() && lru->second.lastUse < m_OverlayPipelineEpoch)
+    {
+      m_pDriver->vkDestroyPipeline(m_Device, lru->second.pipe, NULL);
+      if(lru->second.layout != VK_NULL_HANDLE)
+        m_pDriver->vkDestroyPipelineLayout(m_Device, lru->second.layout, NULL);
+
+      m_OverlayPipelineCache.erase(lru);
+    }
+  }
+
+  pipe.lastUse = m_OverlayPipelineEpoch;
+  m_OverlayPipelineCache[key] = pipe;
+}
+
+void VulkanDebugManager::FreeOverlayPipelines(const vector<ResourceId> &pipelines)
+{
+  for(auto it = m_OverlayPipelineCache.begin(); it != m_OverlayPipelineCache.end();)
+  {
+    if(std::find(pipelines.begin(), pipelines.end(), it->first.pipeline) != pipelines.end())
+    {
+      m_pDriver->vkDestroyPipeline(m_Device, it->second.pipe, NULL);
+      if(it->second.layout != VK_NULL_HANDLE)
+        m_pDriver->vkDestroyPipelineLayout(m_Device, it->second.layout, NULL);
+
+      it = m_OverlayPipelineCache.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+}
+
+void VulkanDebugManager::FreeOverlayPipelineCache()
+{
+  for(auto it = m_OverlayPipelineCache.begin(); it != m_OverlayPipelineCache.end(); ++it)
+  {
+    m_pDriver->vkDestroyPipeline(m_Device, it->second.pipe, NULL);
+    if(it->second.layout != VK_NULL_HANDLE)
+      m_pDriver->vkDestroyPipelineLayout(m_Device, it->second.layout, NULL);
+  }
+
+  m_OverlayPipelineCache.clear();
 }
 
 struct VulkanQuadOverdrawCallback : public VulkanDrawcallCallback
@@ -4794,11 +5249,21 @@ struct VulkanQuadOverdrawCallback : public VulkanDrawcallCallback
     m_PrevState = m_pDriver->GetRenderState();
     VulkanRenderState &pipestate = m_pDriver->GetRenderState();
 
+    // the same pipeline is used for both quad overdraw overlays
+    VulkanDebugManager::OverlayPipelineKey key;
+    key.pipeline = pipestate.graphics.pipeline;
+    key.overlay = DebugOverlay::QuadOverdrawPass;
+    key.pass = 0;
+    key.depthFormat = VK_FORMAT_UNDEFINED;
+
     // check cache first
-    pair<uint32_t, VkPipeline> pipe = m_PipelineCache[pipestate.graphics.pipeline];
+    VulkanDebugManager::OverlayPipeline pipe;
+    VulkanDebugManager::OverlayPipeline *cached = m_pDebug->FindOverlayPipeline(key);
+    if(cached)
+      pipe = *cached;
 
     // if we don't get a hit, create a modified pipeline
-    if(pipe.second == VK_NULL_HANDLE)
+    if(pipe.pipe == VK_NULL_HANDLE)
     {
       VulkanCreationInfo &c = *pipestate.m_CreationInfo;
 
@@ -4937,22 +5402,23 @@ struct VulkanQuadOverdrawCallback : public VulkanDrawcallCallback
       }
 
       vkr = m_pDriver->vkCreateGraphicsPipelines(dev, VK_NULL_HANDLE, 1, &pipeCreateInfo, NULL,
-                                                 &pipe.second);
+                                                 &pipe.pipe);
       RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
       ObjDisp(dev)->DestroyShaderModule(Unwrap(dev), Unwrap(module), NULL);
       m_pDriver->GetResourceManager()->ReleaseWrappedResource(module);
 
-      pipe.first = descSet;
+      pipe.layout = pipeLayout;
+      pipe.descSet = descSet;
 
-      m_PipelineCache[pipestate.graphics.pipeline] = pipe;
+      m_pDebug->AddOverlayPipeline(key, pipe);
     }
 
     // modify state for first draw call
-    pipestate.graphics.pipeline = GetResID(pipe.second);
-    RDCASSERT(pipestate.graphics.descSets.size() >= pipe.first);
-    pipestate.graphics.descSets.resize(pipe.first + 1);
-    pipestate.graphics.descSets[pipe.first].descSet = GetResID(m_pDebug->m_QuadDescSet);
+    pipestate.graphics.pipeline = GetResID(pipe.pipe);
+    RDCASSERT(pipestate.graphics.descSets.size() >= pipe.descSet);
+    pipestate.graphics.descSets.resize(pipe.descSet + 1);
+    pipestate.graphics.descSets[pipe.descSet].descSet = GetResID(m_pDebug->m_QuadDescSet);
 
     if(cmd)
       pipestate.BindPipeline(cmd);
@@ -4995,8 +5461,6 @@ struct VulkanQuadOverdrawCallback : public VulkanDrawcallCallback
   VulkanDebugManager *m_pDebug;
   const vector<uint32_t> &m_Events;
 
-  // cache modified pipelines
-  map<ResourceId, pair<uint32_t, VkPipeline> > m_PipelineCache;
   VulkanRenderState m_PrevState;
 };
 
@@ -5015,10 +5479,15 @@ ResourceId VulkanDebugManager::RenderOverlay(ResourceId texid, DebugOverlay over
   VkResult vkr = vt->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
+  m_OverlayPipelineEpoch++;
+
   // if the overlay image is the wrong size, free it
   if(m_OverlayImage != VK_NULL_HANDLE &&
      (iminfo.extent.width != m_OverlayDim.width || iminfo.extent.height != m_OverlayDim.height))
   {
+    // cached overlay pipelines were made against the old renderpass
+    FreeOverlayPipelineCache();
+
     m_pDriver->vkDestroyRenderPass(m_Device, m_OverlayNoDepthRP, NULL);
     m_pDriver->vkDestroyFramebuffer(m_Device, m_OverlayNoDepthFB, NULL);
     m_pDriver->vkDestroyImageView(m_Device, m_OverlayImageView, NULL);
@@ -5276,103 +5745,116 @@ ResourceId VulkanDebugManager::RenderOverlay(ResourceId texid, DebugOverlay over
     // backup state
     VulkanRenderState prevstate = m_pDriver->m_RenderState;
 
-    // make patched shader
-    VkShaderModule mod = VK_NULL_HANDLE;
+    vkr = vt->EndCommandBuffer(Unwrap(cmd));
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    PatchFixedColShader(mod, highlightCol);
+    OverlayPipelineKey key;
+    key.pipeline = prevstate.graphics.pipeline;
+    key.overlay = overlay;
+    key.pass = 0;
+    key.depthFormat = VK_FORMAT_UNDEFINED;
 
-    // make patched pipeline
-    VkGraphicsPipelineCreateInfo pipeCreateInfo;
+    OverlayPipeline *cached = FindOverlayPipeline(key);
 
-    MakeGraphicsPipelineInfo(pipeCreateInfo, prevstate.graphics.pipeline);
+    VkPipeline pipe = cached ? cached->pipe : VK_NULL_HANDLE;
 
-    // disable all tests possible
-    VkPipelineDepthStencilStateCreateInfo *ds =
-        (VkPipelineDepthStencilStateCreateInfo *)pipeCreateInfo.pDepthStencilState;
-    ds->depthTestEnable = false;
-    ds->depthWriteEnable = false;
-    ds->stencilTestEnable = false;
-    ds->depthBoundsTestEnable = false;
+    if(pipe == VK_NULL_HANDLE)
+    {
+      // make patched shader
+      VkShaderModule mod = GetFixedColShader(highlightCol);
 
-    VkPipelineRasterizationStateCreateInfo *rs =
-        (VkPipelineRasterizationStateCreateInfo *)pipeCreateInfo.pRasterizationState;
-    rs->cullMode = VK_CULL_MODE_NONE;
-    rs->rasterizerDiscardEnable = false;
+      // make patched pipeline
+      VkGraphicsPipelineCreateInfo pipeCreateInfo;
 
-    if(m_pDriver->GetDeviceFeatures().depthClamp)
-    {
-      rs->depthClampEnable = true;
-    }
+      MakeGraphicsPipelineInfo(pipeCreateInfo, prevstate.graphics.pipeline);
 
-    if(overlay == DebugOverlay::Wireframe && m_pDriver->GetDeviceFeatures().fillModeNonSolid)
-    {
-      rs->polygonMode = VK_POLYGON_MODE_LINE;
-      rs->lineWidth = 1.0f;
-    }
+      // disable all tests possible
+      VkPipelineDepthStencilStateCreateInfo *ds =
+          (VkPipelineDepthStencilStateCreateInfo *)pipeCreateInfo.pDepthStencilState;
+      ds->depthTestEnable = false;
+      ds->depthWriteEnable = false;
+      ds->stencilTestEnable = false;
+      ds->depthBoundsTestEnable = false;
 
-    VkPipelineColorBlendStateCreateInfo *cb =
-        (VkPipelineColorBlendStateCreateInfo *)pipeCreateInfo.pColorBlendState;
-    cb->logicOpEnable = false;
-    cb->attachmentCount = 1;    // only one colour attachment
-    for(uint32_t i = 0; i < cb->attachmentCount; i++)
-    {
-      VkPipelineColorBlendAttachmentState *att =
-          (VkPipelineColorBlendAttachmentState *)&cb->pAttachments[i];
-      att->blendEnable = false;
-      att->colorWriteMask = 0xf;
-    }
+      VkPipelineRasterizationStateCreateInfo *rs =
+          (VkPipelineRasterizationStateCreateInfo *)pipeCreateInfo.pRasterizationState;
+      rs->cullMode = VK_CULL_MODE_NONE;
+      rs->rasterizerDiscardEnable = false;
 
-    // set scissors to max
-    for(size_t i = 0; i < pipeCreateInfo.pViewportState->scissorCount; i++)
-    {
-      VkRect2D &sc = (VkRect2D &)pipeCreateInfo.pViewportState->pScissors[i];
-      sc.offset.x = 0;
-      sc.offset.y = 0;
-      sc.extent.width = 16384;
-      sc.extent.height = 16384;
-    }
+      if(m_pDriver->GetDeviceFeatures().depthClamp)
+      {
+        rs->depthClampEnable = true;
+      }
 
-    // set our renderpass and shader
-    pipeCreateInfo.renderPass = m_OverlayNoDepthRP;
-    pipeCreateInfo.subpass = 0;
+      if(overlay == DebugOverlay::Wireframe && m_pDriver->GetDeviceFeatures().fillModeNonSolid)
+      {
+        rs->polygonMode = VK_POLYGON_MODE_LINE;
+        rs->lineWidth = 1.0f;
+      }
 
-    bool found = false;
-    for(uint32_t i = 0; i < pipeCreateInfo.stageCount; i++)
-    {
-      VkPipelineShaderStageCreateInfo &sh =
-          (VkPipelineShaderStageCreateInfo &)pipeCreateInfo.pStages[i];
-      if(sh.stage == VK_SHADER_STAGE_FRAGMENT_BIT)
+      VkPipelineColorBlendStateCreateInfo *cb =
+          (VkPipelineColorBlendStateCreateInfo *)pipeCreateInfo.pColorBlendState;
+      cb->logicOpEnable = false;
+      cb->attachmentCount = 1;    // only one colour attachment
+      for(uint32_t i = 0; i < cb->attachmentCount; i++)
       {
-        sh.module = mod;
-        sh.pName = "main";
-        found = true;
-        break;
+        VkPipelineColorBlendAttachmentState *att =
+            (VkPipelineColorBlendAttachmentState *)&cb->pAttachments[i];
+        att->blendEnable = false;
+        att->colorWriteMask = 0xf;
       }
-    }
 
-    if(!found)
-    {
-      // we know this is safe because it's pointing to a static array that's
-      // big enough for all shaders
+      // set scissors to max
+      for(size_t i = 0; i < pipeCreateInfo.pViewportState->scissorCount; i++)
+      {
+        VkRect2D &sc = (VkRect2D &)pipeCreateInfo.pViewportState->pScissors[i];
+        sc.offset.x = 0;
+        sc.offset.y = 0;
+        sc.extent.width = 16384;
+        sc.extent.height = 16384;
+      }
 
-      VkPipelineShaderStageCreateInfo &sh =
-          (VkPipelineShaderStageCreateInfo &)pipeCreateInfo.pStages[pipeCreateInfo.stageCount++];
-      sh.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-      sh.pNext = NULL;
-      sh.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-      sh.module = mod;
-      sh.pName = "main";
-      sh.pSpecializationInfo = NULL;
-    }
+      // set our renderpass and shader
+      pipeCreateInfo.renderPass = m_OverlayNoDepthRP;
+      pipeCreateInfo.subpass = 0;
 
-    vkr = vt->EndCommandBuffer(Unwrap(cmd));
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+      bool found = false;
+      for(uint32_t i = 0; i < pipeCreateInfo.stageCount; i++)
+      {
+        VkPipelineShaderStageCreateInfo &sh =
+            (VkPipelineShaderStageCreateInfo &)pipeCreateInfo.pStages[i];
+        if(sh.stage == VK_SHADER_STAGE_FRAGMENT_BIT)
+        {
+          sh.module = mod;
+          sh.pName = "main";
+          found = true;
+          break;
+        }
+      }
 
-    VkPipeline pipe = VK_NULL_HANDLE;
+      if(!found)
+      {
+        // we know this is safe because it's pointing to a static array that's
+        // big enough for all shaders
 
-    vkr = m_pDriver->vkCreateGraphicsPipelines(m_Device, VK_NULL_HANDLE, 1, &pipeCreateInfo, NULL,
-                                               &pipe);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+        VkPipelineShaderStageCreateInfo &sh =
+            (VkPipelineShaderStageCreateInfo &)pipeCreateInfo.pStages[pipeCreateInfo.stageCount++];
+        sh.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        sh.pNext = NULL;
+        sh.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+        sh.module = mod;
+        sh.pName = "main";
+        sh.pSpecializationInfo = NULL;
+      }
+
+      vkr = m_pDriver->vkCreateGraphicsPipelines(m_Device, m_InternalPipelineCache, 1,
+                                                 &pipeCreateInfo, NULL, &pipe);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+      OverlayPipeline overlayPipe;
+      overlayPipe.pipe = pipe;
+      AddOverlayPipeline(key, overlayPipe);
+    }
 
     // modify state
     m_pDriver->m_RenderState.renderPass = GetResID(m_OverlayNoDepthRP);
@@ -5395,7 +5877,7 @@ ResourceId VulkanDebugManager::RenderOverlay(ResourceId texid, DebugOverlay over
 
     m_pDriver->ReplayLog(0, eventID, eReplay_OnlyDraw);
 
-    // submit & flush so that we don't have to keep pipeline around for a while
+    // submit & flush so that the cached pipelines aren't in use if they're evicted later
     m_pDriver->SubmitCmds();
     m_pDriver->FlushQ();
 
@@ -5406,9 +5888,6 @@ ResourceId VulkanDebugManager::RenderOverlay(ResourceId texid, DebugOverlay over
 
     // restore state
     m_pDriver->m_RenderState = prevstate;
-
-    m_pDriver->vkDestroyPipeline(m_Device, pipe, NULL);
-    m_pDriver->vkDestroyShaderModule(m_Device, mod, NULL);
   }
   else if(overlay == DebugOverlay::ViewportScissor)
   {
@@ -5557,112 +6036,143 @@ ResourceId VulkanDebugManager::RenderOverlay(ResourceId texid, DebugOverlay over
     // backup state
     VulkanRenderState prevstate = m_pDriver->m_RenderState;
 
-    // make patched shader
-    VkShaderModule mod[2] = {0};
-    VkPipeline pipe[2] = {0};
-
-    // first shader, no culling, writes red
-    PatchFixedColShader(mod[0], highlightCol);
-
-    highlightCol[0] = 0.0f;
-    highlightCol[1] = 1.0f;
-
-    // second shader, normal culling, writes green
-    PatchFixedColShader(mod[1], highlightCol);
+    vkr = vt->EndCommandBuffer(Unwrap(cmd));
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    // make patched pipeline
-    VkGraphicsPipelineCreateInfo pipeCreateInfo;
+    OverlayPipelineKey key[2];
+    VkPipeline pipe[2] = {VK_NULL_HANDLE, VK_NULL_HANDLE};
 
-    MakeGraphicsPipelineInfo(pipeCreateInfo, prevstate.graphics.pipeline);
-
-    // disable all tests possible
-    VkPipelineDepthStencilStateCreateInfo *ds =
-        (VkPipelineDepthStencilStateCreateInfo *)pipeCreateInfo.pDepthStencilState;
-    ds->depthTestEnable = false;
-    ds->depthWriteEnable = false;
-    ds->stencilTestEnable = false;
-    ds->depthBoundsTestEnable = false;
-
-    VkPipelineRasterizationStateCreateInfo *rs =
-        (VkPipelineRasterizationStateCreateInfo *)pipeCreateInfo.pRasterizationState;
-    VkCullModeFlags origCullMode = rs->cullMode;
-    rs->cullMode = VK_CULL_MODE_NONE;    // first render without any culling
-    rs->rasterizerDiscardEnable = false;
-
-    if(m_pDriver->GetDeviceFeatures().depthClamp)
-      rs->depthClampEnable = true;
-
-    VkPipelineColorBlendStateCreateInfo *cb =
-        (VkPipelineColorBlendStateCreateInfo *)pipeCreateInfo.pColorBlendState;
-    cb->logicOpEnable = false;
-    cb->attachmentCount = 1;    // only one colour attachment
-    for(uint32_t i = 0; i < cb->attachmentCount; i++)
+    for(uint32_t i = 0; i < 2; i++)
     {
-      VkPipelineColorBlendAttachmentState *att =
-          (VkPipelineColorBlendAttachmentState *)&cb->pAttachments[i];
-      att->blendEnable = false;
-      att->colorWriteMask = 0xf;
+      key[i].pipeline = prevstate.graphics.pipeline;
+      key[i].overlay = overlay;
+      key[i].pass = i;
+      key[i].depthFormat = VK_FORMAT_UNDEFINED;
+
+      OverlayPipeline *cached = FindOverlayPipeline(key[i]);
+      if(cached)
+        pipe[i] = cached->pipe;
     }
 
-    // set scissors to max
-    for(size_t i = 0; i < pipeCreateInfo.pViewportState->scissorCount; i++)
+    if(pipe[0] == VK_NULL_HANDLE || pipe[1] == VK_NULL_HANDLE)
     {
-      VkRect2D &sc = (VkRect2D &)pipeCreateInfo.pViewportState->pScissors[i];
-      sc.offset.x = 0;
-      sc.offset.y = 0;
-      sc.extent.width = 16384;
-      sc.extent.height = 16384;
-    }
+      // make patched shader
+      VkShaderModule mod[2] = {VK_NULL_HANDLE, VK_NULL_HANDLE};
 
-    // set our renderpass and shader
-    pipeCreateInfo.renderPass = m_OverlayNoDepthRP;
-    pipeCreateInfo.subpass = 0;
+      // first shader, no culling, writes red
+      mod[0] = GetFixedColShader(highlightCol);
 
-    VkPipelineShaderStageCreateInfo *fragShader = NULL;
+      highlightCol[0] = 0.0f;
+      highlightCol[1] = 1.0f;
 
-    for(uint32_t i = 0; i < pipeCreateInfo.stageCount; i++)
-    {
-      VkPipelineShaderStageCreateInfo &sh =
-          (VkPipelineShaderStageCreateInfo &)pipeCreateInfo.pStages[i];
-      if(sh.stage == VK_SHADER_STAGE_FRAGMENT_BIT)
+      // second shader, normal culling, writes green
+      mod[1] = GetFixedColShader(highlightCol);
+
+      // make patched pipeline
+      VkGraphicsPipelineCreateInfo pipeCreateInfo;
+
+      MakeGraphicsPipelineInfo(pipeCreateInfo, prevstate.graphics.pipeline);
+
+      // disable all tests possible
+      VkPipelineDepthStencilStateCreateInfo *ds =
+          (VkPipelineDepthStencilStateCreateInfo *)pipeCreateInfo.pDepthStencilState;
+      ds->depthTestEnable = false;
+      ds->depthWriteEnable = false;
+      ds->stencilTestEnable = false;
+      ds->depthBoundsTestEnable = false;
+
+      VkPipelineRasterizationStateCreateInfo *rs =
+          (VkPipelineRasterizationStateCreateInfo *)pipeCreateInfo.pRasterizationState;
+      VkCullModeFlags origCullMode = rs->cullMode;
+      rs->cullMode = VK_CULL_MODE_NONE;    // first render without any culling
+      rs->rasterizerDiscardEnable = false;
+
+      if(m_pDriver->GetDeviceFeatures().depthClamp)
+        rs->depthClampEnable = true;
+
+      VkPipelineColorBlendStateCreateInfo *cb =
+          (VkPipelineColorBlendStateCreateInfo *)pipeCreateInfo.pColorBlendState;
+      cb->logicOpEnable = false;
+      cb->attachmentCount = 1;    // only one colour attachment
+      for(uint32_t i = 0; i < cb->attachmentCount; i++)
+      {
+        VkPipelineColorBlendAttachmentState *att =
+            (VkPipelineColorBlendAttachmentState *)&cb->pAttachments[i];
+        att->blendEnable = false;
+        att->colorWriteMask = 0xf;
+      }
+
+      // set scissors to max
+      for(size_t i = 0; i < pipeCreateInfo.pViewportState->scissorCount; i++)
+      {
+        VkRect2D &sc = (VkRect2D &)pipeCreateInfo.pViewportState->pScissors[i];
+        sc.offset.x = 0;
+        sc.offset.y = 0;
+        sc.extent.width = 16384;
+        sc.extent.height = 16384;
+      }
+
+      // set our renderpass and shader
+      pipeCreateInfo.renderPass = m_OverlayNoDepthRP;
+      pipeCreateInfo.subpass = 0;
+
+      VkPipelineShaderStageCreateInfo *fragShader = NULL;
+
+      for(uint32_t i = 0; i < pipeCreateInfo.stageCount; i++)
       {
+        VkPipelineShaderStageCreateInfo &sh =
+            (VkPipelineShaderStageCreateInfo &)pipeCreateInfo.pStages[i];
+        if(sh.stage == VK_SHADER_STAGE_FRAGMENT_BIT)
+        {
+          sh.module = mod[0];
+          sh.pName = "main";
+          fragShader = &sh;
+          break;
+        }
+      }
+
+      if(fragShader == NULL)
+      {
+        // we know this is safe because it's pointing to a static array that's
+        // big enough for all shaders
+
+        VkPipelineShaderStageCreateInfo &sh =
+            (VkPipelineShaderStageCreateInfo &)pipeCreateInfo.pStages[pipeCreateInfo.stageCount++];
+        sh.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        sh.pNext = NULL;
+        sh.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
         sh.module = mod[0];
         sh.pName = "main";
+        sh.pSpecializationInfo = NULL;
+
         fragShader = &sh;
-        break;
       }
-    }
-
-    if(fragShader == NULL)
-    {
-      // we know this is safe because it's pointing to a static array that's
-      // big enough for all shaders
 
-      VkPipelineShaderStageCreateInfo &sh =
-          (VkPipelineShaderStageCreateInfo &)pipeCreateInfo.pStages[pipeCreateInfo.stageCount++];
-      sh.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-      sh.pNext = NULL;
-      sh.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-      sh.module = mod[0];
-      sh.pName = "main";
-      sh.pSpecializationInfo = NULL;
-
-      fragShader = &sh;
-    }
+      if(pipe[0] == VK_NULL_HANDLE)
+      {
+        vkr = m_pDriver->vkCreateGraphicsPipelines(m_Device, m_InternalPipelineCache, 1,
+                                                   &pipeCreateInfo, NULL, &pipe[0]);
+        RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    vkr = vt->EndCommandBuffer(Unwrap(cmd));
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+        OverlayPipeline overlayPipe;
+        overlayPipe.pipe = pipe[0];
+        AddOverlayPipeline(key[0], overlayPipe);
+      }
 
-    vkr = m_pDriver->vkCreateGraphicsPipelines(m_Device, VK_NULL_HANDLE, 1, &pipeCreateInfo, NULL,
-                                               &pipe[0]);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+      fragShader->module = mod[1];
+      rs->cullMode = origCullMode;
 
-    fragShader->module = mod[1];
-    rs->cullMode = origCullMode;
+      if(pipe[1] == VK_NULL_HANDLE)
+      {
+        vkr = m_pDriver->vkCreateGraphicsPipelines(m_Device, m_InternalPipelineCache, 1,
+                                                   &pipeCreateInfo, NULL, &pipe[1]);
+        RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    vkr = m_pDriver->vkCreateGraphicsPipelines(m_Device, VK_NULL_HANDLE, 1, &pipeCreateInfo, NULL,
-                                               &pipe[1]);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+        OverlayPipeline overlayPipe;
+        overlayPipe.pipe = pipe[1];
+        AddOverlayPipeline(key[1], overlayPipe);
+      }
+    }
 
     // modify state
     m_pDriver->m_RenderState.renderPass = GetResID(m_OverlayNoDepthRP);
@@ -5686,7 +6196,7 @@ ResourceId VulkanDebugManager::RenderOverlay(ResourceId texid, DebugOverlay over
 
     m_pDriver->ReplayLog(0, eventID, eReplay_OnlyDraw);
 
-    // submit & flush so that we don't have to keep pipeline around for a while
+    // submit & flush so that the cached pipelines aren't in use if they're evicted later
     m_pDriver->SubmitCmds();
     m_pDriver->FlushQ();
 
@@ -5697,12 +6207,6 @@ ResourceId VulkanDebugManager::RenderOverlay(ResourceId texid, DebugOverlay over
 
     // restore state
     m_pDriver->m_RenderState = prevstate;
-
-    for(int i = 0; i < 2; i++)
-    {
-      m_pDriver->vkDestroyPipeline(m_Device, pipe[i], NULL);
-      m_pDriver->vkDestroyShaderModule(m_Device, mod[i], NULL);
-    }
   }
   else if(overlay == DebugOverlay::Depth || overlay == DebugOverlay::Stencil)
   {
@@ -5732,6 +6236,7 @@ ResourceId VulkanDebugManager::RenderOverlay(ResourceId texid, DebugOverlay over
 
     VkFramebuffer depthFB = VK_NULL_HANDLE;
     VkRenderPass depthRP = VK_NULL_HANDLE;
+    VkFormat depthFormat = VK_FORMAT_UNDEFINED;
 
     const VulkanRenderState &state = m_pDriver->m_RenderState;
     VulkanCreationInfo &createinfo = m_pDriver->m_CreationInfo;
@@ -5758,7 +6263,7 @@ ResourceId VulkanDebugManager::RenderOverlay(ResourceId texid, DebugOverlay over
       ResourceId depthView = createinfo.m_Framebuffer[state.framebuffer].attachments[dsIdx].view;
       ResourceId depthIm = createinfo.m_ImageView[depthView].image;
 
-      attDescs[1].format = createinfo.m_Image[depthIm].format;
+      depthFormat = attDescs[1].format = createinfo.m_Image[depthIm].format;
       attDescs[0].samples = attDescs[1].samples = iminfo.samples;
 
       VkAttachmentReference colRef = {0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
@@ -5818,122 +6323,157 @@ ResourceId VulkanDebugManager::RenderOverlay(ResourceId texid, DebugOverlay over
     // backup state
     VulkanRenderState prevstate = m_pDriver->m_RenderState;
 
-    // make patched shader
-    VkShaderModule mod[2] = {0};
-    VkPipeline pipe[2] = {0};
-
-    // first shader, no depth testing, writes red
-    PatchFixedColShader(mod[0], highlightCol);
-
-    highlightCol[0] = 0.0f;
-    highlightCol[1] = 1.0f;
-
-    // second shader, enabled depth testing, writes green
-    PatchFixedColShader(mod[1], highlightCol);
+    vkr = vt->EndCommandBuffer(Unwrap(cmd));
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    // make patched pipeline
-    VkGraphicsPipelineCreateInfo pipeCreateInfo;
+    OverlayPipelineKey key[2];
+    VkPipeline pipe[2] = {VK_NULL_HANDLE, VK_NULL_HANDLE};
 
-    MakeGraphicsPipelineInfo(pipeCreateInfo, prevstate.graphics.pipeline);
-
-    // disable all tests possible
-    VkPipelineDepthStencilStateCreateInfo *ds =
-        (VkPipelineDepthStencilStateCreateInfo *)pipeCreateInfo.pDepthStencilState;
-    VkBool32 origDepthTest = ds->depthTestEnable;
-    ds->depthTestEnable = false;
-    ds->depthWriteEnable = false;
-    VkBool32 origStencilTest = ds->stencilTestEnable;
-    ds->stencilTestEnable = false;
-    ds->depthBoundsTestEnable = false;
-
-    VkPipelineRasterizationStateCreateInfo *rs =
-        (VkPipelineRasterizationStateCreateInfo *)pipeCreateInfo.pRasterizationState;
-    rs->cullMode = VK_CULL_MODE_NONE;
-    rs->rasterizerDiscardEnable = false;
-
-    if(m_pDriver->GetDeviceFeatures().depthClamp)
-      rs->depthClampEnable = true;
-
-    VkPipelineColorBlendStateCreateInfo *cb =
-        (VkPipelineColorBlendStateCreateInfo *)pipeCreateInfo.pColorBlendState;
-    cb->logicOpEnable = false;
-    cb->attachmentCount = 1;    // only one colour attachment
-    for(uint32_t i = 0; i < cb->attachmentCount; i++)
+    for(uint32_t i = 0; i < 2; i++)
     {
-      VkPipelineColorBlendAttachmentState *att =
-          (VkPipelineColorBlendAttachmentState *)&cb->pAttachments[i];
-      att->blendEnable = false;
-      att->colorWriteMask = 0xf;
+      key[i].pipeline = prevstate.graphics.pipeline;
+      key[i].overlay = overlay;
+      key[i].pass = i;
+      key[i].depthFormat = VK_FORMAT_UNDEFINED;
+
+      // the second pass is made against a renderpass with the depth buffer
+      if(i == 1 && depthRP != VK_NULL_HANDLE)
+        key[i].depthFormat = depthFormat;
+
+      OverlayPipeline *cached = FindOverlayPipeline(key[i]);
+      if(cached)
+        pipe[i] = cached->pipe;
     }
 
-    // set scissors to max
-    for(size_t i = 0; i < pipeCreateInfo.pViewportState->scissorCount; i++)
+    if(pipe[0] == VK_NULL_HANDLE || pipe[1] == VK_NULL_HANDLE)
     {
-      VkRect2D &sc = (VkRect2D &)pipeCreateInfo.pViewportState->pScissors[i];
-      sc.offset.x = 0;
-      sc.offset.y = 0;
-      sc.extent.width = 16384;
-      sc.extent.height = 16384;
-    }
+      // make patched shader
+      VkShaderModule mod[2] = {VK_NULL_HANDLE, VK_NULL_HANDLE};
+
+      // first shader, no depth testing, writes red
+      mod[0] = GetFixedColShader(highlightCol);
 
-    // set our renderpass and shader
-    pipeCreateInfo.renderPass = m_OverlayNoDepthRP;
-    pipeCreateInfo.subpass = 0;
+      highlightCol[0] = 0.0f;
+      highlightCol[1] = 1.0f;
 
-    VkPipelineShaderStageCreateInfo *fragShader = NULL;
+      // second shader, enabled depth testing, writes green
+      mod[1] = GetFixedColShader(highlightCol);
 
-    for(uint32_t i = 0; i < pipeCreateInfo.stageCount; i++)
-    {
-      VkPipelineShaderStageCreateInfo &sh =
-          (VkPipelineShaderStageCreateInfo &)pipeCreateInfo.pStages[i];
-      if(sh.stage == VK_SHADER_STAGE_FRAGMENT_BIT)
+      // make patched pipeline
+      VkGraphicsPipelineCreateInfo pipeCreateInfo;
+
+      MakeGraphicsPipelineInfo(pipeCreateInfo, prevstate.graphics.pipeline);
+
+      // disable all tests possible
+      VkPipelineDepthStencilStateCreateInfo *ds =
+          (VkPipelineDepthStencilStateCreateInfo *)pipeCreateInfo.pDepthStencilState;
+      VkBool32 origDepthTest = ds->depthTestEnable;
+      ds->depthTestEnable = false;
+      ds->depthWriteEnable = false;
+      VkBool32 origStencilTest = ds->stencilTestEnable;
+      ds->stencilTestEnable = false;
+      ds->depthBoundsTestEnable = false;
+
+      VkPipelineRasterizationStateCreateInfo *rs =
+          (VkPipelineRasterizationStateCreateInfo *)pipeCreateInfo.pRasterizationState;
+      rs->cullMode = VK_CULL_MODE_NONE;
+      rs->rasterizerDiscardEnable = false;
+
+      if(m_pDriver->GetDeviceFeatures().depthClamp)
+        rs->depthClampEnable = true;
+
+      VkPipelineColorBlendStateCreateInfo *cb =
+          (VkPipelineColorBlendStateCreateInfo *)pipeCreateInfo.pColorBlendState;
+      cb->logicOpEnable = false;
+      cb->attachmentCount = 1;    // only one colour attachment
+      for(uint32_t i = 0; i < cb->attachmentCount; i++)
+      {
+        VkPipelineColorBlendAttachmentState *att =
+            (VkPipelineColorBlendAttachmentState *)&cb->pAttachments[i];
+        att->blendEnable = false;
+        att->colorWriteMask = 0xf;
+      }
+
+      // set scissors to max
+      for(size_t i = 0; i < pipeCreateInfo.pViewportState->scissorCount; i++)
+      {
+        VkRect2D &sc = (VkRect2D &)pipeCreateInfo.pViewportState->pScissors[i];
+        sc.offset.x = 0;
+        sc.offset.y = 0;
+        sc.extent.width = 16384;
+        sc.extent.height = 16384;
+      }
+
+      // set our renderpass and shader
+      pipeCreateInfo.renderPass = m_OverlayNoDepthRP;
+      pipeCreateInfo.subpass = 0;
+
+      VkPipelineShaderStageCreateInfo *fragShader = NULL;
+
+      for(uint32_t i = 0; i < pipeCreateInfo.stageCount; i++)
+      {
+        VkPipelineShaderStageCreateInfo &sh =
+            (VkPipelineShaderStageCreateInfo &)pipeCreateInfo.pStages[i];
+        if(sh.stage == VK_SHADER_STAGE_FRAGMENT_BIT)
+        {
+          sh.module = mod[0];
+          sh.pName = "main";
+          fragShader = &sh;
+          break;
+        }
+      }
+
+      if(fragShader == NULL)
       {
+        // we know this is safe because it's pointing to a static array that's
+        // big enough for all shaders
+
+        VkPipelineShaderStageCreateInfo &sh =
+            (VkPipelineShaderStageCreateInfo &)pipeCreateInfo.pStages[pipeCreateInfo.stageCount++];
+        sh.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        sh.pNext = NULL;
+        sh.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
         sh.module = mod[0];
         sh.pName = "main";
+        sh.pSpecializationInfo = NULL;
+
         fragShader = &sh;
-        break;
       }
-    }
 
-    if(fragShader == NULL)
-    {
-      // we know this is safe because it's pointing to a static array that's
-      // big enough for all shaders
+      if(pipe[0] == VK_NULL_HANDLE)
+      {
+        vkr = m_pDriver->vkCreateGraphicsPipelines(m_Device, m_InternalPipelineCache, 1,
+                                                   &pipeCreateInfo, NULL, &pipe[0]);
+        RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-      VkPipelineShaderStageCreateInfo &sh =
-          (VkPipelineShaderStageCreateInfo &)pipeCreateInfo.pStages[pipeCreateInfo.stageCount++];
-      sh.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-      sh.pNext = NULL;
-      sh.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-      sh.module = mod[0];
-      sh.pName = "main";
-      sh.pSpecializationInfo = NULL;
-
-      fragShader = &sh;
-    }
+        OverlayPipeline overlayPipe;
+        overlayPipe.pipe = pipe[0];
+        AddOverlayPipeline(key[0], overlayPipe);
+      }
 
-    vkr = vt->EndCommandBuffer(Unwrap(cmd));
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+      fragShader->module = mod[1];
 
-    vkr = m_pDriver->vkCreateGraphicsPipelines(m_Device, VK_NULL_HANDLE, 1, &pipeCreateInfo, NULL,
-                                               &pipe[0]);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+      if(depthRP != VK_NULL_HANDLE)
+      {
+        if(overlay == DebugOverlay::Depth)
+          ds->depthTestEnable = origDepthTest;
+        else
+          ds->stencilTestEnable = origStencilTest;
+        pipeCreateInfo.renderPass = depthRP;
+      }
 
-    fragShader->module = mod[1];
+      if(pipe[1] == VK_NULL_HANDLE)
+      {
+        vkr = m_pDriver->vkCreateGraphicsPipelines(m_Device, m_InternalPipelineCache, 1,
+                                                   &pipeCreateInfo, NULL, &pipe[1]);
+        RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    if(depthRP != VK_NULL_HANDLE)
-    {
-      if(overlay == DebugOverlay::Depth)
-        ds->depthTestEnable = origDepthTest;
-      else
-        ds->stencilTestEnable = origStencilTest;
-      pipeCreateInfo.renderPass = depthRP;
+        OverlayPipeline overlayPipe;
+        overlayPipe.pipe = pipe[1];
+        AddOverlayPipeline(key[1], overlayPipe);
+      }
     }
 
-    vkr = m_pDriver->vkCreateGraphicsPipelines(m_Device, VK_NULL_HANDLE, 1, &pipeCreateInfo, NULL,
-                                               &pipe[1]);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
     // modify state
     m_pDriver->m_RenderState.renderPass = GetResID(m_OverlayNoDepthRP);
     m_pDriver->m_RenderState.subpass = 0;
@@ -5961,7 +6501,7 @@ ResourceId VulkanDebugManager::RenderOverlay(ResourceId texid, DebugOverlay over
 
     m_pDriver->ReplayLog(0, eventID, eReplay_OnlyDraw);
 
-    // submit & flush so that we don't have to keep pipeline around for a while
+    // submit & flush so that the cached pipelines aren't in use if they're evicted later
     m_pDriver->SubmitCmds();
     m_pDriver->FlushQ();
 
@@ -5973,13 +6513,7 @@ ResourceId VulkanDebugManager::RenderOverlay(ResourceId texid, DebugOverlay over
     // restore state
     m_pDriver->m_RenderState = prevstate;
 
-    for(int i = 0; i < 2; i++)
-    {
-      m_pDriver->vkDestroyPipeline(m_Device, pipe[i], NULL);
-      m_pDriver->vkDestroyShaderModule(m_Device, mod[i], NULL);
-    }
-
-    if(depthRP != VK_NULL_HANDLE)
+    if(depthRP != VK_NULL_HANDLE)
     {
       m_pDriver->vkDestroyRenderPass(m_Device, depthRP, NULL);
       m_pDriver->vkDestroyFramebuffer(m_Device, depthFB, NULL);
@@ -6316,11 +6850,6 @@ ResourceId VulkanDebugManager::RenderOverlay(ResourceId texid, DebugOverlay over
       m_pDriver->vkDestroyImageView(m_Device, quadImgView, NULL);
       m_pDriver->vkDestroyImage(m_Device, quadImg, NULL);
       m_pDriver->vkFreeMemory(m_Device, quadImgMem, NULL);
-
-      for(auto it = cb.m_PipelineCache.begin(); it != cb.m_PipelineCache.end(); ++it)
-      {
-        m_pDriver->vkDestroyPipeline(m_Device, it->second.second, NULL);
-      }
     }
 
     // restore back to normal
@@ -6637,7 +7166,7 @@ ResourceId VulkanDebugManager::RenderOverlay(ResourceId texid, DebugOverlay over
 
             if(pipe == VK_NULL_HANDLE)
             {
-              vkr = m_pDriver->vkCreateGraphicsPipelines(m_Device, VK_NULL_HANDLE, 1,
+              vkr = m_pDriver->vkCreateGraphicsPipelines(m_Device, m_InternalPipelineCache, 1,
                                                          &pipeCreateInfo, NULL, &pipe);
               RDCASSERTEQUAL(vkr, VK_SUCCESS);
             }
@@ -6766,18 +7295,62 @@ ResourceId VulkanDebugManager::RenderOverlay(ResourceId texid, DebugOverlay over
   return GetResID(m_OverlayImage);
 }
 
+void VulkanDebugManager::WarmMeshDisplayPipelines(void *ths)
+{
+  VulkanDebugManager *debug = (VulkanDebugManager *)ths;
+
+  // the helpers drawn in every mesh view - the bounding box, frustum, axis and vertex highlights
+  MeshFormat helper;
+  helper.specialFormat = SpecialFormat::Unknown;
+  helper.compByteWidth = 4;
+  helper.compCount = 4;
+  helper.compType = CompType::Float;
+  helper.stride = sizeof(Vec4f);
+
+  const Topology topologies[] = {Topology::LineList, Topology::TriangleList,
+                                 Topology::TriangleStrip};
+
+  for(size_t i = 0; i < ARRAY_COUNT(topologies); i++)
+  {
+    helper.topo = topologies[i];
+    debug->CacheMeshDisplayPipelines(helper, helper);
+  }
+}
+
+void VulkanDebugManager::TrimMeshDisplayPipelines()
+{
+  SCOPED_LOCK(m_MeshPipelinesLock);
+
+  if(m_CachedMeshPipelines.size() <= MeshPipelineCacheSize)
+    return;
+
+  // evict down to three quarters, so we don't have to wait for the GPU every render
+  m_pDriver->SubmitCmds();
+  m_pDriver->FlushQ();
+
+  while(m_CachedMeshPipelines.size() > MeshPipelineCacheSize * 3 / 4)
+  {
+    auto lru = m_CachedMeshPipelines.begin();
+    for(auto it = m_CachedMeshPipelines.begin(); it != m_CachedMeshPipelines.end(); ++it)
+      if(it->second.lastUse < lru->second.lastUse)
+        lru = it;
+
+    for(uint32_t i = 0; i < MeshDisplayPipelines::ePipe_Count; i++)
+      m_pDriver->vkDestroyPipeline(m_Device, lru->second.pipes[i], NULL);
+
+    m_CachedMeshPipelines.erase(lru);
+  }
+}
+
 MeshDisplayPipelines VulkanDebugManager::CacheMeshDisplayPipelines(const MeshFormat &primary,
                                                                    const MeshFormat &secondary)
 {
-  // generate a key to look up the map
+  // generate a key to look up the map. The index width doesn't affect the pipelines so isn't
+  // included.
   uint64_t key = 0;
 
   uint64_t bit = 0;
 
-  if(primary.idxByteWidth == 4)
-    key |= 1ULL << bit;
-  bit++;
-
   RDCASSERT((uint32_t)primary.topo < 64);
   key |= uint64_t((uint32_t)primary.topo & 0x3f) << bit;
   bit += 6;
@@ -6819,17 +7392,20 @@ MeshDisplayPipelines VulkanDebugManager::CacheMeshDisplayPipelines(const MeshFor
   }
   bit += 16;
 
+  // held while creating, so a lookup racing with the warm-up thread waits for it instead of
+  // creating the same pipelines twice
+  SCOPED_LOCK(m_MeshPipelinesLock);
+
   MeshDisplayPipelines &cache = m_CachedMeshPipelines[key];
 
+  cache.lastUse = ++m_MeshPipelineTick;
+
   if(cache.pipes[(uint32_t)SolidShade::NoSolid] != VK_NULL_HANDLE)
     return cache;
 
   const VkLayerDispatchTable *vt = ObjDisp(m_Device);
   VkResult vkr = VK_SUCCESS;
 
-  // should we try and evict old pipelines from the cache here?
-  // or just keep them forever
-
   VkVertexInputBindingDescription binds[] = {// primary
                                              {0, primary.stride, VK_VERTEX_INPUT_RATE_VERTEX},
                                              // secondary
@@ -7019,28 +7595,28 @@ MeshDisplayPipelines VulkanDebugManager::CacheMeshDisplayPipelines(const MeshFor
   rs.lineWidth = 1.0f;
   ds.depthTestEnable = false;
 
-  vkr = vt->CreateGraphicsPipelines(Unwrap(m_Device), VK_NULL_HANDLE, 1, &pipeInfo, NULL,
-                                    &cache.pipes[MeshDisplayPipelines::ePipe_Wire]);
+  vkr = vt->CreateGraphicsPipelines(Unwrap(m_Device), Unwrap(m_InternalPipelineCache), 1, &pipeInfo,
+                                    NULL, &cache.pipes[MeshDisplayPipelines::ePipe_Wire]);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
   ds.depthTestEnable = true;
 
-  vkr = vt->CreateGraphicsPipelines(Unwrap(m_Device), VK_NULL_HANDLE, 1, &pipeInfo, NULL,
-                                    &cache.pipes[MeshDisplayPipelines::ePipe_WireDepth]);
+  vkr = vt->CreateGraphicsPipelines(Unwrap(m_Device), Unwrap(m_InternalPipelineCache), 1, &pipeInfo,
+                                    NULL, &cache.pipes[MeshDisplayPipelines::ePipe_WireDepth]);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
   // solid shading pipeline
   rs.polygonMode = VK_POLYGON_MODE_FILL;
   ds.depthTestEnable = false;
 
-  vkr = vt->CreateGraphicsPipelines(Unwrap(m_Device), VK_NULL_HANDLE, 1, &pipeInfo, NULL,
-                                    &cache.pipes[MeshDisplayPipelines::ePipe_Solid]);
+  vkr = vt->CreateGraphicsPipelines(Unwrap(m_Device), Unwrap(m_InternalPipelineCache), 1, &pipeInfo,
+                                    NULL, &cache.pipes[MeshDisplayPipelines::ePipe_Solid]);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
   ds.depthTestEnable = true;
 
-  vkr = vt->CreateGraphicsPipelines(Unwrap(m_Device), VK_NULL_HANDLE, 1, &pipeInfo, NULL,
-                                    &cache.pipes[MeshDisplayPipelines::ePipe_SolidDepth]);
+  vkr = vt->CreateGraphicsPipelines(Unwrap(m_Device), Unwrap(m_InternalPipelineCache), 1, &pipeInfo,
+                                    NULL, &cache.pipes[MeshDisplayPipelines::ePipe_SolidDepth]);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
   if(secondary.buf != ResourceId())
@@ -7052,7 +7628,8 @@ MeshDisplayPipelines VulkanDebugManager::CacheMeshDisplayPipelines(const MeshFor
 
     vi.vertexBindingDescriptionCount = 2;
 
-    vkr = vt->CreateGraphicsPipelines(Unwrap(m_Device), VK_NULL_HANDLE, 1, &pipeInfo, NULL,
+    vkr = vt->CreateGraphicsPipelines(Unwrap(m_Device), Unwrap(m_InternalPipelineCache), 1,
+                                      &pipeInfo, NULL,
                                       &cache.pipes[MeshDisplayPipelines::ePipe_Secondary]);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
   }
@@ -7069,8 +7646,8 @@ MeshDisplayPipelines VulkanDebugManager::CacheMeshDisplayPipelines(const MeshFor
   stages[2].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
   pipeInfo.stageCount = 3;
 
-  vkr = vt->CreateGraphicsPipelines(Unwrap(m_Device), VK_NULL_HANDLE, 1, &pipeInfo, NULL,
-                                    &cache.pipes[MeshDisplayPipelines::ePipe_Lit]);
+  vkr = vt->CreateGraphicsPipelines(Unwrap(m_Device), Unwrap(m_InternalPipelineCache), 1, &pipeInfo,
+                                    NULL, &cache.pipes[MeshDisplayPipelines::ePipe_Lit]);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
   for(uint32_t i = 0; i < MeshDisplayPipelines::ePipe_Count; i++)
@@ -7835,205 +8412,1094 @@ static void AddOutputDumping(const ShaderReflection &refl, const char *entryName
   spirv[3] = idBound;
 }
 
-void VulkanDebugManager::InitPostVSBuffers(uint32_t eventID)
+// texture sampling feedback is recorded into a bitmask of the tiles sampled in each mip. Every
+// texture binding a fragment shader samples from gets its own slot of SamplingSlotWords words.
+static const uint32_t SamplingGridSize = 16;
+static const uint32_t SamplingMaxMips = 16;
+static const uint32_t SamplingWordsPerMip = SamplingGridSize * SamplingGridSize / 32;
+static const uint32_t SamplingSlotWords = SamplingMaxMips * SamplingWordsPerMip;
+static const uint32_t SamplingMaxSlots = 32;
+// draws stop being recorded once their slots fill this much of the feedback buffer
+static const VkDeviceSize SamplingBufferSize = 32 * 1024 * 1024;
+
+RDCCOMPILE_ASSERT((SamplingGridSize & (SamplingGridSize - 1)) == 0 &&
+                      (SamplingMaxMips & (SamplingMaxMips - 1)) == 0,
+                  "Sampling grid size and mip count must be powers of two");
+
+struct SamplingSlot
 {
-  // go through any aliasing
-  if(m_PostVSAlias.find(eventID) != m_PostVSAlias.end())
-    eventID = m_PostVSAlias[eventID];
-
-  if(m_PostVSData.find(eventID) != m_PostVSData.end())
-    return;
-
-  if(!m_pDriver->GetDeviceFeatures().vertexPipelineStoresAndAtomics)
-    return;
+  uint32_t varID;
+  uint32_t set;
+  uint32_t binding;
+  uint32_t arrayElement;
+};
 
-  const VulkanRenderState &state = m_pDriver->m_RenderState;
-  VulkanCreationInfo &creationInfo = m_pDriver->m_CreationInfo;
+// patches every sample of a 2D texture in a fragment shader to also atomically OR the bit for the
+// sampled mip and tile into a storage buffer, in a new descriptor set descSet. slots is filled out
+// with the binding of each slot in the buffer, and is left empty if no samples could be patched.
+static void AddSamplingFeedback(vector<uint32_t> &modSpirv, uint32_t descSet,
+                                vector<SamplingSlot> &slots)
+{
+  uint32_t *spirv = &modSpirv[0];
+  size_t spirvLength = modSpirv.size();
 
-  if(state.graphics.pipeline == ResourceId() || state.renderPass == ResourceId())
-    return;
+  uint32_t idBound = spirv[3];
 
-  const VulkanCreationInfo::Pipeline &pipeInfo = creationInfo.m_Pipeline[state.graphics.pipeline];
+  // find the types we need if they already exist, since non-aggregate types can't be declared
+  // twice, and everything we need to trace each sample back to the variable it samples from.
+  bool hasImageQuery = false;
+  uint32_t uint32ID = 0;
+  uint32_t floatID = 0;
+  uint32_t boolID = 0;
+  uint32_t v2floatID = 0;
+  uint32_t v2uintID = 0;
 
-  if(pipeInfo.shaders[0].module == ResourceId())
-    return;
+  map<uint32_t, size_t> defs;
+  map<uint32_t, uint32_t> constants;
+  map<uint32_t, uint32_t> sets, bindings;
 
-  const VulkanCreationInfo::ShaderModule &moduleInfo =
-      creationInfo.m_ShaderModule[pipeInfo.shaders[0].module];
+  vector<size_t> samples;
 
-  ShaderReflection *refl = pipeInfo.shaders[0].refl;
+  size_t decorateOffset = 0;
+  size_t typeVarOffset = 0;
 
-  // no outputs from this shader? unexpected but theoretically possible (dummy VS before
-  // tessellation maybe). Just fill out an empty data set
-  if(refl->OutputSig.count == 0)
+  size_t it = 5;
+  while(it < spirvLength)
   {
-    // empty vertex output signature
-    m_PostVSData[eventID].vsin.topo = pipeInfo.topology;
-    m_PostVSData[eventID].vsout.buf = VK_NULL_HANDLE;
-    m_PostVSData[eventID].vsout.instStride = 0;
-    m_PostVSData[eventID].vsout.vertStride = 0;
-    m_PostVSData[eventID].vsout.nearPlane = 0.0f;
-    m_PostVSData[eventID].vsout.farPlane = 0.0f;
-    m_PostVSData[eventID].vsout.useIndices = false;
-    m_PostVSData[eventID].vsout.hasPosOut = false;
-    m_PostVSData[eventID].vsout.idxBuf = VK_NULL_HANDLE;
+    uint16_t WordCount = spirv[it] >> spv::WordCountShift;
+    spv::Op opcode = spv::Op(spirv[it] & spv::OpCodeMask);
 
-    m_PostVSData[eventID].vsout.topo = pipeInfo.topology;
+    switch(opcode)
+    {
+      case spv::OpCapability:
+        if(spirv[it + 1] == spv::CapabilityImageQuery)
+          hasImageQuery = true;
+        break;
+      case spv::OpDecorate:
+        if(spirv[it + 2] == spv::DecorationDescriptorSet)
+          sets[spirv[it + 1]] = spirv[it + 3];
+        if(spirv[it + 2] == spv::DecorationBinding)
+          bindings[spirv[it + 1]] = spirv[it + 3];
+        break;
+      case spv::OpTypeInt:
+        if(spirv[it + 2] == 32 && spirv[it + 3] == 0)
+          uint32ID = spirv[it + 1];
+        break;
+      case spv::OpTypeFloat:
+        if(spirv[it + 2] == 32)
+          floatID = spirv[it + 1];
+        break;
+      case spv::OpTypeBool: boolID = spirv[it + 1]; break;
+      case spv::OpTypeVector:
+        if(spirv[it + 3] == 2 && floatID != 0 && spirv[it + 2] == floatID)
+          v2floatID = spirv[it + 1];
+        if(spirv[it + 3] == 2 && uint32ID != 0 && spirv[it + 2] == uint32ID)
+          v2uintID = spirv[it + 1];
+        break;
+      case spv::OpTypeImage:
+      case spv::OpTypeSampledImage:
+      case spv::OpTypeArray:
+      case spv::OpTypePointer: defs[spirv[it + 1]] = it; break;
+      case spv::OpConstant:
+        // only 32-bit constants are needed, as array indices
+        if(WordCount == 4)
+          constants[spirv[it + 2]] = spirv[it + 3];
+        break;
+      case spv::OpVariable:
+      case spv::OpLoad:
+      case spv::OpCopyObject:
+      case spv::OpSampledImage:
+      case spv::OpAccessChain:
+      case spv::OpInBoundsAccessChain: defs[spirv[it + 2]] = it; break;
+      case spv::OpImageSampleImplicitLod:
+      case spv::OpImageSampleExplicitLod:
+      case spv::OpImageSampleDrefImplicitLod:
+      case spv::OpImageSampleDrefExplicitLod: samples.push_back(it); break;
+      case spv::OpFunction:
+        if(typeVarOffset == 0)
+          typeVarOffset = it;
+        break;
+      default: break;
+    }
 
-    return;
-  }
+    // when we reach the types, decorations are over
+    if(decorateOffset == 0 && opcode >= spv::OpTypeVoid && opcode <= spv::OpTypeForwardPointer)
+      decorateOffset = it;
 
-  const DrawcallDescription *drawcall = m_pDriver->GetDrawcall(eventID);
+    it += WordCount;
+  }
 
-  if(drawcall == NULL || drawcall->numIndices == 0 || drawcall->numInstances == 0)
+  if(samples.empty() || decorateOffset == 0 || typeVarOffset == 0)
     return;
 
-  uint32_t descSet = (uint32_t)creationInfo.m_PipelineLayout[pipeInfo.layout].descSetLayouts.size();
-
-  // we go through the driver for all these creations since they need to be properly
-  // registered in order to be put in the partial replay state
-  VkResult vkr = VK_SUCCESS;
-  VkDevice dev = m_Device;
+  // returns the offset of the instruction defining id, looking through copies
+  auto FindDef = [&](uint32_t id) -> size_t {
+    auto def = defs.find(id);
+    while(def != defs.end() && spv::Op(spirv[def->second] & spv::OpCodeMask) == spv::OpCopyObject)
+      def = defs.find(spirv[def->second + 3]);
+    return def == defs.end() ? 0 : def->second;
+  };
 
-  VkDescriptorSetLayout *descSetLayouts;
+  auto DefOp = [&](size_t def) -> spv::Op {
+    return def == 0 ? spv::OpNop : spv::Op(spirv[def] & spv::OpCodeMask);
+  };
 
-  // descSet will be the index of our new descriptor set
-  descSetLayouts = new VkDescriptorSetLayout[descSet + 1];
+  struct SampleOp
+  {
+    size_t offset;
+    uint32_t slot;
+    // the explicit lod, or 0 to query the lod the sample used
+    uint32_t lodID;
+  };
 
-  for(uint32_t i = 0; i < descSet; i++)
-    descSetLayouts[i] = GetResourceManager()->GetCurrentHandle<VkDescriptorSetLayout>(
-        creationInfo.m_PipelineLayout[pipeInfo.layout].descSetLayouts[i]);
+  vector<SampleOp> ops;
 
-  // this layout just says it has one storage buffer
-  descSetLayouts[descSet] = m_MeshFetchDescSetLayout;
+  for(size_t s : samples)
+  {
+    spv::Op opcode = spv::Op(spirv[s] & spv::OpCodeMask);
+    uint16_t WordCount = spirv[s] >> spv::WordCountShift;
 
-  const vector<VkPushConstantRange> &push = creationInfo.m_PipelineLayout[pipeInfo.layout].pushRanges;
+    SampleOp op = {s, 0, 0};
 
-  VkPipelineLayoutCreateInfo pipeLayoutInfo = {
-      VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-      NULL,
-      0,
-      descSet + 1,
-      descSetLayouts,
-      (uint32_t)push.size(),
-      push.empty() ? NULL : &push[0],
-  };
+    if(opcode == spv::OpImageSampleExplicitLod || opcode == spv::OpImageSampleDrefExplicitLod)
+    {
+      // only an explicit Lod gives the mip directly, gradients would need the texture size too.
+      // Bias can't be used with an explicit lod so Lod is always the first operand.
+      size_t maskIdx = opcode == spv::OpImageSampleDrefExplicitLod ? 6 : 5;
+      if(WordCount <= maskIdx + 1 || (spirv[s + maskIdx] & spv::ImageOperandsLodMask) == 0)
+        continue;
 
-  // create pipeline layout with same descriptor set layouts, plus our mesh output set
-  VkPipelineLayout pipeLayout;
-  vkr = m_pDriver->vkCreatePipelineLayout(dev, &pipeLayoutInfo, NULL, &pipeLayout);
-  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+      op.lodID = spirv[s + maskIdx + 1];
+    }
 
-  SAFE_DELETE_ARRAY(descSetLayouts);
+    // trace the sampled image back through the load to the variable, for its binding
+    size_t def = FindDef(spirv[s + 3]);
+    if(DefOp(def) == spv::OpSampledImage)
+      def = FindDef(spirv[def + 3]);
+    if(DefOp(def) != spv::OpLoad)
+      continue;
 
-  VkGraphicsPipelineCreateInfo pipeCreateInfo;
+    SamplingSlot slot = {spirv[def + 3], 0, 0, 0};
 
-  // get pipeline create info
-  MakeGraphicsPipelineInfo(pipeCreateInfo, state.graphics.pipeline);
+    def = FindDef(slot.varID);
+    if(DefOp(def) == spv::OpAccessChain || DefOp(def) == spv::OpInBoundsAccessChain)
+    {
+      // only a constant index into an array of bindings is known when patching
+      uint16_t chainWords = spirv[def] >> spv::WordCountShift;
+      if(chainWords != 5 || constants.find(spirv[def + 4]) == constants.end())
+        continue;
 
-  // repoint pipeline layout
-  pipeCreateInfo.layout = pipeLayout;
+      slot.varID = spirv[def + 3];
+      slot.arrayElement = constants[spirv[def + 4]];
+      def = FindDef(slot.varID);
+    }
 
-  // set primitive topology to point list
-  VkPipelineInputAssemblyStateCreateInfo *ia =
-      (VkPipelineInputAssemblyStateCreateInfo *)pipeCreateInfo.pInputAssemblyState;
+    if(DefOp(def) != spv::OpVariable || sets.find(slot.varID) == sets.end() ||
+       bindings.find(slot.varID) == bindings.end())
+      continue;
 
-  VkPrimitiveTopology topo = ia->topology;
+    slot.set = sets[slot.varID];
+    slot.binding = bindings[slot.varID];
 
-  ia->topology = VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+    // go from the variable's pointer type to the image type
+    size_t type = FindDef(spirv[def + 1]);
+    if(DefOp(type) != spv::OpTypePointer)
+      continue;
+    type = FindDef(spirv[type + 3]);
+    if(DefOp(type) == spv::OpTypeArray)
+      type = FindDef(spirv[type + 2]);
+    if(DefOp(type) == spv::OpTypeSampledImage)
+      type = FindDef(spirv[type + 2]);
+
+    // tiles are only meaningful in 2D, arrays are fine as the layer is ignored
+    if(DefOp(type) != spv::OpTypeImage || spirv[type + 3] != spv::Dim2D || spirv[type + 6] != 0)
+      continue;
 
-  // remove all stages but the vertex shader, we just want to run it and write the data,
-  // we don't want to tessellate/geometry shade, nor rasterize (which we disable below)
-  uint32_t vertIdx = pipeCreateInfo.stageCount;
+    for(op.slot = 0; op.slot < slots.size(); op.slot++)
+      if(slots[op.slot].varID == slot.varID && slots[op.slot].arrayElement == slot.arrayElement)
+        break;
 
-  for(uint32_t i = 0; i < pipeCreateInfo.stageCount; i++)
-  {
-    if(pipeCreateInfo.pStages[i].stage & VK_SHADER_STAGE_VERTEX_BIT)
+    if(op.slot == slots.size())
     {
-      vertIdx = i;
-      break;
+      if(slots.size() == SamplingMaxSlots)
+        continue;
+
+      slots.push_back(slot);
     }
+
+    ops.push_back(op);
   }
 
-  RDCASSERT(vertIdx < pipeCreateInfo.stageCount);
+  if(ops.empty())
+    return;
 
-  if(vertIdx != 0)
-    (VkPipelineShaderStageCreateInfo &)pipeCreateInfo.pStages[0] = pipeCreateInfo.pStages[vertIdx];
+  vector<uint32_t> typeOps;
 
-  pipeCreateInfo.stageCount = 1;
+  auto AddOp = [](vector<uint32_t> &dst, std::initializer_list<uint32_t> words) {
+    dst.push_back(MakeSPIRVOp(spv::Op(*words.begin()), (uint32_t)words.size()));
+    dst.insert(dst.end(), words.begin() + 1, words.end());
+  };
 
-  // enable rasterizer discard
-  VkPipelineRasterizationStateCreateInfo *rs =
-      (VkPipelineRasterizationStateCreateInfo *)pipeCreateInfo.pRasterizationState;
-  rs->rasterizerDiscardEnable = true;
+  if(uint32ID == 0)
+  {
+    uint32ID = idBound++;
+    AddOp(typeOps, {spv::OpTypeInt, uint32ID, 32, 0});
+  }
 
-  VkBuffer meshBuffer = VK_NULL_HANDLE, readbackBuffer = VK_NULL_HANDLE;
-  VkDeviceMemory meshMem = VK_NULL_HANDLE, readbackMem = VK_NULL_HANDLE;
+  if(floatID == 0)
+  {
+    floatID = idBound++;
+    AddOp(typeOps, {spv::OpTypeFloat, floatID, 32});
+  }
 
-  VkBuffer idxBuf = VK_NULL_HANDLE, uniqIdxBuf = VK_NULL_HANDLE;
-  VkDeviceMemory idxBufMem = VK_NULL_HANDLE, uniqIdxBufMem = VK_NULL_HANDLE;
+  if(boolID == 0)
+  {
+    boolID = idBound++;
+    AddOp(typeOps, {spv::OpTypeBool, boolID});
+  }
 
-  uint32_t numVerts = drawcall->numIndices;
-  VkDeviceSize bufSize = 0;
+  if(v2floatID == 0)
+  {
+    v2floatID = idBound++;
+    AddOp(typeOps, {spv::OpTypeVector, v2floatID, floatID, 2});
+  }
 
-  vector<uint32_t> indices;
-  uint32_t idxsize = state.ibuffer.bytewidth;
-  bool index16 = (idxsize == 2);
-  uint32_t numIndices = numVerts;
-  vector<byte> idxdata;
-  uint16_t *idx16 = NULL;
-  uint32_t *idx32 = NULL;
+  if(v2uintID == 0)
+  {
+    v2uintID = idBound++;
+    AddOp(typeOps, {spv::OpTypeVector, v2uintID, uint32ID, 2});
+  }
 
-  uint32_t minIndex = 0, maxIndex = 0;
+  auto AddUintConst = [&](uint32_t val) {
+    uint32_t id = idBound++;
+    AddOp(typeOps, {spv::OpConstant, uint32ID, id, val});
+    return id;
+  };
 
-  uint32_t vertexIndexOffset = 0;
+  auto AddFloatConst = [&](float val) {
+    uint32_t id = idBound++;
+    uint32_t bits = 0;
+    memcpy(&bits, &val, sizeof(bits));
+    AddOp(typeOps, {spv::OpConstant, floatID, id, bits});
+    return id;
+  };
 
-  if(drawcall->flags & DrawFlags::UseIBuffer)
+  uint32_t zeroID = AddUintConst(0);
+  uint32_t oneID = AddUintConst(1);
+  uint32_t fiveID = AddUintConst(5);
+  uint32_t bitMaskID = AddUintConst(31);
+  uint32_t mipMaskID = AddUintConst(SamplingMaxMips - 1);
+  uint32_t tileMaskID = AddUintConst(SamplingGridSize - 1);
+  uint32_t gridID = AddUintConst(SamplingGridSize);
+  uint32_t wordsPerMipID = AddUintConst(SamplingWordsPerMip);
+
+  uint32_t zeroFloatID = AddFloatConst(0.0f);
+  uint32_t oneFloatID = AddFloatConst(1.0f);
+  uint32_t gridFloatID = AddFloatConst(float(SamplingGridSize));
+
+  uint32_t oneVecID = idBound++;
+  AddOp(typeOps, {spv::OpConstantComposite, v2floatID, oneVecID, oneFloatID, oneFloatID});
+
+  vector<uint32_t> slotBaseIDs;
+  for(uint32_t s = 0; s < slots.size(); s++)
+    slotBaseIDs.push_back(AddUintConst(s * SamplingSlotWords));
+
+  // struct { uint words[]; } in a new descriptor set
+  uint32_t runtimeArrayID = idBound++;
+  uint32_t bufStructID = idBound++;
+  uint32_t bufStructPtrID = idBound++;
+  uint32_t uintPtrID = idBound++;
+  uint32_t bufVarID = idBound++;
+
+  AddOp(typeOps, {spv::OpTypeRuntimeArray, runtimeArrayID, uint32ID});
+  AddOp(typeOps, {spv::OpTypeStruct, bufStructID, runtimeArrayID});
+  AddOp(typeOps, {spv::OpTypePointer, bufStructPtrID, spv::StorageClassUniform, bufStructID});
+  AddOp(typeOps, {spv::OpTypePointer, uintPtrID, spv::StorageClassUniform, uint32ID});
+  AddOp(typeOps, {spv::OpVariable, bufStructPtrID, bufVarID, spv::StorageClassUniform});
+
+  vector<uint32_t> decorations;
+
+  AddOp(decorations, {spv::OpDecorate, runtimeArrayID, spv::DecorationArrayStride, 4});
+  AddOp(decorations, {spv::OpMemberDecorate, bufStructID, 0, spv::DecorationOffset, 0});
+  AddOp(decorations, {spv::OpDecorate, bufStructID, spv::DecorationBufferBlock});
+  AddOp(decorations, {spv::OpDecorate, bufVarID, spv::DecorationDescriptorSet, descSet});
+  AddOp(decorations, {spv::OpDecorate, bufVarID, spv::DecorationBinding, 0});
+
+  // patch in reverse so the offsets of the earlier samples stay valid
+  for(auto op = ops.rbegin(); op != ops.rend(); ++op)
   {
-    // fetch ibuffer
-    GetBufferData(state.ibuffer.buf, state.ibuffer.offs + drawcall->indexOffset * idxsize,
-                  drawcall->numIndices * idxsize, idxdata);
+    size_t s = op->offset;
+    uint16_t WordCount = spirv[s] >> spv::WordCountShift;
 
-    // figure out what the maximum index could be, so we can clamp our index buffer to something
-    // sane
-    uint32_t maxIdx = 0;
+    uint32_t sampledImageID = spirv[s + 3];
+    uint32_t coordID = spirv[s + 4];
 
-    // if there are no active bindings assume the vertex shader is generating its own data
-    // and don't clamp the indices
-    if(pipeCreateInfo.pVertexInputState->vertexBindingDescriptionCount == 0)
-      maxIdx = ~0U;
+    vector<uint32_t> code;
 
-    for(uint32_t b = 0; b < pipeCreateInfo.pVertexInputState->vertexBindingDescriptionCount; b++)
+    // the coordinate can have extra components, e.g. the array layer
+    uint32_t uvID = idBound++;
+    AddOp(code, {spv::OpVectorShuffle, v2floatID, uvID, coordID, coordID, 0, 1});
+
+    uint32_t lodID = op->lodID;
+    if(lodID == 0)
     {
-      const VkVertexInputBindingDescription &input =
-          pipeCreateInfo.pVertexInputState->pVertexBindingDescriptions[b];
-      // only vertex inputs (not instance inputs) count
-      if(input.inputRate == VK_VERTEX_INPUT_RATE_VERTEX)
-      {
-        if(b >= state.vbuffers.size())
-          continue;
+      // the first component is the mip accessed, after clamping to the view's mip range
+      uint32_t lodPairID = idBound++;
+      lodID = idBound++;
+      AddOp(code, {spv::OpImageQueryLod, v2floatID, lodPairID, sampledImageID, uvID});
+      AddOp(code, {spv::OpCompositeExtract, floatID, lodID, lodPairID, 0});
+    }
 
-        ResourceId buf = state.vbuffers[b].buf;
-        VkDeviceSize offs = state.vbuffers[b].offs;
+    // clamp an explicit lod to 0, converting a negative value to unsigned is undefined
+    uint32_t negID = idBound++;
+    uint32_t clampedID = idBound++;
+    uint32_t mipUnmaskedID = idBound++;
+    uint32_t mipID = idBound++;
+    AddOp(code, {spv::OpFOrdLessThan, boolID, negID, lodID, zeroFloatID});
+    AddOp(code, {spv::OpSelect, floatID, clampedID, negID, zeroFloatID, lodID});
+    AddOp(code, {spv::OpConvertFToU, uint32ID, mipUnmaskedID, clampedID});
+    AddOp(code, {spv::OpBitwiseAnd, uint32ID, mipID, mipUnmaskedID, mipMaskID});
+
+    // wrap the coordinate into [0, 1) and find the tile. FMod takes the sign of the divisor.
+    uint32_t wrappedID = idBound++;
+    uint32_t scaledID = idBound++;
+    uint32_t tileID = idBound++;
+    AddOp(code, {spv::OpFMod, v2floatID, wrappedID, uvID, oneVecID});
+    AddOp(code, {spv::OpVectorTimesScalar, v2floatID, scaledID, wrappedID, gridFloatID});
+    AddOp(code, {spv::OpConvertFToU, v2uintID, tileID, scaledID});
+
+    uint32_t tileXID = idBound++;
+    uint32_t tileYID = idBound++;
+    uint32_t xID = idBound++;
+    uint32_t yID = idBound++;
+    AddOp(code, {spv::OpCompositeExtract, uint32ID, tileXID, tileID, 0});
+    AddOp(code, {spv::OpCompositeExtract, uint32ID, tileYID, tileID, 1});
+    AddOp(code, {spv::OpBitwiseAnd, uint32ID, xID, tileXID, tileMaskID});
+    AddOp(code, {spv::OpBitwiseAnd, uint32ID, yID, tileYID, tileMaskID});
+
+    // bit = y * gridSize + x, word = slot base + mip * wordsPerMip + bit / 32
+    uint32_t rowID = idBound++;
+    uint32_t bitID = idBound++;
+    uint32_t wordInMipID = idBound++;
+    uint32_t bitInWordID = idBound++;
+    uint32_t maskID = idBound++;
+    uint32_t mipBaseID = idBound++;
+    uint32_t mipWordID = idBound++;
+    uint32_t wordID = idBound++;
+    AddOp(code, {spv::OpIMul, uint32ID, rowID, yID, gridID});
+    AddOp(code, {spv::OpIAdd, uint32ID, bitID, rowID, xID});
+    AddOp(code, {spv::OpShiftRightLogical, uint32ID, wordInMipID, bitID, fiveID});
+    AddOp(code, {spv::OpBitwiseAnd, uint32ID, bitInWordID, bitID, bitMaskID});
+    AddOp(code, {spv::OpShiftLeftLogical, uint32ID, maskID, oneID, bitInWordID});
+    AddOp(code, {spv::OpIMul, uint32ID, mipBaseID, mipID, wordsPerMipID});
+    AddOp(code, {spv::OpIAdd, uint32ID, mipWordID, mipBaseID, wordInMipID});
+    AddOp(code, {spv::OpIAdd, uint32ID, wordID, mipWordID, slotBaseIDs[op->slot]});
+
+    // device scope (1), no memory semantics
+    uint32_t ptrID = idBound++;
+    uint32_t prevID = idBound++;
+    AddOp(code, {spv::OpAccessChain, uintPtrID, ptrID, bufVarID, zeroID, wordID});
+    AddOp(code, {spv::OpAtomicOr, uint32ID, prevID, ptrID, oneID, zeroID, maskID});
+
+    modSpirv.insert(modSpirv.begin() + s + WordCount, code.begin(), code.end());
+
+    // update this value, since vector will have resized and/or reallocated above
+    spirv = &modSpirv[0];
+  }
 
-        VkDeviceSize bufsize = creationInfo.m_Buffer[buf].size;
+  // the functions come after all of these, so inserting the types first leaves the decoration
+  // and capability offsets valid
+  modSpirv.insert(modSpirv.begin() + typeVarOffset, typeOps.begin(), typeOps.end());
+  modSpirv.insert(modSpirv.begin() + decorateOffset, decorations.begin(), decorations.end());
 
-        // the maximum valid index on this particular input is the one that reaches
-        // the end of the buffer. The maximum valid index at all is the one that reads
-        // off the end of ALL buffers (so we max it with any other maxindex value
-        // calculated).
-        if(input.stride > 0)
-          maxIdx = RDCMAX(maxIdx, uint32_t((bufsize - offs) / input.stride));
+  if(!hasImageQuery)
+  {
+    uint32_t capOp[] = {MakeSPIRVOp(spv::OpCapability, 2), spv::CapabilityImageQuery};
+    modSpirv.insert(modSpirv.begin() + 5, capOp, capOp + ARRAY_COUNT(capOp));
+  }
+
+  // patch up the new id bound
+  modSpirv[3] = idBound;
+}
+
+// replays a range of events with each fragment shader swapped for one patched by
+// AddSamplingFeedback. Each draw writes to its own range of the feedback buffer through a dynamic
+// offset, and the texture bound to each of its slots is noted so they can be merged afterwards.
+struct VulkanSamplingFeedbackCallback : public VulkanDrawcallCallback
+{
+  VulkanSamplingFeedbackCallback(WrappedVulkan *vk, uint32_t startEventID, uint32_t endEventID,
+                                 VkDeviceSize bufSize, const VkPhysicalDeviceLimits &limits)
+      : m_pDriver(vk),
+        m_pDebug(vk->GetDebugManager()),
+        m_StartEventID(startEventID),
+        m_EndEventID(endEventID),
+        m_BufSize(bufSize),
+        m_Offset(0),
+        m_Full(false),
+        m_MaxDescSets(limits.maxBoundDescriptorSets),
+        m_Patched(false),
+        m_PrevState(NULL)
+  {
+    m_Align = RDCMAX((VkDeviceSize)1, limits.minStorageBufferOffsetAlignment);
+    m_pDriver->SetDrawcallCB(this);
+  }
+  ~VulkanSamplingFeedbackCallback()
+  {
+    m_pDriver->SetDrawcallCB(NULL);
+
+    // the commands using these must have been submitted and waited on by now
+    for(auto it = m_Pipelines.begin(); it != m_Pipelines.end(); ++it)
+    {
+      if(it->second.pipe != VK_NULL_HANDLE)
+      {
+        m_pDriver->vkDestroyPipeline(m_pDriver->GetDev(), it->second.pipe, NULL);
+        m_pDriver->vkDestroyPipelineLayout(m_pDriver->GetDev(), it->second.layout, NULL);
       }
     }
+  }
 
-    // in case the vertex buffers were set but had invalid stride (0), max with the number
-    // of vertices too. This is fine since the max here is just a conservative limit
-    maxIdx = RDCMAX(maxIdx, drawcall->numIndices);
+  struct PatchedPipeline
+  {
+    VkPipeline pipe = VK_NULL_HANDLE;
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    uint32_t descSet = 0;
+    vector<SamplingSlot> slots;
+  };
 
-    // do ibuffer rebasing/remapping
+  struct DrawFeedback
+  {
+    VkDeviceSize offset;
+    // the original ID of the texture bound to each slot
+    vector<ResourceId> textures;
+  };
 
-    idx16 = (uint16_t *)&idxdata[0];
+  PatchedPipeline &GetPipeline(ResourceId pipeline)
+  {
+    auto cached = m_Pipelines.find(pipeline);
+    if(cached != m_Pipelines.end())
+      return cached->second;
+
+    PatchedPipeline &ret = m_Pipelines[pipeline];
+
+    VulkanCreationInfo &c = *m_pDriver->GetRenderState().m_CreationInfo;
+    const VulkanCreationInfo::Pipeline &p = c.m_Pipeline[pipeline];
+
+    // the fragment shader
+    const ResourceId module = p.shaders[4].module;
+    if(module == ResourceId())
+      return ret;
+
+    // our descriptor set goes after all the application's
+    uint32_t descSet = (uint32_t)c.m_PipelineLayout[p.layout].descSetLayouts.size();
+    if(descSet + 1 > m_MaxDescSets)
+      return ret;
+
+    vector<uint32_t> spirv = c.m_ShaderModule[module].spirv.spirv;
+
+    AddSamplingFeedback(spirv, descSet, ret.slots);
+
+    if(ret.slots.empty())
+      return ret;
+
+    VkDevice dev = m_pDriver->GetDev();
+
+    VkResult vkr = VK_SUCCESS;
+
+    vector<VkDescriptorSetLayout> descSetLayouts;
+    for(uint32_t i = 0; i < descSet; i++)
+      descSetLayouts.push_back(
+          m_pDriver->GetResourceManager()->GetCurrentHandle<VkDescriptorSetLayout>(
+              c.m_PipelineLayout[p.layout].descSetLayouts[i]));
+
+    // a single dynamic storage buffer
+    descSetLayouts.push_back(m_pDebug->m_MeshFetchDescSetLayout);
+
+    const vector<VkPushConstantRange> &push = c.m_PipelineLayout[p.layout].pushRanges;
+
+    VkPipelineLayoutCreateInfo pipeLayoutInfo = {
+        VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        NULL,
+        0,
+        (uint32_t)descSetLayouts.size(),
+        &descSetLayouts[0],
+        (uint32_t)push.size(),
+        push.empty() ? NULL : &push[0],
+    };
+
+    vkr = m_pDriver->vkCreatePipelineLayout(dev, &pipeLayoutInfo, NULL, &ret.layout);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+    VkShaderModuleCreateInfo modinfo = {
+        VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO, NULL, 0, spirv.size() * sizeof(uint32_t),
+        &spirv[0],
+    };
+
+    VkShaderModule patchedModule;
+    vkr = m_pDriver->vkCreateShaderModule(dev, &modinfo, NULL, &patchedModule);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+    // everything else about the pipeline is unchanged, so the draw's output is the same
+    VkGraphicsPipelineCreateInfo pipeCreateInfo;
+    m_pDebug->MakeGraphicsPipelineInfo(pipeCreateInfo, pipeline);
+
+    pipeCreateInfo.layout = ret.layout;
+
+    for(uint32_t i = 0; i < pipeCreateInfo.stageCount; i++)
+    {
+      VkPipelineShaderStageCreateInfo &sh =
+          (VkPipelineShaderStageCreateInfo &)pipeCreateInfo.pStages[i];
+      if(sh.stage == VK_SHADER_STAGE_FRAGMENT_BIT)
+      {
+        sh.module = patchedModule;
+        // entry point name remains the same
+        break;
+      }
+    }
+
+    vkr = m_pDriver->vkCreateGraphicsPipelines(dev, VK_NULL_HANDLE, 1, &pipeCreateInfo, NULL,
+                                               &ret.pipe);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+    m_pDriver->vkDestroyShaderModule(dev, patchedModule, NULL);
+
+    ret.descSet = descSet;
+
+    return ret;
+  }
+
+  void PreDraw(uint32_t eid, VkCommandBuffer cmd)
+  {
+    m_Patched = false;
+
+    if(eid < m_StartEventID || eid > m_EndEventID || m_Full)
+      return;
+
+    VulkanRenderState &pipestate = m_pDriver->GetRenderState();
+
+    if(pipestate.graphics.pipeline == ResourceId())
+      return;
+
+    PatchedPipeline &pipe = GetPipeline(pipestate.graphics.pipeline);
+
+    if(pipe.pipe == VK_NULL_HANDLE)
+      return;
+
+    // the descriptor covers the largest number of slots, so leave room for that past the offset
+    VkDeviceSize offs = AlignUp(m_Offset, m_Align);
+    if(offs + SamplingMaxSlots * SamplingSlotWords * sizeof(uint32_t) > m_BufSize)
+    {
+      RDCWARN("Sampling feedback buffer is full, drawcalls from %u on aren't recorded", eid);
+      m_Full = true;
+      return;
+    }
+
+    m_Offset = offs + pipe.slots.size() * SamplingSlotWords * sizeof(uint32_t);
+
+    DrawFeedback draw;
+    draw.offset = offs;
+
+    for(const SamplingSlot &slot : pipe.slots)
+    {
+      ResourceId tex;
+      if(slot.set < pipestate.graphics.descSets.size())
+        tex = m_pDebug->GetDescriptorImage(pipestate.graphics.descSets[slot.set].descSet,
+                                           slot.binding, slot.arrayElement);
+      draw.textures.push_back(tex);
+    }
+
+    m_Draws.push_back(draw);
+
+    m_PrevState = pipestate;
+    m_Patched = true;
+
+    pipestate.graphics.pipeline = GetResID(pipe.pipe);
+    pipestate.graphics.descSets.resize(pipe.descSet + 1);
+    pipestate.graphics.descSets[pipe.descSet].descSet = GetResID(m_pDebug->m_MeshFetchDescSet);
+    pipestate.graphics.descSets[pipe.descSet].offsets.resize(1);
+    pipestate.graphics.descSets[pipe.descSet].offsets[0] = (uint32_t)offs;
+
+    if(cmd)
+      pipestate.BindPipeline(cmd);
+  }
+
+  bool PostDraw(uint32_t eid, VkCommandBuffer cmd)
+  {
+    if(!m_Patched)
+      return false;
+
+    m_Patched = false;
+
+    // the patched draw had the same output as the real one, so put the state back for the rest of
+    // the replay without drawing again
+    m_pDriver->GetRenderState() = m_PrevState;
+
+    RDCASSERT(cmd);
+    m_pDriver->GetRenderState().BindPipeline(cmd);
+
+    return false;
+  }
+
+  void PostRedraw(uint32_t eid, VkCommandBuffer cmd) {}
+  // Dispatches don't sample with derivatives, so do nothing
+  void PreDispatch(uint32_t eid, VkCommandBuffer cmd) {}
+  bool PostDispatch(uint32_t eid, VkCommandBuffer cmd) { return false; }
+  void PostRedispatch(uint32_t eid, VkCommandBuffer cmd) {}
+  // Ditto copy/etc
+  void PreMisc(uint32_t eid, DrawFlags flags, VkCommandBuffer cmd) {}
+  bool PostMisc(uint32_t eid, DrawFlags flags, VkCommandBuffer cmd) { return false; }
+  void PostRemisc(uint32_t eid, DrawFlags flags, VkCommandBuffer cmd) {}
+  bool RecordAllCmds() { return false; }
+  void AliasEvent(uint32_t primary, uint32_t alias)
+  {
+    // don't care
+  }
+
+  WrappedVulkan *m_pDriver;
+  VulkanDebugManager *m_pDebug;
+  uint32_t m_StartEventID, m_EndEventID;
+
+  VkDeviceSize m_BufSize, m_Align, m_Offset;
+  bool m_Full;
+  uint32_t m_MaxDescSets;
+
+  map<ResourceId, PatchedPipeline> m_Pipelines;
+  vector<DrawFeedback> m_Draws;
+
+  // whether the current draw is using a patched pipeline, and the state to restore after it
+  bool m_Patched;
+  VulkanRenderState m_PrevState;
+};
+
+ResourceId VulkanDebugManager::GetDescriptorImage(ResourceId descSet, uint32_t binding,
+                                                  uint32_t arrayElement)
+{
+  auto it = m_pDriver->m_DescriptorSetState.find(descSet);
+  if(it == m_pDriver->m_DescriptorSetState.end())
+    return ResourceId();
+
+  const vector<DescriptorSetSlot *> &bindings = it->second.currentBindings;
+  const DescSetLayout &layout = m_pDriver->m_CreationInfo.m_DescSetLayout[it->second.layout];
+
+  if(binding >= bindings.size() || binding >= layout.bindings.size() ||
+     arrayElement >= layout.bindings[binding].descriptorCount)
+    return ResourceId();
+
+  VkImageView view = bindings[binding][arrayElement].imageInfo.imageView;
+  if(view == VK_NULL_HANDLE)
+    return ResourceId();
+
+  VulkanResourceManager *rm = m_pDriver->GetResourceManager();
+
+  ResourceId viewid = rm->GetNonDispWrapper(view)->id;
+
+  return rm->GetOriginalID(m_pDriver->m_CreationInfo.m_ImageView[viewid].image);
+}
+
+vector<TextureSamplingFeedback> VulkanDebugManager::FetchTextureSampling(uint32_t startEventID,
+                                                                         uint32_t endEventID)
+{
+  vector<TextureSamplingFeedback> ret;
+
+  if(!m_pDriver->GetDeviceFeatures().fragmentStoresAndAtomics)
+    return ret;
+
+  VkResult vkr = VK_SUCCESS;
+  VkDevice dev = m_Device;
+
+  VkBuffer feedbackBuffer = VK_NULL_HANDLE, readbackBuffer = VK_NULL_HANDLE;
+  VkDeviceMemory feedbackMem = VK_NULL_HANDLE, readbackMem = VK_NULL_HANDLE;
+
+  VkBufferCreateInfo bufInfo = {
+      VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO, NULL, 0, SamplingBufferSize, 0,
+  };
+
+  bufInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+
+  vkr = m_pDriver->vkCreateBuffer(dev, &bufInfo, NULL, &feedbackBuffer);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  bufInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+  vkr = m_pDriver->vkCreateBuffer(dev, &bufInfo, NULL, &readbackBuffer);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  VkMemoryRequirements mrq = {0};
+  m_pDriver->vkGetBufferMemoryRequirements(dev, feedbackBuffer, &mrq);
+
+  VkMemoryAllocateInfo allocInfo = {
+      VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL, mrq.size,
+      m_pDriver->GetGPULocalMemoryIndex(mrq.memoryTypeBits),
+  };
+
+  vkr = m_pDriver->vkAllocateMemory(dev, &allocInfo, NULL, &feedbackMem);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  vkr = m_pDriver->vkBindBufferMemory(dev, feedbackBuffer, feedbackMem, 0);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  m_pDriver->vkGetBufferMemoryRequirements(dev, readbackBuffer, &mrq);
+
+  allocInfo.allocationSize = mrq.size;
+  allocInfo.memoryTypeIndex = m_pDriver->GetReadbackMemoryIndex(mrq.memoryTypeBits);
+
+  vkr = m_pDriver->vkAllocateMemory(dev, &allocInfo, NULL, &readbackMem);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  vkr = m_pDriver->vkBindBufferMemory(dev, readbackBuffer, readbackMem, 0);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  // the descriptor covers as many slots as a shader can use, each draw is pointed at its own range
+  // with a dynamic offset
+  VkDescriptorBufferInfo feedbackdesc = {0};
+  feedbackdesc.buffer = feedbackBuffer;
+  feedbackdesc.offset = 0;
+  feedbackdesc.range = SamplingMaxSlots * SamplingSlotWords * sizeof(uint32_t);
+
+  VkWriteDescriptorSet write = {
+      VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, NULL, m_MeshFetchDescSet, 0,   0, 1,
+      VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, NULL, &feedbackdesc,      NULL};
+  m_pDriver->vkUpdateDescriptorSets(dev, 1, &write, 0, NULL);
+
+  VkCommandBuffer cmd = m_pDriver->GetNextCmd();
+
+  VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
+                                        VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+
+  vkr = ObjDisp(dev)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  ObjDisp(dev)->CmdFillBuffer(Unwrap(cmd), Unwrap(feedbackBuffer), 0, SamplingBufferSize, 0);
+
+  VkBufferMemoryBarrier feedbackbarrier = {
+      VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+      NULL,
+      VK_ACCESS_TRANSFER_WRITE_BIT,
+      VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+      VK_QUEUE_FAMILY_IGNORED,
+      VK_QUEUE_FAMILY_IGNORED,
+      Unwrap(feedbackBuffer),
+      0,
+      SamplingBufferSize,
+  };
+
+  DoPipelineBarrier(cmd, 1, &feedbackbarrier);
+
+  vkr = ObjDisp(dev)->EndCommandBuffer(Unwrap(cmd));
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  m_pDriver->SubmitCmds();
+
+  m_pDriver->ReplayLog(0, startEventID, eReplay_WithoutDraw);
+
+  // the texture footprint of each texture, SamplingSlotWords words each
+  map<ResourceId, vector<uint32_t> > footprints;
+
+  {
+    VulkanSamplingFeedbackCallback cb(m_pDriver, startEventID, endEventID, SamplingBufferSize,
+                                      m_pDriver->GetDeviceProps().limits);
+
+    m_pDriver->ReplayLog(startEventID, endEventID, eReplay_Full);
+
+    cmd = m_pDriver->GetNextCmd();
+
+    vkr = ObjDisp(dev)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+    // wait for the feedback writes to finish
+    feedbackbarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    feedbackbarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+    DoPipelineBarrier(cmd, 1, &feedbackbarrier);
+
+    VkBufferCopy bufcopy = {
+        0, 0, SamplingBufferSize,
+    };
+
+    ObjDisp(dev)->CmdCopyBuffer(Unwrap(cmd), Unwrap(feedbackBuffer), Unwrap(readbackBuffer), 1,
+                                &bufcopy);
+
+    feedbackbarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    feedbackbarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    feedbackbarrier.buffer = Unwrap(readbackBuffer);
+
+    DoPipelineBarrier(cmd, 1, &feedbackbarrier);
+
+    vkr = ObjDisp(dev)->EndCommandBuffer(Unwrap(cmd));
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+    m_pDriver->SubmitCmds();
+    m_pDriver->FlushQ();
+
+    uint32_t *readbackData = NULL;
+    vkr = m_pDriver->vkMapMemory(dev, readbackMem, 0, VK_WHOLE_SIZE, 0, (void **)&readbackData);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+    // merge the draws that sampled from the same texture, which may have used different slots
+    for(const VulkanSamplingFeedbackCallback::DrawFeedback &draw : cb.m_Draws)
+    {
+      const uint32_t *slotData = readbackData + draw.offset / sizeof(uint32_t);
+
+      for(size_t s = 0; s < draw.textures.size(); s++, slotData += SamplingSlotWords)
+      {
+        if(draw.textures[s] == ResourceId())
+          continue;
+
+        vector<uint32_t> &footprint = footprints[draw.textures[s]];
+        footprint.resize(SamplingSlotWords);
+
+        for(uint32_t w = 0; w < SamplingSlotWords; w++)
+          footprint[w] |= slotData[w];
+      }
+    }
+
+    m_pDriver->vkUnmapMemory(dev, readbackMem);
+  }
+
+  m_pDriver->vkDestroyBuffer(dev, feedbackBuffer, NULL);
+  m_pDriver->vkDestroyBuffer(dev, readbackBuffer, NULL);
+  m_pDriver->vkFreeMemory(dev, feedbackMem, NULL);
+  m_pDriver->vkFreeMemory(dev, readbackMem, NULL);
+
+  for(auto it = footprints.begin(); it != footprints.end(); ++it)
+  {
+    TextureSamplingFeedback feedback;
+    feedback.resourceId = it->first;
+    feedback.gridSize = SamplingGridSize;
+
+    vector<SampledMip> mips;
+
+    for(uint32_t m = 0; m < SamplingMaxMips; m++)
+    {
+      const uint32_t *words = &it->second[m * SamplingWordsPerMip];
+
+      SampledMip mip;
+      mip.mip = m;
+
+      for(uint32_t w = 0; w < SamplingWordsPerMip; w++)
+        for(uint32_t bits = words[w]; bits; bits &= bits - 1)
+          mip.numTilesSampled++;
+
+      if(mip.numTilesSampled == 0)
+        continue;
+
+      mip.tiles = vector<uint32_t>(words, words + SamplingWordsPerMip);
+      mips.push_back(mip);
+    }
+
+    // every recorded sample sets a bit, but the texture may have been bound and not sampled
+    if(mips.empty())
+      continue;
+
+    feedback.mips = mips;
+    ret.push_back(feedback);
+  }
+
+  return ret;
+}
+
+void VulkanDebugManager::InitPostVSBuffers(uint32_t eventID)
+{
+  // go through any aliasing
+  if(m_PostVSAlias.find(eventID) != m_PostVSAlias.end())
+    eventID = m_PostVSAlias[eventID];
+
+  if(m_PostVSCache.Lookup(eventID))
+    return;
+
+  for(size_t i = 0; i < m_PostVSBatch.size(); i++)
+    if(m_PostVSBatch[i].eventID == eventID)
+      return;
+
+  if(!m_pDriver->GetDeviceFeatures().vertexPipelineStoresAndAtomics)
+    return;
+
+  const VulkanRenderState &state = m_pDriver->m_RenderState;
+  VulkanCreationInfo &creationInfo = m_pDriver->m_CreationInfo;
+
+  if(state.graphics.pipeline == ResourceId() || state.renderPass == ResourceId())
+    return;
+
+  const VulkanCreationInfo::Pipeline &pipeInfo = creationInfo.m_Pipeline[state.graphics.pipeline];
+
+  if(pipeInfo.shaders[0].module == ResourceId())
+    return;
+
+  const VulkanCreationInfo::ShaderModule &moduleInfo =
+      creationInfo.m_ShaderModule[pipeInfo.shaders[0].module];
+
+  ShaderReflection *refl = pipeInfo.shaders[0].refl;
+
+  // no outputs from this shader? unexpected but theoretically possible (dummy VS before
+  // tessellation maybe). Just fill out an empty data set
+  if(refl->OutputSig.count == 0)
+  {
+    // empty vertex output signature
+    m_PostVSData[eventID].vsin.topo = pipeInfo.topology;
+    m_PostVSData[eventID].vsout.buf = VK_NULL_HANDLE;
+    m_PostVSData[eventID].vsout.instStride = 0;
+    m_PostVSData[eventID].vsout.vertStride = 0;
+    m_PostVSData[eventID].vsout.nearPlane = 0.0f;
+    m_PostVSData[eventID].vsout.farPlane = 0.0f;
+    m_PostVSData[eventID].vsout.useIndices = false;
+    m_PostVSData[eventID].vsout.hasPosOut = false;
+    m_PostVSData[eventID].vsout.idxBuf = VK_NULL_HANDLE;
+
+    m_PostVSData[eventID].vsout.topo = pipeInfo.topology;
+
+    m_PostVSCache.Insert(eventID, 0);
+
+    return;
+  }
+
+  const DrawcallDescription *drawcall = m_pDriver->GetDrawcall(eventID);
+
+  if(drawcall == NULL || drawcall->numIndices == 0 || drawcall->numInstances == 0)
+    return;
+
+  uint32_t descSet = (uint32_t)creationInfo.m_PipelineLayout[pipeInfo.layout].descSetLayouts.size();
+
+  // we go through the driver for all these creations since they need to be properly
+  // registered in order to be put in the partial replay state
+  VkResult vkr = VK_SUCCESS;
+  VkDevice dev = m_Device;
+
+  VkDescriptorSetLayout *descSetLayouts;
+
+  // descSet will be the index of our new descriptor set
+  descSetLayouts = new VkDescriptorSetLayout[descSet + 1];
+
+  for(uint32_t i = 0; i < descSet; i++)
+    descSetLayouts[i] = GetResourceManager()->GetCurrentHandle<VkDescriptorSetLayout>(
+        creationInfo.m_PipelineLayout[pipeInfo.layout].descSetLayouts[i]);
+
+  // this layout just says it has one storage buffer
+  descSetLayouts[descSet] = m_MeshFetchDescSetLayout;
+
+  const vector<VkPushConstantRange> &push = creationInfo.m_PipelineLayout[pipeInfo.layout].pushRanges;
+
+  VkPipelineLayoutCreateInfo pipeLayoutInfo = {
+      VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+      NULL,
+      0,
+      descSet + 1,
+      descSetLayouts,
+      (uint32_t)push.size(),
+      push.empty() ? NULL : &push[0],
+  };
+
+  // create pipeline layout with same descriptor set layouts, plus our mesh output set
+  VkPipelineLayout pipeLayout;
+  vkr = m_pDriver->vkCreatePipelineLayout(dev, &pipeLayoutInfo, NULL, &pipeLayout);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  SAFE_DELETE_ARRAY(descSetLayouts);
+
+  VkGraphicsPipelineCreateInfo pipeCreateInfo;
+
+  // get pipeline create info
+  MakeGraphicsPipelineInfo(pipeCreateInfo, state.graphics.pipeline);
+
+  // repoint pipeline layout
+  pipeCreateInfo.layout = pipeLayout;
+
+  // set primitive topology to point list
+  VkPipelineInputAssemblyStateCreateInfo *ia =
+      (VkPipelineInputAssemblyStateCreateInfo *)pipeCreateInfo.pInputAssemblyState;
+
+  VkPrimitiveTopology topo = ia->topology;
+
+  ia->topology = VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+
+  // remove all stages but the vertex shader, we just want to run it and write the data,
+  // we don't want to tessellate/geometry shade, nor rasterize (which we disable below)
+  uint32_t vertIdx = pipeCreateInfo.stageCount;
+
+  for(uint32_t i = 0; i < pipeCreateInfo.stageCount; i++)
+  {
+    if(pipeCreateInfo.pStages[i].stage & VK_SHADER_STAGE_VERTEX_BIT)
+    {
+      vertIdx = i;
+      break;
+    }
+  }
+
+  RDCASSERT(vertIdx < pipeCreateInfo.stageCount);
+
+  if(vertIdx != 0)
+    (VkPipelineShaderStageCreateInfo &)pipeCreateInfo.pStages[0] = pipeCreateInfo.pStages[vertIdx];
+
+  pipeCreateInfo.stageCount = 1;
+
+  // enable rasterizer discard
+  VkPipelineRasterizationStateCreateInfo *rs =
+      (VkPipelineRasterizationStateCreateInfo *)pipeCreateInfo.pRasterizationState;
+  rs->rasterizerDiscardEnable = true;
+
+  VkBuffer idxBuf = VK_NULL_HANDLE, uniqIdxBuf = VK_NULL_HANDLE;
+  VkDeviceMemory idxBufMem = VK_NULL_HANDLE, uniqIdxBufMem = VK_NULL_HANDLE;
+
+  uint32_t numVerts = drawcall->numIndices;
+  VkDeviceSize bufSize = 0;
+
+  vector<uint32_t> indices;
+  uint32_t idxsize = state.ibuffer.bytewidth;
+  bool index16 = (idxsize == 2);
+  uint32_t numIndices = numVerts;
+  vector<byte> idxdata;
+  uint16_t *idx16 = NULL;
+  uint32_t *idx32 = NULL;
+
+  uint32_t minIndex = 0, maxIndex = 0;
+
+  uint32_t vertexIndexOffset = 0;
+
+  if(drawcall->flags & DrawFlags::UseIBuffer)
+  {
+    // fetch ibuffer
+    GetPostVSIndexData(state.ibuffer.buf, state.ibuffer.offs + drawcall->indexOffset * idxsize,
+                       drawcall->numIndices * idxsize, idxdata);
+
+    // figure out what the maximum index could be, so we can clamp our index buffer to something
+    // sane
+    uint32_t maxIdx = 0;
+
+    // if there are no active bindings assume the vertex shader is generating its own data
+    // and don't clamp the indices
+    if(pipeCreateInfo.pVertexInputState->vertexBindingDescriptionCount == 0)
+      maxIdx = ~0U;
+
+    for(uint32_t b = 0; b < pipeCreateInfo.pVertexInputState->vertexBindingDescriptionCount; b++)
+    {
+      const VkVertexInputBindingDescription &input =
+          pipeCreateInfo.pVertexInputState->pVertexBindingDescriptions[b];
+      // only vertex inputs (not instance inputs) count
+      if(input.inputRate == VK_VERTEX_INPUT_RATE_VERTEX)
+      {
+        if(b >= state.vbuffers.size())
+          continue;
+
+        ResourceId buf = state.vbuffers[b].buf;
+        VkDeviceSize offs = state.vbuffers[b].offs;
+
+        VkDeviceSize bufsize = creationInfo.m_Buffer[buf].size;
+
+        // the maximum valid index on this particular input is the one that reaches
+        // the end of the buffer. The maximum valid index at all is the one that reads
+        // off the end of ALL buffers (so we max it with any other maxindex value
+        // calculated).
+        if(input.stride > 0)
+          maxIdx = RDCMAX(maxIdx, uint32_t((bufsize - offs) / input.stride));
+      }
+    }
+
+    // in case the vertex buffers were set but had invalid stride (0), max with the number
+    // of vertices too. This is fine since the max here is just a conservative limit
+    maxIdx = RDCMAX(maxIdx, drawcall->numIndices);
+
+    // do ibuffer rebasing/remapping
+
+    idx16 = (uint16_t *)&idxdata[0];
     idx32 = (uint32_t *)&idxdata[0];
 
     // only read as many indices as were available in the buffer
@@ -8118,8 +9584,52 @@ void VulkanDebugManager::InitPostVSBuffers(uint32_t eventID)
     vkr = m_pDriver->vkAllocateMemory(dev, &allocInfo, NULL, &idxBufMem);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    vkr = m_pDriver->vkBindBufferMemory(dev, idxBuf, idxBufMem, 0);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    vkr = m_pDriver->vkBindBufferMemory(dev, idxBuf, idxBufMem, 0);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+    // rebase existing index buffer to point to the right elements in our stream-out'd
+    // vertex buffer
+
+    // An index buffer could be something like: 500, 520, 518, 553, 554, 556
+    // in which case we can't use the existing index buffer without filling 499 slots of vertex
+    // data with padding. Instead we rebase the indices based on the smallest index so it becomes
+    // 0, 1, 2, 1, 3, 2 and then that matches our stream-out'd buffer.
+    //
+    // Note that there could also be gaps in the indices as above which must remain as
+    // we don't have a 0-based dense 'vertex id' to base our SSBO indexing off, only index value.
+
+    bool stripRestart = pipeCreateInfo.pInputAssemblyState->primitiveRestartEnable == VK_TRUE &&
+                        IsStrip(drawcall->topology);
+
+    if(index16)
+    {
+      for(uint32_t i = 0; i < numIndices; i++)
+      {
+        if(stripRestart && idx16[i] == 0xffff)
+          continue;
+
+        idx16[i] = idx16[i] - uint16_t(minIndex);
+      }
+    }
+    else
+    {
+      for(uint32_t i = 0; i < numIndices; i++)
+      {
+        if(stripRestart && idx32[i] == 0xffffffff)
+          continue;
+
+        idx32[i] -= minIndex;
+      }
+    }
+
+    // upload rebased memory
+    idxData = NULL;
+    vkr = m_pDriver->vkMapMemory(m_Device, idxBufMem, 0, VK_WHOLE_SIZE, 0, (void **)&idxData);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+    memcpy(idxData, idx32, numIndices * idxsize);
+
+    m_pDriver->vkUnmapMemory(m_Device, idxBufMem);
   }
   else
   {
@@ -8158,8 +9668,8 @@ void VulkanDebugManager::InitPostVSBuffers(uint32_t eventID)
 
   // create new pipeline
   VkPipeline pipe;
-  vkr = m_pDriver->vkCreateGraphicsPipelines(m_Device, VK_NULL_HANDLE, 1, &pipeCreateInfo, NULL,
-                                             &pipe);
+  vkr = m_pDriver->vkCreateGraphicsPipelines(m_Device, m_InternalPipelineCache, 1, &pipeCreateInfo,
+                                             NULL, &pipe);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
   // make copy of state to draw from
@@ -8174,422 +9684,524 @@ void VulkanDebugManager::InitPostVSBuffers(uint32_t eventID)
   // bind to the slot we're using
   modifiedstate.graphics.descSets.resize(descSet + 1);
   modifiedstate.graphics.descSets[descSet].descSet = GetResID(m_MeshFetchDescSet);
+  // the offset into the output buffer is filled in once the whole batch is laid out
+  modifiedstate.graphics.descSets[descSet].offsets.resize(1);
 
-  if(!(drawcall->flags & DrawFlags::UseIBuffer))
+  if(drawcall->flags & DrawFlags::UseIBuffer)
   {
-    // create buffer of sufficient size (num indices * bufStride)
-    VkBufferCreateInfo bufInfo = {
-        VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-        NULL,
-        0,
-        drawcall->numIndices * drawcall->numInstances * bufStride,
-        0,
-    };
+    // bind unique'd ibuffer
+    modifiedstate.ibuffer.bytewidth = 4;
+    modifiedstate.ibuffer.offs = 0;
+    modifiedstate.ibuffer.buf = GetResID(uniqIdxBuf);
 
-    bufSize = bufInfo.size;
+    // this can't just be bufStride * num unique indices per instance, as we don't
+    // have a compact 0-based index to index into the buffer. We must use
+    // index-minIndex which is 0-based but potentially sparse, so this buffer may
+    // be more or less wasteful
+    bufSize = numVerts * drawcall->numInstances * bufStride;
+  }
+  else
+  {
+    bufSize = drawcall->numIndices * drawcall->numInstances * bufStride;
+  }
 
-    bufInfo.usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-    bufInfo.usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
-    bufInfo.usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
-    bufInfo.usage |= VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+  PostVSEvent ev(modifiedstate);
+
+  ev.eventID = eventID;
+  ev.pipeLayout = pipeLayout;
+  ev.pipe = pipe;
+  ev.module = module;
+  ev.descSet = descSet;
+
+  ev.indexed = bool(drawcall->flags & DrawFlags::UseIBuffer);
+  ev.instanced = bool(drawcall->flags & DrawFlags::Instanced);
+  ev.numIndices = drawcall->numIndices;
+  ev.numInstances = drawcall->numInstances;
+  ev.vertexOffset = drawcall->vertexOffset;
+  ev.instanceOffset = drawcall->instanceOffset;
+  ev.baseVertex = drawcall->baseVertex;
+
+  ev.topo = topo;
+  ev.hasPosOut = refl->OutputSig[0].systemValue == ShaderBuiltin::Position;
+  ev.numVerts = numVerts;
+  ev.bufStride = bufStride;
+  ev.bufSize = bufSize;
+  ev.bufOffset = 0;
+
+  ev.numUniqueIndices = (uint32_t)indices.size();
+  ev.uniqIdxBuf = uniqIdxBuf;
+  ev.uniqIdxBufMem = uniqIdxBufMem;
+  ev.idxBuf = idxBuf;
+  ev.idxBufMem = idxBufMem;
+  ev.idxBufSize = numIndices * idxsize;
+  ev.idxFmt = index16 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+
+  m_PostVSBatch.push_back(ev);
+  m_PostVSBatchSize += bufSize;
+
+  // outside of a batch fetch straight away, otherwise wait until the batch is done unless it's
+  // grown too large to keep in one buffer
+  if(!m_PostVSBatching || m_PostVSBatchSize >= POSTVS_BATCH_MAX_SIZE)
+    FetchPostVSBatch();
+}
 
-    vkr = m_pDriver->vkCreateBuffer(dev, &bufInfo, NULL, &meshBuffer);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+void VulkanDebugManager::TrimPostVSCache(uint32_t eventID)
+{
+  if(m_PostVSAlias.find(eventID) != m_PostVSAlias.end())
+    eventID = m_PostVSAlias[eventID];
 
-    bufInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  std::vector<uint32_t> evicted = m_PostVSCache.Trim(eventID);
 
-    vkr = m_pDriver->vkCreateBuffer(dev, &bufInfo, NULL, &readbackBuffer);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  for(size_t i = 0; i < evicted.size(); i++)
+  {
+    VulkanPostVSData::StageData &vsout = m_PostVSData[evicted[i]].vsout;
 
-    VkMemoryRequirements mrq = {0};
-    m_pDriver->vkGetBufferMemoryRequirements(dev, meshBuffer, &mrq);
+    if(vsout.bufmem != VK_NULL_HANDLE)
+    {
+      m_pDriver->vkDestroyBuffer(m_Device, vsout.buf, NULL);
+      m_pDriver->vkFreeMemory(m_Device, vsout.bufmem, NULL);
+    }
+    else if(vsout.buf != VK_NULL_HANDLE)
+    {
+      // only free a batch's buffer once none of its events are left
+      auto it = m_PostVSBatchBuffers.find(vsout.buf);
+      if(it != m_PostVSBatchBuffers.end() && --it->second.second == 0)
+      {
+        m_pDriver->vkDestroyBuffer(m_Device, it->first, NULL);
+        m_pDriver->vkFreeMemory(m_Device, it->second.first, NULL);
+        m_PostVSBatchBuffers.erase(it);
+      }
+    }
 
-    VkMemoryAllocateInfo allocInfo = {
-        VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL, mrq.size,
-        m_pDriver->GetGPULocalMemoryIndex(mrq.memoryTypeBits),
-    };
+    m_pDriver->vkDestroyBuffer(m_Device, vsout.idxBuf, NULL);
+    m_pDriver->vkFreeMemory(m_Device, vsout.idxBufMem, NULL);
 
-    vkr = m_pDriver->vkAllocateMemory(dev, &allocInfo, NULL, &meshMem);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    m_PostVSData.erase(evicted[i]);
+  }
+}
 
-    vkr = m_pDriver->vkBindBufferMemory(dev, meshBuffer, meshMem, 0);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+static uint64_t GetBuffersSize(const VulkanDebugManager::GPUBuffer *const *bufs, size_t count,
+                               uint64_t &num)
+{
+  uint64_t ret = 0;
 
-    m_pDriver->vkGetBufferMemoryRequirements(dev, readbackBuffer, &mrq);
+  for(size_t i = 0; i < count; i++)
+  {
+    if(bufs[i]->buf == VK_NULL_HANDLE)
+      continue;
 
-    allocInfo.memoryTypeIndex = m_pDriver->GetReadbackMemoryIndex(mrq.memoryTypeBits);
+    ret += bufs[i]->totalsize;
+    num++;
+  }
 
-    vkr = m_pDriver->vkAllocateMemory(dev, &allocInfo, NULL, &readbackMem);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  return ret;
+}
 
-    vkr = m_pDriver->vkBindBufferMemory(dev, readbackBuffer, readbackMem, 0);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+void VulkanDebugManager::GetMemoryUsage(vector<MemoryUsage> &usage)
+{
+  usage.push_back(MakeMemoryUsage("Post-VS data", true, m_PostVSCache.NumEvents(),
+                                  m_PostVSCache.GetStats().bytes));
+
+  uint64_t count = 0, bytes = 0;
+  if(m_OverlayImageMem != VK_NULL_HANDLE)
+  {
+    count++;
+    bytes += m_OverlayMemSize;
+  }
+  if(m_CustomTexMem != VK_NULL_HANDLE)
+  {
+    count++;
+    bytes += m_CustomTexMemSize;
+  }
+  usage.push_back(MakeMemoryUsage("Overlays", true, count, bytes));
+
+  count = 0;
+  const GPUBuffer *readback[] = {&m_ReadbackWindow,    &m_PickPixelReadbackBuffer,
+                                 &m_MinMaxTileResult,  &m_MinMaxResult,
+                                 &m_MinMaxReadback,    &m_HistogramBuf,
+                                 &m_HistogramReadback, &m_MeshPickResult,
+                                 &m_MeshPickResultReadback};
+  bytes = GetBuffersSize(readback, ARRAY_COUNT(readback), count);
+  usage.push_back(MakeMemoryUsage("Readback", true, count, bytes));
+
+  count = 0;
+  const GPUBuffer *mesh[] = {&m_MeshPickIB, &m_MeshPickIBUpload, &m_MeshPickVB,
+                             &m_MeshPickVBUpload};
+  bytes = GetBuffersSize(mesh, ARRAY_COUNT(mesh), count);
+  usage.push_back(MakeMemoryUsage("Mesh data", true, count, bytes));
+}
+
+void VulkanDebugManager::BeginPostVSBatch()
+{
+  m_PostVSBatching = true;
+}
 
-    // vkUpdateDescriptorSet desc set to point to buffer
-    VkDescriptorBufferInfo fetchdesc = {0};
-    fetchdesc.buffer = meshBuffer;
-    fetchdesc.offset = 0;
-    fetchdesc.range = bufInfo.size;
+void VulkanDebugManager::EndPostVSBatch()
+{
+  FetchPostVSBatch();
 
-    VkWriteDescriptorSet write = {
-        VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, NULL, m_MeshFetchDescSet, 0,   0, 1,
-        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,      NULL, &fetchdesc,         NULL};
-    m_pDriver->vkUpdateDescriptorSets(dev, 1, &write, 0, NULL);
+  m_PostVSBatching = false;
+  m_PostVSIndexCache.clear();
+}
 
-    VkCommandBuffer cmd = m_pDriver->GetNextCmd();
+void VulkanDebugManager::GetPostVSIndexData(ResourceId buf, uint64_t offset, uint64_t len,
+                                            vector<byte> &ret)
+{
+  uint64_t size = m_pDriver->m_CreationInfo.m_Buffer[buf].size;
 
-    VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
-                                          VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+  // outside of a batch, or for huge buffers, just read back the range that's needed
+  if(!m_PostVSBatching || size > POSTVS_INDEX_CACHE_MAX_SIZE)
+  {
+    GetBufferData(buf, offset, len, ret);
+    return;
+  }
 
-    vkr = ObjDisp(dev)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  // draws in a pass very often share an index buffer, so read it back once for all of them
+  auto it = m_PostVSIndexCache.find(buf);
+  if(it == m_PostVSIndexCache.end())
+  {
+    it = m_PostVSIndexCache.insert(std::make_pair(buf, vector<byte>())).first;
+    GetBufferData(buf, 0, size, it->second);
+  }
 
-    // do single draw
-    modifiedstate.BeginRenderPassAndApplyState(cmd);
-    ObjDisp(cmd)->CmdDraw(Unwrap(cmd), drawcall->numIndices, drawcall->numInstances,
-                          drawcall->vertexOffset, drawcall->instanceOffset);
-    modifiedstate.EndRenderPass(cmd);
+  const vector<byte> &data = it->second;
 
-    VkBufferMemoryBarrier meshbufbarrier = {
-        VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
-        NULL,
-        VK_ACCESS_SHADER_WRITE_BIT,
-        VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
-        VK_QUEUE_FAMILY_IGNORED,
-        VK_QUEUE_FAMILY_IGNORED,
-        Unwrap(meshBuffer),
-        0,
-        bufInfo.size,
-    };
+  ret.clear();
 
-    // wait for writing to finish
-    DoPipelineBarrier(cmd, 1, &meshbufbarrier);
+  if(offset >= data.size())
+    return;
 
-    VkBufferCopy bufcopy = {
-        0, 0, bufInfo.size,
-    };
+  len = RDCMIN(len, data.size() - offset);
 
-    // copy to readback buffer
-    ObjDisp(dev)->CmdCopyBuffer(Unwrap(cmd), Unwrap(meshBuffer), Unwrap(readbackBuffer), 1, &bufcopy);
+  ret.insert(ret.end(), data.begin() + (size_t)offset, data.begin() + (size_t)(offset + len));
+}
+
+void VulkanDebugManager::FetchPostVSBatch()
+{
+  if(m_PostVSBatch.empty())
+    return;
 
-    meshbufbarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    meshbufbarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
-    meshbufbarrier.buffer = Unwrap(readbackBuffer);
+  VkResult vkr = VK_SUCCESS;
+  VkDevice dev = m_Device;
 
-    // wait for copy to finish
-    DoPipelineBarrier(cmd, 1, &meshbufbarrier);
+  // lay out each event's output one after another in a single buffer. Each draw is pointed at its
+  // own range with a dynamic offset into the same descriptor, which covers the largest range.
+  VkDeviceSize align =
+      RDCMAX((VkDeviceSize)1,
+             m_pDriver->GetDeviceProps().limits.minStorageBufferOffsetAlignment);
 
-    vkr = ObjDisp(dev)->EndCommandBuffer(Unwrap(cmd));
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  VkDeviceSize maxRange = 4;
+  VkDeviceSize offs = 0;
 
-    // submit & flush so that we don't have to keep pipeline around for a while
-    m_pDriver->SubmitCmds();
-    m_pDriver->FlushQ();
-  }
-  else
+  for(size_t i = 0; i < m_PostVSBatch.size(); i++)
   {
-    // create buffer of sufficient size
-    // this can't just be bufStride * num unique indices per instance, as we don't
-    // have a compact 0-based index to index into the buffer. We must use
-    // index-minIndex which is 0-based but potentially sparse, so this buffer may
-    // be more or less wasteful
-    VkBufferCreateInfo bufInfo = {
-        VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,          NULL, 0,
-        numVerts * drawcall->numInstances * bufStride, 0,
-    };
+    PostVSEvent &ev = m_PostVSBatch[i];
 
-    bufInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-    bufInfo.usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
-    bufInfo.usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
-    bufInfo.usage |= VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    ev.bufOffset = AlignUp(offs, align);
+    offs = ev.bufOffset + ev.bufSize;
 
-    vkr = m_pDriver->vkCreateBuffer(dev, &bufInfo, NULL, &meshBuffer);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    maxRange = RDCMAX(maxRange, ev.bufSize);
+  }
 
-    bufInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  // make sure the descriptor's range fits at the last offset
+  VkDeviceSize bufSize = m_PostVSBatch.back().bufOffset + maxRange;
 
-    vkr = m_pDriver->vkCreateBuffer(dev, &bufInfo, NULL, &readbackBuffer);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  VkBuffer meshBuffer = VK_NULL_HANDLE, readbackBuffer = VK_NULL_HANDLE;
+  VkDeviceMemory meshMem = VK_NULL_HANDLE, readbackMem = VK_NULL_HANDLE;
 
-    VkMemoryRequirements mrq = {0};
-    m_pDriver->vkGetBufferMemoryRequirements(dev, meshBuffer, &mrq);
+  VkBufferCreateInfo bufInfo = {
+      VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO, NULL, 0, bufSize, 0,
+  };
 
-    VkMemoryAllocateInfo allocInfo = {
-        VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL, mrq.size,
-        m_pDriver->GetGPULocalMemoryIndex(mrq.memoryTypeBits),
-    };
+  bufInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+  bufInfo.usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  bufInfo.usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+  bufInfo.usage |= VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
 
-    vkr = m_pDriver->vkAllocateMemory(dev, &allocInfo, NULL, &meshMem);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  vkr = m_pDriver->vkCreateBuffer(dev, &bufInfo, NULL, &meshBuffer);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    vkr = m_pDriver->vkBindBufferMemory(dev, meshBuffer, meshMem, 0);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  bufInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
 
-    m_pDriver->vkGetBufferMemoryRequirements(dev, readbackBuffer, &mrq);
+  vkr = m_pDriver->vkCreateBuffer(dev, &bufInfo, NULL, &readbackBuffer);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    allocInfo.memoryTypeIndex = m_pDriver->GetReadbackMemoryIndex(mrq.memoryTypeBits);
+  VkMemoryRequirements mrq = {0};
+  m_pDriver->vkGetBufferMemoryRequirements(dev, meshBuffer, &mrq);
 
-    vkr = m_pDriver->vkAllocateMemory(dev, &allocInfo, NULL, &readbackMem);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  VkMemoryAllocateInfo allocInfo = {
+      VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL, mrq.size,
+      m_pDriver->GetGPULocalMemoryIndex(mrq.memoryTypeBits),
+  };
 
-    vkr = m_pDriver->vkBindBufferMemory(dev, readbackBuffer, readbackMem, 0);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  vkr = m_pDriver->vkAllocateMemory(dev, &allocInfo, NULL, &meshMem);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  vkr = m_pDriver->vkBindBufferMemory(dev, meshBuffer, meshMem, 0);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    VkBufferMemoryBarrier meshbufbarrier = {
+  m_pDriver->vkGetBufferMemoryRequirements(dev, readbackBuffer, &mrq);
+
+  allocInfo.allocationSize = mrq.size;
+  allocInfo.memoryTypeIndex = m_pDriver->GetReadbackMemoryIndex(mrq.memoryTypeBits);
+
+  vkr = m_pDriver->vkAllocateMemory(dev, &allocInfo, NULL, &readbackMem);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  vkr = m_pDriver->vkBindBufferMemory(dev, readbackBuffer, readbackMem, 0);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  // vkUpdateDescriptorSet desc set to point to buffer
+  VkDescriptorBufferInfo fetchdesc = {0};
+  fetchdesc.buffer = meshBuffer;
+  fetchdesc.offset = 0;
+  fetchdesc.range = maxRange;
+
+  VkWriteDescriptorSet write = {
+      VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, NULL, m_MeshFetchDescSet, 0,   0, 1,
+      VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, NULL, &fetchdesc,         NULL};
+  m_pDriver->vkUpdateDescriptorSets(dev, 1, &write, 0, NULL);
+
+  VkCommandBuffer cmd = m_pDriver->GetNextCmd();
+
+  VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
+                                        VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+
+  vkr = ObjDisp(dev)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  // wait for all the index uploads to finish
+  vector<VkBufferMemoryBarrier> idxbarriers;
+
+  for(size_t i = 0; i < m_PostVSBatch.size(); i++)
+  {
+    const PostVSEvent &ev = m_PostVSBatch[i];
+
+    if(!ev.indexed)
+      continue;
+
+    VkBufferMemoryBarrier idxbarrier = {
         VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
         NULL,
         VK_ACCESS_HOST_WRITE_BIT,
         VK_ACCESS_INDEX_READ_BIT,
         VK_QUEUE_FAMILY_IGNORED,
         VK_QUEUE_FAMILY_IGNORED,
-        Unwrap(uniqIdxBuf),
+        Unwrap(ev.uniqIdxBuf),
         0,
-        indices.size() * sizeof(uint32_t),
+        ev.numUniqueIndices * sizeof(uint32_t),
     };
 
-    VkCommandBuffer cmd = m_pDriver->GetNextCmd();
+    idxbarriers.push_back(idxbarrier);
 
-    VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
-                                          VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+    idxbarrier.buffer = Unwrap(ev.idxBuf);
+    idxbarrier.size = ev.idxBufSize;
 
-    vkr = ObjDisp(dev)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    idxbarriers.push_back(idxbarrier);
+  }
 
-    // wait for upload to finish
-    DoPipelineBarrier(cmd, 1, &meshbufbarrier);
+  if(!idxbarriers.empty())
+    DoPipelineBarrier(cmd, (uint32_t)idxbarriers.size(), &idxbarriers[0]);
 
-    // fill destination buffer with 0s to ensure unwritten vertices have sane data
-    ObjDisp(dev)->CmdFillBuffer(Unwrap(cmd), Unwrap(meshBuffer), 0, bufInfo.size, 0);
+  // fill destination buffer with 0s to ensure unwritten vertices have sane data
+  ObjDisp(dev)->CmdFillBuffer(Unwrap(cmd), Unwrap(meshBuffer), 0, bufSize, 0);
 
-    // wait to finish
-    meshbufbarrier.buffer = Unwrap(meshBuffer);
-    meshbufbarrier.size = bufInfo.size;
-    DoPipelineBarrier(cmd, 1, &meshbufbarrier);
+  VkBufferMemoryBarrier meshbufbarrier = {
+      VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+      NULL,
+      VK_ACCESS_TRANSFER_WRITE_BIT,
+      VK_ACCESS_SHADER_WRITE_BIT,
+      VK_QUEUE_FAMILY_IGNORED,
+      VK_QUEUE_FAMILY_IGNORED,
+      Unwrap(meshBuffer),
+      0,
+      bufSize,
+  };
 
-    // set bufSize
-    bufSize = numVerts * drawcall->numInstances * bufStride;
+  // wait to finish
+  DoPipelineBarrier(cmd, 1, &meshbufbarrier);
 
-    // bind unique'd ibuffer
-    modifiedstate.ibuffer.bytewidth = 4;
-    modifiedstate.ibuffer.offs = 0;
-    modifiedstate.ibuffer.buf = GetResID(uniqIdxBuf);
+  // record every draw, each writing into its own range of the buffer
+  for(size_t i = 0; i < m_PostVSBatch.size(); i++)
+  {
+    PostVSEvent &ev = m_PostVSBatch[i];
 
-    // vkUpdateDescriptorSet desc set to point to buffer
-    VkDescriptorBufferInfo fetchdesc = {0};
-    fetchdesc.buffer = meshBuffer;
-    fetchdesc.offset = 0;
-    fetchdesc.range = bufInfo.size;
+    ev.state.graphics.descSets[ev.descSet].offsets[0] = (uint32_t)ev.bufOffset;
 
-    VkWriteDescriptorSet write = {
-        VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, NULL, m_MeshFetchDescSet, 0,   0, 1,
-        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,      NULL, &fetchdesc,         NULL};
-    m_pDriver->vkUpdateDescriptorSets(dev, 1, &write, 0, NULL);
+    ev.state.BeginRenderPassAndApplyState(cmd);
+    if(ev.indexed)
+      ObjDisp(cmd)->CmdDrawIndexed(Unwrap(cmd), ev.numUniqueIndices, ev.numInstances, 0,
+                                   ev.baseVertex, ev.instanceOffset);
+    else
+      ObjDisp(cmd)->CmdDraw(Unwrap(cmd), ev.numIndices, ev.numInstances, ev.vertexOffset,
+                            ev.instanceOffset);
+    ev.state.EndRenderPass(cmd);
+  }
 
-    // do single draw
-    modifiedstate.BeginRenderPassAndApplyState(cmd);
-    ObjDisp(cmd)->CmdDrawIndexed(Unwrap(cmd), (uint32_t)indices.size(), drawcall->numInstances, 0,
-                                 drawcall->baseVertex, drawcall->instanceOffset);
-    modifiedstate.EndRenderPass(cmd);
+  // wait for mesh output writing to finish
+  meshbufbarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  meshbufbarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
 
-    // rebase existing index buffer to point to the right elements in our stream-out'd
-    // vertex buffer
+  DoPipelineBarrier(cmd, 1, &meshbufbarrier);
 
-    // An index buffer could be something like: 500, 520, 518, 553, 554, 556
-    // in which case we can't use the existing index buffer without filling 499 slots of vertex
-    // data with padding. Instead we rebase the indices based on the smallest index so it becomes
-    // 0, 1, 2, 1, 3, 2 and then that matches our stream-out'd buffer.
-    //
-    // Note that there could also be gaps in the indices as above which must remain as
-    // we don't have a 0-based dense 'vertex id' to base our SSBO indexing off, only index value.
+  VkBufferCopy bufcopy = {
+      0, 0, bufSize,
+  };
 
-    bool stripRestart = pipeCreateInfo.pInputAssemblyState->primitiveRestartEnable == VK_TRUE &&
-                        IsStrip(drawcall->topology);
+  // copy to readback buffer
+  ObjDisp(dev)->CmdCopyBuffer(Unwrap(cmd), Unwrap(meshBuffer), Unwrap(readbackBuffer), 1, &bufcopy);
 
-    if(index16)
-    {
-      for(uint32_t i = 0; i < numIndices; i++)
-      {
-        if(stripRestart && idx16[i] == 0xffff)
-          continue;
+  meshbufbarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  meshbufbarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+  meshbufbarrier.buffer = Unwrap(readbackBuffer);
 
-        idx16[i] = idx16[i] - uint16_t(minIndex);
-      }
-    }
-    else
-    {
-      for(uint32_t i = 0; i < numIndices; i++)
-      {
-        if(stripRestart && idx32[i] == 0xffffffff)
-          continue;
+  // wait for copy to finish
+  DoPipelineBarrier(cmd, 1, &meshbufbarrier);
 
-        idx32[i] -= minIndex;
-      }
-    }
+  vkr = ObjDisp(dev)->EndCommandBuffer(Unwrap(cmd));
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    // upload rebased memory
-    byte *idxData = NULL;
-    vkr = m_pDriver->vkMapMemory(m_Device, idxBufMem, 0, VK_WHOLE_SIZE, 0, (void **)&idxData);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  // submit & flush once for the whole batch, so that we don't have to keep pipelines around
+  m_pDriver->SubmitCmds();
+  m_pDriver->FlushQ();
 
-    memcpy(idxData, idx32, numIndices * idxsize);
+  // readback mesh data
+  byte *readbackData = NULL;
+  vkr = m_pDriver->vkMapMemory(m_Device, readbackMem, 0, VK_WHOLE_SIZE, 0, (void **)&readbackData);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    m_pDriver->vkUnmapMemory(m_Device, idxBufMem);
+  // a lone event owns its buffer, otherwise the buffer is shared and freed along with the others
+  bool shared = m_PostVSBatch.size() > 1;
 
-    meshbufbarrier.buffer = Unwrap(idxBuf);
-    meshbufbarrier.size = numIndices * idxsize;
+  if(shared)
+    m_PostVSBatchBuffers[meshBuffer] = std::make_pair(meshMem, (uint32_t)m_PostVSBatch.size());
 
-    // wait for upload to finish
-    DoPipelineBarrier(cmd, 1, &meshbufbarrier);
+  for(size_t e = 0; e < m_PostVSBatch.size(); e++)
+  {
+    const PostVSEvent &ev = m_PostVSBatch[e];
 
-    // wait for mesh output writing to finish
-    meshbufbarrier.buffer = Unwrap(meshBuffer);
-    meshbufbarrier.size = bufSize;
-    meshbufbarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-    meshbufbarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    byte *byteData = readbackData + ev.bufOffset;
+    uint32_t numVerts = ev.numVerts;
+    uint32_t bufStride = ev.bufStride;
 
-    DoPipelineBarrier(cmd, 1, &meshbufbarrier);
+    // do near/far calculations
 
-    VkBufferCopy bufcopy = {
-        0, 0, bufInfo.size,
-    };
+    float nearp = 0.1f;
+    float farp = 100.0f;
 
-    // copy to readback buffer
-    ObjDisp(dev)->CmdCopyBuffer(Unwrap(cmd), Unwrap(meshBuffer), Unwrap(readbackBuffer), 1, &bufcopy);
+    Vec4f *pos0 = (Vec4f *)byteData;
 
-    meshbufbarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    meshbufbarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
-    meshbufbarrier.buffer = Unwrap(readbackBuffer);
+    bool found = false;
 
-    // wait for copy to finish
-    DoPipelineBarrier(cmd, 1, &meshbufbarrier);
+    // expect position at the start of the buffer, as system values are sorted first
+    // and position is the first value
 
-    vkr = ObjDisp(dev)->EndCommandBuffer(Unwrap(cmd));
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    for(uint32_t i = 1; ev.hasPosOut && i < numVerts; i++)
+    {
+      //////////////////////////////////////////////////////////////////////////////////
+      // derive near/far, assuming a standard perspective matrix
+      //
+      // the transformation from from pre-projection {Z,W} to post-projection {Z,W}
+      // is linear. So we can say Zpost = Zpre*m + c . Here we assume Wpre = 1
+      // and we know Wpost = Zpre from the perspective matrix.
+      // we can then see from the perspective matrix that
+      // m = F/(F-N)
+      // c = -(F*N)/(F-N)
+      //
+      // with re-arranging and substitution, we then get:
+      // N = -c/m
+      // F = c/(1-m)
+      //
+      // so if we can derive m and c then we can determine N and F. We can do this with
+      // two points, and we pick them reasonably distinct on z to reduce floating-point
+      // error
+
+      Vec4f *pos = (Vec4f *)(byteData + i * bufStride);
+
+      // skip invalid vertices (w=0)
+      if(pos->w != 0.0f && fabs(pos->w - pos0->w) > 0.01f && fabs(pos->z - pos0->z) > 0.01f)
+      {
+        Vec2f A(pos0->w, pos0->z);
+        Vec2f B(pos->w, pos->z);
 
-    // submit & flush so that we don't have to keep pipeline around for a while
-    m_pDriver->SubmitCmds();
-    m_pDriver->FlushQ();
-  }
+        float m = (B.y - A.y) / (B.x - A.x);
+        float c = B.y - B.x * m;
 
-  // readback mesh data
-  byte *byteData = NULL;
-  vkr = m_pDriver->vkMapMemory(m_Device, readbackMem, 0, VK_WHOLE_SIZE, 0, (void **)&byteData);
+        if(m == 1.0f)
+          continue;
 
-  // do near/far calculations
+        if(-c / m <= 0.000001f)
+          continue;
 
-  float nearp = 0.1f;
-  float farp = 100.0f;
+        nearp = -c / m;
+        farp = c / (1 - m);
 
-  Vec4f *pos0 = (Vec4f *)byteData;
+        found = true;
 
-  bool found = false;
+        break;
+      }
+    }
 
-  // expect position at the start of the buffer, as system values are sorted first
-  // and position is the first value
+    // if we didn't find anything, all z's and w's were identical.
+    // If the z is positive and w greater for the first element then
+    // we detect this projection as reversed z with infinite far plane
+    if(!found && pos0->z > 0.0f && pos0->w > pos0->z)
+    {
+      nearp = pos0->z;
+      farp = FLT_MAX;
+    }
 
-  for(uint32_t i = 1; refl->OutputSig[0].systemValue == ShaderBuiltin::Position && i < numVerts; i++)
-  {
-    //////////////////////////////////////////////////////////////////////////////////
-    // derive near/far, assuming a standard perspective matrix
-    //
-    // the transformation from from pre-projection {Z,W} to post-projection {Z,W}
-    // is linear. So we can say Zpost = Zpre*m + c . Here we assume Wpre = 1
-    // and we know Wpost = Zpre from the perspective matrix.
-    // we can then see from the perspective matrix that
-    // m = F/(F-N)
-    // c = -(F*N)/(F-N)
-    //
-    // with re-arranging and substitution, we then get:
-    // N = -c/m
-    // F = c/(1-m)
-    //
-    // so if we can derive m and c then we can determine N and F. We can do this with
-    // two points, and we pick them reasonably distinct on z to reduce floating-point
-    // error
+    VulkanPostVSData &postvs = m_PostVSData[ev.eventID];
 
-    Vec4f *pos = (Vec4f *)(byteData + i * bufStride);
+    // fill out m_PostVSData
+    postvs.vsin.topo = ev.topo;
+    postvs.vsout.topo = ev.topo;
+    postvs.vsout.buf = meshBuffer;
+    postvs.vsout.bufmem = shared ? VK_NULL_HANDLE : meshMem;
+    postvs.vsout.bufOffset = ev.bufOffset;
 
-    // skip invalid vertices (w=0)
-    if(pos->w != 0.0f && fabs(pos->w - pos0->w) > 0.01f && fabs(pos->z - pos0->z) > 0.01f)
-    {
-      Vec2f A(pos0->w, pos0->z);
-      Vec2f B(pos->w, pos->z);
+    postvs.vsout.vertStride = bufStride;
+    postvs.vsout.nearPlane = nearp;
+    postvs.vsout.farPlane = farp;
 
-      float m = (B.y - A.y) / (B.x - A.x);
-      float c = B.y - B.x * m;
+    postvs.vsout.useIndices = ev.indexed;
+    postvs.vsout.numVerts = ev.numIndices;
 
-      if(m == 1.0f)
-        continue;
+    postvs.vsout.instStride = 0;
+    if(ev.instanced)
+      postvs.vsout.instStride = uint32_t(ev.bufSize / ev.numInstances);
 
-      if(-c / m <= 0.000001f)
-        continue;
+    postvs.vsout.idxBuf = VK_NULL_HANDLE;
+    if(postvs.vsout.useIndices && ev.idxBuf != VK_NULL_HANDLE)
+    {
+      postvs.vsout.idxBuf = ev.idxBuf;
+      postvs.vsout.idxBufMem = ev.idxBufMem;
+      postvs.vsout.idxFmt = ev.idxFmt;
+    }
 
-      nearp = -c / m;
-      farp = c / (1 - m);
+    postvs.vsout.hasPosOut = ev.hasPosOut;
 
-      found = true;
+    m_PostVSCache.Insert(ev.eventID, ev.bufSize + (ev.indexed ? ev.idxBufSize : 0));
 
-      break;
+    // clean up temporary objects
+    if(ev.uniqIdxBuf != VK_NULL_HANDLE)
+    {
+      m_pDriver->vkDestroyBuffer(m_Device, ev.uniqIdxBuf, NULL);
+      m_pDriver->vkFreeMemory(m_Device, ev.uniqIdxBufMem, NULL);
     }
-  }
 
-  // if we didn't find anything, all z's and w's were identical.
-  // If the z is positive and w greater for the first element then
-  // we detect this projection as reversed z with infinite far plane
-  if(!found && pos0->z > 0.0f && pos0->w > pos0->z)
-  {
-    nearp = pos0->z;
-    farp = FLT_MAX;
+    m_pDriver->vkDestroyPipelineLayout(dev, ev.pipeLayout, NULL);
+    m_pDriver->vkDestroyPipeline(dev, ev.pipe, NULL);
+    m_pDriver->vkDestroyShaderModule(dev, ev.module, NULL);
   }
 
   m_pDriver->vkUnmapMemory(m_Device, readbackMem);
 
-  // clean up temporary memories
   m_pDriver->vkDestroyBuffer(m_Device, readbackBuffer, NULL);
   m_pDriver->vkFreeMemory(m_Device, readbackMem, NULL);
 
-  if(uniqIdxBuf != VK_NULL_HANDLE)
-  {
-    m_pDriver->vkDestroyBuffer(m_Device, uniqIdxBuf, NULL);
-    m_pDriver->vkFreeMemory(m_Device, uniqIdxBufMem, NULL);
-  }
-
-  // fill out m_PostVSData
-  m_PostVSData[eventID].vsin.topo = topo;
-  m_PostVSData[eventID].vsout.topo = topo;
-  m_PostVSData[eventID].vsout.buf = meshBuffer;
-  m_PostVSData[eventID].vsout.bufmem = meshMem;
-
-  m_PostVSData[eventID].vsout.vertStride = bufStride;
-  m_PostVSData[eventID].vsout.nearPlane = nearp;
-  m_PostVSData[eventID].vsout.farPlane = farp;
-
-  m_PostVSData[eventID].vsout.useIndices = bool(drawcall->flags & DrawFlags::UseIBuffer);
-  m_PostVSData[eventID].vsout.numVerts = drawcall->numIndices;
-
-  m_PostVSData[eventID].vsout.instStride = 0;
-  if(drawcall->flags & DrawFlags::Instanced)
-    m_PostVSData[eventID].vsout.instStride = uint32_t(bufSize / drawcall->numInstances);
-
-  m_PostVSData[eventID].vsout.idxBuf = VK_NULL_HANDLE;
-  if(m_PostVSData[eventID].vsout.useIndices && idxBuf != VK_NULL_HANDLE)
-  {
-    m_PostVSData[eventID].vsout.idxBuf = idxBuf;
-    m_PostVSData[eventID].vsout.idxBufMem = idxBufMem;
-    m_PostVSData[eventID].vsout.idxFmt =
-        state.ibuffer.bytewidth == 2 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
-  }
-
-  m_PostVSData[eventID].vsout.hasPosOut = refl->OutputSig[0].systemValue == ShaderBuiltin::Position;
-
-  // delete pipeline layout
-  m_pDriver->vkDestroyPipelineLayout(dev, pipeLayout, NULL);
-
-  // delete pipeline
-  m_pDriver->vkDestroyPipeline(dev, pipe, NULL);
-
-  // delete shader/shader module
-  m_pDriver->vkDestroyShaderModule(dev, module, NULL);
+  m_PostVSBatch.clear();
+  m_PostVSBatchSize = 0;
 }
 
 MeshFormat VulkanDebugManager::GetPostVSBuffers(uint32_t eventID, uint32_t instID, MeshDataStage stage)
@@ -8626,7 +10238,7 @@ MeshFormat VulkanDebugManager::GetPostVSBuffers(uint32_t eventID, uint32_t instI
   else
     ret.buf = ResourceId();
 
-  ret.offset = s.instStride * instID;
+  ret.offset = s.bufOffset + s.instStride * instID;
   ret.stride = s.vertStride;
 
   ret.compCount = 4;
@@ -25,6 +25,7 @@
 #pragma once
 
 #include "api/replay/renderdoc_replay.h"
+#include "common/shader_cache.h"
 #include "core/core.h"
 #include "replay/replay_driver.h"
 #include "vk_common.h"
@@ -53,6 +54,9 @@ struct MeshDisplayPipelines
   };
 
   VkPipeline pipes[ePipe_Count];
+
+  // for LRU eviction from the cache
+  uint64_t lastUse;
 };
 
 struct VulkanPostVSData
@@ -60,7 +64,9 @@ struct VulkanPostVSData
   struct StageData
   {
     VkBuffer buf;
+    // NULL if buf is shared with other events fetched in the same batch
     VkDeviceMemory bufmem;
+    VkDeviceSize bufOffset;
     VkPrimitiveTopology topo;
 
     uint32_t numVerts;
@@ -113,26 +119,60 @@ public:
   ResourceId RenderOverlay(ResourceId texid, DebugOverlay overlay, uint32_t eventID,
                            const vector<uint32_t> &passEvents);
 
+  vector<TextureSamplingFeedback> FetchTextureSampling(uint32_t startEventID, uint32_t endEventID);
+  // the original ID of the image whose view is in a descriptor, as it is currently written
+  ResourceId GetDescriptorImage(ResourceId descSet, uint32_t binding, uint32_t arrayElement);
+
   void InitPostVSBuffers(uint32_t eventID);
 
+  // compile a user shader through the on-disk shader cache. The returned blob is owned by the cache
+  string GetUserSPIRVBlob(SPIRVShaderStage shadType, const string &source,
+                          vector<uint32_t> **outBlob);
+
+  // between these calls InitPostVSBuffers only prepares each event, and all of them are then
+  // drawn and read back together with a single submit
+  void BeginPostVSBatch();
+  void EndPostVSBatch();
+
+  // free the least recently used post-VS data if it's over budget, other than eventID's
+  void TrimPostVSCache(uint32_t eventID);
+  // estimated GPU memory used for post-VS data, overlays, readback and mesh display
+  void GetMemoryUsage(vector<MemoryUsage> &usage);
+
   // indicates that EID alias is the same as eventID
   void AliasPostVSBuffers(uint32_t eventID, uint32_t alias) { m_PostVSAlias[alias] = eventID; }
   MeshFormat GetPostVSBuffers(uint32_t eventID, uint32_t instID, MeshDataStage stage);
   void GetBufferData(ResourceId buff, uint64_t offset, uint64_t len, vector<byte> &ret);
 
+  // the persistently mapped window that synchronous readbacks copy through. Returns the mapped
+  // pointer and the unwrapped buffer, or NULL if size doesn't fit and the caller needs its own
+  byte *GetReadbackWindow(VkDeviceSize size, VkBuffer &buf);
+
   uint32_t PickVertex(uint32_t eventID, const MeshDisplay &cfg, uint32_t x, uint32_t y, uint32_t w,
                       uint32_t h);
 
   void CopyTex2DMSToArray(VkImage destArray, VkImage srcMS, VkExtent3D extent, uint32_t layers,
                           uint32_t samples, VkFormat fmt);
+
+  // records a dispatch into cmd that compresses numDwords from src into dst, laid out as described
+  // in initstate_compress.comp. Only a limited number can be recorded until the initial state
+  // batch is flushed and ResetInitStateCompression is called.
+  static const uint32_t InitStateCompressBlockDwords = 256;
+  static const uint32_t InitStateCompressHeaderDwords = 4;
+
+  bool CanCompressInitState();
+  void CompressInitState(VkCommandBuffer cmd, VkBuffer src, VkBuffer dst, uint32_t numDwords,
+                         uint32_t numBlocks, uint32_t dataOffset);
+  void ResetInitStateCompression();
   void CopyArrayToTex2DMS(VkImage destMS, VkImage srcArray, VkExtent3D extent, uint32_t layers,
                           uint32_t samples, VkFormat fmt);
 
   void CreateCustomShaderTex(uint32_t width, uint32_t height, uint32_t mip);
   void CreateCustomShaderPipeline(ResourceId shader);
 
-  void ReplaceResource(ResourceId from, ResourceId to);
-  void RemoveReplacement(ResourceId id);
+  // both return the live IDs of the pipelines that were remade or restored
+  void ReplaceResource(ResourceId from, ResourceId to, vector<ResourceId> &pipelines);
+  void RemoveReplacement(ResourceId id, vector<ResourceId> &pipelines);
 
   struct GPUBuffer
   {
@@ -237,6 +277,12 @@ public:
   VkPipeline m_Array2MSPipe;
   VkPipeline m_MS2ArrayPipe;
 
+  VkDescriptorSetLayout m_InitStateCompressDescSetLayout;
+  VkPipelineLayout m_InitStateCompressPipeLayout;
+  VkDescriptorPool m_InitStateCompressDescPool;
+  uint32_t m_InitStateCompressDescSetsUsed;
+  VkPipeline m_InitStateCompressPipe;
+
   // one per depth/stencil output format
   VkPipeline m_DepthMS2ArrayPipe[6];
   // one per depth/stencil output format, per sample count
@@ -265,6 +311,51 @@ public:
   VkExtent2D m_OverlayDim;
   VkDeviceSize m_OverlayMemSize;
 
+  // pipelines patched for an overlay are kept between events, keyed by the pipeline they were
+  // made from. Anything else they depend on (the overlay renderpass, the depth format for the
+  // depth-tested passes) is either in the key or flushes the cache when it changes.
+  struct OverlayPipelineKey
+  {
+    ResourceId pipeline;
+    DebugOverlay overlay;
+    // overlays that draw more than once use a pipeline per pass
+    uint32_t pass;
+    VkFormat depthFormat;
+
+    bool operator<(const OverlayPipelineKey &o) const
+    {
+      if(pipeline != o.pipeline)
+        return pipeline < o.pipeline;
+      if(overlay != o.overlay)
+        return overlay < o.overlay;
+      if(pass != o.pass)
+        return pass < o.pass;
+      return depthFormat < o.depthFormat;
+    }
+  };
+
+  struct OverlayPipeline
+  {
+    OverlayPipeline() : pipe(VK_NULL_HANDLE), layout(VK_NULL_HANDLE), descSet(0), lastUse(0) {}
+    VkPipeline pipe;
+    // only set if the pipeline needed its own layout, e.g. for quad overdraw
+    VkPipelineLayout layout;
+    uint32_t descSet;
+    uint64_t lastUse;
+  };
+
+  static const size_t OverlayPipelineCacheSize = 64;
+
+  map<OverlayPipelineKey, OverlayPipeline> m_OverlayPipelineCache;
+  // incremented for each overlay render. Entries used in the current render are never evicted as
+  // the commands using them may not have been submitted yet.
+  uint64_t m_OverlayPipelineEpoch;
+
+  OverlayPipeline *FindOverlayPipeline(const OverlayPipelineKey &key);
+  void AddOverlayPipeline(const OverlayPipelineKey &key, OverlayPipeline pipe);
+  void FreeOverlayPipelines(const vector<ResourceId> &pipelines);
+  void FreeOverlayPipelineCache();
+
   GPUBuffer m_OverdrawRampUBO;
   VkDescriptorSetLayout m_QuadDescSetLayout;
   VkDescriptorSet m_QuadDescSet;
@@ -305,12 +396,16 @@ public:
   VkPipeline m_MinMaxTilePipe[eTexType_Max][3];    // float, uint, sint
   VkPipeline m_MinMaxResultPipe[3];                // float, uint, sint
 
+  // the min/max and histogram pipelines are only made on first use, as there are many of them
+  void CreateHistogramPipelines(uint32_t textype, uint32_t intTypeIndex);
+
   static const int maxMeshPicks = 500;
 
   GPUBuffer m_MeshPickUBO;
   GPUBuffer m_MeshPickIB, m_MeshPickIBUpload;
   GPUBuffer m_MeshPickVB, m_MeshPickVBUpload;
   uint32_t m_MeshPickIBSize, m_MeshPickVBSize;
+  MeshPickCache m_MeshPickCache;
   GPUBuffer m_MeshPickResult, m_MeshPickResultReadback;
   VkDescriptorSetLayout m_MeshPickDescSetLayout;
   VkDescriptorSet m_MeshPickDescSet;
@@ -324,10 +419,14 @@ public:
   GPUBuffer m_OutlineUBO;
 
   GPUBuffer m_ReadbackWindow;
+  byte *m_ReadbackWindowData;
 
   VkDescriptorSetLayout m_MeshFetchDescSetLayout;
   VkDescriptorSet m_MeshFetchDescSet;
 
+  // must be called before any mesh display pipelines are fetched for a render, while none of the
+  // returned pipelines are referenced by unsubmitted commands
+  void TrimMeshDisplayPipelines();
   MeshDisplayPipelines CacheMeshDisplayPipelines(const MeshFormat &primary,
                                                  const MeshFormat &secondary);
   void MakeGraphicsPipelineInfo(VkGraphicsPipelineCreateInfo &pipeCreateInfo, ResourceId pipeline);
@@ -341,18 +440,36 @@ private:
   static const uint32_t m_ShaderCacheMagic = 0xf00d00d5;
   static const uint32_t m_ShaderCacheVersion = 1;
 
-  bool m_ShaderCacheDirty, m_CacheShaders;
-  map<uint32_t, vector<uint32_t> *> m_ShaderCache;
+  bool m_CacheShaders;
+  ShaderCache<vector<uint32_t> *> m_ShaderCache;
+
+  // a pipeline cache for our own pipelines on replay. Unlike the shader cache it depends on the
+  // driver, so it's stored per-device but shared between all captures.
+  VkPipelineCache m_InternalPipelineCache;
+  void LoadInternalPipelineCache();
+  void SaveInternalPipelineCache();
+
+  bool m_TexelFetchBrokenDriver;
 
   string GetSPIRVBlob(SPIRVShaderStage shadType, const std::vector<std::string> &sources,
                       vector<uint32_t> **outBlob);
+  // compile the jobs that aren't already cached in parallel and add them to the cache
+  void PrecompileSPIRVBlobs(vector<SPIRVCompileJob> &jobs);
 
   void CopyDepthTex2DMSToArray(VkImage destArray, VkImage srcMS, VkExtent3D extent, uint32_t layers,
                                uint32_t samples, VkFormat fmt);
   void CopyDepthArrayToTex2DMS(VkImage destMS, VkImage srcArray, VkExtent3D extent, uint32_t layers,
                                uint32_t samples, VkFormat fmt);
 
-  void PatchFixedColShader(VkShaderModule &mod, float col[4]);
+  // returns a module patched to write the given colour. It is cached and must not be destroyed.
+  VkShaderModule GetFixedColShader(const float col[4]);
+
+  struct FixedColShader
+  {
+    float col[4];
+    VkShaderModule module;
+  };
+  vector<FixedColShader> m_FixedColShaders;
 
   void RenderTextInternal(const TextPrintState &textstate, float x, float y, const char *text);
   static const uint32_t FONT_TEX_WIDTH = 256;
@@ -365,10 +482,71 @@ private:
 
   vector<uint32_t> *m_FixedColSPIRV;
 
+  // mesh display pipelines are made on demand for each format combination. Once there are more
+  // than MeshPipelineCacheSize the least recently used are evicted, at the start of a mesh render.
+  // The common helper formats are made on a background thread after init, so the cache is locked.
+  static const size_t MeshPipelineCacheSize = 64;
+
   map<uint64_t, MeshDisplayPipelines> m_CachedMeshPipelines;
+  uint64_t m_MeshPipelineTick;
+  Threading::CriticalSection m_MeshPipelinesLock;
+  Threading::ThreadHandle m_MeshPipelineWarmThread;
+
+  static void WarmMeshDisplayPipelines(void *ths);
 
   map<uint32_t, VulkanPostVSData> m_PostVSData;
   map<uint32_t, uint32_t> m_PostVSAlias;
+  PostVSCacheTracker m_PostVSCache;
+
+  // an event that's been prepared for post-VS fetch but not yet drawn
+  struct PostVSEvent
+  {
+    PostVSEvent(const VulkanRenderState &s) : state(s) {}
+    uint32_t eventID;
+
+    VkPipelineLayout pipeLayout;
+    VkPipeline pipe;
+    VkShaderModule module;
+
+    // state to draw with, using the patched pipeline and our output descriptor set
+    VulkanRenderState state;
+    uint32_t descSet;
+
+    bool indexed, instanced;
+    uint32_t numIndices, numInstances;
+    uint32_t vertexOffset, instanceOffset;
+    int32_t baseVertex;
+
+    VkPrimitiveTopology topo;
+    bool hasPosOut;
+    uint32_t numVerts;
+    uint32_t bufStride;
+    VkDeviceSize bufSize;
+    VkDeviceSize bufOffset;
+
+    uint32_t numUniqueIndices;
+    VkBuffer uniqIdxBuf;
+    VkDeviceMemory uniqIdxBufMem;
+    VkBuffer idxBuf;
+    VkDeviceMemory idxBufMem;
+    VkDeviceSize idxBufSize;
+    VkIndexType idxFmt;
+  };
+
+  // upper bounds on how much output is batched into one buffer, and on the size of index
+  // buffers that are cached whole while batching
+  static const VkDeviceSize POSTVS_BATCH_MAX_SIZE = 256 * 1024 * 1024;
+  static const uint64_t POSTVS_INDEX_CACHE_MAX_SIZE = 64 * 1024 * 1024;
+
+  void FetchPostVSBatch();
+  void GetPostVSIndexData(ResourceId buf, uint64_t offset, uint64_t len, vector<byte> &ret);
+
+  bool m_PostVSBatching;
+  VkDeviceSize m_PostVSBatchSize;
+  vector<PostVSEvent> m_PostVSBatch;
+  map<ResourceId, vector<byte> > m_PostVSIndexCache;
+  // buffers shared by several events' data, with how many of those events are still cached
+  map<VkBuffer, pair<VkDeviceMemory, uint32_t> > m_PostVSBatchBuffers;
 
   WrappedVulkan *m_pDriver;
   VulkanResourceManager *m_ResourceManager;
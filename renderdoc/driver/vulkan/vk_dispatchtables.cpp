@@ -160,11 +160,68 @@ void InitDeviceExtensionTables(VkDevice device)
 
 #undef DeviceGPA
 
-static Threading::CriticalSection devlock;
-std::map<void *, VkLayerDispatchTableExtended> devlookup;
+// Tables are looked up whenever a dispatchable object is wrapped and on every GetProcAddr, but
+// there's only ever one or two devices and instances. The first few are mirrored into a small array
+// that can be scanned without taking the lock. Tables are never removed and map nodes don't move,
+// so a pointer into the map stays valid for good.
+template <typename TableType>
+struct DispatchTableLookup
+{
+  DispatchTableLookup() : numFast(0) { RDCEraseEl(fast); }
+  static const int32_t NumFastSlots = 4;
+
+  struct FastSlot
+  {
+    void *key;
+    TableType *table;
+  } fast[NumFastSlots];
+  volatile int32_t numFast;
+
+  Threading::CriticalSection lock;
+  std::map<void *, TableType> tables;
+
+  // returns a zeroed table for key, creating it if needed
+  TableType *Init(void *key)
+  {
+    SCOPED_LOCK(lock);
+
+    bool isNew = tables.find(key) == tables.end();
+
+    TableType *table = &tables[key];
+    RDCEraseEl(*table);
+
+    if(isNew && numFast < NumFastSlots)
+    {
+      fast[numFast].key = key;
+      fast[numFast].table = table;
+      // the slot is complete before the count is incremented, but a reader could still see its
+      // fields arrive out of order. It checks for a NULL table and falls back to the lock then
+      Atomic::Inc32(&numFast);
+    }
 
-static Threading::CriticalSection instlock;
-std::map<void *, VkLayerInstanceDispatchTableExtended> instlookup;
+    return table;
+  }
+
+  TableType *Find(void *key)
+  {
+    int32_t count = numFast;
+    for(int32_t i = 0; i < count; i++)
+      if(fast[i].key == key && fast[i].table)
+        return fast[i].table;
+
+    SCOPED_LOCK(lock);
+
+    auto it = tables.find(key);
+
+    if(it == tables.end())
+      return NULL;
+
+    return &it->second;
+  }
+};
+
+static DispatchTableLookup<VkLayerDispatchTableExtended> devlookup;
+static DispatchTableLookup<VkLayerInstanceDispatchTableExtended> instlookup;
 
 static void *GetKey(void *obj)
 {
@@ -176,13 +233,7 @@ void InitDeviceTable(VkDevice dev, PFN_vkGetDeviceProcAddr gpa)
 {
   void *key = GetKey(dev);
 
-  VkLayerDispatchTableExtended *table = NULL;
-
-  {
-    SCOPED_LOCK(devlock);
-    RDCEraseEl(devlookup[key]);
-    table = &devlookup[key];
-  }
+  VkLayerDispatchTableExtended *table = devlookup.Init(key);
 
   table->GetDeviceProcAddr = gpa;
 
@@ -199,13 +250,7 @@ void InitInstanceTable(VkInstance inst, PFN_vkGetInstanceProcAddr gpa)
 {
   void *key = GetKey(inst);
 
-  VkLayerInstanceDispatchTableExtended *table = NULL;
-
-  {
-    SCOPED_LOCK(instlock);
-    RDCEraseEl(instlookup[key]);
-    table = &instlookup[key];
-  }
+  VkLayerInstanceDispatchTableExtended *table = instlookup.Init(key);
 
   // init the GetInstanceProcAddr function first
   table->GetInstanceProcAddr = gpa;
@@ -228,18 +273,12 @@ VkLayerDispatchTableExtended *GetDeviceDispatchTable(void *device)
   if(replay)
     return &replayDeviceTable;
 
-  void *key = GetKey(device);
-
-  {
-    SCOPED_LOCK(devlock);
+  VkLayerDispatchTableExtended *table = devlookup.Find(GetKey(device));
 
-    auto it = devlookup.find(key);
+  if(table == NULL)
+    RDCFATAL("Bad device pointer");
 
-    if(it == devlookup.end())
-      RDCFATAL("Bad device pointer");
-
-    return &it->second;
-  }
+  return table;
 }
 
 VkLayerInstanceDispatchTableExtended *GetInstanceDispatchTable(void *instance)
@@ -247,16 +286,10 @@ VkLayerInstanceDispatchTableExtended *GetInstanceDispatchTable(void *instance)
   if(replay)
     return &replayInstanceTable;
 
-  void *key = GetKey(instance);
-
-  {
-    SCOPED_LOCK(instlock);
-
-    auto it = instlookup.find(key);
+  VkLayerInstanceDispatchTableExtended *table = instlookup.Find(GetKey(instance));
 
-    if(it == instlookup.end())
-      RDCFATAL("Bad device pointer");
+  if(table == NULL)
+    RDCFATAL("Bad device pointer");
 
-    return &it->second;
-  }
+  return table;
 }
@@ -71,6 +71,66 @@ void DescSetLayout::Init(VulkanResourceManager *resourceMan, VulkanCreationInfo
   }
 }
 
+void DescUpdateTemplate::Init(VulkanResourceManager *resourceMan, VulkanCreationInfo &info,
+                              const VkDescriptorUpdateTemplateCreateInfoKHR *pCreateInfo)
+{
+  entries.assign(pCreateInfo->pDescriptorUpdateEntries,
+                 pCreateInfo->pDescriptorUpdateEntries + pCreateInfo->descriptorUpdateEntryCount);
+
+  packedSize = 0;
+  maxDescriptorCount = 0;
+  dataByteSize = 0;
+
+  for(size_t i = 0; i < entries.size(); i++)
+  {
+    const VkDescriptorUpdateTemplateEntryKHR &entry = entries[i];
+
+    packedSize += PackedDescriptorSize(entry.descriptorType) * entry.descriptorCount;
+    maxDescriptorCount = RDCMAX(maxDescriptorCount, entry.descriptorCount);
+
+    if(entry.descriptorCount == 0)
+      continue;
+
+    size_t elemSize = sizeof(VkDescriptorBufferInfo);
+
+    if(entry.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER ||
+       entry.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER)
+      elemSize = sizeof(VkBufferView);
+    else if(entry.descriptorType == VK_DESCRIPTOR_TYPE_SAMPLER ||
+            entry.descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER ||
+            entry.descriptorType == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE ||
+            entry.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE ||
+            entry.descriptorType == VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT)
+      elemSize = sizeof(VkDescriptorImageInfo);
+
+    dataByteSize = RDCMAX(dataByteSize,
+                          entry.offset + entry.stride * (entry.descriptorCount - 1) + elemSize);
+  }
+}
+
+size_t DescUpdateTemplate::PackedDescriptorSize(VkDescriptorType type)
+{
+  switch(type)
+  {
+    case VK_DESCRIPTOR_TYPE_SAMPLER:
+    case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+    case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER: return sizeof(ResourceId);
+    case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+      return sizeof(ResourceId) + sizeof(ResourceId) + sizeof(VkImageLayout);
+    case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+    case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+    case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT: return sizeof(ResourceId) + sizeof(VkImageLayout);
+    case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+    case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+    case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+    case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+      return sizeof(ResourceId) + sizeof(VkDeviceSize) + sizeof(VkDeviceSize);
+    default: RDCERR("Unexpected descriptor type %d", type);
+  }
+
+  return 0;
+}
+
 void DescSetLayout::CreateBindingsArray(vector<DescriptorSetSlot *> &descBindings)
 {
   descBindings.resize(bindings.size());
@@ -459,6 +519,7 @@ void VulkanCreationInfo::Memory::Init(VulkanResourceManager *resourceMan, Vulkan
                                       const VkMemoryAllocateInfo *pAllocInfo)
 {
   size = pAllocInfo->allocationSize;
+  memoryTypeIndex = pAllocInfo->memoryTypeIndex;
 }
 
 void VulkanCreationInfo::Buffer::Init(VulkanResourceManager *resourceMan, VulkanCreationInfo &info,
@@ -466,6 +527,7 @@ void VulkanCreationInfo::Buffer::Init(VulkanResourceManager *resourceMan, Vulkan
 {
   usage = pCreateInfo->usage;
   size = pCreateInfo->size;
+  memory = ResourceId();
 }
 
 void VulkanCreationInfo::BufferView::Init(VulkanResourceManager *resourceMan,
@@ -482,6 +544,7 @@ void VulkanCreationInfo::Image::Init(VulkanResourceManager *resourceMan, VulkanC
 {
   view = VK_NULL_HANDLE;
   stencilView = VK_NULL_HANDLE;
+  memory = ResourceId();
 
   type = pCreateInfo->imageType;
   format = pCreateInfo->format;
@@ -572,6 +635,7 @@ void VulkanCreationInfo::ShaderModule::Init(VulkanResourceManager *resourceMan,
   else
   {
     RDCASSERT(pCreateInfo->codeSize % sizeof(uint32_t) == 0);
-    ParseSPIRV((uint32_t *)pCreateInfo->pCode, pCreateInfo->codeSize / sizeof(uint32_t), spirv);
+    // modules are only parsed once a pipeline or the shader viewer needs them
+    DeferParseSPIRV(pCreateInfo->pCode, pCreateInfo->codeSize / sizeof(uint32_t), spirv);
   }
 }
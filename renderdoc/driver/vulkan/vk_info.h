@@ -60,6 +60,26 @@ struct DescSetLayout
   uint32_t dynamicCount;
 };
 
+struct DescUpdateTemplate
+{
+  void Init(VulkanResourceManager *resourceMan, VulkanCreationInfo &info,
+            const VkDescriptorUpdateTemplateCreateInfoKHR *pCreateInfo);
+
+  // an update's descriptors are serialised tightly packed in entry order, with handles replaced by
+  // IDs and only the members each descriptor type uses, rather than at the application's offsets
+  // and strides. This returns the packed size of one descriptor of the given type.
+  static size_t PackedDescriptorSize(VkDescriptorType type);
+
+  vector<VkDescriptorUpdateTemplateEntryKHR> entries;
+
+  // total size of the packed data for one update, and the most descriptors written by any entry
+  size_t packedSize;
+  uint32_t maxDescriptorCount;
+
+  // extent of the application's data that the entries read from
+  size_t dataByteSize;
+};
+
 struct VulkanCreationInfo
 {
   struct Pipeline
@@ -182,6 +202,9 @@ struct VulkanCreationInfo
   };
   map<ResourceId, Pipeline> m_Pipeline;
 
+  // the pipelines that use each shader module, so replacing a module only has to touch those
+  map<ResourceId, vector<ResourceId> > m_ShaderModulePipelines;
+
   struct PipelineLayout
   {
     void Init(VulkanResourceManager *resourceMan, VulkanCreationInfo &info,
@@ -241,6 +264,7 @@ struct VulkanCreationInfo
               const VkMemoryAllocateInfo *pAllocInfo);
 
     uint64_t size;
+    uint32_t memoryTypeIndex;
 
     VkBuffer wholeMemBuf;
   };
@@ -253,6 +277,9 @@ struct VulkanCreationInfo
 
     VkBufferUsageFlags usage;
     uint64_t size;
+
+    // the memory the buffer is bound to, if any
+    ResourceId memory;
   };
   map<ResourceId, Buffer> m_Buffer;
 
@@ -283,6 +310,9 @@ struct VulkanCreationInfo
 
     bool cube;
     TextureCategory creationFlags;
+
+    // the memory the image is bound to, if any
+    ResourceId memory;
   };
   map<ResourceId, Image> m_Image;
 
@@ -341,4 +371,5 @@ struct VulkanCreationInfo
   map<ResourceId, string> m_Names;
   map<ResourceId, SwapchainInfo> m_SwapChain;
   map<ResourceId, DescSetLayout> m_DescSetLayout;
+  map<ResourceId, DescUpdateTemplate> m_DescUpdateTemplate;
 };
@@ -34,12 +34,191 @@
 // VKTODOLOW The code pattern for creating a few contiguous arrays all in one
 // AllocAlignedBuffer for the initial contents buffer is ugly.
 
-// VKTODOLOW in general we do a lot of "create buffer, use it, flush/sync then destroy".
-// I don't know what the exact cost is, but it would be nice to batch up the buffers/etc
-// used across init state use, and only do a single flush. Also we could then get some
-// nice command buffer reuse (although need to be careful we don't create too large a
-// command buffer that stalls the GPU).
-// See INITSTATEBATCH
+// On capture the readback copies for all resources are batched into shared command buffers, and
+// the temporary buffers/images they use are kept until the batch is flushed - once, after all
+// resources are prepared. A command buffer is closed and submitted after a fixed number of
+// resources so none grow large enough to stall the GPU, and the batch is flushed early if the
+// temporary GPU allocations (e.g. MSAA->array copies) grow past a budget.
+// See InitStateBatch
+
+// how many resources' copies to record into one command buffer before submitting it
+static const uint32_t InitStateBatchResources = 256;
+
+// how many bytes of temporary GPU memory to keep alive before flushing the batch early
+static const VkDeviceSize InitStateBatchTempBudget = 256 * 1024 * 1024;
+
+// while preparing initial contents ahead of a capture, how many internal command buffers can be
+// submitted before the queue is flushed to recycle them
+static const size_t PrepareAheadFlushCmds = 16;
+
+// images smaller than this aren't worth compressing on the GPU before reading them back
+static const VkDeviceSize InitStateCompressMinSize = 64 * 1024;
+
+VkCommandBuffer WrappedVulkan::GetInitStateCmd()
+{
+  if(m_InitStateBatch.cmd == VK_NULL_HANDLE)
+  {
+    m_InitStateBatch.cmd = GetNextCmd();
+
+    VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
+                                          VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+
+    VkResult vkr = ObjDisp(m_InitStateBatch.cmd)->BeginCommandBuffer(Unwrap(m_InitStateBatch.cmd),
+                                                                      &beginInfo);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  }
+
+  return m_InitStateBatch.cmd;
+}
+
+void WrappedVulkan::CloseInitStateCmd()
+{
+  if(m_InitStateBatch.cmd == VK_NULL_HANDLE)
+    return;
+
+  VkResult vkr = ObjDisp(m_InitStateBatch.cmd)->EndCommandBuffer(Unwrap(m_InitStateBatch.cmd));
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  m_InitStateBatch.cmd = VK_NULL_HANDLE;
+  m_InitStateBatch.numResources = 0;
+}
+
+void WrappedVulkan::EndInitStateResource(VkDeviceSize tempBytes)
+{
+  m_InitStateBatch.numResources++;
+  m_InitStateBatch.tempBytes += tempBytes;
+
+  if(m_InitStateBatch.tempBytes > InitStateBatchTempBudget)
+  {
+    FlushInitStateBatch();
+  }
+  else if(m_InitStateBatch.numResources >= InitStateBatchResources)
+  {
+    CloseInitStateCmd();
+    SubmitCmds();
+  }
+}
+
+void WrappedVulkan::FlushInitStateBatch()
+{
+  CloseInitStateCmd();
+
+  // nothing was prepared that needs waiting on
+  if(m_InitStateBatch.buffers.empty() && m_InitStateBatch.images.empty() &&
+     m_InitStateBatch.mems.empty() && m_InternalCmds.pendingcmds.empty() &&
+     m_InternalCmds.submittedcmds.empty())
+    return;
+
+  SubmitCmds();
+  FlushQ();
+
+  if(GetDebugManager())
+    GetDebugManager()->ResetInitStateCompression();
+
+  VkDevice d = GetDev();
+
+  for(size_t i = 0; i < m_InitStateBatch.buffers.size(); i++)
+    ObjDisp(d)->DestroyBuffer(Unwrap(d), m_InitStateBatch.buffers[i], NULL);
+
+  for(size_t i = 0; i < m_InitStateBatch.images.size(); i++)
+    ObjDisp(d)->DestroyImage(Unwrap(d), m_InitStateBatch.images[i], NULL);
+
+  for(size_t i = 0; i < m_InitStateBatch.mems.size(); i++)
+    ObjDisp(d)->FreeMemory(Unwrap(d), m_InitStateBatch.mems[i], NULL);
+
+  m_InitStateBatch.buffers.clear();
+  m_InitStateBatch.images.clear();
+  m_InitStateBatch.mems.clear();
+  m_InitStateBatch.tempBytes = 0;
+}
+
+void WrappedVulkan::PrepareInitialStateAhead()
+{
+  uint64_t budget = uint64_t(RenderDoc::Inst().GetCaptureOptions().PrepareAheadBudget) << 20;
+
+  if(budget == 0)
+    return;
+
+  GetResourceManager()->PrepareInitialContentsAhead(budget);
+
+  // the copies don't need to be waited on until a capture is made, so just submit them. The queue
+  // is only flushed once in a while to recycle the command buffers and temporary objects
+  CloseInitStateCmd();
+  SubmitCmds();
+
+  if(m_InternalCmds.submittedcmds.size() >= PrepareAheadFlushCmds)
+    FlushInitStateBatch();
+}
+
+void WrappedVulkan::AddMemoryBinding(ResourceId mem, ResourceId resource, VkDeviceSize offset,
+                                     VkDeviceSize size)
+{
+  SCOPED_LOCK(m_MemoryBindingsLock);
+
+  vector<MemoryBinding> &bindings = m_MemoryBindings[mem];
+
+  // before growing the list, drop any bindings for resources that have since been destroyed. This
+  // keeps the list bounded for memory that is re-used by many short-lived resources
+  if(bindings.size() == bindings.capacity())
+  {
+    for(size_t i = 0; i < bindings.size();)
+    {
+      if(GetResourceManager()->HasResourceRecord(bindings[i].resource))
+      {
+        i++;
+      }
+      else
+      {
+        bindings[i] = bindings.back();
+        bindings.pop_back();
+      }
+    }
+  }
+
+  MemoryBinding binding = {resource, offset, size};
+  bindings.push_back(binding);
+}
+
+bool WrappedVulkan::FindMemoryBinding(ResourceId mem, ResourceId resource, MemoryBinding &binding)
+{
+  SCOPED_LOCK(m_MemoryBindingsLock);
+
+  auto it = m_MemoryBindings.find(mem);
+
+  if(it == m_MemoryBindings.end())
+    return false;
+
+  for(size_t i = 0; i < it->second.size(); i++)
+  {
+    if(it->second[i].resource == resource)
+    {
+      binding = it->second[i];
+      return true;
+    }
+  }
+
+  return false;
+}
+
+vector<MemoryBinding> WrappedVulkan::GetMemoryBindings(ResourceId mem)
+{
+  vector<MemoryBinding> ret;
+
+  SCOPED_LOCK(m_MemoryBindingsLock);
+
+  auto it = m_MemoryBindings.find(mem);
+
+  if(it == m_MemoryBindings.end())
+    return ret;
+
+  ret.reserve(it->second.size());
+
+  for(size_t i = 0; i < it->second.size(); i++)
+    if(GetResourceManager()->HasResourceRecord(it->second[i].resource))
+      ret.push_back(it->second[i]);
+
+  return ret;
+}
 
 struct MemIDOffset
 {
@@ -54,13 +233,170 @@ void Serialiser::Serialise(const char *name, MemIDOffset &el)
   Serialise("memOffs", el.memOffs);
 }
 
+// a range of a memory object's initial contents, at dataOffset in the readback/upload buffer
+struct MemoryRange
+{
+  VkDeviceSize memOffset;
+  VkDeviceSize size;
+  VkDeviceSize dataOffset;
+};
+
+struct MemoryInitState
+{
+  // on capture these are the merged bound ranges that were read back, on replay the ranges that
+  // were serialised
+  uint32_t numRanges;
+  MemoryRange *ranges;
+
+  // available on capture - the individual bindings the ranges were built from, used to only write
+  // the ranges that were referenced in the frame. If there are none the whole memory is kept.
+  uint32_t numBindings;
+  MemoryBinding *bindings;
+};
+
+// on capture, the blob for a non-sparse image whose contents were compressed on the GPU before
+// readback. They're expanded again before serialising so the data written is unchanged.
+struct CompressedImageInitState
+{
+  uint32_t numBlocks;
+  uint32_t dataOffset;
+};
+
+static void ExpandCompressedImageInitState(const CompressedImageInitState *state, const byte *src,
+                                           byte *dst, uint32_t dataSize)
+{
+  const uint32_t blockDwords = VulkanDebugManager::InitStateCompressBlockDwords;
+
+  const uint32_t *table = (const uint32_t *)src + VulkanDebugManager::InitStateCompressHeaderDwords;
+  const uint32_t *blocks = (const uint32_t *)src + state->dataOffset;
+  uint32_t *out = (uint32_t *)dst;
+
+  uint32_t numDwords = dataSize / 4;
+
+  for(uint32_t b = 0; b < state->numBlocks; b++)
+  {
+    uint32_t slot = table[b * 2 + 0];
+    uint32_t value = table[b * 2 + 1];
+
+    uint32_t first = b * blockDwords;
+    uint32_t count = RDCMIN(blockDwords, numDwords - first);
+
+    if(slot == ~0U)
+    {
+      for(uint32_t i = 0; i < count; i++)
+        out[first + i] = value;
+    }
+    else
+    {
+      memcpy(out + first, blocks + slot * blockDwords, count * sizeof(uint32_t));
+    }
+  }
+}
+
+// a range of a memory object that's bound to a sparse resource, at dataOffs in the readback/upload
+// buffer. Only these ranges are saved, not the whole memory objects, which can be much larger than
+// the pages bound from them.
+struct SparseMemRange
+{
+  ResourceId memId;
+  VkDeviceSize memOffs;
+  VkDeviceSize size;
+  VkDeviceSize dataOffs;
+};
+
+template <>
+void Serialiser::Serialise(const char *name, SparseMemRange &el)
+{
+  Serialise("memId", el.memId);
+  Serialise("memOffs", el.memOffs);
+  Serialise("size", el.size);
+  Serialise("dataOffs", el.dataOffs);
+}
+
+// memory object -> the offset and size of each range of it bound to a sparse resource
+typedef map<VkDeviceMemory, vector<pair<VkDeviceSize, VkDeviceSize> > > SparseBoundMemory;
+
+// merges the bound ranges of each memory object and lays them out back to back. Returns the total
+// size of the ranges.
+static VkDeviceSize GetSparseMemRanges(SparseBoundMemory &bound, vector<SparseMemRange> &ranges)
+{
+  VkDeviceSize totalSize = 0;
+
+  for(auto it = bound.begin(); it != bound.end(); ++it)
+  {
+    vector<pair<VkDeviceSize, VkDeviceSize> > &binds = it->second;
+    std::sort(binds.begin(), binds.end());
+
+    VkDeviceSize memSize = GetRecord(it->first)->Length;
+    size_t first = ranges.size();
+
+    for(size_t i = 0; i < binds.size(); i++)
+    {
+      VkDeviceSize offs = binds[i].first;
+      if(offs >= memSize || binds[i].second == 0)
+        continue;
+
+      VkDeviceSize end = RDCMIN(offs + binds[i].second, memSize);
+
+      if(ranges.size() > first && offs <= ranges.back().memOffs + ranges.back().size)
+      {
+        SparseMemRange &last = ranges.back();
+        VkDeviceSize lastEnd = last.memOffs + last.size;
+
+        if(end > lastEnd)
+        {
+          last.size = end - last.memOffs;
+          totalSize += end - lastEnd;
+        }
+      }
+      else
+      {
+        SparseMemRange range = {GetResID(it->first), offs, end - offs, totalSize};
+        ranges.push_back(range);
+        totalSize += range.size;
+      }
+    }
+  }
+
+  return totalSize;
+}
+
+// reads the list of saved memory ranges. Before 0x9 whole memory objects were saved, listed by
+// where each one starts in the data, and those are read as ranges of VK_WHOLE_SIZE.
+static void ReadSparseMemRanges(Serialiser *ser, uint32_t logVersion, SparseMemRange *ranges,
+                                uint32_t numRanges)
+{
+  if(logVersion >= 0x0000009)
+  {
+    SparseMemRange *r = NULL;
+    ser->SerialiseComplexArray("memRanges", r, numRanges);
+    memcpy(ranges, r, sizeof(SparseMemRange) * numRanges);
+    delete[] r;
+  }
+  else
+  {
+    MemIDOffset *m = NULL;
+    ser->SerialiseComplexArray("mems", m, numRanges);
+
+    for(uint32_t i = 0; i < numRanges; i++)
+    {
+      ranges[i].memId = m[i].memId;
+      ranges[i].memOffs = 0;
+      ranges[i].size = VK_WHOLE_SIZE;
+      ranges[i].dataOffs = m[i].memOffs;
+    }
+
+    delete[] m;
+  }
+}
+
 struct SparseBufferInitState
 {
   uint32_t numBinds;
   VkSparseMemoryBind *binds;
 
-  uint32_t numUniqueMems;
-  MemIDOffset *memDataOffs;
+  uint32_t numMemRanges;
+  SparseMemRange *memRanges;
 
   VkDeviceSize totalSize;
 };
@@ -80,8 +416,8 @@ struct SparseImageInitState
   // available on replay - filled out in the READING path of Serialise_SparseInitialState
   VkSparseImageMemoryBind *pageBinds[NUM_VK_IMAGE_ASPECTS];
 
-  uint32_t numUniqueMems;
-  MemIDOffset *memDataOffs;
+  uint32_t numMemRanges;
+  SparseMemRange *memRanges;
 
   VkDeviceSize totalSize;
 };
@@ -90,58 +426,48 @@ bool WrappedVulkan::Prepare_SparseInitialState(WrappedVkBuffer *buf)
 {
   ResourceId id = buf->id;
 
-  // VKTODOLOW this is a bit conservative, as we save the whole memory object rather than just the
-  // bound range.
-  map<VkDeviceMemory, VkDeviceSize> boundMems;
+  const vector<VkSparseMemoryBind> &opaque = buf->record->sparseInfo->opaquemappings;
+
+  SparseBoundMemory boundMems;
 
-  // value will be filled out later once all memories are added
-  for(size_t i = 0; i < buf->record->sparseInfo->opaquemappings.size(); i++)
-    boundMems[buf->record->sparseInfo->opaquemappings[i].memory] = 0;
+  for(size_t i = 0; i < opaque.size(); i++)
+    if(opaque[i].memory != VK_NULL_HANDLE)
+      boundMems[opaque[i].memory].push_back(std::make_pair(opaque[i].memoryOffset, opaque[i].size));
 
-  uint32_t numElems = (uint32_t)buf->record->sparseInfo->opaquemappings.size();
+  vector<SparseMemRange> memRanges;
+  VkDeviceSize totalSize = GetSparseMemRanges(boundMems, memRanges);
+
+  uint32_t numElems = (uint32_t)opaque.size();
 
   SparseBufferInitState *info = (SparseBufferInitState *)Serialiser::AllocAlignedBuffer(
       sizeof(SparseBufferInitState) + sizeof(VkSparseMemoryBind) * numElems +
-      sizeof(MemIDOffset) * boundMems.size());
+      sizeof(SparseMemRange) * memRanges.size());
 
   VkSparseMemoryBind *binds = (VkSparseMemoryBind *)(info + 1);
-  MemIDOffset *memDataOffs = (MemIDOffset *)(binds + numElems);
+  SparseMemRange *ranges = (SparseMemRange *)(binds + numElems);
 
   info->numBinds = numElems;
-  info->numUniqueMems = (uint32_t)boundMems.size();
-  info->memDataOffs = memDataOffs;
+  info->numMemRanges = (uint32_t)memRanges.size();
+  info->memRanges = ranges;
   info->binds = binds;
 
-  memcpy(binds, &buf->record->sparseInfo->opaquemappings[0], sizeof(VkSparseMemoryBind) * numElems);
+  if(numElems > 0)
+    memcpy(binds, &opaque[0], sizeof(VkSparseMemoryBind) * numElems);
+  if(!memRanges.empty())
+    memcpy(ranges, &memRanges[0], sizeof(SparseMemRange) * memRanges.size());
+
+  info->totalSize = totalSize;
 
   VkDevice d = GetDev();
-  // INITSTATEBATCH
-  VkCommandBuffer cmd = GetNextCmd();
 
   VkBufferCreateInfo bufInfo = {
       VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
       NULL,
       0,
-      0,
+      RDCMAX(totalSize, (VkDeviceSize)1),
       VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
   };
 
-  uint32_t memidx = 0;
-  for(auto it = boundMems.begin(); it != boundMems.end(); ++it)
-  {
-    // store offset
-    it->second = bufInfo.size;
-
-    memDataOffs[memidx].memId = GetResID(it->first);
-    memDataOffs[memidx].memOffs = bufInfo.size;
-
-    // increase size
-    bufInfo.size += GetRecord(it->first)->Length;
-    memidx++;
-  }
-
-  info->totalSize = bufInfo.size;
-
   VkDeviceMemory readbackmem = VK_NULL_HANDLE;
 
   // since these are very short lived, they are not wrapped
@@ -171,18 +497,25 @@ bool WrappedVulkan::Prepare_SparseInitialState(WrappedVkBuffer *buf)
   vkr = ObjDisp(d)->BindBufferMemory(Unwrap(d), dstBuf, Unwrap(readbackmem), 0);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-  vector<VkBuffer> bufdeletes;
-  bufdeletes.push_back(dstBuf);
-
-  VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
-                                        VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+  m_InitStateBatch.buffers.push_back(dstBuf);
 
-  vkr = ObjDisp(d)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
-  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  VkCommandBuffer cmd = GetInitStateCmd();
 
-  // copy all of the bound memory objects
+  // copy the bound ranges of each memory object. The ranges are sorted by memory object
+  size_t r = 0;
   for(auto it = boundMems.begin(); it != boundMems.end(); ++it)
   {
+    vector<VkBufferCopy> regions;
+
+    for(; r < memRanges.size() && memRanges[r].memId == GetResID(it->first); r++)
+    {
+      VkBufferCopy region = {memRanges[r].memOffs, memRanges[r].dataOffs, memRanges[r].size};
+      regions.push_back(region);
+    }
+
+    if(regions.empty())
+      continue;
+
     VkBuffer srcBuf;
 
     bufInfo.size = GetRecord(it->first)->Length;
@@ -192,23 +525,13 @@ bool WrappedVulkan::Prepare_SparseInitialState(WrappedVkBuffer *buf)
     vkr = ObjDisp(d)->BindBufferMemory(Unwrap(d), srcBuf, Unwrap(it->first), 0);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    // copy srcbuf into its area in dstbuf
-    VkBufferCopy region = {0, it->second, bufInfo.size};
+    // copy the bound ranges of srcbuf into their areas in dstbuf
+    ObjDisp(d)->CmdCopyBuffer(Unwrap(cmd), srcBuf, dstBuf, (uint32_t)regions.size(), &regions[0]);
 
-    ObjDisp(d)->CmdCopyBuffer(Unwrap(cmd), srcBuf, dstBuf, 1, &region);
-
-    bufdeletes.push_back(srcBuf);
+    m_InitStateBatch.buffers.push_back(srcBuf);
   }
 
-  vkr = ObjDisp(d)->EndCommandBuffer(Unwrap(cmd));
-  RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-  // INITSTATEBATCH
-  SubmitCmds();
-  FlushQ();
-
-  for(size_t i = 0; i < bufdeletes.size(); i++)
-    ObjDisp(d)->DestroyBuffer(Unwrap(d), bufdeletes[i], NULL);
+  EndInitStateResource(0);
 
   GetResourceManager()->SetInitialContents(
       id, VulkanResourceManager::InitialContentData(GetWrapped(readbackmem), 0, (byte *)info));
@@ -222,26 +545,37 @@ bool WrappedVulkan::Prepare_SparseInitialState(WrappedVkImage *im)
 
   SparseMapping *sparse = im->record->sparseInfo;
 
-  // VKTODOLOW this is a bit conservative, as we save the whole memory object rather than just the
-  // bound range.
-  map<VkDeviceMemory, VkDeviceSize> boundMems;
+  VkDevice d = GetDev();
+
+  SparseBoundMemory boundMems;
 
-  // value will be filled out later once all memories are added
   for(size_t i = 0; i < sparse->opaquemappings.size(); i++)
-    boundMems[sparse->opaquemappings[i].memory] = 0;
+  {
+    const VkSparseMemoryBind &bind = sparse->opaquemappings[i];
+    if(bind.memory != VK_NULL_HANDLE)
+      boundMems[bind.memory].push_back(std::make_pair(bind.memoryOffset, bind.size));
+  }
 
   uint32_t pagePerAspect = sparse->imgdim.width * sparse->imgdim.height * sparse->imgdim.depth;
 
+  // the sparse block size in bytes is the image's memory alignment
+  VkMemoryRequirements pagemrq = {0};
+  ObjDisp(d)->GetImageMemoryRequirements(Unwrap(d), im->real.As<VkImage>(), &pagemrq);
+
   for(uint32_t a = 0; a < NUM_VK_IMAGE_ASPECTS; a++)
   {
     if(sparse->pages[a])
     {
       for(uint32_t i = 0; i < pagePerAspect; i++)
         if(sparse->pages[a][i].first != VK_NULL_HANDLE)
-          boundMems[sparse->pages[a][i].first] = 0;
+          boundMems[sparse->pages[a][i].first].push_back(
+              std::make_pair(sparse->pages[a][i].second, pagemrq.alignment));
     }
   }
 
+  vector<SparseMemRange> memRanges;
+  VkDeviceSize totalSize = GetSparseMemRanges(boundMems, memRanges);
+
   uint32_t totalPageCount = 0;
   for(uint32_t a = 0; a < NUM_VK_IMAGE_ASPECTS; a++)
     totalPageCount += sparse->pages[a] ? pagePerAspect : 0;
@@ -250,22 +584,25 @@ bool WrappedVulkan::Prepare_SparseInitialState(WrappedVkImage *im)
 
   byte *blob = Serialiser::AllocAlignedBuffer(
       sizeof(SparseImageInitState) + sizeof(VkSparseMemoryBind) * opaqueCount +
-      sizeof(MemIDOffset) * totalPageCount + sizeof(MemIDOffset) * boundMems.size());
+      sizeof(MemIDOffset) * totalPageCount + sizeof(SparseMemRange) * memRanges.size());
 
   SparseImageInitState *state = (SparseImageInitState *)blob;
   VkSparseMemoryBind *opaque = (VkSparseMemoryBind *)(state + 1);
   MemIDOffset *pages = (MemIDOffset *)(opaque + opaqueCount);
-  MemIDOffset *memDataOffs = (MemIDOffset *)(pages + totalPageCount);
+  SparseMemRange *ranges = (SparseMemRange *)(pages + totalPageCount);
 
   state->opaque = opaque;
   state->opaqueCount = opaqueCount;
   state->pagedim = sparse->pagedim;
   state->imgdim = sparse->imgdim;
-  state->numUniqueMems = (uint32_t)boundMems.size();
-  state->memDataOffs = memDataOffs;
+  state->numMemRanges = (uint32_t)memRanges.size();
+  state->memRanges = ranges;
+  state->totalSize = totalSize;
 
   if(opaqueCount > 0)
     memcpy(opaque, &sparse->opaquemappings[0], sizeof(VkSparseMemoryBind) * opaqueCount);
+  if(!memRanges.empty())
+    memcpy(ranges, &memRanges[0], sizeof(SparseMemRange) * memRanges.size());
 
   for(uint32_t a = 0; a < NUM_VK_IMAGE_ASPECTS; a++)
   {
@@ -289,34 +626,14 @@ bool WrappedVulkan::Prepare_SparseInitialState(WrappedVkImage *im)
     }
   }
 
-  VkDevice d = GetDev();
-  // INITSTATEBATCH
-  VkCommandBuffer cmd = GetNextCmd();
-
   VkBufferCreateInfo bufInfo = {
       VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
       NULL,
       0,
-      0,
+      RDCMAX(totalSize, (VkDeviceSize)1),
       VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
   };
 
-  uint32_t memidx = 0;
-  for(auto it = boundMems.begin(); it != boundMems.end(); ++it)
-  {
-    // store offset
-    it->second = bufInfo.size;
-
-    memDataOffs[memidx].memId = GetResID(it->first);
-    memDataOffs[memidx].memOffs = bufInfo.size;
-
-    // increase size
-    bufInfo.size += GetRecord(it->first)->Length;
-    memidx++;
-  }
-
-  state->totalSize = bufInfo.size;
-
   VkDeviceMemory readbackmem = VK_NULL_HANDLE;
 
   // since these are very short lived, they are not wrapped
@@ -346,18 +663,25 @@ bool WrappedVulkan::Prepare_SparseInitialState(WrappedVkImage *im)
   vkr = ObjDisp(d)->BindBufferMemory(Unwrap(d), dstBuf, Unwrap(readbackmem), 0);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-  vector<VkBuffer> bufdeletes;
-  bufdeletes.push_back(dstBuf);
+  m_InitStateBatch.buffers.push_back(dstBuf);
 
-  VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
-                                        VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
-
-  vkr = ObjDisp(d)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
-  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  VkCommandBuffer cmd = GetInitStateCmd();
 
-  // copy all of the bound memory objects
+  // copy the bound ranges of each memory object. The ranges are sorted by memory object
+  size_t r = 0;
   for(auto it = boundMems.begin(); it != boundMems.end(); ++it)
   {
+    vector<VkBufferCopy> regions;
+
+    for(; r < memRanges.size() && memRanges[r].memId == GetResID(it->first); r++)
+    {
+      VkBufferCopy region = {memRanges[r].memOffs, memRanges[r].dataOffs, memRanges[r].size};
+      regions.push_back(region);
+    }
+
+    if(regions.empty())
+      continue;
+
     VkBuffer srcBuf;
 
     bufInfo.size = GetRecord(it->first)->Length;
@@ -367,23 +691,13 @@ bool WrappedVulkan::Prepare_SparseInitialState(WrappedVkImage *im)
     vkr = ObjDisp(d)->BindBufferMemory(Unwrap(d), srcBuf, Unwrap(it->first), 0);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    // copy srcbuf into its area in dstbuf
-    VkBufferCopy region = {0, it->second, bufInfo.size};
-
-    ObjDisp(d)->CmdCopyBuffer(Unwrap(cmd), srcBuf, dstBuf, 1, &region);
+    // copy the bound ranges of srcbuf into their areas in dstbuf
+    ObjDisp(d)->CmdCopyBuffer(Unwrap(cmd), srcBuf, dstBuf, (uint32_t)regions.size(), &regions[0]);
 
-    bufdeletes.push_back(srcBuf);
+    m_InitStateBatch.buffers.push_back(srcBuf);
   }
 
-  vkr = ObjDisp(d)->EndCommandBuffer(Unwrap(cmd));
-  RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-  // INITSTATEBATCH
-  SubmitCmds();
-  FlushQ();
-
-  for(size_t i = 0; i < bufdeletes.size(); i++)
-    ObjDisp(d)->DestroyBuffer(Unwrap(d), bufdeletes[i], NULL);
+  EndInitStateResource(0);
 
   GetResourceManager()->SetInitialContents(
       id, VulkanResourceManager::InitialContentData(GetWrapped(readbackmem), 0, (byte *)blob));
@@ -399,13 +713,13 @@ bool WrappedVulkan::Serialise_SparseBufferInitialState(
     SparseBufferInitState *info = (SparseBufferInitState *)contents.blob;
 
     m_pSerialiser->Serialise("numBinds", info->numBinds);
-    m_pSerialiser->Serialise("numUniqueMems", info->numUniqueMems);
+    m_pSerialiser->Serialise("numMemRanges", info->numMemRanges);
 
     if(info->numBinds > 0)
       m_pSerialiser->SerialiseComplexArray("binds", info->binds, info->numBinds);
 
-    if(info->numUniqueMems > 0)
-      m_pSerialiser->SerialiseComplexArray("mems", info->memDataOffs, info->numUniqueMems);
+    if(info->numMemRanges > 0)
+      m_pSerialiser->SerialiseComplexArray("memRanges", info->memRanges, info->numMemRanges);
 
     VkDevice d = GetDev();
 
@@ -423,22 +737,22 @@ bool WrappedVulkan::Serialise_SparseBufferInitialState(
   else
   {
     uint32_t numBinds = 0;
-    uint32_t numUniqueMems = 0;
+    uint32_t numMemRanges = 0;
 
     m_pSerialiser->Serialise("numBinds", numBinds);
-    m_pSerialiser->Serialise("numUniqueMems", numUniqueMems);
+    m_pSerialiser->Serialise("numMemRanges", numMemRanges);
 
     SparseBufferInitState *info = (SparseBufferInitState *)Serialiser::AllocAlignedBuffer(
         sizeof(SparseBufferInitState) + sizeof(VkSparseMemoryBind) * numBinds +
-        sizeof(MemIDOffset) * numUniqueMems);
+        sizeof(SparseMemRange) * numMemRanges);
 
     VkSparseMemoryBind *binds = (VkSparseMemoryBind *)(info + 1);
-    MemIDOffset *memDataOffs = (MemIDOffset *)(binds + numBinds);
+    SparseMemRange *memRanges = (SparseMemRange *)(binds + numBinds);
 
     info->numBinds = numBinds;
-    info->numUniqueMems = numUniqueMems;
+    info->numMemRanges = numMemRanges;
     info->binds = binds;
-    info->memDataOffs = memDataOffs;
+    info->memRanges = memRanges;
 
     if(info->numBinds > 0)
     {
@@ -452,17 +766,10 @@ bool WrappedVulkan::Serialise_SparseBufferInitialState(
       info->binds = NULL;
     }
 
-    if(info->numUniqueMems > 0)
-    {
-      MemIDOffset *m = NULL;
-      m_pSerialiser->SerialiseComplexArray("mems", m, numUniqueMems);
-      memcpy(info->memDataOffs, m, sizeof(MemIDOffset) * numUniqueMems);
-      delete[] m;
-    }
+    if(info->numMemRanges > 0)
+      ReadSparseMemRanges(m_pSerialiser, GetLogVersion(), info->memRanges, numMemRanges);
     else
-    {
-      info->memDataOffs = NULL;
-    }
+      info->memRanges = NULL;
 
     m_pSerialiser->Serialise("totalSize", info->totalSize);
 
@@ -539,7 +846,7 @@ bool WrappedVulkan::Serialise_SparseImageInitialState(ResourceId id,
     m_pSerialiser->Serialise("totalPageCount", totalPageCount);
     m_pSerialiser->Serialise("imgdim", state->imgdim);
     m_pSerialiser->Serialise("pagedim", state->pagedim);
-    m_pSerialiser->Serialise("numUniqueMems", state->numUniqueMems);
+    m_pSerialiser->Serialise("numMemRanges", state->numMemRanges);
 
     if(state->opaqueCount > 0)
       m_pSerialiser->SerialiseComplexArray("opaque", state->opaque, state->opaqueCount);
@@ -555,8 +862,8 @@ bool WrappedVulkan::Serialise_SparseImageInitialState(ResourceId id,
       }
     }
 
-    if(state->numUniqueMems > 0)
-      m_pSerialiser->SerialiseComplexArray("mems", state->memDataOffs, state->numUniqueMems);
+    if(state->numMemRanges > 0)
+      m_pSerialiser->SerialiseComplexArray("memRanges", state->memRanges, state->numMemRanges);
 
     VkDevice d = GetDev();
 
@@ -575,7 +882,7 @@ bool WrappedVulkan::Serialise_SparseImageInitialState(ResourceId id,
   {
     uint32_t opaqueCount = 0;
     uint32_t pageCount = 0;
-    uint32_t numUniqueMems = 0;
+    uint32_t numMemRanges = 0;
     VkExtent3D imgdim = {};
     VkExtent3D pagedim = {};
 
@@ -583,16 +890,16 @@ bool WrappedVulkan::Serialise_SparseImageInitialState(ResourceId id,
     m_pSerialiser->Serialise("pageCount", pageCount);
     m_pSerialiser->Serialise("imgdim", imgdim);
     m_pSerialiser->Serialise("pagedim", pagedim);
-    m_pSerialiser->Serialise("numUniqueMems", numUniqueMems);
+    m_pSerialiser->Serialise("numMemRanges", numMemRanges);
 
     byte *blob = Serialiser::AllocAlignedBuffer(
         sizeof(SparseImageInitState) + sizeof(VkSparseMemoryBind) * opaqueCount +
-        sizeof(VkSparseImageMemoryBind) * pageCount + sizeof(MemIDOffset) * numUniqueMems);
+        sizeof(VkSparseImageMemoryBind) * pageCount + sizeof(SparseMemRange) * numMemRanges);
 
     SparseImageInitState *state = (SparseImageInitState *)blob;
     VkSparseMemoryBind *opaque = (VkSparseMemoryBind *)(state + 1);
     VkSparseImageMemoryBind *pageBinds = (VkSparseImageMemoryBind *)(opaque + opaqueCount);
-    MemIDOffset *memDataOffs = (MemIDOffset *)(pageBinds + pageCount);
+    SparseMemRange *memRanges = (SparseMemRange *)(pageBinds + pageCount);
 
     RDCEraseEl(state->pageBinds);
 
@@ -600,8 +907,8 @@ bool WrappedVulkan::Serialise_SparseImageInitialState(ResourceId id,
     state->opaque = opaque;
     state->imgdim = imgdim;
     state->pagedim = pagedim;
-    state->numUniqueMems = numUniqueMems;
-    state->memDataOffs = memDataOffs;
+    state->numMemRanges = numMemRanges;
+    state->memRanges = memRanges;
 
     if(opaqueCount > 0)
     {
@@ -664,17 +971,10 @@ bool WrappedVulkan::Serialise_SparseImageInitialState(ResourceId id,
       }
     }
 
-    if(state->numUniqueMems > 0)
-    {
-      MemIDOffset *m = NULL;
-      m_pSerialiser->SerialiseComplexArray("opaque", m, numUniqueMems);
-      memcpy(state->memDataOffs, m, sizeof(MemIDOffset) * numUniqueMems);
-      delete[] m;
-    }
+    if(state->numMemRanges > 0)
+      ReadSparseMemRanges(m_pSerialiser, GetLogVersion(), state->memRanges, numMemRanges);
     else
-    {
-      state->memDataOffs = NULL;
-    }
+      state->memRanges = NULL;
 
     m_pSerialiser->Serialise("totalSize", state->totalSize);
 
@@ -804,25 +1104,21 @@ bool WrappedVulkan::Apply_SparseInitialState(WrappedVkBuffer *buf,
   vkr = ObjDisp(cmd)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-  VkBufferCreateInfo bufInfo = {
-      VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-      NULL,
-      0,
-      0,
-      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-  };
-
-  for(uint32_t i = 0; i < info->numUniqueMems; i++)
+  for(uint32_t i = 0; i < info->numMemRanges; i++)
   {
-    VkDeviceMemory dstMem =
-        GetResourceManager()->GetLiveHandle<VkDeviceMemory>(info->memDataOffs[i].memId);
+    const SparseMemRange &range = info->memRanges[i];
+
+    VkDeviceMemory dstMem = GetResourceManager()->GetLiveHandle<VkDeviceMemory>(range.memId);
 
     VkBuffer dstBuf = m_CreationInfo.m_Memory[GetResID(dstMem)].wholeMemBuf;
 
-    bufInfo.size = m_CreationInfo.m_Memory[GetResID(dstMem)].size;
+    // older captures saved the whole memory
+    VkDeviceSize size = range.size;
+    if(size == VK_WHOLE_SIZE)
+      size = m_CreationInfo.m_Memory[GetResID(dstMem)].size;
 
-    // fill the whole memory from the given offset
-    VkBufferCopy region = {info->memDataOffs[i].memOffs, 0, bufInfo.size};
+    // fill the bound range of the memory from its place in the data
+    VkBufferCopy region = {range.dataOffs, range.memOffs, size};
 
     ObjDisp(cmd)->CmdCopyBuffer(Unwrap(cmd), Unwrap(srcBuf), Unwrap(dstBuf), 1, &region);
   }
@@ -944,26 +1240,23 @@ bool WrappedVulkan::Apply_SparseInitialState(WrappedVkImage *im,
   vkr = ObjDisp(cmd)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-  VkBufferCreateInfo bufInfo = {
-      VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-      NULL,
-      0,
-      0,
-      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-  };
-
-  for(uint32_t i = 0; i < info->numUniqueMems; i++)
+  for(uint32_t i = 0; i < info->numMemRanges; i++)
   {
-    VkDeviceMemory dstMem =
-        GetResourceManager()->GetLiveHandle<VkDeviceMemory>(info->memDataOffs[i].memId);
+    const SparseMemRange &range = info->memRanges[i];
+
+    VkDeviceMemory dstMem = GetResourceManager()->GetLiveHandle<VkDeviceMemory>(range.memId);
 
     // since this is short lived it isn't wrapped. Note that we want
     // to cache this up front, so it will then be wrapped
     VkBuffer dstBuf = m_CreationInfo.m_Memory[GetResID(dstMem)].wholeMemBuf;
-    bufInfo.size = m_CreationInfo.m_Memory[GetResID(dstMem)].size;
 
-    // fill the whole memory from the given offset
-    VkBufferCopy region = {info->memDataOffs[i].memOffs, 0, bufInfo.size};
+    // older captures saved the whole memory
+    VkDeviceSize size = range.size;
+    if(size == VK_WHOLE_SIZE)
+      size = m_CreationInfo.m_Memory[GetResID(dstMem)].size;
+
+    // fill the bound range of the memory from its place in the data
+    VkBufferCopy region = {range.dataOffs, range.memOffs, size};
 
     ObjDisp(cmd)->CmdCopyBuffer(Unwrap(cmd), Unwrap(srcBuf), Unwrap(dstBuf), 1, &region);
   }
@@ -974,6 +1267,57 @@ bool WrappedVulkan::Apply_SparseInitialState(WrappedVkImage *im,
   return true;
 }
 
+uint64_t WrappedVulkan::PrepareAheadSize_InitialState(WrappedVkRes *res)
+{
+  VkResourceType type = IdentifyTypeByPtr(res);
+
+  // descriptor sets are cheap to copy on the CPU and sparse resources change their page table
+  // often, so those are always prepared when the capture starts
+  if(type == eResImage)
+  {
+    WrappedVkImage *im = (WrappedVkImage *)res;
+
+    if(im->record->sparseInfo)
+      return 0;
+
+    VkDevice d = GetDev();
+
+    VkMemoryRequirements mrq = {0};
+    ObjDisp(d)->GetImageMemoryRequirements(Unwrap(d), im->real.As<VkImage>(), &mrq);
+
+    return mrq.size;
+  }
+  else if(type == eResDeviceMemory)
+  {
+    VkResourceRecord *record =
+        GetResourceManager()->GetResourceRecord(GetResourceManager()->GetID(res));
+
+    // mapped memory can be written by the CPU at any time without being marked dirty
+    if(record == NULL || (record->memMapState && record->memMapState->mappedPtr))
+      return 0;
+
+    return record->Length;
+  }
+
+  return 0;
+}
+
+uint64_t WrappedVulkan::GetSize_InitialState(WrappedVkRes *res)
+{
+  // only image contents are left out to fit the initial contents budget. Memory holds buffers that
+  // can't be substituted with anything sensible, and images replace cleanly with a clear.
+  if(IdentifyTypeByPtr(res) != eResImage || ((WrappedVkImage *)res)->record->sparseInfo)
+    return 0;
+
+  VkDevice d = GetDev();
+
+  VkMemoryRequirements mrq = {0};
+  ObjDisp(d)->GetImageMemoryRequirements(Unwrap(d), ((WrappedVkImage *)res)->real.As<VkImage>(),
+                                         &mrq);
+
+  return mrq.size;
+}
+
 bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
 {
   ResourceId id = GetResourceManager()->GetID(res);
@@ -1026,8 +1370,6 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
     }
 
     VkDevice d = GetDev();
-    // INITSTATEBATCH
-    VkCommandBuffer cmd = GetNextCmd();
 
     ImageLayouts *layout = NULL;
     {
@@ -1052,6 +1394,7 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
 
     VkImage arrayIm = VK_NULL_HANDLE;
     VkDeviceMemory arrayMem = VK_NULL_HANDLE;
+    VkDeviceSize arrayMemSize = 0;
 
     VkImage realim = im->real.As<VkImage>();
     int numLayers = layout->layerCount;
@@ -1092,6 +1435,8 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
 
       vkr = ObjDisp(d)->BindImageMemory(Unwrap(d), arrayIm, arrayMem, 0);
       RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+      arrayMemSize = mrq.size;
     }
 
     VkFormat sizeFormat = GetDepthOnlyFormat(layout->format);
@@ -1116,10 +1461,37 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
       }
     }
 
+    // optionally the image is copied to GPU-local memory and compressed there, so only the
+    // compressed form is written to readback memory. See initstate_compress.comp for the layout.
+    const uint32_t blockDwords = VulkanDebugManager::InitStateCompressBlockDwords;
+
+    uint32_t numDwords = uint32_t(AlignUp(bufInfo.size, (VkDeviceSize)4) / 4);
+    uint32_t numBlocks = (numDwords + blockDwords - 1) / blockDwords;
+    uint32_t compressedOffset =
+        AlignUp(VulkanDebugManager::InitStateCompressHeaderDwords + numBlocks * 2, blockDwords);
+    VkDeviceSize compressedSize = VkDeviceSize(compressedOffset + numBlocks * blockDwords) * 4;
+
+    bool compress = RenderDoc::Inst().GetCaptureOptions().CompressInitialContentsOnGPU &&
+                    bufInfo.size >= InitStateCompressMinSize &&
+                    compressedSize <= GetDeviceProps().limits.maxStorageBufferRange;
+
+    if(compress && !GetDebugManager()->CanCompressInitState())
+      FlushInitStateBatch();
+
+    compress = compress && GetDebugManager()->CanCompressInitState();
+
+    VkBufferCreateInfo dstInfo = bufInfo;
+
+    if(compress)
+    {
+      dstInfo.size = compressedSize;
+      dstInfo.usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    }
+
     // since this is very short lived, it is not wrapped
     VkBuffer dstBuf;
 
-    vkr = ObjDisp(d)->CreateBuffer(Unwrap(d), &bufInfo, NULL, &dstBuf);
+    vkr = ObjDisp(d)->CreateBuffer(Unwrap(d), &dstInfo, NULL, &dstBuf);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
     VkMemoryRequirements mrq = {0};
@@ -1139,11 +1511,43 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
     vkr = ObjDisp(d)->BindBufferMemory(Unwrap(d), dstBuf, Unwrap(readbackmem), 0);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
-                                          VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+    // the buffer the image is copied into
+    VkBuffer copyBuf = dstBuf;
+    VkDeviceSize copyMemSize = 0;
 
-    vkr = ObjDisp(d)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    if(compress)
+    {
+      VkBufferCreateInfo copyInfo = bufInfo;
+      copyInfo.size = VkDeviceSize(numDwords) * 4;
+      copyInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+
+      vkr = ObjDisp(d)->CreateBuffer(Unwrap(d), &copyInfo, NULL, &copyBuf);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+      VkMemoryRequirements copyMrq = {0};
+
+      ObjDisp(d)->GetBufferMemoryRequirements(Unwrap(d), copyBuf, &copyMrq);
+
+      VkMemoryAllocateInfo copyAllocInfo = {
+          VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL, copyMrq.size,
+          GetGPULocalMemoryIndex(copyMrq.memoryTypeBits),
+      };
+
+      VkDeviceMemory copyMem = VK_NULL_HANDLE;
+
+      vkr = ObjDisp(d)->AllocateMemory(Unwrap(d), &copyAllocInfo, NULL, &copyMem);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+      vkr = ObjDisp(d)->BindBufferMemory(Unwrap(d), copyBuf, copyMem, 0);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+      m_InitStateBatch.buffers.push_back(copyBuf);
+      m_InitStateBatch.mems.push_back(copyMem);
+
+      copyMemSize = copyMrq.size;
+    }
+
+    VkCommandBuffer cmd = GetInitStateCmd();
 
     VkImageAspectFlags aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT;
     if(IsStencilOnlyFormat(layout->format))
@@ -1199,16 +1603,14 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
 
       DoPipelineBarrier(cmd, 1, &arrayimBarrier);
 
-      vkr = ObjDisp(d)->EndCommandBuffer(Unwrap(cmd));
-      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+      // the conversion submits its own work, so everything batched so far must be closed off
+      // first to keep it in order
+      CloseInitStateCmd();
 
       GetDebugManager()->CopyTex2DMSToArray(arrayIm, realim, layout->extent, layout->layerCount,
                                             layout->sampleCount, layout->format);
 
-      cmd = GetNextCmd();
-
-      vkr = ObjDisp(d)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
-      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+      cmd = GetInitStateCmd();
 
       arrayimBarrier.srcAccessMask =
           VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
@@ -1249,7 +1651,7 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
                                  sizeFormat, m);
 
         ObjDisp(d)->CmdCopyImageToBuffer(Unwrap(cmd), realim, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                                         dstBuf, 1, &region);
+                                         copyBuf, 1, &region);
 
         if(sizeFormat != layout->format)
         {
@@ -1263,7 +1665,7 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
                                    layout->extent.depth, VK_FORMAT_S8_UINT, m);
 
           ObjDisp(d)->CmdCopyImageToBuffer(
-              Unwrap(cmd), realim, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dstBuf, 1, &region);
+              Unwrap(cmd), realim, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, copyBuf, 1, &region);
         }
 
         // update the extent for the next mip
@@ -1276,6 +1678,36 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
     RDCASSERTMSG("buffer wasn't sized sufficiently!", bufOffset <= bufInfo.size, bufOffset,
                  mrq.size, layout->extent, layout->format, numLayers, layout->levelCount);
 
+    if(compress)
+    {
+      // the non-uniform block count is accumulated with atomics, so it must start at zero
+      ObjDisp(d)->CmdFillBuffer(Unwrap(cmd), dstBuf, 0,
+                                VulkanDebugManager::InitStateCompressHeaderDwords * 4, 0);
+
+      VkBufferMemoryBarrier bufBarriers[] = {
+          {
+              VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER, NULL, VK_ACCESS_TRANSFER_WRITE_BIT,
+              VK_ACCESS_SHADER_READ_BIT, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+              copyBuf, 0, VK_WHOLE_SIZE,
+          },
+          {
+              VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER, NULL, VK_ACCESS_TRANSFER_WRITE_BIT,
+              VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_QUEUE_FAMILY_IGNORED,
+              VK_QUEUE_FAMILY_IGNORED, dstBuf, 0, VK_WHOLE_SIZE,
+          },
+      };
+
+      DoPipelineBarrier(cmd, ARRAY_COUNT(bufBarriers), bufBarriers);
+
+      GetDebugManager()->CompressInitState(cmd, copyBuf, dstBuf, numDwords, numBlocks,
+                                           compressedOffset);
+
+      bufBarriers[1].srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+      bufBarriers[1].dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+      DoPipelineBarrier(cmd, 1, &bufBarriers[1]);
+    }
+
     // transfer back to whatever it was
     srcimBarrier.oldLayout = srcimBarrier.newLayout;
 
@@ -1290,24 +1722,35 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
       DoPipelineBarrier(cmd, 1, &srcimBarrier);
     }
 
-    vkr = ObjDisp(d)->EndCommandBuffer(Unwrap(cmd));
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    m_InitStateBatch.buffers.push_back(dstBuf);
 
-    // INITSTATEBATCH
-    SubmitCmds();
-    FlushQ();
+    if(arrayIm != VK_NULL_HANDLE)
+    {
+      m_InitStateBatch.images.push_back(arrayIm);
+      m_InitStateBatch.mems.push_back(arrayMem);
+    }
 
-    ObjDisp(d)->DestroyBuffer(Unwrap(d), dstBuf, NULL);
+    if(compress)
+    {
+      CompressedImageInitState *state = (CompressedImageInitState *)Serialiser::AllocAlignedBuffer(
+          sizeof(CompressedImageInitState));
 
-    if(arrayIm != VK_NULL_HANDLE)
+      state->numBlocks = numBlocks;
+      state->dataOffset = compressedOffset;
+
+      // num is the size of the data once it's expanded again
+      GetResourceManager()->SetInitialContents(
+          id, VulkanResourceManager::InitialContentData(GetWrapped(readbackmem), numDwords * 4,
+                                                        (byte *)state));
+    }
+    else
     {
-      ObjDisp(d)->DestroyImage(Unwrap(d), arrayIm, NULL);
-      ObjDisp(d)->FreeMemory(Unwrap(d), arrayMem, NULL);
+      GetResourceManager()->SetInitialContents(
+          id, VulkanResourceManager::InitialContentData(GetWrapped(readbackmem), (uint32_t)mrq.size,
+                                                        NULL));
     }
 
-    GetResourceManager()->SetInitialContents(
-        id, VulkanResourceManager::InitialContentData(GetWrapped(readbackmem), (uint32_t)mrq.size,
-                                                      NULL));
+    EndInitStateResource(arrayMemSize + copyMemSize);
 
     return true;
   }
@@ -1316,19 +1759,78 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
     VkResult vkr = VK_SUCCESS;
 
     VkDevice d = GetDev();
-    // INITSTATEBATCH
-    VkCommandBuffer cmd = GetNextCmd();
 
     VkResourceRecord *record = GetResourceManager()->GetResourceRecord(id);
-    VkDeviceSize dataoffs = 0;
     VkDeviceMemory datamem = ToHandle<VkDeviceMemory>(res);
-    VkDeviceSize datasize = record->Length;
 
     RDCASSERT(datamem != VK_NULL_HANDLE);
 
     RDCASSERT(record->Length > 0);
     VkDeviceSize memsize = record->Length;
 
+    // only read back the ranges that currently have something bound. If nothing is known to be
+    // bound (e.g. the memory is only used for sparse bindings) the whole memory is read back.
+    vector<MemoryBinding> bindings = GetMemoryBindings(id);
+
+    for(size_t i = 0; i < bindings.size();)
+    {
+      if(bindings[i].offset >= memsize || bindings[i].size == 0)
+      {
+        bindings.erase(bindings.begin() + i);
+        continue;
+      }
+
+      bindings[i].size = RDCMIN(bindings[i].size, memsize - bindings[i].offset);
+      i++;
+    }
+
+    std::sort(bindings.begin(), bindings.end());
+
+    vector<MemoryRange> ranges;
+
+    if(bindings.empty())
+    {
+      MemoryRange whole = {0, memsize, 0};
+      ranges.push_back(whole);
+    }
+
+    for(size_t i = 0; i < bindings.size(); i++)
+    {
+      VkDeviceSize end = bindings[i].offset + bindings[i].size;
+
+      if(!ranges.empty() && bindings[i].offset <= ranges.back().memOffset + ranges.back().size)
+      {
+        MemoryRange &last = ranges.back();
+        last.size = RDCMAX(last.size, end - last.memOffset);
+      }
+      else
+      {
+        MemoryRange range = {bindings[i].offset, bindings[i].size, 0};
+        ranges.push_back(range);
+      }
+    }
+
+    VkDeviceSize datasize = 0;
+    for(size_t i = 0; i < ranges.size(); i++)
+    {
+      ranges[i].dataOffset = datasize;
+      datasize += ranges[i].size;
+    }
+
+    byte *blob = Serialiser::AllocAlignedBuffer(sizeof(MemoryInitState) +
+                                                sizeof(MemoryRange) * ranges.size() +
+                                                sizeof(MemoryBinding) * bindings.size());
+
+    MemoryInitState *state = (MemoryInitState *)blob;
+    state->numRanges = (uint32_t)ranges.size();
+    state->ranges = (MemoryRange *)(state + 1);
+    state->numBindings = (uint32_t)bindings.size();
+    state->bindings = (MemoryBinding *)(state->ranges + ranges.size());
+
+    memcpy(state->ranges, &ranges[0], sizeof(MemoryRange) * ranges.size());
+    if(!bindings.empty())
+      memcpy(state->bindings, &bindings[0], sizeof(MemoryBinding) * bindings.size());
+
     VkDeviceMemory readbackmem = VK_NULL_HANDLE;
 
     VkBufferCreateInfo bufInfo = {
@@ -1342,7 +1844,7 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
     // since these are very short lived, they are not wrapped
     VkBuffer srcBuf, dstBuf;
 
-    // dstBuf is just over the allocated memory, so only the image's size
+    // dstBuf is just over the allocated memory, so only the size of the ranges being read back
     bufInfo.size = datasize;
     vkr = ObjDisp(d)->CreateBuffer(Unwrap(d), &bufInfo, NULL, &dstBuf);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
@@ -1373,29 +1875,27 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
     vkr = ObjDisp(d)->BindBufferMemory(Unwrap(d), dstBuf, Unwrap(readbackmem), 0);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
-                                          VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
-
-    vkr = ObjDisp(d)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-    VkBufferCopy region = {dataoffs, 0, datasize};
+    VkCommandBuffer cmd = GetInitStateCmd();
 
-    ObjDisp(d)->CmdCopyBuffer(Unwrap(cmd), srcBuf, dstBuf, 1, &region);
+    vector<VkBufferCopy> regions(ranges.size());
 
-    vkr = ObjDisp(d)->EndCommandBuffer(Unwrap(cmd));
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    for(size_t i = 0; i < ranges.size(); i++)
+    {
+      regions[i].srcOffset = ranges[i].memOffset;
+      regions[i].dstOffset = ranges[i].dataOffset;
+      regions[i].size = ranges[i].size;
+    }
 
-    // INITSTATEBATCH
-    SubmitCmds();
-    FlushQ();
+    ObjDisp(d)->CmdCopyBuffer(Unwrap(cmd), srcBuf, dstBuf, (uint32_t)regions.size(), &regions[0]);
 
-    ObjDisp(d)->DestroyBuffer(Unwrap(d), srcBuf, NULL);
-    ObjDisp(d)->DestroyBuffer(Unwrap(d), dstBuf, NULL);
+    m_InitStateBatch.buffers.push_back(srcBuf);
+    m_InitStateBatch.buffers.push_back(dstBuf);
 
     GetResourceManager()->SetInitialContents(
         id, VulkanResourceManager::InitialContentData(GetWrapped(readbackmem), (uint32_t)datasize,
-                                                      NULL));
+                                                      blob));
+
+    EndInitStateResource(0);
 
     return true;
   }
@@ -1407,6 +1907,57 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
   return false;
 }
 
+// returns the read back ranges of a memory's initial contents that are covered by a binding
+// referenced in the frame, with dataOffset pointing into the readback.
+static vector<MemoryRange> GetReferencedMemoryRanges(VulkanResourceManager *rm,
+                                                     MemoryInitState *state)
+{
+  vector<MemoryRange> ret;
+
+  // without any known bindings, or when all resources are kept, write everything read back
+  if(state->numBindings == 0 || RenderDoc::Inst().GetCaptureOptions().RefAllResources)
+  {
+    ret.assign(state->ranges, state->ranges + state->numRanges);
+    return ret;
+  }
+
+  // the bindings are sorted by offset, so merge the referenced ones in a single pass. Each merged
+  // range lies entirely within one of the read back ranges since those are merged from all of
+  // the bindings.
+  uint32_t r = 0;
+
+  for(uint32_t i = 0; i < state->numBindings; i++)
+  {
+    const MemoryBinding &b = state->bindings[i];
+
+    if(!rm->IsResourceFrameReferenced(b.resource))
+      continue;
+
+    VkDeviceSize end = b.offset + b.size;
+
+    if(!ret.empty() && b.offset <= ret.back().memOffset + ret.back().size)
+    {
+      MemoryRange &last = ret.back();
+      last.size = RDCMAX(last.size, end - last.memOffset);
+      continue;
+    }
+
+    while(r < state->numRanges &&
+          state->ranges[r].memOffset + state->ranges[r].size <= b.offset)
+      r++;
+
+    if(r == state->numRanges)
+      break;
+
+    const MemoryRange &src = state->ranges[r];
+
+    MemoryRange range = {b.offset, b.size, src.dataOffset + (b.offset - src.memOffset)};
+    ret.push_back(range);
+  }
+
+  return ret;
+}
+
 // second parameter isn't used, as we might be serialising init state for a deleted resource
 bool WrappedVulkan::Serialise_InitialState(ResourceId resid, WrappedVkRes *)
 {
@@ -1449,13 +2000,13 @@ bool WrappedVulkan::Serialise_InitialState(ResourceId resid, WrappedVkRes *)
       // both image and memory are serialised as a whole hunk of data
       VkDevice d = GetDev();
 
-      bool isSparse = (initContents.blob != NULL);
+      // memory always has a range list blob. Images have one when sparse, or when compressed
+      bool isSparse = (type == eResImage && record->sparseInfo != NULL);
       m_pSerialiser->Serialise("isSparse", isSparse);
 
       if(isSparse)
       {
         // contains page mapping
-        RDCASSERT(type == eResImage);
         return Serialise_SparseImageInitialState(id, initContents);
       }
 
@@ -1463,10 +2014,52 @@ bool WrappedVulkan::Serialise_InitialState(ResourceId resid, WrappedVkRes *)
       ObjDisp(d)->MapMemory(Unwrap(d), ToHandle<VkDeviceMemory>(initContents.resource), 0,
                             VK_WHOLE_SIZE, 0, (void **)&ptr);
 
-      size_t dataSize = (size_t)initContents.num;
+      if(type == eResDeviceMemory)
+      {
+        vector<MemoryRange> ranges =
+            GetReferencedMemoryRanges(GetResourceManager(), (MemoryInitState *)initContents.blob);
+
+        uint32_t dataSize = 0;
+        for(size_t i = 0; i < ranges.size(); i++)
+          dataSize += (uint32_t)ranges[i].size;
+
+        uint32_t numRanges = (uint32_t)ranges.size();
 
-      m_pSerialiser->Serialise("dataSize", initContents.num);
-      m_pSerialiser->SerialiseBuffer("data", ptr, dataSize);
+        m_pSerialiser->Serialise("dataSize", dataSize);
+        m_pSerialiser->Serialise("numRanges", numRanges);
+
+        for(uint32_t i = 0; i < numRanges; i++)
+        {
+          byte *rangeData = ptr + ranges[i].dataOffset;
+          size_t rangeSize = (size_t)ranges[i].size;
+
+          m_pSerialiser->Serialise("memOffset", ranges[i].memOffset);
+          m_pSerialiser->SerialiseBuffer("data", rangeData, rangeSize);
+        }
+      }
+      else if(initContents.blob)
+      {
+        uint32_t dataSize = initContents.num;
+
+        byte *expanded = new byte[dataSize];
+
+        ExpandCompressedImageInitState((CompressedImageInitState *)initContents.blob, ptr,
+                                       expanded, dataSize);
+
+        size_t expandedSize = (size_t)dataSize;
+
+        m_pSerialiser->Serialise("dataSize", dataSize);
+        m_pSerialiser->SerialiseBuffer("data", expanded, expandedSize);
+
+        SAFE_DELETE_ARRAY(expanded);
+      }
+      else
+      {
+        size_t dataSize = (size_t)initContents.num;
+
+        m_pSerialiser->Serialise("dataSize", initContents.num);
+        m_pSerialiser->SerialiseBuffer("data", ptr, dataSize);
+      }
 
       ObjDisp(d)->UnmapMemory(Unwrap(d), ToHandle<VkDeviceMemory>(initContents.resource));
     }
@@ -1905,7 +2498,7 @@ bool WrappedVulkan::Serialise_InitialState(ResourceId resid, WrappedVkRes *)
           VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
           NULL,
           0,
-          dataSize,
+          RDCMAX(dataSize, 1U),
           VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
       };
 
@@ -1936,15 +2529,52 @@ bool WrappedVulkan::Serialise_InitialState(ResourceId resid, WrappedVkRes *)
       byte *ptr = NULL;
       ObjDisp(d)->MapMemory(Unwrap(d), Unwrap(mem), 0, VK_WHOLE_SIZE, 0, (void **)&ptr);
 
-      size_t dummy = 0;
-      m_pSerialiser->SerialiseBuffer("data", ptr, dummy);
+      byte *blob = NULL;
+
+      // from version 0x7 only some ranges of the memory are serialised
+      if(GetLogVersion() >= 0x0000007)
+      {
+        uint32_t numRanges = 0;
+        m_pSerialiser->Serialise("numRanges", numRanges);
+
+        blob = Serialiser::AllocAlignedBuffer(sizeof(MemoryInitState) +
+                                              sizeof(MemoryRange) * numRanges);
+
+        MemoryInitState *state = (MemoryInitState *)blob;
+        state->numRanges = numRanges;
+        state->ranges = (MemoryRange *)(state + 1);
+        state->numBindings = 0;
+        state->bindings = NULL;
+
+        VkDeviceSize dataOffset = 0;
+
+        for(uint32_t i = 0; i < numRanges; i++)
+        {
+          MemoryRange &range = state->ranges[i];
+
+          m_pSerialiser->Serialise("memOffset", range.memOffset);
+
+          byte *rangeData = ptr + dataOffset;
+          size_t rangeSize = 0;
+          m_pSerialiser->SerialiseBuffer("data", rangeData, rangeSize);
+
+          range.size = rangeSize;
+          range.dataOffset = dataOffset;
+          dataOffset += rangeSize;
+        }
+      }
+      else
+      {
+        size_t dummy = 0;
+        m_pSerialiser->SerialiseBuffer("data", ptr, dummy);
+      }
 
       ObjDisp(d)->UnmapMemory(Unwrap(d), Unwrap(mem));
 
       m_CleanupMems.push_back(mem);
 
       GetResourceManager()->SetInitialContents(
-          id, VulkanResourceManager::InitialContentData(GetWrapped(buf), (uint32_t)dataSize, NULL));
+          id, VulkanResourceManager::InitialContentData(GetWrapped(buf), (uint32_t)dataSize, blob));
     }
     else
     {
@@ -2444,9 +3074,29 @@ void WrappedVulkan::Apply_InitialState(WrappedVkRes *live,
 
     VkBuffer dstBuf = m_CreationInfo.m_Memory[id].wholeMemBuf;
 
-    VkBufferCopy region = {0, dstMemOffs, datasize};
+    MemoryInitState *state = (MemoryInitState *)initial.blob;
 
-    ObjDisp(cmd)->CmdCopyBuffer(Unwrap(cmd), Unwrap(srcBuf), Unwrap(dstBuf), 1, &region);
+    if(state)
+    {
+      vector<VkBufferCopy> regions(state->numRanges);
+
+      for(uint32_t i = 0; i < state->numRanges; i++)
+      {
+        regions[i].srcOffset = state->ranges[i].dataOffset;
+        regions[i].dstOffset = state->ranges[i].memOffset;
+        regions[i].size = state->ranges[i].size;
+      }
+
+      if(!regions.empty())
+        ObjDisp(cmd)->CmdCopyBuffer(Unwrap(cmd), Unwrap(srcBuf), Unwrap(dstBuf),
+                                    (uint32_t)regions.size(), &regions[0]);
+    }
+    else
+    {
+      VkBufferCopy region = {0, dstMemOffs, datasize};
+
+      ObjDisp(cmd)->CmdCopyBuffer(Unwrap(cmd), Unwrap(srcBuf), Unwrap(dstBuf), 1, &region);
+    }
 
     vkr = ObjDisp(cmd)->EndCommandBuffer(Unwrap(cmd));
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
@@ -219,7 +219,10 @@ void VulkanResourceManager::RecordBarriers(vector<pair<ResourceId, ImageRegionSt
     uint32_t nummips = t.subresourceRange.levelCount;
     uint32_t numslices = t.subresourceRange.layerCount;
 
-    auto it = layouts.find(id);
+    // the layouts are only looked at if needed, see WrappedVulkan::RecordCmdImageBarriers
+    auto it = layouts.end();
+    if(nummips == VK_REMAINING_MIP_LEVELS || numslices == VK_REMAINING_ARRAY_LAYERS)
+      it = layouts.find(id);
 
     if(nummips == VK_REMAINING_MIP_LEVELS)
     {
@@ -581,6 +584,16 @@ bool VulkanResourceManager::Prepare_InitialState(WrappedVkRes *res)
   return m_Core->Prepare_InitialState(res);
 }
 
+uint64_t VulkanResourceManager::PrepareAheadSize_InitialState(WrappedVkRes *res)
+{
+  return m_Core->PrepareAheadSize_InitialState(res);
+}
+
+uint64_t VulkanResourceManager::GetSize_InitialState(WrappedVkRes *res)
+{
+  return m_Core->GetSize_InitialState(res);
+}
+
 bool VulkanResourceManager::Serialise_InitialState(ResourceId resid, WrappedVkRes *res)
 {
   return m_Core->Serialise_InitialState(resid, res);
@@ -264,6 +264,8 @@ private:
   bool AllowDeletedResource_InitialState() { return true; }
   bool Need_InitialStateChunk(WrappedVkRes *res);
   bool Prepare_InitialState(WrappedVkRes *res);
+  uint64_t PrepareAheadSize_InitialState(WrappedVkRes *res);
+  uint64_t GetSize_InitialState(WrappedVkRes *res);
   bool Serialise_InitialState(ResourceId resid, WrappedVkRes *res);
   void Create_InitialState(ResourceId id, WrappedVkRes *live, bool hasData);
   void Apply_InitialState(WrappedVkRes *live, InitialContentData initial);
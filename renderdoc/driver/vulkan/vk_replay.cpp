@@ -24,6 +24,7 @@
 
 #include "vk_replay.h"
 #include <float.h>
+#include "common/profiler.h"
 #include "maths/camera.h"
 #include "maths/matrix.h"
 #include "serialise/string_utils.h"
@@ -658,14 +659,22 @@ APIProperties VulkanReplay::GetAPIProperties()
 
 void VulkanReplay::ReadLogInitialisation()
 {
+  SCOPED_PROFILE("VulkanReplay::ReadLogInitialisation");
   m_pDriver->ReadLogInitialisation();
 }
 
 void VulkanReplay::ReplayLog(uint32_t endEventID, ReplayLogType replayType)
 {
+  SCOPED_PROFILE("VulkanReplay::ReplayLog", endEventID);
   m_pDriver->ReplayLog(0, endEventID, replayType);
 }
 
+bool VulkanReplay::AdvanceReplay(uint32_t fromEventID, uint32_t toEventID)
+{
+  // partial replays only work within a single command buffer
+  return false;
+}
+
 vector<uint32_t> VulkanReplay::GetPassEvents(uint32_t eventID)
 {
   vector<uint32_t> passEvents;
@@ -757,6 +766,39 @@ vector<DebugMessage> VulkanReplay::GetDebugMessages()
   return m_pDriver->GetDebugMessages();
 }
 
+vector<MemoryUsage> VulkanReplay::GetMemoryUsage()
+{
+  vector<MemoryUsage> ret;
+
+  ret.push_back(
+      MakeMemoryUsage("Capture data", false, 1, m_pDriver->GetMainSerialiser()->GetSize()));
+
+  // resources are copied on the GPU, so the serialised size is a close estimate of what the copies
+  // take
+  ret.push_back(MakeMemoryUsage("Initial contents", true,
+                                m_pDriver->GetResourceManager()->NumInitialContents(),
+                                m_pDriver->GetFrameRecord().frameInfo.initDataSize));
+
+  uint64_t count = 0, bytes = 0;
+  for(auto it = m_pDriver->m_CreationInfo.m_ShaderModule.begin();
+      it != m_pDriver->m_CreationInfo.m_ShaderModule.end(); ++it)
+  {
+    bytes += it->second.spirv.spirv.capacity() * sizeof(uint32_t);
+
+    for(auto refl = it->second.m_Reflections.begin(); refl != it->second.m_Reflections.end();
+        ++refl)
+    {
+      bytes += GetShaderReflectionSize(refl->second.refl);
+      count++;
+    }
+  }
+  ret.push_back(MakeMemoryUsage("Shader reflection", false, count, bytes));
+
+  GetDebugManager()->GetMemoryUsage(ret);
+
+  return ret;
+}
+
 vector<ResourceId> VulkanReplay::GetTextures()
 {
   vector<ResourceId> texs;
@@ -790,6 +832,26 @@ vector<ResourceId> VulkanReplay::GetBuffers()
   return bufs;
 }
 
+rdctype::str VulkanReplay::GetMemoryTypeName(ResourceId memory)
+{
+  auto it = m_pDriver->m_CreationInfo.m_Memory.find(memory);
+
+  // sparse resources and resources that were never bound have no memory
+  if(memory == ResourceId() || it == m_pDriver->m_CreationInfo.m_Memory.end())
+    return "";
+
+  uint32_t idx = it->second.memoryTypeIndex;
+  const VkPhysicalDeviceMemoryProperties &props = m_pDriver->m_PhysicalDeviceData.memProps;
+
+  if(idx >= props.memoryTypeCount)
+    return StringFormat::Fmt("Type %u", idx);
+
+  VkMemoryType type = props.memoryTypes[idx];
+
+  return StringFormat::Fmt("Type %u, Heap %u (%s)", idx, type.heapIndex,
+                           ToStr::Get((VkMemoryPropertyFlagBits)type.propertyFlags).c_str());
+}
+
 TextureDescription VulkanReplay::GetTexture(ResourceId id)
 {
   VulkanCreationInfo::Image &iminfo = m_pDriver->m_CreationInfo.m_Image[id];
@@ -803,12 +865,23 @@ TextureDescription VulkanReplay::GetTexture(ResourceId id)
   ret.height = iminfo.extent.height;
   ret.depth = iminfo.extent.depth;
   ret.mips = iminfo.mipLevels;
+  ret.placeholderInitialContents =
+      m_pDriver->GetResourceManager()->IsInitialContentsPlaceholder(ret.ID);
 
   ret.byteSize = 0;
   for(uint32_t s = 0; s < ret.mips; s++)
     ret.byteSize += GetByteSize(ret.width, ret.height, ret.depth, iminfo.format, s);
   ret.byteSize *= ret.arraysize;
 
+  VkMemoryRequirements mrq = {};
+  VkDevice dev = m_pDriver->GetDev();
+  VkImage im = m_pDriver->GetResourceManager()->GetCurrentHandle<VkImage>(id);
+  ObjDisp(dev)->GetImageMemoryRequirements(Unwrap(dev), Unwrap(im), &mrq);
+
+  ret.allocationSize = mrq.size;
+  ret.allocationAlignment = mrq.alignment;
+  ret.memoryType = GetMemoryTypeName(iminfo.memory);
+
   ret.msQual = 0;
   ret.msSamp = RDCMAX(1U, (uint32_t)iminfo.samples);
 
@@ -880,6 +953,15 @@ BufferDescription VulkanReplay::GetBuffer(ResourceId id)
   ret.ID = m_pDriver->GetResourceManager()->GetOriginalID(id);
   ret.length = bufinfo.size;
 
+  VkMemoryRequirements mrq = {};
+  VkDevice dev = m_pDriver->GetDev();
+  VkBuffer buf = m_pDriver->GetResourceManager()->GetCurrentHandle<VkBuffer>(id);
+  ObjDisp(dev)->GetBufferMemoryRequirements(Unwrap(dev), Unwrap(buf), &mrq);
+
+  ret.allocationSize = mrq.size;
+  ret.allocationAlignment = mrq.alignment;
+  ret.memoryType = GetMemoryTypeName(bufinfo.memory);
+
   ret.creationFlags = BufferCategory::NoFlags;
 
   if(bufinfo.usage & (VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT))
@@ -1674,9 +1756,17 @@ void VulkanReplay::RenderHighlightBox(float w, float h, float scale)
 ResourceId VulkanReplay::RenderOverlay(ResourceId texid, CompType typeHint, DebugOverlay overlay,
                                        uint32_t eventID, const vector<uint32_t> &passEvents)
 {
+  SCOPED_PROFILE("VulkanReplay::RenderOverlay", eventID);
   return GetDebugManager()->RenderOverlay(texid, overlay, eventID, passEvents);
 }
 
+vector<TextureSamplingFeedback> VulkanReplay::FetchTextureSampling(uint32_t startEventID,
+                                                                   uint32_t endEventID)
+{
+  SCOPED_PROFILE("VulkanReplay::FetchTextureSampling", startEventID);
+  return GetDebugManager()->FetchTextureSampling(startEventID, endEventID);
+}
+
 void VulkanReplay::RenderMesh(uint32_t eventID, const vector<MeshFormat> &secondaryDraws,
                               const MeshDisplay &cfg)
 {
@@ -1694,6 +1784,9 @@ void VulkanReplay::RenderMesh(uint32_t eventID, const vector<MeshFormat> &second
   if(outw.swap == VK_NULL_HANDLE)
     return;
 
+  // evict old mesh pipelines before we fetch any for this render
+  GetDebugManager()->TrimMeshDisplayPipelines();
+
   VkDevice dev = m_pDriver->GetDev();
   VkCommandBuffer cmd = m_pDriver->GetNextCmd();
   const VkLayerDispatchTable *vt = ObjDisp(dev);
@@ -2451,7 +2544,6 @@ void VulkanReplay::BindOutputWindow(uint64_t id, bool depth)
   // semaphore is short lived, so not wrapped, if it's cached (ideally)
   // then it should be wrapped
   VkSemaphore sem;
-  VkPipelineStageFlags stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
   VkSemaphoreCreateInfo semInfo = {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO, NULL, 0};
 
   VkResult vkr = vt->CreateSemaphore(Unwrap(dev), &semInfo, NULL, &sem);
@@ -2461,24 +2553,10 @@ void VulkanReplay::BindOutputWindow(uint64_t id, bool depth)
                                 &outw.curidx);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-  VkSubmitInfo submitInfo = {
-      VK_STRUCTURE_TYPE_SUBMIT_INFO,
-      NULL,
-      1,
-      &sem,
-      &stage,
-      0,
-      NULL,    // cmd buffers
-      0,
-      NULL,    // signal semaphores
-  };
-
-  vkr = vt->QueueSubmit(Unwrap(m_pDriver->GetQ()), 1, &submitInfo, VK_NULL_HANDLE);
-  RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-  vt->QueueWaitIdle(Unwrap(m_pDriver->GetQ()));
-
-  vt->DestroySemaphore(Unwrap(dev), sem, NULL);
+  // rather than idling the queue until the image is acquired, the next submission waits for it
+  // on the GPU. Nothing touches the image until then, and the semaphore is destroyed once that
+  // submission has completed
+  m_pDriver->WaitSemaphoreOnNextSubmit(sem);
 
   VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
                                         VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
@@ -3716,6 +3794,8 @@ bool VulkanReplay::GetMinMax(ResourceId texid, uint32_t sliceFace, uint32_t mip,
 
   descSetBinding += textype;
 
+  GetDebugManager()->CreateHistogramPipelines((uint32_t)textype, intTypeIndex);
+
   if(GetDebugManager()->m_MinMaxTilePipe[textype][intTypeIndex] == VK_NULL_HANDLE)
   {
     *minval = 0.0f;
@@ -3965,6 +4045,8 @@ bool VulkanReplay::GetHistogram(ResourceId texid, uint32_t sliceFace, uint32_t m
 
   descSetBinding += textype;
 
+  GetDebugManager()->CreateHistogramPipelines((uint32_t)textype, intTypeIndex);
+
   if(GetDebugManager()->m_HistogramPipe[textype][intTypeIndex] == VK_NULL_HANDLE)
   {
     histogram.resize(HGRAM_NUM_BUCKETS);
@@ -4153,6 +4235,9 @@ bool VulkanReplay::GetHistogram(ResourceId texid, uint32_t sliceFace, uint32_t m
 
 void VulkanReplay::InitPostVSBuffers(uint32_t eventID)
 {
+  SCOPED_PROFILE("VulkanReplay::InitPostVSBuffers", eventID);
+  // trim before the pass is fetched, so none of its events are evicted
+  GetDebugManager()->TrimPostVSCache(eventID);
   GetDebugManager()->InitPostVSBuffers(eventID);
 }
 
@@ -4166,6 +4251,10 @@ struct VulkanInitPostVSCallback : public VulkanDrawcallCallback
   ~VulkanInitPostVSCallback() { m_pDriver->SetDrawcallCB(NULL); }
   void PreDraw(uint32_t eid, VkCommandBuffer cmd)
   {
+    // once cancelled, the rest of the pass replays without caching anything more
+    if(RenderDoc::Inst().IsReplayCancelled())
+      return;
+
     if(std::find(m_Events.begin(), m_Events.end(), eid) != m_Events.end())
       m_pDriver->GetDebugManager()->InitPostVSBuffers(eid);
   }
@@ -4200,10 +4289,16 @@ void VulkanReplay::InitPostVSBuffers(const vector<uint32_t> &events)
 
   VulkanInitPostVSCallback cb(m_pDriver, events);
 
+  // each event is only prepared as it's reached, then the whole pass is drawn and read back at
+  // once when the batch ends, instead of stalling on every event.
+  GetDebugManager()->BeginPostVSBatch();
+
   // now we replay the events, which are guaranteed (because we generated them in
   // GetPassEvents above) to come from the same command buffer, so the event IDs are
   // still locally continuous, even if we jump into replaying.
   m_pDriver->ReplayLog(events.front(), events.back(), eReplay_Full);
+
+  GetDebugManager()->EndPostVSBatch();
 }
 
 vector<EventUsage> VulkanReplay::GetUsage(ResourceId id)
@@ -4219,6 +4314,7 @@ MeshFormat VulkanReplay::GetPostVSBuffers(uint32_t eventID, uint32_t instID, Mes
 byte *VulkanReplay::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
                                    const GetTextureDataParams &params, size_t &dataSize)
 {
+  SCOPED_PROFILE("VulkanReplay::GetTextureData");
   bool wasms = false;
 
   if(m_pDriver->m_CreationInfo.m_Image.find(tex) == m_pDriver->m_CreationInfo.m_Image.end())
@@ -4769,10 +4865,31 @@ byte *VulkanReplay::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t m
     copyregion[i].imageExtent.depth = RDCMAX(1U, copyregion[i].imageExtent.depth >> mip);
   }
 
-  // for most combined depth-stencil images this will be large enough for both to be copied
-  // separately, but for D24S8 we need to add extra space since they won't be copied packed
-  dataSize = GetByteSize(imInfo.extent.width, imInfo.extent.height, imInfo.extent.depth,
-                         imCreateInfo.format, mip);
+  // if only a region was requested, only copy that region out. Combined depth-stencil and block
+  // formats always read back the whole subresource
+  bool readRegion = params.regionWidth > 0 && params.regionHeight > 0 && !(isDepth && isStencil) &&
+                    !IsBlockFormat(imCreateInfo.format) &&
+                    params.regionX < copyregion[0].imageExtent.width &&
+                    params.regionY < copyregion[0].imageExtent.height;
+
+  if(readRegion)
+  {
+    VkExtent3D &extent = copyregion[0].imageExtent;
+
+    copyregion[0].imageOffset.x = (int32_t)params.regionX;
+    copyregion[0].imageOffset.y = (int32_t)params.regionY;
+    extent.width = RDCMIN(params.regionWidth, extent.width - params.regionX);
+    extent.height = RDCMIN(params.regionHeight, extent.height - params.regionY);
+
+    dataSize = GetByteSize(extent.width, extent.height, extent.depth, imCreateInfo.format, 0);
+  }
+  else
+  {
+    // for most combined depth-stencil images this will be large enough for both to be copied
+    // separately, but for D24S8 we need to add extra space since they won't be copied packed
+    dataSize = GetByteSize(imInfo.extent.width, imInfo.extent.height, imInfo.extent.depth,
+                           imCreateInfo.format, mip);
+  }
 
   if(imCreateInfo.format == VK_FORMAT_D24_UNORM_S8_UINT)
   {
@@ -4781,33 +4898,40 @@ byte *VulkanReplay::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t m
                             VK_FORMAT_S8_UINT, mip);
   }
 
-  VkBufferCreateInfo bufInfo = {
-      VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-      NULL,
-      0,
-      dataSize,
-      VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-  };
-
   VkBuffer readbackBuf = VK_NULL_HANDLE;
-  vkr = vt->CreateBuffer(Unwrap(dev), &bufInfo, NULL, &readbackBuf);
-  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  VkDeviceMemory readbackMem = VK_NULL_HANDLE;
 
-  VkMemoryRequirements mrq = {0};
+  // most reads fit in the debug manager's persistently mapped window, only allocate for big ones
+  byte *pData = GetDebugManager()->GetReadbackWindow(dataSize, readbackBuf);
 
-  vt->GetBufferMemoryRequirements(Unwrap(dev), readbackBuf, &mrq);
+  if(pData == NULL)
+  {
+    VkBufferCreateInfo bufInfo = {
+        VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        NULL,
+        0,
+        dataSize,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+    };
 
-  VkMemoryAllocateInfo allocInfo = {
-      VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL, dataSize,
-      m_pDriver->GetReadbackMemoryIndex(mrq.memoryTypeBits),
-  };
+    vkr = vt->CreateBuffer(Unwrap(dev), &bufInfo, NULL, &readbackBuf);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-  VkDeviceMemory readbackMem = VK_NULL_HANDLE;
-  vkr = vt->AllocateMemory(Unwrap(dev), &allocInfo, NULL, &readbackMem);
-  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    VkMemoryRequirements mrq = {0};
 
-  vkr = vt->BindBufferMemory(Unwrap(dev), readbackBuf, readbackMem, 0);
-  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    vt->GetBufferMemoryRequirements(Unwrap(dev), readbackBuf, &mrq);
+
+    VkMemoryAllocateInfo allocInfo = {
+        VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL, dataSize,
+        m_pDriver->GetReadbackMemoryIndex(mrq.memoryTypeBits),
+    };
+
+    vkr = vt->AllocateMemory(Unwrap(dev), &allocInfo, NULL, &readbackMem);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+    vkr = vt->BindBufferMemory(Unwrap(dev), readbackBuf, readbackMem, 0);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  }
 
   if(isDepth && isStencil)
   {
@@ -4861,12 +4985,14 @@ byte *VulkanReplay::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t m
   vt->EndCommandBuffer(Unwrap(cmd));
 
   m_pDriver->SubmitCmds();
-  m_pDriver->FlushQ();
+  m_pDriver->WaitForSubmittedCmds();
 
   // map the buffer and copy to return buffer
-  byte *pData = NULL;
-  vkr = vt->MapMemory(Unwrap(dev), readbackMem, 0, VK_WHOLE_SIZE, 0, (void **)&pData);
-  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  if(readbackMem != VK_NULL_HANDLE)
+  {
+    vkr = vt->MapMemory(Unwrap(dev), readbackMem, 0, VK_WHOLE_SIZE, 0, (void **)&pData);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  }
 
   RDCASSERT(pData != NULL);
 
@@ -4947,11 +5073,13 @@ byte *VulkanReplay::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t m
     memcpy(ret, pData, dataSize);
   }
 
-  vt->UnmapMemory(Unwrap(dev), readbackMem);
-
   // clean up temporary objects
-  vt->DestroyBuffer(Unwrap(dev), readbackBuf, NULL);
-  vt->FreeMemory(Unwrap(dev), readbackMem, NULL);
+  if(readbackMem != VK_NULL_HANDLE)
+  {
+    vt->UnmapMemory(Unwrap(dev), readbackMem);
+    vt->DestroyBuffer(Unwrap(dev), readbackBuf, NULL);
+    vt->FreeMemory(Unwrap(dev), readbackMem, NULL);
+  }
 
   if(tmpImage != VK_NULL_HANDLE)
   {
@@ -4974,6 +5102,13 @@ byte *VulkanReplay::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t m
   return ret;
 }
 
+vector<TextureThumbnail> VulkanReplay::GetTextureThumbnails(
+    const vector<TextureThumbnailRequest> &textures, uint32_t size)
+{
+  SCOPED_PROFILE("VulkanReplay::GetTextureThumbnails");
+  return FetchTextureThumbnails(this, textures, size);
+}
+
 void VulkanReplay::BuildCustomShader(string source, string entry, const uint32_t compileFlags,
                                      ShaderStage type, ResourceId *id, string *errors)
 {
@@ -4993,13 +5128,11 @@ void VulkanReplay::BuildCustomShader(string source, string entry, const uint32_t
       return;
   }
 
-  vector<string> sources;
-  sources.push_back(source);
-  vector<uint32_t> spirv;
+  vector<uint32_t> *spirv = NULL;
 
-  string output = CompileSPIRV(stage, sources, spirv);
+  string output = GetDebugManager()->GetUserSPIRVBlob(stage, source, &spirv);
 
-  if(spirv.empty())
+  if(spirv == NULL || spirv->empty())
   {
     *id = ResourceId();
     *errors = output;
@@ -5010,8 +5143,8 @@ void VulkanReplay::BuildCustomShader(string source, string entry, const uint32_t
       VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
       NULL,
       0,
-      spirv.size() * sizeof(uint32_t),
-      &spirv[0],
+      spirv->size() * sizeof(uint32_t),
+      &(*spirv)[0],
   };
 
   VkShaderModule module;
@@ -5105,13 +5238,11 @@ void VulkanReplay::BuildTargetShader(string source, string entry, const uint32_t
       return;
   }
 
-  vector<string> sources;
-  sources.push_back(source);
-  vector<uint32_t> spirv;
+  vector<uint32_t> *spirv = NULL;
 
-  string output = CompileSPIRV(stage, sources, spirv);
+  string output = GetDebugManager()->GetUserSPIRVBlob(stage, source, &spirv);
 
-  if(spirv.empty())
+  if(spirv == NULL || spirv->empty())
   {
     *id = ResourceId();
     *errors = output;
@@ -5122,8 +5253,8 @@ void VulkanReplay::BuildTargetShader(string source, string entry, const uint32_t
       VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
       NULL,
       0,
-      spirv.size() * sizeof(uint32_t),
-      &spirv[0],
+      spirv->size() * sizeof(uint32_t),
+      &(*spirv)[0],
   };
 
   VkShaderModule module;
@@ -5135,12 +5266,17 @@ void VulkanReplay::BuildTargetShader(string source, string entry, const uint32_t
 
 void VulkanReplay::ReplaceResource(ResourceId from, ResourceId to)
 {
-  GetDebugManager()->ReplaceResource(from, to);
+  // only cached partial command buffers that bind one of the remade pipelines are stale
+  vector<ResourceId> pipelines;
+  GetDebugManager()->ReplaceResource(from, to, pipelines);
+  m_pDriver->FreePartialCmdCache(pipelines);
 }
 
 void VulkanReplay::RemoveReplacement(ResourceId id)
 {
-  GetDebugManager()->RemoveReplacement(id);
+  vector<ResourceId> pipelines;
+  GetDebugManager()->RemoveReplacement(id, pipelines);
+  m_pDriver->FreePartialCmdCache(pipelines);
 }
 
 void VulkanReplay::FreeTargetResource(ResourceId id)
@@ -5160,25 +5296,12 @@ vector<PixelModification> VulkanReplay::PixelHistory(vector<EventUsage> events,
   return vector<PixelModification>();
 }
 
-ShaderDebugTrace VulkanReplay::DebugVertex(uint32_t eventID, uint32_t vertid, uint32_t instid,
-                                           uint32_t idx, uint32_t instOffset, uint32_t vertOffset)
-{
-  VULKANNOTIMP("DebugVertex");
-  return ShaderDebugTrace();
-}
-
-ShaderDebugTrace VulkanReplay::DebugPixel(uint32_t eventID, uint32_t x, uint32_t y, uint32_t sample,
-                                          uint32_t primitive)
-{
-  VULKANNOTIMP("DebugPixel");
-  return ShaderDebugTrace();
-}
-
-ShaderDebugTrace VulkanReplay::DebugThread(uint32_t eventID, const uint32_t groupid[3],
-                                           const uint32_t threadid[3])
+vector<vector<PixelModification> > VulkanReplay::PixelHistoryRegion(
+    vector<EventUsage> events, ResourceId target, uint32_t x, uint32_t y, uint32_t width,
+    uint32_t height, uint32_t slice, uint32_t mip, uint32_t sampleIdx, CompType typeHint)
 {
-  VULKANNOTIMP("DebugThread");
-  return ShaderDebugTrace();
+  VULKANNOTIMP("PixelHistoryRegion");
+  return vector<vector<PixelModification> >(width * height);
 }
 
 ResourceId VulkanReplay::CreateProxyTexture(const TextureDescription &templateTex)
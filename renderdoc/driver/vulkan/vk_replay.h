@@ -26,6 +26,7 @@
 
 #include "api/replay/renderdoc_replay.h"
 #include "core/core.h"
+#include "replay/counter_provider.h"
 #include "replay/replay_driver.h"
 #include "vk_common.h"
 #include "vk_info.h"
@@ -148,6 +149,7 @@ public:
 
   FrameRecord GetFrameRecord();
   vector<DebugMessage> GetDebugMessages();
+  vector<MemoryUsage> GetMemoryUsage();
 
   void SavePipelineState();
   D3D11Pipe::State GetD3D11PipelineState() { return D3D11Pipe::State(); }
@@ -158,6 +160,8 @@ public:
 
   void ReadLogInitialisation();
   void ReplayLog(uint32_t endEventID, ReplayLogType replayType);
+  bool AdvanceReplay(uint32_t fromEventID, uint32_t toEventID);
+  void SetPrunedEvents(const vector<uint32_t> &eventIDs) {}
 
   vector<uint32_t> GetPassEvents(uint32_t eventID);
 
@@ -182,6 +186,8 @@ public:
   void DescribeCounter(GPUCounter counterID, CounterDescription &desc);
   vector<CounterResult> FetchCounters(const vector<GPUCounter> &counters);
 
+  vector<TextureSamplingFeedback> FetchTextureSampling(uint32_t startEventID, uint32_t endEventID);
+
   bool GetMinMax(ResourceId texid, uint32_t sliceFace, uint32_t mip, uint32_t sample,
                  CompType typeHint, float *minval, float *maxval);
   bool GetHistogram(ResourceId texid, uint32_t sliceFace, uint32_t mip, uint32_t sample,
@@ -193,6 +199,8 @@ public:
   void GetBufferData(ResourceId buff, uint64_t offset, uint64_t len, vector<byte> &retData);
   byte *GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
                        const GetTextureDataParams &params, size_t &dataSize);
+  vector<TextureThumbnail> GetTextureThumbnails(const vector<TextureThumbnailRequest> &textures,
+                                                uint32_t size);
 
   void ReplaceResource(ResourceId from, ResourceId to);
   void RemoveReplacement(ResourceId id);
@@ -217,10 +225,18 @@ public:
   vector<PixelModification> PixelHistory(vector<EventUsage> events, ResourceId target, uint32_t x,
                                          uint32_t y, uint32_t slice, uint32_t mip,
                                          uint32_t sampleIdx, CompType typeHint);
+  vector<vector<PixelModification> > PixelHistoryRegion(vector<EventUsage> events,
+                                                        ResourceId target, uint32_t x, uint32_t y,
+                                                        uint32_t width, uint32_t height,
+                                                        uint32_t slice, uint32_t mip,
+                                                        uint32_t sampleIdx, CompType typeHint);
   ShaderDebugTrace DebugVertex(uint32_t eventID, uint32_t vertid, uint32_t instid, uint32_t idx,
                                uint32_t instOffset, uint32_t vertOffset);
   ShaderDebugTrace DebugPixel(uint32_t eventID, uint32_t x, uint32_t y, uint32_t sample,
                               uint32_t primitive);
+  vector<ShaderDebugTrace> DebugVertices(uint32_t eventID, vector<ShaderDebugVertexInput> inputs,
+                                         uint32_t instOffset, uint32_t vertOffset);
+  vector<ShaderDebugTrace> DebugPixels(uint32_t eventID, vector<ShaderDebugPixelInput> inputs);
   ShaderDebugTrace DebugThread(uint32_t eventID, const uint32_t groupid[3],
                                const uint32_t threadid[3]);
   void PickPixel(ResourceId texture, uint32_t x, uint32_t y, uint32_t sliceFace, uint32_t mip,
@@ -326,6 +342,10 @@ private:
 
   HighlightCache m_HighlightCache;
 
+  // vendor hardware counters, see vk_counters.cpp
+  CounterProviders m_CounterProviders;
+  vector<CounterResult> FetchProviderCounters(const vector<GPUCounter> &counters);
+
   bool m_Proxy;
 
   WrappedVulkan *m_pDriver;
@@ -345,6 +365,8 @@ private:
   void FillCBufferVariables(rdctype::array<ShaderConstant>, vector<ShaderVariable> &outvars,
                             const vector<byte> &data, size_t baseOffset);
 
+  rdctype::str GetMemoryTypeName(ResourceId memory);
+
   VulkanDebugManager *GetDebugManager();
   VulkanResourceManager *GetResourceManager();
 };
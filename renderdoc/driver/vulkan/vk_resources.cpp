@@ -53,6 +53,7 @@ WRAPPED_POOL_INST(WrappedVkCommandPool)
 
 WRAPPED_POOL_INST(WrappedVkSwapchainKHR)
 WRAPPED_POOL_INST(WrappedVkSurfaceKHR)
+WRAPPED_POOL_INST(WrappedVkDescriptorUpdateTemplateKHR)
 
 byte VkResourceRecord::markerValue[32] = {
     0xaa, 0xbb, 0xcc, 0xdd, 0x88, 0x77, 0x66, 0x55, 0x01, 0x23, 0x45, 0x67, 0x98, 0x76, 0x54, 0x32,
@@ -121,6 +122,8 @@ VkResourceType IdentifyTypeByPtr(WrappedVkRes *ptr)
     return eResSwapchain;
   if(WrappedVkSurfaceKHR::IsAlloc(ptr))
     return eResSurface;
+  if(WrappedVkDescriptorUpdateTemplateKHR::IsAlloc(ptr))
+    return eResDescUpdateTemplate;
 
   RDCERR("Unknown type for ptr 0x%p", ptr);
 
@@ -765,6 +768,9 @@ VkResourceRecord::~VkResourceRecord()
 
   if(resType == eResDescriptorSetLayout || resType == eResDescriptorSet)
     SAFE_DELETE(descInfo);
+
+  if(resType == eResDescUpdateTemplate)
+    SAFE_DELETE(descTemplateInfo);
 }
 
 void SparseMapping::Update(uint32_t numBindings, const VkSparseImageMemoryBind *pBindings)
@@ -69,7 +69,8 @@ enum VkResourceType
   eResSemaphore,
 
   eResSwapchain,
-  eResSurface
+  eResSurface,
+  eResDescUpdateTemplate,
 };
 
 // VkDisplayKHR and VkDisplayModeKHR are both UNWRAPPED because there's no need to wrap them.
@@ -546,6 +547,19 @@ struct WrappedVkSurfaceKHR : WrappedVkNonDispRes
     TypeEnum = eResSurface,
   };
 };
+struct WrappedVkDescriptorUpdateTemplateKHR : WrappedVkNonDispRes
+{
+  WrappedVkDescriptorUpdateTemplateKHR(VkDescriptorUpdateTemplateKHR obj, ResourceId objId)
+      : WrappedVkNonDispRes(obj, objId)
+  {
+  }
+  typedef VkDescriptorUpdateTemplateKHR InnerType;
+  ALLOCATE_WITH_WRAPPED_POOL(WrappedVkDescriptorUpdateTemplateKHR);
+  enum
+  {
+    TypeEnum = eResDescUpdateTemplate,
+  };
+};
 
 // VkDisplayKHR and VkDisplayModeKHR are both UNWRAPPED because there's no need to wrap them.
 // The only thing we need to wrap VkSurfaceKHR for is to get back the window from it later.
@@ -643,6 +657,7 @@ UNWRAP_NONDISP_HELPER(VkFramebuffer)
 UNWRAP_NONDISP_HELPER(VkCommandPool)
 UNWRAP_NONDISP_HELPER(VkSwapchainKHR)
 UNWRAP_NONDISP_HELPER(VkSurfaceKHR)
+UNWRAP_NONDISP_HELPER(VkDescriptorUpdateTemplateKHR)
 
 // VkDisplayKHR and VkDisplayModeKHR are both UNWRAPPED because there's no need to wrap them.
 // The only thing we need to wrap VkSurfaceKHR for is to get back the window from it later.
@@ -902,9 +917,15 @@ struct CmdBufferRecordingInfo
   set<VkDescriptorSet> boundDescSets;
 
   vector<VkResourceRecord *> subcmds;
+
+  // set when the command buffer was begun while idle tracking was suspended (see
+  // CaptureOptions::ReduceIdleOverhead). No chunks or frame references are recorded, only the
+  // state needed to stay correct on submission: image layouts, dirtied and sparse resources.
+  bool untracked;
 };
 
 struct DescSetLayout;
+struct DescUpdateTemplate;
 
 struct DescriptorSetData
 {
@@ -928,7 +949,7 @@ struct DescriptorSetData
   // the refcount has the high-bit set if this resource has sparse
   // mapping information
   static const uint32_t SPARSE_REF_BIT = 0x80000000;
-  map<ResourceId, pair<uint32_t, FrameRefType> > bindFrameRefs;
+  ResourceIdMap<pair<uint32_t, FrameRefType> > bindFrameRefs;
 };
 
 struct MemMapState
@@ -940,7 +961,10 @@ struct MemMapState
         mapFlushed(false),
         mapCoherent(false),
         mappedPtr(NULL),
-        refData(NULL)
+        refData(NULL),
+        writeWatch(NULL),
+        writeWatchSynced(false),
+        uploadRecorded(false)
   {
   }
   VkDeviceSize mapOffset, mapSize;
@@ -949,6 +973,26 @@ struct MemMapState
   bool mapCoherent;
   byte *mappedPtr;
   byte *refData;
+
+  // with TrackCoherentMapWrites, tracks the pages of a coherent map written by the application.
+  // Once synced, everything outside the dirty pages is known to already be in the capture.
+  WriteWatch::Region writeWatch;
+  bool writeWatchSynced;
+
+  // set once the first host upload into the memory has been kept as a chunk in its record, see
+  // vkUnmapMemory. Any later write makes the memory dirty as normal.
+  bool uploadRecorded;
+};
+
+// a buffer, buffer view or image range bound into a memory object, tracked during capture so that
+// memory initial contents can skip ranges that nothing is bound to or refers to in the frame.
+struct MemoryBinding
+{
+  ResourceId resource;
+  VkDeviceSize offset;
+  VkDeviceSize size;
+
+  bool operator<(const MemoryBinding &o) const { return offset < o.offset; }
 };
 
 struct AttachmentInfo
@@ -1075,6 +1119,7 @@ public:
     CmdBufferRecordingInfo *cmdInfo;               // only for command buffers
     AttachmentInfo *imageAttachments;              // only for framebuffers and render passes
     DescriptorSetData *descInfo;    // only for descriptor sets and descriptor set layouts
+    DescUpdateTemplate *descTemplateInfo;    // only for descriptor update templates
   };
 
   VkResourceRecord *bakedCommands;
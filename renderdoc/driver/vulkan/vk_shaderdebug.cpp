@@ -0,0 +1,1262 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2017 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include <float.h>
+#include "driver/shaders/spirv/spirv_debug.h"
+#include "maths/formatpacking.h"
+#include "vk_core.h"
+#include "vk_replay.h"
+
+// there's no way to ask whether to keep going from the replay side, so anything running this long
+// is assumed to be stuck in an infinite loop and the trace so far is returned
+#define SHADER_DEBUG_MAX_STEPS 1000000
+
+// the most threads simulated together when a compute shader shares memory across its workgroup
+#define SHADER_DEBUG_MAX_GROUP_THREADS 1024
+
+// reads whatever the current pipeline has bound, for the simulation
+class VulkanDebugAPIWrapper : public SPVDebug::DebugAPIWrapper
+{
+public:
+  VulkanDebugAPIWrapper(VulkanReplay *replay, VulkanCreationInfo &creationInfo,
+                        const VKPipe::Pipeline &pipe, const byte *pushData, size_t pushSize)
+      : m_pReplay(replay), m_CreationInfo(creationInfo), m_Pipe(pipe)
+  {
+    m_PushData.assign(pushData, pushData + pushSize);
+  }
+
+  bool FetchBuffer(const SPVDebug::BindingSlot &slot, vector<byte> &data)
+  {
+    if(slot.set == ~0U)
+    {
+      data = m_PushData;
+      return true;
+    }
+
+    const VKPipe::BindingElement *bind = GetBind(slot);
+    if(bind == NULL || bind->res == ResourceId())
+      return false;
+
+    m_pReplay->GetBufferData(m_pReplay->GetLiveID(bind->res), bind->offset,
+                             bind->size == VK_WHOLE_SIZE ? 0 : bind->size, data);
+    return true;
+  }
+
+  bool GetImageInfo(const SPVDebug::BindingSlot &slot, SPVDebug::ImageInfo &info)
+  {
+    const VKPipe::BindingElement *bind = GetBind(slot);
+    if(bind == NULL || bind->res == ResourceId())
+      return false;
+
+    ResourceId live = m_pReplay->GetLiveID(bind->res);
+
+    if(IsTexelBuffer(slot))
+    {
+      uint32_t elemSize = ElementSize(bind->viewfmt);
+      uint64_t size = bind->size;
+      if(size == VK_WHOLE_SIZE)
+        size = m_CreationInfo.m_Buffer[live].size - bind->offset;
+      info.width = elemSize ? uint32_t(size / elemSize) : 0;
+      return true;
+    }
+
+    if(m_CreationInfo.m_Image.find(live) == m_CreationInfo.m_Image.end())
+      return false;
+
+    const VulkanCreationInfo::Image &im = m_CreationInfo.m_Image[live];
+
+    info.width = RDCMAX(1U, im.extent.width >> bind->baseMip);
+    info.height = RDCMAX(1U, im.extent.height >> bind->baseMip);
+    info.depth = RDCMAX(1U, im.extent.depth >> bind->baseMip);
+    info.mips = RDCMAX(1U, bind->numMip);
+    info.layers = RDCMAX(1U, bind->numLayer);
+    info.samples = (uint32_t)im.samples;
+    return true;
+  }
+
+  bool GetSamplerInfo(const SPVDebug::BindingSlot &slot, SPVDebug::SamplerInfo &info)
+  {
+    const VKPipe::BindingElement *bind = GetBind(slot);
+    if(bind == NULL || bind->sampler == ResourceId())
+      return false;
+
+    info.address[0] = bind->AddressU;
+    info.address[1] = bind->AddressV;
+    info.address[2] = bind->AddressW;
+    info.unnormalized = bind->unnormalized != 0;
+    info.mipBias = bind->mipBias;
+    info.minLod = bind->minlod;
+    info.maxLod = bind->maxlod;
+    info.compare = bind->comparison;
+    memcpy(info.border, bind->BorderColor, sizeof(info.border));
+    return true;
+  }
+
+  bool ReadTexel(const SPVDebug::BindingSlot &slot, uint32_t x, uint32_t y, uint32_t z,
+                 uint32_t mip, uint32_t sample, ShaderValue &texel)
+  {
+    TexelKey key = {slot, {x, y, z, mip, sample}};
+
+    // reading back a texel is a full round trip to the GPU, so never read the same one twice
+    std::map<TexelKey, ShaderValue>::iterator it = m_Texels.find(key);
+    if(it != m_Texels.end())
+    {
+      texel = it->second;
+      return true;
+    }
+
+    const VKPipe::BindingElement *bind = GetBind(slot);
+    if(bind == NULL || bind->res == ResourceId())
+      return false;
+
+    RDCEraseEl(texel);
+
+    if(IsTexelBuffer(slot))
+    {
+      const ResourceFormat &fmt = bind->viewfmt;
+      uint32_t elemSize = ElementSize(fmt);
+
+      vector<byte> data;
+      m_pReplay->GetBufferData(m_pReplay->GetLiveID(bind->res), bind->offset + x * elemSize,
+                               elemSize, data);
+
+      if(data.size() < elemSize || fmt.special)
+        return false;
+
+      if(fmt.compType == CompType::UInt || fmt.compType == CompType::SInt)
+      {
+        // integers are returned as their bits, sign extended to 32-bit
+        for(uint32_t c = 0; c < fmt.compCount; c++)
+        {
+          const byte *comp = &data[c * fmt.compByteWidth];
+          if(fmt.compByteWidth == 1)
+            texel.uv[c] = fmt.compType == CompType::SInt ? uint32_t(int32_t(int8_t(comp[0])))
+                                                         : comp[0];
+          else if(fmt.compByteWidth == 2)
+            texel.uv[c] = fmt.compType == CompType::SInt
+                              ? uint32_t(int32_t(*(const int16_t *)comp))
+                              : *(const uint16_t *)comp;
+          else
+            texel.uv[c] = *(const uint32_t *)comp;
+        }
+      }
+      else
+      {
+        ConvertComponents(fmt, data.data(), fmt.compCount, texel.fv);
+      }
+
+      // missing components read as 0, 0, 0, 1
+      if(fmt.compCount < 4)
+      {
+        if(fmt.compType == CompType::UInt || fmt.compType == CompType::SInt)
+          texel.uv[3] = 1;
+        else
+          texel.fv[3] = 1.0f;
+      }
+    }
+    else
+    {
+      ResourceId live = m_pReplay->GetLiveID(bind->res);
+      const VulkanCreationInfo::Image &im = m_CreationInfo.m_Image[live];
+
+      // 3D textures are picked by slice, everything else by layer within the view
+      uint32_t slice = im.type == VK_IMAGE_TYPE_3D ? z : bind->baseLayer + z;
+
+      CompType typeHint = bind->viewfmt.compType;
+      m_pReplay->PickPixel(live, x, y, slice, bind->baseMip + mip, sample, typeHint, texel.fv);
+    }
+
+    m_Texels[key] = texel;
+    return true;
+  }
+
+private:
+  struct TexelKey
+  {
+    SPVDebug::BindingSlot slot;
+    uint32_t coord[5];
+    bool operator<(const TexelKey &o) const
+    {
+      if(slot < o.slot)
+        return true;
+      if(o.slot < slot)
+        return false;
+      return memcmp(coord, o.coord, sizeof(coord)) < 0;
+    }
+  };
+
+  const VKPipe::DescriptorBinding *GetBinding(const SPVDebug::BindingSlot &slot) const
+  {
+    if(slot.set >= (uint32_t)m_Pipe.DescSets.count)
+      return NULL;
+
+    const VKPipe::DescriptorSet &set = m_Pipe.DescSets[slot.set];
+    if(slot.bind >= (uint32_t)set.bindings.count)
+      return NULL;
+
+    return &set.bindings[slot.bind];
+  }
+
+  const VKPipe::BindingElement *GetBind(const SPVDebug::BindingSlot &slot) const
+  {
+    const VKPipe::DescriptorBinding *binding = GetBinding(slot);
+    if(binding == NULL || slot.arrayIdx >= (uint32_t)binding->binds.count)
+      return NULL;
+
+    return &binding->binds[slot.arrayIdx];
+  }
+
+  bool IsTexelBuffer(const SPVDebug::BindingSlot &slot) const
+  {
+    const VKPipe::DescriptorBinding *binding = GetBinding(slot);
+    return binding && (binding->type == BindType::ReadOnlyTBuffer ||
+                       binding->type == BindType::ReadWriteTBuffer);
+  }
+
+  static uint32_t ElementSize(const ResourceFormat &fmt)
+  {
+    if(fmt.special)
+      return fmt.specialFormat == SpecialFormat::R10G10B10A2 ||
+                     fmt.specialFormat == SpecialFormat::R11G11B10
+                 ? 4
+                 : 0;
+    return fmt.compByteWidth * fmt.compCount;
+  }
+
+  VulkanReplay *m_pReplay;
+  VulkanCreationInfo &m_CreationInfo;
+  const VKPipe::Pipeline &m_Pipe;
+  vector<byte> m_PushData;
+  std::map<TexelKey, ShaderValue> m_Texels;
+};
+
+// decodes the given shader stage of a pipeline with its specialization constants applied
+static bool DecodeShader(VulkanCreationInfo &creationInfo,
+                         const VulkanCreationInfo::Pipeline::Shader &shader, ShaderStage stage,
+                         SPVDebug::DecodedProgram &program)
+{
+  if(shader.module == ResourceId() || shader.refl == NULL)
+    return false;
+
+  std::map<uint32_t, uint64_t> specConstants;
+  for(size_t i = 0; i < shader.specialization.size(); i++)
+  {
+    uint64_t val = 0;
+    memcpy(&val, shader.specialization[i].data,
+           RDCMIN(sizeof(val), shader.specialization[i].size));
+    specConstants[shader.specialization[i].specID] = val;
+  }
+
+  return program.Decode(creationInfo.m_ShaderModule[shader.module].spirv, shader.entryPoint, stage,
+                        specConstants);
+}
+
+// fills in the trace's constant blocks in the same order as the reflection's bindpoint mapping
+static void FillConstantBlocks(SPVDebug::GlobalState &global, const ShaderBindpointMapping &mapping,
+                               ShaderDebugTrace &trace)
+{
+  const SPVDebug::DecodedProgram &program = global.program;
+
+  create_array_uninit(trace.cbuffers, mapping.ConstantBlocks.count);
+
+  for(int32_t i = 0; i < mapping.ConstantBlocks.count; i++)
+  {
+    const BindpointMap &bind = mapping.ConstantBlocks[i];
+
+    for(size_t g = 0; g < program.globals.size(); g++)
+    {
+      const SPVDebug::DecodedProgram::Variable &v = program.globals[g];
+
+      bool pushConst = v.storage == spv::StorageClassPushConstant;
+
+      if(v.storage != spv::StorageClassUniform && !pushConst)
+        continue;
+
+      // push constants are reflected with a special set
+      if(pushConst != (bind.bindset == 10000))
+        continue;
+      if(!pushConst && (v.set != (uint32_t)bind.bindset || v.binding != (uint32_t)bind.bind))
+        continue;
+
+      uint32_t type = v.type;
+      if(program.types[type].kind == SPVDebug::DecodedProgram::Type::Array)
+        type = program.types[type].elem;
+
+      SPVDebug::BindingSlot slot = pushConst ? SPVDebug::BindingSlot(~0U, 0, 0)
+                                             : SPVDebug::BindingSlot(v.set, v.binding, 0);
+      const vector<byte> &data = global.GetBuffer(slot);
+
+      ShaderVariable block =
+          program.ReadMemory(data.data(), data.size(), type, 0, 16, false, 0, "");
+      trace.cbuffers[i] = block.members;
+      break;
+    }
+  }
+}
+
+// steps a single thread on its own to completion, recording every state
+static void SimulateThread(SPVDebug::GlobalState &global, SPVDebug::State &state,
+                           ShaderDebugTrace &trace)
+{
+  ShaderDebugTraceBuilder states;
+
+  states.AddState(state);
+
+  for(uint32_t cycleCounter = 0; !state.Finished(); cycleCounter++)
+  {
+    if(cycleCounter == SHADER_DEBUG_MAX_STEPS)
+    {
+      RDCWARN("Shader debugging stopped after %u steps, possibly in an infinite loop",
+              cycleCounter);
+      break;
+    }
+
+    state.StepNext(global, NULL);
+    states.AddState(state);
+  }
+
+  states.Finish(trace);
+}
+
+// the value of a vertex attribute for one vertex, in the attribute's own type. Missing components
+// default to 0, 0, 0, 1
+static void ReadAttribute(const ResourceFormat &fmt, const vector<byte> &data, ShaderVariable &var,
+                          uint32_t firstComp)
+{
+  bool isInt = fmt.compType == CompType::UInt || fmt.compType == CompType::SInt;
+  bool isDouble = fmt.compType == CompType::Double;
+
+  uint32_t numComps = var.rows * var.columns;
+
+  for(uint32_t c = firstComp; c < numComps && c < firstComp + 4; c++)
+  {
+    uint32_t comp = c - firstComp;
+    const byte *src = comp < fmt.compCount && data.size() >= (comp + 1) * fmt.compByteWidth
+                          ? &data[comp * fmt.compByteWidth]
+                          : NULL;
+
+    if(isDouble)
+    {
+      if(var.type == VarType::Double)
+        var.value.dv[c] = src ? *(const double *)src : (comp == 3 ? 1.0 : 0.0);
+      else
+        var.value.fv[c] = src ? (float)*(const double *)src : (comp == 3 ? 1.0f : 0.0f);
+    }
+    else if(isInt)
+    {
+      uint32_t val = comp == 3 ? 1 : 0;
+      if(src)
+      {
+        bool sint = fmt.compType == CompType::SInt;
+        if(fmt.compByteWidth == 1)
+          val = sint ? uint32_t(int32_t(int8_t(src[0]))) : src[0];
+        else if(fmt.compByteWidth == 2)
+          val = sint ? uint32_t(int32_t(*(const int16_t *)src)) : *(const uint16_t *)src;
+        else
+          val = *(const uint32_t *)src;
+      }
+      var.value.uv[c] = val;
+    }
+    else
+    {
+      float val = comp == 3 ? 1.0f : 0.0f;
+      if(src && !fmt.special)
+        ConvertComponents(fmt, src, 1, &val);
+      else if(fmt.special && comp < 4 && data.size() >= 4)
+        val = ConvertComponent(fmt, (byte *)data.data());
+      var.value.fv[c] = val;
+    }
+  }
+}
+
+ShaderDebugTrace VulkanReplay::DebugVertex(uint32_t eventID, uint32_t vertid, uint32_t instid,
+                                           uint32_t idx, uint32_t instOffset, uint32_t vertOffset)
+{
+  vector<ShaderDebugVertexInput> inputs(1);
+  inputs[0].vertid = vertid;
+  inputs[0].instid = instid;
+  inputs[0].idx = idx;
+
+  return DebugVertices(eventID, inputs, instOffset, vertOffset)[0];
+}
+
+vector<ShaderDebugTrace> VulkanReplay::DebugVertices(uint32_t eventID,
+                                                     vector<ShaderDebugVertexInput> inputs,
+                                                     uint32_t instOffset, uint32_t vertOffset)
+{
+  vector<ShaderDebugTrace> traces(inputs.size());
+
+  if(inputs.empty())
+    return traces;
+
+  const VulkanRenderState &state = m_pDriver->m_RenderState;
+  VulkanCreationInfo &c = m_pDriver->m_CreationInfo;
+
+  if(state.graphics.pipeline == ResourceId())
+    return traces;
+
+  const VulkanCreationInfo::Pipeline &pipe = c.m_Pipeline[state.graphics.pipeline];
+  const VulkanCreationInfo::Pipeline::Shader &shader = pipe.shaders[0];
+
+  VulkanDebugAPIWrapper api(this, c, m_VulkanPipelineState.graphics, state.pushconsts,
+                            sizeof(state.pushconsts));
+
+  // vertex shaders can't write to anything visible to other invocations in a way that's defined,
+  // so every simulation shares the global state
+  SPVDebug::GlobalState global;
+  global.api = &api;
+
+  if(!DecodeShader(c, shader, ShaderStage::Vertex, global.program))
+    return traces;
+
+  const SPVDebug::DecodedProgram &program = global.program;
+  const VKPipe::VertexInput &vi = m_VulkanPipelineState.VI;
+
+  for(size_t t = 0; t < inputs.size(); t++)
+  {
+    const ShaderDebugVertexInput &in = inputs[t];
+    ShaderDebugTrace &trace = traces[t];
+
+    SPVDebug::State thread(0, &program);
+
+    for(size_t g = 0; g < program.globals.size(); g++)
+    {
+      const SPVDebug::DecodedProgram::Variable &v = program.globals[g];
+
+      if(v.storage != spv::StorageClassInput)
+        continue;
+
+      ShaderVariable var = program.MakeValue(v.type, v.name);
+
+      if(v.builtin == spv::BuiltInVertexIndex || v.builtin == spv::BuiltInVertexId)
+      {
+        var.value.uv[0] = in.idx;
+      }
+      else if(v.builtin == spv::BuiltInInstanceIndex || v.builtin == spv::BuiltInInstanceId)
+      {
+        var.value.uv[0] = in.instid + instOffset;
+      }
+      else if(v.location >= 0)
+      {
+        // matrices take one location per column
+        uint32_t numLocations = var.rows > 1 ? var.columns : 1;
+
+        for(uint32_t l = 0; l < numLocations; l++)
+        {
+          for(int32_t a = 0; a < vi.attrs.count; a++)
+          {
+            const VKPipe::VertexAttribute &attr = vi.attrs[a];
+            if(attr.location != (uint32_t)v.location + l)
+              continue;
+
+            const VKPipe::VertexBinding *bind = NULL;
+            for(int32_t b = 0; b < vi.binds.count; b++)
+              if(vi.binds[b].vbufferBinding == attr.binding)
+                bind = &vi.binds[b];
+
+            if(bind == NULL || attr.binding >= (uint32_t)vi.vbuffers.count)
+              break;
+
+            const VKPipe::VB &vb = vi.vbuffers[attr.binding];
+            uint32_t elem = bind->perInstance ? in.instid + instOffset : in.idx;
+
+            vector<byte> data;
+            uint32_t size = attr.format.compByteWidth * attr.format.compCount;
+            if(attr.format.special)
+              size = 4;
+
+            if(vb.buffer != ResourceId())
+              GetBufferData(GetLiveID(vb.buffer),
+                            vb.offset + uint64_t(elem) * bind->bytestride + attr.byteoffset, size,
+                            data);
+
+            if(var.rows > 1)
+            {
+              // read the column, then put it in place in the row-major matrix
+              ShaderVariable col = var;
+              col.rows = 1;
+              col.columns = var.rows;
+              ReadAttribute(attr.format, data, col, 0);
+              for(uint32_t r = 0; r < var.rows; r++)
+                var.value.uv[r * var.columns + l] = col.value.uv[r];
+            }
+            else
+            {
+              ReadAttribute(attr.format, data, var, 0);
+            }
+            break;
+          }
+        }
+      }
+
+      thread.SetInput(v.id, var);
+    }
+
+    thread.Init(global);
+
+    vector<ShaderVariable> traceInputs;
+    thread.GetInputs(traceInputs);
+    trace.inputs = traceInputs;
+    trace.disassembly = program.disassembly;
+
+    FillConstantBlocks(global, *shader.mapping, trace);
+
+    SimulateThread(global, thread, trace);
+  }
+
+  return traces;
+}
+
+ShaderDebugTrace VulkanReplay::DebugPixel(uint32_t eventID, uint32_t x, uint32_t y, uint32_t sample,
+                                          uint32_t primitive)
+{
+  vector<ShaderDebugPixelInput> inputs(1);
+  inputs[0].x = x;
+  inputs[0].y = y;
+  inputs[0].sample = sample;
+  inputs[0].primitive = primitive;
+
+  return DebugPixels(eventID, inputs)[0];
+}
+
+namespace
+{
+// one vertex of the primitive covering a pixel, in framebuffer space
+struct ScreenVertex
+{
+  double x, y, z, w;
+  // index into the post-transform data
+  uint32_t idx;
+};
+
+struct CoveringPrimitive
+{
+  ScreenVertex verts[3];
+  uint32_t primitive;
+  uint32_t instance;
+  // which vertex attributes are flat shaded from
+  uint32_t provoking;
+  bool frontFacing;
+  double depth;
+};
+
+double EdgeFunction(const ScreenVertex &a, const ScreenVertex &b, double px, double py)
+{
+  return (b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x);
+}
+
+// screen-space barycentrics of a point relative to a triangle. They're not clamped, so points
+// outside the triangle still get a sensible extrapolated value.
+void Barycentrics(const CoveringPrimitive &prim, double px, double py, double bary[3])
+{
+  const ScreenVertex *v = prim.verts;
+  double area = EdgeFunction(v[0], v[1], v[2].x, v[2].y);
+  bary[0] = EdgeFunction(v[1], v[2], px, py) / area;
+  bary[1] = EdgeFunction(v[2], v[0], px, py) / area;
+  bary[2] = EdgeFunction(v[0], v[1], px, py) / area;
+}
+};
+
+vector<ShaderDebugTrace> VulkanReplay::DebugPixels(uint32_t eventID,
+                                                   vector<ShaderDebugPixelInput> inputs)
+{
+  vector<ShaderDebugTrace> traces(inputs.size());
+
+  if(inputs.empty())
+    return traces;
+
+  const VulkanRenderState &state = m_pDriver->m_RenderState;
+  VulkanCreationInfo &c = m_pDriver->m_CreationInfo;
+
+  if(state.graphics.pipeline == ResourceId())
+    return traces;
+
+  const VulkanCreationInfo::Pipeline &pipe = c.m_Pipeline[state.graphics.pipeline];
+  const VulkanCreationInfo::Pipeline::Shader &shader = pipe.shaders[4];
+  const VulkanCreationInfo::Pipeline::Shader &vertShader = pipe.shaders[0];
+
+  // pixel inputs are interpolated on the CPU from the vertex shader's outputs, which are only
+  // available when the vertex shader feeds the rasterizer directly
+  if(pipe.shaders[1].module != ResourceId() || pipe.shaders[2].module != ResourceId() ||
+     pipe.shaders[3].module != ResourceId())
+  {
+    RDCWARN("Pixel debugging isn't supported with geometry or tessellation shaders bound");
+    return traces;
+  }
+
+  if(vertShader.refl == NULL)
+    return traces;
+
+  const DrawcallDescription *draw = m_pDriver->GetDrawcall(eventID);
+  if(draw == NULL)
+    return traces;
+
+  VulkanDebugAPIWrapper api(this, c, m_VulkanPipelineState.graphics, state.pushconsts,
+                            sizeof(state.pushconsts));
+
+  SPVDebug::GlobalState global;
+  global.api = &api;
+
+  if(!DecodeShader(c, shader, ShaderStage::Pixel, global.program))
+    return traces;
+
+  const SPVDebug::DecodedProgram &program = global.program;
+
+  // layout of each vertex in the post-transform data, matching how the vertex shader's outputs are
+  // packed when they're fetched
+  const rdctype::array<SigParameter> &outSig = vertShader.refl->OutputSig;
+  vector<uint32_t> outOffsets(outSig.count);
+  int32_t posIdx = -1;
+  {
+    uint32_t offset = 0;
+    for(int32_t o = 0; o < outSig.count; o++)
+    {
+      uint32_t elemSize = outSig[o].compType == CompType::Double ? 8 : 4;
+      if(outSig[o].compCount == 2)
+        offset = AlignUp(offset, 2U * elemSize);
+      else if(outSig[o].compCount > 2)
+        offset = AlignUp(offset, 4U * elemSize);
+      outOffsets[o] = offset;
+      offset += elemSize * outSig[o].compCount;
+
+      if(outSig[o].systemValue == ShaderBuiltin::Position)
+        posIdx = o;
+    }
+  }
+
+  if(posIdx < 0)
+  {
+    RDCWARN("Vertex shader doesn't write a position, can't find the pixel's primitive");
+    return traces;
+  }
+
+  InitPostVSBuffers(eventID);
+
+  const VKPipe::Viewport &vp = m_VulkanPipelineState.VP.viewportScissors.count > 0
+                                   ? m_VulkanPipelineState.VP.viewportScissors[0].vp
+                                   : VKPipe::Viewport();
+
+  // fetch every instance's post-transform data once, for all pixels
+  uint32_t numInstances = RDCMAX(1U, draw->numInstances);
+  vector<vector<byte> > vertData(numInstances);
+  vector<vector<uint32_t> > indices(numInstances);
+  vector<MeshFormat> fmts(numInstances);
+
+  for(uint32_t inst = 0; inst < numInstances; inst++)
+  {
+    MeshFormat &fmt = fmts[inst];
+    fmt = GetPostVSBuffers(eventID, inst, MeshDataStage::VSOut);
+
+    if(fmt.buf == ResourceId())
+      continue;
+
+    GetBufferData(fmt.buf, fmt.offset, 0, vertData[inst]);
+
+    if(fmt.idxbuf != ResourceId())
+    {
+      vector<byte> idxData;
+      GetBufferData(fmt.idxbuf, 0, 0, idxData);
+
+      for(uint32_t i = 0; i < fmt.numVerts; i++)
+      {
+        if(fmt.idxByteWidth == 2 && (i + 1) * 2 <= idxData.size())
+          indices[inst].push_back(((const uint16_t *)idxData.data())[i]);
+        else if(fmt.idxByteWidth == 4 && (i + 1) * 4 <= idxData.size())
+          indices[inst].push_back(((const uint32_t *)idxData.data())[i]);
+      }
+    }
+    else
+    {
+      for(uint32_t i = 0; i < fmt.numVerts; i++)
+        indices[inst].push_back(i);
+    }
+  }
+
+  Topology topo = fmts[0].topo;
+  if(topo != Topology::TriangleList && topo != Topology::TriangleStrip &&
+     topo != Topology::TriangleFan)
+  {
+    RDCWARN("Pixel debugging is only supported for triangles");
+    return traces;
+  }
+
+  // reads a float from one vertex's output
+  struct VertexReader
+  {
+    const vector<byte> *data;
+    uint32_t stride;
+
+    const byte *Get(uint32_t idx, uint32_t offset) const
+    {
+      size_t o = size_t(idx) * stride + offset;
+      if(o + sizeof(double) > data->size() && o + sizeof(float) > data->size())
+        return NULL;
+      return data->data() + o;
+    }
+  };
+
+  for(size_t t = 0; t < inputs.size(); t++)
+  {
+    const ShaderDebugPixelInput &in = inputs[t];
+
+    // find the primitive covering the pixel, the same way the rasterizer would
+    vector<CoveringPrimitive> candidates;
+
+    double cx = in.x + 0.5, cy = in.y + 0.5;
+
+    for(uint32_t inst = 0; inst < numInstances; inst++)
+    {
+      VertexReader reader = {&vertData[inst], fmts[inst].stride};
+      const vector<uint32_t> &idx = indices[inst];
+
+      uint32_t numPrims = 0;
+      if(topo == Topology::TriangleList)
+        numPrims = uint32_t(idx.size() / 3);
+      else if(idx.size() >= 3)
+        numPrims = uint32_t(idx.size() - 2);
+
+      for(uint32_t p = 0; p < numPrims; p++)
+      {
+        CoveringPrimitive prim;
+        prim.primitive = p;
+        prim.instance = inst;
+
+        uint32_t v[3];
+        if(topo == Topology::TriangleList)
+        {
+          v[0] = p * 3;
+          v[1] = p * 3 + 1;
+          v[2] = p * 3 + 2;
+        }
+        else if(topo == Topology::TriangleStrip)
+        {
+          // odd triangles in a strip swap their winding back
+          v[0] = p;
+          v[1] = p + 1 + (p % 2);
+          v[2] = p + 2 - (p % 2);
+        }
+        else
+        {
+          v[0] = p + 1;
+          v[1] = p + 2;
+          v[2] = 0;
+        }
+        prim.provoking = 0;
+
+        bool valid = true;
+        for(int i = 0; i < 3 && valid; i++)
+        {
+          const byte *pos = reader.Get(idx[v[i]], outOffsets[posIdx]);
+          if(pos == NULL)
+          {
+            valid = false;
+            break;
+          }
+
+          const float *clip = (const float *)pos;
+          ScreenVertex &sv = prim.verts[i];
+          sv.w = clip[3];
+          if(sv.w == 0.0)
+          {
+            valid = false;
+            break;
+          }
+          sv.x = vp.x + (clip[0] / sv.w + 1.0) * 0.5 * vp.width;
+          sv.y = vp.y + (clip[1] / sv.w + 1.0) * 0.5 * vp.height;
+          sv.z = vp.minDepth + (clip[2] / sv.w) * (vp.maxDepth - vp.minDepth);
+          sv.idx = idx[v[i]];
+        }
+
+        if(!valid)
+          continue;
+
+        double area = EdgeFunction(prim.verts[0], prim.verts[1], prim.verts[2].x, prim.verts[2].y);
+        if(area == 0.0)
+          continue;
+
+        // Vulkan's facing is the sign of the negated shoelace area in framebuffer space
+        prim.frontFacing = m_VulkanPipelineState.RS.FrontCCW ? area < 0.0 : area > 0.0;
+
+        CullMode cull = m_VulkanPipelineState.RS.cullMode;
+        if(cull == CullMode::FrontAndBack || (cull == CullMode::Front && prim.frontFacing) ||
+           (cull == CullMode::Back && !prim.frontFacing))
+          continue;
+
+        double bary[3];
+        Barycentrics(prim, cx, cy, bary);
+        if(bary[0] < 0.0 || bary[1] < 0.0 || bary[2] < 0.0)
+          continue;
+
+        prim.depth = bary[0] * prim.verts[0].z + bary[1] * prim.verts[1].z +
+                     bary[2] * prim.verts[2].z;
+
+        candidates.push_back(prim);
+      }
+    }
+
+    if(candidates.empty())
+    {
+      RDCLOG("No primitive in the draw covers pixel (%u, %u)", in.x, in.y);
+      continue;
+    }
+
+    // pick the requested primitive if there is one, otherwise whichever would pass the depth test
+    // last
+    size_t chosen = candidates.size() - 1;
+    bool found = false;
+
+    if(in.primitive != ~0U)
+    {
+      for(size_t i = 0; i < candidates.size() && !found; i++)
+      {
+        if(candidates[i].primitive == in.primitive)
+        {
+          chosen = i;
+          found = true;
+        }
+      }
+    }
+
+    if(!found && m_VulkanPipelineState.DS.depthTestEnable)
+    {
+      CompareFunc func = m_VulkanPipelineState.DS.depthCompareOp;
+      bool nearest = func == CompareFunc::Less || func == CompareFunc::LessEqual;
+      bool furthest = func == CompareFunc::Greater || func == CompareFunc::GreaterEqual;
+
+      for(size_t i = 0; i < candidates.size(); i++)
+      {
+        if((nearest && candidates[i].depth <= candidates[chosen].depth) ||
+           (furthest && candidates[i].depth >= candidates[chosen].depth))
+          chosen = i;
+      }
+    }
+
+    const CoveringPrimitive &prim = candidates[chosen];
+    VertexReader reader = {&vertData[prim.instance], fmts[prim.instance].stride};
+
+    // set up the quad around the pixel, with inputs extrapolated to the neighbours
+    int destIdx = (in.x & 1) + (in.y & 1) * 2;
+
+    SPVDebug::State quad[4];
+
+    for(int lane = 0; lane < 4; lane++)
+    {
+      quad[lane] = SPVDebug::State(lane, &program);
+
+      double px = (in.x & ~1U) + (lane & 1) + 0.5;
+      double py = (in.y & ~1U) + (lane >> 1) + 0.5;
+
+      double linear[3];
+      Barycentrics(prim, px, py, linear);
+
+      bool covered = linear[0] >= 0.0 && linear[1] >= 0.0 && linear[2] >= 0.0;
+
+      double persp[3], perspSum = 0.0;
+      for(int i = 0; i < 3; i++)
+      {
+        persp[i] = linear[i] / prim.verts[i].w;
+        perspSum += persp[i];
+      }
+      double invW = perspSum;
+      for(int i = 0; i < 3; i++)
+        persp[i] /= perspSum;
+
+      for(size_t g = 0; g < program.globals.size(); g++)
+      {
+        const SPVDebug::DecodedProgram::Variable &v = program.globals[g];
+
+        if(v.storage != spv::StorageClassInput)
+          continue;
+
+        ShaderVariable var = program.MakeValue(v.type, v.name);
+
+        switch(v.builtin)
+        {
+          case spv::BuiltInFragCoord:
+            var.value.fv[0] = float(px);
+            var.value.fv[1] = float(py);
+            var.value.fv[2] = float(linear[0] * prim.verts[0].z + linear[1] * prim.verts[1].z +
+                                    linear[2] * prim.verts[2].z);
+            var.value.fv[3] = float(invW);
+            break;
+          case spv::BuiltInFrontFacing: var.value.uv[0] = prim.frontFacing ? 1 : 0; break;
+          case spv::BuiltInPrimitiveId: var.value.uv[0] = prim.primitive; break;
+          case spv::BuiltInSampleId: var.value.uv[0] = in.sample == ~0U ? 0 : in.sample; break;
+          case spv::BuiltInSamplePosition:
+            var.value.fv[0] = var.value.fv[1] = 0.5f;
+            break;
+          case spv::BuiltInHelperInvocation: var.value.uv[0] = covered ? 0 : 1; break;
+          case -1:
+          {
+            if(v.location < 0)
+              break;
+
+            // each column of a matrix or element of an array has its own location
+            uint32_t numLocations = 1;
+            if(var.rows > 1)
+              numLocations = var.columns;
+            else if(var.members.count > 0)
+              numLocations = var.members.count;
+
+            for(uint32_t l = 0; l < numLocations; l++)
+            {
+              const SigParameter *sig = NULL;
+              uint32_t sigIdx = 0;
+              for(int32_t o = 0; o < outSig.count; o++)
+              {
+                if(outSig[o].systemValue == ShaderBuiltin::Undefined &&
+                   outSig[o].regIndex == (uint32_t)v.location + l)
+                {
+                  sig = &outSig[o];
+                  sigIdx = (uint32_t)o;
+                }
+              }
+
+              if(sig == NULL)
+                continue;
+
+              ShaderVariable *dst = var.members.count > 0 ? &var.members[l] : &var;
+              uint32_t comps = var.rows > 1 ? var.rows : dst->columns;
+              if(dst->members.count > 0)
+                comps = 0;
+              comps = RDCMIN(comps, sig->compCount);
+
+              bool isFloat = sig->compType == CompType::Float;
+              bool isDouble = sig->compType == CompType::Double;
+              uint32_t elemSize = isDouble ? 8 : 4;
+
+              for(uint32_t comp = 0; comp < comps; comp++)
+              {
+                uint32_t dstComp = var.rows > 1 ? comp * var.columns + l : comp;
+                uint32_t offs = outOffsets[sigIdx] + comp * elemSize;
+
+                if(v.flat || !(isFloat || isDouble))
+                {
+                  const byte *src = reader.Get(prim.verts[prim.provoking].idx, offs);
+                  if(src)
+                    memcpy(&dst->value.uv[dstComp], src, elemSize);
+                  continue;
+                }
+
+                const double *weights = v.noperspective ? linear : persp;
+                double val = 0.0;
+                for(int i = 0; i < 3; i++)
+                {
+                  const byte *src = reader.Get(prim.verts[i].idx, offs);
+                  if(src)
+                    val += weights[i] * (isDouble ? *(const double *)src : *(const float *)src);
+                }
+
+                if(isDouble)
+                  dst->value.dv[dstComp] = val;
+                else
+                  dst->value.fv[dstComp] = float(val);
+              }
+            }
+            break;
+          }
+          default: break;
+        }
+
+        quad[lane].SetInput(v.id, var);
+      }
+
+      if(lane != destIdx)
+        quad[lane].SetHelper();
+
+      quad[lane].Init(global);
+    }
+
+    ShaderDebugTrace &trace = traces[t];
+
+    vector<ShaderVariable> traceInputs;
+    quad[destIdx].GetInputs(traceInputs);
+    trace.inputs = traceInputs;
+    trace.disassembly = program.disassembly;
+
+    FillConstantBlocks(global, *shader.mapping, trace);
+
+    ShaderDebugTraceBuilder states;
+
+    states.AddState(quad[destIdx]);
+
+    // marks any threads stalled waiting for others to catch up
+    bool activeMask[4] = {true, true, true, true};
+
+    // simulate lockstep until the destination thread is finished, using the same scheme as D3D11:
+    // when threads diverge, any that reach the merge block of a construct wait there for the
+    // others so that derivatives are valid again once control flow converges.
+    for(uint32_t cycleCounter = 0; !quad[destIdx].Finished(); cycleCounter++)
+    {
+      if(cycleCounter == SHADER_DEBUG_MAX_STEPS)
+      {
+        RDCWARN("Shader debugging stopped after %u steps, possibly in an infinite loop",
+                cycleCounter);
+        break;
+      }
+
+      for(int i = 0; i < 4; i++)
+        if(activeMask[i])
+          quad[i].StepNext(global, quad);
+
+      if(activeMask[destIdx])
+        states.AddState(quad[destIdx]);
+
+      activeMask[0] = activeMask[1] = activeMask[2] = activeMask[3] = true;
+
+      uint32_t convergencePoint = 0;
+      bool diverged = false;
+      int running = 0;
+
+      for(int i = 0; i < 4; i++)
+      {
+        if(quad[i].Finished())
+          continue;
+
+        running++;
+
+        if(quad[i].nextInstruction != quad[destIdx].nextInstruction)
+          diverged = true;
+
+        if(quad[i].nextInstruction > convergencePoint)
+          convergencePoint = quad[i].nextInstruction;
+      }
+
+      if(!diverged)
+        continue;
+
+      // if the most advanced thread hasn't just reached a merge block, everything keeps going
+      bool atMerge = false;
+      for(int i = 0; i < 4; i++)
+        if(!quad[i].Finished() && quad[i].nextInstruction == convergencePoint &&
+           quad[i].AtConvergencePoint())
+          atMerge = true;
+
+      if(!atMerge)
+        continue;
+
+      int paused = 0;
+      for(int i = 0; i < 4; i++)
+      {
+        if(!quad[i].Finished() && quad[i].nextInstruction == convergencePoint)
+        {
+          activeMask[i] = false;
+          paused++;
+        }
+      }
+
+      // never pause everything, in case the other threads never reach this point
+      if(paused == running)
+        activeMask[0] = activeMask[1] = activeMask[2] = activeMask[3] = true;
+    }
+
+    states.Finish(trace);
+  }
+
+  return traces;
+}
+
+ShaderDebugTrace VulkanReplay::DebugThread(uint32_t eventID, const uint32_t groupid[3],
+                                           const uint32_t threadid[3])
+{
+  ShaderDebugTrace trace;
+
+  const VulkanRenderState &state = m_pDriver->m_RenderState;
+  VulkanCreationInfo &c = m_pDriver->m_CreationInfo;
+
+  if(state.compute.pipeline == ResourceId())
+    return trace;
+
+  const VulkanCreationInfo::Pipeline &pipe = c.m_Pipeline[state.compute.pipeline];
+  const VulkanCreationInfo::Pipeline::Shader &shader = pipe.shaders[5];
+
+  const DrawcallDescription *draw = m_pDriver->GetDrawcall(eventID);
+
+  VulkanDebugAPIWrapper api(this, c, m_VulkanPipelineState.compute, state.pushconsts,
+                            sizeof(state.pushconsts));
+
+  SPVDebug::GlobalState global;
+  global.api = &api;
+
+  if(!DecodeShader(c, shader, ShaderStage::Compute, global.program))
+    return trace;
+
+  const SPVDebug::DecodedProgram &program = global.program;
+  const uint32_t *localSize = program.localSize;
+
+  // threads in a group can only see each other's writes through workgroup memory, so unless the
+  // shader declares some only the requested thread needs to run
+  bool simulateGroup = false;
+  for(size_t g = 0; g < program.globals.size(); g++)
+    if(program.globals[g].storage == spv::StorageClassWorkgroup)
+      simulateGroup = true;
+
+  uint32_t groupThreads = localSize[0] * localSize[1] * localSize[2];
+  if(simulateGroup && groupThreads > SHADER_DEBUG_MAX_GROUP_THREADS)
+  {
+    RDCWARN("Workgroup of %u threads is too large to simulate, shared memory will be incorrect",
+            groupThreads);
+    simulateGroup = false;
+  }
+
+  uint32_t destIdx = 0;
+  vector<uint32_t> threadIDs;
+
+  if(simulateGroup)
+  {
+    for(uint32_t z = 0; z < localSize[2]; z++)
+    {
+      for(uint32_t y = 0; y < localSize[1]; y++)
+      {
+        for(uint32_t x = 0; x < localSize[0]; x++)
+        {
+          if(x == threadid[0] && y == threadid[1] && z == threadid[2])
+            destIdx = (uint32_t)threadIDs.size() / 3;
+          threadIDs.push_back(x);
+          threadIDs.push_back(y);
+          threadIDs.push_back(z);
+        }
+      }
+    }
+  }
+  else
+  {
+    threadIDs.push_back(threadid[0]);
+    threadIDs.push_back(threadid[1]);
+    threadIDs.push_back(threadid[2]);
+  }
+
+  vector<SPVDebug::State> threads(threadIDs.size() / 3);
+
+  for(size_t i = 0; i < threads.size(); i++)
+  {
+    const uint32_t *tid = &threadIDs[i * 3];
+
+    threads[i] = SPVDebug::State(0, &program);
+
+    for(size_t g = 0; g < program.globals.size(); g++)
+    {
+      const SPVDebug::DecodedProgram::Variable &v = program.globals[g];
+
+      if(v.storage != spv::StorageClassInput)
+        continue;
+
+      ShaderVariable var = program.MakeValue(v.type, v.name);
+
+      for(int comp = 0; comp < 3; comp++)
+      {
+        switch(v.builtin)
+        {
+          case spv::BuiltInGlobalInvocationId:
+            var.value.uv[comp] = groupid[comp] * localSize[comp] + tid[comp];
+            break;
+          case spv::BuiltInLocalInvocationId: var.value.uv[comp] = tid[comp]; break;
+          case spv::BuiltInWorkgroupId: var.value.uv[comp] = groupid[comp]; break;
+          case spv::BuiltInNumWorkgroups:
+            var.value.uv[comp] = draw ? draw->dispatchDimension[comp] : 1;
+            break;
+          case spv::BuiltInWorkgroupSize: var.value.uv[comp] = localSize[comp]; break;
+          default: break;
+        }
+      }
+
+      if(v.builtin == spv::BuiltInLocalInvocationIndex)
+        var.value.uv[0] =
+            tid[2] * localSize[0] * localSize[1] + tid[1] * localSize[0] + tid[0];
+
+      threads[i].SetInput(v.id, var);
+    }
+
+    threads[i].Init(global);
+  }
+
+  SPVDebug::State &dest = threads[destIdx];
+
+  vector<ShaderVariable> traceInputs;
+  dest.GetInputs(traceInputs);
+  trace.inputs = traceInputs;
+  trace.disassembly = program.disassembly;
+
+  FillConstantBlocks(global, *shader.mapping, trace);
+
+  if(threads.size() == 1)
+  {
+    SimulateThread(global, dest, trace);
+    return trace;
+  }
+
+  ShaderDebugTraceBuilder states;
+
+  states.AddState(dest);
+
+  // run each thread in turn until it reaches a barrier or finishes, then release the barrier once
+  // every thread has arrived at it
+  uint32_t cycleCounter = 0;
+  bool abort = false;
+
+  while(!abort)
+  {
+    bool allDone = true;
+
+    for(size_t i = 0; i < threads.size() && !abort; i++)
+    {
+      while(!threads[i].Finished() && !threads[i].AtThreadBarrier())
+      {
+        threads[i].StepNext(global, NULL);
+
+        if(i == destIdx)
+          states.AddState(dest);
+
+        if(++cycleCounter == SHADER_DEBUG_MAX_STEPS * 16)
+        {
+          RDCWARN("Shader debugging stopped after %u steps, possibly in an infinite loop",
+                  cycleCounter);
+          abort = true;
+          break;
+        }
+      }
+
+      if(!threads[i].Finished())
+        allDone = false;
+    }
+
+    if(allDone || abort)
+      break;
+
+    for(size_t i = 0; i < threads.size(); i++)
+    {
+      if(threads[i].AtThreadBarrier())
+      {
+        threads[i].StepNext(global, NULL);
+
+        if(i == destIdx)
+          states.AddState(dest);
+      }
+    }
+  }
+
+  states.Finish(trace);
+
+  return trace;
+}
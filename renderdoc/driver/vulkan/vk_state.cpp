@@ -54,6 +54,12 @@ VulkanRenderState::VulkanRenderState(VulkanCreationInfo *createInfo) : m_Creatio
   vbuffers.clear();
 }
 
+VulkanRenderState::VulkanRenderState(const VulkanRenderState &o)
+    : m_ResourceManager(o.m_ResourceManager), m_CreationInfo(o.m_CreationInfo)
+{
+  *this = o;
+}
+
 VulkanRenderState &VulkanRenderState::operator=(const VulkanRenderState &o)
 {
   views = o.views;
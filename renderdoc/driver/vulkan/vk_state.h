@@ -33,6 +33,7 @@ class VulkanResourceManager;
 struct VulkanRenderState
 {
   VulkanRenderState(VulkanCreationInfo *createInfo);
+  VulkanRenderState(const VulkanRenderState &o);
   VulkanRenderState &operator=(const VulkanRenderState &o);
   void BeginRenderPassAndApplyState(VkCommandBuffer cmd);
   void EndRenderPass(VkCommandBuffer cmd);
@@ -302,6 +302,36 @@ string WrappedVulkan::MakeRenderPassOpString(bool store)
   return opDesc;
 }
 
+void WrappedVulkan::RecordCmdImageBarriers(VkResourceRecord *cmdRecord, uint32_t numBarriers,
+                                           const VkImageMemoryBarrier *barriers)
+{
+  // the image layouts are shared by every thread, but they're only needed to look up the size of
+  // images for barriers with VK_REMAINING_* ranges. Barriers with explicit ranges can be recorded
+  // without the lock, so threads recording in parallel don't serialise on it.
+  bool needLayouts = false;
+  for(uint32_t i = 0; i < numBarriers; i++)
+  {
+    if(barriers[i].subresourceRange.levelCount == VK_REMAINING_MIP_LEVELS ||
+       barriers[i].subresourceRange.layerCount == VK_REMAINING_ARRAY_LAYERS)
+    {
+      needLayouts = true;
+      break;
+    }
+  }
+
+  if(needLayouts)
+  {
+    SCOPED_LOCK(m_ImageLayoutsLock);
+    GetResourceManager()->RecordBarriers(cmdRecord->cmdInfo->imgbarriers, m_ImageLayouts,
+                                         numBarriers, barriers);
+  }
+  else
+  {
+    GetResourceManager()->RecordBarriers(cmdRecord->cmdInfo->imgbarriers, m_ImageLayouts,
+                                         numBarriers, barriers);
+  }
+}
+
 // Command pool functions
 
 bool WrappedVulkan::Serialise_vkCreateCommandPool(Serialiser *localSerialiser, VkDevice device,
@@ -416,6 +446,10 @@ VkResult WrappedVulkan::vkAllocateCommandBuffers(VkDevice device,
 
         record->bakedCommands = NULL;
 
+        // command buffers are externally synchronised, so only the recording thread adds chunks
+        // and it doesn't need to lock or allocate IDs for each one.
+        record->SetDeferChunkIDs(true);
+
         record->pool = GetRecord(pAllocateInfo->commandPool);
         record->AddParent(record->pool);
 
@@ -516,6 +550,8 @@ bool WrappedVulkan::Serialise_vkBeginCommandBuffer(Serialiser *localSerialiser,
           m_Partial[p].partialDevice = device;
           m_Partial[p].resultPartialCmdPool =
               (VkCommandPool)(uint64_t)GetResourceManager()->GetNonDispWrapper(allocInfo.commandPool);
+          m_Partial[p].partialBakeId = bakeId;
+          m_Partial[p].resultFromCache = false;
 
           partial = true;
           partialType = p;
@@ -523,6 +559,36 @@ bool WrappedVulkan::Serialise_vkBeginCommandBuffer(Serialiser *localSerialiser,
       }
     }
 
+    // if we've re-recorded this exact partial command buffer before, submit that instead. Clearing
+    // the partial parent makes all the vkCmd chunks skip re-recording, so restore the state they
+    // would have tracked.
+    if(partial && m_DrawcallCallback == NULL && m_Partial[Primary].outsideCmdBuffer == VK_NULL_HANDLE)
+    {
+      PartialCmdKey key;
+      key.bakeId = bakeId;
+      key.lastEvent = m_LastEventID;
+      key.partialType = partialType;
+
+      auto it = m_PartialCmdCache.find(key);
+
+      if(it != m_PartialCmdCache.end())
+      {
+#if ENABLED(VERBOSE_PARTIAL_REPLAY)
+        RDCDEBUG("vkBegin - reusing cached partial %llu up to %u", bakeId, m_LastEventID);
+#endif
+
+        it->second.lastUse = ++m_PartialCmdCacheTick;
+
+        m_Partial[partialType].resultPartialCmdBuffer = it->second.cmd;
+        m_Partial[partialType].resultFromCache = true;
+        m_Partial[partialType].renderPassActive = it->second.renderPassActive;
+        m_Partial[partialType].partialParent = ResourceId();
+        m_RenderState = *it->second.state;
+
+        partial = false;
+      }
+    }
+
     if(partial || (m_DrawcallCallback && m_DrawcallCallback->RecordAllCmds()))
     {
       // pull all re-recorded commands from our own device and command pool for easier cleanup
@@ -563,8 +629,12 @@ bool WrappedVulkan::Serialise_vkBeginCommandBuffer(Serialiser *localSerialiser,
         m_RerecordCmds[cmdId] = cmd;
       }
 
-      // add one-time submit flag as this partial cmd buffer will only be submitted once
-      info.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+      // add one-time submit flag as this partial cmd buffer will only be submitted once, unless
+      // it might be kept in m_PartialCmdCache and submitted again.
+      if(m_DrawcallCallback)
+        info.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+      else
+        info.flags &= ~VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
       ObjDisp(cmd)->BeginCommandBuffer(Unwrap(cmd), &info);
     }
@@ -610,6 +680,7 @@ bool WrappedVulkan::Serialise_vkBeginCommandBuffer(Serialiser *localSerialiser,
       m_BakedCmdBufferInfo[cmdId].curEventID = 0;
       m_BakedCmdBufferInfo[cmdId].eventCount = 0;
       m_BakedCmdBufferInfo[cmdId].drawCount = 0;
+      m_BakedCmdBufferInfo[cmdId].boundPipelines.clear();
 
       m_BakedCmdBufferInfo[cmdId].drawStack.push_back(draw);
     }
@@ -642,6 +713,12 @@ VkResult WrappedVulkan::vkBeginCommandBuffer(VkCommandBuffer commandBuffer,
     record->bakedCommands->cmdInfo->device = record->cmdInfo->device;
     record->bakedCommands->cmdInfo->allocInfo = record->cmdInfo->allocInfo;
 
+    // decide once per recording whether this command buffer is tracked, so that a capture being
+    // queued part-way through doesn't leave it half-recorded.
+    record->cmdInfo->untracked = RenderDoc::Inst().IsIdleTrackingSuspended();
+    record->bakedCommands->cmdInfo->untracked = record->cmdInfo->untracked;
+
+    if(!record->cmdInfo->untracked)
     {
       CACHE_THREAD_SERIALISER();
 
@@ -651,7 +728,7 @@ VkResult WrappedVulkan::vkBeginCommandBuffer(VkCommandBuffer commandBuffer,
       record->AddChunk(scope.Get());
     }
 
-    if(pBeginInfo->pInheritanceInfo)
+    if(pBeginInfo->pInheritanceInfo && !record->cmdInfo->untracked)
     {
       record->MarkResourceFrameReferenced(GetResID(pBeginInfo->pInheritanceInfo->renderPass),
                                           eFrameRef_Read);
@@ -764,6 +841,8 @@ bool WrappedVulkan::Serialise_vkEndCommandBuffer(Serialiser *localSerialiser,
       m_BakedCmdBufferInfo[bakeId].curEventID = 0;
       m_BakedCmdBufferInfo[bakeId].eventCount = m_BakedCmdBufferInfo[m_LastCmdBufferID].curEventID;
       m_BakedCmdBufferInfo[bakeId].drawCount = m_BakedCmdBufferInfo[m_LastCmdBufferID].drawCount;
+      m_BakedCmdBufferInfo[bakeId].boundPipelines.swap(
+          m_BakedCmdBufferInfo[m_LastCmdBufferID].boundPipelines);
 
       m_BakedCmdBufferInfo[m_LastCmdBufferID].draw = NULL;
       m_BakedCmdBufferInfo[m_LastCmdBufferID].curEventID = 0;
@@ -785,6 +864,7 @@ VkResult WrappedVulkan::vkEndCommandBuffer(VkCommandBuffer commandBuffer)
     // ensure that we have a matching begin
     RDCASSERT(record->bakedCommands);
 
+    if(!record->cmdInfo->untracked)
     {
       CACHE_THREAD_SERIALISER();
 
@@ -794,6 +874,10 @@ VkResult WrappedVulkan::vkEndCommandBuffer(VkCommandBuffer commandBuffer)
       record->AddChunk(scope.Get());
     }
 
+    // the commands are ordered against other chunks (e.g. the submit) from the point they're
+    // finished
+    record->AssignDeferredChunkIDs();
+
     record->Bake();
   }
 
@@ -915,13 +999,16 @@ void WrappedVulkan::vkCmdBeginRenderPass(VkCommandBuffer commandBuffer,
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(BEGIN_RENDERPASS);
-    Serialise_vkCmdBeginRenderPass(localSerialiser, commandBuffer, pRenderPassBegin, contents);
+      SCOPED_SERIALISE_CONTEXT(BEGIN_RENDERPASS);
+      Serialise_vkCmdBeginRenderPass(localSerialiser, commandBuffer, pRenderPassBegin, contents);
 
-    record->AddChunk(scope.Get());
-    record->MarkResourceFrameReferenced(GetResID(pRenderPassBegin->renderPass), eFrameRef_Read);
+      record->AddChunk(scope.Get());
+      record->MarkResourceFrameReferenced(GetResID(pRenderPassBegin->renderPass), eFrameRef_Read);
+    }
 
     VkResourceRecord *fb = GetRecord(pRenderPassBegin->framebuffer);
 
@@ -1012,12 +1099,15 @@ void WrappedVulkan::vkCmdNextSubpass(VkCommandBuffer commandBuffer, VkSubpassCon
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(NEXT_SUBPASS);
-    Serialise_vkCmdNextSubpass(localSerialiser, commandBuffer, contents);
+      SCOPED_SERIALISE_CONTEXT(NEXT_SUBPASS);
+      Serialise_vkCmdNextSubpass(localSerialiser, commandBuffer, contents);
 
-    record->AddChunk(scope.Get());
+      record->AddChunk(scope.Get());
+    }
   }
 }
 
@@ -1089,12 +1179,15 @@ void WrappedVulkan::vkCmdEndRenderPass(VkCommandBuffer commandBuffer)
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(END_RENDERPASS);
-    Serialise_vkCmdEndRenderPass(localSerialiser, commandBuffer);
+      SCOPED_SERIALISE_CONTEXT(END_RENDERPASS);
+      Serialise_vkCmdEndRenderPass(localSerialiser, commandBuffer);
 
-    record->AddChunk(scope.Get());
+      record->AddChunk(scope.Get());
+    }
 
     VkResourceRecord *fb = record->cmdInfo->framebuffer;
 
@@ -1109,11 +1202,8 @@ void WrappedVulkan::vkCmdEndRenderPass(VkCommandBuffer commandBuffer)
     }
 
     // apply the implicit layout transitions here
-    {
-      SCOPED_LOCK(m_ImageLayoutsLock);
-      GetResourceManager()->RecordBarriers(GetRecord(commandBuffer)->cmdInfo->imgbarriers,
-                                           m_ImageLayouts, (uint32_t)barriers.size(), &barriers[0]);
-    }
+    if(!barriers.empty())
+      RecordCmdImageBarriers(record, (uint32_t)barriers.size(), &barriers[0]);
   }
 }
 
@@ -1199,6 +1289,7 @@ bool WrappedVulkan::Serialise_vkCmdBindPipeline(Serialiser *localSerialiser,
 
     // track while reading, as we need to bind current topology & index byte width in AddDrawcall
     m_BakedCmdBufferInfo[m_LastCmdBufferID].state.pipeline = GetResID(pipeline);
+    m_BakedCmdBufferInfo[m_LastCmdBufferID].boundPipelines.insert(GetResID(pipeline));
 
     ObjDisp(commandBuffer)->CmdBindPipeline(Unwrap(commandBuffer), bind, Unwrap(pipeline));
   }
@@ -1217,13 +1308,16 @@ void WrappedVulkan::vkCmdBindPipeline(VkCommandBuffer commandBuffer,
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(BIND_PIPELINE);
-    Serialise_vkCmdBindPipeline(localSerialiser, commandBuffer, pipelineBindPoint, pipeline);
+      SCOPED_SERIALISE_CONTEXT(BIND_PIPELINE);
+      Serialise_vkCmdBindPipeline(localSerialiser, commandBuffer, pipelineBindPoint, pipeline);
 
-    record->AddChunk(scope.Get());
-    record->MarkResourceFrameReferenced(GetResID(pipeline), eFrameRef_Read);
+      record->AddChunk(scope.Get());
+      record->MarkResourceFrameReferenced(GetResID(pipeline), eFrameRef_Read);
+    }
   }
 }
 
@@ -1402,16 +1496,19 @@ void WrappedVulkan::vkCmdBindDescriptorSets(VkCommandBuffer commandBuffer,
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(BIND_DESCRIPTOR_SET);
-    Serialise_vkCmdBindDescriptorSets(localSerialiser, commandBuffer, pipelineBindPoint, layout,
-                                      firstSet, setCount, pDescriptorSets, dynamicOffsetCount,
-                                      pDynamicOffsets);
+      SCOPED_SERIALISE_CONTEXT(BIND_DESCRIPTOR_SET);
+      Serialise_vkCmdBindDescriptorSets(localSerialiser, commandBuffer, pipelineBindPoint, layout,
+                                        firstSet, setCount, pDescriptorSets, dynamicOffsetCount,
+                                        pDynamicOffsets);
 
-    record->AddChunk(scope.Get());
-    record->MarkResourceFrameReferenced(GetResID(layout), eFrameRef_Read);
-    record->cmdInfo->boundDescSets.insert(pDescriptorSets, pDescriptorSets + setCount);
+      record->AddChunk(scope.Get());
+      record->MarkResourceFrameReferenced(GetResID(layout), eFrameRef_Read);
+      record->cmdInfo->boundDescSets.insert(pDescriptorSets, pDescriptorSets + setCount);
+    }
 
     // conservatively mark all writeable objects in the descriptor set as dirty here.
     // Technically not all might be written although that required verifying what the
@@ -1423,7 +1520,7 @@ void WrappedVulkan::vkCmdBindDescriptorSets(VkCommandBuffer commandBuffer,
     {
       VkResourceRecord *descSet = GetRecord(pDescriptorSets[i]);
 
-      map<ResourceId, pair<uint32_t, FrameRefType> > &frameRefs = descSet->descInfo->bindFrameRefs;
+      ResourceIdMap<pair<uint32_t, FrameRefType> > &frameRefs = descSet->descInfo->bindFrameRefs;
 
       for(auto it = frameRefs.begin(); it != frameRefs.end(); ++it)
       {
@@ -1528,13 +1625,17 @@ void WrappedVulkan::vkCmdBindVertexBuffers(VkCommandBuffer commandBuffer, uint32
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
+
+      SCOPED_SERIALISE_CONTEXT(BIND_VERTEX_BUFFERS);
+      Serialise_vkCmdBindVertexBuffers(localSerialiser, commandBuffer, firstBinding, bindingCount,
+                                       pBuffers, pOffsets);
 
-    SCOPED_SERIALISE_CONTEXT(BIND_VERTEX_BUFFERS);
-    Serialise_vkCmdBindVertexBuffers(localSerialiser, commandBuffer, firstBinding, bindingCount,
-                                     pBuffers, pOffsets);
+      record->AddChunk(scope.Get());
+    }
 
-    record->AddChunk(scope.Get());
     for(uint32_t i = 0; i < bindingCount; i++)
     {
       record->MarkResourceFrameReferenced(GetResID(pBuffers[i]), eFrameRef_Read);
@@ -1602,14 +1703,18 @@ void WrappedVulkan::vkCmdBindIndexBuffer(VkCommandBuffer commandBuffer, VkBuffer
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
+
+      SCOPED_SERIALISE_CONTEXT(BIND_INDEX_BUFFER);
+      Serialise_vkCmdBindIndexBuffer(localSerialiser, commandBuffer, buffer, offset, indexType);
 
-    SCOPED_SERIALISE_CONTEXT(BIND_INDEX_BUFFER);
-    Serialise_vkCmdBindIndexBuffer(localSerialiser, commandBuffer, buffer, offset, indexType);
+      record->AddChunk(scope.Get());
+      record->MarkResourceFrameReferenced(GetResID(buffer), eFrameRef_Read);
+      record->MarkResourceFrameReferenced(GetRecord(buffer)->baseResource, eFrameRef_Read);
+    }
 
-    record->AddChunk(scope.Get());
-    record->MarkResourceFrameReferenced(GetResID(buffer), eFrameRef_Read);
-    record->MarkResourceFrameReferenced(GetRecord(buffer)->baseResource, eFrameRef_Read);
     if(GetRecord(buffer)->sparseInfo)
       record->cmdInfo->sparse.insert(GetRecord(buffer)->sparseInfo);
   }
@@ -1670,13 +1775,16 @@ void WrappedVulkan::vkCmdUpdateBuffer(VkCommandBuffer commandBuffer, VkBuffer de
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(UPDATE_BUF);
-    Serialise_vkCmdUpdateBuffer(localSerialiser, commandBuffer, destBuffer, destOffset, dataSize,
-                                pData);
+      SCOPED_SERIALISE_CONTEXT(UPDATE_BUF);
+      Serialise_vkCmdUpdateBuffer(localSerialiser, commandBuffer, destBuffer, destOffset, dataSize,
+                                  pData);
 
-    record->AddChunk(scope.Get());
+      record->AddChunk(scope.Get());
+    }
 
     VkResourceRecord *buf = GetRecord(destBuffer);
 
@@ -1739,12 +1847,16 @@ void WrappedVulkan::vkCmdFillBuffer(VkCommandBuffer commandBuffer, VkBuffer dest
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(FILL_BUF);
-    Serialise_vkCmdFillBuffer(localSerialiser, commandBuffer, destBuffer, destOffset, fillSize, data);
+      SCOPED_SERIALISE_CONTEXT(FILL_BUF);
+      Serialise_vkCmdFillBuffer(localSerialiser, commandBuffer, destBuffer, destOffset, fillSize,
+                                data);
 
-    record->AddChunk(scope.Get());
+      record->AddChunk(scope.Get());
+    }
 
     VkResourceRecord *buf = GetRecord(destBuffer);
 
@@ -1816,14 +1928,17 @@ void WrappedVulkan::vkCmdPushConstants(VkCommandBuffer commandBuffer, VkPipeline
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(PUSH_CONST);
-    Serialise_vkCmdPushConstants(localSerialiser, commandBuffer, layout, stageFlags, start, length,
-                                 values);
+      SCOPED_SERIALISE_CONTEXT(PUSH_CONST);
+      Serialise_vkCmdPushConstants(localSerialiser, commandBuffer, layout, stageFlags, start,
+                                   length, values);
 
-    record->AddChunk(scope.Get());
-    record->MarkResourceFrameReferenced(GetResID(layout), eFrameRef_Read);
+      record->AddChunk(scope.Get());
+      record->MarkResourceFrameReferenced(GetResID(layout), eFrameRef_Read);
+    }
   }
 }
 
@@ -1964,23 +2079,21 @@ void WrappedVulkan::vkCmdPipelineBarrier(
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(PIPELINE_BARRIER);
-    Serialise_vkCmdPipelineBarrier(localSerialiser, commandBuffer, srcStageMask, destStageMask,
-                                   dependencyFlags, memoryBarrierCount, pMemoryBarriers,
-                                   bufferMemoryBarrierCount, pBufferMemoryBarriers,
-                                   imageMemoryBarrierCount, pImageMemoryBarriers);
+      SCOPED_SERIALISE_CONTEXT(PIPELINE_BARRIER);
+      Serialise_vkCmdPipelineBarrier(localSerialiser, commandBuffer, srcStageMask, destStageMask,
+                                     dependencyFlags, memoryBarrierCount, pMemoryBarriers,
+                                     bufferMemoryBarrierCount, pBufferMemoryBarriers,
+                                     imageMemoryBarrierCount, pImageMemoryBarriers);
 
-    record->AddChunk(scope.Get());
+      record->AddChunk(scope.Get());
+    }
 
     if(imageMemoryBarrierCount > 0)
-    {
-      SCOPED_LOCK(m_ImageLayoutsLock);
-      GetResourceManager()->RecordBarriers(GetRecord(commandBuffer)->cmdInfo->imgbarriers,
-                                           m_ImageLayouts, imageMemoryBarrierCount,
-                                           pImageMemoryBarriers);
-    }
+      RecordCmdImageBarriers(record, imageMemoryBarrierCount, pImageMemoryBarriers);
   }
 }
 
@@ -2033,12 +2146,16 @@ void WrappedVulkan::vkCmdWriteTimestamp(VkCommandBuffer commandBuffer,
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(WRITE_TIMESTAMP);
-    Serialise_vkCmdWriteTimestamp(localSerialiser, commandBuffer, pipelineStage, queryPool, query);
+      SCOPED_SERIALISE_CONTEXT(WRITE_TIMESTAMP);
+      Serialise_vkCmdWriteTimestamp(localSerialiser, commandBuffer, pipelineStage, queryPool,
+                                    query);
 
-    record->AddChunk(scope.Get());
+      record->AddChunk(scope.Get());
+    }
 
     record->MarkResourceFrameReferenced(GetResID(queryPool), eFrameRef_Read);
   }
@@ -2105,14 +2222,17 @@ void WrappedVulkan::vkCmdCopyQueryPoolResults(VkCommandBuffer commandBuffer, VkQ
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(COPY_QUERY_RESULTS);
-    Serialise_vkCmdCopyQueryPoolResults(localSerialiser, commandBuffer, queryPool, firstQuery,
-                                        queryCount, destBuffer, destOffset, destStride, flags);
+      SCOPED_SERIALISE_CONTEXT(COPY_QUERY_RESULTS);
+      Serialise_vkCmdCopyQueryPoolResults(localSerialiser, commandBuffer, queryPool, firstQuery,
+                                          queryCount, destBuffer, destOffset, destStride, flags);
 
-    record->AddChunk(scope.Get());
-    record->MarkResourceFrameReferenced(GetResID(queryPool), eFrameRef_Read);
+      record->AddChunk(scope.Get());
+      record->MarkResourceFrameReferenced(GetResID(queryPool), eFrameRef_Read);
+    }
 
     VkResourceRecord *buf = GetRecord(destBuffer);
 
@@ -2174,13 +2294,16 @@ void WrappedVulkan::vkCmdBeginQuery(VkCommandBuffer commandBuffer, VkQueryPool q
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(BEGIN_QUERY);
-    Serialise_vkCmdBeginQuery(localSerialiser, commandBuffer, queryPool, query, flags);
+      SCOPED_SERIALISE_CONTEXT(BEGIN_QUERY);
+      Serialise_vkCmdBeginQuery(localSerialiser, commandBuffer, queryPool, query, flags);
 
-    record->AddChunk(scope.Get());
-    record->MarkResourceFrameReferenced(GetResID(queryPool), eFrameRef_Read);
+      record->AddChunk(scope.Get());
+      record->MarkResourceFrameReferenced(GetResID(queryPool), eFrameRef_Read);
+    }
   }
 }
 
@@ -2228,13 +2351,16 @@ void WrappedVulkan::vkCmdEndQuery(VkCommandBuffer commandBuffer, VkQueryPool que
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(END_QUERY);
-    Serialise_vkCmdEndQuery(localSerialiser, commandBuffer, queryPool, query);
+      SCOPED_SERIALISE_CONTEXT(END_QUERY);
+      Serialise_vkCmdEndQuery(localSerialiser, commandBuffer, queryPool, query);
 
-    record->AddChunk(scope.Get());
-    record->MarkResourceFrameReferenced(GetResID(queryPool), eFrameRef_Read);
+      record->AddChunk(scope.Get());
+      record->MarkResourceFrameReferenced(GetResID(queryPool), eFrameRef_Read);
+    }
   }
 }
 
@@ -2286,13 +2412,17 @@ void WrappedVulkan::vkCmdResetQueryPool(VkCommandBuffer commandBuffer, VkQueryPo
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(RESET_QUERY_POOL);
-    Serialise_vkCmdResetQueryPool(localSerialiser, commandBuffer, queryPool, firstQuery, queryCount);
+      SCOPED_SERIALISE_CONTEXT(RESET_QUERY_POOL);
+      Serialise_vkCmdResetQueryPool(localSerialiser, commandBuffer, queryPool, firstQuery,
+                                    queryCount);
 
-    record->AddChunk(scope.Get());
-    record->MarkResourceFrameReferenced(GetResID(queryPool), eFrameRef_Read);
+      record->AddChunk(scope.Get());
+      record->MarkResourceFrameReferenced(GetResID(queryPool), eFrameRef_Read);
+    }
   }
 }
 
@@ -2592,12 +2722,16 @@ void WrappedVulkan::vkCmdExecuteCommands(VkCommandBuffer commandBuffer, uint32_t
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(EXEC_CMDS);
-    Serialise_vkCmdExecuteCommands(localSerialiser, commandBuffer, commandBufferCount, pCmdBuffers);
+      SCOPED_SERIALISE_CONTEXT(EXEC_CMDS);
+      Serialise_vkCmdExecuteCommands(localSerialiser, commandBuffer, commandBufferCount,
+                                     pCmdBuffers);
 
-    record->AddChunk(scope.Get());
+      record->AddChunk(scope.Get());
+    }
 
     for(uint32_t i = 0; i < commandBufferCount; i++)
     {
@@ -2662,12 +2796,15 @@ void WrappedVulkan::vkCmdDebugMarkerBeginEXT(VkCommandBuffer commandBuffer,
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(BEGIN_EVENT);
-    Serialise_vkCmdDebugMarkerBeginEXT(localSerialiser, commandBuffer, pMarker);
+      SCOPED_SERIALISE_CONTEXT(BEGIN_EVENT);
+      Serialise_vkCmdDebugMarkerBeginEXT(localSerialiser, commandBuffer, pMarker);
 
-    record->AddChunk(scope.Get());
+      record->AddChunk(scope.Get());
+    }
   }
 }
 
@@ -2711,12 +2848,15 @@ void WrappedVulkan::vkCmdDebugMarkerEndEXT(VkCommandBuffer commandBuffer)
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(END_EVENT);
-    Serialise_vkCmdDebugMarkerEndEXT(localSerialiser, commandBuffer);
+      SCOPED_SERIALISE_CONTEXT(END_EVENT);
+      Serialise_vkCmdDebugMarkerEndEXT(localSerialiser, commandBuffer);
 
-    record->AddChunk(scope.Get());
+      record->AddChunk(scope.Get());
+    }
   }
 }
 
@@ -2764,11 +2904,14 @@ void WrappedVulkan::vkCmdDebugMarkerInsertEXT(VkCommandBuffer commandBuffer,
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(SET_MARKER);
-    Serialise_vkCmdDebugMarkerInsertEXT(localSerialiser, commandBuffer, pMarker);
+      SCOPED_SERIALISE_CONTEXT(SET_MARKER);
+      Serialise_vkCmdDebugMarkerInsertEXT(localSerialiser, commandBuffer, pMarker);
 
-    record->AddChunk(scope.Get());
+      record->AddChunk(scope.Get());
+    }
   }
 }
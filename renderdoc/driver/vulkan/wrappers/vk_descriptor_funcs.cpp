@@ -381,6 +381,152 @@ VkResult WrappedVulkan::vkResetDescriptorPool(VkDevice device, VkDescriptorPool
   return ObjDisp(device)->ResetDescriptorPool(Unwrap(device), Unwrap(descriptorPool), flags);
 }
 
+void WrappedVulkan::ReplayDescriptorSetWrite(VkDevice device,
+                                             const VkWriteDescriptorSet &writeDesc)
+{
+  // check for validity - if a resource wasn't referenced other than in this update
+  // (ie. the descriptor set was overwritten or never bound), then the write descriptor
+  // will be invalid with some missing handles. It's safe though to just skip this
+  // update as we only get here if it's never used.
+
+  // if a set was never bound, it will have been omitted and we just drop any writes to it
+  bool valid = (writeDesc.dstSet != VK_NULL_HANDLE);
+
+  if(!valid)
+    return;
+
+  ResourceId setId = GetResourceManager()->GetNonDispWrapper(writeDesc.dstSet)->id;
+
+  const DescSetLayout &layout = m_CreationInfo.m_DescSetLayout[m_DescriptorSetState[setId].layout];
+
+  const DescSetLayout::Binding *layoutBinding = &layout.bindings[writeDesc.dstBinding];
+  uint32_t curIdx = writeDesc.dstArrayElement;
+
+  switch(writeDesc.descriptorType)
+  {
+    case VK_DESCRIPTOR_TYPE_SAMPLER:
+    {
+      for(uint32_t i = 0; i < writeDesc.descriptorCount; i++)
+        valid &= (writeDesc.pImageInfo[i].sampler != VK_NULL_HANDLE);
+      break;
+    }
+    case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+    {
+      for(uint32_t i = 0; i < writeDesc.descriptorCount; i++, curIdx++)
+      {
+        // allow consecutive descriptor bind updates. See vkUpdateDescriptorSets for more
+        // explanation
+        if(curIdx >= layoutBinding->descriptorCount)
+        {
+          layoutBinding++;
+          curIdx = 0;
+        }
+
+        valid &= (writeDesc.pImageInfo[i].sampler != VK_NULL_HANDLE) ||
+                 (layoutBinding->immutableSampler &&
+                  layoutBinding->immutableSampler[curIdx] != ResourceId());
+        valid &= (writeDesc.pImageInfo[i].imageView != VK_NULL_HANDLE);
+      }
+      break;
+    }
+    case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+    case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+    case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+    {
+      for(uint32_t i = 0; i < writeDesc.descriptorCount; i++)
+        valid &= (writeDesc.pImageInfo[i].imageView != VK_NULL_HANDLE);
+      break;
+    }
+    case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+    case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+    {
+      for(uint32_t i = 0; i < writeDesc.descriptorCount; i++)
+        valid &= (writeDesc.pTexelBufferView[i] != VK_NULL_HANDLE);
+      break;
+    }
+    case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+    case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+    case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+    case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+    {
+      for(uint32_t i = 0; i < writeDesc.descriptorCount; i++)
+        valid &= (writeDesc.pBufferInfo[i].buffer != VK_NULL_HANDLE);
+      break;
+    }
+    default: RDCERR("Unexpected descriptor type %d", writeDesc.descriptorType);
+  }
+
+  if(valid)
+  {
+    ObjDisp(device)->UpdateDescriptorSets(Unwrap(device), 1, &writeDesc, 0, NULL);
+
+    // update our local tracking
+    vector<DescriptorSetSlot *> &bindings = m_DescriptorSetState[setId].currentBindings;
+
+    {
+      RDCASSERT(writeDesc.dstBinding < bindings.size());
+
+      DescriptorSetSlot **bind = &bindings[writeDesc.dstBinding];
+      layoutBinding = &layout.bindings[writeDesc.dstBinding];
+      curIdx = writeDesc.dstArrayElement;
+
+      if(writeDesc.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER ||
+         writeDesc.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER)
+      {
+        for(uint32_t d = 0; d < writeDesc.descriptorCount; d++, curIdx++)
+        {
+          // allow consecutive descriptor bind updates. See vkUpdateDescriptorSets for more
+          // explanation
+          if(curIdx >= layoutBinding->descriptorCount)
+          {
+            layoutBinding++;
+            bind++;
+            curIdx = 0;
+          }
+
+          (*bind)[curIdx].texelBufferView = writeDesc.pTexelBufferView[d];
+        }
+      }
+      else if(writeDesc.descriptorType == VK_DESCRIPTOR_TYPE_SAMPLER ||
+              writeDesc.descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER ||
+              writeDesc.descriptorType == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE ||
+              writeDesc.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE ||
+              writeDesc.descriptorType == VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT)
+      {
+        for(uint32_t d = 0; d < writeDesc.descriptorCount; d++, curIdx++)
+        {
+          // allow consecutive descriptor bind updates. See vkUpdateDescriptorSets for more
+          // explanation
+          if(curIdx >= layoutBinding->descriptorCount)
+          {
+            layoutBinding++;
+            bind++;
+            curIdx = 0;
+          }
+
+          (*bind)[curIdx].imageInfo = writeDesc.pImageInfo[d];
+        }
+      }
+      else
+      {
+        for(uint32_t d = 0; d < writeDesc.descriptorCount; d++, curIdx++)
+        {
+          // allow consecutive descriptor bind updates. See vkUpdateDescriptorSets for more
+          // explanation
+          if(curIdx >= layoutBinding->descriptorCount)
+          {
+            layoutBinding++;
+            bind++;
+            curIdx = 0;
+          }
+
+          (*bind)[curIdx].bufferInfo = writeDesc.pBufferInfo[d];
+        }
+      }
+    }
+  }
+}
+
 bool WrappedVulkan::Serialise_vkUpdateDescriptorSets(Serialiser *localSerialiser, VkDevice device,
                                                      uint32_t writeCount,
                                                      const VkWriteDescriptorSet *pDescriptorWrites,
@@ -415,149 +561,7 @@ bool WrappedVulkan::Serialise_vkUpdateDescriptorSets(Serialiser *localSerialiser
 
     if(writes)
     {
-      // check for validity - if a resource wasn't referenced other than in this update
-      // (ie. the descriptor set was overwritten or never bound), then the write descriptor
-      // will be invalid with some missing handles. It's safe though to just skip this
-      // update as we only get here if it's never used.
-
-      // if a set was never bound, it will have been omitted and we just drop any writes to it
-      bool valid = (writeDesc.dstSet != VK_NULL_HANDLE);
-
-      if(!valid)
-        return true;
-
-      const DescSetLayout &layout =
-          m_CreationInfo.m_DescSetLayout
-              [m_DescriptorSetState[GetResourceManager()->GetNonDispWrapper(writeDesc.dstSet)->id].layout];
-
-      const DescSetLayout::Binding *layoutBinding = &layout.bindings[writeDesc.dstBinding];
-      uint32_t curIdx = writeDesc.dstArrayElement;
-
-      switch(writeDesc.descriptorType)
-      {
-        case VK_DESCRIPTOR_TYPE_SAMPLER:
-        {
-          for(uint32_t i = 0; i < writeDesc.descriptorCount; i++)
-            valid &= (writeDesc.pImageInfo[i].sampler != VK_NULL_HANDLE);
-          break;
-        }
-        case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
-        {
-          for(uint32_t i = 0; i < writeDesc.descriptorCount; i++, curIdx++)
-          {
-            // allow consecutive descriptor bind updates. See vkUpdateDescriptorSets for more
-            // explanation
-            if(curIdx >= layoutBinding->descriptorCount)
-            {
-              layoutBinding++;
-              curIdx = 0;
-            }
-
-            valid &= (writeDesc.pImageInfo[i].sampler != VK_NULL_HANDLE) ||
-                     (layoutBinding->immutableSampler &&
-                      layoutBinding->immutableSampler[curIdx] != ResourceId());
-            valid &= (writeDesc.pImageInfo[i].imageView != VK_NULL_HANDLE);
-          }
-          break;
-        }
-        case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
-        case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
-        case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
-        {
-          for(uint32_t i = 0; i < writeDesc.descriptorCount; i++)
-            valid &= (writeDesc.pImageInfo[i].imageView != VK_NULL_HANDLE);
-          break;
-        }
-        case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
-        case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
-        {
-          for(uint32_t i = 0; i < writeDesc.descriptorCount; i++)
-            valid &= (writeDesc.pTexelBufferView[i] != VK_NULL_HANDLE);
-          break;
-        }
-        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
-        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
-        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
-        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
-        {
-          for(uint32_t i = 0; i < writeDesc.descriptorCount; i++)
-            valid &= (writeDesc.pBufferInfo[i].buffer != VK_NULL_HANDLE);
-          break;
-        }
-        default: RDCERR("Unexpected descriptor type %d", writeDesc.descriptorType);
-      }
-
-      if(valid)
-      {
-        ObjDisp(device)->UpdateDescriptorSets(Unwrap(device), 1, &writeDesc, 0, NULL);
-
-        // update our local tracking
-        vector<DescriptorSetSlot *> &bindings =
-            m_DescriptorSetState[GetResourceManager()->GetNonDispWrapper(writeDesc.dstSet)->id]
-                .currentBindings;
-
-        {
-          RDCASSERT(writeDesc.dstBinding < bindings.size());
-
-          DescriptorSetSlot **bind = &bindings[writeDesc.dstBinding];
-          layoutBinding = &layout.bindings[writeDesc.dstBinding];
-          curIdx = writeDesc.dstArrayElement;
-
-          if(writeDesc.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER ||
-             writeDesc.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER)
-          {
-            for(uint32_t d = 0; d < writeDesc.descriptorCount; d++, curIdx++)
-            {
-              // allow consecutive descriptor bind updates. See vkUpdateDescriptorSets for more
-              // explanation
-              if(curIdx >= layoutBinding->descriptorCount)
-              {
-                layoutBinding++;
-                bind++;
-                curIdx = 0;
-              }
-
-              (*bind)[curIdx].texelBufferView = writeDesc.pTexelBufferView[d];
-            }
-          }
-          else if(writeDesc.descriptorType == VK_DESCRIPTOR_TYPE_SAMPLER ||
-                  writeDesc.descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER ||
-                  writeDesc.descriptorType == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE ||
-                  writeDesc.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE ||
-                  writeDesc.descriptorType == VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT)
-          {
-            for(uint32_t d = 0; d < writeDesc.descriptorCount; d++, curIdx++)
-            {
-              // allow consecutive descriptor bind updates. See vkUpdateDescriptorSets for more
-              // explanation
-              if(curIdx >= layoutBinding->descriptorCount)
-              {
-                layoutBinding++;
-                bind++;
-                curIdx = 0;
-              }
-
-              (*bind)[curIdx].imageInfo = writeDesc.pImageInfo[d];
-            }
-          }
-          else
-          {
-            for(uint32_t d = 0; d < writeDesc.descriptorCount; d++, curIdx++)
-            {
-              // allow consecutive descriptor bind updates. See vkUpdateDescriptorSets for more
-              // explanation
-              if(curIdx >= layoutBinding->descriptorCount)
-              {
-                layoutBinding++;
-                bind++;
-                curIdx = 0;
-              }
-
-              (*bind)[curIdx].bufferInfo = writeDesc.pBufferInfo[d];
-            }
-          }
-        }
-      }
+      ReplayDescriptorSetWrite(device, writeDesc);
     }
     else
     {
@@ -627,6 +631,122 @@ bool WrappedVulkan::Serialise_vkUpdateDescriptorSets(Serialiser *localSerialiser
   return true;
 }
 
+static FrameRefType DescriptorFrameRef(VkDescriptorType type)
+{
+  switch(type)
+  {
+    case VK_DESCRIPTOR_TYPE_SAMPLER:
+    case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+    case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+    case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+    case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+    case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+    case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT: return eFrameRef_Read;
+    case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+    case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+    case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+    case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC: return eFrameRef_Write;
+    default: RDCERR("Unexpected descriptor type");
+  }
+
+  return eFrameRef_Write;
+}
+
+void WrappedVulkan::UpdateTrackedDescriptor(VkResourceRecord *record, DescriptorSetSlot &bind,
+                                            VkDescriptorType type, FrameRefType ref,
+                                            const void *descriptor)
+{
+  if(bind.texelBufferView != VK_NULL_HANDLE)
+  {
+    record->RemoveBindFrameRef(GetResID(bind.texelBufferView));
+
+    VkResourceRecord *viewRecord = GetRecord(bind.texelBufferView);
+    if(viewRecord && viewRecord->baseResource != ResourceId())
+      record->RemoveBindFrameRef(viewRecord->baseResource);
+  }
+  if(bind.imageInfo.imageView != VK_NULL_HANDLE)
+  {
+    record->RemoveBindFrameRef(GetResID(bind.imageInfo.imageView));
+
+    VkResourceRecord *viewRecord = GetRecord(bind.imageInfo.imageView);
+    if(viewRecord)
+    {
+      record->RemoveBindFrameRef(viewRecord->baseResource);
+      if(viewRecord->baseResourceMem != ResourceId())
+        record->RemoveBindFrameRef(viewRecord->baseResourceMem);
+    }
+  }
+  if(bind.imageInfo.sampler != VK_NULL_HANDLE)
+  {
+    record->RemoveBindFrameRef(GetResID(bind.imageInfo.sampler));
+  }
+  if(bind.bufferInfo.buffer != VK_NULL_HANDLE)
+  {
+    record->RemoveBindFrameRef(GetResID(bind.bufferInfo.buffer));
+
+    VkResourceRecord *bufRecord = GetRecord(bind.bufferInfo.buffer);
+    if(bufRecord && bufRecord->baseResource != ResourceId())
+      record->RemoveBindFrameRef(bufRecord->baseResource);
+  }
+
+  // NULL everything out now so that we don't accidentally reference an object
+  // that was removed already
+  bind.texelBufferView = VK_NULL_HANDLE;
+  bind.bufferInfo.buffer = VK_NULL_HANDLE;
+  bind.imageInfo.imageView = VK_NULL_HANDLE;
+  bind.imageInfo.sampler = VK_NULL_HANDLE;
+
+  if(type == VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER ||
+     type == VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER)
+  {
+    bind.texelBufferView = *(const VkBufferView *)descriptor;
+  }
+  else if(type == VK_DESCRIPTOR_TYPE_SAMPLER || type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER ||
+          type == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE || type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE ||
+          type == VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT)
+  {
+    bind.imageInfo = *(const VkDescriptorImageInfo *)descriptor;
+
+    // ignore descriptors not part of the write, by NULL'ing out those members
+    // as they might not even point to a valid object
+    if(type == VK_DESCRIPTOR_TYPE_SAMPLER)
+      bind.imageInfo.imageView = VK_NULL_HANDLE;
+    else if(type != VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
+      bind.imageInfo.sampler = VK_NULL_HANDLE;
+  }
+  else
+  {
+    bind.bufferInfo = *(const VkDescriptorBufferInfo *)descriptor;
+  }
+
+  if(bind.texelBufferView != VK_NULL_HANDLE)
+  {
+    record->AddBindFrameRef(GetResID(bind.texelBufferView), eFrameRef_Read,
+                            GetRecord(bind.texelBufferView)->sparseInfo != NULL);
+    if(GetRecord(bind.texelBufferView)->baseResource != ResourceId())
+      record->AddBindFrameRef(GetRecord(bind.texelBufferView)->baseResource, ref);
+  }
+  if(bind.imageInfo.imageView != VK_NULL_HANDLE)
+  {
+    record->AddBindFrameRef(GetResID(bind.imageInfo.imageView), eFrameRef_Read,
+                            GetRecord(bind.imageInfo.imageView)->sparseInfo != NULL);
+    record->AddBindFrameRef(GetRecord(bind.imageInfo.imageView)->baseResource, ref);
+    if(GetRecord(bind.imageInfo.imageView)->baseResourceMem != ResourceId())
+      record->AddBindFrameRef(GetRecord(bind.imageInfo.imageView)->baseResourceMem, eFrameRef_Read);
+  }
+  if(bind.imageInfo.sampler != VK_NULL_HANDLE)
+  {
+    record->AddBindFrameRef(GetResID(bind.imageInfo.sampler), eFrameRef_Read);
+  }
+  if(bind.bufferInfo.buffer != VK_NULL_HANDLE)
+  {
+    record->AddBindFrameRef(GetResID(bind.bufferInfo.buffer), eFrameRef_Read,
+                            GetRecord(bind.bufferInfo.buffer)->sparseInfo != NULL);
+    if(GetRecord(bind.bufferInfo.buffer)->baseResource != ResourceId())
+      record->AddBindFrameRef(GetRecord(bind.bufferInfo.buffer)->baseResource, ref);
+  }
+}
+
 void WrappedVulkan::vkUpdateDescriptorSets(VkDevice device, uint32_t writeCount,
                                            const VkWriteDescriptorSet *pDescriptorWrites,
                                            uint32_t copyCount,
@@ -805,23 +925,7 @@ void WrappedVulkan::vkUpdateDescriptorSets(VkDevice device, uint32_t writeCount,
 
       const DescSetLayout::Binding *layoutBinding = &layout.bindings[pDescriptorWrites[i].dstBinding];
 
-      FrameRefType ref = eFrameRef_Write;
-
-      switch(layoutBinding->descriptorType)
-      {
-        case VK_DESCRIPTOR_TYPE_SAMPLER:
-        case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
-        case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
-        case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
-        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
-        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
-        case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT: ref = eFrameRef_Read; break;
-        case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
-        case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
-        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
-        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC: ref = eFrameRef_Write; break;
-        default: RDCERR("Unexpected descriptor type");
-      }
+      FrameRefType ref = DescriptorFrameRef(layoutBinding->descriptorType);
 
       // We need to handle the cases where these bindings are stale:
       // ie. image handle 0xf00baa is allocated
@@ -861,100 +965,22 @@ void WrappedVulkan::vkUpdateDescriptorSets(VkDevice device, uint32_t writeCount,
           curIdx = 0;
         }
 
-        DescriptorSetSlot &bind = (*binding)[curIdx];
-
-        if(bind.texelBufferView != VK_NULL_HANDLE)
-        {
-          record->RemoveBindFrameRef(GetResID(bind.texelBufferView));
-
-          VkResourceRecord *viewRecord = GetRecord(bind.texelBufferView);
-          if(viewRecord && viewRecord->baseResource != ResourceId())
-            record->RemoveBindFrameRef(viewRecord->baseResource);
-        }
-        if(bind.imageInfo.imageView != VK_NULL_HANDLE)
-        {
-          record->RemoveBindFrameRef(GetResID(bind.imageInfo.imageView));
-
-          VkResourceRecord *viewRecord = GetRecord(bind.imageInfo.imageView);
-          if(viewRecord)
-          {
-            record->RemoveBindFrameRef(viewRecord->baseResource);
-            if(viewRecord->baseResourceMem != ResourceId())
-              record->RemoveBindFrameRef(viewRecord->baseResourceMem);
-          }
-        }
-        if(bind.imageInfo.sampler != VK_NULL_HANDLE)
-        {
-          record->RemoveBindFrameRef(GetResID(bind.imageInfo.sampler));
-        }
-        if(bind.bufferInfo.buffer != VK_NULL_HANDLE)
-        {
-          record->RemoveBindFrameRef(GetResID(bind.bufferInfo.buffer));
-
-          VkResourceRecord *bufRecord = GetRecord(bind.bufferInfo.buffer);
-          if(bufRecord && bufRecord->baseResource != ResourceId())
-            record->RemoveBindFrameRef(bufRecord->baseResource);
-        }
-
-        // NULL everything out now so that we don't accidentally reference an object
-        // that was removed already
-        bind.texelBufferView = VK_NULL_HANDLE;
-        bind.bufferInfo.buffer = VK_NULL_HANDLE;
-        bind.imageInfo.imageView = VK_NULL_HANDLE;
-        bind.imageInfo.sampler = VK_NULL_HANDLE;
+        const void *descriptor = NULL;
 
         if(pDescriptorWrites[i].descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER ||
            pDescriptorWrites[i].descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER)
-        {
-          bind.texelBufferView = pDescriptorWrites[i].pTexelBufferView[d];
-        }
+          descriptor = &pDescriptorWrites[i].pTexelBufferView[d];
         else if(pDescriptorWrites[i].descriptorType == VK_DESCRIPTOR_TYPE_SAMPLER ||
                 pDescriptorWrites[i].descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER ||
                 pDescriptorWrites[i].descriptorType == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE ||
                 pDescriptorWrites[i].descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE ||
                 pDescriptorWrites[i].descriptorType == VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT)
-        {
-          bind.imageInfo = pDescriptorWrites[i].pImageInfo[d];
-
-          // ignore descriptors not part of the write, by NULL'ing out those members
-          // as they might not even point to a valid object
-          if(pDescriptorWrites[i].descriptorType == VK_DESCRIPTOR_TYPE_SAMPLER)
-            bind.imageInfo.imageView = VK_NULL_HANDLE;
-          else if(pDescriptorWrites[i].descriptorType != VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
-            bind.imageInfo.sampler = VK_NULL_HANDLE;
-        }
+          descriptor = &pDescriptorWrites[i].pImageInfo[d];
         else
-        {
-          bind.bufferInfo = pDescriptorWrites[i].pBufferInfo[d];
-        }
+          descriptor = &pDescriptorWrites[i].pBufferInfo[d];
 
-        if(bind.texelBufferView != VK_NULL_HANDLE)
-        {
-          record->AddBindFrameRef(GetResID(bind.texelBufferView), eFrameRef_Read,
-                                  GetRecord(bind.texelBufferView)->sparseInfo != NULL);
-          if(GetRecord(bind.texelBufferView)->baseResource != ResourceId())
-            record->AddBindFrameRef(GetRecord(bind.texelBufferView)->baseResource, ref);
-        }
-        if(bind.imageInfo.imageView != VK_NULL_HANDLE)
-        {
-          record->AddBindFrameRef(GetResID(bind.imageInfo.imageView), eFrameRef_Read,
-                                  GetRecord(bind.imageInfo.imageView)->sparseInfo != NULL);
-          record->AddBindFrameRef(GetRecord(bind.imageInfo.imageView)->baseResource, ref);
-          if(GetRecord(bind.imageInfo.imageView)->baseResourceMem != ResourceId())
-            record->AddBindFrameRef(GetRecord(bind.imageInfo.imageView)->baseResourceMem,
-                                    eFrameRef_Read);
-        }
-        if(bind.imageInfo.sampler != VK_NULL_HANDLE)
-        {
-          record->AddBindFrameRef(GetResID(bind.imageInfo.sampler), eFrameRef_Read);
-        }
-        if(bind.bufferInfo.buffer != VK_NULL_HANDLE)
-        {
-          record->AddBindFrameRef(GetResID(bind.bufferInfo.buffer), eFrameRef_Read,
-                                  GetRecord(bind.bufferInfo.buffer)->sparseInfo != NULL);
-          if(GetRecord(bind.bufferInfo.buffer)->baseResource != ResourceId())
-            record->AddBindFrameRef(GetRecord(bind.bufferInfo.buffer)->baseResource, ref);
-        }
+        UpdateTrackedDescriptor(record, (*binding)[curIdx], pDescriptorWrites[i].descriptorType,
+                                ref, descriptor);
       }
     }
 
@@ -985,23 +1011,7 @@ void WrappedVulkan::vkUpdateDescriptorSets(VkDevice device, uint32_t writeCount,
       const DescSetLayout::Binding *srclayoutBinding =
           &srclayout.bindings[pDescriptorCopies[i].srcBinding];
 
-      FrameRefType ref = eFrameRef_Write;
-
-      switch(dstlayoutBinding->descriptorType)
-      {
-        case VK_DESCRIPTOR_TYPE_SAMPLER:
-        case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
-        case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
-        case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
-        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
-        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
-        case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT: ref = eFrameRef_Read; break;
-        case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
-        case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
-        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
-        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC: ref = eFrameRef_Write; break;
-        default: RDCERR("Unexpected descriptor type");
-      }
+      FrameRefType ref = DescriptorFrameRef(dstlayoutBinding->descriptorType);
 
       // allow roll-over between consecutive bindings. See above in the plain write case for more
       // explanation
@@ -1084,3 +1094,415 @@ void WrappedVulkan::vkUpdateDescriptorSets(VkDevice device, uint32_t writeCount,
     }
   }
 }
+
+// see DescUpdateTemplate::PackedDescriptorSize for the packed layout
+template <typename T>
+static void WritePacked(byte *&dst, const T &val)
+{
+  memcpy(dst, &val, sizeof(T));
+  dst += sizeof(T);
+}
+
+template <typename T>
+static T ReadPacked(const byte *&src)
+{
+  T ret;
+  memcpy(&ret, src, sizeof(T));
+  src += sizeof(T);
+  return ret;
+}
+
+// returns the live unwrapped handle for a packed ID, or VK_NULL_HANDLE if the resource wasn't
+// included in the capture
+template <typename T>
+static T ReadPackedHandle(VulkanResourceManager *rm, const byte *&src)
+{
+  ResourceId id = ReadPacked<ResourceId>(src);
+
+  if(id == ResourceId() || !rm->HasLiveResource(id))
+    return VK_NULL_HANDLE;
+
+  return Unwrap(rm->GetLiveHandle<T>(id));
+}
+
+static void PackTemplateUpdate(const DescUpdateTemplate &info, const void *pData, byte *dst)
+{
+  for(size_t i = 0; i < info.entries.size(); i++)
+  {
+    const VkDescriptorUpdateTemplateEntryKHR &entry = info.entries[i];
+    const byte *src = (const byte *)pData + entry.offset;
+
+    for(uint32_t d = 0; d < entry.descriptorCount; d++, src += entry.stride)
+    {
+      const VkDescriptorImageInfo *imInfo = (const VkDescriptorImageInfo *)src;
+      const VkDescriptorBufferInfo *bufInfo = (const VkDescriptorBufferInfo *)src;
+
+      // only read the members the descriptor type uses, the others could be garbage
+      switch(entry.descriptorType)
+      {
+        case VK_DESCRIPTOR_TYPE_SAMPLER: WritePacked(dst, GetResID(imInfo->sampler)); break;
+        case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+          WritePacked(dst, GetResID(imInfo->sampler));
+          WritePacked(dst, GetResID(imInfo->imageView));
+          WritePacked(dst, imInfo->imageLayout);
+          break;
+        case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+        case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+        case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+          WritePacked(dst, GetResID(imInfo->imageView));
+          WritePacked(dst, imInfo->imageLayout);
+          break;
+        case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+        case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+          WritePacked(dst, GetResID(*(const VkBufferView *)src));
+          break;
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+          WritePacked(dst, GetResID(bufInfo->buffer));
+          WritePacked(dst, bufInfo->offset);
+          WritePacked(dst, bufInfo->range);
+          break;
+        default: RDCERR("Unexpected descriptor type %d", entry.descriptorType);
+      }
+    }
+  }
+}
+
+bool WrappedVulkan::Serialise_vkCreateDescriptorUpdateTemplateKHR(
+    Serialiser *localSerialiser, VkDevice device,
+    const VkDescriptorUpdateTemplateCreateInfoKHR *pCreateInfo,
+    const VkAllocationCallbacks *pAllocator,
+    VkDescriptorUpdateTemplateKHR *pDescriptorUpdateTemplate)
+{
+  SERIALISE_ELEMENT(ResourceId, devId, GetResID(device));
+  SERIALISE_ELEMENT(VkDescriptorUpdateTemplateCreateInfoKHR, info, *pCreateInfo);
+  SERIALISE_ELEMENT(ResourceId, id, GetResID(*pDescriptorUpdateTemplate));
+
+  if(m_State == READING)
+  {
+    VkDescriptorUpdateTemplateKHR templ = VK_NULL_HANDLE;
+
+    device = GetResourceManager()->GetLiveHandle<VkDevice>(devId);
+
+    VkResult ret =
+        ObjDisp(device)->CreateDescriptorUpdateTemplateKHR(Unwrap(device), &info, NULL, &templ);
+
+    if(ret != VK_SUCCESS)
+    {
+      RDCERR("Failed on resource serialise-creation, VkResult: 0x%08x", ret);
+    }
+    else
+    {
+      ResourceId live = GetResourceManager()->WrapResource(Unwrap(device), templ);
+      GetResourceManager()->AddLiveResource(id, templ);
+
+      m_CreationInfo.m_DescUpdateTemplate[live].Init(GetResourceManager(), m_CreationInfo, &info);
+    }
+  }
+
+  return true;
+}
+
+VkResult WrappedVulkan::vkCreateDescriptorUpdateTemplateKHR(
+    VkDevice device, const VkDescriptorUpdateTemplateCreateInfoKHR *pCreateInfo,
+    const VkAllocationCallbacks *pAllocator,
+    VkDescriptorUpdateTemplateKHR *pDescriptorUpdateTemplate)
+{
+  VkDescriptorUpdateTemplateCreateInfoKHR unwrapped = *pCreateInfo;
+  unwrapped.descriptorSetLayout = Unwrap(unwrapped.descriptorSetLayout);
+  unwrapped.pipelineLayout = Unwrap(unwrapped.pipelineLayout);
+
+  VkResult ret = ObjDisp(device)->CreateDescriptorUpdateTemplateKHR(
+      Unwrap(device), &unwrapped, pAllocator, pDescriptorUpdateTemplate);
+
+  if(ret == VK_SUCCESS)
+  {
+    ResourceId id = GetResourceManager()->WrapResource(Unwrap(device), *pDescriptorUpdateTemplate);
+
+    if(m_State >= WRITING)
+    {
+      Chunk *chunk = NULL;
+
+      {
+        CACHE_THREAD_SERIALISER();
+
+        SCOPED_SERIALISE_CONTEXT(CREATE_DESCRIPTOR_UPDATE_TEMPLATE);
+        Serialise_vkCreateDescriptorUpdateTemplateKHR(localSerialiser, device, pCreateInfo, NULL,
+                                                      pDescriptorUpdateTemplate);
+
+        chunk = scope.Get();
+      }
+
+      VkResourceRecord *record =
+          GetResourceManager()->AddResourceRecord(*pDescriptorUpdateTemplate);
+      record->AddChunk(chunk);
+
+      if(pCreateInfo->descriptorSetLayout != VK_NULL_HANDLE)
+        record->AddParent(GetRecord(pCreateInfo->descriptorSetLayout));
+      if(pCreateInfo->pipelineLayout != VK_NULL_HANDLE)
+        record->AddParent(GetRecord(pCreateInfo->pipelineLayout));
+
+      // the entries are needed to unwrap and pack each update
+      record->descTemplateInfo = new DescUpdateTemplate();
+      record->descTemplateInfo->Init(GetResourceManager(), m_CreationInfo, pCreateInfo);
+    }
+    else
+    {
+      GetResourceManager()->AddLiveResource(id, *pDescriptorUpdateTemplate);
+
+      m_CreationInfo.m_DescUpdateTemplate[id].Init(GetResourceManager(), m_CreationInfo,
+                                                   pCreateInfo);
+    }
+  }
+
+  return ret;
+}
+
+bool WrappedVulkan::Serialise_vkUpdateDescriptorSetWithTemplateKHR(
+    Serialiser *localSerialiser, VkDevice device, VkDescriptorSet descriptorSet,
+    VkDescriptorUpdateTemplateKHR descriptorUpdateTemplate, const void *pData)
+{
+  SERIALISE_ELEMENT(ResourceId, devId, GetResID(device));
+  SERIALISE_ELEMENT(ResourceId, setId, GetResID(descriptorSet));
+  SERIALISE_ELEMENT(ResourceId, templId, GetResID(descriptorUpdateTemplate));
+
+  // the template was serialised once when it was created, so each update only needs the
+  // descriptors themselves. These are packed tightly with handles replaced by IDs instead of
+  // expanded into VkWriteDescriptorSets.
+  byte *packed = NULL;
+  size_t packedSize = 0;
+
+  if(m_State >= WRITING)
+  {
+    const DescUpdateTemplate &info = *GetRecord(descriptorUpdateTemplate)->descTemplateInfo;
+
+    packedSize = info.packedSize;
+    packed = GetTempMemory(packedSize);
+
+    PackTemplateUpdate(info, pData, packed);
+  }
+
+  localSerialiser->SerialiseBuffer("packedData", packed, packedSize);
+
+  Serialise_DebugMessages(localSerialiser, false);
+
+  if(m_State < WRITING)
+  {
+    // if a set was never bound, it will have been omitted and we just drop any writes to it
+    if(GetResourceManager()->HasLiveResource(setId))
+    {
+      device = GetResourceManager()->GetLiveHandle<VkDevice>(devId);
+      descriptorSet = GetResourceManager()->GetLiveHandle<VkDescriptorSet>(setId);
+
+      const DescUpdateTemplate &info =
+          m_CreationInfo.m_DescUpdateTemplate[GetResourceManager()->GetLiveID(templId)];
+
+      // replay each entry as a write, so that any entry referencing resources that weren't
+      // included in the capture can be skipped on its own
+      VkDescriptorBufferInfo *descriptors =
+          GetTempArray<VkDescriptorBufferInfo>(info.maxDescriptorCount);
+
+      RDCCOMPILE_ASSERT(sizeof(VkDescriptorBufferInfo) >= sizeof(VkDescriptorImageInfo),
+                        "Descriptor structs sizes are unexpected, ensure largest size is used");
+
+      VkDescriptorImageInfo *imInfos = (VkDescriptorImageInfo *)descriptors;
+      VkBufferView *bufViews = (VkBufferView *)descriptors;
+
+      const byte *src = packed;
+
+      for(size_t i = 0; i < info.entries.size(); i++)
+      {
+        const VkDescriptorUpdateTemplateEntryKHR &entry = info.entries[i];
+
+        VkWriteDescriptorSet write = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, 0};
+        write.dstSet = Unwrap(descriptorSet);
+        write.dstBinding = entry.dstBinding;
+        write.dstArrayElement = entry.dstArrayElement;
+        write.descriptorCount = entry.descriptorCount;
+        write.descriptorType = entry.descriptorType;
+
+        for(uint32_t d = 0; d < entry.descriptorCount; d++)
+        {
+          switch(entry.descriptorType)
+          {
+            case VK_DESCRIPTOR_TYPE_SAMPLER:
+              imInfos[d].sampler = ReadPackedHandle<VkSampler>(GetResourceManager(), src);
+              imInfos[d].imageView = VK_NULL_HANDLE;
+              imInfos[d].imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+              break;
+            case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+              imInfos[d].sampler = ReadPackedHandle<VkSampler>(GetResourceManager(), src);
+              imInfos[d].imageView = ReadPackedHandle<VkImageView>(GetResourceManager(), src);
+              imInfos[d].imageLayout = ReadPacked<VkImageLayout>(src);
+              break;
+            case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+            case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+            case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+              imInfos[d].sampler = VK_NULL_HANDLE;
+              imInfos[d].imageView = ReadPackedHandle<VkImageView>(GetResourceManager(), src);
+              imInfos[d].imageLayout = ReadPacked<VkImageLayout>(src);
+              break;
+            case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+            case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+              bufViews[d] = ReadPackedHandle<VkBufferView>(GetResourceManager(), src);
+              break;
+            case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+            case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+            case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+            case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+              descriptors[d].buffer = ReadPackedHandle<VkBuffer>(GetResourceManager(), src);
+              descriptors[d].offset = ReadPacked<VkDeviceSize>(src);
+              descriptors[d].range = ReadPacked<VkDeviceSize>(src);
+              break;
+            default: RDCERR("Unexpected descriptor type %d", entry.descriptorType);
+          }
+        }
+
+        write.pImageInfo = imInfos;
+        write.pBufferInfo = descriptors;
+        write.pTexelBufferView = bufViews;
+
+        ReplayDescriptorSetWrite(device, write);
+      }
+    }
+
+    SAFE_DELETE_ARRAY(packed);
+  }
+
+  return true;
+}
+
+void WrappedVulkan::vkUpdateDescriptorSetWithTemplateKHR(
+    VkDevice device, VkDescriptorSet descriptorSet,
+    VkDescriptorUpdateTemplateKHR descriptorUpdateTemplate, const void *pData)
+{
+  SCOPED_DBG_SINK();
+
+  const DescUpdateTemplate *info = NULL;
+
+  if(m_State >= WRITING)
+    info = GetRecord(descriptorUpdateTemplate)->descTemplateInfo;
+  else
+    info = &m_CreationInfo.m_DescUpdateTemplate[GetResID(descriptorUpdateTemplate)];
+
+  {
+    // unwrap the handles into a copy of the data at the same offsets, so the driver can consume
+    // it exactly as the application laid it out
+    byte *memory = GetTempMemory(info->dataByteSize);
+
+    for(size_t i = 0; i < info->entries.size(); i++)
+    {
+      const VkDescriptorUpdateTemplateEntryKHR &entry = info->entries[i];
+
+      for(uint32_t d = 0; d < entry.descriptorCount; d++)
+      {
+        size_t offs = entry.offset + entry.stride * d;
+
+        if(entry.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER ||
+           entry.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER)
+        {
+          VkBufferView *dst = (VkBufferView *)(memory + offs);
+          *dst = Unwrap(*(const VkBufferView *)((const byte *)pData + offs));
+        }
+        else if(entry.descriptorType == VK_DESCRIPTOR_TYPE_SAMPLER ||
+                entry.descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER ||
+                entry.descriptorType == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE ||
+                entry.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE ||
+                entry.descriptorType == VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT)
+        {
+          const VkDescriptorImageInfo *src =
+              (const VkDescriptorImageInfo *)((const byte *)pData + offs);
+          VkDescriptorImageInfo *dst = (VkDescriptorImageInfo *)(memory + offs);
+
+          // members the descriptor type doesn't use could be garbage, so don't unwrap them
+          dst->sampler = VK_NULL_HANDLE;
+          dst->imageView = VK_NULL_HANDLE;
+          dst->imageLayout = src->imageLayout;
+
+          if(entry.descriptorType == VK_DESCRIPTOR_TYPE_SAMPLER ||
+             entry.descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
+            dst->sampler = Unwrap(src->sampler);
+          if(entry.descriptorType != VK_DESCRIPTOR_TYPE_SAMPLER)
+            dst->imageView = Unwrap(src->imageView);
+        }
+        else
+        {
+          const VkDescriptorBufferInfo *src =
+              (const VkDescriptorBufferInfo *)((const byte *)pData + offs);
+          VkDescriptorBufferInfo *dst = (VkDescriptorBufferInfo *)(memory + offs);
+
+          dst->buffer = Unwrap(src->buffer);
+          dst->offset = src->offset;
+          dst->range = src->range;
+        }
+      }
+    }
+
+    ObjDisp(device)->UpdateDescriptorSetWithTemplateKHR(
+        Unwrap(device), Unwrap(descriptorSet), Unwrap(descriptorUpdateTemplate), memory);
+  }
+
+  bool capframe = false;
+  {
+    SCOPED_LOCK(m_CapTransitionLock);
+    capframe = (m_State == WRITING_CAPFRAME);
+  }
+
+  if(capframe)
+  {
+    {
+      CACHE_THREAD_SERIALISER();
+
+      SCOPED_SERIALISE_CONTEXT(UPDATE_DESC_SET_WITH_TEMPLATE);
+      Serialise_vkUpdateDescriptorSetWithTemplateKHR(localSerialiser, device, descriptorSet,
+                                                     descriptorUpdateTemplate, pData);
+
+      m_FrameCaptureRecord->AddChunk(scope.Get());
+    }
+
+    // as with vkUpdateDescriptorSets the set doesn't need to be referenced here, but the template
+    // does since its entries are needed to decode the update
+    GetResourceManager()->MarkResourceFrameReferenced(GetResID(descriptorUpdateTemplate),
+                                                      eFrameRef_Read);
+  }
+
+  // need to track descriptor set contents whether capframing or idle
+  if(m_State >= WRITING)
+  {
+    VkResourceRecord *record = GetRecord(descriptorSet);
+    RDCASSERT(record->descInfo && record->descInfo->layout);
+    const DescSetLayout &layout = *record->descInfo->layout;
+
+    for(size_t i = 0; i < info->entries.size(); i++)
+    {
+      const VkDescriptorUpdateTemplateEntryKHR &entry = info->entries[i];
+
+      RDCASSERT(entry.dstBinding < record->descInfo->descBindings.size());
+
+      DescriptorSetSlot **binding = &record->descInfo->descBindings[entry.dstBinding];
+
+      const DescSetLayout::Binding *layoutBinding = &layout.bindings[entry.dstBinding];
+
+      FrameRefType ref = DescriptorFrameRef(layoutBinding->descriptorType);
+
+      uint32_t curIdx = entry.dstArrayElement;
+
+      for(uint32_t d = 0; d < entry.descriptorCount; d++, curIdx++)
+      {
+        // roll over onto the next binding, the same as a VkWriteDescriptorSet. See
+        // vkUpdateDescriptorSets
+        if(curIdx >= layoutBinding->descriptorCount)
+        {
+          layoutBinding++;
+          binding++;
+          curIdx = 0;
+        }
+
+        UpdateTrackedDescriptor(record, (*binding)[curIdx], entry.descriptorType, ref,
+                                (const byte *)pData + entry.offset + entry.stride * d);
+      }
+    }
+  }
+}
@@ -418,6 +418,10 @@ void WrappedVulkan::Shutdown()
   SubmitSemaphores();
   FlushQ();
 
+  FreePartialCmdCache();
+
+  DestroyReplayPipelineCache();
+
   // since we didn't create proper registered resources for our command buffers,
   // they won't be taken down properly with the pool. So we release them (just our
   // data) here.
@@ -434,6 +438,8 @@ void WrappedVulkan::Shutdown()
     GetResourceManager()->ReleaseWrappedResource(m_InternalCmds.freesems[i]);
   }
 
+  DestroyInternalFences();
+
   // we do more in Shutdown than the equivalent vkDestroyInstance since on replay there's
   // no explicit vkDestroyDevice, we destroy the device here then the instance
 
@@ -638,6 +644,23 @@ bool WrappedVulkan::Serialise_vkEnumeratePhysicalDevices(Serialiser *localSerial
       // this device isn't any better, ignore it
     }
 
+    // if this replay was pinned to a GPU, that overrides any matching
+    uint32_t replayGPU = RenderDoc::Inst().GetReplayGPU();
+    if(replayGPU < (uint32_t)m_ReplayPhysicalDevices.size())
+    {
+      bestIdx = replayGPU;
+
+      pd = m_ReplayPhysicalDevices[bestIdx];
+
+      ObjDisp(pd)->GetPhysicalDeviceProperties(Unwrap(pd), &bestPhysProps);
+      ObjDisp(pd)->GetPhysicalDeviceMemoryProperties(Unwrap(pd), &bestMemProps);
+    }
+    else if(replayGPU != ~0U)
+    {
+      RDCWARN("Replay GPU %u requested but only %u are available, matching automatically",
+              replayGPU, (uint32_t)m_ReplayPhysicalDevices.size());
+    }
+
     {
       VkDriverInfo runningVersion(bestPhysProps);
 
@@ -1044,6 +1067,11 @@ bool WrappedVulkan::Serialise_vkCreateDevice(Serialiser *localSerialiser,
     else
       RDCWARN("vertexPipelineStoresAndAtomics = false, output mesh data will not be available");
 
+    if(availFeatures.fragmentStoresAndAtomics)
+      enabledFeatures.fragmentStoresAndAtomics = true;
+    else
+      RDCWARN("fragmentStoresAndAtomics = false, texture sampling feedback will not be available");
+
     if(availFeatures.shaderStorageImageWriteWithoutFormat)
       enabledFeatures.shaderStorageImageWriteWithoutFormat = true;
     else
@@ -1429,6 +1457,11 @@ VkResult WrappedVulkan::vkCreateDevice(VkPhysicalDevice physicalDevice,
     ObjDisp(physicalDevice)
         ->GetPhysicalDeviceFeatures(Unwrap(physicalDevice), &m_PhysicalDeviceData.features);
 
+    for(int i = VK_FORMAT_BEGIN_RANGE + 1; i < VK_FORMAT_END_RANGE; i++)
+      ObjDisp(physicalDevice)
+          ->GetPhysicalDeviceFormatProperties(Unwrap(physicalDevice), VkFormat(i),
+                                              &m_PhysicalDeviceData.fmtprops[i]);
+
     m_PhysicalDeviceData.readbackMemIndex =
         m_PhysicalDeviceData.GetMemoryIndex(~0U, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, 0);
     m_PhysicalDeviceData.uploadMemIndex =
@@ -1481,6 +1514,8 @@ void WrappedVulkan::vkDestroyDevice(VkDevice device, const VkAllocationCallbacks
     GetResourceManager()->ReleaseWrappedResource(m_InternalCmds.freesems[i]);
   }
 
+  DestroyInternalFences();
+
   m_InternalCmds.Reset();
 
   m_QueueFamilyIdx = ~0U;
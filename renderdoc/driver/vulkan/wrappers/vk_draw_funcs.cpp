@@ -146,13 +146,16 @@ void WrappedVulkan::vkCmdDraw(VkCommandBuffer commandBuffer, uint32_t vertexCoun
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(DRAW);
-    Serialise_vkCmdDraw(localSerialiser, commandBuffer, vertexCount, instanceCount, firstVertex,
-                        firstInstance);
+      SCOPED_SERIALISE_CONTEXT(DRAW);
+      Serialise_vkCmdDraw(localSerialiser, commandBuffer, vertexCount, instanceCount, firstVertex,
+                          firstInstance);
 
-    record->AddChunk(scope.Get());
+      record->AddChunk(scope.Get());
+    }
   }
 }
 
@@ -245,13 +248,16 @@ void WrappedVulkan::vkCmdDrawIndexed(VkCommandBuffer commandBuffer, uint32_t ind
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(DRAW_INDEXED);
-    Serialise_vkCmdDrawIndexed(localSerialiser, commandBuffer, indexCount, instanceCount,
-                               firstIndex, vertexOffset, firstInstance);
+      SCOPED_SERIALISE_CONTEXT(DRAW_INDEXED);
+      Serialise_vkCmdDrawIndexed(localSerialiser, commandBuffer, indexCount, instanceCount,
+                                 firstIndex, vertexOffset, firstInstance);
 
-    record->AddChunk(scope.Get());
+      record->AddChunk(scope.Get());
+    }
   }
 }
 
@@ -516,12 +522,15 @@ void WrappedVulkan::vkCmdDrawIndirect(VkCommandBuffer commandBuffer, VkBuffer bu
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(DRAW_INDIRECT);
-    Serialise_vkCmdDrawIndirect(localSerialiser, commandBuffer, buffer, offset, count, stride);
+      SCOPED_SERIALISE_CONTEXT(DRAW_INDIRECT);
+      Serialise_vkCmdDrawIndirect(localSerialiser, commandBuffer, buffer, offset, count, stride);
 
-    record->AddChunk(scope.Get());
+      record->AddChunk(scope.Get());
+    }
 
     record->MarkResourceFrameReferenced(GetResID(buffer), eFrameRef_Read);
     record->MarkResourceFrameReferenced(GetRecord(buffer)->baseResource, eFrameRef_Read);
@@ -813,12 +822,16 @@ void WrappedVulkan::vkCmdDrawIndexedIndirect(VkCommandBuffer commandBuffer, VkBu
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(DRAW_INDEXED_INDIRECT);
-    Serialise_vkCmdDrawIndexedIndirect(localSerialiser, commandBuffer, buffer, offset, count, stride);
+      SCOPED_SERIALISE_CONTEXT(DRAW_INDEXED_INDIRECT);
+      Serialise_vkCmdDrawIndexedIndirect(localSerialiser, commandBuffer, buffer, offset, count,
+                                         stride);
 
-    record->AddChunk(scope.Get());
+      record->AddChunk(scope.Get());
+    }
 
     record->MarkResourceFrameReferenced(GetResID(buffer), eFrameRef_Read);
     record->MarkResourceFrameReferenced(GetRecord(buffer)->baseResource, eFrameRef_Read);
@@ -896,12 +909,15 @@ void WrappedVulkan::vkCmdDispatch(VkCommandBuffer commandBuffer, uint32_t x, uin
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(DISPATCH);
-    Serialise_vkCmdDispatch(localSerialiser, commandBuffer, x, y, z);
+      SCOPED_SERIALISE_CONTEXT(DISPATCH);
+      Serialise_vkCmdDispatch(localSerialiser, commandBuffer, x, y, z);
 
-    record->AddChunk(scope.Get());
+      record->AddChunk(scope.Get());
+    }
   }
 }
 
@@ -994,12 +1010,15 @@ void WrappedVulkan::vkCmdDispatchIndirect(VkCommandBuffer commandBuffer, VkBuffe
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(DISPATCH_INDIRECT);
-    Serialise_vkCmdDispatchIndirect(localSerialiser, commandBuffer, buffer, offset);
+      SCOPED_SERIALISE_CONTEXT(DISPATCH_INDIRECT);
+      Serialise_vkCmdDispatchIndirect(localSerialiser, commandBuffer, buffer, offset);
 
-    record->AddChunk(scope.Get());
+      record->AddChunk(scope.Get());
+    }
 
     record->MarkResourceFrameReferenced(GetResID(buffer), eFrameRef_Read);
     record->MarkResourceFrameReferenced(GetRecord(buffer)->baseResource, eFrameRef_Read);
@@ -1117,13 +1136,16 @@ void WrappedVulkan::vkCmdBlitImage(VkCommandBuffer commandBuffer, VkImage srcIma
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(BLIT_IMG);
-    Serialise_vkCmdBlitImage(localSerialiser, commandBuffer, srcImage, srcImageLayout, destImage,
-                             destImageLayout, regionCount, pRegions, filter);
+      SCOPED_SERIALISE_CONTEXT(BLIT_IMG);
+      Serialise_vkCmdBlitImage(localSerialiser, commandBuffer, srcImage, srcImageLayout, destImage,
+                               destImageLayout, regionCount, pRegions, filter);
 
-    record->AddChunk(scope.Get());
+      record->AddChunk(scope.Get());
+    }
 
     record->MarkResourceFrameReferenced(GetResID(srcImage), eFrameRef_Read);
     record->MarkResourceFrameReferenced(GetRecord(srcImage)->baseResource, eFrameRef_Read);
@@ -1244,13 +1266,16 @@ void WrappedVulkan::vkCmdResolveImage(VkCommandBuffer commandBuffer, VkImage src
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(RESOLVE_IMG);
-    Serialise_vkCmdResolveImage(localSerialiser, commandBuffer, srcImage, srcImageLayout, destImage,
-                                destImageLayout, regionCount, pRegions);
+      SCOPED_SERIALISE_CONTEXT(RESOLVE_IMG);
+      Serialise_vkCmdResolveImage(localSerialiser, commandBuffer, srcImage, srcImageLayout,
+                                  destImage, destImageLayout, regionCount, pRegions);
 
-    record->AddChunk(scope.Get());
+      record->AddChunk(scope.Get());
+    }
 
     record->MarkResourceFrameReferenced(GetResID(srcImage), eFrameRef_Read);
     record->MarkResourceFrameReferenced(GetRecord(srcImage)->baseResource, eFrameRef_Read);
@@ -1371,17 +1396,21 @@ void WrappedVulkan::vkCmdCopyImage(VkCommandBuffer commandBuffer, VkImage srcIma
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(COPY_IMG);
-    Serialise_vkCmdCopyImage(localSerialiser, commandBuffer, srcImage, srcImageLayout, destImage,
-                             destImageLayout, regionCount, pRegions);
+      SCOPED_SERIALISE_CONTEXT(COPY_IMG);
+      Serialise_vkCmdCopyImage(localSerialiser, commandBuffer, srcImage, srcImageLayout, destImage,
+                               destImageLayout, regionCount, pRegions);
+
+      record->AddChunk(scope.Get());
+      record->MarkResourceFrameReferenced(GetResID(srcImage), eFrameRef_Read);
+      record->MarkResourceFrameReferenced(GetRecord(srcImage)->baseResource, eFrameRef_Read);
+      record->MarkResourceFrameReferenced(GetResID(destImage), eFrameRef_Write);
+      record->MarkResourceFrameReferenced(GetRecord(destImage)->baseResource, eFrameRef_Read);
+    }
 
-    record->AddChunk(scope.Get());
-    record->MarkResourceFrameReferenced(GetResID(srcImage), eFrameRef_Read);
-    record->MarkResourceFrameReferenced(GetRecord(srcImage)->baseResource, eFrameRef_Read);
-    record->MarkResourceFrameReferenced(GetResID(destImage), eFrameRef_Write);
-    record->MarkResourceFrameReferenced(GetRecord(destImage)->baseResource, eFrameRef_Read);
     record->cmdInfo->dirtied.insert(GetResID(destImage));
     if(GetRecord(srcImage)->sparseInfo)
       record->cmdInfo->sparse.insert(GetRecord(srcImage)->sparseInfo);
@@ -1489,13 +1518,16 @@ void WrappedVulkan::vkCmdCopyBufferToImage(VkCommandBuffer commandBuffer, VkBuff
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(COPY_BUF2IMG);
-    Serialise_vkCmdCopyBufferToImage(localSerialiser, commandBuffer, srcBuffer, destImage,
-                                     destImageLayout, regionCount, pRegions);
+      SCOPED_SERIALISE_CONTEXT(COPY_BUF2IMG);
+      Serialise_vkCmdCopyBufferToImage(localSerialiser, commandBuffer, srcBuffer, destImage,
+                                       destImageLayout, regionCount, pRegions);
 
-    record->AddChunk(scope.Get());
+      record->AddChunk(scope.Get());
+    }
 
     record->MarkResourceFrameReferenced(GetResID(srcBuffer), eFrameRef_Read);
     record->MarkResourceFrameReferenced(GetRecord(srcBuffer)->baseResource, eFrameRef_Read);
@@ -1607,15 +1639,18 @@ void WrappedVulkan::vkCmdCopyImageToBuffer(VkCommandBuffer commandBuffer, VkImag
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(COPY_IMG2BUF);
-    Serialise_vkCmdCopyImageToBuffer(localSerialiser, commandBuffer, srcImage, srcImageLayout,
-                                     destBuffer, regionCount, pRegions);
+      SCOPED_SERIALISE_CONTEXT(COPY_IMG2BUF);
+      Serialise_vkCmdCopyImageToBuffer(localSerialiser, commandBuffer, srcImage, srcImageLayout,
+                                       destBuffer, regionCount, pRegions);
 
-    record->AddChunk(scope.Get());
-    record->MarkResourceFrameReferenced(GetResID(srcImage), eFrameRef_Read);
-    record->MarkResourceFrameReferenced(GetRecord(srcImage)->baseResource, eFrameRef_Read);
+      record->AddChunk(scope.Get());
+      record->MarkResourceFrameReferenced(GetResID(srcImage), eFrameRef_Read);
+      record->MarkResourceFrameReferenced(GetRecord(srcImage)->baseResource, eFrameRef_Read);
+    }
 
     VkResourceRecord *buf = GetRecord(destBuffer);
 
@@ -1733,15 +1768,18 @@ void WrappedVulkan::vkCmdCopyBuffer(VkCommandBuffer commandBuffer, VkBuffer srcB
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(COPY_BUF);
-    Serialise_vkCmdCopyBuffer(localSerialiser, commandBuffer, srcBuffer, destBuffer, regionCount,
-                              pRegions);
+      SCOPED_SERIALISE_CONTEXT(COPY_BUF);
+      Serialise_vkCmdCopyBuffer(localSerialiser, commandBuffer, srcBuffer, destBuffer, regionCount,
+                                pRegions);
 
-    record->AddChunk(scope.Get());
-    record->MarkResourceFrameReferenced(GetResID(srcBuffer), eFrameRef_Read);
-    record->MarkResourceFrameReferenced(GetRecord(srcBuffer)->baseResource, eFrameRef_Read);
+      record->AddChunk(scope.Get());
+      record->MarkResourceFrameReferenced(GetResID(srcBuffer), eFrameRef_Read);
+      record->MarkResourceFrameReferenced(GetRecord(srcBuffer)->baseResource, eFrameRef_Read);
+    }
 
     VkResourceRecord *buf = GetRecord(destBuffer);
 
@@ -1849,15 +1887,19 @@ void WrappedVulkan::vkCmdClearColorImage(VkCommandBuffer commandBuffer, VkImage
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(CLEAR_COLOR);
-    Serialise_vkCmdClearColorImage(localSerialiser, commandBuffer, image, imageLayout, pColor,
-                                   rangeCount, pRanges);
+      SCOPED_SERIALISE_CONTEXT(CLEAR_COLOR);
+      Serialise_vkCmdClearColorImage(localSerialiser, commandBuffer, image, imageLayout, pColor,
+                                     rangeCount, pRanges);
+
+      record->AddChunk(scope.Get());
+      record->MarkResourceFrameReferenced(GetResID(image), eFrameRef_Write);
+      record->MarkResourceFrameReferenced(GetRecord(image)->baseResource, eFrameRef_Read);
+    }
 
-    record->AddChunk(scope.Get());
-    record->MarkResourceFrameReferenced(GetResID(image), eFrameRef_Write);
-    record->MarkResourceFrameReferenced(GetRecord(image)->baseResource, eFrameRef_Read);
     if(GetRecord(image)->sparseInfo)
       record->cmdInfo->sparse.insert(GetRecord(image)->sparseInfo);
   }
@@ -1955,15 +1997,19 @@ void WrappedVulkan::vkCmdClearDepthStencilImage(VkCommandBuffer commandBuffer, V
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
+
+      SCOPED_SERIALISE_CONTEXT(CLEAR_DEPTHSTENCIL);
+      Serialise_vkCmdClearDepthStencilImage(localSerialiser, commandBuffer, image, imageLayout,
+                                            pDepthStencil, rangeCount, pRanges);
 
-    SCOPED_SERIALISE_CONTEXT(CLEAR_DEPTHSTENCIL);
-    Serialise_vkCmdClearDepthStencilImage(localSerialiser, commandBuffer, image, imageLayout,
-                                          pDepthStencil, rangeCount, pRanges);
+      record->AddChunk(scope.Get());
+      record->MarkResourceFrameReferenced(GetResID(image), eFrameRef_Write);
+      record->MarkResourceFrameReferenced(GetRecord(image)->baseResource, eFrameRef_Read);
+    }
 
-    record->AddChunk(scope.Get());
-    record->MarkResourceFrameReferenced(GetResID(image), eFrameRef_Write);
-    record->MarkResourceFrameReferenced(GetRecord(image)->baseResource, eFrameRef_Read);
     if(GetRecord(image)->sparseInfo)
       record->cmdInfo->sparse.insert(GetRecord(image)->sparseInfo);
   }
@@ -2083,13 +2129,16 @@ void WrappedVulkan::vkCmdClearAttachments(VkCommandBuffer commandBuffer, uint32_
   {
     VkResourceRecord *record = GetRecord(commandBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(CLEAR_ATTACH);
-    Serialise_vkCmdClearAttachments(localSerialiser, commandBuffer, attachmentCount, pAttachments,
-                                    rectCount, pRects);
+      SCOPED_SERIALISE_CONTEXT(CLEAR_ATTACH);
+      Serialise_vkCmdClearAttachments(localSerialiser, commandBuffer, attachmentCount, pAttachments,
+                                      rectCount, pRects);
 
-    record->AddChunk(scope.Get());
+      record->AddChunk(scope.Get());
+    }
 
     // image/attachments are referenced when the render pass is started and the framebuffer is
     // bound.
@@ -85,7 +85,6 @@ DESTROY_IMPL(VkShaderModule, DestroyShaderModule)
 DESTROY_IMPL(VkPipeline, DestroyPipeline)
 DESTROY_IMPL(VkPipelineCache, DestroyPipelineCache)
 DESTROY_IMPL(VkPipelineLayout, DestroyPipelineLayout)
-DESTROY_IMPL(VkSampler, DestroySampler)
 DESTROY_IMPL(VkDescriptorSetLayout, DestroyDescriptorSetLayout)
 DESTROY_IMPL(VkDescriptorPool, DestroyDescriptorPool)
 DESTROY_IMPL(VkSemaphore, DestroySemaphore)
@@ -95,9 +94,38 @@ DESTROY_IMPL(VkCommandPool, DestroyCommandPool)
 DESTROY_IMPL(VkQueryPool, DestroyQueryPool)
 DESTROY_IMPL(VkFramebuffer, DestroyFramebuffer)
 DESTROY_IMPL(VkRenderPass, DestroyRenderPass)
+DESTROY_IMPL(VkDescriptorUpdateTemplateKHR, DestroyDescriptorUpdateTemplateKHR)
 
 #undef DESTROY_IMPL
 
+void WrappedVulkan::vkDestroySampler(VkDevice device, VkSampler obj,
+                                     const VkAllocationCallbacks *pAllocator)
+{
+  if(obj == VK_NULL_HANDLE)
+    return;
+
+  if(m_State >= WRITING)
+  {
+    SCOPED_LOCK(m_DeferredSamplersLock);
+
+    auto it = m_DeferredSamplers.find(GetResID(obj));
+    if(it != m_DeferredSamplers.end())
+    {
+      // if the frame being captured might use it, or something else still holds the record (e.g.
+      // a descriptor set layout with this as an immutable sampler) it still needs its creation
+      // chunk
+      if(m_State == WRITING_CAPFRAME || GetRecord(obj)->GetRefCount() > 1)
+        SerialiseDeferredSampler(it->second);
+
+      m_DeferredSamplers.erase(it);
+    }
+  }
+
+  VkSampler unwrappedObj = Unwrap(obj);
+  GetResourceManager()->ReleaseWrappedResource(obj, true);
+  ObjDisp(device)->DestroySampler(Unwrap(device), unwrappedObj, pAllocator);
+}
+
 // needs to be separate because it releases internal resources
 void WrappedVulkan::vkDestroySwapchainKHR(VkDevice device, VkSwapchainKHR obj,
                                           const VkAllocationCallbacks *pAllocator)
@@ -331,6 +359,13 @@ bool WrappedVulkan::ReleaseResource(WrappedVkRes *res)
       vt->DestroyDescriptorSetLayout(Unwrap(dev), real, NULL);
       break;
     }
+    case eResDescUpdateTemplate:
+    {
+      VkDescriptorUpdateTemplateKHR real = nondisp->real.As<VkDescriptorUpdateTemplateKHR>();
+      GetResourceManager()->ReleaseWrappedResource(VkDescriptorUpdateTemplateKHR(handle));
+      vt->DestroyDescriptorUpdateTemplateKHR(Unwrap(dev), real, NULL);
+      break;
+    }
     case eResCommandPool:
     {
       VkCommandPool real = nondisp->real.As<VkCommandPool>();
@@ -430,7 +465,20 @@ VkResult WrappedVulkan::vkCreateSampler(VkDevice device, const VkSamplerCreateIn
   {
     ResourceId id = GetResourceManager()->WrapResource(Unwrap(device), *pSampler);
 
-    if(m_State >= WRITING)
+    if(m_State == WRITING_IDLE && pCreateInfo->pNext == NULL)
+    {
+      GetResourceManager()->AddResourceRecord(*pSampler);
+
+      DeferredSampler deferred;
+      deferred.device = device;
+      deferred.sampler = *pSampler;
+      deferred.info = *pCreateInfo;
+      deferred.chunkID = ResourceRecord::ReserveIDs(1);
+
+      SCOPED_LOCK(m_DeferredSamplersLock);
+      m_DeferredSamplers[id] = deferred;
+    }
+    else if(m_State >= WRITING)
     {
       Chunk *chunk = NULL;
 
@@ -457,6 +505,34 @@ VkResult WrappedVulkan::vkCreateSampler(VkDevice device, const VkSamplerCreateIn
   return ret;
 }
 
+void WrappedVulkan::SerialiseDeferredSampler(const DeferredSampler &deferred)
+{
+  VkSampler sampler = deferred.sampler;
+
+  Chunk *chunk = NULL;
+
+  {
+    CACHE_THREAD_SERIALISER();
+
+    SCOPED_SERIALISE_CONTEXT(CREATE_SAMPLER);
+    Serialise_vkCreateSampler(localSerialiser, deferred.device, &deferred.info, NULL, &sampler);
+
+    chunk = scope.Get();
+  }
+
+  GetRecord(sampler)->AddChunk(chunk, deferred.chunkID);
+}
+
+void WrappedVulkan::SerialiseDeferredSamplers()
+{
+  SCOPED_LOCK(m_DeferredSamplersLock);
+
+  for(auto it = m_DeferredSamplers.begin(); it != m_DeferredSamplers.end(); ++it)
+    SerialiseDeferredSampler(it->second);
+
+  m_DeferredSamplers.clear();
+}
+
 bool WrappedVulkan::Serialise_vkCreateFramebuffer(Serialiser *localSerialiser, VkDevice device,
                                                   const VkFramebufferCreateInfo *pCreateInfo,
                                                   const VkAllocationCallbacks *pAllocator,
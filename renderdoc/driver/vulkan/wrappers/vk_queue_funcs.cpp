@@ -202,6 +202,13 @@ bool WrappedVulkan::Serialise_vkQueueSubmit(Serialiser *localSerialiser, VkQueue
 
     AddEvent(desc);
 
+    QueueSubmission submission;
+    submission.queue = queueId;
+    // we only support the one queue family, which always has graphics
+    submission.type = QueueType::Graphics;
+    submission.eventID = m_RootEventID;
+    submission.waits = numWaitSems;
+
     // we're adding multiple events, need to increment ourselves
     m_RootEventID++;
 
@@ -258,6 +265,9 @@ bool WrappedVulkan::Serialise_vkQueueSubmit(Serialiser *localSerialiser, VkQueue
     // account for the outer loop thinking we've added one event and incrementing,
     // since we've done all the handling ourselves this will be off by one.
     m_RootEventID--;
+
+    submission.lastEventID = m_RootEventID;
+    m_QueueSubmissions.push_back(submission);
   }
   else if(m_State == EXECUTING)
   {
@@ -643,6 +653,21 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
 
       if(capframe)
       {
+        // command buffers recorded while idle tracking was suspended have no commands to replay
+        if(record->bakedCommands->cmdInfo->untracked)
+          RDCWARN("Command buffer %llu was recorded before the capture was queued, with idle "
+                  "tracking suspended. Its commands will be missing from the capture.",
+                  record->GetResourceID());
+
+        for(size_t sub = 0; sub < record->bakedCommands->cmdInfo->subcmds.size(); sub++)
+        {
+          VkResourceRecord *subrecord = record->bakedCommands->cmdInfo->subcmds[sub];
+          if(subrecord->bakedCommands->cmdInfo->untracked)
+            RDCWARN("Secondary command buffer %llu was recorded before the capture was queued, "
+                    "with idle tracking suspended. Its commands will be missing from the capture.",
+                    subrecord->GetResourceID());
+        }
+
         // for each bound descriptor set, mark it referenced as well as all resources currently
         // bound to it
         for(auto it = record->bakedCommands->cmdInfo->boundDescSets.begin();
@@ -732,6 +757,12 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
           continue;
         }
 
+        if(state.writeWatch)
+        {
+          FlushWatchedMap(record);
+          continue;
+        }
+
         size_t diffStart = 0, diffEnd = 0;
         bool found = true;
 
@@ -487,6 +487,9 @@ void WrappedVulkan::vkFreeMemory(VkDevice device, VkDeviceMemory memory,
     if(wrapped->record->memMapState && wrapped->record->memMapState->refData)
       Serialiser::FreeAlignedBuffer(wrapped->record->memMapState->refData);
 
+    if(wrapped->record->memMapState && wrapped->record->memMapState->writeWatch)
+      WriteWatch::End(wrapped->record->memMapState->writeWatch);
+
     {
       SCOPED_LOCK(m_CoherentMapsLock);
 
@@ -494,6 +497,11 @@ void WrappedVulkan::vkFreeMemory(VkDevice device, VkDeviceMemory memory,
       if(it != m_CoherentMaps.end())
         m_CoherentMaps.erase(it);
     }
+
+    {
+      SCOPED_LOCK(m_MemoryBindingsLock);
+      m_MemoryBindings.erase(wrapped->id);
+    }
   }
 
   GetResourceManager()->ReleaseWrappedResource(memory);
@@ -536,6 +544,18 @@ VkResult WrappedVulkan::vkMapMemory(VkDevice device, VkDeviceMemory mem, VkDevic
 
       if(state.mapCoherent)
       {
+        if(RenderDoc::Inst().GetCaptureOptions().TrackCoherentMapWrites)
+        {
+          state.writeWatch = WriteWatch::Begin(realData, (size_t)state.mapSize);
+          state.writeWatchSynced = false;
+
+          // the memory is always dirty while it's tracked, so that its initial contents are
+          // saved when a capture starts and only pages written after that need to be serialised
+          SCOPED_LOCK(m_CapTransitionLock);
+          if(state.writeWatch && m_State != WRITING_CAPFRAME)
+            GetResourceManager()->MarkDirtyResource(id);
+        }
+
         SCOPED_LOCK(m_CoherentMapsLock);
         m_CoherentMaps.push_back(memrecord);
       }
@@ -610,14 +630,33 @@ void WrappedVulkan::vkUnmapMemory(VkDevice device, VkDeviceMemory mem)
       // dirty when capframe starts, then we mark dirty while in-frame
 
       bool capframe = false;
+      bool recordUpload = false;
       {
         SCOPED_LOCK(m_CapTransitionLock);
         capframe = (m_State == WRITING_CAPFRAME);
 
-        if(!capframe)
+        // if nothing has written to this memory since it was created, this unmap is its creation
+        // upload (e.g. a static mesh written once). That's kept in the memory's record instead, so
+        // it's replayed on creation, and the memory doesn't have to be read back and saved as
+        // initial contents in every capture while nothing else writes to it.
+        if(!capframe && !state.uploadRecorded && !GetResourceManager()->IsResourceDirty(id))
+          recordUpload = true;
+        else if(!capframe)
           GetResourceManager()->MarkDirtyResource(id);
       }
 
+      if(recordUpload)
+      {
+        CACHE_THREAD_SERIALISER();
+
+        SCOPED_SERIALISE_CONTEXT(UNMAP_MEM);
+        Serialise_vkUnmapMemory(localSerialiser, device, mem);
+
+        memrecord->AddChunk(scope.Get());
+
+        state.uploadRecorded = true;
+      }
+
       if(capframe)
       {
         // coherent maps must always serialise all data on unmap, even if a flush was seen, because
@@ -653,6 +692,9 @@ void WrappedVulkan::vkUnmapMemory(VkDevice device, VkDeviceMemory mem)
 
     Serialiser::FreeAlignedBuffer(state.refData);
 
+    WriteWatch::End(state.writeWatch);
+    state.writeWatch = NULL;
+
     if(state.mapCoherent)
     {
       SCOPED_LOCK(m_CoherentMapsLock);
@@ -798,6 +840,50 @@ VkResult WrappedVulkan::vkFlushMappedMemoryRanges(VkDevice device, uint32_t memR
   return ret;
 }
 
+void WrappedVulkan::FlushWatchedMap(VkResourceRecord *record)
+{
+  MemMapState &state = *record->memMapState;
+
+  vector<std::pair<size_t, size_t> > ranges;
+
+  if(state.writeWatchSynced)
+  {
+    WriteWatch::GetDirtyRanges(state.writeWatch, ranges);
+  }
+  else
+  {
+    // this was mapped during the capture so none of it has been saved yet. Save all of it now and
+    // only track writes from here on
+    WriteWatch::Reset(state.writeWatch);
+    ranges.push_back(std::make_pair((size_t)0, (size_t)state.mapSize));
+    state.writeWatchSynced = true;
+  }
+
+  // the dirty pages take the place of diffing against reference data
+  state.needRefData = false;
+
+  if(ranges.empty())
+  {
+    RDCDEBUG("Persistent map flush not needed for %llu", record->GetResourceID());
+    return;
+  }
+
+  // MULTIDEVICE should find the device for this queue.
+  VkDevice dev = GetDev();
+
+  for(size_t i = 0; i < ranges.size(); i++)
+  {
+    VkMappedMemoryRange range = {
+        VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, NULL, (VkDeviceMemory)(uint64_t)record->Resource,
+        state.mapOffset + ranges[i].first, ranges[i].second - ranges[i].first};
+    vkFlushMappedMemoryRanges(dev, 1, &range);
+  }
+
+  state.mapFlushed = false;
+
+  GetResourceManager()->MarkPendingDirty(record->GetResourceID());
+}
+
 VkResult WrappedVulkan::vkInvalidateMappedMemoryRanges(VkDevice device, uint32_t memRangeCount,
                                                        const VkMappedMemoryRange *pMemRanges)
 {
@@ -831,6 +917,8 @@ bool WrappedVulkan::Serialise_vkBindBufferMemory(Serialiser *localSerialiser, Vk
     mem = GetResourceManager()->GetLiveHandle<VkDeviceMemory>(memId);
 
     ObjDisp(device)->BindBufferMemory(Unwrap(device), Unwrap(buffer), Unwrap(mem), offs);
+
+    m_CreationInfo.m_Buffer[GetResID(buffer)].memory = GetResID(mem);
   }
 
   return true;
@@ -861,6 +949,11 @@ VkResult WrappedVulkan::vkBindBufferMemory(VkDevice device, VkBuffer buffer, VkD
 
     record->AddParent(GetRecord(mem));
     record->baseResource = GetResID(mem);
+
+    VkMemoryRequirements mrq = {0};
+    ObjDisp(device)->GetBufferMemoryRequirements(Unwrap(device), Unwrap(buffer), &mrq);
+
+    AddMemoryBinding(GetResID(mem), record->GetResourceID(), memOffset, mrq.size);
   }
 
   return ObjDisp(device)->BindBufferMemory(Unwrap(device), Unwrap(buffer), Unwrap(mem), memOffset);
@@ -882,6 +975,8 @@ bool WrappedVulkan::Serialise_vkBindImageMemory(Serialiser *localSerialiser, VkD
     mem = GetResourceManager()->GetLiveHandle<VkDeviceMemory>(memId);
 
     ObjDisp(device)->BindImageMemory(Unwrap(device), Unwrap(image), Unwrap(mem), offs);
+
+    m_CreationInfo.m_Image[GetResID(image)].memory = GetResID(mem);
   }
 
   return true;
@@ -916,6 +1011,11 @@ VkResult WrappedVulkan::vkBindImageMemory(VkDevice device, VkImage image, VkDevi
     // Anything that looks up a baseResource for an image knows not to chase further
     // than the image.
     record->baseResource = GetResID(mem);
+
+    VkMemoryRequirements mrq = {0};
+    ObjDisp(device)->GetImageMemoryRequirements(Unwrap(device), Unwrap(image), &mrq);
+
+    AddMemoryBinding(GetResID(mem), record->GetResourceID(), memOffset, mrq.size);
   }
 
   return ObjDisp(device)->BindImageMemory(Unwrap(device), Unwrap(image), Unwrap(mem), memOffset);
@@ -1104,6 +1204,19 @@ VkResult WrappedVulkan::vkCreateBufferView(VkDevice device, const VkBufferViewCr
       // store the base resource
       record->baseResource = bufferRecord->baseResource;
       record->sparseInfo = bufferRecord->sparseInfo;
+
+      // texel buffer views refer to the memory directly rather than to the buffer, so they get
+      // their own binding covering the viewed range
+      MemoryBinding bufferBinding;
+      if(FindMemoryBinding(bufferRecord->baseResource, bufferRecord->GetResourceID(), bufferBinding))
+      {
+        VkDeviceSize size = pCreateInfo->range;
+        if(size == VK_WHOLE_SIZE)
+          size = bufferBinding.size - RDCMIN(bufferBinding.size, pCreateInfo->offset);
+
+        AddMemoryBinding(bufferRecord->baseResource, record->GetResourceID(),
+                         bufferBinding.offset + pCreateInfo->offset, size);
+      }
     }
     else
     {
@@ -303,48 +303,34 @@ bool WrappedVulkan::Serialise_vkCreateGraphicsPipelines(
 {
   SERIALISE_ELEMENT(ResourceId, devId, GetResID(device));
   SERIALISE_ELEMENT(ResourceId, cacheId, GetResID(pipelineCache));
-  SERIALISE_ELEMENT(VkGraphicsPipelineCreateInfo, info, *pCreateInfos);
+
+  // not deserialised on scope exit, as the pipeline might be created later from the queue
+  VkGraphicsPipelineCreateInfo info;
+  if(m_State >= WRITING)
+    info = *pCreateInfos;
+  localSerialiser->Serialise("info", info);
+
   SERIALISE_ELEMENT(ResourceId, id, GetResID(*pPipelines));
 
   if(m_State == READING)
   {
-    VkPipeline pipe = VK_NULL_HANDLE;
-
-    device = GetResourceManager()->GetLiveHandle<VkDevice>(devId);
-    // don't use pipeline caches on replay
-    pipelineCache =
-        VK_NULL_HANDLE;    // GetResourceManager()->GetLiveHandle<VkPipelineCache>(cacheId);
-
-    VkResult ret = ObjDisp(device)->CreateGraphicsPipelines(Unwrap(device), Unwrap(pipelineCache),
-                                                            1, &info, NULL, &pipe);
-
-    if(ret != VK_SUCCESS)
+    PendingPipeline pending;
+    pending.device = GetResourceManager()->GetLiveHandle<VkDevice>(devId);
+    // don't use the captured pipeline caches on replay, only our own persistent one
+    pending.cache = GetReplayPipelineCache();
+    pending.id = id;
+    pending.compute = false;
+    pending.graphicsInfo = info;
+
+    // the base pipeline may still be queued. Deriving is only a hint, so drop it.
+    if(m_DeferPipelineCreation && (info.flags & VK_PIPELINE_CREATE_DERIVATIVE_BIT))
     {
-      RDCERR("Failed on resource serialise-creation, VkResult: 0x%08x", ret);
+      pending.graphicsInfo.flags &= ~VK_PIPELINE_CREATE_DERIVATIVE_BIT;
+      pending.graphicsInfo.basePipelineHandle = VK_NULL_HANDLE;
+      pending.graphicsInfo.basePipelineIndex = -1;
     }
-    else
-    {
-      ResourceId live;
-
-      if(GetResourceManager()->HasWrapper(ToTypedHandle(pipe)))
-      {
-        live = GetResourceManager()->GetNonDispWrapper(pipe)->id;
-
-        // destroy this instance of the duplicate, as we must have matching create/destroy
-        // calls and there won't be a wrapped resource hanging around to destroy this one.
-        ObjDisp(device)->DestroyPipeline(Unwrap(device), pipe, NULL);
-
-        // whenever the new ID is requested, return the old ID, via replacements.
-        GetResourceManager()->ReplaceResource(id, GetResourceManager()->GetOriginalID(live));
-      }
-      else
-      {
-        live = GetResourceManager()->WrapResource(Unwrap(device), pipe);
-        GetResourceManager()->AddLiveResource(id, pipe);
 
-        m_CreationInfo.m_Pipeline[live].Init(GetResourceManager(), m_CreationInfo, &info);
-      }
-    }
+    QueuePendingPipeline(pending);
   }
 
   return true;
@@ -459,46 +445,34 @@ bool WrappedVulkan::Serialise_vkCreateComputePipelines(Serialiser *localSerialis
 {
   SERIALISE_ELEMENT(ResourceId, devId, GetResID(device));
   SERIALISE_ELEMENT(ResourceId, cacheId, GetResID(pipelineCache));
-  SERIALISE_ELEMENT(VkComputePipelineCreateInfo, info, *pCreateInfos);
+
+  // not deserialised on scope exit, as the pipeline might be created later from the queue
+  VkComputePipelineCreateInfo info;
+  if(m_State >= WRITING)
+    info = *pCreateInfos;
+  localSerialiser->Serialise("info", info);
+
   SERIALISE_ELEMENT(ResourceId, id, GetResID(*pPipelines));
 
   if(m_State == READING)
   {
-    VkPipeline pipe = VK_NULL_HANDLE;
-
-    device = GetResourceManager()->GetLiveHandle<VkDevice>(devId);
-    pipelineCache = GetResourceManager()->GetLiveHandle<VkPipelineCache>(cacheId);
-
-    VkResult ret = ObjDisp(device)->CreateComputePipelines(Unwrap(device), Unwrap(pipelineCache), 1,
-                                                           &info, NULL, &pipe);
-
-    if(ret != VK_SUCCESS)
+    PendingPipeline pending;
+    pending.device = GetResourceManager()->GetLiveHandle<VkDevice>(devId);
+    // don't use the captured pipeline caches on replay, only our own persistent one
+    pending.cache = GetReplayPipelineCache();
+    pending.id = id;
+    pending.compute = true;
+    pending.computeInfo = info;
+
+    // the base pipeline may still be queued. Deriving is only a hint, so drop it.
+    if(m_DeferPipelineCreation && (info.flags & VK_PIPELINE_CREATE_DERIVATIVE_BIT))
     {
-      RDCERR("Failed on resource serialise-creation, VkResult: 0x%08x", ret);
+      pending.computeInfo.flags &= ~VK_PIPELINE_CREATE_DERIVATIVE_BIT;
+      pending.computeInfo.basePipelineHandle = VK_NULL_HANDLE;
+      pending.computeInfo.basePipelineIndex = -1;
     }
-    else
-    {
-      ResourceId live;
-
-      if(GetResourceManager()->HasWrapper(ToTypedHandle(pipe)))
-      {
-        live = GetResourceManager()->GetNonDispWrapper(pipe)->id;
-
-        // destroy this instance of the duplicate, as we must have matching create/destroy
-        // calls and there won't be a wrapped resource hanging around to destroy this one.
-        ObjDisp(device)->DestroyPipeline(Unwrap(device), pipe, NULL);
-
-        // whenever the new ID is requested, return the old ID, via replacements.
-        GetResourceManager()->ReplaceResource(id, GetResourceManager()->GetOriginalID(live));
-      }
-      else
-      {
-        live = GetResourceManager()->WrapResource(Unwrap(device), pipe);
-        GetResourceManager()->AddLiveResource(id, pipe);
 
-        m_CreationInfo.m_Pipeline[live].Init(GetResourceManager(), m_CreationInfo, &info);
-      }
-    }
+    QueuePendingPipeline(pending);
   }
 
   return true;
@@ -591,13 +591,16 @@ void WrappedVulkan::vkCmdSetEvent(VkCommandBuffer cmdBuffer, VkEvent event,
   {
     VkResourceRecord *record = GetRecord(cmdBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(CMD_SET_EVENT);
-    Serialise_vkCmdSetEvent(localSerialiser, cmdBuffer, event, stageMask);
+      SCOPED_SERIALISE_CONTEXT(CMD_SET_EVENT);
+      Serialise_vkCmdSetEvent(localSerialiser, cmdBuffer, event, stageMask);
 
-    record->AddChunk(scope.Get());
-    record->MarkResourceFrameReferenced(GetResID(event), eFrameRef_Read);
+      record->AddChunk(scope.Get());
+      record->MarkResourceFrameReferenced(GetResID(event), eFrameRef_Read);
+    }
   }
 }
 
@@ -647,13 +650,16 @@ void WrappedVulkan::vkCmdResetEvent(VkCommandBuffer cmdBuffer, VkEvent event,
   {
     VkResourceRecord *record = GetRecord(cmdBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(CMD_RESET_EVENT);
-    Serialise_vkCmdResetEvent(localSerialiser, cmdBuffer, event, stageMask);
+      SCOPED_SERIALISE_CONTEXT(CMD_RESET_EVENT);
+      Serialise_vkCmdResetEvent(localSerialiser, cmdBuffer, event, stageMask);
 
-    record->AddChunk(scope.Get());
-    record->MarkResourceFrameReferenced(GetResID(event), eFrameRef_Read);
+      record->AddChunk(scope.Get());
+      record->MarkResourceFrameReferenced(GetResID(event), eFrameRef_Read);
+    }
   }
 }
 
@@ -817,22 +823,22 @@ void WrappedVulkan::vkCmdWaitEvents(VkCommandBuffer cmdBuffer, uint32_t eventCou
   {
     VkResourceRecord *record = GetRecord(cmdBuffer);
 
-    CACHE_THREAD_SERIALISER();
+    if(!record->cmdInfo->untracked)
+    {
+      CACHE_THREAD_SERIALISER();
 
-    SCOPED_SERIALISE_CONTEXT(CMD_WAIT_EVENTS);
-    Serialise_vkCmdWaitEvents(localSerialiser, cmdBuffer, eventCount, pEvents, srcStageMask,
-                              dstStageMask, memoryBarrierCount, pMemoryBarriers,
-                              bufferMemoryBarrierCount, pBufferMemoryBarriers,
-                              imageMemoryBarrierCount, pImageMemoryBarriers);
+      SCOPED_SERIALISE_CONTEXT(CMD_WAIT_EVENTS);
+      Serialise_vkCmdWaitEvents(localSerialiser, cmdBuffer, eventCount, pEvents, srcStageMask,
+                                dstStageMask, memoryBarrierCount, pMemoryBarriers,
+                                bufferMemoryBarrierCount, pBufferMemoryBarriers,
+                                imageMemoryBarrierCount, pImageMemoryBarriers);
 
-    if(imageMemoryBarrierCount > 0)
-    {
-      SCOPED_LOCK(m_ImageLayoutsLock);
-      GetResourceManager()->RecordBarriers(GetRecord(cmdBuffer)->cmdInfo->imgbarriers, m_ImageLayouts,
-                                           imageMemoryBarrierCount, pImageMemoryBarriers);
+      if(imageMemoryBarrierCount > 0)
+        RecordCmdImageBarriers(record, imageMemoryBarrierCount, pImageMemoryBarriers);
+
+      record->AddChunk(scope.Get());
     }
 
-    record->AddChunk(scope.Get());
     for(uint32_t i = 0; i < eventCount; i++)
       record->MarkResourceFrameReferenced(GetResID(pEvents[i]), eFrameRef_Read);
   }
@@ -616,6 +616,8 @@ VkResult WrappedVulkan::vkQueuePresentKHR(VkQueue queue, const VkPresentInfoKHR
     RenderDoc::Inst().Tick();
 
     GetResourceManager()->FlushPendingDirty();
+
+    PrepareInitialStateAhead();
   }
 
   m_FrameCounter++;    // first present becomes frame #1, this function is at the end of the frame
@@ -721,9 +723,15 @@ VkResult WrappedVulkan::vkQueuePresentKHR(VkQueue queue, const VkPresentInfoKHR
 
   RenderDoc::Inst().SetCurrentDriver(RDC_Vulkan);
 
-  // kill any current capture that isn't application defined
+  // kill any current capture that isn't application defined, unless it's set to record more
+  // frames, in which case just mark where this one ended
   if(m_State == WRITING_CAPFRAME && !m_AppControlledCapture)
-    RenderDoc::Inst().EndFrameCapture(LayerDisp(m_Instance), swapInfo.wndHandle);
+  {
+    if(RenderDoc::Inst().ShouldContinueFrameCapture())
+      AddFrameBoundary(swapInfo.images[swapInfo.lastPresent].im);
+    else
+      RenderDoc::Inst().EndFrameCapture(LayerDisp(m_Instance), swapInfo.wndHandle);
+  }
 
   if(RenderDoc::Inst().ShouldTriggerCapture(m_FrameCounter) && m_State == WRITING_IDLE)
   {
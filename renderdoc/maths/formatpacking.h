@@ -136,7 +136,17 @@ inline float ConvertFromSRGB8(uint8_t comp)
   return SRGB8_lookuptable[comp];
 }
 
+inline void ConvertFromSRGB8(const uint8_t *in, float *out, size_t count)
+{
+  for(size_t i = 0; i < count; i++)
+    out[i] = SRGB8_lookuptable[in[i]];
+}
+
 struct ResourceFormat;
 float ConvertComponent(const ResourceFormat &fmt, byte *data);
 
+// converts count tightly packed components of a regular (non-special) format, with the same
+// results as calling ConvertComponent on each one.
+void ConvertComponents(const ResourceFormat &fmt, const byte *data, size_t count, float *out);
+
 #include "half_convert.h"
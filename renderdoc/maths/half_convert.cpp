@@ -0,0 +1,296 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "common/common.h"
+#include "half_convert.h"
+
+// The bulk conversion has SIMD implementations selected at runtime based on the CPU, using the
+// same detection as FindDiffRange. The scalar version computes every case and selects at the end
+// rather than branching, and the SSE2 and NEON versions do exactly the same on 4 halfs at a time.
+// F16C converts in hardware, but gives signed zeroes and keeps infinities and NaNs, so those lanes
+// are patched afterwards to match ConvertFromHalf.
+
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#define HALF_CONVERT_X86 OPTION_ON
+#else
+#define HALF_CONVERT_X86 OPTION_OFF
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define HALF_CONVERT_NEON OPTION_ON
+#else
+#define HALF_CONVERT_NEON OPTION_OFF
+#endif
+
+#if ENABLED(HALF_CONVERT_X86)
+
+#include <emmintrin.h>
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#define HALF_CONVERT_F16C_FUNC
+#define HALF_CONVERT_AVX2_FUNC
+#else
+#define HALF_CONVERT_F16C_FUNC __attribute__((target("f16c")))
+#define HALF_CONVERT_AVX2_FUNC __attribute__((target("avx2,f16c")))
+#endif
+
+#elif ENABLED(HALF_CONVERT_NEON)
+
+#include <arm_neon.h>
+
+#endif
+
+static void ConvertFromHalf_Scalar(const uint16_t *in, float *out, size_t count)
+{
+  union
+  {
+    uint32_t u;
+    float f;
+  } subnormal, result;
+
+  for(size_t i = 0; i < count; i++)
+  {
+    uint32_t h = in[i];
+    uint32_t sign = (h & 0x8000) << 16;
+    uint32_t exponent = h & 0x7C00;
+    uint32_t mantissa = h & 0x03FF;
+
+    // normal numbers only need the exponent rebiased and the mantissa shifted up
+    uint32_t normal = sign | (((h & 0x7FFF) << 13) + ((127 - 15) << 23));
+
+    // subnormals are mantissa * 2^-24, which is exact in a float. Zero stays positive.
+    subnormal.f = float(mantissa) * (1.0f / 16777216.0f);
+    subnormal.u |= mantissa ? sign : 0;
+
+    result.u = exponent == 0x7C00 ? 0x7F800001 : (exponent == 0 ? subnormal.u : normal);
+    out[i] = result.f;
+  }
+}
+
+#if ENABLED(HALF_CONVERT_X86)
+
+// h holds 4 halfs zero-extended to 32-bit, returns the float bits
+static __m128i HalfToFloat_SSE2(__m128i h)
+{
+  const __m128i zero = _mm_setzero_si128();
+
+  __m128i sign = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x8000)), 16);
+  __m128i exponent = _mm_and_si128(h, _mm_set1_epi32(0x7C00));
+  __m128i mantissa = _mm_and_si128(h, _mm_set1_epi32(0x03FF));
+
+  __m128i normal = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x7FFF)), 13);
+  normal = _mm_or_si128(sign, _mm_add_epi32(normal, _mm_set1_epi32((127 - 15) << 23)));
+
+  __m128 subnormalf = _mm_mul_ps(_mm_cvtepi32_ps(mantissa), _mm_set1_ps(1.0f / 16777216.0f));
+  __m128i subnormal = _mm_castps_si128(subnormalf);
+  subnormal = _mm_or_si128(subnormal, _mm_andnot_si128(_mm_cmpeq_epi32(mantissa, zero), sign));
+
+  __m128i isSubnormal = _mm_cmpeq_epi32(exponent, zero);
+  __m128i isSpecial = _mm_cmpeq_epi32(exponent, _mm_set1_epi32(0x7C00));
+
+  __m128i ret =
+      _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+
+  return _mm_or_si128(_mm_and_si128(isSpecial, _mm_set1_epi32(0x7F800001)),
+                      _mm_andnot_si128(isSpecial, ret));
+}
+
+// f is the hardware conversion of the 4 halfs in h, zero-extended to 32-bit
+static __m128 PatchHardwareHalfs_SSE2(__m128i h, __m128 f)
+{
+  __m128i isZero = _mm_cmpeq_epi32(_mm_and_si128(h, _mm_set1_epi32(0x7FFF)), _mm_setzero_si128());
+  __m128i isSpecial =
+      _mm_cmpeq_epi32(_mm_and_si128(h, _mm_set1_epi32(0x7C00)), _mm_set1_epi32(0x7C00));
+
+  __m128i ret = _mm_andnot_si128(isZero, _mm_castps_si128(f));
+
+  ret = _mm_or_si128(_mm_and_si128(isSpecial, _mm_set1_epi32(0x7F800001)),
+                     _mm_andnot_si128(isSpecial, ret));
+
+  return _mm_castsi128_ps(ret);
+}
+
+static void ConvertFromHalf_SSE2(const uint16_t *in, float *out, size_t count)
+{
+  const __m128i zero = _mm_setzero_si128();
+
+  size_t i = 0;
+
+  for(; i + 8 <= count; i += 8)
+  {
+    __m128i h = _mm_loadu_si128((const __m128i *)(in + i));
+
+    _mm_storeu_si128((__m128i *)(out + i), HalfToFloat_SSE2(_mm_unpacklo_epi16(h, zero)));
+    _mm_storeu_si128((__m128i *)(out + i + 4), HalfToFloat_SSE2(_mm_unpackhi_epi16(h, zero)));
+  }
+
+  ConvertFromHalf_Scalar(in + i, out + i, count - i);
+}
+
+HALF_CONVERT_F16C_FUNC static void ConvertFromHalf_F16C(const uint16_t *in, float *out,
+                                                        size_t count)
+{
+  const __m128i zero = _mm_setzero_si128();
+
+  size_t i = 0;
+
+  for(; i + 8 <= count; i += 8)
+  {
+    __m128i h = _mm_loadu_si128((const __m128i *)(in + i));
+
+    __m128 lo = _mm_cvtph_ps(h);
+    __m128 hi = _mm_cvtph_ps(_mm_unpackhi_epi64(h, h));
+
+    _mm_storeu_ps(out + i, PatchHardwareHalfs_SSE2(_mm_unpacklo_epi16(h, zero), lo));
+    _mm_storeu_ps(out + i + 4, PatchHardwareHalfs_SSE2(_mm_unpackhi_epi16(h, zero), hi));
+  }
+
+  ConvertFromHalf_Scalar(in + i, out + i, count - i);
+}
+
+HALF_CONVERT_AVX2_FUNC static void ConvertFromHalf_AVX2(const uint16_t *in, float *out,
+                                                        size_t count)
+{
+  const __m256i magnitudeMask = _mm256_set1_epi32(0x7FFF);
+  const __m256i exponentMask = _mm256_set1_epi32(0x7C00);
+  const __m256 nan = _mm256_castsi256_ps(_mm256_set1_epi32(0x7F800001));
+
+  size_t i = 0;
+
+  for(; i + 8 <= count; i += 8)
+  {
+    __m128i h16 = _mm_loadu_si128((const __m128i *)(in + i));
+    __m256i h = _mm256_cvtepu16_epi32(h16);
+
+    __m256 f = _mm256_cvtph_ps(h16);
+
+    __m256i isZero = _mm256_cmpeq_epi32(_mm256_and_si256(h, magnitudeMask), _mm256_setzero_si256());
+    __m256i isSpecial = _mm256_cmpeq_epi32(_mm256_and_si256(h, exponentMask), exponentMask);
+
+    f = _mm256_andnot_ps(_mm256_castsi256_ps(isZero), f);
+    f = _mm256_blendv_ps(f, nan, _mm256_castsi256_ps(isSpecial));
+
+    _mm256_storeu_ps(out + i, f);
+  }
+
+  ConvertFromHalf_Scalar(in + i, out + i, count - i);
+}
+
+#elif ENABLED(HALF_CONVERT_NEON)
+
+// h holds 4 halfs zero-extended to 32-bit, returns the float bits
+static uint32x4_t HalfToFloat_NEON(uint32x4_t h)
+{
+  const uint32x4_t zero = vdupq_n_u32(0);
+
+  uint32x4_t sign = vshlq_n_u32(vandq_u32(h, vdupq_n_u32(0x8000)), 16);
+  uint32x4_t exponent = vandq_u32(h, vdupq_n_u32(0x7C00));
+  uint32x4_t mantissa = vandq_u32(h, vdupq_n_u32(0x03FF));
+
+  uint32x4_t normal = vshlq_n_u32(vandq_u32(h, vdupq_n_u32(0x7FFF)), 13);
+  normal = vorrq_u32(sign, vaddq_u32(normal, vdupq_n_u32((127 - 15) << 23)));
+
+  float32x4_t subnormalf = vmulq_n_f32(vcvtq_f32_u32(mantissa), 1.0f / 16777216.0f);
+  uint32x4_t subnormal = vreinterpretq_u32_f32(subnormalf);
+  subnormal = vorrq_u32(subnormal, vbicq_u32(sign, vceqq_u32(mantissa, zero)));
+
+  uint32x4_t ret = vbslq_u32(vceqq_u32(exponent, zero), subnormal, normal);
+
+  return vbslq_u32(vceqq_u32(exponent, vdupq_n_u32(0x7C00)), vdupq_n_u32(0x7F800001), ret);
+}
+
+static void ConvertFromHalf_NEON(const uint16_t *in, float *out, size_t count)
+{
+  size_t i = 0;
+
+  for(; i + 8 <= count; i += 8)
+  {
+    uint16x8_t h = vld1q_u16(in + i);
+
+    uint32x4_t lo = HalfToFloat_NEON(vmovl_u16(vget_low_u16(h)));
+    uint32x4_t hi = HalfToFloat_NEON(vmovl_u16(vget_high_u16(h)));
+
+    vst1q_f32(out + i, vreinterpretq_f32_u32(lo));
+    vst1q_f32(out + i + 4, vreinterpretq_f32_u32(hi));
+  }
+
+  ConvertFromHalf_Scalar(in + i, out + i, count - i);
+}
+
+#endif
+
+static const HalfConvertImplementation halfConvertImpls[] = {
+    {"Scalar", &ConvertFromHalf_Scalar},
+#if ENABLED(HALF_CONVERT_X86)
+    {"SSE2", &ConvertFromHalf_SSE2},
+    {"F16C", &ConvertFromHalf_F16C},
+    {"AVX2", &ConvertFromHalf_AVX2},
+#elif ENABLED(HALF_CONVERT_NEON)
+    {"NEON", &ConvertFromHalf_NEON},
+#endif
+};
+
+static size_t CountSupportedHalfConvertImpls()
+{
+  size_t count = 1;
+
+#if ENABLED(HALF_CONVERT_X86)
+  // each implementation needs everything the previous one did. The AVX2 path also uses F16C
+  if(CPUSupportsSSE2())
+  {
+    count++;
+
+    if(CPUSupportsF16C())
+    {
+      count++;
+
+      if(CPUSupportsAVX2())
+        count++;
+    }
+  }
+#elif ENABLED(HALF_CONVERT_NEON)
+  count++;
+#endif
+
+  return count;
+}
+
+size_t GetHalfConvertImplementations(const HalfConvertImplementation **impls)
+{
+  static const size_t count = CountSupportedHalfConvertImpls();
+
+  if(impls)
+    *impls = halfConvertImpls;
+
+  return count;
+}
+
+void ConvertFromHalf(const uint16_t *in, float *out, size_t count)
+{
+  static const HalfConvertImplementation &impl =
+      halfConvertImpls[GetHalfConvertImplementations(NULL) - 1];
+
+  impl.func(in, out, count);
+}
@@ -130,3 +130,16 @@ inline float ConvertFromHalf(uint16_t comp)
     return nan.f;
   }
 }
+
+// converts count halfs to floats with the same results as ConvertFromHalf. There are SIMD
+// implementations picked at runtime based on the CPU, defined in half_convert.cpp.
+void ConvertFromHalf(const uint16_t *in, float *out, size_t count);
+
+// the implementations of the bulk ConvertFromHalf usable on this CPU, in increasing order of
+// preference. ConvertFromHalf always uses the last one, the list is only exposed for benchmarking.
+struct HalfConvertImplementation
+{
+  const char *name;
+  void (*func)(const uint16_t *in, float *out, size_t count);
+};
+size_t GetHalfConvertImplementations(const HalfConvertImplementation **impls);
@@ -28,9 +28,32 @@
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
+#include "common/globalconfig.h"
 #include "quat.h"
 #include "vec.h"
 
+// Mul and the point transforms are a weighted sum of the matrix columns, which maps directly onto
+// 4-wide vectors since the matrix is column-major. SSE2 and NEON are always present on the 64-bit
+// targets so the implementation is picked at compile time, with a scalar fallback otherwise.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MATRIX_SSE2 OPTION_ON
+#else
+#define MATRIX_SSE2 OPTION_OFF
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define MATRIX_NEON OPTION_ON
+#else
+#define MATRIX_NEON OPTION_OFF
+#endif
+
+#if ENABLED(MATRIX_SSE2)
+#include <emmintrin.h>
+#elif ENABLED(MATRIX_NEON)
+#include <arm_neon.h>
+#endif
+
 // colour ramp from http://www.ncl.ucar.edu/Document/Graphics/ColorTables/GMT_wysiwyg.shtml
 const Vec4f overdrawRamp[128] = {
     Vec4f(0.000000f, 0.000000f, 0.000000f, 0.0f), Vec4f(0.250980f, 0.000000f, 0.250980f, 1.0f),
@@ -107,6 +130,39 @@ static inline size_t matIdx(const size_t x, const size_t y)
 Matrix4f Matrix4f::Mul(const Matrix4f &o) const
 {
   Matrix4f m;
+
+#if ENABLED(MATRIX_SSE2)
+  __m128 c0 = _mm_loadu_ps(&f[0]);
+  __m128 c1 = _mm_loadu_ps(&f[4]);
+  __m128 c2 = _mm_loadu_ps(&f[8]);
+  __m128 c3 = _mm_loadu_ps(&f[12]);
+
+  // each column of the result is our columns weighted by the matching column of o
+  for(size_t y = 0; y < 4; y++)
+  {
+    const float *oc = &o.f[y * 4];
+    __m128 r = _mm_mul_ps(c0, _mm_set1_ps(oc[0]));
+    r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(oc[1])));
+    r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(oc[2])));
+    r = _mm_add_ps(r, _mm_mul_ps(c3, _mm_set1_ps(oc[3])));
+    _mm_storeu_ps(&m.f[y * 4], r);
+  }
+#elif ENABLED(MATRIX_NEON)
+  float32x4_t c0 = vld1q_f32(&f[0]);
+  float32x4_t c1 = vld1q_f32(&f[4]);
+  float32x4_t c2 = vld1q_f32(&f[8]);
+  float32x4_t c3 = vld1q_f32(&f[12]);
+
+  for(size_t y = 0; y < 4; y++)
+  {
+    const float *oc = &o.f[y * 4];
+    float32x4_t r = vmulq_n_f32(c0, oc[0]);
+    r = vmlaq_n_f32(r, c1, oc[1]);
+    r = vmlaq_n_f32(r, c2, oc[2]);
+    r = vmlaq_n_f32(r, c3, oc[3]);
+    vst1q_f32(&m.f[y * 4], r);
+  }
+#else
   for(size_t x = 0; x < 4; x++)
   {
     for(size_t y = 0; y < 4; y++)
@@ -116,6 +172,7 @@ Matrix4f Matrix4f::Mul(const Matrix4f &o) const
           (*this)[matIdx(x, 2)] * o[matIdx(2, y)] + (*this)[matIdx(x, 3)] * o[matIdx(3, y)];
     }
   }
+#endif
 
   return m;
 }
@@ -205,6 +262,103 @@ Vec3f Matrix4f::Transform(const Vec3f &v, const float w) const
   return vout * (1.0f / wout);
 }
 
+void Matrix4f::TransformPoints(const Vec3f *in, Vec3f *out, size_t count, const float w) const
+{
+#if ENABLED(MATRIX_SSE2)
+  __m128 c0 = _mm_loadu_ps(&f[0]);
+  __m128 c1 = _mm_loadu_ps(&f[4]);
+  __m128 c2 = _mm_loadu_ps(&f[8]);
+  // the w column is the same for every point, so fold it into the translation once
+  __m128 c3 = _mm_mul_ps(_mm_loadu_ps(&f[12]), _mm_set1_ps(w));
+
+  for(size_t i = 0; i < count; i++)
+  {
+    __m128 r = _mm_mul_ps(c0, _mm_set1_ps(in[i].x));
+    r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(in[i].y)));
+    r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(in[i].z)));
+    r = _mm_add_ps(r, c3);
+
+    // multiply by the reciprocal rather than dividing, to match Transform() exactly
+    float invW = 1.0f / _mm_cvtss_f32(_mm_shuffle_ps(r, r, _MM_SHUFFLE(3, 3, 3, 3)));
+    r = _mm_mul_ps(r, _mm_set1_ps(invW));
+
+    float res[4];
+    _mm_storeu_ps(res, r);
+    out[i] = Vec3f(res[0], res[1], res[2]);
+  }
+#elif ENABLED(MATRIX_NEON)
+  float32x4_t c0 = vld1q_f32(&f[0]);
+  float32x4_t c1 = vld1q_f32(&f[4]);
+  float32x4_t c2 = vld1q_f32(&f[8]);
+  float32x4_t c3 = vmulq_n_f32(vld1q_f32(&f[12]), w);
+
+  for(size_t i = 0; i < count; i++)
+  {
+    float32x4_t r = vmulq_n_f32(c0, in[i].x);
+    r = vmlaq_n_f32(r, c1, in[i].y);
+    r = vmlaq_n_f32(r, c2, in[i].z);
+    r = vaddq_f32(r, c3);
+    r = vmulq_n_f32(r, 1.0f / vgetq_lane_f32(r, 3));
+
+    out[i] = Vec3f(vgetq_lane_f32(r, 0), vgetq_lane_f32(r, 1), vgetq_lane_f32(r, 2));
+  }
+#else
+  for(size_t i = 0; i < count; i++)
+    out[i] = Transform(in[i], w);
+#endif
+}
+
+void Matrix4f::TransformPoints(const Vec3f *in, Vec4f *out, size_t count, const float w) const
+{
+#if ENABLED(MATRIX_SSE2)
+  __m128 c0 = _mm_loadu_ps(&f[0]);
+  __m128 c1 = _mm_loadu_ps(&f[4]);
+  __m128 c2 = _mm_loadu_ps(&f[8]);
+  __m128 c3 = _mm_mul_ps(_mm_loadu_ps(&f[12]), _mm_set1_ps(w));
+
+  for(size_t i = 0; i < count; i++)
+  {
+    __m128 r = _mm_mul_ps(c0, _mm_set1_ps(in[i].x));
+    r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(in[i].y)));
+    r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(in[i].z)));
+    r = _mm_add_ps(r, c3);
+
+    float res[4];
+    _mm_storeu_ps(res, r);
+    out[i] = Vec4f(res[0], res[1], res[2], res[3]);
+  }
+#elif ENABLED(MATRIX_NEON)
+  float32x4_t c0 = vld1q_f32(&f[0]);
+  float32x4_t c1 = vld1q_f32(&f[4]);
+  float32x4_t c2 = vld1q_f32(&f[8]);
+  float32x4_t c3 = vmulq_n_f32(vld1q_f32(&f[12]), w);
+
+  for(size_t i = 0; i < count; i++)
+  {
+    float32x4_t r = vmulq_n_f32(c0, in[i].x);
+    r = vmlaq_n_f32(r, c1, in[i].y);
+    r = vmlaq_n_f32(r, c2, in[i].z);
+    r = vaddq_f32(r, c3);
+
+    out[i] = Vec4f(vgetq_lane_f32(r, 0), vgetq_lane_f32(r, 1), vgetq_lane_f32(r, 2),
+                   vgetq_lane_f32(r, 3));
+  }
+#else
+  for(size_t i = 0; i < count; i++)
+  {
+    const Vec3f v = in[i];
+    out[i] = Vec4f(f[matIdx(0, 0)] * v.x + f[matIdx(0, 1)] * v.y + f[matIdx(0, 2)] * v.z +
+                       f[matIdx(0, 3)] * w,
+                   f[matIdx(1, 0)] * v.x + f[matIdx(1, 1)] * v.y + f[matIdx(1, 2)] * v.z +
+                       f[matIdx(1, 3)] * w,
+                   f[matIdx(2, 0)] * v.x + f[matIdx(2, 1)] * v.y + f[matIdx(2, 2)] * v.z +
+                       f[matIdx(2, 3)] * w,
+                   f[matIdx(3, 0)] * v.x + f[matIdx(3, 1)] * v.y + f[matIdx(3, 2)] * v.z +
+                       f[matIdx(3, 3)] * w);
+  }
+#endif
+}
+
 const Vec3f Matrix4f::GetPosition() const
 {
   return Vec3f(f[12], f[13], f[14]);
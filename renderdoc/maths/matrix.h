@@ -26,6 +26,7 @@
 #pragma once
 
 class Vec3f;
+struct Vec4f;
 class Quatf;
 
 #include <string.h>
@@ -70,6 +71,12 @@ public:
 
   Vec3f Transform(const Vec3f &v, const float w = 1.0f) const;
 
+  // batched versions of Transform for transforming whole meshes at once. The first divides by the
+  // resulting w like Transform and in and out may be the same array, the second leaves the results
+  // in homogeneous (clip) space.
+  void TransformPoints(const Vec3f *in, Vec3f *out, size_t count, const float w = 1.0f) const;
+  void TransformPoints(const Vec3f *in, Vec4f *out, size_t count, const float w = 1.0f) const;
+
   const float *Data() const { return &f[0]; }
   const Vec3f GetPosition() const;
   const Vec3f GetForward() const;
@@ -152,6 +152,143 @@ string Callstack::AddressDetails::formattedString(const char *commonPath)
   return fmt;
 }
 
+void Callstack::StackResolver::GetAddrs(const uint64_t *addrs, size_t count,
+                                        AddressDetails *details)
+{
+  for(size_t i = 0; i < count; i++)
+    details[i] = GetAddr(addrs[i]);
+}
+
+static const char SymbolCacheMagic[8] = {'R', 'D', 'O', 'C', 'S', 'Y', 'M', 'S'};
+static const uint32_t SymbolCacheVersion = 1;
+
+static void WriteCacheString(vector<byte> &out, const string &str)
+{
+  uint32_t len = (uint32_t)str.size();
+  out.insert(out.end(), (const byte *)&len, (const byte *)(&len + 1));
+  out.insert(out.end(), str.begin(), str.end());
+}
+
+static bool ReadCacheData(const vector<byte> &in, size_t &offs, void *dst, size_t size)
+{
+  if(offs + size > in.size())
+    return false;
+
+  memcpy(dst, &in[offs], size);
+  offs += size;
+  return true;
+}
+
+static bool ReadCacheString(const vector<byte> &in, size_t &offs, string &str)
+{
+  uint32_t len = 0;
+  if(!ReadCacheData(in, offs, &len, sizeof(len)) || offs + len > in.size())
+    return false;
+
+  str.assign((const char *)&in[offs], len);
+  offs += len;
+  return true;
+}
+
+Callstack::SymbolCache::SymbolCache(const string &moduleKey) : m_Key(moduleKey), m_Dirty(false)
+{
+  m_Filename = FileIO::GetAppFolderFilename(
+      StringFormat::Fmt("symcache_%08x.bin", strhash(moduleKey.c_str())));
+
+  vector<byte> data;
+  FileIO::slurp(m_Filename.c_str(), data);
+
+  size_t offs = 0;
+
+  char magic[sizeof(SymbolCacheMagic)] = {};
+  uint32_t version = 0;
+  string key;
+  uint32_t count = 0;
+
+  // a different key means a hash collision with another module, so ignore its entries. They'll
+  // be replaced when we save
+  if(!ReadCacheData(data, offs, magic, sizeof(magic)) ||
+     memcmp(magic, SymbolCacheMagic, sizeof(magic)) != 0 ||
+     !ReadCacheData(data, offs, &version, sizeof(version)) || version != SymbolCacheVersion ||
+     !ReadCacheString(data, offs, key) || key != m_Key ||
+     !ReadCacheData(data, offs, &count, sizeof(count)))
+    return;
+
+  for(uint32_t i = 0; i < count; i++)
+  {
+    uint64_t addrOffset = 0;
+    AddressDetails details;
+
+    if(!ReadCacheData(data, offs, &addrOffset, sizeof(addrOffset)) ||
+       !ReadCacheData(data, offs, &details.line, sizeof(details.line)) ||
+       !ReadCacheString(data, offs, details.function) ||
+       !ReadCacheString(data, offs, details.filename))
+    {
+      RDCWARN("Symbol cache %s is truncated", m_Filename.c_str());
+      break;
+    }
+
+    m_Entries[addrOffset] = details;
+  }
+}
+
+Callstack::SymbolCache::~SymbolCache()
+{
+  Save();
+}
+
+bool Callstack::SymbolCache::Find(uint64_t offset, AddressDetails &details) const
+{
+  auto it = m_Entries.find(offset);
+  if(it == m_Entries.end())
+    return false;
+
+  details = it->second;
+  return true;
+}
+
+void Callstack::SymbolCache::Add(uint64_t offset, const AddressDetails &details)
+{
+  m_Entries[offset] = details;
+  m_Dirty = true;
+}
+
+void Callstack::SymbolCache::Save()
+{
+  if(!m_Dirty)
+    return;
+
+  m_Dirty = false;
+
+  vector<byte> data;
+  data.insert(data.end(), SymbolCacheMagic, SymbolCacheMagic + sizeof(SymbolCacheMagic));
+  data.insert(data.end(), (const byte *)&SymbolCacheVersion,
+              (const byte *)(&SymbolCacheVersion + 1));
+  WriteCacheString(data, m_Key);
+
+  uint32_t count = (uint32_t)m_Entries.size();
+  data.insert(data.end(), (const byte *)&count, (const byte *)(&count + 1));
+
+  for(auto it = m_Entries.begin(); it != m_Entries.end(); ++it)
+  {
+    data.insert(data.end(), (const byte *)&it->first, (const byte *)(&it->first + 1));
+    data.insert(data.end(), (const byte *)&it->second.line, (const byte *)(&it->second.line + 1));
+    WriteCacheString(data, it->second.function);
+    WriteCacheString(data, it->second.filename);
+  }
+
+  FILE *f = FileIO::fopen(m_Filename.c_str(), "wb");
+
+  if(f == NULL)
+  {
+    RDCWARN("Couldn't write symbol cache %s", m_Filename.c_str());
+    return;
+  }
+
+  FileIO::fwrite(&data[0], 1, data.size(), f);
+  FileIO::fclose(f);
+}
+
 string OSUtility::MakeMachineIdentString(uint64_t ident)
 {
   string ret = "";
@@ -192,3 +329,196 @@ string OSUtility::MakeMachineIdentString(uint64_t ident)
 
   return ret;
 }
+
+// regions are looked up from inside the platform's fault handler, so they live in a fixed table
+// guarded by a spinlock rather than anything that might allocate or block.
+struct WatchedRegion
+{
+  // page-aligned bounds of the tracked memory
+  byte *pageBase;
+  size_t numPages;
+
+  // the caller's base and size, for returning ranges relative to it
+  byte *base;
+  size_t size;
+
+  // one byte per page, set when the page is written to
+  volatile uint8_t *dirty;
+
+  // how many pages are currently dirty, so clean regions can be skipped without a scan
+  size_t numDirty;
+};
+
+static const int MaxWatchedRegions = 256;
+static WatchedRegion watchedRegions[MaxWatchedRegions] = {};
+static volatile int32_t watchLock = 0;
+static bool watchHandlerInstalled = false;
+
+struct ScopedWatchLock
+{
+  ScopedWatchLock()
+  {
+    while(Atomic::CmpExch32(&watchLock, 0, 1) != 0)
+    {
+    }
+  }
+  ~ScopedWatchLock() { Atomic::CmpExch32(&watchLock, 1, 0); }
+};
+
+WriteWatch::Region WriteWatch::Begin(void *base, size_t size)
+{
+  if(base == NULL || size == 0)
+    return NULL;
+
+  const size_t pageSize = GetPageSize();
+
+  byte *pageBase = (byte *)(uintptr_t(base) & ~uintptr_t(pageSize - 1));
+  byte *pageEnd = AlignUpPtr((byte *)base + size, pageSize);
+
+  WatchedRegion *ret = NULL;
+
+  {
+    ScopedWatchLock lock;
+
+    if(!watchHandlerInstalled)
+      watchHandlerInstalled = InstallFaultHandler();
+
+    if(!watchHandlerInstalled)
+      return NULL;
+
+    for(int i = 0; i < MaxWatchedRegions; i++)
+    {
+      if(watchedRegions[i].pageBase == NULL)
+      {
+        ret = &watchedRegions[i];
+        break;
+      }
+    }
+
+    if(ret == NULL)
+    {
+      RDCWARN("Too many regions being write-watched, can't track %p", base);
+      return NULL;
+    }
+
+    ret->numPages = (pageEnd - pageBase) / pageSize;
+    ret->base = (byte *)base;
+    ret->size = size;
+    ret->dirty = new uint8_t[ret->numPages];
+    memset((void *)ret->dirty, 0, ret->numPages);
+
+    // the region must be in the table before it's protected, so the first write finds it
+    ret->pageBase = pageBase;
+
+    if(!Protect(pageBase, pageEnd - pageBase, false))
+    {
+      delete[] ret->dirty;
+      RDCEraseMem(ret, sizeof(WatchedRegion));
+      return NULL;
+    }
+  }
+
+  return (Region)ret;
+}
+
+void WriteWatch::End(Region region)
+{
+  WatchedRegion *r = (WatchedRegion *)region;
+
+  if(r == NULL)
+    return;
+
+  ScopedWatchLock lock;
+
+  Protect(r->pageBase, r->numPages * GetPageSize(), true);
+
+  delete[] r->dirty;
+  RDCEraseMem(r, sizeof(WatchedRegion));
+}
+
+void WriteWatch::Reset(Region region)
+{
+  WatchedRegion *r = (WatchedRegion *)region;
+
+  if(r == NULL)
+    return;
+
+  ScopedWatchLock lock;
+
+  memset((void *)r->dirty, 0, r->numPages);
+  r->numDirty = 0;
+  Protect(r->pageBase, r->numPages * GetPageSize(), false);
+}
+
+void WriteWatch::GetDirtyRanges(Region region, vector<std::pair<size_t, size_t> > &ranges)
+{
+  ranges.clear();
+
+  WatchedRegion *r = (WatchedRegion *)region;
+
+  if(r == NULL)
+    return;
+
+  const size_t pageSize = GetPageSize();
+  const size_t baseOffs = r->base - r->pageBase;
+
+  ScopedWatchLock lock;
+
+  if(r->numDirty == 0)
+    return;
+
+  r->numDirty = 0;
+
+  size_t page = 0;
+  while(page < r->numPages)
+  {
+    if(!r->dirty[page])
+    {
+      page++;
+      continue;
+    }
+
+    // combine runs of dirty pages into one range
+    size_t start = page;
+    while(page < r->numPages && r->dirty[page])
+      r->dirty[page++] = 0;
+
+    Protect(r->pageBase + start * pageSize, (page - start) * pageSize, false);
+
+    size_t rangeStart = start * pageSize;
+    size_t rangeEnd = page * pageSize;
+
+    rangeStart = rangeStart > baseOffs ? rangeStart - baseOffs : 0;
+    rangeEnd = RDCMIN(rangeEnd - baseOffs, r->size);
+
+    ranges.push_back(std::make_pair(rangeStart, rangeEnd));
+  }
+}
+
+bool WriteWatch::HandleWrite(void *addr)
+{
+  const size_t pageSize = GetPageSize();
+
+  ScopedWatchLock lock;
+
+  for(int i = 0; i < MaxWatchedRegions; i++)
+  {
+    WatchedRegion &r = watchedRegions[i];
+
+    if(r.pageBase == NULL || (byte *)addr < r.pageBase ||
+       (byte *)addr >= r.pageBase + r.numPages * pageSize)
+      continue;
+
+    size_t page = ((byte *)addr - r.pageBase) / pageSize;
+
+    if(!r.dirty[page])
+      r.numDirty++;
+
+    r.dirty[page] = 1;
+    Protect(r.pageBase + page * pageSize, pageSize, true);
+
+    return true;
+  }
+
+  return false;
+}
@@ -69,6 +69,10 @@ uint32_t LaunchAndInjectIntoProcess(const char *app, const char *workingDir, con
 void *LoadModule(const char *module);
 void *GetFunctionAddress(void *module, const char *function);
 uint32_t GetCurrentPID();
+// the peak memory used by this process so far, in bytes
+uint64_t GetPeakMemoryUsage();
+// flushes asynchronous logging if the process crashes. Installed when asynchronous logging starts
+void InstallCrashLogFlush();
 };
 
 namespace Timing
@@ -98,6 +102,47 @@ private:
   data m_Data;
 };
 
+// a counting semaphore, for putting threads to sleep until there's something for them to do
+template <class data>
+class SemaphoreTemplate
+{
+public:
+  SemaphoreTemplate();
+  ~SemaphoreTemplate();
+  // blocks until the count is non-zero, then decrements it
+  void Wait();
+  // increments the count, waking up to that many waiting threads
+  void Signal(uint32_t count);
+
+private:
+  // no copying
+  SemaphoreTemplate &operator=(const SemaphoreTemplate &other);
+  SemaphoreTemplate(const SemaphoreTemplate &other);
+
+  data m_Data;
+};
+
+// a lock that any number of readers can hold at once, or a single writer. Unlike CriticalSection
+// it's not recursive, so a thread must not take it again while already holding it.
+template <class data>
+class RWLockTemplate
+{
+public:
+  RWLockTemplate();
+  ~RWLockTemplate();
+  void ReadLock();
+  void ReadUnlock();
+  void WriteLock();
+  void WriteUnlock();
+
+private:
+  // no copying
+  RWLockTemplate &operator=(const RWLockTemplate &other);
+  RWLockTemplate(const RWLockTemplate &other);
+
+  data m_Data;
+};
+
 void Init();
 void Shutdown();
 uint64_t AllocateTLSSlot();
@@ -106,6 +151,8 @@ void *GetTLSValue(uint64_t slot);
 void SetTLSValue(uint64_t slot, void *value);
 
 // must typedef CriticalSectionTemplate<X> CriticalSection
+// and SemaphoreTemplate<Y> Semaphore
+// and RWLockTemplate<Z> RWLock
 
 typedef void (*ThreadEntry)(void *);
 typedef uint64_t ThreadHandle;
@@ -115,6 +162,13 @@ void JoinThread(ThreadHandle handle);
 void CloseThread(ThreadHandle handle);
 void Sleep(uint32_t milliseconds);
 
+// number of logical processors available, at least 1
+uint32_t GetCPUCount();
+
+// lowers the calling thread's scheduling priority, for background work that shouldn't compete
+// with the application
+void SetCurrentThreadLowPriority();
+
 // kind of windows specific, to handle this case:
 // http://blogs.msdn.com/b/oldnewthing/archive/2013/11/05/10463645.aspx
 void KeepModuleAlive();
@@ -123,6 +177,13 @@ void ReleaseModuleExitThread();
 
 namespace Network
 {
+// one of several buffers sent together with a single call
+struct SendBuffer
+{
+  const void *data;
+  uint32_t length;
+};
+
 class Socket
 {
 public:
@@ -141,6 +202,13 @@ public:
   bool SendDataBlocking(const void *buf, uint32_t length);
   bool RecvDataBlocking(void *data, uint32_t length);
 
+  // sends the buffers in order as if they were one contiguous buffer, with as few system calls as
+  // possible so that small headers don't go out in packets of their own
+  bool SendDataBlocking(const SendBuffer *bufs, uint32_t count);
+
+  // sockets are created with Nagle's algorithm disabled, as most traffic is request/reply
+  void SetNoDelay(bool nodelay);
+
 private:
   ptrdiff_t socket;
 };
@@ -214,6 +282,33 @@ class StackResolver
 public:
   virtual ~StackResolver() {}
   virtual AddressDetails GetAddr(uint64_t addr) = 0;
+
+  // resolves count addresses into details. Resolvers that can look up many addresses at once more
+  // cheaply than one by one override this, by default it just calls GetAddr on each.
+  virtual void GetAddrs(const uint64_t *addrs, size_t count, AddressDetails *details);
+};
+
+// A cache of resolved addresses within one module that persists on disk across captures and
+// sessions, so each address only has to be looked up in the symbols once. moduleKey must uniquely
+// identify the exact build of the module, e.g. by its pdb GUID and age. Addresses are given as
+// offsets into the module so they don't depend on where it was loaded. Not thread-safe.
+class SymbolCache
+{
+public:
+  SymbolCache(const string &moduleKey);
+  ~SymbolCache();
+
+  bool Find(uint64_t offset, AddressDetails &details) const;
+  void Add(uint64_t offset, const AddressDetails &details);
+
+  // written on destruction too, but this allows saving the cache early
+  void Save();
+
+private:
+  string m_Key;
+  string m_Filename;
+  map<uint64_t, AddressDetails> m_Entries;
+  bool m_Dirty;
 };
 
 void Init();
@@ -269,6 +364,13 @@ void *logfile_open(const char *filename);
 void logfile_append(void *handle, const char *msg, size_t length);
 void logfile_close(void *handle);
 
+// copy-on-write memory mapping of an entire file. Returns NULL on failure, otherwise an opaque
+// handle to pass to mmap_close, with the mapped data and its size returned in the parameters. The
+// mapping remains valid until mmap_close. Writing to it only modifies a private copy of the page,
+// never the file.
+void *mmap_open(const char *filename, const byte **data, uint64_t *size);
+void mmap_close(void *handle);
+
 // utility functions
 inline bool dump(const char *filename, const void *buffer, size_t size)
 {
@@ -303,6 +405,48 @@ inline bool slurp(const char *filename, vector<unsigned char> &buffer)
 }
 };
 
+// Tracks which pages of a region of memory are written to, by write-protecting the pages and
+// catching the fault from the first write to each one. Note that writes made by the kernel on the
+// process's behalf (e.g. read() straight into the memory) fail instead of faulting, so this is only
+// suitable for memory that the application writes to directly.
+namespace WriteWatch
+{
+typedef void *Region;
+
+// starts tracking writes to the given memory, which must be readable and writable. Returns NULL
+// if the memory can't be tracked
+Region Begin(void *base, size_t size);
+void End(Region region);
+
+// forgets any writes so far and write-protects the whole region again
+void Reset(Region region);
+
+// returns the [start, end) byte ranges relative to the base of the region that have been written
+// since Begin(), Reset() or the last call. Those pages are write-protected again before returning,
+// so any data read from them afterwards is at least as new as the tracking.
+void GetDirtyRanges(Region region, vector<std::pair<size_t, size_t> > &ranges);
+
+// implemented per-platform
+size_t GetPageSize();
+bool InstallFaultHandler();
+bool Protect(void *base, size_t size, bool writable);
+
+// called by the platform's fault handler with the address written. Returns true if the write was
+// to a tracked page, which is then made writable, or false if the fault should be passed on
+bool HandleWrite(void *addr);
+};
+
+// Memory allocated directly from the OS in whole pages, for large buffers.
+namespace VirtualMemory
+{
+// returns size bytes of zeroed read/write memory, or NULL on failure. If largePages is set, the
+// memory is backed by large pages where the OS allows it, which saves TLB misses when scanning
+// through big buffers. It quietly falls back to normal pages when they're not available.
+void *Alloc(size_t size, bool largePages);
+// size must be the same size that was passed to Alloc
+void Free(void *ptr, size_t size);
+};
+
 namespace Keyboard
 {
 void Init();
@@ -388,6 +532,7 @@ inline uint32_t CountLeadingZeroes(uint32_t value);
 #if ENABLED(RDOC_X64)
 inline uint64_t CountLeadingZeroes(uint64_t value);
 #endif
+inline uint32_t CountTrailingZeroes(uint32_t value);
 };
 
 // must #define:
@@ -31,6 +31,7 @@ public:
   {
     RDCEraseEl(addrs);
     numLevels = 0;
+    Collect();
   }
   AndroidCallstack(uint64_t *calls, size_t num) { Set(calls, num); }
   ~AndroidCallstack() {}
@@ -41,11 +42,20 @@ public:
       addrs[i] = calls[i];
   }
 
-  size_t NumLevels() const { return 0; }
+  size_t NumLevels() const { return size_t(numLevels); }
   const uint64_t *GetAddrs() const { return addrs; }
 private:
   AndroidCallstack(const Callstack::Stackwalk &other);
 
+  void Collect()
+  {
+#if ENABLED(RDOC_FRAME_POINTER_UNWIND)
+    // there's no unwinder to fall back on here, so callstacks are only available when built with
+    // frame pointers. Only the raw addresses are stored, they're resolved offline.
+    numLevels = (int)Callstack::WalkFramePointers(addrs, ARRAY_COUNT(addrs));
+#endif
+  }
+
   uint64_t addrs[128];
   int numLevels;
 };
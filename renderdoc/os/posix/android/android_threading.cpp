@@ -24,6 +24,8 @@
 
 #include "os/os_specific.h"
 
+#include <sys/resource.h>
+#include <sys/syscall.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -38,3 +40,9 @@ uint64_t Timing::GetTick()
   clock_gettime(CLOCK_MONOTONIC, &ts);
   return uint64_t(ts.tv_sec) * 1000000000ULL + uint32_t(ts.tv_nsec & 0xffffffff);
 }
+
+void Threading::SetCurrentThreadLowPriority()
+{
+  // on linux the nice value is per-thread, when given a thread ID
+  setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), 19);
+}
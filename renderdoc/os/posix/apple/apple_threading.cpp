@@ -25,8 +25,9 @@
 #include "os/os_specific.h"
 
 #include <mach/mach_time.h>
+#include <sys/resource.h>
 
-double Timing::GetTickFrequency()
+static double QueryTickFrequency()
 {
   mach_timebase_info_data_t timeInfo;
   mach_timebase_info(&timeInfo);
@@ -36,7 +37,19 @@ double Timing::GetTickFrequency()
   return (double)numer / (double)denom;
 }
 
+double Timing::GetTickFrequency()
+{
+  // the timebase is fixed, so only query it once
+  static const double freq = QueryTickFrequency();
+  return freq;
+}
+
 uint64_t Timing::GetTick()
 {
   return mach_absolute_time();
 }
+
+void Threading::SetCurrentThreadLowPriority()
+{
+  setpriority(PRIO_DARWIN_THREAD, 0, PRIO_DARWIN_BG);
+}
@@ -25,8 +25,10 @@
 #include <execinfo.h>
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
 #include <map>
 #include <vector>
+#include "common/threading.h"
 #include "os/os_specific.h"
 
 void *renderdocBase = NULL;
@@ -57,21 +59,44 @@ private:
 
   void Collect()
   {
-    void *addrs_ptr[ARRAY_COUNT(addrs)];
+    uint64_t stack[ARRAY_COUNT(addrs)];
+    int count = 0;
+
+#if ENABLED(RDOC_FRAME_POINTER_UNWIND)
+    // walking frame pointers is far cheaper than backtrace(), which unwinds with the exception
+    // tables. If the walk stopped before making it out of our own frames though, something in
+    // between lacks a frame pointer, so fall back to unwinding properly.
+    count = (int)Callstack::WalkFramePointers(stack, ARRAY_COUNT(stack));
+    if(NumOwnFrames(stack, count) == count)
+      count = 0;
+#endif
+
+    if(count == 0)
+    {
+      void *addrs_ptr[ARRAY_COUNT(addrs)];
 
-    numLevels = backtrace(addrs_ptr, ARRAY_COUNT(addrs));
+      count = backtrace(addrs_ptr, ARRAY_COUNT(addrs));
 
-    int offs = 0;
-    // if we want to trim levels of the stack, we can do that here
-    // by incrementing offs and decrementing numLevels
-    while(numLevels > 0 && addrs_ptr[offs] >= renderdocBase && addrs_ptr[offs] < renderdocEnd)
-    {
-      offs++;
-      numLevels--;
+      for(int i = 0; i < count; i++)
+        stack[i] = (uint64_t)addrs_ptr[i];
     }
 
+    // trim off our own levels of the stack, only the application's calls are interesting
+    int offs = NumOwnFrames(stack, count);
+    numLevels = count - offs;
+
     for(int i = 0; i < numLevels; i++)
-      addrs[i] = (uint64_t)addrs_ptr[i + offs];
+      addrs[i] = stack[i + offs];
+  }
+
+  static int NumOwnFrames(const uint64_t *stack, int count)
+  {
+    uint64_t base = (uint64_t)renderdocBase, end = (uint64_t)renderdocEnd;
+
+    int ret = 0;
+    while(ret < count && stack[ret] >= base && stack[ret] < end)
+      ret++;
+    return ret;
   }
 
   uint64_t addrs[128];
@@ -157,76 +182,194 @@ struct LookupModule
 class LinuxResolver : public Callstack::StackResolver
 {
 public:
-  LinuxResolver(vector<LookupModule> modules) { m_Modules = modules; }
-  Callstack::AddressDetails GetAddr(uint64_t addr)
+  LinuxResolver(vector<LookupModule> modules)
   {
-    EnsureCached(addr);
+    m_Modules = modules;
+    m_SymbolCaches.resize(m_Modules.size(), NULL);
+  }
 
-    return m_Cache[addr];
+  ~LinuxResolver()
+  {
+    for(size_t i = 0; i < m_SymbolCaches.size(); i++)
+      delete m_SymbolCaches[i];
   }
 
-private:
-  void EnsureCached(uint64_t addr)
+  Callstack::AddressDetails GetAddr(uint64_t addr)
+  {
+    Callstack::AddressDetails ret;
+    GetAddrs(&addr, 1, &ret);
+    return ret;
+  }
+
+  void GetAddrs(const uint64_t *addrs, size_t count, Callstack::AddressDetails *details)
   {
-    auto it = m_Cache.insert(
-        std::pair<uint64_t, Callstack::AddressDetails>(addr, Callstack::AddressDetails()));
-    if(!it.second)
-      return;
+    // addresses that aren't cached yet, per module, as offsets for addr2line
+    std::map<size_t, std::vector<uint64_t> > pending;
+
+    for(size_t i = 0; i < count; i++)
+    {
+      uint64_t addr = addrs[i];
+
+      if(m_Cache.find(addr) != m_Cache.end())
+        continue;
+
+      size_t mod = FindModule(addr);
+
+      if(mod == m_Modules.size())
+      {
+        m_Cache[addr] = UnknownAddress(addr);
+        continue;
+      }
+
+      Callstack::AddressDetails cached;
+      if(GetSymbolCache(mod)->Find(addr - m_Modules[mod].base, cached))
+      {
+        m_Cache[addr] = cached;
+        continue;
+      }
+
+      std::vector<uint64_t> &offsets = pending[mod];
+      if(std::find(offsets.begin(), offsets.end(), addr - m_Modules[mod].base) == offsets.end())
+        offsets.push_back(addr - m_Modules[mod].base);
+    }
+
+    if(!pending.empty())
+    {
+      std::vector<size_t> mods;
+      for(auto it = pending.begin(); it != pending.end(); ++it)
+        mods.push_back(it->first);
+
+      std::vector<std::vector<Callstack::AddressDetails> > results(mods.size());
+
+      // each module needs its own addr2line process anyway, so look them all up at once
+      Threading::ParallelFor(0, (uint32_t)mods.size(), [&](uint32_t i) {
+        results[i] = Addr2Line(m_Modules[mods[i]].path, pending[mods[i]]);
+      });
+
+      for(size_t i = 0; i < mods.size(); i++)
+      {
+        const std::vector<uint64_t> &offsets = pending[mods[i]];
+        Callstack::SymbolCache *symbolCache = GetSymbolCache(mods[i]);
+
+        for(size_t o = 0; o < offsets.size(); o++)
+        {
+          Callstack::AddressDetails &result = results[i][o];
+          symbolCache->Add(offsets[o], result);
+          m_Cache[m_Modules[mods[i]].base + offsets[o]] = result;
+        }
 
-    Callstack::AddressDetails &ret = it.first->second;
+        symbolCache->Save();
+      }
+    }
 
+    for(size_t i = 0; i < count; i++)
+      details[i] = m_Cache[addrs[i]];
+  }
+
+private:
+  static Callstack::AddressDetails UnknownAddress(uint64_t addr)
+  {
+    Callstack::AddressDetails ret;
     ret.filename = "Unknown";
     ret.line = 0;
     ret.function = StringFormat::Fmt("0x%08llx", addr);
+    return ret;
+  }
 
+  size_t FindModule(uint64_t addr)
+  {
     for(size_t i = 0; i < m_Modules.size(); i++)
-    {
       if(addr >= m_Modules[i].base && addr < m_Modules[i].end)
+        return i;
+
+    return m_Modules.size();
+  }
+
+  Callstack::SymbolCache *GetSymbolCache(size_t mod)
+  {
+    // the path and modification time of the module is the best we can do to identify the build
+    if(m_SymbolCaches[mod] == NULL)
+      m_SymbolCaches[mod] = new Callstack::SymbolCache(
+          StringFormat::Fmt("%s %llu", m_Modules[mod].path,
+                            FileIO::GetModifiedTimestamp(m_Modules[mod].path)));
+
+    return m_SymbolCaches[mod];
+  }
+
+  static std::vector<Callstack::AddressDetails> Addr2Line(const char *path,
+                                                          const std::vector<uint64_t> &offsets)
+  {
+    std::vector<Callstack::AddressDetails> ret;
+
+    // addr2line prints the function and then file:line for each address in order. Pass a limited
+    // number of addresses each time to stay well inside command line length limits
+    const size_t batchSize = 256;
+
+    for(size_t first = 0; first < offsets.size(); first += batchSize)
+    {
+      size_t last = RDCMIN(first + batchSize, offsets.size());
+
+      string cmd = StringFormat::Fmt("addr2line -j.text -fCe \"%s\"", path);
+      for(size_t i = first; i < last; i++)
+        cmd += StringFormat::Fmt(" 0x%llx", offsets[i]);
+
+      string output;
+
+      FILE *f = ::popen(cmd.c_str(), "r");
+
+      if(f)
       {
-        uint64_t relative = addr - m_Modules[i].base;
-        string cmd =
-            StringFormat::Fmt("addr2line -j.text -fCe \"%s\" 0x%llx", m_Modules[i].path, relative);
+        char buf[4096];
+        size_t read = 0;
+        while((read = fread(buf, 1, sizeof(buf), f)) > 0)
+          output.append(buf, read);
 
-        FILE *f = ::popen(cmd.c_str(), "r");
+        pclose(f);
+      }
 
-        char result[2048] = {0};
-        fread(result, 1, 2047, f);
+      std::vector<string> lines;
+      for(size_t start = 0; start < output.size();)
+      {
+        size_t end = output.find('\n', start);
+        if(end == string::npos)
+          end = output.size();
+        lines.push_back(output.substr(start, end - start));
+        start = end + 1;
+      }
 
-        fclose(f);
+      for(size_t i = first; i < last; i++)
+      {
+        Callstack::AddressDetails details;
+        details.line = 0;
 
-        char *line2 = strchr(result, '\n');
-        if(line2)
-        {
-          *line2 = 0;
-          line2++;
-        }
+        size_t idx = (i - first) * 2;
 
-        ret.function = result;
+        if(idx < lines.size())
+          details.function = lines[idx];
 
-        if(line2)
+        if(idx + 1 < lines.size())
         {
-          char *last = line2 + strlen(line2) - 1;
-          uint32_t mul = 1;
-          ret.line = 0;
-          while(*last >= '0' && *last <= '9')
+          string fileline = lines[idx + 1];
+
+          size_t colon = fileline.rfind(':');
+          if(colon != string::npos)
           {
-            ret.line += mul * (uint32_t(*last) - uint32_t('0'));
-            *last = 0;
-            last--;
-            mul *= 10;
+            details.line = (uint32_t)atoi(fileline.c_str() + colon + 1);
+            fileline.erase(colon);
           }
-          if(*last == ':')
-            *last = 0;
 
-          ret.filename = line2;
+          details.filename = fileline;
         }
 
-        break;
+        ret.push_back(details);
       }
     }
+
+    return ret;
   }
 
   std::vector<LookupModule> m_Modules;
+  std::vector<Callstack::SymbolCache *> m_SymbolCaches;
   std::map<uint64_t, Callstack::AddressDetails> m_Cache;
 };
 
@@ -0,0 +1,98 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "os/os_specific.h"
+
+#if ENABLED(RDOC_FRAME_POINTER_UNWIND)
+
+// the bounds of the calling thread's stack, looked up once per thread. Both are 0 if they couldn't
+// be found, in which case nothing is walked
+static void GetStackBounds(uintptr_t &lo, uintptr_t &hi)
+{
+  static uint64_t loSlot = Threading::AllocateTLSSlot();
+  static uint64_t hiSlot = Threading::AllocateTLSSlot();
+
+  lo = (uintptr_t)Threading::GetTLSValue(loSlot);
+  hi = (uintptr_t)Threading::GetTLSValue(hiSlot);
+
+  if(hi != 0)
+    return;
+
+  pthread_attr_t attr;
+  if(pthread_getattr_np(pthread_self(), &attr) == 0)
+  {
+    void *addr = NULL;
+    size_t size = 0;
+    if(pthread_attr_getstack(&attr, &addr, &size) == 0)
+    {
+      lo = (uintptr_t)addr;
+      hi = lo + size;
+    }
+
+    pthread_attr_destroy(&attr);
+  }
+
+  Threading::SetTLSValue(loSlot, (void *)lo);
+  Threading::SetTLSValue(hiSlot, (void *)hi);
+}
+
+namespace Callstack
+{
+// must not be inlined, so that our own frame record is the first in the chain
+__attribute__((noinline)) size_t WalkFramePointers(uint64_t *addrs, size_t maxLevels)
+{
+  uintptr_t lo = 0, hi = 0;
+  GetStackBounds(lo, hi);
+
+  // each frame record is the caller's frame pointer followed by the return address
+  const uintptr_t *frame = (const uintptr_t *)__builtin_frame_address(0);
+
+  size_t numLevels = 0;
+  while(numLevels < maxLevels)
+  {
+    uintptr_t addr = (uintptr_t)frame;
+
+    // the record must be aligned and entirely inside this thread's stack before it's read
+    if(addr < lo || addr + 2 * sizeof(uintptr_t) > hi || (addr & (sizeof(uintptr_t) - 1)) != 0)
+      break;
+
+    if(frame[1] == 0)
+      break;
+
+    addrs[numLevels++] = (uint64_t)frame[1];
+
+    // the stack grows down, so callers' frames are always higher up. Anything else means the chain
+    // has been broken, most likely by a function that was built without frame pointers
+    const uintptr_t *next = (const uintptr_t *)frame[0];
+    if(next <= frame)
+      break;
+
+    frame = next;
+  }
+
+  return numLevels;
+}
+};
+
+#endif
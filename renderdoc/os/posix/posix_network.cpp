@@ -24,6 +24,7 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <netdb.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
@@ -32,13 +33,19 @@
 #include <string.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <string>
+#include <vector>
 #include "os/os_specific.h"
 #include "serialise/string_utils.h"
 
 using std::string;
 
+#ifndef IOV_MAX
+#define IOV_MAX 16
+#endif
+
 namespace Network
 {
 void Init()
@@ -90,10 +97,10 @@ Socket *Socket::AcceptClient(bool wait)
       int flags = fcntl(s, F_GETFL, 0);
       fcntl(s, F_SETFL, flags | O_NONBLOCK);
 
-      int nodelay = 1;
-      setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (char *)&nodelay, sizeof(nodelay));
+      Socket *ret = new Socket((ptrdiff_t)s);
+      ret->SetNoDelay(true);
 
-      return new Socket((ptrdiff_t)s);
+      return ret;
     }
 
     int err = errno;
@@ -154,6 +161,81 @@ bool Socket::SendDataBlocking(const void *buf, uint32_t length)
   return true;
 }
 
+bool Socket::SendDataBlocking(const SendBuffer *bufs, uint32_t count)
+{
+  // the iovecs are advanced past whatever has been sent, so work on a copy
+  std::vector<iovec> iov;
+  iov.reserve(count);
+
+  for(uint32_t i = 0; i < count; i++)
+  {
+    if(bufs[i].length == 0)
+      continue;
+
+    iovec v = {(void *)bufs[i].data, bufs[i].length};
+    iov.push_back(v);
+  }
+
+  if(iov.empty())
+    return true;
+
+  int flags = fcntl(socket, F_GETFL, 0);
+  fcntl(socket, F_SETFL, flags & ~O_NONBLOCK);
+
+  size_t first = 0;
+
+  while(first < iov.size())
+  {
+    msghdr msg = {};
+    msg.msg_iov = &iov[first];
+    msg.msg_iovlen = RDCMIN(iov.size() - first, (size_t)IOV_MAX);
+
+    ssize_t ret = sendmsg(socket, &msg, 0);
+
+    if(ret <= 0)
+    {
+      int err = errno;
+
+      if(err == EWOULDBLOCK || err == EAGAIN)
+      {
+        ret = 0;
+      }
+      else
+      {
+        RDCWARN("sendmsg: %d", err);
+        Shutdown();
+        return false;
+      }
+    }
+
+    // skip any buffers that were completely sent, and move into one that was partially sent
+    size_t remaining = (size_t)ret;
+
+    while(first < iov.size() && remaining >= iov[first].iov_len)
+    {
+      remaining -= iov[first].iov_len;
+      first++;
+    }
+
+    if(remaining > 0)
+    {
+      iov[first].iov_base = (char *)iov[first].iov_base + remaining;
+      iov[first].iov_len -= remaining;
+    }
+  }
+
+  flags = fcntl(socket, F_GETFL, 0);
+  fcntl(socket, F_SETFL, flags | O_NONBLOCK);
+
+  return true;
+}
+
+void Socket::SetNoDelay(bool nodelay)
+{
+  int value = nodelay ? 1 : 0;
+  setsockopt((int)socket, IPPROTO_TCP, TCP_NODELAY, (char *)&value, sizeof(value));
+}
+
 bool Socket::IsRecvDataWaiting()
 {
   char dummy;
@@ -328,10 +410,10 @@ Socket *CreateClientSocket(const char *host, uint16_t port, int timeoutMS)
       }
     }
 
-    int nodelay = 1;
-    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (char *)&nodelay, sizeof(nodelay));
+    Socket *ret = new Socket((ptrdiff_t)s);
+    ret->SetNoDelay(true);
 
-    return new Socket((ptrdiff_t)s);
+    return ret;
   }
 
   RDCWARN("Failed to connect to %s:%d", host, port);
@@ -26,8 +26,11 @@
 #include <errno.h>
 #include <limits.h>
 #include <pwd.h>
+#include <signal.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -617,3 +620,173 @@ uint32_t Process::GetCurrentPID()
 {
   return (uint32_t)getpid();
 }
+
+uint64_t Process::GetPeakMemoryUsage()
+{
+  rusage usage = {};
+  if(getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+
+#if ENABLED(RDOC_APPLE)
+  // reported in bytes on apple
+  return (uint64_t)usage.ru_maxrss;
+#else
+  // reported in kilobytes everywhere else
+  return (uint64_t)usage.ru_maxrss * 1024;
+#endif
+}
+
+// signals that end the process, and whatever was handling them before the log flush
+static const int CrashSignals[] = {SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT};
+static struct sigaction prevCrashActions[ARRAY_COUNT(CrashSignals)];
+
+static void CrashLogFlushHandler(int sig, siginfo_t *info, void *context)
+{
+  rdclog_crashflush();
+
+  for(size_t i = 0; i < ARRAY_COUNT(CrashSignals); i++)
+  {
+    if(CrashSignals[i] != sig)
+      continue;
+
+    struct sigaction &prev = prevCrashActions[i];
+
+    // hand the signal to whoever was handling it before, or crash as we would have done without
+    // this handler
+    if(prev.sa_flags & SA_SIGINFO)
+    {
+      prev.sa_sigaction(sig, info, context);
+    }
+    else if(prev.sa_handler == SIG_DFL || prev.sa_handler == SIG_IGN)
+    {
+      signal(sig, SIG_DFL);
+      raise(sig);
+    }
+    else
+    {
+      prev.sa_handler(sig);
+    }
+    return;
+  }
+}
+
+void Process::InstallCrashLogFlush()
+{
+  static bool installed = false;
+  if(installed)
+    return;
+  installed = true;
+
+  // this is installed when logging starts, before the write-watch fault handler below, so that
+  // write-watch faults are handled there without flushing the log
+  struct sigaction action = {};
+  action.sa_sigaction = &CrashLogFlushHandler;
+  action.sa_flags = SA_SIGINFO;
+  sigemptyset(&action.sa_mask);
+
+  for(size_t i = 0; i < ARRAY_COUNT(CrashSignals); i++)
+  {
+    if(sigaction(CrashSignals[i], &action, &prevCrashActions[i]) != 0)
+      RDCWARN("Couldn't install crash log flush for signal %d - errno %d", CrashSignals[i], errno);
+  }
+}
+
+static struct sigaction prevSegvAction, prevBusAction;
+
+static void WriteWatchFaultHandler(int sig, siginfo_t *info, void *context)
+{
+  if(WriteWatch::HandleWrite(info->si_addr))
+    return;
+
+  // not a write we're tracking, so pass it on to whoever was handling it before
+  struct sigaction &prev = (sig == SIGBUS) ? prevBusAction : prevSegvAction;
+
+  if(prev.sa_flags & SA_SIGINFO)
+  {
+    prev.sa_sigaction(sig, info, context);
+  }
+  else if(prev.sa_handler == SIG_DFL || prev.sa_handler == SIG_IGN)
+  {
+    // put back the default behaviour, so that when the faulting instruction runs again the
+    // process crashes as it would have done without us
+    signal(sig, SIG_DFL);
+  }
+  else
+  {
+    prev.sa_handler(sig);
+  }
+}
+
+size_t WriteWatch::GetPageSize()
+{
+  static size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+  return pageSize;
+}
+
+bool WriteWatch::InstallFaultHandler()
+{
+  struct sigaction action = {};
+  action.sa_sigaction = &WriteWatchFaultHandler;
+  action.sa_flags = SA_SIGINFO | SA_RESTART;
+  sigemptyset(&action.sa_mask);
+
+  // macOS raises SIGBUS for writes to protected pages, Linux raises SIGSEGV
+  if(sigaction(SIGSEGV, &action, &prevSegvAction) != 0 ||
+     sigaction(SIGBUS, &action, &prevBusAction) != 0)
+  {
+    RDCERR("Couldn't install write-watch fault handler - errno %d", errno);
+    return false;
+  }
+
+  return true;
+}
+
+bool WriteWatch::Protect(void *base, size_t size, bool writable)
+{
+  return mprotect(base, size, writable ? (PROT_READ | PROT_WRITE) : PROT_READ) == 0;
+}
+
+#if defined(MADV_HUGEPAGE)
+// the size of transparent huge pages on every platform that has them
+static const size_t HugePageSize = 2 * 1024 * 1024;
+#endif
+
+void *VirtualMemory::Alloc(size_t size, bool largePages)
+{
+#if defined(MADV_HUGEPAGE)
+  if(largePages)
+  {
+    // huge pages can only back aligned ranges, so map enough extra to align the start and then
+    // hand back the excess on either side
+    size_t mapSize = size + HugePageSize;
+    byte *map =
+        (byte *)mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if(map != (byte *)MAP_FAILED)
+    {
+      byte *ret = (byte *)AlignUp((size_t)map, HugePageSize);
+      byte *end = (byte *)AlignUp((size_t)(ret + size), WriteWatch::GetPageSize());
+
+      if(ret > map)
+        munmap(map, ret - map);
+      if(map + mapSize > end)
+        munmap(end, map + mapSize - end);
+
+      // this is only advice, if transparent huge pages are disabled it does nothing
+      madvise(ret, size, MADV_HUGEPAGE);
+
+      return ret;
+    }
+  }
+#endif
+
+  void *ret = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+  return ret == MAP_FAILED ? NULL : ret;
+}
+
+void VirtualMemory::Free(void *ptr, size_t size)
+{
+  if(ptr)
+    munmap(ptr, size);
+}
@@ -50,6 +50,16 @@ bool DebuggerPresent();
 void WriteOutput(int channel, const char *str);
 };
 
+namespace Callstack
+{
+#if ENABLED(RDOC_FRAME_POINTER_UNWIND)
+// walks the calling thread's frame pointers into addrs and returns how many levels were found. The
+// walk stops at the first frame record that isn't on this thread's stack, so a frame that omits the
+// frame pointer ends the stack early rather than crashing.
+size_t WalkFramePointers(uint64_t *addrs, size_t maxLevels);
+#endif
+};
+
 namespace Threading
 {
 struct pthreadLockData
@@ -58,6 +68,17 @@ struct pthreadLockData
   pthread_mutexattr_t attr;
 };
 typedef CriticalSectionTemplate<pthreadLockData> CriticalSection;
+
+// unnamed POSIX semaphores aren't available on apple, so this is built on a condition variable
+struct pthreadSemaphoreData
+{
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  uint32_t count;
+};
+typedef SemaphoreTemplate<pthreadSemaphoreData> Semaphore;
+
+typedef RWLockTemplate<pthread_rwlock_t> RWLock;
 };
 
 namespace Bits
@@ -73,4 +94,9 @@ inline uint64_t CountLeadingZeroes(uint64_t value)
   return __builtin_clzl(value);
 }
 #endif
+
+inline uint32_t CountTrailingZeroes(uint32_t value)
+{
+  return value == 0 ? 32 : __builtin_ctz(value);
+}
 };
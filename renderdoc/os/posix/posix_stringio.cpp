@@ -31,6 +31,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <time.h>
@@ -404,6 +405,55 @@ void logfile_close(void *handle)
     close(fd);
   }
 }
+
+struct FileMapping
+{
+  void *ptr;
+  size_t size;
+};
+
+void *mmap_open(const char *filename, const byte **data, uint64_t *size)
+{
+  int fd = open(filename, O_RDONLY);
+
+  if(fd < 0)
+    return NULL;
+
+  struct stat st;
+  if(fstat(fd, &st) != 0 || st.st_size <= 0)
+  {
+    close(fd);
+    return NULL;
+  }
+
+  void *ptr = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+  // the mapping keeps the file referenced, we don't need the descriptor anymore
+  close(fd);
+
+  if(ptr == MAP_FAILED)
+    return NULL;
+
+  FileMapping *mapping = new FileMapping;
+  mapping->ptr = ptr;
+  mapping->size = (size_t)st.st_size;
+
+  *data = (const byte *)ptr;
+  *size = (uint64_t)st.st_size;
+
+  return mapping;
+}
+
+void mmap_close(void *handle)
+{
+  FileMapping *mapping = (FileMapping *)handle;
+
+  if(mapping)
+  {
+    munmap(mapping->ptr, mapping->size);
+    delete mapping;
+  }
+}
 };
 
 namespace StringFormat
@@ -101,6 +101,79 @@ void CriticalSection::Unlock()
   pthread_mutex_unlock(&m_Data.lock);
 }
 
+template <>
+Semaphore::SemaphoreTemplate()
+{
+  pthread_mutex_init(&m_Data.lock, NULL);
+  pthread_cond_init(&m_Data.cond, NULL);
+  m_Data.count = 0;
+}
+
+template <>
+Semaphore::~SemaphoreTemplate()
+{
+  pthread_cond_destroy(&m_Data.cond);
+  pthread_mutex_destroy(&m_Data.lock);
+}
+
+template <>
+void Semaphore::Wait()
+{
+  pthread_mutex_lock(&m_Data.lock);
+  while(m_Data.count == 0)
+    pthread_cond_wait(&m_Data.cond, &m_Data.lock);
+  m_Data.count--;
+  pthread_mutex_unlock(&m_Data.lock);
+}
+
+template <>
+void Semaphore::Signal(uint32_t count)
+{
+  pthread_mutex_lock(&m_Data.lock);
+  m_Data.count += count;
+  if(count == 1)
+    pthread_cond_signal(&m_Data.cond);
+  else if(count > 1)
+    pthread_cond_broadcast(&m_Data.cond);
+  pthread_mutex_unlock(&m_Data.lock);
+}
+
+template <>
+RWLock::RWLockTemplate()
+{
+  pthread_rwlock_init(&m_Data, NULL);
+}
+
+template <>
+RWLock::~RWLockTemplate()
+{
+  pthread_rwlock_destroy(&m_Data);
+}
+
+template <>
+void RWLock::ReadLock()
+{
+  pthread_rwlock_rdlock(&m_Data);
+}
+
+template <>
+void RWLock::ReadUnlock()
+{
+  pthread_rwlock_unlock(&m_Data);
+}
+
+template <>
+void RWLock::WriteLock()
+{
+  pthread_rwlock_wrlock(&m_Data);
+}
+
+template <>
+void RWLock::WriteUnlock()
+{
+  pthread_rwlock_unlock(&m_Data);
+}
+
 struct ThreadInitData
 {
   ThreadEntry entryFunc;
@@ -245,4 +318,10 @@ void Sleep(uint32_t milliseconds)
 {
   usleep(milliseconds * 1000);
 }
+
+uint32_t GetCPUCount()
+{
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count > 0 ? (uint32_t)count : 1;
+}
 };
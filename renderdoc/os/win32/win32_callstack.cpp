@@ -365,6 +365,7 @@ public:
   ~Win32CallstackResolver();
 
   Callstack::AddressDetails GetAddr(uint64_t addr);
+  void GetAddrs(const uint64_t *addrs, size_t count, Callstack::AddressDetails *details);
 
 private:
   wstring pdbBrowse(wstring startingPoint);
@@ -376,6 +377,10 @@ private:
     DWORD size;
 
     uint32_t moduleId;
+
+    // only for modules whose symbols loaded, so a later run that finds them isn't stuck with
+    // whatever was resolved without symbols
+    Callstack::SymbolCache *symbolCache;
   };
 
   vector<wstring> pdbRememberedPaths;
@@ -600,23 +605,21 @@ BOOL CALLBACK EnumModule(PCWSTR ModuleName, DWORD64 BaseOfDll, PVOID UserContext
 
 void Win32Callstack::Collect()
 {
-  std::vector<PVOID> stack32;
-
-  stack32.resize(64);
+  PVOID stack32[64];
 
-  USHORT num = RtlCaptureStackBackTrace(0, 63, &stack32[0], NULL);
+  USHORT num = RtlCaptureStackBackTrace(0, 63, stack32, NULL);
 
-  stack32.resize(num);
-
-  while(!stack32.empty() && (uint64_t)stack32[0] >= (uint64_t)renderdocBase &&
-        (uint64_t)stack32[0] <= (uint64_t)renderdocBase + renderdocSize)
+  // skip our own frames at the top of the stack
+  USHORT first = 0;
+  while(first < num && (uint64_t)stack32[first] >= (uint64_t)renderdocBase &&
+        (uint64_t)stack32[first] <= (uint64_t)renderdocBase + renderdocSize)
   {
-    stack32.erase(stack32.begin());
+    first++;
   }
 
-  m_AddrStack.resize(stack32.size());
-  for(size_t i = 0; i < stack32.size(); i++)
-    m_AddrStack[i] = (DWORD64)stack32[i];
+  m_AddrStack.resize(num - first);
+  for(USHORT i = first; i < num; i++)
+    m_AddrStack[i - first] = (DWORD64)stack32[i];
 }
 
 Win32Callstack::Win32Callstack()
@@ -733,6 +736,7 @@ Win32CallstackResolver::Win32CallstackResolver(char *moduleDB, size_t DBSize, st
     m.base = chunk->base;
     m.size = chunk->size;
     m.moduleId = 0;
+    m.symbolCache = NULL;
 
     if(find(pdbIgnores.begin(), pdbIgnores.end(), m.name) != pdbIgnores.end())
     {
@@ -855,6 +859,12 @@ Win32CallstackResolver::Win32CallstackResolver(char *moduleDB, size_t DBSize, st
 
     DIA2::SetBaseAddress(m.moduleId, chunk->base);
 
+    const GUID &guid = chunk->guid;
+    m.symbolCache = new Callstack::SymbolCache(StringFormat::Fmt(
+        "%ls {%08x-%04x-%04x-%02x%02x-%02x%02x%02x%02x%02x%02x} %u", m.name.c_str(), guid.Data1,
+        guid.Data2, guid.Data3, guid.Data4[0], guid.Data4[1], guid.Data4[2], guid.Data4[3],
+        guid.Data4[4], guid.Data4[5], guid.Data4[6], guid.Data4[7], chunk->age));
+
     RDCLOG("Loaded Symbols for %ls", m.name.c_str());
 
     modules.push_back(m);
@@ -868,6 +878,8 @@ Win32CallstackResolver::Win32CallstackResolver(char *moduleDB, size_t DBSize, st
 
 Win32CallstackResolver::~Win32CallstackResolver()
 {
+  for(size_t i = 0; i < modules.size(); i++)
+    delete modules[i].symbolCache;
 }
 
 Callstack::AddressDetails Win32CallstackResolver::GetAddr(DWORD64 addr)
@@ -881,12 +893,23 @@ Callstack::AddressDetails Win32CallstackResolver::GetAddr(DWORD64 addr)
   wcsncpy_s(info.fileName, L"Unknown", 126);
   wsprintfW(info.funcName, L"0x%08I64x", addr);
 
+  Callstack::SymbolCache *symbolCache = NULL;
+  uint64_t offset = 0;
+
   for(size_t i = 0; i < modules.size(); i++)
   {
     DWORD64 base = modules[i].base;
     DWORD size = modules[i].size;
     if(addr > base && addr < base + size)
     {
+      symbolCache = modules[i].symbolCache;
+      offset = addr - base;
+
+      // looking up in the pdb is slow, so check if this address was resolved previously
+      Callstack::AddressDetails cached;
+      if(symbolCache && symbolCache->Find(offset, cached))
+        return cached;
+
       if(modules[i].moduleId != 0)
         info = DIA2::GetAddr(modules[i].moduleId, addr);
 
@@ -937,9 +960,24 @@ Callstack::AddressDetails Win32CallstackResolver::GetAddr(DWORD64 addr)
   ret.function = StringFormat::Wide2UTF8(wstring(info.funcName));
   ret.line = info.lineNum;
 
+  if(symbolCache)
+    symbolCache->Add(offset, ret);
+
   return ret;
 }
 
+void Win32CallstackResolver::GetAddrs(const uint64_t *addrs, size_t count,
+                                      Callstack::AddressDetails *details)
+{
+  // DIA sessions belong to the thread that opened them, so there's no resolving in parallel here.
+  // Batching at least lets the caches be written once for the whole lot
+  Callstack::StackResolver::GetAddrs(addrs, count, details);
+
+  for(size_t i = 0; i < modules.size(); i++)
+    if(modules[i].symbolCache)
+      modules[i].symbolCache->Save();
+}
+
 ////////////////////////////////////////////////////////////////////
 // implement public interface
 
@@ -25,6 +25,7 @@
 
 #include <winsock2.h>
 #include <ws2tcpip.h>
+#include <vector>
 #include "os/os_specific.h"
 
 #ifndef WSA_FLAG_NO_HANDLE_INHERIT
@@ -85,10 +86,10 @@ Socket *Socket::AcceptClient(bool wait)
       u_long enable = 1;
       ioctlsocket(s, FIONBIO, &enable);
 
-      BOOL nodelay = TRUE;
-      setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char *)&nodelay, sizeof(nodelay));
+      Socket *ret = new Socket((ptrdiff_t)s);
+      ret->SetNoDelay(true);
 
-      return new Socket((ptrdiff_t)s);
+      return ret;
     }
 
     int err = WSAGetLastError();
@@ -155,6 +156,84 @@ bool Socket::SendDataBlocking(const void *buf, uint32_t length)
   return true;
 }
 
+bool Socket::SendDataBlocking(const SendBuffer *bufs, uint32_t count)
+{
+  // the WSABUFs are advanced past whatever has been sent, so work on a copy
+  std::vector<WSABUF> wsabufs;
+  wsabufs.reserve(count);
+
+  for(uint32_t i = 0; i < count; i++)
+  {
+    if(bufs[i].length == 0)
+      continue;
+
+    WSABUF b = {bufs[i].length, (CHAR *)bufs[i].data};
+    wsabufs.push_back(b);
+  }
+
+  if(wsabufs.empty())
+    return true;
+
+  u_long enable = 0;
+  ioctlsocket(socket, FIONBIO, &enable);
+
+  DWORD timeout = 3000;
+  setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, (const char *)&timeout, sizeof(timeout));
+
+  size_t first = 0;
+
+  while(first < wsabufs.size())
+  {
+    DWORD sent = 0;
+    int ret = WSASend(socket, &wsabufs[first], DWORD(wsabufs.size() - first), &sent, 0, NULL, NULL);
+
+    if(ret != 0)
+    {
+      int err = WSAGetLastError();
+
+      if(err == WSAEWOULDBLOCK)
+      {
+        sent = 0;
+      }
+      else
+      {
+        RDCWARN("WSASend: %d", err);
+        Shutdown();
+        return false;
+      }
+    }
+
+    // skip any buffers that were completely sent, and move into one that was partially sent
+    DWORD remaining = sent;
+
+    while(first < wsabufs.size() && remaining >= wsabufs[first].len)
+    {
+      remaining -= wsabufs[first].len;
+      first++;
+    }
+
+    if(remaining > 0)
+    {
+      wsabufs[first].buf += remaining;
+      wsabufs[first].len -= remaining;
+    }
+  }
+
+  enable = 1;
+  ioctlsocket(socket, FIONBIO, &enable);
+
+  timeout = 600000;
+  setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, (const char *)&timeout, sizeof(timeout));
+
+  return true;
+}
+
+void Socket::SetNoDelay(bool nodelay)
+{
+  BOOL value = nodelay ? TRUE : FALSE;
+  setsockopt((SOCKET)socket, IPPROTO_TCP, TCP_NODELAY, (const char *)&value, sizeof(value));
+}
+
 bool Socket::IsRecvDataWaiting()
 {
   char dummy;
@@ -343,10 +422,10 @@ Socket *CreateClientSocket(const char *host, uint16_t port, int timeoutMS)
       }
     }
 
-    BOOL nodelay = TRUE;
-    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char *)&nodelay, sizeof(nodelay));
+    Socket *ret = new Socket((ptrdiff_t)s);
+    ret->SetNoDelay(true);
 
-    return new Socket((ptrdiff_t)s);
+    return ret;
   }
 
   return NULL;
@@ -26,6 +26,7 @@
 // must be separate so that it's included first and not sorted by clang-format
 #include <windows.h>
 
+#include <psapi.h>
 #include <tchar.h>
 #include <tlhelp32.h>
 #include <string>
@@ -1093,3 +1094,117 @@ uint32_t Process::GetCurrentPID()
 {
   return (uint32_t)GetCurrentProcessId();
 }
+
+uint64_t Process::GetPeakMemoryUsage()
+{
+  PROCESS_MEMORY_COUNTERS counters = {};
+  counters.cb = sizeof(counters);
+
+  if(!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    return 0;
+
+  return (uint64_t)counters.PeakWorkingSetSize;
+}
+
+void Process::InstallCrashLogFlush()
+{
+  // the crash handler flushes the log before writing its minidump, see CrashHandler
+}
+
+static LONG CALLBACK WriteWatchExceptionHandler(EXCEPTION_POINTERS *exception)
+{
+  EXCEPTION_RECORD *rec = exception->ExceptionRecord;
+
+  // ExceptionInformation[0] is 1 for a write access, and [1] is the address accessed
+  if(rec->ExceptionCode == EXCEPTION_ACCESS_VIOLATION && rec->NumberParameters >= 2 &&
+     rec->ExceptionInformation[0] == 1 && WriteWatch::HandleWrite((void *)rec->ExceptionInformation[1]))
+    return EXCEPTION_CONTINUE_EXECUTION;
+
+  return EXCEPTION_CONTINUE_SEARCH;
+}
+
+size_t WriteWatch::GetPageSize()
+{
+  static size_t pageSize = 0;
+
+  if(pageSize == 0)
+  {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    pageSize = info.dwPageSize;
+  }
+
+  return pageSize;
+}
+
+bool WriteWatch::InstallFaultHandler()
+{
+  // GetWriteWatch() would be cheaper, but it only works on memory we allocated ourselves with
+  // MEM_WRITE_WATCH, and the memory we need to watch is mapped by the driver.
+  if(AddVectoredExceptionHandler(1, &WriteWatchExceptionHandler) == NULL)
+  {
+    RDCERR("Couldn't install write-watch exception handler - %u", GetLastError());
+    return false;
+  }
+
+  return true;
+}
+
+bool WriteWatch::Protect(void *base, size_t size, bool writable)
+{
+  DWORD oldProtect = 0;
+  return VirtualProtect(base, size, writable ? PAGE_READWRITE : PAGE_READONLY, &oldProtect) == TRUE;
+}
+
+// large pages need SeLockMemoryPrivilege, which users only have if it's granted by policy. Even
+// then it has to be enabled on the process token before large page allocations succeed.
+static bool EnableLockMemoryPrivilege()
+{
+  HANDLE token = NULL;
+  if(!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+    return false;
+
+  TOKEN_PRIVILEGES privs = {};
+  privs.PrivilegeCount = 1;
+  privs.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+
+  bool ret = false;
+
+  // AdjustTokenPrivileges succeeds even if the privilege wasn't held, and only sets the error
+  if(LookupPrivilegeValueW(NULL, SE_LOCK_MEMORY_NAME, &privs.Privileges[0].Luid) &&
+     AdjustTokenPrivileges(token, FALSE, &privs, 0, NULL, NULL))
+    ret = (GetLastError() == ERROR_SUCCESS);
+
+  CloseHandle(token);
+
+  return ret;
+}
+
+// returns 0 if large pages can't be used
+static size_t GetLargePageSize()
+{
+  static size_t largePageSize = EnableLockMemoryPrivilege() ? GetLargePageMinimum() : 0;
+  return largePageSize;
+}
+
+void *VirtualMemory::Alloc(size_t size, bool largePages)
+{
+  size_t largePageSize = largePages ? GetLargePageSize() : 0;
+
+  if(largePageSize > 0)
+  {
+    // this needs enough physically contiguous memory, so it can fail once memory is fragmented
+    void *ret = VirtualAlloc(NULL, AlignUp(size, largePageSize),
+                             MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+    if(ret)
+      return ret;
+  }
+
+  return VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+}
+
+void VirtualMemory::Free(void *ptr, size_t size)
+{
+  if(ptr)
+    VirtualFree(ptr, 0, MEM_RELEASE);
+}
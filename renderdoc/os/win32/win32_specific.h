@@ -65,6 +65,8 @@ void WriteOutput(int channel, const char *str);
 namespace Threading
 {
 typedef CriticalSectionTemplate<CRITICAL_SECTION> CriticalSection;
+typedef SemaphoreTemplate<HANDLE> Semaphore;
+typedef RWLockTemplate<SRWLOCK> RWLock;
 };
 
 namespace Bits
@@ -84,4 +86,11 @@ inline uint64_t CountLeadingZeroes(uint64_t value)
   return (result == TRUE) ? (index ^ 63) : 64;
 }
 #endif
+
+inline uint32_t CountTrailingZeroes(uint32_t value)
+{
+  DWORD index;
+  BOOLEAN result = _BitScanForward(&index, value);
+  return (result == TRUE) ? index : 32;
+}
 };
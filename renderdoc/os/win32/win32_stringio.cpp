@@ -544,6 +544,71 @@ void logfile_close(void *handle)
 {
   CloseHandle((HANDLE)handle);
 }
+
+struct FileMapping
+{
+  HANDLE file;
+  HANDLE mapping;
+  void *view;
+};
+
+void *mmap_open(const char *filename, const byte **data, uint64_t *size)
+{
+  wstring wfn = StringFormat::UTF82Wide(string(filename));
+
+  HANDLE file = CreateFileW(wfn.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, NULL);
+
+  if(file == INVALID_HANDLE_VALUE)
+    return NULL;
+
+  LARGE_INTEGER fileSize = {};
+  if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0)
+  {
+    CloseHandle(file);
+    return NULL;
+  }
+
+  HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+
+  if(mapping == NULL)
+  {
+    CloseHandle(file);
+    return NULL;
+  }
+
+  void *view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+
+  if(view == NULL)
+  {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return NULL;
+  }
+
+  FileMapping *ret = new FileMapping;
+  ret->file = file;
+  ret->mapping = mapping;
+  ret->view = view;
+
+  *data = (const byte *)view;
+  *size = (uint64_t)fileSize.QuadPart;
+
+  return ret;
+}
+
+void mmap_close(void *handle)
+{
+  FileMapping *mapping = (FileMapping *)handle;
+
+  if(mapping)
+  {
+    UnmapViewOfFile(mapping->view);
+    CloseHandle(mapping->mapping);
+    CloseHandle(mapping->file);
+    delete mapping;
+  }
+}
 };
 
 namespace StringFormat
@@ -26,13 +26,20 @@
 #include <time.h>
 #include "os/os_specific.h"
 
-double Timing::GetTickFrequency()
+static double QueryTickFrequency()
 {
   LARGE_INTEGER li;
   QueryPerformanceFrequency(&li);
   return double(li.QuadPart) / 1000.0;
 }
 
+double Timing::GetTickFrequency()
+{
+  // the frequency is fixed at boot, so only query it once
+  static const double freq = QueryTickFrequency();
+  return freq;
+}
+
 uint64_t Timing::GetTick()
 {
   LARGE_INTEGER li;
@@ -106,6 +113,56 @@ void CriticalSection::Unlock()
   LeaveCriticalSection(&m_Data);
 }
 
+Semaphore::SemaphoreTemplate()
+{
+  m_Data = CreateSemaphore(NULL, 0, LONG_MAX, NULL);
+}
+
+Semaphore::~SemaphoreTemplate()
+{
+  CloseHandle(m_Data);
+}
+
+void Semaphore::Wait()
+{
+  WaitForSingleObject(m_Data, INFINITE);
+}
+
+void Semaphore::Signal(uint32_t count)
+{
+  if(count > 0)
+    ReleaseSemaphore(m_Data, (LONG)count, NULL);
+}
+
+RWLock::RWLockTemplate()
+{
+  InitializeSRWLock(&m_Data);
+}
+
+RWLock::~RWLockTemplate()
+{
+}
+
+void RWLock::ReadLock()
+{
+  AcquireSRWLockShared(&m_Data);
+}
+
+void RWLock::ReadUnlock()
+{
+  ReleaseSRWLockShared(&m_Data);
+}
+
+void RWLock::WriteLock()
+{
+  AcquireSRWLockExclusive(&m_Data);
+}
+
+void RWLock::WriteUnlock()
+{
+  ReleaseSRWLockExclusive(&m_Data);
+}
+
 struct ThreadInitData
 {
   ThreadEntry entryFunc;
@@ -253,4 +310,16 @@ void Sleep(uint32_t milliseconds)
 {
   ::Sleep((DWORD)milliseconds);
 }
+
+uint32_t GetCPUCount()
+{
+  SYSTEM_INFO info = {};
+  GetSystemInfo(&info);
+  return info.dwNumberOfProcessors > 0 ? (uint32_t)info.dwNumberOfProcessors : 1;
+}
+
+void SetCurrentThreadLowPriority()
+{
+  SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+}
 };
@@ -78,6 +78,9 @@ static uint32_t GetNumCaptures()
 
 static uint32_t GetCapture(uint32_t idx, char *logfile, uint32_t *pathlength, uint64_t *timestamp)
 {
+  // the application is given the path, so it has to exist
+  RenderDoc::Inst().EnsureCaptureFile(idx);
+
   vector<CaptureData> caps = RenderDoc::Inst().GetCaptures();
 
   if(idx >= (uint32_t)caps.size())
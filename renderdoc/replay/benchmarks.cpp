@@ -0,0 +1,535 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2017 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "benchmarks.h"
+#include <map>
+#include <vector>
+#include "common/common.h"
+#include "common/timing.h"
+#include "common/wrapped_pool.h"
+#include "core/resource_id_map.h"
+#include "core/resource_manager.h"
+#include "maths/formatpacking.h"
+#include "maths/half_convert.h"
+#include "serialise/serialiser.h"
+#include "serialise/string_utils.h"
+
+// how long to repeat each measurement for, to get a stable enough number
+static const double MinMeasureMilliseconds = 250.0;
+
+// calls f repeatedly for at least MinMeasureMilliseconds, after a warm-up call. Returns the average
+// time per call in seconds
+template <typename Func>
+static double MeasureSeconds(Func f)
+{
+  f();
+
+  uint32_t iters = 0;
+  PerformanceTimer timer;
+  do
+  {
+    f();
+    iters++;
+  } while(timer.GetMilliseconds() < MinMeasureMilliseconds);
+
+  return timer.GetMilliseconds() / (1000.0 * iters);
+}
+
+static double GBPerSecond(size_t bytes, double seconds)
+{
+  return double(bytes) / (seconds * 1024.0 * 1024.0 * 1024.0);
+}
+
+static double MillionsPerSecond(size_t count, double seconds)
+{
+  return double(count) / (seconds * 1000000.0);
+}
+
+static std::string BenchmarkSerialiser()
+{
+  std::string ret = "Serialiser\n";
+
+  // POD arrays, as used for buffer and texture data
+  {
+    const uint32_t numElems = 4 * 1024 * 1024;
+    std::vector<float> data(numElems);
+    for(uint32_t i = 0; i < numElems; i++)
+      data[i] = float(i) * 0.5f;
+
+    Serialiser writer(NULL, Serialiser::WRITING, false);
+
+    double writeSecs = MeasureSeconds([&]() {
+      writer.Rewind();
+      float *el = &data[0];
+      uint32_t count = numElems;
+      writer.SerialisePODArray("", el, count);
+    });
+
+    Serialiser reader((size_t)writer.GetOffset(), writer.GetRawPtr(0), false);
+
+    std::vector<float> readback(numElems);
+
+    double readSecs = MeasureSeconds([&]() {
+      reader.SetOffset(0);
+      float *el = &readback[0];
+      uint32_t count = 0;
+      reader.SerialisePODArray("", el, count);
+    });
+
+    ret += StringFormat::Fmt("  POD array write  %8.2f GB/s\n",
+                             GBPerSecond(numElems * sizeof(float), writeSecs));
+    ret += StringFormat::Fmt("  POD array read   %8.2f GB/s%s\n",
+                             GBPerSecond(numElems * sizeof(float), readSecs),
+                             readback == data ? "" : " (INCORRECT RESULT)");
+  }
+
+  // many short strings, as used for names and shader entry points
+  {
+    const uint32_t numStrings = 64 * 1024;
+    std::vector<std::string> strings(numStrings);
+    for(uint32_t i = 0; i < numStrings; i++)
+      strings[i] = StringFormat::Fmt("Resource name string number %u", i);
+
+    Serialiser writer(NULL, Serialiser::WRITING, false);
+
+    double writeSecs = MeasureSeconds([&]() {
+      writer.Rewind();
+      for(uint32_t i = 0; i < numStrings; i++)
+        writer.SerialiseString("", strings[i]);
+    });
+
+    Serialiser reader((size_t)writer.GetOffset(), writer.GetRawPtr(0), false);
+
+    std::vector<std::string> readback(numStrings);
+
+    double readSecs = MeasureSeconds([&]() {
+      reader.SetOffset(0);
+      for(uint32_t i = 0; i < numStrings; i++)
+        reader.SerialiseString("", readback[i]);
+    });
+
+    ret += StringFormat::Fmt("  string write     %8.2f M/s\n",
+                             MillionsPerSecond(numStrings, writeSecs));
+    ret += StringFormat::Fmt("  string read      %8.2f M/s%s\n",
+                             MillionsPerSecond(numStrings, readSecs),
+                             readback == strings ? "" : " (INCORRECT RESULT)");
+  }
+
+  return ret;
+}
+
+std::string BenchmarkDiffRange(uint32_t sizeMB)
+{
+  const DiffRangeImplementation *impls = NULL;
+  size_t numImpls = GetDiffRangeImplementations(&impls);
+
+  const size_t size = RDCMAX(1U, sizeMB) * 1024 * 1024;
+
+  // room to align the buffers, with a spare vector so the unaligned cases can still compare the
+  // full size
+  byte *aalloc = new byte[size + 32];
+  byte *balloc = new byte[size + 32];
+
+  byte *a = AlignUpPtr(aalloc, 16);
+  byte *b = AlignUpPtr(balloc, 16);
+
+  struct
+  {
+    const char *name;
+    size_t diffStart, diffEnd;
+  } cases[] = {
+      {"identical", 0, 0},
+      {"early diff", 64, 65},
+      {"late diff", size - 64, size - 63},
+      {"diff at both ends", 1, size - 1},
+  };
+
+  std::string ret = StringFormat::Fmt("FindDiffRange over %u MB\n", RDCMAX(1U, sizeMB));
+
+  for(int aligned = 1; aligned >= 0; aligned--)
+  {
+    byte *aptr = aligned ? a : a + 3;
+    byte *bptr = aligned ? b : b + 5;
+
+    for(size_t c = 0; c < ARRAY_COUNT(cases); c++)
+    {
+      for(size_t i = 0; i < size; i++)
+        aptr[i] = bptr[i] = byte(i * 7);
+
+      if(cases[c].diffEnd > 0)
+      {
+        aptr[cases[c].diffStart] ^= 0xff;
+        if(cases[c].diffEnd - 1 != cases[c].diffStart)
+          aptr[cases[c].diffEnd - 1] ^= 0xff;
+      }
+
+      ret += StringFormat::Fmt("  %s, %s:\n", aligned ? "aligned" : "unaligned", cases[c].name);
+
+      for(size_t impl = 0; impl < numImpls; impl++)
+      {
+        size_t diffStart = 0, diffEnd = 0;
+        bool found = impls[impl].func(aptr, bptr, size, diffStart, diffEnd);
+
+        bool correct = !found;
+        if(cases[c].diffEnd > 0)
+          correct = found && diffStart == cases[c].diffStart && diffEnd == cases[c].diffEnd;
+
+        double seconds =
+            MeasureSeconds([&]() { impls[impl].func(aptr, bptr, size, diffStart, diffEnd); });
+
+        ret += StringFormat::Fmt("    %-8s %8.2f GB/s%s\n", impls[impl].name,
+                                 GBPerSecond(size, seconds), correct ? "" : " (INCORRECT RESULT)");
+      }
+    }
+  }
+
+  delete[] aalloc;
+  delete[] balloc;
+
+  return ret;
+}
+
+static std::string BenchmarkConversions()
+{
+  std::string ret = "Format conversion\n";
+
+  const size_t count = 1024 * 1024;
+
+  std::vector<float> floats(count);
+  std::vector<uint16_t> halfs(count);
+  std::vector<uint32_t> packed(count);
+  std::vector<Vec4f> vec4s(count);
+  std::vector<Vec3f> vec3s(count);
+
+  for(size_t i = 0; i < count; i++)
+  {
+    floats[i] = float(i % 4096) / 64.0f - 32.0f;
+    packed[i] = uint32_t(i * 2654435761U);
+  }
+
+  double secs = MeasureSeconds([&]() {
+    for(size_t i = 0; i < count; i++)
+      halfs[i] = ConvertToHalf(floats[i]);
+  });
+  ret += StringFormat::Fmt("  float to half    %8.2f M/s\n", MillionsPerSecond(count, secs));
+
+  secs = MeasureSeconds([&]() {
+    for(size_t i = 0; i < count; i++)
+      floats[i] = ConvertFromHalf(halfs[i]);
+  });
+  ret += StringFormat::Fmt("  half to float    %8.2f M/s\n", MillionsPerSecond(count, secs));
+
+  const HalfConvertImplementation *halfImpls = NULL;
+  size_t numHalfImpls = GetHalfConvertImplementations(&halfImpls);
+
+  for(size_t impl = 0; impl < numHalfImpls; impl++)
+  {
+    secs = MeasureSeconds([&]() { halfImpls[impl].func(halfs.data(), floats.data(), count); });
+    ret += StringFormat::Fmt("  bulk half %-6s %8.2f M/s\n", halfImpls[impl].name,
+                             MillionsPerSecond(count, secs));
+  }
+
+  secs = MeasureSeconds([&]() {
+    for(size_t i = 0; i < count; i++)
+      vec4s[i] = ConvertFromR10G10B10A2(packed[i]);
+  });
+  ret += StringFormat::Fmt("  from R10G10B10A2 %8.2f M/s\n", MillionsPerSecond(count, secs));
+
+  secs = MeasureSeconds([&]() {
+    for(size_t i = 0; i < count; i++)
+      packed[i] = ConvertToR10G10B10A2(vec4s[i]);
+  });
+  ret += StringFormat::Fmt("  to R10G10B10A2   %8.2f M/s\n", MillionsPerSecond(count, secs));
+
+  secs = MeasureSeconds([&]() {
+    for(size_t i = 0; i < count; i++)
+      vec3s[i] = ConvertFromR11G11B10(packed[i]);
+  });
+  ret += StringFormat::Fmt("  from R11G11B10   %8.2f M/s\n", MillionsPerSecond(count, secs));
+
+  secs = MeasureSeconds([&]() {
+    for(size_t i = 0; i < count; i++)
+      vec3s[i] = ConvertFromB5G6R5(uint16_t(packed[i]));
+  });
+  ret += StringFormat::Fmt("  from B5G6R5      %8.2f M/s\n", MillionsPerSecond(count, secs));
+
+  secs = MeasureSeconds([&]() {
+    for(size_t i = 0; i < count; i++)
+      floats[i] = ConvertFromSRGB8(uint8_t(packed[i]));
+  });
+  ret += StringFormat::Fmt("  from SRGB8       %8.2f M/s\n", MillionsPerSecond(count, secs));
+
+  std::vector<uint8_t> bytes(count);
+  for(size_t i = 0; i < count; i++)
+    bytes[i] = uint8_t(packed[i]);
+
+  secs = MeasureSeconds([&]() { ConvertFromSRGB8(bytes.data(), floats.data(), count); });
+  ret += StringFormat::Fmt("  from SRGB8 bulk  %8.2f M/s\n", MillionsPerSecond(count, secs));
+
+  return ret;
+}
+
+struct BenchRecord : public ResourceRecord
+{
+  enum
+  {
+    NullResource = 0
+  };
+
+  BenchRecord(ResourceId id) : ResourceRecord(id, true) {}
+};
+
+// a resource manager with no resources of its own, only used to time record lookups
+class BenchResourceManager : public ResourceManager<void *, void *, BenchRecord>
+{
+public:
+  BenchResourceManager() : ResourceManager(WRITING_IDLE, NULL) {}
+private:
+  bool SerialisableResource(ResourceId id, BenchRecord *record) { return false; }
+  ResourceId GetID(void *res) { return ResourceId(); }
+  bool ResourceTypeRelease(void *res) { return true; }
+  bool Force_InitialState(void *res, bool prepare) { return false; }
+  bool Need_InitialStateChunk(void *res) { return false; }
+  bool Prepare_InitialState(void *res) { return false; }
+  bool Serialise_InitialState(ResourceId id, void *res) { return false; }
+  void Create_InitialState(ResourceId id, void *live, bool hasData) {}
+  void Apply_InitialState(void *live, InitialContentData initial) {}
+};
+
+struct LookupThreadData
+{
+  BenchResourceManager *manager;
+  const std::vector<ResourceId> *ids;
+  size_t lookups;
+  size_t found;
+};
+
+static void LookupThread(void *data)
+{
+  LookupThreadData *lookup = (LookupThreadData *)data;
+
+  const std::vector<ResourceId> &ids = *lookup->ids;
+
+  size_t found = 0;
+  for(size_t i = 0; i < lookup->lookups; i++)
+    if(lookup->manager->GetResourceRecord(ids[(i * 7919) % ids.size()]))
+      found++;
+
+  lookup->found = found;
+}
+
+static std::string BenchmarkResourceManager()
+{
+  std::string ret = "ResourceManager record lookup\n";
+
+  const size_t numRecords = 64 * 1024;
+  const size_t lookupsPerThread = 256 * 1024;
+
+  BenchResourceManager manager;
+
+  std::vector<ResourceId> ids(numRecords);
+  for(size_t i = 0; i < numRecords; i++)
+  {
+    ids[i] = ResourceIDGen::GetNewUniqueID();
+    manager.AddResourceRecord(ids[i]);
+  }
+
+  for(uint32_t numThreads = 1; numThreads <= 8; numThreads *= 2)
+  {
+    std::vector<LookupThreadData> threadData(numThreads);
+
+    double secs = MeasureSeconds([&]() {
+      std::vector<Threading::ThreadHandle> threads(numThreads);
+
+      for(uint32_t t = 0; t < numThreads; t++)
+      {
+        LookupThreadData d = {&manager, &ids, lookupsPerThread, 0};
+        threadData[t] = d;
+        threads[t] = Threading::CreateThread(&LookupThread, &threadData[t]);
+      }
+
+      for(uint32_t t = 0; t < numThreads; t++)
+      {
+        Threading::JoinThread(threads[t]);
+        Threading::CloseThread(threads[t]);
+      }
+    });
+
+    bool correct = true;
+    for(uint32_t t = 0; t < numThreads; t++)
+      correct &= (threadData[t].found == lookupsPerThread);
+
+    ret += StringFormat::Fmt("  %u thread(s)     %8.2f M/s%s\n", numThreads,
+                             MillionsPerSecond(lookupsPerThread * numThreads, secs),
+                             correct ? "" : " (INCORRECT RESULT)");
+  }
+
+  for(size_t i = 0; i < numRecords; i++)
+    manager.GetResourceRecord(ids[i])->Delete(&manager);
+
+  return ret;
+}
+
+template <typename MapType>
+static std::string BenchmarkIdMap(const char *name, const std::vector<ResourceId> &ids,
+                                  const std::vector<ResourceId> &lookupOrder)
+{
+  MapType m;
+
+  double insertSecs = MeasureSeconds([&]() {
+    m.clear();
+    for(size_t i = 0; i < ids.size(); i++)
+      m[ids[i]] = ids[i];
+  });
+
+  size_t found = 0;
+  double lookupSecs = MeasureSeconds([&]() {
+    found = 0;
+    for(size_t i = 0; i < lookupOrder.size(); i++)
+    {
+      auto it = m.find(lookupOrder[i]);
+      if(it != m.end() && it->second == lookupOrder[i])
+        found++;
+    }
+  });
+
+  return StringFormat::Fmt("  %-16s insert %8.2f M/s, lookup %8.2f M/s%s\n", name,
+                           MillionsPerSecond(ids.size(), insertSecs),
+                           MillionsPerSecond(lookupOrder.size(), lookupSecs),
+                           found == lookupOrder.size() ? "" : " (INCORRECT RESULT)");
+}
+
+static std::string BenchmarkResourceIdMap()
+{
+  std::string ret = "ResourceId maps\n";
+
+  for(size_t numIds = 1024; numIds <= 512 * 1024; numIds *= 8)
+  {
+    std::vector<ResourceId> ids(numIds);
+    for(size_t i = 0; i < numIds; i++)
+      ids[i] = ResourceIDGen::GetNewUniqueID();
+
+    // look up in a scattered order, as replaying or capturing a frame would
+    std::vector<ResourceId> lookupOrder(numIds);
+    for(size_t i = 0; i < numIds; i++)
+      lookupOrder[i] = ids[(i * 7919) % numIds];
+
+    ret += StringFormat::Fmt(" %u IDs\n", (uint32_t)numIds);
+    ret += BenchmarkIdMap<std::map<ResourceId, ResourceId> >("std::map", ids, lookupOrder);
+    ret += BenchmarkIdMap<ResourceIdMap<ResourceId> >("ResourceIdMap", ids, lookupOrder);
+  }
+
+  return ret;
+}
+
+struct BenchPoolObject
+{
+  uint64_t data[8];
+
+  ALLOCATE_WITH_WRAPPED_POOL(BenchPoolObject);
+};
+
+WRAPPED_POOL_INST(BenchPoolObject);
+
+static void PoolThread(void *data)
+{
+  size_t rounds = *(size_t *)data;
+
+  const size_t batch = 256;
+  BenchPoolObject *objs[batch];
+
+  for(size_t r = 0; r < rounds; r++)
+  {
+    for(size_t i = 0; i < batch; i++)
+      objs[i] = new BenchPoolObject();
+    for(size_t i = 0; i < batch; i++)
+      delete objs[i];
+  }
+}
+
+static std::string BenchmarkWrappedPool()
+{
+  std::string ret = "WrappingPool allocate and free\n";
+
+  size_t rounds = 1024;
+
+  for(uint32_t numThreads = 1; numThreads <= 8; numThreads *= 2)
+  {
+    double secs = MeasureSeconds([&]() {
+      std::vector<Threading::ThreadHandle> threads(numThreads);
+
+      for(uint32_t t = 0; t < numThreads; t++)
+        threads[t] = Threading::CreateThread(&PoolThread, &rounds);
+
+      for(uint32_t t = 0; t < numThreads; t++)
+      {
+        Threading::JoinThread(threads[t]);
+        Threading::CloseThread(threads[t]);
+      }
+    });
+
+    // one allocation and one free per object
+    ret += StringFormat::Fmt("  %u thread(s)     %8.2f M/s\n", numThreads,
+                             MillionsPerSecond(rounds * 256 * 2 * numThreads, secs));
+  }
+
+  return ret;
+}
+
+std::string RunBenchmarks(const std::string &filter)
+{
+  struct
+  {
+    const char *name;
+    std::string (*func)();
+  } benchmarks[] = {
+      {"serialiser", &BenchmarkSerialiser},
+      {"compression", []() { return BenchmarkCompression(64); }},
+      {"diffrange", []() { return BenchmarkDiffRange(16); }},
+      {"conversion", &BenchmarkConversions},
+      {"resourcemanager", &BenchmarkResourceManager},
+      {"resourceidmap", &BenchmarkResourceIdMap},
+      {"wrappedpool", &BenchmarkWrappedPool},
+  };
+
+  std::string ret;
+
+  for(size_t i = 0; i < ARRAY_COUNT(benchmarks); i++)
+  {
+    if(!filter.empty() && strstr(benchmarks[i].name, filter.c_str()) == NULL)
+      continue;
+
+    ret += benchmarks[i].func();
+    ret += "\n";
+  }
+
+  if(ret.empty())
+  {
+    ret = "No benchmarks match '" + filter + "'. Available benchmarks:\n";
+    for(size_t i = 0; i < ARRAY_COUNT(benchmarks); i++)
+      ret += std::string("  ") + benchmarks[i].name + "\n";
+  }
+
+  return ret;
+}
@@ -23,6 +23,7 @@
  ******************************************************************************/
 
 #include "api/replay/renderdoc_replay.h"
+#include "core/capture_session.h"
 #include "core/core.h"
 #include "jpeg-compressor/jpgd.h"
 #include "jpeg-compressor/jpge.h"
@@ -50,15 +51,26 @@ public:
   ReplaySupport LocalReplaySupport() { return m_Support; }
   const char *DriverName() { return m_DriverName.c_str(); }
   const char *RecordedMachineIdent() { return m_Ident.c_str(); }
+  void SetReplayGPU(uint32_t gpu) { m_GPU = gpu; }
   rdctype::pair<ReplayStatus, IReplayController *> OpenCapture(float *progress);
 
   rdctype::array<byte> GetThumbnail(FileType type, uint32_t maxsize);
+  ReplayStatus Repack(const char *destfile, uint32_t compressLevel, bool stripCallstacks,
+                      bool stripThumbnail)
+  {
+    if(m_Status != ReplayStatus::Succeeded)
+      return m_Status;
+
+    return RenderDoc::RepackCapture(Filename(), destfile, compressLevel, stripCallstacks,
+                                    stripThumbnail);
+  }
 
 private:
   std::string m_Filename, m_DriverName, m_Ident;
   RDCDriver m_DriverType;
   ReplayStatus m_Status;
   ReplaySupport m_Support;
+  uint32_t m_GPU;
 };
 
 CaptureFile::CaptureFile(const char *f)
@@ -66,9 +78,25 @@ CaptureFile::CaptureFile(const char *f)
   m_Filename = f;
 
   m_DriverType = RDC_Unknown;
+  m_GPU = ~0U;
   uint64_t fileMachineIdent = 0;
-  m_Status = RenderDoc::Inst().FillInitParams(Filename(), m_DriverType, m_DriverName,
-                                              fileMachineIdent, NULL);
+
+  // opening for the file browser and recent captures list only needs the metadata, which saves
+  // scanning the whole capture. Anything wrong with the rest of the file shows up when it's opened
+  // for replay.
+  CaptureMetadata metadata;
+  if(RenderDoc::ReadCaptureMetadata(Filename(), metadata))
+  {
+    m_DriverType = metadata.driverType;
+    m_DriverName = metadata.driverName;
+    fileMachineIdent = metadata.machineIdent;
+    m_Status = ReplayStatus::Succeeded;
+  }
+  else
+  {
+    m_Status = RenderDoc::Inst().FillInitParams(Filename(), m_DriverType, m_DriverName,
+                                                fileMachineIdent, NULL);
+  }
 
   if(m_Status != ReplayStatus::Succeeded)
   {
@@ -101,10 +129,12 @@ rdctype::pair<ReplayStatus, IReplayController *> CaptureFile::OpenCapture(float
   ReplayStatus ret;
 
   RenderDoc::Inst().SetProgressPtr(progress);
+  RenderDoc::Inst().SetReplayGPU(m_GPU);
 
   ret = render->CreateDevice(Filename());
 
   RenderDoc::Inst().SetProgressPtr(NULL);
+  RenderDoc::Inst().SetReplayGPU(~0U);
 
   if(ret != ReplayStatus::Succeeded)
     SAFE_DELETE(render);
@@ -116,28 +146,46 @@ rdctype::array<byte> CaptureFile::GetThumbnail(FileType type, uint32_t maxsize)
 {
   rdctype::array<byte> buf;
 
-  Serialiser ser(Filename(), Serialiser::READING, false);
+  byte *jpgbuf = NULL;
+  size_t thumblen = 0;
+  uint32_t thumbwidth = 0, thumbheight = 0;
 
-  if(ser.HasError())
-    return buf;
+  CaptureMetadata metadata;
 
-  ser.Rewind();
+  // the metadata at the start of the file has a copy of the thumbnail, only older captures need to
+  // be opened to find it
+  if(RenderDoc::ReadCaptureMetadata(Filename(), metadata))
+  {
+    if(metadata.thumbnail.empty())
+      return buf;
 
-  int chunkType = ser.PushContext(NULL, NULL, 1, false);
+    thumblen = metadata.thumbnail.size();
+    thumbwidth = metadata.thumbWidth;
+    thumbheight = metadata.thumbHeight;
 
-  if(chunkType != THUMBNAIL_DATA)
-    return buf;
+    jpgbuf = new byte[thumblen];
+    memcpy(jpgbuf, &metadata.thumbnail[0], thumblen);
+  }
+  else
+  {
+    Serialiser ser(Filename(), Serialiser::READING, false);
 
-  bool HasThumbnail = false;
-  ser.Serialise(NULL, HasThumbnail);
+    if(ser.HasError())
+      return buf;
 
-  if(!HasThumbnail)
-    return buf;
+    ser.Rewind();
+
+    int chunkType = ser.PushContext(NULL, NULL, 1, false);
+
+    if(chunkType != THUMBNAIL_DATA)
+      return buf;
+
+    bool HasThumbnail = false;
+    ser.Serialise(NULL, HasThumbnail);
+
+    if(!HasThumbnail)
+      return buf;
 
-  byte *jpgbuf = NULL;
-  size_t thumblen = 0;
-  uint32_t thumbwidth = 0, thumbheight = 0;
-  {
     ser.Serialise("ThumbWidth", thumbwidth);
     ser.Serialise("ThumbHeight", thumbheight);
     ser.SerialiseBuffer("ThumbnailPixels", jpgbuf, thumblen);
@@ -246,4 +294,16 @@ rdctype::array<byte> CaptureFile::GetThumbnail(FileType type, uint32_t maxsize)
 extern "C" RENDERDOC_API ICaptureFile *RENDERDOC_CC RENDERDOC_OpenCaptureFile(const char *logfile)
 {
   return new CaptureFile(logfile);
+}
+
+extern "C" RENDERDOC_API uint32_t RENDERDOC_CC
+RENDERDOC_GetSessionCaptureCount(const char *sessionfile)
+{
+  return GetSessionCaptureCount(sessionfile);
+}
+
+extern "C" RENDERDOC_API ReplayStatus RENDERDOC_CC
+RENDERDOC_ExtractSessionCapture(const char *sessionfile, uint32_t index, const char *destfile)
+{
+  return ExtractSessionCapture(sessionfile, index, destfile);
 }
\ No newline at end of file
@@ -48,6 +48,27 @@ int RENDERDOC_CC SetCaptureOptionU32(RENDERDOC_CaptureOption opt, uint32_t val)
     case eRENDERDOC_Option_SaveAllInitials: opts.SaveAllInitials = (val != 0); break;
     case eRENDERDOC_Option_CaptureAllCmdLists: opts.CaptureAllCmdLists = (val != 0); break;
     case eRENDERDOC_Option_DebugOutputMute: opts.DebugOutputMute = (val != 0); break;
+    case eRENDERDOC_Option_CompressionLevel: opts.CompressionLevel = RDCMIN(val, 9U); break;
+    case eRENDERDOC_Option_DeduplicateInitialContents:
+      opts.DeduplicateInitialContents = (val != 0);
+      break;
+    case eRENDERDOC_Option_WriteCapturesAsync: opts.WriteCapturesAsync = (val != 0); break;
+    case eRENDERDOC_Option_FramesPerCapture: opts.FramesPerCapture = RDCMAX(val, 1U); break;
+    case eRENDERDOC_Option_TrackCoherentMapWrites: opts.TrackCoherentMapWrites = (val != 0); break;
+    case eRENDERDOC_Option_ProfileAPICalls: opts.ProfileAPICalls = (val != 0); break;
+    case eRENDERDOC_Option_ReduceIdleOverhead: opts.ReduceIdleOverhead = (val != 0); break;
+    case eRENDERDOC_Option_PrepareAheadBudget: opts.PrepareAheadBudget = val; break;
+    case eRENDERDOC_Option_CompressInitialContentsOnGPU:
+      opts.CompressInitialContentsOnGPU = (val != 0);
+      break;
+    case eRENDERDOC_Option_InitialContentsBudget: opts.InitialContentsBudget = val; break;
+    case eRENDERDOC_Option_FrameTimeTriggerMS: opts.FrameTimeTriggerMS = val; break;
+    case eRENDERDOC_Option_FrameTimeTriggerMultiple:
+      opts.FrameTimeTriggerMultiple = (float)val;
+      break;
+    case eRENDERDOC_Option_AppendCapturesToSession:
+      opts.AppendCapturesToSession = (val != 0);
+      break;
     default: RDCLOG("Unrecognised capture option '%d'", opt); return 0;
   }
 
@@ -75,6 +96,39 @@ int RENDERDOC_CC SetCaptureOptionF32(RENDERDOC_CaptureOption opt, float val)
     case eRENDERDOC_Option_SaveAllInitials: opts.SaveAllInitials = (val != 0.0f); break;
     case eRENDERDOC_Option_CaptureAllCmdLists: opts.CaptureAllCmdLists = (val != 0.0f); break;
     case eRENDERDOC_Option_DebugOutputMute: opts.DebugOutputMute = (val != 0.0f); break;
+    case eRENDERDOC_Option_CompressionLevel:
+      opts.CompressionLevel = RDCMIN((uint32_t)RDCMAX(val, 0.0f), 9U);
+      break;
+    case eRENDERDOC_Option_DeduplicateInitialContents:
+      opts.DeduplicateInitialContents = (val != 0.0f);
+      break;
+    case eRENDERDOC_Option_WriteCapturesAsync: opts.WriteCapturesAsync = (val != 0.0f); break;
+    case eRENDERDOC_Option_FramesPerCapture:
+      opts.FramesPerCapture = RDCMAX((uint32_t)RDCMAX(val, 0.0f), 1U);
+      break;
+    case eRENDERDOC_Option_TrackCoherentMapWrites:
+      opts.TrackCoherentMapWrites = (val != 0.0f);
+      break;
+    case eRENDERDOC_Option_ProfileAPICalls: opts.ProfileAPICalls = (val != 0.0f); break;
+    case eRENDERDOC_Option_ReduceIdleOverhead: opts.ReduceIdleOverhead = (val != 0.0f); break;
+    case eRENDERDOC_Option_PrepareAheadBudget:
+      opts.PrepareAheadBudget = (uint32_t)RDCMAX(val, 0.0f);
+      break;
+    case eRENDERDOC_Option_CompressInitialContentsOnGPU:
+      opts.CompressInitialContentsOnGPU = (val != 0.0f);
+      break;
+    case eRENDERDOC_Option_InitialContentsBudget:
+      opts.InitialContentsBudget = (uint32_t)RDCMAX(val, 0.0f);
+      break;
+    case eRENDERDOC_Option_FrameTimeTriggerMS:
+      opts.FrameTimeTriggerMS = (uint32_t)RDCMAX(val, 0.0f);
+      break;
+    case eRENDERDOC_Option_FrameTimeTriggerMultiple:
+      opts.FrameTimeTriggerMultiple = RDCMAX(val, 0.0f);
+      break;
+    case eRENDERDOC_Option_AppendCapturesToSession:
+      opts.AppendCapturesToSession = (val != 0.0f);
+      break;
     default: RDCLOG("Unrecognised capture option '%d'", opt); return 0;
   }
 
@@ -110,6 +164,32 @@ uint32_t RENDERDOC_CC GetCaptureOptionU32(RENDERDOC_CaptureOption opt)
       return (RenderDoc::Inst().GetCaptureOptions().CaptureAllCmdLists ? 1 : 0);
     case eRENDERDOC_Option_DebugOutputMute:
       return (RenderDoc::Inst().GetCaptureOptions().DebugOutputMute ? 1 : 0);
+    case eRENDERDOC_Option_CompressionLevel:
+      return (RenderDoc::Inst().GetCaptureOptions().CompressionLevel);
+    case eRENDERDOC_Option_DeduplicateInitialContents:
+      return (RenderDoc::Inst().GetCaptureOptions().DeduplicateInitialContents ? 1 : 0);
+    case eRENDERDOC_Option_WriteCapturesAsync:
+      return (RenderDoc::Inst().GetCaptureOptions().WriteCapturesAsync ? 1 : 0);
+    case eRENDERDOC_Option_FramesPerCapture:
+      return (RenderDoc::Inst().GetCaptureOptions().FramesPerCapture);
+    case eRENDERDOC_Option_TrackCoherentMapWrites:
+      return (RenderDoc::Inst().GetCaptureOptions().TrackCoherentMapWrites ? 1 : 0);
+    case eRENDERDOC_Option_ProfileAPICalls:
+      return (RenderDoc::Inst().GetCaptureOptions().ProfileAPICalls ? 1 : 0);
+    case eRENDERDOC_Option_ReduceIdleOverhead:
+      return (RenderDoc::Inst().GetCaptureOptions().ReduceIdleOverhead ? 1 : 0);
+    case eRENDERDOC_Option_PrepareAheadBudget:
+      return RenderDoc::Inst().GetCaptureOptions().PrepareAheadBudget;
+    case eRENDERDOC_Option_CompressInitialContentsOnGPU:
+      return (RenderDoc::Inst().GetCaptureOptions().CompressInitialContentsOnGPU ? 1 : 0);
+    case eRENDERDOC_Option_InitialContentsBudget:
+      return RenderDoc::Inst().GetCaptureOptions().InitialContentsBudget;
+    case eRENDERDOC_Option_FrameTimeTriggerMS:
+      return RenderDoc::Inst().GetCaptureOptions().FrameTimeTriggerMS;
+    case eRENDERDOC_Option_FrameTimeTriggerMultiple:
+      return (uint32_t)RenderDoc::Inst().GetCaptureOptions().FrameTimeTriggerMultiple;
+    case eRENDERDOC_Option_AppendCapturesToSession:
+      return (RenderDoc::Inst().GetCaptureOptions().AppendCapturesToSession ? 1 : 0);
     default: break;
   }
 
@@ -145,6 +225,32 @@ float RENDERDOC_CC GetCaptureOptionF32(RENDERDOC_CaptureOption opt)
       return (RenderDoc::Inst().GetCaptureOptions().CaptureAllCmdLists ? 1.0f : 0.0f);
     case eRENDERDOC_Option_DebugOutputMute:
       return (RenderDoc::Inst().GetCaptureOptions().DebugOutputMute ? 1.0f : 0.0f);
+    case eRENDERDOC_Option_CompressionLevel:
+      return (RenderDoc::Inst().GetCaptureOptions().CompressionLevel * 1.0f);
+    case eRENDERDOC_Option_DeduplicateInitialContents:
+      return (RenderDoc::Inst().GetCaptureOptions().DeduplicateInitialContents ? 1.0f : 0.0f);
+    case eRENDERDOC_Option_WriteCapturesAsync:
+      return (RenderDoc::Inst().GetCaptureOptions().WriteCapturesAsync ? 1.0f : 0.0f);
+    case eRENDERDOC_Option_FramesPerCapture:
+      return (RenderDoc::Inst().GetCaptureOptions().FramesPerCapture * 1.0f);
+    case eRENDERDOC_Option_TrackCoherentMapWrites:
+      return (RenderDoc::Inst().GetCaptureOptions().TrackCoherentMapWrites ? 1.0f : 0.0f);
+    case eRENDERDOC_Option_ProfileAPICalls:
+      return (RenderDoc::Inst().GetCaptureOptions().ProfileAPICalls ? 1.0f : 0.0f);
+    case eRENDERDOC_Option_ReduceIdleOverhead:
+      return (RenderDoc::Inst().GetCaptureOptions().ReduceIdleOverhead ? 1.0f : 0.0f);
+    case eRENDERDOC_Option_PrepareAheadBudget:
+      return (float)RenderDoc::Inst().GetCaptureOptions().PrepareAheadBudget;
+    case eRENDERDOC_Option_CompressInitialContentsOnGPU:
+      return (RenderDoc::Inst().GetCaptureOptions().CompressInitialContentsOnGPU ? 1.0f : 0.0f);
+    case eRENDERDOC_Option_InitialContentsBudget:
+      return (float)RenderDoc::Inst().GetCaptureOptions().InitialContentsBudget;
+    case eRENDERDOC_Option_FrameTimeTriggerMS:
+      return (float)RenderDoc::Inst().GetCaptureOptions().FrameTimeTriggerMS;
+    case eRENDERDOC_Option_FrameTimeTriggerMultiple:
+      return RenderDoc::Inst().GetCaptureOptions().FrameTimeTriggerMultiple;
+    case eRENDERDOC_Option_AppendCapturesToSession:
+      return (RenderDoc::Inst().GetCaptureOptions().AppendCapturesToSession ? 1.0f : 0.0f);
     default: break;
   }
 
@@ -166,4 +272,17 @@ CaptureOptions::CaptureOptions()
   SaveAllInitials = false;
   CaptureAllCmdLists = false;
   DebugOutputMute = true;
+  CompressionLevel = 0;
+  DeduplicateInitialContents = false;
+  WriteCapturesAsync = false;
+  FramesPerCapture = 1;
+  TrackCoherentMapWrites = false;
+  ProfileAPICalls = false;
+  ReduceIdleOverhead = false;
+  PrepareAheadBudget = 0;
+  CompressInitialContentsOnGPU = false;
+  InitialContentsBudget = 0;
+  FrameTimeTriggerMS = 0;
+  FrameTimeTriggerMultiple = 0.0f;
+  AppendCapturesToSession = false;
 }
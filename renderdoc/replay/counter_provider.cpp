@@ -0,0 +1,328 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2017 Baldur Karlsson
+ * Copyright (c) 2014 Crytek
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "counter_provider.h"
+#include <string.h>
+#include <algorithm>
+#include "os/os_specific.h"
+#include "serialise/string_utils.h"
+
+// each IHV range is this wide, so a provider's counters can't spill into the next range
+static const uint32_t ProviderRangeSize =
+    uint32_t(GPUCounter::FirstIntel) - uint32_t(GPUCounter::FirstAMD);
+
+static bool IsComplete(const RENDERDOC_CounterProvider &funcs)
+{
+  return funcs.Init && funcs.Shutdown && funcs.NumCounters && funcs.DescribeCounter &&
+         funcs.BeginSession && funcs.BeginPass && funcs.BeginSample && funcs.EndSample &&
+         funcs.EndPass && funcs.EndSession && funcs.GetResult;
+}
+
+void CounterProviders::Init(RENDERDOC_CounterAPI api, void *nativeDevice)
+{
+  Shutdown();
+
+  vector<std::string> libraries;
+  split(RenderDoc::Inst().GetConfigSetting("replay.counterProviders"), libraries, ';');
+
+  for(const std::string &lib : libraries)
+  {
+    std::string path = trim(lib);
+
+    if(path.empty())
+      continue;
+
+    void *module = Process::LoadModule(path.c_str());
+
+    if(module == NULL)
+    {
+      RDCWARN("Couldn't load counter provider '%s'", path.c_str());
+      continue;
+    }
+
+    pRENDERDOC_GetCounterProvider getProvider =
+        (pRENDERDOC_GetCounterProvider)Process::GetFunctionAddress(module,
+                                                                  "RENDERDOC_GetCounterProvider");
+
+    Provider p = {};
+
+    if(getProvider == NULL || !getProvider(RENDERDOC_COUNTER_PROVIDER_VERSION, &p.funcs) ||
+       p.funcs.version != RENDERDOC_COUNTER_PROVIDER_VERSION || !IsComplete(p.funcs))
+    {
+      RDCWARN("'%s' is not a compatible counter provider", path.c_str());
+      continue;
+    }
+
+    if(p.funcs.counterBase < uint32_t(GPUCounter::FirstAMD) ||
+       p.funcs.counterBase >= uint32_t(GPUCounter::FirstEstimated))
+    {
+      RDCWARN("Counter provider '%s' uses reserved counter IDs from %u", path.c_str(),
+              p.funcs.counterBase);
+      continue;
+    }
+
+    if(!p.funcs.Init(api, nativeDevice))
+    {
+      RDCLOG("Counter provider '%s' doesn't support this device", path.c_str());
+      continue;
+    }
+
+    p.numCounters = RDCMIN(p.funcs.NumCounters(), ProviderRangeSize);
+    p.numCounters =
+        RDCMIN(p.numCounters, uint32_t(GPUCounter::FirstEstimated) - p.funcs.counterBase);
+
+    bool overlap = false;
+    for(const Provider &o : m_Providers)
+    {
+      if(p.funcs.counterBase < o.funcs.counterBase + o.numCounters &&
+         o.funcs.counterBase < p.funcs.counterBase + p.numCounters)
+        overlap = true;
+    }
+
+    if(overlap)
+    {
+      RDCWARN("Counter provider '%s' overlaps another provider's counters", path.c_str());
+      p.funcs.Shutdown();
+      continue;
+    }
+
+    RDCLOG("Loaded %u counters from counter provider '%s'", p.numCounters, path.c_str());
+
+    m_Providers.push_back(p);
+  }
+}
+
+void CounterProviders::Shutdown()
+{
+  for(Provider &p : m_Providers)
+    p.funcs.Shutdown();
+
+  m_Providers.clear();
+}
+
+CounterProviders::Provider *CounterProviders::GetProvider(GPUCounter counterID, uint32_t &index)
+{
+  for(Provider &p : m_Providers)
+  {
+    uint32_t c = (uint32_t)counterID;
+    if(c >= p.funcs.counterBase && c < p.funcs.counterBase + p.numCounters)
+    {
+      index = c - p.funcs.counterBase;
+      return &p;
+    }
+  }
+
+  return NULL;
+}
+
+const CounterProviders::Provider *CounterProviders::GetProvider(GPUCounter counterID,
+                                                                uint32_t &index) const
+{
+  return const_cast<CounterProviders *>(this)->GetProvider(counterID, index);
+}
+
+bool CounterProviders::IsProviderCounter(GPUCounter counterID) const
+{
+  uint32_t index = 0;
+  return GetProvider(counterID, index) != NULL;
+}
+
+vector<GPUCounter> CounterProviders::EnumerateCounters() const
+{
+  vector<GPUCounter> ret;
+
+  for(const Provider &p : m_Providers)
+    for(uint32_t i = 0; i < p.numCounters; i++)
+      ret.push_back(GPUCounter(p.funcs.counterBase + i));
+
+  return ret;
+}
+
+bool CounterProviders::DescribeCounter(GPUCounter counterID, CounterDescription &desc) const
+{
+  uint32_t index = 0;
+  const Provider *p = GetProvider(counterID, index);
+
+  if(p == NULL)
+    return false;
+
+  RENDERDOC_CounterProviderDescription providerDesc = {};
+  p->funcs.DescribeCounter(index, &providerDesc);
+
+  desc.counterID = counterID;
+  desc.name = providerDesc.name ? providerDesc.name : "Unknown";
+  desc.description = providerDesc.description ? providerDesc.description : "";
+  desc.resultByteWidth = 8;
+  desc.resultType =
+      providerDesc.type == eRENDERDOC_CounterType_Double ? CompType::Double : CompType::UInt;
+
+  switch(providerDesc.unit)
+  {
+    case eRENDERDOC_CounterUnit_Seconds: desc.unit = CounterUnit::Seconds; break;
+    case eRENDERDOC_CounterUnit_Percentage: desc.unit = CounterUnit::Percentage; break;
+    case eRENDERDOC_CounterUnit_Bytes: desc.unit = CounterUnit::Bytes; break;
+    default: desc.unit = CounterUnit::Absolute; break;
+  }
+
+  return true;
+}
+
+bool CounterProviders::SplitCounters(const vector<GPUCounter> &counters,
+                                     vector<GPUCounter> &apiCounters,
+                                     vector<GPUCounter> &providerCounters) const
+{
+  for(GPUCounter c : counters)
+  {
+    if(IsProviderCounter(c))
+      providerCounters.push_back(c);
+    else
+      apiCounters.push_back(c);
+  }
+
+  return !providerCounters.empty();
+}
+
+uint32_t CounterProviders::BeginSession(const vector<GPUCounter> &counters)
+{
+  m_SessionCounters.clear();
+  m_SessionEvents.clear();
+  m_CurrentPass = 0;
+
+  for(Provider &p : m_Providers)
+  {
+    p.sessionIndices.clear();
+    p.sessionPasses = 0;
+  }
+
+  for(GPUCounter c : counters)
+  {
+    uint32_t index = 0;
+    Provider *p = GetProvider(c, index);
+
+    if(p == NULL)
+      continue;
+
+    m_SessionCounters.push_back(c);
+    p->sessionIndices.push_back(index);
+  }
+
+  // providers schedule their own counters into passes, and we replay enough times to satisfy the
+  // provider needing the most. Providers that finish early sit out the remaining passes.
+  uint32_t numPasses = 0;
+
+  for(Provider &p : m_Providers)
+  {
+    if(p.sessionIndices.empty())
+      continue;
+
+    p.sessionPasses =
+        RDCMAX(1U, p.funcs.BeginSession(&p.sessionIndices[0], (uint32_t)p.sessionIndices.size()));
+    numPasses = RDCMAX(numPasses, p.sessionPasses);
+  }
+
+  return numPasses;
+}
+
+void CounterProviders::BeginPass(uint32_t pass)
+{
+  m_CurrentPass = pass;
+
+  for(Provider &p : m_Providers)
+    if(pass < p.sessionPasses)
+      p.funcs.BeginPass(pass);
+}
+
+void CounterProviders::BeginSample(uint32_t eventID, void *nativeCommand)
+{
+  // every pass replays the same events, so the first one is enough to know what was sampled
+  if(m_CurrentPass == 0)
+    m_SessionEvents.push_back(eventID);
+
+  for(Provider &p : m_Providers)
+    if(m_CurrentPass < p.sessionPasses)
+      p.funcs.BeginSample(eventID, nativeCommand);
+}
+
+void CounterProviders::EndSample(uint32_t eventID, void *nativeCommand)
+{
+  for(Provider &p : m_Providers)
+    if(m_CurrentPass < p.sessionPasses)
+      p.funcs.EndSample(eventID, nativeCommand);
+}
+
+void CounterProviders::EndPass(uint32_t pass)
+{
+  for(Provider &p : m_Providers)
+    if(pass < p.sessionPasses)
+      p.funcs.EndPass(pass);
+}
+
+vector<CounterResult> CounterProviders::EndSession()
+{
+  vector<CounterResult> ret;
+
+  for(Provider &p : m_Providers)
+    if(p.sessionPasses > 0)
+      p.funcs.EndSession();
+
+  // an event recorded into a command buffer that's submitted several times is only sampled once
+  std::sort(m_SessionEvents.begin(), m_SessionEvents.end());
+  m_SessionEvents.erase(std::unique(m_SessionEvents.begin(), m_SessionEvents.end()),
+                        m_SessionEvents.end());
+
+  ret.reserve(m_SessionEvents.size() * m_SessionCounters.size());
+
+  for(uint32_t eventID : m_SessionEvents)
+  {
+    for(GPUCounter c : m_SessionCounters)
+    {
+      uint32_t index = 0;
+      Provider *p = GetProvider(c, index);
+
+      CounterResult result;
+      result.eventID = eventID;
+      result.counterID = c;
+
+      // leave the value as 0 if the provider couldn't produce it, so every event still has a
+      // result for every counter
+      uint64_t value = 0;
+      if(p->funcs.GetResult(eventID, index, &value))
+        memcpy(&result.value, &value, sizeof(value));
+
+      ret.push_back(result);
+    }
+  }
+
+  for(Provider &p : m_Providers)
+  {
+    p.sessionIndices.clear();
+    p.sessionPasses = 0;
+  }
+
+  m_SessionCounters.clear();
+  m_SessionEvents.clear();
+
+  return ret;
+}
@@ -0,0 +1,85 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2017 Baldur Karlsson
+ * Copyright (c) 2014 Crytek
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include "api/replay/renderdoc_counter_provider.h"
+#include "api/replay/renderdoc_replay.h"
+#include "core/core.h"
+
+// Loads the vendor counter provider libraries listed in the replay.counterProviders config
+// setting and exposes their counters as GPUCounter values in the IHV ranges. Each replay driver
+// owns one of these and drives it from FetchCounters, since only the driver knows how to bracket
+// individual events on its command lists.
+class CounterProviders
+{
+public:
+  CounterProviders() : m_CurrentPass(0) {}
+  ~CounterProviders() { Shutdown(); }
+  void Init(RENDERDOC_CounterAPI api, void *nativeDevice);
+  void Shutdown();
+
+  bool IsProviderCounter(GPUCounter counterID) const;
+
+  vector<GPUCounter> EnumerateCounters() const;
+  // returns false if the counter doesn't belong to any provider
+  bool DescribeCounter(GPUCounter counterID, CounterDescription &desc) const;
+
+  // split the requested counters into those the driver fetches itself and those that come from a
+  // provider. Returns true if there are any provider counters.
+  bool SplitCounters(const vector<GPUCounter> &counters, vector<GPUCounter> &apiCounters,
+                     vector<GPUCounter> &providerCounters) const;
+
+  // a session gathers provider counters over several replays of the frame. The driver replays the
+  // frame once for each pass returned by BeginSession, bracketing each pass with BeginPass/EndPass
+  // and every event with BeginSample/EndSample.
+  uint32_t BeginSession(const vector<GPUCounter> &counters);
+  void BeginPass(uint32_t pass);
+  void BeginSample(uint32_t eventID, void *nativeCommand);
+  void EndSample(uint32_t eventID, void *nativeCommand);
+  void EndPass(uint32_t pass);
+  // returns one result for every sampled event and requested counter
+  vector<CounterResult> EndSession();
+
+private:
+  struct Provider
+  {
+    RENDERDOC_CounterProvider funcs;
+    uint32_t numCounters;
+
+    // counter indices requested in the current session, and the passes they need
+    vector<uint32_t> sessionIndices;
+    uint32_t sessionPasses;
+  };
+
+  Provider *GetProvider(GPUCounter counterID, uint32_t &index);
+  const Provider *GetProvider(GPUCounter counterID, uint32_t &index) const;
+
+  vector<Provider> m_Providers;
+
+  vector<GPUCounter> m_SessionCounters;
+  vector<uint32_t> m_SessionEvents;
+  uint32_t m_CurrentPass;
+};
@@ -27,9 +27,11 @@
 #include "api/replay/renderdoc_replay.h"
 #include "api/replay/version.h"
 #include "common/common.h"
+#include "common/timing.h"
 #include "core/core.h"
 #include "maths/camera.h"
 #include "maths/formatpacking.h"
+#include "replay/benchmarks.h"
 #include "replay/type_helpers.h"
 #include "serialise/string_utils.h"
 
@@ -165,6 +167,61 @@ extern "C" RENDERDOC_API uint16_t RENDERDOC_CC Maths_FloatToHalf(float f)
   return ConvertToHalf(f);
 }
 
+static void ApplyShaderChanges(rdctype::array<ShaderVariable> &vars,
+                               const rdctype::array<ShaderRegisterChange> &changes)
+{
+  for(int32_t i = 0; i < changes.count; i++)
+  {
+    const ShaderRegisterChange &c = changes[i];
+
+    if(c.index < (uint32_t)vars.count)
+      vars[c.index].value = c.value;
+  }
+}
+
+extern "C" RENDERDOC_API void RENDERDOC_CC ShaderDebug_ReconstructState(
+    const ShaderDebugTrace *trace, int32_t step, int32_t currentStep, ShaderDebugState *state)
+{
+  if(trace == NULL || state == NULL || step < 0 || step >= trace->steps.count)
+    return;
+
+  int32_t interval = (int32_t)RDCMAX(1U, trace->keyframeInterval);
+  int32_t keyframe = RDCMIN(step / interval, trace->keyframes.count - 1);
+
+  if(keyframe < 0)
+    return;
+
+  int32_t keyframeStep = keyframe * interval;
+
+  // the current state can only be re-used if it's between the keyframe and where we're going,
+  // otherwise start from the keyframe itself
+  if(currentStep < keyframeStep || currentStep > step)
+  {
+    *state = trace->keyframes[keyframe];
+    currentStep = keyframeStep;
+  }
+
+  for(int32_t s = currentStep + 1; s <= step; s++)
+  {
+    const ShaderDebugStateDelta &delta = trace->steps[s];
+
+    ApplyShaderChanges(state->registers, delta.registers);
+    ApplyShaderChanges(state->outputs, delta.outputs);
+
+    for(int32_t i = 0; i < delta.indexableTemps.count; i++)
+    {
+      const ShaderRegisterChange &c = delta.indexableTemps[i];
+
+      if(c.arrayIndex < (uint32_t)state->indexableTemps.count &&
+         c.index < (uint32_t)state->indexableTemps[c.arrayIndex].count)
+        state->indexableTemps[c.arrayIndex][c.index].value = c.value;
+    }
+  }
+
+  state->nextInstruction = trace->steps[step].nextInstruction;
+  state->flags = trace->steps[step].flags;
+}
+
 extern "C" RENDERDOC_API Camera *RENDERDOC_CC Camera_InitArcball()
 {
   return new Camera(Camera::eType_Arcball);
@@ -246,6 +303,27 @@ extern "C" RENDERDOC_API void RENDERDOC_CC RENDERDOC_SetConfigSetting(const char
                                                                       const char *value)
 {
   RenderDoc::Inst().SetConfigSetting(name, value);
+
+  // the job system doesn't know about config settings, so pass this one on
+  if(!strcmp(name, "threading.workerCount"))
+    Threading::JobSystem::SetWorkerCount((uint32_t)atoi(value));
+}
+
+extern "C" RENDERDOC_API uint64_t RENDERDOC_CC RENDERDOC_GetPeakMemoryUsage()
+{
+  return Process::GetPeakMemoryUsage();
+}
+
+extern "C" RENDERDOC_API void RENDERDOC_CC RENDERDOC_BenchmarkDiffRange(uint32_t sizeMB,
+                                                                        rdctype::str *report)
+{
+  *report = BenchmarkDiffRange(sizeMB);
+}
+
+extern "C" RENDERDOC_API void RENDERDOC_CC RENDERDOC_RunBenchmarks(const char *filter,
+                                                                  rdctype::str *report)
+{
+  *report = RunBenchmarks(filter ? filter : "");
 }
 
 extern "C" RENDERDOC_API void *RENDERDOC_CC RENDERDOC_MakeEnvironmentModificationList(int numElems)
@@ -0,0 +1,323 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "index_analysis.h"
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "os/os_specific.h"
+
+// Simulating the vertex cache looks every index up in every cache entry, so that's done a vector of
+// entries at a time. Unlike FindDiffRange there's no wider path worth detecting at runtime, and
+// SSE2 and NEON are always present on the 64-bit targets, so the implementation is picked at
+// compile time.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define INDEX_ANALYSIS_SSE2 OPTION_ON
+#else
+#define INDEX_ANALYSIS_SSE2 OPTION_OFF
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define INDEX_ANALYSIS_NEON OPTION_ON
+#else
+#define INDEX_ANALYSIS_NEON OPTION_OFF
+#endif
+
+#if ENABLED(INDEX_ANALYSIS_SSE2)
+#include <emmintrin.h>
+#elif ENABLED(INDEX_ANALYSIS_NEON)
+#include <arm_neon.h>
+#endif
+
+// restart indices are widened to this, and it's what empty cache entries hold. A real index can't
+// be this large as no vertex buffer can hold that many vertices
+static const uint32_t NoIndex = ~0U;
+
+// the simulated caches. These are the common models used for index buffer optimisation - a small
+// FIFO like most fixed-function hardware, and a larger LRU approximating newer batch-based designs.
+// Both must be multiples of 4 entries, and no more than 32.
+static const uint32_t FIFOCacheSize = 16;
+static const uint32_t LRUCacheSize = 32;
+
+// returns a bitmask of which of the count entries hold idx
+static uint32_t MatchEntries(const uint32_t *entries, uint32_t count, uint32_t idx)
+{
+  uint32_t mask = 0;
+
+#if ENABLED(INDEX_ANALYSIS_SSE2)
+  __m128i key = _mm_set1_epi32((int)idx);
+  for(uint32_t i = 0; i < count; i += 4)
+  {
+    __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(entries + i)), key);
+    mask |= uint32_t(_mm_movemask_ps(_mm_castsi128_ps(eq))) << i;
+  }
+#elif ENABLED(INDEX_ANALYSIS_NEON)
+  // NEON has no movemask, so give each lane its own bit and add them across
+  static const uint32_t laneBits[4] = {1, 2, 4, 8};
+  uint32x4_t bits = vld1q_u32(laneBits);
+  uint32x4_t key = vdupq_n_u32(idx);
+  for(uint32_t i = 0; i < count; i += 4)
+  {
+    uint32x4_t eq = vandq_u32(vceqq_u32(vld1q_u32(entries + i), key), bits);
+    uint32x2_t sum = vpadd_u32(vget_low_u32(eq), vget_high_u32(eq));
+    mask |= vget_lane_u32(vpadd_u32(sum, sum), 0) << i;
+  }
+#else
+  for(uint32_t i = 0; i < count; i++)
+  {
+    if(entries[i] == idx)
+      mask |= 1U << i;
+  }
+#endif
+
+  return mask;
+}
+
+// finds the smallest and largest index, ignoring restarts
+static void GetIndexRange(const uint32_t *indices, uint32_t count, uint32_t &minIdx,
+                          uint32_t &maxIdx)
+{
+  uint32_t lo = NoIndex, hi = 0;
+  uint32_t i = 0;
+
+#if ENABLED(INDEX_ANALYSIS_SSE2)
+  // SSE2 only has signed 32-bit compares, so flip the sign bit to order unsigned values. Restarts
+  // are already the largest value so only need masking out of the maximum
+  const __m128i bias = _mm_set1_epi32(int(0x80000000));
+  const __m128i restart = _mm_set1_epi32(int(NoIndex));
+  __m128i vlo = _mm_xor_si128(restart, bias);
+  __m128i vhi = bias;
+
+  for(; i + 4 <= count; i += 4)
+  {
+    __m128i v = _mm_loadu_si128((const __m128i *)(indices + i));
+    __m128i lov = _mm_xor_si128(v, bias);
+    __m128i hiv = _mm_xor_si128(_mm_andnot_si128(_mm_cmpeq_epi32(v, restart), v), bias);
+
+    __m128i lt = _mm_cmplt_epi32(lov, vlo);
+    vlo = _mm_or_si128(_mm_and_si128(lt, lov), _mm_andnot_si128(lt, vlo));
+    __m128i gt = _mm_cmpgt_epi32(hiv, vhi);
+    vhi = _mm_or_si128(_mm_and_si128(gt, hiv), _mm_andnot_si128(gt, vhi));
+  }
+
+  uint32_t los[4], his[4];
+  _mm_storeu_si128((__m128i *)los, _mm_xor_si128(vlo, bias));
+  _mm_storeu_si128((__m128i *)his, _mm_xor_si128(vhi, bias));
+#elif ENABLED(INDEX_ANALYSIS_NEON)
+  const uint32x4_t restart = vdupq_n_u32(NoIndex);
+  uint32x4_t vlo = restart;
+  uint32x4_t vhi = vdupq_n_u32(0);
+
+  for(; i + 4 <= count; i += 4)
+  {
+    uint32x4_t v = vld1q_u32(indices + i);
+    vlo = vminq_u32(vlo, v);
+    vhi = vmaxq_u32(vhi, vbicq_u32(v, vceqq_u32(v, restart)));
+  }
+
+  uint32_t los[4], his[4];
+  vst1q_u32(los, vlo);
+  vst1q_u32(his, vhi);
+#endif
+
+#if ENABLED(INDEX_ANALYSIS_SSE2) || ENABLED(INDEX_ANALYSIS_NEON)
+  for(int l = 0; l < 4; l++)
+  {
+    lo = RDCMIN(lo, los[l]);
+    hi = RDCMAX(hi, his[l]);
+  }
+#endif
+
+  for(; i < count; i++)
+  {
+    if(indices[i] == NoIndex)
+      continue;
+
+    lo = RDCMIN(lo, indices[i]);
+    hi = RDCMAX(hi, indices[i]);
+  }
+
+  minIdx = lo;
+  maxIdx = hi;
+}
+
+static uint32_t CountUniqueIndices(const std::vector<uint32_t> &indices, uint32_t lo, uint32_t hi)
+{
+  if(lo > hi)
+    return 0;
+
+  uint64_t range = uint64_t(hi) - lo + 1;
+
+  // a bit per index in the range is quickest, but 32-bit indices can be spread far wider than
+  // there are indices, so sort a copy instead if the bits would take much more memory than that
+  if(range > uint64_t(indices.size()) * 32 + 65536)
+  {
+    std::vector<uint32_t> sorted(indices);
+    std::sort(sorted.begin(), sorted.end());
+    size_t unique = std::unique(sorted.begin(), sorted.end()) - sorted.begin();
+
+    // restarts sort to the end
+    if(unique > 0 && sorted[unique - 1] == NoIndex)
+      unique--;
+
+    return (uint32_t)unique;
+  }
+
+  std::vector<uint64_t> seen(size_t((range + 63) / 64), 0);
+  uint32_t ret = 0;
+
+  for(uint32_t idx : indices)
+  {
+    if(idx == NoIndex)
+      continue;
+
+    uint64_t &word = seen[(idx - lo) / 64];
+    uint64_t bit = 1ULL << ((idx - lo) % 64);
+
+    if((word & bit) == 0)
+      ret++;
+    word |= bit;
+  }
+
+  return ret;
+}
+
+IndexStats AnalyseIndices(const byte *data, uint32_t numIndices, uint32_t byteWidth, bool strip)
+{
+  IndexStats ret;
+
+  // widen everything to 32-bit first, so nothing after this needs to care about the width
+  std::vector<uint32_t> indices(numIndices);
+
+  if(byteWidth == 4)
+  {
+    memcpy(indices.data(), data, numIndices * sizeof(uint32_t));
+  }
+  else if(byteWidth == 2)
+  {
+    const uint16_t *src = (const uint16_t *)data;
+    for(uint32_t i = 0; i < numIndices; i++)
+      indices[i] = strip && src[i] == 0xffff ? NoIndex : src[i];
+  }
+  else if(byteWidth == 1)
+  {
+    for(uint32_t i = 0; i < numIndices; i++)
+      indices[i] = strip && data[i] == 0xff ? NoIndex : data[i];
+  }
+  else
+  {
+    return ret;
+  }
+
+  // a partial triangle at the end of a list is never drawn
+  if(!strip)
+    indices.resize(numIndices - numIndices % 3);
+
+  uint32_t count = (uint32_t)indices.size();
+
+  if(strip)
+  {
+    // after the first two indices of each run, every index finishes a triangle
+    uint32_t run = 0;
+    for(uint32_t i = 0; i < count; i++)
+    {
+      if(indices[i] == NoIndex)
+      {
+        run = 0;
+        continue;
+      }
+
+      if(++run < 3)
+        continue;
+
+      uint32_t a = indices[i - 2], b = indices[i - 1], c = indices[i];
+
+      ret.triangles++;
+      if(a == b || b == c || a == c)
+        ret.degenerateTriangles++;
+    }
+  }
+  else
+  {
+    for(uint32_t i = 0; i < count; i += 3)
+    {
+      uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+
+      ret.triangles++;
+      if(a == b || b == c || a == c)
+        ret.degenerateTriangles++;
+    }
+  }
+
+  GetIndexRange(indices.data(), count, ret.minIndex, ret.maxIndex);
+  ret.uniqueVertices = CountUniqueIndices(indices, ret.minIndex, ret.maxIndex);
+
+  // every index is looked up in turn. For strips the two previous vertices of each triangle were
+  // the last two looked up, so they always hit and looking up just the new one is equivalent
+  uint32_t fifo[FIFOCacheSize];
+  uint32_t fifoNext = 0;
+
+  // each LRU entry and the tick it was last used on. The least recently used entry is only needed
+  // on a miss, so it's cheaper to search for it then than to keep the entries in order
+  uint32_t lru[LRUCacheSize];
+  uint32_t lruUsed[LRUCacheSize] = {};
+  uint32_t tick = 0;
+
+  std::fill(fifo, fifo + FIFOCacheSize, NoIndex);
+  std::fill(lru, lru + LRUCacheSize, NoIndex);
+
+  for(uint32_t i = 0; i < count; i++)
+  {
+    uint32_t idx = indices[i];
+
+    if(idx == NoIndex)
+      continue;
+
+    if(MatchEntries(fifo, FIFOCacheSize, idx) == 0)
+    {
+      ret.fifoMisses++;
+      fifo[fifoNext] = idx;
+      fifoNext = (fifoNext + 1) % FIFOCacheSize;
+    }
+
+    uint32_t hit = MatchEntries(lru, LRUCacheSize, idx);
+    uint32_t slot = 0;
+
+    if(hit)
+    {
+      slot = Bits::CountTrailingZeroes(hit);
+    }
+    else
+    {
+      ret.lruMisses++;
+      slot = uint32_t(std::min_element(lruUsed, lruUsed + LRUCacheSize) - lruUsed);
+      lru[slot] = idx;
+    }
+
+    lruUsed[slot] = ++tick;
+  }
+
+  return ret;
+}
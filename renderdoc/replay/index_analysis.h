@@ -0,0 +1,47 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include "common/common.h"
+
+// the results of simulating an index buffer through the post-transform vertex cache, for
+// GetIndexEfficiency
+struct IndexStats
+{
+  uint32_t triangles = 0;
+  uint32_t degenerateTriangles = 0;
+  // distinct vertices referenced, and the range they lie in. minIndex > maxIndex if there are none
+  uint32_t uniqueVertices = 0;
+  uint32_t minIndex = ~0U;
+  uint32_t maxIndex = 0;
+  // vertices transformed by a 16-entry FIFO cache and by a 32-entry LRU cache
+  uint32_t fifoMisses = 0;
+  uint32_t lruMisses = 0;
+};
+
+// analyses numIndices indices of byteWidth 1, 2 or 4 bytes, drawn as a triangle list or as a
+// triangle strip. Strips are cut at the all-ones restart index for the width.
+IndexStats AnalyseIndices(const byte *data, uint32_t numIndices, uint32_t byteWidth, bool strip);
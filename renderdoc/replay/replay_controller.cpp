@@ -24,9 +24,13 @@
  ******************************************************************************/
 
 #include "replay_controller.h"
+#include <math.h>
+#include <algorithm>
+#include <deque>
 #include <string.h>
 #include <time.h>
 #include "common/dds_readwrite.h"
+#include "common/profiler.h"
 #include "jpeg-compressor/jpgd.h"
 #include "jpeg-compressor/jpge.h"
 #include "maths/formatpacking.h"
@@ -160,6 +164,41 @@ float ConvertComponent(const ResourceFormat &fmt, byte *data)
   return 0.0f;
 }
 
+void ConvertComponents(const ResourceFormat &fmt, const byte *data, size_t count, float *out)
+{
+  // the common formats get a tight loop of their own, so the format is only decoded once rather
+  // than for every component
+  if(fmt.compByteWidth == 4 && fmt.compType == CompType::Float)
+  {
+    memcpy(out, data, count * sizeof(float));
+  }
+  else if(fmt.compByteWidth == 2 && fmt.compType == CompType::Float)
+  {
+    ConvertFromHalf((const uint16_t *)data, out, count);
+  }
+  else if(fmt.compByteWidth == 2 &&
+          (fmt.compType == CompType::UNorm || fmt.compType == CompType::Depth))
+  {
+    const uint16_t *u16 = (const uint16_t *)data;
+    for(size_t i = 0; i < count; i++)
+      out[i] = float(u16[i]) / 65535.0f;
+  }
+  else if(fmt.compByteWidth == 1 && fmt.compType == CompType::UNorm && fmt.srgbCorrected)
+  {
+    ConvertFromSRGB8(data, out, count);
+  }
+  else if(fmt.compByteWidth == 1 && fmt.compType == CompType::UNorm)
+  {
+    for(size_t i = 0; i < count; i++)
+      out[i] = float(data[i]) / 255.0f;
+  }
+  else
+  {
+    for(size_t i = 0; i < count; i++)
+      out[i] = ConvertComponent(fmt, (byte *)data + i * fmt.compByteWidth);
+  }
+}
+
 static void fileWriteFunc(void *context, void *data, int size)
 {
   FileIO::fwrite(data, 1, size, (FILE *)context);
@@ -170,6 +209,8 @@ ReplayController::ReplayController()
   m_pDevice = NULL;
 
   m_EventID = 100000;
+
+  m_CancelRequested = false;
 }
 
 ReplayController::~ReplayController()
@@ -194,10 +235,18 @@ ReplayController::~ReplayController()
   if(m_pDevice)
     m_pDevice->Shutdown();
   m_pDevice = NULL;
+
+  Profiler::EndTrace();
 }
 
 void ReplayController::SetFrameEvent(uint32_t eventID, bool force)
 {
+  SCOPED_PROFILE("ReplayController::SetFrameEvent", eventID);
+
+  // only whole-pass analysis in the outputs is cancellable here. The replays themselves always run
+  // to completion so the current state is never left partially applied.
+  ScopedReplayCancel cancel(&m_CancelRequested);
+
   if(eventID != m_EventID || force)
   {
     m_EventID = eventID;
@@ -233,971 +282,4616 @@ VKPipe::State ReplayController::GetVulkanPipelineState()
   return m_VulkanPipelineState;
 }
 
-FrameDescription ReplayController::GetFrameInfo()
+// a constant block read by a bound shader, and where its contents come from. IDs are original IDs,
+// as in the pipeline state.
+struct ConstantBlockSource
 {
-  return m_FrameRecord.frameInfo;
-}
-
-DrawcallDescription *ReplayController::GetDrawcallByEID(uint32_t eventID)
+  ShaderStage stage;
+  ResourceId shader;
+  std::string entryPoint;
+  uint32_t slot;
+  ResourceId buffer;
+  uint64_t offset = 0;
+  uint64_t size = 0;
+  // contents that are set directly rather than read from a buffer, e.g. D3D12 root constants
+  vector<byte> inlineData;
+};
+
+// returns false if a block that should be read from a buffer has no binding
+static bool GetConstantBlockBinding(const ShaderReflection *refl, const ShaderBindpointMapping &map,
+                                    int32_t i, BindpointMap &bind)
 {
-  if(eventID >= m_Drawcalls.size())
-    return NULL;
+  const ConstantBlock &cb = refl->ConstantBlocks[i];
 
-  return m_Drawcalls[eventID];
-}
+  if(!cb.bufferBacked)
+    return true;
 
-rdctype::array<DrawcallDescription> ReplayController::GetDrawcalls()
-{
-  return m_FrameRecord.drawcallList;
+  if(cb.bindPoint < 0 || cb.bindPoint >= map.ConstantBlocks.count)
+    return false;
+
+  bind = map.ConstantBlocks[cb.bindPoint];
+  return bind.bind >= 0;
 }
 
-rdctype::array<CounterResult> ReplayController::FetchCounters(const rdctype::array<GPUCounter> &counters)
+static void GetConstantBlockSources(const D3D11Pipe::State &pipe, vector<ConstantBlockSource> &out)
 {
-  vector<GPUCounter> counterArray;
-  counterArray.reserve(counters.count);
-  for(int32_t i = 0; i < counters.count; i++)
-    counterArray.push_back(counters[i]);
+  const D3D11Pipe::Shader *stages[] = {
+      &pipe.m_VS, &pipe.m_HS, &pipe.m_DS, &pipe.m_GS, &pipe.m_PS, &pipe.m_CS,
+  };
 
-  return m_pDevice->FetchCounters(counterArray);
-}
+  for(int s = 0; s < 6; s++)
+  {
+    const D3D11Pipe::Shader &sh = *stages[s];
+    if(sh.Object == ResourceId() || sh.ShaderDetails == NULL)
+      continue;
 
-rdctype::array<GPUCounter> ReplayController::EnumerateCounters()
-{
-  return m_pDevice->EnumerateCounters();
+    for(int32_t i = 0; i < sh.ShaderDetails->ConstantBlocks.count; i++)
+    {
+      BindpointMap bind;
+      if(!GetConstantBlockBinding(sh.ShaderDetails, sh.BindpointMapping, i, bind) ||
+         bind.bind >= sh.ConstantBuffers.count)
+        continue;
+
+      const D3D11Pipe::CBuffer &cb = sh.ConstantBuffers[bind.bind];
+
+      ConstantBlockSource src;
+      src.stage = StageFromIndex(s);
+      src.shader = sh.Object;
+      src.slot = (uint32_t)i;
+      src.buffer = cb.Buffer;
+      src.offset = uint64_t(cb.VecOffset) * 16;
+      src.size = uint64_t(cb.VecCount) * 16;
+
+      if(src.buffer != ResourceId())
+        out.push_back(src);
+    }
+  }
 }
 
-CounterDescription ReplayController::DescribeCounter(GPUCounter counterID)
+static void GetConstantBlockSources(const D3D12Pipe::State &pipe, vector<ConstantBlockSource> &out)
 {
-  CounterDescription ret;
+  const D3D12Pipe::Shader *stages[] = {
+      &pipe.m_VS, &pipe.m_HS, &pipe.m_DS, &pipe.m_GS, &pipe.m_PS, &pipe.m_CS,
+  };
 
-  m_pDevice->DescribeCounter(counterID, ret);
+  for(int s = 0; s < 6; s++)
+  {
+    const D3D12Pipe::Shader &sh = *stages[s];
+    if(sh.Object == ResourceId() || sh.ShaderDetails == NULL)
+      continue;
 
-  return ret;
+    for(int32_t i = 0; i < sh.ShaderDetails->ConstantBlocks.count; i++)
+    {
+      BindpointMap bind;
+      if(!GetConstantBlockBinding(sh.ShaderDetails, sh.BindpointMapping, i, bind) ||
+         bind.bindset < 0 || bind.bindset >= sh.Spaces.count ||
+         bind.bind >= sh.Spaces[bind.bindset].ConstantBuffers.count)
+        continue;
+
+      const D3D12Pipe::CBuffer &cb = sh.Spaces[bind.bindset].ConstantBuffers[bind.bind];
+
+      ConstantBlockSource src;
+      src.stage = StageFromIndex(s);
+      src.shader = sh.Object;
+      src.slot = (uint32_t)i;
+
+      if(cb.Immediate)
+      {
+        const byte *values = (const byte *)cb.RootValues.elems;
+        src.inlineData.assign(values, values + cb.RootValues.count * sizeof(uint32_t));
+        src.size = src.inlineData.size();
+        out.push_back(src);
+      }
+      else if(cb.Buffer != ResourceId())
+      {
+        src.buffer = cb.Buffer;
+        src.offset = cb.Offset;
+        src.size = cb.ByteSize;
+        out.push_back(src);
+      }
+    }
+  }
 }
 
-rdctype::array<BufferDescription> ReplayController::GetBuffers()
+static void GetConstantBlockSources(const GLPipe::State &pipe, vector<ConstantBlockSource> &out)
 {
-  if(m_Buffers.empty())
+  const GLPipe::Shader *stages[] = {
+      &pipe.m_VS, &pipe.m_TCS, &pipe.m_TES, &pipe.m_GS, &pipe.m_FS, &pipe.m_CS,
+  };
+
+  for(int s = 0; s < 6; s++)
   {
-    vector<ResourceId> ids = m_pDevice->GetBuffers();
+    const GLPipe::Shader &sh = *stages[s];
+    if(sh.Object == ResourceId() || sh.ShaderDetails == NULL)
+      continue;
 
-    m_Buffers.resize(ids.size());
+    for(int32_t i = 0; i < sh.ShaderDetails->ConstantBlocks.count; i++)
+    {
+      BindpointMap bind;
+      if(!GetConstantBlockBinding(sh.ShaderDetails, sh.BindpointMapping, i, bind))
+        continue;
 
-    for(size_t i = 0; i < ids.size(); i++)
-      m_Buffers[i] = m_pDevice->GetBuffer(ids[i]);
-  }
+      ConstantBlockSource src;
+      src.stage = StageFromIndex(s);
+      src.shader = sh.Object;
+      src.slot = (uint32_t)i;
 
-  return m_Buffers;
+      // bare uniforms are read from the program itself
+      if(sh.ShaderDetails->ConstantBlocks[i].bufferBacked)
+      {
+        if(bind.bind >= pipe.UniformBuffers.count ||
+           pipe.UniformBuffers[bind.bind].Resource == ResourceId())
+          continue;
+
+        const GLPipe::Buffer &ubo = pipe.UniformBuffers[bind.bind];
+        src.buffer = ubo.Resource;
+        src.offset = ubo.Offset;
+        src.size = ubo.Size;
+      }
+
+      out.push_back(src);
+    }
+  }
 }
 
-rdctype::array<TextureDescription> ReplayController::GetTextures()
+static void GetConstantBlockSources(const VKPipe::State &pipe, vector<ConstantBlockSource> &out)
 {
-  if(m_Textures.empty())
+  const VKPipe::Shader *stages[] = {
+      &pipe.m_VS, &pipe.m_TCS, &pipe.m_TES, &pipe.m_GS, &pipe.m_FS, &pipe.m_CS,
+  };
+
+  for(int s = 0; s < 6; s++)
   {
-    vector<ResourceId> ids = m_pDevice->GetTextures();
+    const VKPipe::Shader &sh = *stages[s];
+    if(sh.Object == ResourceId() || sh.ShaderDetails == NULL)
+      continue;
 
-    m_Textures.resize(ids.size());
+    const VKPipe::Pipeline &p =
+        StageFromIndex(s) == ShaderStage::Compute ? pipe.compute : pipe.graphics;
 
-    for(size_t i = 0; i < ids.size(); i++)
-      m_Textures[i] = m_pDevice->GetTexture(ids[i]);
-  }
+    for(int32_t i = 0; i < sh.ShaderDetails->ConstantBlocks.count; i++)
+    {
+      BindpointMap bind;
+      if(!GetConstantBlockBinding(sh.ShaderDetails, sh.BindpointMapping, i, bind))
+        continue;
 
-  return m_Textures;
+      ConstantBlockSource src;
+      src.stage = StageFromIndex(s);
+      src.shader = sh.Object;
+      src.entryPoint = sh.entryPoint.c_str();
+      src.slot = (uint32_t)i;
+
+      // push constants and specialisation constants are filled in by the driver
+      if(sh.ShaderDetails->ConstantBlocks[i].bufferBacked)
+      {
+        if(bind.bindset < 0 || bind.bindset >= p.DescSets.count ||
+           bind.bind >= p.DescSets[bind.bindset].bindings.count ||
+           p.DescSets[bind.bindset].bindings[bind.bind].binds.count == 0)
+          continue;
+
+        const VKPipe::BindingElement &el = p.DescSets[bind.bindset].bindings[bind.bind].binds[0];
+        if(el.res == ResourceId())
+          continue;
+
+        src.buffer = el.res;
+        src.offset = el.offset;
+        src.size = el.size;
+      }
+
+      out.push_back(src);
+    }
+  }
 }
 
-rdctype::array<rdctype::str> ReplayController::GetResolve(const rdctype::array<uint64_t> &callstack)
+rdctype::array<EventData> ReplayController::GetEventData(const rdctype::array<uint32_t> &eventIDs,
+                                                         EventDataFlags flags,
+                                                         const rdctype::array<GPUCounter> &counters)
 {
-  rdctype::array<rdctype::str> ret;
+  SCOPED_PROFILE("ReplayController::GetEventData");
 
-  if(callstack.empty())
-    return ret;
+  vector<uint32_t> events(eventIDs.begin(), eventIDs.end());
+  std::sort(events.begin(), events.end());
+  events.erase(std::unique(events.begin(), events.end()), events.end());
 
-  Callstack::StackResolver *resolv = m_pDevice->GetCallstackResolver();
+  vector<EventData> ret;
 
-  if(resolv == NULL)
+  if(events.empty())
     return ret;
 
-  create_array_uninit(ret, (size_t)callstack.count);
-  for(int32_t i = 0; i < callstack.count; i++)
+  ScopedReplayCancel cancel(&m_CancelRequested);
+
+  // counters replay the whole frame by themselves, so fetch them all at once up front
+  std::map<uint32_t, vector<CounterResult> > eventCounters;
+
+  if((flags & EventDataFlags::Counters) && counters.count > 0)
   {
-    Callstack::AddressDetails info = resolv->GetAddr(callstack[i]);
-    ret[i] = info.formattedString();
+    rdctype::array<CounterResult> results = FetchCounters(counters);
+    for(const CounterResult &r : results)
+      eventCounters[r.eventID].push_back(r);
   }
 
-  return ret;
-}
+  // the usage data is by live ID, but everything returned uses original IDs
+  ResourceIdMap<ResourceId> originalIDs;
 
-rdctype::array<DebugMessage> ReplayController::GetDebugMessages()
-{
-  return m_pDevice->GetDebugMessages();
-}
+  if(flags & EventDataFlags::BoundResources)
+  {
+    BuildEventDependencies();
 
-rdctype::array<EventUsage> ReplayController::GetUsage(ResourceId id)
-{
-  return m_pDevice->GetUsage(m_pDevice->GetLiveID(id));
-}
+    for(const TextureDescription &tex : m_Textures)
+      originalIDs[m_pDevice->GetLiveID(tex.ID)] = tex.ID;
+    for(const BufferDescription &buf : m_Buffers)
+      originalIDs[m_pDevice->GetLiveID(buf.ID)] = buf.ID;
+  }
 
-MeshFormat ReplayController::GetPostVSData(uint32_t instID, MeshDataStage stage)
-{
-  DrawcallDescription *draw = GetDrawcallByEID(m_EventID);
+  GraphicsAPI api = m_pDevice->GetAPIProperties().pipelineType;
 
-  MeshFormat ret;
-  RDCEraseEl(ret);
+  bool needState = bool(flags & (EventDataFlags::PipelineState | EventDataFlags::ConstantBuffers));
 
-  if(draw == NULL || !(draw->flags & DrawFlags::Drawcall))
-    return MeshFormat();
+  // the event whose state the replay is currently at, if any
+  uint32_t replayedEvent = 0;
 
-  instID = RDCMIN(instID, draw->numInstances - 1);
+  ret.reserve(events.size());
 
-  return m_pDevice->GetPostVSBuffers(draw->eventID, instID, stage);
-}
+  for(uint32_t eventID : events)
+  {
+    if(m_CancelRequested)
+      break;
 
-rdctype::array<byte> ReplayController::GetBufferData(ResourceId buff, uint64_t offset, uint64_t len)
-{
-  rdctype::array<byte> ret;
+    EventData data;
+    data.eventID = eventID;
 
-  if(buff == ResourceId())
-    return ret;
+    if(needState)
+    {
+      if(replayedEvent == 0 || !m_pDevice->AdvanceReplay(replayedEvent, eventID))
+        m_pDevice->ReplayLog(eventID, eReplay_WithoutDraw);
 
-  ResourceId liveId = m_pDevice->GetLiveID(buff);
+      replayedEvent = eventID;
 
-  if(liveId == ResourceId())
-  {
-    RDCERR("Couldn't get Live ID for %llu getting buffer data", buff);
-    return ret;
-  }
+      FetchPipelineState();
 
-  vector<byte> retData;
-  m_pDevice->GetBufferData(liveId, offset, len, retData);
+      if(flags & EventDataFlags::PipelineState)
+      {
+        if(api == GraphicsAPI::D3D11)
+          data.d3d11 = m_D3D11PipelineState;
+        else if(api == GraphicsAPI::D3D12)
+          data.d3d12 = m_D3D12PipelineState;
+        else if(api == GraphicsAPI::OpenGL)
+          data.gl = m_GLPipelineState;
+        else if(api == GraphicsAPI::Vulkan)
+          data.vulkan = m_VulkanPipelineState;
+      }
 
-  create_array_init(ret, retData.size(), !retData.empty() ? &retData[0] : NULL);
+      if(flags & EventDataFlags::ConstantBuffers)
+        data.constantBlocks = GetBoundConstantBlocks();
+    }
+
+    if(flags & EventDataFlags::BoundResources)
+    {
+      auto it = m_EventResources.find(eventID);
+      if(it != m_EventResources.end())
+      {
+        vector<EventResourceUsage> resources;
+
+        for(const std::pair<ResourceId, ResourceUsage> &u : it->second.usage)
+        {
+          auto orig = originalIDs.find(u.first);
+
+          EventResourceUsage res;
+          res.resourceId = orig == originalIDs.end() ? u.first : orig->second;
+          res.usage = u.second;
+          resources.push_back(res);
+        }
+
+        data.resources = resources;
+      }
+    }
+
+    auto counterIt = eventCounters.find(eventID);
+    if(counterIt != eventCounters.end())
+      data.counters = counterIt->second;
+
+    ret.push_back(data);
+  }
+
+  // go back to the current event, since the replay and pipeline state have moved on
+  if(needState)
+    SetFrameEvent(m_EventID, true);
 
   return ret;
 }
 
-rdctype::array<byte> ReplayController::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip)
+rdctype::array<EventConstantBlock> ReplayController::GetBoundConstantBlocks()
 {
-  rdctype::array<byte> ret;
+  vector<ConstantBlockSource> sources;
 
-  ResourceId liveId = m_pDevice->GetLiveID(tex);
+  GraphicsAPI api = m_pDevice->GetAPIProperties().pipelineType;
 
-  if(liveId == ResourceId())
+  if(api == GraphicsAPI::D3D11)
+    GetConstantBlockSources(m_D3D11PipelineState, sources);
+  else if(api == GraphicsAPI::D3D12)
+    GetConstantBlockSources(m_D3D12PipelineState, sources);
+  else if(api == GraphicsAPI::OpenGL)
+    GetConstantBlockSources(m_GLPipelineState, sources);
+  else if(api == GraphicsAPI::Vulkan)
+    GetConstantBlockSources(m_VulkanPipelineState, sources);
+
+  rdctype::array<EventConstantBlock> ret;
+  ret.create((int)sources.size());
+
+  for(size_t i = 0; i < sources.size(); i++)
   {
-    RDCERR("Couldn't get Live ID for %llu getting texture data", tex);
-    return ret;
-  }
+    const ConstantBlockSource &src = sources[i];
+    EventConstantBlock &block = ret[(int)i];
 
-  size_t sz = 0;
-  byte *bytes = m_pDevice->GetTextureData(liveId, arrayIdx, mip, GetTextureDataParams(), sz);
+    block.stage = src.stage;
+    block.slot = src.slot;
+    block.buffer = src.buffer;
+    block.byteOffset = src.offset;
+    block.byteSize = src.size;
 
-  if(sz == 0 || bytes == NULL)
-    create_array_uninit(ret, 0);
-  else
-    create_array_init(ret, sz, bytes);
+    vector<byte> contents = src.inlineData;
+    if(src.buffer != ResourceId())
+      m_pDevice->GetBufferData(m_pDevice->GetLiveID(src.buffer), src.offset, 0, contents);
 
-  SAFE_DELETE_ARRAY(bytes);
+    bool cacheable = src.buffer != ResourceId() || !src.inlineData.empty();
+
+    block.variables = DecodeConstantBlock(m_pDevice->GetLiveID(src.shader), src.entryPoint,
+                                          src.slot, contents, cacheable);
+  }
 
   return ret;
 }
 
-bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path)
+rdctype::array<ShaderVariable> ReplayController::DecodeConstantBlock(ResourceId liveShader,
+                                                                     const std::string &entryPoint,
+                                                                     uint32_t slot,
+                                                                     const vector<byte> &contents,
+                                                                     bool cacheable)
 {
-  TextureSave sd = saveData;    // mutable copy
-  ResourceId liveid = m_pDevice->GetLiveID(sd.id);
-  TextureDescription td = m_pDevice->GetTexture(liveid);
-
-  bool success = false;
+  ConstantBlockKey key = {liveShader, entryPoint, slot};
 
-  // clamp sample/mip/slice indices
-  if(td.msSamp == 1)
+  if(cacheable)
   {
-    sd.sample.sampleIndex = 0;
-    sd.sample.mapToArray = false;
+    auto it = m_ConstantBlockCache.find(key);
+    if(it != m_ConstantBlockCache.end() && it->second.contents == contents)
+      return it->second.variables;
   }
-  else
+
+  vector<ShaderVariable> vars;
+  m_pDevice->FillCBufferVariables(liveShader, entryPoint, slot, vars, contents);
+
+  if(cacheable)
   {
-    if(sd.sample.sampleIndex != ~0U)
-      sd.sample.sampleIndex = RDCCLAMP(sd.sample.sampleIndex, 0U, td.msSamp);
+    // the cache only needs to cover the blocks of a few events' worth of shaders, so rather than
+    // tracking which entries are stale just start again once it grows too big
+    if(m_ConstantBlockCache.size() >= MaxCachedConstantBlocks)
+      m_ConstantBlockCache.clear();
+
+    CachedConstantBlock &cached = m_ConstantBlockCache[key];
+    cached.contents = contents;
+    cached.variables = vars;
   }
 
-  // don't support cube cruciform for non cubemaps, or
-  // cubemap arrays
-  if(!td.cubemap || td.arraysize != 6 || td.msSamp != 1)
-    sd.slice.cubeCruciform = false;
+  return vars;
+}
 
-  if(sd.mip != -1)
-    sd.mip = RDCCLAMP(sd.mip, 0, (int32_t)td.mips);
-  if(sd.slice.sliceIndex != -1)
-    sd.slice.sliceIndex = RDCCLAMP(sd.slice.sliceIndex, 0, int32_t(td.arraysize * td.depth));
+FrameDescription ReplayController::GetFrameInfo()
+{
+  return m_FrameRecord.frameInfo;
+}
 
-  if(td.arraysize * td.depth * td.msSamp == 1)
-  {
-    sd.slice.sliceIndex = 0;
-    sd.slice.slicesAsGrid = false;
-  }
+DrawcallDescription *ReplayController::GetDrawcallByEID(uint32_t eventID)
+{
+  if(eventID >= m_Drawcalls.size())
+    return NULL;
 
-  // can't extract a channel that's not in the source texture
-  if(sd.channelExtract >= 0 && (uint32_t)sd.channelExtract >= td.format.compCount)
-    sd.channelExtract = -1;
+  return m_Drawcalls[eventID];
+}
 
-  sd.slice.sliceGridWidth = RDCMAX(sd.slice.sliceGridWidth, 1);
+rdctype::array<DrawcallDescription> ReplayController::GetDrawcalls()
+{
+  return m_FrameRecord.drawcallList;
+}
 
-  // store sample count so we know how many 'slices' is one real slice
-  // multisampled textures cannot have mips, subresource layout is same as would be for mips:
-  // [slice0 sample0], [slice0 sample1], [slice1 sample0], [slice1 sample1]
-  uint32_t sampleCount = td.msSamp;
-  bool multisampled = td.msSamp > 1;
+const FlatDrawcallList &ReplayController::GetFlatDrawcalls()
+{
+  return m_FlatDrawcalls;
+}
 
-  bool resolveSamples = (sd.sample.sampleIndex == ~0U);
+static uint32_t FlattenDrawcalls(const rdctype::array<DrawcallDescription> &draws, int32_t parent,
+                                 vector<FlatDrawcall> &flat, StringPool &names)
+{
+  uint32_t lastEID = 0;
+  int32_t prevSibling = -1;
 
-  if(resolveSamples)
+  for(int32_t i = 0; i < draws.count; i++)
   {
-    td.msSamp = 1;
-    sd.sample.mapToArray = false;
-    sd.sample.sampleIndex = 0;
-  }
+    const DrawcallDescription &d = draws[i];
 
-  // treat any multisampled texture as if it were an array
-  // of <sample count> dimension (on top of potential existing array
-  // dimension). GetTextureData() uses the same convention.
-  if(td.msSamp > 1)
-  {
-    td.arraysize *= td.msSamp;
-    td.msSamp = 1;
-  }
+    int32_t idx = (int32_t)flat.size();
 
-  if(sd.destType != FileType::DDS && sd.sample.mapToArray && !sd.slice.slicesAsGrid &&
-     sd.slice.sliceIndex == -1)
-  {
-    sd.sample.mapToArray = false;
-    sd.sample.sampleIndex = 0;
-  }
+    if(prevSibling >= 0)
+      flat[prevSibling].nextSibling = idx;
+    else if(parent >= 0)
+      flat[parent].firstChild = idx;
 
-  // only DDS supports writing multiple mips, fall back to mip 0 if 'all mips' was specified
-  if(sd.destType != FileType::DDS && sd.mip == -1)
-    sd.mip = 0;
+    prevSibling = idx;
 
-  // only DDS supports writing multiple slices, fall back to slice 0 if 'all slices' was specified
-  if(sd.destType != FileType::DDS && sd.slice.sliceIndex == -1 && !sd.slice.slicesAsGrid &&
-     !sd.slice.cubeCruciform)
-    sd.slice.sliceIndex = 0;
+    FlatDrawcall f;
+    f.eventID = d.eventID;
+    f.lastEventID = d.eventID;
+    f.drawcallID = d.drawcallID;
+    f.flags = d.flags;
+    memcpy(f.markerColor, d.markerColor, sizeof(f.markerColor));
+    f.parent = parent;
+    f.firstChild = -1;
+    f.nextSibling = -1;
+    f.nameOffset = names.Intern(d.name.c_str(), d.name.count);
 
-  // fetch source data subresources (typically only one, possibly more
-  // if we're writing to DDS (so writing multiple mips/slices) or resolving
-  // down a multisampled texture for writing as a single 'image' elsewhere)
-  uint32_t sliceOffset = 0;
-  uint32_t sliceStride = 1;
-  uint32_t numSlices = td.arraysize * td.depth;
+    flat.push_back(f);
 
-  uint32_t mipOffset = 0;
-  uint32_t numMips = td.mips;
+    lastEID = FlattenDrawcalls(d.children, idx, flat, names);
 
-  bool singleSlice = (sd.slice.sliceIndex != -1);
+    if(lastEID == 0)
+    {
+      lastEID = d.eventID;
 
-  // set which slices/mips we need
-  if(multisampled)
+      if((d.flags & DrawFlags::SetMarker) && i + 1 < draws.count)
+        lastEID = draws[i + 1].eventID;
+    }
+
+    flat[idx].lastEventID = lastEID;
+  }
+
+  return lastEID;
+}
+
+static void GatherCPUTimes(const rdctype::array<DrawcallDescription> &draws, uint64_t &firstTime,
+                           bool &anyTimed)
+{
+  for(const DrawcallDescription &d : draws)
   {
-    bool singleSample = !sd.sample.mapToArray;
+    for(const APIEvent &ev : d.events)
+    {
+      // events without a CPU timeline have no thread and are ignored
+      if(ev.threadID == 0)
+        continue;
 
-    // multisampled images have no mips
-    mipOffset = 0;
-    numMips = 1;
+      if(!anyTimed || ev.cpuTimestamp < firstTime)
+        firstTime = ev.cpuTimestamp;
+      anyTimed = true;
+    }
 
-    if(singleSlice)
+    GatherCPUTimes(d.children, firstTime, anyTimed);
+  }
+}
+
+static void RebaseCPUTimes(rdctype::array<DrawcallDescription> &draws, uint64_t firstTime,
+                           vector<ThreadTimeline> &threads)
+{
+  for(DrawcallDescription &d : draws)
+  {
+    for(APIEvent &ev : d.events)
     {
-      if(singleSample)
+      if(ev.threadID == 0)
+        continue;
+
+      ev.cpuTimestamp -= firstTime;
+
+      ThreadTimeline *thread = NULL;
+      for(ThreadTimeline &t : threads)
       {
-        // we want a specific sample in a specific real slice
-        sliceOffset = sd.slice.sliceIndex * sampleCount + sd.sample.sampleIndex;
-        numSlices = 1;
+        if(t.threadID == ev.threadID)
+        {
+          thread = &t;
+          break;
+        }
       }
-      else
+
+      if(thread == NULL)
       {
-        // we want all the samples (now mapped to slices) in a specific real slice
-        sliceOffset = sd.slice.sliceIndex;
-        numSlices = sampleCount;
+        ThreadTimeline t;
+        t.threadID = ev.threadID;
+        t.begin = t.end = ev.cpuTimestamp;
+        t.numEvents = 0;
+        threads.push_back(t);
+        thread = &threads.back();
       }
+
+      thread->begin = RDCMIN(thread->begin, ev.cpuTimestamp);
+      thread->end = RDCMAX(thread->end, ev.cpuTimestamp);
+      thread->numEvents++;
     }
-    else
+
+    RebaseCPUTimes(d.children, firstTime, threads);
+  }
+}
+
+static void IndexEventReferences(const rdctype::array<DrawcallDescription> &draws,
+                                 ResourceIdMap<vector<uint32_t>> &eventRefs)
+{
+  for(const DrawcallDescription &d : draws)
+  {
+    for(const APIEvent &ev : d.events)
     {
-      if(singleSample)
-      {
-        // we want one sample in every slice, so we have to set the stride to sampleCount
-        // to skip every other sample (mapped to slices), starting from the sample we want
-        // in the first real slice
-        sliceOffset = sd.sample.sampleIndex;
-        sliceStride = sampleCount;
-        numSlices = RDCMAX(1U, td.arraysize / sampleCount);
-      }
-      else
+      for(const ResourceId &id : ev.referencedResources)
       {
-        // we want all slices, all samples
-        sliceOffset = 0;
-        numSlices = td.arraysize;
+        vector<uint32_t> &eids = eventRefs[id];
+
+        // the same event can appear again for each draw of a multi-draw
+        if(eids.empty() || eids.back() != ev.eventID)
+          eids.push_back(ev.eventID);
       }
     }
+
+    IndexEventReferences(d.children, eventRefs);
   }
-  else
+}
+
+static void SplitEventParameters(rdctype::array<DrawcallDescription> &draws,
+                                 std::map<uint32_t, std::string> &eventParams)
+{
+  for(DrawcallDescription &d : draws)
   {
-    if(singleSlice)
+    for(APIEvent &ev : d.events)
     {
-      numSlices = 1;
-      sliceOffset = sd.slice.sliceIndex;
-    }
-    // otherwise take all slices, as by default
+      // the first line is the function name, everything after it is the parameters
+      std::string desc = ev.eventDesc.c_str();
+      size_t lineEnd = desc.find('\n');
 
-    if(sd.mip != -1)
-    {
-      mipOffset = sd.mip;
-      numMips = 1;
+      if(lineEnd == std::string::npos)
+        continue;
+
+      eventParams[ev.eventID] = desc.substr(lineEnd + 1);
+      ev.eventDesc = desc.substr(0, lineEnd);
     }
-    // otherwise take all mips, as by default
+
+    SplitEventParameters(d.children, eventParams);
   }
+}
 
-  vector<byte *> subdata;
+static bool IsEstimatedCounter(GPUCounter counterID)
+{
+  return counterID >= GPUCounter::FirstEstimated;
+}
 
-  bool downcast = false;
+static double GetCounterValue(const CounterDescription &desc, const CounterResult &result)
+{
+  if(desc.resultType == CompType::Double)
+    return result.value.d;
+  else if(desc.resultType == CompType::Float)
+    return result.value.f;
+  else if(desc.resultByteWidth == 4)
+    return (double)result.value.u32;
+
+  return (double)result.value.u64;
+}
 
-  // don't support slice mappings for DDS - it supports slices natively
-  if(sd.destType == FileType::DDS)
+rdctype::array<CounterResult> ReplayController::FetchCounters(const rdctype::array<GPUCounter> &counters)
+{
+  SCOPED_PROFILE("ReplayController::FetchCounters");
+
+  vector<GPUCounter> counterArray, estimated;
+  counterArray.reserve(counters.count);
+  for(int32_t i = 0; i < counters.count; i++)
   {
-    sd.slice.cubeCruciform = false;
-    sd.slice.slicesAsGrid = false;
+    if(IsEstimatedCounter(counters[i]))
+      estimated.push_back(counters[i]);
+    else
+      counterArray.push_back(counters[i]);
   }
 
-  // force downcast to be able to do grid mappings
-  if(sd.slice.cubeCruciform || sd.slice.slicesAsGrid)
-    downcast = true;
+  ScopedReplayCancel cancel(&m_CancelRequested);
 
-  // we don't support any file formats that handle these block compression formats
-  if(td.format.specialFormat == SpecialFormat::ETC2 ||
-     td.format.specialFormat == SpecialFormat::EAC || td.format.specialFormat == SpecialFormat::ASTC)
-    downcast = true;
+  vector<CounterResult> ret;
 
-  // for DDS don't downcast, for non-HDR always downcast if we're not already RGBA8 unorm
-  // for HDR&EXR we can convert from most regular types as well as 10.10.10.2 and 11.11.10
-  if((sd.destType != FileType::DDS && sd.destType != FileType::HDR && sd.destType != FileType::EXR &&
-      (td.format.compByteWidth != 1 || td.format.compCount != 4 ||
-       td.format.compType != CompType::UNorm || td.format.bgraOrder)) ||
-     downcast || (sd.destType != FileType::DDS && td.format.special &&
-                  td.format.specialFormat != SpecialFormat::R10G10B10A2 &&
-                  td.format.specialFormat != SpecialFormat::R11G11B10))
+  if(!counterArray.empty())
+    ret = m_pDevice->FetchCounters(counterArray);
+
+  if(!estimated.empty() && !m_CancelRequested)
   {
-    downcast = true;
-    td.format.compByteWidth = 1;
-    td.format.compCount = 4;
-    td.format.compType = CompType::UNorm;
-    td.format.special = false;
-    td.format.specialFormat = SpecialFormat::Unknown;
+    rdctype::array<DrawcallBandwidth> bandwidth = GetDrawcallBandwidth();
+
+    for(const DrawcallBandwidth &bw : bandwidth)
+    {
+      for(GPUCounter c : estimated)
+      {
+        if(c == GPUCounter::EstimatedBytesRead)
+          ret.push_back(CounterResult(bw.eventID, c, bw.bytesRead));
+        else if(c == GPUCounter::EstimatedBytesWritten)
+          ret.push_back(CounterResult(bw.eventID, c, bw.bytesWritten));
+      }
+    }
+
+    std::sort(ret.begin(), ret.end());
   }
 
-  uint32_t rowPitch = 0;
-  uint32_t slicePitch = 0;
+  return ret;
+}
 
-  bool blockformat = false;
-  int blockSize = 0;
-  uint32_t bytesPerPixel = 1;
+rdctype::array<double> ReplayController::ReplayLoop(uint32_t iterations, IReplayOutput *output,
+                                                   bool timeGPU)
+{
+  SCOPED_PROFILE("ReplayController::ReplayLoop");
 
-  td.width = RDCMAX(1U, td.width >> mipOffset);
-  td.height = RDCMAX(1U, td.height >> mipOffset);
-  td.depth = RDCMAX(1U, td.depth >> mipOffset);
+  vector<double> ret;
 
-  if(td.format.specialFormat == SpecialFormat::BC1 ||
-     td.format.specialFormat == SpecialFormat::BC2 || td.format.specialFormat == SpecialFormat::BC3 ||
-     td.format.specialFormat == SpecialFormat::BC4 || td.format.specialFormat == SpecialFormat::BC5 ||
-     td.format.specialFormat == SpecialFormat::BC6 || td.format.specialFormat == SpecialFormat::BC7)
+  if(m_Drawcalls.empty() || iterations == 0)
+    return ret;
+
+  uint32_t lastEID = uint32_t(m_Drawcalls.size() - 1);
+
+  ReplayOutput *out = NULL;
+  for(size_t i = 0; i < m_Outputs.size(); i++)
+    if((IReplayOutput *)m_Outputs[i] == output)
+      out = m_Outputs[i];
+
+  vector<GPUCounter> durationCounter;
+
+  if(timeGPU)
   {
-    blockSize = (td.format.specialFormat == SpecialFormat::BC1 ||
-                 td.format.specialFormat == SpecialFormat::BC4)
-                    ? 8
-                    : 16;
-    rowPitch = RDCMAX(1U, ((td.width + 3) / 4)) * blockSize;
-    slicePitch = rowPitch * RDCMAX(1U, td.height / 4);
-    blockformat = true;
+    vector<GPUCounter> available = m_pDevice->EnumerateCounters();
+
+    if(std::find(available.begin(), available.end(), GPUCounter::EventGPUDuration) !=
+       available.end())
+      durationCounter.push_back(GPUCounter::EventGPUDuration);
+    else
+      RDCWARN("GPU durations aren't available, replaying without timing");
   }
-  else
+
+  ScopedReplayCancel cancel(&m_CancelRequested);
+
+  ret.reserve(iterations);
+
+  for(uint32_t it = 0; it < iterations && !m_CancelRequested; it++)
   {
-    switch(td.format.specialFormat)
+    if(durationCounter.empty())
     {
-      case SpecialFormat::S8: bytesPerPixel = 1; break;
-      case SpecialFormat::R10G10B10A2:
-      case SpecialFormat::R9G9B9E5:
-      case SpecialFormat::R11G11B10:
-      case SpecialFormat::D24S8: bytesPerPixel = 4; break;
-      case SpecialFormat::R5G6B5:
-      case SpecialFormat::R5G5B5A1:
-      case SpecialFormat::R4G4B4A4: bytesPerPixel = 2; break;
-      case SpecialFormat::D32S8: bytesPerPixel = 8; break;
-      case SpecialFormat::D16S8:
-      case SpecialFormat::YUV:
-      case SpecialFormat::R4G4:
-        RDCERR("Unsupported file format %u", td.format.specialFormat);
-        return false;
-      default: bytesPerPixel = td.format.compCount * td.format.compByteWidth;
+      m_pDevice->ReplayLog(lastEID, eReplay_Full);
     }
+    else
+    {
+      vector<CounterResult> results = m_pDevice->FetchCounters(durationCounter);
 
-    rowPitch = td.width * bytesPerPixel;
-    slicePitch = rowPitch * td.height;
+      // a cancelled fetch only covers part of the frame, so it doesn't count as an iteration
+      if(m_CancelRequested)
+        break;
+
+      double duration = 0.0;
+      for(const CounterResult &r : results)
+        duration += r.value.d;
+
+      ret.push_back(duration);
+    }
+
+    if(out)
+    {
+      out->SetFrameEvent(lastEID);
+      out->Display();
+    }
   }
 
-  // loop over fetching subresources
-  for(uint32_t s = 0; s < numSlices; s++)
+  // put the replay and any outputs back where they were
+  SetFrameEvent(m_EventID, true);
+
+  return ret;
+}
+
+rdctype::array<CounterStatistics> ReplayController::FetchCounterStatistics(
+    const rdctype::array<GPUCounter> &counters, uint32_t iterations)
+{
+  // estimated counters don't vary between replays, so there's nothing to gather for them
+  vector<GPUCounter> counterArray;
+  counterArray.reserve(counters.count);
+  for(int32_t i = 0; i < counters.count; i++)
   {
-    uint32_t slice = s * sliceStride + sliceOffset;
+    if(!IsEstimatedCounter(counters[i]))
+      counterArray.push_back(counters[i]);
+  }
 
-    for(uint32_t m = 0; m < numMips; m++)
-    {
-      uint32_t mip = m + mipOffset;
+  if(counterArray.empty() || iterations == 0)
+    return rdctype::array<CounterStatistics>();
 
-      GetTextureDataParams params;
-      params.forDiskSave = true;
-      params.typeHint = sd.typeHint;
-      params.resolve = resolveSamples;
-      params.remap = downcast ? eRemap_RGBA8 : eRemap_None;
-      params.blackPoint = sd.comp.blackPoint;
-      params.whitePoint = sd.comp.whitePoint;
+  map<GPUCounter, CounterDescription> descs;
+  for(GPUCounter c : counterArray)
+    m_pDevice->DescribeCounter(c, descs[c]);
 
-      size_t datasize = 0;
-      byte *bytes = m_pDevice->GetTextureData(liveid, slice, mip, params, datasize);
+  ScopedReplayCancel cancel(&m_CancelRequested);
 
-      if(bytes == NULL)
-      {
-        RDCERR("Couldn't get bytes for mip %u, slice %u", mip, slice);
+  // warm up caches, clocks and any lazily created resources before recording anything
+  m_pDevice->FetchCounters(counterArray);
 
-        for(size_t i = 0; i < subdata.size(); i++)
-          delete[] subdata[i];
+  map<pair<uint32_t, GPUCounter>, vector<double> > samples;
 
-        return false;
-      }
+  for(uint32_t it = 0; it < iterations; it++)
+  {
+    vector<CounterResult> results = m_pDevice->FetchCounters(counterArray);
 
-      if(td.depth == 1)
-      {
-        subdata.push_back(bytes);
-        continue;
-      }
+    // a cancelled fetch only covers part of the frame, so keep the complete iterations we have
+    if(m_CancelRequested)
+      break;
 
-      uint32_t mipSlicePitch = slicePitch;
+    for(const CounterResult &r : results)
+      samples[std::make_pair(r.eventID, r.counterID)].push_back(
+          GetCounterValue(descs[r.counterID], r));
+  }
 
-      uint32_t w = RDCMAX(1U, td.width >> m);
-      uint32_t h = RDCMAX(1U, td.height >> m);
-      uint32_t d = RDCMAX(1U, td.depth >> m);
+  vector<CounterStatistics> ret;
+  ret.reserve(samples.size());
 
-      if(blockformat)
-      {
-        mipSlicePitch = RDCMAX(1U, ((w + 3) / 4)) * blockSize * RDCMAX(1U, h / 4);
-      }
-      else
-      {
-        mipSlicePitch = w * bytesPerPixel * h;
-      }
+  for(auto it = samples.begin(); it != samples.end(); ++it)
+  {
+    vector<double> &vals = it->second;
 
-      // we don't support slice ranges, only all-or-nothing
-      // we're also not dealing with multisampled slices if
-      // depth > 1. So if we only want one slice out of a 3D texture
-      // then make sure we get it
-      if(numSlices == 1)
-      {
-        byte *depthslice = new byte[mipSlicePitch];
-        byte *b = bytes + mipSlicePitch * sliceOffset;
-        memcpy(depthslice, b, slicePitch);
-        subdata.push_back(depthslice);
-
-        delete[] bytes;
-        continue;
-      }
-
-      s += (d - 1);
+    std::sort(vals.begin(), vals.end());
 
-      byte *b = bytes;
-
-      // add each depth slice as a separate subdata
-      for(uint32_t di = 0; di < d; di++)
-      {
-        byte *depthslice = new byte[mipSlicePitch];
+    CounterStatistics stats;
+    stats.eventID = it->first.first;
+    stats.counterID = it->first.second;
+    stats.samples = (uint32_t)vals.size();
+    stats.minimum = vals[0];
 
-        memcpy(depthslice, b, mipSlicePitch);
+    size_t mid = vals.size() / 2;
+    if(vals.size() % 2 == 0)
+      stats.median = (vals[mid - 1] + vals[mid]) * 0.5;
+    else
+      stats.median = vals[mid];
 
-        subdata.push_back(depthslice);
+    double sum = 0.0;
+    for(double v : vals)
+      sum += v;
+    stats.mean = sum / double(vals.size());
 
-        b += mipSlicePitch;
-      }
+    double variance = 0.0;
+    for(double v : vals)
+      variance += (v - stats.mean) * (v - stats.mean);
+    stats.stddev = sqrt(variance / double(vals.size()));
 
-      delete[] bytes;
-    }
+    ret.push_back(stats);
   }
 
-  // should have been handled above, but verify incoming data is RGBA8
-  if(sd.slice.slicesAsGrid && td.format.compByteWidth == 1 && td.format.compCount == 4)
-  {
-    uint32_t sliceWidth = td.width;
-    uint32_t sliceHeight = td.height;
+  return ret;
+}
 
-    uint32_t sliceGridHeight = (td.arraysize * td.depth) / sd.slice.sliceGridWidth;
-    if((td.arraysize * td.depth) % sd.slice.sliceGridWidth != 0)
-      sliceGridHeight++;
+static void AddTimelineRegions(const FlatDrawcallList &flat, const vector<double> &totals,
+                               const vector<uint32_t> &counts, int32_t first, uint32_t depth,
+                               double start, bool critical, double minDuration,
+                               vector<TimelineRegion> &regions)
+{
+  // the most expensive sibling continues the critical path, and is never merged away
+  int32_t hottest = -1;
+  if(critical)
+  {
+    for(int32_t i = first; i >= 0; i = flat.Get(i).nextSibling)
+      if(hottest < 0 || totals[i] > totals[hottest])
+        hottest = i;
+  }
 
-    td.width *= sd.slice.sliceGridWidth;
-    td.height *= sliceGridHeight;
+  TimelineRegion run = {};
+  int32_t runFirst = -1;
+  uint32_t runSiblings = 0;
 
-    byte *combinedData = new byte[td.width * td.height * td.format.compCount];
+  double time = start;
 
-    memset(combinedData, 0, td.width * td.height * td.format.compCount);
+  for(int32_t i = first; i >= 0; i = flat.Get(i).nextSibling)
+  {
+    const FlatDrawcall &d = flat.Get(i);
 
-    for(size_t i = 0; i < subdata.size(); i++)
+    if(totals[i] < minDuration && i != hottest)
     {
-      uint32_t gridx = (uint32_t)i % sd.slice.sliceGridWidth;
-      uint32_t gridy = (uint32_t)i / sd.slice.sliceGridWidth;
-
-      uint32_t yoffs = gridy * sliceHeight;
-      uint32_t xoffs = gridx * sliceWidth;
-
-      for(uint32_t y = 0; y < sliceHeight; y++)
+      if(runSiblings == 0)
       {
-        for(uint32_t x = 0; x < sliceWidth; x++)
-        {
-          uint32_t *srcpix = (uint32_t *)&subdata[i][(y * sliceWidth + x) * 4 + 0];
-          uint32_t *dstpix = (uint32_t *)&combinedData[((y + yoffs) * td.width + x + xoffs) * 4 + 0];
+        run.eventID = d.eventID;
+        run.depth = depth;
+        run.numEvents = 0;
+        run.start = time;
+        run.duration = 0.0;
+        runFirst = i;
+      }
 
-          *dstpix = *srcpix;
-        }
+      run.lastEventID = d.lastEventID;
+      run.numEvents += counts[i];
+      run.duration += totals[i];
+      runSiblings++;
+    }
+    else
+    {
+      if(runSiblings > 0)
+      {
+        run.drawIndex = runSiblings == 1 ? runFirst : -1;
+        regions.push_back(run);
+        runSiblings = 0;
       }
 
-      delete[] subdata[i];
+      TimelineRegion region;
+      region.drawIndex = i;
+      region.eventID = d.eventID;
+      region.lastEventID = d.lastEventID;
+      region.depth = depth;
+      region.numEvents = counts[i];
+      region.critical = (i == hottest);
+      region.start = time;
+      region.duration = totals[i];
+      regions.push_back(region);
+
+      if(d.firstChild >= 0)
+        AddTimelineRegions(flat, totals, counts, d.firstChild, depth + 1, time, i == hottest,
+                           minDuration, regions);
     }
 
-    subdata.resize(1);
-    subdata[0] = combinedData;
-    rowPitch = td.width * 4;
+    time += totals[i];
   }
 
-  // should have been handled above, but verify incoming data is RGBA8 and 6 slices
-  if(sd.slice.cubeCruciform && td.format.compByteWidth == 1 && td.format.compCount == 4 &&
-     subdata.size() == 6)
+  if(runSiblings > 0)
   {
-    uint32_t sliceWidth = td.width;
-    uint32_t sliceHeight = td.height;
-
-    td.width *= 4;
-    td.height *= 3;
-
-    byte *combinedData = new byte[td.width * td.height * td.format.compCount];
-
-    memset(combinedData, 0, td.width * td.height * td.format.compCount);
-
-    /*
-     Y X=0   1   2   3
-     =     +---+
-     0     |+y |
-           |[2]|
-       +---+---+---+---+
-     1 |-x |+z |+x |-z |
-       |[1]|[4]|[0]|[5]|
-       +---+---+---+---+
-     2     |-y |
-           |[3]|
-           +---+
-
-    */
-
-    uint32_t gridx[6] = {2, 0, 1, 1, 1, 3};
-    uint32_t gridy[6] = {1, 1, 0, 2, 1, 1};
+    run.drawIndex = runSiblings == 1 ? runFirst : -1;
+    regions.push_back(run);
+  }
+}
 
-    for(size_t i = 0; i < subdata.size(); i++)
-    {
-      uint32_t yoffs = gridy[i] * sliceHeight;
-      uint32_t xoffs = gridx[i] * sliceWidth;
+rdctype::array<TimelineRegion> ReplayController::GetDurationTimeline(
+    const rdctype::array<CounterResult> &durations, double minDuration)
+{
+  const FlatDrawcallList &flat = m_FlatDrawcalls;
+  int32_t count = flat.Count();
 
-      for(uint32_t y = 0; y < sliceHeight; y++)
-      {
-        for(uint32_t x = 0; x < sliceWidth; x++)
-        {
-          uint32_t *srcpix = (uint32_t *)&subdata[i][(y * sliceWidth + x) * 4 + 0];
-          uint32_t *dstpix = (uint32_t *)&combinedData[((y + yoffs) * td.width + x + xoffs) * 4 + 0];
+  if(count == 0)
+    return rdctype::array<TimelineRegion>();
 
-          *dstpix = *srcpix;
-        }
-      }
+  vector<double> times;
+  for(int32_t i = 0; i < durations.count; i++)
+  {
+    const CounterResult &r = durations[i];
 
-      delete[] subdata[i];
-    }
+    if(r.counterID != GPUCounter::EventGPUDuration)
+      continue;
 
-    subdata.resize(1);
-    subdata[0] = combinedData;
-    rowPitch = td.width * 4;
+    if(r.eventID >= times.size())
+      times.resize(r.eventID + 1, 0.0);
+    times[r.eventID] = r.value.d;
   }
 
-  int numComps = td.format.compCount;
+  vector<double> totals(count, 0.0);
+  vector<uint32_t> counts(count, 0);
 
-  // if we want a grayscale image of one channel, splat it across all channels
-  // and set alpha to full
-  if(sd.channelExtract >= 0 && td.format.compByteWidth == 1 &&
-     (uint32_t)sd.channelExtract < td.format.compCount)
+  // children always come after their parent in the list, so walking it backwards finishes each
+  // subtree's sums before they're added into its parent
+  for(int32_t i = count - 1; i >= 0; i--)
   {
-    uint32_t cc = td.format.compCount;
+    const FlatDrawcall &d = flat.Get(i);
 
-    for(uint32_t y = 0; y < td.height; y++)
+    if(d.firstChild < 0)
     {
-      for(uint32_t x = 0; x < td.width; x++)
-      {
-        subdata[0][(y * td.width + x) * cc + 0] =
-            subdata[0][(y * td.width + x) * cc + sd.channelExtract];
-        if(cc >= 2)
-          subdata[0][(y * td.width + x) * cc + 1] =
-              subdata[0][(y * td.width + x) * cc + sd.channelExtract];
-        if(cc >= 3)
-          subdata[0][(y * td.width + x) * cc + 2] =
-              subdata[0][(y * td.width + x) * cc + sd.channelExtract];
-        if(cc >= 4)
-          subdata[0][(y * td.width + x) * cc + 3] = 255;
-      }
+      if(d.eventID < times.size())
+        totals[i] = times[d.eventID];
+      counts[i] = 1;
     }
-  }
 
-  // handle formats that don't support alpha
-  if(numComps == 4 && (sd.destType == FileType::BMP || sd.destType == FileType::JPG))
-  {
-    byte *nonalpha = new byte[td.width * td.height * 3];
-
-    for(uint32_t y = 0; y < td.height; y++)
+    if(d.parent >= 0)
     {
-      for(uint32_t x = 0; x < td.width; x++)
-      {
-        byte r = subdata[0][(y * td.width + x) * 4 + 0];
-        byte g = subdata[0][(y * td.width + x) * 4 + 1];
-        byte b = subdata[0][(y * td.width + x) * 4 + 2];
-        byte a = subdata[0][(y * td.width + x) * 4 + 3];
+      totals[d.parent] += totals[i];
+      counts[d.parent] += counts[i];
+    }
+  }
 
-        if(sd.alpha != AlphaMapping::Discard)
-        {
-          FloatVector col = sd.alphaCol;
-          if(sd.alpha == AlphaMapping::BlendToCheckerboard)
-          {
-            bool lightSquare = ((x / 64) % 2) == ((y / 64) % 2);
-            col = lightSquare ? sd.alphaCol : sd.alphaColSecondary;
-          }
+  vector<TimelineRegion> ret;
+  AddTimelineRegions(flat, totals, counts, 0, 0, 0.0, true, minDuration, ret);
 
-          col.x = powf(col.x, 1.0f / 2.2f);
-          col.y = powf(col.y, 1.0f / 2.2f);
-          col.z = powf(col.z, 1.0f / 2.2f);
+  return ret;
+}
 
-          FloatVector pixel = FloatVector(float(r) / 255.0f, float(g) / 255.0f, float(b) / 255.0f,
-                                          float(a) / 255.0f);
+rdctype::array<SubmissionTiming> ReplayController::GetQueueTimeline()
+{
+  SCOPED_PROFILE("ReplayController::GetQueueTimeline");
 
-          pixel.x = pixel.x * pixel.w + col.x * (1.0f - pixel.w);
-          pixel.y = pixel.y * pixel.w + col.y * (1.0f - pixel.w);
-          pixel.z = pixel.z * pixel.w + col.z * (1.0f - pixel.w);
+  const rdctype::array<QueueSubmission> &submissions = m_FrameRecord.frameInfo.queueSubmissions;
 
-          r = byte(pixel.x * 255.0f);
-          g = byte(pixel.y * 255.0f);
-          b = byte(pixel.z * 255.0f);
-        }
+  if(submissions.count == 0)
+    return rdctype::array<SubmissionTiming>();
 
-        nonalpha[(y * td.width + x) * 3 + 0] = r;
-        nonalpha[(y * td.width + x) * 3 + 1] = g;
-        nonalpha[(y * td.width + x) * 3 + 2] = b;
-      }
-    }
+  CounterValueMap counters =
+      FetchCounterValues({GPUCounter::EventGPUDuration, GPUCounter::EventGPUStart});
 
-    delete[] subdata[0];
+  if(m_CancelRequested)
+    return rdctype::array<SubmissionTiming>();
 
-    subdata[0] = nonalpha;
+  bool measured = false;
+  for(auto it = counters.begin(); it != counters.end() && !measured; ++it)
+    measured = (it->first.second == GPUCounter::EventGPUStart);
 
-    numComps = 3;
-    rowPitch = td.width * 3;
-  }
+  vector<SubmissionTiming> timings;
+  timings.reserve(submissions.count);
 
-  // assume that (R,G,0) is better mapping than (Y,A) for 2 component data
-  if(numComps == 2 && (sd.destType == FileType::BMP || sd.destType == FileType::JPG ||
-                       sd.destType == FileType::PNG || sd.destType == FileType::TGA))
+  // without start times all we can do is assume the queues ran one after another
+  double serialTime = 0.0;
+
+  for(int32_t s = 0; s < submissions.count; s++)
   {
-    byte *rg0 = new byte[td.width * td.height * 3];
+    const QueueSubmission &sub = submissions[s];
 
-    for(uint32_t y = 0; y < td.height; y++)
+    SubmissionTiming timing = {};
+    timing.submission = uint32_t(s);
+
+    double first = 0.0, last = 0.0, total = 0.0;
+    bool any = false;
+
+    // counters are keyed by EID first, so the submission's events are one contiguous range
+    for(auto it = counters.lower_bound(std::make_pair(sub.eventID, GPUCounter(0)));
+        it != counters.end() && it->first.first <= sub.lastEventID; ++it)
     {
-      for(uint32_t x = 0; x < td.width; x++)
-      {
-        byte r = subdata[0][(y * td.width + x) * 2 + 0];
-        byte g = subdata[0][(y * td.width + x) * 2 + 1];
+      if(it->first.second != GPUCounter::EventGPUDuration)
+        continue;
 
-        rg0[(y * td.width + x) * 3 + 0] = r;
-        rg0[(y * td.width + x) * 3 + 1] = g;
-        rg0[(y * td.width + x) * 3 + 2] = 0;
+      total += it->second;
 
-        // if we're greyscaling the image, then keep the greyscale here.
-        if(sd.channelExtract >= 0)
-          rg0[(y * td.width + x) * 3 + 2] = r;
-      }
+      auto start = counters.find(std::make_pair(it->first.first, GPUCounter::EventGPUStart));
+      if(start == counters.end())
+        continue;
+
+      first = any ? RDCMIN(first, start->second) : start->second;
+      last = any ? RDCMAX(last, start->second + it->second) : start->second + it->second;
+      any = true;
     }
 
-    delete[] subdata[0];
+    if(measured)
+    {
+      timing.start = first;
+      timing.duration = last - first;
+    }
+    else
+    {
+      timing.start = serialTime;
+      timing.duration = total;
+      serialTime += total;
+    }
 
-    subdata[0] = rg0;
+    // submissions with nothing timed in them still hold their place in the order, but don't take
+    // any time
+    if(measured && !any && !timings.empty())
+      timing.start = timings.back().start + timings.back().duration;
 
-    numComps = 3;
-    rowPitch = td.width * 3;
+    timings.push_back(timing);
   }
 
-  FILE *f = FileIO::fopen(path, "wb");
+  std::stable_sort(timings.begin(), timings.end(),
+                   [](const SubmissionTiming &a, const SubmissionTiming &b) {
+                     return a.start < b.start;
+                   });
 
-  if(!f)
-  {
-    success = false;
-  }
-  else
+  for(size_t i = 0; i < timings.size(); i++)
   {
-    if(sd.destType == FileType::DDS)
-    {
-      dds_data ddsData;
+    SubmissionTiming &t = timings[i];
+    ResourceId queue = submissions[t.submission].queue;
 
-      ddsData.width = td.width;
-      ddsData.height = td.height;
-      ddsData.depth = td.depth;
-      ddsData.format = td.format;
-      ddsData.mips = numMips;
-      ddsData.slices = numSlices / td.depth;
-      ddsData.subdata = &subdata[0];
-      ddsData.cubemap = td.cubemap && numSlices == 6;
+    double end = t.start + t.duration;
 
-      success = write_dds_to_file(f, ddsData);
-    }
-    else if(sd.destType == FileType::BMP)
+    // the queue was idle from whenever its previous submission finished
+    double prevEnd = 0.0;
+    for(size_t j = 0; j < i; j++)
     {
-      int ret = stbi_write_bmp_to_func(fileWriteFunc, (void *)f, td.width, td.height, numComps,
-                                       subdata[0]);
-      success = (ret != 0);
+      if(submissions[timings[j].submission].queue == queue)
+        prevEnd = RDCMAX(prevEnd, timings[j].start + timings[j].duration);
     }
-    else if(sd.destType == FileType::PNG)
+
+    t.stall = RDCMAX(0.0, t.start - prevEnd);
+
+    // collect where other queues were busy during this submission, then merge the spans so time
+    // where several queues were busy at once isn't counted twice
+    vector<pair<double, double> > busy;
+    for(size_t j = 0; j < timings.size(); j++)
     {
-      // discard alpha if requested
-      for(uint32_t p = 0; sd.alpha == AlphaMapping::Discard && p < td.width * td.height; p++)
-        subdata[0][p * 4 + 3] = 255;
+      if(submissions[timings[j].submission].queue == queue)
+        continue;
 
-      int ret = stbi_write_png_to_func(fileWriteFunc, (void *)f, td.width, td.height, numComps,
-                                       subdata[0], rowPitch);
-      success = (ret != 0);
+      double lo = RDCMAX(t.start, timings[j].start);
+      double hi = RDCMIN(end, timings[j].start + timings[j].duration);
+
+      if(hi > lo)
+        busy.push_back(std::make_pair(lo, hi));
     }
-    else if(sd.destType == FileType::TGA)
+
+    std::sort(busy.begin(), busy.end());
+
+    double covered = t.start;
+    for(const pair<double, double> &span : busy)
+    {
+      if(span.second <= covered)
+        continue;
+
+      t.overlap += span.second - RDCMAX(span.first, covered);
+      covered = span.second;
+    }
+  }
+
+  return timings;
+}
+
+rdctype::array<GPUCounter> ReplayController::EnumerateCounters()
+{
+  vector<GPUCounter> ret = m_pDevice->EnumerateCounters();
+
+  // the estimated counters are worked out here, so they're available on any driver
+  ret.push_back(GPUCounter::EstimatedBytesRead);
+  ret.push_back(GPUCounter::EstimatedBytesWritten);
+
+  return ret;
+}
+
+CounterDescription ReplayController::DescribeCounter(GPUCounter counterID)
+{
+  CounterDescription ret;
+
+  if(IsEstimatedCounter(counterID))
+  {
+    ret.counterID = counterID;
+    ret.resultType = CompType::UInt;
+    ret.resultByteWidth = sizeof(uint64_t);
+    ret.unit = CounterUnit::Bytes;
+
+    if(counterID == GPUCounter::EstimatedBytesRead)
+    {
+      ret.name = "Estimated Bytes Read";
+      ret.description =
+          "An estimate of the bytes read from vertex buffers, bound resources, and render "
+          "targets for blending and depth testing.";
+    }
+    else
+    {
+      ret.name = "Estimated Bytes Written";
+      ret.description =
+          "An estimate of the bytes written to render targets, depth targets and read-write "
+          "resources, or by clears and copies.";
+    }
+
+    return ret;
+  }
+
+  m_pDevice->DescribeCounter(counterID, ret);
+
+  return ret;
+}
+
+rdctype::array<BufferDescription> ReplayController::GetBuffers()
+{
+  if(m_Buffers.empty())
+  {
+    vector<ResourceId> ids = m_pDevice->GetBuffers();
+
+    m_Buffers.resize(ids.size());
+
+    for(size_t i = 0; i < ids.size(); i++)
+      m_Buffers[i] = m_pDevice->GetBuffer(ids[i]);
+  }
+
+  return m_Buffers;
+}
+
+rdctype::array<TextureDescription> ReplayController::GetTextures()
+{
+  if(m_Textures.empty())
+  {
+    vector<ResourceId> ids = m_pDevice->GetTextures();
+
+    m_Textures.resize(ids.size());
+
+    for(size_t i = 0; i < ids.size(); i++)
+      m_Textures[i] = m_pDevice->GetTexture(ids[i]);
+  }
+
+  return m_Textures;
+}
+
+static bool LargestResourceFirst(const ResourceMemory &a, const ResourceMemory &b)
+{
+  if(a.bytes != b.bytes)
+    return a.bytes > b.bytes;
+  return a.ID < b.ID;
+}
+
+rdctype::array<ResourceMemory> ReplayController::GetResourceMemory()
+{
+  // make sure the descriptions are cached
+  GetTextures();
+  GetBuffers();
+
+  vector<ResourceMemory> ret;
+  ret.reserve(m_Textures.size() + m_Buffers.size());
+
+  for(size_t i = 0; i < m_Textures.size(); i++)
+  {
+    ResourceMemory mem;
+    mem.ID = m_Textures[i].ID;
+    mem.name = m_Textures[i].name;
+    mem.texture = true;
+    mem.memoryType = m_Textures[i].memoryType;
+    mem.bytes = m_Textures[i].allocationSize;
+    ret.push_back(mem);
+  }
+
+  for(size_t i = 0; i < m_Buffers.size(); i++)
+  {
+    ResourceMemory mem;
+    mem.ID = m_Buffers[i].ID;
+    mem.name = m_Buffers[i].name;
+    mem.texture = false;
+    mem.memoryType = m_Buffers[i].memoryType;
+    mem.bytes = m_Buffers[i].allocationSize;
+    ret.push_back(mem);
+  }
+
+  std::sort(ret.begin(), ret.end(), LargestResourceFirst);
+
+  return ret;
+}
+
+rdctype::array<rdctype::str> ReplayController::GetResolve(const rdctype::array<uint64_t> &callstack)
+{
+  rdctype::array<rdctype::str> ret;
+
+  if(callstack.empty())
+    return ret;
+
+  Callstack::StackResolver *resolv = m_pDevice->GetCallstackResolver();
+
+  if(resolv == NULL)
+    return ret;
+
+  // resolve the whole stack at once so the resolver can batch its symbol lookups
+  vector<Callstack::AddressDetails> info((size_t)callstack.count);
+  resolv->GetAddrs(callstack.elems, info.size(), &info[0]);
+
+  create_array_uninit(ret, (size_t)callstack.count);
+  for(int32_t i = 0; i < callstack.count; i++)
+    ret[i] = info[i].formattedString();
+
+  return ret;
+}
+
+rdctype::array<uint32_t> ReplayController::FindEventsReferencing(ResourceId id)
+{
+  auto it = m_EventReferences.find(id);
+
+  if(it == m_EventReferences.end())
+    return rdctype::array<uint32_t>();
+
+  return it->second;
+}
+
+rdctype::str ReplayController::GetEventParameters(uint32_t eventID)
+{
+  auto it = m_EventParameters.find(eventID);
+
+  if(it == m_EventParameters.end())
+    return "";
+
+  return it->second;
+}
+
+rdctype::array<DebugMessage> ReplayController::GetDebugMessages()
+{
+  return m_pDevice->GetDebugMessages();
+}
+
+// identifiers for each kind of message returned from AnalyseWastedWork, as documented there
+enum WastedWorkMessage
+{
+  WastedWork_RedundantState = 1,
+  WastedWork_RedundantClear = 2,
+  WastedWork_NeverRead = 3,
+  WastedWork_OverwrittenOutput = 4,
+};
+
+static DebugMessage MakeWastedWorkMessage(uint32_t eventID, WastedWorkMessage id,
+                                          MessageSource source, MessageCategory category,
+                                          MessageSeverity severity, const std::string &desc)
+{
+  DebugMessage msg;
+  msg.eventID = eventID;
+  msg.messageID = (uint32_t)id;
+  msg.source = source;
+  msg.category = category;
+  msg.severity = severity;
+  msg.description = desc;
+  return msg;
+}
+
+static bool IsStateSettingCall(const std::string &name)
+{
+  // markers, object names and events have Set in their name but don't touch pipeline state
+  if(name.find("Marker") != std::string::npos || name.find("Name") != std::string::npos ||
+     name.find("Event") != std::string::npos || name.find("PrivateData") != std::string::npos ||
+     name.find("Debug") != std::string::npos)
+    return false;
+
+  return name.find("Set") != std::string::npos || name.find("Bind") != std::string::npos ||
+         name.find("UseProgram") != std::string::npos;
+}
+
+static void FindRedundantState(const rdctype::array<DrawcallDescription> &draws,
+                               const std::map<uint32_t, std::string> &eventParams,
+                               std::map<std::string, std::string> &lastCalls,
+                               vector<DebugMessage> &msgs)
+{
+  const DrawFlags passive = DrawFlags::Drawcall | DrawFlags::Dispatch | DrawFlags::Clear |
+                            DrawFlags::SetMarker | DrawFlags::PushMarker | DrawFlags::PopMarker;
+
+  for(int32_t i = 0; i < draws.count; i++)
+  {
+    const DrawcallDescription &draw = draws[i];
+
+    for(int32_t e = 0; e < draw.events.count; e++)
+    {
+      const APIEvent &ev = draw.events[e];
+      std::string name = ev.eventDesc.c_str();
+
+      // the event's name is the function name followed by its chunk index
+      name = name.substr(0, name.find(' '));
+
+      auto paramIt = eventParams.find(ev.eventID);
+      std::string params = paramIt == eventParams.end() ? "" : paramIt->second;
+
+      // the drawcall itself doesn't change any state
+      if(ev.eventID == draw.eventID && (draw.flags & passive))
+        continue;
+
+      if(!IsStateSettingCall(name))
+      {
+        // we don't know what this call does to the state, so be conservative and forget
+        // everything. This covers command buffer boundaries, barriers, ClearState, etc.
+        lastCalls.clear();
+        continue;
+      }
+
+      auto it = lastCalls.find(name);
+      if(it != lastCalls.end() && it->second == params)
+      {
+        msgs.push_back(MakeWastedWorkMessage(
+            ev.eventID, WastedWork_RedundantState, MessageSource::RedundantAPIUse,
+            MessageCategory::State_Setting, MessageSeverity::Low,
+            StringFormat::Fmt("%s repeats the previous call with identical parameters, and no "
+                              "other state has been set since.",
+                              name.c_str())));
+        continue;
+      }
+
+      // this call changes state, which could affect how other calls behave (e.g. a pipeline
+      // with a different layout disturbing descriptor sets), so only this call is kept.
+      lastCalls.clear();
+      lastCalls[name] = params;
+    }
+
+    FindRedundantState(draw.children, eventParams, lastCalls, msgs);
+  }
+}
+
+// usages that only write to the resource, and so don't depend on its previous contents
+static bool IsOverwriteUsage(ResourceUsage usage)
+{
+  return usage == ResourceUsage::Clear || usage == ResourceUsage::CopyDst ||
+         usage == ResourceUsage::ResolveDst || usage == ResourceUsage::StreamOut;
+}
+
+static bool IsReadUsage(ResourceUsage usage)
+{
+  return usage != ResourceUsage::Unused && usage != ResourceUsage::Barrier &&
+         !IsOverwriteUsage(usage);
+}
+
+static bool SameSubresource(const EventUsage &a, const EventUsage &b)
+{
+  // without a view the whole resource is used, so it overlaps with anything
+  return a.view == ResourceId() || b.view == ResourceId() || a.view == b.view;
+}
+
+static void FindWastedWrites(const std::string &resName, bool isBuffer,
+                             const vector<EventUsage> &usage, vector<DebugMessage> &msgs)
+{
+  uint32_t numUploads = 0;
+  uint32_t firstUpload = 0;
+  bool anyRead = false;
+
+  for(size_t i = 0; i < usage.size(); i++)
+  {
+    const EventUsage &u = usage[i];
+
+    if(IsReadUsage(u.usage))
+      anyRead = true;
+
+    if(u.usage == ResourceUsage::CopyDst || u.usage == ResourceUsage::ResolveDst)
+    {
+      if(numUploads == 0)
+        firstUpload = u.eventID;
+      numUploads++;
+    }
+
+    if(u.usage != ResourceUsage::Clear && u.usage != ResourceUsage::ColorTarget &&
+       u.usage != ResourceUsage::DepthStencilTarget)
+      continue;
+
+    // only check the last of any duplicate usages in the same event
+    if(i + 1 < usage.size() && usage[i + 1].eventID == u.eventID && usage[i + 1].usage == u.usage)
+      continue;
+
+    // find the next use of the same subresource in a later event
+    const EventUsage *next = NULL;
+    for(size_t j = i + 1; j < usage.size(); j++)
+    {
+      if(usage[j].eventID != u.eventID && usage[j].usage != ResourceUsage::Barrier &&
+         SameSubresource(u, usage[j]))
+      {
+        next = &usage[j];
+        break;
+      }
+    }
+
+    if(next == NULL || next->usage != ResourceUsage::Clear)
+      continue;
+
+    if(u.usage == ResourceUsage::Clear)
+    {
+      msgs.push_back(MakeWastedWorkMessage(
+          next->eventID, WastedWork_RedundantClear, MessageSource::RedundantAPIUse,
+          MessageCategory::Resource_Manipulation, MessageSeverity::Medium,
+          StringFormat::Fmt("%s is cleared again without being used since it was cleared at "
+                            "EID %u.",
+                            resName.c_str(), u.eventID)));
+    }
+    else
+    {
+      msgs.push_back(MakeWastedWorkMessage(
+          u.eventID, WastedWork_OverwrittenOutput, MessageSource::GeneralPerformance,
+          MessageCategory::Execution, MessageSeverity::Medium,
+          StringFormat::Fmt("Output to %s is cleared at EID %u without being read.",
+                            resName.c_str(), next->eventID)));
+    }
+  }
+
+  if(numUploads > 0 && !anyRead)
+  {
+    msgs.push_back(MakeWastedWorkMessage(
+        firstUpload, WastedWork_NeverRead, MessageSource::GeneralPerformance,
+        MessageCategory::Resource_Manipulation, MessageSeverity::Medium,
+        StringFormat::Fmt("%s %s is written to %u time(s) but never read in the frame.",
+                          isBuffer ? "Buffer" : "Texture", resName.c_str(), numUploads)));
+  }
+}
+
+static bool WastedWorkSort(const DebugMessage &a, const DebugMessage &b)
+{
+  if(a.eventID != b.eventID)
+    return a.eventID < b.eventID;
+  return a.messageID < b.messageID;
+}
+
+rdctype::array<DebugMessage> ReplayController::AnalyseWastedWork()
+{
+  vector<DebugMessage> ret;
+
+  std::map<std::string, std::string> lastCalls;
+  FindRedundantState(m_FrameRecord.drawcallList, m_EventParameters, lastCalls, ret);
+
+  // make sure the descriptions are cached
+  GetTextures();
+  GetBuffers();
+
+  for(size_t i = 0; i < m_Textures.size(); i++)
+  {
+    const TextureDescription &tex = m_Textures[i];
+
+    // the backbuffer's contents are consumed by presenting, which isn't a usage
+    if(tex.creationFlags & TextureCategory::SwapBuffer)
+      continue;
+
+    FindWastedWrites(tex.name.c_str(), false, m_pDevice->GetUsage(m_pDevice->GetLiveID(tex.ID)),
+                     ret);
+  }
+
+  for(size_t i = 0; i < m_Buffers.size(); i++)
+  {
+    const BufferDescription &buf = m_Buffers[i];
+
+    FindWastedWrites(buf.name.c_str(), true, m_pDevice->GetUsage(m_pDevice->GetLiveID(buf.ID)),
+                     ret);
+  }
+
+  std::stable_sort(ret.begin(), ret.end(), WastedWorkSort);
+
+  return ret;
+}
+
+static void AddShaderCost(ShaderCost &total, const ShaderCost &stage)
+{
+  total.instructions += stage.instructions;
+  total.aluInstructions += stage.aluInstructions;
+  total.transcendentalInstructions += stage.transcendentalInstructions;
+  total.sampleInstructions += stage.sampleInstructions;
+  total.memoryInstructions += stage.memoryInstructions;
+  total.flowControlInstructions += stage.flowControlInstructions;
+  total.tempRegisters = RDCMAX(total.tempRegisters, stage.tempRegisters);
+  total.loops += stage.loops;
+  total.maxLoopDepth = RDCMAX(total.maxLoopDepth, stage.maxLoopDepth);
+}
+
+rdctype::array<DrawcallShaderCost> ReplayController::GetDrawcallShaderCosts()
+{
+  vector<DrawcallShaderCost> ret;
+
+  GraphicsAPI api = m_pDevice->GetAPIProperties().pipelineType;
+
+  uint32_t prevEventID = m_EventID;
+
+  for(size_t i = 0; i < m_Drawcalls.size(); i++)
+  {
+    const DrawcallDescription *draw = m_Drawcalls[i];
+
+    if(draw == NULL || draw->eventID != (uint32_t)i ||
+       !(draw->flags & (DrawFlags::Drawcall | DrawFlags::Dispatch)))
+      continue;
+
+    if(m_CancelRequested)
+      break;
+
+    m_pDevice->ReplayLog(draw->eventID, eReplay_WithoutDraw);
+    FetchPipelineState();
+
+    ResourceId ids[6];
+    ShaderReflection *refls[6] = {};
+
+    if(api == GraphicsAPI::D3D11)
+    {
+      const D3D11Pipe::Shader *stages[] = {
+          &m_D3D11PipelineState.m_VS, &m_D3D11PipelineState.m_HS, &m_D3D11PipelineState.m_DS,
+          &m_D3D11PipelineState.m_GS, &m_D3D11PipelineState.m_PS, &m_D3D11PipelineState.m_CS,
+      };
+
+      for(int s = 0; s < 6; s++)
+      {
+        ids[s] = stages[s]->Object;
+        refls[s] = stages[s]->ShaderDetails;
+      }
+    }
+    else if(api == GraphicsAPI::D3D12)
+    {
+      const D3D12Pipe::Shader *stages[] = {
+          &m_D3D12PipelineState.m_VS, &m_D3D12PipelineState.m_HS, &m_D3D12PipelineState.m_DS,
+          &m_D3D12PipelineState.m_GS, &m_D3D12PipelineState.m_PS, &m_D3D12PipelineState.m_CS,
+      };
+
+      for(int s = 0; s < 6; s++)
+      {
+        ids[s] = stages[s]->Object;
+        refls[s] = stages[s]->ShaderDetails;
+      }
+    }
+    else if(api == GraphicsAPI::OpenGL)
+    {
+      const GLPipe::Shader *stages[] = {
+          &m_GLPipelineState.m_VS, &m_GLPipelineState.m_TCS, &m_GLPipelineState.m_TES,
+          &m_GLPipelineState.m_GS, &m_GLPipelineState.m_FS,  &m_GLPipelineState.m_CS,
+      };
+
+      for(int s = 0; s < 6; s++)
+      {
+        ids[s] = stages[s]->Object;
+        refls[s] = stages[s]->ShaderDetails;
+      }
+    }
+    else if(api == GraphicsAPI::Vulkan)
+    {
+      const VKPipe::Shader *stages[] = {
+          &m_VulkanPipelineState.m_VS, &m_VulkanPipelineState.m_TCS, &m_VulkanPipelineState.m_TES,
+          &m_VulkanPipelineState.m_GS, &m_VulkanPipelineState.m_FS,  &m_VulkanPipelineState.m_CS,
+      };
+
+      for(int s = 0; s < 6; s++)
+      {
+        ids[s] = stages[s]->Object;
+        refls[s] = stages[s]->ShaderDetails;
+      }
+    }
+
+    DrawcallShaderCost cost;
+    cost.eventID = draw->eventID;
+    create_array_uninit(cost.shaders, 6);
+    create_array_uninit(cost.stageCosts, 6);
+
+    // only the compute shader runs for a dispatch, and only the graphics stages for a draw
+    bool dispatch = bool(draw->flags & DrawFlags::Dispatch);
+
+    for(int s = 0; s < 6; s++)
+    {
+      bool computeStage = (s == (int)ShaderStage::Compute);
+
+      if(computeStage != dispatch)
+        continue;
+
+      cost.shaders[s] = ids[s];
+
+      if(ids[s] != ResourceId() && refls[s])
+      {
+        cost.stageCosts[s] = refls[s]->Cost;
+        AddShaderCost(cost.cost, refls[s]->Cost);
+      }
+    }
+
+    ret.push_back(cost);
+  }
+
+  SetFrameEvent(prevEventID, true);
+
+  return ret;
+}
+
+// the most an event is assumed to fetch per shader invocation from a resource - a single
+// 4-component 32-bit read. This bounds the traffic from large resources that are only sparsely
+// sampled.
+static const uint64_t BytesPerInvocation = 16;
+
+static uint64_t GetTexelBytes(const ResourceFormat &fmt)
+{
+  if(!fmt.special)
+    return uint64_t(fmt.compCount) * fmt.compByteWidth;
+
+  switch(fmt.specialFormat)
+  {
+    case SpecialFormat::R4G4:
+    case SpecialFormat::S8: return 1;
+    case SpecialFormat::R5G6B5:
+    case SpecialFormat::R5G5B5A1:
+    case SpecialFormat::R4G4B4A4: return 2;
+    case SpecialFormat::D32S8: return 8;
+    default: break;
+  }
+
+  return 4;
+}
+
+// the API-independent subset of the pipeline state that decides a drawcall's memory traffic. IDs
+// are original IDs, as in the pipeline state.
+struct DrawOutputState
+{
+  // vertex buffer and stride
+  vector<pair<ResourceId, uint32_t> > vbuffers;
+  // index buffer and the byte offset it's bound at
+  ResourceId ibuffer;
+  uint64_t ibufferOffset = 0;
+  // colour target and whether it's read back for blending or logic ops
+  vector<pair<ResourceId, bool> > colour;
+  ResourceId depth;
+  bool depthTest = false;
+  bool depthWrite = false;
+  float viewWidth = 0.0f;
+  float viewHeight = 0.0f;
+  uint32_t threads[3] = {0, 0, 0};
+};
+
+static void GetComputeThreads(const ShaderReflection *refl, DrawOutputState &out)
+{
+  if(refl)
+  {
+    for(int i = 0; i < 3; i++)
+      out.threads[i] = refl->DispatchThreadsDimension[i];
+  }
+}
+
+static void GetDrawOutputState(const D3D11Pipe::State &pipe, DrawOutputState &out)
+{
+  for(const D3D11Pipe::VB &vb : pipe.m_IA.vbuffers)
+    out.vbuffers.push_back(std::make_pair(vb.Buffer, vb.Stride));
+
+  out.ibuffer = pipe.m_IA.ibuffer.Buffer;
+  out.ibufferOffset = pipe.m_IA.ibuffer.Offset;
+
+  const D3D11Pipe::BlendState &blend = pipe.m_OM.m_BlendState;
+
+  for(int32_t i = 0; i < pipe.m_OM.RenderTargets.count; i++)
+  {
+    // without independent blending the first target's blend state applies to all of them
+    int32_t b = blend.IndependentBlend ? i : 0;
+    bool read = b < blend.Blends.count && (blend.Blends[b].Enabled || blend.Blends[b].LogicEnabled);
+
+    out.colour.push_back(std::make_pair(pipe.m_OM.RenderTargets[i].Resource, read));
+  }
+
+  out.depth = pipe.m_OM.DepthTarget.Resource;
+  out.depthTest = pipe.m_OM.m_State.DepthEnable != 0;
+  out.depthWrite = out.depthTest && pipe.m_OM.m_State.DepthWrites && !pipe.m_OM.DepthReadOnly;
+
+  if(pipe.m_RS.Viewports.count > 0)
+  {
+    out.viewWidth = pipe.m_RS.Viewports[0].Width;
+    out.viewHeight = pipe.m_RS.Viewports[0].Height;
+  }
+
+  GetComputeThreads(pipe.m_CS.ShaderDetails, out);
+}
+
+static void GetDrawOutputState(const D3D12Pipe::State &pipe, DrawOutputState &out)
+{
+  for(const D3D12Pipe::VB &vb : pipe.m_IA.vbuffers)
+    out.vbuffers.push_back(std::make_pair(vb.Buffer, vb.Stride));
+
+  out.ibuffer = pipe.m_IA.ibuffer.Buffer;
+  out.ibufferOffset = pipe.m_IA.ibuffer.Offset;
+
+  const D3D12Pipe::BlendState &blend = pipe.m_OM.m_BlendState;
+
+  for(int32_t i = 0; i < pipe.m_OM.RenderTargets.count; i++)
+  {
+    int32_t b = blend.IndependentBlend ? i : 0;
+    bool read = b < blend.Blends.count && (blend.Blends[b].Enabled || blend.Blends[b].LogicEnabled);
+
+    out.colour.push_back(std::make_pair(pipe.m_OM.RenderTargets[i].Resource, read));
+  }
+
+  out.depth = pipe.m_OM.DepthTarget.Resource;
+  out.depthTest = pipe.m_OM.m_State.DepthEnable != 0;
+  out.depthWrite = out.depthTest && pipe.m_OM.m_State.DepthWrites && !pipe.m_OM.DepthReadOnly;
+
+  if(pipe.m_RS.Viewports.count > 0)
+  {
+    out.viewWidth = pipe.m_RS.Viewports[0].Width;
+    out.viewHeight = pipe.m_RS.Viewports[0].Height;
+  }
+
+  GetComputeThreads(pipe.m_CS.ShaderDetails, out);
+}
+
+static void GetDrawOutputState(const GLPipe::State &pipe, DrawOutputState &out)
+{
+  for(const GLPipe::VB &vb : pipe.m_VtxIn.vbuffers)
+    out.vbuffers.push_back(std::make_pair(vb.Buffer, vb.Stride));
+
+  // GL draws give the index offset in the draw itself
+  out.ibuffer = pipe.m_VtxIn.ibuffer;
+
+  const GLPipe::FBO &fbo = pipe.m_FB.m_DrawFBO;
+  const GLPipe::BlendState &blend = pipe.m_FB.m_Blending;
+
+  // blend state is per draw buffer, not per attachment
+  for(int32_t i = 0; i < fbo.DrawBuffers.count; i++)
+  {
+    int32_t att = fbo.DrawBuffers[i];
+    if(att < 0 || att >= fbo.Color.count)
+      continue;
+
+    bool read = i < blend.Blends.count && blend.Blends[i].Enabled;
+
+    out.colour.push_back(std::make_pair(fbo.Color[att].Obj, read));
+  }
+
+  out.depth = fbo.Depth.Obj;
+  out.depthTest = pipe.m_DepthState.DepthEnable != 0;
+  out.depthWrite = out.depthTest && pipe.m_DepthState.DepthWrites;
+
+  if(pipe.m_Rasterizer.Viewports.count > 0)
+  {
+    out.viewWidth = pipe.m_Rasterizer.Viewports[0].Width;
+    out.viewHeight = pipe.m_Rasterizer.Viewports[0].Height;
+  }
+
+  GetComputeThreads(pipe.m_CS.ShaderDetails, out);
+}
+
+static void GetDrawOutputState(const VKPipe::State &pipe, DrawOutputState &out)
+{
+  for(const VKPipe::VertexBinding &bind : pipe.VI.binds)
+  {
+    if(bind.vbufferBinding < (uint32_t)pipe.VI.vbuffers.count)
+      out.vbuffers.push_back(
+          std::make_pair(pipe.VI.vbuffers[bind.vbufferBinding].buffer, bind.bytestride));
+  }
+
+  out.ibuffer = pipe.IA.ibuffer.buf;
+  out.ibufferOffset = pipe.IA.ibuffer.offs;
+
+  const VKPipe::RenderPass &rp = pipe.Pass.renderpass;
+  const VKPipe::Framebuffer &fb = pipe.Pass.framebuffer;
+
+  for(int32_t i = 0; i < rp.colorAttachments.count; i++)
+  {
+    uint32_t att = rp.colorAttachments[i];
+    if(att >= (uint32_t)fb.attachments.count)
+      continue;
+
+    bool read = pipe.CB.logicOpEnable ||
+                (i < pipe.CB.attachments.count && pipe.CB.attachments[i].blendEnable);
+
+    out.colour.push_back(std::make_pair(fb.attachments[att].img, read));
+  }
+
+  if(rp.depthstencilAttachment >= 0 && rp.depthstencilAttachment < fb.attachments.count)
+    out.depth = fb.attachments[rp.depthstencilAttachment].img;
+
+  out.depthTest = pipe.DS.depthTestEnable != 0;
+  out.depthWrite = out.depthTest && pipe.DS.depthWriteEnable;
+
+  if(pipe.VP.viewportScissors.count > 0)
+  {
+    out.viewWidth = pipe.VP.viewportScissors[0].vp.width;
+    out.viewHeight = pipe.VP.viewportScissors[0].vp.height;
+  }
+
+  GetComputeThreads(pipe.m_CS.ShaderDetails, out);
+}
+
+ReplayController::CounterValueMap ReplayController::FetchCounterValues(
+    const vector<GPUCounter> &counters)
+{
+  CounterValueMap ret;
+
+  vector<GPUCounter> available = m_pDevice->EnumerateCounters();
+  vector<GPUCounter> fetch;
+
+  for(GPUCounter c : counters)
+  {
+    if(std::find(available.begin(), available.end(), c) != available.end())
+      fetch.push_back(c);
+  }
+
+  if(fetch.empty())
+    return ret;
+
+  map<GPUCounter, CounterDescription> descs;
+  for(GPUCounter c : fetch)
+    m_pDevice->DescribeCounter(c, descs[c]);
+
+  ScopedReplayCancel cancel(&m_CancelRequested);
+
+  for(const CounterResult &r : m_pDevice->FetchCounters(fetch))
+    ret[std::make_pair(r.eventID, r.counterID)] = GetCounterValue(descs[r.counterID], r);
+
+  return ret;
+}
+
+rdctype::array<DrawcallBandwidth> ReplayController::GetDrawcallBandwidth()
+{
+  SCOPED_PROFILE("ReplayController::GetDrawcallBandwidth");
+
+  // where the driver has pipeline statistics, use the real vertex, pixel and thread counts rather
+  // than working them out from the drawcall parameters
+  return EstimateBandwidth(FetchCounterValues(
+      {GPUCounter::VSInvocations, GPUCounter::PSInvocations, GPUCounter::CSInvocations}));
+}
+
+vector<DrawcallBandwidth> ReplayController::EstimateBandwidth(const CounterValueMap &counters)
+{
+  BuildEventDependencies();
+
+  // byte size and texel size of every texture and buffer, by live ID
+  struct ResourceSize
+  {
+    uint64_t bytes = 0;
+    uint64_t texelBytes = 0;
+  };
+  ResourceIdMap<ResourceSize> sizes;
+  sizes.reserve(m_Textures.size() + m_Buffers.size());
+
+  for(const TextureDescription &tex : m_Textures)
+  {
+    ResourceSize &size = sizes[m_pDevice->GetLiveID(tex.ID)];
+    size.bytes = tex.byteSize;
+    size.texelBytes = GetTexelBytes(tex.format) * RDCMAX(1U, tex.msSamp);
+  }
+
+  for(const BufferDescription &buf : m_Buffers)
+    sizes[m_pDevice->GetLiveID(buf.ID)].bytes = buf.length;
+
+  auto GetSize = [this, &sizes](ResourceId id, bool live) -> ResourceSize {
+    auto it = sizes.find(live ? id : m_pDevice->GetLiveID(id));
+    return it == sizes.end() ? ResourceSize() : it->second;
+  };
+
+  auto GetInvocations = [&counters](uint32_t eventID, GPUCounter c, uint64_t fallback) {
+    auto it = counters.find(std::make_pair(eventID, c));
+    return it == counters.end() ? fallback : uint64_t(it->second);
+  };
+
+  vector<DrawcallBandwidth> ret;
+
+  GraphicsAPI api = m_pDevice->GetAPIProperties().pipelineType;
+
+  uint32_t prevEventID = m_EventID;
+  bool replayed = false;
+
+  for(size_t i = 0; i < m_Drawcalls.size(); i++)
+  {
+    const DrawcallDescription *draw = m_Drawcalls[i];
+
+    if(draw == NULL || draw->eventID != (uint32_t)i ||
+       !(draw->flags & (DrawFlags::Drawcall | DrawFlags::Dispatch | DrawFlags::Clear |
+                        DrawFlags::Copy | DrawFlags::Resolve | DrawFlags::GenMips)))
+      continue;
+
+    if(m_CancelRequested)
+      break;
+
+    DrawcallBandwidth bw;
+    bw.eventID = draw->eventID;
+
+    uint64_t instances = RDCMAX(1U, draw->numInstances);
+    uint64_t vertices = 0;
+    uint64_t pixels = 0;
+    uint64_t threads = 0;
+
+    // only drawcalls and dispatches have pipeline state that matters, the rest just move whole
+    // resources around and are covered by their usage below
+    if(draw->flags & (DrawFlags::Drawcall | DrawFlags::Dispatch))
+    {
+      m_pDevice->ReplayLog(draw->eventID, eReplay_WithoutDraw);
+      FetchPipelineState();
+      replayed = true;
+
+      DrawOutputState state;
+
+      if(api == GraphicsAPI::D3D11)
+        GetDrawOutputState(m_D3D11PipelineState, state);
+      else if(api == GraphicsAPI::D3D12)
+        GetDrawOutputState(m_D3D12PipelineState, state);
+      else if(api == GraphicsAPI::OpenGL)
+        GetDrawOutputState(m_GLPipelineState, state);
+      else if(api == GraphicsAPI::Vulkan)
+        GetDrawOutputState(m_VulkanPipelineState, state);
+
+      if(draw->flags & DrawFlags::Dispatch)
+      {
+        const uint32_t *groupSize = draw->dispatchThreadsDimension[0] != 0
+                                        ? draw->dispatchThreadsDimension
+                                        : state.threads;
+
+        uint64_t count = 1;
+        for(int d = 0; d < 3; d++)
+          count *= uint64_t(draw->dispatchDimension[d]) * RDCMAX(1U, groupSize[d]);
+
+        threads = GetInvocations(draw->eventID, GPUCounter::CSInvocations, count);
+      }
+      else
+      {
+        vertices = GetInvocations(draw->eventID, GPUCounter::VSInvocations,
+                                  uint64_t(draw->numIndices) * instances);
+
+        // without pipeline statistics assume every pixel in the viewport is shaded once
+        uint64_t area = uint64_t(RDCMAX(0.0f, state.viewWidth)) *
+                        uint64_t(RDCMAX(0.0f, state.viewHeight));
+        pixels = GetInvocations(draw->eventID, GPUCounter::PSInvocations, area);
+
+        // a buffer can't be read more than once, which also bounds per-instance data
+        for(const pair<ResourceId, uint32_t> &vb : state.vbuffers)
+        {
+          if(vb.first != ResourceId())
+            bw.vertexBytes += RDCMIN(GetSize(vb.first, false).bytes, vertices * vb.second);
+        }
+
+        for(const pair<ResourceId, bool> &col : state.colour)
+        {
+          if(col.first == ResourceId())
+            continue;
+
+          uint64_t bytes = pixels * GetSize(col.first, false).texelBytes;
+
+          bw.targetWriteBytes += bytes;
+          if(col.second)
+            bw.targetReadBytes += bytes;
+        }
+
+        if(state.depth != ResourceId() && state.depthTest)
+        {
+          uint64_t bytes = pixels * GetSize(state.depth, false).texelBytes;
+
+          bw.targetReadBytes += bytes;
+          if(state.depthWrite)
+            bw.targetWriteBytes += bytes;
+        }
+      }
+    }
+
+    // the most any shader can read from or write to one resource
+    uint64_t shaderBytes = (vertices + pixels + threads) * BytesPerInvocation;
+
+    auto ev = m_EventResources.find(draw->eventID);
+    if(ev != m_EventResources.end())
+    {
+      for(const pair<ResourceId, ResourceUsage> &u : ev->second.usage)
+      {
+        uint64_t size = GetSize(u.first, true).bytes;
+
+        switch(u.second)
+        {
+          case ResourceUsage::IndexBuffer:
+            bw.vertexBytes +=
+                RDCMIN(size, uint64_t(draw->numIndices) * instances * draw->indexByteWidth);
+            break;
+          case ResourceUsage::VS_Constants:
+          case ResourceUsage::HS_Constants:
+          case ResourceUsage::DS_Constants:
+          case ResourceUsage::GS_Constants:
+          case ResourceUsage::PS_Constants:
+          case ResourceUsage::CS_Constants:
+          case ResourceUsage::All_Constants:
+          case ResourceUsage::VS_Resource:
+          case ResourceUsage::HS_Resource:
+          case ResourceUsage::DS_Resource:
+          case ResourceUsage::GS_Resource:
+          case ResourceUsage::PS_Resource:
+          case ResourceUsage::CS_Resource:
+          case ResourceUsage::All_Resource:
+          case ResourceUsage::InputTarget:
+            bw.resourceReadBytes += RDCMIN(size, shaderBytes);
+            break;
+          case ResourceUsage::VS_RWResource:
+          case ResourceUsage::HS_RWResource:
+          case ResourceUsage::DS_RWResource:
+          case ResourceUsage::GS_RWResource:
+          case ResourceUsage::PS_RWResource:
+          case ResourceUsage::CS_RWResource:
+          case ResourceUsage::All_RWResource:
+            bw.targetReadBytes += RDCMIN(size, shaderBytes);
+            bw.targetWriteBytes += RDCMIN(size, shaderBytes);
+            break;
+          case ResourceUsage::StreamOut:
+            bw.targetWriteBytes += RDCMIN(size, vertices * BytesPerInvocation);
+            break;
+          case ResourceUsage::CopySrc:
+          case ResourceUsage::ResolveSrc: bw.resourceReadBytes += size; break;
+          case ResourceUsage::Clear:
+          case ResourceUsage::CopyDst:
+          case ResourceUsage::ResolveDst: bw.targetWriteBytes += size; break;
+          case ResourceUsage::Copy:
+          case ResourceUsage::Resolve:
+          case ResourceUsage::GenMips:
+            bw.resourceReadBytes += size;
+            bw.targetWriteBytes += size;
+            break;
+          // vertex buffers and targets were counted from the pipeline state, which knows the
+          // strides, formats and blending
+          default: break;
+        }
+      }
+    }
+
+    bw.bytesRead = bw.vertexBytes + bw.resourceReadBytes + bw.targetReadBytes;
+    bw.bytesWritten = bw.targetWriteBytes;
+
+    ret.push_back(bw);
+  }
+
+  if(replayed)
+    SetFrameEvent(prevEventID, true);
+
+  return ret;
+}
+
+// rough throughputs of a GPU relative to its shader instruction rate, for scoring fixed-function
+// work and memory traffic against shading. A GPU runs a few dozen instructions in the time it takes
+// to set up a primitive or write a sample, and several for each byte of memory it moves.
+static const double WorkPerPrimitive = 32.0;
+static const double WorkPerSample = 32.0;
+static const double WorkPerByte = 8.0;
+// events scoring below this can't fill the GPU, so the fixed cost of issuing them dominates
+static const double OverheadWork = 65536.0;
+// the group size assumed for a dispatch when neither the call nor a counter gives the thread count
+static const uint64_t DefaultGroupSize = 64;
+
+static double GetHighestWork(const DrawcallBottleneck &b)
+{
+  return RDCMAX(RDCMAX(b.vertexWork, b.fragmentWork),
+                RDCMAX(RDCMAX(b.fillWork, b.bandwidthWork), b.computeWork));
+}
+
+static uint32_t GetStageInstructions(const DrawcallShaderCost &cost, ShaderStage stage)
+{
+  if((int32_t)stage >= cost.stageCosts.count)
+    return 0;
+
+  return cost.stageCosts[(int32_t)stage].instructions;
+}
+
+rdctype::array<PassBottleneck> ReplayController::AnalyseBottlenecks()
+{
+  SCOPED_PROFILE("ReplayController::AnalyseBottlenecks");
+
+  CounterValueMap counters = FetchCounterValues(
+      {GPUCounter::EventGPUDuration, GPUCounter::VSInvocations, GPUCounter::PSInvocations,
+       GPUCounter::CSInvocations, GPUCounter::RasterizedPrimitives, GPUCounter::SamplesWritten});
+
+  if(m_CancelRequested)
+    return rdctype::array<PassBottleneck>();
+
+  rdctype::array<DrawcallShaderCost> costs = GetDrawcallShaderCosts();
+
+  if(m_CancelRequested)
+    return rdctype::array<PassBottleneck>();
+
+  vector<DrawcallBandwidth> bandwidth = EstimateBandwidth(counters);
+
+  if(m_CancelRequested)
+    return rdctype::array<PassBottleneck>();
+
+  auto GetCounter = [&counters](uint32_t eventID, GPUCounter c, double fallback) {
+    auto it = counters.find(std::make_pair(eventID, c));
+    return it == counters.end() ? fallback : it->second;
+  };
+
+  map<uint32_t, uint64_t> bytes;
+  for(const DrawcallBandwidth &bw : bandwidth)
+    bytes[bw.eventID] = bw.bytesRead + bw.bytesWritten;
+
+  // the shortest event in the frame is close to the fixed cost of any event
+  bool hasDurations = false;
+  double minDuration = 0.0;
+
+  for(auto it = counters.begin(); it != counters.end(); ++it)
+  {
+    if(it->first.second != GPUCounter::EventGPUDuration || it->second <= 0.0)
+      continue;
+
+    minDuration = hasDurations ? RDCMIN(minDuration, it->second) : it->second;
+    hasDurations = true;
+  }
+
+  auto GetCost = [hasDurations](const DrawcallBottleneck &b) {
+    return hasDurations ? b.duration : GetHighestWork(b);
+  };
+
+  vector<PassBottleneck> passes;
+  vector<vector<DrawcallBottleneck> > passDraws;
+  map<int64_t, size_t> parentPasses;
+
+  // the top-level pass being added to, and the targets of its last event
+  size_t topLevelPass = ~0U;
+  const DrawcallDescription *topLevelDraw = NULL;
+
+  for(const DrawcallShaderCost &cost : costs)
+  {
+    const DrawcallDescription *draw = GetDrawcallByEID(cost.eventID);
+
+    if(draw == NULL)
+      continue;
+
+    DrawcallBottleneck b;
+    b.eventID = cost.eventID;
+    b.duration = GetCounter(b.eventID, GPUCounter::EventGPUDuration, 0.0);
+    b.bytes = bytes[b.eventID];
+    b.bandwidthWork = double(b.bytes) * WorkPerByte;
+
+    if(draw->flags & DrawFlags::Dispatch)
+    {
+      uint64_t threads = 1;
+      for(int d = 0; d < 3; d++)
+        threads *= draw->dispatchDimension[d];
+      if(draw->dispatchThreadsDimension[0] != 0)
+        threads *= uint64_t(draw->dispatchThreadsDimension[0]) *
+                   RDCMAX(1U, draw->dispatchThreadsDimension[1]) *
+                   RDCMAX(1U, draw->dispatchThreadsDimension[2]);
+      else
+        threads *= DefaultGroupSize;
+
+      b.computeInvocations =
+          (uint64_t)GetCounter(b.eventID, GPUCounter::CSInvocations, double(threads));
+
+      b.computeWork = double(b.computeInvocations) *
+                      RDCMAX(1U, GetStageInstructions(cost, ShaderStage::Compute));
+
+      b.limiter = b.computeWork >= b.bandwidthWork ? Bottleneck::Compute : Bottleneck::Bandwidth;
+    }
+    else
+    {
+      uint64_t vertices = uint64_t(draw->numIndices) * RDCMAX(1U, draw->numInstances);
+
+      b.vertexInvocations =
+          (uint64_t)GetCounter(b.eventID, GPUCounter::VSInvocations, double(vertices));
+      b.rasterizedPrimitives =
+          (uint64_t)GetCounter(b.eventID, GPUCounter::RasterizedPrimitives, 0.0);
+      b.samplesWritten = (uint64_t)GetCounter(b.eventID, GPUCounter::SamplesWritten, 0.0);
+      b.pixelInvocations = (uint64_t)GetCounter(b.eventID, GPUCounter::PSInvocations,
+                                                double(b.samplesWritten));
+
+      uint32_t vertexInstructions = GetStageInstructions(cost, ShaderStage::Vertex) +
+                                    GetStageInstructions(cost, ShaderStage::Hull) +
+                                    GetStageInstructions(cost, ShaderStage::Domain) +
+                                    GetStageInstructions(cost, ShaderStage::Geometry);
+
+      b.vertexWork = double(b.vertexInvocations) * RDCMAX(1U, vertexInstructions) +
+                     double(b.rasterizedPrimitives) * WorkPerPrimitive;
+      b.fragmentWork = double(b.pixelInvocations) *
+                       RDCMAX(1U, GetStageInstructions(cost, ShaderStage::Pixel));
+      b.fillWork = double(b.samplesWritten) * WorkPerSample;
+
+      b.limiter = Bottleneck::Vertex;
+      double highest = b.vertexWork;
+
+      if(b.fragmentWork > highest)
+      {
+        b.limiter = Bottleneck::Fragment;
+        highest = b.fragmentWork;
+      }
+
+      if(b.fillWork > highest)
+      {
+        b.limiter = Bottleneck::Fill;
+        highest = b.fillWork;
+      }
+
+      if(b.bandwidthWork > highest)
+        b.limiter = Bottleneck::Bandwidth;
+    }
+
+    double work = GetHighestWork(b);
+
+    // a small event that takes about as long as the quickest event in the frame is just paying the
+    // fixed cost
+    if(work < OverheadWork ||
+       (hasDurations && b.duration <= minDuration * 2.0 && work < OverheadWork * 16.0))
+      b.limiter = Bottleneck::Overhead;
+
+    size_t pass = ~0U;
+
+    if(draw->parent != 0)
+    {
+      auto it = parentPasses.find(draw->parent);
+
+      if(it == parentPasses.end())
+      {
+        pass = passes.size();
+        parentPasses[draw->parent] = pass;
+
+        const DrawcallDescription *parent = GetDrawcallByEID((uint32_t)draw->parent);
+
+        passes.push_back(PassBottleneck());
+        passes.back().eventID = b.eventID;
+        if(parent)
+          passes.back().name = parent->name;
+        passDraws.push_back(vector<DrawcallBottleneck>());
+      }
+      else
+      {
+        pass = it->second;
+      }
+
+      topLevelPass = ~0U;
+    }
+    else
+    {
+      // group unmarked events at the top level by the targets they write to
+      if(topLevelPass == ~0U || topLevelDraw->depthOut != draw->depthOut ||
+         memcmp(topLevelDraw->outputs, draw->outputs, sizeof(draw->outputs)) != 0)
+      {
+        topLevelPass = passes.size();
+
+        passes.push_back(PassBottleneck());
+        passes.back().eventID = b.eventID;
+        passDraws.push_back(vector<DrawcallBottleneck>());
+      }
+
+      pass = topLevelPass;
+      topLevelDraw = draw;
+    }
+
+    PassBottleneck &p = passes[pass];
+    p.lastEventID = b.eventID;
+    p.duration += b.duration;
+    p.work += work;
+
+    passDraws[pass].push_back(b);
+  }
+
+  for(size_t i = 0; i < passes.size(); i++)
+  {
+    PassBottleneck &p = passes[i];
+    vector<DrawcallBottleneck> &draws = passDraws[i];
+
+    if(p.name.count == 0)
+      p.name = StringFormat::Fmt("Unmarked events %u - %u", p.eventID, p.lastEventID);
+
+    // the pass is limited by whatever is limiting most of its cost
+    map<Bottleneck, double> share;
+    for(const DrawcallBottleneck &b : draws)
+      share[b.limiter] += GetCost(b);
+
+    double highest = -1.0;
+    for(auto it = share.begin(); it != share.end(); ++it)
+    {
+      if(it->second > highest)
+      {
+        p.limiter = it->first;
+        highest = it->second;
+      }
+    }
+
+    std::stable_sort(draws.begin(), draws.end(),
+                     [&GetCost](const DrawcallBottleneck &a, const DrawcallBottleneck &b) {
+                       return GetCost(a) > GetCost(b);
+                     });
+
+    p.draws = draws;
+  }
+
+  std::stable_sort(passes.begin(), passes.end(),
+                   [hasDurations](const PassBottleneck &a, const PassBottleneck &b) {
+                     return hasDurations ? a.duration > b.duration : a.work > b.work;
+                   });
+
+  return passes;
+}
+
+rdctype::array<IndexEfficiency> ReplayController::GetIndexEfficiency()
+{
+  SCOPED_PROFILE("ReplayController::GetIndexEfficiency");
+
+  vector<IndexEfficiency> ret;
+
+  GraphicsAPI api = m_pDevice->GetAPIProperties().pipelineType;
+
+  uint32_t prevEventID = m_EventID;
+  bool replayed = false;
+
+  for(size_t i = 0; i < m_Drawcalls.size(); i++)
+  {
+    const DrawcallDescription *draw = m_Drawcalls[i];
+
+    if(draw == NULL || draw->eventID != (uint32_t)i || !(draw->flags & DrawFlags::Drawcall) ||
+       !(draw->flags & DrawFlags::UseIBuffer) || draw->numIndices == 0)
+      continue;
+
+    if(draw->topology != Topology::TriangleList && draw->topology != Topology::TriangleStrip)
+      continue;
+
+    if(m_CancelRequested)
+      break;
+
+    m_pDevice->ReplayLog(draw->eventID, eReplay_WithoutDraw);
+    FetchPipelineState();
+    replayed = true;
+
+    DrawOutputState state;
+
+    if(api == GraphicsAPI::D3D11)
+      GetDrawOutputState(m_D3D11PipelineState, state);
+    else if(api == GraphicsAPI::D3D12)
+      GetDrawOutputState(m_D3D12PipelineState, state);
+    else if(api == GraphicsAPI::OpenGL)
+      GetDrawOutputState(m_GLPipelineState, state);
+    else if(api == GraphicsAPI::Vulkan)
+      GetDrawOutputState(m_VulkanPipelineState, state);
+
+    if(state.ibuffer == ResourceId())
+      continue;
+
+    IndexStatsKey key;
+    key.buffer = m_pDevice->GetLiveID(state.ibuffer);
+    key.offset = state.ibufferOffset + uint64_t(draw->indexOffset) * draw->indexByteWidth;
+    key.count = draw->numIndices;
+    key.byteWidth = draw->indexByteWidth;
+    key.strip = draw->topology == Topology::TriangleStrip;
+
+    // the same mesh is often drawn many times, only re-read the indices if they've been written
+    auto it = m_IndexStats.find(key);
+    if(it == m_IndexStats.end() ||
+       TextureWrittenBetween(key.buffer, draw->eventID, it->second.eventID))
+    {
+      vector<byte> data;
+      m_pDevice->GetBufferData(key.buffer, key.offset, uint64_t(key.count) * key.byteWidth, data);
+
+      // the draw may read past the end of the buffer, only analyse the indices that are there
+      uint32_t count = RDCMIN(key.count, uint32_t(data.size() / RDCMAX(1U, key.byteWidth)));
+
+      CachedIndexStats &cached = m_IndexStats[key];
+      cached.eventID = draw->eventID;
+      cached.stats = AnalyseIndices(data.data(), count, key.byteWidth, key.strip);
+
+      it = m_IndexStats.find(key);
+    }
+
+    const IndexStats &stats = it->second.stats;
+
+    IndexEfficiency eff;
+    eff.eventID = draw->eventID;
+    eff.indexBuffer = state.ibuffer;
+    eff.byteOffset = key.offset;
+    eff.numIndices = key.count;
+    eff.triangles = stats.triangles;
+    eff.degenerateTriangles = stats.degenerateTriangles;
+    eff.uniqueVertices = stats.uniqueVertices;
+
+    if(stats.uniqueVertices > 0)
+    {
+      eff.minIndex = stats.minIndex;
+      eff.maxIndex = stats.maxIndex;
+      eff.referencedFraction =
+          float(double(stats.uniqueVertices) / (double(stats.maxIndex - stats.minIndex) + 1.0));
+      eff.lruATVR = float(stats.lruMisses) / float(stats.uniqueVertices);
+    }
+
+    if(stats.triangles > 0)
+    {
+      eff.fifoACMR = float(stats.fifoMisses) / float(stats.triangles);
+      eff.lruACMR = float(stats.lruMisses) / float(stats.triangles);
+    }
+
+    ret.push_back(eff);
+  }
+
+  if(replayed)
+    SetFrameEvent(prevEventID, true);
+
+  return ret;
+}
+
+rdctype::array<TextureSamplingFeedback> ReplayController::GetTextureSampling(uint32_t startEventID,
+                                                                             uint32_t endEventID)
+{
+  SCOPED_PROFILE("ReplayController::GetTextureSampling", startEventID);
+
+  rdctype::array<TextureSamplingFeedback> ret;
+
+  if(endEventID < startEventID)
+    std::swap(startEventID, endEventID);
+
+  {
+    ScopedReplayCancel cancel(&m_CancelRequested);
+
+    ret = m_pDevice->FetchTextureSampling(startEventID, endEventID);
+  }
+
+  // a cancelled replay only covers some of the events, which would be misleading
+  if(m_CancelRequested)
+    ret = rdctype::array<TextureSamplingFeedback>();
+
+  SetFrameEvent(m_EventID, true);
+
+  return ret;
+}
+
+static uint64_t GetDrawcallTreeSize(const rdctype::array<DrawcallDescription> &draws,
+                                    uint64_t &count)
+{
+  uint64_t ret = draws.count * sizeof(DrawcallDescription);
+
+  for(int32_t i = 0; i < draws.count; i++)
+  {
+    const DrawcallDescription &draw = draws[i];
+
+    count++;
+
+    ret += draw.name.count;
+    ret += draw.events.count * sizeof(APIEvent);
+
+    for(int32_t e = 0; e < draw.events.count; e++)
+      ret += draw.events[e].eventDesc.count + draw.events[e].callstack.count * sizeof(uint64_t) +
+             draw.events[e].referencedResources.count * sizeof(ResourceId);
+
+    ret += GetDrawcallTreeSize(draw.children, count);
+  }
+
+  return ret;
+}
+
+rdctype::array<MemoryUsage> ReplayController::GetMemoryUsage()
+{
+  vector<MemoryUsage> ret = m_pDevice->GetMemoryUsage();
+
+  ret.push_back(MakeMemoryUsage("Chunks", false, Chunk::NumLiveChunks(), Chunk::TotalMem()));
+
+  uint64_t count = 0;
+  uint64_t bytes = GetDrawcallTreeSize(m_FrameRecord.drawcallList, count);
+  bytes += m_Drawcalls.capacity() * sizeof(DrawcallDescription *);
+  bytes += m_FlatDrawcalls.draws.count * sizeof(FlatDrawcall) + m_FlatDrawcalls.names.count;
+  ret.push_back(MakeMemoryUsage("Drawcall tree", false, count, bytes));
+
+  bytes = 0;
+  for(auto it = m_EventParameters.begin(); it != m_EventParameters.end(); ++it)
+    bytes += sizeof(uint32_t) + it->second.capacity();
+  ret.push_back(MakeMemoryUsage("Event parameters", false, m_EventParameters.size(), bytes));
+
+  bytes = 0;
+  for(auto it = m_EventReferences.begin(); it != m_EventReferences.end(); ++it)
+    bytes += sizeof(ResourceId) + it->second.capacity() * sizeof(uint32_t);
+  ret.push_back(MakeMemoryUsage("Event references", false, m_EventReferences.size(), bytes));
+
+  bytes = 0;
+  for(auto it = m_EventResources.begin(); it != m_EventResources.end(); ++it)
+    bytes += sizeof(uint32_t) + sizeof(EventResources) +
+             it->second.used.capacity() * sizeof(ResourceId) +
+             it->second.usage.capacity() * sizeof(pair<ResourceId, ResourceUsage>);
+  for(auto it = m_ResourceWrites.begin(); it != m_ResourceWrites.end(); ++it)
+    bytes += sizeof(ResourceId) + it->second.capacity() * sizeof(uint32_t);
+  ret.push_back(MakeMemoryUsage("Event dependencies", false, m_EventResources.size(), bytes));
+
+  bytes = 0;
+  for(auto it = m_TextureStats.begin(); it != m_TextureStats.end(); ++it)
+  {
+    bytes += sizeof(TextureStatsKey) + sizeof(TextureStats);
+    for(const TextureStats::Histogram &h : it->second.histograms)
+      bytes += sizeof(TextureStats::Histogram) + h.buckets.capacity() * sizeof(uint32_t);
+  }
+  ret.push_back(MakeMemoryUsage("Texture statistics", false, m_TextureStats.size(), bytes));
+
+  bytes = 0;
+  for(auto it = m_ThumbnailCache.begin(); it != m_ThumbnailCache.end(); ++it)
+    bytes += uint64_t(it->second.width) * it->second.height * 4;
+  ret.push_back(MakeMemoryUsage("Texture thumbnails", true, m_ThumbnailCache.size(), bytes));
+
+  return ret;
+}
+
+rdctype::array<EventUsage> ReplayController::GetUsage(ResourceId id)
+{
+  return m_pDevice->GetUsage(m_pDevice->GetLiveID(id));
+}
+
+MeshFormat ReplayController::GetPostVSData(uint32_t instID, MeshDataStage stage)
+{
+  SCOPED_PROFILE("ReplayController::GetPostVSData", m_EventID);
+
+  DrawcallDescription *draw = GetDrawcallByEID(m_EventID);
+
+  MeshFormat ret;
+  RDCEraseEl(ret);
+
+  if(draw == NULL || !(draw->flags & DrawFlags::Drawcall))
+    return MeshFormat();
+
+  instID = RDCMIN(instID, draw->numInstances - 1);
+
+  return GetPostVSBuffers(draw->eventID, instID, stage);
+}
+
+void ReplayController::InitPostVSBuffers(uint32_t eventID)
+{
+  // GetPostVSBuffers initialises the event itself if the disk cache turns out not to have what's
+  // needed
+  if(m_PostVSDiskCache.Contains(eventID))
+    return;
+
+  m_pDevice->InitPostVSBuffers(eventID);
+}
+
+MeshFormat ReplayController::GetPostVSBuffers(uint32_t eventID, uint32_t instID,
+                                              MeshDataStage stage)
+{
+  if(!m_PostVSDiskCache.IsOpen())
+    return m_pDevice->GetPostVSBuffers(eventID, instID, stage);
+
+  MeshFormat ret;
+
+  if(m_PostVSDiskCache.GetFormat(eventID, instID, stage, ret))
+  {
+    // the stage has no output, e.g. GS output for a draw without a geometry shader
+    if(ret.buf == ResourceId())
+      return ret;
+
+    ResourceId buf = GetPostVSProxyBuffer(eventID, stage, false);
+    ResourceId idxbuf = ret.idxbuf == ResourceId() ? ResourceId()
+                                                   : GetPostVSProxyBuffer(eventID, stage, true);
+
+    if(buf != ResourceId() && (idxbuf != ResourceId()) == (ret.idxbuf != ResourceId()))
+    {
+      ret.buf = buf;
+      ret.idxbuf = idxbuf;
+      return ret;
+    }
+  }
+
+  m_pDevice->InitPostVSBuffers(eventID);
+  ret = m_pDevice->GetPostVSBuffers(eventID, instID, stage);
+
+  // empty results are stored too, so asking for them doesn't need the driver next time
+  if(ret.buf == ResourceId())
+  {
+    m_PostVSDiskCache.StoreFormat(eventID, instID, stage, ret);
+    return ret;
+  }
+
+  // instances share their buffers, so the data only needs to be stored once per stage
+  vector<byte> data;
+
+  if(!m_PostVSDiskCache.HasData(eventID, stage, false))
+  {
+    m_pDevice->GetBufferData(ret.buf, 0, 0, data);
+    m_PostVSDiskCache.StoreData(eventID, stage, false, data);
+  }
+
+  if(ret.idxbuf != ResourceId() && !m_PostVSDiskCache.HasData(eventID, stage, true))
+  {
+    m_pDevice->GetBufferData(ret.idxbuf, 0, 0, data);
+    m_PostVSDiskCache.StoreData(eventID, stage, true, data);
+  }
+
+  m_PostVSDiskCache.StoreFormat(eventID, instID, stage, ret);
+
+  return ret;
+}
+
+ResourceId ReplayController::GetPostVSProxyBuffer(uint32_t eventID, MeshDataStage stage, bool index)
+{
+  uint64_t key = (uint64_t(eventID) << 32) | (uint64_t(stage) << 1) | (index ? 1 : 0);
+
+  auto it = m_PostVSProxyBuffers.find(key);
+  if(it != m_PostVSProxyBuffers.end())
+    return it->second;
+
+  vector<byte> data;
+  if(!m_PostVSDiskCache.GetData(eventID, stage, index, data))
+    return ResourceId();
+
+  BufferDescription desc;
+  desc.creationFlags = index ? BufferCategory::Index : BufferCategory::Vertex;
+  desc.length = data.size();
+
+  ResourceId ret = m_pDevice->CreateProxyBuffer(desc);
+
+  // not every driver can create proxy buffers, in which case the cache is no use
+  if(ret == ResourceId())
+  {
+    RDCWARN("Can't create buffers for post-VS disk cache, disabling it");
+    m_PostVSDiskCache.Close();
+    return ret;
+  }
+
+  m_pDevice->SetProxyBufferData(ret, &data[0], data.size());
+
+  m_PostVSProxyBuffers[key] = ret;
+
+  return ret;
+}
+
+rdctype::array<byte> ReplayController::GetBufferData(ResourceId buff, uint64_t offset, uint64_t len)
+{
+  SCOPED_PROFILE("ReplayController::GetBufferData");
+
+  rdctype::array<byte> ret;
+
+  if(buff == ResourceId())
+    return ret;
+
+  ResourceId liveId = m_pDevice->GetLiveID(buff);
+
+  if(liveId == ResourceId())
+  {
+    RDCERR("Couldn't get Live ID for %llu getting buffer data", buff);
+    return ret;
+  }
+
+  vector<byte> retData;
+  m_pDevice->GetBufferData(liveId, offset, len, retData);
+
+  create_array_init(ret, retData.size(), !retData.empty() ? &retData[0] : NULL);
+
+  return ret;
+}
+
+rdctype::array<byte> ReplayController::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip)
+{
+  SCOPED_PROFILE("ReplayController::GetTextureData");
+
+  rdctype::array<byte> ret;
+
+  ResourceId liveId = m_pDevice->GetLiveID(tex);
+
+  if(liveId == ResourceId())
+  {
+    RDCERR("Couldn't get Live ID for %llu getting texture data", tex);
+    return ret;
+  }
+
+  size_t sz = 0;
+  byte *bytes = m_pDevice->GetTextureData(liveId, arrayIdx, mip, GetTextureDataParams(), sz);
+
+  if(sz == 0 || bytes == NULL)
+    create_array_uninit(ret, 0);
+  else
+    create_array_init(ret, sz, bytes);
+
+  SAFE_DELETE_ARRAY(bytes);
+
+  return ret;
+}
+
+// the size of one texel for formats that can be read back a region at a time, or 0 if the format
+// isn't supported
+static uint32_t RegionBytesPerPixel(const ResourceFormat &fmt)
+{
+  if(!fmt.special)
+    return fmt.compCount * fmt.compByteWidth;
+
+  switch(fmt.specialFormat)
+  {
+    case SpecialFormat::S8: return 1;
+    case SpecialFormat::R5G6B5:
+    case SpecialFormat::R5G5B5A1:
+    case SpecialFormat::R4G4B4A4: return 2;
+    case SpecialFormat::R10G10B10A2:
+    case SpecialFormat::R9G9B9E5:
+    case SpecialFormat::R11G11B10:
+    case SpecialFormat::D24S8: return 4;
+    case SpecialFormat::D32S8: return 8;
+    default: break;
+  }
+
+  return 0;
+}
+
+rdctype::array<byte> ReplayController::GetTextureDataRegion(ResourceId tex, uint32_t arrayIdx,
+                                                            uint32_t mip, uint32_t x, uint32_t y,
+                                                            uint32_t width, uint32_t height)
+{
+  SCOPED_PROFILE("ReplayController::GetTextureDataRegion");
+
+  rdctype::array<byte> ret;
+
+  ResourceId liveId = m_pDevice->GetLiveID(tex);
+
+  if(liveId == ResourceId())
+  {
+    RDCERR("Couldn't get Live ID for %llu getting texture data", tex);
+    return ret;
+  }
+
+  TextureDescription td = m_pDevice->GetTexture(liveId);
+
+  uint32_t bpp = RegionBytesPerPixel(td.format);
+
+  if(bpp == 0)
+  {
+    RDCERR("Can't fetch a region of texture %llu with format %s", tex, td.format.strname.c_str());
+    return ret;
+  }
+
+  uint32_t mipWidth = RDCMAX(1U, td.width >> mip);
+  uint32_t mipHeight = RDCMAX(1U, td.height >> mip);
+  uint32_t mipDepth = RDCMAX(1U, td.depth >> mip);
+
+  if(x >= mipWidth || y >= mipHeight || width == 0 || height == 0)
+    return ret;
+
+  width = RDCMIN(width, mipWidth - x);
+  height = RDCMIN(height, mipHeight - y);
+
+  GetTextureDataParams params;
+  params.regionX = x;
+  params.regionY = y;
+  params.regionWidth = width;
+  params.regionHeight = height;
+
+  size_t sz = 0;
+  byte *bytes = m_pDevice->GetTextureData(liveId, arrayIdx, mip, params, sz);
+
+  size_t rowSize = size_t(width) * bpp;
+  size_t regionSize = rowSize * height * mipDepth;
+  size_t fullRowSize = size_t(mipWidth) * bpp;
+  size_t fullSize = fullRowSize * mipHeight * mipDepth;
+
+  if(bytes == NULL || sz == 0)
+  {
+    create_array_uninit(ret, 0);
+  }
+  else if(sz == regionSize)
+  {
+    create_array_init(ret, sz, bytes);
+  }
+  else if(sz >= fullSize)
+  {
+    // the driver returned the whole subresource, so crop it here
+    create_array_uninit(ret, regionSize);
+
+    byte *dst = ret.elems;
+    for(uint32_t z = 0; z < mipDepth; z++)
+    {
+      for(uint32_t row = 0; row < height; row++)
+      {
+        memcpy(dst, bytes + (z * mipHeight + y + row) * fullRowSize + x * bpp, rowSize);
+        dst += rowSize;
+      }
+    }
+  }
+  else
+  {
+    RDCERR("Unexpected size %llu reading back region of texture %llu", (uint64_t)sz, tex);
+  }
+
+  SAFE_DELETE_ARRAY(bytes);
+
+  return ret;
+}
+
+bool ReplayController::FetchTextureFloats(ResourceId liveId, uint32_t sliceFace, uint32_t mip,
+                                          std::vector<FloatVector> &texels)
+{
+  TextureDescription td = m_pDevice->GetTexture(liveId);
+  const ResourceFormat &fmt = td.format;
+
+  bool r10g10b10a2 = fmt.special && fmt.specialFormat == SpecialFormat::R10G10B10A2;
+  bool r11g11b10 = fmt.special && fmt.specialFormat == SpecialFormat::R11G11B10;
+
+  if(fmt.special && !r10g10b10a2 && !r11g11b10)
+  {
+    RDCERR("Can't compare texture with format %s", fmt.strname.c_str());
+    return false;
+  }
+
+  GetTextureDataParams params;
+  params.resolve = td.msSamp > 1;
+
+  size_t sz = 0;
+  byte *bytes = m_pDevice->GetTextureData(liveId, sliceFace, mip, params, sz);
+
+  size_t count = size_t(RDCMAX(1U, td.width >> mip)) * RDCMAX(1U, td.height >> mip) *
+                 RDCMAX(1U, td.depth >> mip);
+
+  size_t bpp = fmt.special ? 4 : fmt.compCount * fmt.compByteWidth;
+
+  if(bytes == NULL || sz < count * bpp)
+  {
+    RDCERR("Unexpected size %llu fetching texture to compare", (uint64_t)sz);
+    SAFE_DELETE_ARRAY(bytes);
+    return false;
+  }
+
+  texels.resize(count);
+
+  if(r10g10b10a2 || r11g11b10)
+  {
+    const uint32_t *packed = (const uint32_t *)bytes;
+
+    for(size_t i = 0; i < count; i++)
+    {
+      if(r10g10b10a2)
+      {
+        Vec4f v = ConvertFromR10G10B10A2(packed[i]);
+        texels[i] = FloatVector(v.x, v.y, v.z, v.w);
+      }
+      else
+      {
+        Vec3f v = ConvertFromR11G11B10(packed[i]);
+        texels[i] = FloatVector(v.x, v.y, v.z, 1.0f);
+      }
+    }
+  }
+  else
+  {
+    std::vector<float> comps(count * fmt.compCount);
+    ConvertComponents(fmt, bytes, comps.size(), &comps[0]);
+
+    for(size_t i = 0; i < count; i++)
+    {
+      float *c = &comps[i * fmt.compCount];
+      float rgba[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+      for(uint32_t ch = 0; ch < fmt.compCount && ch < 4; ch++)
+        rgba[ch] = c[ch];
+
+      if(fmt.bgraOrder)
+        std::swap(rgba[0], rgba[2]);
+
+      texels[i] = FloatVector(rgba[0], rgba[1], rgba[2], rgba[3]);
+    }
+  }
+
+  SAFE_DELETE_ARRAY(bytes);
+
+  return true;
+}
+
+// the results from one block of rows of a texture comparison, merged once all blocks are done
+struct TextureDiffBlock
+{
+  uint64_t changed = 0;
+  float maxError[4] = {};
+  double sumError[4] = {};
+  uint32_t minX = ~0U, minY = ~0U, maxX = 0, maxY = 0;
+};
+
+struct TextureDiffBatch
+{
+  const FloatVector *a;
+  const FloatVector *b;
+  FloatVector *diff;
+  uint32_t width, height;
+  uint32_t rows;
+  float threshold;
+
+  static const uint32_t RowsPerJob = 64;
+
+  int32_t numJobs;
+  volatile int32_t nextJob;
+  std::vector<TextureDiffBlock> blocks;
+};
+
+static void TextureDiffWorker(void *param)
+{
+  TextureDiffBatch *batch = (TextureDiffBatch *)param;
+
+  for(;;)
+  {
+    int32_t idx = Atomic::Inc32(&batch->nextJob) - 1;
+
+    if(idx >= batch->numJobs)
+      break;
+
+    TextureDiffBlock &block = batch->blocks[idx];
+
+    uint32_t rowStart = uint32_t(idx) * TextureDiffBatch::RowsPerJob;
+    uint32_t rowEnd = RDCMIN(batch->rows, rowStart + TextureDiffBatch::RowsPerJob);
+
+    for(uint32_t row = rowStart; row < rowEnd; row++)
+    {
+      // 3D textures have each slice's rows in turn, the bounds are only tracked in 2D
+      uint32_t y = row % batch->height;
+
+      size_t offs = size_t(row) * batch->width;
+      const FloatVector *a = batch->a + offs;
+      const FloatVector *b = batch->b + offs;
+      FloatVector *diff = batch->diff + offs;
+
+      for(uint32_t x = 0; x < batch->width; x++)
+      {
+        float err[4] = {
+            fabsf(a[x].x - b[x].x), fabsf(a[x].y - b[x].y), fabsf(a[x].z - b[x].z),
+            fabsf(a[x].w - b[x].w),
+        };
+
+        diff[x] = FloatVector(err[0], err[1], err[2], err[3]);
+
+        bool changed = false;
+
+        for(int c = 0; c < 4; c++)
+        {
+          block.maxError[c] = RDCMAX(block.maxError[c], err[c]);
+          block.sumError[c] += err[c];
+          changed |= err[c] > batch->threshold;
+        }
+
+        if(changed)
+        {
+          block.changed++;
+          block.minX = RDCMIN(block.minX, x);
+          block.maxX = RDCMAX(block.maxX, x);
+          block.minY = RDCMIN(block.minY, y);
+          block.maxY = RDCMAX(block.maxY, y);
+        }
+      }
+    }
+  }
+}
+
+TextureDiff ReplayController::CompareTextures(ResourceId texA, uint32_t eventA, ResourceId texB,
+                                              uint32_t eventB, uint32_t sliceFace, uint32_t mip,
+                                              float threshold)
+{
+  SCOPED_PROFILE("ReplayController::CompareTextures");
+
+  TextureDiff ret;
+  ret.totalPixels = ret.changedPixels = 0;
+  ret.changedX = ret.changedY = ret.changedWidth = ret.changedHeight = 0;
+
+  ResourceId liveA = m_pDevice->GetLiveID(texA);
+  ResourceId liveB = m_pDevice->GetLiveID(texB);
+
+  if(liveA == ResourceId() || liveB == ResourceId())
+  {
+    RDCERR("Couldn't get Live ID for %llu or %llu comparing textures", texA, texB);
+    return ret;
+  }
+
+  TextureDescription tdA = m_pDevice->GetTexture(liveA);
+  TextureDescription tdB = m_pDevice->GetTexture(liveB);
+
+  uint32_t width = RDCMAX(1U, tdA.width >> mip);
+  uint32_t height = RDCMAX(1U, tdA.height >> mip);
+  uint32_t depth = RDCMAX(1U, tdA.depth >> mip);
+
+  if(width != RDCMAX(1U, tdB.width >> mip) || height != RDCMAX(1U, tdB.height >> mip) ||
+     depth != RDCMAX(1U, tdB.depth >> mip))
+  {
+    RDCERR("Can't compare textures %llu and %llu with different dimensions", texA, texB);
+    return ret;
+  }
+
+  uint32_t prevEvent = m_EventID;
+
+  std::vector<FloatVector> a, b;
+
+  // each replay only needs to produce one texture, so anything that can't affect it is skipped
+  ReplayForTarget(liveA, eventA);
+  bool success = FetchTextureFloats(liveA, sliceFace, mip, a);
+
+  if(success)
+  {
+    if(eventB != eventA || liveB != liveA)
+      ReplayForTarget(liveB, eventB);
+    success = FetchTextureFloats(liveB, sliceFace, mip, b);
+  }
+
+  // put the replay back where it was
+  SetFrameEvent(prevEvent, true);
+
+  if(!success)
+    return ret;
+
+  std::vector<FloatVector> diff(a.size());
+
+  TextureDiffBatch batch;
+  batch.a = &a[0];
+  batch.b = &b[0];
+  batch.diff = &diff[0];
+  batch.width = width;
+  batch.height = height;
+  batch.rows = height * depth;
+  batch.threshold = threshold;
+  batch.numJobs = int32_t((batch.rows + TextureDiffBatch::RowsPerJob - 1) /
+                          TextureDiffBatch::RowsPerJob);
+  batch.nextJob = 0;
+  batch.blocks.resize(batch.numJobs);
+
+  {
+    uint32_t numThreads = RDCMIN(Threading::GetCPUCount(), (uint32_t)batch.numJobs);
+
+    std::vector<Threading::ThreadHandle> threads;
+
+    for(uint32_t i = 1; i < numThreads; i++)
+    {
+      Threading::ThreadHandle t = Threading::CreateThread(TextureDiffWorker, &batch);
+      if(t)
+        threads.push_back(t);
+    }
+
+    TextureDiffWorker(&batch);
+
+    for(size_t i = 0; i < threads.size(); i++)
+    {
+      Threading::JoinThread(threads[i]);
+      Threading::CloseThread(threads[i]);
+    }
+  }
+
+  TextureDiffBlock total;
+
+  for(const TextureDiffBlock &block : batch.blocks)
+  {
+    total.changed += block.changed;
+    for(int c = 0; c < 4; c++)
+    {
+      total.maxError[c] = RDCMAX(total.maxError[c], block.maxError[c]);
+      total.sumError[c] += block.sumError[c];
+    }
+    total.minX = RDCMIN(total.minX, block.minX);
+    total.minY = RDCMIN(total.minY, block.minY);
+    total.maxX = RDCMAX(total.maxX, block.maxX);
+    total.maxY = RDCMAX(total.maxY, block.maxY);
+  }
+
+  double count = double(a.size());
+
+  ret.totalPixels = a.size();
+  ret.changedPixels = total.changed;
+  ret.maxError = FloatVector(total.maxError[0], total.maxError[1], total.maxError[2],
+                             total.maxError[3]);
+  ret.meanError = FloatVector(float(total.sumError[0] / count), float(total.sumError[1] / count),
+                              float(total.sumError[2] / count), float(total.sumError[3] / count));
+
+  if(total.changed > 0)
+  {
+    ret.changedX = total.minX;
+    ret.changedY = total.minY;
+    ret.changedWidth = total.maxX - total.minX + 1;
+    ret.changedHeight = total.maxY - total.minY + 1;
+  }
+
+  // 3D textures only show their first slice of differences
+  if(m_DiffTexture == ResourceId() || m_DiffWidth != width || m_DiffHeight != height)
+  {
+    TextureDescription desc;
+    desc.dimension = 2;
+    desc.resType = TextureDim::Texture2D;
+    desc.width = width;
+    desc.height = height;
+    desc.depth = 1;
+    desc.arraysize = 1;
+    desc.mips = 1;
+    desc.msQual = 0;
+    desc.msSamp = 1;
+    desc.cubemap = false;
+    desc.customName = false;
+    desc.byteSize = size_t(width) * height * sizeof(FloatVector);
+    desc.allocationSize = 0;
+    desc.allocationAlignment = 0;
+    desc.placeholderInitialContents = false;
+    desc.format.special = false;
+    desc.format.compCount = 4;
+    desc.format.compByteWidth = 4;
+    desc.format.compType = CompType::Float;
+    desc.creationFlags = TextureCategory::ShaderRead;
+
+    m_DiffTexture = m_pDevice->CreateProxyTexture(desc);
+    m_DiffWidth = width;
+    m_DiffHeight = height;
+  }
+
+  if(m_DiffTexture != ResourceId())
+    m_pDevice->SetProxyTextureData(m_DiffTexture, 0, 0, (byte *)&diff[0],
+                                   size_t(width) * height * sizeof(FloatVector));
+
+  ret.diffTexture = m_DiffTexture;
+
+  return ret;
+}
+
+bool ReplayController::FetchTextureSave(const TextureSave &saveData, TextureSaveJob &job)
+{
+  SCOPED_PROFILE("ReplayController::FetchTextureSave");
+
+  TextureSave sd = saveData;    // mutable copy
+  ResourceId liveid = m_pDevice->GetLiveID(sd.id);
+  TextureDescription td = m_pDevice->GetTexture(liveid);
+
+  // clamp sample/mip/slice indices
+  if(td.msSamp == 1)
+  {
+    sd.sample.sampleIndex = 0;
+    sd.sample.mapToArray = false;
+  }
+  else
+  {
+    if(sd.sample.sampleIndex != ~0U)
+      sd.sample.sampleIndex = RDCCLAMP(sd.sample.sampleIndex, 0U, td.msSamp);
+  }
+
+  // don't support cube cruciform for non cubemaps, or
+  // cubemap arrays
+  if(!td.cubemap || td.arraysize != 6 || td.msSamp != 1)
+    sd.slice.cubeCruciform = false;
+
+  if(sd.mip != -1)
+    sd.mip = RDCCLAMP(sd.mip, 0, (int32_t)td.mips);
+  if(sd.slice.sliceIndex != -1)
+    sd.slice.sliceIndex = RDCCLAMP(sd.slice.sliceIndex, 0, int32_t(td.arraysize * td.depth));
+
+  if(td.arraysize * td.depth * td.msSamp == 1)
+  {
+    sd.slice.sliceIndex = 0;
+    sd.slice.slicesAsGrid = false;
+  }
+
+  // can't extract a channel that's not in the source texture
+  if(sd.channelExtract >= 0 && (uint32_t)sd.channelExtract >= td.format.compCount)
+    sd.channelExtract = -1;
+
+  sd.slice.sliceGridWidth = RDCMAX(sd.slice.sliceGridWidth, 1);
+
+  // store sample count so we know how many 'slices' is one real slice
+  // multisampled textures cannot have mips, subresource layout is same as would be for mips:
+  // [slice0 sample0], [slice0 sample1], [slice1 sample0], [slice1 sample1]
+  uint32_t sampleCount = td.msSamp;
+  bool multisampled = td.msSamp > 1;
+
+  bool resolveSamples = (sd.sample.sampleIndex == ~0U);
+
+  if(resolveSamples)
+  {
+    td.msSamp = 1;
+    sd.sample.mapToArray = false;
+    sd.sample.sampleIndex = 0;
+  }
+
+  // treat any multisampled texture as if it were an array
+  // of <sample count> dimension (on top of potential existing array
+  // dimension). GetTextureData() uses the same convention.
+  if(td.msSamp > 1)
+  {
+    td.arraysize *= td.msSamp;
+    td.msSamp = 1;
+  }
+
+  if(sd.destType != FileType::DDS && sd.sample.mapToArray && !sd.slice.slicesAsGrid &&
+     sd.slice.sliceIndex == -1)
+  {
+    sd.sample.mapToArray = false;
+    sd.sample.sampleIndex = 0;
+  }
+
+  // only DDS supports writing multiple mips, fall back to mip 0 if 'all mips' was specified
+  if(sd.destType != FileType::DDS && sd.mip == -1)
+    sd.mip = 0;
+
+  // only DDS supports writing multiple slices, fall back to slice 0 if 'all slices' was specified
+  if(sd.destType != FileType::DDS && sd.slice.sliceIndex == -1 && !sd.slice.slicesAsGrid &&
+     !sd.slice.cubeCruciform)
+    sd.slice.sliceIndex = 0;
+
+  // fetch source data subresources (typically only one, possibly more
+  // if we're writing to DDS (so writing multiple mips/slices) or resolving
+  // down a multisampled texture for writing as a single 'image' elsewhere)
+  uint32_t sliceOffset = 0;
+  uint32_t sliceStride = 1;
+  uint32_t numSlices = td.arraysize * td.depth;
+
+  uint32_t mipOffset = 0;
+  uint32_t numMips = td.mips;
+
+  bool singleSlice = (sd.slice.sliceIndex != -1);
+
+  // set which slices/mips we need
+  if(multisampled)
+  {
+    bool singleSample = !sd.sample.mapToArray;
+
+    // multisampled images have no mips
+    mipOffset = 0;
+    numMips = 1;
+
+    if(singleSlice)
+    {
+      if(singleSample)
+      {
+        // we want a specific sample in a specific real slice
+        sliceOffset = sd.slice.sliceIndex * sampleCount + sd.sample.sampleIndex;
+        numSlices = 1;
+      }
+      else
+      {
+        // we want all the samples (now mapped to slices) in a specific real slice
+        sliceOffset = sd.slice.sliceIndex;
+        numSlices = sampleCount;
+      }
+    }
+    else
+    {
+      if(singleSample)
+      {
+        // we want one sample in every slice, so we have to set the stride to sampleCount
+        // to skip every other sample (mapped to slices), starting from the sample we want
+        // in the first real slice
+        sliceOffset = sd.sample.sampleIndex;
+        sliceStride = sampleCount;
+        numSlices = RDCMAX(1U, td.arraysize / sampleCount);
+      }
+      else
+      {
+        // we want all slices, all samples
+        sliceOffset = 0;
+        numSlices = td.arraysize;
+      }
+    }
+  }
+  else
+  {
+    if(singleSlice)
+    {
+      numSlices = 1;
+      sliceOffset = sd.slice.sliceIndex;
+    }
+    // otherwise take all slices, as by default
+
+    if(sd.mip != -1)
+    {
+      mipOffset = sd.mip;
+      numMips = 1;
+    }
+    // otherwise take all mips, as by default
+  }
+
+  vector<byte *> subdata;
+
+  bool downcast = false;
+
+  // don't support slice mappings for DDS - it supports slices natively
+  if(sd.destType == FileType::DDS)
+  {
+    sd.slice.cubeCruciform = false;
+    sd.slice.slicesAsGrid = false;
+  }
+
+  // force downcast to be able to do grid mappings
+  if(sd.slice.cubeCruciform || sd.slice.slicesAsGrid)
+    downcast = true;
+
+  // we don't support any file formats that handle these block compression formats
+  if(td.format.specialFormat == SpecialFormat::ETC2 ||
+     td.format.specialFormat == SpecialFormat::EAC || td.format.specialFormat == SpecialFormat::ASTC)
+    downcast = true;
+
+  // for DDS don't downcast, for non-HDR always downcast if we're not already RGBA8 unorm
+  // for HDR&EXR we can convert from most regular types as well as 10.10.10.2 and 11.11.10
+  if((sd.destType != FileType::DDS && sd.destType != FileType::HDR && sd.destType != FileType::EXR &&
+      (td.format.compByteWidth != 1 || td.format.compCount != 4 ||
+       td.format.compType != CompType::UNorm || td.format.bgraOrder)) ||
+     downcast || (sd.destType != FileType::DDS && td.format.special &&
+                  td.format.specialFormat != SpecialFormat::R10G10B10A2 &&
+                  td.format.specialFormat != SpecialFormat::R11G11B10))
+  {
+    downcast = true;
+    td.format.compByteWidth = 1;
+    td.format.compCount = 4;
+    td.format.compType = CompType::UNorm;
+    td.format.special = false;
+    td.format.specialFormat = SpecialFormat::Unknown;
+  }
+
+  uint32_t rowPitch = 0;
+  uint32_t slicePitch = 0;
+
+  bool blockformat = false;
+  int blockSize = 0;
+  uint32_t bytesPerPixel = 1;
+
+  td.width = RDCMAX(1U, td.width >> mipOffset);
+  td.height = RDCMAX(1U, td.height >> mipOffset);
+  td.depth = RDCMAX(1U, td.depth >> mipOffset);
+
+  if(td.format.specialFormat == SpecialFormat::BC1 ||
+     td.format.specialFormat == SpecialFormat::BC2 || td.format.specialFormat == SpecialFormat::BC3 ||
+     td.format.specialFormat == SpecialFormat::BC4 || td.format.specialFormat == SpecialFormat::BC5 ||
+     td.format.specialFormat == SpecialFormat::BC6 || td.format.specialFormat == SpecialFormat::BC7)
+  {
+    blockSize = (td.format.specialFormat == SpecialFormat::BC1 ||
+                 td.format.specialFormat == SpecialFormat::BC4)
+                    ? 8
+                    : 16;
+    rowPitch = RDCMAX(1U, ((td.width + 3) / 4)) * blockSize;
+    slicePitch = rowPitch * RDCMAX(1U, td.height / 4);
+    blockformat = true;
+  }
+  else
+  {
+    switch(td.format.specialFormat)
+    {
+      case SpecialFormat::S8: bytesPerPixel = 1; break;
+      case SpecialFormat::R10G10B10A2:
+      case SpecialFormat::R9G9B9E5:
+      case SpecialFormat::R11G11B10:
+      case SpecialFormat::D24S8: bytesPerPixel = 4; break;
+      case SpecialFormat::R5G6B5:
+      case SpecialFormat::R5G5B5A1:
+      case SpecialFormat::R4G4B4A4: bytesPerPixel = 2; break;
+      case SpecialFormat::D32S8: bytesPerPixel = 8; break;
+      case SpecialFormat::D16S8:
+      case SpecialFormat::YUV:
+      case SpecialFormat::R4G4:
+        RDCERR("Unsupported file format %u", td.format.specialFormat);
+        return false;
+      default: bytesPerPixel = td.format.compCount * td.format.compByteWidth;
+    }
+
+    rowPitch = td.width * bytesPerPixel;
+    slicePitch = rowPitch * td.height;
+  }
+
+  // DDS needs no conversion, so write it straight out and fetch each subresource only as it's
+  // written rather than holding the whole texture in memory. A single depth slice of a 3D texture
+  // is extracted below, so that case still goes through the normal path.
+  if(sd.destType == FileType::DDS && (td.depth == 1 || !singleSlice))
+  {
+    dds_data ddsData = {};
+
+    ddsData.width = td.width;
+    ddsData.height = td.height;
+    ddsData.depth = td.depth;
+    ddsData.format = td.format;
+    ddsData.mips = numMips;
+    ddsData.slices = numSlices / td.depth;
+    ddsData.cubemap = td.cubemap && numSlices == 6;
+
+    job.written = true;
+    job.writeSuccess = false;
+
+    FILE *f = FileIO::fopen(job.path.c_str(), "wb");
+
+    if(f)
+    {
+      job.writeSuccess = write_dds_to_file(f, ddsData, [&](int slice, int mip) -> byte * {
+        GetTextureDataParams params;
+        params.forDiskSave = true;
+        params.typeHint = sd.typeHint;
+        params.resolve = resolveSamples;
+        params.remap = downcast ? eRemap_RGBA8 : eRemap_None;
+        params.blackPoint = sd.comp.blackPoint;
+        params.whitePoint = sd.comp.whitePoint;
+
+        size_t datasize = 0;
+        return m_pDevice->GetTextureData(liveid, slice * sliceStride + sliceOffset,
+                                         mip + mipOffset, params, datasize);
+      });
+
+      FileIO::fclose(f);
+    }
+
+    return true;
+  }
+
+  // loop over fetching subresources
+  for(uint32_t s = 0; s < numSlices; s++)
+  {
+    uint32_t slice = s * sliceStride + sliceOffset;
+
+    for(uint32_t m = 0; m < numMips; m++)
+    {
+      uint32_t mip = m + mipOffset;
+
+      GetTextureDataParams params;
+      params.forDiskSave = true;
+      params.typeHint = sd.typeHint;
+      params.resolve = resolveSamples;
+      params.remap = downcast ? eRemap_RGBA8 : eRemap_None;
+      params.blackPoint = sd.comp.blackPoint;
+      params.whitePoint = sd.comp.whitePoint;
+
+      size_t datasize = 0;
+      byte *bytes = m_pDevice->GetTextureData(liveid, slice, mip, params, datasize);
+
+      if(bytes == NULL)
+      {
+        RDCERR("Couldn't get bytes for mip %u, slice %u", mip, slice);
+
+        for(size_t i = 0; i < subdata.size(); i++)
+          delete[] subdata[i];
+
+        return false;
+      }
+
+      if(td.depth == 1)
+      {
+        subdata.push_back(bytes);
+        continue;
+      }
+
+      uint32_t mipSlicePitch = slicePitch;
+
+      uint32_t w = RDCMAX(1U, td.width >> m);
+      uint32_t h = RDCMAX(1U, td.height >> m);
+      uint32_t d = RDCMAX(1U, td.depth >> m);
+
+      if(blockformat)
+      {
+        mipSlicePitch = RDCMAX(1U, ((w + 3) / 4)) * blockSize * RDCMAX(1U, h / 4);
+      }
+      else
+      {
+        mipSlicePitch = w * bytesPerPixel * h;
+      }
+
+      // we don't support slice ranges, only all-or-nothing
+      // we're also not dealing with multisampled slices if
+      // depth > 1. So if we only want one slice out of a 3D texture
+      // then make sure we get it
+      if(numSlices == 1)
+      {
+        byte *depthslice = new byte[mipSlicePitch];
+        byte *b = bytes + mipSlicePitch * sliceOffset;
+        memcpy(depthslice, b, slicePitch);
+        subdata.push_back(depthslice);
+
+        delete[] bytes;
+        continue;
+      }
+
+      s += (d - 1);
+
+      byte *b = bytes;
+
+      // add each depth slice as a separate subdata
+      for(uint32_t di = 0; di < d; di++)
+      {
+        byte *depthslice = new byte[mipSlicePitch];
+
+        memcpy(depthslice, b, mipSlicePitch);
+
+        subdata.push_back(depthslice);
+
+        b += mipSlicePitch;
+      }
+
+      delete[] bytes;
+    }
+  }
+
+  job.sd = sd;
+  job.td = td;
+  job.subdata.swap(subdata);
+  job.rowPitch = rowPitch;
+  job.numSlices = numSlices;
+  job.numMips = numMips;
+
+  return true;
+}
+
+static bool EncodeTextureSave(TextureSaveJob &job)
+{
+  SCOPED_PROFILE("EncodeTextureSave");
+
+  if(job.written)
+    return job.writeSuccess;
+
+  TextureSave &sd = job.sd;
+  TextureDescription &td = job.td;
+  vector<byte *> &subdata = job.subdata;
+  uint32_t rowPitch = job.rowPitch;
+  uint32_t numSlices = job.numSlices;
+  uint32_t numMips = job.numMips;
+
+  bool success = false;
+
+  // should have been handled above, but verify incoming data is RGBA8
+  if(sd.slice.slicesAsGrid && td.format.compByteWidth == 1 && td.format.compCount == 4)
+  {
+    uint32_t sliceWidth = td.width;
+    uint32_t sliceHeight = td.height;
+
+    uint32_t sliceGridHeight = (td.arraysize * td.depth) / sd.slice.sliceGridWidth;
+    if((td.arraysize * td.depth) % sd.slice.sliceGridWidth != 0)
+      sliceGridHeight++;
+
+    td.width *= sd.slice.sliceGridWidth;
+    td.height *= sliceGridHeight;
+
+    byte *combinedData = new byte[td.width * td.height * td.format.compCount];
+
+    memset(combinedData, 0, td.width * td.height * td.format.compCount);
+
+    for(size_t i = 0; i < subdata.size(); i++)
+    {
+      uint32_t gridx = (uint32_t)i % sd.slice.sliceGridWidth;
+      uint32_t gridy = (uint32_t)i / sd.slice.sliceGridWidth;
+
+      uint32_t yoffs = gridy * sliceHeight;
+      uint32_t xoffs = gridx * sliceWidth;
+
+      for(uint32_t y = 0; y < sliceHeight; y++)
+      {
+        for(uint32_t x = 0; x < sliceWidth; x++)
+        {
+          uint32_t *srcpix = (uint32_t *)&subdata[i][(y * sliceWidth + x) * 4 + 0];
+          uint32_t *dstpix = (uint32_t *)&combinedData[((y + yoffs) * td.width + x + xoffs) * 4 + 0];
+
+          *dstpix = *srcpix;
+        }
+      }
+
+      delete[] subdata[i];
+    }
+
+    subdata.resize(1);
+    subdata[0] = combinedData;
+    rowPitch = td.width * 4;
+  }
+
+  // should have been handled above, but verify incoming data is RGBA8 and 6 slices
+  if(sd.slice.cubeCruciform && td.format.compByteWidth == 1 && td.format.compCount == 4 &&
+     subdata.size() == 6)
+  {
+    uint32_t sliceWidth = td.width;
+    uint32_t sliceHeight = td.height;
+
+    td.width *= 4;
+    td.height *= 3;
+
+    byte *combinedData = new byte[td.width * td.height * td.format.compCount];
+
+    memset(combinedData, 0, td.width * td.height * td.format.compCount);
+
+    /*
+     Y X=0   1   2   3
+     =     +---+
+     0     |+y |
+           |[2]|
+       +---+---+---+---+
+     1 |-x |+z |+x |-z |
+       |[1]|[4]|[0]|[5]|
+       +---+---+---+---+
+     2     |-y |
+           |[3]|
+           +---+
+
+    */
+
+    uint32_t gridx[6] = {2, 0, 1, 1, 1, 3};
+    uint32_t gridy[6] = {1, 1, 0, 2, 1, 1};
+
+    for(size_t i = 0; i < subdata.size(); i++)
+    {
+      uint32_t yoffs = gridy[i] * sliceHeight;
+      uint32_t xoffs = gridx[i] * sliceWidth;
+
+      for(uint32_t y = 0; y < sliceHeight; y++)
+      {
+        for(uint32_t x = 0; x < sliceWidth; x++)
+        {
+          uint32_t *srcpix = (uint32_t *)&subdata[i][(y * sliceWidth + x) * 4 + 0];
+          uint32_t *dstpix = (uint32_t *)&combinedData[((y + yoffs) * td.width + x + xoffs) * 4 + 0];
+
+          *dstpix = *srcpix;
+        }
+      }
+
+      delete[] subdata[i];
+    }
+
+    subdata.resize(1);
+    subdata[0] = combinedData;
+    rowPitch = td.width * 4;
+  }
+
+  int numComps = td.format.compCount;
+
+  // if we want a grayscale image of one channel, splat it across all channels
+  // and set alpha to full
+  if(sd.channelExtract >= 0 && td.format.compByteWidth == 1 &&
+     (uint32_t)sd.channelExtract < td.format.compCount)
+  {
+    uint32_t cc = td.format.compCount;
+
+    for(uint32_t y = 0; y < td.height; y++)
+    {
+      for(uint32_t x = 0; x < td.width; x++)
+      {
+        subdata[0][(y * td.width + x) * cc + 0] =
+            subdata[0][(y * td.width + x) * cc + sd.channelExtract];
+        if(cc >= 2)
+          subdata[0][(y * td.width + x) * cc + 1] =
+              subdata[0][(y * td.width + x) * cc + sd.channelExtract];
+        if(cc >= 3)
+          subdata[0][(y * td.width + x) * cc + 2] =
+              subdata[0][(y * td.width + x) * cc + sd.channelExtract];
+        if(cc >= 4)
+          subdata[0][(y * td.width + x) * cc + 3] = 255;
+      }
+    }
+  }
+
+  // handle formats that don't support alpha
+  if(numComps == 4 && (sd.destType == FileType::BMP || sd.destType == FileType::JPG))
+  {
+    byte *nonalpha = new byte[td.width * td.height * 3];
+
+    for(uint32_t y = 0; y < td.height; y++)
+    {
+      for(uint32_t x = 0; x < td.width; x++)
+      {
+        byte r = subdata[0][(y * td.width + x) * 4 + 0];
+        byte g = subdata[0][(y * td.width + x) * 4 + 1];
+        byte b = subdata[0][(y * td.width + x) * 4 + 2];
+        byte a = subdata[0][(y * td.width + x) * 4 + 3];
+
+        if(sd.alpha != AlphaMapping::Discard)
+        {
+          FloatVector col = sd.alphaCol;
+          if(sd.alpha == AlphaMapping::BlendToCheckerboard)
+          {
+            bool lightSquare = ((x / 64) % 2) == ((y / 64) % 2);
+            col = lightSquare ? sd.alphaCol : sd.alphaColSecondary;
+          }
+
+          col.x = powf(col.x, 1.0f / 2.2f);
+          col.y = powf(col.y, 1.0f / 2.2f);
+          col.z = powf(col.z, 1.0f / 2.2f);
+
+          FloatVector pixel = FloatVector(float(r) / 255.0f, float(g) / 255.0f, float(b) / 255.0f,
+                                          float(a) / 255.0f);
+
+          pixel.x = pixel.x * pixel.w + col.x * (1.0f - pixel.w);
+          pixel.y = pixel.y * pixel.w + col.y * (1.0f - pixel.w);
+          pixel.z = pixel.z * pixel.w + col.z * (1.0f - pixel.w);
+
+          r = byte(pixel.x * 255.0f);
+          g = byte(pixel.y * 255.0f);
+          b = byte(pixel.z * 255.0f);
+        }
+
+        nonalpha[(y * td.width + x) * 3 + 0] = r;
+        nonalpha[(y * td.width + x) * 3 + 1] = g;
+        nonalpha[(y * td.width + x) * 3 + 2] = b;
+      }
+    }
+
+    delete[] subdata[0];
+
+    subdata[0] = nonalpha;
+
+    numComps = 3;
+    rowPitch = td.width * 3;
+  }
+
+  // assume that (R,G,0) is better mapping than (Y,A) for 2 component data
+  if(numComps == 2 && (sd.destType == FileType::BMP || sd.destType == FileType::JPG ||
+                       sd.destType == FileType::PNG || sd.destType == FileType::TGA))
+  {
+    byte *rg0 = new byte[td.width * td.height * 3];
+
+    for(uint32_t y = 0; y < td.height; y++)
+    {
+      for(uint32_t x = 0; x < td.width; x++)
+      {
+        byte r = subdata[0][(y * td.width + x) * 2 + 0];
+        byte g = subdata[0][(y * td.width + x) * 2 + 1];
+
+        rg0[(y * td.width + x) * 3 + 0] = r;
+        rg0[(y * td.width + x) * 3 + 1] = g;
+        rg0[(y * td.width + x) * 3 + 2] = 0;
+
+        // if we're greyscaling the image, then keep the greyscale here.
+        if(sd.channelExtract >= 0)
+          rg0[(y * td.width + x) * 3 + 2] = r;
+      }
+    }
+
+    delete[] subdata[0];
+
+    subdata[0] = rg0;
+
+    numComps = 3;
+    rowPitch = td.width * 3;
+  }
+
+  FILE *f = FileIO::fopen(job.path.c_str(), "wb");
+
+  if(!f)
+  {
+    success = false;
+  }
+  else
+  {
+    if(sd.destType == FileType::DDS)
+    {
+      dds_data ddsData;
+
+      ddsData.width = td.width;
+      ddsData.height = td.height;
+      ddsData.depth = td.depth;
+      ddsData.format = td.format;
+      ddsData.mips = numMips;
+      ddsData.slices = numSlices / td.depth;
+      ddsData.subdata = &subdata[0];
+      ddsData.cubemap = td.cubemap && numSlices == 6;
+
+      success = write_dds_to_file(f, ddsData);
+    }
+    else if(sd.destType == FileType::BMP)
+    {
+      int ret = stbi_write_bmp_to_func(fileWriteFunc, (void *)f, td.width, td.height, numComps,
+                                       subdata[0]);
+      success = (ret != 0);
+    }
+    else if(sd.destType == FileType::PNG)
+    {
+      // discard alpha if requested
+      for(uint32_t p = 0; sd.alpha == AlphaMapping::Discard && p < td.width * td.height; p++)
+        subdata[0][p * 4 + 3] = 255;
+
+      int ret = stbi_write_png_to_func(fileWriteFunc, (void *)f, td.width, td.height, numComps,
+                                       subdata[0], rowPitch);
+      success = (ret != 0);
+    }
+    else if(sd.destType == FileType::TGA)
+    {
+      // discard alpha if requested
+      for(uint32_t p = 0; sd.alpha == AlphaMapping::Discard && p < td.width * td.height; p++)
+        subdata[0][p * 4 + 3] = 255;
+
+      int ret = stbi_write_tga_to_func(fileWriteFunc, (void *)f, td.width, td.height, numComps,
+                                       subdata[0]);
+      success = (ret != 0);
+    }
+    else if(sd.destType == FileType::JPG)
+    {
+      jpge::params p;
+      p.m_quality = sd.jpegQuality;
+
+      int len = td.width * td.height * td.format.compCount;
+      // ensure buffer is at least 1024
+      if(len < 1024)
+        len = 1024;
+
+      char *jpgdst = new char[len];
+
+      success = jpge::compress_image_to_jpeg_file_in_memory(jpgdst, len, td.width, td.height,
+                                                            numComps, subdata[0], p);
+
+      if(success)
+        fwrite(jpgdst, 1, len, f);
+
+      delete[] jpgdst;
+    }
+    else if(sd.destType == FileType::HDR || sd.destType == FileType::EXR)
+    {
+      float *fldata = NULL;
+      float *abgr[4] = {NULL, NULL, NULL, NULL};
+
+      if(sd.destType == FileType::HDR)
+      {
+        fldata = new float[td.width * td.height * 4];
+      }
+      else
+      {
+        abgr[0] = new float[td.width * td.height];
+        abgr[1] = new float[td.width * td.height];
+        abgr[2] = new float[td.width * td.height];
+        abgr[3] = new float[td.width * td.height];
+      }
+
+      byte *srcData = subdata[0];
+
+      ResourceFormat saveFmt = td.format;
+      if(saveFmt.compType == CompType::Typeless)
+        saveFmt.compType = sd.typeHint;
+      if(saveFmt.compType == CompType::Typeless)
+        saveFmt.compType = saveFmt.compByteWidth == 4 ? CompType::Float : CompType::UNorm;
+
+      uint32_t pixStride = saveFmt.compCount * saveFmt.compByteWidth;
+
+      // 24-bit depth still has a stride of 4 bytes.
+      if(saveFmt.compType == CompType::Depth && pixStride == 3)
+        pixStride = 4;
+
+      // regular formats are converted a row at a time
+      bool rowConvert = !saveFmt.special && pixStride == saveFmt.compCount * saveFmt.compByteWidth;
+      std::vector<float> rowComps(rowConvert ? td.width * saveFmt.compCount : 0);
+
+      for(uint32_t y = 0; y < td.height; y++)
+      {
+        if(rowConvert)
+        {
+          ConvertComponents(saveFmt, srcData, rowComps.size(), rowComps.data());
+          srcData += td.width * pixStride;
+        }
+
+        for(uint32_t x = 0; x < td.width; x++)
+        {
+          float r = 0.0f;
+          float g = 0.0f;
+          float b = 0.0f;
+          float a = 1.0f;
+
+          if(saveFmt.special && saveFmt.specialFormat == SpecialFormat::R10G10B10A2)
+          {
+            uint32_t *u32 = (uint32_t *)srcData;
+
+            Vec4f vec = ConvertFromR10G10B10A2(*u32);
+
+            r = vec.x;
+            g = vec.y;
+            b = vec.z;
+            a = vec.w;
+
+            srcData += 4;
+          }
+          else if(saveFmt.special && saveFmt.specialFormat == SpecialFormat::R11G11B10)
+          {
+            uint32_t *u32 = (uint32_t *)srcData;
+
+            Vec3f vec = ConvertFromR11G11B10(*u32);
+
+            r = vec.x;
+            g = vec.y;
+            b = vec.z;
+            a = 1.0f;
+
+            srcData += 4;
+          }
+          else if(rowConvert)
+          {
+            const float *comps = &rowComps[x * saveFmt.compCount];
+
+            if(saveFmt.compCount >= 1)
+              r = comps[0];
+            if(saveFmt.compCount >= 2)
+              g = comps[1];
+            if(saveFmt.compCount >= 3)
+              b = comps[2];
+            if(saveFmt.compCount >= 4)
+              a = comps[3];
+          }
+          else
+          {
+            if(saveFmt.compCount >= 1)
+              r = ConvertComponent(saveFmt, srcData + saveFmt.compByteWidth * 0);
+            if(saveFmt.compCount >= 2)
+              g = ConvertComponent(saveFmt, srcData + saveFmt.compByteWidth * 1);
+            if(saveFmt.compCount >= 3)
+              b = ConvertComponent(saveFmt, srcData + saveFmt.compByteWidth * 2);
+            if(saveFmt.compCount >= 4)
+              a = ConvertComponent(saveFmt, srcData + saveFmt.compByteWidth * 3);
+
+            srcData += pixStride;
+          }
+
+          if(saveFmt.bgraOrder)
+            std::swap(r, b);
+
+          // HDR can't represent negative values
+          if(sd.destType == FileType::HDR)
+          {
+            r = RDCMAX(r, 0.0f);
+            g = RDCMAX(g, 0.0f);
+            b = RDCMAX(b, 0.0f);
+            a = RDCMAX(a, 0.0f);
+          }
+
+          if(sd.channelExtract == 0)
+          {
+            g = b = r;
+            a = 1.0f;
+          }
+          if(sd.channelExtract == 1)
+          {
+            r = b = g;
+            a = 1.0f;
+          }
+          if(sd.channelExtract == 2)
+          {
+            r = g = b;
+            a = 1.0f;
+          }
+          if(sd.channelExtract == 3)
+          {
+            r = g = b = a;
+            a = 1.0f;
+          }
+
+          if(fldata)
+          {
+            fldata[(y * td.width + x) * 4 + 0] = r;
+            fldata[(y * td.width + x) * 4 + 1] = g;
+            fldata[(y * td.width + x) * 4 + 2] = b;
+            fldata[(y * td.width + x) * 4 + 3] = a;
+          }
+          else
+          {
+            abgr[0][(y * td.width + x)] = a;
+            abgr[1][(y * td.width + x)] = b;
+            abgr[2][(y * td.width + x)] = g;
+            abgr[3][(y * td.width + x)] = r;
+          }
+        }
+      }
+
+      if(sd.destType == FileType::HDR)
+      {
+        int ret = stbi_write_hdr_to_func(fileWriteFunc, (void *)f, td.width, td.height, 4, fldata);
+        success = (ret != 0);
+      }
+      else if(sd.destType == FileType::EXR)
+      {
+        const char *err = NULL;
+
+        EXRImage exrImage;
+        InitEXRImage(&exrImage);
+
+        int pixTypes[4] = {TINYEXR_PIXELTYPE_FLOAT, TINYEXR_PIXELTYPE_FLOAT,
+                           TINYEXR_PIXELTYPE_FLOAT, TINYEXR_PIXELTYPE_FLOAT};
+        int reqTypes[4] = {TINYEXR_PIXELTYPE_HALF, TINYEXR_PIXELTYPE_HALF, TINYEXR_PIXELTYPE_HALF,
+                           TINYEXR_PIXELTYPE_HALF};
+
+        // must be in this order as many viewers don't pay attention to channels and just assume
+        // they are in this order
+        const char *bgraNames[4] = {"A", "B", "G", "R"};
+
+        exrImage.num_channels = 4;
+        exrImage.channel_names = bgraNames;
+        exrImage.images = (unsigned char **)abgr;
+        exrImage.width = td.width;
+        exrImage.height = td.height;
+        exrImage.pixel_types = pixTypes;
+        exrImage.requested_pixel_types = reqTypes;
+
+        unsigned char *mem = NULL;
+
+        size_t ret = SaveMultiChannelEXRToMemory(&exrImage, &mem, &err);
+
+        success = (ret > 0);
+        if(success)
+          FileIO::fwrite(mem, 1, ret, f);
+        else
+          RDCERR("Error saving EXR file %d: '%s'", ret, err);
+
+        free(mem);
+      }
+
+      if(fldata)
+      {
+        delete[] fldata;
+      }
+      else
+      {
+        delete[] abgr[0];
+        delete[] abgr[1];
+        delete[] abgr[2];
+        delete[] abgr[3];
+      }
+    }
+
+    FileIO::fclose(f);
+  }
+
+  for(size_t i = 0; i < subdata.size(); i++)
+    delete[] subdata[i];
+  subdata.clear();
+
+  return success;
+}
+
+bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path)
+{
+  SCOPED_PROFILE("ReplayController::SaveTexture");
+
+  TextureSaveJob job;
+  job.path = path;
+
+  if(!FetchTextureSave(saveData, job))
+    return false;
+
+  return EncodeTextureSave(job);
+}
+
+// textures that have been fetched for a batch save and are waiting to be encoded
+struct TextureSaveBatch
+{
+  Threading::CriticalSection lock;
+  std::deque<TextureSaveJob *> pending;
+
+  // set once every texture has been fetched, so idle encoders can exit
+  volatile int32_t fetchDone = 0;
+  volatile int32_t failures = 0;
+};
+
+static void TextureSaveWorker(void *param)
+{
+  TextureSaveBatch *batch = (TextureSaveBatch *)param;
+
+  for(;;)
+  {
+    TextureSaveJob *job = NULL;
+
+    {
+      SCOPED_LOCK(batch->lock);
+      if(!batch->pending.empty())
+      {
+        job = batch->pending.front();
+        batch->pending.pop_front();
+      }
+    }
+
+    if(job == NULL)
+    {
+      if(Atomic::CmpExch32(&batch->fetchDone, 1, 1) == 1)
+      {
+        // check once more, in case a job was queued just before the flag was set
+        SCOPED_LOCK(batch->lock);
+        if(batch->pending.empty())
+          break;
+        continue;
+      }
+
+      Threading::Sleep(1);
+      continue;
+    }
+
+    if(!EncodeTextureSave(*job))
+    {
+      RDCERR("Failed to save texture to '%s'", job->path.c_str());
+      Atomic::Inc32(&batch->failures);
+    }
+
+    delete job;
+  }
+}
+
+bool ReplayController::SaveTextures(const rdctype::array<TextureSave> &saveData,
+                                    const rdctype::array<rdctype::str> &paths)
+{
+  SCOPED_PROFILE("ReplayController::SaveTextures");
+
+  if(saveData.count != paths.count)
+  {
+    RDCERR("Mismatched texture save count %d and path count %d", saveData.count, paths.count);
+    return false;
+  }
+
+  if(saveData.count == 0)
+    return true;
+
+  // readback has to happen here on the replay thread, but encoding doesn't touch the device. So
+  // while the next texture is read back, the ones already fetched are encoded on the other cores.
+  uint32_t numEncoders = RDCMAX(1U, Threading::GetCPUCount() - 1);
+  numEncoders = RDCMIN(numEncoders, (uint32_t)saveData.count);
+
+  // bound how far readback can get ahead, to cap the memory held by fetched textures
+  size_t maxPending = numEncoders * 2;
+
+  TextureSaveBatch batch;
+
+  std::vector<Threading::ThreadHandle> threads;
+  for(uint32_t i = 0; i < numEncoders; i++)
+  {
+    Threading::ThreadHandle t = Threading::CreateThread(&TextureSaveWorker, &batch);
+    if(t)
+      threads.push_back(t);
+  }
+
+  for(int32_t i = 0; i < saveData.count; i++)
+  {
+    TextureSaveJob *job = new TextureSaveJob;
+    job->path = paths[i].elems;
+
+    if(!FetchTextureSave(saveData[i], *job))
+    {
+      RDCERR("Failed to read back texture for '%s'", job->path.c_str());
+      Atomic::Inc32(&batch.failures);
+      delete job;
+      continue;
+    }
+
+    // if no encoder threads could be created, encode inline
+    if(threads.empty())
+    {
+      if(!EncodeTextureSave(*job))
+        Atomic::Inc32(&batch.failures);
+      delete job;
+      continue;
+    }
+
+    for(;;)
+    {
+      {
+        SCOPED_LOCK(batch.lock);
+        if(batch.pending.size() < maxPending)
+        {
+          batch.pending.push_back(job);
+          break;
+        }
+      }
+
+      Threading::Sleep(1);
+    }
+  }
+
+  Atomic::Inc32(&batch.fetchDone);
+
+  for(size_t i = 0; i < threads.size(); i++)
+  {
+    Threading::JoinThread(threads[i]);
+    Threading::CloseThread(threads[i]);
+  }
+
+  return batch.failures == 0;
+}
+
+
+// whether a usage could change the resource's contents
+static bool IsWriteUsage(ResourceUsage usage)
+{
+  switch(usage)
+  {
+    case ResourceUsage::VertexBuffer:
+    case ResourceUsage::IndexBuffer:
+    case ResourceUsage::VS_Constants:
+    case ResourceUsage::HS_Constants:
+    case ResourceUsage::DS_Constants:
+    case ResourceUsage::GS_Constants:
+    case ResourceUsage::PS_Constants:
+    case ResourceUsage::CS_Constants:
+    case ResourceUsage::All_Constants:
+    case ResourceUsage::VS_Resource:
+    case ResourceUsage::HS_Resource:
+    case ResourceUsage::DS_Resource:
+    case ResourceUsage::GS_Resource:
+    case ResourceUsage::PS_Resource:
+    case ResourceUsage::CS_Resource:
+    case ResourceUsage::All_Resource:
+    case ResourceUsage::InputTarget:
+    case ResourceUsage::CopySrc:
+    case ResourceUsage::ResolveSrc:
+    case ResourceUsage::Barrier:
+    case ResourceUsage::Indirect: return false;
+
+    case ResourceUsage::Unused:
+    case ResourceUsage::StreamOut:
+    case ResourceUsage::VS_RWResource:
+    case ResourceUsage::HS_RWResource:
+    case ResourceUsage::DS_RWResource:
+    case ResourceUsage::GS_RWResource:
+    case ResourceUsage::PS_RWResource:
+    case ResourceUsage::CS_RWResource:
+    case ResourceUsage::All_RWResource:
+    case ResourceUsage::ColorTarget:
+    case ResourceUsage::DepthStencilTarget:
+    case ResourceUsage::Clear:
+    case ResourceUsage::Copy:
+    case ResourceUsage::CopyDst:
+    case ResourceUsage::Resolve:
+    case ResourceUsage::ResolveDst:
+    case ResourceUsage::GenMips: return true;
+  }
+
+  return true;
+}
+
+vector<EventUsage> ReplayController::GetPixelHistoryEvents(ResourceId target)
+{
+  auto usage = m_pDevice->GetUsage(m_pDevice->GetLiveID(target));
+
+  vector<EventUsage> events;
+
+  for(size_t i = 0; i < usage.size(); i++)
+  {
+    if(usage[i].eventID > m_EventID)
+      continue;
+
+    // read-only events aren't valid pixel history events
+    if(!IsWriteUsage(usage[i].usage))
+      continue;
+
+    events.push_back(usage[i]);
+  }
+
+  return events;
+}
+
+bool ReplayController::TextureWrittenBetween(ResourceId texid, uint32_t from, uint32_t to)
+{
+  auto writesit = m_TextureWrites.find(texid);
+
+  if(writesit == m_TextureWrites.end())
+  {
+    vector<EventUsage> usage = m_pDevice->GetUsage(texid);
+
+    vector<uint32_t> &writes = m_TextureWrites[texid];
+
+    for(size_t i = 0; i < usage.size(); i++)
+      if(IsWriteUsage(usage[i].usage))
+        writes.push_back(usage[i].eventID);
+
+    std::sort(writes.begin(), writes.end());
+
+    writesit = m_TextureWrites.find(texid);
+  }
+
+  if(from > to)
+    std::swap(from, to);
+
+  const vector<uint32_t> &writes = writesit->second;
+  auto w = std::upper_bound(writes.begin(), writes.end(), from);
+
+  return w != writes.end() && *w <= to;
+}
+
+// a resource that may be transient, along with what it could be aliased with
+struct TransientCandidate
+{
+  TransientResource res;
+  std::string memoryType;
+};
+
+static bool GetTransientCandidate(vector<EventUsage> usage, TransientResource &res)
+{
+  std::sort(usage.begin(), usage.end());
+
+  bool first = true;
+  bool anyRead = false;
+
+  for(const EventUsage &u : usage)
+  {
+    if(u.usage == ResourceUsage::Unused || u.usage == ResourceUsage::Barrier)
+      continue;
+
+    // if the first thing the frame does is read the resource, its contents come from before the
+    // frame and must persist
+    if(first)
     {
-      // discard alpha if requested
-      for(uint32_t p = 0; sd.alpha == AlphaMapping::Discard && p < td.width * td.height; p++)
-        subdata[0][p * 4 + 3] = 255;
+      if(!IsWriteUsage(u.usage))
+        return false;
 
-      int ret = stbi_write_tga_to_func(fileWriteFunc, (void *)f, td.width, td.height, numComps,
-                                       subdata[0]);
-      success = (ret != 0);
+      res.firstWrite = u.eventID;
+      first = false;
     }
-    else if(sd.destType == FileType::JPG)
+
+    if(IsReadUsage(u.usage) && u.eventID > res.firstWrite)
     {
-      jpge::params p;
-      p.m_quality = sd.jpegQuality;
+      res.lastRead = u.eventID;
+      anyRead = true;
+    }
+  }
 
-      int len = td.width * td.height * td.format.compCount;
-      // ensure buffer is at least 1024
-      if(len < 1024)
-        len = 1024;
+  return anyRead;
+}
 
-      char *jpgdst = new char[len];
+static bool LargestTransientFirst(const TransientCandidate &a, const TransientCandidate &b)
+{
+  if(a.res.bytes != b.res.bytes)
+    return a.res.bytes > b.res.bytes;
+  return a.res.ID < b.res.ID;
+}
 
-      success = jpge::compress_image_to_jpeg_file_in_memory(jpgdst, len, td.width, td.height,
-                                                            numComps, subdata[0], p);
+static bool EarliestTransientFirst(const TransientResource &a, const TransientResource &b)
+{
+  if(a.firstWrite != b.firstWrite)
+    return a.firstWrite < b.firstWrite;
+  return a.ID < b.ID;
+}
 
-      if(success)
-        fwrite(jpgdst, 1, len, f);
+static bool LargestSavingFirst(const AliasGroup &a, const AliasGroup &b)
+{
+  if(a.savedBytes != b.savedBytes)
+    return a.savedBytes > b.savedBytes;
+  return a.bytes > b.bytes;
+}
 
-      delete[] jpgdst;
-    }
-    else if(sd.destType == FileType::HDR || sd.destType == FileType::EXR)
+rdctype::array<AliasGroup> ReplayController::GetTransientAliasing()
+{
+  SCOPED_PROFILE("ReplayController::GetTransientAliasing");
+
+  // make sure the descriptions are cached
+  GetTextures();
+  GetBuffers();
+
+  vector<TransientCandidate> transients;
+
+  for(const TextureDescription &tex : m_Textures)
+  {
+    if(tex.creationFlags & TextureCategory::SwapBuffer)
+      continue;
+
+    if(!(tex.creationFlags &
+         (TextureCategory::ColorTarget | TextureCategory::DepthTarget |
+          TextureCategory::ShaderReadWrite)))
+      continue;
+
+    TransientCandidate t;
+    t.res.ID = tex.ID;
+    t.res.name = tex.name;
+    t.res.texture = true;
+    t.res.bytes = tex.allocationSize ? tex.allocationSize : tex.byteSize;
+    t.memoryType = tex.memoryType.c_str();
+
+    if(GetTransientCandidate(m_pDevice->GetUsage(m_pDevice->GetLiveID(tex.ID)), t.res))
+      transients.push_back(t);
+  }
+
+  for(const BufferDescription &buf : m_Buffers)
+  {
+    if(!(buf.creationFlags & BufferCategory::ReadWrite))
+      continue;
+
+    TransientCandidate t;
+    t.res.ID = buf.ID;
+    t.res.name = buf.name;
+    t.res.texture = false;
+    t.res.bytes = buf.allocationSize ? buf.allocationSize : buf.length;
+    t.memoryType = buf.memoryType.c_str();
+
+    if(GetTransientCandidate(m_pDevice->GetUsage(m_pDevice->GetLiveID(buf.ID)), t.res))
+      transients.push_back(t);
+  }
+
+  // first-fit decreasing: place each resource, largest first, in the first group of the same memory
+  // type where it doesn't overlap anything already there. Each group's allocation is then the size
+  // of the first resource placed in it.
+  std::sort(transients.begin(), transients.end(), LargestTransientFirst);
+
+  struct PackedGroup
+  {
+    std::string memoryType;
+    uint64_t bytes, savedBytes;
+    vector<TransientResource> resources;
+  };
+
+  vector<PackedGroup> groups;
+
+  for(const TransientCandidate &t : transients)
+  {
+    PackedGroup *dest = NULL;
+
+    for(PackedGroup &group : groups)
     {
-      float *fldata = NULL;
-      float *abgr[4] = {NULL, NULL, NULL, NULL};
+      if(group.memoryType != t.memoryType)
+        continue;
 
-      if(sd.destType == FileType::HDR)
+      bool overlaps = false;
+      for(const TransientResource &r : group.resources)
       {
-        fldata = new float[td.width * td.height * 4];
+        if(t.res.firstWrite <= r.lastRead && r.firstWrite <= t.res.lastRead)
+        {
+          overlaps = true;
+          break;
+        }
       }
-      else
+
+      if(!overlaps)
       {
-        abgr[0] = new float[td.width * td.height];
-        abgr[1] = new float[td.width * td.height];
-        abgr[2] = new float[td.width * td.height];
-        abgr[3] = new float[td.width * td.height];
+        dest = &group;
+        break;
       }
+    }
 
-      byte *srcData = subdata[0];
+    if(dest == NULL)
+    {
+      groups.push_back(PackedGroup());
+      dest = &groups.back();
+      dest->memoryType = t.memoryType;
+      dest->bytes = t.res.bytes;
+      dest->savedBytes = 0;
+    }
+    else
+    {
+      dest->savedBytes += t.res.bytes;
+    }
 
-      ResourceFormat saveFmt = td.format;
-      if(saveFmt.compType == CompType::Typeless)
-        saveFmt.compType = sd.typeHint;
-      if(saveFmt.compType == CompType::Typeless)
-        saveFmt.compType = saveFmt.compByteWidth == 4 ? CompType::Float : CompType::UNorm;
+    dest->resources.push_back(t.res);
+  }
 
-      uint32_t pixStride = saveFmt.compCount * saveFmt.compByteWidth;
+  vector<AliasGroup> ret;
+  ret.resize(groups.size());
 
-      // 24-bit depth still has a stride of 4 bytes.
-      if(saveFmt.compType == CompType::Depth && pixStride == 3)
-        pixStride = 4;
+  for(size_t i = 0; i < groups.size(); i++)
+  {
+    std::sort(groups[i].resources.begin(), groups[i].resources.end(), EarliestTransientFirst);
 
-      for(uint32_t y = 0; y < td.height; y++)
+    ret[i].memoryType = groups[i].memoryType;
+    ret[i].bytes = groups[i].bytes;
+    ret[i].savedBytes = groups[i].savedBytes;
+    ret[i].resources = groups[i].resources;
+  }
+
+  std::sort(ret.begin(), ret.end(), LargestSavingFirst);
+
+  return ret;
+}
+
+void ReplayController::BuildEventDependencies()
+{
+  if(m_DependenciesBuilt)
+    return;
+
+  SCOPED_PROFILE("ReplayController::BuildEventDependencies");
+
+  m_DependenciesBuilt = true;
+
+  // make sure the descriptions are cached
+  GetTextures();
+  GetBuffers();
+
+  vector<ResourceId> ids;
+  for(const TextureDescription &tex : m_Textures)
+    ids.push_back(m_pDevice->GetLiveID(tex.ID));
+  for(const BufferDescription &buf : m_Buffers)
+    ids.push_back(m_pDevice->GetLiveID(buf.ID));
+
+  for(ResourceId id : ids)
+  {
+    vector<EventUsage> usage = m_pDevice->GetUsage(id);
+
+    vector<uint32_t> writes;
+
+    for(const EventUsage &u : usage)
+    {
+      if(u.usage == ResourceUsage::Barrier)
+        continue;
+
+      EventResources &ev = m_EventResources[u.eventID];
+
+      if(ev.used.empty() || ev.used.back() != id)
+        ev.used.push_back(id);
+
+      ev.usage.push_back(std::make_pair(id, u.usage));
+
+      if(IsWriteUsage(u.usage))
       {
-        for(uint32_t x = 0; x < td.width; x++)
-        {
-          float r = 0.0f;
-          float g = 0.0f;
-          float b = 0.0f;
-          float a = 1.0f;
+        ev.writes = true;
+        writes.push_back(u.eventID);
+      }
+    }
 
-          if(saveFmt.special && saveFmt.specialFormat == SpecialFormat::R10G10B10A2)
-          {
-            uint32_t *u32 = (uint32_t *)srcData;
+    if(!writes.empty())
+    {
+      std::sort(writes.begin(), writes.end());
+      writes.erase(std::unique(writes.begin(), writes.end()), writes.end());
+      m_ResourceWrites[id].swap(writes);
+    }
+  }
 
-            Vec4f vec = ConvertFromR10G10B10A2(*u32);
+  for(auto it = m_EventResources.begin(); it != m_EventResources.end(); ++it)
+  {
+    std::sort(it->second.used.begin(), it->second.used.end());
+    it->second.used.erase(std::unique(it->second.used.begin(), it->second.used.end()),
+                          it->second.used.end());
+
+    // a resource bound through several views is only counted once for each kind of use
+    std::sort(it->second.usage.begin(), it->second.usage.end());
+    it->second.usage.erase(std::unique(it->second.usage.begin(), it->second.usage.end()),
+                           it->second.usage.end());
+  }
+}
 
-            r = vec.x;
-            g = vec.y;
-            b = vec.z;
-            a = vec.w;
+vector<uint32_t> ReplayController::GetPrunableEvents(ResourceId target, uint32_t eventID)
+{
+  BuildEventDependencies();
 
-            srcData += 4;
-          }
-          else if(saveFmt.special && saveFmt.specialFormat == SpecialFormat::R11G11B10)
-          {
-            uint32_t *u32 = (uint32_t *)srcData;
+  // walk back from the target through the events that wrote to it, then the events that wrote to
+  // anything those events used, and so on. Any write can be partial and any use can depend on
+  // the previous contents, so a needed event depends on every earlier write to everything it used.
+  //
+  // For each resource reached this tracks the last event whose writes to it are needed, so each
+  // write is only followed once.
+  ResourceIdMap<uint32_t> neededUntil;
+  std::set<uint32_t> neededEvents;
+  vector<std::pair<ResourceId, uint32_t> > work;
 
-            Vec3f vec = ConvertFromR11G11B10(*u32);
+  work.push_back(std::make_pair(target, eventID));
 
-            r = vec.x;
-            g = vec.y;
-            b = vec.z;
-            a = 1.0f;
+  while(!work.empty())
+  {
+    ResourceId id = work.back().first;
+    uint32_t until = work.back().second;
+    work.pop_back();
 
-            srcData += 4;
-          }
-          else
-          {
-            if(saveFmt.compCount >= 1)
-              r = ConvertComponent(saveFmt, srcData + saveFmt.compByteWidth * 0);
-            if(saveFmt.compCount >= 2)
-              g = ConvertComponent(saveFmt, srcData + saveFmt.compByteWidth * 1);
-            if(saveFmt.compCount >= 3)
-              b = ConvertComponent(saveFmt, srcData + saveFmt.compByteWidth * 2);
-            if(saveFmt.compCount >= 4)
-              a = ConvertComponent(saveFmt, srcData + saveFmt.compByteWidth * 3);
+    uint32_t from = 0;
 
-            srcData += pixStride;
-          }
+    auto it = neededUntil.find(id);
+    if(it != neededUntil.end())
+    {
+      if(it->second >= until)
+        continue;
 
-          if(saveFmt.bgraOrder)
-            std::swap(r, b);
+      from = it->second;
+      it->second = until;
+    }
+    else
+    {
+      neededUntil[id] = until;
+    }
 
-          // HDR can't represent negative values
-          if(sd.destType == FileType::HDR)
-          {
-            r = RDCMAX(r, 0.0f);
-            g = RDCMAX(g, 0.0f);
-            b = RDCMAX(b, 0.0f);
-            a = RDCMAX(a, 0.0f);
-          }
+    auto writes = m_ResourceWrites.find(id);
+    if(writes == m_ResourceWrites.end())
+      continue;
 
-          if(sd.channelExtract == 0)
-          {
-            g = b = r;
-            a = 1.0f;
-          }
-          if(sd.channelExtract == 1)
-          {
-            r = b = g;
-            a = 1.0f;
-          }
-          if(sd.channelExtract == 2)
-          {
-            r = g = b;
-            a = 1.0f;
-          }
-          if(sd.channelExtract == 3)
-          {
-            r = g = b = a;
-            a = 1.0f;
-          }
+    for(auto w = std::upper_bound(writes->second.begin(), writes->second.end(), from);
+        w != writes->second.end() && *w <= until; ++w)
+    {
+      if(!neededEvents.insert(*w).second)
+        continue;
+
+      for(ResourceId used : m_EventResources[*w].used)
+        work.push_back(std::make_pair(used, *w - 1));
+    }
+  }
+
+  // only drawcalls with known outputs can be skipped. Anything that writes nowhere we know about
+  // is kept in case it writes somewhere that matters.
+  vector<uint32_t> ret;
+
+  for(uint32_t e = 1; e < eventID && e < m_Drawcalls.size(); e++)
+  {
+    const DrawcallDescription *draw = m_Drawcalls[e];
+
+    if(draw == NULL || draw->eventID != e ||
+       !(draw->flags & (DrawFlags::Drawcall | DrawFlags::Dispatch | DrawFlags::Clear |
+                        DrawFlags::Copy | DrawFlags::Resolve | DrawFlags::GenMips)))
+      continue;
+
+    auto ev = m_EventResources.find(e);
+    if(ev == m_EventResources.end() || !ev->second.writes)
+      continue;
+
+    if(neededEvents.find(e) == neededEvents.end())
+      ret.push_back(e);
+  }
+
+  return ret;
+}
+
+void ReplayController::ReplayForTarget(ResourceId target, uint32_t eventID)
+{
+  // working out what to skip needs the usage of every resource, which isn't worth fetching from a
+  // remote replay that can't skip anything
+  if(m_pDevice->IsRemoteProxy())
+  {
+    m_pDevice->ReplayLog(eventID, eReplay_Full);
+    return;
+  }
 
-          if(fldata)
-          {
-            fldata[(y * td.width + x) * 4 + 0] = r;
-            fldata[(y * td.width + x) * 4 + 1] = g;
-            fldata[(y * td.width + x) * 4 + 2] = b;
-            fldata[(y * td.width + x) * 4 + 3] = a;
-          }
-          else
-          {
-            abgr[0][(y * td.width + x)] = a;
-            abgr[1][(y * td.width + x)] = b;
-            abgr[2][(y * td.width + x)] = g;
-            abgr[3][(y * td.width + x)] = r;
-          }
-        }
-      }
+  vector<uint32_t> pruned = GetPrunableEvents(target, eventID);
 
-      if(sd.destType == FileType::HDR)
-      {
-        int ret = stbi_write_hdr_to_func(fileWriteFunc, (void *)f, td.width, td.height, 4, fldata);
-        success = (ret != 0);
-      }
-      else if(sd.destType == FileType::EXR)
-      {
-        const char *err = NULL;
+  RDCDEBUG("Replaying to %u for %llu, skipping %u drawcalls", eventID, target,
+           (uint32_t)pruned.size());
 
-        EXRImage exrImage;
-        InitEXRImage(&exrImage);
+  m_pDevice->SetPrunedEvents(pruned);
+  m_pDevice->ReplayLog(eventID, eReplay_Full);
+  m_pDevice->SetPrunedEvents(vector<uint32_t>());
+}
 
-        int pixTypes[4] = {TINYEXR_PIXELTYPE_FLOAT, TINYEXR_PIXELTYPE_FLOAT,
-                           TINYEXR_PIXELTYPE_FLOAT, TINYEXR_PIXELTYPE_FLOAT};
-        int reqTypes[4] = {TINYEXR_PIXELTYPE_HALF, TINYEXR_PIXELTYPE_HALF, TINYEXR_PIXELTYPE_HALF,
-                           TINYEXR_PIXELTYPE_HALF};
+TextureStats &ReplayController::GetTextureStats(const TextureStatsKey &key, uint32_t eventID)
+{
+  auto it = m_TextureStats.find(key);
 
-        // must be in this order as many viewers don't pay attention to channels and just assume
-        // they are in this order
-        const char *bgraNames[4] = {"A", "B", "G", "R"};
+  // the results are still valid if nothing wrote to the texture between the event they were
+  // calculated at and this one.
+  if(it != m_TextureStats.end() && !TextureWrittenBetween(key.texid, eventID, it->second.eventID))
+    return it->second;
 
-        exrImage.num_channels = 4;
-        exrImage.channel_names = bgraNames;
-        exrImage.images = (unsigned char **)abgr;
-        exrImage.width = td.width;
-        exrImage.height = td.height;
-        exrImage.pixel_types = pixTypes;
-        exrImage.requested_pixel_types = reqTypes;
+  TextureStats &stats = m_TextureStats[key];
+  stats = TextureStats();
+  stats.eventID = eventID;
+  return stats;
+}
 
-        unsigned char *mem = NULL;
+void ReplayController::UpdateThumbnails(const vector<ThumbnailKey> &keys, uint32_t eventID)
+{
+  vector<TextureThumbnailRequest> requests;
 
-        size_t ret = SaveMultiChannelEXRToMemory(&exrImage, &mem, &err);
+  for(const ThumbnailKey &key : keys)
+  {
+    auto it = m_ThumbnailCache.find(key);
 
-        success = (ret > 0);
-        if(success)
-          FileIO::fwrite(mem, 1, ret, f);
-        else
-          RDCERR("Error saving EXR file %d: '%s'", ret, err);
+    if(it != m_ThumbnailCache.end() && it->second.valid &&
+       !TextureWrittenBetween(key.texid, eventID, it->second.eventID))
+      continue;
 
-        free(mem);
-      }
+    TextureThumbnailRequest req = {key.texid, key.typeHint};
+    requests.push_back(req);
+  }
 
-      if(fldata)
-      {
-        delete[] fldata;
-      }
-      else
-      {
-        delete[] abgr[0];
-        delete[] abgr[1];
-        delete[] abgr[2];
-        delete[] abgr[3];
-      }
+  if(requests.empty())
+    return;
+
+  vector<TextureThumbnail> thumbs =
+      m_pDevice->GetTextureThumbnails(requests, ReplayOutput::ThumbnailSize);
+
+  for(size_t i = 0; i < requests.size() && i < thumbs.size(); i++)
+  {
+    ThumbnailKey key = {requests[i].texid, requests[i].typeHint};
+    CachedThumbnail &cache = m_ThumbnailCache[key];
+    const TextureThumbnail &thumb = thumbs[i];
+
+    cache.eventID = eventID;
+    cache.valid = false;
+
+    if(thumb.rgba.empty())
+      continue;
+
+    // the texture is only recreated if the thumbnail changes size, which is rare
+    if(cache.proxy == ResourceId() || cache.width != thumb.width || cache.height != thumb.height)
+    {
+      TextureDescription desc;
+      desc.dimension = 2;
+      desc.resType = TextureDim::Texture2D;
+      desc.width = thumb.width;
+      desc.height = thumb.height;
+      desc.depth = 1;
+      desc.arraysize = 1;
+      desc.mips = 1;
+      desc.msQual = 0;
+      desc.msSamp = 1;
+      desc.cubemap = false;
+      desc.customName = false;
+      desc.byteSize = thumb.rgba.size();
+      desc.allocationSize = 0;
+      desc.allocationAlignment = 0;
+      desc.placeholderInitialContents = false;
+      desc.format.special = false;
+      desc.format.compCount = 4;
+      desc.format.compByteWidth = 1;
+      desc.format.compType = CompType::UNorm;
+      desc.creationFlags = TextureCategory::ShaderRead;
+
+      cache.proxy = m_pDevice->CreateProxyTexture(desc);
+      cache.width = thumb.width;
+      cache.height = thumb.height;
+
+      if(cache.proxy == ResourceId())
+        continue;
     }
 
-    FileIO::fclose(f);
+    m_pDevice->SetProxyTextureData(cache.proxy, 0, 0, (byte *)&thumb.rgba[0], thumb.rgba.size());
+    cache.valid = true;
   }
+}
 
-  for(size_t i = 0; i < subdata.size(); i++)
-    delete[] subdata[i];
+ResourceId ReplayController::GetThumbnail(const ThumbnailKey &key, uint32_t eventID)
+{
+  auto it = m_ThumbnailCache.find(key);
 
-  return success;
+  if(it == m_ThumbnailCache.end() || !it->second.valid ||
+     TextureWrittenBetween(key.texid, eventID, it->second.eventID))
+    return ResourceId();
+
+  return it->second.proxy;
 }
 
 rdctype::array<PixelModification> ReplayController::PixelHistory(ResourceId target, uint32_t x,
@@ -1205,6 +4899,8 @@ rdctype::array<PixelModification> ReplayController::PixelHistory(ResourceId targ
                                                                  uint32_t mip, uint32_t sampleIdx,
                                                                  CompType typeHint)
 {
+  SCOPED_PROFILE("ReplayController::PixelHistory", m_EventID);
+
   rdctype::array<PixelModification> ret;
 
   for(size_t t = 0; t < m_Textures.size(); t++)
@@ -1228,73 +4924,102 @@ rdctype::array<PixelModification> ReplayController::PixelHistory(ResourceId targ
     }
   }
 
-  auto usage = m_pDevice->GetUsage(m_pDevice->GetLiveID(target));
+  vector<EventUsage> events = GetPixelHistoryEvents(target);
 
-  vector<EventUsage> events;
+  if(events.empty())
+  {
+    RDCDEBUG("Target %llu not written to before %u", target, m_EventID);
+    return ret;
+  }
 
-  for(size_t i = 0; i < usage.size(); i++)
   {
-    if(usage[i].eventID > m_EventID)
-      continue;
+    ScopedReplayCancel cancel(&m_CancelRequested);
 
-    switch(usage[i].usage)
-    {
-      case ResourceUsage::VertexBuffer:
-      case ResourceUsage::IndexBuffer:
-      case ResourceUsage::VS_Constants:
-      case ResourceUsage::HS_Constants:
-      case ResourceUsage::DS_Constants:
-      case ResourceUsage::GS_Constants:
-      case ResourceUsage::PS_Constants:
-      case ResourceUsage::CS_Constants:
-      case ResourceUsage::All_Constants:
-      case ResourceUsage::VS_Resource:
-      case ResourceUsage::HS_Resource:
-      case ResourceUsage::DS_Resource:
-      case ResourceUsage::GS_Resource:
-      case ResourceUsage::PS_Resource:
-      case ResourceUsage::CS_Resource:
-      case ResourceUsage::All_Resource:
-      case ResourceUsage::InputTarget:
-      case ResourceUsage::CopySrc:
-      case ResourceUsage::ResolveSrc:
-      case ResourceUsage::Barrier:
-      case ResourceUsage::Indirect:
-        // read-only, not a valid pixel history event
-        continue;
+    ret = m_pDevice->PixelHistory(events, m_pDevice->GetLiveID(target), x, y, slice, mip,
+                                  sampleIdx, typeHint);
+  }
 
-      case ResourceUsage::Unused:
-      case ResourceUsage::StreamOut:
-      case ResourceUsage::VS_RWResource:
-      case ResourceUsage::HS_RWResource:
-      case ResourceUsage::DS_RWResource:
-      case ResourceUsage::GS_RWResource:
-      case ResourceUsage::PS_RWResource:
-      case ResourceUsage::CS_RWResource:
-      case ResourceUsage::All_RWResource:
-      case ResourceUsage::ColorTarget:
-      case ResourceUsage::DepthStencilTarget:
-      case ResourceUsage::Clear:
-      case ResourceUsage::Copy:
-      case ResourceUsage::CopyDst:
-      case ResourceUsage::Resolve:
-      case ResourceUsage::ResolveDst:
-      case ResourceUsage::GenMips:
-        // writing - include in pixel history events
-        break;
+  // a cancelled history only covers some of the events, which would be misleading
+  if(m_CancelRequested)
+    ret = rdctype::array<PixelModification>();
+
+  SetFrameEvent(m_EventID, true);
+
+  return ret;
+}
+
+rdctype::array<PixelRegionHistory> ReplayController::PixelHistoryRegion(
+    ResourceId target, uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t slice,
+    uint32_t mip, uint32_t sampleIdx, CompType typeHint)
+{
+  rdctype::array<PixelRegionHistory> ret;
+
+  for(size_t t = 0; t < m_Textures.size(); t++)
+  {
+    if(m_Textures[t].ID == target)
+    {
+      if(x >= m_Textures[t].width || y >= m_Textures[t].height)
+      {
+        RDCDEBUG("PixelHistoryRegion out of bounds on %llu (%u,%u) vs (%u,%u)", target, x, y,
+                 m_Textures[t].width, m_Textures[t].height);
+        return ret;
+      }
+
+      width = RDCMIN(width, m_Textures[t].width - x);
+      height = RDCMIN(height, m_Textures[t].height - y);
+
+      if(m_Textures[t].msSamp == 1)
+        sampleIdx = ~0U;
+
+      slice = RDCCLAMP(slice, 0U, m_Textures[t].arraysize);
+      mip = RDCCLAMP(mip, 0U, m_Textures[t].mips);
+
+      break;
     }
+  }
 
-    events.push_back(usage[i]);
+  if(width == 0 || height == 0)
+    return ret;
+
+  vector<EventUsage> events = GetPixelHistoryEvents(target);
+
+  vector<PixelRegionHistory> region;
+  region.resize(width * height);
+
+  for(uint32_t py = 0; py < height; py++)
+  {
+    for(uint32_t px = 0; px < width; px++)
+    {
+      region[py * width + px].x = x + px;
+      region[py * width + px].y = y + py;
+    }
   }
 
   if(events.empty())
   {
     RDCDEBUG("Target %llu not written to before %u", target, m_EventID);
+    ret = region;
     return ret;
   }
 
-  ret = m_pDevice->PixelHistory(events, m_pDevice->GetLiveID(target), x, y, slice, mip, sampleIdx,
-                                typeHint);
+  // the driver shares the replays and readbacks across the whole region, and we only need to
+  // restore the current event once at the end rather than after every pixel.
+  vector<vector<PixelModification> > history;
+
+  {
+    ScopedReplayCancel cancel(&m_CancelRequested);
+
+    history = m_pDevice->PixelHistoryRegion(events, m_pDevice->GetLiveID(target), x, y, width,
+                                            height, slice, mip, sampleIdx, typeHint);
+  }
+
+  if(!m_CancelRequested)
+  {
+    for(size_t i = 0; i < region.size() && i < history.size(); i++)
+      region[i].modifications = history[i];
+  }
+
+  ret = region;
 
   SetFrameEvent(m_EventID, true);
 
@@ -1325,6 +5050,46 @@ ShaderDebugTrace *ReplayController::DebugPixel(uint32_t x, uint32_t y, uint32_t
   return ret;
 }
 
+rdctype::array<ShaderDebugTrace> ReplayController::DebugVertices(
+    const rdctype::array<ShaderDebugVertexInput> &inputs, uint32_t instOffset, uint32_t vertOffset)
+{
+  rdctype::array<ShaderDebugTrace> ret;
+
+  if(inputs.count == 0)
+    return ret;
+
+  vector<ShaderDebugVertexInput> in;
+  in.reserve(inputs.count);
+  for(int32_t i = 0; i < inputs.count; i++)
+    in.push_back(inputs[i]);
+
+  ret = m_pDevice->DebugVertices(m_EventID, in, instOffset, vertOffset);
+
+  SetFrameEvent(m_EventID, true);
+
+  return ret;
+}
+
+rdctype::array<ShaderDebugTrace> ReplayController::DebugPixels(
+    const rdctype::array<ShaderDebugPixelInput> &inputs)
+{
+  rdctype::array<ShaderDebugTrace> ret;
+
+  if(inputs.count == 0)
+    return ret;
+
+  vector<ShaderDebugPixelInput> in;
+  in.reserve(inputs.count);
+  for(int32_t i = 0; i < inputs.count; i++)
+    in.push_back(inputs[i]);
+
+  ret = m_pDevice->DebugPixels(m_EventID, in);
+
+  SetFrameEvent(m_EventID, true);
+
+  return ret;
+}
+
 ShaderDebugTrace *ReplayController::DebugThread(const uint32_t groupid[3], const uint32_t threadid[3])
 {
   ShaderDebugTrace *ret = new ShaderDebugTrace;
@@ -1348,11 +5113,8 @@ rdctype::array<ShaderVariable> ReplayController::GetCBufferVariableContents(
   if(buffer != ResourceId())
     m_pDevice->GetBufferData(m_pDevice->GetLiveID(buffer), offs, 0, data);
 
-  vector<ShaderVariable> v;
-
-  m_pDevice->FillCBufferVariables(m_pDevice->GetLiveID(shader), entryPoint, cbufslot, v, data);
-
-  return v;
+  return DecodeConstantBlock(m_pDevice->GetLiveID(shader), entryPoint, cbufslot, data,
+                             buffer != ResourceId());
 }
 
 rdctype::array<WindowingSystem> ReplayController::GetSupportedWindowSystems()
@@ -1455,6 +5217,14 @@ void ReplayController::ReplaceResource(ResourceId from, ResourceId to)
 {
   m_pDevice->ReplaceResource(from, to);
 
+  // a replaced shader can have different reflection behind the same ID
+  m_ConstantBlockCache.clear();
+
+  // any texture's contents could be different now
+  m_TextureStats.clear();
+  for(auto it = m_ThumbnailCache.begin(); it != m_ThumbnailCache.end(); ++it)
+    it->second.valid = false;
+
   SetFrameEvent(m_EventID, true);
 
   for(size_t i = 0; i < m_Outputs.size(); i++)
@@ -1466,6 +5236,13 @@ void ReplayController::RemoveReplacement(ResourceId id)
 {
   m_pDevice->RemoveReplacement(id);
 
+  // a replaced shader can have different reflection behind the same ID
+  m_ConstantBlockCache.clear();
+
+  m_TextureStats.clear();
+  for(auto it = m_ThumbnailCache.begin(); it != m_ThumbnailCache.end(); ++it)
+    it->second.valid = false;
+
   SetFrameEvent(m_EventID, true);
 
   for(size_t i = 0; i < m_Outputs.size(); i++)
@@ -1495,6 +5272,11 @@ ReplayStatus ReplayController::CreateDevice(const char *logfile)
   if(driver && status == ReplayStatus::Succeeded)
   {
     RDCLOG("Created replay driver.");
+
+    // only local captures have a file to key the cache on
+    if(RenderDoc::Inst().GetConfigSetting("replay.postVSCache.disk") == "1")
+      m_PostVSDiskCache.Open(logfile);
+
     return PostCreateInit(driver);
   }
 
@@ -1516,16 +5298,62 @@ ReplayStatus ReplayController::SetDevice(IReplayDriver *device)
 
 ReplayStatus ReplayController::PostCreateInit(IReplayDriver *device)
 {
+  // the trace covers everything from loading the capture until it's closed
+  string profileTrace = RenderDoc::Inst().GetConfigSetting("replay.profileTrace");
+  if(!profileTrace.empty())
+    Profiler::BeginTrace(profileTrace.c_str());
+
   m_pDevice = device;
 
-  m_pDevice->ReadLogInitialisation();
+  {
+    SCOPED_PROFILE("ReplayController::ReadLogInitialisation");
+    m_pDevice->ReadLogInitialisation();
+  }
 
   FetchPipelineState();
 
   m_FrameRecord = m_pDevice->GetFrameRecord();
 
+  // make CPU timestamps relative to the start of the frame, and find the span of each thread
+  {
+    uint64_t firstTime = 0;
+    bool anyTimed = false;
+    GatherCPUTimes(m_FrameRecord.drawcallList, firstTime, anyTimed);
+
+    if(anyTimed)
+    {
+      vector<ThreadTimeline> threads;
+      RebaseCPUTimes(m_FrameRecord.drawcallList, firstTime, threads);
+      m_FrameRecord.frameInfo.threadTimelines = threads;
+    }
+  }
+
+  // only the function names travel with the drawcall list, the parameters are looked up on demand
+  SplitEventParameters(m_FrameRecord.drawcallList, m_EventParameters);
+
+  // an inverted index of the resources each event referenced, so finding every event that used a
+  // resource is a single lookup
+  IndexEventReferences(m_FrameRecord.drawcallList, m_EventReferences);
+
+  for(auto it = m_EventReferences.begin(); it != m_EventReferences.end(); ++it)
+  {
+    std::sort(it->second.begin(), it->second.end());
+    it->second.erase(std::unique(it->second.begin(), it->second.end()), it->second.end());
+  }
+
   SetupDrawcallPointers(&m_Drawcalls, m_FrameRecord.drawcallList, NULL, NULL);
 
+  {
+    vector<FlatDrawcall> flat;
+    StringPool names;
+
+    flat.reserve(m_Drawcalls.size());
+    FlattenDrawcalls(m_FrameRecord.drawcallList, -1, flat, names);
+
+    m_FlatDrawcalls.draws = flat;
+    m_FlatDrawcalls.names = names.GetData();
+  }
+
   return ReplayStatus::Succeeded;
 }
 
@@ -1653,6 +5481,14 @@ extern "C" RENDERDOC_API void RENDERDOC_CC ReplayRenderer_SetFrameEvent(IReplayC
 {
   rend->SetFrameEvent(eventID, force != 0);
 }
+extern "C" RENDERDOC_API void RENDERDOC_CC ReplayRenderer_RequestCancel(IReplayController *rend)
+{
+  rend->RequestCancel();
+}
+extern "C" RENDERDOC_API void RENDERDOC_CC ReplayRenderer_ClearCancelRequest(IReplayController *rend)
+{
+  rend->ClearCancelRequest();
+}
 extern "C" RENDERDOC_API void RENDERDOC_CC
 ReplayRenderer_GetD3D11PipelineState(IReplayController *rend, D3D11Pipe::State *state)
 {
@@ -1741,6 +5577,27 @@ ReplayRenderer_FetchCounters(IReplayController *rend, GPUCounter *counters, uint
   create_array_init(counterArray, (size_t)numCounters, counters);
   *results = rend->FetchCounters(counterArray);
 }
+extern "C" RENDERDOC_API void RENDERDOC_CC ReplayRenderer_FetchCounterStatistics(
+    IReplayController *rend, GPUCounter *counters, uint32_t numCounters, uint32_t iterations,
+    rdctype::array<CounterStatistics> *results)
+{
+  rdctype::array<GPUCounter> counterArray;
+  create_array_init(counterArray, (size_t)numCounters, counters);
+  *results = rend->FetchCounterStatistics(counterArray, iterations);
+}
+extern "C" RENDERDOC_API void RENDERDOC_CC ReplayRenderer_GetDurationTimeline(
+    IReplayController *rend, CounterResult *durations, uint32_t numDurations, double minDuration,
+    rdctype::array<TimelineRegion> *regions)
+{
+  rdctype::array<CounterResult> durationArray;
+  create_array_init(durationArray, (size_t)numDurations, durations);
+  *regions = rend->GetDurationTimeline(durationArray, minDuration);
+}
+extern "C" RENDERDOC_API void RENDERDOC_CC
+ReplayRenderer_GetQueueTimeline(IReplayController *rend, rdctype::array<SubmissionTiming> *timings)
+{
+  *timings = rend->GetQueueTimeline();
+}
 extern "C" RENDERDOC_API void RENDERDOC_CC
 ReplayRenderer_EnumerateCounters(IReplayController *rend, rdctype::array<GPUCounter> *counters)
 {
@@ -1762,6 +5619,31 @@ ReplayRenderer_GetBuffers(IReplayController *rend, rdctype::array<BufferDescript
 {
   *bufs = rend->GetBuffers();
 }
+extern "C" RENDERDOC_API void RENDERDOC_CC ReplayRenderer_GetEventData(
+    IReplayController *rend, uint32_t *eventIDs, uint32_t numEvents, EventDataFlags flags,
+    GPUCounter *counters, uint32_t numCounters, rdctype::array<EventData> *data)
+{
+  rdctype::array<uint32_t> eventArray;
+  create_array_init(eventArray, (size_t)numEvents, eventIDs);
+  rdctype::array<GPUCounter> counterArray;
+  create_array_init(counterArray, (size_t)numCounters, counters);
+  *data = rend->GetEventData(eventArray, flags, counterArray);
+}
+extern "C" RENDERDOC_API void RENDERDOC_CC ReplayRenderer_GetBoundConstantBlocks(
+    IReplayController *rend, rdctype::array<EventConstantBlock> *blocks)
+{
+  *blocks = rend->GetBoundConstantBlocks();
+}
+extern "C" RENDERDOC_API void RENDERDOC_CC
+ReplayRenderer_GetResourceMemory(IReplayController *rend, rdctype::array<ResourceMemory> *mem)
+{
+  *mem = rend->GetResourceMemory();
+}
+extern "C" RENDERDOC_API void RENDERDOC_CC
+ReplayRenderer_GetTransientAliasing(IReplayController *rend, rdctype::array<AliasGroup> *groups)
+{
+  *groups = rend->GetTransientAliasing();
+}
 extern "C" RENDERDOC_API void RENDERDOC_CC
 ReplayRenderer_GetResolve(IReplayController *rend, uint64_t *callstack, uint32_t callstackLen,
                           rdctype::array<rdctype::str> *trace)
@@ -1771,10 +5653,60 @@ ReplayRenderer_GetResolve(IReplayController *rend, uint64_t *callstack, uint32_t
   *trace = rend->GetResolve(stack);
 }
 extern "C" RENDERDOC_API void RENDERDOC_CC
+ReplayRenderer_GetEventParameters(IReplayController *rend, uint32_t eventID, rdctype::str *params)
+{
+  *params = rend->GetEventParameters(eventID);
+}
+extern "C" RENDERDOC_API void RENDERDOC_CC
+ReplayRenderer_FindEventsReferencing(IReplayController *rend, ResourceId id,
+                                     rdctype::array<uint32_t> *events)
+{
+  *events = rend->FindEventsReferencing(id);
+}
+extern "C" RENDERDOC_API void RENDERDOC_CC
 ReplayRenderer_GetDebugMessages(IReplayController *rend, rdctype::array<DebugMessage> *msgs)
 {
   *msgs = rend->GetDebugMessages();
 }
+extern "C" RENDERDOC_API void RENDERDOC_CC
+ReplayRenderer_AnalyseWastedWork(IReplayController *rend, rdctype::array<DebugMessage> *msgs)
+{
+  *msgs = rend->AnalyseWastedWork();
+}
+extern "C" RENDERDOC_API void RENDERDOC_CC ReplayRenderer_GetDrawcallShaderCosts(
+    IReplayController *rend, rdctype::array<DrawcallShaderCost> *costs)
+{
+  *costs = rend->GetDrawcallShaderCosts();
+}
+
+extern "C" RENDERDOC_API void RENDERDOC_CC ReplayRenderer_GetDrawcallBandwidth(
+    IReplayController *rend, rdctype::array<DrawcallBandwidth> *bandwidth)
+{
+  *bandwidth = rend->GetDrawcallBandwidth();
+}
+
+extern "C" RENDERDOC_API void RENDERDOC_CC
+ReplayRenderer_AnalyseBottlenecks(IReplayController *rend, rdctype::array<PassBottleneck> *passes)
+{
+  *passes = rend->AnalyseBottlenecks();
+}
+extern "C" RENDERDOC_API void RENDERDOC_CC
+ReplayRenderer_GetIndexEfficiency(IReplayController *rend, rdctype::array<IndexEfficiency> *eff)
+{
+  *eff = rend->GetIndexEfficiency();
+}
+extern "C" RENDERDOC_API void RENDERDOC_CC
+ReplayRenderer_GetTextureSampling(IReplayController *rend, uint32_t startEventID,
+                                  uint32_t endEventID,
+                                  rdctype::array<TextureSamplingFeedback> *feedback)
+{
+  *feedback = rend->GetTextureSampling(startEventID, endEventID);
+}
+extern "C" RENDERDOC_API void RENDERDOC_CC
+ReplayRenderer_GetMemoryUsage(IReplayController *rend, rdctype::array<MemoryUsage> *usage)
+{
+  *usage = rend->GetMemoryUsage();
+}
 
 extern "C" RENDERDOC_API void RENDERDOC_CC ReplayRenderer_PixelHistory(
     IReplayController *rend, ResourceId target, uint32_t x, uint32_t y, uint32_t slice,
@@ -1782,6 +5714,14 @@ extern "C" RENDERDOC_API void RENDERDOC_CC ReplayRenderer_PixelHistory(
 {
   *history = rend->PixelHistory(target, x, y, slice, mip, sampleIdx, typeHint);
 }
+
+extern "C" RENDERDOC_API void RENDERDOC_CC ReplayRenderer_PixelHistoryRegion(
+    IReplayController *rend, ResourceId target, uint32_t x, uint32_t y, uint32_t width,
+    uint32_t height, uint32_t slice, uint32_t mip, uint32_t sampleIdx, CompType typeHint,
+    rdctype::array<PixelRegionHistory> *history)
+{
+  *history = rend->PixelHistoryRegion(target, x, y, width, height, slice, mip, sampleIdx, typeHint);
+}
 extern "C" RENDERDOC_API void RENDERDOC_CC
 ReplayRenderer_DebugVertex(IReplayController *rend, uint32_t vertid, uint32_t instid, uint32_t idx,
                            uint32_t instOffset, uint32_t vertOffset, ShaderDebugTrace *trace)
@@ -1800,6 +5740,22 @@ extern "C" RENDERDOC_API void RENDERDOC_CC ReplayRenderer_DebugPixel(IReplayCont
   *trace = *ret;
   delete ret;
 }
+extern "C" RENDERDOC_API void RENDERDOC_CC ReplayRenderer_DebugVertices(
+    IReplayController *rend, ShaderDebugVertexInput *inputs, uint32_t numInputs,
+    uint32_t instOffset, uint32_t vertOffset, rdctype::array<ShaderDebugTrace> *traces)
+{
+  rdctype::array<ShaderDebugVertexInput> inputArray;
+  create_array_init(inputArray, (size_t)numInputs, inputs);
+  *traces = rend->DebugVertices(inputArray, instOffset, vertOffset);
+}
+extern "C" RENDERDOC_API void RENDERDOC_CC ReplayRenderer_DebugPixels(
+    IReplayController *rend, ShaderDebugPixelInput *inputs, uint32_t numInputs,
+    rdctype::array<ShaderDebugTrace> *traces)
+{
+  rdctype::array<ShaderDebugPixelInput> inputArray;
+  create_array_init(inputArray, (size_t)numInputs, inputs);
+  *traces = rend->DebugPixels(inputArray);
+}
 extern "C" RENDERDOC_API void RENDERDOC_CC ReplayRenderer_DebugThread(IReplayController *rend,
                                                                       uint32_t groupid[3],
                                                                       uint32_t threadid[3],
@@ -1855,3 +5811,17 @@ extern "C" RENDERDOC_API void RENDERDOC_CC ReplayRenderer_GetTextureData(IReplay
 {
   *data = rend->GetTextureData(tex, arrayIdx, mip);
 }
+
+extern "C" RENDERDOC_API void RENDERDOC_CC ReplayRenderer_CompareTextures(
+    IReplayController *rend, ResourceId texA, uint32_t eventA, ResourceId texB, uint32_t eventB,
+    uint32_t sliceFace, uint32_t mip, float threshold, TextureDiff *diff)
+{
+  *diff = rend->CompareTextures(texA, eventA, texB, eventB, sliceFace, mip, threshold);
+}
+
+extern "C" RENDERDOC_API void RENDERDOC_CC ReplayRenderer_GetTextureDataRegion(
+    IReplayController *rend, ResourceId tex, uint32_t arrayIdx, uint32_t mip, uint32_t x,
+    uint32_t y, uint32_t width, uint32_t height, rdctype::array<byte> *data)
+{
+  *data = rend->GetTextureDataRegion(tex, arrayIdx, mip, x, y, width, height);
+}
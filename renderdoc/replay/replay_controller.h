@@ -30,11 +30,155 @@
 #include "api/replay/renderdoc_replay.h"
 #include "common/common.h"
 #include "core/core.h"
+#include "core/resource_id_map.h"
+#include "replay/index_analysis.h"
 #include "replay/replay_driver.h"
 #include "type_helpers.h"
 
 struct ReplayController;
 
+// a texture that has been read back from the device for saving, along with the mapped description
+// and settings to encode it with. Encoding only touches CPU memory so it can be done on any thread.
+struct TextureSaveJob
+{
+  TextureSave sd;
+  TextureDescription td;
+  std::string path;
+
+  std::vector<byte *> subdata;
+  uint32_t rowPitch = 0;
+  uint32_t numSlices = 0;
+  uint32_t numMips = 0;
+
+  // set if the file was already written while fetching, so there's nothing left to encode
+  bool written = false;
+  bool writeSuccess = false;
+};
+
+// the subresource and interpretation that min/max and histogram results were calculated for
+struct TextureStatsKey
+{
+  ResourceId texid;
+  uint32_t sliceFace;
+  uint32_t mip;
+  uint32_t sample;
+  CompType typeHint;
+
+  bool operator<(const TextureStatsKey &o) const
+  {
+    if(texid != o.texid)
+      return texid < o.texid;
+    if(sliceFace != o.sliceFace)
+      return sliceFace < o.sliceFace;
+    if(mip != o.mip)
+      return mip < o.mip;
+    if(sample != o.sample)
+      return sample < o.sample;
+    return typeHint < o.typeHint;
+  }
+};
+
+// cached results for a texture subresource, valid at any event where the texture has the same
+// contents as at eventID.
+struct TextureStats
+{
+  uint32_t eventID = 0;
+
+  bool hasMinMax = false;
+  PixelValue minval;
+  PixelValue maxval;
+
+  struct Histogram
+  {
+    float minval;
+    float maxval;
+    uint32_t channels;
+    std::vector<uint32_t> buckets;
+  };
+
+  // the most recently requested ranges, dragging the range around requests many of these
+  std::vector<Histogram> histograms;
+};
+
+// the interpretation a texture thumbnail was made with
+struct ThumbnailKey
+{
+  ResourceId texid;
+  CompType typeHint;
+
+  bool operator<(const ThumbnailKey &o) const
+  {
+    if(texid != o.texid)
+      return texid < o.texid;
+    return typeHint < o.typeHint;
+  }
+};
+
+// a cached thumbnail in a small displayable texture, valid at any event where the texture has the
+// same contents as at eventID.
+struct CachedThumbnail
+{
+  uint32_t eventID = 0;
+  bool valid = false;
+
+  ResourceId proxy;
+  uint32_t width = 0;
+  uint32_t height = 0;
+};
+
+// the indices analysed for GetIndexEfficiency. The buffer is the live ID
+struct IndexStatsKey
+{
+  ResourceId buffer;
+  uint64_t offset;
+  uint32_t count;
+  uint32_t byteWidth;
+  bool strip;
+
+  bool operator<(const IndexStatsKey &o) const
+  {
+    if(buffer != o.buffer)
+      return buffer < o.buffer;
+    if(offset != o.offset)
+      return offset < o.offset;
+    if(count != o.count)
+      return count < o.count;
+    if(byteWidth != o.byteWidth)
+      return byteWidth < o.byteWidth;
+    return strip < o.strip;
+  }
+};
+
+// a cached index analysis, valid at any event where the buffer has the same contents as at eventID.
+struct CachedIndexStats
+{
+  uint32_t eventID = 0;
+  IndexStats stats;
+};
+
+struct ConstantBlockKey
+{
+  ResourceId shader;
+  std::string entryPoint;
+  uint32_t slot;
+
+  bool operator<(const ConstantBlockKey &o) const
+  {
+    if(shader != o.shader)
+      return shader < o.shader;
+    if(entryPoint != o.entryPoint)
+      return entryPoint < o.entryPoint;
+    return slot < o.slot;
+  }
+};
+
+// the variables decoded from a constant block, valid wherever the block has the same contents
+struct CachedConstantBlock
+{
+  vector<byte> contents;
+  rdctype::array<ShaderVariable> variables;
+};
+
 struct ReplayOutput : public IReplayOutput
 {
 public:
@@ -58,7 +202,11 @@ public:
   ResourceId GetDebugOverlayTexID() { return m_OverlayResourceId; }
   PixelValue PickPixel(ResourceId texID, bool customShader, uint32_t x, uint32_t y,
                        uint32_t sliceFace, uint32_t mip, uint32_t sample);
+  void RequestPickPixel(ResourceId texID, bool customShader, uint32_t x, uint32_t y,
+                        uint32_t sliceFace, uint32_t mip, uint32_t sample);
+  PixelPick GetPickedPixel() { return m_PickResult; }
   rdctype::pair<uint32_t, uint32_t> PickVertex(uint32_t eventID, uint32_t x, uint32_t y);
+  bool IsMeshDisplayReduced() { return m_MeshDisplayReduced; }
 
 private:
   ReplayOutput(ReplayController *parent, WindowingSystem system, void *data, ReplayOutputType type);
@@ -68,11 +216,31 @@ private:
 
   void RefreshOverlay();
 
+  // the largest dimension of cached thumbnails. Thumbnail windows are small, this leaves some room
+  // for high-DPI displays.
+  static const uint32_t ThumbnailSize = 128;
+
   void DisplayContext();
   void DisplayTex();
 
+  // the latest requested pick, made when the output is next displayed, and the last one made
+  bool m_PickPending;
+  PixelPick m_PickRequest;
+  PixelPick m_PickResult;
+
+  void ResolvePendingPick();
+
   void DisplayMesh();
 
+  // while the view is changing, at most this many vertices are drawn over all the meshes so that
+  // moving the camera stays responsive. The full meshes are drawn once the view stops changing.
+  static const uint32_t MeshMovingVertexBudget = 4 * 1024 * 1024;
+
+  // the view the meshes were last displayed with, to tell when the camera is moving
+  float m_LastMeshView[16];
+  MeshDisplay m_LastMeshDisplay;
+  bool m_MeshDisplayReduced;
+
   ReplayController *m_pRenderer;
 
   bool m_OverlayDirty;
@@ -135,12 +303,18 @@ public:
 
   void SetFrameEvent(uint32_t eventID, bool force);
 
+  void RequestCancel() { m_CancelRequested = true; }
+  void ClearCancelRequest() { m_CancelRequested = false; }
   void FetchPipelineState();
 
   D3D11Pipe::State GetD3D11PipelineState();
   D3D12Pipe::State GetD3D12PipelineState();
   GLPipe::State GetGLPipelineState();
   VKPipe::State GetVulkanPipelineState();
+  rdctype::array<EventData> GetEventData(const rdctype::array<uint32_t> &eventIDs,
+                                         EventDataFlags flags,
+                                         const rdctype::array<GPUCounter> &counters);
+  rdctype::array<EventConstantBlock> GetBoundConstantBlocks();
 
   rdctype::pair<ResourceId, rdctype::str> BuildCustomShader(const char *entry, const char *source,
                                                             const uint32_t compileFlags,
@@ -156,20 +330,47 @@ public:
 
   FrameDescription GetFrameInfo();
   rdctype::array<DrawcallDescription> GetDrawcalls();
+  const FlatDrawcallList &GetFlatDrawcalls();
   rdctype::array<CounterResult> FetchCounters(const rdctype::array<GPUCounter> &counters);
+  rdctype::array<CounterStatistics> FetchCounterStatistics(const rdctype::array<GPUCounter> &counters,
+                                                           uint32_t iterations);
+  rdctype::array<double> ReplayLoop(uint32_t iterations, IReplayOutput *output, bool timeGPU);
+  rdctype::array<TimelineRegion> GetDurationTimeline(const rdctype::array<CounterResult> &durations,
+                                                     double minDuration);
+  rdctype::array<SubmissionTiming> GetQueueTimeline();
   rdctype::array<GPUCounter> EnumerateCounters();
   CounterDescription DescribeCounter(GPUCounter counterID);
   rdctype::array<TextureDescription> GetTextures();
   rdctype::array<BufferDescription> GetBuffers();
+  rdctype::array<ResourceMemory> GetResourceMemory();
+  rdctype::array<AliasGroup> GetTransientAliasing();
   rdctype::array<rdctype::str> GetResolve(const rdctype::array<uint64_t> &callstack);
+  rdctype::str GetEventParameters(uint32_t eventID);
+  rdctype::array<uint32_t> FindEventsReferencing(ResourceId id);
   rdctype::array<DebugMessage> GetDebugMessages();
+  rdctype::array<DebugMessage> AnalyseWastedWork();
+  rdctype::array<DrawcallShaderCost> GetDrawcallShaderCosts();
+  rdctype::array<DrawcallBandwidth> GetDrawcallBandwidth();
+  rdctype::array<PassBottleneck> AnalyseBottlenecks();
+  rdctype::array<IndexEfficiency> GetIndexEfficiency();
+  rdctype::array<TextureSamplingFeedback> GetTextureSampling(uint32_t startEventID,
+                                                             uint32_t endEventID);
+  rdctype::array<MemoryUsage> GetMemoryUsage();
 
   rdctype::array<PixelModification> PixelHistory(ResourceId target, uint32_t x, uint32_t y,
                                                  uint32_t slice, uint32_t mip, uint32_t sampleIdx,
                                                  CompType typeHint);
+  rdctype::array<PixelRegionHistory> PixelHistoryRegion(ResourceId target, uint32_t x, uint32_t y,
+                                                        uint32_t width, uint32_t height,
+                                                        uint32_t slice, uint32_t mip,
+                                                        uint32_t sampleIdx, CompType typeHint);
   ShaderDebugTrace *DebugVertex(uint32_t vertid, uint32_t instid, uint32_t idx, uint32_t instOffset,
                                 uint32_t vertOffset);
   ShaderDebugTrace *DebugPixel(uint32_t x, uint32_t y, uint32_t sample, uint32_t primitive);
+  rdctype::array<ShaderDebugTrace> DebugVertices(
+      const rdctype::array<ShaderDebugVertexInput> &inputs, uint32_t instOffset,
+      uint32_t vertOffset);
+  rdctype::array<ShaderDebugTrace> DebugPixels(const rdctype::array<ShaderDebugPixelInput> &inputs);
   ShaderDebugTrace *DebugThread(const uint32_t groupid[3], const uint32_t threadid[3]);
   void FreeTrace(ShaderDebugTrace *trace);
 
@@ -179,8 +380,15 @@ public:
 
   rdctype::array<byte> GetBufferData(ResourceId buff, uint64_t offset, uint64_t len);
   rdctype::array<byte> GetTextureData(ResourceId buff, uint32_t arrayIdx, uint32_t mip);
+  rdctype::array<byte> GetTextureDataRegion(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
+                                            uint32_t x, uint32_t y, uint32_t width,
+                                            uint32_t height);
+  TextureDiff CompareTextures(ResourceId texA, uint32_t eventA, ResourceId texB, uint32_t eventB,
+                              uint32_t sliceFace, uint32_t mip, float threshold);
 
   bool SaveTexture(const TextureSave &saveData, const char *path);
+  bool SaveTextures(const rdctype::array<TextureSave> &saveData,
+                    const rdctype::array<rdctype::str> &paths);
 
   rdctype::array<ShaderVariable> GetCBufferVariableContents(ResourceId shader, const char *entryPoint,
                                                             uint32_t cbufslot, ResourceId buffer,
@@ -197,13 +405,56 @@ private:
   ReplayStatus PostCreateInit(IReplayDriver *device);
 
   DrawcallDescription *GetDrawcallByEID(uint32_t eventID);
+  vector<EventUsage> GetPixelHistoryEvents(ResourceId target);
+
+  bool TextureWrittenBetween(ResourceId texid, uint32_t from, uint32_t to);
+
+  // replays up to and including eventID, skipping any drawcalls which can't affect the contents of
+  // the live resource target at that point. Other resources are left in an undefined state, so
+  // the replay must be reset to the current event afterwards.
+  void ReplayForTarget(ResourceId target, uint32_t eventID);
+
+  // counter values by event and counter, for the counters in the list that the driver supports
+  typedef std::map<std::pair<uint32_t, GPUCounter>, double> CounterValueMap;
+  CounterValueMap FetchCounterValues(const vector<GPUCounter> &counters);
+  vector<DrawcallBandwidth> EstimateBandwidth(const CounterValueMap &counters);
+
+  void BuildEventDependencies();
+  vector<uint32_t> GetPrunableEvents(ResourceId target, uint32_t eventID);
+  TextureStats &GetTextureStats(const TextureStatsKey &key, uint32_t eventID);
+
+  // decodes the contents of a constant block, reusing the previous decode if the block's contents
+  // haven't changed. Blocks that the driver fills in itself, like GL bare uniforms, have no
+  // contents to compare so aren't cacheable.
+  rdctype::array<ShaderVariable> DecodeConstantBlock(ResourceId liveShader,
+                                                     const std::string &entryPoint, uint32_t slot,
+                                                     const vector<byte> &contents, bool cacheable);
+
+  // fetches new thumbnails in one batch for any of the given textures that don't have an up to date
+  // one at eventID.
+  void UpdateThumbnails(const vector<ThumbnailKey> &keys, uint32_t eventID);
+  // returns the texture to display as a thumbnail, or ResourceId() if there isn't an up to date one
+  ResourceId GetThumbnail(const ThumbnailKey &key, uint32_t eventID);
+
+  // post-transform data for a draw goes through these rather than straight to the driver, so that
+  // draws in the disk cache don't have to be streamed out again
+  void InitPostVSBuffers(uint32_t eventID);
+  MeshFormat GetPostVSBuffers(uint32_t eventID, uint32_t instID, MeshDataStage stage);
+  ResourceId GetPostVSProxyBuffer(uint32_t eventID, MeshDataStage stage, bool index);
 
   IReplayDriver *GetDevice() { return m_pDevice; }
   FrameRecord m_FrameRecord;
   vector<DrawcallDescription *> m_Drawcalls;
+  FlatDrawcallList m_FlatDrawcalls;
+  // event ID -> serialised parameters, split out of the events' descriptions
+  std::map<uint32_t, std::string> m_EventParameters;
+  // resource ID -> sorted event IDs of every call that referenced it
+  ResourceIdMap<vector<uint32_t>> m_EventReferences;
 
   uint32_t m_EventID;
 
+  volatile bool m_CancelRequested;
+
   D3D11Pipe::State m_D3D11PipelineState;
   D3D12Pipe::State m_D3D12PipelineState;
   GLPipe::State m_GLPipelineState;
@@ -214,10 +465,47 @@ private:
   std::vector<BufferDescription> m_Buffers;
   std::vector<TextureDescription> m_Textures;
 
+  bool FetchTextureSave(const TextureSave &saveData, TextureSaveJob &job);
+  bool FetchTextureFloats(ResourceId liveId, uint32_t sliceFace, uint32_t mip,
+                          std::vector<FloatVector> &texels);
+
+  // the difference texture from CompareTextures, only recreated if the size changes
+  ResourceId m_DiffTexture;
+  uint32_t m_DiffWidth = 0;
+  uint32_t m_DiffHeight = 0;
+
   IReplayDriver *m_pDevice;
 
   std::set<ResourceId> m_TargetResources;
   std::set<ResourceId> m_CustomShaders;
 
+  // live texture ID -> sorted events that write to it
+  std::map<ResourceId, std::vector<uint32_t> > m_TextureWrites;
+
+  // the dependency graph between events for ReplayForTarget, built from the usage of every
+  // texture and buffer the first time it's needed
+  struct EventResources
+  {
+    // sorted live IDs of the resources the event used in any way
+    std::vector<ResourceId> used;
+    // each distinct way a resource was used at the event, for GetDrawcallBandwidth
+    std::vector<std::pair<ResourceId, ResourceUsage> > usage;
+    bool writes = false;
+  };
+  std::map<uint32_t, EventResources> m_EventResources;
+  // live resource ID -> sorted events that write to it
+  ResourceIdMap<std::vector<uint32_t> > m_ResourceWrites;
+  bool m_DependenciesBuilt = false;
+  std::map<TextureStatsKey, TextureStats> m_TextureStats;
+  std::map<ThumbnailKey, CachedThumbnail> m_ThumbnailCache;
+  std::map<IndexStatsKey, CachedIndexStats> m_IndexStats;
+
+  static const size_t MaxCachedConstantBlocks = 1024;
+  std::map<ConstantBlockKey, CachedConstantBlock> m_ConstantBlockCache;
+
+  PostVSDiskCache m_PostVSDiskCache;
+  // buffers created from disk cache data, keyed by event, stage and vertex/index
+  std::map<uint64_t, ResourceId> m_PostVSProxyBuffers;
+
   friend struct ReplayOutput;
 };
@@ -23,7 +23,9 @@
  ******************************************************************************/
 
 #include "replay_driver.h"
+#include "3rdparty/lz4/lz4.h"
 #include "maths/formatpacking.h"
+#include "serialise/string_utils.h"
 
 DrawcallDescription *SetupDrawcallPointers(vector<DrawcallDescription *> *drawcallTable,
                                            rdctype::array<DrawcallDescription> &draws,
@@ -80,6 +82,211 @@ DrawcallDescription *SetupDrawcallPointers(vector<DrawcallDescription *> *drawca
   return ret;
 }
 
+MemoryUsage MakeMemoryUsage(const char *category, bool gpu, uint64_t count, uint64_t bytes)
+{
+  MemoryUsage ret;
+  ret.category = category;
+  ret.gpu = gpu;
+  ret.count = count;
+  ret.bytes = bytes;
+  return ret;
+}
+
+vector<TextureThumbnail> FetchTextureThumbnails(IRemoteDriver *driver,
+                                                const vector<TextureThumbnailRequest> &textures,
+                                                uint32_t size)
+{
+  vector<TextureThumbnail> ret(textures.size());
+
+  size = RDCMAX(size, 1U);
+
+  for(size_t i = 0; i < textures.size(); i++)
+  {
+    if(textures[i].texid == ResourceId())
+      continue;
+
+    TextureDescription desc = driver->GetTexture(textures[i].texid);
+
+    // multisampled textures aren't remapped, these fall back to being displayed directly
+    if(desc.width == 0 || desc.height == 0 || desc.msSamp > 1)
+      continue;
+
+    // start from the smallest mip that's still at least as big as the thumbnail
+    uint32_t mip = 0;
+    while(mip + 1 < desc.mips &&
+          RDCMAX(desc.width >> (mip + 1), desc.height >> (mip + 1)) >= size)
+      mip++;
+
+    uint32_t srcW = RDCMAX(1U, desc.width >> mip);
+    uint32_t srcH = RDCMAX(1U, desc.height >> mip);
+
+    GetTextureDataParams params;
+    params.typeHint = textures[i].typeHint;
+    params.remap = eRemap_RGBA8;
+    params.blackPoint = textures[i].typeHint == CompType::SNorm ? -1.0f : 0.0f;
+    params.whitePoint = 1.0f;
+
+    size_t dataSize = 0;
+    byte *data = driver->GetTextureData(textures[i].texid, 0, mip, params, dataSize);
+
+    // 3D textures return every slice, we only use the first
+    if(data == NULL || dataSize < size_t(srcW) * srcH * 4)
+    {
+      delete[] data;
+      continue;
+    }
+
+    TextureThumbnail &thumb = ret[i];
+
+    float scale = RDCMAX(1.0f, float(RDCMAX(srcW, srcH)) / float(size));
+
+    thumb.width = RDCMAX(1U, uint32_t(float(srcW) / scale));
+    thumb.height = RDCMAX(1U, uint32_t(float(srcH) / scale));
+    thumb.rgba.resize(size_t(thumb.width) * thumb.height * 4);
+
+    // box filter each destination pixel from the source texels it covers
+    for(uint32_t y = 0; y < thumb.height; y++)
+    {
+      uint32_t y0 = y * srcH / thumb.height;
+      uint32_t y1 = RDCMAX(y0 + 1, (y + 1) * srcH / thumb.height);
+
+      for(uint32_t x = 0; x < thumb.width; x++)
+      {
+        uint32_t x0 = x * srcW / thumb.width;
+        uint32_t x1 = RDCMAX(x0 + 1, (x + 1) * srcW / thumb.width);
+
+        uint32_t sum[4] = {0, 0, 0, 0};
+
+        for(uint32_t sy = y0; sy < y1; sy++)
+        {
+          const byte *src = data + (size_t(sy) * srcW + x0) * 4;
+
+          for(uint32_t sx = x0; sx < x1; sx++, src += 4)
+          {
+            sum[0] += src[0];
+            sum[1] += src[1];
+            sum[2] += src[2];
+            sum[3] += src[3];
+          }
+        }
+
+        uint32_t count = (y1 - y0) * (x1 - x0);
+        byte *dst = &thumb.rgba[(size_t(y) * thumb.width + x) * 4];
+
+        for(int c = 0; c < 4; c++)
+          dst[c] = byte(sum[c] / count);
+      }
+    }
+
+    delete[] data;
+  }
+
+  return ret;
+}
+
+static uint64_t GetConstantsSize(const rdctype::array<ShaderConstant> &constants)
+{
+  uint64_t ret = constants.count * sizeof(ShaderConstant);
+
+  for(int32_t i = 0; i < constants.count; i++)
+  {
+    ret += constants[i].name.count + constants[i].type.descriptor.name.count;
+    ret += GetConstantsSize(constants[i].type.members);
+  }
+
+  return ret;
+}
+
+uint64_t GetShaderReflectionSize(const ShaderReflection &refl)
+{
+  uint64_t ret = sizeof(ShaderReflection);
+
+  ret += refl.RawBytes.count + refl.Disassembly.count + refl.DebugInfo.entryFunc.count;
+
+  for(int32_t i = 0; i < refl.DebugInfo.files.count; i++)
+    ret += refl.DebugInfo.files[i].first.count + refl.DebugInfo.files[i].second.count;
+
+  ret += (refl.InputSig.count + refl.OutputSig.count) * sizeof(SigParameter);
+
+  for(int32_t i = 0; i < refl.ConstantBlocks.count; i++)
+    ret += sizeof(ConstantBlock) + refl.ConstantBlocks[i].name.count +
+           GetConstantsSize(refl.ConstantBlocks[i].variables);
+
+  ret += (refl.ReadOnlyResources.count + refl.ReadWriteResources.count) * sizeof(ShaderResource);
+
+  for(int32_t i = 0; i < refl.Interfaces.count; i++)
+    ret += sizeof(rdctype::str) + refl.Interfaces[i].count;
+
+  return ret;
+}
+
+static void DiffShaderVariables(rdctype::array<ShaderVariable> &prev,
+                                const rdctype::array<ShaderVariable> &cur, uint32_t arrayIndex,
+                                vector<ShaderRegisterChange> &changes)
+{
+  RDCASSERT(prev.count == cur.count);
+
+  for(int32_t i = 0; i < cur.count && i < prev.count; i++)
+  {
+    if(memcmp(&prev[i].value, &cur[i].value, sizeof(ShaderValue)) == 0)
+      continue;
+
+    ShaderRegisterChange change;
+    change.index = (uint32_t)i;
+    change.arrayIndex = arrayIndex;
+    change.value = cur[i].value;
+    changes.push_back(change);
+
+    // keep the previous state up to date in place, rather than copying the whole state each step
+    prev[i].value = cur[i].value;
+  }
+}
+
+void ShaderDebugTraceBuilder::AddState(const ShaderDebugState &state)
+{
+  size_t step = m_Steps.size();
+
+  m_Steps.push_back(ShaderDebugStateDelta());
+  ShaderDebugStateDelta &delta = m_Steps.back();
+
+  delta.nextInstruction = state.nextInstruction;
+  delta.flags = state.flags;
+
+  if((step % SHADER_DEBUG_KEYFRAME_INTERVAL) == 0)
+  {
+    m_Keyframes.push_back(state);
+    m_Prev = state;
+    return;
+  }
+
+  vector<ShaderRegisterChange> changes;
+
+  DiffShaderVariables(m_Prev.registers, state.registers, 0, changes);
+  delta.registers = changes;
+  changes.clear();
+
+  DiffShaderVariables(m_Prev.outputs, state.outputs, 0, changes);
+  delta.outputs = changes;
+  changes.clear();
+
+  RDCASSERT(m_Prev.indexableTemps.count == state.indexableTemps.count);
+
+  for(int32_t i = 0; i < state.indexableTemps.count && i < m_Prev.indexableTemps.count; i++)
+    DiffShaderVariables(m_Prev.indexableTemps[i], state.indexableTemps[i], (uint32_t)i, changes);
+  delta.indexableTemps = changes;
+}
+
+void ShaderDebugTraceBuilder::Finish(ShaderDebugTrace &trace)
+{
+  trace.keyframeInterval = SHADER_DEBUG_KEYFRAME_INTERVAL;
+  trace.keyframes = m_Keyframes;
+  trace.steps = m_Steps;
+
+  m_Prev = ShaderDebugState();
+  m_Keyframes.clear();
+  m_Steps.clear();
+}
+
 FloatVector HighlightCache::InterpretVertex(byte *data, uint32_t vert, const MeshDisplay &cfg,
                                             byte *end, bool useidx, bool &valid)
 {
@@ -99,6 +306,350 @@ FloatVector HighlightCache::InterpretVertex(byte *data, uint32_t vert, const Mes
   return HighlightCache::InterpretVertex(data, vert, cfg, end, valid);
 }
 
+PostVSCacheTracker::PostVSCacheTracker()
+{
+  const string &budget = RenderDoc::Inst().GetConfigSetting("replay.postVSCache.budget");
+
+  m_Budget = budget.empty() ? 1024 : (uint64_t)RDCMAX(0, atoi(budget.c_str()));
+  m_Budget *= 1024 * 1024;
+}
+
+PostVSCacheTracker::~PostVSCacheTracker()
+{
+  if(m_Stats.hits + m_Stats.misses == 0)
+    return;
+
+  RDCLOG("Post-VS cache: %llu hits, %llu misses, %llu evictions (%llu MB), peak %llu MB of %llu MB",
+         m_Stats.hits, m_Stats.misses, m_Stats.evictions, m_Stats.evictedBytes / (1024 * 1024),
+         m_Stats.peakBytes / (1024 * 1024), m_Budget / (1024 * 1024));
+}
+
+bool PostVSCacheTracker::Lookup(uint32_t eventID)
+{
+  auto it = m_Entries.find(eventID);
+
+  if(it == m_Entries.end())
+  {
+    m_Stats.misses++;
+    return false;
+  }
+
+  m_Stats.hits++;
+
+  // move to the back, as the most recently used
+  m_LRU.splice(m_LRU.end(), m_LRU, it->second);
+
+  return true;
+}
+
+void PostVSCacheTracker::Insert(uint32_t eventID, uint64_t bytes)
+{
+  auto it = m_Entries.find(eventID);
+
+  if(it != m_Entries.end())
+  {
+    m_Stats.bytes -= it->second->bytes;
+    m_LRU.erase(it->second);
+  }
+
+  Entry entry = {eventID, bytes};
+  m_Entries[eventID] = m_LRU.insert(m_LRU.end(), entry);
+
+  m_Stats.bytes += bytes;
+  m_Stats.peakBytes = RDCMAX(m_Stats.peakBytes, m_Stats.bytes);
+}
+
+std::vector<uint32_t> PostVSCacheTracker::Trim(uint32_t keepEventID)
+{
+  std::vector<uint32_t> ret;
+
+  if(m_Budget == 0)
+    return ret;
+
+  auto it = m_LRU.begin();
+
+  while(m_Stats.bytes > m_Budget && it != m_LRU.end())
+  {
+    if(it->eventID == keepEventID)
+    {
+      ++it;
+      continue;
+    }
+
+    ret.push_back(it->eventID);
+
+    m_Stats.evictions++;
+    m_Stats.evictedBytes += it->bytes;
+    m_Stats.bytes -= it->bytes;
+
+    m_Entries.erase(it->eventID);
+    it = m_LRU.erase(it);
+  }
+
+  if(!ret.empty())
+    RDCDEBUG("Evicted post-VS data for %u events, %llu MB still cached", (uint32_t)ret.size(),
+             m_Stats.bytes / (1024 * 1024));
+
+  return ret;
+}
+
+enum
+{
+  PostVSDiskCacheMagic = MAKE_FOURCC('R', 'D', 'P', 'V'),
+  PostVSDiskCacheVersion = 1,
+
+  PostVSRecord_Format = 0,
+  PostVSRecord_Data = 1,
+};
+
+struct PostVSDiskCacheHeader
+{
+  uint32_t magic;
+  uint32_t version;
+  // MeshFormat is stored raw, so a cache from a build where it's laid out differently is discarded
+  uint32_t formatSize;
+  uint32_t padding;
+  uint64_t captureSize;
+  uint64_t captureTimestamp;
+};
+
+struct PostVSDiskCacheRecord
+{
+  uint32_t type;
+  uint32_t eventID;
+  uint32_t index;
+  uint32_t stage;
+  uint64_t size;
+  uint64_t uncompressedSize;
+};
+
+void PostVSDiskCache::Open(const std::string &capturePath)
+{
+  Close();
+
+  FILE *capture = FileIO::fopen(capturePath.c_str(), "rb");
+  if(capture == NULL)
+    return;
+
+  FileIO::fseek64(capture, 0, SEEK_END);
+  uint64_t captureSize = FileIO::ftell64(capture);
+  FileIO::fclose(capture);
+
+  uint64_t timestamp = FileIO::GetModifiedTimestamp(capturePath);
+
+  // identify the capture by its path, size and modification time
+  uint32_t captureHash = strhash(capturePath.c_str());
+  captureHash =
+      strhash(StringFormat::Fmt("%llu_%llu", captureSize, timestamp).c_str(), captureHash);
+
+  string filename =
+      FileIO::GetAppFolderFilename(StringFormat::Fmt("postvscache_%08x.bin", captureHash));
+
+  PostVSDiskCacheHeader expected;
+  RDCEraseEl(expected);
+  expected.magic = PostVSDiskCacheMagic;
+  expected.version = PostVSDiskCacheVersion;
+  expected.formatSize = sizeof(MeshFormat);
+  expected.captureSize = captureSize;
+  expected.captureTimestamp = timestamp;
+
+  m_File = FileIO::fopen(filename.c_str(), "r+b");
+
+  if(m_File)
+  {
+    FileIO::fseek64(m_File, 0, SEEK_END);
+    uint64_t fileSize = FileIO::ftell64(m_File);
+    FileIO::fseek64(m_File, 0, SEEK_SET);
+
+    PostVSDiskCacheHeader header;
+    bool valid = FileIO::fread(&header, sizeof(header), 1, m_File) == 1 &&
+                 memcmp(&header, &expected, sizeof(header)) == 0;
+
+    uint64_t offs = sizeof(header);
+
+    PostVSDiskCacheRecord rec;
+    while(valid && offs < fileSize)
+    {
+      // a record cut short by an interrupted write invalidates the whole file, as anything
+      // appended after it would be misread
+      valid = offs + sizeof(rec) <= fileSize && FileIO::fread(&rec, sizeof(rec), 1, m_File) == 1;
+      offs += sizeof(rec);
+
+      if(!valid || offs + rec.size > fileSize)
+      {
+        valid = false;
+        break;
+      }
+
+      Key key = {rec.eventID, rec.index, rec.stage};
+
+      if(rec.type == PostVSRecord_Format && rec.size == sizeof(MeshFormat))
+      {
+        MeshFormat fmt;
+        valid = FileIO::fread(&fmt, sizeof(fmt), 1, m_File) == 1;
+        m_Formats[key] = fmt;
+      }
+      else if(rec.type == PostVSRecord_Data)
+      {
+        DataLocation loc = {offs, rec.size, rec.uncompressedSize};
+        m_Data[key] = loc;
+        FileIO::fseek64(m_File, offs + rec.size, SEEK_SET);
+      }
+      else
+      {
+        valid = false;
+      }
+
+      offs += rec.size;
+    }
+
+    if(!valid)
+    {
+      RDCWARN("Discarding invalid post-VS disk cache %s", filename.c_str());
+
+      FileIO::fclose(m_File);
+      m_File = NULL;
+      m_Formats.clear();
+      m_Data.clear();
+    }
+  }
+
+  if(m_File == NULL)
+  {
+    FileIO::CreateParentDirectory(filename);
+
+    m_File = FileIO::fopen(filename.c_str(), "w+b");
+
+    if(m_File == NULL)
+    {
+      RDCWARN("Couldn't open post-VS disk cache %s", filename.c_str());
+      return;
+    }
+
+    FileIO::fwrite(&expected, sizeof(expected), 1, m_File);
+  }
+
+  RDCLOG("Opened post-VS disk cache %s with %u mesh formats", filename.c_str(),
+         (uint32_t)m_Formats.size());
+}
+
+void PostVSDiskCache::Close()
+{
+  if(m_File)
+    FileIO::fclose(m_File);
+
+  m_File = NULL;
+  m_Formats.clear();
+  m_Data.clear();
+}
+
+bool PostVSDiskCache::Contains(uint32_t eventID) const
+{
+  Key key = {eventID, 0, 0};
+  auto it = m_Formats.lower_bound(key);
+  return it != m_Formats.end() && it->first.eventID == eventID;
+}
+
+bool PostVSDiskCache::GetFormat(uint32_t eventID, uint32_t instID, MeshDataStage stage,
+                                MeshFormat &fmt) const
+{
+  Key key = {eventID, instID, (uint32_t)stage};
+  auto it = m_Formats.find(key);
+
+  if(it == m_Formats.end())
+    return false;
+
+  fmt = it->second;
+  return true;
+}
+
+bool PostVSDiskCache::HasData(uint32_t eventID, MeshDataStage stage, bool index) const
+{
+  Key key = {eventID, index ? 1U : 0U, (uint32_t)stage};
+  return m_Data.find(key) != m_Data.end();
+}
+
+bool PostVSDiskCache::GetData(uint32_t eventID, MeshDataStage stage, bool index,
+                              std::vector<byte> &data)
+{
+  Key key = {eventID, index ? 1U : 0U, (uint32_t)stage};
+  auto it = m_Data.find(key);
+
+  if(m_File == NULL || it == m_Data.end())
+    return false;
+
+  const DataLocation &loc = it->second;
+
+  std::vector<byte> compressed((size_t)loc.size);
+  data.resize((size_t)loc.uncompressedSize);
+
+  FileIO::fseek64(m_File, loc.offset, SEEK_SET);
+
+  if(FileIO::fread(&compressed[0], compressed.size(), 1, m_File) != 1)
+    return false;
+
+  int ret = LZ4_decompress_safe((const char *)&compressed[0], (char *)&data[0],
+                                (int)compressed.size(), (int)data.size());
+
+  return ret == (int)data.size();
+}
+
+void PostVSDiskCache::StoreFormat(uint32_t eventID, uint32_t instID, MeshDataStage stage,
+                                  const MeshFormat &fmt)
+{
+  Key key = {eventID, instID, (uint32_t)stage};
+
+  if(m_File == NULL || m_Formats.find(key) != m_Formats.end())
+    return;
+
+  AppendRecord(PostVSRecord_Format, key, &fmt, sizeof(fmt), sizeof(fmt));
+  m_Formats[key] = fmt;
+}
+
+void PostVSDiskCache::StoreData(uint32_t eventID, MeshDataStage stage, bool index,
+                                const std::vector<byte> &data)
+{
+  Key key = {eventID, index ? 1U : 0U, (uint32_t)stage};
+
+  if(m_File == NULL || data.empty() || data.size() > LZ4_MAX_INPUT_SIZE ||
+     m_Data.find(key) != m_Data.end())
+    return;
+
+  std::vector<byte> compressed(LZ4_COMPRESSBOUND(data.size()));
+
+  int size = LZ4_compress_default((const char *)&data[0], (char *)&compressed[0], (int)data.size(),
+                                  (int)compressed.size());
+
+  if(size <= 0)
+    return;
+
+  AppendRecord(PostVSRecord_Data, key, &compressed[0], (uint64_t)size, data.size());
+}
+
+void PostVSDiskCache::AppendRecord(uint32_t type, const Key &key, const void *payload,
+                                   uint64_t size, uint64_t uncompressedSize)
+{
+  PostVSDiskCacheRecord rec = {type, key.eventID, key.index, key.stage, size, uncompressedSize};
+
+  FileIO::fseek64(m_File, 0, SEEK_END);
+
+  uint64_t offs = FileIO::ftell64(m_File) + sizeof(rec);
+
+  if(FileIO::fwrite(&rec, sizeof(rec), 1, m_File) != 1 ||
+     FileIO::fwrite(payload, (size_t)size, 1, m_File) != 1)
+  {
+    RDCWARN("Couldn't write to post-VS disk cache, disabling it");
+    Close();
+    return;
+  }
+
+  if(type == PostVSRecord_Data)
+  {
+    DataLocation loc = {offs, size, uncompressedSize};
+    m_Data[key] = loc;
+  }
+}
+
 FloatVector HighlightCache::InterpretVertex(byte *data, uint32_t vert, const MeshDisplay &cfg,
                                             byte *end, bool &valid)
 {
@@ -580,3 +1131,16 @@ bool HighlightCache::FetchHighlightPositions(const MeshDisplay &cfg, FloatVector
 
   return valid;
 }
+
+bool MeshPickCache::Matches(uint32_t eventID, const MeshFormat &fmt) const
+{
+  // only the properties that affect the unpacked data matter, the topology and projection only go
+  // into the pick parameters which are always updated.
+  return valid && EID == eventID && mesh.buf == fmt.buf && mesh.offset == fmt.offset &&
+         mesh.stride == fmt.stride && mesh.compCount == fmt.compCount &&
+         mesh.compByteWidth == fmt.compByteWidth && mesh.compType == fmt.compType &&
+         mesh.specialFormat == fmt.specialFormat && mesh.bgraOrder == fmt.bgraOrder &&
+         mesh.numVerts == fmt.numVerts && mesh.baseVertex == fmt.baseVertex &&
+         mesh.idxbuf == fmt.idxbuf && mesh.idxoffs == fmt.idxoffs &&
+         mesh.idxByteWidth == fmt.idxByteWidth;
+}
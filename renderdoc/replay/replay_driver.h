@@ -25,6 +25,8 @@
 
 #pragma once
 
+#include <list>
+#include <map>
 #include "api/replay/renderdoc_replay.h"
 #include "core/core.h"
 #include "maths/vec.h"
@@ -54,17 +56,44 @@ struct GetTextureDataParams
   float blackPoint;
   float whitePoint;
 
+  // optional rectangle of the subresource to read back, in texels of the requested mip. A width of
+  // 0 reads the whole subresource. Drivers that can't read back a region return the whole
+  // subresource instead, so callers must check the returned size.
+  uint32_t regionX;
+  uint32_t regionY;
+  uint32_t regionWidth;
+  uint32_t regionHeight;
+
   GetTextureDataParams()
       : forDiskSave(false),
         typeHint(CompType::Typeless),
         resolve(false),
         remap(eRemap_None),
         blackPoint(0.0f),
-        whitePoint(0.0f)
+        whitePoint(0.0f),
+        regionX(0),
+        regionY(0),
+        regionWidth(0),
+        regionHeight(0)
   {
   }
 };
 
+// a small displayable picture of a texture, see IRemoteDriver::GetTextureThumbnails
+struct TextureThumbnailRequest
+{
+  ResourceId texid;
+  CompType typeHint;
+};
+
+struct TextureThumbnail
+{
+  uint32_t width = 0;
+  uint32_t height = 0;
+  // tightly packed RGBA8 rows, empty if no thumbnail could be made for the texture
+  vector<byte> rgba;
+};
+
 // these two interfaces define what an API driver implementation must provide
 // to the replay. At minimum it must implement IRemoteDriver which contains
 // all of the functionality that cannot be achieved elsewhere. An IReplayDriver
@@ -90,6 +119,9 @@ public:
 
   virtual vector<DebugMessage> GetDebugMessages() = 0;
 
+  // estimated memory used by the driver, see IReplayController::GetMemoryUsage
+  virtual vector<MemoryUsage> GetMemoryUsage() = 0;
+
   virtual ShaderReflection *GetShader(ResourceId shader, string entryPoint) = 0;
 
   virtual vector<EventUsage> GetUsage(ResourceId id) = 0;
@@ -104,6 +136,16 @@ public:
 
   virtual void ReadLogInitialisation() = 0;
   virtual void ReplayLog(uint32_t endEventID, ReplayLogType replayType) = 0;
+  // move a replay left just before fromEventID by ReplayLog(fromEventID, eReplay_WithoutDraw) on to
+  // just before toEventID, without going back to the start of the frame. Returns false without
+  // replaying anything if the driver can't, in which case the caller must use ReplayLog.
+  virtual bool AdvanceReplay(uint32_t fromEventID, uint32_t toEventID) = 0;
+  // sorted events whose work later replays can skip, because nothing being inspected depends on
+  // their results. That is only worked out from resource usage, so drivers must only skip work
+  // that sets no state, and ignore the list for frames where draws can affect later ones in other
+  // ways, such as through queries. Any state around a skipped drawcall still applies. An empty
+  // list replays everything again. Drivers that can't skip work ignore this.
+  virtual void SetPrunedEvents(const vector<uint32_t> &eventIDs) = 0;
 
   virtual vector<uint32_t> GetPassEvents(uint32_t eventID) = 0;
 
@@ -118,6 +160,10 @@ public:
                              vector<byte> &retData) = 0;
   virtual byte *GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
                                const GetTextureDataParams &params, size_t &dataSize) = 0;
+  // fetches thumbnails of several textures in one go, each scaled to fit within size x size. The
+  // results are in the same order as the requests.
+  virtual vector<TextureThumbnail> GetTextureThumbnails(
+      const vector<TextureThumbnailRequest> &textures, uint32_t size) = 0;
 
   virtual void BuildTargetShader(string source, string entry, const uint32_t compileFlags,
                                  ShaderStage type, ResourceId *id, string *errors) = 0;
@@ -129,16 +175,30 @@ public:
   virtual void DescribeCounter(GPUCounter counterID, CounterDescription &desc) = 0;
   virtual vector<CounterResult> FetchCounters(const vector<GPUCounter> &counterID) = 0;
 
+  // replays the range, recording which mips and tiles of each texture are sampled
+  virtual vector<TextureSamplingFeedback> FetchTextureSampling(uint32_t startEventID,
+                                                               uint32_t endEventID) = 0;
+
   virtual void FillCBufferVariables(ResourceId shader, string entryPoint, uint32_t cbufSlot,
                                     vector<ShaderVariable> &outvars, const vector<byte> &data) = 0;
 
   virtual vector<PixelModification> PixelHistory(vector<EventUsage> events, ResourceId target,
                                                  uint32_t x, uint32_t y, uint32_t slice, uint32_t mip,
                                                  uint32_t sampleIdx, CompType typeHint) = 0;
+  // returns the history for each pixel in the region in row-major order
+  virtual vector<vector<PixelModification> > PixelHistoryRegion(
+      vector<EventUsage> events, ResourceId target, uint32_t x, uint32_t y, uint32_t width,
+      uint32_t height, uint32_t slice, uint32_t mip, uint32_t sampleIdx, CompType typeHint) = 0;
   virtual ShaderDebugTrace DebugVertex(uint32_t eventID, uint32_t vertid, uint32_t instid,
                                        uint32_t idx, uint32_t instOffset, uint32_t vertOffset) = 0;
   virtual ShaderDebugTrace DebugPixel(uint32_t eventID, uint32_t x, uint32_t y, uint32_t sample,
                                       uint32_t primitive) = 0;
+  // returns one trace for each input, in the same order
+  virtual vector<ShaderDebugTrace> DebugVertices(uint32_t eventID,
+                                                 vector<ShaderDebugVertexInput> inputs,
+                                                 uint32_t instOffset, uint32_t vertOffset) = 0;
+  virtual vector<ShaderDebugTrace> DebugPixels(uint32_t eventID,
+                                               vector<ShaderDebugPixelInput> inputs) = 0;
   virtual ShaderDebugTrace DebugThread(uint32_t eventID, const uint32_t groupid[3],
                                        const uint32_t threadid[3]) = 0;
 
@@ -210,6 +270,134 @@ DrawcallDescription *SetupDrawcallPointers(std::vector<DrawcallDescription *> *d
                                            DrawcallDescription *parent,
                                            DrawcallDescription *previous);
 
+MemoryUsage MakeMemoryUsage(const char *category, bool gpu, uint64_t count, uint64_t bytes);
+
+// implements GetTextureThumbnails on top of GetTextureData, by converting the mip closest to the
+// thumbnail size to RGBA8 on the GPU, then filtering it down to size.
+vector<TextureThumbnail> FetchTextureThumbnails(IRemoteDriver *driver,
+                                                const vector<TextureThumbnailRequest> &textures,
+                                                uint32_t size);
+
+// estimated CPU memory held by a shader reflection, including its bytecode and embedded sources
+uint64_t GetShaderReflectionSize(const ShaderReflection &refl);
+
+// number of steps between full states stored in a shader debug trace
+#define SHADER_DEBUG_KEYFRAME_INTERVAL 64
+
+// accumulates the states of a shader debugging simulation as it runs. Only the variables that
+// changed are kept for each step, with a full keyframe every SHADER_DEBUG_KEYFRAME_INTERVAL steps.
+// See ShaderDebug_ReconstructState for rebuilding a given step.
+class ShaderDebugTraceBuilder
+{
+public:
+  void AddState(const ShaderDebugState &state);
+  void Finish(ShaderDebugTrace &trace);
+
+private:
+  ShaderDebugState m_Prev;
+  std::vector<ShaderDebugState> m_Keyframes;
+  std::vector<ShaderDebugStateDelta> m_Steps;
+};
+
+// tracks how much memory each event's post-VS data uses, in least recently used order, so that a
+// driver can evict old events once the total goes over replay.postVSCache.budget (in MB, 0 for no
+// limit). The driver owns the data itself, and frees whichever events Trim returns.
+class PostVSCacheTracker
+{
+public:
+  struct Stats
+  {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t evictedBytes = 0;
+    uint64_t bytes = 0;
+    uint64_t peakBytes = 0;
+  };
+
+  PostVSCacheTracker();
+  ~PostVSCacheTracker();
+
+  // returns true if the event has data, and marks it as the most recently used
+  bool Lookup(uint32_t eventID);
+  void Insert(uint32_t eventID, uint64_t bytes);
+
+  // returns the events to free to get back within budget, least recently used first. keepEventID
+  // is never returned, as it's about to be used.
+  std::vector<uint32_t> Trim(uint32_t keepEventID);
+
+  const Stats &GetStats() const { return m_Stats; }
+  size_t NumEvents() const { return m_Entries.size(); }
+
+private:
+  struct Entry
+  {
+    uint32_t eventID;
+    uint64_t bytes;
+  };
+
+  uint64_t m_Budget;
+  std::list<Entry> m_LRU;
+  std::map<uint32_t, std::list<Entry>::iterator> m_Entries;
+  Stats m_Stats;
+};
+
+// optional file in the app folder holding post-transform data fetched for a capture, so reopening
+// the capture doesn't stream-out the same draws again. Enabled with replay.postVSCache.disk = 1.
+// Each draw's vertex and index buffers are stored LZ4 compressed, once per stage, along with the
+// MeshFormat for every instance that was fetched. Only the index is read on open, buffer data is
+// read when it's first used.
+class PostVSDiskCache
+{
+public:
+  PostVSDiskCache() : m_File(NULL) {}
+  ~PostVSDiskCache() { Close(); }
+  // opens the cache for this capture, discarding it if the capture has changed since it was written
+  void Open(const std::string &capturePath);
+  void Close();
+  bool IsOpen() const { return m_File != NULL; }
+  bool Contains(uint32_t eventID) const;
+
+  bool GetFormat(uint32_t eventID, uint32_t instID, MeshDataStage stage, MeshFormat &fmt) const;
+  bool HasData(uint32_t eventID, MeshDataStage stage, bool index) const;
+  bool GetData(uint32_t eventID, MeshDataStage stage, bool index, std::vector<byte> &data);
+
+  void StoreFormat(uint32_t eventID, uint32_t instID, MeshDataStage stage, const MeshFormat &fmt);
+  void StoreData(uint32_t eventID, MeshDataStage stage, bool index, const std::vector<byte> &data);
+
+private:
+  struct Key
+  {
+    uint32_t eventID;
+    // the instance for formats, or 0 for vertex and 1 for index data
+    uint32_t index;
+    uint32_t stage;
+
+    bool operator<(const Key &o) const
+    {
+      if(eventID != o.eventID)
+        return eventID < o.eventID;
+      if(index != o.index)
+        return index < o.index;
+      return stage < o.stage;
+    }
+  };
+
+  struct DataLocation
+  {
+    uint64_t offset;
+    uint64_t size;
+    uint64_t uncompressedSize;
+  };
+
+  void AppendRecord(uint32_t type, const Key &key, const void *payload, uint64_t size,
+                    uint64_t uncompressedSize);
+
+  FILE *m_File;
+  std::map<Key, MeshFormat> m_Formats;
+  std::map<Key, DataLocation> m_Data;
+};
+
 // simple cache for when we need buffer data for highlighting
 // vertices, typical use will be lots of vertices in the same
 // mesh, not jumping back and forth much between meshes.
@@ -239,4 +427,26 @@ struct HighlightCache
 
   FloatVector InterpretVertex(byte *data, uint32_t vert, const MeshDisplay &cfg, byte *end,
                               bool useidx, bool &valid);
-};
\ No newline at end of file
+};
+// remembers which mesh a driver last unpacked and uploaded for vertex picking. Clicking around the
+// same draw then only re-runs the pick itself against the data still on the GPU, rather than
+// reading back, converting and uploading every vertex again. Anything that can change buffer
+// contents at the same event (e.g. resource replacement) must Invalidate it.
+class MeshPickCache
+{
+public:
+  MeshPickCache() : valid(false), EID(0) {}
+  bool Matches(uint32_t eventID, const MeshFormat &fmt) const;
+  void Set(uint32_t eventID, const MeshFormat &fmt)
+  {
+    valid = true;
+    EID = eventID;
+    mesh = fmt;
+  }
+  void Invalidate() { valid = false; }
+
+private:
+  bool valid;
+  uint32_t EID;
+  MeshFormat mesh;
+};
@@ -24,6 +24,8 @@
  ******************************************************************************/
 
 #include "common/common.h"
+#include "common/profiler.h"
+#include "maths/camera.h"
 #include "maths/matrix.h"
 #include "serialise/string_utils.h"
 #include "replay_controller.h"
@@ -87,6 +89,10 @@ ReplayOutput::ReplayOutput(ReplayController *parent, WindowingSystem system, voi
 
   RDCEraseEl(m_RenderData);
 
+  m_PickPending = false;
+  RDCEraseEl(m_PickRequest);
+  RDCEraseEl(m_PickResult);
+
   m_PixelContext.outputID = 0;
   m_PixelContext.texture = ResourceId();
   m_PixelContext.depthMode = false;
@@ -105,6 +111,10 @@ ReplayOutput::ReplayOutput(ReplayController *parent, WindowingSystem system, voi
   m_pDevice->GetOutputWindowDimensions(m_MainOutput.outputID, m_Width, m_Height);
 
   m_CustomShaderResourceId = ResourceId();
+
+  RDCEraseEl(m_LastMeshView);
+  RDCEraseEl(m_LastMeshDisplay);
+  m_MeshDisplayReduced = false;
 }
 
 ReplayOutput::~ReplayOutput()
@@ -153,11 +163,15 @@ void ReplayOutput::SetFrameEvent(int eventID)
   for(size_t i = 0; i < m_Thumbnails.size(); i++)
     m_Thumbnails[i].dirty = true;
 
+  m_PickResult.valid = false;
+
   RefreshOverlay();
 }
 
 void ReplayOutput::RefreshOverlay()
 {
+  SCOPED_PROFILE("ReplayOutput::RefreshOverlay", m_EventID);
+
   DrawcallDescription *draw = m_pRenderer->GetDrawcallByEID(m_EventID);
 
   passEvents = m_pDevice->GetPassEvents(m_EventID);
@@ -185,13 +199,21 @@ void ReplayOutput::RefreshOverlay()
 
     if(draw != NULL && (draw->flags & DrawFlags::Drawcall))
     {
-      m_pDevice->InitPostVSBuffers(draw->eventID);
+      m_pRenderer->InitPostVSBuffers(draw->eventID);
 
       if(postVSWholePass && !passEvents.empty())
       {
-        m_pDevice->InitPostVSBuffers(passEvents);
+        vector<uint32_t> uncached;
+        for(size_t i = 0; i < passEvents.size(); i++)
+          if(!m_pRenderer->m_PostVSDiskCache.Contains(passEvents[i]))
+            uncached.push_back(passEvents[i]);
+
+        if(!uncached.empty())
+        {
+          m_pDevice->InitPostVSBuffers(uncached);
 
-        m_pDevice->ReplayLog(m_EventID, eReplay_WithoutDraw);
+          m_pDevice->ReplayLog(m_EventID, eReplay_WithoutDraw);
+        }
       }
     }
   }
@@ -292,17 +314,30 @@ rdctype::pair<PixelValue, PixelValue> ReplayOutput::GetMinMax()
   uint32_t mip = m_RenderData.texDisplay.mip;
   uint32_t sample = m_RenderData.texDisplay.sampleIdx;
 
+  // custom shader output is re-rendered every time it's displayed, so it can't be cached
   if(m_RenderData.texDisplay.CustomShader != ResourceId() && m_CustomShaderResourceId != ResourceId())
   {
     tex = m_CustomShaderResourceId;
     typeHint = CompType::Typeless;
     slice = 0;
     sample = 0;
+
+    m_pDevice->GetMinMax(tex, slice, mip, sample, typeHint, &minval.value_f[0], &maxval.value_f[0]);
+
+    return rdctype::make_pair(minval, maxval);
   }
 
-  m_pDevice->GetMinMax(tex, slice, mip, sample, typeHint, &minval.value_f[0], &maxval.value_f[0]);
+  TextureStatsKey key = {tex, slice, mip, sample, typeHint};
+  TextureStats &stats = m_pRenderer->GetTextureStats(key, m_EventID);
+
+  if(!stats.hasMinMax)
+  {
+    m_pDevice->GetMinMax(tex, slice, mip, sample, typeHint, &stats.minval.value_f[0],
+                         &stats.maxval.value_f[0]);
+    stats.hasMinMax = true;
+  }
 
-  return rdctype::make_pair(minval, maxval);
+  return rdctype::make_pair(stats.minval, stats.maxval);
 }
 
 rdctype::array<uint32_t> ReplayOutput::GetHistogram(float minval, float maxval, bool channels[4])
@@ -322,10 +357,36 @@ rdctype::array<uint32_t> ReplayOutput::GetHistogram(float minval, float maxval,
     typeHint = CompType::Typeless;
     slice = 0;
     sample = 0;
+
+    m_pDevice->GetHistogram(tex, slice, mip, sample, typeHint, minval, maxval, channels, hist);
+
+    return hist;
+  }
+
+  uint32_t channelMask = 0;
+  for(int c = 0; c < 4; c++)
+    if(channels[c])
+      channelMask |= 1U << c;
+
+  TextureStatsKey key = {tex, slice, mip, sample, typeHint};
+  TextureStats &stats = m_pRenderer->GetTextureStats(key, m_EventID);
+
+  for(size_t i = 0; i < stats.histograms.size(); i++)
+  {
+    const TextureStats::Histogram &h = stats.histograms[i];
+    if(h.minval == minval && h.maxval == maxval && h.channels == channelMask)
+      return h.buckets;
   }
 
   m_pDevice->GetHistogram(tex, slice, mip, sample, typeHint, minval, maxval, channels, hist);
 
+  // only keep a few ranges, the oldest is least likely to be requested again
+  if(stats.histograms.size() >= 8)
+    stats.histograms.erase(stats.histograms.begin());
+
+  TextureStats::Histogram h = {minval, maxval, channelMask, hist};
+  stats.histograms.push_back(h);
+
   return hist;
 }
 
@@ -398,6 +459,36 @@ PixelValue ReplayOutput::PickPixel(ResourceId tex, bool customShader, uint32_t x
   return ret;
 }
 
+void ReplayOutput::RequestPickPixel(ResourceId texID, bool customShader, uint32_t x, uint32_t y,
+                                    uint32_t sliceFace, uint32_t mip, uint32_t sample)
+{
+  // any earlier request that hasn't been made yet is superseded
+  m_PickRequest.valid = false;
+  m_PickRequest.texID = texID;
+  m_PickRequest.customShader = customShader;
+  m_PickRequest.x = x;
+  m_PickRequest.y = y;
+  m_PickRequest.sliceFace = sliceFace;
+  m_PickRequest.mip = mip;
+  m_PickRequest.sample = sample;
+
+  m_PickPending = true;
+}
+
+void ReplayOutput::ResolvePendingPick()
+{
+  if(!m_PickPending)
+    return;
+
+  m_PickPending = false;
+
+  m_PickResult = m_PickRequest;
+  m_PickResult.value =
+      PickPixel(m_PickRequest.texID, m_PickRequest.customShader != 0, m_PickRequest.x,
+                m_PickRequest.y, m_PickRequest.sliceFace, m_PickRequest.mip, m_PickRequest.sample);
+  m_PickResult.valid = true;
+}
+
 rdctype::pair<uint32_t, uint32_t> ReplayOutput::PickVertex(uint32_t eventID, uint32_t x, uint32_t y)
 {
   DrawcallDescription *draw = m_pRenderer->GetDrawcallByEID(eventID);
@@ -443,14 +534,14 @@ rdctype::pair<uint32_t, uint32_t> ReplayOutput::PickVertex(uint32_t eventID, uin
 
     // used for post-VS output, calculate the offset of the element we're using as position,
     // relative to 0
-    MeshFormat fmt = m_pDevice->GetPostVSBuffers(
+    MeshFormat fmt = m_pRenderer->GetPostVSBuffers(
         draw->eventID, m_RenderData.meshDisplay.curInstance, m_RenderData.meshDisplay.type);
     uint64_t elemOffset = cfg.position.offset - fmt.offset;
 
     for(uint32_t inst = firstInst; inst < maxInst; inst++)
     {
       // find the start of this buffer, and apply the element offset, then pick in that instance
-      fmt = m_pDevice->GetPostVSBuffers(draw->eventID, inst, m_RenderData.meshDisplay.type);
+      fmt = m_pRenderer->GetPostVSBuffers(draw->eventID, inst, m_RenderData.meshDisplay.type);
       if(fmt.buf != ResourceId())
         cfg.position.offset = fmt.offset + elemOffset;
 
@@ -552,6 +643,8 @@ void ReplayOutput::DisplayContext()
 
 void ReplayOutput::Display()
 {
+  SCOPED_PROFILE("ReplayOutput::Display", m_EventID);
+
   if(m_pDevice->CheckResizeOutputWindow(m_MainOutput.outputID))
   {
     m_pDevice->GetOutputWindowDimensions(m_MainOutput.outputID, m_Width, m_Height);
@@ -562,6 +655,23 @@ void ReplayOutput::Display()
     if(m_pDevice->CheckResizeOutputWindow(m_Thumbnails[i].outputID))
       m_Thumbnails[i].dirty = true;
 
+  // thumbnails are displayed from small cached copies where possible, which are fetched together
+  // for all the thumbnails that need them
+  vector<ThumbnailKey> thumbKeys;
+
+  for(size_t i = 0; i < m_Thumbnails.size(); i++)
+  {
+    if(!m_Thumbnails[i].dirty || m_Thumbnails[i].texture == ResourceId() ||
+       !m_pDevice->IsOutputWindowVisible(m_Thumbnails[i].outputID))
+      continue;
+
+    ThumbnailKey key = {m_pDevice->GetLiveID(m_Thumbnails[i].texture), m_Thumbnails[i].typeHint};
+    thumbKeys.push_back(key);
+  }
+
+  if(!thumbKeys.empty())
+    m_pRenderer->UpdateThumbnails(thumbKeys, m_EventID);
+
   for(size_t i = 0; i < m_Thumbnails.size(); i++)
   {
     if(!m_Thumbnails[i].dirty)
@@ -620,6 +730,18 @@ void ReplayOutput::Display()
     if(m_Thumbnails[i].depthMode)
       disp.Green = disp.Blue = false;
 
+    // the range has already been applied to the cached copy. If there isn't one we fall back to
+    // rendering from the texture itself.
+    ThumbnailKey key = {disp.texid, disp.typeHint};
+    ResourceId thumb = m_pRenderer->GetThumbnail(key, m_EventID);
+
+    if(thumb != ResourceId())
+    {
+      disp.texid = thumb;
+      disp.typeHint = CompType::Typeless;
+      disp.rangemin = 0.0f;
+    }
+
     m_pDevice->RenderTexture(disp);
 
     m_pDevice->FlipOutputWindow(m_Thumbnails[i].outputID);
@@ -636,6 +758,7 @@ void ReplayOutput::Display()
     m_pDevice->FlipOutputWindow(m_MainOutput.outputID);
     m_pDevice->BindOutputWindow(m_PixelContext.outputID, false);
     m_pDevice->FlipOutputWindow(m_PixelContext.outputID);
+    ResolvePendingPick();
     return;
   }
 
@@ -651,6 +774,9 @@ void ReplayOutput::Display()
   m_pDevice->FlipOutputWindow(m_MainOutput.outputID);
 
   DisplayContext();
+
+  // picks are made after the frame is submitted, with the custom shader and overlay up to date
+  ResolvePendingPick();
 }
 
 void ReplayOutput::DisplayTex()
@@ -733,6 +859,20 @@ void ReplayOutput::DisplayTex()
   }
 }
 
+// the number of vertices to draw to fit in budget, without leaving a partial primitive
+static uint32_t TruncateToPrimitives(Topology topo, uint32_t budget, uint32_t numVerts)
+{
+  if(numVerts <= budget)
+    return numVerts;
+
+  if(IsStrip(topo))
+    return budget;
+
+  uint32_t primSize = RDCMAX(1U, Topology_NumVerticesPerPrimitive(topo));
+
+  return budget - (budget % primSize);
+}
+
 void ReplayOutput::DisplayMesh()
 {
   DrawcallDescription *draw = m_pRenderer->GetDrawcallByEID(m_EventID);
@@ -797,9 +937,9 @@ void ReplayOutput::DisplayMesh()
         for(uint32_t inst = 0; inst < RDCMAX(1U, draw->numInstances); inst++)
         {
           // get the 'most final' stage
-          MeshFormat fmt = m_pDevice->GetPostVSBuffers(passEvents[i], inst, MeshDataStage::GSOut);
+          MeshFormat fmt = m_pRenderer->GetPostVSBuffers(passEvents[i], inst, MeshDataStage::GSOut);
           if(fmt.buf == ResourceId())
-            fmt = m_pDevice->GetPostVSBuffers(passEvents[i], inst, MeshDataStage::VSOut);
+            fmt = m_pRenderer->GetPostVSBuffers(passEvents[i], inst, MeshDataStage::VSOut);
 
           fmt.meshColor = passDraws;
 
@@ -822,9 +962,9 @@ void ReplayOutput::DisplayMesh()
       for(uint32_t inst = 0; inst < maxInst; inst++)
       {
         // get the 'most final' stage
-        MeshFormat fmt = m_pDevice->GetPostVSBuffers(draw->eventID, inst, MeshDataStage::GSOut);
+        MeshFormat fmt = m_pRenderer->GetPostVSBuffers(draw->eventID, inst, MeshDataStage::GSOut);
         if(fmt.buf == ResourceId())
-          fmt = m_pDevice->GetPostVSBuffers(draw->eventID, inst, MeshDataStage::VSOut);
+          fmt = m_pRenderer->GetPostVSBuffers(draw->eventID, inst, MeshDataStage::VSOut);
 
         fmt.meshColor = otherInstances;
 
@@ -837,6 +977,51 @@ void ReplayOutput::DisplayMesh()
 
   mesh.position.meshColor = drawItself;
 
+  // if the camera or projection changed since the last display, only draw up to a budget of
+  // vertices. The current draw takes priority, then the secondary draws in order.
+  bool viewChanged = false;
+
+  if(mesh.cam)
+  {
+    Matrix4f view = mesh.cam->GetMatrix();
+    viewChanged = memcmp(view.Data(), m_LastMeshView, sizeof(m_LastMeshView)) != 0;
+    memcpy(m_LastMeshView, view.Data(), sizeof(m_LastMeshView));
+  }
+
+  viewChanged |= mesh.ortho != m_LastMeshDisplay.ortho || mesh.fov != m_LastMeshDisplay.fov ||
+                 mesh.aspect != m_LastMeshDisplay.aspect;
+
+  m_LastMeshDisplay = m_RenderData.meshDisplay;
+
+  uint64_t totalVerts = mesh.position.numVerts;
+  for(const MeshFormat &fmt : secondaryDraws)
+    totalVerts += fmt.numVerts;
+
+  m_MeshDisplayReduced = viewChanged && totalVerts > MeshMovingVertexBudget;
+
+  if(m_MeshDisplayReduced)
+  {
+    uint32_t budget = MeshMovingVertexBudget;
+
+    uint32_t numVerts = TruncateToPrimitives(mesh.position.topo, budget, mesh.position.numVerts);
+    mesh.position.numVerts = numVerts;
+    mesh.second.numVerts = RDCMIN(mesh.second.numVerts, numVerts);
+    budget -= numVerts;
+
+    for(size_t i = 0; i < secondaryDraws.size(); i++)
+    {
+      if(budget == 0)
+      {
+        secondaryDraws.resize(i);
+        break;
+      }
+
+      numVerts = TruncateToPrimitives(secondaryDraws[i].topo, budget, secondaryDraws[i].numVerts);
+      secondaryDraws[i].numVerts = numVerts;
+      budget -= numVerts;
+    }
+  }
+
   m_pDevice->RenderMesh(m_EventID, secondaryDraws, mesh);
 }
 
@@ -845,6 +1030,11 @@ extern "C" RENDERDOC_API void RENDERDOC_CC ReplayOutput_SetTextureDisplay(IRepla
 {
   output->SetTextureDisplay(o);
 }
+extern "C" RENDERDOC_API bool32 RENDERDOC_CC ReplayOutput_IsMeshDisplayReduced(IReplayOutput *output)
+{
+  return output->IsMeshDisplayReduced();
+}
+
 extern "C" RENDERDOC_API void RENDERDOC_CC ReplayOutput_SetMeshDisplay(IReplayOutput *output,
                                                                        const MeshDisplay &o)
 {
@@ -922,6 +1112,19 @@ extern "C" RENDERDOC_API void RENDERDOC_CC ReplayOutput_PickPixel(
   *val = output->PickPixel(texID, customShader != 0, x, y, sliceFace, mip, sample);
 }
 
+extern "C" RENDERDOC_API void RENDERDOC_CC ReplayOutput_RequestPickPixel(
+    IReplayOutput *output, ResourceId texID, bool32 customShader, uint32_t x, uint32_t y,
+    uint32_t sliceFace, uint32_t mip, uint32_t sample)
+{
+  output->RequestPickPixel(texID, customShader != 0, x, y, sliceFace, mip, sample);
+}
+
+extern "C" RENDERDOC_API void RENDERDOC_CC ReplayOutput_GetPickedPixel(IReplayOutput *output,
+                                                                       PixelPick *pick)
+{
+  *pick = output->GetPickedPixel();
+}
+
 extern "C" RENDERDOC_API uint32_t RENDERDOC_CC ReplayOutput_PickVertex(IReplayOutput *output,
                                                                        uint32_t eventID, uint32_t x,
                                                                        uint32_t y,
@@ -24,10 +24,13 @@
  ******************************************************************************/
 
 #include "serialiser.h"
+#include <algorithm>
 #include <errno.h>
 #include "3rdparty/lz4/lz4.h"
+#include "3rdparty/miniz/miniz.h"
 #include "common/timing.h"
 #include "core/core.h"
+#include "replay/benchmarks.h"
 #include "serialise/string_utils.h"
 
 #if ENABLED(RDOC_MSVS)
@@ -36,24 +39,43 @@
 #pragma warning(disable : 4422)
 #endif
 
-#if ENABLED(RDOC_DEVEL)
-
 int64_t Chunk::m_LiveChunks = 0;
 int64_t Chunk::m_TotalMem = 0;
-int64_t Chunk::m_MaxChunks = 0;
 
+#if ENABLED(RDOC_DEVEL)
+int64_t Chunk::m_MaxChunks = 0;
 #endif
 
 const uint32_t Serialiser::MAGIC_HEADER = MAKE_FOURCC('R', 'D', 'O', 'C');
 const uint64_t Serialiser::BufferAlignment = 64;
 
+int64_t Serialiser::m_AlignedBufferBytes = 0;
+
 // based on blockStreaming_doubleBuffer.c in lz4 examples
 struct CompressedFileIO
 {
   // large block size
   static const size_t BlockSize = 64 * 1024;
 
-  CompressedFileIO(FILE *f)
+  // how many blocks each worker thread gets in a batch when compressing in parallel
+  static const size_t BlocksPerThread = 8;
+
+  enum Codec
+  {
+    Codec_LZ4,
+    // zlib-style deflate through miniz, slower but with a better ratio. Blocks are always
+    // independent
+    Codec_Deflate,
+  };
+
+  // if numThreads is more than 1, each block is compressed independently without using the
+  // previous block as a dictionary, so that full batches of blocks can be compressed across
+  // several threads and then written out in order. When reading, independent must be set to
+  // match how the data was written.
+  //
+  // level is only used for Codec_Deflate when writing, from 1 (fastest) to 9 (smallest).
+  CompressedFileIO(FILE *f, Codec codec = Codec_LZ4, int level = 0, uint32_t numThreads = 1,
+                   bool independent = false)
   {
     m_F = f;
     LZ4_resetStream(&m_LZ4Comp);
@@ -62,21 +84,55 @@ struct CompressedFileIO
     m_PageIdx = m_PageOffset = 0;
     m_PageData = 0;
 
-    m_CompressSize = LZ4_COMPRESSBOUND(BlockSize);
+    m_Codec = codec;
+    m_Level = RDCCLAMP(level, 1, 9);
+
+    m_CompressSize = RDCMAX((size_t)LZ4_COMPRESSBOUND(BlockSize),
+                            (size_t)mz_compressBound((mz_ulong)BlockSize));
     m_CompressBuf = new byte[m_CompressSize];
+
+    m_NumThreads = RDCMAX(numThreads, 1U);
+    m_Independent = independent || m_NumThreads > 1 || m_Codec != Codec_LZ4;
+
+    // only LZ4 supports streaming with a dictionary, so other codecs always go through the batch
+    // even on one thread
+    m_Batched = m_NumThreads > 1 || m_Codec != Codec_LZ4;
+
+    m_BatchCount = 0;
+    m_NextBatchBlock = 0;
+    m_BaseOffset = 0;
+    m_MappedData = NULL;
+    m_MappedSize = m_MappedStart = m_MappedPos = 0;
+
+    m_DecompressThreads = 1;
+    m_DecompCount = 0;
+    m_NextDecompBlock = 0;
+
+    if(m_Batched)
+    {
+      size_t batchBlocks = m_NumThreads * BlocksPerThread;
+      m_BatchData.resize(batchBlocks * BlockSize);
+      m_BatchComp.resize(batchBlocks * m_CompressSize);
+      m_BatchSizes.resize(batchBlocks);
+      m_BatchCompSizes.resize(batchBlocks);
+    }
   }
 
   ~CompressedFileIO() { SAFE_DELETE_ARRAY(m_CompressBuf); }
-  uint32_t GetCompressedSize() { return m_CompressedSize; }
-  uint32_t GetUncompressedSize() { return m_UncompressedSize; }
+  uint64_t GetCompressedSize() { return m_CompressedSize; }
+  uint64_t GetUncompressedSize() { return m_UncompressedSize; }
+  // offsets of each written block, relative to the start of the compressed data
+  const vector<uint64_t> &GetBlockOffsets() { return m_BlockOffsets; }
+  // when reading, whether a block table was provided with SetBlockTable
+  bool HasBlockTable() { return !m_BlockOffsets.empty(); }
   // write out some data - accumulate into the input pages, then
-  // when a page is full call Flush() to flush it out to disk
+  // when a page is full call FlushPage() to flush it out to disk
   void Write(const void *data, size_t len)
   {
     if(data == NULL || len == 0)
       return;
 
-    m_UncompressedSize += (uint32_t)len;
+    m_UncompressedSize += len;
 
     const byte *src = (const byte *)data;
 
@@ -95,12 +151,12 @@ struct CompressedFileIO
         len = BlockSize - m_PageOffset;
       }
 
-      memcpy(m_InPages[m_PageIdx] + m_PageOffset, src, len);
+      memcpy(CurrentPage() + m_PageOffset, src, len);
       m_PageOffset += len;
 
       if(remainder > 0)
       {
-        Flush();    // this will swap the input pages and reset the page offset
+        FlushPage();    // this will swap the input pages and reset the page offset
 
         src += len;
         len = remainder;
@@ -108,9 +164,38 @@ struct CompressedFileIO
     } while(remainder > 0);
   }
 
-  // flush out the current page to disk
+  // flush out any pending data to disk
   void Flush()
   {
+    if(m_Batched)
+    {
+      // don't write out an empty trailing block
+      if(m_PageOffset > 0)
+        FlushPage();
+
+      CompressBatch();
+    }
+    else
+    {
+      FlushPage();
+    }
+  }
+
+  // flush out the current page to disk
+  void FlushPage()
+  {
+    if(m_Batched)
+    {
+      // queue up the page in the batch, and only compress once the batch is full
+      m_BatchSizes[m_BatchCount++] = m_PageOffset;
+      m_PageOffset = 0;
+
+      if(m_BatchCount == m_BatchSizes.size())
+        CompressBatch();
+
+      return;
+    }
+
     // m_PageOffset is the amount written, usually equal to BlockSize except the last block.
     int32_t compSize = LZ4_compress_fast_continue(&m_LZ4Comp, (const char *)m_InPages[m_PageIdx],
                                                   (char *)m_CompressBuf, (int)m_PageOffset,
@@ -122,10 +207,7 @@ struct CompressedFileIO
       return;
     }
 
-    FileIO::fwrite(&compSize, sizeof(compSize), 1, m_F);
-    FileIO::fwrite(m_CompressBuf, 1, compSize, m_F);
-
-    m_CompressedSize += compSize + sizeof(int32_t);
+    WriteBlock(m_CompressBuf, compSize);
 
     m_PageOffset = 0;
     m_PageIdx = 1 - m_PageIdx;
@@ -138,6 +220,93 @@ struct CompressedFileIO
     m_CompressedSize = m_UncompressedSize = 0;
     m_PageIdx = 0;
     m_PageOffset = 0;
+    m_PageData = 0;
+    m_MappedPos = m_MappedStart;
+  }
+
+  // when reading independent blocks, provide the block layout from the block table section so
+  // that Skip() can seek directly to the right block. baseOffset is the file offset of the first
+  // block.
+  void SetBlockTable(uint64_t baseOffset, const vector<byte> &table)
+  {
+    if(!m_Independent || table.size() < sizeof(uint32_t) * 2)
+      return;
+
+    uint32_t blockSize = 0, numBlocks = 0;
+    memcpy(&blockSize, &table[0], sizeof(uint32_t));
+    memcpy(&numBlocks, &table[sizeof(uint32_t)], sizeof(uint32_t));
+
+    if(blockSize != BlockSize || table.size() < sizeof(uint32_t) * 2 + numBlocks * sizeof(uint64_t))
+    {
+      RDCWARN("Unexpected block table layout, ignoring");
+      return;
+    }
+
+    m_BaseOffset = baseOffset;
+    m_BlockOffsets.resize(numBlocks);
+    if(numBlocks > 0)
+      memcpy(&m_BlockOffsets[0], &table[sizeof(uint32_t) * 2], numBlocks * sizeof(uint64_t));
+  }
+
+  // read the compressed blocks directly out of a mapping of the file instead of through the FILE*.
+  // start is the offset in the mapping of the first block
+  void SetMappedSource(const byte *data, uint64_t size, uint64_t start)
+  {
+    m_MappedData = data;
+    m_MappedSize = size;
+    m_MappedStart = m_MappedPos = start;
+  }
+
+  // when reading independent blocks, reads covering several whole blocks decompress them directly
+  // into the destination across this many threads.
+  void SetDecompressThreads(uint32_t numThreads)
+  {
+    m_DecompressThreads = RDCMAX(numThreads, 1U);
+  }
+
+  // skip forward over some data without returning it
+  void Skip(size_t len)
+  {
+    uint64_t target = m_UncompressedSize + len;
+
+    // if we know where the blocks are and the target isn't in the current page, seek directly
+    // to the containing block instead of decompressing everything in between
+    if(!m_BlockOffsets.empty() && len > m_PageData)
+    {
+      size_t block = size_t(target / BlockSize);
+
+      if(block < m_BlockOffsets.size())
+      {
+        if(m_MappedData)
+          m_MappedPos = m_BaseOffset + m_BlockOffsets[block];
+        else
+          FileIO::fseek64(m_F, m_BaseOffset + m_BlockOffsets[block], SEEK_SET);
+
+        FillBuffer();
+
+        size_t inBlock = size_t(target - uint64_t(block) * BlockSize);
+        inBlock = RDCMIN(inBlock, m_PageData);
+
+        m_PageOffset += inBlock;
+        m_PageData -= inBlock;
+        m_UncompressedSize = target;
+        return;
+      }
+    }
+
+    m_UncompressedSize = target;
+
+    do
+    {
+      size_t skipamount = RDCMIN(len, m_PageData);
+
+      m_PageOffset += skipamount;
+      m_PageData -= skipamount;
+      len -= skipamount;
+
+      if(len > 0)
+        FillBuffer();
+    } while(len > 0 && m_PageData > 0);
   }
 
   // read out some data - if the input page is empty we fill
@@ -147,7 +316,7 @@ struct CompressedFileIO
     if(data == NULL || len == 0)
       return;
 
-    m_UncompressedSize += (uint32_t)len;
+    m_UncompressedSize += len;
 
     // loop continually, writing up to BlockSize out of what remains of data
     do
@@ -170,6 +339,18 @@ struct CompressedFileIO
         len -= readamount;
       }
 
+      // the current page is used up, so any whole blocks left to read can skip the pages
+      if(len >= BlockSize * 2 && m_Independent && m_DecompressThreads > 1)
+      {
+        size_t decompressed = DecompressBlocks(data, len);
+
+        data += decompressed;
+        len -= decompressed;
+
+        if(len == 0)
+          break;
+      }
+
       if(len > 0)
         FillBuffer();    // this will swap the input pages and reset the page offset
     } while(len > 0);
@@ -178,16 +359,49 @@ struct CompressedFileIO
   void FillBuffer()
   {
     int32_t compSize = 0;
+    size_t numRead = 0;
+    const byte *compData = m_CompressBuf;
+
+    if(m_MappedData)
+    {
+      if(m_MappedPos + sizeof(compSize) <= m_MappedSize)
+      {
+        memcpy(&compSize, m_MappedData + m_MappedPos, sizeof(compSize));
+        m_MappedPos += sizeof(compSize);
+      }
+
+      compData = m_MappedData + m_MappedPos;
+      numRead = (size_t)RDCMIN(uint64_t(RDCMAX(compSize, 0)), m_MappedSize - m_MappedPos);
+      m_MappedPos += numRead;
+    }
+    else
+    {
+      FileIO::fread(&compSize, sizeof(compSize), 1, m_F);
+      numRead = FileIO::fread(m_CompressBuf, 1, compSize, m_F);
+    }
 
-    FileIO::fread(&compSize, sizeof(compSize), 1, m_F);
-    size_t numRead = FileIO::fread(m_CompressBuf, 1, compSize, m_F);
+    if(numRead < (size_t)RDCMAX(compSize, 0))
+    {
+      RDCERR("Truncated compressed block: %i / %i", int(numRead), compSize);
+      m_PageOffset = 0;
+      m_PageData = 0;
+      return;
+    }
 
     m_CompressedSize += compSize;
 
     m_PageIdx = 1 - m_PageIdx;
 
-    int32_t decompSize = LZ4_decompress_safe_continue(
-        &m_LZ4Decomp, (const char *)m_CompressBuf, (char *)m_InPages[m_PageIdx], compSize, BlockSize);
+    int32_t decompSize = 0;
+
+    if(m_Codec == Codec_Deflate)
+      decompSize = DeflateDecompress(compData, compSize, m_InPages[m_PageIdx]);
+    else if(m_Independent)
+      decompSize = LZ4_decompress_safe((const char *)compData, (char *)m_InPages[m_PageIdx],
+                                       compSize, BlockSize);
+    else
+      decompSize = LZ4_decompress_safe_continue(&m_LZ4Decomp, (const char *)compData,
+                                                (char *)m_InPages[m_PageIdx], compSize, BlockSize);
 
     if(decompSize < 0)
     {
@@ -199,7 +413,7 @@ struct CompressedFileIO
     m_PageData = decompSize;
   }
 
-  static void Decompress(byte *destBuf, const byte *srcBuf, size_t len)
+  static void Decompress(Codec codec, byte *destBuf, const byte *srcBuf, size_t len)
   {
     LZ4_streamDecode_t lz4;
     LZ4_setStreamDecode(&lz4, NULL, 0);
@@ -214,8 +428,13 @@ struct CompressedFileIO
       if(srcBuf + *compSize > srcBufEnd)
         break;
 
-      int32_t decompSize = LZ4_decompress_safe_continue(&lz4, (const char *)srcBuf, (char *)destBuf,
-                                                        *compSize, BlockSize);
+      int32_t decompSize = 0;
+
+      if(codec == Codec_Deflate)
+        decompSize = DeflateDecompress(srcBuf, *compSize, destBuf);
+      else
+        decompSize = LZ4_decompress_safe_continue(&lz4, (const char *)srcBuf, (char *)destBuf,
+                                                  *compSize, BlockSize);
 
       if(decompSize < 0)
         return;
@@ -225,181 +444,815 @@ struct CompressedFileIO
     }
   }
 
-  LZ4_stream_t m_LZ4Comp;
-  LZ4_streamDecode_t m_LZ4Decomp;
-  FILE *m_F;
-  uint32_t m_CompressedSize, m_UncompressedSize;
+private:
+  // read the header and compressed data for the next block, returns false if there isn't one.
+  // src is set to point at the compressed data, which for file reads is copied into buf.
+  bool ReadCompressedBlock(byte *buf, const byte *&src, int32_t &compSize)
+  {
+    compSize = 0;
 
-  byte m_InPages[2][BlockSize];
-  size_t m_PageIdx, m_PageOffset, m_PageData;
+    if(m_MappedData)
+    {
+      if(m_MappedPos + sizeof(compSize) > m_MappedSize)
+        return false;
 
-  byte *m_CompressBuf;
-  size_t m_CompressSize;
-};
+      memcpy(&compSize, m_MappedData + m_MappedPos, sizeof(compSize));
 
-Chunk::Chunk(Serialiser *ser, uint32_t chunkType, bool temporary)
-{
-  m_Length = (uint32_t)ser->GetOffset();
+      if(compSize <= 0 || (size_t)compSize > m_CompressSize ||
+         m_MappedPos + sizeof(compSize) + compSize > m_MappedSize)
+        return false;
 
-  RDCASSERT(ser->GetOffset() < 0xffffffff);
+      m_MappedPos += sizeof(compSize);
+      src = m_MappedData + m_MappedPos;
+      m_MappedPos += compSize;
+      return true;
+    }
 
-  m_ChunkType = chunkType;
+    uint64_t pos = FileIO::ftell64(m_F);
 
-  m_Temporary = temporary;
+    if(FileIO::fread(&compSize, sizeof(compSize), 1, m_F) != 1 || compSize <= 0 ||
+       (size_t)compSize > m_CompressSize ||
+       FileIO::fread(buf, 1, compSize, m_F) != (size_t)compSize)
+    {
+      // leave the block for FillBuffer to report
+      FileIO::fseek64(m_F, pos, SEEK_SET);
+      return false;
+    }
 
-  if(ser->HasAlignedData())
-  {
-    m_Data = Serialiser::AllocAlignedBuffer(m_Length);
-    m_AlignedData = true;
+    src = buf;
+    return true;
   }
-  else
+
+  // decompress as many whole blocks as fit in len straight into data, in batches spread across
+  // m_DecompressThreads threads. Returns how many bytes were decompressed.
+  size_t DecompressBlocks(byte *data, size_t len)
   {
-    m_Data = new byte[m_Length];
-    m_AlignedData = false;
-  }
+    const size_t batchBlocks = m_DecompressThreads * BlocksPerThread;
 
-  memcpy(m_Data, ser->GetRawPtr(0), m_Length);
+    if(m_DecompComp.empty())
+    {
+      m_DecompComp.resize(batchBlocks * m_CompressSize);
+      m_DecompSrc.resize(batchBlocks);
+      m_DecompSrcSizes.resize(batchBlocks);
+      m_DecompDst.resize(batchBlocks);
+      m_DecompSizes.resize(batchBlocks);
+    }
 
-  if(ser->GetDebugText())
-    m_DebugStr = ser->GetDebugStr();
+    size_t total = 0;
 
-  ser->Rewind();
+    while(len >= BlockSize)
+    {
+      size_t count = RDCMIN(len / BlockSize, batchBlocks);
 
-#if ENABLED(RDOC_DEVEL)
-  int64_t newval = Atomic::Inc64(&m_LiveChunks);
-  Atomic::ExchAdd64(&m_TotalMem, m_Length);
+      // the blocks are read in order on this thread, then decompressed in parallel. Each gets a
+      // BlockSize slot, usually exactly filled
+      m_DecompCount = 0;
+      for(size_t i = 0; i < count; i++)
+      {
+        if(!ReadCompressedBlock(&m_DecompComp[i * m_CompressSize], m_DecompSrc[i],
+                                m_DecompSrcSizes[i]))
+          break;
 
-  if(newval > m_MaxChunks)
-  {
-    int breakpointme = 0;
-    (void)breakpointme;
-  }
+        m_DecompDst[i] = data + i * BlockSize;
+        m_DecompCount++;
+      }
 
-  m_MaxChunks = RDCMAX(newval, m_MaxChunks);
-#endif
-}
+      if(m_DecompCount == 0)
+        break;
 
-Chunk *Chunk::Duplicate()
-{
-  Chunk *ret = new Chunk();
-  ret->m_DebugStr = m_DebugStr;
-  ret->m_Length = m_Length;
-  ret->m_ChunkType = m_ChunkType;
-  ret->m_Temporary = m_Temporary;
-  ret->m_AlignedData = m_AlignedData;
+      m_NextDecompBlock = 0;
 
-  if(m_AlignedData)
-    ret->m_Data = Serialiser::AllocAlignedBuffer(m_Length);
-  else
-    ret->m_Data = new byte[m_Length];
+      uint32_t numThreads = RDCMIN(m_DecompressThreads, (uint32_t)m_DecompCount);
 
-  memcpy(ret->m_Data, m_Data, m_Length);
+      vector<Threading::ThreadHandle> threads;
+      for(uint32_t i = 1; i < numThreads; i++)
+      {
+        Threading::ThreadHandle t = Threading::CreateThread(&CompressedFileIO::DecompressWorker, this);
+        if(t)
+          threads.push_back(t);
+      }
 
-#if ENABLED(RDOC_DEVEL)
-  int64_t newval = Atomic::Inc64(&m_LiveChunks);
-  Atomic::ExchAdd64(&m_TotalMem, m_Length);
+      DecompressWorker(this);
 
-  if(newval > m_MaxChunks)
-  {
-    int breakpointme = 0;
-    (void)breakpointme;
-  }
+      for(size_t i = 0; i < threads.size(); i++)
+      {
+        Threading::JoinThread(threads[i]);
+        Threading::CloseThread(threads[i]);
+      }
 
-  m_MaxChunks = RDCMAX(newval, m_MaxChunks);
-#endif
+      // only the last block in the data can be short, but if one isn't the rest is moved down to
+      // keep everything contiguous
+      size_t batchTotal = 0;
+      for(size_t i = 0; i < m_DecompCount; i++)
+      {
+        m_CompressedSize += m_DecompSrcSizes[i];
 
-  return ret;
-}
+        if(m_DecompSizes[i] < 0)
+        {
+          RDCERR("Error decompressing: %i (%i)", m_DecompSizes[i], m_DecompSrcSizes[i]);
+          continue;
+        }
 
-Chunk::~Chunk()
-{
-#if ENABLED(RDOC_DEVEL)
-  Atomic::Dec64(&m_LiveChunks);
-  Atomic::ExchAdd64(&m_TotalMem, -int64_t(m_Length));
-#endif
+        if(data + batchTotal != m_DecompDst[i])
+          memmove(data + batchTotal, m_DecompDst[i], m_DecompSizes[i]);
 
-  if(m_AlignedData)
-  {
-    if(m_Data)
-      Serialiser::FreeAlignedBuffer(m_Data);
+        batchTotal += m_DecompSizes[i];
+      }
 
-    m_Data = NULL;
-  }
-  else
-  {
-    SAFE_DELETE_ARRAY(m_Data);
+      data += batchTotal;
+      len -= batchTotal;
+      total += batchTotal;
+
+      if(m_DecompCount < count || batchTotal < m_DecompCount * BlockSize)
+        break;
+    }
+
+    return total;
   }
-}
 
-/*
+  static void DecompressWorker(void *ths)
+  {
+    CompressedFileIO *io = (CompressedFileIO *)ths;
 
- -----------------------------
- File format for version 0x31:
+    for(;;)
+    {
+      int32_t idx = Atomic::Inc32(&io->m_NextDecompBlock) - 1;
 
- uint64_t MAGIC_HEADER;
- uint64_t version = 0x00000031;
- uint64_t filesize;
- uint64_t resolveDBSize;
+      if(idx >= (int32_t)io->m_DecompCount)
+        break;
 
- if(resolveDBSize > 0)
- {
-   byte resolveDB[resolveDBSize];
-   byte paddingTo16Alignment[];
- }
+      const byte *src = io->m_DecompSrc[idx];
+      int32_t srcSize = io->m_DecompSrcSizes[idx];
+      byte *dst = io->m_DecompDst[idx];
 
- byte captureData[]; // remainder of the file
+      if(io->m_Codec == Codec_Deflate)
+        io->m_DecompSizes[idx] = DeflateDecompress(src, srcSize, dst);
+      else
+        io->m_DecompSizes[idx] =
+            LZ4_decompress_safe((const char *)src, (char *)dst, srcSize, BlockSize);
+    }
+  }
 
- -----------------------------
- File format for version 0x32:
+  // decompress one deflate block up to BlockSize, returns the decompressed size or -1 on error
+  static int32_t DeflateDecompress(const byte *src, int32_t srcSize, byte *dst)
+  {
+    mz_ulong destLen = (mz_ulong)BlockSize;
+    int ret = mz_uncompress(dst, &destLen, src, (mz_ulong)srcSize);
+    return ret == MZ_OK ? (int32_t)destLen : -1;
+  }
 
- uint64_t MAGIC_HEADER;
- uint64_t version = 0x00000032;
+  byte *CurrentPage()
+  {
+    if(m_Batched)
+      return &m_BatchData[m_BatchCount * BlockSize];
 
- 1 or more sections:
+    return m_InPages[m_PageIdx];
+  }
 
- Section
- {
-   char isASCII = '\0' or 'A'; // indicates the section is ASCII or binary. ASCII allows for easy
- appending by hand/script
-   if(isASCII == 'A')
-   {
-     // ASCII sections are discouraged for tools, but useful for hand-editing by just
-     // appending a simple text file
-     char newline = '\n';
-     char length[]; // length of just section data below, as decimal string
-     char newline = '\n';
-     char sectionType[]; // section type, see SectionType enum, as decimal string.
-     char newline = '\n';
-     char sectionName[]; // UTF-8 string name of section.
-     char newline = '\n';
-     // sectionName is an arbitrary string. If two sections exist with the
-     // exact same name, the last one to occur in the file will be taken, the
-     // others ignored.
+  void WriteBlock(const byte *data, int32_t compSize)
+  {
+    m_BlockOffsets.push_back(m_CompressedSize);
 
-     byte sectiondata[ interpret(length) ]; // section data
-   }
-   else if(isASCII == '\0')
-   {
-     byte zero[3]; // pad out the above character with 0 bytes. Reserved for future use
-     uint32_t sectionFlags; // section flags - e.g. is compressed or not.
-     uint32_t sectionType; // section type enum, see SectionType. Could be eSectionType_Unknown
-     uint32_t sectionLength; // byte length of the actual section data
-     uint32_t sectionNameLength; // byte length of the string below (minimum 1, for null terminator)
-     char sectionName[sectionNameLength]; // UTF-8 string name of section, optional.
+    FileIO::fwrite(&compSize, sizeof(compSize), 1, m_F);
+    FileIO::fwrite(data, 1, compSize, m_F);
 
-     byte sectiondata[length]; // actual contents of the section
+    m_CompressedSize += compSize + sizeof(int32_t);
+  }
 
-     // note: compressed sections will contain the uncompressed length as a uint64_t
-     // before the compressed data.
-   }
- };
+  // compress all the queued blocks across the worker threads, then write them out in order
+  void CompressBatch()
+  {
+    if(m_BatchCount == 0)
+      return;
 
- // remainder of the file is tightly packed/unaligned section structures.
- // The first section must always be the actual frame capture data in
- // binary form
- Section sections[];
+    m_NextBatchBlock = 0;
 
-*/
+    uint32_t numThreads = RDCMIN(m_NumThreads, (uint32_t)m_BatchCount);
+
+    vector<Threading::ThreadHandle> threads;
+    for(uint32_t i = 1; i < numThreads; i++)
+    {
+      Threading::ThreadHandle t = Threading::CreateThread(&CompressedFileIO::CompressWorker, this);
+      if(t)
+        threads.push_back(t);
+    }
+
+    // this thread works on the batch as well, so it's still processed if no threads could start
+    CompressWorker(this);
+
+    for(size_t i = 0; i < threads.size(); i++)
+    {
+      Threading::JoinThread(threads[i]);
+      Threading::CloseThread(threads[i]);
+    }
+
+    for(size_t i = 0; i < m_BatchCount; i++)
+    {
+      if(m_BatchCompSizes[i] <= 0)
+      {
+        RDCERR("Error compressing: %i", m_BatchCompSizes[i]);
+        continue;
+      }
+
+      WriteBlock(&m_BatchComp[i * m_CompressSize], m_BatchCompSizes[i]);
+    }
+
+    m_BatchCount = 0;
+  }
+
+  static void CompressWorker(void *ths)
+  {
+    CompressedFileIO *io = (CompressedFileIO *)ths;
+
+    for(;;)
+    {
+      int32_t idx = Atomic::Inc32(&io->m_NextBatchBlock) - 1;
+
+      if(idx >= (int32_t)io->m_BatchCount)
+        break;
+
+      const byte *src = &io->m_BatchData[idx * BlockSize];
+      byte *dst = &io->m_BatchComp[idx * io->m_CompressSize];
+
+      if(io->m_Codec == Codec_Deflate)
+      {
+        mz_ulong destLen = (mz_ulong)io->m_CompressSize;
+        int ret = mz_compress2(dst, &destLen, src, (mz_ulong)io->m_BatchSizes[idx], io->m_Level);
+        io->m_BatchCompSizes[idx] = ret == MZ_OK ? (int32_t)destLen : -1;
+      }
+      else
+      {
+        io->m_BatchCompSizes[idx] =
+            LZ4_compress_fast((const char *)src, (char *)dst, (int)io->m_BatchSizes[idx],
+                              (int)io->m_CompressSize, 1);
+      }
+    }
+  }
+
+  LZ4_stream_t m_LZ4Comp;
+  LZ4_streamDecode_t m_LZ4Decomp;
+  FILE *m_F;
+  uint64_t m_CompressedSize, m_UncompressedSize;
+
+  byte m_InPages[2][BlockSize];
+  size_t m_PageIdx, m_PageOffset, m_PageData;
+
+  byte *m_CompressBuf;
+  size_t m_CompressSize;
+
+  Codec m_Codec;
+  int m_Level;
+
+  uint32_t m_NumThreads;
+  bool m_Independent;
+  bool m_Batched;
+
+  // file offset of the first block, only used when reading with a block table
+  uint64_t m_BaseOffset;
+
+  // file mapping to read from, if not NULL
+  const byte *m_MappedData;
+  uint64_t m_MappedSize, m_MappedStart, m_MappedPos;
+
+  // parallel compression batch. m_BatchData holds the uncompressed blocks at BlockSize strides,
+  // m_BatchComp the compressed results at m_CompressSize strides
+  vector<byte> m_BatchData, m_BatchComp;
+  vector<size_t> m_BatchSizes;
+  vector<int32_t> m_BatchCompSizes;
+  size_t m_BatchCount;
+  volatile int32_t m_NextBatchBlock;
+
+  // parallel decompression batch when reading. m_DecompComp holds compressed blocks read from the
+  // file at m_CompressSize strides, m_DecompSrc points either into it or into the mapping
+  uint32_t m_DecompressThreads;
+  vector<byte> m_DecompComp;
+  vector<const byte *> m_DecompSrc;
+  vector<int32_t> m_DecompSrcSizes;
+  vector<byte *> m_DecompDst;
+  vector<int32_t> m_DecompSizes;
+  size_t m_DecompCount;
+  volatile int32_t m_NextDecompBlock;
+
+  vector<uint64_t> m_BlockOffsets;
+};
+
+static bool IsCompressed(uint32_t sectionFlags)
+{
+  return (sectionFlags & (Serialiser::eSectionFlag_LZ4Compressed |
+                          Serialiser::eSectionFlag_DeflateCompressed)) != 0;
+}
+
+static CompressedFileIO::Codec GetCodec(uint32_t sectionFlags)
+{
+  return (sectionFlags & Serialiser::eSectionFlag_DeflateCompressed) ? CompressedFileIO::Codec_Deflate
+                                                                     : CompressedFileIO::Codec_LZ4;
+}
+
+string BenchmarkCompression(uint32_t sizeMB)
+{
+  const size_t size = RDCMAX(1U, sizeMB) * 1024 * 1024;
+
+  // somewhat compressible data, with runs and gradients similar to texture and buffer contents
+  vector<byte> data(size), readback(size);
+  for(size_t i = 0; i < size; i++)
+    data[i] = (i & 0x1000) ? byte(i >> 6) : byte((i * 2654435761U) >> 24);
+
+  string path, logfile, target;
+  FileIO::GetDefaultFiles("benchmark", path, logfile, target);
+  path += "_compression.tmp";
+  FileIO::CreateParentDirectory(path);
+
+  struct
+  {
+    const char *name;
+    CompressedFileIO::Codec codec;
+    int level;
+    uint32_t threads;
+  } cases[] = {
+      {"LZ4", CompressedFileIO::Codec_LZ4, 0, 1},
+      {"LZ4 x4", CompressedFileIO::Codec_LZ4, 0, 4},
+      {"deflate 1", CompressedFileIO::Codec_Deflate, 1, 1},
+      {"deflate 1 x4", CompressedFileIO::Codec_Deflate, 1, 4},
+      {"deflate 6 x4", CompressedFileIO::Codec_Deflate, 6, 4},
+  };
+
+  string ret = StringFormat::Fmt("CompressedFileIO over %u MB\n", RDCMAX(1U, sizeMB));
+
+  for(size_t c = 0; c < ARRAY_COUNT(cases); c++)
+  {
+    FILE *f = FileIO::fopen(path.c_str(), "w+b");
+
+    if(!f)
+    {
+      ret += StringFormat::Fmt("  Couldn't open '%s'\n", path.c_str());
+      break;
+    }
+
+    uint64_t compSize = 0;
+    double writeMS = 0.0, readMS = 0.0;
+
+    {
+      PerformanceTimer timer;
+      CompressedFileIO writer(f, cases[c].codec, cases[c].level, cases[c].threads);
+      writer.Write(&data[0], size);
+      writer.Flush();
+      writeMS = timer.GetMilliseconds();
+      compSize = writer.GetCompressedSize();
+    }
+
+    FileIO::fseek64(f, 0, SEEK_SET);
+
+    {
+      PerformanceTimer timer;
+      CompressedFileIO reader(f, cases[c].codec, 0, 1, cases[c].threads > 1);
+      reader.Read(&readback[0], size);
+      readMS = timer.GetMilliseconds();
+    }
+
+    FileIO::fclose(f);
+
+    double gb = double(size) / (1024.0 * 1024.0 * 1024.0);
+
+    ret += StringFormat::Fmt("  %-12s compress %7.2f GB/s, decompress %7.2f GB/s, ratio %5.2f%s\n",
+                             cases[c].name, gb * 1000.0 / RDCMAX(writeMS, 0.001),
+                             gb * 1000.0 / RDCMAX(readMS, 0.001),
+                             double(size) / double(RDCMAX(compSize, (uint64_t)1)),
+                             readback == data ? "" : " (INCORRECT RESULT)");
+  }
+
+  FileIO::Delete(path.c_str());
+
+  return ret;
+}
+
+// Chunk payloads are small and extremely numerous while capturing, so rather than going to the
+// heap for each one they're sub-allocated from pages owned by the allocating thread. A page counts
+// the payloads still alive in it and is freed in one go once they are all gone.
+// Only chunks recorded while a frame is being captured use pages, since those are discarded
+// together with the frame. Chunks recorded outside a capture mostly live on in resource records,
+// and a single one of them would keep a whole page alive, so they go to the heap like larger
+// payloads do. Every payload has a page header either way, so it can be shared by reference.
+struct ChunkPage
+{
+  // one reference for each live chunk using the page, plus one held by the owning thread while
+  // it's still allocating from the page
+  volatile int32_t refcount;
+  uint32_t used;
+};
+
+static const uint32_t ChunkPageSize = 256 * 1024;
+
+// larger payloads are allocated on their own so that pages don't end up mostly empty
+static const uint32_t ChunkPageMaxAlloc = 32 * 1024;
+
+// chunks at least this big take ownership of the serialiser's buffer instead of copying it
+static const uint32_t ChunkStealMinSize = 1024 * 1024;
+
+static void ReleaseChunkPage(ChunkPage *page)
+{
+  if(Atomic::Dec32(&page->refcount) == 0)
+    Serialiser::FreeAlignedBuffer((byte *)page);
+}
+
+// the page a thread is currently allocating from. These are registered globally so that the
+// threads' references can be dropped when a capture ends, including for threads that have exited.
+// The lock is only ever contended at that point.
+struct ChunkPageThreadState
+{
+  Threading::CriticalSection lock;
+  ChunkPage *page;
+};
+
+static uint64_t ChunkPageTLSSlot = Threading::AllocateTLSSlot();
+static Threading::CriticalSection ChunkPageThreadsLock;
+static vector<ChunkPageThreadState *> ChunkPageThreads;
+
+static ChunkPageThreadState *GetChunkPageThreadState()
+{
+  ChunkPageThreadState *state = (ChunkPageThreadState *)Threading::GetTLSValue(ChunkPageTLSSlot);
+
+  if(state == NULL)
+  {
+    state = new ChunkPageThreadState;
+    state->page = NULL;
+
+    Threading::SetTLSValue(ChunkPageTLSSlot, (void *)state);
+
+    SCOPED_LOCK(ChunkPageThreadsLock);
+    ChunkPageThreads.push_back(state);
+  }
+
+  return state;
+}
+
+void Chunk::ReleaseThreadPages()
+{
+  SCOPED_LOCK(ChunkPageThreadsLock);
+
+  for(ChunkPageThreadState *state : ChunkPageThreads)
+  {
+    SCOPED_LOCK(state->lock);
+
+    if(state->page)
+      ReleaseChunkPage(state->page);
+
+    state->page = NULL;
+  }
+}
+
+void Chunk::AllocData()
+{
+  m_Page = NULL;
+  m_DetachedBuffer = false;
+
+  const uint32_t pageAlignment = (uint32_t)Serialiser::BufferAlignment;
+  const uint32_t headerSize = AlignUp((uint32_t)sizeof(ChunkPage), pageAlignment);
+  const uint32_t alignment = m_AlignedData ? pageAlignment : 16;
+
+  if(m_Length > ChunkPageMaxAlloc || !RenderDoc::Inst().IsFrameCapturing())
+  {
+    m_Page = (ChunkPage *)Serialiser::AllocAlignedBuffer(size_t(headerSize + m_Length));
+    m_Page->refcount = 1;
+    // a page of its own is never allocated from, and may be too big for used to hold its size
+    m_Page->used = headerSize;
+
+    m_Data = (byte *)m_Page + headerSize;
+
+    return;
+  }
+
+  ChunkPageThreadState *state = GetChunkPageThreadState();
+
+  SCOPED_LOCK(state->lock);
+
+  ChunkPage *page = state->page;
+
+  uint32_t offs = page ? AlignUp(page->used, alignment) : 0;
+
+  if(page == NULL || offs + m_Length > ChunkPageSize)
+  {
+    // the page is full, so this thread gives up its reference and it will be freed when the last
+    // payload in it is
+    if(page)
+      ReleaseChunkPage(page);
+
+    page = (ChunkPage *)Serialiser::AllocAlignedBuffer(ChunkPageSize);
+    page->refcount = 1;
+    page->used = headerSize;
+
+    state->page = page;
+
+    offs = headerSize;
+  }
+
+  Atomic::Inc32(&page->refcount);
+  page->used = offs + (uint32_t)m_Length;
+
+  m_Page = page;
+  m_Data = (byte *)page + offs;
+}
+
+void Chunk::FreeData()
+{
+  if(m_Page)
+  {
+    ReleaseChunkPage(m_Page);
+    m_Page = NULL;
+    m_Data = NULL;
+  }
+  else if(m_DetachedBuffer)
+  {
+    if(m_Data)
+      Serialiser::FreeAlignedBuffer(m_Data);
+
+    m_Data = NULL;
+  }
+}
+
+Chunk::Chunk(Serialiser *ser, uint32_t chunkType, bool temporary)
+{
+  m_Length = ser->GetOffset();
+
+  m_ChunkType = chunkType;
+
+  m_Temporary = temporary;
+
+  m_AlignedData = ser->HasAlignedData();
+
+  if(ser->IsWriting())
+  {
+    m_Timestamp = Timing::GetTimestamp();
+    m_ThreadID = Threading::GetCurrentID();
+  }
+  else
+  {
+    m_Timestamp = m_ThreadID = 0;
+  }
+
+  // a large chunk is nearly always a single big buffer (an upload, initial contents) that has
+  // just grown the serialiser's buffer to fit. Rather than copying it a second time, take the
+  // buffer itself and let the serialiser start a fresh one. Only do this when little of the
+  // buffer would be wasted, so a buffer left large by an earlier chunk isn't handed out for a
+  // much smaller one
+  if(ser->IsWriting() && m_Length >= ChunkStealMinSize &&
+     ser->GetBufferCapacity() <= (uint64_t)m_Length * 2)
+  {
+    m_Page = NULL;
+    m_DetachedBuffer = true;
+    m_Data = ser->DetachBuffer();
+  }
+  else
+  {
+    AllocData();
+
+    memcpy(m_Data, ser->GetRawPtr(0), (size_t)m_Length);
+  }
+
+  if(ser->GetDebugText())
+    m_DebugStr = ser->GetDebugStr();
+
+  ser->Rewind();
+
+  CountLiveChunk();
+}
+
+Chunk *Chunk::Duplicate()
+{
+  Chunk *ret = CopyHeader();
+
+  ret->AllocData();
+
+  memcpy(ret->m_Data, m_Data, (size_t)m_Length);
+
+  return ret;
+}
+
+Chunk *Chunk::Share()
+{
+  // a serialiser buffer that was taken over has no page to count references in
+  if(m_Page == NULL)
+    return Duplicate();
+
+  Chunk *ret = CopyHeader();
+
+  Atomic::Inc32(&m_Page->refcount);
+
+  ret->m_Page = m_Page;
+  ret->m_Data = m_Data;
+  ret->m_DetachedBuffer = false;
+
+  return ret;
+}
+
+Chunk *Chunk::AllocRaw(uint32_t chunkType, uint64_t length, bool aligned, uint64_t timestamp,
+                       uint64_t threadID)
+{
+  Chunk *ret = new Chunk();
+  ret->m_ChunkType = chunkType;
+  ret->m_Length = length;
+  ret->m_Temporary = true;
+  ret->m_AlignedData = aligned;
+  ret->m_Timestamp = timestamp;
+  ret->m_ThreadID = threadID;
+
+  ret->AllocData();
+
+  ret->CountLiveChunk();
+
+  return ret;
+}
+
+Chunk *Chunk::CopyHeader()
+{
+  Chunk *ret = new Chunk();
+  ret->m_DebugStr = m_DebugStr;
+  ret->m_Length = m_Length;
+  ret->m_ChunkType = m_ChunkType;
+  ret->m_Temporary = m_Temporary;
+  ret->m_AlignedData = m_AlignedData;
+  ret->m_Timestamp = m_Timestamp;
+  ret->m_ThreadID = m_ThreadID;
+
+  ret->CountLiveChunk();
+
+  return ret;
+}
+
+void Chunk::CountLiveChunk()
+{
+  // shared payloads are counted once for every chunk using them
+  Atomic::ExchAdd64(&m_TotalMem, m_Length);
+
+#if ENABLED(RDOC_DEVEL)
+  int64_t newval = Atomic::Inc64(&m_LiveChunks);
+
+  if(newval > m_MaxChunks)
+  {
+    int breakpointme = 0;
+    (void)breakpointme;
+  }
+
+  m_MaxChunks = RDCMAX(newval, m_MaxChunks);
+#else
+  Atomic::Inc64(&m_LiveChunks);
+#endif
+}
+
+Chunk::~Chunk()
+{
+  Atomic::Dec64(&m_LiveChunks);
+  Atomic::ExchAdd64(&m_TotalMem, -int64_t(m_Length));
+
+  FreeData();
+}
+
+/*
+
+ -----------------------------
+ File format for version 0x31:
+
+ uint64_t MAGIC_HEADER;
+ uint64_t version = 0x00000031;
+ uint64_t filesize;
+ uint64_t resolveDBSize;
+
+ if(resolveDBSize > 0)
+ {
+   byte resolveDB[resolveDBSize];
+   byte paddingTo16Alignment[];
+ }
+
+ byte captureData[]; // remainder of the file
+
+ -----------------------------
+ File format for version 0x32 and 0x33:
+
+ uint64_t MAGIC_HEADER;
+ uint64_t version = 0x00000033;
+
+ 1 or more sections:
+
+ Section
+ {
+   char isASCII = '\0' or 'A'; // indicates the section is ASCII or binary. ASCII allows for easy
+ appending by hand/script
+   if(isASCII == 'A')
+   {
+     // ASCII sections are discouraged for tools, but useful for hand-editing by just
+     // appending a simple text file
+     char newline = '\n';
+     char length[]; // length of just section data below, as decimal string
+     char newline = '\n';
+     char sectionType[]; // section type, see SectionType enum, as decimal string.
+     char newline = '\n';
+     char sectionName[]; // UTF-8 string name of section.
+     char newline = '\n';
+     // sectionName is an arbitrary string. If two sections exist with the
+     // exact same name, the last one to occur in the file will be taken, the
+     // others ignored.
+
+     byte sectiondata[ interpret(length) ]; // section data
+   }
+   else if(isASCII == '\0')
+   {
+     byte zero[3]; // pad out the above character with 0 bytes. Reserved for future use
+     uint32_t sectionFlags; // section flags - e.g. is compressed or not.
+     uint32_t sectionType; // section type enum, see SectionType. Could be eSectionType_Unknown
+     uint32_t sectionLength; // byte length of the actual section data
+     uint32_t sectionNameLength; // byte length of the string below (minimum 1, for null terminator)
+     char sectionName[sectionNameLength]; // UTF-8 string name of section, optional.
+
+     byte sectiondata[length]; // actual contents of the section
+
+     // note: compressed sections will contain the uncompressed length as a uint64_t
+     // before the compressed data.
+   }
+ };
+
+ // LZ4 or deflate compressed data is a sequence of blocks, each decompressing to at most 64kB:
+ Block
+ {
+   int32_t compressedSize;
+   byte compressedData[compressedSize];
+ };
+
+ // By default each block uses the previous one as a dictionary, so they must be decompressed
+ // in order. If the section has eSectionFlag_LZ4IndependentBlocks then every block can be
+ // decompressed on its own, and a 'renderdoc/internal/blocktable' section follows with the
+ // layout of the blocks. Deflate blocks (eSectionFlag_DeflateCompressed) are always independent:
+ BlockTable
+ {
+   uint32_t uncompressedBlockSize; // every block except the last decompresses to this size
+   uint32_t numBlocks;
+   uint64_t blockOffset[numBlocks]; // offset of each Block, relative to the first
+ };
+
+ // Optionally a 'renderdoc/internal/chunkindex' section lists every top-level chunk in the frame
+ // capture data so readers can seek directly to a chunk instead of walking the chunk headers.
+ // Captures without it are read by scanning as before.
+ ChunkIndex
+ {
+   uint64_t numChunks;
+   Serialiser::ChunkIndexEntry
+   {
+     uint64_t offset; // offset of the chunk header in the uncompressed frame capture data
+     uint32_t chunkType;
+     uint32_t reserved; // always 0
+     uint64_t length; // length including the header
+   } entries[numChunks];
+ };
+
+ // If buffers were deduplicated, a 'renderdoc/internal/dedupbuffers' section lists the hashes of
+ // those that are referred back to, so readers only need to keep those copies.
+ DedupBuffers
+ {
+   uint64_t numHashes;
+   uint64_t hashes[numHashes];
+ };
+
+ // Chunk headers don't contain their callstack, only its index in a table of every unique
+ // callstack, which is written in a 'renderdoc/internal/callstacks' section. Older captures have
+ // the addresses inline in each chunk header instead.
+ CallstackTable
+ {
+   uint32_t numCallstacks;
+   uint32_t offsets[numCallstacks + 1]; // stack i is addrs[offsets[i]] to addrs[offsets[i+1]]
+   uint64_t addrs[offsets[numCallstacks]];
+ };
+
+ // A 'renderdoc/internal/cputimeline' section records when and on which thread each top-level
+ // chunk was recorded, in the same order as the chunk index.
+ CPUTimeline
+ {
+   uint64_t numChunks;
+   double tickFrequency; // ticks per millisecond of the timestamps
+   Serialiser::ChunkTimingEntry
+   {
+     uint64_t timestamp;
+     uint64_t threadID;
+   } entries[numChunks];
+ };
+
+ // A 'renderdoc/internal/metadata' section holds a summary of the capture (driver, machine,
+ // frame number and thumbnail), see RenderDoc::ReadCaptureMetadata. When present it's always the
+ // first section, uncompressed, so it can be read without scanning the rest of the file.
+
+ // remainder of the file is tightly packed/unaligned section structures.
+ // The first section must always be the actual frame capture data in
+ // binary form, after the metadata section if there is one
+ Section sections[];
+
+ // Version 0x33 has the same layout, but buffers inside the frame capture data can be stored
+ // deduplicated. Their 32-bit length is then 0xffffffff, followed by
+ //   uint64_t hash; uint32_t length; byte isReference;
+ // and the contents only if isReference is 0. See Serialiser::SerialiseBuffer.
+ // A chunk header's callstack length can also be 0xff, followed by a uint32_t index into the
+ // CallstackTable above instead of the addresses. Older versions only have inline addresses.
+ // Chunks of 4GB or more have a 32-bit length of 0xffffffff, then a uint64_t length and padding
+ // to 64 bytes in total. Buffers of 4GB or more have a length of 0xfffffffe then a uint64_t length.
+ // In version 0x32 the ChunkIndex entries had a 32-bit length and no reserved field.
+
+*/
 
 struct FileHeader
 {
@@ -437,7 +1290,7 @@ struct BinarySectionHeader
   }
 
 Serialiser::Serialiser(size_t length, const byte *memoryBuf, bool fileheader)
-    : m_pCallstack(NULL), m_pResolver(NULL), m_Buffer(NULL)
+    : m_pCallstack(NULL), m_pResolver(NULL), m_Buffer(NULL), m_BufferMapped(false), m_MappedFile(NULL)
 {
   m_ResolverThread = 0;
 
@@ -447,6 +1300,10 @@ Serialiser::Serialiser(size_t length, const byte *memoryBuf, bool fileheader)
 
   RDCCOMPILE_ASSERT(offsetof(BinarySectionHeader, name) == sizeof(uint32_t) * 5,
                     "BinarySectionHeader size has changed or contains padding");
+  RDCCOMPILE_ASSERT(sizeof(ChunkIndexEntry) == sizeof(uint64_t) * 3,
+                    "ChunkIndexEntry size has changed or contains padding");
+  RDCCOMPILE_ASSERT(sizeof(ChunkTimingEntry) == sizeof(uint64_t) * 2,
+                    "ChunkTimingEntry size has changed or contains padding");
 
   Reset();
 
@@ -455,6 +1312,9 @@ Serialiser::Serialiser(size_t length, const byte *memoryBuf, bool fileheader)
 
   m_FileSize = 0;
 
+  // in-memory captures don't have the list of referenced buffers
+  m_DedupCacheAll = true;
+
   if(!fileheader)
   {
     m_BufferSize = length;
@@ -533,13 +1393,22 @@ Serialiser::Serialiser(size_t length, const byte *memoryBuf, bool fileheader)
     m_Sections.push_back(frameCap);
     m_KnownSections[eSectionType_FrameCapture] = frameCap;
   }
-  else if(header->version == SERIALISE_VERSION)
+  else if(header->version >= 0x00000032 && header->version <= SERIALISE_VERSION)
   {
     memoryBuf += sizeof(FileHeader);
 
     // when loading in-memory we only care about the first section, which should be binary
     const BinarySectionHeader *sectionHeader = (const BinarySectionHeader *)memoryBuf;
 
+    // skip past the metadata section to the frame capture, if there is one
+    if(memoryBuf + offsetof(BinarySectionHeader, name) < memoryBufEnd &&
+       sectionHeader->isASCII == 0 && sectionHeader->sectionType == eSectionType_Metadata)
+    {
+      memoryBuf += offsetof(BinarySectionHeader, name) + sectionHeader->sectionNameLength +
+                   sectionHeader->sectionLength;
+      sectionHeader = (const BinarySectionHeader *)memoryBuf;
+    }
+
     // verify validity
     if(memoryBuf + offsetof(BinarySectionHeader, name) >= memoryBufEnd)
     {
@@ -624,9 +1493,11 @@ Serialiser::Serialiser(size_t length, const byte *memoryBuf, bool fileheader)
   m_CurrentBufferSize = (size_t)m_BufferSize;
   m_BufferHead = m_Buffer = AllocAlignedBuffer(m_CurrentBufferSize);
 
-  if(m_KnownSections[eSectionType_FrameCapture]->flags & eSectionFlag_LZ4Compressed)
+  uint32_t frameFlags = m_KnownSections[eSectionType_FrameCapture]->flags;
+
+  if(IsCompressed(frameFlags))
   {
-    CompressedFileIO::Decompress(m_Buffer, memoryBuf, memoryBufEnd - memoryBuf);
+    CompressedFileIO::Decompress(GetCodec(frameFlags), m_Buffer, memoryBuf, memoryBufEnd - memoryBuf);
   }
   else
   {
@@ -635,7 +1506,7 @@ Serialiser::Serialiser(size_t length, const byte *memoryBuf, bool fileheader)
 }
 
 Serialiser::Serialiser(const char *path, Mode mode, bool debugMode, uint64_t sizeHint)
-    : m_pCallstack(NULL), m_pResolver(NULL), m_Buffer(NULL)
+    : m_pCallstack(NULL), m_pResolver(NULL), m_Buffer(NULL), m_BufferMapped(false), m_MappedFile(NULL)
 {
   m_ResolverThread = 0;
 
@@ -742,7 +1613,7 @@ Serialiser::Serialiser(const char *path, Mode mode, bool debugMode, uint64_t siz
       m_Sections.push_back(frameCap);
       m_KnownSections[eSectionType_FrameCapture] = frameCap;
     }
-    else if(header.version == SERIALISE_VERSION)
+    else if(header.version >= 0x00000032 && header.version <= SERIALISE_VERSION)
     {
       while(!FileIO::feof(m_ReadFileHandle))
       {
@@ -858,9 +1729,12 @@ Serialiser::Serialiser(const char *path, Mode mode, bool debugMode, uint64_t siz
 
           sect->fileoffset = FileIO::ftell64(m_ReadFileHandle);
 
-          if(sect->flags & eSectionFlag_LZ4Compressed)
+          if(IsCompressed(sect->flags))
           {
-            sect->compressedReader = new CompressedFileIO(m_ReadFileHandle);
+            sect->compressedReader =
+                new CompressedFileIO(m_ReadFileHandle, GetCodec(sect->flags), 0, 1,
+                                     (sect->flags & eSectionFlag_LZ4IndependentBlocks) != 0);
+            sect->compressedReader->SetDecompressThreads(RDCMIN(Threading::GetCPUCount(), 32U));
             FileIO::fread(&sect->size, 1, sizeof(uint64_t), m_ReadFileHandle);
 
             sect->fileoffset += sizeof(uint64_t);
@@ -871,8 +1745,12 @@ Serialiser::Serialiser(const char *path, Mode mode, bool debugMode, uint64_t siz
           m_Sections.push_back(sect);
 
           // if section isn't frame capture data and is small enough, read it all into memory now,
-          // otherwise skip
-          if(sect->type != eSectionType_FrameCapture && sectionHeader.sectionLength < 4 * 1024 * 1024)
+          // otherwise skip. The chunk index, callstack table and CPU timeline are always needed so
+          // they're read regardless of size
+          if(sect->type != eSectionType_FrameCapture &&
+             (sectionHeader.sectionLength < 4 * 1024 * 1024 ||
+              sect->type == eSectionType_ChunkIndex || sect->type == eSectionType_CallstackTable ||
+              sect->type == eSectionType_CPUTimeline))
           {
             sect->data.resize(sectionHeader.sectionLength);
             FileIO::fread(&sect->data[0], 1, sectionHeader.sectionLength, m_ReadFileHandle);
@@ -913,16 +1791,195 @@ Serialiser::Serialiser(const char *path, Mode mode, bool debugMode, uint64_t siz
       return;
     }
 
-    m_BufferSize = m_KnownSections[eSectionType_FrameCapture]->size;
-    m_CurrentBufferSize = (size_t)RDCMIN(m_BufferSize, (uint64_t)64 * 1024);
-    m_BufferHead = m_Buffer = AllocAlignedBuffer(m_CurrentBufferSize);
+    Section *frameCap = m_KnownSections[eSectionType_FrameCapture];
+    Section *blockTable = m_KnownSections[eSectionType_BlockTable];
+    Section *chunkIndex = m_KnownSections[eSectionType_ChunkIndex];
+    Section *dedupBuffers = m_KnownSections[eSectionType_DedupBuffers];
+    Section *callstacks = m_KnownSections[eSectionType_CallstackTable];
+    Section *timeline = m_KnownSections[eSectionType_CPUTimeline];
+
+    if(frameCap->compressedReader && blockTable)
+      frameCap->compressedReader->SetBlockTable(frameCap->fileoffset, blockTable->data);
+
+    // the index was written with 32-bit lengths before version 0x33, just scan those captures
+    if(chunkIndex && m_SerVer >= 0x00000033 && chunkIndex->data.size() >= sizeof(uint64_t))
+    {
+      uint64_t numChunks = 0;
+      memcpy(&numChunks, &chunkIndex->data[0], sizeof(uint64_t));
+
+      if(chunkIndex->data.size() >= sizeof(uint64_t) + numChunks * sizeof(ChunkIndexEntry))
+      {
+        m_ChunkIndex.resize((size_t)numChunks);
+        if(numChunks > 0)
+          memcpy(&m_ChunkIndex[0], &chunkIndex->data[sizeof(uint64_t)],
+                 (size_t)numChunks * sizeof(ChunkIndexEntry));
+      }
+      else
+      {
+        RDCWARN("Truncated chunk index, ignoring");
+      }
+
+      // don't need to keep the raw data around
+      chunkIndex->data.clear();
+    }
+
+    if(timeline && timeline->data.size() >= sizeof(uint64_t) + sizeof(double))
+    {
+      uint64_t numChunks = 0;
+      memcpy(&numChunks, &timeline->data[0], sizeof(uint64_t));
+      memcpy(&m_ChunkTickFrequency, &timeline->data[sizeof(uint64_t)], sizeof(double));
+
+      const size_t headerSize = sizeof(uint64_t) + sizeof(double);
+
+      if(numChunks == m_ChunkIndex.size() && m_ChunkTickFrequency > 0.0 &&
+         timeline->data.size() >= headerSize + numChunks * sizeof(ChunkTimingEntry))
+      {
+        m_ChunkTimings.resize((size_t)numChunks);
+        if(numChunks > 0)
+          memcpy(&m_ChunkTimings[0], &timeline->data[headerSize],
+                 (size_t)numChunks * sizeof(ChunkTimingEntry));
+      }
+      else
+      {
+        RDCWARN("CPU timeline doesn't match chunk index, ignoring");
+      }
+
+      timeline->data.clear();
+    }
+
+    if(dedupBuffers && dedupBuffers->data.size() >= sizeof(uint64_t))
+    {
+      uint64_t numHashes = 0;
+      memcpy(&numHashes, &dedupBuffers->data[0], sizeof(uint64_t));
+
+      if(dedupBuffers->data.size() >= sizeof(uint64_t) + numHashes * sizeof(uint64_t))
+      {
+        const uint64_t *hashes = (const uint64_t *)&dedupBuffers->data[sizeof(uint64_t)];
+        m_DedupReferenced.insert(hashes, hashes + numHashes);
+      }
+      else
+      {
+        RDCWARN("Truncated deduplicated buffer list, ignoring");
+      }
+
+      dedupBuffers->data.clear();
+    }
+
+    // chunk headers refer to callstacks by index into this table, so it must be complete. Every
+    // index read from a chunk is checked against it, and the offsets are checked here so each
+    // callstack lies within the addresses
+    m_FileCallstacks = true;
+
+    if(callstacks)
+    {
+      const byte *data = callstacks->data.data();
+      size_t dataSize = callstacks->data.size();
+
+      uint32_t numCallstacks = 0;
+      if(dataSize >= sizeof(uint32_t))
+        memcpy(&numCallstacks, data, sizeof(uint32_t));
+
+      size_t offsetsSize = (size_t(numCallstacks) + 1) * sizeof(uint32_t);
+      bool valid = dataSize >= sizeof(uint32_t) + offsetsSize;
+
+      if(valid)
+      {
+        m_CallstackOffsets.resize(numCallstacks + 1);
+        memcpy(&m_CallstackOffsets[0], data + sizeof(uint32_t), offsetsSize);
+
+        valid = m_CallstackOffsets[0] == 0;
+        for(uint32_t i = 0; valid && i < numCallstacks; i++)
+          valid = m_CallstackOffsets[i] <= m_CallstackOffsets[i + 1];
+
+        size_t numAddrs = m_CallstackOffsets.back();
+
+        if(valid && dataSize >= sizeof(uint32_t) + offsetsSize + numAddrs * sizeof(uint64_t))
+        {
+          m_CallstackAddrs.resize(numAddrs);
+          if(numAddrs > 0)
+            memcpy(&m_CallstackAddrs[0], data + sizeof(uint32_t) + offsetsSize,
+                   numAddrs * sizeof(uint64_t));
+        }
+        else
+        {
+          valid = false;
+        }
+      }
+
+      callstacks->data.clear();
+
+      if(!valid)
+      {
+        RDCERR("Callstack table is truncated or corrupt");
+
+        m_CallstackOffsets.clear();
+        m_CallstackAddrs.clear();
+
+        m_ErrorCode = eSerError_Corrupt;
+        m_HasError = true;
+        FileIO::fclose(m_ReadFileHandle);
+        m_ReadFileHandle = 0;
+        return;
+      }
+    }
+
+    m_BufferSize = frameCap->size;
     m_ReadOffset = 0;
 
-    FileIO::fseek64(m_ReadFileHandle, m_KnownSections[eSectionType_FrameCapture]->fileoffset,
-                    SEEK_SET);
+    // map the file if possible. Uncompressed frame data can then be used in place without being
+    // read into memory, and compressed data is decompressed directly out of the mapping. The
+    // mapped pages are shared through the OS page cache with anyone else reading the file.
+    const byte *mappedData = NULL;
+    uint64_t mappedSize = 0;
+    m_MappedFile = FileIO::mmap_open(m_Filename.c_str(), &mappedData, &mappedSize);
 
-    // read initial buffer of data
-    ReadFromFile(0, m_CurrentBufferSize);
+    if(m_MappedFile)
+    {
+      uint64_t sectionEnd = frameCap->fileoffset;
+      if(!IsCompressed(frameCap->flags))
+        sectionEnd += frameCap->size;
+
+      if(sectionEnd > mappedSize)
+      {
+        RDCWARN("Frame capture data extends past end of file, not mapping");
+        FileIO::mmap_close(m_MappedFile);
+        m_MappedFile = NULL;
+      }
+    }
+
+    // readers rely on the buffer being aligned like AllocAlignedBuffer's, so uncompressed data can
+    // only be used in place if the section happens to start aligned within the file
+    if(m_MappedFile && !IsCompressed(frameCap->flags) &&
+       (frameCap->fileoffset % BufferAlignment) != 0)
+    {
+      RDCDEBUG("Uncompressed frame capture data isn't aligned in the file, reading it instead");
+      FileIO::mmap_close(m_MappedFile);
+      m_MappedFile = NULL;
+    }
+
+    if(m_MappedFile && !IsCompressed(frameCap->flags))
+    {
+      m_CurrentBufferSize = (size_t)m_BufferSize;
+      m_BufferHead = m_Buffer = (byte *)mappedData + frameCap->fileoffset;
+      m_BufferMapped = true;
+
+      // everything is available, we don't need to read from the file anymore
+      FileIO::fclose(m_ReadFileHandle);
+      m_ReadFileHandle = 0;
+    }
+    else
+    {
+      if(m_MappedFile)
+        frameCap->compressedReader->SetMappedSource(mappedData, mappedSize, frameCap->fileoffset);
+
+      m_CurrentBufferSize = (size_t)RDCMIN(m_BufferSize, (uint64_t)64 * 1024);
+      m_BufferHead = m_Buffer = AllocAlignedBuffer(m_CurrentBufferSize);
+
+      FileIO::fseek64(m_ReadFileHandle, frameCap->fileoffset, SEEK_SET);
+
+      // read initial buffer of data
+      ReadFromFile(0, m_CurrentBufferSize);
+    }
   }
   else
   {
@@ -968,18 +2025,34 @@ void Serialiser::Reset()
 
   SAFE_DELETE(m_pCallstack);
   SAFE_DELETE(m_pResolver);
-  if(m_Buffer)
+  if(m_Buffer && !m_BufferMapped)
   {
     FreeAlignedBuffer(m_Buffer);
     m_Buffer = NULL;
   }
 
+  m_BufferMapped = false;
+
   m_ChunkLookup = NULL;
 
   m_AlignedData = false;
 
+  m_DedupBuffers = false;
+
+  m_FileCallstacks = false;
+
+  m_WriteProgress = NULL;
+  m_WriteStream = NULL;
+  m_DedupCacheAll = false;
+
+  m_CompressLevel = ~0U;
+
+  m_ChunkTickFrequency = 0.0;
+
   m_ReadFileHandle = NULL;
 
+  m_InReadRange = false;
+
   m_ReadOffset = 0;
 
   m_BufferHead = m_Buffer = NULL;
@@ -1009,6 +2082,15 @@ Serialiser::~Serialiser()
     SAFE_DELETE(m_Sections[i]);
   }
 
+  if(m_Buffer && m_BufferMapped)
+    m_Buffer = NULL;
+
+  if(m_MappedFile)
+  {
+    FileIO::mmap_close(m_MappedFile);
+    m_MappedFile = NULL;
+  }
+
   for(size_t i = 0; i < m_Chunks.size(); i++)
   {
     if(m_Chunks[i]->IsTemporary())
@@ -1036,12 +2118,24 @@ void Serialiser::WriteBytes(const byte *buf, size_t nBytes)
     return;
   }
 
+  ReserveWriteSpace(nBytes);
+
+  memcpy(m_BufferHead, buf, nBytes);
+
+  m_BufferHead += nBytes;
+}
+
+void Serialiser::ReserveWriteSpace(size_t nBytes)
+{
   if(m_Buffer + m_BufferSize < m_BufferHead + nBytes + 8)
   {
-    // reallocate
+    // reallocate. Grow geometrically once the buffer is large, so that serialising a big buffer
+    // doesn't step through many intermediate sizes
+    uint64_t growth = RDCMAX(m_BufferSize / 2, (uint64_t)128 * 1024);
+
     while(m_Buffer + m_BufferSize < m_BufferHead + nBytes + 8)
     {
-      m_BufferSize += 128 * 1024;
+      m_BufferSize += growth;
     }
 
     byte *newBuf = AllocAlignedBuffer((size_t)m_BufferSize);
@@ -1055,12 +2149,33 @@ void Serialiser::WriteBytes(const byte *buf, size_t nBytes)
     m_Buffer = newBuf;
     m_BufferHead = newBuf + curUsed;
   }
+}
 
-  memcpy(m_BufferHead, buf, nBytes);
+byte *Serialiser::DetachBuffer()
+{
+  RDCASSERT(m_Mode == WRITING);
 
-  m_BufferHead += nBytes;
+  byte *ret = m_Buffer;
+
+  m_BufferSize = 128 * 1024;
+  m_BufferHead = m_Buffer = AllocAlignedBuffer((size_t)m_BufferSize);
+
+  return ret;
 }
 
+// a chunk length of LargeChunkMarker means the chunk is 4GB or more. A uint64_t with the real
+// length follows, padded out to BufferAlignment so the contents stay aligned as they were written.
+// Only captures of version 0x33 or later can contain the marker, in older ones it's a real length.
+// Writing still builds each chunk contiguously in memory, only reading goes through in pieces.
+static const uint32_t LargeChunkMarker = 0xffffffff;
+
+// likewise a buffer length of LargeBufferMarker is followed by a uint64_t with the real length, in
+// version 0x33 or later
+static const uint32_t LargeBufferMarker = 0xfffffffe;
+
+// large buffers are read through the window in pieces of this size
+static const uint64_t StreamedReadSize = 16 * 1024 * 1024;
+
 void *Serialiser::ReadBytes(size_t nBytes)
 {
   if(m_HasError)
@@ -1069,6 +2184,20 @@ void *Serialiser::ReadBytes(size_t nBytes)
     return NULL;
   }
 
+  // the whole frame capture data is mapped so this can only happen when reading off the end. Take
+  // a copy we own so the normal windowing below can be used
+  if(m_BufferMapped && m_BufferHead + nBytes > m_Buffer + m_CurrentBufferSize)
+  {
+    RDCERR("Reading off the end of mapped capture data");
+
+    byte *copy = AllocAlignedBuffer(m_CurrentBufferSize);
+    memcpy(copy, m_Buffer, m_CurrentBufferSize);
+
+    m_BufferHead = copy + (m_BufferHead - m_Buffer);
+    m_Buffer = copy;
+    m_BufferMapped = false;
+  }
+
   // if we would read off the end of our current window
   if(m_BufferHead + nBytes > m_Buffer + m_CurrentBufferSize)
   {
@@ -1123,6 +2252,23 @@ void *Serialiser::ReadBytes(size_t nBytes)
   return ret;
 }
 
+void Serialiser::ReadStreamed(byte *dst, uint64_t nBytes)
+{
+  while(nBytes > 0 && !m_HasError)
+  {
+    size_t piece = (size_t)RDCMIN(nBytes, StreamedReadSize);
+    void *src = ReadBytes(piece);
+
+    if(dst && src)
+    {
+      memcpy(dst, src, piece);
+      dst += piece;
+    }
+
+    nBytes -= piece;
+  }
+}
+
 void Serialiser::ReadFromFile(uint64_t bufferOffs, size_t length)
 {
   RDCASSERT(m_ReadFileHandle);
@@ -1130,30 +2276,163 @@ void Serialiser::ReadFromFile(uint64_t bufferOffs, size_t length)
   if(m_ReadFileHandle == NULL)
     return;
 
-  Section *s = m_KnownSections[eSectionType_FrameCapture];
+  Section *s = m_KnownSections[eSectionType_FrameCapture];
+
+  RDCASSERT(s);
+
+  if(IsCompressed(s->flags))
+  {
+    RDCASSERT(s->compressedReader);
+    s->compressedReader->Read(m_Buffer + bufferOffs, length);
+  }
+  else
+  {
+    FileIO::fread(m_Buffer + bufferOffs, 1, length, m_ReadFileHandle);
+  }
+}
+
+void Serialiser::SkipFileTo(uint64_t offs)
+{
+  RDCASSERT(m_ReadFileHandle);
+
+  if(m_ReadFileHandle == NULL)
+    return;
+
+  Section *s = m_KnownSections[eSectionType_FrameCapture];
+
+  RDCASSERT(s);
+
+  offs = RDCMIN(offs, m_BufferSize);
+
+  // the file has been read up to the end of the current window
+  uint64_t fileOffs = RDCMIN(m_ReadOffset + m_CurrentBufferSize, m_BufferSize);
+
+  RDCASSERT(offs >= fileOffs);
+
+  if(IsCompressed(s->flags))
+  {
+    RDCASSERT(s->compressedReader);
+    s->compressedReader->Skip(size_t(offs - fileOffs));
+  }
+  else
+  {
+    FileIO::fseek64(m_ReadFileHandle, s->fileoffset + offs, SEEK_SET);
+  }
+
+  m_ReadOffset = offs;
+  m_BufferHead = m_Buffer;
+
+  ReadFromFile(0, (size_t)RDCMIN((uint64_t)m_CurrentBufferSize, m_BufferSize - offs));
+}
+
+void Serialiser::SkipToIndexedChunk(uint32_t chunkIdx, uint32_t *idx)
+{
+  uint64_t offs = GetOffset();
+
+  // find the first chunk at or after our current position
+  size_t first = 0, last = m_ChunkIndex.size();
+  while(first < last)
+  {
+    size_t mid = first + (last - first) / 2;
+    if(m_ChunkIndex[mid].offset < offs)
+      first = mid + 1;
+    else
+      last = mid;
+  }
+
+  for(size_t i = first; i < m_ChunkIndex.size(); i++)
+  {
+    if(m_ChunkIndex[i].chunkType == chunkIdx)
+    {
+      SetOffset(m_ChunkIndex[i].offset);
+      return;
+    }
+
+    if(idx)
+      (*idx)++;
+  }
+
+  // not found, leave the serialiser at the end just like a scan would
+  SetOffset(m_BufferSize);
+}
+
+bool Serialiser::GetChunkTiming(uint64_t offset, uint64_t &microseconds, uint64_t &threadID) const
+{
+  if(m_ChunkTimings.empty())
+    return false;
+
+  // the offset may be before padding that was written ahead of the chunk, so look for the first
+  // chunk at or after it
+  size_t first = 0, last = m_ChunkIndex.size();
+  while(first < last)
+  {
+    size_t mid = first + (last - first) / 2;
+    if(m_ChunkIndex[mid].offset < offset)
+      first = mid + 1;
+    else
+      last = mid;
+  }
+
+  if(first >= m_ChunkTimings.size())
+    return false;
+
+  microseconds = uint64_t(double(m_ChunkTimings[first].timestamp) * 1000.0 / m_ChunkTickFrequency);
+  threadID = m_ChunkTimings[first].threadID;
+
+  return true;
+}
+
+void Serialiser::GetChunkResourceRefs(rdctype::array<ResourceId> &refs) const
+{
+  vector<ResourceId> ids = m_ChunkResourceRefs;
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+  refs = ids;
+}
+
+// buffers at least this big come from VirtualMemory instead of the heap, so they can be backed by
+// large pages. That's only worth it when the buffer spans a few of them.
+static const size_t LargePageBufferThreshold = 4 * 1024 * 1024;
+
+// Aligned buffers have three pointer-sized words stored just before them: the pointer to the start
+// of the real allocation, the size it was allocated from VirtualMemory with, or 0 if it came from
+// the heap, and the size that was asked for.
+byte *Serialiser::AllocAlignedBuffer(size_t size, size_t alignment)
+{
+  const size_t headerSize = sizeof(byte *) * 3;
+
+#if ENABLED(LARGE_PAGE_BUFFERS)
+  // page-aligned buffers may be protected a page at a time, which large pages don't allow
+  if(size >= LargePageBufferThreshold && alignment < WriteWatch::GetPageSize())
+  {
+    size_t allocSize = size + headerSize + alignment;
+    byte *rawAlloc = (byte *)VirtualMemory::Alloc(allocSize, true);
+
+    // if even that failed, let the heap have a go
+    if(rawAlloc)
+    {
+      byte *alignedAlloc = (byte *)AlignUp((size_t)(rawAlloc + headerSize), alignment);
+
+      byte **realPointer = (byte **)alignedAlloc;
+      realPointer[-1] = rawAlloc;
+      realPointer[-2] = (byte *)allocSize;
+      realPointer[-3] = (byte *)size;
 
-  RDCASSERT(s);
+      Atomic::ExchAdd64(&m_AlignedBufferBytes, (int64_t)size);
 
-  if(s->flags & eSectionFlag_LZ4Compressed)
-  {
-    RDCASSERT(s->compressedReader);
-    s->compressedReader->Read(m_Buffer + bufferOffs, length);
-  }
-  else
-  {
-    FileIO::fread(m_Buffer + bufferOffs, 1, length, m_ReadFileHandle);
+      return alignedAlloc;
+    }
   }
-}
+#endif
 
-byte *Serialiser::AllocAlignedBuffer(size_t size, size_t alignment)
-{
   byte *rawAlloc = NULL;
 
 #if defined(__EXCEPTIONS) || defined(_CPPUNWIND)
   try
 #endif
   {
-    rawAlloc = new byte[size + sizeof(byte *) + alignment];
+    rawAlloc = new byte[size + headerSize + alignment];
   }
 #if defined(__EXCEPTIONS) || defined(_CPPUNWIND)
   catch(std::bad_alloc &)
@@ -1167,10 +2446,14 @@ byte *Serialiser::AllocAlignedBuffer(size_t size, size_t alignment)
 
   RDCASSERT(rawAlloc);
 
-  byte *alignedAlloc = (byte *)AlignUp((size_t)(rawAlloc + sizeof(byte *)), alignment);
+  byte *alignedAlloc = (byte *)AlignUp((size_t)(rawAlloc + headerSize), alignment);
 
   byte **realPointer = (byte **)alignedAlloc;
   realPointer[-1] = rawAlloc;
+  realPointer[-2] = NULL;
+  realPointer[-3] = (byte *)size;
+
+  Atomic::ExchAdd64(&m_AlignedBufferBytes, (int64_t)size);
 
   return alignedAlloc;
 }
@@ -1182,8 +2465,14 @@ void Serialiser::FreeAlignedBuffer(byte *buf)
 
   byte **realPointer = (byte **)buf;
   byte *rawAlloc = realPointer[-1];
+  size_t allocSize = (size_t)realPointer[-2];
+
+  Atomic::ExchAdd64(&m_AlignedBufferBytes, -(int64_t)(size_t)realPointer[-3]);
 
-  delete[] rawAlloc;
+  if(allocSize > 0)
+    VirtualMemory::Free(rawAlloc, allocSize);
+  else
+    delete[] rawAlloc;
 }
 
 void Serialiser::SetPersistentBlock(uint64_t offs)
@@ -1194,6 +2483,10 @@ void Serialiser::SetPersistentBlock(uint64_t offs)
   // while reading the chunk header
   RDCASSERT(m_ReadOffset <= offs);
 
+  // if the data is mapped, it's all already available
+  if(m_BufferMapped)
+    return;
+
   // also can't persistent block ahead of where we are
   RDCASSERT(offs < (m_BufferHead - m_Buffer) + m_ReadOffset);
 
@@ -1237,6 +2530,121 @@ void Serialiser::SetPersistentBlock(uint64_t offs)
   m_ReadFileHandle = 0;
 }
 
+bool Serialiser::CanReadRange()
+{
+  if(m_Mode != READING || m_InReadRange)
+    return false;
+
+  // everything is in memory already
+  if(m_ReadOffset == 0 && m_CurrentBufferSize >= m_BufferSize)
+    return true;
+
+  Section *s = m_KnownSections[eSectionType_FrameCapture];
+
+  if(s == NULL || m_Filename.empty())
+    return false;
+
+  // compressed data can only be read from the middle if we know where the blocks are
+  if(IsCompressed(s->flags))
+    return s->compressedReader && s->compressedReader->HasBlockTable() &&
+           m_KnownSections[eSectionType_BlockTable] != NULL;
+
+  return true;
+}
+
+bool Serialiser::BeginReadRange(uint64_t offs, uint64_t length)
+{
+  if(!CanReadRange() || offs + length > m_BufferSize)
+    return false;
+
+  byte *rangeBuf = NULL;
+  bool owned = false;
+
+  if(m_ReadOffset == 0 && m_CurrentBufferSize >= m_BufferSize)
+  {
+    rangeBuf = m_Buffer + offs;
+  }
+  else
+  {
+    Section *s = m_KnownSections[eSectionType_FrameCapture];
+
+    FILE *f = FileIO::fopen(m_Filename.c_str(), "rb");
+
+    if(f == NULL)
+    {
+      RDCERR("Couldn't re-open '%s' to read range", m_Filename.c_str());
+      return false;
+    }
+
+    rangeBuf = AllocAlignedBuffer((size_t)length);
+    owned = true;
+
+    FileIO::fseek64(f, s->fileoffset, SEEK_SET);
+
+    if(IsCompressed(s->flags))
+    {
+      CompressedFileIO reader(f, GetCodec(s->flags), 0, 1,
+                              (s->flags & eSectionFlag_LZ4IndependentBlocks) != 0);
+      reader.SetBlockTable(s->fileoffset, m_KnownSections[eSectionType_BlockTable]->data);
+      reader.Skip((size_t)offs);
+      reader.Read(rangeBuf, (size_t)length);
+    }
+    else
+    {
+      FileIO::fseek64(f, s->fileoffset + offs, SEEK_SET);
+
+      if(FileIO::fread(rangeBuf, 1, (size_t)length, f) != (size_t)length)
+      {
+        RDCERR("Couldn't read range %llu-%llu from '%s'", offs, offs + length, m_Filename.c_str());
+        FileIO::fclose(f);
+        FreeAlignedBuffer(rangeBuf);
+        return false;
+      }
+    }
+
+    FileIO::fclose(f);
+  }
+
+  m_SavedBuffer = m_Buffer;
+  m_SavedBufferHead = m_BufferHead;
+  m_SavedReadOffset = m_ReadOffset;
+  m_SavedBufferSize = m_CurrentBufferSize;
+  m_SavedChunkLen = m_LastChunkLen;
+  m_SavedBufferMapped = m_BufferMapped;
+
+  // the range is treated like mapped data, so it's never re-allocated while reading from it
+  m_BufferHead = m_Buffer = rangeBuf;
+  m_ReadOffset = offs;
+  m_CurrentBufferSize = (size_t)length;
+  m_BufferMapped = true;
+
+  m_InReadRange = true;
+  m_ReadRangeCopy = owned ? rangeBuf : NULL;
+
+  return true;
+}
+
+void Serialiser::EndReadRange()
+{
+  if(!m_InReadRange)
+    return;
+
+  // if we read off the end of the range, ReadBytes took its own copy that we must free too
+  if(!m_BufferMapped)
+    FreeAlignedBuffer(m_Buffer);
+
+  FreeAlignedBuffer(m_ReadRangeCopy);
+
+  m_Buffer = m_SavedBuffer;
+  m_BufferHead = m_SavedBufferHead;
+  m_ReadOffset = m_SavedReadOffset;
+  m_CurrentBufferSize = m_SavedBufferSize;
+  m_LastChunkLen = m_SavedChunkLen;
+  m_BufferMapped = m_SavedBufferMapped;
+
+  m_InReadRange = false;
+}
+
 void Serialiser::SetOffset(uint64_t offs)
 {
   if(m_HasError)
@@ -1258,7 +2666,7 @@ void Serialiser::SetOffset(uint64_t offs)
       RDCASSERT(s);
       FileIO::fseek64(m_ReadFileHandle, s->fileoffset, SEEK_SET);
 
-      if(s->flags & eSectionFlag_LZ4Compressed)
+      if(IsCompressed(s->flags))
       {
         RDCASSERT(s->compressedReader);
         s->compressedReader->Reset();
@@ -1271,43 +2679,434 @@ void Serialiser::SetOffset(uint64_t offs)
     m_BufferHead = m_Buffer = AllocAlignedBuffer(m_CurrentBufferSize);
     m_ReadOffset = offs;
 
-    ReadFromFile(0, m_CurrentBufferSize);
+    ReadFromFile(0, m_CurrentBufferSize);
+  }
+
+  // if we're jumping forward past our in-memory window, skip the file ahead and load the window
+  // from the new offset
+  if(m_Mode == READING && m_ReadFileHandle && offs > m_ReadOffset + m_CurrentBufferSize)
+    SkipFileTo(offs);
+
+  RDCASSERT(m_BufferHead && m_Buffer && offs <= GetSize());
+  m_BufferHead = m_Buffer + offs - m_ReadOffset;
+  m_Indent = 0;
+}
+
+void Serialiser::InitCallstackResolver()
+{
+  if(m_pResolver == NULL && m_ResolverThread == 0 &&
+     m_KnownSections[eSectionType_ResolveDatabase] != NULL)
+  {
+    m_ResolverThreadKillSignal = false;
+    m_ResolverThread = Threading::CreateThread(&Serialiser::CreateResolver, (void *)this);
+  }
+}
+
+void Serialiser::SetCallstack(uint64_t *levels, size_t numLevels)
+{
+  if(m_pCallstack == NULL)
+    m_pCallstack = Callstack::Create();
+
+  m_pCallstack->Set(levels, numLevels);
+}
+
+void Serialiser::CreateResolver(void *ths)
+{
+  Serialiser *ser = (Serialiser *)ths;
+
+  string dir = dirname(ser->m_Filename);
+
+  Section *s = ser->m_KnownSections[Serialiser::eSectionType_ResolveDatabase];
+  RDCASSERT(s);
+
+  Callstack::StackResolver *resolver = Callstack::MakeResolver(
+      (char *)&s->data[0], s->data.size(), dir, &ser->m_ResolverThreadKillSignal);
+
+  // every address that can be asked for is already known from the callstack table, so resolve them
+  // all up front in batches while we're off the main thread. Later lookups then hit the cache.
+  if(resolver && !ser->m_CallstackAddrs.empty())
+  {
+    vector<uint64_t> addrs = ser->m_CallstackAddrs;
+    std::sort(addrs.begin(), addrs.end());
+    addrs.erase(std::unique(addrs.begin(), addrs.end()), addrs.end());
+
+    const size_t batchSize = 1024;
+    vector<Callstack::AddressDetails> details(batchSize);
+
+    for(size_t i = 0; i < addrs.size() && !ser->m_ResolverThreadKillSignal; i += batchSize)
+      resolver->GetAddrs(&addrs[i], RDCMIN(batchSize, addrs.size() - i), &details[0]);
+  }
+
+  ser->m_pResolver = resolver;
+}
+
+static uint64_t HashBuffer(const byte *buf, size_t len);
+
+// a chunk header's callstack length is never this large, so it marks a header that has an index
+// into the callstack table instead
+static const uint8_t CallstackIndexMarker = 0xff;
+
+// Every callstack collected in this process, with each unique stack stored once. The table only
+// grows, since chunks recorded for an earlier capture can still be written into a later one, and
+// the whole table is written into each capture. Threads keep a cache of the stacks they've
+// already interned so that the lock is only taken for a stack the thread hasn't seen before.
+// Stacks are looked up by hash, and the addresses are compared before an entry is reused.
+struct CallstackTable
+{
+  CallstackTable() : threadCacheSlot(Threading::AllocateTLSSlot()) { offsets.push_back(0); }
+  ~CallstackTable()
+  {
+    for(size_t i = 0; i < threadCaches.size(); i++)
+      delete threadCaches[i];
+  }
+
+  // a thread's cached stack, with a copy of its addresses so a hit can be checked without the lock
+  struct CachedStack
+  {
+    uint32_t idx;
+    vector<uint64_t> addrs;
+  };
+
+  uint64_t threadCacheSlot;
+  Threading::CriticalSection lock;
+  vector<map<uint64_t, CachedStack> *> threadCaches;
+
+  std::multimap<uint64_t, uint32_t> lookup;
+  vector<uint32_t> offsets;
+  vector<uint64_t> addrs;
+
+  // must be called with the lock held
+  bool Matches(uint32_t idx, const uint64_t *levels, size_t numLevels) const
+  {
+    uint32_t first = offsets[idx];
+    return offsets[idx + 1] - first == numLevels &&
+           (numLevels == 0 || memcmp(&addrs[first], levels, numLevels * sizeof(uint64_t)) == 0);
+  }
+};
+
+static CallstackTable &GetCallstackTable()
+{
+  static CallstackTable table;
+  return table;
+}
+
+static uint32_t InternCallstack(const uint64_t *levels, size_t numLevels)
+{
+  CallstackTable &table = GetCallstackTable();
+
+  uint64_t hash = HashBuffer((const byte *)levels, numLevels * sizeof(uint64_t));
+
+  typedef map<uint64_t, CallstackTable::CachedStack> ThreadCache;
+
+  ThreadCache *cache = (ThreadCache *)Threading::GetTLSValue(table.threadCacheSlot);
+
+  if(cache)
+  {
+    auto it = cache->find(hash);
+    if(it != cache->end() && it->second.addrs.size() == numLevels &&
+       (numLevels == 0 ||
+        memcmp(&it->second.addrs[0], levels, numLevels * sizeof(uint64_t)) == 0))
+      return it->second.idx;
+  }
+
+  uint32_t idx = ~0U;
+
+  {
+    SCOPED_LOCK(table.lock);
+
+    if(cache == NULL)
+    {
+      cache = new ThreadCache();
+      table.threadCaches.push_back(cache);
+      Threading::SetTLSValue(table.threadCacheSlot, cache);
+    }
+
+    auto range = table.lookup.equal_range(hash);
+    for(auto it = range.first; it != range.second; ++it)
+    {
+      if(table.Matches(it->second, levels, numLevels))
+      {
+        idx = it->second;
+        break;
+      }
+    }
+
+    if(idx == ~0U)
+    {
+      idx = uint32_t(table.offsets.size() - 1);
+      table.lookup.insert(std::make_pair(hash, idx));
+      table.addrs.insert(table.addrs.end(), levels, levels + numLevels);
+      table.offsets.push_back((uint32_t)table.addrs.size());
+    }
+  }
+
+  // a colliding stack just replaces the cached one, it will be found again under the lock
+  CallstackTable::CachedStack &cached = (*cache)[hash];
+  cached.idx = idx;
+  cached.addrs.assign(levels, levels + numLevels);
+
+  return idx;
+}
+
+void Serialiser::SetInternedCallstack(uint32_t idx)
+{
+  if(m_FileCallstacks)
+  {
+    // the offsets were validated against the addresses when the table was loaded
+    if((size_t)idx + 1 < m_CallstackOffsets.size())
+    {
+      uint32_t first = m_CallstackOffsets[idx];
+      SetCallstack(m_CallstackAddrs.data() + first, m_CallstackOffsets[idx + 1] - first);
+      return;
+    }
+
+    RDCERR("Callstack index %u is out of range of the %u in the file", idx,
+           uint32_t(RDCMAX(m_CallstackOffsets.size(), (size_t)1) - 1));
+    m_ErrorCode = eSerError_Corrupt;
+    m_HasError = true;
+    SetCallstack(NULL, 0);
+    return;
+  }
+  else
+  {
+    CallstackTable &table = GetCallstackTable();
+
+    SCOPED_LOCK(table.lock);
+
+    if((size_t)idx + 1 < table.offsets.size())
+    {
+      uint32_t first = table.offsets[idx];
+      SetCallstack(table.addrs.data() + first, table.offsets[idx + 1] - first);
+      return;
+    }
+  }
+
+  RDCERR("Invalid callstack index %u", idx);
+  SetCallstack(NULL, 0);
+}
+
+// the stream is published at most once per this many bytes, as each time flushes the file
+static const uint64_t WriteStreamGranularity = 1024 * 1024;
+
+static void UpdateWriteStream(CaptureWriteStream *stream, FILE *f, uint64_t stableStart,
+                              bool complete)
+{
+  if(stream == NULL)
+    return;
+
+  uint64_t stableEnd = 0;
+
+  if(f)
+  {
+    fflush(f);
+    stableEnd = FileIO::ftell64(f);
+  }
+
+  SCOPED_LOCK(stream->lock);
+  stream->stableStart = stableStart;
+  stream->stableEnd = RDCMAX(stableEnd, stableStart);
+  stream->complete = complete;
+  stream->failed = complete && f == NULL;
+}
+
+bool Serialiser::ReadFileMetadata(const char *path, vector<byte> &data)
+{
+  FILE *f = FileIO::fopen(path, "rb");
+
+  if(!f)
+    return false;
+
+  const char sectionName[] = "renderdoc/internal/metadata";
+
+  FileHeader header;
+  BinarySectionHeader section = {0};
+  char name[sizeof(sectionName)] = {0};
+
+  bool ret = FileIO::fread(&header, 1, sizeof(header), f) == sizeof(header) &&
+             header.magic == MAGIC_HEADER && header.version >= 0x00000032 &&
+             header.version <= SERIALISE_VERSION;
+
+  ret = ret &&
+        FileIO::fread(&section, 1, offsetof(BinarySectionHeader, name), f) ==
+            offsetof(BinarySectionHeader, name) &&
+        section.isASCII == 0 && section.sectionType == eSectionType_Metadata &&
+        section.sectionFlags == eSectionFlag_None && section.sectionNameLength == sizeof(name);
+
+  ret = ret && FileIO::fread(name, 1, sizeof(name), f) == sizeof(name) &&
+        !memcmp(name, sectionName, sizeof(name));
+
+  if(ret)
+  {
+    data.resize(section.sectionLength);
+    ret = data.empty() || FileIO::fread(&data[0], 1, data.size(), f) == data.size();
+  }
+
+  FileIO::fclose(f);
+
+  return ret;
+}
+
+bool Serialiser::ReadRawSections(vector<RawSection> &sections)
+{
+  if(m_Mode != READING || m_Filename.empty())
+    return false;
+
+  // the file handle may already have been closed once the frame capture was in memory
+  FILE *f = FileIO::fopen(m_Filename.c_str(), "rb");
+
+  if(!f)
+    return false;
+
+  bool ret = true;
+
+  for(size_t i = 0; i < m_Sections.size(); i++)
+  {
+    const Section *s = m_Sections[i];
+
+    if(s->type == eSectionType_FrameCapture || s->type == eSectionType_BlockTable ||
+       s->type == eSectionType_ChunkIndex || s->type == eSectionType_DedupBuffers ||
+       s->type == eSectionType_Metadata)
+      continue;
+
+    if(IsCompressed(s->flags))
+    {
+      RDCWARN("Not copying compressed section '%s'", s->name.c_str());
+      continue;
+    }
+
+    RawSection raw;
+    raw.type = s->type;
+    raw.name = s->name;
+    raw.data.resize((size_t)s->size);
+
+    FileIO::fseek64(f, s->fileoffset, SEEK_SET);
+
+    if(!raw.data.empty() && FileIO::fread(&raw.data[0], 1, raw.data.size(), f) != raw.data.size())
+    {
+      RDCERR("Truncated section '%s'", s->name.c_str());
+      ret = false;
+      break;
+    }
+
+    sections.push_back(raw);
+  }
+
+  FileIO::fclose(f);
+
+  return ret;
+}
+
+Chunk *Serialiser::ReadRawChunk()
+{
+  if(m_Mode != READING || m_HasError || m_Indent != 0)
+    return NULL;
+
+  uint16_t c = 0;
+
+  // skip padding, see PushContext
+  while(c == 0)
+  {
+    if(AtEnd())
+      return NULL;
+
+    ReadInto(c);
+
+    if(c == 0)
+    {
+      uint8_t controlByte = 0;
+      ReadInto(controlByte);
+
+      if(controlByte != 0x0)
+      {
+        RDCERR("Unexpected control byte: %x", (uint32_t)controlByte);
+        return NULL;
+      }
+
+      uint8_t padLength = 0;
+      ReadInto(padLength);
+
+      if(padLength > 0)
+        ReadBytes((size_t)padLength);
+    }
+  }
+
+  // buffers in the chunk can only be aligned if the chunk itself was
+  bool aligned = ((GetOffset() - sizeof(c)) % BufferAlignment) == 0;
+
+  // the header is read piece by piece, since the read window can move between reads
+  vector<byte> header;
+  header.insert(header.end(), (byte *)&c, (byte *)&c + sizeof(c));
+
+  if(c & 0x8000)
+  {
+    uint8_t callLen = 0;
+    ReadInto(callLen);
+    header.push_back(callLen);
+
+    size_t callSize = callLen == CallstackIndexMarker && m_SerVer >= 0x00000033
+                          ? sizeof(uint32_t)
+                          : callLen * sizeof(uint64_t);
+    if(callSize > 0)
+    {
+      byte *calls = (byte *)ReadBytes(callSize);
+      header.insert(header.end(), calls, calls + callSize);
+    }
+  }
+
+  uint64_t chunkLen = 0;
+
+  if(c & 0x4000)
+  {
+    uint16_t miniSize = 0;
+    ReadInto(miniSize);
+    header.insert(header.end(), (byte *)&miniSize, (byte *)&miniSize + sizeof(miniSize));
+    chunkLen = miniSize;
+  }
+  else
+  {
+    uint32_t chunkSize = 0;
+    ReadInto(chunkSize);
+    header.insert(header.end(), (byte *)&chunkSize, (byte *)&chunkSize + sizeof(chunkSize));
+    chunkLen = chunkSize;
+
+    if(chunkSize == LargeChunkMarker && m_SerVer >= 0x00000033)
+    {
+      ReadInto(chunkLen);
+      header.insert(header.end(), (byte *)&chunkLen, (byte *)&chunkLen + sizeof(chunkLen));
+
+      const size_t padSize = BufferAlignment - sizeof(chunkLen);
+      byte *pad = (byte *)ReadBytes(padSize);
+      header.insert(header.end(), pad, pad + padSize);
+    }
   }
 
-  RDCASSERT(m_BufferHead && m_Buffer && offs <= GetSize());
-  m_BufferHead = m_Buffer + offs - m_ReadOffset;
-  m_Indent = 0;
-}
+  if(m_HasError)
+    return NULL;
 
-void Serialiser::InitCallstackResolver()
-{
-  if(m_pResolver == NULL && m_ResolverThread == 0 &&
-     m_KnownSections[eSectionType_ResolveDatabase] != NULL)
-  {
-    m_ResolverThreadKillSignal = false;
-    m_ResolverThread = Threading::CreateThread(&Serialiser::CreateResolver, (void *)this);
-  }
-}
+  Chunk *ret = new Chunk();
+  ret->m_ChunkType = c & 0x3fff;
+  ret->m_Length = uint64_t(header.size()) + chunkLen;
+  ret->m_Temporary = true;
+  ret->m_AlignedData = aligned;
+  ret->m_Timestamp = ret->m_ThreadID = 0;
 
-void Serialiser::SetCallstack(uint64_t *levels, size_t numLevels)
-{
-  if(m_pCallstack == NULL)
-    m_pCallstack = Callstack::Create();
+  ret->AllocData();
 
-  m_pCallstack->Set(levels, numLevels);
-}
+  memcpy(ret->m_Data, &header[0], header.size());
+  ReadStreamed(ret->m_Data + header.size(), chunkLen);
 
-void Serialiser::CreateResolver(void *ths)
-{
-  Serialiser *ser = (Serialiser *)ths;
+  ret->CountLiveChunk();
 
-  string dir = dirname(ser->m_Filename);
+  return ret;
+}
 
-  Section *s = ser->m_KnownSections[Serialiser::eSectionType_ResolveDatabase];
-  RDCASSERT(s);
+bool Serialiser::HasRawSection(SectionType type) const
+{
+  for(size_t i = 0; i < m_RawSections.size(); i++)
+    if(m_RawSections[i].type == type)
+      return true;
 
-  ser->m_pResolver = Callstack::MakeResolver((char *)&s->data[0], s->data.size(), dir,
-                                             &ser->m_ResolverThreadKillSignal);
+  return false;
 }
 
 void Serialiser::FlushToDisk()
@@ -1353,6 +3152,7 @@ void Serialiser::FlushToDisk()
       RDCERR("Can't open capture file '%s' for write, errno %d", m_Filename.c_str(), errno);
       m_ErrorCode = eSerError_FileIO;
       m_HasError = true;
+      UpdateWriteStream(m_WriteStream, NULL, 0, true);
       return;
     }
 
@@ -1363,6 +3163,36 @@ void Serialiser::FlushToDisk()
     // write header
     FileIO::fwrite(&header, 1, sizeof(FileHeader), binFile);
 
+    // write the metadata section straight after the header, so it's at a fixed offset
+    if(!m_Metadata.empty())
+    {
+      const char sectionName[] = "renderdoc/internal/metadata";
+
+      BinarySectionHeader section = {0};
+      section.isASCII = 0;                                // redundant but explicit
+      section.sectionNameLength = sizeof(sectionName);    // includes null terminator
+      section.sectionType = eSectionType_Metadata;
+      section.sectionFlags = eSectionFlag_None;
+      section.sectionLength = (uint32_t)m_Metadata.size();
+
+      FileIO::fwrite(&section, 1, offsetof(BinarySectionHeader, name), binFile);
+      FileIO::fwrite(sectionName, 1, sizeof(sectionName), binFile);
+      FileIO::fwrite(&m_Metadata[0], 1, m_Metadata.size(), binFile);
+    }
+
+    // compress across all cores if we can, the blocks become independent which costs a little in
+    // compression ratio but this is typically the bulk of the time spent writing the capture.
+    uint32_t numThreads = RDCMIN(Threading::GetCPUCount(), 32U);
+
+    // level 0 keeps the fast LZ4 path, anything higher trades write time for a smaller capture
+    // with deflate. Deflate blocks are always independent so they get a block table.
+    uint32_t compressLevel = m_CompressLevel != ~0U
+                                 ? m_CompressLevel
+                                 : RenderDoc::Inst().GetCaptureOptions().CompressionLevel;
+    CompressedFileIO::Codec codec =
+        compressLevel > 0 ? CompressedFileIO::Codec_Deflate : CompressedFileIO::Codec_LZ4;
+    bool independentBlocks = numThreads > 1 || codec != CompressedFileIO::Codec_LZ4;
+
     static const byte padding[BufferAlignment] = {0};
 
     uint64_t compressedSizeOffset = 0;
@@ -1376,7 +3206,13 @@ void Serialiser::FlushToDisk()
       section.isASCII = 0;                                // redundant but explicit
       section.sectionNameLength = sizeof(sectionName);    // includes null terminator
       section.sectionType = eSectionType_FrameCapture;
-      section.sectionFlags = eSectionFlag_LZ4Compressed;
+      if(codec == CompressedFileIO::Codec_Deflate)
+        section.sectionFlags = eSectionFlag_DeflateCompressed;
+      else if(numThreads > 1)
+        section.sectionFlags =
+            SectionFlags(eSectionFlag_LZ4Compressed | eSectionFlag_LZ4IndependentBlocks);
+      else
+        section.sectionFlags = eSectionFlag_LZ4Compressed;
       section.sectionLength =
           0;    // will be fixed up later, to avoid having to compress everything into memory
 
@@ -1390,13 +3226,27 @@ void Serialiser::FlushToDisk()
       FileIO::fwrite(&len, 1, sizeof(uint64_t), binFile);
     }
 
-    CompressedFileIO fwriter(binFile);
+    // everything up to here is fixed up at the end
+    uint64_t streamStart = FileIO::ftell64(binFile);
+    uint64_t streamPublished = streamStart;
+    UpdateWriteStream(m_WriteStream, binFile, streamStart, false);
+
+    CompressedFileIO fwriter(binFile, codec, (int)compressLevel, numThreads);
 
     // track offset so we can add padding. The padding is relative
     // to the start of the decompressed buffer, so we start it from 0
     uint64_t offs = 0;
     uint64_t alignedoffs = 0;
 
+    vector<ChunkIndexEntry> chunkIndex;
+    chunkIndex.reserve(m_Chunks.size());
+
+    vector<ChunkTimingEntry> chunkTimings;
+    chunkTimings.reserve(m_Chunks.size());
+
+    // chunks copied from another capture with ReadRawChunk have no timestamps
+    bool hasTimings = false;
+
     // write frame capture contents
     for(size_t i = 0; i < m_Chunks.size(); i++)
     {
@@ -1434,12 +3284,28 @@ void Serialiser::FlushToDisk()
         }
       }
 
-      fwriter.Write(chunk->GetData(), chunk->GetLength());
+      ChunkIndexEntry entry = {offs, chunk->GetChunkType(), 0, chunk->GetLength()};
+      chunkIndex.push_back(entry);
+
+      ChunkTimingEntry timing = {chunk->GetTimestamp(), chunk->GetThreadID()};
+      chunkTimings.push_back(timing);
+      hasTimings |= timing.timestamp != 0;
+
+      fwriter.Write(chunk->GetData(), (size_t)chunk->GetLength());
 
       offs += chunk->GetLength();
 
       if(chunk->IsTemporary())
         SAFE_DELETE(chunk);
+
+      if(m_WriteProgress)
+        *m_WriteProgress = float(i + 1) / float(m_Chunks.size());
+
+      if(m_WriteStream && FileIO::ftell64(binFile) >= streamPublished + WriteStreamGranularity)
+      {
+        UpdateWriteStream(m_WriteStream, binFile, streamStart, false);
+        streamPublished = FileIO::ftell64(binFile);
+      }
     }
 
     fwriter.Flush();
@@ -1455,7 +3321,12 @@ void Serialiser::FlushToDisk()
 
       FileIO::fseek64(binFile, compressedSizeOffset, SEEK_SET);
 
-      compsize = fwriter.GetCompressedSize();
+      // the section length in the header is only 32-bit. The uncompressed size below is 64-bit
+      if(fwriter.GetCompressedSize() > UINT32_MAX)
+        RDCERR("Compressed frame capture data is %llu bytes, too large for the section header",
+               fwriter.GetCompressedSize());
+
+      compsize = (uint32_t)fwriter.GetCompressedSize();
       FileIO::fwrite(&compsize, 1, sizeof(compsize), binFile);
 
       FileIO::fseek64(binFile, uncompressedSizeOffset, SEEK_SET);
@@ -1465,15 +3336,138 @@ void Serialiser::FlushToDisk()
 
       FileIO::fseek64(binFile, curoffs, SEEK_SET);
 
-      RDCLOG("Compressed frame capture data from %u to %u", fwriter.GetUncompressedSize(),
+      RDCLOG("Compressed frame capture data from %llu to %llu", fwriter.GetUncompressedSize(),
              fwriter.GetCompressedSize());
     }
 
+    // write block table section so the blocks can be located without decompressing in order
+    if(independentBlocks)
+    {
+      const char sectionName[] = "renderdoc/internal/blocktable";
+
+      const vector<uint64_t> &offsets = fwriter.GetBlockOffsets();
+
+      uint32_t blockLayout[2] = {
+          (uint32_t)CompressedFileIO::BlockSize, (uint32_t)offsets.size(),
+      };
+
+      BinarySectionHeader section = {0};
+      section.isASCII = 0;                                // redundant but explicit
+      section.sectionNameLength = sizeof(sectionName);    // includes null terminator
+      section.sectionType = eSectionType_BlockTable;
+      section.sectionFlags = eSectionFlag_None;
+      section.sectionLength = uint32_t(sizeof(blockLayout) + offsets.size() * sizeof(uint64_t));
+
+      FileIO::fwrite(&section, 1, offsetof(BinarySectionHeader, name), binFile);
+      FileIO::fwrite(sectionName, 1, sizeof(sectionName), binFile);
+      FileIO::fwrite(blockLayout, 1, sizeof(blockLayout), binFile);
+      if(!offsets.empty())
+        FileIO::fwrite(&offsets[0], sizeof(uint64_t), offsets.size(), binFile);
+    }
+
+    // write the chunk index section
+    {
+      const char sectionName[] = "renderdoc/internal/chunkindex";
+
+      uint64_t numChunks = chunkIndex.size();
+
+      BinarySectionHeader section = {0};
+      section.isASCII = 0;                                // redundant but explicit
+      section.sectionNameLength = sizeof(sectionName);    // includes null terminator
+      section.sectionType = eSectionType_ChunkIndex;
+      section.sectionFlags = eSectionFlag_None;
+      section.sectionLength = uint32_t(sizeof(numChunks) + numChunks * sizeof(ChunkIndexEntry));
+
+      FileIO::fwrite(&section, 1, offsetof(BinarySectionHeader, name), binFile);
+      FileIO::fwrite(sectionName, 1, sizeof(sectionName), binFile);
+      FileIO::fwrite(&numChunks, 1, sizeof(numChunks), binFile);
+      if(!chunkIndex.empty())
+        FileIO::fwrite(&chunkIndex[0], sizeof(ChunkIndexEntry), chunkIndex.size(), binFile);
+    }
+
+    // write the CPU timeline section, so replay can show when each call was made
+    if(hasTimings && !HasRawSection(eSectionType_CPUTimeline))
+    {
+      const char sectionName[] = "renderdoc/internal/cputimeline";
+
+      uint64_t numChunks = chunkTimings.size();
+      double tickFrequency = Timing::GetTimestampFrequency();
+
+      BinarySectionHeader section = {0};
+      section.isASCII = 0;                                // redundant but explicit
+      section.sectionNameLength = sizeof(sectionName);    // includes null terminator
+      section.sectionType = eSectionType_CPUTimeline;
+      section.sectionFlags = eSectionFlag_None;
+      section.sectionLength = uint32_t(sizeof(numChunks) + sizeof(tickFrequency) +
+                                       numChunks * sizeof(ChunkTimingEntry));
+
+      FileIO::fwrite(&section, 1, offsetof(BinarySectionHeader, name), binFile);
+      FileIO::fwrite(sectionName, 1, sizeof(sectionName), binFile);
+      FileIO::fwrite(&numChunks, 1, sizeof(numChunks), binFile);
+      FileIO::fwrite(&tickFrequency, 1, sizeof(tickFrequency), binFile);
+      if(!chunkTimings.empty())
+        FileIO::fwrite(&chunkTimings[0], sizeof(ChunkTimingEntry), chunkTimings.size(), binFile);
+    }
+
+    // write the list of deduplicated buffers that are referenced, so the reader only has to keep
+    // those copies in memory
+    if(!m_DedupReferenced.empty())
+    {
+      const char sectionName[] = "renderdoc/internal/dedupbuffers";
+
+      uint64_t numHashes = m_DedupReferenced.size();
+
+      BinarySectionHeader section = {0};
+      section.isASCII = 0;                                // redundant but explicit
+      section.sectionNameLength = sizeof(sectionName);    // includes null terminator
+      section.sectionType = eSectionType_DedupBuffers;
+      section.sectionFlags = eSectionFlag_None;
+      section.sectionLength = uint32_t(sizeof(numHashes) + numHashes * sizeof(uint64_t));
+
+      FileIO::fwrite(&section, 1, offsetof(BinarySectionHeader, name), binFile);
+      FileIO::fwrite(sectionName, 1, sizeof(sectionName), binFile);
+      FileIO::fwrite(&numHashes, 1, sizeof(numHashes), binFile);
+      for(auto it = m_DedupReferenced.begin(); it != m_DedupReferenced.end(); ++it)
+        FileIO::fwrite(&*it, 1, sizeof(uint64_t), binFile);
+    }
+
+    // write the table of interned callstacks that chunk headers refer to
+    if(!HasRawSection(eSectionType_CallstackTable))
+    {
+      CallstackTable &table = GetCallstackTable();
+
+      SCOPED_LOCK(table.lock);
+
+      if(table.offsets.size() > 1)
+      {
+        const char sectionName[] = "renderdoc/internal/callstacks";
+
+        uint32_t numCallstacks = uint32_t(table.offsets.size() - 1);
+
+        BinarySectionHeader section = {0};
+        section.isASCII = 0;                                // redundant but explicit
+        section.sectionNameLength = sizeof(sectionName);    // includes null terminator
+        section.sectionType = eSectionType_CallstackTable;
+        section.sectionFlags = eSectionFlag_None;
+        section.sectionLength =
+            uint32_t(sizeof(numCallstacks) + table.offsets.size() * sizeof(uint32_t) +
+                     table.addrs.size() * sizeof(uint64_t));
+
+        FileIO::fwrite(&section, 1, offsetof(BinarySectionHeader, name), binFile);
+        FileIO::fwrite(sectionName, 1, sizeof(sectionName), binFile);
+        FileIO::fwrite(&numCallstacks, 1, sizeof(numCallstacks), binFile);
+        FileIO::fwrite(&table.offsets[0], sizeof(uint32_t), table.offsets.size(), binFile);
+        if(!table.addrs.empty())
+          FileIO::fwrite(&table.addrs[0], sizeof(uint64_t), table.addrs.size(), binFile);
+      }
+    }
+
     char *symbolDB = NULL;
     size_t symbolDBSize = 0;
 
-    if(RenderDoc::Inst().GetCaptureOptions().CaptureCallstacks ||
-       RenderDoc::Inst().GetCaptureOptions().CaptureCallstacksOnlyDraws)
+    if(!HasRawSection(eSectionType_ResolveDatabase) &&
+       (RenderDoc::Inst().GetCaptureOptions().CaptureCallstacks ||
+        RenderDoc::Inst().GetCaptureOptions().CaptureCallstacksOnlyDraws))
     {
       // get symbol database
       Callstack::GetLoadedModules(symbolDB, symbolDBSize);
@@ -1505,6 +3499,7 @@ void Serialiser::FlushToDisk()
     }
 
     // write the machine identifier as an ASCII section
+    if(!HasRawSection(eSectionType_MachineID))
     {
       const char sectionName[] = "renderdoc/internal/machineid";
 
@@ -1522,6 +3517,26 @@ void Serialiser::FlushToDisk()
       FileIO::fwrite(&machineID, 1, sizeof(machineID), binFile);
     }
 
+    // write any sections copied from another capture
+    for(size_t i = 0; i < m_RawSections.size(); i++)
+    {
+      const RawSection &raw = m_RawSections[i];
+
+      BinarySectionHeader section = {0};
+      section.isASCII = 0;    // redundant but explicit
+      section.sectionNameLength = uint32_t(raw.name.size() + 1);    // includes null terminator
+      section.sectionType = raw.type;
+      section.sectionFlags = eSectionFlag_None;
+      section.sectionLength = (uint32_t)raw.data.size();
+
+      FileIO::fwrite(&section, 1, offsetof(BinarySectionHeader, name), binFile);
+      FileIO::fwrite(raw.name.c_str(), 1, raw.name.size() + 1, binFile);
+      if(!raw.data.empty())
+        FileIO::fwrite(&raw.data[0], 1, raw.data.size(), binFile);
+    }
+
+    UpdateWriteStream(m_WriteStream, binFile, streamStart, true);
+
     FileIO::fclose(binFile);
   }
 }
@@ -1542,7 +3557,8 @@ void Serialiser::DebugPrint(const char *fmt, ...)
   tmpBuf[1023] = '\0';
   va_end(args);
 
-  m_DebugText += GetIndent();
+  // append the indent in place rather than building a temporary string for it each line
+  m_DebugText.append(m_Mode == READING ? (m_Indent > 0 ? 4 : 0) : (size_t)m_Indent * 4, ' ');
   m_DebugText += tmpBuf;
 }
 
@@ -1588,13 +3604,12 @@ uint32_t Serialiser::PushContext(const char *name, const char *typeName, uint32_
 
       if(call)
       {
-        uint8_t numLevels = call->NumLevels() & 0xff;
-        WriteFrom(numLevels);
+        uint8_t marker = CallstackIndexMarker;
+        WriteFrom(marker);
 
-        if(call->NumLevels())
-        {
-          WriteBytes((byte *)call->GetAddrs(), sizeof(uint64_t) * numLevels);
-        }
+        uint32_t callstackIdx =
+            InternCallstack(call->NumLevels() ? call->GetAddrs() : NULL, call->NumLevels());
+        WriteFrom(callstackIdx);
 
         SAFE_DELETE(call);
       }
@@ -1629,6 +3644,7 @@ uint32_t Serialiser::PushContext(const char *name, const char *typeName, uint32_
     {
       // reset debug text
       m_DebugText = "";
+      m_ChunkResourceRefs.clear();
     }
 
     if(chunkIdx > 0)
@@ -1675,8 +3691,18 @@ uint32_t Serialiser::PushContext(const char *name, const char *typeName, uint32_
           uint8_t callLen = 0;
           ReadInto(callLen);
 
-          uint64_t *calls = (uint64_t *)ReadBytes(callLen * sizeof(uint64_t));
-          SetCallstack(calls, callLen);
+          // interned callstacks were added in version 0x33
+          if(callLen == CallstackIndexMarker && m_SerVer >= 0x00000033)
+          {
+            uint32_t callstackIdx = 0;
+            ReadInto(callstackIdx);
+            SetInternedCallstack(callstackIdx);
+          }
+          else
+          {
+            uint64_t *calls = (uint64_t *)ReadBytes(callLen * sizeof(uint64_t));
+            SetCallstack(calls, callLen);
+          }
         }
         else
         {
@@ -1699,6 +3725,12 @@ uint32_t Serialiser::PushContext(const char *name, const char *typeName, uint32_
         ReadInto(chunkSize);
 
         m_LastChunkLen = chunkSize;
+
+        if(chunkSize == LargeChunkMarker && m_SerVer >= 0x00000033)
+        {
+          ReadInto(m_LastChunkLen);
+          ReadBytes(BufferAlignment - sizeof(uint64_t));
+        }
       }
     }
 
@@ -1744,23 +3776,45 @@ void Serialiser::PopContext(uint32_t chunkIdx)
       uint64_t chunkLength =
           (curOffset - chunkOffset) - (smallchunk ? sizeof(uint16_t) : sizeof(uint32_t));
 
-      RDCASSERT(chunkLength < 0xffffffff);
-
-      uint32_t chunklen = (uint32_t)chunkLength;
-
-      byte *head = m_BufferHead;
-      SetOffset(chunkOffset);
-      if(smallchunk)
+      if(!smallchunk && chunkLength >= LargeChunkMarker)
       {
-        uint16_t miniSize = (chunklen & 0xffff);
-        RDCASSERT(chunklen <= 0xffff);
-        WriteFrom(miniSize);
+        // make room for the 64-bit length after the 32-bit one. This moves the contents by
+        // BufferAlignment so any aligned buffers in them stay aligned. Chunks this large are rare
+        // enough that the copy doesn't matter next to writing them out
+        static const byte padding[BufferAlignment] = {0};
+        WriteBytes(padding, BufferAlignment);
+
+        if(m_HasError)
+          return;
+
+        byte *contents = m_Buffer + chunkOffset + sizeof(uint32_t);
+        memmove(contents + BufferAlignment, contents, (size_t)chunkLength);
+        memset(contents, 0, BufferAlignment);
+        memcpy(contents, &chunkLength, sizeof(chunkLength));
+
+        byte *head = m_BufferHead;
+        SetOffset(chunkOffset);
+        WriteFrom(LargeChunkMarker);
+        m_BufferHead = head;
       }
       else
       {
-        WriteFrom(chunklen);
+        uint32_t chunklen = (uint32_t)chunkLength;
+
+        byte *head = m_BufferHead;
+        SetOffset(chunkOffset);
+        if(smallchunk)
+        {
+          uint16_t miniSize = (chunklen & 0xffff);
+          RDCASSERT(chunklen <= 0xffff);
+          WriteFrom(miniSize);
+        }
+        else
+        {
+          WriteFrom(chunklen);
+        }
+        m_BufferHead = head;
       }
-      m_BufferHead = head;
     }
 
     if(m_DebugTextWriting)
@@ -1814,6 +3868,18 @@ void Serialiser::SerialiseString(const char *name, string &el)
   }
 }
 
+void Serialiser::TakeChunkOwnership()
+{
+  for(size_t i = 0; i < m_Chunks.size(); i++)
+  {
+    if(!m_Chunks[i]->IsTemporary())
+    {
+      m_Chunks[i] = m_Chunks[i]->Duplicate();
+      m_Chunks[i]->m_Temporary = true;
+    }
+  }
+}
+
 void Serialiser::Insert(Chunk *chunk)
 {
   m_Chunks.push_back(chunk);
@@ -1821,6 +3887,13 @@ void Serialiser::Insert(Chunk *chunk)
   m_DebugText += chunk->GetDebugString();
 }
 
+void Serialiser::InsertFirst(Chunk *chunk)
+{
+  m_Chunks.insert(m_Chunks.begin(), chunk);
+
+  m_DebugText = chunk->GetDebugString() + m_DebugText;
+}
+
 void Serialiser::AlignNextBuffer(const size_t alignment)
 {
   // on new logs, we don't have to align. This code will be deleted once backwards-compat is dropped
@@ -1865,13 +3938,107 @@ void Serialiser::AlignNextBuffer(const size_t alignment)
   }
 }
 
+// MurmurHash64A, used to find buffers with identical contents
+static uint64_t HashBuffer(const byte *buf, size_t len)
+{
+  const uint64_t m = 0xc6a4a7935bd1e995ULL;
+  const int r = 47;
+
+  uint64_t h = 0x8445d61a4e774912ULL ^ (len * m);
+
+  const byte *end = buf + (len & ~size_t(7));
+
+  for(const byte *p = buf; p != end; p += sizeof(uint64_t))
+  {
+    uint64_t k;
+    memcpy(&k, p, sizeof(k));
+
+    k *= m;
+    k ^= k >> r;
+    k *= m;
+
+    h ^= k;
+    h *= m;
+  }
+
+  size_t rem = len & 7;
+  if(rem)
+  {
+    uint64_t k = 0;
+    memcpy(&k, end, rem);
+    h ^= k;
+    h *= m;
+  }
+
+  h ^= h >> r;
+  h *= m;
+  h ^= h >> r;
+
+  return h;
+}
+
+uint64_t Serialiser::HashBytes(const byte *buf, size_t len)
+{
+  return HashBuffer(buf, len);
+}
+
 void Serialiser::SerialiseBuffer(const char *name, byte *&buf, size_t &len)
 {
   uint32_t bufLen = (uint32_t)len;
+  uint64_t largeLen = len;
+
+  // a length of DedupMarker means a deduplicated buffer header follows:
+  //   uint64_t hash; uint32_t length; byte isReference;
+  // then the buffer contents as normal if it isn't a reference.
+  const uint32_t DedupMarker = 0xffffffff;
 
   if(m_Mode >= WRITING)
   {
-    WriteFrom(bufLen);
+    // buffers too big for a 32-bit length are never deduplicated, they're expected to be unique
+    if(largeLen >= LargeBufferMarker)
+    {
+      WriteFrom(LargeBufferMarker);
+      WriteFrom(largeLen);
+    }
+    else if(m_DedupBuffers)
+    {
+      uint64_t hash = HashBuffer(buf, bufLen);
+
+      auto it = m_DedupWritten.find(hash);
+
+      if(it == m_DedupWritten.end())
+      {
+        m_DedupWritten[hash].assign(buf, buf + bufLen);
+
+        WriteFrom(DedupMarker);
+        WriteFrom(hash);
+        WriteFrom(bufLen);
+        WriteFrom(byte(0));
+      }
+      else if(it->second.size() == bufLen &&
+              (bufLen == 0 || memcmp(&it->second[0], buf, bufLen) == 0))
+      {
+        WriteFrom(DedupMarker);
+        WriteFrom(hash);
+        WriteFrom(bufLen);
+        WriteFrom(byte(1));
+
+        m_DedupReferenced.insert(hash);
+
+        len = (size_t)bufLen;
+        return;
+      }
+      else
+      {
+        // a different buffer with the same hash. Write it without a dedup header so readers don't
+        // replace the cached copy that later references expect
+        WriteFrom(bufLen);
+      }
+    }
+    else
+    {
+      WriteFrom(bufLen);
+    }
 
     // ensure byte alignment
     uint64_t offs = GetOffset();
@@ -1885,7 +4052,7 @@ void Serialiser::SerialiseBuffer(const char *name, byte *&buf, size_t &len)
 
     RDCASSERT((GetOffset() % BufferAlignment) == 0);
 
-    WriteBytes(buf, bufLen);
+    WriteBytes(buf, len);
 
     m_AlignedData = true;
   }
@@ -1893,6 +4060,49 @@ void Serialiser::SerialiseBuffer(const char *name, byte *&buf, size_t &len)
   {
     ReadInto(bufLen);
 
+    largeLen = bufLen;
+
+    uint64_t hash = 0;
+    bool dedup = false;
+
+    if(bufLen == LargeBufferMarker && m_SerVer >= 0x00000033)
+    {
+      ReadInto(largeLen);
+    }
+    else if(bufLen == DedupMarker && m_SerVer >= 0x00000033)
+    {
+      byte isReference = 0;
+
+      ReadInto(hash);
+      ReadInto(bufLen);
+      ReadInto(isReference);
+
+      dedup = true;
+
+      if(isReference)
+      {
+        if(buf == NULL)
+          buf = new byte[bufLen];
+
+        auto it = m_DedupCache.find(hash);
+        if(it != m_DedupCache.end() && it->second.size() == bufLen)
+        {
+          if(bufLen > 0)
+            memcpy(buf, &it->second[0], bufLen);
+        }
+        else
+        {
+          RDCERR("Deduplicated buffer %llx wasn't read before being referenced", hash);
+          memset(buf, 0, bufLen);
+        }
+
+        len = (size_t)bufLen;
+        return;
+      }
+
+      largeLen = bufLen;
+    }
+
     // ensure byte alignment
     uint64_t offs = GetOffset();
 
@@ -1905,11 +4115,19 @@ void Serialiser::SerialiseBuffer(const char *name, byte *&buf, size_t &len)
     }
 
     if(buf == NULL)
-      buf = new byte[bufLen];
-    memcpy(buf, ReadBytes(bufLen), bufLen);
+      buf = new byte[(size_t)largeLen];
+
+    // big buffers are copied out a piece at a time, rather than growing the read window to fit
+    if(largeLen > StreamedReadSize)
+      ReadStreamed(buf, largeLen);
+    else
+      memcpy(buf, ReadBytes((size_t)largeLen), (size_t)largeLen);
+
+    if(dedup && (m_DedupCacheAll || m_DedupReferenced.find(hash) != m_DedupReferenced.end()))
+      m_DedupCache[hash].assign(buf, buf + bufLen);
   }
 
-  len = (size_t)bufLen;
+  len = (size_t)largeLen;
 
   if(m_DebugTextWriting && name && name[0])
   {
@@ -1919,14 +4137,59 @@ void Serialiser::SerialiseBuffer(const char *name, byte *&buf, size_t &len)
 
     memcpy(lbuf, buf, RDCMIN(len, 4 * sizeof(uint32_t)));
 
-    if(bufLen <= 16)
+    if(largeLen <= 16)
     {
       ellipsis = "   ";
     }
 
-    DebugPrint("%s: RawBuffer % 5d:< 0x%08x 0x%08x 0x%08x 0x%08x %s>\n", name, bufLen, lbuf[0],
-               lbuf[1], lbuf[2], lbuf[3], ellipsis);
+    DebugPrint("%s: RawBuffer % 5llu:< 0x%08x 0x%08x 0x%08x 0x%08x %s>\n", name, largeLen,
+               lbuf[0], lbuf[1], lbuf[2], lbuf[3], ellipsis);
+  }
+}
+
+byte *Serialiser::ReserveBuffer(const char *name, size_t len, size_t trailing)
+{
+  RDCASSERT(m_Mode >= WRITING && !m_DedupBuffers);
+
+  uint32_t bufLen = (uint32_t)len;
+  uint64_t largeLen = len;
+
+  // same layout as SerialiseBuffer, so it's read back with that
+  if(largeLen >= LargeBufferMarker)
+  {
+    WriteFrom(LargeBufferMarker);
+    WriteFrom(largeLen);
+  }
+  else
+  {
+    WriteFrom(bufLen);
+  }
+
+  uint64_t offs = GetOffset();
+  uint64_t alignedoffs = AlignUp(offs, BufferAlignment);
+
+  if(offs != alignedoffs)
+  {
+    static const byte padding[BufferAlignment] = {0};
+    WriteBytes(&padding[0], (size_t)(alignedoffs - offs));
   }
+
+  if(m_HasError)
+    return NULL;
+
+  // grow now for everything up to the end of the trailing data, so the buffer doesn't move while
+  // the contents are being filled in
+  ReserveWriteSpace(len + trailing);
+
+  byte *ret = m_BufferHead;
+  m_BufferHead += len;
+
+  m_AlignedData = true;
+
+  if(m_DebugTextWriting && name && name[0])
+    DebugPrint("%s: RawBuffer % 5llu:< reserved >\n", name, largeLen);
+
+  return ret;
 }
 
 template <>
@@ -1935,6 +4198,25 @@ void Serialiser::Serialise(const char *name, string &el)
   SerialiseString(name, el);
 }
 
+template <>
+void Serialiser::Serialise(const char *name, ResourceId &el)
+{
+  if(m_Mode == WRITING)
+  {
+    WriteFrom(el);
+  }
+  else if(m_Mode == READING)
+  {
+    ReadInto(el);
+
+    if(el != ResourceId() && (m_ChunkResourceRefs.empty() || m_ChunkResourceRefs.back() != el))
+      m_ChunkResourceRefs.push_back(el);
+  }
+
+  if(name != NULL && m_DebugTextWriting)
+    DebugPrint("%s: %s\n", name, ToStr::Get(el).c_str());
+}
+
 // floats need aligned reads
 template <>
 void Serialiser::ReadInto(float &f)
@@ -28,6 +28,7 @@
 #include <stdint.h>
 #include <string.h>
 #include <list>
+#include <map>
 #include <set>
 #include <string>
 #include <utility>
@@ -37,6 +38,9 @@
 #include "os/os_specific.h"
 #include "replay/type_helpers.h"
 
+struct ResourceId;
+
+using std::map;
 using std::set;
 using std::string;
 
@@ -88,9 +92,13 @@ typedef const char *(*ChunkLookup)(uint32_t chunkType);
 class Serialiser;
 class ScopedContext;
 struct CompressedFileIO;
+struct CaptureWriteStream;
+
+struct ChunkPage;
 
 // holds the memory, length and type for a given chunk, so that it can be
 // passed around and moved between owners before being serialised out
+
 class Chunk
 {
 public:
@@ -98,22 +106,34 @@ public:
 
   const char *GetDebugString() { return m_DebugStr.c_str(); }
   byte *GetData() { return m_Data; }
-  uint32_t GetLength() { return m_Length; }
+  uint64_t GetLength() { return m_Length; }
   uint32_t GetChunkType() { return m_ChunkType; }
   bool IsAligned() { return m_AlignedData; }
   bool IsTemporary() { return m_Temporary; }
-#if ENABLED(RDOC_DEVEL)
+  // when and on which thread the chunk was recorded. Only set for chunks that are being written
+  uint64_t GetTimestamp() { return m_Timestamp; }
+  uint64_t GetThreadID() { return m_ThreadID; }
   static uint64_t NumLiveChunks() { return m_LiveChunks; }
   static uint64_t TotalMem() { return m_TotalMem; }
-#else
-  static uint64_t NumLiveChunks() { return 0; }
-  static uint64_t TotalMem() { return 0; }
-#endif
 
   // grab current contents of the serialiser into this chunk
   Chunk(Serialiser *ser, uint32_t chunkType, bool temp);
 
+  // a new chunk with its own copy of the contents
   Chunk *Duplicate();
+  // a new chunk referencing the same contents, which are freed with the last chunk using them.
+  // Only for chunks whose contents are never modified once recorded, which is everything except
+  // the chunks that back a resource's data pointer (see SetDataPtr).
+  Chunk *Share();
+
+  // a new temporary chunk with room for length bytes of contents, header included as GetData()
+  // returns them. The caller fills in the contents, e.g. to rebuild a chunk stored elsewhere.
+  static Chunk *AllocRaw(uint32_t chunkType, uint64_t length, bool aligned, uint64_t timestamp,
+                         uint64_t threadID);
+
+  // drops every thread's reference to the page it's allocating from, so that pages are freed as
+  // soon as the chunks in them are. Called when the last active frame capture ends.
+  static void ReleaseThreadPages();
 
 private:
   Chunk() {}
@@ -121,19 +141,37 @@ private:
   Chunk(const Chunk &);
   Chunk &operator=(const Chunk &);
 
+  // a new chunk with the same properties as this one and no contents
+  Chunk *CopyHeader();
+  void CountLiveChunk();
+
   friend class ScopedContext;
+  friend class Serialiser;
+
+  // allocates m_Data for m_Length bytes, from the current thread's chunk page if it's small enough
+  void AllocData();
+  void FreeData();
 
   bool m_AlignedData;
   bool m_Temporary;
 
   uint32_t m_ChunkType;
 
-  uint32_t m_Length;
+  uint64_t m_Timestamp;
+  uint64_t m_ThreadID;
+
+  uint64_t m_Length;
   byte *m_Data;
+  // the page m_Data was sub-allocated from, or NULL if it was allocated on its own
+  ChunkPage *m_Page;
+  // m_Data is a serialiser's buffer that was taken over rather than copied
+  bool m_DetachedBuffer;
   string m_DebugStr;
 
+  // kept in every build for the replay's memory usage report
+  static int64_t m_LiveChunks, m_TotalMem;
 #if ENABLED(RDOC_DEVEL)
-  static int64_t m_LiveChunks, m_MaxChunks, m_TotalMem;
+  static int64_t m_MaxChunks;
 #endif
 };
 
@@ -176,6 +214,12 @@ public:
     eSectionFlag_None = 0x0,
     eSectionFlag_ASCIIStored = 0x1,
     eSectionFlag_LZ4Compressed = 0x2,
+    // LZ4 blocks were compressed independently and don't reference previous blocks. See the
+    // eSectionType_BlockTable section for the block layout
+    eSectionFlag_LZ4IndependentBlocks = 0x4,
+    // compressed with deflate instead of LZ4, in the same block layout. Blocks are always
+    // independent
+    eSectionFlag_DeflateCompressed = 0x8,
   };
 
   enum SectionType
@@ -186,13 +230,36 @@ public:
     eSectionType_MachineID,          // renderdoc/internal/machineid
     eSectionType_FrameBookmarks,     // renderdoc/ui/bookmarks
     eSectionType_Notes,              // renderdoc/ui/notes
+    eSectionType_BlockTable,         // renderdoc/internal/blocktable
+    eSectionType_ChunkIndex,         // renderdoc/internal/chunkindex
+    eSectionType_DedupBuffers,       // renderdoc/internal/dedupbuffers
+    eSectionType_CallstackTable,     // renderdoc/internal/callstacks
+    eSectionType_CPUTimeline,        // renderdoc/internal/cputimeline
+    eSectionType_Metadata,           // renderdoc/internal/metadata
     eSectionType_Num,
   };
 
+  // one entry per top-level chunk in the frame capture data, stored in the chunk index section
+  struct ChunkIndexEntry
+  {
+    uint64_t offset;       // offset of the chunk's header in the frame capture data
+    uint32_t chunkType;    // chunk type as passed to PushContext
+    uint32_t reserved;     // always 0
+    uint64_t length;       // length of the chunk in bytes, including its header
+  };
+
+  // when and where each top-level chunk was recorded, stored in the CPU timeline section in the
+  // same order as the chunk index
+  struct ChunkTimingEntry
+  {
+    uint64_t timestamp;    // Timing::GetTimestamp() when the chunk was recorded
+    uint64_t threadID;     // Threading::GetCurrentID() of the recording thread
+  };
+
   // version number of overall file format or chunk organisation. If the contents/meaning/order of
   // chunks have changed this does not need to be bumped, there are version numbers within each
   // API that interprets the stream that can be bumped.
-  static const uint64_t SERIALISE_VERSION = 0x00000032;
+  static const uint64_t SERIALISE_VERSION = 0x00000033;
   static const uint32_t MAGIC_HEADER;
 
   //////////////////////////////////////////
@@ -242,11 +309,24 @@ public:
   }
 
   byte *GetRawPtr(size_t offs) const { return m_Buffer + offs; }
+  // only valid while writing - the allocated size of the in-memory buffer
+  uint64_t GetBufferCapacity() const { return m_BufferSize; }
+  // hands ownership of the in-memory buffer (allocated with AllocAlignedBuffer) to the caller and
+  // starts a fresh one. Only valid while writing.
+  byte *DetachBuffer();
   // Set up the base pointer and size. Serialiser will allocate enough for
   // the rest of the file and keep it all in memory (useful to keep everything
   // in actual frame data resident in memory).
   void SetPersistentBlock(uint64_t offs);
 
+  // when reading, the capture data between offs and offs + length can be read again after it has
+  // been passed, including from before the persistent block. Between BeginReadRange and
+  // EndReadRange the serialiser reads from a copy of that range, e.g. to process a chunk that was
+  // skipped earlier, then returns to where it was. Compressed captures need a block table.
+  bool CanReadRange();
+  bool BeginReadRange(uint64_t offs, uint64_t length);
+  void EndReadRange();
+
   void SetOffset(uint64_t offs);
 
   void Rewind()
@@ -260,6 +340,13 @@ public:
   // assumes buffer head is sitting before a chunk (ie. pushcontext will be valid)
   void SkipToChunk(uint32_t chunkIdx, uint32_t *idx = NULL)
   {
+    // if the capture has a chunk index we can jump straight there
+    if(m_Mode == READING && !m_ChunkIndex.empty())
+    {
+      SkipToIndexedChunk(chunkIdx, idx);
+      return;
+    }
+
     do
     {
       size_t offs = m_BufferHead - m_Buffer + (size_t)m_ReadOffset;
@@ -286,7 +373,70 @@ public:
   }
 
   // assumes buffer head is sitting in a chunk (ie. immediately after a pushcontext)
-  void SkipCurrentChunk() { ReadBytes(m_LastChunkLen); }
+  void SkipCurrentChunk() { ReadStreamed(NULL, m_LastChunkLen); }
+  // the length of the current chunk's contents, after its header
+  uint64_t GetCurrentChunkLength() const { return m_LastChunkLen; }
+  // true if buffers in the capture refer back to identical copies earlier on, which then have to
+  // be read in order
+  bool HasDedupReferences() const { return !m_DedupReferenced.empty(); }
+  // the chunk index is only available when reading captures that were written with one, it's
+  // empty otherwise.
+  bool HasChunkIndex() const { return !m_ChunkIndex.empty(); }
+  const vector<ChunkIndexEntry> &GetChunkIndex() const { return m_ChunkIndex; }
+  // looks up when the chunk at or after the given offset was recorded, in microseconds on the
+  // capturing machine's clock, and on which thread. Returns false if the capture has no CPU
+  // timeline
+  bool GetChunkTiming(uint64_t offset, uint64_t &microseconds, uint64_t &threadID) const;
+  // when reading, the distinct non-null resource IDs serialised so far in the current chunk, sorted
+  void GetChunkResourceRefs(rdctype::array<ResourceId> &refs) const;
+  // while enabled, buffers written with SerialiseBuffer are hashed and any with the same contents
+  // as one written earlier are stored as a reference to that copy. Only enable this for chunks that
+  // go into the capture in the order they're serialised, so the first copy is always read before
+  // any reference to it.
+  void SetBufferDeduplication(bool enabled) { m_DedupBuffers = enabled; }
+  void ResetBufferDeduplication()
+  {
+    m_DedupWritten.clear();
+    m_DedupReferenced.clear();
+  }
+  // hashes of the buffers that were referenced at least once, pass these to the file serialiser
+  // with AddReferencedBuffers so that readers know which copies they need to keep around.
+  const set<uint64_t> &GetReferencedBuffers() const { return m_DedupReferenced; }
+  void AddReferencedBuffers(const set<uint64_t> &hashes)
+  {
+    m_DedupReferenced.insert(hashes.begin(), hashes.end());
+  }
+
+  // when writing, a small block stored uncompressed as the first section in the file, so that it
+  // can be read with ReadFileMetadata without scanning the rest of the capture.
+  void SetMetadata(const byte *data, size_t len) { m_Metadata.assign(data, data + len); }
+  // reads only the metadata section of a capture file. Returns false if the file isn't a capture or
+  // was written without one.
+  static bool ReadFileMetadata(const char *path, vector<byte> &data);
+
+  // a section stored outside of the frame capture data, as it is in the file
+  struct RawSection
+  {
+    SectionType type;
+    string name;
+    vector<byte> data;
+  };
+
+  // when reading, loads every section that a repacked capture should carry over unchanged. The
+  // frame capture data, the metadata and the sections FlushToDisk always regenerates (block table,
+  // chunk index, deduplicated buffer list) are left out.
+  bool ReadRawSections(vector<RawSection> &sections);
+  // when writing, a section to copy into the file as-is. It replaces the one FlushToDisk would
+  // otherwise generate from this process for the callstack table, resolve DB, machine ID and CPU
+  // timeline, since those describe wherever the data was originally captured.
+  void AddRawSection(const RawSection &section) { m_RawSections.push_back(section); }
+  // when reading, copies the next top-level chunk including its header, ready to insert into a
+  // file serialiser. Padding ahead of it is skipped, the destination adds its own where needed.
+  // Returns NULL at the end of the frame capture data.
+  Chunk *ReadRawChunk();
+  // when writing, overrides the capture options' compression level. 0 is LZ4, anything higher is
+  // deflate at that level
+  void SetCompressionLevel(uint32_t level) { m_CompressLevel = level; }
   void InitCallstackResolver();
   bool HasCallstacks() { return m_KnownSections[eSectionType_ResolveDatabase] != NULL; }
   // get callstack resolver, created with the DB in the file
@@ -324,6 +474,8 @@ public:
 
   // Write a chunk to disk
   void Insert(Chunk *el);
+  // Write a chunk to disk before any chunks that were already inserted
+  void InsertFirst(Chunk *el);
 
   // serialise a fixed-size array.
   template <int Num, class T>
@@ -558,6 +710,11 @@ public:
   void SerialiseBuffer(const char *name, byte *&buf, size_t &len);
   void AlignNextBuffer(const size_t alignment);
 
+  // when writing, serialise a buffer header for len bytes and return where its contents go, for
+  // the caller to fill in later. Room is also made for trailing bytes of whatever is serialised
+  // after, so the returned pointer stays valid until then. Returns NULL on error.
+  byte *ReserveBuffer(const char *name, size_t len, size_t trailing);
+
   // NOT recommended interface. Useful for specific situations if e.g. you have
   // a buffer of data that is not arbitrary in size and can be determined by a 'type' or
   // similar elsewhere in the stream, so you want to skip the type-safety of the above
@@ -569,9 +726,26 @@ public:
 
   static byte *AllocAlignedBuffer(size_t size, size_t align = 64);
   static void FreeAlignedBuffer(byte *buf);
+  // total bytes requested by aligned buffers that are still allocated
+  static uint64_t AlignedBufferBytes() { return (uint64_t)m_AlignedBufferBytes; }
 
   void FlushToDisk();
 
+  // when writing, the chunks inserted so far in the order FlushToDisk will write them
+  const vector<Chunk *> &GetChunks() const { return m_Chunks; }
+  // the hash used to find buffers with identical contents, for finding identical chunks elsewhere
+  static uint64_t HashBytes(const byte *buf, size_t len);
+
+  // when writing, replace any inserted chunks that are owned elsewhere with copies owned by this
+  // serialiser, so that it can still be flushed after the originals are modified or freed.
+  void TakeChunkOwnership();
+
+  // when writing, FlushToDisk updates this with the fraction of chunks written so far
+  void SetWriteProgress(volatile float *progress) { m_WriteProgress = progress; }
+  // when writing, FlushToDisk updates this as the file's contents become final
+  void SetWriteStream(CaptureWriteStream *stream) { m_WriteStream = stream; }
+  const string &GetFilename() const { return m_Filename; }
+
   // set a function used when serialising a text representation
   // of the chunks
   void SetChunkNameLookup(ChunkLookup lookup) { m_ChunkLookup = lookup; }
@@ -583,9 +757,16 @@ private:
   // Raw memory buffer read/write
 
   void WriteBytes(const byte *buf, size_t nBytes);
+  void ReserveWriteSpace(size_t nBytes);
   void *ReadBytes(size_t nBytes);
+  // reads nBytes into dst, or skips them if dst is NULL, a piece at a time so the read window
+  // doesn't have to grow to hold them all at once
+  void ReadStreamed(byte *dst, uint64_t nBytes);
 
   void ReadFromFile(uint64_t bufferOffs, size_t length);
+  void SkipFileTo(uint64_t offs);
+
+  void SkipToIndexedChunk(uint32_t chunkIdx, uint32_t *idx);
 
   template <class T>
   void WriteFrom(const T &f)
@@ -629,8 +810,13 @@ private:
 
   //////////////////////////////////////////
 
+  // chunks sub-allocate their payloads with the same alignment
+  friend class Chunk;
+
   static const uint64_t BufferAlignment;
 
+  static int64_t m_AlignedBufferBytes;
+
   //////////////////////////////////////////
 
   uint64_t m_SerVer;
@@ -656,8 +842,12 @@ private:
   uint64_t m_BufferSize;
   byte *m_Buffer;
   byte *m_BufferHead;
-  size_t m_LastChunkLen;
+  // if true, m_Buffer points into m_MappedFile and must not be freed or written to
+  bool m_BufferMapped;
+  uint64_t m_LastChunkLen;
   bool m_AlignedData;
+  // see GetChunkResourceRefs
+  vector<ResourceId> m_ChunkResourceRefs;
   vector<uint64_t> m_ChunkFixups;
 
   // reading from file:
@@ -696,8 +886,59 @@ private:
   // the file pointer to read from
   FILE *m_ReadFileHandle;
 
+  // the window saved by BeginReadRange, restored by EndReadRange
+  bool m_InReadRange;
+  byte *m_ReadRangeCopy;
+  byte *m_SavedBuffer;
+  byte *m_SavedBufferHead;
+  uint64_t m_SavedReadOffset;
+  size_t m_SavedBufferSize;
+  uint64_t m_SavedChunkLen;
+  bool m_SavedBufferMapped;
+
+  // read-only mapping of the file being read, if available
+  void *m_MappedFile;
+
+  // index of every top-level chunk, when reading a capture
+  vector<ChunkIndexEntry> m_ChunkIndex;
+
+  // recording time and thread of every top-level chunk, parallel to m_ChunkIndex. The timestamps
+  // are in ticks of the capturing machine, m_ChunkTickFrequency per millisecond
+  vector<ChunkTimingEntry> m_ChunkTimings;
+  double m_ChunkTickFrequency;
+
+  // buffer deduplication. When writing m_DedupWritten has the contents of each hash written so
+  // far, so a matching hash is only referenced if the bytes match too, and m_DedupReferenced has
+  // those that a later buffer referred back to. When reading
+  // m_DedupReferenced comes from the file and says which buffers to keep in m_DedupCache. In-memory
+  // reads don't have the list, so m_DedupCacheAll keeps every one.
+  bool m_DedupBuffers;
+  bool m_DedupCacheAll;
+  map<uint64_t, vector<byte> > m_DedupWritten;
+  set<uint64_t> m_DedupReferenced;
+  map<uint64_t, vector<byte> > m_DedupCache;
+
+  // written as the first section, see SetMetadata
+  vector<byte> m_Metadata;
+
+  // see AddRawSection and SetCompressionLevel. ~0U uses the capture options' level
+  vector<RawSection> m_RawSections;
+  uint32_t m_CompressLevel;
+  bool HasRawSection(SectionType type) const;
+
+  // interned callstacks read from the file, m_CallstackOffsets[i] to m_CallstackOffsets[i+1] are
+  // the addresses of callstack i. In-memory reads don't have the table (m_FileCallstacks is false)
+  // and look up the interned callstacks of this process instead.
+  bool m_FileCallstacks;
+  vector<uint32_t> m_CallstackOffsets;
+  vector<uint64_t> m_CallstackAddrs;
+
+  void SetInternedCallstack(uint32_t idx);
+
   // writing to file
   vector<Chunk *> m_Chunks;
+  volatile float *m_WriteProgress;
+  CaptureWriteStream *m_WriteStream;
 
   // a database of strings read from the file, useful when serialised structures
   // expect a char* to return and point to static memory
@@ -712,6 +953,10 @@ private:
 template <>
 void Serialiser::Serialise(const char *name, string &el);
 
+// records the IDs referenced by each chunk while reading
+template <>
+void Serialiser::Serialise(const char *name, ResourceId &el);
+
 // floats need aligned reads
 template <>
 void Serialiser::ReadInto(float &f);
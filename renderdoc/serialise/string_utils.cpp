@@ -99,3 +99,27 @@ std::string trim(const std::string &str)
   // searching from the start found something, so searching from the end must have too.
   return str.substr(start, end - start + 1);
 }
+
+uint32_t StringPool::Intern(const char *str, size_t len)
+{
+  std::string key(str, len);
+
+  auto it = m_Offsets.find(key);
+  if(it != m_Offsets.end())
+    return it->second;
+
+  uint32_t offset = (uint32_t)m_Data.size();
+
+  m_Data.append(key);
+  m_Data.push_back('\0');
+
+  m_Offsets[key] = offset;
+
+  return offset;
+}
+
+void StringPool::SetData(const std::string &data)
+{
+  m_Data = data;
+  m_Offsets.clear();
+}
@@ -26,6 +26,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <map>
 #include <string>
 #include <vector>
 using std::string;
@@ -117,3 +118,26 @@ void merge(const vector<std::basic_string<CharType> > &in, std::basic_string<Cha
     out += sep;
   }
 }
+
+// stores each distinct string once, NULL-terminated in a single buffer, so that strings which
+// repeat a lot can be referred to by their 32-bit offset into it.
+class StringPool
+{
+public:
+  uint32_t Intern(const char *str, size_t len);
+  uint32_t Intern(const std::string &str) { return Intern(str.c_str(), str.size()); }
+  // offsets outside the pool give an empty string, as they may have come from a corrupt stream
+  const char *Get(uint32_t offset) const
+  {
+    return offset < m_Data.size() ? m_Data.c_str() + offset : "";
+  }
+
+  const std::string &GetData() const { return m_Data; }
+  // replaces the contents with the buffer from another pool. Strings can be looked up in it, but
+  // interning afterwards won't find the existing copies.
+  void SetData(const std::string &data);
+
+private:
+  std::string m_Data;
+  std::map<std::string, uint32_t> m_Offsets;
+};
@@ -27,6 +27,8 @@
 #include <app/renderdoc_app.h>
 #include <replay/renderdoc_replay.h>
 #include <replay/version.h>
+#include <algorithm>
+#include <chrono>
 #include <string>
 
 using std::string;
@@ -46,13 +48,39 @@ void readCapOpts(const std::string &str, CaptureOptions *opts)
     *(b++) = (byte(str[i * 2 + 0] - 'a') << 4) | byte(str[i * 2 + 1] - 'a');
 }
 
+// the texture that was presented at the end of the frame, or failing that any swapchain image
+static ResourceId PresentedTextureID(IReplayController *renderer)
+{
+  ResourceId ret;
+
+  rdctype::array<TextureDescription> texs = renderer->GetTextures();
+
+  for(int32_t i = 0; i < texs.count; i++)
+  {
+    if(texs[i].creationFlags & TextureCategory::SwapBuffer)
+    {
+      ret = texs[i].ID;
+      break;
+    }
+  }
+
+  rdctype::array<DrawcallDescription> draws = renderer->GetDrawcalls();
+
+  if(draws.count > 0 && draws[draws.count - 1].flags & DrawFlags::Present)
+  {
+    ResourceId id = draws[draws.count - 1].copyDestination;
+    if(id != ResourceId())
+      ret = id;
+  }
+
+  return ret;
+}
+
 void DisplayRendererPreview(IReplayController *renderer, uint32_t width, uint32_t height)
 {
   if(renderer == NULL)
     return;
 
-  rdctype::array<TextureDescription> texs = renderer->GetTextures();
-
   TextureDisplay d;
   d.mip = 0;
   d.sampleIdx = ~0U;
@@ -74,25 +102,45 @@ void DisplayRendererPreview(IReplayController *renderer, uint32_t width, uint32_
   d.Red = d.Green = d.Blue = true;
   d.Alpha = false;
 
-  for(int32_t i = 0; i < texs.count; i++)
+  d.texid = PresentedTextureID(renderer);
+
+  DisplayRendererPreview(renderer, d, width, height);
+}
+
+// replays to the end of the frame and saves the presented texture, without creating any window or
+// output. The only rendering done is what's needed to read the texture back
+static bool SaveRendererPreview(IReplayController *renderer, const string &path)
+{
+  TextureSave save = {};
+  save.id = PresentedTextureID(renderer);
+  save.typeHint = CompType::Typeless;
+  save.destType = FileType::PNG;
+  save.mip = 0;
+  save.comp.blackPoint = 0.0f;
+  save.comp.whitePoint = 1.0f;
+  save.sample.mapToArray = false;
+  save.sample.sampleIndex = TextureSampleMapping::ResolveSamples;
+  save.slice.sliceIndex = 0;
+  save.channelExtract = -1;
+  save.alpha = AlphaMapping::Discard;
+
+  if(save.id == ResourceId())
   {
-    if(texs[i].creationFlags & TextureCategory::SwapBuffer)
-    {
-      d.texid = texs[i].ID;
-      break;
-    }
+    std::cerr << "Couldn't find a presented texture to save." << std::endl;
+    return false;
   }
 
-  rdctype::array<DrawcallDescription> draws = renderer->GetDrawcalls();
+  renderer->SetFrameEvent(10000000, true);
 
-  if(draws.count > 0 && draws[draws.count - 1].flags & DrawFlags::Present)
+  if(!renderer->SaveTexture(save, path.c_str()))
   {
-    ResourceId id = draws[draws.count - 1].copyDestination;
-    if(id != ResourceId())
-      d.texid = id;
+    std::cerr << "Couldn't save the presented texture to '" << path << "'." << std::endl;
+    return false;
   }
 
-  DisplayRendererPreview(renderer, d, width, height);
+  std::cout << "Saved the presented texture to '" << path << "'." << std::endl;
+
+  return true;
 }
 
 std::map<std::string, Command *> commands;
@@ -297,6 +345,58 @@ struct ThumbCommand : public Command
   }
 };
 
+struct RepackCommand : public Command
+{
+  virtual void AddOptions(cmdline::parser &parser)
+  {
+    parser.set_footer("<filename.rdc>");
+    parser.add<string>("out", 'o', "The output filename to save the repacked capture to", true,
+                       "filename.rdc");
+    parser.add<int>("level", 'l', "0 for fast LZ4 compression, or 1-9 for deflate at that level.",
+                    false, 0, cmdline::range(0, 9));
+    parser.add("strip-callstacks", 0, "Remove any callstacks recorded in the capture.");
+    parser.add("strip-thumbnail", 0, "Remove the capture's embedded thumbnail.");
+  }
+  virtual const char *Description()
+  {
+    return "Recompresses a capture to a new file, optionally removing optional data.";
+  }
+  virtual bool IsInternalOnly() { return false; }
+  virtual bool IsCaptureCommand() { return false; }
+  virtual int Execute(cmdline::parser &parser, const CaptureOptions &)
+  {
+    if(parser.rest().empty())
+    {
+      std::cerr << "Error: repack command requires a capture filename." << std::endl
+                << std::endl
+                << parser.usage();
+      return 0;
+    }
+
+    string filename = parser.rest()[0];
+
+    string outfile = parser.get<string>("out");
+
+    ICaptureFile *file = RENDERDOC_OpenCaptureFile(filename.c_str());
+
+    ReplayStatus status = file->Repack(outfile.c_str(), (uint32_t)parser.get<int>("level"),
+                                       parser.exist("strip-callstacks"),
+                                       parser.exist("strip-thumbnail"));
+
+    file->Shutdown();
+
+    if(status != ReplayStatus::Succeeded)
+    {
+      std::cerr << "Couldn't repack '" << filename << "' to '" << outfile << "'." << std::endl;
+      return 1;
+    }
+
+    std::cout << "Repacked '" << filename << "' to '" << outfile << "'." << std::endl;
+
+    return 0;
+  }
+};
+
 struct CaptureCommand : public Command
 {
   virtual void AddOptions(cmdline::parser &parser)
@@ -477,10 +577,15 @@ struct ReplayCommand : public Command
                        "Instead of replaying locally, replay on this host over the network.", false);
     parser.add<uint32_t>("remote-port", 0, "If --remote-host is set, use this port.", false,
                          RENDERDOC_GetDefaultRemoteServerPort());
+    parser.add("headless", 0,
+               "Don't open a preview window, save the backbuffer to the --out image instead.");
+    parser.add<string>("out", 'o', "With --headless, the image to save. Defaults to <capture>.png",
+                       false, "");
   }
   virtual const char *Description()
   {
-    return "Replay the log file and show the backbuffer on a preview window.";
+    return "Replay the log file and show the backbuffer on a preview window, or save it with "
+           "--headless.";
   }
   virtual bool IsInternalOnly() { return false; }
   virtual bool IsCaptureCommand() { return false; }
@@ -496,6 +601,11 @@ struct ReplayCommand : public Command
 
     string filename = parser.rest()[0];
 
+    bool headless = parser.exist("headless");
+    string outfile = parser.get<string>("out");
+    if(outfile.empty())
+      outfile = filename + ".png";
+
     if(parser.exist("remote-host"))
     {
       std::cout << "Replaying '" << filename << "' on " << parser.get<string>("remote-host") << ":"
@@ -521,10 +631,15 @@ struct ReplayCommand : public Command
       IReplayController *renderer = NULL;
       std::tie(status, renderer) = remote->OpenCapture(~0U, remotePath.elems, NULL);
 
+      bool success = false;
+
       if(status == ReplayStatus::Succeeded)
       {
-        DisplayRendererPreview(renderer, parser.get<uint32_t>("width"),
-                               parser.get<uint32_t>("height"));
+        if(headless)
+          success = SaveRendererPreview(renderer, outfile);
+        else
+          DisplayRendererPreview(renderer, parser.get<uint32_t>("width"),
+                                 parser.get<uint32_t>("height"));
 
         remote->CloseCapture(renderer);
       }
@@ -534,6 +649,9 @@ struct ReplayCommand : public Command
       }
 
       remote->ShutdownConnection();
+
+      if(headless && !success)
+        return 1;
     }
     else
     {
@@ -555,10 +673,18 @@ struct ReplayCommand : public Command
 
       if(status == ReplayStatus::Succeeded)
       {
-        DisplayRendererPreview(renderer, parser.get<uint32_t>("width"),
-                               parser.get<uint32_t>("height"));
+        bool success = true;
+
+        if(headless)
+          success = SaveRendererPreview(renderer, outfile);
+        else
+          DisplayRendererPreview(renderer, parser.get<uint32_t>("width"),
+                                 parser.get<uint32_t>("height"));
 
         renderer->Shutdown();
+
+        if(!success)
+          return 1;
       }
       else
       {
@@ -570,6 +696,283 @@ struct ReplayCommand : public Command
   }
 };
 
+struct BenchmarkCommand : public Command
+{
+  virtual void AddOptions(cmdline::parser &parser)
+  {
+    parser.set_footer("<capture.rdc>");
+    parser.add<uint32_t>("iterations", 'n', "The number of times to replay the frame.", false, 10);
+    parser.add<string>("counters", 'c',
+                       "A comma-separated list of counter names to fetch per event, or 'all'.",
+                       false, "");
+    parser.add<string>("out", 'o', "The file to write the per-event counters to.", false, "");
+    parser.add<string>("format", 'f', "The format of the per-event counters.", false, "csv",
+                       cmdline::oneof<string>("csv", "json"));
+    parser.add<string>("profile-trace", 0,
+                       "Write a Chrome trace of RenderDoc's internal replay profiling to this file.",
+                       false, "");
+  }
+  virtual const char *Description()
+  {
+    return "Replays the log file repeatedly and reports how long it takes.";
+  }
+  virtual bool IsInternalOnly() { return false; }
+  virtual bool IsCaptureCommand() { return false; }
+  virtual int Execute(cmdline::parser &parser, const CaptureOptions &)
+  {
+    if(parser.rest().empty())
+    {
+      std::cerr << "Error: benchmark command requires a filename to load." << std::endl
+                << std::endl
+                << parser.usage();
+      return 0;
+    }
+
+    string filename = parser.rest()[0];
+
+    uint32_t iterations = std::max(1U, parser.get<uint32_t>("iterations"));
+
+    string profileTrace = parser.get<string>("profile-trace");
+    if(!profileTrace.empty())
+      RENDERDOC_SetConfigSetting("replay.profileTrace", profileTrace.c_str());
+
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+    ICaptureFile *file = RENDERDOC_OpenCaptureFile(filename.c_str());
+
+    if(file->OpenStatus() != ReplayStatus::Succeeded)
+    {
+      std::cerr << "Couldn't load '" << filename << "'." << std::endl;
+      file->Shutdown();
+      return 1;
+    }
+
+    double openTime = MillisecondsSince(start);
+
+    IReplayController *renderer = NULL;
+    ReplayStatus status = ReplayStatus::InternalError;
+    std::tie(status, renderer) = file->OpenCapture(NULL);
+
+    file->Shutdown();
+
+    if(status != ReplayStatus::Succeeded)
+    {
+      std::cerr << "Couldn't load and replay '" << filename << "'." << std::endl;
+      return 1;
+    }
+
+    double loadTime = MillisecondsSince(start) - openTime;
+
+    FrameDescription frame = renderer->GetFrameInfo();
+
+    std::cout << "Capture:        " << filename << std::endl;
+    std::cout << "File size:      " << Megabytes(frame.compressedFileSize) << " MB ("
+              << Megabytes(frame.uncompressedFileSize) << " MB uncompressed)" << std::endl;
+    std::cout << "Open time:      " << openTime << " ms" << std::endl;
+    std::cout << "Load time:      " << loadTime << " ms" << std::endl;
+    std::cout << "Peak memory:    " << Megabytes(RENDERDOC_GetPeakMemoryUsage()) << " MB"
+              << std::endl;
+
+    uint32_t lastEID = LastEventID(renderer->GetDrawcalls());
+
+    // replay once to warm up caches and lazily created resources, then time each full replay
+    renderer->SetFrameEvent(lastEID, true);
+
+    std::vector<double> cpuTimes;
+    cpuTimes.reserve(iterations);
+
+    for(uint32_t i = 0; i < iterations; i++)
+    {
+      std::chrono::high_resolution_clock::time_point replayStart =
+          std::chrono::high_resolution_clock::now();
+
+      renderer->SetFrameEvent(lastEID, true);
+
+      cpuTimes.push_back(MillisecondsSince(replayStart));
+    }
+
+    std::sort(cpuTimes.begin(), cpuTimes.end());
+
+    double cpuTotal = 0.0;
+    for(double t : cpuTimes)
+      cpuTotal += t;
+
+    std::cout << "Iterations:     " << iterations << std::endl;
+    std::cout << "CPU frame time: " << cpuTimes[cpuTimes.size() / 2] << " ms median, "
+              << cpuTimes.front() << " ms min, " << cpuTotal / cpuTimes.size() << " ms mean"
+              << std::endl;
+
+    rdctype::array<GPUCounter> available = renderer->EnumerateCounters();
+
+    bool hasGPUDuration = false;
+    for(GPUCounter c : available)
+      if(c == GPUCounter::EventGPUDuration)
+        hasGPUDuration = true;
+
+    if(hasGPUDuration)
+    {
+      rdctype::array<GPUCounter> durationCounter;
+      durationCounter.create(1);
+      durationCounter[0] = GPUCounter::EventGPUDuration;
+
+      rdctype::array<CounterStatistics> stats =
+          renderer->FetchCounterStatistics(durationCounter, iterations);
+
+      // the durations are in seconds
+      double gpuMedian = 0.0, gpuMin = 0.0, gpuMean = 0.0;
+      for(const CounterStatistics &s : stats)
+      {
+        gpuMedian += s.median * 1000.0;
+        gpuMin += s.minimum * 1000.0;
+        gpuMean += s.mean * 1000.0;
+      }
+
+      std::cout << "GPU frame time: " << gpuMedian << " ms median, " << gpuMin << " ms min, "
+                << gpuMean << " ms mean (sum over events)" << std::endl;
+    }
+    else
+    {
+      std::cout << "GPU frame time: not available" << std::endl;
+    }
+
+    int ret = 0;
+
+    string counterList = parser.get<string>("counters");
+
+    if(!counterList.empty())
+      ret = ExportCounters(renderer, available, counterList, iterations, parser.get<string>("out"),
+                           parser.get<string>("format"));
+
+    renderer->Shutdown();
+
+    return ret;
+  }
+
+  static double MillisecondsSince(std::chrono::high_resolution_clock::time_point start)
+  {
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() -
+                                                     start)
+        .count();
+  }
+
+  static double Megabytes(uint64_t bytes) { return double(bytes) / (1024.0 * 1024.0); }
+  static uint32_t LastEventID(const rdctype::array<DrawcallDescription> &draws)
+  {
+    if(draws.count == 0)
+      return 0;
+
+    const DrawcallDescription &last = draws[draws.count - 1];
+
+    return std::max(last.eventID, LastEventID(last.children));
+  }
+
+  static int ExportCounters(IReplayController *renderer, const rdctype::array<GPUCounter> &available,
+                            const string &counterList, uint32_t iterations, const string &outfile,
+                            const string &format)
+  {
+    std::vector<GPUCounter> selected;
+    std::map<GPUCounter, CounterDescription> descs;
+
+    for(GPUCounter c : available)
+      descs[c] = renderer->DescribeCounter(c);
+
+    if(counterList == "all")
+    {
+      selected.assign(available.begin(), available.end());
+    }
+    else
+    {
+      size_t begin = 0;
+      while(begin <= counterList.size())
+      {
+        size_t end = counterList.find(',', begin);
+        if(end == string::npos)
+          end = counterList.size();
+
+        string name = counterList.substr(begin, end - begin);
+        begin = end + 1;
+
+        if(name.empty())
+          continue;
+
+        bool found = false;
+        for(auto it = descs.begin(); it != descs.end(); ++it)
+        {
+          if(name == it->second.name.c_str())
+          {
+            selected.push_back(it->first);
+            found = true;
+            break;
+          }
+        }
+
+        if(!found)
+        {
+          std::cerr << "Error: counter '" << name << "' is not available. Available counters:"
+                    << std::endl;
+          for(auto it = descs.begin(); it != descs.end(); ++it)
+            std::cerr << "  " << it->second.name.c_str() << std::endl;
+          return 1;
+        }
+      }
+    }
+
+    if(selected.empty())
+      return 0;
+
+    rdctype::array<CounterStatistics> stats = renderer->FetchCounterStatistics(selected, iterations);
+
+    FILE *f = stdout;
+
+    if(!outfile.empty())
+    {
+      f = fopen(outfile.c_str(), "w");
+
+      if(!f)
+      {
+        std::cerr << "Couldn't open destination file '" << outfile << "'" << std::endl;
+        return 1;
+      }
+    }
+
+    bool json = (format == "json");
+
+    if(json)
+      fprintf(f, "[\n");
+    else
+      fprintf(f, "EID,Counter,Samples,Min,Median,Mean,StdDev\n");
+
+    for(int32_t i = 0; i < stats.count; i++)
+    {
+      const CounterStatistics &s = stats[i];
+      const char *name = descs[s.counterID].name.c_str();
+
+      if(json)
+        fprintf(f,
+                "  {\"eid\": %u, \"counter\": \"%s\", \"samples\": %u, \"min\": %.9g, "
+                "\"median\": %.9g, \"mean\": %.9g, \"stddev\": %.9g}%s\n",
+                s.eventID, name, s.samples, s.minimum, s.median, s.mean, s.stddev,
+                i + 1 < stats.count ? "," : "");
+      else
+        fprintf(f, "%u,\"%s\",%u,%.9g,%.9g,%.9g,%.9g\n", s.eventID, name, s.samples, s.minimum,
+                s.median, s.mean, s.stddev);
+    }
+
+    if(json)
+      fprintf(f, "]\n");
+
+    if(f != stdout)
+    {
+      fclose(f);
+
+      std::cout << "Wrote " << stats.count << " counter results to '" << outfile << "'."
+                << std::endl;
+    }
+
+    return 0;
+  }
+};
+
 struct CapAltBitCommand : public Command
 {
   virtual void AddOptions(cmdline::parser &parser)
@@ -673,6 +1076,47 @@ struct CapAltBitCommand : public Command
   }
 };
 
+struct BenchDiffCommand : public Command
+{
+  virtual void AddOptions(cmdline::parser &parser)
+  {
+    parser.add<uint32_t>("size", 's', "The size of the buffers to compare, in MB.", false, 64);
+  }
+  virtual const char *Description() { return "Internal use only!"; }
+  virtual bool IsInternalOnly() { return true; }
+  virtual bool IsCaptureCommand() { return false; }
+  virtual int Execute(cmdline::parser &parser, const CaptureOptions &)
+  {
+    rdctype::str report;
+    RENDERDOC_BenchmarkDiffRange(parser.get<uint32_t>("size"), &report);
+
+    std::cout << report.c_str();
+
+    return 0;
+  }
+};
+
+struct MicroBenchCommand : public Command
+{
+  virtual void AddOptions(cmdline::parser &parser)
+  {
+    parser.add<std::string>("filter", 'f', "Only run benchmarks whose name contains this string.",
+                            false, "");
+  }
+  virtual const char *Description() { return "Internal use only!"; }
+  virtual bool IsInternalOnly() { return true; }
+  virtual bool IsCaptureCommand() { return false; }
+  virtual int Execute(cmdline::parser &parser, const CaptureOptions &)
+  {
+    rdctype::str report;
+    RENDERDOC_RunBenchmarks(parser.get<std::string>("filter").c_str(), &report);
+
+    std::cout << report.c_str();
+
+    return 0;
+  }
+};
+
 int renderdoccmd(std::vector<std::string> &argv)
 {
   try
@@ -699,11 +1143,15 @@ int renderdoccmd(std::vector<std::string> &argv)
 
     // add platform agnostic commands
     add_command("thumb", new ThumbCommand());
+    add_command("repack", new RepackCommand());
     add_command("capture", new CaptureCommand());
     add_command("inject", new InjectCommand());
     add_command("remoteserver", new RemoteServerCommand());
     add_command("replay", new ReplayCommand());
+    add_command("benchmark", new BenchmarkCommand());
     add_command("capaltbit", new CapAltBitCommand());
+    add_command("benchdiff", new BenchDiffCommand());
+    add_command("microbench", new MicroBenchCommand());
 
     if(argv.size() <= 1)
     {
@@ -779,6 +1227,38 @@ int renderdoccmd(std::vector<std::string> &argv)
               "Capturing Option: Save all initial resource contents at frame start.");
       cmd.add("opt-capture-all-cmd-lists", 0,
               "Capturing Option: In D3D11, record all command lists from application start.");
+      cmd.add<int>("opt-compression-level", 0,
+                   "Capturing Option: 0 for fast LZ4 compression, or 1-9 for deflate at that level.",
+                   false, 0, cmdline::range(0, 9));
+      cmd.add("opt-dedup-initial-contents", 0,
+              "Capturing Option: Store identical initial resource contents only once.");
+      cmd.add("opt-write-captures-async", 0,
+              "Capturing Option: Write captures to disk on a background thread.");
+      cmd.add<int>("opt-frames-per-capture", 0,
+                   "Capturing Option: Record this many consecutive frames into each capture.", false,
+                   1, cmdline::range(1, 1000));
+      cmd.add("opt-track-coherent-map-writes", 0,
+              "Capturing Option: In Vulkan and GL, track writes to coherent maps per-page.");
+      cmd.add("opt-profile-api-calls", 0,
+              "Capturing Option: Time each API entry point and show the slowest in the overlay.");
+      cmd.add("opt-reduce-idle-overhead", 0,
+              "Capturing Option: In Vulkan, only track command buffers while a capture is pending.");
+      cmd.add<int>("opt-prepare-ahead-budget", 0,
+                   "Capturing Option: Prepare up to this many MB of initial contents before capture.",
+                   false, 0, cmdline::range(0, 65536));
+      cmd.add("opt-compress-initials-on-gpu", 0,
+              "Capturing Option: In Vulkan, compress image initial contents before reading back.");
+      cmd.add<int>("opt-initial-contents-budget", 0,
+                   "Capturing Option: Store at most this many MB of texture initial contents.",
+                   false, 0, cmdline::range(0, 1048576));
+      cmd.add<int>("opt-frame-time-trigger-ms", 0,
+                   "Capturing Option: Capture the frame after one taking longer than this many ms.",
+                   false, 0, cmdline::range(0, 3600000));
+      cmd.add<float>("opt-frame-time-trigger-multiple", 0,
+                     "Capturing Option: Capture the frame after one this many times the average.",
+                     false, 0.0f, cmdline::range(0.0f, 1000.0f));
+      cmd.add("opt-append-to-session", 0,
+              "Capturing Option: Append captures to one session file, sharing identical chunks.");
     }
 
     cmd.parse_check(argv, true);
@@ -810,8 +1290,28 @@ int renderdoccmd(std::vector<std::string> &argv)
         opts.SaveAllInitials = true;
       if(cmd.exist("opt-capture-all-cmd-lists"))
         opts.CaptureAllCmdLists = true;
+      if(cmd.exist("opt-dedup-initial-contents"))
+        opts.DeduplicateInitialContents = true;
+      if(cmd.exist("opt-write-captures-async"))
+        opts.WriteCapturesAsync = true;
+      if(cmd.exist("opt-track-coherent-map-writes"))
+        opts.TrackCoherentMapWrites = true;
+      if(cmd.exist("opt-profile-api-calls"))
+        opts.ProfileAPICalls = true;
+      if(cmd.exist("opt-reduce-idle-overhead"))
+        opts.ReduceIdleOverhead = true;
+      if(cmd.exist("opt-compress-initials-on-gpu"))
+        opts.CompressInitialContentsOnGPU = true;
 
       opts.DelayForDebugger = (uint32_t)cmd.get<int>("opt-delay-for-debugger");
+      opts.CompressionLevel = (uint32_t)cmd.get<int>("opt-compression-level");
+      opts.FramesPerCapture = (uint32_t)cmd.get<int>("opt-frames-per-capture");
+      opts.PrepareAheadBudget = (uint32_t)cmd.get<int>("opt-prepare-ahead-budget");
+      opts.InitialContentsBudget = (uint32_t)cmd.get<int>("opt-initial-contents-budget");
+      opts.FrameTimeTriggerMS = (uint32_t)cmd.get<int>("opt-frame-time-trigger-ms");
+      opts.FrameTimeTriggerMultiple = cmd.get<float>("opt-frame-time-trigger-multiple");
+      if(cmd.exist("opt-append-to-session"))
+        opts.AppendCapturesToSession = true;
     }
 
     if(cmd.exist("help"))
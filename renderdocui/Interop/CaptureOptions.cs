@@ -80,5 +80,18 @@ public class CaptureOptions
         public bool SaveAllInitials;
         public bool CaptureAllCmdLists;
         public bool DebugOutputMute;
+        public UInt32 CompressionLevel;
+        public bool DeduplicateInitialContents;
+        public bool WriteCapturesAsync;
+        public UInt32 FramesPerCapture;
+        public bool TrackCoherentMapWrites;
+        public bool ProfileAPICalls;
+        public bool ReduceIdleOverhead;
+        public UInt32 PrepareAheadBudget;
+        public bool CompressInitialContentsOnGPU;
+        public UInt32 InitialContentsBudget;
+        public UInt32 FrameTimeTriggerMS;
+        public float FrameTimeTriggerMultiple;
+        public bool AppendCapturesToSession;
     };
 };
@@ -321,6 +321,16 @@ public enum D3DBufferViewFlags
         Counter = 0x4,
     };
 
+    [Flags]
+    public enum EventDataFlags
+    {
+        NoFlags = 0x0,
+        PipelineState = 0x1,
+        BoundResources = 0x2,
+        ConstantBuffers = 0x4,
+        Counters = 0x8,
+    };
+
     public enum ShaderStageType
     {
         Vertex = 0,
@@ -614,12 +624,21 @@ public enum GPUCounters : uint
         GSInvocations,
         PSInvocations,
         CSInvocations,
+        EventGPUStart,
+        CoveredPixels,
+        ShadedQuadPixels,
+        HelperPixelRatio,
+        DepthRejectedPixels,
 
         FirstAMD = 1000000,
 
         FirstIntel = 2000000,
 
         FirstNvidia = 3000000,
+
+        FirstEstimated = 4000000,
+        EstimatedBytesRead = FirstEstimated,
+        EstimatedBytesWritten,
     };
 
     public enum CounterUnits
@@ -627,6 +646,24 @@ public enum CounterUnits
         Absolute,
         Seconds,
         Percentage,
+        Bytes,
+    };
+
+    public enum Bottleneck
+    {
+        Overhead,
+        Vertex,
+        Fragment,
+        Fill,
+        Bandwidth,
+        Compute,
+    };
+
+    public enum QueueType
+    {
+        Graphics,
+        Compute,
+        Copy,
     };
 
     public enum ReplaySupport
@@ -667,6 +704,9 @@ public enum TargetControlMessageType
         CaptureCopied,
         RegisterAPI,
         NewChild,
+        CaptureProgress,
+        APICallStats,
+        Telemetry,
     };
 
     public enum EnvironmentModificationType
@@ -326,6 +326,10 @@ public class FetchBuffer
         public bool customName;
         public BufferCreationFlags creationFlags;
         public UInt64 length;
+        public UInt64 allocationSize;
+        public UInt64 allocationAlignment;
+        [CustomMarshalAs(CustomUnmanagedType.UTF8TemplatedString)]
+        public string memoryType;
     };
 
     [StructLayout(LayoutKind.Sequential)]
@@ -346,6 +350,11 @@ public class FetchTexture
         public TextureCreationFlags creationFlags;
         public UInt32 msQual, msSamp;
         public UInt64 byteSize;
+        public bool placeholderInitialContents;
+        public UInt64 allocationSize;
+        public UInt64 allocationAlignment;
+        [CustomMarshalAs(CustomUnmanagedType.UTF8TemplatedString)]
+        public string memoryType;
     };
 
     [StructLayout(LayoutKind.Sequential)]
@@ -525,6 +534,7 @@ public class FetchFrameStatistics
     public class FetchFrameInfo
     {
         public UInt32 frameNumber;
+        public UInt32 frameCount;
         public UInt64 fileOffset;
         public UInt64 uncompressedFileSize;
         public UInt64 compressedFileSize;
@@ -536,6 +546,31 @@ public class FetchFrameInfo
 
         [CustomMarshalAs(CustomUnmanagedType.TemplatedArray)]
         public DebugMessage[] debugMessages;
+
+        [CustomMarshalAs(CustomUnmanagedType.TemplatedArray)]
+        public ThreadTimeline[] threadTimelines;
+
+        [CustomMarshalAs(CustomUnmanagedType.TemplatedArray)]
+        public QueueSubmission[] queueSubmissions;
+    };
+
+    [StructLayout(LayoutKind.Sequential)]
+    public class ThreadTimeline
+    {
+        public UInt64 threadID;
+        public UInt64 begin;
+        public UInt64 end;
+        public UInt32 numEvents;
+    };
+
+    [StructLayout(LayoutKind.Sequential)]
+    public class QueueSubmission
+    {
+        public ResourceId queue;
+        public QueueType type;
+        public UInt32 eventID;
+        public UInt32 lastEventID;
+        public UInt32 waits;
     };
 
     [StructLayout(LayoutKind.Sequential)]
@@ -550,6 +585,12 @@ public class FetchAPIEvent
         public string eventDesc;
 
         public UInt64 fileOffset;
+
+        public UInt64 cpuTimestamp;
+        public UInt64 threadID;
+
+        [CustomMarshalAs(CustomUnmanagedType.TemplatedArray)]
+        public ResourceId[] referencedResources;
     };
 
     [StructLayout(LayoutKind.Sequential)]
@@ -796,6 +837,52 @@ public class SliceMapping
         public int jpegQuality = 90;
     };
 
+    [StructLayout(LayoutKind.Sequential)]
+    public class TextureDiff
+    {
+        public ResourceId diffTexture;
+        public UInt64 totalPixels;
+        public UInt64 changedPixels;
+        public FloatVector maxError;
+        public FloatVector meanError;
+        public UInt32 changedX, changedY, changedWidth, changedHeight;
+    };
+
+    [StructLayout(LayoutKind.Sequential)]
+    public class EventResourceUsage
+    {
+        public ResourceId resourceId;
+        public ResourceUsage usage;
+    };
+
+    [StructLayout(LayoutKind.Sequential)]
+    public class EventConstantBlock
+    {
+        public ShaderStageType stage;
+        public UInt32 slot;
+        public ResourceId buffer;
+        public UInt64 byteOffset;
+        public UInt64 byteSize;
+        [CustomMarshalAs(CustomUnmanagedType.TemplatedArray)]
+        public ShaderVariable[] variables;
+    };
+
+    [StructLayout(LayoutKind.Sequential)]
+    public class EventData
+    {
+        public UInt32 eventID;
+        public D3D11PipelineState d3d11;
+        public D3D12PipelineState d3d12;
+        public GLPipelineState gl;
+        public VulkanPipelineState vulkan;
+        [CustomMarshalAs(CustomUnmanagedType.TemplatedArray)]
+        public EventResourceUsage[] resources;
+        [CustomMarshalAs(CustomUnmanagedType.TemplatedArray)]
+        public EventConstantBlock[] constantBlocks;
+        [CustomMarshalAs(CustomUnmanagedType.TemplatedArray)]
+        public CounterResult[] counters;
+    };
+
     [StructLayout(LayoutKind.Sequential)]
     public class APIProperties
     {
@@ -844,6 +931,157 @@ public struct ValueUnion
         public ValueUnion value;
     };
 
+    [StructLayout(LayoutKind.Sequential)]
+    public class CounterStatistics
+    {
+        public UInt32 eventID;
+        public UInt32 counterID;
+        public UInt32 samples;
+        public double minimum;
+        public double median;
+        public double mean;
+        public double stddev;
+    };
+
+    [StructLayout(LayoutKind.Sequential)]
+    public class DrawcallBandwidth
+    {
+        public UInt32 eventID;
+        public UInt64 vertexBytes;
+        public UInt64 resourceReadBytes;
+        public UInt64 targetReadBytes;
+        public UInt64 targetWriteBytes;
+        public UInt64 bytesRead;
+        public UInt64 bytesWritten;
+    };
+
+    [StructLayout(LayoutKind.Sequential)]
+    public class DrawcallBottleneck
+    {
+        public UInt32 eventID;
+        public Bottleneck limiter;
+        public double duration;
+        public UInt64 vertexInvocations;
+        public UInt64 pixelInvocations;
+        public UInt64 computeInvocations;
+        public UInt64 rasterizedPrimitives;
+        public UInt64 samplesWritten;
+        public UInt64 bytes;
+        public double vertexWork;
+        public double fragmentWork;
+        public double fillWork;
+        public double bandwidthWork;
+        public double computeWork;
+    };
+
+    [StructLayout(LayoutKind.Sequential)]
+    public class PassBottleneck
+    {
+        public UInt32 eventID;
+        public UInt32 lastEventID;
+
+        [CustomMarshalAs(CustomUnmanagedType.UTF8TemplatedString)]
+        public string name;
+
+        public Bottleneck limiter;
+        public double duration;
+        public double work;
+
+        [CustomMarshalAs(CustomUnmanagedType.TemplatedArray)]
+        public DrawcallBottleneck[] draws;
+    };
+
+    [StructLayout(LayoutKind.Sequential)]
+    public class IndexEfficiency
+    {
+        public UInt32 eventID;
+        public ResourceId indexBuffer;
+        public UInt64 byteOffset;
+        public UInt32 numIndices;
+        public UInt32 triangles;
+        public UInt32 degenerateTriangles;
+        public UInt32 uniqueVertices;
+        public UInt32 minIndex;
+        public UInt32 maxIndex;
+        public float referencedFraction;
+        public float fifoACMR;
+        public float lruACMR;
+        public float lruATVR;
+    };
+
+    [StructLayout(LayoutKind.Sequential)]
+    public class SampledMip
+    {
+        public UInt32 mip;
+        public UInt32 numTilesSampled;
+        [CustomMarshalAs(CustomUnmanagedType.TemplatedArray)]
+        public UInt32[] tiles;
+    };
+
+    [StructLayout(LayoutKind.Sequential)]
+    public class TextureSamplingFeedback
+    {
+        public ResourceId resourceId;
+        public UInt32 gridSize;
+        [CustomMarshalAs(CustomUnmanagedType.TemplatedArray)]
+        public SampledMip[] mips;
+    };
+
+    [StructLayout(LayoutKind.Sequential)]
+    public class SubmissionTiming
+    {
+        public UInt32 submission;
+        public double start;
+        public double duration;
+        public double stall;
+        public double overlap;
+    };
+
+    [StructLayout(LayoutKind.Sequential)]
+    public class MemoryUsage
+    {
+        [CustomMarshalAs(CustomUnmanagedType.UTF8TemplatedString)]
+        public string category;
+        public bool gpu;
+        public UInt64 count;
+        public UInt64 bytes;
+    };
+
+    [StructLayout(LayoutKind.Sequential)]
+    public class ResourceMemory
+    {
+        public ResourceId ID;
+        [CustomMarshalAs(CustomUnmanagedType.UTF8TemplatedString)]
+        public string name;
+        public bool texture;
+        [CustomMarshalAs(CustomUnmanagedType.UTF8TemplatedString)]
+        public string memoryType;
+        public UInt64 bytes;
+    };
+
+    [StructLayout(LayoutKind.Sequential)]
+    public class TransientResource
+    {
+        public ResourceId ID;
+        [CustomMarshalAs(CustomUnmanagedType.UTF8TemplatedString)]
+        public string name;
+        public bool texture;
+        public UInt64 bytes;
+        public UInt32 firstWrite;
+        public UInt32 lastRead;
+    };
+
+    [StructLayout(LayoutKind.Sequential)]
+    public class AliasGroup
+    {
+        [CustomMarshalAs(CustomUnmanagedType.UTF8TemplatedString)]
+        public string memoryType;
+        public UInt64 bytes;
+        public UInt64 savedBytes;
+        [CustomMarshalAs(CustomUnmanagedType.TemplatedArray)]
+        public TransientResource[] resources;
+    };
+
     [StructLayout(LayoutKind.Sequential)]
     public class PixelValue
     {
@@ -867,6 +1105,18 @@ public struct ValueUnion
         public ValueUnion value;
     };
 
+    [StructLayout(LayoutKind.Sequential)]
+    public class PixelPick
+    {
+        public bool valid;
+        public ResourceId texID;
+        public bool customShader;
+        public UInt32 x, y;
+        public UInt32 sliceFace, mip, sample;
+        [CustomMarshalAs(CustomUnmanagedType.CustomClass)]
+        public PixelValue value;
+    };
+
     [StructLayout(LayoutKind.Sequential)]
     public class ModificationValue
     {
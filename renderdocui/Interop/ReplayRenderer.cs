@@ -114,6 +114,32 @@ public struct NewChildData
         };
         [CustomMarshalAs(CustomUnmanagedType.CustomClass)]
         public NewChildData NewChild;
+
+        public float CaptureProgress;
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct APICallStat
+        {
+            [CustomMarshalAs(CustomUnmanagedType.UTF8TemplatedString)]
+            public string name;
+            public UInt64 count;
+            public double milliseconds;
+        };
+        [CustomMarshalAs(CustomUnmanagedType.TemplatedArray)]
+        public APICallStat[] APICallStats;
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct TargetTelemetry
+        {
+            public double frameTimeMin;
+            public double frameTimeAvg;
+            public double frameTimeMax;
+            public double apiMilliseconds;
+            public UInt64 liveChunks;
+            public UInt64 chunkBytes;
+            public UInt64 bufferBytes;
+        };
+        public TargetTelemetry Telemetry;
     };
 
     public class ReplayOutput
@@ -131,6 +157,9 @@ public class ReplayOutput
         [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
         private static extern void ReplayOutput_Display(IntPtr real);
 
+        [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
+        private static extern bool ReplayOutput_IsMeshDisplayReduced(IntPtr real);
+
         [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
         private static extern bool ReplayOutput_SetPixelContext(IntPtr real, UInt32 windowSystem, IntPtr wnd);
         [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
@@ -152,6 +181,11 @@ public class ReplayOutput
         private static extern void ReplayOutput_PickPixel(IntPtr real, ResourceId texID, bool customShader,
                                                                 UInt32 x, UInt32 y, UInt32 sliceFace, UInt32 mip, UInt32 sample, IntPtr outval);
         [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
+        private static extern void ReplayOutput_RequestPickPixel(IntPtr real, ResourceId texID, bool customShader,
+                                                                UInt32 x, UInt32 y, UInt32 sliceFace, UInt32 mip, UInt32 sample);
+        [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
+        private static extern void ReplayOutput_GetPickedPixel(IntPtr real, IntPtr outpick);
+        [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
         private static extern UInt32 ReplayOutput_PickVertex(IntPtr real, UInt32 eventID, UInt32 x, UInt32 y, IntPtr outPickedInstance);
 
         private IntPtr m_Real = IntPtr.Zero;
@@ -182,6 +216,11 @@ public void Display()
             ReplayOutput_Display(m_Real);
         }
 
+        public bool IsMeshDisplayReduced()
+        {
+            return ReplayOutput_IsMeshDisplayReduced(m_Real);
+        }
+
         public bool SetPixelContext(IntPtr wnd)
         {
             // 1 == eWindowingSystem_Win32
@@ -256,6 +295,24 @@ public PixelValue PickPixel(ResourceId texID, bool customShader, UInt32 x, UInt3
             return ret;
         }
 
+        public void RequestPickPixel(ResourceId texID, bool customShader, UInt32 x, UInt32 y, UInt32 sliceFace, UInt32 mip, UInt32 sample)
+        {
+            ReplayOutput_RequestPickPixel(m_Real, texID, customShader, x, y, sliceFace, mip, sample);
+        }
+
+        public PixelPick GetPickedPixel()
+        {
+            IntPtr mem = CustomMarshal.Alloc(typeof(PixelPick));
+
+            ReplayOutput_GetPickedPixel(m_Real, mem);
+
+            PixelPick ret = (PixelPick)CustomMarshal.PtrToStructure(mem, typeof(PixelPick), false);
+
+            CustomMarshal.Free(mem);
+
+            return ret;
+        }
+
         public UInt32 PickVertex(UInt32 eventID, UInt32 x, UInt32 y, out UInt32 pickedInstance)
         {
             IntPtr mem = CustomMarshal.Alloc(typeof(UInt32));
@@ -294,6 +351,10 @@ public class ReplayRenderer
         [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
         private static extern void ReplayRenderer_SetFrameEvent(IntPtr real, UInt32 eventID, bool force);
         [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
+        private static extern void ReplayRenderer_RequestCancel(IntPtr real);
+        [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
+        private static extern void ReplayRenderer_ClearCancelRequest(IntPtr real);
+        [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
         private static extern void ReplayRenderer_GetD3D11PipelineState(IntPtr real, IntPtr mem);
         [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
         private static extern void ReplayRenderer_GetD3D12PipelineState(IntPtr real, IntPtr mem);
@@ -323,6 +384,12 @@ public class ReplayRenderer
         [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
         private static extern void ReplayRenderer_FetchCounters(IntPtr real, IntPtr counters, UInt32 numCounters, IntPtr outresults);
         [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
+        private static extern void ReplayRenderer_GetEventData(IntPtr real, IntPtr eventIDs, UInt32 numEvents, EventDataFlags flags, IntPtr counters, UInt32 numCounters, IntPtr outdata);
+        [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
+        private static extern void ReplayRenderer_GetBoundConstantBlocks(IntPtr real, IntPtr outblocks);
+        [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
+        private static extern void ReplayRenderer_FetchCounterStatistics(IntPtr real, IntPtr counters, UInt32 numCounters, UInt32 iterations, IntPtr outresults);
+        [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
         private static extern void ReplayRenderer_EnumerateCounters(IntPtr real, IntPtr outcounters);
         [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
         private static extern void ReplayRenderer_DescribeCounter(IntPtr real, UInt32 counter, IntPtr outdesc);
@@ -331,9 +398,33 @@ public class ReplayRenderer
         [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
         private static extern void ReplayRenderer_GetBuffers(IntPtr real, IntPtr outbufs);
         [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
+        private static extern void ReplayRenderer_GetResourceMemory(IntPtr real, IntPtr outmem);
+        [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
+        private static extern void ReplayRenderer_GetTransientAliasing(IntPtr real, IntPtr outgroups);
+        [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
         private static extern void ReplayRenderer_GetResolve(IntPtr real, UInt64[] callstack, UInt32 callstackLen, IntPtr outtrace);
         [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
+        private static extern void ReplayRenderer_GetEventParameters(IntPtr real, UInt32 eventID, IntPtr outparams);
+        [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
+        private static extern void ReplayRenderer_FindEventsReferencing(IntPtr real, ResourceId id, IntPtr outevents);
+        [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
         private static extern void ReplayRenderer_GetDebugMessages(IntPtr real, IntPtr outmsgs);
+        [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
+        private static extern void ReplayRenderer_AnalyseWastedWork(IntPtr real, IntPtr outmsgs);
+        [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
+        private static extern void ReplayRenderer_GetDrawcallShaderCosts(IntPtr real, IntPtr outcosts);
+        [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
+        private static extern void ReplayRenderer_GetDrawcallBandwidth(IntPtr real, IntPtr outbandwidth);
+        [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
+        private static extern void ReplayRenderer_AnalyseBottlenecks(IntPtr real, IntPtr outpasses);
+        [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
+        private static extern void ReplayRenderer_GetIndexEfficiency(IntPtr real, IntPtr outeff);
+        [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
+        private static extern void ReplayRenderer_GetTextureSampling(IntPtr real, UInt32 startEventID, UInt32 endEventID, IntPtr outfeedback);
+        [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
+        private static extern void ReplayRenderer_GetQueueTimeline(IntPtr real, IntPtr outtimings);
+        [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
+        private static extern void ReplayRenderer_GetMemoryUsage(IntPtr real, IntPtr outusage);
         
         [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
         private static extern void ReplayRenderer_PixelHistory(IntPtr real, ResourceId target, UInt32 x, UInt32 y, UInt32 slice, UInt32 mip, UInt32 sampleIdx, FormatComponentType typeHint, IntPtr history);
@@ -361,6 +452,12 @@ public class ReplayRenderer
         [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
         private static extern void ReplayRenderer_GetTextureData(IntPtr real, ResourceId tex, UInt32 arrayIdx, UInt32 mip, IntPtr outdata);
 
+        [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
+        private static extern void ReplayRenderer_CompareTextures(IntPtr real, ResourceId texA, UInt32 eventA, ResourceId texB, UInt32 eventB, UInt32 sliceFace, UInt32 mip, float threshold, IntPtr outdiff);
+
+        [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
+        private static extern void ReplayRenderer_GetTextureDataRegion(IntPtr real, ResourceId tex, UInt32 arrayIdx, UInt32 mip, UInt32 x, UInt32 y, UInt32 width, UInt32 height, IntPtr outdata);
+
         private IntPtr m_Real = IntPtr.Zero;
 
         public IntPtr Real { get { return m_Real; } }
@@ -413,6 +510,12 @@ public bool InitResolver()
         public void SetFrameEvent(UInt32 eventID, bool force)
         { ReplayRenderer_SetFrameEvent(m_Real, eventID, force); }
 
+        public void RequestCancel()
+        { ReplayRenderer_RequestCancel(m_Real); }
+
+        public void ClearCancelRequest()
+        { ReplayRenderer_ClearCancelRequest(m_Real); }
+
         public GLPipelineState GetGLPipelineState()
         {
             IntPtr mem = CustomMarshal.Alloc(typeof(GLPipelineState));
@@ -555,6 +658,43 @@ private void FixupDraws(Dictionary<Int64, FetchDrawcall> map, FetchDrawcall[] dr
             }
         }
 
+        public EventData[] GetEventData(UInt32[] eventIDs, EventDataFlags flags, UInt32[] counters)
+        {
+            IntPtr mem = CustomMarshal.Alloc(typeof(templated_array));
+
+            IntPtr eventsmem = CustomMarshal.Alloc(typeof(UInt32), eventIDs.Length);
+            IntPtr countersmem = CustomMarshal.Alloc(typeof(UInt32), counters.Length);
+
+            for (int i = 0; i < eventIDs.Length; i++)
+                Marshal.WriteInt32(eventsmem, sizeof(UInt32) * i, (int)eventIDs[i]);
+            for (int i = 0; i < counters.Length; i++)
+                Marshal.WriteInt32(countersmem, sizeof(UInt32) * i, (int)counters[i]);
+
+            ReplayRenderer_GetEventData(m_Real, eventsmem, (uint)eventIDs.Length, flags, countersmem, (uint)counters.Length, mem);
+
+            CustomMarshal.Free(eventsmem);
+            CustomMarshal.Free(countersmem);
+
+            EventData[] ret = (EventData[])CustomMarshal.GetTemplatedArray(mem, typeof(EventData), true);
+
+            CustomMarshal.Free(mem);
+
+            return ret;
+        }
+
+        public EventConstantBlock[] GetBoundConstantBlocks()
+        {
+            IntPtr mem = CustomMarshal.Alloc(typeof(templated_array));
+
+            ReplayRenderer_GetBoundConstantBlocks(m_Real, mem);
+
+            EventConstantBlock[] ret = (EventConstantBlock[])CustomMarshal.GetTemplatedArray(mem, typeof(EventConstantBlock), true);
+
+            CustomMarshal.Free(mem);
+
+            return ret;
+        }
+
         public Dictionary<uint, List<CounterResult>> FetchCounters(UInt32[] counters)
         {
             IntPtr mem = CustomMarshal.Alloc(typeof(templated_array));
@@ -591,6 +731,38 @@ private void FixupDraws(Dictionary<Int64, FetchDrawcall> map, FetchDrawcall[] dr
             return ret;
         }
 
+        public Dictionary<uint, List<CounterStatistics>> FetchCounterStatistics(UInt32[] counters, UInt32 iterations)
+        {
+            IntPtr mem = CustomMarshal.Alloc(typeof(templated_array));
+
+            IntPtr countersmem = CustomMarshal.Alloc(typeof(UInt32), counters.Length);
+
+            for (int i = 0; i < counters.Length; i++)
+                Marshal.WriteInt32(countersmem, sizeof(UInt32) * i, (int)counters[i]);
+
+            ReplayRenderer_FetchCounterStatistics(m_Real, countersmem, (uint)counters.Length, iterations, mem);
+
+            CustomMarshal.Free(countersmem);
+
+            Dictionary<uint, List<CounterStatistics>> ret = new Dictionary<uint, List<CounterStatistics>>();
+
+            {
+                CounterStatistics[] resultArray = (CounterStatistics[])CustomMarshal.GetTemplatedArray(mem, typeof(CounterStatistics), true);
+
+                foreach (var result in resultArray)
+                {
+                    if (!ret.ContainsKey(result.eventID))
+                        ret.Add(result.eventID, new List<CounterStatistics>());
+
+                    ret[result.eventID].Add(result);
+                }
+            }
+
+            CustomMarshal.Free(mem);
+
+            return ret;
+        }
+
         public UInt32[] EnumerateCounters()
         {
             IntPtr mem = CustomMarshal.Alloc(typeof(templated_array));
@@ -665,6 +837,32 @@ public FetchBuffer[] GetBuffers()
             return ret;
         }
 
+        public ResourceMemory[] GetResourceMemory()
+        {
+            IntPtr mem = CustomMarshal.Alloc(typeof(templated_array));
+
+            ReplayRenderer_GetResourceMemory(m_Real, mem);
+
+            ResourceMemory[] ret = (ResourceMemory[])CustomMarshal.GetTemplatedArray(mem, typeof(ResourceMemory), true);
+
+            CustomMarshal.Free(mem);
+
+            return ret;
+        }
+
+        public AliasGroup[] GetTransientAliasing()
+        {
+            IntPtr mem = CustomMarshal.Alloc(typeof(templated_array));
+
+            ReplayRenderer_GetTransientAliasing(m_Real, mem);
+
+            AliasGroup[] ret = (AliasGroup[])CustomMarshal.GetTemplatedArray(mem, typeof(AliasGroup), true);
+
+            CustomMarshal.Free(mem);
+
+            return ret;
+        }
+
         public string[] GetResolve(UInt64[] callstack)
         {
             IntPtr mem = CustomMarshal.Alloc(typeof(templated_array));
@@ -680,6 +878,32 @@ public string[] GetResolve(UInt64[] callstack)
             return ret;
         }
 
+        public string GetEventParameters(UInt32 eventID)
+        {
+            IntPtr mem = CustomMarshal.Alloc(typeof(templated_array));
+
+            ReplayRenderer_GetEventParameters(m_Real, eventID, mem);
+
+            string ret = CustomMarshal.TemplatedArrayToString(mem, true);
+
+            CustomMarshal.Free(mem);
+
+            return ret;
+        }
+
+        public UInt32[] FindEventsReferencing(ResourceId id)
+        {
+            IntPtr mem = CustomMarshal.Alloc(typeof(templated_array));
+
+            ReplayRenderer_FindEventsReferencing(m_Real, id, mem);
+
+            UInt32[] ret = (UInt32[])CustomMarshal.GetTemplatedArray(mem, typeof(UInt32), true);
+
+            CustomMarshal.Free(mem);
+
+            return ret;
+        }
+
         public DebugMessage[] GetDebugMessages()
         {
             IntPtr mem = CustomMarshal.Alloc(typeof(templated_array));
@@ -693,6 +917,110 @@ public DebugMessage[] GetDebugMessages()
             return ret;
         }
 
+        public DebugMessage[] AnalyseWastedWork()
+        {
+            IntPtr mem = CustomMarshal.Alloc(typeof(templated_array));
+
+            ReplayRenderer_AnalyseWastedWork(m_Real, mem);
+
+            DebugMessage[] ret = (DebugMessage[])CustomMarshal.GetTemplatedArray(mem, typeof(DebugMessage), true);
+
+            CustomMarshal.Free(mem);
+
+            return ret;
+        }
+
+        public DrawcallShaderCost[] GetDrawcallShaderCosts()
+        {
+            IntPtr mem = CustomMarshal.Alloc(typeof(templated_array));
+
+            ReplayRenderer_GetDrawcallShaderCosts(m_Real, mem);
+
+            DrawcallShaderCost[] ret = (DrawcallShaderCost[])CustomMarshal.GetTemplatedArray(mem, typeof(DrawcallShaderCost), true);
+
+            CustomMarshal.Free(mem);
+
+            return ret;
+        }
+
+        public DrawcallBandwidth[] GetDrawcallBandwidth()
+        {
+            IntPtr mem = CustomMarshal.Alloc(typeof(templated_array));
+
+            ReplayRenderer_GetDrawcallBandwidth(m_Real, mem);
+
+            DrawcallBandwidth[] ret = (DrawcallBandwidth[])CustomMarshal.GetTemplatedArray(mem, typeof(DrawcallBandwidth), true);
+
+            CustomMarshal.Free(mem);
+
+            return ret;
+        }
+
+        public PassBottleneck[] AnalyseBottlenecks()
+        {
+            IntPtr mem = CustomMarshal.Alloc(typeof(templated_array));
+
+            ReplayRenderer_AnalyseBottlenecks(m_Real, mem);
+
+            PassBottleneck[] ret = (PassBottleneck[])CustomMarshal.GetTemplatedArray(mem, typeof(PassBottleneck), true);
+
+            CustomMarshal.Free(mem);
+
+            return ret;
+        }
+
+        public IndexEfficiency[] GetIndexEfficiency()
+        {
+            IntPtr mem = CustomMarshal.Alloc(typeof(templated_array));
+
+            ReplayRenderer_GetIndexEfficiency(m_Real, mem);
+
+            IndexEfficiency[] ret = (IndexEfficiency[])CustomMarshal.GetTemplatedArray(mem, typeof(IndexEfficiency), true);
+
+            CustomMarshal.Free(mem);
+
+            return ret;
+        }
+
+        public TextureSamplingFeedback[] GetTextureSampling(UInt32 startEventID, UInt32 endEventID)
+        {
+            IntPtr mem = CustomMarshal.Alloc(typeof(templated_array));
+
+            ReplayRenderer_GetTextureSampling(m_Real, startEventID, endEventID, mem);
+
+            TextureSamplingFeedback[] ret = (TextureSamplingFeedback[])CustomMarshal.GetTemplatedArray(mem, typeof(TextureSamplingFeedback), true);
+
+            CustomMarshal.Free(mem);
+
+            return ret;
+        }
+
+        public SubmissionTiming[] GetQueueTimeline()
+        {
+            IntPtr mem = CustomMarshal.Alloc(typeof(templated_array));
+
+            ReplayRenderer_GetQueueTimeline(m_Real, mem);
+
+            SubmissionTiming[] ret = (SubmissionTiming[])CustomMarshal.GetTemplatedArray(mem, typeof(SubmissionTiming), true);
+
+            CustomMarshal.Free(mem);
+
+            return ret;
+        }
+
+        public MemoryUsage[] GetMemoryUsage()
+        {
+            IntPtr mem = CustomMarshal.Alloc(typeof(templated_array));
+
+            ReplayRenderer_GetMemoryUsage(m_Real, mem);
+
+            MemoryUsage[] ret = (MemoryUsage[])CustomMarshal.GetTemplatedArray(mem, typeof(MemoryUsage), true);
+
+            CustomMarshal.Free(mem);
+
+            return ret;
+        }
+
         public PixelModification[] PixelHistory(ResourceId target, UInt32 x, UInt32 y, UInt32 slice, UInt32 mip, UInt32 sampleIdx, FormatComponentType typeHint)
         {
             IntPtr mem = CustomMarshal.Alloc(typeof(templated_array));
@@ -823,6 +1151,32 @@ public byte[] GetTextureData(ResourceId tex, UInt32 arrayIdx, UInt32 mip)
 
             return ret;
         }
+
+        public byte[] GetTextureDataRegion(ResourceId tex, UInt32 arrayIdx, UInt32 mip, UInt32 x, UInt32 y, UInt32 width, UInt32 height)
+        {
+            IntPtr mem = CustomMarshal.Alloc(typeof(templated_array));
+
+            ReplayRenderer_GetTextureDataRegion(m_Real, tex, arrayIdx, mip, x, y, width, height, mem);
+
+            byte[] ret = (byte[])CustomMarshal.GetTemplatedArray(mem, typeof(byte), true);
+
+            CustomMarshal.Free(mem);
+
+            return ret;
+        }
+
+        public TextureDiff CompareTextures(ResourceId texA, UInt32 eventA, ResourceId texB, UInt32 eventB, UInt32 sliceFace, UInt32 mip, float threshold)
+        {
+            IntPtr mem = CustomMarshal.Alloc(typeof(TextureDiff));
+
+            ReplayRenderer_CompareTextures(m_Real, texA, eventA, texB, eventB, sliceFace, mip, threshold, mem);
+
+            TextureDiff ret = (TextureDiff)CustomMarshal.PtrToStructure(mem, typeof(TextureDiff), true);
+
+            CustomMarshal.Free(mem);
+
+            return ret;
+        }
     };
 
     public class RemoteServer
@@ -1202,6 +1556,18 @@ public void ReceiveMessage()
                     NewChild = msg.NewChild;
                     ChildAdded = true;
                 }
+                else if (msg.Type == TargetControlMessageType.CaptureProgress)
+                {
+                    CaptureProgress = msg.CaptureProgress;
+                }
+                else if (msg.Type == TargetControlMessageType.APICallStats)
+                {
+                    APICallStats = msg.APICallStats;
+                }
+                else if (msg.Type == TargetControlMessageType.Telemetry)
+                {
+                    Telemetry = msg.Telemetry;
+                }
             }
         }
 
@@ -1215,6 +1581,12 @@ public void ReceiveMessage()
         public bool CaptureCopied;
         public bool InfoUpdated;
 
+        public float CaptureProgress = -1.0f;
+
+        public TargetControlMessage.APICallStat[] APICallStats = new TargetControlMessage.APICallStat[0];
+
+        public TargetControlMessage.TargetTelemetry Telemetry = new TargetControlMessage.TargetTelemetry();
+
         public TargetControlMessage.NewCaptureData CaptureFile = new TargetControlMessage.NewCaptureData();
 
         public TargetControlMessage.NewChildData NewChild = new TargetControlMessage.NewChildData();
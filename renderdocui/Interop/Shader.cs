@@ -172,6 +172,11 @@ public string Row(int row)
 		{
 			return Row(row, type);
 		}
+
+        public ShaderVariable ShallowCopy()
+        {
+            return (ShaderVariable)MemberwiseClone();
+        }
     };
         
     [StructLayout(LayoutKind.Sequential)]
@@ -194,6 +199,30 @@ public struct IndexableTempArray
         public UInt32 nextInstruction;
         public ShaderDebugStateFlags flags;
     };
+
+    [StructLayout(LayoutKind.Sequential)]
+    public class ShaderRegisterChange
+    {
+        public UInt32 index;
+        public UInt32 arrayIndex;
+
+        [CustomMarshalAs(CustomUnmanagedType.Union)]
+        public ShaderVariable.ValueUnion value;
+    };
+
+    [StructLayout(LayoutKind.Sequential)]
+    public class ShaderDebugStateDelta
+    {
+        [CustomMarshalAs(CustomUnmanagedType.TemplatedArray)]
+        public ShaderRegisterChange[] registers;
+        [CustomMarshalAs(CustomUnmanagedType.TemplatedArray)]
+        public ShaderRegisterChange[] outputs;
+        [CustomMarshalAs(CustomUnmanagedType.TemplatedArray)]
+        public ShaderRegisterChange[] indexableTemps;
+
+        public UInt32 nextInstruction;
+        public ShaderDebugStateFlags flags;
+    };
     
     [StructLayout(LayoutKind.Sequential)]
     public class ShaderDebugTrace
@@ -211,7 +240,80 @@ public struct CBuffer
         public CBuffer[] cbuffers;
 
         [CustomMarshalAs(CustomUnmanagedType.TemplatedArray)]
-        public ShaderDebugState[] states;
+        public ShaderDebugStateDelta[] steps;
+
+        [CustomMarshalAs(CustomUnmanagedType.TemplatedArray)]
+        public ShaderDebugState[] keyframes;
+
+        public UInt32 keyframeInterval;
+
+        [CustomMarshalAs(CustomUnmanagedType.UTF8TemplatedString)]
+        public string disassembly;
+
+        private static ShaderVariable[] CopyVariables(ShaderVariable[] vars)
+        {
+            ShaderVariable[] ret = new ShaderVariable[vars.Length];
+            for (int i = 0; i < vars.Length; i++)
+                ret[i] = vars[i].ShallowCopy();
+            return ret;
+        }
+
+        private static void ApplyChanges(ShaderVariable[] vars, ShaderRegisterChange[] changes)
+        {
+            foreach (var c in changes)
+            {
+                if (c.index < vars.Length)
+                {
+                    // replace rather than modify, so states handed out earlier are left alone
+                    vars[c.index] = vars[c.index].ShallowCopy();
+                    vars[c.index].value = c.value;
+                }
+            }
+        }
+
+        // only the changes at each step are stored, with a full state every keyframeInterval
+        // steps. This rebuilds the state at a step, continuing on from state if it holds an
+        // earlier step after the same keyframe.
+        public ShaderDebugState ReconstructState(int step, ShaderDebugState state, int currentStep)
+        {
+            if (steps == null || step < 0 || step >= steps.Length || keyframes.Length == 0)
+                return null;
+
+            int interval = (int)Math.Max(1U, keyframeInterval);
+            int keyframe = Math.Min(step / interval, keyframes.Length - 1);
+            int keyframeStep = keyframe * interval;
+
+            if (state == null || currentStep < keyframeStep || currentStep > step)
+            {
+                ShaderDebugState key = keyframes[keyframe];
+
+                state = new ShaderDebugState();
+                state.registers = CopyVariables(key.registers);
+                state.outputs = CopyVariables(key.outputs);
+                state.indexableTemps = new ShaderDebugState.IndexableTempArray[key.indexableTemps.Length];
+                for (int i = 0; i < key.indexableTemps.Length; i++)
+                    state.indexableTemps[i].temps = CopyVariables(key.indexableTemps[i].temps);
+
+                currentStep = keyframeStep;
+            }
+
+            for (int s = currentStep + 1; s <= step; s++)
+            {
+                ApplyChanges(state.registers, steps[s].registers);
+                ApplyChanges(state.outputs, steps[s].outputs);
+
+                foreach (var c in steps[s].indexableTemps)
+                {
+                    if (c.arrayIndex < state.indexableTemps.Length)
+                        ApplyChanges(state.indexableTemps[c.arrayIndex].temps, new ShaderRegisterChange[] { c });
+                }
+            }
+
+            state.nextInstruction = steps[step].nextInstruction;
+            state.flags = steps[step].flags;
+
+            return state;
+        }
     };
     
     [StructLayout(LayoutKind.Sequential)]
@@ -417,6 +519,20 @@ public string BaseFilename
         public Int32 entryFile;
     };
     
+    [StructLayout(LayoutKind.Sequential)]
+    public class ShaderCost
+    {
+        public UInt32 instructions;
+        public UInt32 aluInstructions;
+        public UInt32 transcendentalInstructions;
+        public UInt32 sampleInstructions;
+        public UInt32 memoryInstructions;
+        public UInt32 flowControlInstructions;
+        public UInt32 tempRegisters;
+        public UInt32 loops;
+        public UInt32 maxLoopDepth;
+    };
+
     [StructLayout(LayoutKind.Sequential)]
     public class ShaderReflection
     {
@@ -455,6 +571,24 @@ public struct Interface
 
         [CustomMarshalAs(CustomUnmanagedType.TemplatedArray)]
         public Interface[] Interfaces;
+
+        [CustomMarshalAs(CustomUnmanagedType.CustomClass)]
+        public ShaderCost Cost;
+    };
+
+    [StructLayout(LayoutKind.Sequential)]
+    public class DrawcallShaderCost
+    {
+        public UInt32 eventID;
+
+        [CustomMarshalAs(CustomUnmanagedType.TemplatedArray)]
+        public ResourceId[] shaders;
+
+        [CustomMarshalAs(CustomUnmanagedType.TemplatedArray)]
+        public ShaderCost[] stageCosts;
+
+        [CustomMarshalAs(CustomUnmanagedType.CustomClass)]
+        public ShaderCost cost;
     };
 
     [StructLayout(LayoutKind.Sequential)]
@@ -84,36 +84,13 @@ public void FillAPIView()
             apiEvents.BeginUpdate();
             apiEvents.Nodes.Clear();
 
-            Regex rgxopen = new Regex("^\\s*{");
-            Regex rgxclose = new Regex("^\\s*}");
-
             FetchDrawcall draw = m_Core.CurDrawcall;
 
             if (draw != null && draw.events != null && draw.events.Length > 0)
             {
                 foreach (var ev in draw.events)
                 {
-                    string[] lines = ev.eventDesc.Split(new string[] { "\r\n", "\n" }, StringSplitOptions.None);
-
-                    TreelistView.Node root = new TreelistView.Node(new object[] { ev.eventID, lines[0] });
-
-                    int i=1;
-
-                    if (i < lines.Length && lines[i].Trim() == "{")
-                        i++;
-
-                    List<TreelistView.Node> nodestack = new List<TreelistView.Node>();
-                    nodestack.Add(root);
-
-                    for (; i < lines.Length; i++)
-                    {
-                        if (rgxopen.IsMatch(lines[i]))
-                            nodestack.Add(nodestack.Last().Nodes.LastNode);
-                        else if (rgxclose.IsMatch(lines[i]))
-                            nodestack.RemoveAt(nodestack.Count - 1);
-                        else if(lines[i].Trim().Length > 0 && nodestack.Count > 0)
-                            nodestack.Last().Nodes.Add(new TreelistView.Node(new object[] { "", lines[i].Trim() }));
-                    }
+                    TreelistView.Node root = new TreelistView.Node(new object[] { ev.eventID, ev.eventDesc });
 
                     if (ev.eventID == draw.eventID)
                         root.Bold = true;
@@ -125,6 +102,53 @@ public void FillAPIView()
 
                 if (apiEvents.Nodes.Count > 0)
                     apiEvents.NodesSelection.Add(apiEvents.Nodes[0]);
+
+                // the parameters aren't part of the drawcall list, fetch them for just these events
+                m_Core.Renderer.BeginInvoke((ReplayRenderer r) =>
+                {
+                    string[] parameters = new string[draw.events.Length];
+                    for (int i = 0; i < draw.events.Length; i++)
+                        parameters[i] = r.GetEventParameters(draw.events[i].eventID);
+
+                    this.BeginInvoke(new Action(() => { AddParameters(draw, parameters); }));
+                });
+            }
+
+            apiEvents.EndUpdate();
+        }
+
+        private void AddParameters(FetchDrawcall draw, string[] parameters)
+        {
+            // the selection moved on while the parameters were being fetched
+            if (m_Core.CurDrawcall != draw || apiEvents.Nodes.Count != parameters.Length)
+                return;
+
+            Regex rgxopen = new Regex("^\\s*{");
+            Regex rgxclose = new Regex("^\\s*}");
+
+            apiEvents.BeginUpdate();
+
+            for (int n = 0; n < parameters.Length; n++)
+            {
+                string[] lines = parameters[n].Split(new string[] { "\r\n", "\n" }, StringSplitOptions.None);
+
+                int i = 0;
+
+                if (i < lines.Length && lines[i].Trim() == "{")
+                    i++;
+
+                List<TreelistView.Node> nodestack = new List<TreelistView.Node>();
+                nodestack.Add(apiEvents.Nodes[n]);
+
+                for (; i < lines.Length; i++)
+                {
+                    if (rgxopen.IsMatch(lines[i]))
+                        nodestack.Add(nodestack.Last().Nodes.LastNode);
+                    else if (rgxclose.IsMatch(lines[i]))
+                        nodestack.RemoveAt(nodestack.Count - 1);
+                    else if(lines[i].Trim().Length > 0 && nodestack.Count > 0)
+                        nodestack.Last().Nodes.Add(new TreelistView.Node(new object[] { "", lines[i].Trim() }));
+                }
             }
 
             apiEvents.EndUpdate();
@@ -210,6 +210,12 @@ private UIState GetUIState(object sender)
         // Cameras
         private TimedUpdate m_Updater = null;
 
+        // set when the last display only drew part of the meshes while the camera was moving. Once the
+        // camera has been still for a few updates, the meshes are drawn again in full.
+        private bool m_MeshReduced = false;
+        private int m_SettledUpdates = 0;
+        private const int MeshRefineDelay = 10;
+
         private ArcballCamera m_Arcball = null;
         private FlyCamera m_Flycam = null;
         private CameraControls m_CurrentCamera = null;
@@ -2378,7 +2384,14 @@ private void TimerUpdate()
             if (m_CurrentCamera == null) return;
 
             if (m_CurrentCamera.Update())
+            {
+                m_SettledUpdates = 0;
+                render.Invalidate();
+            }
+            else if (m_MeshReduced && ++m_SettledUpdates == MeshRefineDelay)
+            {
                 render.Invalidate();
+            }
         }
 
         private void PickVert(Point p)
@@ -2593,7 +2606,15 @@ private void render_Paint(object sender, PaintEventArgs e)
                 return;
             }
 
-            m_Core.Renderer.InvokeForPaint("bufferpaint", (ReplayRenderer r) => { RT_UpdateRenderOutput(r); if (m_Output != null) m_Output.Display(); });
+            m_Core.Renderer.InvokeForPaint("bufferpaint", (ReplayRenderer r) =>
+            {
+                RT_UpdateRenderOutput(r);
+                if (m_Output != null)
+                {
+                    m_Output.Display();
+                    m_MeshReduced = m_Output.IsMeshDisplayReduced();
+                }
+            });
         }
 
         private void BufferViewer_Load(object sender, EventArgs e)
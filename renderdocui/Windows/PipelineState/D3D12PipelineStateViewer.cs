@@ -2471,7 +2471,7 @@ private void csDebug_Click(object sender, EventArgs e)
                     trace = r.DebugThread(new uint[] { gx, gy, gz }, new uint[] { tx, ty, tz });
                 });
 
-                if (trace == null || trace.states.Length == 0)
+                if (trace == null || trace.steps.Length == 0)
                 {
                     MessageBox.Show("Couldn't debug compute shader.", "Uh Oh!",
                                     MessageBoxButtons.OK, MessageBoxIcon.Information);
@@ -117,6 +117,24 @@ private void contextMouseDown(object sender, MouseEventArgs args)
             m_RightclickPoint = m_DisassemblyView.PositionFromPoint(args.X, args.Y);
         }
 
+        // the full state at m_StateStep, rebuilt on demand from the per-step changes in the trace
+        private ShaderDebugState m_State = null;
+        private int m_StateStep = -1;
+
+        private ShaderDebugState CurrentState
+        {
+            get
+            {
+                if (m_State == null || m_StateStep != CurrentStep)
+                {
+                    m_State = m_Trace.ReconstructState(CurrentStep, m_State, m_StateStep);
+                    m_StateStep = CurrentStep;
+                }
+
+                return m_State;
+            }
+        }
+
         private int CurrentStep_;
         public int CurrentStep
         {
@@ -126,9 +144,9 @@ public int CurrentStep
             }
             set
             {
-                if (m_Trace != null && m_Trace.states != null && m_Trace.states.Length > 0)
+                if (m_Trace != null && m_Trace.steps != null && m_Trace.steps.Length > 0)
                 {
-                    CurrentStep_ = Helpers.Clamp(value, 0, m_Trace.states.Length - 1);
+                    CurrentStep_ = Helpers.Clamp(value, 0, m_Trace.steps.Length - 1);
                 }
                 else
                 {
@@ -1097,7 +1115,7 @@ void scintilla1_Click(object sender, EventArgs e)
 
         void scintilla1_MouseMove(object sender, MouseEventArgs e)
         {
-            if (m_Trace == null || m_Trace.states.Length == 0) return;
+            if (m_Trace == null || m_Trace.steps.Length == 0) return;
 
             ScintillaNET.Scintilla scintilla1 = sender as ScintillaNET.Scintilla;
 
@@ -1153,7 +1171,7 @@ private void regsList_Leave(object sender, EventArgs e)
 
         private void regsList_MouseMove(object sender, MouseEventArgs e)
         {
-            if (m_Trace == null || m_Trace.states.Length == 0) return;
+            if (m_Trace == null || m_Trace.steps.Length == 0) return;
 
             // ignore mousemove events that are identical to the last we saw
             if (prevSender == sender && prevPoint.X == e.X && prevPoint.Y == e.Y)
@@ -1221,7 +1239,7 @@ private string GetShaderVariableAsText(ShaderVariable hoverVar)
 
         private void hoverTimer_Tick(object sender, EventArgs e)
         {
-            if (m_Trace == null || m_Trace.states.Length == 0) return;
+            if (m_Trace == null || m_Trace.steps.Length == 0) return;
 
             hoverTimer.Enabled = false;
 
@@ -1239,7 +1257,7 @@ private void hoverTimer_Tick(object sender, EventArgs e)
                 hoverPoint = new Point(m_HoverScintilla.ClientRectangle.Left + pt.X + 10, m_HoverScintilla.ClientRectangle.Top + pt.Y + 10);
                 hoverWin = m_HoverScintilla;
 
-                var state = m_Trace.states[CurrentStep];
+                var state = CurrentState;
 
                 string regtype = m_HoverReg.Substring(0, 1);
                 string regidx = m_HoverReg.Substring(1);
@@ -1409,7 +1427,7 @@ private void AddResourceRegister(ShaderResource slot, D3D11PipelineState.ShaderS
 
         public void UpdateDebugging()
         {
-            if (m_Trace == null || m_Trace.states == null || m_Trace.states.Length == 0)
+            if (m_Trace == null || m_Trace.steps == null || m_Trace.steps.Length == 0)
             {
                 //curInstruction.Text = "0";
 
@@ -1422,14 +1440,14 @@ public void UpdateDebugging()
                 return;
             }
 
-            var state = m_Trace.states[CurrentStep];
+            var state = CurrentState;
 
             //curInstruction.Text = CurrentStep.ToString();
 
             UInt32 nextInst = state.nextInstruction;
             bool done = false;
 
-            if (CurrentStep == m_Trace.states.Length - 1)
+            if (CurrentStep == m_Trace.steps.Length - 1)
             {
                 nextInst--;
                 done = true;
@@ -1723,7 +1741,7 @@ public void OnEventSelected(UInt32 eventID)
 
         void m_DisassemblyView_KeyDown(object sender, KeyEventArgs e)
         {
-            if (m_Trace == null || m_Trace.states == null)
+            if (m_Trace == null || m_Trace.steps == null)
                 return;
 
             DebugKeys_KeyDown(sender, e);
@@ -1731,7 +1749,7 @@ void m_DisassemblyView_KeyDown(object sender, KeyEventArgs e)
 
         private void regsList_KeyDown(object sender, KeyEventArgs e)
         {
-            if (m_Trace == null || m_Trace.states == null)
+            if (m_Trace == null || m_Trace.steps == null)
                 return;
 
             if (e.KeyCode == Keys.C && e.Control)
@@ -1793,7 +1811,7 @@ private void regsList_KeyDown(object sender, KeyEventArgs e)
 
         void DebugKeys_KeyDown(object sender, KeyEventArgs e)
         {
-            if (m_Trace == null || m_Trace.states == null)
+            if (m_Trace == null || m_Trace.steps == null)
                 return;
 
             if (e.KeyCode == Keys.F10)
@@ -1826,7 +1844,7 @@ void DebugKeys_KeyDown(object sender, KeyEventArgs e)
 
         private void runBack_Click(object sender, EventArgs e)
         {
-            if (m_Trace == null || m_Trace.states == null)
+            if (m_Trace == null || m_Trace.steps == null)
                 return;
 
             RunBack();
@@ -1834,7 +1852,7 @@ private void runBack_Click(object sender, EventArgs e)
 
         private void run_Click(object sender, EventArgs e)
         {
-            if (m_Trace == null || m_Trace.states == null)
+            if (m_Trace == null || m_Trace.steps == null)
                 return;
 
             Run();
@@ -1842,7 +1860,7 @@ private void run_Click(object sender, EventArgs e)
 
         private void stepBack_Click(object sender, EventArgs e)
         {
-            if (m_Trace == null || m_Trace.states == null)
+            if (m_Trace == null || m_Trace.steps == null)
                 return;
 
             StepBack();
@@ -1850,7 +1868,7 @@ private void stepBack_Click(object sender, EventArgs e)
 
         private void stepNext_Click(object sender, EventArgs e)
         {
-            if (m_Trace == null || m_Trace.states == null)
+            if (m_Trace == null || m_Trace.steps == null)
                 return;
 
             StepNext();
@@ -1858,7 +1876,7 @@ private void stepNext_Click(object sender, EventArgs e)
 
         private void runToCursor_Click(object sender, EventArgs e)
         {
-            if (m_Trace == null || m_Trace.states == null)
+            if (m_Trace == null || m_Trace.steps == null)
                 return;
 
             RunToCursor();
@@ -1866,7 +1884,7 @@ private void runToCursor_Click(object sender, EventArgs e)
 
         private void runToSample_Click(object sender, EventArgs e)
         {
-            if (m_Trace == null || m_Trace.states == null)
+            if (m_Trace == null || m_Trace.steps == null)
                 return;
 
             RunToSample();
@@ -1874,7 +1892,7 @@ private void runToSample_Click(object sender, EventArgs e)
 
         private void runToNanOrInf_Click(object sender, EventArgs e)
         {
-            if (m_Trace == null || m_Trace.states == null)
+            if (m_Trace == null || m_Trace.steps == null)
                 return;
 
             RunToNanOrInf();
@@ -1882,7 +1900,7 @@ private void runToNanOrInf_Click(object sender, EventArgs e)
 
         private bool StepBack()
         {
-            if (m_Trace == null || m_Trace.states == null)
+            if (m_Trace == null || m_Trace.steps == null)
                 return false;
 
             if (CurrentStep == 0)
@@ -1895,9 +1913,9 @@ private bool StepBack()
 
         private bool StepNext()
         {
-            if (m_Trace == null || m_Trace.states == null) return false;
+            if (m_Trace == null || m_Trace.steps == null) return false;
 
-            if (CurrentStep + 1 >= m_Trace.states.Length)
+            if (CurrentStep + 1 >= m_Trace.steps.Length)
                 return false;
 
             CurrentStep++;
@@ -1907,7 +1925,7 @@ private bool StepNext()
 
         private void RunTo(int runToInstruction, bool forward)
         {
-            if (m_Trace == null || m_Trace.states == null)
+            if (m_Trace == null || m_Trace.steps == null)
                 return;
 
             int step = CurrentStep;
@@ -1916,17 +1934,17 @@ private void RunTo(int runToInstruction, bool forward)
 
             bool firstStep = true;
 
-            while (step < m_Trace.states.Length)
+            while (step < m_Trace.steps.Length)
             {
-                if (m_Trace.states[step].nextInstruction == runToInstruction)
+                if (m_Trace.steps[step].nextInstruction == runToInstruction)
                     break;
 
-                if (!firstStep && m_Breakpoints.Contains((int)m_Trace.states[step].nextInstruction))
+                if (!firstStep && m_Breakpoints.Contains((int)m_Trace.steps[step].nextInstruction))
                     break;
 
                 firstStep = false;
 
-                if (step + inc < 0 || step + inc >= m_Trace.states.Length)
+                if (step + inc < 0 || step + inc >= m_Trace.steps.Length)
                     break;
 
                 step += inc;
@@ -1984,24 +2002,24 @@ private void RunToCursor()
 
         private void RunToCondition(ShaderDebugStateFlags condition)
         {
-            if (m_Trace == null || m_Trace.states == null)
+            if (m_Trace == null || m_Trace.steps == null)
                 return;
 
             int step = CurrentStep;
 
             bool firstStep = true;
 
-            while (step < m_Trace.states.Length)
+            while (step < m_Trace.steps.Length)
             {
                 int nextStep = step + 1;
 
-                if (nextStep >= m_Trace.states.Length)
+                if (nextStep >= m_Trace.steps.Length)
                     break;
 
-                if (!firstStep && m_Trace.states[nextStep].flags.HasFlag(condition))
+                if (!firstStep && m_Trace.steps[nextStep].flags.HasFlag(condition))
                     break;
 
-                if (!firstStep && m_Breakpoints.Contains((int)m_Trace.states[step].nextInstruction))
+                if (!firstStep && m_Breakpoints.Contains((int)m_Trace.steps[step].nextInstruction))
                     break;
 
                 firstStep = false;
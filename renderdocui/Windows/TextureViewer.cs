@@ -3618,7 +3618,7 @@ private void debugPixel_Click(object sender, EventArgs e)
                 trace = r.DebugPixel((UInt32)x, (UInt32)y, m_TexDisplay.sampleIdx, uint.MaxValue);
             });
 
-            if (trace == null || trace.states.Length == 0)
+            if (trace == null || trace.steps.Length == 0)
             {
                 // if we couldn't debug the pixel on this event, open up a pixel history
                 pixelHistory_Click(sender, e);